@@ -0,0 +1,171 @@
+# Copyright (c), ETH Zurich and UNC Chapel Hill.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#
+#     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+#       its contributors may be used to endorse or promote products derived
+#       from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+import argparse
+import sys
+from pathlib import Path
+
+from comparison.results import read_results, write_results
+from comparison.stats import Comparison, Verdict, compare_results
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(
+        description="Compare the runtime benchmark results of two builds and "
+        "flag statistically significant slowdowns. Exits with a non-zero code "
+        "if any benchmark regressed."
+    )
+    parser.add_argument(
+        "--results_a_path",
+        type=Path,
+        nargs="+",
+        required=True,
+        help="Results of the baseline build, merged if multiple are given.",
+    )
+    parser.add_argument(
+        "--results_b_path",
+        type=Path,
+        nargs="+",
+        required=True,
+        help="Results of the contender build, merged if multiple are given.",
+    )
+    parser.add_argument(
+        "--alpha",
+        type=float,
+        default=0.01,
+        help="Significance level of the Mann-Whitney U test.",
+    )
+    parser.add_argument(
+        "--min_rel_change",
+        type=float,
+        default=0.05,
+        help="Minimum relative change of the median runtime to be flagged.",
+    )
+    parser.add_argument(
+        "--min_repetitions",
+        type=int,
+        default=5,
+        help="Minimum number of repetitions per benchmark to test for "
+        "significance.",
+    )
+    parser.add_argument(
+        "--show_unchanged",
+        action="store_true",
+        help="Also list the benchmarks without a significant change.",
+    )
+    parser.add_argument(
+        "--output_a_path",
+        type=Path,
+        help="Optionally write the merged results A in the common schema.",
+    )
+    parser.add_argument(
+        "--output_b_path",
+        type=Path,
+        help="Optionally write the merged results B in the common schema.",
+    )
+    return parser.parse_args()
+
+
+def format_seconds(seconds: float | None) -> str:
+    if seconds is None:
+        return "-"
+    for unit, scale in (("s", 1.0), ("ms", 1e-3), ("us", 1e-6)):
+        if seconds >= scale:
+            return f"{seconds / scale:.3f} {unit}"
+    return f"{seconds / 1e-9:.1f} ns"
+
+
+def create_comparison_table(comparisons: list[Comparison]) -> str:
+    rows = [("Benchmark", "Median A", "Median B", "Change", "p-value", "")]
+    for comparison in comparisons:
+        rows.append(
+            (
+                comparison.name,
+                format_seconds(comparison.median_a),
+                format_seconds(comparison.median_b),
+                "-"
+                if comparison.rel_change is None
+                else f"{100 * comparison.rel_change:+.1f}%",
+                "-"
+                if comparison.p_value is None
+                else f"{comparison.p_value:.4f}",
+                comparison.verdict.value,
+            )
+        )
+    widths = [max(len(row[i]) for row in rows) for i in range(len(rows[0]))]
+    lines = []
+    for row in rows:
+        cells = [row[0].ljust(widths[0])]
+        cells += [cell.rjust(width) for cell, width in zip(row[1:], widths[1:])]
+        lines.append("  ".join(cells).rstrip())
+    return "\n".join(lines)
+
+
+def main() -> int:
+    args = parse_args()
+
+    results_a = read_results(args.results_a_path)
+    results_b = read_results(args.results_b_path)
+    if args.output_a_path is not None:
+        write_results(results_a, args.output_a_path)
+    if args.output_b_path is not None:
+        write_results(results_b, args.output_b_path)
+
+    comparisons = compare_results(
+        results_a,
+        results_b,
+        min_repetitions=args.min_repetitions,
+        alpha=args.alpha,
+        min_rel_change=args.min_rel_change,
+    )
+
+    num_by_verdict = {verdict: 0 for verdict in Verdict}
+    for comparison in comparisons:
+        num_by_verdict[comparison.verdict] += 1
+    if not args.show_unchanged:
+        comparisons = [
+            comparison
+            for comparison in comparisons
+            if comparison.verdict != Verdict.UNCHANGED
+        ]
+
+    print(create_comparison_table(comparisons))
+    print(
+        ", ".join(
+            f"{num} {verdict.value}"
+            for verdict, num in num_by_verdict.items()
+            if num > 0
+        )
+    )
+
+    return 1 if num_by_verdict[Verdict.REGRESSION] > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
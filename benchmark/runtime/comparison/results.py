@@ -0,0 +1,185 @@
+# Copyright (c), ETH Zurich and UNC Chapel Hill.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#
+#     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+#       its contributors may be used to endorse or promote products derived
+#       from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+"""Schema of the results of the runtime benchmarks.
+
+All runtime benchmarks are compared through the same schema, in which each
+benchmark has a unique name (including its arguments) and a list of repeated
+runtime measurements in seconds. The following inputs are converted to it:
+
+- The JSON output of the Google Benchmark based targets, as written with
+  ``--benchmark_out=results.json --benchmark_out_format=json``. Only the
+  individual repetitions are used and the aggregates (mean, median, etc.) are
+  ignored, so the benchmarks should be run with ``--benchmark_repetitions``.
+- The JSON lines output of ``benchmark_mapper_scaling``. Each line is one
+  measurement of the total runtime and of the runtimes of the traced stages,
+  so that repeated runs appended to the same file are repetitions.
+- Files in the schema itself, as written by ``write_results``.
+"""
+
+import dataclasses
+import json
+from pathlib import Path
+from typing import Any
+
+SCHEMA_VERSION = 1
+
+_TIME_UNIT_TO_SECONDS = {
+    "ns": 1e-9,
+    "us": 1e-6,
+    "ms": 1e-3,
+    "s": 1.0,
+}
+
+
+@dataclasses.dataclass(kw_only=True)
+class BenchmarkResult:
+    # Unique name of the benchmark including its arguments.
+    name: str
+    # Repeated measurements of the wall-clock time in seconds.
+    real_times: list[float] = dataclasses.field(default_factory=list)
+    # Repeated measurements of the CPU time in seconds, if available.
+    cpu_times: list[float] = dataclasses.field(default_factory=list)
+
+
+@dataclasses.dataclass(kw_only=True)
+class RuntimeResults:
+    # Information about the machine and build, e.g., the host name, number of
+    # CPUs, or the label of the run.
+    context: dict[str, Any] = dataclasses.field(default_factory=dict)
+    # Results by the name of the benchmark.
+    benchmarks: dict[str, BenchmarkResult] = dataclasses.field(
+        default_factory=dict
+    )
+
+    def add(self, name: str, real_time: float, cpu_time: float | None) -> None:
+        result = self.benchmarks.setdefault(name, BenchmarkResult(name=name))
+        result.real_times.append(real_time)
+        if cpu_time is not None:
+            result.cpu_times.append(cpu_time)
+
+    def merge(self, other: "RuntimeResults") -> None:
+        for key, value in other.context.items():
+            self.context.setdefault(key, value)
+        for name, result in other.benchmarks.items():
+            merged = self.benchmarks.setdefault(
+                name, BenchmarkResult(name=name)
+            )
+            merged.real_times.extend(result.real_times)
+            merged.cpu_times.extend(result.cpu_times)
+
+
+def _parse_google_benchmark(data: dict[str, Any]) -> RuntimeResults:
+    results = RuntimeResults(context=dict(data.get("context", {})))
+    for entry in data["benchmarks"]:
+        if entry.get("run_type", "iteration") != "iteration":
+            continue
+        if entry.get("error_occurred", False):
+            continue
+        scale = _TIME_UNIT_TO_SECONDS[entry.get("time_unit", "ns")]
+        results.add(
+            name=entry.get("run_name", entry["name"]),
+            real_time=scale * entry["real_time"],
+            cpu_time=scale * entry["cpu_time"],
+        )
+    return results
+
+
+def _parse_schema(data: dict[str, Any]) -> RuntimeResults:
+    if data.get("schema_version") != SCHEMA_VERSION:
+        raise ValueError(
+            f"Unsupported schema version: {data.get('schema_version')}"
+        )
+    results = RuntimeResults(context=dict(data.get("context", {})))
+    for entry in data["benchmarks"]:
+        results.benchmarks[entry["name"]] = BenchmarkResult(
+            name=entry["name"],
+            real_times=list(entry["real_times"]),
+            cpu_times=list(entry.get("cpu_times", [])),
+        )
+    return results
+
+
+def _parse_mapper_scaling(lines: list[str]) -> RuntimeResults:
+    results = RuntimeResults()
+    for line in lines:
+        run = json.loads(line)
+        results.context.setdefault("label", run["label"])
+        name = (
+            f"MapperScaling/{run['mapper']}/num_images:{run['num_images']}"
+            f"/num_threads:{run['num_threads']}"
+        )
+        results.add(name, real_time=run["total_s"], cpu_time=None)
+        for stage_name, stage in run["stages"].items():
+            results.add(
+                f"{name}/{stage_name}",
+                real_time=stage["total_s"],
+                cpu_time=None,
+            )
+    return results
+
+
+def parse_results(text: str) -> RuntimeResults:
+    """Parse the results in any of the supported formats."""
+    lines = [line for line in text.splitlines() if line.strip()]
+    if not lines:
+        return RuntimeResults()
+    try:
+        data = json.loads(text)
+    except json.JSONDecodeError:
+        # Multiple JSON objects, one per line.
+        return _parse_mapper_scaling(lines)
+    if "schema_version" in data:
+        return _parse_schema(data)
+    if "benchmarks" in data:
+        return _parse_google_benchmark(data)
+    if "mapper" in data:
+        return _parse_mapper_scaling(lines)
+    raise ValueError("Unknown format of runtime benchmark results")
+
+
+def read_results(paths: list[Path]) -> RuntimeResults:
+    """Read and merge the results of multiple files, e.g., of different
+    benchmark targets or of repeated invocations of the same target."""
+    results = RuntimeResults()
+    for path in paths:
+        results.merge(parse_results(path.read_text()))
+    return results
+
+
+def write_results(results: RuntimeResults, path: Path) -> None:
+    data = {
+        "schema_version": SCHEMA_VERSION,
+        "context": results.context,
+        "benchmarks": [
+            dataclasses.asdict(result)
+            for result in results.benchmarks.values()
+        ],
+    }
+    path.write_text(json.dumps(data, indent=2) + "\n")
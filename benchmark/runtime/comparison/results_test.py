@@ -0,0 +1,163 @@
+# Copyright (c), ETH Zurich and UNC Chapel Hill.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#
+#     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+#       its contributors may be used to endorse or promote products derived
+#       from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+import json
+from pathlib import Path
+
+import pytest
+
+from .results import (
+    BenchmarkResult,
+    RuntimeResults,
+    parse_results,
+    read_results,
+    write_results,
+)
+
+GOOGLE_BENCHMARK_JSON = {
+    "context": {"host_name": "host", "num_cpus": 8},
+    "benchmarks": [
+        {
+            "name": "BM_Foo/10",
+            "run_name": "BM_Foo/10",
+            "run_type": "iteration",
+            "repetition_index": 0,
+            "real_time": 2.0,
+            "cpu_time": 1.5,
+            "time_unit": "ms",
+        },
+        {
+            "name": "BM_Foo/10",
+            "run_name": "BM_Foo/10",
+            "run_type": "iteration",
+            "repetition_index": 1,
+            "real_time": 3.0,
+            "cpu_time": 2.5,
+            "time_unit": "ms",
+        },
+        {
+            "name": "BM_Foo/10_mean",
+            "run_name": "BM_Foo/10",
+            "run_type": "aggregate",
+            "aggregate_name": "mean",
+            "real_time": 2.5,
+            "cpu_time": 2.0,
+            "time_unit": "ms",
+        },
+        {
+            "name": "BM_Bar",
+            "run_name": "BM_Bar",
+            "run_type": "iteration",
+            "error_occurred": True,
+            "real_time": 0,
+            "cpu_time": 0,
+            "time_unit": "ns",
+        },
+    ],
+}
+
+
+def test_parse_google_benchmark() -> None:
+    results = parse_results(json.dumps(GOOGLE_BENCHMARK_JSON))
+    assert results.context["host_name"] == "host"
+    assert list(results.benchmarks) == ["BM_Foo/10"]
+    assert results.benchmarks["BM_Foo/10"].real_times == pytest.approx(
+        [2e-3, 3e-3]
+    )
+    assert results.benchmarks["BM_Foo/10"].cpu_times == pytest.approx(
+        [1.5e-3, 2.5e-3]
+    )
+
+
+def test_parse_mapper_scaling() -> None:
+    lines = [
+        json.dumps(
+            {
+                "label": "abc",
+                "mapper": "incremental",
+                "num_images": 25,
+                "num_threads": 1,
+                "total_s": total_s,
+                "stages": {
+                    "AdjustGlobalBundle": {
+                        "calls": 2,
+                        "total_s": total_s / 2,
+                        "max_s": total_s / 4,
+                        "items": 0,
+                    }
+                },
+            }
+        )
+        for total_s in [1.0, 2.0]
+    ]
+    results = parse_results("\n".join(lines) + "\n")
+    assert results.context["label"] == "abc"
+    name = "MapperScaling/incremental/num_images:25/num_threads:1"
+    assert results.benchmarks[name].real_times == [1.0, 2.0]
+    assert results.benchmarks[name].cpu_times == []
+    assert results.benchmarks[name + "/AdjustGlobalBundle"].real_times == [
+        0.5,
+        1.0,
+    ]
+
+    # Also parse a single line, which is valid JSON by itself.
+    results = parse_results(lines[0])
+    assert results.benchmarks[name].real_times == [1.0]
+
+
+def test_parse_empty() -> None:
+    assert parse_results("\n").benchmarks == {}
+
+
+def test_parse_unknown() -> None:
+    with pytest.raises(ValueError):
+        parse_results(json.dumps({"foo": 1}))
+
+
+def test_write_read_results(tmp_path: Path) -> None:
+    results = RuntimeResults(
+        context={"label": "abc"},
+        benchmarks={
+            "BM_Foo": BenchmarkResult(
+                name="BM_Foo", real_times=[1.0, 2.0], cpu_times=[0.5, 1.5]
+            )
+        },
+    )
+    path = tmp_path / "results.json"
+    write_results(results, path)
+    assert read_results([path]) == results
+
+
+def test_read_merges_results(tmp_path: Path) -> None:
+    path1 = tmp_path / "results1.json"
+    path2 = tmp_path / "results2.json"
+    path1.write_text(json.dumps(GOOGLE_BENCHMARK_JSON))
+    path2.write_text(json.dumps(GOOGLE_BENCHMARK_JSON))
+    results = read_results([path1, path2])
+    assert len(results.benchmarks["BM_Foo/10"].real_times) == 4
@@ -0,0 +1,168 @@
+# Copyright (c), ETH Zurich and UNC Chapel Hill.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#
+#     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+#       its contributors may be used to endorse or promote products derived
+#       from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+"""Detection of statistically significant runtime changes between builds."""
+
+import dataclasses
+import enum
+import math
+import statistics
+
+from .results import BenchmarkResult, RuntimeResults
+
+
+def mann_whitney_u_test(a: list[float], b: list[float]) -> float:
+    """Two-sided p-value of the Mann-Whitney U test that the samples a and b
+    are drawn from the same distribution.
+
+    Uses the normal approximation with tie and continuity correction, which is
+    reasonably accurate for at least 5 samples per side. Unlike the t-test, the
+    test makes no assumption about the distribution of the runtimes, which are
+    typically skewed by outliers due to the system noise.
+    """
+    n_a = len(a)
+    n_b = len(b)
+    if n_a == 0 or n_b == 0:
+        return 1.0
+
+    # Rank the pooled samples, where tied values get their average rank.
+    values = sorted([(value, 0) for value in a] + [(value, 1) for value in b])
+    n = n_a + n_b
+    rank_sum_a = 0.0
+    tie_correction = 0.0
+    i = 0
+    while i < n:
+        j = i
+        while j + 1 < n and values[j + 1][0] == values[i][0]:
+            j += 1
+        num_ties = j - i + 1
+        rank = 0.5 * (i + j) + 1
+        num_a = sum(1 for k in range(i, j + 1) if values[k][1] == 0)
+        rank_sum_a += rank * num_a
+        tie_correction += num_ties**3 - num_ties
+        i = j + 1
+
+    u_a = rank_sum_a - n_a * (n_a + 1) / 2
+    mean_u = n_a * n_b / 2
+    var_u = n_a * n_b / 12 * ((n + 1) - tie_correction / (n * (n - 1)))
+    if var_u <= 0:
+        return 1.0
+    z = (abs(u_a - mean_u) - 0.5) / math.sqrt(var_u)
+    return min(1.0, math.erfc(max(z, 0.0) / math.sqrt(2)))
+
+
+class Verdict(enum.Enum):
+    UNCHANGED = "unchanged"
+    REGRESSION = "REGRESSION"
+    IMPROVEMENT = "improvement"
+    # Too few repetitions in either of the results to test for significance.
+    INSUFFICIENT = "insufficient repetitions"
+    # Only present in one of the results.
+    MISSING = "missing"
+
+
+@dataclasses.dataclass(kw_only=True)
+class Comparison:
+    name: str
+    median_a: float | None
+    median_b: float | None
+    # Relative change of the median runtime from a to b, e.g., 0.1 if b is 10%
+    # slower than a.
+    rel_change: float | None
+    p_value: float | None
+    verdict: Verdict
+
+
+def compare_benchmark(
+    a: BenchmarkResult | None,
+    b: BenchmarkResult | None,
+    min_repetitions: int,
+    alpha: float,
+    min_rel_change: float,
+) -> Comparison:
+    """Compare the wall-clock times of a benchmark, where a change is only
+    flagged if it is both statistically significant at the given level and
+    larger than the given relative change of the median runtime."""
+    name = a.name if a is not None else b.name if b is not None else ""
+    median_a = statistics.median(a.real_times) if a and a.real_times else None
+    median_b = statistics.median(b.real_times) if b and b.real_times else None
+    if a is None or b is None or median_a is None or median_b is None:
+        return Comparison(
+            name=name,
+            median_a=median_a,
+            median_b=median_b,
+            rel_change=None,
+            p_value=None,
+            verdict=Verdict.MISSING,
+        )
+
+    rel_change = median_b / median_a - 1 if median_a > 0 else 0.0
+    if min(len(a.real_times), len(b.real_times)) < min_repetitions:
+        return Comparison(
+            name=name,
+            median_a=median_a,
+            median_b=median_b,
+            rel_change=rel_change,
+            p_value=None,
+            verdict=Verdict.INSUFFICIENT,
+        )
+
+    p_value = mann_whitney_u_test(a.real_times, b.real_times)
+    verdict = Verdict.UNCHANGED
+    if p_value < alpha and abs(rel_change) >= min_rel_change:
+        verdict = Verdict.REGRESSION if rel_change > 0 else Verdict.IMPROVEMENT
+    return Comparison(
+        name=name,
+        median_a=median_a,
+        median_b=median_b,
+        rel_change=rel_change,
+        p_value=p_value,
+        verdict=verdict,
+    )
+
+
+def compare_results(
+    results_a: RuntimeResults,
+    results_b: RuntimeResults,
+    min_repetitions: int = 5,
+    alpha: float = 0.01,
+    min_rel_change: float = 0.05,
+) -> list[Comparison]:
+    names = list(results_a.benchmarks)
+    names += [name for name in results_b.benchmarks if name not in names]
+    return [
+        compare_benchmark(
+            results_a.benchmarks.get(name),
+            results_b.benchmarks.get(name),
+            min_repetitions=min_repetitions,
+            alpha=alpha,
+            min_rel_change=min_rel_change,
+        )
+        for name in names
+    ]
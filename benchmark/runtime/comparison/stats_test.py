@@ -0,0 +1,102 @@
+# Copyright (c), ETH Zurich and UNC Chapel Hill.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#
+#     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+#       its contributors may be used to endorse or promote products derived
+#       from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+import pytest
+
+from .results import BenchmarkResult, RuntimeResults
+from .stats import Verdict, compare_results, mann_whitney_u_test
+
+
+def test_mann_whitney_u_test() -> None:
+    # Same as scipy.stats.mannwhitneyu(a, b, method="asymptotic").
+    assert mann_whitney_u_test(
+        [1, 2, 3, 4, 5], [6, 7, 8, 9, 10]
+    ) == pytest.approx(0.01219, abs=1e-4)
+    assert mann_whitney_u_test(
+        [1, 3, 5, 7, 9], [2, 4, 6, 8, 10]
+    ) == pytest.approx(0.67610, abs=1e-4)
+    assert mann_whitney_u_test([1, 1, 2, 2], [2, 2, 3, 3]) == pytest.approx(
+        0.08636, abs=1e-4
+    )
+    assert mann_whitney_u_test([1, 1, 1], [1, 1, 1]) == 1.0
+    assert mann_whitney_u_test([], [1, 2]) == 1.0
+
+
+def _make_results(times: dict[str, list[float]]) -> RuntimeResults:
+    return RuntimeResults(
+        benchmarks={
+            name: BenchmarkResult(name=name, real_times=real_times)
+            for name, real_times in times.items()
+        }
+    )
+
+
+def test_compare_results() -> None:
+    base = [1.0, 1.01, 0.99, 1.02, 0.98, 1.0, 1.01, 0.99]
+    results_a = _make_results(
+        {
+            "Slower": base,
+            "Faster": base,
+            "Noisy": base,
+            "Small": base,
+            "Few": base[:3],
+            "Removed": base,
+        }
+    )
+    results_b = _make_results(
+        {
+            "Slower": [1.2 * t for t in base],
+            "Faster": [0.8 * t for t in base],
+            "Noisy": [t + 0.005 for t in base],
+            "Small": [t + 0.04 for t in base],
+            "Few": [2 * t for t in base[:3]],
+            "Added": base,
+        }
+    )
+    comparisons = {
+        comparison.name: comparison
+        for comparison in compare_results(
+            results_a,
+            results_b,
+            min_repetitions=5,
+            alpha=0.01,
+            min_rel_change=0.05,
+        )
+    }
+    assert comparisons["Slower"].verdict == Verdict.REGRESSION
+    assert comparisons["Slower"].rel_change == pytest.approx(0.2)
+    assert comparisons["Faster"].verdict == Verdict.IMPROVEMENT
+    assert comparisons["Noisy"].verdict == Verdict.UNCHANGED
+    # Significant but below the minimum relative change.
+    assert comparisons["Small"].verdict == Verdict.UNCHANGED
+    assert comparisons["Small"].p_value is not None
+    assert comparisons["Small"].p_value < 0.01
+    assert comparisons["Few"].verdict == Verdict.INSUFFICIENT
+    assert comparisons["Removed"].verdict == Verdict.MISSING
+    assert comparisons["Added"].verdict == Verdict.MISSING
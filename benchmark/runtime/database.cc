@@ -0,0 +1,302 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/scene/database.h"
+#include "colmap/scene/database_cache.h"
+#include "colmap/scene/database_mmap.h"
+#include "colmap/scene/database_shard.h"
+#include "colmap/scene/database_sqlite.h"
+#include "colmap/sensor/models.h"
+
+#include <filesystem>
+
+#include <benchmark/benchmark.h>
+#include <glog/logging.h>
+
+using namespace colmap;
+
+// The number of features of every image and of matches of every image pair,
+// which are kept small, such that the benchmarks are dominated by the
+// per-entry overhead of the database rather than by copying large blobs.
+constexpr int kNumFeaturesPerImage = 16;
+
+enum class DatabaseBackend {
+  SQLITE,
+  SQLITE_IN_MEMORY,
+  MMAP,
+  // Shard of a SQLite database, which stores the matches and two-view
+  // geometries in a separate SQLite database.
+  SHARD,
+};
+
+// Opens a new, empty database of the given backend in a temporary directory,
+// which is cleared before.
+std::shared_ptr<Database> OpenEmptyDatabase(const DatabaseBackend backend) {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "colmap_benchmark_database";
+  std::filesystem::remove_all(path);
+  std::filesystem::create_directories(path);
+  switch (backend) {
+    case DatabaseBackend::SQLITE:
+      return OpenSqliteDatabase(path / "database.db");
+    case DatabaseBackend::SQLITE_IN_MEMORY:
+      return OpenSqliteDatabase(kInMemorySqliteDatabasePath);
+    case DatabaseBackend::MMAP:
+      return OpenMmapDatabase(path / "mmap");
+    case DatabaseBackend::SHARD:
+      return OpenShardDatabase(OpenSqliteDatabase(path / "database.db"),
+                               path / "shard.db");
+  }
+  return nullptr;
+}
+
+FeatureKeypoints CreateKeypoints() {
+  FeatureKeypoints keypoints;
+  keypoints.reserve(kNumFeaturesPerImage);
+  for (int i = 0; i < kNumFeaturesPerImage; ++i) {
+    keypoints.emplace_back(i, i);
+  }
+  return keypoints;
+}
+
+FeatureDescriptors CreateDescriptors() {
+  return FeatureDescriptors(
+      FeatureExtractorType::SIFT,
+      FeatureDescriptorsData::Constant(kNumFeaturesPerImage, 128, 1));
+}
+
+FeatureMatches CreateMatches() {
+  FeatureMatches matches;
+  matches.reserve(kNumFeaturesPerImage);
+  for (int i = 0; i < kNumFeaturesPerImage; ++i) {
+    matches.emplace_back(i, i);
+  }
+  return matches;
+}
+
+// Writes a single camera and rig and one frame per image. Optionally, writes
+// the keypoints of all images and the two-view geometries between consecutive
+// images. Returns the identifiers of the images.
+std::vector<image_t> PopulateDatabase(const int num_images,
+                                      const bool with_two_view_geometries,
+                                      Database* database) {
+  DatabaseTransaction transaction(database);
+
+  Camera camera = Camera::CreateFromModelId(
+      kInvalidCameraId, SimplePinholeCameraModel::model_id, 1, 1, 1);
+  camera.camera_id = database->WriteCamera(camera);
+
+  Rig rig;
+  rig.AddRefSensor(camera.SensorId());
+  const rig_t rig_id = database->WriteRig(rig);
+
+  const FeatureKeypoints keypoints = CreateKeypoints();
+  TwoViewGeometry two_view_geometry;
+  two_view_geometry.config = TwoViewGeometry::ConfigurationType::CALIBRATED;
+  two_view_geometry.inlier_matches = CreateMatches();
+
+  std::vector<image_t> image_ids;
+  image_ids.reserve(num_images);
+  for (int i = 0; i < num_images; ++i) {
+    Image image;
+    image.SetName("image" + std::to_string(i));
+    image.SetCameraId(camera.camera_id);
+    image.SetImageId(database->WriteImage(image));
+    image_ids.push_back(image.ImageId());
+
+    Frame frame;
+    frame.SetRigId(rig_id);
+    frame.AddDataId(image.DataId());
+    database->WriteFrame(frame);
+
+    if (with_two_view_geometries) {
+      database->WriteKeypoints(image.ImageId(), keypoints);
+      if (i > 0) {
+        database->WriteTwoViewGeometry(
+            image_ids[i - 1], image_ids[i], two_view_geometry);
+      }
+    }
+  }
+
+  return image_ids;
+}
+
+// Measures the throughput of writing one entry per image (or per pair of
+// consecutive images) into a database, which is populated with the images
+// beforehand. The written entries are cleared before every iteration. Without
+// a transaction, every write is committed separately.
+template <typename WriteFunc, typename ClearFunc>
+void RunWriteBenchmark(benchmark::State& state,
+                       const DatabaseBackend backend,
+                       const size_t entry_num_bytes,
+                       WriteFunc write_func,
+                       ClearFunc clear_func) {
+  FLAGS_minloglevel = 2;
+
+  const int num_images = state.range(0);
+  const bool use_transaction = state.range(1);
+
+  std::shared_ptr<Database> database = OpenEmptyDatabase(backend);
+  const std::vector<image_t> image_ids = PopulateDatabase(
+      num_images, /*with_two_view_geometries=*/false, database.get());
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    clear_func(database.get());
+    state.ResumeTiming();
+
+    if (use_transaction) {
+      DatabaseTransaction transaction(database.get());
+      write_func(image_ids, database.get());
+    } else {
+      write_func(image_ids, database.get());
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * num_images);
+  state.SetBytesProcessed(state.iterations() * num_images * entry_num_bytes);
+}
+
+static void BM_DatabaseWriteKeypoints(benchmark::State& state,
+                                      const DatabaseBackend backend) {
+  const FeatureKeypoints keypoints = CreateKeypoints();
+  RunWriteBenchmark(
+      state,
+      backend,
+      keypoints.size() * sizeof(FeatureKeypoint),
+      [&](const std::vector<image_t>& image_ids, Database* database) {
+        for (const image_t image_id : image_ids) {
+          database->WriteKeypoints(image_id, keypoints);
+        }
+      },
+      [](Database* database) { database->ClearKeypoints(); });
+}
+
+static void BM_DatabaseWriteDescriptors(benchmark::State& state,
+                                        const DatabaseBackend backend) {
+  const FeatureDescriptors descriptors = CreateDescriptors();
+  RunWriteBenchmark(
+      state,
+      backend,
+      descriptors.data.size(),
+      [&](const std::vector<image_t>& image_ids, Database* database) {
+        for (const image_t image_id : image_ids) {
+          database->WriteDescriptors(image_id, descriptors);
+        }
+      },
+      [](Database* database) { database->ClearDescriptors(); });
+}
+
+static void BM_DatabaseWriteMatches(benchmark::State& state,
+                                    const DatabaseBackend backend) {
+  const FeatureMatches matches = CreateMatches();
+  RunWriteBenchmark(
+      state,
+      backend,
+      matches.size() * sizeof(FeatureMatch),
+      [&](const std::vector<image_t>& image_ids, Database* database) {
+        for (size_t i = 0; i < image_ids.size(); ++i) {
+          database->WriteMatches(
+              image_ids[i], image_ids[(i + 1) % image_ids.size()], matches);
+        }
+      },
+      [](Database* database) { database->ClearMatches(); });
+}
+
+static void BM_DatabaseReadTwoViewGeometries(benchmark::State& state,
+                                             const DatabaseBackend backend) {
+  FLAGS_minloglevel = 2;
+
+  const int num_images = state.range(0);
+  std::shared_ptr<Database> database = OpenEmptyDatabase(backend);
+  PopulateDatabase(
+      num_images, /*with_two_view_geometries=*/true, database.get());
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(database->ReadTwoViewGeometries());
+  }
+
+  state.SetItemsProcessed(state.iterations() * (num_images - 1));
+}
+
+static void BM_DatabaseCacheCreate(benchmark::State& state,
+                                   const DatabaseBackend backend) {
+  FLAGS_minloglevel = 2;
+
+  const int num_images = state.range(0);
+  std::shared_ptr<Database> database = OpenEmptyDatabase(backend);
+  PopulateDatabase(
+      num_images, /*with_two_view_geometries=*/true, database.get());
+
+  DatabaseCache::Options options;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(DatabaseCache::Create(*database, options));
+  }
+
+  state.SetItemsProcessed(state.iterations() * num_images);
+}
+
+// Args: {num_images, use_transaction}
+static void AddWriteArguments(::benchmark::Benchmark* b) {
+  b->ArgsProduct({{10000, 100000, 1000000}, {0, 1}})
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+}
+
+// Args: {num_images}
+static void AddReadArguments(::benchmark::Benchmark* b) {
+  b->Arg(10000)
+      ->Arg(100000)
+      ->Arg(1000000)
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+}
+
+#define REGISTER_DATABASE_BENCHMARKS(name, backend)             \
+  BENCHMARK_CAPTURE(BM_DatabaseWriteKeypoints, name, backend)   \
+      ->Apply(AddWriteArguments);                               \
+  BENCHMARK_CAPTURE(BM_DatabaseWriteDescriptors, name, backend) \
+      ->Apply(AddWriteArguments);                               \
+  BENCHMARK_CAPTURE(BM_DatabaseWriteMatches, name, backend)     \
+      ->Apply(AddWriteArguments);                               \
+  BENCHMARK_CAPTURE(                                            \
+      BM_DatabaseReadTwoViewGeometries, name, backend)          \
+      ->Apply(AddReadArguments);                                \
+  BENCHMARK_CAPTURE(BM_DatabaseCacheCreate, name, backend)      \
+      ->Apply(AddReadArguments);
+
+REGISTER_DATABASE_BENCHMARKS(SQLite, DatabaseBackend::SQLITE)
+REGISTER_DATABASE_BENCHMARKS(SQLiteInMemory, DatabaseBackend::SQLITE_IN_MEMORY)
+REGISTER_DATABASE_BENCHMARKS(Mmap, DatabaseBackend::MMAP)
+REGISTER_DATABASE_BENCHMARKS(Shard, DatabaseBackend::SHARD)
+
+#undef REGISTER_DATABASE_BENCHMARKS
+
+BENCHMARK_MAIN();
@@ -0,0 +1,432 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/feature/aliked.h"
+#include "colmap/feature/extractor.h"
+#include "colmap/feature/index.h"
+#include "colmap/feature/matcher.h"
+#include "colmap/feature/sift.h"
+#include "colmap/feature/utils.h"
+#include "colmap/math/random.h"
+#include "colmap/sensor/bitmap.h"
+#include "colmap/util/file.h"
+
+#include <algorithm>
+#include <map>
+
+#include <benchmark/benchmark.h>
+#include <glog/logging.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace colmap;
+
+// Images and features are extracted from a fixed number of images, which are
+// processed in a round-robin fashion during the benchmark iterations.
+constexpr int kNumImages = 8;
+
+// Environment variable with an optional directory of real images, which are
+// used instead of the synthetic images, e.g., to reproduce regressions on a
+// specific dataset.
+constexpr char kImagePathEnvVar[] = "COLMAP_BENCHMARK_IMAGE_PATH";
+
+// Creates overlapping crops of a shared canvas with random rectangles of
+// random intensity, so that consecutive images produce feature matches.
+std::vector<Bitmap> CreateSyntheticImages(const int num_images,
+                                          const int max_image_size,
+                                          const bool as_rgb) {
+  SetPRNGSeed(42);
+
+  const int width = max_image_size;
+  const int height = max_image_size * 3 / 4;
+  const int step = width / 10;
+  const int canvas_width = width + (num_images - 1) * step;
+
+  Bitmap canvas(canvas_width, height, /*as_rgb=*/false);
+  canvas.Fill(BitmapColor<uint8_t>(128));
+  const int num_rectangles = canvas_width * height / 2000;
+  for (int i = 0; i < num_rectangles; ++i) {
+    const int rect_width = RandomUniformInteger(4, width / 20);
+    const int rect_height = RandomUniformInteger(4, width / 20);
+    const int x0 = RandomUniformInteger(0, canvas_width - rect_width);
+    const int y0 = RandomUniformInteger(0, height - rect_height);
+    const BitmapColor<uint8_t> color(RandomUniformInteger(0, 255));
+    for (int y = y0; y < y0 + rect_height; ++y) {
+      for (int x = x0; x < x0 + rect_width; ++x) {
+        canvas.SetPixel(x, y, color);
+      }
+    }
+  }
+
+  std::vector<Bitmap> images;
+  images.reserve(num_images);
+  for (int i = 0; i < num_images; ++i) {
+    Bitmap image(width, height, /*as_rgb=*/false);
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        image.SetPixel(x, y, *canvas.GetPixel(i * step + x, y));
+      }
+    }
+    images.push_back(as_rgb ? image.CloneAsRGB() : std::move(image));
+  }
+  return images;
+}
+
+// Reads the first images from the given directory and downscales them to the
+// maximum image size.
+std::vector<Bitmap> ReadImages(const std::filesystem::path& path,
+                               const int num_images,
+                               const int max_image_size,
+                               const bool as_rgb) {
+  std::vector<std::filesystem::path> image_paths = GetRecursiveFileList(path);
+  std::sort(image_paths.begin(), image_paths.end());
+
+  std::vector<Bitmap> images;
+  for (const auto& image_path : image_paths) {
+    if (static_cast<int>(images.size()) >= num_images) {
+      break;
+    }
+    Bitmap image;
+    if (!image.Read(image_path, as_rgb)) {
+      continue;
+    }
+    const int image_size = std::max(image.Width(), image.Height());
+    if (image_size > max_image_size) {
+      const double scale = static_cast<double>(max_image_size) / image_size;
+      image.Rescale(static_cast<int>(image.Width() * scale),
+                    static_cast<int>(image.Height() * scale));
+    }
+    images.push_back(std::move(image));
+  }
+  THROW_CHECK(!images.empty()) << "No images found in " << path;
+  return images;
+}
+
+// Returns the cached benchmark images, which are read from the directory in
+// the environment variable, if set, or otherwise synthesized.
+const std::vector<Bitmap>& GetImages(const int max_image_size,
+                                     const bool as_rgb) {
+  static std::map<std::pair<int, bool>, std::vector<Bitmap>> cache;
+  auto& images = cache[{max_image_size, as_rgb}];
+  if (images.empty()) {
+    if (const std::optional<std::string> image_path =
+            GetEnvSafe(kImagePathEnvVar);
+        image_path.has_value() && !image_path->empty()) {
+      images = ReadImages(*image_path, kNumImages, max_image_size, as_rgb);
+    } else {
+      images = CreateSyntheticImages(kNumImages, max_image_size, as_rgb);
+    }
+  }
+  return images;
+}
+
+struct ImageFeatures {
+  std::vector<std::shared_ptr<const FeatureKeypoints>> keypoints;
+  std::vector<std::shared_ptr<const FeatureDescriptors>> descriptors;
+};
+
+// Returns the cached features of the benchmark images, which are extracted
+// on the CPU to make the matching benchmarks independent of the extraction.
+const ImageFeatures& GetImageFeatures(const FeatureExtractorType type,
+                                      const int max_num_features) {
+  static std::map<std::pair<FeatureExtractorType, int>, ImageFeatures> cache;
+  ImageFeatures& features = cache[{type, max_num_features}];
+  if (features.keypoints.empty()) {
+    FeatureExtractionOptions options(type);
+    options.use_gpu = false;
+    if (type == FeatureExtractorType::SIFT) {
+      options.sift->max_num_features = max_num_features;
+    } else {
+      options.aliked->max_num_features = max_num_features;
+    }
+    auto extractor = THROW_CHECK_NOTNULL(FeatureExtractor::Create(options));
+    const int max_image_size = std::min(options.EffMaxImageSize(), 1600);
+    for (const Bitmap& image :
+         GetImages(max_image_size, options.RequiresRGB())) {
+      auto keypoints = std::make_shared<FeatureKeypoints>();
+      auto descriptors = std::make_shared<FeatureDescriptors>();
+      THROW_CHECK(
+          extractor->Extract(image, keypoints.get(), descriptors.get()));
+      features.keypoints.push_back(std::move(keypoints));
+      features.descriptors.push_back(std::move(descriptors));
+    }
+  }
+  return features;
+}
+
+// Creates random unit-length descriptors with a perturbed copy of each
+// descriptor, such that every query has a distinct nearest neighbor.
+FeatureDescriptorsFloat CreateRandomDescriptors(const int num_descriptors,
+                                                const int num_dims) {
+  SetPRNGSeed(42);
+  FeatureDescriptorsFloatData data(num_descriptors, num_dims);
+  for (int i = 0; i < num_descriptors; ++i) {
+    for (int j = 0; j < num_dims; ++j) {
+      data(i, j) = RandomUniformReal(0.f, 1.f);
+    }
+  }
+  L2NormalizeFeatureDescriptors(&data);
+  return FeatureDescriptorsFloat(FeatureExtractorType::SIFT, std::move(data));
+}
+
+// Reports the peak resident memory of the process in megabytes.
+void ReportPeakMemory(benchmark::State& state) {
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+    const double num_bytes = usage.ru_maxrss;
+#else
+    const double num_bytes = usage.ru_maxrss * 1024.0;
+#endif
+    state.counters["peak_mem_mb"] = num_bytes / (1024 * 1024);
+  }
+#endif
+}
+
+static void BM_FeatureExtraction(benchmark::State& state,
+                                 const FeatureExtractorType type,
+                                 const bool use_gpu) {
+  FLAGS_minloglevel = 2;  // Suppress INFO and WARNING logs.
+
+  FeatureExtractionOptions options(type);
+  options.max_image_size = state.range(0);
+  options.use_gpu = use_gpu;
+  options.gpu_index = "0";
+  auto extractor = FeatureExtractor::Create(options);
+  if (extractor == nullptr) {
+    state.SkipWithError("Failed to create feature extractor");
+    return;
+  }
+
+  const std::vector<Bitmap>& images =
+      GetImages(options.max_image_size, options.RequiresRGB());
+
+  size_t image_idx = 0;
+  size_t num_features = 0;
+  FeatureKeypoints keypoints;
+  FeatureDescriptors descriptors;
+  for (auto _ : state) {
+    const Bitmap& image = images[image_idx++ % images.size()];
+    if (!extractor->Extract(image, &keypoints, &descriptors)) {
+      state.SkipWithError("Failed to extract features");
+      break;
+    }
+    num_features += keypoints.size();
+  }
+
+  state.counters["images/s"] =
+      benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+  state.counters["features"] =
+      benchmark::Counter(num_features, benchmark::Counter::kAvgIterations);
+  ReportPeakMemory(state);
+}
+
+static void BM_FeatureMatching(benchmark::State& state,
+                               const FeatureMatcherType type,
+                               const bool use_gpu) {
+  FLAGS_minloglevel = 2;  // Suppress INFO and WARNING logs.
+
+  const FeatureExtractorType extractor_type =
+      (type == FeatureMatcherType::SIFT_BRUTEFORCE ||
+       type == FeatureMatcherType::SIFT_LIGHTGLUE)
+          ? FeatureExtractorType::SIFT
+          : FeatureExtractorType::ALIKED_N16ROT;
+  const ImageFeatures& features =
+      GetImageFeatures(extractor_type, state.range(0));
+
+  FeatureMatchingOptions options(type);
+  options.use_gpu = use_gpu;
+  options.gpu_index = "0";
+  auto matcher = FeatureMatcher::Create(options);
+  if (matcher == nullptr) {
+    state.SkipWithError("Failed to create feature matcher");
+    return;
+  }
+
+  const size_t num_images = features.keypoints.size();
+  std::vector<FeatureMatcher::Image> images(num_images);
+  for (size_t i = 0; i < num_images; ++i) {
+    images[i].image_id = i + 1;
+    images[i].keypoints = features.keypoints[i];
+    images[i].descriptors = features.descriptors[i];
+  }
+
+  // Match consecutive, overlapping images.
+  size_t pair_idx = 0;
+  size_t num_matches = 0;
+  FeatureMatches matches;
+  for (auto _ : state) {
+    const size_t image_idx1 = pair_idx++ % num_images;
+    const size_t image_idx2 = (image_idx1 + 1) % num_images;
+    matcher->Match(images[image_idx1], images[image_idx2], &matches);
+    num_matches += matches.size();
+  }
+
+  state.counters["pairs/s"] =
+      benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+  state.counters["matches"] =
+      benchmark::Counter(num_matches, benchmark::Counter::kAvgIterations);
+  ReportPeakMemory(state);
+}
+
+static void BM_FeatureDescriptorIndexBuild(benchmark::State& state) {
+  const FeatureDescriptorsFloat descriptors =
+      CreateRandomDescriptors(state.range(0), 128);
+  for (auto _ : state) {
+    auto index = FeatureDescriptorIndex::Create(
+        FeatureDescriptorIndex::Type::FAISS, state.range(1));
+    index->Build(descriptors);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  ReportPeakMemory(state);
+}
+
+static void BM_FeatureDescriptorIndexSearch(benchmark::State& state) {
+  const FeatureDescriptorsFloat descriptors =
+      CreateRandomDescriptors(state.range(0), 128);
+  auto index = FeatureDescriptorIndex::Create(
+      FeatureDescriptorIndex::Type::FAISS, state.range(1));
+  index->Build(descriptors);
+
+  FeatureDescriptorsFloat query_descriptors = descriptors;
+  query_descriptors.data +=
+      0.01f * FeatureDescriptorsFloatData::Random(descriptors.data.rows(),
+                                                  descriptors.data.cols());
+  L2NormalizeFeatureDescriptors(&query_descriptors.data);
+
+  Eigen::RowMajorMatrixXi indices;
+  Eigen::RowMajorMatrixXf l2_dists;
+  for (auto _ : state) {
+    index->Search(/*num_neighbors=*/2, query_descriptors, indices, l2_dists);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  ReportPeakMemory(state);
+}
+
+// Args: {max_image_size}
+BENCHMARK_CAPTURE(BM_FeatureExtraction,
+                  SiftCPU,
+                  FeatureExtractorType::SIFT,
+                  /*use_gpu=*/false)
+    ->Arg(640)
+    ->Arg(1600)
+    ->Arg(3200)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+#ifdef COLMAP_CUDA_ENABLED
+BENCHMARK_CAPTURE(BM_FeatureExtraction,
+                  SiftGPU,
+                  FeatureExtractorType::SIFT,
+                  /*use_gpu=*/true)
+    ->Arg(640)
+    ->Arg(1600)
+    ->Arg(3200)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+#endif
+
+#ifdef COLMAP_ONNX_ENABLED
+BENCHMARK_CAPTURE(BM_FeatureExtraction,
+                  AlikedCPU,
+                  FeatureExtractorType::ALIKED_N16ROT,
+                  /*use_gpu=*/false)
+    ->Arg(640)
+    ->Arg(1024)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+#ifdef COLMAP_CUDA_ENABLED
+BENCHMARK_CAPTURE(BM_FeatureExtraction,
+                  AlikedGPU,
+                  FeatureExtractorType::ALIKED_N16ROT,
+                  /*use_gpu=*/true)
+    ->Arg(640)
+    ->Arg(1024)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+#endif
+#endif
+
+// Args: {max_num_features}
+BENCHMARK_CAPTURE(BM_FeatureMatching,
+                  SiftBruteForceCPU,
+                  FeatureMatcherType::SIFT_BRUTEFORCE,
+                  /*use_gpu=*/false)
+    ->Arg(2048)
+    ->Arg(8192)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+#ifdef COLMAP_CUDA_ENABLED
+BENCHMARK_CAPTURE(BM_FeatureMatching,
+                  SiftBruteForceGPU,
+                  FeatureMatcherType::SIFT_BRUTEFORCE,
+                  /*use_gpu=*/true)
+    ->Arg(2048)
+    ->Arg(8192)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+#endif
+
+#ifdef COLMAP_ONNX_ENABLED
+BENCHMARK_CAPTURE(BM_FeatureMatching,
+                  AlikedLightGlueCPU,
+                  FeatureMatcherType::ALIKED_LIGHTGLUE,
+                  /*use_gpu=*/false)
+    ->Arg(1024)
+    ->Arg(2048)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+#ifdef COLMAP_CUDA_ENABLED
+BENCHMARK_CAPTURE(BM_FeatureMatching,
+                  AlikedLightGlueGPU,
+                  FeatureMatcherType::ALIKED_LIGHTGLUE,
+                  /*use_gpu=*/true)
+    ->Arg(1024)
+    ->Arg(2048)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+#endif
+#endif
+
+// Args: {num_descriptors, num_threads}
+BENCHMARK(BM_FeatureDescriptorIndexBuild)
+    ->ArgsProduct({{1000, 10000}, {1, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_FeatureDescriptorIndexSearch)
+    ->ArgsProduct({{1000, 10000}, {1, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,163 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// Measures how the incremental and global mappers scale with the number of
+// images and threads on synthetic scenes. For each run, outputs one JSON
+// object per line to stdout with the total runtime, the reconstruction
+// statistics, and the per-stage runtimes of the traced zones (e.g.,
+// RegisterNextImage, TriangulateImage, AdjustLocalBundle, AdjustGlobalBundle,
+// FilterPoints, RotationAveraging, GlobalPositioning). Stage runtimes are
+// inclusive of nested stages.
+//
+// Usage:
+//   mapper_scaling \
+//       [--mappers=incremental,global] [--num_frames=25,50,100] \
+//       [--num_threads=1,-1] [--num_points3D_per_frame=N] \
+//       [--track_length=N] [--point2D_stddev=X] [--label=NAME]
+
+#include "colmap/controllers/base_option_manager.h"
+#include "colmap/controllers/global_pipeline.h"
+#include "colmap/controllers/incremental_pipeline.h"
+#include "colmap/scene/database_sqlite.h"
+#include "colmap/scene/reconstruction.h"
+#include "colmap/scene/reconstruction_manager.h"
+#include "colmap/scene/synthetic.h"
+#include "colmap/util/misc.h"
+#include "colmap/util/timer.h"
+#include "colmap/util/tracing.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+using namespace colmap;
+
+int main(int argc, char** argv) {
+  std::string mappers = "incremental,global";
+  std::string num_frames_list = "25,50,100";
+  std::string num_threads_list = "1,-1";
+  int num_points3D_per_frame = 100;
+  int track_length = 8;
+  double point2D_stddev = 0.5;
+  std::string label = "default";
+
+  BaseOptionManager args(/*add_project_options=*/false);
+  args.AddDefaultOption("mappers", &mappers);
+  args.AddDefaultOption("num_frames", &num_frames_list);
+  args.AddDefaultOption("num_threads", &num_threads_list);
+  args.AddDefaultOption("num_points3D_per_frame", &num_points3D_per_frame);
+  args.AddDefaultOption("track_length", &track_length);
+  args.AddDefaultOption("point2D_stddev", &point2D_stddev);
+  args.AddDefaultOption("label", &label);
+  if (!args.Parse(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  SetTracingEnabled(true);
+
+  for (const int num_frames : CSVToVector<int>(num_frames_list)) {
+    for (const int num_threads : CSVToVector<int>(num_threads_list)) {
+      for (const std::string& mapper : CSVToVector<std::string>(mappers)) {
+        // Synthesize a fresh scene for each run, so that runs share no state.
+        SetPRNGSeed(42);
+
+        auto database = Database::Open(kInMemorySqliteDatabasePath);
+        SyntheticDatasetOptions dataset_options;
+        dataset_options.num_rigs = 1;
+        dataset_options.num_cameras_per_rig = 1;
+        dataset_options.num_frames_per_rig = num_frames;
+        dataset_options.num_points3D = num_frames * num_points3D_per_frame;
+        dataset_options.track_length = std::min(track_length, num_frames);
+        dataset_options.camera_has_prior_focal_length = true;
+        Reconstruction gt_reconstruction;
+        SynthesizeDataset(dataset_options, &gt_reconstruction, database.get());
+
+        SyntheticNoiseOptions noise_options;
+        noise_options.point2D_stddev = point2D_stddev;
+        SynthesizeNoise(noise_options, &gt_reconstruction, database.get());
+
+        auto reconstruction_manager = std::make_shared<ReconstructionManager>();
+        ClearTrace();
+        Timer timer;
+        timer.Start();
+        if (mapper == "incremental") {
+          auto options = std::make_shared<IncrementalPipelineOptions>();
+          options->num_threads = num_threads;
+          IncrementalPipeline pipeline(
+              options, std::move(database), reconstruction_manager);
+          pipeline.Run();
+        } else if (mapper == "global") {
+          GlobalPipelineOptions options;
+          options.num_threads = num_threads;
+          options.random_seed = 42;
+          GlobalPipeline pipeline(
+              options, std::move(database), reconstruction_manager);
+          pipeline.Run();
+        } else {
+          std::cerr << "Unknown mapper: " << mapper << "\n";
+          return EXIT_FAILURE;
+        }
+        const double total_seconds = timer.ElapsedSeconds();
+
+        size_t num_reg_images = 0;
+        size_t num_points3D = 0;
+        double mean_reproj_error = 0;
+        if (reconstruction_manager->Size() > 0) {
+          const auto& reconstruction = *reconstruction_manager->Get(0);
+          num_reg_images = reconstruction.NumRegImages();
+          num_points3D = reconstruction.NumPoints3D();
+          mean_reproj_error = reconstruction.ComputeMeanReprojectionError();
+        }
+
+        std::cout << "{\"label\":\"" << label << "\",\"mapper\":\"" << mapper
+                  << "\",\"num_images\":" << gt_reconstruction.NumImages()
+                  << ",\"num_threads\":" << num_threads
+                  << ",\"total_s\":" << total_seconds
+                  << ",\"num_models\":" << reconstruction_manager->Size()
+                  << ",\"num_reg_images\":" << num_reg_images
+                  << ",\"num_points3D\":" << num_points3D
+                  << ",\"mean_reproj_error\":" << mean_reproj_error
+                  << ",\"stages\":{";
+        bool first_stage = true;
+        for (const auto& [name, summary] : SummarizeTraceZones()) {
+          std::cout << (first_stage ? "" : ",") << "\"" << name
+                    << "\":{\"calls\":" << summary.num_calls
+                    << ",\"total_s\":" << summary.total_duration_us * 1e-6
+                    << ",\"max_s\":" << summary.max_duration_us * 1e-6
+                    << ",\"items\":" << summary.num_items << "}";
+          first_stage = false;
+        }
+        std::cout << "}}" << std::endl;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
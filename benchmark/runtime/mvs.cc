@@ -0,0 +1,330 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/math/math.h"
+#include "colmap/mvs/fusion.h"
+#include "colmap/mvs/patch_match.h"
+#include "colmap/scene/reconstruction.h"
+#include "colmap/scene/synthetic.h"
+#include "colmap/sensor/bitmap.h"
+#include "colmap/util/file.h"
+#include "colmap/util/tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+
+#include <benchmark/benchmark.h>
+#include <glog/logging.h>
+
+using namespace colmap;
+
+// The depth of the synthetic plane along the optical axis and its slope along
+// the x-axis, such that the depth varies across the reference image.
+constexpr float kPlaneDepth = 5.0f;
+constexpr float kPlaneSlope = 0.2f;
+
+// Ground-truth depth of the synthetic plane for a camera translated along the
+// x-axis by tx, where u is the normalized image x-coordinate.
+float PlaneDepth(const float u, const float tx) {
+  return (kPlaneDepth - kPlaneSlope * tx) / (1.0f - kPlaneSlope * u);
+}
+
+// Renders a textured, slanted plane for a camera translated along the x-axis.
+mvs::Image CreatePlaneImage(const int width, const int height, const float tx) {
+  const float f = 0.8f * width;
+  const float K[9] = {f, 0, width / 2.0f, 0, f, height / 2.0f, 0, 0, 1};
+  const float R[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  const float T[3] = {tx, 0, 0};
+  mvs::Image image("", width, height, K, R, T);
+  Bitmap bitmap(width, height, /*as_rgb=*/false);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const float u = (x - K[2]) / K[0];
+      const float v = (y - K[5]) / K[4];
+      const float depth = PlaneDepth(u, tx);
+      const float X = u * depth - tx;
+      const float Y = v * depth;
+      const float intensity = 127.5f + 60.0f * std::sin(7.0f * X) +
+                              60.0f * std::cos(5.0f * Y + 3.0f * X * X);
+      bitmap.SetPixel(x, y, BitmapColor<uint8_t>(intensity));
+    }
+  }
+  image.SetBitmap(bitmap);
+  return image;
+}
+
+// Returns the cached images of a reference view and source views, which are
+// symmetrically translated to both sides of the reference view.
+std::vector<mvs::Image>& GetPlaneImages(const int width,
+                                        const int num_src_images) {
+  static std::map<std::pair<int, int>, std::vector<mvs::Image>> cache;
+  auto& images = cache[{width, num_src_images}];
+  if (images.empty()) {
+    const int height = width * 3 / 4;
+    images.push_back(CreatePlaneImage(width, height, 0.0f));
+    for (int i = 0; i < num_src_images; ++i) {
+      const float tx = 0.25f * (i / 2 + 1) * (i % 2 == 0 ? 1 : -1);
+      images.push_back(CreatePlaneImage(width, height, tx));
+    }
+  }
+  return images;
+}
+
+// Reports the mean runtime per call of the traced zone in milliseconds.
+void ReportTraceZone(benchmark::State& state,
+                     const std::map<std::string, TraceZoneSummary>& summaries,
+                     const std::string& zone_name,
+                     const std::string& counter_name) {
+  const auto it = summaries.find(zone_name);
+  if (it != summaries.end() && it->second.num_calls > 0) {
+    state.counters[counter_name] =
+        1e-3 * it->second.total_duration_us / it->second.num_calls;
+  }
+}
+
+static void BM_PatchMatch(benchmark::State& state, const bool use_gpu) {
+  FLAGS_minloglevel = 2;
+
+  const int width = state.range(0);
+  const int num_src_images = 4;
+  std::vector<mvs::Image>& images = GetPlaneImages(width, num_src_images);
+
+  mvs::PatchMatchOptions options;
+  options.use_gpu = use_gpu;
+  options.depth_min = 1.0f;
+  options.depth_max = 20.0f;
+  options.window_radius = state.range(1);
+  options.num_samples = state.range(2);
+  options.geom_consistency = false;
+  options.filter = false;
+
+  mvs::PatchMatch::Problem problem;
+  problem.ref_image_idx = 0;
+  for (int i = 1; i <= num_src_images; ++i) {
+    problem.src_image_idxs.push_back(i);
+  }
+  problem.images = &images;
+
+  ClearTrace();
+  SetTracingEnabled(true);
+  mvs::DepthMap depth_map;
+  for (auto _ : state) {
+    mvs::PatchMatch patch_match(options, problem);
+    patch_match.Run();
+    depth_map = patch_match.GetDepthMap();
+  }
+  SetTracingEnabled(false);
+
+  const std::map<std::string, TraceZoneSummary> summaries =
+      SummarizeTraceZones();
+  ClearTrace();
+  ReportTraceZone(state, summaries, "PatchMatchInitialCost", "init_cost_ms");
+  ReportTraceZone(state, summaries, "PatchMatchSweep", "sweep_ms");
+
+  const int height = depth_map.GetHeight();
+  state.counters["MP/s"] =
+      benchmark::Counter(1e-6 * width * height,
+                         benchmark::Counter::kIsIterationInvariantRate);
+
+  // Evaluate the accuracy of the last depth map, excluding the border pixels
+  // that are not fully covered by the windows.
+  const float* K = images[0].GetK();
+  const int border = options.window_radius;
+  std::vector<float> rel_errors;
+  rel_errors.reserve((width - 2 * border) * (height - 2 * border));
+  for (int row = border; row < height - border; ++row) {
+    for (int col = border; col < width - border; ++col) {
+      const float depth = PlaneDepth((col - K[2]) / K[0], 0.0f);
+      rel_errors.push_back(std::abs(depth_map.Get(row, col) - depth) / depth);
+    }
+  }
+  const size_t num_accurate = std::count_if(
+      rel_errors.begin(), rel_errors.end(), [](const float rel_error) {
+        return rel_error < 0.01f;
+      });
+  state.counters["accurate_1%"] =
+      static_cast<double>(num_accurate) / rel_errors.size();
+  state.counters["median_rel_error"] = Median(rel_errors);
+}
+
+// Writes a synthetic dense workspace with consistent depth and normal maps of
+// a sphere around the origin, which are observed by all images. Returns the
+// radius of the sphere.
+double CreateFusionWorkspace(const std::filesystem::path& path,
+                             const int num_frames,
+                             const int width,
+                             const int height) {
+  CreateDirIfNotExists(path / "sparse", /*recursive=*/true);
+  CreateDirIfNotExists(path / "images");
+  CreateDirIfNotExists(path / "stereo");
+  CreateDirIfNotExists(path / "stereo" / "depth_maps");
+  CreateDirIfNotExists(path / "stereo" / "normal_maps");
+
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = num_frames;
+  synthetic_dataset_options.camera_width = width;
+  synthetic_dataset_options.camera_height = height;
+  synthetic_dataset_options.camera_params = {
+      1.25 * width, 0.5 * width, 0.5 * height, 0.0};
+  Reconstruction reconstruction;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+  reconstruction.Write(path / "sparse");
+
+  double sphere_radius = std::numeric_limits<double>::max();
+  for (const auto& [image_id, image] : reconstruction.Images()) {
+    sphere_radius =
+        std::min(sphere_radius, 0.3 * image.ProjectionCenter().norm());
+  }
+
+  std::ofstream fusion_cfg(path / "stereo" / "fusion.cfg");
+  for (const auto& [image_id, image] : reconstruction.Images()) {
+    fusion_cfg << image.Name() << "\n";
+
+    mvs::Mat<float> depth_map(width, height, 1);
+    mvs::Mat<float> normal_map(width, height, 3);
+    const Rigid3d cam_from_world = image.CamFromWorld();
+    const Eigen::Vector3d center = image.ProjectionCenter();
+    const Eigen::Matrix3d inv_K =
+        image.CameraPtr()->CalibrationMatrix().inverse();
+    for (int row = 0; row < height; ++row) {
+      for (int col = 0; col < width; ++col) {
+        // Intersect the ray with unit depth in the camera frame with the
+        // sphere.
+        const Eigen::Vector3d ray = cam_from_world.rotation().inverse() *
+                                    (inv_K * Eigen::Vector3d(col, row, 1));
+        const double a = ray.squaredNorm();
+        const double b = 2 * ray.dot(center);
+        const double c = center.squaredNorm() - sphere_radius * sphere_radius;
+        const double discriminant = b * b - 4 * a * c;
+        if (discriminant < 0) {
+          depth_map.Set(row, col, 0.0f);
+          for (int d = 0; d < 3; ++d) {
+            normal_map.Set(row, col, d, 0.0f);
+          }
+          continue;
+        }
+        const double depth = (-b - std::sqrt(discriminant)) / (2 * a);
+        depth_map.Set(row, col, depth);
+        const Eigen::Vector3d normal =
+            cam_from_world.rotation() * (center + depth * ray).normalized();
+        for (int d = 0; d < 3; ++d) {
+          normal_map.Set(row, col, d, normal(d));
+        }
+      }
+    }
+
+    depth_map.Write(path / "stereo" / "depth_maps" /
+                    (image.Name() + ".geometric.bin"));
+    normal_map.Write(path / "stereo" / "normal_maps" /
+                     (image.Name() + ".geometric.bin"));
+
+    Bitmap bitmap(width, height, /*as_rgb=*/true);
+    bitmap.Fill(BitmapColor<uint8_t>(0, 64, 128));
+    bitmap.Write(path / "images" / image.Name());
+  }
+
+  return sphere_radius;
+}
+
+static void BM_StereoFusion(benchmark::State& state) {
+  FLAGS_minloglevel = 2;
+
+  const int num_frames = state.range(0);
+  const int width = 640;
+  const int height = 480;
+
+  static std::map<int, double> sphere_radii;
+  const std::filesystem::path workspace_path =
+      std::filesystem::temp_directory_path() / "colmap_benchmark_fusion" /
+      std::to_string(num_frames);
+  if (sphere_radii.count(num_frames) == 0) {
+    sphere_radii[num_frames] =
+        CreateFusionWorkspace(workspace_path, num_frames, width, height);
+  }
+  const double sphere_radius = sphere_radii.at(num_frames);
+
+  mvs::StereoFusionOptions options;
+  options.num_threads = state.range(1);
+
+  size_t num_points = 0;
+  double sum_radius_error = 0;
+  for (auto _ : state) {
+    mvs::StereoFusion fusion(
+        options, workspace_path, "COLMAP", "", "geometric");
+    fusion.Run();
+
+    state.PauseTiming();
+    const auto& points = fusion.GetFusedPoints();
+    num_points += points.size();
+    for (const auto& point : points) {
+      sum_radius_error +=
+          std::abs(Eigen::Vector3d(point.x, point.y, point.z).norm() -
+                   sphere_radius);
+    }
+    state.ResumeTiming();
+  }
+
+  state.counters["MP/s"] =
+      benchmark::Counter(1e-6 * num_frames * width * height,
+                         benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["points"] =
+      benchmark::Counter(num_points, benchmark::Counter::kAvgIterations);
+  if (num_points > 0) {
+    state.counters["mean_rel_error"] =
+        sum_radius_error / num_points / sphere_radius;
+  }
+}
+
+// Args: {width, window_radius, num_samples}
+BENCHMARK_CAPTURE(BM_PatchMatch, CPU, /*use_gpu=*/false)
+    ->ArgsProduct({{320, 640}, {3, 5}, {15}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+#ifdef COLMAP_CUDA_ENABLED
+BENCHMARK_CAPTURE(BM_PatchMatch, GPU, /*use_gpu=*/true)
+    ->ArgsProduct({{640, 1280, 2560}, {3, 5, 7}, {7, 15, 30}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+#endif
+
+// Args: {num_frames, num_threads}
+BENCHMARK(BM_StereoFusion)
+    ->ArgsProduct({{10, 30}, {1, 4, -1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
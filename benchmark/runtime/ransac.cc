@@ -0,0 +1,591 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/estimators/generalized_pose.h"
+#include "colmap/estimators/pose.h"
+#include "colmap/estimators/solvers/absolute_pose.h"
+#include "colmap/estimators/solvers/essential_matrix.h"
+#include "colmap/geometry/essential_matrix.h"
+#include "colmap/geometry/rigid3.h"
+#include "colmap/math/math.h"
+#include "colmap/math/random.h"
+#include "colmap/optim/loransac.h"
+#include "colmap/scene/reconstruction.h"
+#include "colmap/scene/synthetic.h"
+#include "colmap/sensor/models.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+#include <benchmark/benchmark.h>
+#include <glog/logging.h>
+
+using namespace colmap;
+
+// Parameters of the synthetic scenes, as given by the benchmark arguments:
+// {num_points3D, inlier_ratio [%], point2D_stddev [0.1px], camera_model_idx}.
+struct SceneArgs {
+  int num_points3D = 0;
+  double inlier_ratio = 1.0;
+  double point2D_stddev = 0.0;
+  int camera_model_idx = 0;
+};
+
+SceneArgs GetSceneArgs(const benchmark::State& state) {
+  SceneArgs args;
+  args.num_points3D = state.range(0);
+  args.inlier_ratio = state.range(1) / 100.0;
+  args.point2D_stddev = state.range(2) / 10.0;
+  args.camera_model_idx = state.range(3);
+  return args;
+}
+
+static void SceneArguments(benchmark::Benchmark* b) {
+  b->ArgsProduct({{200, 2000}, {30, 60, 90}, {0, 10}, {0, 1, 2}});
+}
+
+// Synthesizes a scene with a single rig and noisy 2D observations.
+Reconstruction SynthesizeScene(const SceneArgs& args,
+                               const int num_cameras_per_rig,
+                               const int num_frames_per_rig) {
+  SetPRNGSeed(42);
+
+  SyntheticDatasetOptions options;
+  options.num_rigs = 1;
+  options.num_cameras_per_rig = num_cameras_per_rig;
+  options.num_frames_per_rig = num_frames_per_rig;
+  options.num_points3D = args.num_points3D;
+  options.num_points2D_without_point3D = 0;
+  switch (args.camera_model_idx) {
+    case 0:
+      options.camera_model_id = SimplePinholeCameraModel::model_id;
+      options.camera_params = {1280, 512, 384};
+      break;
+    case 1:
+      options.camera_model_id = SimpleRadialCameraModel::model_id;
+      options.camera_params = {1280, 512, 384, 0.05};
+      break;
+    case 2:
+      options.camera_model_id = OpenCVFisheyeCameraModel::model_id;
+      options.camera_params = {1280, 1280, 512, 384, 0.05, 0.01, 0, 0};
+      break;
+    default:
+      LOG(FATAL) << "Unknown camera model index: " << args.camera_model_idx;
+  }
+
+  Reconstruction reconstruction;
+  SynthesizeDataset(options, &reconstruction);
+
+  SyntheticNoiseOptions noise_options;
+  noise_options.point2D_stddev = args.point2D_stddev;
+  SynthesizeNoise(noise_options, &reconstruction);
+
+  return reconstruction;
+}
+
+// Replaces a random subset of the 2D points with uniformly random points in
+// the image, such that the given ratio of the points are inliers. Returns the
+// ground-truth inlier mask.
+std::vector<char> AddOutliers(const double inlier_ratio,
+                              const Camera& camera,
+                              std::vector<Eigen::Vector2d>* points2D) {
+  const size_t num_points = points2D->size();
+  std::vector<size_t> shuffled_idxs(num_points);
+  std::iota(shuffled_idxs.begin(), shuffled_idxs.end(), 0);
+  std::shuffle(shuffled_idxs.begin(), shuffled_idxs.end(), *PRNG);
+
+  std::vector<char> inlier_mask(num_points, true);
+  const size_t num_inliers = std::round(inlier_ratio * num_points);
+  for (size_t i = num_inliers; i < num_points; ++i) {
+    (*points2D)[shuffled_idxs[i]] =
+        Eigen::Vector2d(RandomUniformReal<double>(0, camera.width),
+                        RandomUniformReal<double>(0, camera.height));
+    inlier_mask[shuffled_idxs[i]] = false;
+  }
+  return inlier_mask;
+}
+
+double RotationErrorDeg(const Rigid3d& b_from_a, const Rigid3d& gt_b_from_a) {
+  return RadToDeg(b_from_a.rotation().angularDistance(gt_b_from_a.rotation()));
+}
+
+double TranslationDirectionErrorDeg(const Rigid3d& b_from_a,
+                                    const Rigid3d& gt_b_from_a) {
+  const double cos_angle = b_from_a.translation().normalized().dot(
+      gt_b_from_a.translation().normalized());
+  return RadToDeg(std::acos(std::clamp(cos_angle, -1.0, 1.0)));
+}
+
+double PositionError(const Rigid3d& b_from_a, const Rigid3d& gt_b_from_a) {
+  return (b_from_a.TgtOriginInSrc() - gt_b_from_a.TgtOriginInSrc()).norm();
+}
+
+// Accumulates the accuracy of the estimates over the benchmark iterations.
+class AccuracyStats {
+ public:
+  explicit AccuracyStats(std::vector<char> gt_inlier_mask)
+      : gt_inlier_mask_(std::move(gt_inlier_mask)) {}
+
+  void AddFailure() { ++num_estimates_; }
+
+  void Add(const double rotation_error,
+           const double translation_error,
+           const std::vector<char>& inlier_mask) {
+    ++num_estimates_;
+    ++num_successes_;
+    sum_rotation_error_ += rotation_error;
+    sum_translation_error_ += translation_error;
+    for (size_t i = 0; i < inlier_mask.size(); ++i) {
+      num_inliers_ += inlier_mask[i];
+      num_gt_inliers_ += gt_inlier_mask_[i];
+      num_true_inliers_ += inlier_mask[i] && gt_inlier_mask_[i];
+    }
+  }
+
+  void Report(const std::string& translation_error_name,
+              benchmark::State& state) const {
+    state.counters["success"] = static_cast<double>(num_successes_) /
+                                std::max<size_t>(1, num_estimates_);
+    if (num_successes_ == 0) {
+      return;
+    }
+    state.counters["rot_err_deg"] = sum_rotation_error_ / num_successes_;
+    state.counters[translation_error_name] =
+        sum_translation_error_ / num_successes_;
+    state.counters["precision"] = static_cast<double>(num_true_inliers_) /
+                                  std::max<size_t>(1, num_inliers_);
+    state.counters["recall"] = static_cast<double>(num_true_inliers_) /
+                               std::max<size_t>(1, num_gt_inliers_);
+  }
+
+ private:
+  const std::vector<char> gt_inlier_mask_;
+  size_t num_estimates_ = 0;
+  size_t num_successes_ = 0;
+  double sum_rotation_error_ = 0;
+  double sum_translation_error_ = 0;
+  size_t num_inliers_ = 0;
+  size_t num_gt_inliers_ = 0;
+  size_t num_true_inliers_ = 0;
+};
+
+// Reports the number of RANSAC trials per estimate and the time per trial.
+void ReportTrials(const size_t num_trials, benchmark::State& state) {
+  state.counters["trials"] =
+      benchmark::Counter(num_trials, benchmark::Counter::kAvgIterations);
+  state.counters["time/trial"] = benchmark::Counter(
+      num_trials, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+struct AbsolutePoseProblem {
+  Camera camera;
+  std::vector<Eigen::Vector2d> points2D;
+  std::vector<Eigen::Vector3d> points3D;
+  std::vector<char> gt_inlier_mask;
+  Rigid3d gt_cam_from_world;
+};
+
+AbsolutePoseProblem BuildAbsolutePoseProblem(const SceneArgs& args) {
+  const Reconstruction reconstruction = SynthesizeScene(
+      args, /*num_cameras_per_rig=*/1, /*num_frames_per_rig=*/1);
+  const Image& image = reconstruction.Image(reconstruction.RegImageIds()[0]);
+
+  AbsolutePoseProblem problem;
+  problem.camera = *image.CameraPtr();
+  problem.gt_cam_from_world = image.CamFromWorld();
+  for (const Point2D& point2D : image.Points2D()) {
+    if (point2D.HasPoint3D()) {
+      problem.points2D.push_back(point2D.xy);
+      problem.points3D.push_back(
+          reconstruction.Point3D(point2D.point3D_id).xyz);
+    }
+  }
+  problem.gt_inlier_mask =
+      AddOutliers(args.inlier_ratio, problem.camera, &problem.points2D);
+  return problem;
+}
+
+struct RelativePoseProblem {
+  Camera camera1;
+  Camera camera2;
+  std::vector<Eigen::Vector3d> cam_rays1;
+  std::vector<Eigen::Vector3d> cam_rays2;
+  std::vector<char> gt_inlier_mask;
+  Rigid3d gt_cam2_from_cam1;
+};
+
+RelativePoseProblem BuildRelativePoseProblem(const SceneArgs& args) {
+  const Reconstruction reconstruction = SynthesizeScene(
+      args, /*num_cameras_per_rig=*/1, /*num_frames_per_rig=*/2);
+  const std::vector<image_t> image_ids = reconstruction.RegImageIds();
+  const Image& image1 = reconstruction.Image(image_ids[0]);
+  const Image& image2 = reconstruction.Image(image_ids[1]);
+
+  RelativePoseProblem problem;
+  problem.camera1 = *image1.CameraPtr();
+  problem.camera2 = *image2.CameraPtr();
+  problem.gt_cam2_from_cam1 =
+      image2.CamFromWorld() * Inverse(image1.CamFromWorld());
+
+  std::unordered_map<point3D_t, Eigen::Vector2d> points2D1;
+  for (const Point2D& point2D : image1.Points2D()) {
+    if (point2D.HasPoint3D()) {
+      points2D1.emplace(point2D.point3D_id, point2D.xy);
+    }
+  }
+  std::vector<Eigen::Vector2d> matched_points2D1;
+  std::vector<Eigen::Vector2d> matched_points2D2;
+  for (const Point2D& point2D : image2.Points2D()) {
+    const auto it = points2D1.find(point2D.point3D_id);
+    if (point2D.HasPoint3D() && it != points2D1.end()) {
+      matched_points2D1.push_back(it->second);
+      matched_points2D2.push_back(point2D.xy);
+    }
+  }
+  problem.gt_inlier_mask =
+      AddOutliers(args.inlier_ratio, problem.camera2, &matched_points2D2);
+
+  for (size_t i = 0; i < matched_points2D1.size(); ++i) {
+    problem.cam_rays1.push_back(
+        problem.camera1.CamRayFromImg(matched_points2D1[i])
+            .value_or(Eigen::Vector3d::Zero()));
+    problem.cam_rays2.push_back(
+        problem.camera2.CamRayFromImg(matched_points2D2[i])
+            .value_or(Eigen::Vector3d::Zero()));
+  }
+  return problem;
+}
+
+struct GeneralizedPoseProblem {
+  std::vector<Camera> cameras;
+  std::vector<Rigid3d> cams_from_rig;
+  std::vector<Eigen::Vector2d> points2D1;
+  std::vector<size_t> camera_idxs1;
+  std::vector<Eigen::Vector3d> points3D;
+  std::vector<Eigen::Vector2d> points2D2;
+  std::vector<size_t> camera_idxs2;
+  std::vector<char> gt_inlier_mask;
+  Rigid3d gt_rig1_from_world;
+  Rigid3d gt_rig2_from_rig1;
+};
+
+// Builds the 2D-3D correspondences of the first frame and the 2D-2D
+// correspondences between the same cameras in both frames of a rig.
+GeneralizedPoseProblem BuildGeneralizedPoseProblem(const SceneArgs& args,
+                                                   const bool relative) {
+  constexpr int kNumCamerasPerRig = 3;
+  const Reconstruction reconstruction = SynthesizeScene(
+      args, kNumCamerasPerRig, /*num_frames_per_rig=*/relative ? 2 : 1);
+  const std::vector<frame_t>& frame_ids = reconstruction.RegFrameIds();
+  const Frame& frame1 = reconstruction.Frame(frame_ids[0]);
+
+  GeneralizedPoseProblem problem;
+  problem.gt_rig1_from_world = frame1.RigFromWorld();
+
+  std::unordered_map<camera_t, size_t> camera_id_to_idx;
+  std::unordered_map<camera_t, const Image*> frame2_images;
+  if (relative) {
+    const Frame& frame2 = reconstruction.Frame(frame_ids[1]);
+    problem.gt_rig2_from_rig1 =
+        frame2.RigFromWorld() * Inverse(frame1.RigFromWorld());
+    for (const data_t& data_id : frame2.ImageIds()) {
+      const Image& image = reconstruction.Image(data_id.id);
+      frame2_images.emplace(image.CameraId(), &image);
+    }
+  }
+
+  for (const data_t& data_id : frame1.ImageIds()) {
+    const Image& image1 = reconstruction.Image(data_id.id);
+    const size_t camera_idx = problem.cameras.size();
+    camera_id_to_idx.emplace(image1.CameraId(), camera_idx);
+    problem.cameras.push_back(*image1.CameraPtr());
+    problem.cams_from_rig.push_back(image1.CamFromWorld() *
+                                    Inverse(problem.gt_rig1_from_world));
+
+    std::unordered_map<point3D_t, Eigen::Vector2d> points2D2;
+    if (relative) {
+      for (const Point2D& point2D :
+           frame2_images.at(image1.CameraId())->Points2D()) {
+        if (point2D.HasPoint3D()) {
+          points2D2.emplace(point2D.point3D_id, point2D.xy);
+        }
+      }
+    }
+
+    for (const Point2D& point2D : image1.Points2D()) {
+      if (!point2D.HasPoint3D()) {
+        continue;
+      }
+      if (relative) {
+        const auto it = points2D2.find(point2D.point3D_id);
+        if (it == points2D2.end()) {
+          continue;
+        }
+        problem.points2D2.push_back(it->second);
+        problem.camera_idxs2.push_back(camera_idx);
+      }
+      problem.points2D1.push_back(point2D.xy);
+      problem.camera_idxs1.push_back(camera_idx);
+      problem.points3D.push_back(
+          reconstruction.Point3D(point2D.point3D_id).xyz);
+    }
+  }
+
+  // All cameras of the rig share the same calibration.
+  problem.gt_inlier_mask =
+      AddOutliers(args.inlier_ratio,
+                  problem.cameras[0],
+                  relative ? &problem.points2D2 : &problem.points2D1);
+  return problem;
+}
+
+RANSACOptions GetRANSACOptions() {
+  RANSACOptions options;
+  options.max_error = 4.0;
+  options.confidence = 0.9999;
+  options.min_inlier_ratio = 0.1;
+  options.max_num_trials = 10000;
+  options.random_seed = 42;
+  return options;
+}
+
+static void BM_EstimateAbsolutePose(benchmark::State& state) {
+  FLAGS_minloglevel = 2;  // Suppress INFO and WARNING logs.
+
+  const AbsolutePoseProblem problem =
+      BuildAbsolutePoseProblem(GetSceneArgs(state));
+
+  AbsolutePoseEstimationOptions options;
+  options.ransac_options.random_seed = 42;
+
+  AccuracyStats stats(problem.gt_inlier_mask);
+  for (auto _ : state) {
+    Camera camera = problem.camera;
+    Rigid3d cam_from_world;
+    size_t num_inliers;
+    std::vector<char> inlier_mask;
+    if (EstimateAbsolutePose(options,
+                             problem.points2D,
+                             problem.points3D,
+                             &cam_from_world,
+                             &camera,
+                             &num_inliers,
+                             &inlier_mask)) {
+      stats.Add(RotationErrorDeg(cam_from_world, problem.gt_cam_from_world),
+                PositionError(cam_from_world, problem.gt_cam_from_world),
+                inlier_mask);
+    } else {
+      stats.AddFailure();
+    }
+  }
+
+  stats.Report("pos_err", state);
+  state.counters["points"] = problem.points2D.size();
+}
+
+static void BM_LORANSACAbsolutePose(benchmark::State& state) {
+  FLAGS_minloglevel = 2;  // Suppress INFO and WARNING logs.
+
+  const AbsolutePoseProblem problem =
+      BuildAbsolutePoseProblem(GetSceneArgs(state));
+
+  std::vector<P3PEstimator::X_t> points2D_with_rays(problem.points2D.size());
+  for (size_t i = 0; i < problem.points2D.size(); ++i) {
+    points2D_with_rays[i].image_point = problem.points2D[i];
+    points2D_with_rays[i].camera_ray =
+        problem.camera.CamRayFromImg(problem.points2D[i])
+            .value_or(Eigen::Vector3d::Zero());
+  }
+
+  const ImgFromCamFunc img_from_cam_func = std::bind(
+      &Camera::ImgFromCam, &problem.camera, std::placeholders::_1);
+  LORANSAC<P3PEstimator, EPNPEstimator> ransac(
+      GetRANSACOptions(),
+      P3PEstimator(img_from_cam_func),
+      EPNPEstimator(img_from_cam_func));
+
+  size_t num_trials = 0;
+  AccuracyStats stats(problem.gt_inlier_mask);
+  for (auto _ : state) {
+    const auto report = ransac.Estimate(points2D_with_rays, problem.points3D);
+    num_trials += report.num_trials;
+    if (report.success) {
+      const Rigid3d cam_from_world(
+          Eigen::Quaterniond(report.model.leftCols<3>()), report.model.col(3));
+      stats.Add(RotationErrorDeg(cam_from_world, problem.gt_cam_from_world),
+                PositionError(cam_from_world, problem.gt_cam_from_world),
+                report.inlier_mask);
+    } else {
+      stats.AddFailure();
+    }
+  }
+
+  ReportTrials(num_trials, state);
+  stats.Report("pos_err", state);
+  state.counters["points"] = problem.points2D.size();
+}
+
+static void BM_LORANSACEssentialMatrix(benchmark::State& state) {
+  FLAGS_minloglevel = 2;  // Suppress INFO and WARNING logs.
+
+  const RelativePoseProblem problem =
+      BuildRelativePoseProblem(GetSceneArgs(state));
+
+  RANSACOptions options = GetRANSACOptions();
+  options.max_error = (problem.camera1.CamFromImgThreshold(options.max_error) +
+                       problem.camera2.CamFromImgThreshold(options.max_error)) /
+                      2;
+  LORANSAC<EssentialMatrixFivePointEstimator,
+           EssentialMatrixFivePointEstimator>
+      ransac(options);
+
+  size_t num_trials = 0;
+  AccuracyStats stats(problem.gt_inlier_mask);
+  std::vector<Eigen::Vector3d> points3D;
+  for (auto _ : state) {
+    const auto report = ransac.Estimate(problem.cam_rays1, problem.cam_rays2);
+    num_trials += report.num_trials;
+    if (report.success) {
+      state.PauseTiming();
+      Rigid3d cam2_from_cam1;
+      PoseFromEssentialMatrix(report.model,
+                              problem.cam_rays1,
+                              problem.cam_rays2,
+                              &cam2_from_cam1,
+                              &points3D);
+      stats.Add(RotationErrorDeg(cam2_from_cam1, problem.gt_cam2_from_cam1),
+                TranslationDirectionErrorDeg(cam2_from_cam1,
+                                             problem.gt_cam2_from_cam1),
+                report.inlier_mask);
+      state.ResumeTiming();
+    } else {
+      stats.AddFailure();
+    }
+  }
+
+  ReportTrials(num_trials, state);
+  stats.Report("trans_err_deg", state);
+  state.counters["points"] = problem.cam_rays1.size();
+}
+
+static void BM_EstimateGeneralizedAbsolutePose(benchmark::State& state) {
+  FLAGS_minloglevel = 2;  // Suppress INFO and WARNING logs.
+
+  const GeneralizedPoseProblem problem =
+      BuildGeneralizedPoseProblem(GetSceneArgs(state), /*relative=*/false);
+  const RANSACOptions options = GetRANSACOptions();
+
+  AccuracyStats stats(problem.gt_inlier_mask);
+  for (auto _ : state) {
+    Rigid3d rig_from_world;
+    size_t num_inliers;
+    std::vector<char> inlier_mask;
+    if (EstimateGeneralizedAbsolutePose(options,
+                                        problem.points2D1,
+                                        problem.points3D,
+                                        problem.camera_idxs1,
+                                        problem.cams_from_rig,
+                                        problem.cameras,
+                                        &rig_from_world,
+                                        &num_inliers,
+                                        &inlier_mask)) {
+      stats.Add(RotationErrorDeg(rig_from_world, problem.gt_rig1_from_world),
+                PositionError(rig_from_world, problem.gt_rig1_from_world),
+                inlier_mask);
+    } else {
+      stats.AddFailure();
+    }
+  }
+
+  stats.Report("pos_err", state);
+  state.counters["points"] = problem.points2D1.size();
+}
+
+static void BM_EstimateGeneralizedRelativePose(benchmark::State& state) {
+  FLAGS_minloglevel = 2;  // Suppress INFO and WARNING logs.
+
+  const GeneralizedPoseProblem problem =
+      BuildGeneralizedPoseProblem(GetSceneArgs(state), /*relative=*/true);
+  const RANSACOptions options = GetRANSACOptions();
+
+  AccuracyStats stats(problem.gt_inlier_mask);
+  for (auto _ : state) {
+    std::optional<Rigid3d> rig2_from_rig1;
+    std::optional<Rigid3d> pano2_from_pano1;
+    size_t num_inliers;
+    std::vector<char> inlier_mask;
+    if (EstimateGeneralizedRelativePose(options,
+                                        problem.points2D1,
+                                        problem.points2D2,
+                                        problem.camera_idxs1,
+                                        problem.camera_idxs2,
+                                        problem.cams_from_rig,
+                                        problem.cameras,
+                                        &rig2_from_rig1,
+                                        &pano2_from_pano1,
+                                        &num_inliers,
+                                        &inlier_mask) &&
+        rig2_from_rig1.has_value()) {
+      stats.Add(RotationErrorDeg(*rig2_from_rig1, problem.gt_rig2_from_rig1),
+                (rig2_from_rig1->translation() -
+                 problem.gt_rig2_from_rig1.translation())
+                    .norm(),
+                inlier_mask);
+    } else {
+      stats.AddFailure();
+    }
+  }
+
+  stats.Report("trans_err", state);
+  state.counters["points"] = problem.points2D1.size();
+}
+
+BENCHMARK(BM_EstimateAbsolutePose)
+    ->Apply(SceneArguments)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_LORANSACAbsolutePose)
+    ->Apply(SceneArguments)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_LORANSACEssentialMatrix)
+    ->Apply(SceneArguments)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_EstimateGeneralizedAbsolutePose)
+    ->Apply(SceneArguments)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_EstimateGeneralizedRelativePose)
+    ->Apply(SceneArguments)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
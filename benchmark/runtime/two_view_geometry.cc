@@ -0,0 +1,238 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/estimators/two_view_geometry.h"
+
+#include "colmap/geometry/rigid3.h"
+#include "colmap/math/math.h"
+#include "colmap/math/random.h"
+#include "colmap/scene/reconstruction.h"
+#include "colmap/scene/synthetic.h"
+#include "colmap/sensor/models.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <benchmark/benchmark.h>
+#include <glog/logging.h>
+
+using namespace colmap;
+
+struct TwoViewGeometryProblem {
+  Camera camera1;
+  Camera camera2;
+  std::vector<Eigen::Vector2d> points1;
+  std::vector<Eigen::Vector2d> points2;
+  FeatureMatches matches;
+  std::unordered_set<uint64_t> gt_inlier_matches;
+  Rigid3d gt_cam2_from_cam1;
+};
+
+uint64_t MatchKey(const FeatureMatch& match) {
+  return (static_cast<uint64_t>(match.point2D_idx1) << 32) |
+         match.point2D_idx2;
+}
+
+// Synthesizes an image pair with noisy 2D observations and the given ratio of
+// inlier matches, where the outlier matches are uniformly random.
+TwoViewGeometryProblem BuildTwoViewGeometryProblem(
+    const int num_points3D,
+    const double inlier_ratio,
+    const double point2D_stddev,
+    const int camera_model_idx,
+    const bool has_prior_focal_length) {
+  SetPRNGSeed(42);
+
+  SyntheticDatasetOptions options;
+  options.num_rigs = 1;
+  options.num_cameras_per_rig = 1;
+  options.num_frames_per_rig = 2;
+  options.num_points3D = num_points3D;
+  options.camera_has_prior_focal_length = has_prior_focal_length;
+  switch (camera_model_idx) {
+    case 0:
+      options.camera_model_id = SimplePinholeCameraModel::model_id;
+      options.camera_params = {1280, 512, 384};
+      break;
+    case 1:
+      options.camera_model_id = SimpleRadialCameraModel::model_id;
+      options.camera_params = {1280, 512, 384, 0.05};
+      break;
+    case 2:
+      options.camera_model_id = OpenCVFisheyeCameraModel::model_id;
+      options.camera_params = {1280, 1280, 512, 384, 0.05, 0.01, 0, 0};
+      break;
+    default:
+      LOG(FATAL) << "Unknown camera model index: " << camera_model_idx;
+  }
+
+  Reconstruction reconstruction;
+  SynthesizeDataset(options, &reconstruction);
+
+  SyntheticNoiseOptions noise_options;
+  noise_options.point2D_stddev = point2D_stddev;
+  SynthesizeNoise(noise_options, &reconstruction);
+
+  const std::vector<image_t> image_ids = reconstruction.RegImageIds();
+  const Image& image1 = reconstruction.Image(image_ids[0]);
+  const Image& image2 = reconstruction.Image(image_ids[1]);
+
+  TwoViewGeometryProblem problem;
+  problem.camera1 = *image1.CameraPtr();
+  problem.camera2 = *image2.CameraPtr();
+  problem.gt_cam2_from_cam1 =
+      image2.CamFromWorld() * Inverse(image1.CamFromWorld());
+
+  std::unordered_map<point3D_t, point2D_t> point3D_to_point2D_idx1;
+  for (point2D_t point2D_idx = 0; point2D_idx < image1.NumPoints2D();
+       ++point2D_idx) {
+    const Point2D& point2D = image1.Point2D(point2D_idx);
+    problem.points1.push_back(point2D.xy);
+    if (point2D.HasPoint3D()) {
+      point3D_to_point2D_idx1.emplace(point2D.point3D_id, point2D_idx);
+    }
+  }
+  for (point2D_t point2D_idx = 0; point2D_idx < image2.NumPoints2D();
+       ++point2D_idx) {
+    const Point2D& point2D = image2.Point2D(point2D_idx);
+    problem.points2.push_back(point2D.xy);
+    const auto it = point3D_to_point2D_idx1.find(point2D.point3D_id);
+    if (point2D.HasPoint3D() && it != point3D_to_point2D_idx1.end()) {
+      problem.matches.emplace_back(it->second, point2D_idx);
+      problem.gt_inlier_matches.insert(MatchKey(problem.matches.back()));
+    }
+  }
+
+  const size_t num_inliers = problem.matches.size();
+  const size_t num_outliers =
+      std::round(num_inliers * (1 - inlier_ratio) / inlier_ratio);
+  for (size_t i = 0; i < num_outliers; ++i) {
+    problem.matches.emplace_back(
+        RandomUniformInteger<point2D_t>(0, problem.points1.size() - 1),
+        RandomUniformInteger<point2D_t>(0, problem.points2.size() - 1));
+  }
+  std::shuffle(problem.matches.begin(), problem.matches.end(), *PRNG);
+
+  return problem;
+}
+
+static void BM_EstimateTwoViewGeometry(benchmark::State& state) {
+  FLAGS_minloglevel = 2;  // Suppress INFO and WARNING logs.
+
+  const TwoViewGeometryProblem problem =
+      BuildTwoViewGeometryProblem(/*num_points3D=*/state.range(0),
+                                  /*inlier_ratio=*/state.range(1) / 100.0,
+                                  /*point2D_stddev=*/state.range(2) / 10.0,
+                                  /*camera_model_idx=*/state.range(3),
+                                  /*has_prior_focal_length=*/state.range(4));
+
+  TwoViewGeometryOptions options;
+  options.compute_relative_pose = true;
+  options.ransac_options.random_seed = 42;
+
+  size_t num_estimates = 0;
+  size_t num_successes = 0;
+  double sum_rotation_error = 0;
+  double sum_translation_error = 0;
+  size_t num_inliers = 0;
+  size_t num_true_inliers = 0;
+  const size_t num_gt_inliers = problem.gt_inlier_matches.size();
+  int config = TwoViewGeometry::UNDEFINED;
+  for (auto _ : state) {
+    const TwoViewGeometry geometry =
+        EstimateTwoViewGeometry(problem.camera1,
+                                problem.points1,
+                                problem.camera2,
+                                problem.points2,
+                                problem.matches,
+                                options);
+
+    state.PauseTiming();
+    ++num_estimates;
+    config = geometry.config;
+    if (geometry.cam2_from_cam1.has_value()) {
+      ++num_successes;
+      const Rigid3d& cam2_from_cam1 = *geometry.cam2_from_cam1;
+      sum_rotation_error += RadToDeg(cam2_from_cam1.rotation().angularDistance(
+          problem.gt_cam2_from_cam1.rotation()));
+      const double cos_angle = cam2_from_cam1.translation().normalized().dot(
+          problem.gt_cam2_from_cam1.translation().normalized());
+      sum_translation_error +=
+          RadToDeg(std::acos(std::clamp(cos_angle, -1.0, 1.0)));
+
+      num_inliers += geometry.inlier_matches.size();
+      for (const FeatureMatch& inlier_match : geometry.inlier_matches) {
+        num_true_inliers += problem.gt_inlier_matches.count(
+            MatchKey(inlier_match));
+      }
+    }
+    state.ResumeTiming();
+  }
+
+  state.counters["config"] = config;
+  state.counters["success"] =
+      static_cast<double>(num_successes) / std::max<size_t>(1, num_estimates);
+  if (num_successes > 0) {
+    state.counters["rot_err_deg"] = sum_rotation_error / num_successes;
+    state.counters["trans_err_deg"] = sum_translation_error / num_successes;
+    state.counters["precision"] = static_cast<double>(num_true_inliers) /
+                                  std::max<size_t>(1, num_inliers);
+    state.counters["recall"] = static_cast<double>(num_true_inliers) /
+                               (num_successes * num_gt_inliers);
+  }
+  state.counters["matches"] = problem.matches.size();
+}
+
+static void GenerateArguments(benchmark::Benchmark* b) {
+  // Args: {num_points3D, inlier_ratio [%], point2D_stddev [0.1px],
+  //        camera_model_idx, has_prior_focal_length}
+  for (const int num_points3D : {200, 2000}) {
+    for (const int inlier_ratio : {30, 60, 90}) {
+      for (const int point2D_stddev : {0, 10}) {
+        for (const int camera_model_idx : {0, 1, 2}) {
+          for (const bool has_prior_focal_length : {true, false}) {
+            b->Args({num_points3D,
+                     inlier_ratio,
+                     point2D_stddev,
+                     camera_model_idx,
+                     has_prior_focal_length});
+          }
+        }
+      }
+    }
+  }
+}
+
+BENCHMARK(BM_EstimateTwoViewGeometry)
+    ->Apply(GenerateArguments)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -25,6 +25,16 @@ find_package(Eigen3 ${COLMAP_FIND_TYPE})
 
 find_package(OpenImageIO ${COLMAP_FIND_TYPE})
 
+# OpenImageIO does not expose the DCT scaling of libjpeg, so we optionally link
+# against libjpeg directly to decode JPEG images at reduced resolution.
+find_package(JPEG QUIET)
+if(JPEG_FOUND)
+    list(APPEND COLMAP_COMPILE_DEFINITIONS COLMAP_LIBJPEG_ENABLED)
+    message(STATUS "Enabling libjpeg support")
+else()
+    message(STATUS "Disabling libjpeg support (not found)")
+endif()
+
 find_package(Metis ${COLMAP_FIND_TYPE})
 
 find_package(Glog ${COLMAP_FIND_TYPE})
@@ -241,10 +251,31 @@ if(CUDA_ENABLED AND CUDA_FOUND)
 
     message(STATUS "Enabling CUDA support (version: ${CUDAToolkit_VERSION}, "
                     "archs: ${CMAKE_CUDA_ARCHITECTURES})")
+
+    # nvJPEG ships with the CUDA toolkit and is only exposed as an imported
+    # target through the FindCUDAToolkit module.
+    if(TARGET CUDA::nvjpeg)
+        set(NVJPEG_FOUND ON)
+        list(APPEND COLMAP_COMPILE_DEFINITIONS COLMAP_NVJPEG_ENABLED)
+        message(STATUS "Enabling nvJPEG support")
+    else()
+        set(NVJPEG_FOUND OFF)
+        message(STATUS "Disabling nvJPEG support (not found)")
+    endif()
 else()
     set(CUDA_ENABLED OFF)
 endif()
 
+if(FAISS_GPU_ENABLED)
+    if(CUDA_ENABLED)
+        list(APPEND COLMAP_COMPILE_DEFINITIONS COLMAP_FAISS_GPU_ENABLED)
+        message(STATUS "Enabling faiss GPU support")
+    else()
+        message(STATUS "Disabling faiss GPU support (requires CUDA)")
+        set(FAISS_GPU_ENABLED OFF)
+    endif()
+endif()
+
 if(ONNX_ENABLED)
     if(FETCH_ONNX)
         include(FetchContent)
@@ -31,9 +31,11 @@
 
 #include "colmap/controllers/feature_extraction.h"
 #include "colmap/controllers/feature_matching.h"
+#include "colmap/controllers/feature_matching_utils.h"
 #include "colmap/controllers/global_pipeline.h"
 #include "colmap/controllers/hierarchical_pipeline.h"
 #include "colmap/controllers/incremental_pipeline.h"
+#include "colmap/controllers/matcher_cache.h"
 #include "colmap/controllers/option_manager.h"
 #include "colmap/controllers/undistorters.h"
 #include "colmap/estimators/view_graph_calibration.h"
@@ -48,8 +50,24 @@
 #include "colmap/scene/database.h"
 #include "colmap/util/logging.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/resource_usage.h"
+
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace colmap {
+namespace {
+
+// Interval in which the database is polled for newly extracted images.
+constexpr int kPipelinedMatchingIntervalSeconds = 5;
+
+// Minimum number of new image pairs to match in one pipelined batch, since
+// every batch sets up the matchers anew.
+constexpr size_t kMinNumPipelinedImagePairs = 500;
+
+}  // namespace
 
 AutomaticReconstructionController::AutomaticReconstructionController(
     const Options& options,
@@ -80,6 +98,7 @@ AutomaticReconstructionController::AutomaticReconstructionController(
   }
 
   THROW_CHECK(ExistsCameraModelWithName(options_.camera_model));
+  THROW_CHECK_GT(options_.progressive_num_features, 0);
 
   // Set feature type first so quality modifiers can query EffMaxImageSize().
   if (options_.feature == Feature::SIFT) {
@@ -165,6 +184,9 @@ AutomaticReconstructionController::AutomaticReconstructionController(
   option_manager_.feature_matching->gpu_index = options_.gpu_index;
 #if defined(COLMAP_MVS_ENABLED)
   option_manager_.patch_match_stereo->gpu_index = options_.gpu_index;
+  // Without CUDA, PatchMatch defaults to and only supports the CPU.
+  option_manager_.patch_match_stereo->use_gpu =
+      options_.use_gpu && option_manager_.patch_match_stereo->use_gpu;
 #endif
   option_manager_.mapper->ba_gpu_index = options_.gpu_index;
   if (option_manager_.bundle_adjustment->ceres) {
@@ -196,28 +218,40 @@ void AutomaticReconstructionController::Setup() {
   }
 
   if (options_.matching) {
+    const FeatureMatchingOptions matching_options =
+        InitialFeatureMatchingOptions();
+
     exhaustive_matcher_ =
         CreateExhaustiveFeatureMatcher(*option_manager_.exhaustive_pairing,
-                                       *option_manager_.feature_matching,
+                                       matching_options,
                                        *option_manager_.two_view_geometry,
                                        *option_manager_.database_path);
 
     sequential_matcher_ =
         CreateSequentialFeatureMatcher(*option_manager_.sequential_pairing,
-                                       *option_manager_.feature_matching,
+                                       matching_options,
                                        *option_manager_.two_view_geometry,
                                        *option_manager_.database_path);
 
     if (!options_.vocab_tree_path.empty()) {
       vocab_tree_matcher_ =
           CreateVocabTreeFeatureMatcher(*option_manager_.vocab_tree_pairing,
-                                        *option_manager_.feature_matching,
+                                        matching_options,
                                         *option_manager_.two_view_geometry,
                                         *option_manager_.database_path);
     }
   }
 }
 
+FeatureMatchingOptions
+AutomaticReconstructionController::InitialFeatureMatchingOptions() const {
+  FeatureMatchingOptions matching_options = *option_manager_.feature_matching;
+  if (options_.progressive) {
+    matching_options.max_num_features = options_.progressive_num_features;
+  }
+  return matching_options;
+}
+
 void AutomaticReconstructionController::Stop() {
   if (active_thread_ != nullptr) {
     active_thread_->Stop();
@@ -260,17 +294,97 @@ void AutomaticReconstructionController::Run() {
 }
 
 void AutomaticReconstructionController::RunFeatureExtraction() {
+  ScopedResourceUsage resource_usage("AutomaticFeatureExtraction");
   LOG_HEADING1("Feature extraction");
 
   THROW_CHECK_NOTNULL(feature_extractor_);
   active_thread_ = feature_extractor_.get();
   feature_extractor_->Start();
+  if (options_.pipelined && options_.matching) {
+    RunPipelinedFeatureMatching();
+  }
   feature_extractor_->Wait();
   feature_extractor_.reset();
   active_thread_ = nullptr;
 }
 
+void AutomaticReconstructionController::RunPipelinedFeatureMatching() {
+  // Loop detection and vocabulary tree retrieval need the features of all
+  // images, so only the sequential neighbors are matched during extraction.
+  // These pairs are part of the sequential and exhaustive pairing, whereas
+  // vocabulary tree matching may not select all of them.
+  if (options_.data_type != DataType::VIDEO &&
+      !options_.vocab_tree_path.empty()) {
+    return;
+  }
+
+  const int overlap = option_manager_.sequential_pairing->overlap;
+  std::unordered_set<image_pair_t> matched_pair_ids;
+  while (!IsStopped() && !feature_extractor_->IsFinished()) {
+    for (int i = 0; i < kPipelinedMatchingIntervalSeconds &&
+                    !feature_extractor_->IsFinished();
+         ++i) {
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    auto database = Database::Open(*option_manager_.database_path);
+
+    // Only match images whose keypoints and descriptors were written.
+    std::vector<Image> images = database->ReadAllImages();
+    std::sort(images.begin(),
+              images.end(),
+              [](const Image& image1, const Image& image2) {
+                return image1.Name() < image2.Name();
+              });
+    std::vector<image_t> image_ids;
+    image_ids.reserve(images.size());
+    for (const Image& image : images) {
+      if (database->ExistsKeypoints(image.ImageId()) &&
+          database->ExistsDescriptors(image.ImageId())) {
+        image_ids.push_back(image.ImageId());
+      }
+    }
+
+    std::vector<std::pair<image_t, image_t>> image_pairs;
+    for (size_t i = 0; i < image_ids.size(); ++i) {
+      for (size_t j = i + 1;
+           j < std::min(image_ids.size(), i + 1 + overlap);
+           ++j) {
+        if (matched_pair_ids.count(
+                ImagePairToPairId(image_ids[i], image_ids[j])) == 0) {
+          image_pairs.emplace_back(image_ids[i], image_ids[j]);
+        }
+      }
+    }
+
+    if (image_pairs.size() < kMinNumPipelinedImagePairs) {
+      continue;
+    }
+
+    LOG(INFO) << "Matching " << image_pairs.size()
+              << " image pairs of extracted images";
+
+    // The cache reads the list of images only once, so every batch needs
+    // its own cache and matchers.
+    auto cache = std::make_shared<FeatureMatcherCache>(
+        option_manager_.sequential_pairing->CacheSize(), database);
+    FeatureMatcherController matcher(InitialFeatureMatchingOptions(),
+                                     *option_manager_.two_view_geometry,
+                                     cache);
+    if (!matcher.Setup()) {
+      return;
+    }
+    matcher.Match(image_pairs);
+    cache->FlushWrites();
+
+    for (const auto& [image_id1, image_id2] : image_pairs) {
+      matched_pair_ids.insert(ImagePairToPairId(image_id1, image_id2));
+    }
+  }
+}
+
 void AutomaticReconstructionController::RunFeatureMatching() {
+  ScopedResourceUsage resource_usage("AutomaticFeatureMatching");
   LOG_HEADING1("Feature matching");
 
   Thread* matcher = nullptr;
@@ -298,6 +412,7 @@ void AutomaticReconstructionController::RunFeatureMatching() {
 }
 
 void AutomaticReconstructionController::RunSparseMapper() {
+  ScopedResourceUsage resource_usage("AutomaticSparseMapper");
   LOG_HEADING1("Sparse reconstruction");
 
   const auto sparse_path = options_.workspace_path / "sparse";
@@ -321,8 +436,17 @@ void AutomaticReconstructionController::RunSparseMapper() {
       auto options =
           std::make_shared<IncrementalPipelineOptions>(*option_manager_.mapper);
       options->image_path = *option_manager_.image_path;
-      mapper = std::make_unique<IncrementalPipeline>(
+      auto incremental_mapper = std::make_unique<IncrementalPipeline>(
           options, std::move(database), reconstruction_manager_);
+      if (options_.pipelined && options_.dense && !options_.progressive) {
+        // All models are final once the mapper finished a model, since only
+        // the model in progress is modified or discarded. Preview models are
+        // only final after the progressive refinement.
+        incremental_mapper->AddCallback(
+            IncrementalPipeline::LAST_IMAGE_REG_CALLBACK,
+            [this]() { ScheduleDenseStereo(); });
+      }
+      mapper = std::move(incremental_mapper);
       break;
     }
     case Mapper::HIERARCHICAL: {
@@ -354,12 +478,105 @@ void AutomaticReconstructionController::RunSparseMapper() {
   mapper->SetCheckIfStoppedFunc([&]() { return IsStopped(); });
   mapper->Run();
 
+  if (options_.progressive) {
+    const auto preview_path = options_.workspace_path / "sparse_preview";
+    CreateDirIfNotExists(preview_path);
+    reconstruction_manager_->Write(preview_path);
+    if (IsStopped()) {
+      return;
+    }
+    RunProgressiveRefinement();
+  }
+
   CreateDirIfNotExists(sparse_path);
   reconstruction_manager_->Write(sparse_path);
   option_manager_.Write(sparse_path / "project.ini");
 }
 
+void AutomaticReconstructionController::RunProgressiveRefinement() {
+  ScopedResourceUsage resource_usage("AutomaticProgressiveRefinement");
+  LOG_HEADING1("Progressive refinement");
+
+  auto database = Database::Open(*option_manager_.database_path);
+
+  // Match all features of the verified image pairs, whose images are
+  // registered in the same preview model.
+  std::unordered_map<image_t, size_t> image_to_reconstruction_idx;
+  for (size_t i = 0; i < reconstruction_manager_->Size(); ++i) {
+    for (const image_t image_id :
+         reconstruction_manager_->Get(i)->RegImageIds()) {
+      image_to_reconstruction_idx.emplace(image_id, i);
+    }
+  }
+
+  std::vector<std::pair<image_t, image_t>> image_pairs;
+  for (const auto& [pair_id, _] : database->ReadTwoViewGeometryNumInliers()) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    const auto it1 = image_to_reconstruction_idx.find(image_id1);
+    const auto it2 = image_to_reconstruction_idx.find(image_id2);
+    if (it1 != image_to_reconstruction_idx.end() &&
+        it2 != image_to_reconstruction_idx.end() &&
+        it1->second == it2->second) {
+      image_pairs.emplace_back(image_id1, image_id2);
+    }
+  }
+
+  LOG(INFO) << "Matching all features of " << image_pairs.size()
+            << " registered image pairs";
+
+  // Existing matches are skipped by the matcher, so the preview matches
+  // must be deleted first.
+  {
+    DatabaseTransaction database_transaction(database.get());
+    for (const auto& [image_id1, image_id2] : image_pairs) {
+      database->DeleteMatches(image_id1, image_id2);
+      database->DeleteTwoViewGeometry(image_id1, image_id2);
+    }
+  }
+
+  {
+    auto cache = std::make_shared<FeatureMatcherCache>(
+        option_manager_.exhaustive_pairing->CacheSize(), database);
+    FeatureMatcherController matcher(*option_manager_.feature_matching,
+                                     *option_manager_.two_view_geometry,
+                                     cache);
+    if (!matcher.Setup()) {
+      LOG(ERROR) << "Failed to setup the feature matchers";
+      return;
+    }
+    matcher.Match(image_pairs);
+    cache->FlushWrites();
+  }
+
+  if (IsStopped()) {
+    return;
+  }
+
+  // Triangulate the preview models anew from all matched features. The
+  // subsequent bundle adjustment also refines the preview poses.
+  auto mapper_options =
+      std::make_shared<IncrementalPipelineOptions>(*option_manager_.mapper);
+  mapper_options->image_path = *option_manager_.image_path;
+  mapper_options->load_all_images = true;
+  IncrementalPipeline mapper(mapper_options,
+                             std::move(database),
+                             std::make_shared<ReconstructionManager>());
+  for (size_t i = 0; i < reconstruction_manager_->Size(); ++i) {
+    if (IsStopped()) {
+      return;
+    }
+    auto reconstruction = reconstruction_manager_->Get(i);
+    if (reconstruction->NumRegImages() < 2) {
+      continue;
+    }
+    LOG(INFO) << "Triangulating model " << i;
+    reconstruction->DeleteAllPoints2DAndPoints3D();
+    mapper.TriangulateReconstruction(reconstruction);
+  }
+}
+
 void AutomaticReconstructionController::RunDenseMapper() {
+  ScopedResourceUsage resource_usage("AutomaticDenseMapper");
 #if !defined(COLMAP_MVS_ENABLED)
   LOG(WARNING) << "Skipping dense reconstruction because the MVS module is "
                   "not available";
@@ -369,6 +586,12 @@ void AutomaticReconstructionController::RunDenseMapper() {
 
   CreateDirIfNotExists(options_.workspace_path / "dense");
 
+  // Models already processed in the pipelined mode are skipped below, and
+  // models with failed or interrupted stereo are processed again.
+  if (dense_stereo_pool_ != nullptr) {
+    dense_stereo_pool_->Wait();
+  }
+
   for (size_t i = 0; i < reconstruction_manager_->Size(); ++i) {
     if (IsStopped()) {
       return;
@@ -393,43 +616,7 @@ void AutomaticReconstructionController::RunDenseMapper() {
       continue;
     }
 
-    // Image undistortion.
-
-    if (!ExistsDir(dense_path)) {
-      CreateDirIfNotExists(dense_path);
-
-      UndistortCameraOptions undistortion_options;
-      undistortion_options.max_image_size =
-          option_manager_.patch_match_stereo->max_image_size;
-      COLMAPUndistorter::Options undistorter_options;
-      undistorter_options.num_threads = options_.num_threads;
-      COLMAPUndistorter undistorter(std::move(undistorter_options),
-                                    undistortion_options,
-                                    *reconstruction_manager_->Get(i),
-                                    *option_manager_.image_path,
-                                    dense_path);
-      undistorter.SetCheckIfStoppedFunc([&]() { return IsStopped(); });
-      undistorter.Run();
-    }
-
-    if (IsStopped()) {
-      return;
-    }
-
-    // Patch match stereo.
-
-#if defined(COLMAP_CUDA_ENABLED)
-    {
-      mvs::PatchMatchController patch_match_controller(
-          *option_manager_.patch_match_stereo, dense_path, "COLMAP", "");
-      patch_match_controller.SetCheckIfStoppedFunc(
-          [&]() { return IsStopped(); });
-      patch_match_controller.Run();
-    }
-#else   // COLMAP_CUDA_ENABLED
-    LOG(WARNING) << "Skipping patch match stereo because CUDA is not available";
-    return;
-#endif  // COLMAP_CUDA_ENABLED
+    RunDenseStereo(i, *reconstruction_manager_->Get(i));
 
     if (IsStopped()) {
       return;
@@ -493,4 +680,66 @@ void AutomaticReconstructionController::RunDenseMapper() {
 #endif  // COLMAP_MVS_ENABLED
 }
 
+void AutomaticReconstructionController::ScheduleDenseStereo() {
+#if defined(COLMAP_MVS_ENABLED)
+  if (dense_stereo_pool_ == nullptr) {
+    CreateDirIfNotExists(options_.workspace_path / "dense");
+    dense_stereo_pool_ = std::make_unique<ThreadPool>(1);
+  }
+
+  for (; num_scheduled_dense_models_ < reconstruction_manager_->Size();
+       ++num_scheduled_dense_models_) {
+    LOG(INFO) << "Scheduling dense stereo for model "
+              << num_scheduled_dense_models_;
+    dense_stereo_pool_->AddTask(
+        [this,
+         reconstruction_idx = num_scheduled_dense_models_,
+         reconstruction = reconstruction_manager_->Get(
+             num_scheduled_dense_models_)]() {
+          if (!IsStopped()) {
+            RunDenseStereo(reconstruction_idx, *reconstruction);
+          }
+        });
+  }
+#endif  // COLMAP_MVS_ENABLED
+}
+
+#if defined(COLMAP_MVS_ENABLED)
+void AutomaticReconstructionController::RunDenseStereo(
+    const size_t reconstruction_idx, const Reconstruction& reconstruction) {
+  const auto dense_path =
+      options_.workspace_path / "dense" / std::to_string(reconstruction_idx);
+
+  // Image undistortion.
+
+  if (!ExistsDir(dense_path)) {
+    CreateDirIfNotExists(dense_path);
+
+    UndistortCameraOptions undistortion_options;
+    undistortion_options.max_image_size =
+        option_manager_.patch_match_stereo->max_image_size;
+    COLMAPUndistorter::Options undistorter_options;
+    undistorter_options.num_threads = options_.num_threads;
+    COLMAPUndistorter undistorter(std::move(undistorter_options),
+                                  undistortion_options,
+                                  reconstruction,
+                                  *option_manager_.image_path,
+                                  dense_path);
+    undistorter.SetCheckIfStoppedFunc([&]() { return IsStopped(); });
+    undistorter.Run();
+  }
+
+  if (IsStopped()) {
+    return;
+  }
+
+  // Patch match stereo.
+
+  mvs::PatchMatchController patch_match_controller(
+      *option_manager_.patch_match_stereo, dense_path, "COLMAP", "");
+  patch_match_controller.SetCheckIfStoppedFunc([&]() { return IsStopped(); });
+  patch_match_controller.Run();
+}
+#endif  // COLMAP_MVS_ENABLED
+
 }  // namespace colmap
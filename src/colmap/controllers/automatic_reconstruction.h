@@ -94,7 +94,8 @@ class AutomaticReconstructionController : public Thread {
     // Whether to perform sparse mapping.
     bool sparse = true;
 
-// Whether to perform dense mapping.
+// Whether to perform dense mapping. Without CUDA, dense stereo runs on the
+// CPU, which is too slow to be enabled by default.
 #if defined(COLMAP_CUDA_ENABLED) && defined(COLMAP_MVS_ENABLED)
     bool dense = true;
 #else
@@ -116,8 +117,8 @@ class AutomaticReconstructionController : public Thread {
     // The random seed to use in all stages.
     int random_seed = -1;
 
-    // Whether to use the GPU in feature extraction, feature matching, and
-    // bundle adjustment.
+    // Whether to use the GPU in feature extraction, feature matching, bundle
+    // adjustment, and dense stereo.
     bool use_gpu = true;
 
     // Index of the GPU used for GPU stages. For multi-GPU computation in
@@ -128,6 +129,20 @@ class AutomaticReconstructionController : public Thread {
 
     // Bundle adjustment solver backend for local and global BA.
     BundleAdjustmentBackend ba_backend = BundleAdjustmentBackend::CERES;
+
+    // Whether to overlap the reconstruction stages. Images are then matched
+    // to their sequential neighbors while the features of the remaining images
+    // are still extracted, and dense stereo of finished models runs while the
+    // incremental mapper reconstructs the next models.
+    bool pipelined = false;
+
+    // Whether to reconstruct progressively. A preview model is then first
+    // reconstructed from the matches of the progressive_num_features features
+    // with the largest scale per image and written to the "sparse_preview"
+    // folder. Afterwards, all features of the image pairs registered in the
+    // preview model are matched and its points are triangulated anew.
+    bool progressive = false;
+    int progressive_num_features = 1024;
   };
 
   AutomaticReconstructionController(
@@ -147,6 +162,23 @@ class AutomaticReconstructionController : public Thread {
   void RunSparseMapper();
   void RunDenseMapper();
 
+  // The options of the feature matching stage, which only matches the
+  // largest-scale features in the progressive mode.
+  FeatureMatchingOptions InitialFeatureMatchingOptions() const;
+
+  // Matches all features of the image pairs registered in the preview models
+  // and triangulates the models anew.
+  void RunProgressiveRefinement();
+
+  // Matches the sequential neighbors of images with extracted features until
+  // the feature extractor finished.
+  void RunPipelinedFeatureMatching();
+
+  // Schedules dense stereo for all finished models of the mapper.
+  void ScheduleDenseStereo();
+  void RunDenseStereo(size_t reconstruction_idx,
+                      const Reconstruction& reconstruction);
+
   const Options options_;
   OptionManager option_manager_;
   std::shared_ptr<ReconstructionManager> reconstruction_manager_;
@@ -155,6 +187,10 @@ class AutomaticReconstructionController : public Thread {
   std::unique_ptr<Thread> exhaustive_matcher_;
   std::unique_ptr<Thread> sequential_matcher_;
   std::unique_ptr<Thread> vocab_tree_matcher_;
+  size_t num_scheduled_dense_models_ = 0;
+  // Declared last, so that its tasks are stopped before the other members are
+  // destructed.
+  std::unique_ptr<ThreadPool> dense_stereo_pool_;
 };
 
 }  // namespace colmap
@@ -32,6 +32,7 @@
 #include "colmap/estimators/bundle_adjustment_ceres.h"
 #include "colmap/sfm/observation_manager.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/resource_usage.h"
 #include "colmap/util/timer.h"
 
 namespace colmap {
@@ -65,6 +66,7 @@ BundleAdjustmentController::BundleAdjustmentController(
     : options_(options), reconstruction_(std::move(reconstruction)) {}
 
 void BundleAdjustmentController::Run() {
+  ScopedResourceUsage resource_usage("BundleAdjustmentController");
   THROW_CHECK_NOTNULL(reconstruction_);
 
   LOG_HEADING1("Global bundle adjustment");
@@ -29,15 +29,28 @@
 
 #include "colmap/controllers/feature_extraction.h"
 
+#include "colmap/controllers/feature_extraction_scheduler.h"
+#include "colmap/feature/aliked.h"
 #include "colmap/feature/sift.h"
 #include "colmap/scene/database.h"
+#if defined(COLMAP_NVJPEG_ENABLED)
+#include "colmap/sensor/gpu_jpeg_decoder.h"
+#endif
 #include "colmap/util/cuda.h"
 #include "colmap/util/file.h"
+#include "colmap/util/metrics.h"
 #include "colmap/util/misc.h"
 #include "colmap/util/opengl_utils.h"
+#include "colmap/util/resource_usage.h"
 #include "colmap/util/timer.h"
+#include "colmap/util/timestamp.h"
+#include "colmap/util/tracing.h"
 
+#include <chrono>
+#include <mutex>
 #include <numeric>
+#include <sstream>
+#include <vector>
 
 namespace colmap {
 namespace {
@@ -83,6 +96,73 @@ void MaskFeatures(const Bitmap& mask,
   descriptors->data.conservativeResize(out_index, descriptors->data.cols());
 }
 
+// Hashes all options that influence the extracted features, so that the
+// features of an image are extracted again when any of them changes. Options
+// that only affect the performance, such as the number of threads, are ignored.
+uint64_t ComputeFeatureOptionsHash(
+    const ImageReaderOptions& reader_options,
+    const FeatureExtractionOptions& extraction_options) {
+  std::ostringstream stream;
+  stream.precision(17);
+  stream << FeatureExtractorTypeToString(extraction_options.type) << ';'
+         << extraction_options.max_image_size << ';'
+         << reader_options.mask_path.string() << ';'
+         << reader_options.camera_mask_path.string() << ';';
+  switch (extraction_options.type) {
+    case FeatureExtractorType::SIFT: {
+      const SiftExtractionOptions& sift = *extraction_options.sift;
+      stream << extraction_options.use_gpu << ';' << sift.max_num_features
+             << ';' << sift.first_octave << ';' << sift.num_octaves << ';'
+             << sift.octave_resolution << ';' << sift.peak_threshold << ';'
+             << sift.edge_threshold << ';' << sift.estimate_affine_shape
+             << ';' << sift.max_num_orientations << ';' << sift.upright << ';'
+             << sift.darkness_adaptivity << ';' << sift.domain_size_pooling
+             << ';' << sift.dsp_min_scale << ';' << sift.dsp_max_scale << ';'
+             << sift.dsp_num_scales << ';' << sift.force_covariant_extractor
+             << ';' << sift.tile_size << ';' << sift.tile_overlap << ';'
+             << SiftExtractionOptions::NormalizationToString(
+                    sift.normalization);
+      break;
+    }
+    case FeatureExtractorType::ALIKED_N16ROT:
+    case FeatureExtractorType::ALIKED_N32: {
+      const AlikedExtractionOptions& aliked = *extraction_options.aliked;
+      stream << aliked.max_num_features << ';' << aliked.min_score << ';'
+             << aliked.n16rot_model_path << ';' << aliked.n32_model_path
+             << ';'
+             << FeatureDescriptorPrecisionToString(
+                    aliked.descriptor_precision);
+      break;
+    }
+    default:
+      break;
+  }
+  return ComputeFNV1aHash(stream.str());
+}
+
+// Defer the decoding of JPEG images to the GPU image decoder stage, if
+// enabled and supported, or otherwise to the parallel CPU image resizer stage,
+// which decodes the images directly at reduced resolution using libjpeg.
+ImageReaderOptions GetEffectiveReaderOptions(
+    const ImageReaderOptions& reader_options,
+    const FeatureExtractionOptions& extraction_options) {
+  ImageReaderOptions effective_reader_options = reader_options;
+  effective_reader_options.feature_options_hash =
+      ComputeFeatureOptionsHash(reader_options, extraction_options);
+  if (extraction_options.use_gpu_decoding) {
+#if defined(COLMAP_NVJPEG_ENABLED)
+    effective_reader_options.defer_jpeg_decoding = true;
+#else
+    LOG(WARNING) << "GPU image decoding requires nvJPEG support, decoding "
+                    "images on the CPU instead.";
+#endif
+  }
+#if defined(COLMAP_LIBJPEG_ENABLED)
+  effective_reader_options.defer_jpeg_decoding = true;
+#endif
+  return effective_reader_options;
+}
+
 struct ImageData {
   ImageReader::Status status = ImageReader::Status::FAILURE;
 
@@ -95,14 +175,139 @@ struct ImageData {
 
   FeatureKeypoints keypoints;
   FeatureDescriptors descriptors;
+
+  // Only valid if options_hash is non-zero.
+  FeatureExtractionFingerprint fingerprint;
+
+  // Only valid for video frames.
+  timestamp_t timestamp = kInvalidTimestamp;
 };
 
+// Recycles the bitmap and keypoint buffers of processed images, so that the
+// extraction pipeline reuses their memory instead of allocating and freeing
+// it for every image. The number of pooled buffers is naturally bounded by
+// the number of images in flight.
+class FeatureExtractionBufferPool {
+ public:
+  // Resets the bitmap to an empty bitmap that reuses a released buffer.
+  void AcquireBitmap(Bitmap* bitmap) {
+    *bitmap = Bitmap();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!bitmap_buffers_.empty()) {
+      bitmap->RowMajorData() = std::move(bitmap_buffers_.back());
+      bitmap_buffers_.pop_back();
+    }
+  }
+
+  // Resets the bitmap to an empty bitmap and keeps its buffer for reuse.
+  void ReleaseBitmap(Bitmap* bitmap) {
+    std::vector<uint8_t> buffer = std::move(bitmap->RowMajorData());
+    *bitmap = Bitmap();
+    if (buffer.capacity() == 0) {
+      return;
+    }
+    buffer.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    bitmap_buffers_.push_back(std::move(buffer));
+  }
+
+  void AcquireKeypoints(FeatureKeypoints* keypoints) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!keypoints_buffers_.empty()) {
+      *keypoints = std::move(keypoints_buffers_.back());
+      keypoints_buffers_.pop_back();
+    }
+  }
+
+  void ReleaseKeypoints(FeatureKeypoints* keypoints) {
+    FeatureKeypoints buffer = std::move(*keypoints);
+    keypoints->clear();
+    if (buffer.capacity() == 0) {
+      return;
+    }
+    buffer.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    keypoints_buffers_.push_back(std::move(buffer));
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::vector<uint8_t>> bitmap_buffers_;
+  std::vector<FeatureKeypoints> keypoints_buffers_;
+};
+
+// Downscales the images or, if their decoding was deferred by the image
+// reader, decodes them directly at reduced resolution.
 class ImageResizerThread : public Thread {
  public:
-  ImageResizerThread(int max_image_size,
-                     JobQueue<ImageData>* input_queue,
-                     JobQueue<ImageData>* output_queue)
-      : max_image_size_(max_image_size),
+  ImageResizerThread(const std::filesystem::path& image_path,
+                     bool as_rgb,
+                     int max_image_size,
+                     LockFreeJobQueue<ImageData>* input_queue,
+                     LockFreeJobQueue<ImageData>* output_queue)
+      : image_path_(image_path),
+        as_rgb_(as_rgb),
+        max_image_size_(max_image_size),
+        input_queue_(input_queue),
+        output_queue_(output_queue) {
+    THROW_CHECK_GT(max_image_size_, 0);
+  }
+
+ private:
+  void Run() override {
+    while (true) {
+      if (IsStopped()) {
+        break;
+      }
+
+      auto input_job = input_queue_->Pop();
+      if (input_job.IsValid()) {
+        auto& image_data = input_job.Data();
+
+        if (image_data.status == ImageReader::Status::SUCCESS) {
+          Bitmap& bitmap = *image_data.bitmap;
+          if (bitmap.IsEmpty()) {
+            if (!bitmap.ReadThumbnail(image_path_ / image_data.image.Name(),
+                                      max_image_size_,
+                                      as_rgb_)) {
+              image_data.status = ImageReader::Status::BITMAP_ERROR;
+            }
+          } else {
+            bitmap.Thumbnail(max_image_size_);
+          }
+        }
+
+        output_queue_->Push(std::move(image_data));
+      } else {
+        break;
+      }
+    }
+  }
+
+  const std::filesystem::path image_path_;
+  const bool as_rgb_;
+  const int max_image_size_;
+
+  LockFreeJobQueue<ImageData>* input_queue_;
+  LockFreeJobQueue<ImageData>* output_queue_;
+};
+
+#if defined(COLMAP_NVJPEG_ENABLED)
+// Replaces the CPU image resizer stage by decoding and downscaling the JPEG
+// images, whose decoding was deferred by the image reader, on the GPU. Images
+// that nvJPEG cannot decode are decoded on the CPU instead.
+class GpuImageDecoderThread : public Thread {
+ public:
+  GpuImageDecoderThread(const std::filesystem::path& image_path,
+                        bool as_rgb,
+                        int max_image_size,
+                        int gpu_index,
+                        LockFreeJobQueue<ImageData>* input_queue,
+                        LockFreeJobQueue<ImageData>* output_queue)
+      : image_path_(image_path),
+        as_rgb_(as_rgb),
+        max_image_size_(max_image_size),
+        gpu_index_(gpu_index),
         input_queue_(input_queue),
         output_queue_(output_queue) {
     THROW_CHECK_GT(max_image_size_, 0);
@@ -110,6 +315,9 @@ class ImageResizerThread : public Thread {
 
  private:
   void Run() override {
+    SetBestCudaDevice(gpu_index_);
+    GpuJpegDecoder decoder;
+
     while (true) {
       if (IsStopped()) {
         break;
@@ -120,7 +328,20 @@ class ImageResizerThread : public Thread {
         auto& image_data = input_job.Data();
 
         if (image_data.status == ImageReader::Status::SUCCESS) {
-          image_data.bitmap->Thumbnail(max_image_size_);
+          Bitmap& bitmap = *image_data.bitmap;
+          if (bitmap.IsEmpty()) {
+            const std::filesystem::path path =
+                image_path_ / image_data.image.Name();
+            if (!decoder.Decode(path, as_rgb_, max_image_size_, &bitmap)) {
+              VLOG(2) << "Failed to decode " << path
+                      << " on the GPU, decoding on the CPU instead";
+              if (!bitmap.ReadThumbnail(path, max_image_size_, as_rgb_)) {
+                image_data.status = ImageReader::Status::BITMAP_ERROR;
+              }
+            }
+          } else {
+            bitmap.Thumbnail(max_image_size_);
+          }
         }
 
         output_queue_->Push(std::move(image_data));
@@ -130,22 +351,79 @@ class ImageResizerThread : public Thread {
     }
   }
 
+  const std::filesystem::path image_path_;
+  const bool as_rgb_;
   const int max_image_size_;
+  const int gpu_index_;
+  LockFreeJobQueue<ImageData>* input_queue_;
+  LockFreeJobQueue<ImageData>* output_queue_;
+};
+#endif  // COLMAP_NVJPEG_ENABLED
+
+// The scheduling cost of an image is its number of pixels after resizing.
+double ComputeSchedulingCost(const ImageData& image_data) {
+  if (image_data.status != ImageReader::Status::SUCCESS) {
+    return 0;
+  }
+  return static_cast<double>(image_data.bitmap->Width()) *
+         image_data.bitmap->Height();
+}
 
-  JobQueue<ImageData>* input_queue_;
-  JobQueue<ImageData>* output_queue_;
+// Routes the images to the input queues of heterogeneous extractor workers.
+class FeatureExtractionSchedulerThread : public Thread {
+ public:
+  FeatureExtractionSchedulerThread(
+      FeatureExtractionScheduler* scheduler,
+      LockFreeJobQueue<ImageData>* input_queue,
+      std::vector<LockFreeJobQueue<ImageData>*> output_queues)
+      : scheduler_(scheduler),
+        input_queue_(input_queue),
+        output_queues_(std::move(output_queues)) {
+    THROW_CHECK_EQ(scheduler_->NumWorkers(), output_queues_.size());
+  }
+
+ private:
+  void Run() override {
+    while (true) {
+      if (IsStopped()) {
+        break;
+      }
+
+      auto input_job = input_queue_->Pop();
+      if (input_job.IsValid()) {
+        auto& image_data = input_job.Data();
+        const size_t worker_idx =
+            scheduler_->Schedule(ComputeSchedulingCost(image_data));
+        output_queues_[worker_idx]->Push(std::move(image_data));
+      } else {
+        break;
+      }
+    }
+  }
+
+  FeatureExtractionScheduler* scheduler_;
+  LockFreeJobQueue<ImageData>* input_queue_;
+  std::vector<LockFreeJobQueue<ImageData>*> output_queues_;
 };
 
 class FeatureExtractorThread : public Thread {
  public:
+  // If a scheduler is given, the thread reports its throughput as the worker
+  // with the given index and GPU workers fall back to the CPU on failure.
   FeatureExtractorThread(const FeatureExtractionOptions& extraction_options,
                          const std::shared_ptr<Bitmap>& camera_mask,
-                         JobQueue<ImageData>* input_queue,
-                         JobQueue<ImageData>* output_queue)
+                         FeatureExtractionBufferPool* buffer_pool,
+                         LockFreeJobQueue<ImageData>* input_queue,
+                         LockFreeJobQueue<ImageData>* output_queue,
+                         FeatureExtractionScheduler* scheduler = nullptr,
+                         size_t worker_idx = 0)
       : extraction_options_(extraction_options),
         camera_mask_(camera_mask),
+        buffer_pool_(THROW_CHECK_NOTNULL(buffer_pool)),
         input_queue_(input_queue),
-        output_queue_(output_queue) {
+        output_queue_(output_queue),
+        scheduler_(scheduler),
+        worker_idx_(worker_idx) {
     THROW_CHECK(extraction_options_.Check());
 
     if (extraction_options_.RequiresOpenGL()) {
@@ -169,77 +447,181 @@ class FeatureExtractorThread : public Thread {
 
     SignalValidSetup();
 
+    const size_t batch_size = extraction_options_.batch_size;
+    const auto batch_timeout =
+        std::chrono::milliseconds(extraction_options_.batch_timeout_ms);
+
+    std::vector<ImageData> batch;
+    batch.reserve(batch_size);
     while (true) {
       if (IsStopped()) {
         break;
       }
 
       auto input_job = input_queue_->Pop();
-      if (input_job.IsValid()) {
-        auto& image_data = input_job.Data();
+      if (!input_job.IsValid()) {
+        break;
+      }
 
-        if (image_data.status == ImageReader::Status::SUCCESS) {
-          const int orig_width = image_data.bitmap->Width();
-          const int orig_height = image_data.bitmap->Height();
-          const int rot90 =
-              image_data.pose_prior.HasGravity()
-                  ? ComputeRot90FromGravity(image_data.pose_prior.gravity)
-                  : 0;
-          if (rot90 > 0) {
-            image_data.bitmap->Rot90(rot90);
-          }
-          if (extractor->Extract(*image_data.bitmap,
-                                 &image_data.keypoints,
-                                 &image_data.descriptors)) {
-            if (rot90 > 0) {
-              const int w = image_data.bitmap->Width();
-              const int h = image_data.bitmap->Height();
-              for (auto& kp : image_data.keypoints) {
-                kp.Rot90(4 - rot90, w, h);
-              }
-            }
-            ScaleKeypoints(orig_width,
-                           orig_height,
-                           image_data.camera.width,
-                           image_data.camera.height,
-                           &image_data.keypoints);
-            if (camera_mask_) {
-              MaskFeatures(*camera_mask_,
-                           &image_data.keypoints,
-                           &image_data.descriptors);
-            }
-            if (image_data.mask) {
-              MaskFeatures(*image_data.mask,
-                           &image_data.keypoints,
-                           &image_data.descriptors);
-            }
-          } else {
-            image_data.status = ImageReader::Status::FAILURE;
-          }
+      // Collect further images until the batch is full or no new image
+      // arrives before the deadline.
+      batch.clear();
+      batch.push_back(std::move(input_job.Data()));
+      const auto deadline = std::chrono::steady_clock::now() + batch_timeout;
+      while (batch.size() < batch_size) {
+        auto next_job = input_queue_->PopUntil(deadline);
+        if (!next_job.IsValid()) {
+          break;
         }
+        batch.push_back(std::move(next_job.Data()));
+      }
+
+      Timer timer;
+      timer.Start();
+      double batch_cost = 0;
+      for (const auto& image_data : batch) {
+        batch_cost += ComputeSchedulingCost(image_data);
+      }
+
+      ExtractBatch(extractor.get(), &batch);
+
+      if (scheduler_ != nullptr) {
+        scheduler_->Finish(worker_idx_, batch_cost, timer.ElapsedSeconds());
+      }
 
-        // Release the memory, since it is not used afterwards.
+      for (auto& image_data : batch) {
+        // Recycle the memory, since it is not used afterwards.
         // Warning: Do not reset the pointer, as we use it later
         // to check if a mask exists for logging purposes.
-        *image_data.bitmap = Bitmap();
+        buffer_pool_->ReleaseBitmap(image_data.bitmap.get());
         if (image_data.mask) {
-          *image_data.mask = Bitmap();
+          buffer_pool_->ReleaseBitmap(image_data.mask.get());
         }
 
         output_queue_->Push(std::move(image_data));
-      } else {
-        break;
       }
     }
   }
 
+  void ExtractBatch(FeatureExtractor* extractor,
+                    std::vector<ImageData>* batch) {
+    std::vector<ImageData*> batch_data;
+    std::vector<int> orig_widths;
+    std::vector<int> orig_heights;
+    std::vector<int> rot90s;
+    for (auto& image_data : *batch) {
+      if (image_data.status != ImageReader::Status::SUCCESS) {
+        continue;
+      }
+      orig_widths.push_back(image_data.bitmap->Width());
+      orig_heights.push_back(image_data.bitmap->Height());
+      const int rot90 =
+          image_data.pose_prior.HasGravity()
+              ? ComputeRot90FromGravity(image_data.pose_prior.gravity)
+              : 0;
+      if (rot90 > 0) {
+        image_data.bitmap->Rot90(rot90);
+      }
+      rot90s.push_back(rot90);
+      batch_data.push_back(&image_data);
+    }
+
+    if (batch_data.empty()) {
+      return;
+    }
+
+    TraceZone trace_zone("ExtractFeatures");
+    trace_zone.SetNumItems(batch_data.size());
+
+    std::vector<bool> success;
+    if (batch_data.size() == 1) {
+      ImageData& image_data = *batch_data[0];
+      success.push_back(extractor->Extract(*image_data.bitmap,
+                                           &image_data.keypoints,
+                                           &image_data.descriptors));
+    } else {
+      std::vector<const Bitmap*> bitmaps;
+      std::vector<FeatureKeypoints*> keypoints;
+      std::vector<FeatureDescriptors*> descriptors;
+      bitmaps.reserve(batch_data.size());
+      keypoints.reserve(batch_data.size());
+      descriptors.reserve(batch_data.size());
+      for (ImageData* image_data : batch_data) {
+        bitmaps.push_back(image_data->bitmap.get());
+        keypoints.push_back(&image_data->keypoints);
+        descriptors.push_back(&image_data->descriptors);
+      }
+      success = extractor->ExtractBatch(bitmaps, keypoints, descriptors);
+      THROW_CHECK_EQ(success.size(), batch_data.size());
+    }
+
+    for (size_t i = 0; i < batch_data.size(); ++i) {
+      ImageData& image_data = *batch_data[i];
+      if (!success[i] && !ExtractWithCpuFallback(&image_data)) {
+        image_data.status = ImageReader::Status::FAILURE;
+        continue;
+      }
+      if (rot90s[i] > 0) {
+        const int w = image_data.bitmap->Width();
+        const int h = image_data.bitmap->Height();
+        for (auto& kp : image_data.keypoints) {
+          kp.Rot90(4 - rot90s[i], w, h);
+        }
+      }
+      ScaleKeypoints(orig_widths[i],
+                     orig_heights[i],
+                     image_data.camera.width,
+                     image_data.camera.height,
+                     &image_data.keypoints);
+      if (camera_mask_) {
+        MaskFeatures(
+            *camera_mask_, &image_data.keypoints, &image_data.descriptors);
+      }
+      if (image_data.mask) {
+        MaskFeatures(
+            *image_data.mask, &image_data.keypoints, &image_data.descriptors);
+      }
+    }
+  }
+
+  // Extracts the features of a scheduled GPU worker on the CPU, if the GPU
+  // failed to extract them, which is typically caused by insufficient memory
+  // for large images. Larger images are then scheduled to other workers.
+  bool ExtractWithCpuFallback(ImageData* image_data) {
+    if (scheduler_ == nullptr || !extraction_options_.use_gpu) {
+      return false;
+    }
+
+    scheduler_->LimitCost(worker_idx_, ComputeSchedulingCost(*image_data));
+
+    if (cpu_extractor_ == nullptr) {
+      FeatureExtractionOptions cpu_extraction_options = extraction_options_;
+      cpu_extraction_options.use_gpu = false;
+      cpu_extractor_ = FeatureExtractor::Create(cpu_extraction_options);
+      if (cpu_extractor_ == nullptr) {
+        return false;
+      }
+    }
+
+    LOG(WARNING) << "Failed to extract features of " << image_data->image.Name()
+                 << " on the GPU, extracting them on the CPU instead.";
+    return cpu_extractor_->Extract(*image_data->bitmap,
+                                   &image_data->keypoints,
+                                   &image_data->descriptors);
+  }
+
   const FeatureExtractionOptions extraction_options_;
   std::shared_ptr<Bitmap> camera_mask_;
 
   std::unique_ptr<OpenGLContextManager> opengl_context_;
+  std::unique_ptr<FeatureExtractor> cpu_extractor_;
+  FeatureExtractionBufferPool* buffer_pool_;
+
+  LockFreeJobQueue<ImageData>* input_queue_;
+  LockFreeJobQueue<ImageData>* output_queue_;
 
-  JobQueue<ImageData>* input_queue_;
-  JobQueue<ImageData>* output_queue_;
+  FeatureExtractionScheduler* scheduler_;
+  const size_t worker_idx_;
 };
 
 class FeatureWriterThread : public Thread {
@@ -247,10 +629,12 @@ class FeatureWriterThread : public Thread {
   FeatureWriterThread(FeatureExtractorType extractor_type,
                       size_t num_images,
                       Database* database,
-                      JobQueue<ImageData>* input_queue)
+                      FeatureExtractionBufferPool* buffer_pool,
+                      LockFreeJobQueue<ImageData>* input_queue)
       : extractor_type_str_(FeatureExtractorTypeToString(extractor_type)),
         num_images_(num_images),
         database_(database),
+        buffer_pool_(THROW_CHECK_NOTNULL(buffer_pool)),
         input_queue_(input_queue) {}
 
  private:
@@ -273,9 +657,18 @@ class FeatureWriterThread : public Thread {
         LOG(INFO) << StringPrintf("  Name:            %s",
                                   image_data.image.Name().c_str());
 
+        if (image_data.status ==
+            ImageReader::Status::VIDEO_FRAME_SKIPPED) {
+          VLOG(2) << image_data.image.Name() << " "
+                  << ImageReader::StatusToString(image_data.status);
+          buffer_pool_->ReleaseKeypoints(&image_data.keypoints);
+          continue;
+        }
+
         if (image_data.status != ImageReader::Status::SUCCESS) {
           LOG(WARNING) << image_data.image.Name() << " "
                        << ImageReader::StatusToString(image_data.status);
+          buffer_pool_->ReleaseKeypoints(&image_data.keypoints);
           continue;
         }
 
@@ -291,6 +684,11 @@ class FeatureWriterThread : public Thread {
               image_data.camera.MeanFocalLength(),
               image_data.camera.has_prior_focal_length ? " (Prior)" : "");
         }
+        if (image_data.timestamp != kInvalidTimestamp) {
+          LOG(INFO) << StringPrintf(
+              "  Timestamp:       %.3fs",
+              SecondsFromTimestamp(image_data.timestamp));
+        }
         LOG(INFO) << "  Features:        " << image_data.keypoints.size()
                   << " (" << extractor_type_str_ << ")";
         if (image_data.mask) {
@@ -329,25 +727,68 @@ class FeatureWriterThread : public Thread {
           database_->WriteFrame(frame);
         }
 
-        if (!database_->ExistsKeypoints(image_data.image.ImageId())) {
-          database_->WriteKeypoints(image_data.image.ImageId(),
-                                    image_data.keypoints);
+        const image_t image_id = image_data.image.ImageId();
+        const bool exists_keypoints = database_->ExistsKeypoints(image_id);
+        const bool exists_descriptors = database_->ExistsDescriptors(image_id);
+        if (exists_keypoints || exists_descriptors) {
+          // The features are outdated and the matches of the image refer to
+          // the indices of the previous features.
+          DeleteMatches(image_id);
+        }
+
+        if (exists_keypoints) {
+          database_->UpdateKeypoints(image_id, image_data.keypoints);
+        } else {
+          database_->WriteKeypoints(image_id, image_data.keypoints);
         }
 
-        if (!database_->ExistsDescriptors(image_data.image.ImageId())) {
-          database_->WriteDescriptors(image_data.image.ImageId(),
-                                      image_data.descriptors);
+        if (exists_descriptors) {
+          database_->UpdateDescriptors(image_id, image_data.descriptors);
+        } else {
+          database_->WriteDescriptors(image_id, image_data.descriptors);
         }
+
+        if (image_data.fingerprint.options_hash != 0) {
+          database_->WriteFeatureExtractionFingerprint(image_id,
+                                                       image_data.fingerprint);
+        }
+
+        buffer_pool_->ReleaseKeypoints(&image_data.keypoints);
+
+        IncrementMetricCounter("colmap_extracted_images_total");
       } else {
         break;
       }
     }
   }
 
+  void DeleteMatches(image_t image_id) {
+    if (!image_ids_.has_value()) {
+      image_ids_.emplace();
+      for (const Image& image : database_->ReadAllImages()) {
+        image_ids_->push_back(image.ImageId());
+      }
+    }
+    for (const image_t other_image_id : *image_ids_) {
+      if (other_image_id == image_id) {
+        continue;
+      }
+      if (database_->ExistsMatches(image_id, other_image_id)) {
+        database_->DeleteMatches(image_id, other_image_id);
+      }
+      if (database_->ExistsTwoViewGeometry(image_id, other_image_id)) {
+        database_->DeleteTwoViewGeometry(image_id, other_image_id);
+      }
+    }
+  }
+
   const std::string extractor_type_str_;
   const size_t num_images_;
   Database* database_;
-  JobQueue<ImageData>* input_queue_;
+  FeatureExtractionBufferPool* buffer_pool_;
+  LockFreeJobQueue<ImageData>* input_queue_;
+  // Lazily initialized identifiers of all images in the database.
+  std::optional<std::vector<image_t>> image_ids_;
 };
 
 // Feature extraction class to extract features for all images in a directory.
@@ -356,7 +797,8 @@ class FeatureExtractorController : public Thread {
   FeatureExtractorController(const std::filesystem::path& database_path,
                              const ImageReaderOptions& reader_options,
                              const FeatureExtractionOptions& extraction_options)
-      : reader_options_(reader_options),
+      : reader_options_(
+            GetEffectiveReaderOptions(reader_options, extraction_options)),
         extraction_options_(extraction_options),
         database_(Database::Open(database_path)),
         image_reader_(reader_options_, database_.get()) {
@@ -388,14 +830,37 @@ class FeatureExtractorController : public Thread {
     // avoid excess in memory usage since images and features take lots of
     // memory.
     constexpr int kQueueSize = 1;
-    resizer_queue_ = std::make_unique<JobQueue<ImageData>>(kQueueSize);
-    extractor_queue_ = std::make_unique<JobQueue<ImageData>>(kQueueSize);
-    writer_queue_ = std::make_unique<JobQueue<ImageData>>(kQueueSize);
+    resizer_queue_ =
+        std::make_unique<LockFreeJobQueue<ImageData>>(kQueueSize);
+    extractor_queue_ =
+        std::make_unique<LockFreeJobQueue<ImageData>>(kQueueSize);
+    writer_queue_ = std::make_unique<LockFreeJobQueue<ImageData>>(kQueueSize);
 
     const int max_image_size = extraction_options_.EffMaxImageSize();
-    for (int i = 0; i < num_threads; ++i) {
-      resizers_.emplace_back(std::make_unique<ImageResizerThread>(
-          max_image_size, resizer_queue_.get(), extractor_queue_.get()));
+#if defined(COLMAP_NVJPEG_ENABLED)
+    if (reader_options_.defer_jpeg_decoding &&
+        extraction_options_.use_gpu_decoding) {
+      for (const int gpu_index :
+           CSVToVector<int>(extraction_options_.gpu_index)) {
+        resizers_.emplace_back(
+            std::make_unique<GpuImageDecoderThread>(reader_options_.image_path,
+                                                    reader_options_.as_rgb,
+                                                    max_image_size,
+                                                    gpu_index,
+                                                    resizer_queue_.get(),
+                                                    extractor_queue_.get()));
+      }
+    }
+#endif  // COLMAP_NVJPEG_ENABLED
+    if (resizers_.empty()) {
+      for (int i = 0; i < num_threads; ++i) {
+        resizers_.emplace_back(
+            std::make_unique<ImageResizerThread>(reader_options_.image_path,
+                                                 reader_options_.as_rgb,
+                                                 max_image_size,
+                                                 resizer_queue_.get(),
+                                                 extractor_queue_.get()));
+      }
     }
 
     // Determine if GPU extraction should be used. SIFT GPU extraction is not
@@ -426,13 +891,19 @@ class FeatureExtractorController : public Thread {
       worker_extraction_options.num_threads =
           std::max(num_threads / static_cast<int>(gpu_indices.size()), 1);
 
-      for (const int gpu_index : gpu_indices) {
-        worker_extraction_options.gpu_index = std::to_string(gpu_index);
-        extractors_.emplace_back(
-            std::make_unique<FeatureExtractorThread>(worker_extraction_options,
-                                                     camera_mask,
-                                                     extractor_queue_.get(),
-                                                     writer_queue_.get()));
+      if (extraction_options_.num_cpu_workers > 0) {
+        CreateHybridExtractors(
+            worker_extraction_options, gpu_indices, camera_mask);
+      } else {
+        for (const int gpu_index : gpu_indices) {
+          worker_extraction_options.gpu_index = std::to_string(gpu_index);
+          extractors_.emplace_back(std::make_unique<FeatureExtractorThread>(
+              worker_extraction_options,
+              camera_mask,
+              &buffer_pool_,
+              extractor_queue_.get(),
+              writer_queue_.get()));
+        }
       }
     } else {
       const static FeatureExtractionOptions kDefaultExtractionOptions;
@@ -478,6 +949,7 @@ class FeatureExtractorController : public Thread {
         extractors_.emplace_back(
             std::make_unique<FeatureExtractorThread>(worker_extraction_options,
                                                      camera_mask,
+                                                     &buffer_pool_,
                                                      extractor_queue_.get(),
                                                      writer_queue_.get()));
       }
@@ -486,15 +958,102 @@ class FeatureExtractorController : public Thread {
     writer_ = std::make_unique<FeatureWriterThread>(extraction_options_.type,
                                                     image_reader_.NumImages(),
                                                     database_.get(),
+                                                    &buffer_pool_,
                                                     writer_queue_.get());
   }
 
  private:
+  // Creates one worker per GPU plus the CPU workers, which each have their own
+  // input queue fed by the scheduler thread.
+  void CreateHybridExtractors(const FeatureExtractionOptions& gpu_options,
+                              const std::vector<int>& gpu_indices,
+                              const std::shared_ptr<Bitmap>& camera_mask) {
+    // Rough initial throughputs in pixels per second, which are only used
+    // until the first images of each worker were extracted.
+    constexpr double kInitialGpuThroughput = 5e7;
+    constexpr double kInitialCpuThroughput = 2e6;
+
+    std::vector<FeatureExtractionOptions> worker_options;
+    std::vector<double> initial_throughputs;
+    for (const int gpu_index : gpu_indices) {
+      FeatureExtractionOptions options = gpu_options;
+      options.gpu_index = std::to_string(gpu_index);
+      worker_options.push_back(std::move(options));
+      initial_throughputs.push_back(kInitialGpuThroughput);
+    }
+
+    FeatureExtractionOptions cpu_options = gpu_options;
+    cpu_options.use_gpu = false;
+    const int num_cpu_workers = extraction_options_.num_cpu_workers;
+    switch (extraction_options_.type) {
+      case FeatureExtractorType::SIFT:
+        cpu_options.num_threads = 1;
+        for (int i = 0; i < num_cpu_workers; ++i) {
+          worker_options.push_back(cpu_options);
+          initial_throughputs.push_back(kInitialCpuThroughput);
+        }
+        break;
+      case FeatureExtractorType::ALIKED_N16ROT:
+      case FeatureExtractorType::ALIKED_N32:
+        // A single CPU worker to limit the RAM usage, see below.
+        cpu_options.num_threads = num_cpu_workers;
+        worker_options.push_back(cpu_options);
+        initial_throughputs.push_back(kInitialCpuThroughput * num_cpu_workers);
+        break;
+      default:
+        LOG(FATAL_THROW) << "Unknown feature extractor type: "
+                         << FeatureExtractorTypeToString(
+                                extraction_options_.type);
+    }
+
+    scheduler_ =
+        std::make_unique<FeatureExtractionScheduler>(initial_throughputs);
+
+    const size_t worker_queue_size =
+        std::max(1, extraction_options_.batch_size);
+    std::vector<LockFreeJobQueue<ImageData>*> worker_queues;
+    for (size_t i = 0; i < worker_options.size(); ++i) {
+      worker_queues_.push_back(
+          std::make_unique<LockFreeJobQueue<ImageData>>(worker_queue_size));
+      worker_queues.push_back(worker_queues_.back().get());
+      extractors_.emplace_back(
+          std::make_unique<FeatureExtractorThread>(worker_options[i],
+                                                   camera_mask,
+                                                   &buffer_pool_,
+                                                   worker_queues_.back().get(),
+                                                   writer_queue_.get(),
+                                                   scheduler_.get(),
+                                                   i));
+    }
+
+    scheduler_thread_ = std::make_unique<FeatureExtractionSchedulerThread>(
+        scheduler_.get(), extractor_queue_.get(), std::move(worker_queues));
+
+    LOG(INFO) << StringPrintf(
+        "Scheduling feature extraction among %d GPU and %d CPU workers",
+        static_cast<int>(gpu_indices.size()),
+        static_cast<int>(worker_options.size() - gpu_indices.size()));
+  }
+
   void Run() override {
+    ScopedResourceUsage resource_usage("FeatureExtractorController");
     LOG_HEADING1("Feature extraction");
     Timer run_timer;
     run_timer.Start();
 
+    std::vector<std::unique_ptr<ScopedMetricFn>> metric_fns;
+    const auto AddQueueSizeMetric =
+        [&metric_fns](const std::string& name,
+                      const LockFreeJobQueue<ImageData>* queue) {
+          metric_fns.push_back(std::make_unique<ScopedMetricFn>(
+              "colmap_job_queue_size{queue=\"" + name + "\"}",
+              MetricType::kGauge,
+              [queue]() { return queue->Size(); }));
+        };
+    AddQueueSizeMetric("resizer", resizer_queue_.get());
+    AddQueueSizeMetric("extractor", extractor_queue_.get());
+    AddQueueSizeMetric("writer", writer_queue_.get());
+
     for (auto& resizer : resizers_) {
       resizer->Start();
     }
@@ -503,6 +1062,10 @@ class FeatureExtractorController : public Thread {
       extractor->Start();
     }
 
+    if (scheduler_thread_) {
+      scheduler_thread_->Start();
+    }
+
     writer_->Start();
 
     for (auto& extractor : extractors_) {
@@ -511,33 +1074,50 @@ class FeatureExtractorController : public Thread {
       }
     }
 
+    // Read the metadata of all new images in parallel upfront, so that the
+    // sequential image reader is not bound by the file system latency.
+    image_reader_.PrescanMetaData(extraction_options_.num_threads);
+
     while (image_reader_.NextIndex() < image_reader_.NumImages()) {
       if (IsStopped()) {
         resizer_queue_->Stop();
         extractor_queue_->Stop();
         resizer_queue_->Clear();
         extractor_queue_->Clear();
+        for (auto& worker_queue : worker_queues_) {
+          worker_queue->Stop();
+          worker_queue->Clear();
+        }
         break;
       }
 
       ImageData image_data;
       image_data.bitmap = std::make_unique<Bitmap>();
+      buffer_pool_.AcquireBitmap(image_data.bitmap.get());
+      buffer_pool_.AcquireKeypoints(&image_data.keypoints);
       Bitmap mask;
+      if (!reader_options_.mask_path.empty()) {
+        buffer_pool_.AcquireBitmap(&mask);
+      }
       image_data.status = image_reader_.Next(&image_data.rig,
                                              &image_data.camera,
                                              &image_data.image,
                                              &image_data.pose_prior,
                                              image_data.bitmap.get(),
-                                             &mask);
-      if (!mask.IsEmpty()) {
+                                             &mask,
+                                             &image_data.fingerprint,
+                                             &image_data.timestamp);
+      if (mask.IsEmpty()) {
+        buffer_pool_.ReleaseBitmap(&mask);
+      } else {
         image_data.mask = std::make_unique<Bitmap>(std::move(mask));
       }
 
       if (image_data.status != ImageReader::Status::SUCCESS) {
-        // Release the memory, since it is not used afterwards.
-        *image_data.bitmap = Bitmap();
+        // Recycle the memory, since it is not used afterwards.
+        buffer_pool_.ReleaseBitmap(image_data.bitmap.get());
         if (image_data.mask) {
-          *image_data.mask = Bitmap();
+          buffer_pool_.ReleaseBitmap(image_data.mask.get());
         }
       }
 
@@ -552,6 +1132,13 @@ class FeatureExtractorController : public Thread {
 
     extractor_queue_->Wait();
     extractor_queue_->Stop();
+    if (scheduler_thread_) {
+      scheduler_thread_->Wait();
+    }
+    for (auto& worker_queue : worker_queues_) {
+      worker_queue->Wait();
+      worker_queue->Stop();
+    }
     for (auto& extractor : extractors_) {
       extractor->Wait();
     }
@@ -569,13 +1156,21 @@ class FeatureExtractorController : public Thread {
   std::shared_ptr<Database> database_;
   ImageReader image_reader_;
 
+  // Must outlive the threads below, which recycle their buffers in the pool.
+  FeatureExtractionBufferPool buffer_pool_;
+
   std::vector<std::unique_ptr<Thread>> resizers_;
   std::vector<std::unique_ptr<Thread>> extractors_;
   std::unique_ptr<Thread> writer_;
 
-  std::unique_ptr<JobQueue<ImageData>> resizer_queue_;
-  std::unique_ptr<JobQueue<ImageData>> extractor_queue_;
-  std::unique_ptr<JobQueue<ImageData>> writer_queue_;
+  std::unique_ptr<LockFreeJobQueue<ImageData>> resizer_queue_;
+  std::unique_ptr<LockFreeJobQueue<ImageData>> extractor_queue_;
+  std::unique_ptr<LockFreeJobQueue<ImageData>> writer_queue_;
+
+  // Only used to schedule among GPU and CPU workers.
+  std::unique_ptr<FeatureExtractionScheduler> scheduler_;
+  std::unique_ptr<Thread> scheduler_thread_;
+  std::vector<std::unique_ptr<LockFreeJobQueue<ImageData>>> worker_queues_;
 };
 
 // Import features from text files. Each image must have a corresponding text
@@ -592,6 +1187,7 @@ class FeatureImporterController : public Thread {
 
  private:
   void Run() override {
+    ScopedResourceUsage resource_usage("FeatureImporterController");
     LOG_HEADING1("Feature import");
     Timer run_timer;
     run_timer.Start();
@@ -0,0 +1,143 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/controllers/feature_extraction_scheduler.h"
+
+#include "colmap/util/logging.h"
+
+#include <algorithm>
+
+namespace colmap {
+namespace {
+
+// Weight of the latest measurement in the moving average of the throughput.
+constexpr double kThroughputSmoothing = 0.3;
+
+}  // namespace
+
+FeatureExtractionScheduler::FeatureExtractionScheduler(
+    const std::vector<double>& initial_throughputs) {
+  THROW_CHECK(!initial_throughputs.empty());
+  workers_.resize(initial_throughputs.size());
+  for (size_t i = 0; i < initial_throughputs.size(); ++i) {
+    THROW_CHECK_GT(initial_throughputs[i], 0);
+    workers_[i].throughput = initial_throughputs[i];
+  }
+}
+
+size_t FeatureExtractionScheduler::NumWorkers() const {
+  return workers_.size();
+}
+
+size_t FeatureExtractionScheduler::Schedule(const double cost) {
+  THROW_CHECK_GE(cost, 0);
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  const auto find_earliest_worker = [this, cost](bool respect_max_cost) {
+    size_t best_worker_idx = workers_.size();
+    double best_completion_time = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < workers_.size(); ++i) {
+      const Worker& worker = workers_[i];
+      if (respect_max_cost && cost >= worker.max_cost) {
+        continue;
+      }
+      const double completion_time =
+          (worker.pending_cost + cost) / worker.throughput;
+      if (completion_time < best_completion_time) {
+        best_completion_time = completion_time;
+        best_worker_idx = i;
+      }
+    }
+    return best_worker_idx;
+  };
+
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    Worker& worker = workers_[i];
+    if (!worker.has_measurement && worker.pending_cost == 0 &&
+        cost < worker.max_cost) {
+      worker.pending_cost += cost;
+      return i;
+    }
+  }
+
+  size_t worker_idx = find_earliest_worker(/*respect_max_cost=*/true);
+  if (worker_idx == workers_.size()) {
+    worker_idx = find_earliest_worker(/*respect_max_cost=*/false);
+  }
+  THROW_CHECK_LT(worker_idx, workers_.size());
+
+  workers_[worker_idx].pending_cost += cost;
+  return worker_idx;
+}
+
+void FeatureExtractionScheduler::Finish(const size_t worker_idx,
+                                        const double cost,
+                                        const double elapsed_seconds) {
+  THROW_CHECK_GE(cost, 0);
+  THROW_CHECK_GE(elapsed_seconds, 0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  Worker& worker = workers_.at(worker_idx);
+  worker.pending_cost = std::max(0.0, worker.pending_cost - cost);
+  if (cost == 0 || elapsed_seconds == 0) {
+    return;
+  }
+  const double throughput = cost / elapsed_seconds;
+  if (worker.has_measurement) {
+    worker.throughput = kThroughputSmoothing * throughput +
+                        (1 - kThroughputSmoothing) * worker.throughput;
+  } else {
+    worker.throughput = throughput;
+    worker.has_measurement = true;
+  }
+}
+
+void FeatureExtractionScheduler::LimitCost(const size_t worker_idx,
+                                           const double max_cost) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Worker& worker = workers_.at(worker_idx);
+  worker.max_cost = std::min(worker.max_cost, max_cost);
+}
+
+double FeatureExtractionScheduler::Throughput(const size_t worker_idx) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return workers_.at(worker_idx).throughput;
+}
+
+double FeatureExtractionScheduler::PendingCost(const size_t worker_idx) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return workers_.at(worker_idx).pending_cost;
+}
+
+double FeatureExtractionScheduler::MaxCost(const size_t worker_idx) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return workers_.at(worker_idx).max_cost;
+}
+
+}  // namespace colmap
@@ -0,0 +1,86 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace colmap {
+
+// Schedules feature extraction jobs among heterogeneous workers, e.g., a mix
+// of GPU and CPU extractors. Each job is assigned to the worker with the
+// earliest expected completion time given its pending work and its measured
+// throughput. Since the cost of a job (e.g., its number of pixels) weighs more
+// on slow workers, large images are routed to fast workers and small images
+// fill the slow workers, which avoids that the slow workers stall the tail of
+// the extraction. This class is thread-safe.
+class FeatureExtractionScheduler {
+ public:
+  // The initial throughputs in cost units per second are only used until the
+  // first job of the worker finished.
+  explicit FeatureExtractionScheduler(
+      const std::vector<double>& initial_throughputs);
+
+  size_t NumWorkers() const;
+
+  // Assigns a job with the given non-negative cost to a worker and returns its
+  // index. Idle workers without any finished job are preferred to measure
+  // their throughput. Workers whose cost limit is exceeded by the job are not
+  // considered, unless the job exceeds the limits of all workers.
+  size_t Schedule(double cost);
+
+  // Reports that the worker finished jobs of the given total cost within the
+  // elapsed time. The throughput is estimated as an exponential moving average.
+  void Finish(size_t worker_idx, double cost, double elapsed_seconds);
+
+  // Restricts the worker to jobs with a cost below max_cost, e.g., after a GPU
+  // worker fell back to the CPU because it ran out of memory. Other jobs are
+  // rebalanced to the remaining workers.
+  void LimitCost(size_t worker_idx, double max_cost);
+
+  double Throughput(size_t worker_idx) const;
+  double PendingCost(size_t worker_idx) const;
+  double MaxCost(size_t worker_idx) const;
+
+ private:
+  struct Worker {
+    double throughput = 0;
+    double pending_cost = 0;
+    double max_cost = std::numeric_limits<double>::infinity();
+    bool has_measurement = false;
+  };
+
+  mutable std::mutex mutex_;
+  std::vector<Worker> workers_;
+};
+
+}  // namespace colmap
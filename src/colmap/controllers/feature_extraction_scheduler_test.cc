@@ -0,0 +1,114 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/controllers/feature_extraction_scheduler.h"
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+TEST(FeatureExtractionScheduler, Empty) {
+  EXPECT_ANY_THROW(FeatureExtractionScheduler({}));
+  EXPECT_ANY_THROW(FeatureExtractionScheduler({0}));
+}
+
+TEST(FeatureExtractionScheduler, MeasureIdleWorkers) {
+  FeatureExtractionScheduler scheduler({10, 1, 1});
+  EXPECT_EQ(scheduler.NumWorkers(), 3);
+  EXPECT_EQ(scheduler.Schedule(10), 0);
+  EXPECT_EQ(scheduler.Schedule(10), 1);
+  EXPECT_EQ(scheduler.Schedule(10), 2);
+  EXPECT_EQ(scheduler.Schedule(10), 0);
+}
+
+TEST(FeatureExtractionScheduler, EarliestCompletionTime) {
+  // One fast GPU worker and two slow CPU workers.
+  FeatureExtractionScheduler scheduler({1, 1, 1});
+  for (size_t i = 0; i < scheduler.NumWorkers(); ++i) {
+    EXPECT_EQ(scheduler.Schedule(10), i);
+    scheduler.Finish(i, 10, i == 0 ? 1 : 10);
+  }
+
+  // Large jobs go to the fast worker until its backlog exceeds the time that
+  // the slow workers need.
+  EXPECT_EQ(scheduler.Schedule(10), 0);
+  EXPECT_EQ(scheduler.Schedule(10), 0);
+  EXPECT_EQ(scheduler.PendingCost(0), 20);
+  EXPECT_EQ(scheduler.Schedule(10), 0);
+  // Small jobs fill the slow workers.
+  EXPECT_EQ(scheduler.Schedule(1), 1);
+  EXPECT_EQ(scheduler.Schedule(1), 2);
+  EXPECT_EQ(scheduler.Schedule(10), 0);
+  EXPECT_EQ(scheduler.PendingCost(0), 40);
+  EXPECT_EQ(scheduler.PendingCost(1), 1);
+  EXPECT_EQ(scheduler.PendingCost(2), 1);
+  EXPECT_ANY_THROW(scheduler.Schedule(-1));
+}
+
+TEST(FeatureExtractionScheduler, Finish) {
+  FeatureExtractionScheduler scheduler({10});
+  EXPECT_EQ(scheduler.Schedule(10), 0);
+  // The first measurement replaces the initial throughput.
+  scheduler.Finish(0, 10, 5);
+  EXPECT_EQ(scheduler.PendingCost(0), 0);
+  EXPECT_EQ(scheduler.Throughput(0), 2);
+  // Later measurements are smoothed.
+  EXPECT_EQ(scheduler.Schedule(10), 0);
+  scheduler.Finish(0, 10, 1);
+  EXPECT_GT(scheduler.Throughput(0), 2);
+  EXPECT_LT(scheduler.Throughput(0), 10);
+  // Failed jobs without elapsed time do not change the throughput.
+  const double throughput = scheduler.Throughput(0);
+  scheduler.Finish(0, 0, 1);
+  scheduler.Finish(0, 1, 0);
+  EXPECT_EQ(scheduler.Throughput(0), throughput);
+  EXPECT_EQ(scheduler.PendingCost(0), 0);
+  EXPECT_ANY_THROW(scheduler.Finish(1, 1, 1));
+}
+
+TEST(FeatureExtractionScheduler, LimitCost) {
+  FeatureExtractionScheduler scheduler({10, 1});
+  scheduler.Finish(0, 10, 1);
+  scheduler.Finish(1, 1, 1);
+  scheduler.LimitCost(0, 5);
+  scheduler.LimitCost(0, 8);
+  EXPECT_EQ(scheduler.MaxCost(0), 5);
+  EXPECT_EQ(scheduler.Schedule(4), 0);
+  // Jobs exceeding the limit are routed to the other workers.
+  EXPECT_EQ(scheduler.Schedule(5), 1);
+  EXPECT_EQ(scheduler.Schedule(6), 1);
+  // Unless they exceed the limits of all workers.
+  scheduler.LimitCost(1, 5);
+  EXPECT_EQ(scheduler.Schedule(7), 0);
+}
+
+}  // namespace
+}  // namespace colmap
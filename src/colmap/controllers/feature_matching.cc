@@ -34,8 +34,11 @@
 #include "colmap/feature/matcher.h"
 #include "colmap/feature/utils.h"
 #include "colmap/scene/database.h"
+#include "colmap/scene/database_shard.h"
 #include "colmap/util/file.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/resource_usage.h"
+#include "colmap/util/threading.h"
 #include "colmap/util/timer.h"
 
 #include <fstream>
@@ -43,6 +46,52 @@
 namespace colmap {
 namespace {
 
+// Maximum number of matches and two-view geometries that are queued for the
+// asynchronous database writer before matching blocks.
+constexpr size_t kMaxNumPendingDatabaseWrites = 2000;
+
+// Minimum time between two checkpoints of the feature matching progress.
+constexpr double kCheckpointIntervalSeconds = 60.0;
+
+// Resumes the pair generator from the checkpoint, if it exists and matches
+// the generator. Otherwise, matching starts from the first image pair.
+void ResumePairGenerator(const std::filesystem::path& checkpoint_path,
+                         PairGenerator* pair_generator) {
+  if (checkpoint_path.empty() || !ExistsFile(checkpoint_path)) {
+    return;
+  }
+  std::ifstream file(checkpoint_path);
+  THROW_CHECK_FILE_OPEN(file, checkpoint_path);
+  std::string cursor;
+  std::getline(file, cursor);
+  try {
+    pair_generator->Seek(cursor);
+    LOG(INFO) << "Resuming feature matching from checkpoint "
+              << checkpoint_path;
+  } catch (const std::exception& error) {
+    LOG(WARNING) << "Ignoring incompatible feature matching checkpoint "
+                 << checkpoint_path << ": " << error.what();
+  }
+}
+
+void WritePairGeneratorCheckpoint(const std::filesystem::path& checkpoint_path,
+                                  const PairGenerator& pair_generator) {
+  const std::string cursor = pair_generator.Cursor();
+  if (cursor.empty()) {
+    return;
+  }
+  // Replace the checkpoint atomically, so that a crash never leaves a
+  // partially written checkpoint behind.
+  std::filesystem::path tmp_path = checkpoint_path;
+  tmp_path += ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::trunc);
+    THROW_CHECK_FILE_OPEN(file, tmp_path);
+    file << cursor << '\n';
+  }
+  std::filesystem::rename(tmp_path, checkpoint_path);
+}
+
 void RigVerification(const std::shared_ptr<Database>& database,
                      const std::shared_ptr<FeatureMatcherCache>& cache,
                      const TwoViewGeometryOptions& geometry_options,
@@ -150,6 +199,7 @@ void RigVerification(const std::shared_ptr<Database>& database,
   }
 
   thread_pool.Wait();
+  cache->FlushWrites();
 }
 
 class FeatureMatcherThread : public Thread {
@@ -160,16 +210,42 @@ class FeatureMatcherThread : public Thread {
       const FeatureMatchingOptions& matching_options,
       const TwoViewGeometryOptions& geometry_options,
       const std::filesystem::path& database_path) {
-    auto database = Database::Open(database_path);
+    // In sharded mode, the matches and two-view geometries are written into
+    // the shard database, while the features are still read from the main
+    // database, optionally through the read pool.
+    std::shared_ptr<Database> database = Database::Open(database_path);
+    if (matching_options.num_shards > 1) {
+      database = OpenShardDatabase(std::move(database),
+                                   matching_options.shard_database_path);
+    }
     auto cache = std::make_shared<FeatureMatcherCache>(
-        pairing_options.CacheSize(), database);
+        pairing_options.CacheSize(),
+        database,
+        kMaxNumPendingDatabaseWrites,
+        Database::OpenReadOnlyPool(
+            database_path,
+            GetEffectiveNumThreads(matching_options.num_threads)),
+        static_cast<size_t>(1024.0 * 1024.0 * 1024.0 *
+                            matching_options.feature_cache_size),
+        matching_options.spill_cache_path,
+        static_cast<size_t>(1024.0 * 1024.0 * 1024.0 *
+                            matching_options.spill_cache_size));
     return std::make_unique<FeatureMatcherThread>(
         matching_options,
         geometry_options,
         database,
         cache,
-        [pairing_options, cache]() {
-          return std::make_unique<PairGeneratorType>(pairing_options, cache);
+        [pairing_options,
+         shard_index = matching_options.shard_index,
+         num_shards = matching_options.num_shards,
+         cache]() -> std::unique_ptr<PairGenerator> {
+          auto pair_generator =
+              std::make_unique<PairGeneratorType>(pairing_options, cache);
+          if (num_shards > 1) {
+            return std::make_unique<ShardedPairGenerator>(
+                std::move(pair_generator), shard_index, num_shards);
+          }
+          return pair_generator;
         });
   }
 
@@ -192,6 +268,7 @@ class FeatureMatcherThread : public Thread {
 
  private:
   void Run() override {
+    ScopedResourceUsage resource_usage("FeatureMatcherThread");
     LOG_HEADING1("Feature matching & geometric verification");
 
     Timer run_timer;
@@ -204,6 +281,20 @@ class FeatureMatcherThread : public Thread {
     std::unique_ptr<PairGenerator> pair_generator =
         THROW_CHECK_NOTNULL(pair_generator_factory_());
 
+    const std::filesystem::path& checkpoint_path =
+        matching_options_.checkpoint_path;
+    if (!checkpoint_path.empty()) {
+      if (pair_generator->Cursor().empty()) {
+        LOG(WARNING) << "Pair generator does not support checkpoints";
+      }
+      ResumePairGenerator(checkpoint_path, pair_generator.get());
+    }
+
+    FeatureMatchingProgressReporter progress_reporter(
+        matching_options_, &matcher_, cache_.get());
+
+    Timer checkpoint_timer;
+    checkpoint_timer.Start();
     while (!pair_generator->HasFinished()) {
       if (IsStopped()) {
         run_timer.PrintMinutes();
@@ -215,6 +306,22 @@ class FeatureMatcherThread : public Thread {
           pair_generator->Next();
       matcher_.Match(image_pairs);
       LOG(INFO) << StringPrintf("in %.3fs", timer.ElapsedSeconds());
+      progress_reporter.MaybeReport(pair_generator->Progress());
+
+      if (!checkpoint_path.empty() &&
+          checkpoint_timer.ElapsedSeconds() >= kCheckpointIntervalSeconds) {
+        // Only checkpoint image pairs, whose results are in the database.
+        cache_->FlushWrites();
+        WritePairGeneratorCheckpoint(checkpoint_path, *pair_generator);
+        checkpoint_timer.Restart();
+      }
+    }
+
+    cache_->FlushWrites();
+    progress_reporter.MaybeReport(pair_generator->Progress(), /*force=*/true);
+
+    if (!checkpoint_path.empty() && ExistsFile(checkpoint_path)) {
+      std::filesystem::remove(checkpoint_path);
     }
 
     run_timer.PrintMinutes();
@@ -251,7 +358,12 @@ class GeometricVerifierThread : public Thread {
       const std::filesystem::path& database_path) {
     auto database = Database::Open(database_path);
     auto cache = std::make_shared<FeatureMatcherCache>(
-        pairing_options.CacheSize(), database);
+        pairing_options.CacheSize(),
+        database,
+        kMaxNumPendingDatabaseWrites,
+        Database::OpenReadOnlyPool(
+            database_path,
+            GetEffectiveNumThreads(verifier_options.num_threads)));
     return std::make_unique<GeometricVerifierThread>(
         verifier_options,
         geometry_options,
@@ -304,6 +416,8 @@ class GeometricVerifierThread : public Thread {
       LOG(INFO) << StringPrintf("in %.3fs", timer.ElapsedSeconds());
     }
 
+    cache_->FlushWrites();
+
     if (verifier_.Options().rig_verification) {
       run_timer.Restart();
       LOG_HEADING1("Rig verification");
@@ -344,6 +458,15 @@ std::unique_ptr<Thread> CreateVocabTreeFeatureMatcher(
       pairing_options, matching_options, geometry_options, database_path);
 }
 
+std::unique_ptr<Thread> CreateGlobalDescriptorFeatureMatcher(
+    const GlobalDescriptorPairingOptions& pairing_options,
+    const FeatureMatchingOptions& matching_options,
+    const TwoViewGeometryOptions& geometry_options,
+    const std::filesystem::path& database_path) {
+  return FeatureMatcherThread::Create<GlobalDescriptorPairGenerator>(
+      pairing_options, matching_options, geometry_options, database_path);
+}
+
 std::unique_ptr<Thread> CreateSequentialFeatureMatcher(
     const SequentialPairingOptions& pairing_options,
     const FeatureMatchingOptions& matching_options,
@@ -401,6 +524,7 @@ class FeaturePairsFeatureMatcher : public Thread {
 
  private:
   void Run() override {
+    ScopedResourceUsage resource_usage("FeaturePairsFeatureMatcher");
     LOG_HEADING1("Importing matches");
     Timer run_timer;
     run_timer.Start();
@@ -75,6 +75,14 @@ std::unique_ptr<Thread> CreateVocabTreeFeatureMatcher(
     const TwoViewGeometryOptions& geometry_options,
     const std::filesystem::path& database_path);
 
+// Match each image against its nearest neighbors using global image
+// descriptors aggregated from the local features.
+std::unique_ptr<Thread> CreateGlobalDescriptorFeatureMatcher(
+    const GlobalDescriptorPairingOptions& pairing_options,
+    const FeatureMatchingOptions& matching_options,
+    const TwoViewGeometryOptions& geometry_options,
+    const std::filesystem::path& database_path);
+
 // Sequentially match images within neighborhood:
 //
 // +-------------------------------+-----------------------> images[i]
@@ -30,11 +30,14 @@
 #include "colmap/controllers/feature_matching.h"
 
 #include "colmap/feature/types.h"
+#include "colmap/feature/utils.h"
 #include "colmap/retrieval/visual_index.h"
 #include "colmap/scene/synthetic.h"
 #include "colmap/util/testing.h"
 
 #include <fstream>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <gtest/gtest.h>
 
@@ -89,6 +92,55 @@ TEST(CreateExhaustiveFeatureMatcher, Nominal) {
   EXPECT_EQ(database->ReadTwoViewGeometries().size(), 6);
 }
 
+TEST(CreateExhaustiveFeatureMatcher, MaxNumFeatures) {
+  const auto test_dir = CreateTestDir();
+  const auto database_path = test_dir / "database.db";
+  auto database = Database::Open(database_path);
+  CreateTestDatabase(/*num_images=*/4, *database);
+  database->ClearMatches();
+  database->ClearTwoViewGeometries();
+
+  ExhaustivePairingOptions pairing_options;
+  FeatureMatchingOptions matching_options;
+  matching_options.use_gpu = false;
+  matching_options.num_threads = 1;
+  matching_options.max_num_features = 18;
+  matching_options.skip_geometric_verification = true;
+  TwoViewGeometryOptions geometry_options;
+  geometry_options.min_num_inliers = 1;
+
+  auto matcher = CreateExhaustiveFeatureMatcher(
+      pairing_options, matching_options, geometry_options, database_path);
+  ASSERT_NE(matcher, nullptr);
+  matcher->Start();
+  matcher->Wait();
+
+  // The matches refer to the original indices of the top-scale features.
+  std::unordered_map<image_t, std::unordered_set<point2D_t>> top_indices;
+  for (const Image& image : database->ReadAllImages()) {
+    FeatureKeypoints keypoints = database->ReadKeypoints(image.ImageId());
+    FeatureDescriptors descriptors = database->ReadDescriptors(image.ImageId());
+    std::vector<point2D_t> indices;
+    ExtractTopScaleFeatures(&keypoints,
+                            &descriptors,
+                            matching_options.max_num_features,
+                            &indices);
+    top_indices[image.ImageId()].insert(indices.begin(), indices.end());
+  }
+
+  const auto all_matches = database->ReadAllMatches();
+  EXPECT_EQ(all_matches.size(), 6);
+  for (const auto& [pair_id, matches] : all_matches) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    EXPECT_GT(matches.size(), 0);
+    EXPECT_LE(matches.size(), matching_options.max_num_features);
+    for (const FeatureMatch& match : matches) {
+      EXPECT_EQ(top_indices.at(image_id1).count(match.point2D_idx1), 1);
+      EXPECT_EQ(top_indices.at(image_id2).count(match.point2D_idx2), 1);
+    }
+  }
+}
+
 TEST(CreateVocabTreeFeatureMatcher, Nominal) {
   const auto test_dir = CreateTestDir();
   const auto database_path = test_dir / "database.db";
@@ -32,16 +32,41 @@
 #include "colmap/estimators/two_view_geometry.h"
 #include "colmap/feature/sift.h"
 #include "colmap/feature/utils.h"
+#include "colmap/util/cache.h"
 #include "colmap/util/cuda.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/tracing.h"
 
 #if defined(COLMAP_CUDA_ENABLED)
 #include <cuda_runtime.h>
 #endif
 
+#include <algorithm>
+#include <chrono>
 #include <unordered_set>
 
 namespace colmap {
+namespace {
+
+// The largest-scale features of an image together with their original
+// indices, which are matched instead of all features if the number of
+// matched features is limited.
+struct TopScaleFeatures {
+  std::shared_ptr<const FeatureKeypoints> keypoints;
+  std::shared_ptr<const FeatureDescriptors> descriptors;
+  std::vector<point2D_t> indices;
+};
+
+void MapTopScaleFeatureMatches(const TopScaleFeatures& features1,
+                               const TopScaleFeatures& features2,
+                               FeatureMatches* matches) {
+  for (FeatureMatch& match : *matches) {
+    match.point2D_idx1 = features1.indices.at(match.point2D_idx1);
+    match.point2D_idx2 = features2.indices.at(match.point2D_idx2);
+  }
+}
+
+}  // namespace
 
 FeatureMatcherWorker::FeatureMatcherWorker(
     const FeatureMatchingOptions& matching_options,
@@ -82,11 +107,46 @@ void FeatureMatcherWorker::Run() {
   }
 #endif
 
+  // If the number of matched features is limited, keep the selected features
+  // of the recently matched images, since consecutive batches mostly share
+  // images.
+  const bool limit_num_features = matching_options_.max_num_features > 0;
+  const size_t top_scale_cache_size =
+      std::max<size_t>(16, 2 * matching_options_.batch_size);
+  LRUCache<image_t, TopScaleFeatures> top_scale_features_cache(
+      top_scale_cache_size, [this](const image_t image_id) {
+        FeatureKeypoints keypoints = *cache_->GetKeypoints(image_id);
+        FeatureDescriptors descriptors = *cache_->GetDescriptors(image_id);
+        auto features = std::make_shared<TopScaleFeatures>();
+        ExtractTopScaleFeatures(&keypoints,
+                                &descriptors,
+                                matching_options_.max_num_features,
+                                &features->indices);
+        features->keypoints =
+            std::make_shared<FeatureKeypoints>(std::move(keypoints));
+        features->descriptors =
+            std::make_shared<FeatureDescriptors>(std::move(descriptors));
+        return features;
+      });
+
+  // The shared descriptor indices are built from all features of an image,
+  // so the indices of the selected features are cached per worker.
+  ThreadSafeLRUCache<image_t, FeatureDescriptorIndex> top_scale_index_cache(
+      top_scale_cache_size,
+      [&top_scale_features_cache](const image_t image_id) {
+        std::shared_ptr<FeatureDescriptorIndex> index =
+            FeatureDescriptorIndex::Create();
+        index->Build(
+            top_scale_features_cache.Get(image_id)->descriptors->ToFloat());
+        return index;
+      });
+
   if (matching_options_.type == FeatureMatcherType::SIFT_BRUTEFORCE) {
     // TODO(jsch): This is a bit ugly, but currently cannot think of a better
     // way to inject the shared descriptor index cache.
     THROW_CHECK_NOTNULL(matching_options_.sift)->cpu_descriptor_index_cache =
-        &cache_->GetFeatureDescriptorIndexCache();
+        limit_num_features ? &top_scale_index_cache
+                           : &cache_->GetFeatureDescriptorIndexCache();
     THROW_CHECK_NOTNULL(matching_options_.sift->cpu_descriptor_index_cache);
   }
 
@@ -94,6 +154,10 @@ void FeatureMatcherWorker::Run() {
   // of descriptors for any image over the whole database.
   matching_options_.max_num_matches = std::min<int>(
       matching_options_.max_num_matches, cache_->MaxNumKeypoints());
+  if (matching_options_.max_num_features > 0) {
+    matching_options_.max_num_matches = std::min(
+        matching_options_.max_num_matches, matching_options_.max_num_features);
+  }
 
   std::unique_ptr<FeatureMatcher> matcher =
       FeatureMatcher::Create(matching_options_);
@@ -105,63 +169,126 @@ void FeatureMatcherWorker::Run() {
 
   SignalValidSetup();
 
+  // Guided matching relies on the per-pair two-view geometry and is therefore
+  // always performed for one image pair at a time.
+  const size_t batch_size =
+      matching_options_.guided_matching ? 1 : matching_options_.batch_size;
+  const auto batch_timeout =
+      std::chrono::milliseconds(matching_options_.batch_timeout_ms);
+
+  std::vector<FeatureMatcherData> batch;
+  batch.reserve(batch_size);
+
   while (true) {
     if (IsStopped()) {
       break;
     }
 
     auto input_job = input_queue_->Pop();
-    if (input_job.IsValid()) {
-      auto& data = input_job.Data();
+    if (!input_job.IsValid()) {
+      continue;
+    }
 
+    // Collect further image pairs until the batch is full or no new pair
+    // arrives before the deadline. Pairs without descriptors are passed
+    // through directly.
+    batch.clear();
+    auto add_to_batch = [this, &batch](FeatureMatcherData& data) {
       if (!cache_->ExistsDescriptors(data.image_id1) ||
           !cache_->ExistsDescriptors(data.image_id2)) {
         THROW_CHECK(output_queue_->Push(std::move(data)));
-        continue;
+      } else {
+        batch.push_back(std::move(data));
+      }
+    };
+    add_to_batch(input_job.Data());
+    const auto deadline = std::chrono::steady_clock::now() + batch_timeout;
+    while (batch.size() < batch_size) {
+      auto next_job = input_queue_->PopUntil(deadline);
+      if (!next_job.IsValid()) {
+        break;
       }
+      add_to_batch(next_job.Data());
+    }
 
-      const auto& camera1 =
-          cache_->GetCamera(cache_->GetImage(data.image_id1).CameraId());
-      const auto& camera2 =
-          cache_->GetCamera(cache_->GetImage(data.image_id2).CameraId());
-
-      if (matching_options_.guided_matching) {
-        matcher->MatchGuided(
-            geometry_options_.ransac_options.max_error,
-            {
-                data.image_id1,
-                &camera1,
-                cache_->GetKeypoints(data.image_id1),
-                cache_->GetDescriptors(data.image_id1),
-                cache_->FindImagePosePriorOrNull(data.image_id1),
-            },
-            {
-                data.image_id2,
-                &camera2,
-                cache_->GetKeypoints(data.image_id2),
-                cache_->GetDescriptors(data.image_id2),
-                cache_->FindImagePosePriorOrNull(data.image_id2),
-            },
-            &data.two_view_geometry);
+    if (batch.empty()) {
+      continue;
+    }
+
+    TraceZone trace_zone("MatchFeatures");
+    trace_zone.SetNumItems(batch.size());
+
+    auto image_for_id = [this, limit_num_features, &top_scale_features_cache](
+                            const image_t image_id) {
+      FeatureMatcher::Image image{
+          image_id,
+          &cache_->GetCamera(cache_->GetImage(image_id).CameraId()),
+          nullptr,
+          nullptr,
+          cache_->FindImagePosePriorOrNull(image_id),
+      };
+      if (limit_num_features) {
+        auto features = top_scale_features_cache.Get(image_id);
+        image.keypoints = features->keypoints;
+        image.descriptors = features->descriptors;
       } else {
-        matcher->Match(
-            {
-                data.image_id1,
-                &camera1,
-                cache_->GetKeypoints(data.image_id1),
-                cache_->GetDescriptors(data.image_id1),
-                cache_->FindImagePosePriorOrNull(data.image_id1),
-            },
-            {
-                data.image_id2,
-                &camera2,
-                cache_->GetKeypoints(data.image_id2),
-                cache_->GetDescriptors(data.image_id2),
-                cache_->FindImagePosePriorOrNull(data.image_id2),
-            },
-            &data.matches);
+        image.keypoints = cache_->GetKeypoints(image_id);
+        image.descriptors = cache_->GetDescriptors(image_id);
+      }
+      return image;
+    };
+
+    if (matching_options_.guided_matching) {
+      for (auto& data : batch) {
+        matcher->MatchGuided(geometry_options_.ransac_options.max_error,
+                             image_for_id(data.image_id1),
+                             image_for_id(data.image_id2),
+                             &data.two_view_geometry);
       }
+    } else if (batch.size() == 1) {
+      matcher->Match(image_for_id(batch[0].image_id1),
+                     image_for_id(batch[0].image_id2),
+                     &batch[0].matches);
+    } else {
+      std::vector<FeatureMatcher::Image> images;
+      images.reserve(2 * batch.size());
+      for (const auto& data : batch) {
+        images.push_back(image_for_id(data.image_id1));
+        images.push_back(image_for_id(data.image_id2));
+      }
+      std::vector<std::pair<const FeatureMatcher::Image*,
+                            const FeatureMatcher::Image*>>
+          image_pairs;
+      std::vector<FeatureMatches*> matches;
+      image_pairs.reserve(batch.size());
+      matches.reserve(batch.size());
+      for (size_t i = 0; i < batch.size(); ++i) {
+        image_pairs.emplace_back(&images[2 * i], &images[2 * i + 1]);
+        matches.push_back(&batch[i].matches);
+      }
+      matcher->MatchBatch(image_pairs, matches);
+    }
 
+    // Map the matches of the selected features to the original features.
+    // Guided matching only recomputes the inlier matches, whereas the
+    // matches of the first matching pass are already mapped.
+    if (limit_num_features) {
+      for (auto& data : batch) {
+        const auto features1 = top_scale_features_cache.Get(data.image_id1);
+        const auto features2 = top_scale_features_cache.Get(data.image_id2);
+        if (matching_options_.guided_matching) {
+          MapTopScaleFeatureMatches(
+              *features1, *features2, &data.two_view_geometry.inlier_matches);
+        } else {
+          MapTopScaleFeatureMatches(*features1, *features2, &data.matches);
+        }
+      }
+    }
+
+    IncrementTraceCounter("NumMatchedPairs", batch.size());
+    IncrementMetricCounter("colmap_matched_image_pairs_total", batch.size());
+
+    for (auto& data : batch) {
       THROW_CHECK(output_queue_->Push(std::move(data)));
     }
   }
@@ -178,10 +305,12 @@ class VerifierWorker : public Thread {
                  std::shared_ptr<FeatureMatcherCache> cache,
                  JobQueue<Input>* input_queue,
                  JobQueue<Output>* output_queue,
-                 const bool use_existing_relative_pose = false)
+                 const bool use_existing_relative_pose = false,
+                 const int numa_node = ThreadPool::kAnyNumaNode)
       : options_(options),
         cache_(std::move(cache)),
         use_existing_relative_pose_(use_existing_relative_pose),
+        numa_node_(numa_node),
         input_queue_(input_queue),
         output_queue_(output_queue) {
     THROW_CHECK(options_.Check());
@@ -189,6 +318,10 @@ class VerifierWorker : public Thread {
 
  protected:
   void Run() override {
+    if (numa_node_ != ThreadPool::kAnyNumaNode) {
+      PinThreadToNumaNode(numa_node_);
+    }
+
     while (true) {
       if (IsStopped()) {
         break;
@@ -204,6 +337,8 @@ class VerifierWorker : public Thread {
           continue;
         }
 
+        COLMAP_TRACE_ZONE("VerifyPair");
+
         const auto& camera1 =
             cache_->GetCamera(cache_->GetImage(data.image_id1).CameraId());
         const auto& camera2 =
@@ -231,6 +366,8 @@ class VerifierWorker : public Thread {
               camera1, points1, camera2, points2, data.matches, options_);
         }
 
+        IncrementMetricCounter("colmap_verified_image_pairs_total");
+
         THROW_CHECK(output_queue_->Push(std::move(data)));
       }
     }
@@ -240,6 +377,7 @@ class VerifierWorker : public Thread {
   const TwoViewGeometryOptions options_;
   std::shared_ptr<FeatureMatcherCache> cache_;
   const bool use_existing_relative_pose_;
+  const int numa_node_;
   JobQueue<Input>* input_queue_;
   JobQueue<Output>* output_queue_;
 };
@@ -262,6 +400,12 @@ FeatureMatcherController::FeatureMatcherController(
   const int num_threads = GetEffectiveNumThreads(matching_options_.num_threads);
   THROW_CHECK_GT(num_threads, 0);
 
+  if (matching_options_.type == FeatureMatcherType::SIFT_BRUTEFORCE &&
+      !matching_options_.sift->cpu_descriptor_index_path.empty()) {
+    cache_->SetFeatureDescriptorIndexPath(
+        matching_options_.sift->cpu_descriptor_index_path);
+  }
+
   std::vector<int> gpu_indices = CSVToVector<int>(matching_options_.gpu_index);
   THROW_CHECK_GT(gpu_indices.size(), 0);
 
@@ -353,6 +497,17 @@ FeatureMatcherController::FeatureMatcherController(
           geometry_options_, cache_, &verifier_queue_, &output_queue_));
     }
   }
+
+  const auto AddQueueSizeMetric =
+      [this](const std::string& name, JobQueue<FeatureMatcherData>* queue) {
+        metric_fns_.push_back(std::make_unique<ScopedMetricFn>(
+            "colmap_job_queue_size{queue=\"" + name + "\"}",
+            MetricType::kGauge,
+            [queue]() { return queue->Size(); }));
+      };
+  AddQueueSizeMetric("matcher", &matcher_queue_);
+  AddQueueSizeMetric("verifier", &verifier_queue_);
+  AddQueueSizeMetric("guided_matcher", &guided_matcher_queue_);
 }
 
 FeatureMatcherController::~FeatureMatcherController() {
@@ -430,6 +585,16 @@ void FeatureMatcherController::Match(
     return;
   }
 
+  // Load the features of the involved images with batched database reads
+  // instead of one query per image on cache misses in the worker threads.
+  std::vector<image_t> image_ids;
+  image_ids.reserve(2 * image_pairs.size());
+  for (const auto& [image_id1, image_id2] : image_pairs) {
+    image_ids.push_back(image_id1);
+    image_ids.push_back(image_id2);
+  }
+  cache_->PrefetchFeatures(image_ids);
+
   //////////////////////////////////////////////////////////////////////////////
   // Match the image pairs
   //////////////////////////////////////////////////////////////////////////////
@@ -465,6 +630,7 @@ void FeatureMatcherController::Match(
         cache_->ExistsTwoViewGeometry(image_id1, image_id2);
 
     if (exists_matches && exists_two_view_geometry) {
+      stats_.num_skipped_pairs += 1;
       continue;
     }
 
@@ -500,6 +666,11 @@ void FeatureMatcherController::Match(
     THROW_CHECK(output_job.IsValid());
     auto& output = output_job.Data();
 
+    stats_.num_queue_samples += 1;
+    stats_.matcher_queue_size_sum +=
+        matcher_queue_.Size() + guided_matcher_queue_.Size();
+    stats_.verifier_queue_size_sum += verifier_queue_.Size();
+
     if (output.matches.size() <
         static_cast<size_t>(geometry_options_.min_num_inliers)) {
       output.matches = {};
@@ -510,6 +681,14 @@ void FeatureMatcherController::Match(
       output.two_view_geometry = TwoViewGeometry();
     }
 
+    stats_.num_processed_pairs += 1;
+    if (!output.matches.empty()) {
+      stats_.num_matched_pairs += 1;
+    }
+    if (!output.two_view_geometry.inlier_matches.empty()) {
+      stats_.num_verified_pairs += 1;
+    }
+
     cache_->WriteMatches(output.image_id1, output.image_id2, output.matches);
     cache_->WriteTwoViewGeometry(
         output.image_id1, output.image_id2, output.two_view_geometry);
@@ -518,6 +697,102 @@ void FeatureMatcherController::Match(
   THROW_CHECK_EQ(output_queue_.Size(), 0);
 }
 
+const FeatureMatcherController::Stats& FeatureMatcherController::GetStats()
+    const {
+  return stats_;
+}
+
+FeatureMatchingProgressReporter::FeatureMatchingProgressReporter(
+    const FeatureMatchingOptions& options,
+    const FeatureMatcherController* matcher,
+    const FeatureMatcherCache* cache)
+    : interval_(options.progress_interval),
+      callback_(options.progress_callback),
+      matcher_(THROW_CHECK_NOTNULL(matcher)),
+      cache_(THROW_CHECK_NOTNULL(cache)),
+      last_matcher_stats_(matcher->GetStats()),
+      last_cache_stats_(cache->GetStats()) {
+  timer_.Start();
+}
+
+void FeatureMatchingProgressReporter::MaybeReport(const double progress,
+                                                  const bool force) {
+  if (interval_ <= 0) {
+    return;
+  }
+  const double elapsed_time_sec = timer_.ElapsedSeconds();
+  if (!force && elapsed_time_sec - last_report_time_sec_ < interval_) {
+    return;
+  }
+
+  const FeatureMatchingProgress record = ComputeProgress(progress);
+  LOG(INFO) << record.ToString();
+  if (callback_) {
+    callback_(record);
+  }
+
+  last_report_time_sec_ = elapsed_time_sec;
+  last_matcher_stats_ = matcher_->GetStats();
+  last_cache_stats_ = cache_->GetStats();
+}
+
+FeatureMatchingProgress FeatureMatchingProgressReporter::ComputeProgress(
+    const double progress) const {
+  const FeatureMatcherController::Stats& matcher_stats = matcher_->GetStats();
+  const FeatureMatcherCache::Stats cache_stats = cache_->GetStats();
+
+  FeatureMatchingProgress record;
+  record.elapsed_time_sec = timer_.ElapsedSeconds();
+  record.interval_time_sec = record.elapsed_time_sec - last_report_time_sec_;
+  record.progress = progress;
+  if (progress > 0) {
+    record.remaining_time_sec =
+        record.elapsed_time_sec * (1 - std::min(progress, 1.0)) / progress;
+  }
+
+  record.num_processed_pairs = matcher_stats.num_processed_pairs;
+  record.num_skipped_pairs = matcher_stats.num_skipped_pairs;
+  record.num_matched_pairs = matcher_stats.num_matched_pairs;
+  record.num_verified_pairs = matcher_stats.num_verified_pairs;
+  if (record.interval_time_sec > 0) {
+    record.pairs_per_sec = (matcher_stats.num_processed_pairs -
+                            last_matcher_stats_.num_processed_pairs) /
+                           record.interval_time_sec;
+  }
+
+  const size_t num_queue_samples =
+      matcher_stats.num_queue_samples - last_matcher_stats_.num_queue_samples;
+  if (num_queue_samples > 0) {
+    record.mean_matcher_queue_size =
+        static_cast<double>(matcher_stats.matcher_queue_size_sum -
+                            last_matcher_stats_.matcher_queue_size_sum) /
+        num_queue_samples;
+    record.mean_verifier_queue_size =
+        static_cast<double>(matcher_stats.verifier_queue_size_sum -
+                            last_matcher_stats_.verifier_queue_size_sum) /
+        num_queue_samples;
+  }
+
+  const auto HitRatio = [](const size_t num_hits, const size_t num_misses) {
+    const size_t num_accesses = num_hits + num_misses;
+    return num_accesses == 0 ? -1.0
+                             : static_cast<double>(num_hits) / num_accesses;
+  };
+  record.keypoints_cache_hit_ratio = HitRatio(
+      cache_stats.num_keypoints_hits - last_cache_stats_.num_keypoints_hits,
+      cache_stats.num_keypoints_misses -
+          last_cache_stats_.num_keypoints_misses);
+  record.descriptors_cache_hit_ratio = HitRatio(
+      cache_stats.num_descriptors_hits -
+          last_cache_stats_.num_descriptors_hits,
+      cache_stats.num_descriptors_misses -
+          last_cache_stats_.num_descriptors_misses);
+  record.database_wait_time_sec = cache_stats.database_wait_time_sec -
+                                  last_cache_stats_.database_wait_time_sec;
+
+  return record;
+}
+
 GeometricVerifierController::GeometricVerifierController(
     const GeometricVerifierOptions& options,
     const TwoViewGeometryOptions& geometry_options,
@@ -530,26 +805,40 @@ GeometricVerifierController::GeometricVerifierController(
 
   const int num_threads = GetEffectiveNumThreads(options_.num_threads);
 
+  // With NUMA-aware threading, the image pairs are partitioned over one queue
+  // per NUMA node, whose verifiers are pinned to the node.
+  const int num_numa_nodes = std::min(GetNumNumaNodes(), num_threads);
+  for (int node = 0; node < num_numa_nodes; ++node) {
+    verifier_queues_.push_back(
+        std::make_unique<JobQueue<FeatureMatcherData>>());
+  }
+
   // Run geometric verification
   for (int i = 0; i < num_threads; ++i) {
-    verifiers_.emplace_back(
-        std::make_unique<VerifierWorker>(geometry_options_,
-                                         cache_,
-                                         &verifier_queue_,
-                                         &output_queue_,
-                                         options_.use_existing_relative_pose));
+    const int node = i % num_numa_nodes;
+    verifiers_.emplace_back(std::make_unique<VerifierWorker>(
+        geometry_options_,
+        cache_,
+        verifier_queues_[node].get(),
+        &output_queue_,
+        options_.use_existing_relative_pose,
+        num_numa_nodes > 1 ? node : ThreadPool::kAnyNumaNode));
   }
 }
 
 GeometricVerifierController::~GeometricVerifierController() {
-  verifier_queue_.Wait();
+  for (auto& verifier_queue : verifier_queues_) {
+    verifier_queue->Wait();
+  }
   output_queue_.Wait();
 
   for (auto& verifier : verifiers_) {
     verifier->Stop();
   }
 
-  verifier_queue_.Stop();
+  for (auto& verifier_queue : verifier_queues_) {
+    verifier_queue->Stop();
+  }
   output_queue_.Stop();
 
   for (auto& verifier : verifiers_) {
@@ -632,7 +921,11 @@ void GeometricVerifierController::Verify(
         data.two_view_geometry =
             cache_->GetTwoViewGeometry(image_id1, image_id2);
       }
-      THROW_CHECK(verifier_queue_.Push(std::move(data)));
+      // The pairs of an image are verified on the same node, where its
+      // keypoints are likely still cached.
+      THROW_CHECK(
+          verifier_queues_[image_id1 % verifier_queues_.size()]->Push(
+              std::move(data)));
     }
   }
 
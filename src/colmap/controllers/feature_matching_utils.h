@@ -32,8 +32,10 @@
 #include "colmap/controllers/feature_matching.h"
 #include "colmap/estimators/two_view_geometry.h"
 #include "colmap/feature/matcher.h"
+#include "colmap/util/metrics.h"
 #include "colmap/util/opengl_utils.h"
 #include "colmap/util/threading.h"
+#include "colmap/util/timer.h"
 
 #include <memory>
 #include <vector>
@@ -74,7 +76,8 @@ class FeatureMatcherWorker : public Thread {
 // results to the database and skips already matched image pairs. To improve
 // performance of the matching by taking advantage of caching and database
 // transactions, pass multiple images to the `Match` function. Note that the
-// database should be in an active transaction while calling `Match`.
+// database should be in an active transaction while calling `Match`, unless
+// the cache writes asynchronously in its own transactions.
 class FeatureMatcherController {
  public:
   FeatureMatcherController(const FeatureMatchingOptions& matching_options,
@@ -89,6 +92,24 @@ class FeatureMatcherController {
   // Match one batch of multiple image pairs.
   void Match(const std::vector<std::pair<image_t, image_t>>& image_pairs);
 
+  // Statistics of the image pairs passed to Match since construction.
+  struct Stats {
+    // Number of image pairs processed by the matchers, skipped because their
+    // results already exist, with at least min_num_inliers matches, and with
+    // at least min_num_inliers verified inlier matches.
+    size_t num_processed_pairs = 0;
+    size_t num_skipped_pairs = 0;
+    size_t num_matched_pairs = 0;
+    size_t num_verified_pairs = 0;
+    // Sums of the queue sizes, sampled whenever a result is written, from
+    // which the mean occupancy of the queues is derived.
+    size_t num_queue_samples = 0;
+    size_t matcher_queue_size_sum = 0;
+    size_t verifier_queue_size_sum = 0;
+  };
+
+  const Stats& GetStats() const;
+
  private:
   FeatureMatchingOptions matching_options_;
   TwoViewGeometryOptions geometry_options_;
@@ -104,6 +125,37 @@ class FeatureMatcherController {
   JobQueue<FeatureMatcherData> verifier_queue_;
   JobQueue<FeatureMatcherData> guided_matcher_queue_;
   JobQueue<FeatureMatcherData> output_queue_;
+
+  Stats stats_;
+
+  std::vector<std::unique_ptr<ScopedMetricFn>> metric_fns_;
+};
+
+// Reports the progress of a feature matcher controller in regular intervals,
+// which is logged and passed to the progress callback of the options.
+class FeatureMatchingProgressReporter {
+ public:
+  FeatureMatchingProgressReporter(const FeatureMatchingOptions& options,
+                                  const FeatureMatcherController* matcher,
+                                  const FeatureMatcherCache* cache);
+
+  // Reports the progress, if the interval of the options elapsed since the
+  // last report or if forced, where progress is the fraction of the generated
+  // image pairs or negative if unknown.
+  void MaybeReport(double progress, bool force = false);
+
+  // Computes the progress since the last report without reporting it.
+  FeatureMatchingProgress ComputeProgress(double progress) const;
+
+ private:
+  const double interval_;
+  const std::function<void(const FeatureMatchingProgress&)> callback_;
+  const FeatureMatcherController* matcher_;
+  const FeatureMatcherCache* cache_;
+  Timer timer_;
+  double last_report_time_sec_ = 0;
+  FeatureMatcherController::Stats last_matcher_stats_;
+  FeatureMatcherCache::Stats last_cache_stats_;
 };
 
 class GeometricVerifierController {
@@ -132,7 +184,8 @@ class GeometricVerifierController {
 
   std::vector<std::unique_ptr<Thread>> verifiers_;
 
-  JobQueue<FeatureMatcherData> verifier_queue_;
+  // One queue per NUMA node.
+  std::vector<std::unique_ptr<JobQueue<FeatureMatcherData>>> verifier_queues_;
   JobQueue<FeatureMatcherData> output_queue_;
 };
 
@@ -251,6 +251,97 @@ TEST(FeatureMatcherController, MatchSkipGeometricVerification) {
   EXPECT_TRUE(tvg.inlier_matches.empty());
 }
 
+TEST(FeatureMatcherController, Stats) {
+  auto data = CreateTestData(3);
+  data.database->ClearMatches();
+  data.database->ClearTwoViewGeometries();
+
+  FeatureMatcherController controller(
+      DefaultMatchingOptions(), TwoViewGeometryOptions(), data.cache);
+  ASSERT_TRUE(controller.Setup());
+
+  const auto pairs = AllPairs(data.image_ids);
+  controller.Match(pairs);
+  const FeatureMatcherController::Stats stats1 = controller.GetStats();
+  EXPECT_EQ(stats1.num_processed_pairs, pairs.size());
+  EXPECT_EQ(stats1.num_skipped_pairs, 0);
+  EXPECT_LE(stats1.num_matched_pairs, pairs.size());
+  EXPECT_LE(stats1.num_verified_pairs, stats1.num_matched_pairs);
+  EXPECT_EQ(stats1.num_queue_samples, pairs.size());
+
+  // Existing results are skipped.
+  controller.Match(pairs);
+  const FeatureMatcherController::Stats stats2 = controller.GetStats();
+  EXPECT_EQ(stats2.num_processed_pairs, pairs.size());
+  EXPECT_EQ(stats2.num_skipped_pairs, pairs.size());
+}
+
+TEST(FeatureMatchingProgressReporter, Nominal) {
+  auto data = CreateTestData(3);
+  data.database->ClearMatches();
+  data.database->ClearTwoViewGeometries();
+
+  std::vector<FeatureMatchingProgress> records;
+  FeatureMatchingOptions matching_options = DefaultMatchingOptions();
+  matching_options.progress_interval = 1e6;
+  matching_options.progress_callback =
+      [&records](const FeatureMatchingProgress& record) {
+        records.push_back(record);
+      };
+
+  FeatureMatcherController controller(
+      matching_options, TwoViewGeometryOptions(), data.cache);
+  ASSERT_TRUE(controller.Setup());
+  FeatureMatchingProgressReporter reporter(
+      matching_options, &controller, data.cache.get());
+
+  const auto pairs = AllPairs(data.image_ids);
+  controller.Match(pairs);
+
+  // The interval has not elapsed yet.
+  reporter.MaybeReport(0.5);
+  EXPECT_TRUE(records.empty());
+
+  reporter.MaybeReport(0.5, /*force=*/true);
+  ASSERT_EQ(records.size(), 1);
+  EXPECT_EQ(records[0].progress, 0.5);
+  EXPECT_GE(records[0].remaining_time_sec, 0);
+  EXPECT_EQ(records[0].num_processed_pairs, pairs.size());
+  EXPECT_EQ(records[0].num_skipped_pairs, 0);
+  EXPECT_GT(records[0].pairs_per_sec, 0);
+  EXPECT_GE(records[0].mean_matcher_queue_size, 0);
+  EXPECT_GE(records[0].keypoints_cache_hit_ratio, 0);
+  EXPECT_LE(records[0].keypoints_cache_hit_ratio, 1);
+  EXPECT_GE(records[0].database_wait_time_sec, 0);
+
+  // Interval statistics are relative to the last report.
+  controller.Match(pairs);
+  reporter.MaybeReport(/*progress=*/-1, /*force=*/true);
+  ASSERT_EQ(records.size(), 2);
+  EXPECT_EQ(records[1].progress, -1);
+  EXPECT_EQ(records[1].remaining_time_sec, -1);
+  EXPECT_EQ(records[1].num_processed_pairs, pairs.size());
+  EXPECT_EQ(records[1].num_skipped_pairs, pairs.size());
+  EXPECT_EQ(records[1].pairs_per_sec, 0);
+  EXPECT_EQ(records[1].mean_matcher_queue_size, 0);
+  EXPECT_FALSE(records[1].ToString().empty());
+}
+
+TEST(FeatureMatchingProgressReporter, Disabled) {
+  auto data = CreateTestData(2);
+  int num_records = 0;
+  FeatureMatchingOptions matching_options = DefaultMatchingOptions();
+  matching_options.progress_interval = 0;
+  matching_options.progress_callback =
+      [&num_records](const FeatureMatchingProgress&) { ++num_records; };
+  FeatureMatcherController controller(
+      matching_options, TwoViewGeometryOptions(), data.cache);
+  FeatureMatchingProgressReporter reporter(
+      matching_options, &controller, data.cache.get());
+  reporter.MaybeReport(1, /*force=*/true);
+  EXPECT_EQ(num_records, 0);
+}
+
 TEST(GeometricVerifierController, OptionsAccessor) {
   auto data = CreateTestData(3);
 
@@ -34,8 +34,11 @@
 #include "colmap/scene/database_cache.h"
 #include "colmap/sfm/global_mapper.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/resource_usage.h"
 #include "colmap/util/timer.h"
 
+#include <unordered_set>
+
 namespace colmap {
 namespace {
 
@@ -63,6 +66,18 @@ void WarnInsufficientPriorFocalLengths() {
                   "manually.";
 }
 
+DatabaseCache::Options CreateDatabaseCacheOptions(
+    const GlobalPipelineOptions& options) {
+  DatabaseCache::Options database_cache_options;
+  database_cache_options.min_num_matches = options.min_num_matches;
+  database_cache_options.ignore_watermarks = options.ignore_watermarks;
+  database_cache_options.image_names = {options.image_names.begin(),
+                                        options.image_names.end()};
+  database_cache_options.correspondence_graph_snapshot_path =
+      options.correspondence_graph_snapshot_path;
+  return database_cache_options;
+}
+
 }  // namespace
 
 GlobalPipeline::GlobalPipeline(
@@ -75,20 +90,35 @@ GlobalPipeline::GlobalPipeline(
   THROW_CHECK_NOTNULL(database);
 
   // Create database cache with relative poses for pose graph.
-  DatabaseCache::Options database_cache_options;
-  database_cache_options.min_num_matches = options_.min_num_matches;
-  database_cache_options.ignore_watermarks = options_.ignore_watermarks;
-  database_cache_options.image_names = {options_.image_names.begin(),
-                                        options_.image_names.end()};
-  database_cache_ = DatabaseCache::Create(*database, database_cache_options);
+  database_cache_ =
+      DatabaseCache::Create(*database, CreateDatabaseCacheOptions(options_));
   if (options_.decompose_relative_pose) {
-    MaybeDecomposeRelativePoses(database_cache_.get());
+    MaybeDecomposeRelativePoses(database_cache_.get(), options_.num_threads);
+  }
+
+  RegisterCallback(MODEL_UPDATE_CALLBACK);
+}
+
+GlobalPipeline::GlobalPipeline(
+    GlobalPipelineOptions options,
+    std::shared_ptr<DatabaseCache> database_cache,
+    std::shared_ptr<ReconstructionManager> reconstruction_manager)
+    : options_(std::move(options)),
+      reconstruction_manager_(
+          std::move(THROW_CHECK_NOTNULL(reconstruction_manager))) {
+  THROW_CHECK_NOTNULL(database_cache);
+
+  database_cache_ = DatabaseCache::CreateFromCache(
+      *database_cache, CreateDatabaseCacheOptions(options_));
+  if (options_.decompose_relative_pose) {
+    MaybeDecomposeRelativePoses(database_cache_.get(), options_.num_threads);
   }
 
   RegisterCallback(MODEL_UPDATE_CALLBACK);
 }
 
 void GlobalPipeline::Run() {
+  ScopedResourceUsage resource_usage("GlobalPipeline");
   const bool has_insufficient_prior_focal_lengths =
       HasInsufficientPriorFocalLengths(*database_cache_);
   if (has_insufficient_prior_focal_lengths) {
@@ -96,9 +126,17 @@ void GlobalPipeline::Run() {
   }
 
   // Add the reconstruction to the manager up front so that intermediate states
-  // can be rendered while the global mapper is running.
+  // can be rendered while the global mapper is running. When extending, the
+  // first existing reconstruction is continued instead.
+  const bool extend_reconstruction = options_.mapper.extend_reconstruction &&
+                                     reconstruction_manager_->Size() > 0;
   auto reconstruction =
-      reconstruction_manager_->Get(reconstruction_manager_->Add());
+      extend_reconstruction
+          ? reconstruction_manager_->Get(0)
+          : reconstruction_manager_->Get(reconstruction_manager_->Add());
+  const std::unordered_set<frame_t> existing_frame_ids(
+      reconstruction->RegFrameIds().begin(),
+      reconstruction->RegFrameIds().end());
 
   // Prepare mapper options with top-level options.
   GlobalMapperOptions mapper_options = options_.mapper;
@@ -118,14 +156,31 @@ void GlobalPipeline::Run() {
   LOG(INFO) << "Reconstruction done in " << run_timer.ElapsedSeconds()
             << " seconds";
 
-  // Align reconstruction to the original metric scales in rig extrinsics.
-  AlignReconstructionToOrigRigScales(database_cache_->Rigs(),
-                                     reconstruction.get());
-
-  if (!options_.image_path.empty()) {
-    LOG(INFO) << "Extracting colors ...";
-    reconstruction->ExtractColorsForAllImages(options_.image_path,
-                                              options_.num_threads);
+  if (extend_reconstruction) {
+    // The existing reconstruction is already aligned and colored, so only the
+    // colors of the new frames are extracted.
+    if (!options_.image_path.empty()) {
+      LOG(INFO) << "Extracting colors ...";
+      for (const frame_t frame_id : reconstruction->RegFrameIds()) {
+        if (existing_frame_ids.count(frame_id)) {
+          continue;
+        }
+        for (const auto& data_id : reconstruction->Frame(frame_id).ImageIds()) {
+          reconstruction->ExtractColorsForImage(data_id.id,
+                                                options_.image_path);
+        }
+      }
+    }
+  } else {
+    // Align reconstruction to the original metric scales in rig extrinsics.
+    AlignReconstructionToOrigRigScales(database_cache_->Rigs(),
+                                       reconstruction.get());
+
+    if (!options_.image_path.empty()) {
+      LOG(INFO) << "Extracting colors ...";
+      reconstruction->ExtractColorsForAllImages(options_.image_path,
+                                                options_.num_threads);
+    }
   }
 
   if (has_insufficient_prior_focal_lengths) {
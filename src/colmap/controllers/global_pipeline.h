@@ -49,6 +49,10 @@ struct GlobalPipelineOptions {
   // Names of images to reconstruct. If empty, all images are used.
   std::vector<std::string> image_names;
 
+  // Optional path to a snapshot of the correspondence graph, which is reused
+  // in subsequent runs on the same database instead of rebuilding the graph.
+  std::filesystem::path correspondence_graph_snapshot_path;
+
   // The image path at which to find the images to extract point colors.
   std::filesystem::path image_path;
 
@@ -78,6 +82,12 @@ class GlobalPipeline : public BaseController {
                  std::shared_ptr<Database> database,
                  std::shared_ptr<ReconstructionManager> reconstruction_manager);
 
+  // Reconstruct from the images of an existing database cache, filtered by
+  // the options. Relative poses already present in the cache are reused.
+  GlobalPipeline(GlobalPipelineOptions options,
+                 std::shared_ptr<DatabaseCache> database_cache,
+                 std::shared_ptr<ReconstructionManager> reconstruction_manager);
+
   void Run() override;
 
  private:
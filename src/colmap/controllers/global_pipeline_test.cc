@@ -143,6 +143,47 @@ TEST(GlobalPipeline, SfMWithRandomSeedStability) {
   }
 }
 
+TEST(GlobalPipeline, DeterministicAcrossNumThreads) {
+  SetPRNGSeed(1);
+
+  const auto database_path = CreateTestDir() / "database.db";
+
+  auto database = Database::Open(database_path);
+  Reconstruction gt_reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 4;
+  synthetic_dataset_options.num_points3D = 100;
+  SynthesizeDataset(
+      synthetic_dataset_options, &gt_reconstruction, database.get());
+  SyntheticNoiseOptions synthetic_noise_options;
+  synthetic_noise_options.point2D_stddev = 0.5;
+  SynthesizeNoise(synthetic_noise_options, &gt_reconstruction, database.get());
+
+  ViewGraphCalibrationOptions vgc_options;
+  vgc_options.random_seed = 42;
+  vgc_options.solver_options.num_threads = 1;
+  CalibrateViewGraph(vgc_options, database.get());
+
+  auto run_mapper = [&](int num_threads) {
+    GlobalPipelineOptions options;
+    options.num_threads = num_threads;
+    options.random_seed = 42;
+    options.mapper.deterministic = true;
+    auto reconstruction_manager = std::make_shared<ReconstructionManager>();
+    GlobalPipeline mapper(std::move(options), database, reconstruction_manager);
+    mapper.Run();
+    EXPECT_EQ(reconstruction_manager->Size(), 1);
+    return reconstruction_manager;
+  };
+
+  auto reconstruction_manager0 = run_mapper(/*num_threads=*/1);
+  auto reconstruction_manager1 = run_mapper(/*num_threads=*/4);
+  EXPECT_THAT(*reconstruction_manager0->Get(0),
+              ReconstructionEq(*reconstruction_manager1->Get(0)));
+}
+
 TEST(GlobalPipeline, WithExistingRelativePoses) {
   const auto database_path = CreateTestDir() / "database.db";
   auto database = Database::Open(database_path);
@@ -29,75 +29,123 @@
 
 #include "colmap/controllers/hierarchical_pipeline.h"
 
+#include "colmap/estimators/two_view_geometry.h"
 #include "colmap/scene/database.h"
 #include "colmap/scene/scene_clustering.h"
 #include "colmap/sfm/observation_manager.h"
+#include "colmap/util/file.h"
+#include "colmap/util/file_job_queue.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/resource_usage.h"
 #include "colmap/util/threading.h"
 #include "colmap/util/timer.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace colmap {
 namespace {
 
-void MergeClusters(const SceneClustering::Cluster& cluster,
-                   std::unordered_map<const SceneClustering::Cluster*,
-                                      std::shared_ptr<ReconstructionManager>>*
-                       reconstruction_managers) {
-  // Extract all reconstructions from all child clusters.
-  std::vector<std::shared_ptr<Reconstruction>> reconstructions;
-  for (const auto& child_cluster : cluster.child_clusters) {
-    if (!child_cluster.child_clusters.empty()) {
-      MergeClusters(child_cluster, reconstruction_managers);
-    }
+// The interval at which the job queue is checked for changes.
+constexpr std::chrono::seconds kJobQueuePollInterval(1);
 
-    auto& reconstruction_manager = reconstruction_managers->at(&child_cluster);
-    for (size_t i = 0; i < reconstruction_manager->Size(); ++i) {
-      reconstructions.push_back(reconstruction_manager->Get(i));
-    }
+// The name of the database of a cluster in the job queue.
+constexpr char kJobDatabaseName[] = "database.db";
+
+DatabaseCache::Options CreateDatabaseCacheOptions(
+    const HierarchicalPipelineOptions& options) {
+  DatabaseCache::Options database_cache_options;
+  if (options.use_global_mapper) {
+    database_cache_options.min_num_matches =
+        static_cast<size_t>(options.global_options.min_num_matches);
+    database_cache_options.ignore_watermarks =
+        options.global_options.ignore_watermarks;
+    database_cache_options.correspondence_graph_snapshot_path =
+        options.global_options.correspondence_graph_snapshot_path;
+  } else {
+    database_cache_options.min_num_matches =
+        static_cast<size_t>(options.incremental_options.min_num_matches);
+    database_cache_options.ignore_watermarks =
+        options.incremental_options.ignore_watermarks;
+    database_cache_options.correspondence_graph_snapshot_path =
+        options.incremental_options.correspondence_graph_snapshot_path;
   }
+  return database_cache_options;
+}
 
-  // Try to merge all child cluster reconstruction.
-  while (reconstructions.size() > 1) {
-    bool merge_success = false;
-    for (size_t i = 0; i < reconstructions.size(); ++i) {
-      const int num_reg_images_i = reconstructions[i]->NumRegImages();
-      for (size_t j = 0; j < i; ++j) {
-        const double kMaxReprojError = 8.0;
-        const int num_reg_images_j = reconstructions[j]->NumRegImages();
-        if (MergeAndFilterReconstructions(
-                kMaxReprojError, *reconstructions[j], *reconstructions[i])) {
-          LOG(INFO) << StringPrintf(
-              "=> Merged clusters with %d and %d images into %d images",
-              num_reg_images_i,
-              num_reg_images_j,
-              reconstructions[i]->NumRegImages());
-          reconstructions.erase(reconstructions.begin() + j);
-          merge_success = true;
-          break;
-        }
-      }
+FileJobQueueOptions CreateJobQueueOptions(
+    const HierarchicalPipelineOptions& options) {
+  FileJobQueueOptions job_queue_options;
+  job_queue_options.max_num_attempts = options.job_max_num_attempts;
+  job_queue_options.job_timeout = options.job_timeout;
+  return job_queue_options;
+}
 
-      if (merge_success) {
-        break;
+// Reconstruct one cluster using incremental or global mapping. The cluster is
+// given by the names of its images or, if empty, all images in the cache.
+void ReconstructCluster(
+    const HierarchicalPipelineOptions& options,
+    const std::shared_ptr<DatabaseCache>& database_cache,
+    const std::unordered_set<std::string>& image_names,
+    const int num_threads,
+    std::shared_ptr<ReconstructionManager> reconstruction_manager) {
+  if (options.use_global_mapper) {
+    GlobalPipelineOptions global_options = options.global_options;
+    global_options.image_path = options.image_path;
+    global_options.num_threads = num_threads;
+    global_options.decompose_relative_pose = false;
+    global_options.mapper.extend_reconstruction = false;
+    global_options.image_names.assign(image_names.begin(), image_names.end());
+
+    GlobalPipeline mapper(
+        std::move(global_options), database_cache, reconstruction_manager);
+    mapper.Run();
+
+    // Unlike incremental mapping, global mapping keeps the reconstruction even
+    // if it failed, so drop it before merging.
+    for (int i = static_cast<int>(reconstruction_manager->Size()) - 1; i >= 0;
+         --i) {
+      if (reconstruction_manager->Get(i)->NumRegImages() == 0) {
+        reconstruction_manager->Delete(i);
       }
     }
-
-    if (!merge_success) {
-      break;
-    }
+    return;
   }
 
-  // Insert a new reconstruction manager for merged cluster.
-  auto& reconstruction_manager = (*reconstruction_managers)[&cluster];
-  reconstruction_manager = std::make_shared<ReconstructionManager>();
-  for (const auto& reconstruction : reconstructions) {
-    reconstruction_manager->Get(reconstruction_manager->Add()) = reconstruction;
+  auto incremental_options =
+      std::make_shared<IncrementalPipelineOptions>(options.incremental_options);
+  incremental_options->image_path = options.image_path;
+  incremental_options->max_model_overlap = 3;
+  incremental_options->init_num_trials = options.init_num_trials;
+  incremental_options->num_threads = num_threads;
+
+  // Create a filtered database cache for this cluster.
+  std::shared_ptr<DatabaseCache> cluster_database_cache = database_cache;
+  if (!image_names.empty()) {
+    DatabaseCache::Options cluster_cache_options;
+    cluster_cache_options.min_num_matches =
+        static_cast<size_t>(options.incremental_options.min_num_matches);
+    cluster_cache_options.image_names = image_names;
+    cluster_database_cache =
+        DatabaseCache::CreateFromCache(*database_cache, cluster_cache_options);
   }
 
-  // Delete all merged child cluster reconstruction managers.
-  for (const auto& child_cluster : cluster.child_clusters) {
-    reconstruction_managers->erase(&child_cluster);
+  IncrementalPipeline mapper(std::move(incremental_options),
+                             std::move(cluster_database_cache),
+                             std::move(reconstruction_manager));
+  mapper.Run();
+}
+
+std::unordered_set<std::string> GetClusterImageNames(
+    const SceneClustering::Cluster& cluster,
+    const std::unordered_map<image_t, std::string>& image_id_to_name) {
+  std::unordered_set<std::string> image_names;
+  image_names.reserve(cluster.image_ids.size());
+  for (const image_t image_id : cluster.image_ids) {
+    image_names.insert(image_id_to_name.at(image_id));
   }
+  return image_names;
 }
 
 }  // namespace
@@ -106,6 +154,8 @@ bool HierarchicalPipelineOptions::Check() const {
   CHECK_OPTION_GT(init_num_trials, -1);
   CHECK_OPTION_GE(num_threads, -1);
   CHECK_OPTION_GE(num_workers, -1);
+  CHECK_OPTION_GT(job_max_num_attempts, 0);
+  CHECK_OPTION_GT(job_timeout, 0);
   clustering_options.Check();
   THROW_CHECK_EQ(clustering_options.branching, 2);
   incremental_options.Check();
@@ -125,15 +175,22 @@ HierarchicalPipeline::HierarchicalPipeline(
   LOG(INFO) << "Loading database";
   Timer timer;
   timer.Start();
-  DatabaseCache::Options database_cache_options;
-  database_cache_options.min_num_matches =
-      static_cast<size_t>(options_.incremental_options.min_num_matches);
-  database_cache_options.ignore_watermarks =
-      options_.incremental_options.ignore_watermarks;
-  database_cache_ = DatabaseCache::Create(*database, database_cache_options);
+  database_cache_ =
+      DatabaseCache::Create(*database, CreateDatabaseCacheOptions(options_));
   timer.PrintMinutes();
 
-  if (options_.incremental_options.ba_refine_sensor_from_rig) {
+  // Decompose the relative poses once for all clusters, since the clusters
+  // overlap and would otherwise decompose the shared image pairs repeatedly.
+  if (options_.use_global_mapper &&
+      options_.global_options.decompose_relative_pose) {
+    MaybeDecomposeRelativePoses(database_cache_.get(), options_.num_threads);
+  }
+
+  const bool refine_sensor_from_rig =
+      options_.use_global_mapper
+          ? options_.global_options.mapper.refine_sensor_from_rig
+          : options_.incremental_options.ba_refine_sensor_from_rig;
+  if (refine_sensor_from_rig) {
     LOG(WARNING)
         << "The hierarchical reconstruction pipeline currently does not work "
            "robustly when refining the rig extrinsics, because overlapping "
@@ -144,6 +201,7 @@ HierarchicalPipeline::HierarchicalPipeline(
 }
 
 void HierarchicalPipeline::Run() {
+  ScopedResourceUsage resource_usage("HierarchicalPipeline");
   LOG_HEADING1("Partitioning scene");
   Timer run_timer;
   run_timer.Start();
@@ -158,8 +216,10 @@ void HierarchicalPipeline::Run() {
     image_id_to_name.emplace(image_id, image.Name());
   }
 
+  SceneClustering::Options clustering_options = options_.clustering_options;
+  clustering_options.num_threads = options_.num_threads;
   SceneClustering scene_clustering =
-      SceneClustering::Create(options_.clustering_options, *database_cache_);
+      SceneClustering::Create(clustering_options, *database_cache_);
 
   auto leaf_clusters = scene_clustering.GetLeafClusters();
 
@@ -181,7 +241,13 @@ void HierarchicalPipeline::Run() {
 
   // Determine the number of workers and threads per worker. The total thread
   // budget is divided across workers to avoid oversubscription.
-  if (options_.incremental_options.num_threads > 0) {
+  if (options_.use_global_mapper) {
+    if (options_.global_options.num_threads > 0) {
+      LOG(WARNING)
+          << "GlobalMapper.num_threads is ignored in hierarchical mapping. Use "
+             "num_threads to control the total thread budget instead.";
+    }
+  } else if (options_.incremental_options.num_threads > 0) {
     LOG(WARNING)
         << "Mapper.num_threads is ignored in hierarchical mapping. Use "
            "num_threads to control the total thread budget instead.";
@@ -197,42 +263,6 @@ void HierarchicalPipeline::Run() {
   const int num_threads_per_worker =
       std::max(1, num_total_threads / num_eff_workers);
 
-  // Function to reconstruct one cluster using incremental mapping.
-  auto ReconstructCluster =
-      [this, &image_id_to_name, num_threads_per_worker](
-          const SceneClustering::Cluster& cluster,
-          std::shared_ptr<ReconstructionManager> reconstruction_manager) {
-        if (cluster.image_ids.empty()) {
-          return;
-        }
-
-        auto incremental_options = std::make_shared<IncrementalPipelineOptions>(
-            options_.incremental_options);
-        incremental_options->image_path = options_.image_path;
-        incremental_options->max_model_overlap = 3;
-        incremental_options->init_num_trials = options_.init_num_trials;
-        incremental_options->num_threads = num_threads_per_worker;
-
-        std::unordered_set<std::string> cluster_image_names;
-        cluster_image_names.reserve(cluster.image_ids.size());
-        for (const image_t image_id : cluster.image_ids) {
-          cluster_image_names.insert(image_id_to_name.at(image_id));
-        }
-
-        // Create a filtered database cache for this cluster.
-        DatabaseCache::Options cluster_cache_options;
-        cluster_cache_options.min_num_matches =
-            static_cast<size_t>(options_.incremental_options.min_num_matches);
-        cluster_cache_options.image_names = cluster_image_names;
-        auto cluster_database_cache = DatabaseCache::CreateFromCache(
-            *database_cache_, cluster_cache_options);
-
-        IncrementalPipeline mapper(std::move(incremental_options),
-                                   std::move(cluster_database_cache),
-                                   std::move(reconstruction_manager));
-        mapper.Run();
-      };
-
   // Start reconstructing the bigger clusters first for better resource usage.
   // NOLINTNEXTLINE(bugprone-nondeterministic-pointer-iteration-order)
   std::sort(leaf_clusters.begin(),
@@ -242,21 +272,38 @@ void HierarchicalPipeline::Run() {
               return cluster1->image_ids.size() > cluster2->image_ids.size();
             });
 
-  // Start the reconstruction workers. Use a separate reconstruction manager per
-  // thread to avoid race conditions.
-  std::unordered_map<const SceneClustering::Cluster*,
-                     std::shared_ptr<ReconstructionManager>>
-      reconstruction_managers;
-  reconstruction_managers.reserve(leaf_clusters.size());
-
-  ThreadPool thread_pool(num_eff_workers);
-  for (const auto& cluster : leaf_clusters) {
-    reconstruction_managers[cluster] =
-        std::make_shared<ReconstructionManager>();
-    thread_pool.AddTask(
-        ReconstructCluster, *cluster, reconstruction_managers[cluster]);
+  std::vector<std::shared_ptr<Reconstruction>> reconstructions;
+  if (options_.job_queue_path.empty()) {
+    // Start the reconstruction workers. Use a separate reconstruction manager
+    // per thread to avoid race conditions.
+    std::vector<std::shared_ptr<ReconstructionManager>> reconstruction_managers;
+    reconstruction_managers.reserve(leaf_clusters.size());
+
+    ThreadPool thread_pool(num_eff_workers);
+    for (const auto& cluster : leaf_clusters) {
+      auto& reconstruction_manager = reconstruction_managers.emplace_back(
+          std::make_shared<ReconstructionManager>());
+      if (cluster->image_ids.empty()) {
+        continue;
+      }
+      thread_pool.AddTask(ReconstructCluster,
+                          std::cref(options_),
+                          std::cref(database_cache_),
+                          GetClusterImageNames(*cluster, image_id_to_name),
+                          num_threads_per_worker,
+                          reconstruction_manager);
+    }
+    thread_pool.Wait();
+
+    for (const auto& reconstruction_manager : reconstruction_managers) {
+      for (size_t i = 0; i < reconstruction_manager->Size(); ++i) {
+        reconstructions.push_back(reconstruction_manager->Get(i));
+      }
+    }
+  } else {
+    reconstructions =
+        ReconstructClustersWithJobQueue(leaf_clusters, image_id_to_name);
   }
-  thread_pool.Wait();
 
   //////////////////////////////////////////////////////////////////////////////
   // Merge clusters
@@ -265,13 +312,19 @@ void HierarchicalPipeline::Run() {
   if (leaf_clusters.size() > 1) {
     LOG_HEADING1("Merging clusters");
 
-    MergeClusters(*scene_clustering.GetRootCluster(), &reconstruction_managers);
+    ReconstructionMergingOptions merging_options;
+    merging_options.num_threads = options_.num_threads;
+    reconstructions =
+        MergeAndFilterReconstructions(merging_options, reconstructions);
   }
 
-  THROW_CHECK_EQ(reconstruction_managers.size(), 1);
-  THROW_CHECK_GT(
-      reconstruction_managers.begin()->second->Get(0)->NumRegImages(), 0);
-  *reconstruction_manager_ = *reconstruction_managers.begin()->second;
+  THROW_CHECK(!reconstructions.empty());
+  THROW_CHECK_GT(reconstructions[0]->NumRegImages(), 0);
+  reconstruction_manager_->Clear();
+  for (auto& reconstruction : reconstructions) {
+    reconstruction_manager_->Get(reconstruction_manager_->Add()) =
+        std::move(reconstruction);
+  }
 
   for (size_t i = 0; i < reconstruction_manager_->Size(); ++i) {
     auto reconstruction = reconstruction_manager_->Get(i);
@@ -281,4 +334,164 @@ void HierarchicalPipeline::Run() {
   run_timer.PrintMinutes();
 }
 
+std::vector<std::shared_ptr<Reconstruction>>
+HierarchicalPipeline::ReconstructClustersWithJobQueue(
+    const std::vector<const SceneClustering::Cluster*>& clusters,
+    const std::unordered_map<image_t, std::string>& image_id_to_name) {
+  FileJobQueue job_queue(options_.job_queue_path,
+                         CreateJobQueueOptions(options_));
+  THROW_CHECK(job_queue.IsEmpty())
+      << "The job queue " << options_.job_queue_path << " is not empty.";
+
+  // Write the database of each cluster and submit it, such that workers can
+  // start reconstructing the first clusters while the others are written.
+  LOG(INFO) << "Submitting clusters to " << options_.job_queue_path;
+  DatabaseCache::Options cluster_cache_options =
+      CreateDatabaseCacheOptions(options_);
+  cluster_cache_options.correspondence_graph_snapshot_path.clear();
+  ParallelFor(
+      0,
+      clusters.size(),
+      [&](const int64_t begin, const int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          if (clusters[i]->image_ids.empty()) {
+            continue;
+          }
+          DatabaseCache::Options options = cluster_cache_options;
+          options.image_names =
+              GetClusterImageNames(*clusters[i], image_id_to_name);
+          const std::string job_name = StringPrintf("cluster%06d", i);
+          const std::filesystem::path job_path = job_queue.JobPath(job_name);
+          std::filesystem::create_directories(job_path);
+          {
+            std::shared_ptr<Database> database =
+                Database::Open(job_path / kJobDatabaseName);
+            DatabaseCache::CreateFromCache(*database_cache_, options)
+                ->WriteToDatabase(database.get());
+          }
+          job_queue.Submit(job_name);
+        }
+      },
+      options_.num_threads,
+      /*grain_size=*/1);
+
+  LOG(INFO) << "Waiting for workers to reconstruct the clusters";
+  FileJobQueue::Status status;
+  FileJobQueue::Status prev_status;
+  while (true) {
+    status = job_queue.Update();
+    if (status.num_done != prev_status.num_done ||
+        status.num_abandoned != prev_status.num_abandoned) {
+      LOG(INFO) << "Clusters: " << status.num_pending << " pending, "
+                << status.num_running << " running, " << status.num_done
+                << " done, " << status.num_abandoned << " abandoned";
+    }
+    if (status.IsFinished()) {
+      break;
+    }
+    prev_status = status;
+    std::this_thread::sleep_for(kJobQueuePollInterval);
+  }
+  job_queue.Close();
+
+  if (status.num_abandoned > 0) {
+    LOG(WARNING) << "Failed to reconstruct " << status.num_abandoned
+                 << " clusters after " << options_.job_max_num_attempts
+                 << " attempts";
+  }
+
+  std::vector<std::shared_ptr<Reconstruction>> reconstructions;
+  for (const FileJobQueue::Job& job : job_queue.DoneJobs()) {
+    for (size_t i = 0;; ++i) {
+      const std::filesystem::path reconstruction_path =
+          job.output_path / std::to_string(i);
+      if (!ExistsDir(reconstruction_path)) {
+        break;
+      }
+      auto reconstruction = std::make_shared<Reconstruction>();
+      reconstruction->Read(reconstruction_path);
+      reconstructions.push_back(std::move(reconstruction));
+    }
+  }
+
+  return reconstructions;
+}
+
+HierarchicalClusterWorker::HierarchicalClusterWorker(
+    const HierarchicalPipelineOptions& options)
+    : options_(options) {
+  THROW_CHECK(options_.Check());
+  THROW_CHECK(!options_.job_queue_path.empty());
+}
+
+void HierarchicalClusterWorker::Run() {
+  FileJobQueue job_queue(options_.job_queue_path,
+                         CreateJobQueueOptions(options_));
+
+  // Send heartbeats well within the timeout to tolerate delays on the shared
+  // file system.
+  const auto heartbeat_interval =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::duration<double>(options_.job_timeout / 10));
+
+  // The clusters were already filtered and decomposed by the pipeline.
+  DatabaseCache::Options database_cache_options =
+      CreateDatabaseCacheOptions(options_);
+  database_cache_options.correspondence_graph_snapshot_path.clear();
+
+  while (!job_queue.IsClosed()) {
+    const std::optional<FileJobQueue::Job> job = job_queue.Claim();
+    if (!job.has_value()) {
+      std::this_thread::sleep_for(kJobQueuePollInterval);
+      continue;
+    }
+
+    LOG_HEADING1(StringPrintf(
+        "Reconstructing %s (attempt %d)", job->name.c_str(), job->attempt));
+
+    std::mutex heartbeat_mutex;
+    std::condition_variable heartbeat_condition;
+    bool finished = false;
+    std::thread heartbeat_thread([&]() {
+      std::unique_lock<std::mutex> lock(heartbeat_mutex);
+      while (!heartbeat_condition.wait_for(
+          lock, heartbeat_interval, [&finished]() { return finished; })) {
+        if (!job_queue.Heartbeat(*job)) {
+          LOG(WARNING) << "Lost " << job->name << " to another worker";
+          break;
+        }
+      }
+    });
+
+    bool success = false;
+    try {
+      auto database_cache = DatabaseCache::Create(
+          Database::Open(job->path / kJobDatabaseName),
+          database_cache_options);
+      auto reconstruction_manager = std::make_shared<ReconstructionManager>();
+      ReconstructCluster(options_,
+                         database_cache,
+                         /*image_names=*/{},
+                         GetEffectiveNumThreads(options_.num_threads),
+                         reconstruction_manager);
+      reconstruction_manager->Write(job->output_path);
+      success = true;
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Failed to reconstruct " << job->name << ": " << e.what();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(heartbeat_mutex);
+      finished = true;
+    }
+    heartbeat_condition.notify_one();
+    heartbeat_thread.join();
+
+    if (!(success ? job_queue.Finish(*job) : job_queue.Fail(*job))) {
+      LOG(WARNING) << "Discarding " << job->name
+                   << ", which was retried in the meantime";
+    }
+  }
+}
+
 }  // namespace colmap
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include "colmap/controllers/global_pipeline.h"
 #include "colmap/controllers/incremental_pipeline.h"
 #include "colmap/scene/reconstruction_manager.h"
 #include "colmap/scene/scene_clustering.h"
@@ -36,6 +37,9 @@
 
 #include <filesystem>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace colmap {
 
@@ -57,17 +61,39 @@ struct HierarchicalPipelineOptions {
   // Options for clustering the scene graph.
   SceneClustering::Options clustering_options;
 
+  // Whether to reconstruct each cluster using global instead of incremental
+  // mapping. The cluster reconstructions are merged in the same way.
+  bool use_global_mapper = false;
+
   // Options used to reconstruction each cluster individually.
   IncrementalPipelineOptions incremental_options;
 
+  // Options used to reconstruct each cluster if use_global_mapper is enabled.
+  GlobalPipelineOptions global_options;
+
+  // Optional directory on a shared file system, through which the clusters
+  // are reconstructed by `HierarchicalClusterWorker` processes on any number
+  // of machines instead of locally. Each cluster is submitted as a job with a
+  // database of only its own images, cameras, and matches. The directory must
+  // not contain any jobs yet.
+  std::filesystem::path job_queue_path;
+
+  // The maximum number of attempts to reconstruct a cluster in the job queue,
+  // before the cluster is left out of the merged reconstruction.
+  int job_max_num_attempts = 3;
+
+  // The time in seconds after which a cluster in the job queue is retried, if
+  // its worker stopped sending heartbeats, e.g., because it crashed.
+  double job_timeout = 300;
+
   bool Check() const;
 };
 
 // Hierarchical mapping first hierarchically partitions the scene into multiple
-// overlapping clusters, then reconstructs them separately using incremental
-// mapping, and finally merges them all into a globally consistent
+// overlapping clusters, then reconstructs them separately using incremental or
+// global mapping, and finally merges them all into a globally consistent
 // reconstruction. This is especially useful for larger-scale scenes, since
-// incremental mapping becomes slow with an increasing number of images.
+// mapping becomes slow with an increasing number of images.
 class HierarchicalPipeline : public BaseController {
  public:
   HierarchicalPipeline(
@@ -78,9 +104,30 @@ class HierarchicalPipeline : public BaseController {
   void Run() override;
 
  private:
+  // Reconstruct the clusters through the job queue and return the
+  // reconstructions of all successfully reconstructed clusters.
+  std::vector<std::shared_ptr<Reconstruction>> ReconstructClustersWithJobQueue(
+      const std::vector<const SceneClustering::Cluster*>& clusters,
+      const std::unordered_map<image_t, std::string>& image_id_to_name);
+
   const HierarchicalPipelineOptions options_;
   std::shared_ptr<DatabaseCache> database_cache_;
   std::shared_ptr<ReconstructionManager> reconstruction_manager_;
 };
 
+// Worker for the distributed hierarchical pipeline, which reconstructs the
+// clusters in the job queue at `job_queue_path` until the pipeline has
+// collected all clusters. The clusters are reconstructed with the same
+// options as in the pipeline and any number of workers can run concurrently.
+class HierarchicalClusterWorker : public BaseController {
+ public:
+  explicit HierarchicalClusterWorker(
+      const HierarchicalPipelineOptions& options);
+
+  void Run() override;
+
+ private:
+  const HierarchicalPipelineOptions options_;
+};
+
 }  // namespace colmap
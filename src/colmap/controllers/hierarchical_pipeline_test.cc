@@ -30,10 +30,13 @@
 #include "colmap/controllers/hierarchical_pipeline.h"
 
 #include "colmap/estimators/alignment.h"
+#include "colmap/estimators/view_graph_calibration.h"
 #include "colmap/scene/database.h"
 #include "colmap/scene/synthetic.h"
 #include "colmap/util/testing.h"
 
+#include <thread>
+
 #include <gtest/gtest.h>
 
 namespace colmap {
@@ -104,6 +107,80 @@ TEST(HierarchicalPipeline, WithoutNoise) {
                    reconstruction->ComputeMeanReprojectionError());
 }
 
+TEST(HierarchicalPipeline, WithoutNoiseGlobalMapper) {
+  SetPRNGSeed(1);
+
+  const auto database_path = CreateTestDir() / "database.db";
+
+  auto database = Database::Open(database_path);
+  Reconstruction gt_reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 20;
+  synthetic_dataset_options.num_points3D = 100;
+  SynthesizeDataset(
+      synthetic_dataset_options, &gt_reconstruction, database.get());
+  CalibrateViewGraph(ViewGraphCalibrationOptions(), database.get());
+
+  auto reconstruction_manager = std::make_shared<ReconstructionManager>();
+  HierarchicalPipelineOptions mapper_options;
+  mapper_options.use_global_mapper = true;
+  mapper_options.clustering_options.leaf_max_num_images = 10;
+  mapper_options.clustering_options.image_overlap = 5;
+  HierarchicalPipeline mapper(mapper_options, database, reconstruction_manager);
+  mapper.Run();
+
+  ASSERT_EQ(reconstruction_manager->Size(), 1);
+  ExpectEqualReconstructions(gt_reconstruction,
+                             *reconstruction_manager->Get(0),
+                             /*max_rotation_error_deg=*/1e-2,
+                             /*max_proj_center_error=*/1e-3,
+                             /*num_obs_tolerance=*/0.1);
+}
+
+TEST(HierarchicalPipeline, WithoutNoiseJobQueue) {
+  SetPRNGSeed(1);
+
+  const auto test_dir = CreateTestDir();
+
+  auto database = Database::Open(test_dir / "database.db");
+  Reconstruction gt_reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 20;
+  synthetic_dataset_options.num_points3D = 100;
+  SynthesizeDataset(
+      synthetic_dataset_options, &gt_reconstruction, database.get());
+
+  auto reconstruction_manager = std::make_shared<ReconstructionManager>();
+  HierarchicalPipelineOptions mapper_options;
+  mapper_options.clustering_options.leaf_max_num_images = 5;
+  mapper_options.clustering_options.image_overlap = 3;
+  mapper_options.job_queue_path = test_dir / "jobs";
+  HierarchicalPipeline mapper(mapper_options, database, reconstruction_manager);
+
+  std::vector<std::thread> worker_threads;
+  for (int i = 0; i < 2; ++i) {
+    worker_threads.emplace_back([&mapper_options]() {
+      HierarchicalClusterWorker worker(mapper_options);
+      worker.Run();
+    });
+  }
+  mapper.Run();
+  for (auto& worker_thread : worker_threads) {
+    worker_thread.join();
+  }
+
+  ASSERT_EQ(reconstruction_manager->Size(), 1);
+  ExpectEqualReconstructions(gt_reconstruction,
+                             *reconstruction_manager->Get(0),
+                             /*max_rotation_error_deg=*/1e-2,
+                             /*max_proj_center_error=*/1e-4,
+                             /*num_obs_tolerance=*/0);
+}
+
 TEST(HierarchicalPipeline, WithoutNoiseAndNonTrivialFrames) {
   SetPRNGSeed(1);
 
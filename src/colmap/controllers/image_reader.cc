@@ -32,11 +32,54 @@
 #include "colmap/sensor/models.h"
 #include "colmap/util/file.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/string.h"
+#include "colmap/util/threading.h"
 
 namespace colmap {
+namespace {
+
+bool IsJpegFile(const std::filesystem::path& path) {
+  std::string extension = path.extension().string();
+  StringToLower(&extension);
+  return extension == ".jpg" || extension == ".jpeg";
+}
+
+// Computes the fingerprint of the image file. The content of the file is only
+// hashed if its size or modification time differ from the given previous
+// fingerprint of the same file.
+std::optional<FeatureExtractionFingerprint> ComputeFeatureExtractionFingerprint(
+    const std::filesystem::path& path,
+    uint64_t options_hash,
+    const FeatureExtractionFingerprint* prev_fingerprint = nullptr) {
+  std::error_code error_code;
+  FeatureExtractionFingerprint fingerprint;
+  fingerprint.options_hash = options_hash;
+  fingerprint.file_size = std::filesystem::file_size(path, error_code);
+  if (error_code) {
+    return std::nullopt;
+  }
+  fingerprint.file_mtime = std::filesystem::last_write_time(path, error_code)
+                               .time_since_epoch()
+                               .count();
+  if (error_code) {
+    return std::nullopt;
+  }
+  if (prev_fingerprint != nullptr &&
+      prev_fingerprint->file_size == fingerprint.file_size &&
+      prev_fingerprint->file_mtime == fingerprint.file_mtime) {
+    fingerprint.file_hash = prev_fingerprint->file_hash;
+  } else {
+    fingerprint.file_hash = ComputeFileFNV1aHash(path);
+  }
+  return fingerprint;
+}
+
+}  // namespace
 
 bool ImageReaderOptions::Check() const {
   CHECK_OPTION_GT(default_focal_length_factor, 0.0);
+  CHECK_OPTION_GE(video_min_frame_difference, 0.0);
+  CHECK_OPTION_GE(video_min_relative_sharpness, 0.0);
   CHECK_OPTION(ExistsCameraModelWithName(camera_model));
   const CameraModelId model_id = CameraModelNameToId(camera_model);
   if (!camera_params.empty()) {
@@ -66,6 +109,33 @@ ImageReader::ImageReader(const ImageReaderOptions& options, Database* database)
     }
   }
 
+  if (options_.read_video_frames) {
+    std::vector<std::string> image_names;
+    image_names.reserve(options_.image_names.size());
+    for (std::string& image_name : options_.image_names) {
+      if (!IsVideoFile(image_name)) {
+        image_names.push_back(std::move(image_name));
+        continue;
+      }
+      if (!video_reader_.Open(options_.image_path / image_name)) {
+        LOG(ERROR) << "Failed to open video " << image_name;
+        continue;
+      }
+      const int num_frames = video_reader_.NumFrames();
+      VLOG(2) << "Reading " << num_frames << " frames from video "
+              << image_name;
+      for (int frame_idx = 0; frame_idx < num_frames; ++frame_idx) {
+        std::string frame_name =
+            StringPrintf("%s/frame_%06d.png", image_name.c_str(), frame_idx);
+        video_frames_.emplace(frame_name, VideoFrame{image_name, frame_idx});
+        image_names.push_back(std::move(frame_name));
+      }
+    }
+    video_reader_.Close();
+    std::sort(image_names.begin(), image_names.end());
+    options_.image_names = std::move(image_names);
+  }
+
   if (static_cast<camera_t>(options_.existing_camera_id) != kInvalidCameraId) {
     THROW_CHECK(database->ExistsCamera(options_.existing_camera_id));
     prev_camera_ = database->ReadCamera(options_.existing_camera_id);
@@ -91,12 +161,15 @@ ImageReader::ImageReader(const ImageReaderOptions& options, Database* database)
   }
 }
 
-ImageReader::Status ImageReader::Next(Rig* rig,
-                                      Camera* camera,
-                                      Image* image,
-                                      PosePrior* pose_prior,
-                                      Bitmap* bitmap,
-                                      Bitmap* mask) {
+ImageReader::Status ImageReader::Next(
+    Rig* rig,
+    Camera* camera,
+    Image* image,
+    PosePrior* pose_prior,
+    Bitmap* bitmap,
+    Bitmap* mask,
+    FeatureExtractionFingerprint* fingerprint,
+    timestamp_t* timestamp) {
   THROW_CHECK_NOTNULL(camera);
   THROW_CHECK_NOTNULL(image);
   THROW_CHECK_NOTNULL(bitmap);
@@ -105,7 +178,32 @@ ImageReader::Status ImageReader::Next(Rig* rig,
   THROW_CHECK_LE(image_index_, options_.image_names.size());
 
   const std::string image_name = options_.image_names.at(image_index_ - 1);
-  const std::filesystem::path image_path = options_.image_path / image_name;
+  std::filesystem::path image_path = options_.image_path / image_name;
+
+  // Video frames are read from and fingerprinted by their video file.
+  const VideoFrame* video_frame = nullptr;
+  if (const auto it = video_frames_.find(image_name);
+      it != video_frames_.end()) {
+    video_frame = &it->second;
+    image_path = options_.image_path / video_frame->video_name;
+    if (video_frame->video_name != video_name_) {
+      video_reader_.Close();
+      video_name_ = video_frame->video_name;
+      prev_video_frame_signature_.resize(0, 0);
+      video_mean_sharpness_ = 0;
+      video_fingerprint_.reset();
+    }
+  }
+
+  if (timestamp != nullptr) {
+    *timestamp = kInvalidTimestamp;
+  }
+
+  std::optional<ImageMetaData> meta_data;
+  if (image_index_ <= prescanned_meta_data_.size()) {
+    meta_data = std::move(prescanned_meta_data_[image_index_ - 1]);
+    prescanned_meta_data_[image_index_ - 1].reset();
+  }
 
   DatabaseTransaction database_transaction(database_);
 
@@ -122,6 +220,7 @@ ImageReader::Status ImageReader::Next(Rig* rig,
 
   const bool exists_image = database_->ExistsImageWithName(image->Name());
 
+  std::optional<FeatureExtractionFingerprint> curr_fingerprint;
   if (exists_image) {
     *image = database_->ReadImageWithName(image->Name()).value();
     const bool exists_keypoints = database_->ExistsKeypoints(image->ImageId());
@@ -129,7 +228,35 @@ ImageReader::Status ImageReader::Next(Rig* rig,
         database_->ExistsDescriptors(image->ImageId());
 
     if (exists_keypoints && exists_descriptors) {
-      return Status::IMAGE_EXISTS;
+      if (options_.feature_options_hash == 0) {
+        return Status::IMAGE_EXISTS;
+      }
+      const std::optional<FeatureExtractionFingerprint> prev_fingerprint =
+          database_->ReadFeatureExtractionFingerprint(image->ImageId());
+      if (!prev_fingerprint.has_value()) {
+        return Status::IMAGE_EXISTS;
+      }
+      if (video_frame != nullptr && video_fingerprint_.has_value()) {
+        curr_fingerprint = video_fingerprint_;
+      } else {
+        curr_fingerprint = ComputeFeatureExtractionFingerprint(
+            image_path, options_.feature_options_hash, &*prev_fingerprint);
+        if (video_frame != nullptr) {
+          video_fingerprint_ = curr_fingerprint;
+        }
+      }
+      if (!curr_fingerprint.has_value()) {
+        return Status::BITMAP_ERROR;
+      }
+      if (curr_fingerprint->file_hash == prev_fingerprint->file_hash &&
+          curr_fingerprint->options_hash == prev_fingerprint->options_hash) {
+        // Only record the new modification time of a touched file.
+        if (*curr_fingerprint != *prev_fingerprint) {
+          database_->WriteFeatureExtractionFingerprint(image->ImageId(),
+                                                       *curr_fingerprint);
+        }
+        return Status::IMAGE_EXISTS;
+      }
     }
   }
 
@@ -137,10 +264,33 @@ ImageReader::Status ImageReader::Next(Rig* rig,
   // Read image.
   //////////////////////////////////////////////////////////////////////////////
 
-  if (!bitmap->Read(image_path, /*as_rgb=*/options_.as_rgb)) {
+  if (video_frame != nullptr) {
+    const Status status = ReadVideoFrame(*video_frame, bitmap);
+    if (status != Status::SUCCESS) {
+      return status;
+    }
+    if (timestamp != nullptr) {
+      *timestamp = video_reader_.FrameTimestamp(video_frame->frame_idx);
+    }
+  } else if (options_.defer_jpeg_decoding && IsJpegFile(image_path)) {
+    // The metadata of prescanned images is already known, so that the file
+    // need not be accessed at all.
+    if (meta_data.has_value()) {
+      *bitmap = Bitmap();
+    } else if (!bitmap->ReadMetaData(image_path,
+                                     /*as_rgb=*/options_.as_rgb)) {
+      return Status::BITMAP_ERROR;
+    }
+  } else if (!bitmap->Read(image_path, /*as_rgb=*/options_.as_rgb)) {
     return Status::BITMAP_ERROR;
   }
 
+  if (!meta_data.has_value()) {
+    meta_data = ExtractMetaData(*bitmap);
+  }
+  const size_t width = static_cast<size_t>(meta_data->width);
+  const size_t height = static_cast<size_t>(meta_data->height);
+
   //////////////////////////////////////////////////////////////////////////////
   // Read mask.
   //////////////////////////////////////////////////////////////////////////////
@@ -184,8 +334,7 @@ ImageReader::Status ImageReader::Next(Rig* rig,
       return Status::CAMERA_SINGLE_DIM_ERROR;
     }
 
-    if (static_cast<size_t>(bitmap->Width()) != current_camera.width ||
-        static_cast<size_t>(bitmap->Height()) != current_camera.height) {
+    if (width != current_camera.width || height != current_camera.height) {
       return Status::CAMERA_EXIST_DIM_ERROR;
     }
 
@@ -210,8 +359,7 @@ ImageReader::Status ImageReader::Next(Rig* rig,
         ((options_.single_camera && !options_.single_camera_per_folder) ||
          (options_.single_camera_per_folder &&
           image_folder == prev_image_folder_)) &&
-        (prev_camera_.width != static_cast<size_t>(bitmap->Width()) ||
-         prev_camera_.height != static_cast<size_t>(bitmap->Height()))) {
+        (prev_camera_.width != width || prev_camera_.height != height)) {
       return Status::CAMERA_SINGLE_DIM_ERROR;
     }
 
@@ -219,13 +367,12 @@ ImageReader::Status ImageReader::Next(Rig* rig,
     // Read camera model and check for consistency if it exists
     //////////////////////////////////////////////////////////////////////////////
 
-    const std::optional<std::string> camera_model = bitmap->ExifCameraModel();
+    const std::optional<std::string>& camera_model = meta_data->camera_model;
     if (camera_model.has_value() &&
         camera_model_to_id_.count(*camera_model) > 0) {
       Camera camera =
           database_->ReadCamera(camera_model_to_id_.at(*camera_model));
-      if (camera.width != static_cast<size_t>(bitmap->Width()) ||
-          camera.height != static_cast<size_t>(bitmap->Height())) {
+      if (camera.width != width || camera.height != height) {
         return Status::CAMERA_EXIST_DIM_ERROR;
       }
       prev_camera_ = std::move(camera);
@@ -245,33 +392,37 @@ ImageReader::Status ImageReader::Next(Rig* rig,
     // Extract camera model and focal length
     //////////////////////////////////////////////////////////////////////////////
 
-    if (prev_camera_.camera_id == kInvalidCameraId ||
-        options_.single_camera_per_image ||
-        (!options_.single_camera && !options_.single_camera_per_folder &&
-         static_cast<camera_t>(options_.existing_camera_id) ==
-             kInvalidCameraId &&
-         (!camera_model.has_value() ||
-          camera_model_to_id_.count(camera_model.value()) == 0)) ||
-        (options_.single_camera_per_folder &&
-         image_folders_.count(image_folder) == 0)) {
+    // All frames of a video share the camera of its first frame.
+    const bool continues_video = video_frame != nullptr &&
+                                 prev_camera_.camera_id != kInvalidCameraId &&
+                                 image_folder == prev_image_folder_;
+    if (!continues_video &&
+        (prev_camera_.camera_id == kInvalidCameraId ||
+         options_.single_camera_per_image ||
+         (!options_.single_camera && !options_.single_camera_per_folder &&
+          static_cast<camera_t>(options_.existing_camera_id) ==
+              kInvalidCameraId &&
+          (!camera_model.has_value() ||
+           camera_model_to_id_.count(camera_model.value()) == 0)) ||
+         (options_.single_camera_per_folder &&
+          image_folders_.count(image_folder) == 0))) {
       if (options_.camera_params.empty()) {
         // Extract focal length.
-        const std::optional<double> maybe_focal_length =
-            bitmap->ExifFocalLength();
+        const std::optional<double>& maybe_focal_length =
+            meta_data->focal_length;
         const double focal_length = maybe_focal_length.value_or(
-            options_.default_focal_length_factor *
-            std::max(bitmap->Width(), bitmap->Height()));
+            options_.default_focal_length_factor * std::max(width, height));
 
         prev_camera_ = Camera::CreateFromModelId(prev_camera_.camera_id,
                                                  prev_camera_.model_id,
                                                  focal_length,
-                                                 bitmap->Width(),
-                                                 bitmap->Height());
+                                                 width,
+                                                 height);
         prev_camera_.has_prior_focal_length = maybe_focal_length.has_value();
       }
 
-      prev_camera_.width = static_cast<size_t>(bitmap->Width());
-      prev_camera_.height = static_cast<size_t>(bitmap->Height());
+      prev_camera_.width = width;
+      prev_camera_.height = height;
 
       if (!prev_camera_.VerifyParams()) {
         return Status::CAMERA_PARAM_ERROR;
@@ -299,9 +450,9 @@ ImageReader::Status ImageReader::Next(Rig* rig,
     // Extract GPS data.
     //////////////////////////////////////////////////////////////////////////////
 
-    const std::optional<double> latitude = bitmap->ExifLatitude();
-    const std::optional<double> longitude = bitmap->ExifLongitude();
-    const std::optional<double> altitude = bitmap->ExifAltitude();
+    const std::optional<double>& latitude = meta_data->latitude;
+    const std::optional<double>& longitude = meta_data->longitude;
+    const std::optional<double>& altitude = meta_data->altitude;
     if (latitude.has_value() && longitude.has_value() && altitude.has_value()) {
       pose_prior->position = Eigen::Vector3d(*latitude, *longitude, *altitude);
       pose_prior->coordinate_system = PosePrior::CoordinateSystem::WGS84;
@@ -311,7 +462,7 @@ ImageReader::Status ImageReader::Next(Rig* rig,
     // Extract Gravity from Orientation.
     //////////////////////////////////////////////////////////////////////////////
 
-    const std::optional<int> orientation = bitmap->ExifOrientation();
+    const std::optional<int>& orientation = meta_data->orientation;
     if (orientation.has_value()) {
       const auto gravity = GravityFromExifOrientation(orientation.value());
       if (gravity.has_value()) {
@@ -320,6 +471,26 @@ ImageReader::Status ImageReader::Next(Rig* rig,
     }
   }
 
+  if (fingerprint != nullptr && options_.feature_options_hash != 0) {
+    if (!curr_fingerprint.has_value()) {
+      if (meta_data->fingerprint.has_value()) {
+        curr_fingerprint = meta_data->fingerprint;
+      } else if (video_frame != nullptr && video_fingerprint_.has_value()) {
+        curr_fingerprint = video_fingerprint_;
+      } else {
+        curr_fingerprint = ComputeFeatureExtractionFingerprint(
+            image_path, options_.feature_options_hash);
+        if (video_frame != nullptr) {
+          video_fingerprint_ = curr_fingerprint;
+        }
+      }
+      if (!curr_fingerprint.has_value()) {
+        return Status::BITMAP_ERROR;
+      }
+    }
+    *fingerprint = *curr_fingerprint;
+  }
+
   *camera = prev_camera_;
   *rig = prev_rig_;
 
@@ -329,6 +500,108 @@ ImageReader::Status ImageReader::Next(Rig* rig,
   return Status::SUCCESS;
 }
 
+ImageReader::Status ImageReader::ReadVideoFrame(const VideoFrame& video_frame,
+                                                Bitmap* bitmap) {
+  if (!video_reader_.IsOpen() &&
+      !video_reader_.Open(options_.image_path / video_frame.video_name)) {
+    return Status::BITMAP_ERROR;
+  }
+
+  if (!video_reader_.ReadFrame(
+          video_frame.frame_idx, /*as_rgb=*/options_.as_rgb, bitmap)) {
+    return Status::BITMAP_ERROR;
+  }
+
+  const Eigen::MatrixXf signature = ComputeVideoFrameSignature(*bitmap);
+
+  if (options_.video_min_relative_sharpness > 0) {
+    // Exponential moving average of the sharpness of the preceding frames.
+    constexpr double kSharpnessSmoothing = 0.1;
+    const double sharpness = ComputeVideoFrameSharpness(signature);
+    const bool is_blurry =
+        video_mean_sharpness_ > 0 &&
+        sharpness < options_.video_min_relative_sharpness *
+                        video_mean_sharpness_;
+    video_mean_sharpness_ =
+        video_mean_sharpness_ > 0
+            ? (1 - kSharpnessSmoothing) * video_mean_sharpness_ +
+                  kSharpnessSmoothing * sharpness
+            : sharpness;
+    if (is_blurry) {
+      *bitmap = Bitmap();
+      return Status::VIDEO_FRAME_SKIPPED;
+    }
+  }
+
+  if (ComputeVideoFrameDifference(signature, prev_video_frame_signature_) <
+      options_.video_min_frame_difference) {
+    *bitmap = Bitmap();
+    return Status::VIDEO_FRAME_SKIPPED;
+  }
+
+  prev_video_frame_signature_ = signature;
+
+  return Status::SUCCESS;
+}
+
+ImageReader::ImageMetaData ImageReader::ExtractMetaData(const Bitmap& bitmap) {
+  ImageMetaData meta_data;
+  meta_data.width = bitmap.Width();
+  meta_data.height = bitmap.Height();
+  meta_data.camera_model = bitmap.ExifCameraModel();
+  meta_data.focal_length = bitmap.ExifFocalLength();
+  meta_data.latitude = bitmap.ExifLatitude();
+  meta_data.longitude = bitmap.ExifLongitude();
+  meta_data.altitude = bitmap.ExifAltitude();
+  meta_data.orientation = bitmap.ExifOrientation();
+  return meta_data;
+}
+
+void ImageReader::PrescanMetaData(const int num_threads) {
+  // Existing images are mostly skipped by Next, and video frames are decoded
+  // from their video file.
+  std::vector<size_t> image_idxs;
+  for (size_t image_idx = image_index_;
+       image_idx < options_.image_names.size();
+       ++image_idx) {
+    const std::string& image_name = options_.image_names[image_idx];
+    if (video_frames_.count(image_name) == 0 &&
+        !database_->ExistsImageWithName(image_name)) {
+      image_idxs.push_back(image_idx);
+    }
+  }
+
+  LOG(INFO) << "Prescanning metadata of " << image_idxs.size() << " images";
+
+  prescanned_meta_data_.clear();
+  prescanned_meta_data_.resize(options_.image_names.size());
+  ParallelFor(
+      0,
+      image_idxs.size(),
+      [&](const int64_t begin, const int64_t end) {
+        Bitmap bitmap;
+        for (int64_t i = begin; i < end; ++i) {
+          const size_t image_idx = image_idxs[i];
+          const std::filesystem::path image_path =
+              options_.image_path / options_.image_names[image_idx];
+          // Unreadable images are reported by Next.
+          if (!bitmap.ReadMetaData(image_path, /*as_rgb=*/options_.as_rgb)) {
+            continue;
+          }
+          ImageMetaData meta_data = ExtractMetaData(bitmap);
+          if (options_.feature_options_hash != 0) {
+            meta_data.fingerprint = ComputeFeatureExtractionFingerprint(
+                image_path, options_.feature_options_hash);
+            if (!meta_data.fingerprint.has_value()) {
+              continue;
+            }
+          }
+          prescanned_meta_data_[image_idx] = std::move(meta_data);
+        }
+      },
+      num_threads);
+}
+
 size_t ImageReader::NextIndex() const { return image_index_; }
 
 size_t ImageReader::NumImages() const { return options_.image_names.size(); }
@@ -353,6 +626,9 @@ std::string ImageReader::StatusToString(const ImageReader::Status status) {
              "image has different dimensions.";
     case ImageReader::Status::CAMERA_PARAM_ERROR:
       return "CAMERA_PARAM_ERROR: Camera has invalid parameters.";
+    case ImageReader::Status::VIDEO_FRAME_SKIPPED:
+      return "VIDEO_FRAME_SKIPPED: Video frame is a near-duplicate of the "
+             "previous frame or blurry.";
     default:
       return "Unknown";
   }
@@ -31,8 +31,11 @@
 
 #include "colmap/scene/database.h"
 #include "colmap/sensor/bitmap.h"
+#include "colmap/sensor/video.h"
 
 #include <filesystem>
+#include <optional>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -86,12 +89,42 @@ struct ImageReaderOptions {
   // Whether to read images as grayscale or RGB.
   bool as_rgb = false;
 
+  // Whether to only read the dimensions and metadata of JPEG images and leave
+  // the pixel data of their bitmaps empty. The images must then be decoded by
+  // a later stage, e.g., on the GPU.
+  bool defer_jpeg_decoding = false;
+
+  // Whether to read the frames of video files (e.g., .mp4, .mov) in the image
+  // path directly, without first exporting them as images. The frame with
+  // index 12 of a video abc/012.mp4 is named abc/012.mp4/frame_000012.png,
+  // e.g., for its mask. All frames of a video share the same camera. Requires
+  // OpenImageIO with FFmpeg support.
+  bool read_video_frames = false;
+
+  // Skip video frames whose mean absolute intensity difference in [0, 255] to
+  // the previously read frame of the video is below this threshold, e.g., if
+  // the camera does not move. The difference is computed on a downsampled
+  // grayscale version of the frames.
+  double video_min_frame_difference = 2.0;
+
+  // Skip blurry video frames whose sharpness is below this fraction of the
+  // average sharpness of the preceding frames of the video. Disabled if 0.
+  double video_min_relative_sharpness = 0.0;
+
+  // Hash of the options that determine the extracted features. If non-zero,
+  // the existing features of an image are only kept if their fingerprint in
+  // the database matches the current image file and options. The content of a
+  // file is only hashed if its size or modification time changed. Images with
+  // changed file or options are read again, so that their features can be
+  // replaced. Existing features without fingerprint are always kept.
+  uint64_t feature_options_hash = 0;
+
   bool Check() const;
 };
 
 // Recursively iterate over the images in a directory. Skips an image if it
-// already exists in the database. Extracts the camera intrinsics from EXIF and
-// writes the camera information to the database.
+// already exists in the database with up-to-date features. Extracts the camera
+// intrinsics from EXIF and writes the camera information to the database.
 class ImageReader {
  public:
   enum class Status {
@@ -102,28 +135,67 @@ class ImageReader {
     MASK_ERROR,
     CAMERA_SINGLE_DIM_ERROR,
     CAMERA_EXIST_DIM_ERROR,
-    CAMERA_PARAM_ERROR
+    CAMERA_PARAM_ERROR,
+    VIDEO_FRAME_SKIPPED
   };
 
   ImageReader(const ImageReaderOptions& options, Database* database);
 
+  // If feature_options_hash is set, the optional fingerprint is set to the
+  // fingerprint of the read image, which should be written to the database
+  // together with its extracted features. The optional timestamp is set to
+  // the timestamp of video frames and to kInvalidTimestamp for images.
   Status Next(Rig* rig,
               Camera* camera,
               Image* image,
               PosePrior* pose_prior,
               Bitmap* bitmap,
-              Bitmap* mask);
+              Bitmap* mask,
+              FeatureExtractionFingerprint* fingerprint = nullptr,
+              timestamp_t* timestamp = nullptr);
   size_t NextIndex() const;
   size_t NumImages() const;
 
+  // Read the dimensions, EXIF metadata, and fingerprints of all remaining
+  // images that are not yet in the database in parallel, so that Next does not
+  // read them one by one. Next then only decodes the pixels of the images and
+  // skips reading JPEG images entirely if their decoding is deferred.
+  void PrescanMetaData(int num_threads = -1);
+
   static std::string StatusToString(Status status);
 
  private:
+  struct VideoFrame {
+    std::string video_name;
+    int frame_idx = -1;
+  };
+
+  struct ImageMetaData {
+    int width = 0;
+    int height = 0;
+    std::optional<std::string> camera_model;
+    std::optional<double> focal_length;
+    std::optional<double> latitude;
+    std::optional<double> longitude;
+    std::optional<double> altitude;
+    std::optional<int> orientation;
+    // Only set for prescanned images.
+    std::optional<FeatureExtractionFingerprint> fingerprint;
+  };
+
+  static ImageMetaData ExtractMetaData(const Bitmap& bitmap);
+
+  // Decodes the video frame and checks whether it is a near-duplicate of the
+  // previously read frame or blurry.
+  Status ReadVideoFrame(const VideoFrame& video_frame, Bitmap* bitmap);
+
   // Image reader options.
   ImageReaderOptions options_;
   Database* database_;
   // Index of previously processed image.
   size_t image_index_;
+  // Prescanned metadata by image index, see PrescanMetaData.
+  std::vector<std::optional<ImageMetaData>> prescanned_meta_data_;
   // Previously processed rig/camera.
   Rig prev_rig_;
   Camera prev_camera_;
@@ -131,6 +203,17 @@ class ImageReader {
   // Names of image sub-folders.
   std::string prev_image_folder_;
   std::unordered_set<std::string> image_folders_;
+
+  // Video frames by their image name.
+  std::unordered_map<std::string, VideoFrame> video_frames_;
+  // Currently opened video and the signature and average sharpness of its
+  // previously read frames for skipping near-duplicate and blurry frames.
+  VideoReader video_reader_;
+  std::string video_name_;
+  Eigen::MatrixXf prev_video_frame_signature_;
+  double video_mean_sharpness_ = 0;
+  // Fingerprint of the current video file, shared by all its frames.
+  std::optional<FeatureExtractionFingerprint> video_fingerprint_;
 };
 
 }  // namespace colmap
@@ -34,6 +34,8 @@
 #include "colmap/util/file.h"
 #include "colmap/util/testing.h"
 
+#include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <tuple>
 
@@ -215,6 +217,104 @@ TEST(ImageReaderTest, SingleCamera) {
   EXPECT_EQ(database->NumCameras(), 1);
 }
 
+TEST(ImageReaderTest, DeferJpegDecoding) {
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  const auto test_dir = CreateTestDir();
+
+  ImageReaderOptions options;
+  options.image_path = test_dir / "images";
+  options.defer_jpeg_decoding = true;
+  CreateDirIfNotExists(options.image_path);
+
+  Bitmap test_bitmap(10, 20, true);
+  test_bitmap.Write(options.image_path / "0.JPG");
+  test_bitmap.Write(options.image_path / "1.png");
+
+  ImageReader image_reader(options, database.get());
+  EXPECT_EQ(image_reader.NumImages(), 2);
+
+  Rig rig;
+  Camera camera;
+  Image image;
+  PosePrior pose_prior;
+  Bitmap bitmap;
+  Bitmap mask;
+
+  ASSERT_EQ(
+      image_reader.Next(&rig, &camera, &image, &pose_prior, &bitmap, &mask),
+      ImageReader::Status::SUCCESS);
+  EXPECT_EQ(image.Name(), "0.JPG");
+  EXPECT_EQ(camera.width, 10);
+  EXPECT_EQ(camera.height, 20);
+  EXPECT_EQ(bitmap.Width(), 10);
+  EXPECT_EQ(bitmap.Height(), 20);
+  EXPECT_TRUE(bitmap.IsEmpty());
+
+  ASSERT_EQ(
+      image_reader.Next(&rig, &camera, &image, &pose_prior, &bitmap, &mask),
+      ImageReader::Status::SUCCESS);
+  EXPECT_EQ(image.Name(), "1.png");
+  EXPECT_FALSE(bitmap.IsEmpty());
+}
+
+TEST(ImageReaderTest, PrescanMetaData) {
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  const auto test_dir = CreateTestDir();
+
+  ImageReaderOptions options;
+  options.image_path = test_dir / "images";
+  options.defer_jpeg_decoding = true;
+  options.feature_options_hash = 42;
+  CreateDirIfNotExists(options.image_path);
+
+  Bitmap test_bitmap(10, 20, true);
+  test_bitmap.Write(options.image_path / "0.jpg");
+  test_bitmap.Write(options.image_path / "1.png");
+  test_bitmap.Write(options.image_path / "2.jpg");
+  // Not a valid image, which is reported as an error by Next.
+  std::ofstream file(options.image_path / "3.jpg");
+  file << "not an image";
+  file.close();
+
+  ImageReader image_reader(options, database.get());
+  EXPECT_EQ(image_reader.NumImages(), 4);
+  image_reader.PrescanMetaData();
+
+  // Prescanned JPEG images with deferred decoding are no longer accessed.
+  std::filesystem::remove(options.image_path / "2.jpg");
+
+  Rig rig;
+  Camera camera;
+  Image image;
+  PosePrior pose_prior;
+  Bitmap bitmap;
+  Bitmap mask;
+  FeatureExtractionFingerprint fingerprint;
+  timestamp_t timestamp;
+
+  for (const std::string image_name : {"0.jpg", "1.png", "2.jpg"}) {
+    ASSERT_EQ(image_reader.Next(&rig,
+                                &camera,
+                                &image,
+                                &pose_prior,
+                                &bitmap,
+                                &mask,
+                                &fingerprint,
+                                &timestamp),
+              ImageReader::Status::SUCCESS);
+    EXPECT_EQ(image.Name(), image_name);
+    EXPECT_EQ(camera.width, 10);
+    EXPECT_EQ(camera.height, 20);
+    EXPECT_EQ(bitmap.IsEmpty(), image_name != "1.png");
+    EXPECT_EQ(fingerprint.options_hash, 42);
+    EXPECT_GT(fingerprint.file_size, 0);
+  }
+
+  EXPECT_EQ(
+      image_reader.Next(&rig, &camera, &image, &pose_prior, &bitmap, &mask),
+      ImageReader::Status::BITMAP_ERROR);
+}
+
 TEST(ImageReaderTest, SingleCameraDimensionError) {
   auto database = Database::Open(kInMemorySqliteDatabasePath);
   const auto test_dir = CreateTestDir();
@@ -576,5 +676,95 @@ TEST(ImageReaderTest, ImageExistsWithKeypoints) {
   EXPECT_EQ(status, ImageReader::Status::IMAGE_EXISTS);
 }
 
+TEST(ImageReaderTest, ImageExistsWithFeatureExtractionFingerprint) {
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  const auto test_dir = CreateTestDir();
+
+  ImageReaderOptions options;
+  options.image_path = test_dir / "images";
+  options.feature_options_hash = 1;
+  CreateDirIfNotExists(options.image_path);
+
+  const auto test_path = options.image_path / "test.png";
+  Bitmap test_bitmap(10, 20, true);
+  test_bitmap.Write(test_path);
+
+  Camera existing_camera = Camera::CreateFromModelName(
+      kInvalidCameraId, "SIMPLE_RADIAL", /*focal_length=*/1, 10, 20);
+  existing_camera.camera_id = database->WriteCamera(existing_camera);
+  Rig existing_rig;
+  existing_rig.AddRefSensor(existing_camera.SensorId());
+  database->WriteRig(existing_rig);
+
+  Image existing_image;
+  existing_image.SetName("test.png");
+  existing_image.SetCameraId(existing_camera.camera_id);
+  existing_image.SetImageId(database->WriteImage(existing_image));
+  database->WriteKeypoints(existing_image.ImageId(), FeatureKeypoints());
+  database->WriteDescriptors(existing_image.ImageId(), FeatureDescriptors());
+
+  Rig rig;
+  Camera camera;
+  Image image;
+  PosePrior pose_prior;
+  Bitmap bitmap;
+  Bitmap mask;
+  FeatureExtractionFingerprint fingerprint;
+
+  const auto read_next = [&](const ImageReaderOptions& options) {
+    fingerprint = FeatureExtractionFingerprint();
+    ImageReader image_reader(options, database.get());
+    return image_reader.Next(
+        &rig, &camera, &image, &pose_prior, &bitmap, &mask, &fingerprint);
+  };
+
+  // Existing features without fingerprint are kept.
+  EXPECT_EQ(read_next(options), ImageReader::Status::IMAGE_EXISTS);
+  EXPECT_EQ(fingerprint, FeatureExtractionFingerprint());
+
+  // Changed options require to extract the features again.
+  ImageReaderOptions changed_options = options;
+  changed_options.feature_options_hash = 2;
+  // Fingerprint of unknown file and options.
+  database->WriteFeatureExtractionFingerprint(existing_image.ImageId(),
+                                              FeatureExtractionFingerprint());
+  EXPECT_EQ(read_next(changed_options), ImageReader::Status::SUCCESS);
+  EXPECT_EQ(fingerprint.file_hash, ComputeFileFNV1aHash(test_path));
+  EXPECT_EQ(fingerprint.file_size, std::filesystem::file_size(test_path));
+  EXPECT_EQ(fingerprint.options_hash, 2);
+  EXPECT_EQ(image.ImageId(), existing_image.ImageId());
+  EXPECT_EQ(camera.camera_id, existing_camera.camera_id);
+
+  // Unchanged file and options.
+  fingerprint.options_hash = 1;
+  const FeatureExtractionFingerprint expected_fingerprint = fingerprint;
+  database->WriteFeatureExtractionFingerprint(existing_image.ImageId(),
+                                              expected_fingerprint);
+  EXPECT_EQ(read_next(options), ImageReader::Status::IMAGE_EXISTS);
+  EXPECT_EQ(fingerprint, FeatureExtractionFingerprint());
+  EXPECT_EQ(
+      database->ReadFeatureExtractionFingerprint(existing_image.ImageId()),
+      expected_fingerprint);
+
+  // Touched file with unchanged content only updates the fingerprint.
+  std::filesystem::last_write_time(
+      test_path,
+      std::filesystem::last_write_time(test_path) + std::chrono::hours(1));
+  EXPECT_EQ(read_next(options), ImageReader::Status::IMAGE_EXISTS);
+  const std::optional<FeatureExtractionFingerprint> touched_fingerprint =
+      database->ReadFeatureExtractionFingerprint(existing_image.ImageId());
+  ASSERT_TRUE(touched_fingerprint.has_value());
+  EXPECT_EQ(touched_fingerprint->file_hash, expected_fingerprint.file_hash);
+  EXPECT_NE(touched_fingerprint->file_mtime, expected_fingerprint.file_mtime);
+
+  // Changed content requires to extract the features again.
+  test_bitmap.Fill(BitmapColor<uint8_t>(255));
+  test_bitmap.Write(test_path);
+  EXPECT_EQ(read_next(options), ImageReader::Status::SUCCESS);
+  EXPECT_EQ(fingerprint.file_hash, ComputeFileFNV1aHash(test_path));
+  EXPECT_NE(fingerprint.file_hash, expected_fingerprint.file_hash);
+  EXPECT_EQ(fingerprint.options_hash, 1);
+}
+
 }  // namespace
 }  // namespace colmap
@@ -32,10 +32,20 @@
 #include "colmap/estimators/alignment.h"
 #include "colmap/estimators/bundle_adjustment_caspar.h"
 #include "colmap/estimators/bundle_adjustment_ceres.h"
+#include "colmap/math/connected_components.h"
 #include "colmap/scene/database.h"
+#include "colmap/util/endian.h"
 #include "colmap/util/file.h"
+#include "colmap/util/resource_usage.h"
+#include "colmap/util/threading.h"
 #include "colmap/util/timer.h"
 
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
 namespace colmap {
 namespace {
 
@@ -68,6 +78,9 @@ DatabaseCache::Options CreateDatabaseCacheOptions(
     }
   }
   database_cache_options.load_all_images = options.load_all_images;
+  database_cache_options.correspondence_graph_snapshot_path =
+      options.correspondence_graph_snapshot_path;
+  database_cache_options.lazy_load_points2D = options.lazy_load_points2D;
   database_cache_options.convert_pose_priors_to_enu =
       options.use_prior_position;
   return database_cache_options;
@@ -126,8 +139,100 @@ bool HasUnknownSensorFromRig(const Reconstruction& reconstruction) {
   return false;
 }
 
+// The number of local refinements after a global refinement, which define the
+// reference for the drift estimate.
+constexpr size_t kNumReferenceRefinements = 3;
+
 }  // namespace
 
+bool GlobalRefinementScheduler::Options::Check() const {
+  CHECK_OPTION_GE(min_num_frames, 0);
+  CHECK_OPTION_GT(max_frames_ratio, 1.0);
+  CHECK_OPTION_GE(max_error_increase, 0);
+  CHECK_OPTION_GE(max_filtered_ratio, 0);
+  return true;
+}
+
+GlobalRefinementScheduler::GlobalRefinementScheduler(const Options& options)
+    : options_(options) {
+  THROW_CHECK(options_.Check());
+}
+
+void GlobalRefinementScheduler::LocalRefinementDone(
+    const IncrementalMapper::LocalBundleAdjustmentReport& report) {
+  if (report.num_adjusted_observations == 0) {
+    return;
+  }
+
+  // Later local refinements are smoothed to follow the trend.
+  constexpr double kSmoothingFactor = 0.25;
+
+  num_local_refinements_ += 1;
+  const double filtered_ratio =
+      static_cast<double>(report.num_filtered_observations) /
+      report.num_adjusted_observations;
+  if (num_local_refinements_ <= kNumReferenceRefinements) {
+    ref_reproj_error_ += (report.mean_reproj_error - ref_reproj_error_) /
+                         num_local_refinements_;
+    reproj_error_ = ref_reproj_error_;
+    filtered_ratio_ +=
+        (filtered_ratio - filtered_ratio_) / num_local_refinements_;
+  } else {
+    reproj_error_ +=
+        kSmoothingFactor * (report.mean_reproj_error - reproj_error_);
+    filtered_ratio_ += kSmoothingFactor * (filtered_ratio - filtered_ratio_);
+  }
+}
+
+void GlobalRefinementScheduler::GlobalRefinementDone(
+    const Reconstruction& reconstruction, const double elapsed_seconds) {
+  num_reg_frames_at_refinement_ = reconstruction.NumRegFrames();
+  num_refinements_ += 1;
+  refinement_seconds_ += elapsed_seconds;
+  num_local_refinements_ = 0;
+  ref_reproj_error_ = 0;
+  reproj_error_ = 0;
+  filtered_ratio_ = 0;
+}
+
+bool GlobalRefinementScheduler::ShouldRunGlobalRefinement(
+    const Reconstruction& reconstruction) {
+  if (!options_.adaptive || num_refinements_ == 0 ||
+      reconstruction.NumRegFrames() <
+          static_cast<size_t>(options_.min_num_frames) ||
+      num_local_refinements_ <= kNumReferenceRefinements ||
+      reconstruction.NumRegFrames() >=
+          options_.max_frames_ratio * num_reg_frames_at_refinement_) {
+    return true;
+  }
+
+  const double error_increase =
+      ref_reproj_error_ > 0 ? reproj_error_ / ref_reproj_error_ - 1 : 0;
+  if (error_increase > options_.max_error_increase ||
+      filtered_ratio_ > options_.max_filtered_ratio) {
+    return true;
+  }
+
+  num_skipped_refinements_ += 1;
+  const double expected_seconds = refinement_seconds_ / num_refinements_;
+  time_saved_seconds_ += expected_seconds;
+  LOG(INFO) << StringPrintf(
+      "Skipping global bundle adjustment (error increase: %.2f%%, filtered "
+      "observations: %.2f%%, estimated time saved: %.3fs)",
+      100 * error_increase,
+      100 * filtered_ratio_,
+      expected_seconds);
+  return false;
+}
+
+size_t GlobalRefinementScheduler::NumSkippedRefinements() const {
+  return num_skipped_refinements_;
+}
+
+double GlobalRefinementScheduler::TimeSavedSeconds() const {
+  return time_saved_seconds_;
+}
+
 IncrementalMapper::Options IncrementalPipelineOptions::Mapper() const {
   IncrementalMapper::Options options = mapper;
   options.abs_pose_refine_focal_length = ba_refine_focal_length;
@@ -143,6 +248,9 @@ IncrementalMapper::Options IncrementalPipelineOptions::Mapper() const {
   options.use_robust_loss_on_prior_position = use_robust_loss_on_prior_position;
   options.prior_position_loss_scale = prior_position_loss_scale;
   options.random_seed = random_seed;
+  if (structure_less_registration_first) {
+    options.structure_less_triangulate = false;
+  }
   return options;
 }
 
@@ -153,6 +261,7 @@ IncrementalTriangulator::Options IncrementalPipelineOptions::Triangulation()
   options.max_focal_length_ratio = max_focal_length_ratio;
   options.max_extra_param = max_extra_param;
   options.random_seed = random_seed;
+  options.num_threads = num_threads;
   return options;
 }
 
@@ -232,12 +341,25 @@ BundleAdjustmentOptions IncrementalPipelineOptions::GlobalBundleAdjustment()
   return options;
 }
 
+GlobalRefinementScheduler::Options
+IncrementalPipelineOptions::GlobalRefinementScheduling() const {
+  GlobalRefinementScheduler::Options options;
+  options.adaptive = ba_global_adaptive;
+  options.min_num_frames = ba_global_adaptive_min_num_frames;
+  options.max_frames_ratio = ba_global_adaptive_max_frames_ratio;
+  options.max_error_increase = ba_global_adaptive_max_error_increase;
+  options.max_filtered_ratio = ba_global_adaptive_max_filtered_ratio;
+  return options;
+}
+
 bool IncrementalPipelineOptions::Check() const {
   CHECK_OPTION_GT(min_num_matches, 0);
   CHECK_OPTION_GT(max_num_models, 0);
   CHECK_OPTION_GT(max_model_overlap, 0);
   CHECK_OPTION_GE(min_model_size, 0);
   CHECK_OPTION_GT(init_num_trials, 0);
+  CHECK_OPTION_GT(structure_less_batch_size, 0);
+  CHECK_OPTION_GT(num_speculative_reg_images, 0);
   CHECK_OPTION_GT(min_focal_length_ratio, 0);
   CHECK_OPTION_GT(max_focal_length_ratio, 0);
   CHECK_OPTION_GE(max_extra_param, 0);
@@ -252,6 +374,8 @@ bool IncrementalPipelineOptions::Check() const {
   CHECK_OPTION_GE(ba_global_max_refinements, 0);
   CHECK_OPTION_GE(ba_global_max_refinement_change, 0);
   CHECK_OPTION_GE(snapshot_frames_freq, 0);
+  CHECK_OPTION_GE(checkpoint_frames_freq, 0);
+  CHECK_OPTION(!resume_from_checkpoint || !checkpoint_path.empty());
   CHECK_OPTION_GT(prior_position_loss_scale, 0.);
   CHECK_OPTION_GE(num_threads, -1);
   CHECK_OPTION_GE(random_seed, -1);
@@ -261,6 +385,7 @@ bool IncrementalPipelineOptions::Check() const {
 #endif
   CHECK_OPTION(Mapper().Check());
   CHECK_OPTION(Triangulation().Check());
+  CHECK_OPTION(GlobalRefinementScheduling().Check());
   return true;
 }
 
@@ -279,7 +404,7 @@ IncrementalPipeline::IncrementalPipeline(
   Timer timer;
   timer.Start();
   database_cache_ = DatabaseCache::Create(
-      *database,
+      std::move(database),
       CreateDatabaseCacheOptions(*options_, *reconstruction_manager_));
   timer.PrintMinutes();
 
@@ -309,6 +434,7 @@ IncrementalPipeline::IncrementalPipeline(
 }
 
 void IncrementalPipeline::Run() {
+  ScopedResourceUsage resource_usage("IncrementalPipeline");
   total_run_timer_->Start();
 
   if (database_cache_->NumImages() == 0) {
@@ -321,21 +447,38 @@ void IncrementalPipeline::Run() {
     return;
   }
 
-  // Is there a sub-reconstruction before we start the reconstruction? I.e. the
-  // user has imported an existing reconstruction.
-  const bool continue_reconstruction = reconstruction_manager_->Size() > 0;
-  THROW_CHECK_LE(reconstruction_manager_->Size(), 1)
-      << "Can only continue from a single reconstruction, "
-         "but multiple are given.";
+  if (options_->parallel_components && options_->multiple_models &&
+      !options_->IsInitialPairProvided() &&
+      !options_->resume_from_checkpoint &&
+      reconstruction_manager_->Size() == 0 && ReconstructComponents()) {
+    total_run_timer_->PrintMinutes();
+    return;
+  }
 
   const size_t num_images = database_cache_->NumImages();
 
   IncrementalMapper::Options mapper_options = options_->Mapper();
   IncrementalMapper mapper(database_cache_);
+
+  // Is there a sub-reconstruction before we start the reconstruction? I.e. the
+  // user has imported an existing reconstruction or we resume from a
+  // checkpoint with a model in progress.
+  bool continue_reconstruction = reconstruction_manager_->Size() > 0;
+  if (options_->resume_from_checkpoint) {
+    THROW_CHECK_EQ(reconstruction_manager_->Size(), 0)
+        << "Cannot resume from checkpoint with given reconstructions.";
+    continue_reconstruction = ReadCheckpoint(mapper);
+  } else {
+    THROW_CHECK_LE(reconstruction_manager_->Size(), 1)
+        << "Can only continue from a single reconstruction, "
+           "but multiple are given.";
+  }
+
   if (Reconstruct(mapper,
                   mapper_options,
                   /*continue_reconstruction=*/continue_reconstruction) ==
       Status::STOP) {
+    WaitForCheckpoint();
     total_run_timer_->PrintMinutes();
     return;
   }
@@ -374,6 +517,7 @@ void IncrementalPipeline::Run() {
     }
   }
 
+  WaitForCheckpoint();
   total_run_timer_->PrintMinutes();
 }
 
@@ -477,6 +621,12 @@ IncrementalPipeline::Status IncrementalPipeline::ReconstructSubModel(
     const std::shared_ptr<Reconstruction>& reconstruction) {
   mapper.BeginReconstruction(reconstruction);
 
+  if (!resume_mapper_state_.empty()) {
+    std::istringstream mapper_state(resume_mapper_state_);
+    mapper.ReadState(mapper_state);
+    resume_mapper_state_.clear();
+  }
+
   if (HasUnknownSensorFromRig(*reconstruction)) {
     return Status::UNKNOWN_SENSOR_FROM_RIG;
   }
@@ -499,12 +649,19 @@ IncrementalPipeline::Status IncrementalPipeline::ReconstructSubModel(
   ////////////////////////////////////////////////////////////////////////////
 
   size_t snapshot_prev_num_reg_frames = reconstruction->NumRegFrames();
+  size_t checkpoint_prev_num_reg_frames = reconstruction->NumRegFrames();
   size_t ba_prev_num_reg_frames = reconstruction->NumRegFrames();
   size_t ba_prev_num_points = reconstruction->NumPoints3D();
+  size_t global_ba_num_reg_frames = ba_prev_num_reg_frames;
+  size_t global_ba_num_points = ba_prev_num_points;
+  GlobalRefinementScheduler global_refinement_scheduler(
+      options_->GlobalRefinementScheduling());
 
   std::vector<bool> structure_less_flags;
   if (options_->structure_less_registration_only) {
     structure_less_flags = {true};
+  } else if (options_->structure_less_registration_first) {
+    structure_less_flags = {true, false};
   } else {
     if (options_->structure_less_registration_fallback) {
       structure_less_flags = {false, true};
@@ -513,6 +670,38 @@ IncrementalPipeline::Status IncrementalPipeline::ReconstructSubModel(
     }
   }
 
+  // Poses of next images that were speculatively estimated together with a
+  // successfully registered image. They are committed in later iterations,
+  // if they are still consistent with the reconstruction.
+  std::deque<IncrementalMapper::NextImagePose> speculative_poses;
+  const auto is_trivial_frame = [&reconstruction](const image_t image_id) {
+    return reconstruction->Image(image_id).FramePtr()->RigPtr()->NumSensors() ==
+           1;
+  };
+
+  // Images registered structure-less in the fast path, whose triangulation
+  // and local refinement is deferred to the next batch.
+  std::vector<image_t> deferred_image_ids;
+  const auto triangulate_deferred_images = [&]() {
+    for (const image_t image_id : deferred_image_ids) {
+      const Image& image = reconstruction->Image(image_id);
+      for (const data_t& data_id : image.FramePtr()->ImageIds()) {
+        mapper.TriangulateImage(options_->Triangulation(), data_id.id);
+      }
+    }
+  };
+  const auto extract_deferred_colors = [&]() {
+    if (!options_->extract_colors) {
+      return;
+    }
+    for (const image_t image_id : deferred_image_ids) {
+      const Image& image = reconstruction->Image(image_id);
+      for (const data_t& data_id : image.FramePtr()->ImageIds()) {
+        ExtractColors(options_->image_path, data_id.id, *reconstruction);
+      }
+    }
+  };
+
   bool reg_next_success = true;
   bool prev_reg_next_success = true;
   do {
@@ -522,12 +711,37 @@ IncrementalPipeline::Status IncrementalPipeline::ReconstructSubModel(
 
     prev_reg_next_success = reg_next_success;
     reg_next_success = false;
+    bool reg_structure_less = false;
     image_t next_image_id = kInvalidImageId;
 
+    while (!speculative_poses.empty() && !reg_next_success) {
+      const IncrementalMapper::NextImagePose pose =
+          std::move(speculative_poses.front());
+      speculative_poses.pop_front();
+      reg_next_success = mapper.RegisterNextImage(mapper_options, pose);
+      if (reg_next_success) {
+        next_image_id = pose.image_id;
+        LOG(INFO) << StringPrintf(
+            "Registered image #%d from speculative pose (num_reg_frames=%d)",
+            next_image_id,
+            reconstruction->NumRegFrames());
+      }
+    }
+
     // Try to register next image. Always prefer structure-based registration
     // first, and if that fails, try (less reliable) structure-less
     // registration.
     for (const bool structure_less : structure_less_flags) {
+      if (reg_next_success) {
+        break;
+      }
+
+      const bool speculative =
+          !structure_less && options_->num_speculative_reg_images > 1;
+      std::unordered_map<image_t, IncrementalMapper::NextImagePose>
+          batch_poses;
+      std::vector<image_t> batch_image_ids;
+
       const std::vector<image_t> next_images = mapper.FindNextImages(
           mapper_options, /*structure_less=*/structure_less);
 
@@ -552,6 +766,41 @@ IncrementalPipeline::Status IncrementalPipeline::ReconstructSubModel(
               mapper.ObservationManager().NumCorrespondences(next_image_id));
           reg_next_success = mapper.RegisterNextStructureLessImage(
               mapper_options, next_image_id);
+          reg_structure_less = reg_next_success;
+        } else if (speculative && is_trivial_frame(next_image_id)) {
+          if (batch_poses.count(next_image_id) == 0) {
+            // Estimate the poses of the next few candidates concurrently.
+            batch_poses.clear();
+            batch_image_ids.clear();
+            for (size_t i = reg_trial;
+                 i < next_images.size() &&
+                 batch_image_ids.size() <
+                     static_cast<size_t>(options_->num_speculative_reg_images);
+                 ++i) {
+              if (is_trivial_frame(next_images[i])) {
+                batch_image_ids.push_back(next_images[i]);
+              }
+            }
+            for (auto& pose : mapper.EstimateNextImagePoses(mapper_options,
+                                                            batch_image_ids)) {
+              batch_poses.emplace(pose.image_id, std::move(pose));
+            }
+          }
+          reg_next_success = mapper.RegisterNextImage(
+              mapper_options, batch_poses.at(next_image_id));
+          if (reg_next_success) {
+            // Keep the successful estimates of the remaining candidates.
+            const auto it = std::find(batch_image_ids.begin(),
+                                      batch_image_ids.end(),
+                                      next_image_id);
+            for (auto next_it = std::next(it); next_it != batch_image_ids.end();
+                 ++next_it) {
+              IncrementalMapper::NextImagePose& pose = batch_poses.at(*next_it);
+              if (pose.success) {
+                speculative_poses.push_back(std::move(pose));
+              }
+            }
+          }
         } else {
           reg_next_success =
               mapper.RegisterNextImage(mapper_options, next_image_id);
@@ -579,29 +828,41 @@ IncrementalPipeline::Status IncrementalPipeline::ReconstructSubModel(
     }
 
     if (reg_next_success) {
-      const Image& image = reconstruction->Image(next_image_id);
-      for (const data_t& data_id : image.FramePtr()->ImageIds()) {
-        mapper.TriangulateImage(options_->Triangulation(), data_id.id);
+      deferred_image_ids.push_back(next_image_id);
+      if (reg_structure_less && options_->structure_less_registration_first &&
+          deferred_image_ids.size() <
+              static_cast<size_t>(options_->structure_less_batch_size)) {
+        continue;
       }
-      mapper.IterativeLocalRefinement(options_->ba_local_max_refinements,
-                                      options_->ba_local_max_refinement_change,
-                                      mapper_options,
-                                      options_->LocalBundleAdjustment(),
-                                      options_->Triangulation(),
-                                      next_image_id);
+
+      triangulate_deferred_images();
+      global_refinement_scheduler.LocalRefinementDone(
+          mapper.IterativeLocalRefinement(
+              options_->ba_local_max_refinements,
+              options_->ba_local_max_refinement_change,
+              mapper_options,
+              options_->LocalBundleAdjustment(),
+              options_->Triangulation(),
+              next_image_id));
 
       if (CheckRunGlobalRefinement(
               *reconstruction, ba_prev_num_reg_frames, ba_prev_num_points)) {
-        IterativeGlobalRefinement(*options_, mapper_options, mapper);
+        if (global_refinement_scheduler.ShouldRunGlobalRefinement(
+                *reconstruction)) {
+          Timer global_ba_timer;
+          global_ba_timer.Start();
+          IterativeGlobalRefinement(*options_, mapper_options, mapper);
+          global_refinement_scheduler.GlobalRefinementDone(
+              *reconstruction, global_ba_timer.ElapsedSeconds());
+          global_ba_num_reg_frames = reconstruction->NumRegFrames();
+          global_ba_num_points = reconstruction->NumPoints3D();
+        }
         ba_prev_num_points = reconstruction->NumPoints3D();
         ba_prev_num_reg_frames = reconstruction->NumRegFrames();
       }
 
-      if (options_->extract_colors) {
-        for (const data_t& data_id : image.FramePtr()->ImageIds()) {
-          ExtractColors(options_->image_path, data_id.id, *reconstruction);
-        }
-      }
+      extract_deferred_colors();
+      deferred_image_ids.clear();
 
       if (options_->snapshot_frames_freq > 0 &&
           reconstruction->NumRegFrames() >=
@@ -610,6 +871,14 @@ IncrementalPipeline::Status IncrementalPipeline::ReconstructSubModel(
         WriteSnapshot(*reconstruction, options_->snapshot_path);
       }
 
+      if (options_->checkpoint_frames_freq > 0 &&
+          reconstruction->NumRegFrames() >=
+              options_->checkpoint_frames_freq +
+                  checkpoint_prev_num_reg_frames) {
+        checkpoint_prev_num_reg_frames = reconstruction->NumRegFrames();
+        WriteCheckpoint(mapper);
+      }
+
       Callback(NEXT_IMAGE_REG_CALLBACK);
     }
 
@@ -623,18 +892,31 @@ IncrementalPipeline::Status IncrementalPipeline::ReconstructSubModel(
     // bundle adjustment and try again to register one image. If this fails
     // once, then exit the incremental mapping.
     if (!reg_next_success && prev_reg_next_success) {
+      triangulate_deferred_images();
+      extract_deferred_colors();
+      deferred_image_ids.clear();
       IterativeGlobalRefinement(*options_, mapper_options, mapper);
     }
   } while (reg_next_success || prev_reg_next_success);
 
+  triangulate_deferred_images();
+  extract_deferred_colors();
+
+  if (global_refinement_scheduler.NumSkippedRefinements() > 0) {
+    LOG(INFO) << StringPrintf(
+        "Skipped %d global bundle adjustments, estimated time saved: %.3fs",
+        static_cast<int>(global_refinement_scheduler.NumSkippedRefinements()),
+        global_refinement_scheduler.TimeSavedSeconds());
+  }
+
   if (CheckIfStopped() || CheckReachedMaxRuntime()) {
     return Status::INTERRUPTED;
   }
 
   // Only run final global BA, if last incremental BA was not global.
   if (reconstruction->NumRegFrames() > 0 &&
-      reconstruction->NumRegFrames() != ba_prev_num_reg_frames &&
-      reconstruction->NumPoints3D() != ba_prev_num_points) {
+      reconstruction->NumRegFrames() != global_ba_num_reg_frames &&
+      reconstruction->NumPoints3D() != global_ba_num_points) {
     IterativeGlobalRefinement(*options_, mapper_options, mapper);
   }
   return Status::SUCCESS;
@@ -653,7 +935,7 @@ IncrementalPipeline::Status IncrementalPipeline::Reconstruct(
     const size_t reconstruction_idx =
         (!continue_reconstruction || num_trials > 0)
             ? reconstruction_manager_->Add()
-            : 0;
+            : reconstruction_manager_->Size() - 1;
     std::shared_ptr<Reconstruction> reconstruction =
         reconstruction_manager_->Get(reconstruction_idx);
 
@@ -663,6 +945,9 @@ IncrementalPipeline::Status IncrementalPipeline::Reconstruct(
       case Status::INTERRUPTED: {
         reconstruction->UpdatePoint3DErrors();
         LOG(INFO) << "Keeping reconstruction due to interrupt";
+        if (options_->checkpoint_frames_freq > 0) {
+          WriteCheckpoint(mapper);
+        }
         mapper.EndReconstruction(/*discard=*/false);
         AlignReconstructionToOrigRigScales(database_cache_->Rigs(),
                                            reconstruction.get());
@@ -726,6 +1011,10 @@ IncrementalPipeline::Status IncrementalPipeline::Reconstruct(
                                              reconstruction.get());
         }
 
+        if (options_->checkpoint_frames_freq > 0) {
+          WriteCheckpoint(mapper);
+        }
+
         Callback(LAST_IMAGE_REG_CALLBACK);
 
         // Check if we should or can reconstruct another sub-model.
@@ -756,30 +1045,44 @@ void IncrementalPipeline::TriangulateReconstruction(
   IncrementalMapper mapper(database_cache_);
   mapper.BeginReconstruction(reconstruction);
 
-  LOG(INFO) << "Iterative triangulation";
-  size_t image_idx = 0;
-  for (const image_t image_id : reconstruction->RegImageIds()) {
-    const auto& image = reconstruction->Image(image_id);
+  if (options_->parallel_triangulation) {
+    LOG(INFO) << "Parallel triangulation";
+    const size_t num_tris =
+        mapper.TriangulateAllImages(options_->Triangulation());
+    LOG(INFO) << "=> Triangulated " << num_tris << " observations of "
+              << reconstruction->NumPoints3D() << " points";
+
+    LOG(INFO) << "Global bundle adjustment";
+    mapper.AdjustGlobalBundle(options_->Mapper(),
+                              options_->GlobalBundleAdjustment());
+    LOG(INFO) << "=> Filtered observations: "
+              << mapper.FilterPoints(options_->Mapper());
+  } else {
+    LOG(INFO) << "Iterative triangulation";
+    size_t image_idx = 0;
+    for (const image_t image_id : reconstruction->RegImageIds()) {
+      const auto& image = reconstruction->Image(image_id);
 
-    LOG(INFO) << StringPrintf(
-        "Triangulating image #%d (%d)", image_id, image_idx++);
-    const size_t num_existing_points3D = image.NumPoints3D();
-    LOG(INFO) << "=> Image sees " << num_existing_points3D << " / "
-              << mapper.ObservationManager().NumObservations(image_id)
-              << " points";
+      LOG(INFO) << StringPrintf(
+          "Triangulating image #%d (%d)", image_id, image_idx++);
+      const size_t num_existing_points3D = image.NumPoints3D();
+      LOG(INFO) << "=> Image sees " << num_existing_points3D << " / "
+                << mapper.ObservationManager().NumObservations(image_id)
+                << " points";
+
+      mapper.TriangulateImage(options_->Triangulation(), image_id);
+      VLOG(1) << "=> Triangulated "
+              << (image.NumPoints3D() - num_existing_points3D) << " points";
+    }
 
-    mapper.TriangulateImage(options_->Triangulation(), image_id);
-    VLOG(1) << "=> Triangulated "
-            << (image.NumPoints3D() - num_existing_points3D) << " points";
+    LOG(INFO) << "Retriangulation and Global bundle adjustment";
+    mapper.IterativeGlobalRefinement(options_->ba_global_max_refinements,
+                                     options_->ba_global_max_refinement_change,
+                                     options_->Mapper(),
+                                     options_->GlobalBundleAdjustment(),
+                                     options_->Triangulation(),
+                                     /*normalize_reconstruction=*/false);
   }
-
-  LOG(INFO) << "Retriangulation and Global bundle adjustment";
-  mapper.IterativeGlobalRefinement(options_->ba_global_max_refinements,
-                                   options_->ba_global_max_refinement_change,
-                                   options_->Mapper(),
-                                   options_->GlobalBundleAdjustment(),
-                                   options_->Triangulation(),
-                                   /*normalize_reconstruction=*/false);
   mapper.EndReconstruction(/*discard=*/false);
 
   reconstruction->UpdatePoint3DErrors();
@@ -795,6 +1098,236 @@ void IncrementalPipeline::RegisterCallbacks() {
   RegisterCallback(LAST_IMAGE_REG_CALLBACK);
 }
 
+bool IncrementalPipeline::ReconstructComponents() {
+  // Images of the same frame are reconstructed together, so they must end up
+  // in the same component.
+  std::unordered_set<image_t> image_ids;
+  std::vector<std::pair<image_t, image_t>> edges;
+  std::unordered_map<frame_t, image_t> frame_to_image_id;
+  for (const auto& [image_id, image] : database_cache_->Images()) {
+    image_ids.insert(image_id);
+    const auto [it, inserted] =
+        frame_to_image_id.emplace(image.FrameId(), image_id);
+    if (!inserted) {
+      edges.emplace_back(it->second, image_id);
+    }
+  }
+  for (const auto& [pair_id, num_matches] :
+       database_cache_->CorrespondenceGraph()->NumMatchesBetweenAllImages()) {
+    if (num_matches > 0) {
+      edges.push_back(PairIdToImagePair(pair_id));
+    }
+  }
+
+  std::vector<std::vector<image_t>> components =
+      FindConnectedComponents(image_ids, edges);
+  if (components.size() <= 1) {
+    return false;
+  }
+
+  std::sort(components.begin(),
+            components.end(),
+            [](const std::vector<image_t>& component1,
+               const std::vector<image_t>& component2) {
+              return component1.size() > component2.size();
+            });
+
+  // Same as for sequential reconstruction, small models are only kept for the
+  // largest component.
+  const size_t num_components = components.size();
+  components.erase(
+      std::remove_if(components.begin() + 1,
+                     components.end(),
+                     [this](const std::vector<image_t>& component) {
+                       return component.size() <
+                              static_cast<size_t>(options_->min_model_size);
+                     }),
+      components.end());
+
+  LOG(INFO) << StringPrintf(
+      "Reconstructing %d of %d connected components in parallel",
+      static_cast<int>(components.size()),
+      static_cast<int>(num_components));
+
+  const int num_threads = GetEffectiveNumThreads(options_->num_threads);
+  const int num_workers =
+      std::min(static_cast<int>(components.size()), num_threads);
+
+  std::vector<std::shared_ptr<class ReconstructionManager>>
+      component_reconstruction_managers(components.size());
+  ThreadPool thread_pool(num_workers);
+  for (size_t i = 0; i < components.size(); ++i) {
+    auto component_options =
+        std::make_shared<IncrementalPipelineOptions>(*options_);
+    component_options->parallel_components = false;
+    component_options->num_threads = std::max(1, num_threads / num_workers);
+    component_options->max_runtime_seconds = -1;
+    component_options->checkpoint_path.clear();
+    component_options->checkpoint_frames_freq = 0;
+    if (!options_->snapshot_path.empty()) {
+      component_options->snapshot_path =
+          options_->snapshot_path /
+          StringPrintf("component%d", static_cast<int>(i));
+    }
+    component_options->image_names.clear();
+    for (const image_t image_id : components[i]) {
+      component_options->image_names.push_back(
+          database_cache_->Image(image_id).Name());
+    }
+
+    component_reconstruction_managers[i] =
+        std::make_shared<class ReconstructionManager>();
+    thread_pool.AddTask([this,
+                         component_options = std::move(component_options),
+                         component_reconstruction_manager =
+                             component_reconstruction_managers[i]]() {
+      IncrementalPipeline component_pipeline(component_options,
+                                             database_cache_,
+                                             component_reconstruction_manager);
+      component_pipeline.SetCheckIfStoppedFunc([this]() {
+        return CheckIfStopped() || CheckReachedMaxRuntime();
+      });
+      component_pipeline.Run();
+    });
+  }
+  thread_pool.Wait();
+
+  // The components share no images, so their models cannot be merged and are
+  // collected in the order of decreasing component size.
+  for (const auto& component_reconstruction_manager :
+       component_reconstruction_managers) {
+    for (size_t i = 0; i < component_reconstruction_manager->Size() &&
+                       reconstruction_manager_->Size() <
+                           static_cast<size_t>(options_->max_num_models);
+         ++i) {
+      const size_t reconstruction_idx = reconstruction_manager_->Add();
+      reconstruction_manager_->Get(reconstruction_idx) =
+          component_reconstruction_manager->Get(i);
+    }
+  }
+
+  Callback(LAST_IMAGE_REG_CALLBACK);
+
+  return true;
+}
+
+void IncrementalPipeline::WriteCheckpoint(const IncrementalMapper& mapper) {
+  if (options_->checkpoint_path.empty()) {
+    return;
+  }
+
+  // Only keep one pending checkpoint in memory.
+  WaitForCheckpoint();
+  if (checkpoint_thread_pool_ == nullptr) {
+    checkpoint_thread_pool_ = std::make_shared<ThreadPool>(1);
+  }
+
+  LOG(INFO) << "Creating checkpoint";
+
+  const std::filesystem::path& checkpoint_path = options_->checkpoint_path;
+  CreateDirIfNotExists(checkpoint_path / "models", /*recursive=*/true);
+
+  // Copy the data, such that mapping can continue while writing.
+  const bool in_progress = mapper.Reconstruction() != nullptr;
+  const size_t num_finished_models =
+      reconstruction_manager_->Size() - (in_progress ? 1 : 0);
+
+  // Finished models do not change anymore and are written only once.
+  for (; num_checkpoint_models_ < num_finished_models;
+       ++num_checkpoint_models_) {
+    auto model = std::make_shared<const Reconstruction>(
+        *reconstruction_manager_->Get(num_checkpoint_models_));
+    const std::filesystem::path model_path =
+        checkpoint_path / "models" / std::to_string(num_checkpoint_models_);
+    checkpoint_thread_pool_->AddTask([model, model_path]() {
+      CreateDirIfNotExists(model_path);
+      model->Write(model_path);
+    });
+  }
+
+  std::shared_ptr<const Reconstruction> current_model;
+  if (in_progress) {
+    current_model =
+        std::make_shared<const Reconstruction>(*mapper.Reconstruction());
+  }
+
+  std::ostringstream state;
+  WriteBinaryLittleEndian<uint64_t>(&state, num_finished_models);
+  WriteBinaryLittleEndian<uint8_t>(&state, in_progress ? 1 : 0);
+  mapper.WriteState(state);
+
+  // Write the new checkpoint next to the previous one and only replace it once
+  // complete, such that there is always a consistent checkpoint.
+  checkpoint_thread_pool_->AddTask(
+      [checkpoint_path, current_model, state = state.str()]() {
+        const std::filesystem::path tmp_path = checkpoint_path / "current.tmp";
+        std::filesystem::remove_all(tmp_path);
+        CreateDirIfNotExists(tmp_path);
+        if (current_model) {
+          CreateDirIfNotExists(tmp_path / "model");
+          current_model->Write(tmp_path / "model");
+        }
+        {
+          std::ofstream file(tmp_path / "state.bin", std::ios::binary);
+          THROW_CHECK_FILE_OPEN(file, tmp_path / "state.bin");
+          file.write(state.data(), state.size());
+        }
+        const std::filesystem::path current_path = checkpoint_path / "current";
+        std::filesystem::remove_all(current_path);
+        std::filesystem::rename(tmp_path, current_path);
+        VLOG(1) << "=> Wrote checkpoint to " << current_path;
+      });
+}
+
+bool IncrementalPipeline::ReadCheckpoint(IncrementalMapper& mapper) {
+  const std::filesystem::path& checkpoint_path = options_->checkpoint_path;
+
+  // Fall back to a complete checkpoint that was not yet moved into place.
+  std::filesystem::path current_path = checkpoint_path / "current";
+  if (!ExistsFile(current_path / "state.bin")) {
+    current_path = checkpoint_path / "current.tmp";
+  }
+  if (!ExistsFile(current_path / "state.bin")) {
+    LOG(WARNING) << "No checkpoint found in " << checkpoint_path
+                 << ", starting from scratch.";
+    return false;
+  }
+
+  LOG(INFO) << "Resuming from checkpoint " << current_path;
+
+  std::ifstream file(current_path / "state.bin", std::ios::binary);
+  THROW_CHECK_FILE_OPEN(file, current_path / "state.bin");
+  const uint64_t num_finished_models = ReadBinaryLittleEndian<uint64_t>(&file);
+  const bool in_progress = ReadBinaryLittleEndian<uint8_t>(&file) != 0;
+
+  for (uint64_t i = 0; i < num_finished_models; ++i) {
+    reconstruction_manager_->Read(checkpoint_path / "models" /
+                                  std::to_string(i));
+  }
+  num_checkpoint_models_ = num_finished_models;
+
+  if (in_progress) {
+    reconstruction_manager_->Read(current_path / "model");
+    // The state is restored after beginning the continued reconstruction.
+    std::ostringstream mapper_state;
+    mapper_state << file.rdbuf();
+    resume_mapper_state_ = mapper_state.str();
+  } else {
+    mapper.ReadState(file);
+  }
+
+  LOG(INFO) << "=> Resumed " << num_finished_models << " finished models"
+            << (in_progress ? " and one model in progress" : "");
+
+  return in_progress;
+}
+
+void IncrementalPipeline::WaitForCheckpoint() {
+  if (checkpoint_thread_pool_ != nullptr) {
+    checkpoint_thread_pool_->Wait();
+  }
+}
+
 bool IncrementalPipeline::CheckReachedMaxRuntime() const {
   if (options_->max_runtime_seconds > 0 &&
       total_run_timer_->ElapsedSeconds() > options_->max_runtime_seconds) {
@@ -41,8 +41,76 @@
 
 namespace colmap {
 
+class ThreadPool;
 class Timer;
 
+// Decides whether a global refinement proposed by the growth-based schedule of
+// the incremental pipeline is worth its cost. The drift of the model since the
+// last global refinement is estimated from the trend of the reprojection errors
+// and the fraction of filtered observations in the local refinements. Global
+// refinement is skipped as long as these stay close to their values right
+// after the last global refinement.
+class GlobalRefinementScheduler {
+ public:
+  struct Options {
+    // Whether to skip global refinements that are not expected to improve the
+    // model. If disabled, all proposed global refinements are run.
+    bool adaptive = false;
+
+    // Models with fewer registered frames are always refined globally.
+    int min_num_frames = 50;
+
+    // Growth ratio of registered frames since the last global refinement after
+    // which global refinement is always run.
+    double max_frames_ratio = 2.0;
+
+    // Relative increase of the local reprojection error over its reference
+    // after the last global refinement above which the model is considered as
+    // drifted.
+    double max_error_increase = 0.1;
+
+    // Fraction of filtered observations in local refinement above which the
+    // model is considered as drifted.
+    double max_filtered_ratio = 0.02;
+
+    bool Check() const;
+  };
+
+  explicit GlobalRefinementScheduler(const Options& options);
+
+  // Update the drift estimate with the report of a local refinement.
+  void LocalRefinementDone(
+      const IncrementalMapper::LocalBundleAdjustmentReport& report);
+
+  // Reset the drift estimate after a global refinement, which took the given
+  // time to run.
+  void GlobalRefinementDone(const Reconstruction& reconstruction,
+                            double elapsed_seconds);
+
+  // Whether to run a proposed global refinement. Otherwise, the refinement is
+  // counted as skipped.
+  bool ShouldRunGlobalRefinement(const Reconstruction& reconstruction);
+
+  size_t NumSkippedRefinements() const;
+
+  // Estimated time saved by the skipped refinements, based on the average
+  // runtime of the previous global refinements.
+  double TimeSavedSeconds() const;
+
+ private:
+  const Options options_;
+  size_t num_reg_frames_at_refinement_ = 0;
+  size_t num_refinements_ = 0;
+  double refinement_seconds_ = 0;
+  size_t num_skipped_refinements_ = 0;
+  double time_saved_seconds_ = 0;
+  // Statistics of the local refinements since the last global refinement.
+  size_t num_local_refinements_ = 0;
+  double ref_reproj_error_ = 0;
+  double reproj_error_ = 0;
+  double filtered_ratio_ = 0;
+};
+
 // NOLINTNEXTLINE(clang-analyzer-optin.performance.Padding)
 struct IncrementalPipelineOptions {
   // The minimum number of matches for inlier matches to be considered.
@@ -68,6 +136,20 @@ struct IncrementalPipelineOptions {
   // number of images, we also always keep it.
   int min_model_size = 10;
 
+  // Whether to reconstruct the connected components of the correspondence
+  // graph concurrently with separate mappers, if the scene consists of
+  // multiple components. Components with fewer than min_model_size images,
+  // except for the largest one, are not reconstructed. Checkpoints are not
+  // written in this mode and snapshots are written into per-component
+  // sub-folders of the snapshot path.
+  bool parallel_components = false;
+
+  // Whether to triangulate models with known poses by triangulating the
+  // candidate tracks of all images concurrently, followed by a single global
+  // bundle adjustment, instead of triangulating image by image with iterative
+  // global refinement. Only used by TriangulateReconstruction.
+  bool parallel_triangulation = false;
+
   // The image identifiers used to initialize the reconstruction. Note that
   // only one or both image identifiers can be specified. In the former case,
   // the second image is automatically determined.
@@ -85,6 +167,23 @@ struct IncrementalPipelineOptions {
   // Only use structure-less and skip structure-based image registration.
   bool structure_less_registration_only = false;
 
+  // Whether to try structure-less registration before structure-based
+  // registration, which is cheaper for sequences with high overlap between
+  // consecutive frames, e.g., video. New points of structure-less registered
+  // images are not triangulated during registration but in batches.
+  bool structure_less_registration_first = false;
+
+  // The number of images registered structure-less in a row, after which they
+  // are triangulated and locally refined together. Only used if
+  // structure_less_registration_first is enabled.
+  int structure_less_batch_size = 5;
+
+  // The number of next image candidates whose poses are speculatively
+  // estimated in parallel. The successful estimates are registered one after
+  // another, as long as they remain consistent with the reconstruction. A
+  // value of 1 registers the images strictly sequentially.
+  int num_speculative_reg_images = 1;
+
   // Whether to extract colors for reconstructed points.
   bool extract_colors = true;
 
@@ -123,6 +222,15 @@ struct IncrementalPipelineOptions {
   int ba_global_frames_freq = 500;
   int ba_global_points_freq = 250000;
 
+  // Whether to skip the global bundle adjustments triggered by the growth
+  // rates as long as the local bundle adjustments indicate no drift of the
+  // model, see GlobalRefinementScheduler::Options for the thresholds.
+  bool ba_global_adaptive = false;
+  int ba_global_adaptive_min_num_frames = 50;
+  double ba_global_adaptive_max_frames_ratio = 2.0;
+  double ba_global_adaptive_max_error_increase = 0.1;
+  double ba_global_adaptive_max_filtered_ratio = 0.02;
+
   // Ceres solver function tolerance for global bundle adjustment
   double ba_global_function_tolerance = 0.0;
 
@@ -162,6 +270,16 @@ struct IncrementalPipelineOptions {
   std::filesystem::path snapshot_path;
   int snapshot_frames_freq = 0;
 
+  // Path to a folder for checkpoints of the incremental reconstruction, which
+  // contain the reconstructed models and the state of the mapper. Checkpoints
+  // are written asynchronously according to the specified frequency of
+  // registered frames and when the reconstruction is interrupted. If enabled,
+  // the reconstruction resumes from the latest checkpoint in the folder
+  // without redoing the registrations.
+  std::filesystem::path checkpoint_path;
+  int checkpoint_frames_freq = 0;
+  bool resume_from_checkpoint = false;
+
   // The image path at which to find the images to extract point colors.
   // If not specified, all point colors will be black.
   std::filesystem::path image_path;
@@ -176,6 +294,17 @@ struct IncrementalPipelineOptions {
   // enabled for incremental SfM.
   bool load_all_images = false;
 
+  // Optional path to a snapshot of the correspondence graph, which is reused
+  // in subsequent runs on the same database instead of rebuilding the graph.
+  std::filesystem::path correspondence_graph_snapshot_path;
+
+  // Whether to load the keypoints of images on demand, when they are
+  // considered for registration, instead of keeping the keypoints of all
+  // images in memory. Reduces the peak memory usage for large datasets. The
+  // size of the loaded keypoints of unregistered images can be bounded by
+  // `mapper.lazy_points2D_cache_size`.
+  bool lazy_load_points2D = false;
+
   // If reconstruction is provided as input, fix the existing frame poses.
   bool fix_existing_frames = false;
 
@@ -198,6 +327,7 @@ struct IncrementalPipelineOptions {
   IncrementalTriangulator::Options Triangulation() const;
   BundleAdjustmentOptions LocalBundleAdjustment() const;
   BundleAdjustmentOptions GlobalBundleAdjustment() const;
+  GlobalRefinementScheduler::Options GlobalRefinementScheduling() const;
 
   inline bool IsInitialPairProvided() const {
     return init_image_id1 != -1 && init_image_id2 != -1;
@@ -276,10 +406,34 @@ class IncrementalPipeline : public BaseController {
  private:
   void RegisterCallbacks();
 
+  // Reconstruct the connected components of the correspondence graph
+  // concurrently. Returns false without reconstructing anything, if there is
+  // only a single component.
+  bool ReconstructComponents();
+
+  // Write a checkpoint of all models and the mapper state in the background.
+  // If the mapper has an active reconstruction, it is checkpointed as the
+  // model in progress, which is continued when resuming.
+  void WriteCheckpoint(const IncrementalMapper& mapper);
+
+  // Read the latest checkpoint into the reconstruction manager and mapper.
+  // Returns whether a model in progress should be continued.
+  bool ReadCheckpoint(IncrementalMapper& mapper);
+
+  void WaitForCheckpoint();
+
   const std::shared_ptr<IncrementalPipelineOptions> options_;
   std::shared_ptr<class ReconstructionManager> reconstruction_manager_;
   std::shared_ptr<class DatabaseCache> database_cache_;
   std::shared_ptr<Timer> total_run_timer_;
+
+  // Single worker to write checkpoints in the background.
+  std::shared_ptr<ThreadPool> checkpoint_thread_pool_;
+  // Number of finished models that were already written to the checkpoint.
+  size_t num_checkpoint_models_ = 0;
+  // Mapper state of the checkpoint, which is restored after beginning the
+  // continued reconstruction.
+  std::string resume_mapper_state_;
 };
 
 }  // namespace colmap
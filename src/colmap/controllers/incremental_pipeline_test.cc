@@ -33,6 +33,7 @@
 #include "colmap/scene/database.h"
 #include "colmap/scene/reconstruction_matchers.h"
 #include "colmap/scene/synthetic.h"
+#include "colmap/util/file.h"
 #include "colmap/util/testing.h"
 
 #include <gtest/gtest.h>
@@ -67,6 +68,55 @@ TEST(IncrementalPipeline, WithoutNoise) {
                                  /*max_proj_center_error=*/1e-4));
 }
 
+TEST(IncrementalPipeline, ResumeFromCheckpoint) {
+  const auto test_dir = CreateTestDir();
+  const auto database_path = test_dir / "database.db";
+
+  auto database = Database::Open(database_path);
+  Reconstruction gt_reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 7;
+  synthetic_dataset_options.num_points3D = 50;
+  synthetic_dataset_options.camera_has_prior_focal_length = false;
+  SynthesizeDataset(
+      synthetic_dataset_options, &gt_reconstruction, database.get());
+
+  auto options = std::make_shared<IncrementalPipelineOptions>();
+  options->checkpoint_path = test_dir / "checkpoint";
+  options->checkpoint_frames_freq = 2;
+
+  // Interrupt the reconstruction after a few registrations.
+  {
+    auto reconstruction_manager = std::make_shared<ReconstructionManager>();
+    IncrementalPipeline mapper(options, database, reconstruction_manager);
+    int num_reg_callbacks = 0;
+    mapper.AddCallback(IncrementalPipeline::NEXT_IMAGE_REG_CALLBACK,
+                       [&num_reg_callbacks]() { ++num_reg_callbacks; });
+    mapper.SetCheckIfStoppedFunc(
+        [&num_reg_callbacks]() { return num_reg_callbacks >= 4; });
+    mapper.Run();
+    ASSERT_EQ(reconstruction_manager->Size(), 1);
+    EXPECT_LT(reconstruction_manager->Get(0)->NumRegFrames(),
+              gt_reconstruction.NumRegFrames());
+  }
+  EXPECT_TRUE(ExistsFile(options->checkpoint_path / "current" / "state.bin"));
+
+  options->resume_from_checkpoint = true;
+  auto reconstruction_manager = std::make_shared<ReconstructionManager>();
+  IncrementalPipeline mapper(options, database, reconstruction_manager);
+  mapper.Run();
+
+  ASSERT_EQ(reconstruction_manager->Size(), 1);
+  EXPECT_EQ(reconstruction_manager->Get(0)->NumRegFrames(),
+            gt_reconstruction.NumRegFrames());
+  EXPECT_THAT(gt_reconstruction,
+              ReconstructionNear(*reconstruction_manager->Get(0),
+                                 /*max_rotation_error_deg=*/1e-2,
+                                 /*max_proj_center_error=*/1e-4));
+}
+
 TEST(IncrementalPipeline, WithoutNoiseSphericalCameras) {
   SetPRNGSeed(0);
   const auto database_path = CreateTestDir() / "database.db";
@@ -334,6 +384,91 @@ TEST(IncrementalPipeline, IgnoreRedundantPoints3D) {
                                  /*max_proj_center_error=*/1e-4));
 }
 
+TEST(IncrementalPipeline, AdaptiveGlobalBundleAdjustment) {
+  const auto database_path = CreateTestDir() / "database.db";
+
+  auto database = Database::Open(database_path);
+  Reconstruction gt_reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 7;
+  synthetic_dataset_options.num_points3D = 50;
+  SynthesizeDataset(
+      synthetic_dataset_options, &gt_reconstruction, database.get());
+
+  auto reconstruction_manager = std::make_shared<ReconstructionManager>();
+  auto options = std::make_shared<IncrementalPipelineOptions>();
+  options->ba_global_adaptive = true;
+  options->ba_global_adaptive_min_num_frames = 0;
+  IncrementalPipeline mapper(options, database, reconstruction_manager);
+  mapper.Run();
+
+  ASSERT_EQ(reconstruction_manager->Size(), 1);
+  EXPECT_THAT(gt_reconstruction,
+              ReconstructionNear(*reconstruction_manager->Get(0),
+                                 /*max_rotation_error_deg=*/1e-2,
+                                 /*max_proj_center_error=*/1e-4));
+}
+
+TEST(GlobalRefinementScheduler, Nominal) {
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 10;
+  synthetic_dataset_options.num_points3D = 50;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+
+  IncrementalMapper::LocalBundleAdjustmentReport report;
+  report.num_adjusted_observations = 1000;
+  report.num_filtered_observations = 0;
+  report.mean_reproj_error = 1.0;
+
+  GlobalRefinementScheduler::Options options;
+  options.min_num_frames = 0;
+
+  // Always run, if not adaptive.
+  GlobalRefinementScheduler fixed_scheduler(options);
+  fixed_scheduler.GlobalRefinementDone(reconstruction, 2.0);
+  for (int i = 0; i < 5; ++i) {
+    fixed_scheduler.LocalRefinementDone(report);
+  }
+  EXPECT_TRUE(fixed_scheduler.ShouldRunGlobalRefinement(reconstruction));
+  EXPECT_EQ(fixed_scheduler.NumSkippedRefinements(), 0);
+
+  options.adaptive = true;
+  GlobalRefinementScheduler scheduler(options);
+  // Run without any timing and drift statistics.
+  EXPECT_TRUE(scheduler.ShouldRunGlobalRefinement(reconstruction));
+  scheduler.GlobalRefinementDone(reconstruction, 2.0);
+  EXPECT_TRUE(scheduler.ShouldRunGlobalRefinement(reconstruction));
+
+  // Skip, if the local reprojection errors are stable.
+  for (int i = 0; i < 5; ++i) {
+    scheduler.LocalRefinementDone(report);
+  }
+  EXPECT_FALSE(scheduler.ShouldRunGlobalRefinement(reconstruction));
+  EXPECT_EQ(scheduler.NumSkippedRefinements(), 1);
+  EXPECT_EQ(scheduler.TimeSavedSeconds(), 2.0);
+
+  // Run, if the local reprojection errors increase.
+  report.mean_reproj_error = 2.0;
+  for (int i = 0; i < 5; ++i) {
+    scheduler.LocalRefinementDone(report);
+  }
+  EXPECT_TRUE(scheduler.ShouldRunGlobalRefinement(reconstruction));
+  scheduler.GlobalRefinementDone(reconstruction, 4.0);
+
+  // Run, if many observations are filtered.
+  report.num_filtered_observations = 100;
+  for (int i = 0; i < 5; ++i) {
+    scheduler.LocalRefinementDone(report);
+  }
+  EXPECT_TRUE(scheduler.ShouldRunGlobalRefinement(reconstruction));
+  EXPECT_EQ(scheduler.NumSkippedRefinements(), 1);
+}
+
 TEST(IncrementalPipeline, StructureLessRegistrationOnly) {
   const auto database_path = CreateTestDir() / "database.db";
 
@@ -360,6 +495,33 @@ TEST(IncrementalPipeline, StructureLessRegistrationOnly) {
                                  /*max_proj_center_error=*/1e-4));
 }
 
+TEST(IncrementalPipeline, StructureLessRegistrationFirst) {
+  const auto database_path = CreateTestDir() / "database.db";
+
+  auto database = Database::Open(database_path);
+  Reconstruction gt_reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 7;
+  synthetic_dataset_options.num_points3D = 50;
+  SynthesizeDataset(
+      synthetic_dataset_options, &gt_reconstruction, database.get());
+
+  auto reconstruction_manager = std::make_shared<ReconstructionManager>();
+  auto options = std::make_shared<IncrementalPipelineOptions>();
+  options->structure_less_registration_first = true;
+  options->structure_less_batch_size = 3;
+  IncrementalPipeline mapper(options, database, reconstruction_manager);
+  mapper.Run();
+
+  ASSERT_EQ(reconstruction_manager->Size(), 1);
+  EXPECT_THAT(gt_reconstruction,
+              ReconstructionNear(*reconstruction_manager->Get(0),
+                                 /*max_rotation_error_deg=*/1e-3,
+                                 /*max_proj_center_error=*/1e-4));
+}
+
 TEST(IncrementalPipeline, MultiReconstruction) {
   const auto database_path = CreateTestDir() / "database.db";
 
@@ -403,6 +565,42 @@ TEST(IncrementalPipeline, MultiReconstruction) {
                                  /*max_proj_center_error=*/1e-4));
 }
 
+TEST(IncrementalPipeline, ParallelComponents) {
+  const auto database_path = CreateTestDir() / "database.db";
+
+  auto database = Database::Open(database_path);
+  Reconstruction gt_reconstruction1;
+  Reconstruction gt_reconstruction2;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 5;
+  synthetic_dataset_options.num_points3D = 50;
+  SynthesizeDataset(
+      synthetic_dataset_options, &gt_reconstruction1, database.get());
+  synthetic_dataset_options.num_frames_per_rig = 4;
+  SynthesizeDataset(
+      synthetic_dataset_options, &gt_reconstruction2, database.get());
+
+  auto reconstruction_manager = std::make_shared<ReconstructionManager>();
+  auto mapper_options = std::make_shared<IncrementalPipelineOptions>();
+  mapper_options->min_model_size = 4;
+  mapper_options->parallel_components = true;
+  IncrementalPipeline mapper(mapper_options, database, reconstruction_manager);
+  mapper.Run();
+
+  // Models are ordered by decreasing component size.
+  ASSERT_EQ(reconstruction_manager->Size(), 2);
+  EXPECT_THAT(gt_reconstruction1,
+              ReconstructionNear(*reconstruction_manager->Get(0),
+                                 /*max_rotation_error_deg=*/1e-2,
+                                 /*max_proj_center_error=*/1e-4));
+  EXPECT_THAT(gt_reconstruction2,
+              ReconstructionNear(*reconstruction_manager->Get(1),
+                                 /*max_rotation_error_deg=*/1e-2,
+                                 /*max_proj_center_error=*/1e-4));
+}
+
 TEST(IncrementalPipeline, FixExistingFrames) {
   const auto database_path = CreateTestDir() / "database.db";
 
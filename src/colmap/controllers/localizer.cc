@@ -0,0 +1,289 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/controllers/localizer.h"
+
+#include "colmap/feature/utils.h"
+#include "colmap/util/logging.h"
+#include "colmap/util/misc.h"
+#include "colmap/util/threading.h"
+#include "colmap/util/timer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace colmap {
+
+bool LocalizerOptions::Check() const {
+  CHECK_OPTION_GT(num_images, 0);
+  CHECK_OPTION_GT(num_nearest_neighbors, 0);
+  CHECK_OPTION_GT(num_checks, 0);
+  CHECK_OPTION_GE(num_images_after_verification, 0);
+  CHECK_OPTION_GT(max_ratio, 0.0);
+  CHECK_OPTION_LE(max_ratio, 1.0);
+  CHECK_OPTION_GT(min_num_inliers, 0);
+  abs_pose_options.Check();
+  abs_pose_refinement_options.Check();
+  return true;
+}
+
+Localizer::Localizer(const LocalizerOptions& options,
+                     std::shared_ptr<const Reconstruction> reconstruction,
+                     const Database& database,
+                     std::unique_ptr<retrieval::VisualIndex> visual_index)
+    : options_(options),
+      reconstruction_(std::move(reconstruction)),
+      visual_index_(std::move(visual_index)) {
+  THROW_CHECK(options_.Check());
+  THROW_CHECK_NOTNULL(reconstruction_);
+
+  Timer timer;
+  timer.Start();
+
+  image_ids_ = reconstruction_->RegImageIds();
+  std::sort(image_ids_.begin(), image_ids_.end());
+
+  std::vector<FeatureDescriptors> descriptors = database.ReadDescriptors(
+      span<const image_t>(image_ids_.data(), image_ids_.size()));
+
+  if (visual_index_ != nullptr) {
+    retrieval::VisualIndex::IndexOptions index_options;
+    // Same as for vocabulary tree matching, each feature is only assigned to
+    // a single visual word in the indexing phase.
+    index_options.num_neighbors = 1;
+    index_options.num_checks = options_.num_checks;
+    index_options.num_threads = options_.num_threads;
+
+    bool added_images = false;
+    for (size_t i = 0; i < image_ids_.size(); ++i) {
+      const image_t image_id = image_ids_[i];
+      if (visual_index_->IsImageIndexed(image_id)) {
+        continue;
+      }
+      FeatureKeypoints image_keypoints = database.ReadKeypoints(image_id);
+      FeatureDescriptors image_descriptors = descriptors[i];
+      if (options_.max_num_features > 0 &&
+          image_descriptors.data.rows() > options_.max_num_features) {
+        ExtractTopScaleFeatures(
+            &image_keypoints, &image_descriptors, options_.max_num_features);
+      }
+      visual_index_->Add(index_options,
+                         image_id,
+                         image_keypoints,
+                         image_descriptors.ToFloat());
+      added_images = true;
+    }
+
+    if (added_images) {
+      visual_index_->Prepare();
+    }
+  }
+
+  // Only the features with a 3D point are indexed for matching. The entries
+  // are created up front, so that they can be built concurrently.
+  std::vector<IndexedImage*> indexed_images;
+  indexed_images.reserve(image_ids_.size());
+  for (const image_t image_id : image_ids_) {
+    indexed_images.push_back(&indexed_images_[image_id]);
+  }
+
+  ParallelFor(
+      0,
+      image_ids_.size(),
+      [&](const int64_t begin, const int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          const Image& image = reconstruction_->Image(image_ids_[i]);
+          const FeatureDescriptorsFloat image_descriptors =
+              descriptors[i].ToFloat();
+          THROW_CHECK_EQ(image_descriptors.data.rows(), image.NumPoints2D());
+
+          IndexedImage& indexed_image = *indexed_images[i];
+          FeatureDescriptorsFloat point_descriptors;
+          point_descriptors.type = image_descriptors.type;
+          point_descriptors.precision = image_descriptors.precision;
+          point_descriptors.data.resize(image.NumPoints3D(),
+                                        image_descriptors.data.cols());
+          indexed_image.point3D_ids.reserve(image.NumPoints3D());
+          for (point2D_t point2D_idx = 0; point2D_idx < image.NumPoints2D();
+               ++point2D_idx) {
+            const struct Point2D& point2D = image.Point2D(point2D_idx);
+            if (point2D.HasPoint3D()) {
+              point_descriptors.data.row(indexed_image.point3D_ids.size()) =
+                  image_descriptors.data.row(point2D_idx);
+              indexed_image.point3D_ids.push_back(point2D.point3D_id);
+            }
+          }
+
+          // Queries are answered by a single thread each.
+          indexed_image.index = FeatureDescriptorIndex::Create(
+              FeatureDescriptorIndex::Type::DEFAULT, /*num_threads=*/1);
+          indexed_image.index->Build(point_descriptors);
+        }
+      },
+      options_.num_threads,
+      /*grain_size=*/1);
+
+  LOG(INFO) << StringPrintf("Indexed %d images for localization in %.3fs",
+                            image_ids_.size(),
+                            timer.ElapsedSeconds());
+}
+
+std::optional<LocalizationResult> Localizer::Localize(
+    const Camera& camera,
+    const FeatureKeypoints& keypoints,
+    const FeatureDescriptors& descriptors) const {
+  THROW_CHECK_EQ(keypoints.size(), descriptors.data.rows());
+
+  const FeatureDescriptorsFloat query_descriptors = descriptors.ToFloat();
+
+  // Match the query features against the features of the retrieved images
+  // and collect the unique 2D-3D correspondences.
+  std::vector<std::pair<point2D_t, point3D_t>> correspondences;
+  Eigen::RowMajorMatrixXi indices;
+  Eigen::RowMajorMatrixXf l2_dists;
+  for (const image_t image_id :
+       RetrieveImages(keypoints, query_descriptors)) {
+    const IndexedImage& indexed_image = indexed_images_.at(image_id);
+    if (indexed_image.point3D_ids.empty()) {
+      continue;
+    }
+    indexed_image.index->Search(
+        /*num_neighbors=*/2, query_descriptors, indices, l2_dists);
+    for (int i = 0; i < indices.rows(); ++i) {
+      const int best_idx = indices(i, 0);
+      if (best_idx < 0) {
+        continue;
+      }
+      // Keep this comparison >= in order to ensure that the case of
+      // best == second_best is detected.
+      if (indices.cols() > 1 && indices(i, 1) >= 0 &&
+          std::sqrt(l2_dists(i, 0)) >=
+              options_.max_ratio * std::sqrt(l2_dists(i, 1))) {
+        continue;
+      }
+      correspondences.emplace_back(static_cast<point2D_t>(i),
+                                   indexed_image.point3D_ids[best_idx]);
+    }
+  }
+
+  std::sort(correspondences.begin(), correspondences.end());
+  correspondences.erase(
+      std::unique(correspondences.begin(), correspondences.end()),
+      correspondences.end());
+
+  if (correspondences.size() <
+      static_cast<size_t>(options_.min_num_inliers)) {
+    return std::nullopt;
+  }
+
+  std::vector<Eigen::Vector2d> points2D;
+  std::vector<Eigen::Vector3d> points3D;
+  points2D.reserve(correspondences.size());
+  points3D.reserve(correspondences.size());
+  for (const auto& [point2D_idx, point3D_id] : correspondences) {
+    const FeatureKeypoint& keypoint = keypoints[point2D_idx];
+    points2D.emplace_back(keypoint.x, keypoint.y);
+    points3D.push_back(reconstruction_->Point3D(point3D_id).xyz);
+  }
+
+  AbsolutePoseEstimationOptions abs_pose_options = options_.abs_pose_options;
+  AbsolutePoseRefinementOptions abs_pose_refinement_options =
+      options_.abs_pose_refinement_options;
+  if (options_.estimate_unknown_focal_length &&
+      !camera.has_prior_focal_length) {
+    abs_pose_options.estimate_focal_length = true;
+    abs_pose_refinement_options.refine_focal_length = true;
+  }
+
+  LocalizationResult result;
+  result.camera = camera;
+  std::vector<char> inlier_mask;
+  if (!EstimateAbsolutePose(abs_pose_options,
+                            points2D,
+                            points3D,
+                            &result.cam_from_world,
+                            &result.camera,
+                            &result.num_inliers,
+                            &inlier_mask) ||
+      result.num_inliers < static_cast<size_t>(options_.min_num_inliers)) {
+    return std::nullopt;
+  }
+
+  if (options_.refine_pose &&
+      !RefineAbsolutePose(abs_pose_refinement_options,
+                          inlier_mask,
+                          points2D,
+                          points3D,
+                          &result.cam_from_world,
+                          &result.camera)) {
+    return std::nullopt;
+  }
+
+  result.inlier_correspondences.reserve(result.num_inliers);
+  for (size_t i = 0; i < correspondences.size(); ++i) {
+    if (inlier_mask[i]) {
+      result.inlier_correspondences.push_back(correspondences[i]);
+    }
+  }
+
+  return result;
+}
+
+std::vector<image_t> Localizer::RetrieveImages(
+    const FeatureKeypoints& keypoints,
+    const FeatureDescriptorsFloat& descriptors) const {
+  if (visual_index_ == nullptr) {
+    return image_ids_;
+  }
+
+  retrieval::VisualIndex::QueryOptions query_options;
+  query_options.max_num_images = options_.num_images;
+  query_options.num_neighbors = options_.num_nearest_neighbors;
+  query_options.num_checks = options_.num_checks;
+  query_options.num_images_after_verification =
+      options_.num_images_after_verification;
+  query_options.num_threads = 1;
+
+  std::vector<retrieval::ImageScore> image_scores;
+  visual_index_->Query(query_options, keypoints, descriptors, &image_scores);
+
+  // The visual index may also contain images that are not registered.
+  std::vector<image_t> image_ids;
+  image_ids.reserve(image_scores.size());
+  for (const retrieval::ImageScore& image_score : image_scores) {
+    const image_t image_id = static_cast<image_t>(image_score.image_id);
+    if (indexed_images_.count(image_id) > 0) {
+      image_ids.push_back(image_id);
+    }
+  }
+  return image_ids;
+}
+
+}  // namespace colmap
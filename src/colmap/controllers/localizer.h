@@ -0,0 +1,147 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "colmap/estimators/pose.h"
+#include "colmap/feature/index.h"
+#include "colmap/feature/types.h"
+#include "colmap/geometry/rigid3.h"
+#include "colmap/retrieval/visual_index.h"
+#include "colmap/scene/camera.h"
+#include "colmap/scene/database.h"
+#include "colmap/scene/reconstruction.h"
+
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace colmap {
+
+struct LocalizerOptions {
+  // Number of most similar registered images to retrieve per query image. The
+  // query is matched against all registered images without a visual index.
+  int num_images = 20;
+
+  // Number of nearest neighbor visual words per query feature in retrieval.
+  int num_nearest_neighbors = 5;
+
+  // Number of nearest-neighbor checks to use in retrieval.
+  int num_checks = 64;
+
+  // How many images to return after spatial verification in retrieval. Set to
+  // 0 to turn off spatial verification.
+  int num_images_after_verification = 0;
+
+  // The maximum number of features to use for indexing a registered image in
+  // the visual index. If an image has more features, only the largest-scale
+  // features will be indexed.
+  int max_num_features = -1;
+
+  // Maximum distance ratio between first and second best match.
+  double max_ratio = 0.8;
+
+  // Minimum number of inliers for a query image to be localized.
+  int min_num_inliers = 30;
+
+  // Whether to estimate and refine the focal length of query cameras without
+  // a prior focal length, e.g., from EXIF.
+  bool estimate_unknown_focal_length = true;
+
+  // Whether to refine the estimated pose with the RANSAC inliers.
+  bool refine_pose = true;
+
+  AbsolutePoseEstimationOptions abs_pose_options;
+  AbsolutePoseRefinementOptions abs_pose_refinement_options;
+
+  // Number of threads for building the indices. Queries are single-threaded,
+  // so that concurrent queries do not oversubscribe the cores.
+  int num_threads = -1;
+
+  bool Check() const;
+};
+
+struct LocalizationResult {
+  Rigid3d cam_from_world;
+
+  // The query camera with the estimated parameters, if enabled.
+  Camera camera;
+
+  size_t num_inliers = 0;
+
+  // The query feature index and the matched 3D point of each inlier.
+  std::vector<std::pair<point2D_t, point3D_t>> inlier_correspondences;
+};
+
+// Localizes query images against a fixed reconstruction. The 2D-3D descriptor
+// index of the registered images and the visual index for retrieval are built
+// once on construction and kept in memory, so that many query images can be
+// localized with low latency, e.g., by a long-running service. Localize is
+// thread-safe and can be called concurrently.
+class Localizer {
+ public:
+  // The descriptors of the registered images are read from the database,
+  // which is not used after construction. The registered images are added to
+  // the visual index, if they are not yet indexed. Without a visual index, the
+  // query images are matched against all registered images.
+  Localizer(const LocalizerOptions& options,
+            std::shared_ptr<const Reconstruction> reconstruction,
+            const Database& database,
+            std::unique_ptr<retrieval::VisualIndex> visual_index = nullptr);
+
+  // Estimates the pose of a query image with the given camera and features.
+  // Returns std::nullopt, if the image could not be localized.
+  std::optional<LocalizationResult> Localize(
+      const Camera& camera,
+      const FeatureKeypoints& keypoints,
+      const FeatureDescriptors& descriptors) const;
+
+  const Reconstruction& GetReconstruction() const { return *reconstruction_; }
+
+ private:
+  struct IndexedImage {
+    std::unique_ptr<FeatureDescriptorIndex> index;
+    // The 3D point of each row of the descriptor index.
+    std::vector<point3D_t> point3D_ids;
+  };
+
+  std::vector<image_t> RetrieveImages(
+      const FeatureKeypoints& keypoints,
+      const FeatureDescriptorsFloat& descriptors) const;
+
+  const LocalizerOptions options_;
+  const std::shared_ptr<const Reconstruction> reconstruction_;
+  std::unique_ptr<retrieval::VisualIndex> visual_index_;
+  std::vector<image_t> image_ids_;
+  std::unordered_map<image_t, IndexedImage> indexed_images_;
+};
+
+}  // namespace colmap
@@ -0,0 +1,169 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/controllers/localizer.h"
+
+#include "colmap/geometry/rigid3_matchers.h"
+#include "colmap/math/random.h"
+#include "colmap/scene/database_sqlite.h"
+#include "colmap/scene/synthetic.h"
+#include "colmap/util/threading.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+std::shared_ptr<Reconstruction> CreateSyntheticReconstruction(
+    Database* database) {
+  SetPRNGSeed(1);
+  auto reconstruction = std::make_shared<Reconstruction>();
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 5;
+  synthetic_dataset_options.num_points3D = 100;
+  synthetic_dataset_options.camera_has_prior_focal_length = true;
+  SynthesizeDataset(
+      synthetic_dataset_options, reconstruction.get(), database);
+  return reconstruction;
+}
+
+void ExpectLocalizesImages(const Localizer& localizer,
+                           const Database& database) {
+  const Reconstruction& reconstruction = localizer.GetReconstruction();
+  for (const image_t image_id : reconstruction.RegImageIds()) {
+    const Image& image = reconstruction.Image(image_id);
+    const std::optional<LocalizationResult> result =
+        localizer.Localize(*image.CameraPtr(),
+                           database.ReadKeypoints(image_id),
+                           database.ReadDescriptors(image_id));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_GE(result->num_inliers, image.NumPoints3D());
+    EXPECT_EQ(result->inlier_correspondences.size(), result->num_inliers);
+    EXPECT_THAT(result->cam_from_world,
+                Rigid3dNear(image.CamFromWorld(), 1e-6, 1e-6));
+    for (const auto& [point2D_idx, point3D_id] :
+         result->inlier_correspondences) {
+      if (image.Point2D(point2D_idx).HasPoint3D()) {
+        EXPECT_EQ(image.Point2D(point2D_idx).point3D_id, point3D_id);
+      }
+    }
+  }
+}
+
+TEST(LocalizerOptions, Check) {
+  LocalizerOptions options;
+  EXPECT_TRUE(options.Check());
+  options.max_ratio = 0;
+  EXPECT_FALSE(options.Check());
+  options.max_ratio = 0.8;
+  options.num_images = 0;
+  EXPECT_FALSE(options.Check());
+}
+
+TEST(Localizer, WithoutVisualIndex) {
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  auto reconstruction = CreateSyntheticReconstruction(database.get());
+  const Localizer localizer(LocalizerOptions(), reconstruction, *database);
+  ExpectLocalizesImages(localizer, *database);
+}
+
+TEST(Localizer, WithVisualIndex) {
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  auto reconstruction = CreateSyntheticReconstruction(database.get());
+
+  auto visual_index = retrieval::VisualIndex::Create();
+  retrieval::VisualIndex::BuildOptions build_options;
+  // Keep test runtimes low.
+  build_options.num_visual_words = 5;
+  build_options.num_iterations = 10;
+  build_options.num_rounds = 1;
+  visual_index->Build(build_options,
+                      database->ReadDescriptors(1).ToFloat());
+
+  const Localizer localizer(
+      LocalizerOptions(), reconstruction, *database, std::move(visual_index));
+  ExpectLocalizesImages(localizer, *database);
+}
+
+TEST(Localizer, UnknownImage) {
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  auto reconstruction = CreateSyntheticReconstruction(database.get());
+  const Localizer localizer(LocalizerOptions(), reconstruction, *database);
+
+  const Image& image = reconstruction->Image(1);
+  FeatureDescriptors descriptors = database->ReadDescriptors(1);
+  descriptors.data.setRandom();
+  EXPECT_FALSE(localizer
+                   .Localize(*image.CameraPtr(),
+                             database->ReadKeypoints(1),
+                             descriptors)
+                   .has_value());
+}
+
+TEST(Localizer, ConcurrentQueries) {
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  auto reconstruction = CreateSyntheticReconstruction(database.get());
+  const Localizer localizer(LocalizerOptions(), reconstruction, *database);
+
+  const std::vector<image_t> image_ids = reconstruction->RegImageIds();
+  std::vector<FeatureKeypoints> keypoints;
+  std::vector<FeatureDescriptors> descriptors;
+  for (const image_t image_id : image_ids) {
+    keypoints.push_back(database->ReadKeypoints(image_id));
+    descriptors.push_back(database->ReadDescriptors(image_id));
+  }
+
+  constexpr int kNumQueriesPerImage = 4;
+  std::vector<std::optional<LocalizationResult>> results(
+      kNumQueriesPerImage * image_ids.size());
+  ThreadPool thread_pool(4);
+  for (size_t i = 0; i < results.size(); ++i) {
+    thread_pool.AddTask([&, i]() {
+      const size_t image_idx = i % image_ids.size();
+      const Image& image = reconstruction->Image(image_ids[image_idx]);
+      results[i] = localizer.Localize(
+          *image.CameraPtr(), keypoints[image_idx], descriptors[image_idx]);
+    });
+  }
+  thread_pool.Wait();
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Image& image =
+        reconstruction->Image(image_ids[i % image_ids.size()]);
+    ASSERT_TRUE(results[i].has_value());
+    EXPECT_THAT(results[i]->cam_from_world,
+                Rigid3dNear(image.CamFromWorld(), 1e-6, 1e-6));
+  }
+}
+
+}  // namespace
+}  // namespace colmap
@@ -29,55 +29,273 @@
 
 #include "colmap/controllers/matcher_cache.h"
 
+#include "colmap/util/endian.h"
+#include "colmap/util/file.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+
 namespace colmap {
+namespace {
+
+// The spill files only live on the local machine, so that the features are
+// written in native byte order without any encoding.
+
+void WriteSpilledKeypoints(const FeatureKeypoints& keypoints,
+                           std::ostream* stream) {
+  static_assert(std::is_trivially_copyable_v<FeatureKeypoint>);
+  const uint64_t num_keypoints = keypoints.size();
+  stream->write(reinterpret_cast<const char*>(&num_keypoints),
+                sizeof(num_keypoints));
+  stream->write(reinterpret_cast<const char*>(keypoints.data()),
+                num_keypoints * sizeof(FeatureKeypoint));
+}
+
+std::shared_ptr<FeatureKeypoints> ReadSpilledKeypoints(std::istream* stream) {
+  uint64_t num_keypoints = 0;
+  stream->read(reinterpret_cast<char*>(&num_keypoints), sizeof(num_keypoints));
+  auto keypoints = std::make_shared<FeatureKeypoints>(num_keypoints);
+  stream->read(reinterpret_cast<char*>(keypoints->data()),
+               num_keypoints * sizeof(FeatureKeypoint));
+  THROW_CHECK(stream->good()) << "Failed to read spilled keypoints";
+  return keypoints;
+}
+
+void WriteSpilledDescriptors(const FeatureDescriptors& descriptors,
+                             std::ostream* stream) {
+  const std::array<int64_t, 4> header = {
+      static_cast<int64_t>(descriptors.type),
+      static_cast<int64_t>(descriptors.precision),
+      static_cast<int64_t>(descriptors.data.rows()),
+      static_cast<int64_t>(descriptors.data.cols())};
+  stream->write(reinterpret_cast<const char*>(header.data()),
+                sizeof(header));
+  stream->write(reinterpret_cast<const char*>(descriptors.data.data()),
+                descriptors.data.size());
+}
+
+std::shared_ptr<FeatureDescriptors> ReadSpilledDescriptors(
+    std::istream* stream) {
+  std::array<int64_t, 4> header;
+  stream->read(reinterpret_cast<char*>(header.data()), sizeof(header));
+  THROW_CHECK(stream->good()) << "Failed to read spilled descriptors";
+  auto descriptors = std::make_shared<FeatureDescriptors>(
+      static_cast<FeatureExtractorType>(header[0]),
+      FeatureDescriptorsData(header[2], header[3]),
+      static_cast<FeatureDescriptorPrecision>(header[1]));
+  stream->read(reinterpret_cast<char*>(descriptors->data.data()),
+               descriptors->data.size());
+  THROW_CHECK(stream->good()) << "Failed to read spilled descriptors";
+  return descriptors;
+}
+
+// Adds the lifetime of the timer to the given total in microseconds.
+class ScopedWaitTimer {
+ public:
+  explicit ScopedWaitTimer(std::atomic<int64_t>* total_us)
+      : total_us_(total_us), start_time_(std::chrono::steady_clock::now()) {}
+
+  ~ScopedWaitTimer() {
+    total_us_->fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - start_time_)
+                             .count(),
+                         std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<int64_t>* total_us_;
+  const std::chrono::steady_clock::time_point start_time_;
+};
+
+}  // namespace
 
 FeatureMatcherCache::FeatureMatcherCache(
-    const size_t cache_size, const std::shared_ptr<Database>& database)
+    const size_t cache_size,
+    const std::shared_ptr<Database>& database,
+    const size_t max_num_pending_writes,
+    std::shared_ptr<DatabaseReadPool> read_pool,
+    const size_t max_num_feature_bytes,
+    const std::filesystem::path& spill_cache_path,
+    const size_t max_num_spill_bytes)
     : cache_size_(cache_size),
       database_(THROW_CHECK_NOTNULL(database)),
+      read_pool_(std::move(read_pool)),
+      max_num_pending_writes_(max_num_pending_writes),
       descriptor_index_cache_(cache_size_, [this](const image_t image_id) {
-        auto descriptors = GetDescriptors(image_id);
-        auto index = FeatureDescriptorIndex::Create();
-        index->Build(descriptors->ToFloat());
-        return index;
+        return LoadFeatureDescriptorIndex(image_id);
       }) {
-  keypoints_cache_ =
-      std::make_unique<ThreadSafeLRUCache<image_t, FeatureKeypoints>>(
-          cache_size_, [this](const image_t image_id) {
-            std::lock_guard<std::mutex> lock(database_mutex_);
-            return std::make_shared<FeatureKeypoints>(
-                database_->ReadKeypoints(image_id));
-          });
-
-  descriptors_cache_ =
-      std::make_unique<ThreadSafeLRUCache<image_t, FeatureDescriptors>>(
-          cache_size_, [this](const image_t image_id) {
-            std::lock_guard<std::mutex> lock(database_mutex_);
-            return std::make_shared<FeatureDescriptors>(
-                database_->ReadDescriptors(image_id));
-          });
+  // Without a memory limit, every image counts as one byte, such that the
+  // caches are limited by the number of images. Otherwise, the descriptors,
+  // which typically dominate the memory, get four fifths of the limit.
+  // Each shard evicts independently against its share of the limit, so the
+  // count-limited caches use a single shard to keep exactly cache_size images.
+  const bool limit_bytes = max_num_feature_bytes > 0;
+  const size_t num_cache_shards = limit_bytes ? 16 : 1;
+  const size_t max_num_keypoints_bytes =
+      limit_bytes ? std::max<size_t>(max_num_feature_bytes / 5, 1)
+                  : cache_size_;
+  const size_t max_num_descriptors_bytes =
+      limit_bytes ? std::max<size_t>(
+                        max_num_feature_bytes - max_num_feature_bytes / 5, 1)
+                  : cache_size_;
+
+  keypoints_cache_ = std::make_unique<
+      ThreadSafeMemoryConstrainedLRUCache<image_t, FeatureKeypoints>>(
+      max_num_keypoints_bytes,
+      [this](const image_t image_id) {
+        if (keypoints_spill_cache_) {
+          if (auto keypoints = keypoints_spill_cache_->Get(image_id)) {
+            return keypoints;
+          }
+        }
+        auto keypoints = std::make_shared<FeatureKeypoints>();
+        ReadFeatures([&](const Database& database) {
+          *keypoints = database.ReadKeypoints(image_id);
+        });
+        return keypoints;
+      },
+      [limit_bytes](const FeatureKeypoints& keypoints) -> size_t {
+        return limit_bytes ? keypoints.size() * sizeof(FeatureKeypoint) : 1;
+      },
+      num_cache_shards);
+
+  descriptors_cache_ = std::make_unique<
+      ThreadSafeMemoryConstrainedLRUCache<image_t, FeatureDescriptors>>(
+      max_num_descriptors_bytes,
+      [this](const image_t image_id) {
+        if (descriptors_spill_cache_) {
+          if (auto descriptors = descriptors_spill_cache_->Get(image_id)) {
+            return descriptors;
+          }
+        }
+        auto descriptors = std::make_shared<FeatureDescriptors>();
+        ReadFeatures([&](const Database& database) {
+          *descriptors = database.ReadDescriptors(image_id);
+        });
+        return descriptors;
+      },
+      [limit_bytes](const FeatureDescriptors& descriptors) -> size_t {
+        return limit_bytes ? descriptors.data.size() : 1;
+      },
+      num_cache_shards);
+
+  // Features evicted from memory are spilled into local files, from which they
+  // are read on the next miss instead of from the database.
+  if (!spill_cache_path.empty() && max_num_spill_bytes > 0) {
+    keypoints_spill_cache_ =
+        std::make_unique<FileSpillCache<image_t, FeatureKeypoints>>(
+            spill_cache_path / "keypoints",
+            std::max<size_t>(max_num_spill_bytes / 5, 1),
+            WriteSpilledKeypoints,
+            ReadSpilledKeypoints);
+    descriptors_spill_cache_ =
+        std::make_unique<FileSpillCache<image_t, FeatureDescriptors>>(
+            spill_cache_path / "descriptors",
+            std::max<size_t>(max_num_spill_bytes - max_num_spill_bytes / 5, 1),
+            WriteSpilledDescriptors,
+            ReadSpilledDescriptors);
+    keypoints_cache_->SetEvictFn(
+        [this](const image_t image_id,
+               const std::shared_ptr<FeatureKeypoints>& keypoints) {
+          keypoints_spill_cache_->Put(image_id, *keypoints);
+        });
+    descriptors_cache_->SetEvictFn(
+        [this](const image_t image_id,
+               const std::shared_ptr<FeatureDescriptors>& descriptors) {
+          descriptors_spill_cache_->Put(image_id, *descriptors);
+        });
+  }
 
   keypoints_exists_cache_ = std::make_unique<ThreadSafeLRUCache<image_t, bool>>(
       cache_size_, [this](const image_t image_id) {
-        std::lock_guard<std::mutex> lock(database_mutex_);
-        return std::make_shared<bool>(database_->ExistsKeypoints(image_id));
+        auto exists = std::make_shared<bool>(false);
+        ReadFeatures([&](const Database& database) {
+          *exists = database.ExistsKeypoints(image_id);
+        });
+        return exists;
       });
 
   descriptors_exists_cache_ =
       std::make_unique<ThreadSafeLRUCache<image_t, bool>>(
           cache_size_, [this](const image_t image_id) {
-            std::lock_guard<std::mutex> lock(database_mutex_);
-            return std::make_shared<bool>(
-                database_->ExistsDescriptors(image_id));
+            auto exists = std::make_shared<bool>(false);
+            ReadFeatures([&](const Database& database) {
+              *exists = database.ExistsDescriptors(image_id);
+            });
+            return exists;
           });
+
+  metric_fns_.push_back(std::make_unique<ScopedMetricFn>(
+      "colmap_feature_cache_hits_total{cache=\"keypoints\"}",
+      MetricType::kCounter,
+      [this]() { return keypoints_cache_->NumHits(); }));
+  metric_fns_.push_back(std::make_unique<ScopedMetricFn>(
+      "colmap_feature_cache_misses_total{cache=\"keypoints\"}",
+      MetricType::kCounter,
+      [this]() { return keypoints_cache_->NumMisses(); }));
+  metric_fns_.push_back(std::make_unique<ScopedMetricFn>(
+      "colmap_feature_cache_hits_total{cache=\"descriptors\"}",
+      MetricType::kCounter,
+      [this]() { return descriptors_cache_->NumHits(); }));
+  metric_fns_.push_back(std::make_unique<ScopedMetricFn>(
+      "colmap_feature_cache_misses_total{cache=\"descriptors\"}",
+      MetricType::kCounter,
+      [this]() { return descriptors_cache_->NumMisses(); }));
+  metric_fns_.push_back(std::make_unique<ScopedMetricFn>(
+      "colmap_feature_cache_database_wait_seconds_total",
+      MetricType::kCounter,
+      [this]() { return GetStats().database_wait_time_sec; }));
+
+  if (max_num_pending_writes_ > 0) {
+    writer_thread_ = std::thread(&FeatureMatcherCache::RunWriter, this);
+  }
+}
+
+FeatureMatcherCache::~FeatureMatcherCache() {
+  if (!writer_thread_.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    stop_writer_ = true;
+  }
+  writer_pop_condition_.notify_all();
+  // The writer commits all pending writes before it returns.
+  writer_thread_.join();
+
+  if (writer_exception_) {
+    try {
+      std::rethrow_exception(writer_exception_);
+    } catch (const std::exception& exception) {
+      LOG(ERROR) << "Failed to write matches: " << exception.what();
+    }
+  }
 }
 
 void FeatureMatcherCache::AccessDatabase(
     const std::function<void(Database& database)>& func) {
+  FlushWrites();
+  ScopedWaitTimer wait_timer(&database_wait_time_us_);
   std::lock_guard<std::mutex> lock(database_mutex_);
   func(*database_);
 }
 
+void FeatureMatcherCache::FlushWrites() {
+  ScopedWaitTimer wait_timer(&database_wait_time_us_);
+  std::unique_lock<std::mutex> lock(writer_mutex_);
+  writer_commit_condition_.wait(
+      lock, [this]() { return num_uncommitted_writes_ == 0; });
+  if (writer_exception_) {
+    std::rethrow_exception(writer_exception_);
+  }
+}
+
 const Camera& FeatureMatcherCache::GetCamera(const camera_t camera_id) {
   MaybeLoadCameras();
   return cameras_cache_->at(camera_id);
@@ -114,14 +332,123 @@ std::shared_ptr<FeatureDescriptors> FeatureMatcherCache::GetDescriptors(
   return descriptors_cache_->Get(image_id);
 }
 
+void FeatureMatcherCache::SetFeatureDescriptorIndexPath(
+    const std::filesystem::path& path) {
+  if (!path.empty()) {
+    CreateDirIfNotExists(path, /*recursive=*/true);
+  }
+  descriptor_index_path_ = path;
+}
+
+std::unique_ptr<FeatureDescriptorIndex>
+FeatureMatcherCache::LoadFeatureDescriptorIndex(const image_t image_id) {
+  auto descriptors = GetDescriptors(image_id);
+  auto index = FeatureDescriptorIndex::Create();
+  if (descriptor_index_path_.empty()) {
+    index->Build(descriptors->ToFloat());
+    return index;
+  }
+
+  // The persisted index is identified by the descriptors it was built from.
+  const uint64_t descriptors_hash = ComputeFNV1aHash(std::string_view(
+      reinterpret_cast<const char*>(descriptors->data.data()),
+      descriptors->data.size()));
+  const std::array<uint64_t, 5> header = {
+      descriptors_hash,
+      static_cast<uint64_t>(descriptors->type),
+      static_cast<uint64_t>(descriptors->precision),
+      static_cast<uint64_t>(descriptors->data.rows()),
+      static_cast<uint64_t>(descriptors->data.cols())};
+
+  const std::filesystem::path path =
+      descriptor_index_path_ / (std::to_string(image_id) + ".bin");
+  {
+    std::ifstream file(path, std::ios::binary);
+    if (file.is_open()) {
+      std::array<uint64_t, 5> file_header;
+      for (uint64_t& value : file_header) {
+        value = ReadBinaryLittleEndian<uint64_t>(&file);
+      }
+      if (file.good() && file_header == header) {
+        index->Read(&file);
+        return index;
+      }
+    }
+  }
+
+  index->Build(descriptors->ToFloat());
+
+  // Write to a temporary file first, so that concurrent matching processes
+  // never read a partially written index.
+  const std::filesystem::path tmp_path =
+      path.string() + "." +
+      std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                     static_cast<size_t>(std::chrono::steady_clock::now()
+                                             .time_since_epoch()
+                                             .count())) +
+      ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary);
+    THROW_CHECK_FILE_OPEN(file, tmp_path);
+    for (const uint64_t value : header) {
+      WriteBinaryLittleEndian<uint64_t>(&file, value);
+    }
+    index->Write(&file);
+  }
+  std::filesystem::rename(tmp_path, path);
+
+  return index;
+}
+
+void FeatureMatcherCache::PrefetchFeatures(
+    const std::vector<image_t>& image_ids) {
+  std::vector<image_t> missing_image_ids;
+  missing_image_ids.reserve(std::min(image_ids.size(), cache_size_));
+  std::unordered_set<image_t> unique_image_ids;
+  for (const image_t image_id : image_ids) {
+    if (missing_image_ids.size() >= cache_size_) {
+      break;
+    }
+    if (unique_image_ids.insert(image_id).second &&
+        (!keypoints_cache_->Exists(image_id) ||
+         !descriptors_cache_->Exists(image_id))) {
+      missing_image_ids.push_back(image_id);
+    }
+  }
+
+  if (missing_image_ids.empty()) {
+    return;
+  }
+
+  std::vector<FeatureKeypoints> keypoints;
+  std::vector<FeatureDescriptors> descriptors;
+  ReadFeatures([&](const Database& database) {
+    const span<const image_t> missing_image_ids_span(missing_image_ids.data(),
+                                                     missing_image_ids.size());
+    keypoints = database.ReadKeypoints(missing_image_ids_span);
+    descriptors = database.ReadDescriptors(missing_image_ids_span);
+  });
+
+  for (size_t i = 0; i < missing_image_ids.size(); ++i) {
+    keypoints_cache_->Insert(
+        missing_image_ids[i],
+        std::make_shared<FeatureKeypoints>(std::move(keypoints[i])));
+    descriptors_cache_->Insert(
+        missing_image_ids[i],
+        std::make_shared<FeatureDescriptors>(std::move(descriptors[i])));
+  }
+}
+
 FeatureMatches FeatureMatcherCache::GetMatches(const image_t image_id1,
                                                const image_t image_id2) {
+  MaybeFlushWrites(image_id1, image_id2);
   std::lock_guard<std::mutex> lock(database_mutex_);
   return database_->ReadMatches(image_id1, image_id2);
 }
 
 TwoViewGeometry FeatureMatcherCache::GetTwoViewGeometry(
     const image_t image_id1, const image_t image_id2) {
+  MaybeFlushWrites(image_id1, image_id2);
   std::lock_guard<std::mutex> lock(database_mutex_);
   return database_->ReadTwoViewGeometry(image_id1, image_id2);
 }
@@ -171,18 +498,33 @@ bool FeatureMatcherCache::ExistsDescriptors(const image_t image_id) {
 
 bool FeatureMatcherCache::ExistsMatches(const image_t image_id1,
                                         const image_t image_id2) {
+  {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    if (pending_matches_pair_ids_.count(
+            ImagePairToPairId(image_id1, image_id2)) > 0) {
+      return true;
+    }
+  }
   std::lock_guard<std::mutex> lock(database_mutex_);
   return database_->ExistsMatches(image_id1, image_id2);
 }
 
 bool FeatureMatcherCache::ExistsTwoViewGeometry(const image_t image_id1,
                                                 const image_t image_id2) {
+  {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    if (pending_two_view_geometry_pair_ids_.count(
+            ImagePairToPairId(image_id1, image_id2)) > 0) {
+      return true;
+    }
+  }
   std::lock_guard<std::mutex> lock(database_mutex_);
   return database_->ExistsTwoViewGeometry(image_id1, image_id2);
 }
 
 bool FeatureMatcherCache::ExistsInlierMatches(const image_t image_id1,
                                               const image_t image_id2) {
+  MaybeFlushWrites(image_id1, image_id2);
   std::lock_guard<std::mutex> lock(database_mutex_);
   if (!database_->ExistsTwoViewGeometry(image_id1, image_id2)) {
     return false;
@@ -195,6 +537,7 @@ void FeatureMatcherCache::UpdateTwoViewGeometry(
     const image_t image_id1,
     const image_t image_id2,
     const TwoViewGeometry& two_view_geometry) {
+  MaybeFlushWrites(image_id1, image_id2);
   std::lock_guard<std::mutex> lock(database_mutex_);
   database_->UpdateTwoViewGeometry(image_id1, image_id2, two_view_geometry);
 }
@@ -202,6 +545,14 @@ void FeatureMatcherCache::UpdateTwoViewGeometry(
 void FeatureMatcherCache::WriteMatches(const image_t image_id1,
                                        const image_t image_id2,
                                        const FeatureMatches& matches) {
+  if (max_num_pending_writes_ > 0) {
+    PendingWrite write;
+    write.image_id1 = image_id1;
+    write.image_id2 = image_id2;
+    write.matches = matches;
+    PushPendingWrite(std::move(write));
+    return;
+  }
   std::lock_guard<std::mutex> lock(database_mutex_);
   database_->WriteMatches(image_id1, image_id2, matches);
 }
@@ -210,24 +561,35 @@ void FeatureMatcherCache::WriteTwoViewGeometry(
     const image_t image_id1,
     const image_t image_id2,
     const TwoViewGeometry& two_view_geometry) {
+  if (max_num_pending_writes_ > 0) {
+    PendingWrite write;
+    write.image_id1 = image_id1;
+    write.image_id2 = image_id2;
+    write.two_view_geometry = two_view_geometry;
+    PushPendingWrite(std::move(write));
+    return;
+  }
   std::lock_guard<std::mutex> lock(database_mutex_);
   database_->WriteTwoViewGeometry(image_id1, image_id2, two_view_geometry);
 }
 
 void FeatureMatcherCache::DeleteMatches(const image_t image_id1,
                                         const image_t image_id2) {
+  MaybeFlushWrites(image_id1, image_id2);
   std::lock_guard<std::mutex> lock(database_mutex_);
   database_->DeleteMatches(image_id1, image_id2);
 }
 
 void FeatureMatcherCache::DeleteTwoViewGeometry(const image_t image_id1,
                                                 const image_t image_id2) {
+  MaybeFlushWrites(image_id1, image_id2);
   std::lock_guard<std::mutex> lock(database_mutex_);
   database_->DeleteTwoViewGeometry(image_id1, image_id2);
 }
 
 void FeatureMatcherCache::DeleteInlierMatches(const image_t image_id1,
                                               const image_t image_id2) {
+  MaybeFlushWrites(image_id1, image_id2);
   std::lock_guard<std::mutex> lock(database_mutex_);
   database_->DeleteInlierMatches(image_id1, image_id2);
 }
@@ -240,6 +602,17 @@ size_t FeatureMatcherCache::MaxNumKeypoints() {
   return *max_num_keypoints_;
 }
 
+FeatureMatcherCache::Stats FeatureMatcherCache::GetStats() const {
+  Stats stats;
+  stats.num_keypoints_hits = keypoints_cache_->NumHits();
+  stats.num_keypoints_misses = keypoints_cache_->NumMisses();
+  stats.num_descriptors_hits = descriptors_cache_->NumHits();
+  stats.num_descriptors_misses = descriptors_cache_->NumMisses();
+  stats.database_wait_time_sec =
+      1e-6 * database_wait_time_us_.load(std::memory_order_relaxed);
+  return stats;
+}
+
 void FeatureMatcherCache::MaybeLoadCameras() {
   std::lock_guard<std::mutex> lock(database_mutex_);
   if (cameras_cache_) {
@@ -307,4 +680,109 @@ void FeatureMatcherCache::MaybeLoadPosePriors() {
   }
 }
 
+void FeatureMatcherCache::ReadFeatures(
+    const std::function<void(const Database& database)>& func) {
+  ScopedWaitTimer wait_timer(&database_wait_time_us_);
+  if (read_pool_) {
+    read_pool_->Read(func);
+  } else {
+    std::lock_guard<std::mutex> lock(database_mutex_);
+    func(*database_);
+  }
+}
+
+void FeatureMatcherCache::PushPendingWrite(PendingWrite write) {
+  const image_pair_t pair_id =
+      ImagePairToPairId(write.image_id1, write.image_id2);
+  {
+    ScopedWaitTimer wait_timer(&database_wait_time_us_);
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    writer_push_condition_.wait(lock, [this]() {
+      return pending_writes_.size() < max_num_pending_writes_;
+    });
+    if (writer_exception_) {
+      std::rethrow_exception(writer_exception_);
+    }
+    if (write.matches) {
+      pending_matches_pair_ids_.insert(pair_id);
+    }
+    if (write.two_view_geometry) {
+      pending_two_view_geometry_pair_ids_.insert(pair_id);
+    }
+    pending_writes_.push_back(std::move(write));
+    num_uncommitted_writes_ += 1;
+  }
+  writer_pop_condition_.notify_one();
+}
+
+void FeatureMatcherCache::MaybeFlushWrites(const image_t image_id1,
+                                           const image_t image_id2) {
+  const image_pair_t pair_id = ImagePairToPairId(image_id1, image_id2);
+  ScopedWaitTimer wait_timer(&database_wait_time_us_);
+  std::unique_lock<std::mutex> lock(writer_mutex_);
+  writer_commit_condition_.wait(lock, [this, pair_id]() {
+    return pending_matches_pair_ids_.count(pair_id) == 0 &&
+           pending_two_view_geometry_pair_ids_.count(pair_id) == 0;
+  });
+  if (writer_exception_) {
+    std::rethrow_exception(writer_exception_);
+  }
+}
+
+void FeatureMatcherCache::RunWriter() {
+  std::vector<PendingWrite> writes;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(writer_mutex_);
+      writer_pop_condition_.wait(
+          lock, [this]() { return stop_writer_ || !pending_writes_.empty(); });
+      if (pending_writes_.empty()) {
+        return;
+      }
+      // Take all pending writes at once to commit them in one transaction.
+      std::swap(writes, pending_writes_);
+    }
+    writer_push_condition_.notify_all();
+
+    try {
+      std::lock_guard<std::mutex> lock(database_mutex_);
+      // After a failed write, drop all later writes until the cache is
+      // destructed.
+      if (!writer_exception_) {
+        DatabaseTransaction database_transaction(database_.get());
+        for (const PendingWrite& write : writes) {
+          if (write.matches) {
+            database_->WriteMatches(
+                write.image_id1, write.image_id2, *write.matches);
+          }
+          if (write.two_view_geometry) {
+            database_->WriteTwoViewGeometry(
+                write.image_id1, write.image_id2, *write.two_view_geometry);
+          }
+        }
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(writer_mutex_);
+      writer_exception_ = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(writer_mutex_);
+      for (const PendingWrite& write : writes) {
+        const image_pair_t pair_id =
+            ImagePairToPairId(write.image_id1, write.image_id2);
+        if (write.matches) {
+          pending_matches_pair_ids_.erase(pair_id);
+        }
+        if (write.two_view_geometry) {
+          pending_two_view_geometry_pair_ids_.erase(pair_id);
+        }
+      }
+      num_uncommitted_writes_ -= writes.size();
+    }
+    writer_commit_condition_.notify_all();
+    writes.clear();
+  }
+}
+
 }  // namespace colmap
@@ -36,31 +36,75 @@
 #include "colmap/scene/image.h"
 #include "colmap/scene/two_view_geometry.h"
 #include "colmap/util/cache.h"
+#include "colmap/util/metrics.h"
 #include "colmap/util/types.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace colmap {
 
 // Cache for feature matching to minimize database access during matching.
+//
+// If max_num_pending_writes > 0, matches and two-view geometries are written
+// asynchronously by a dedicated writer thread, which groups all pending writes
+// into one database transaction. Writers block once max_num_pending_writes
+// entries are pending. Reads of image pairs with pending writes and direct
+// database access wait for the pending writes to be committed. Note that the
+// database must then not be in an active transaction while matching.
+//
+// If a read pool is given, cache misses of keypoints and descriptors are read
+// concurrently through the read-only connections of the pool instead of
+// sequentially through the shared database.
+//
+// The keypoints and descriptors of at most cache_size images are cached. If
+// max_num_feature_bytes > 0, they are instead cached up to the given memory,
+// such that images with many features take up a larger share of the cache.
+// The memory-limited caches are split into independently locked shards, each
+// of which evicts against its share of the memory.
+// If a spill cache path is given, features evicted from memory are written
+// into files up to max_num_spill_bytes, e.g., on a local SSD, and served from
+// there on later misses instead of from the database.
 class FeatureMatcherCache {
  public:
   FeatureMatcherCache(size_t cache_size,
-                      const std::shared_ptr<Database>& database);
+                      const std::shared_ptr<Database>& database,
+                      size_t max_num_pending_writes = 0,
+                      std::shared_ptr<DatabaseReadPool> read_pool = nullptr,
+                      size_t max_num_feature_bytes = 0,
+                      const std::filesystem::path& spill_cache_path = "",
+                      size_t max_num_spill_bytes = 0);
+
+  ~FeatureMatcherCache();
 
   // Executes a function that accesses the database. This function is thread
   // safe and ensures that only one function can access the database at a time.
   void AccessDatabase(const std::function<void(Database& database)>& func);
 
+  // Blocks until all pending writes are committed to the database. Rethrows
+  // the first exception raised by the writer thread, if any.
+  void FlushWrites();
+
   const Camera& GetCamera(camera_t camera_id);
   const Frame& GetFrame(frame_t frame_id);
   const Image& GetImage(image_t image_id);
   const PosePrior* FindImagePosePriorOrNull(image_t image_id);
   std::shared_ptr<FeatureKeypoints> GetKeypoints(image_t image_id);
   std::shared_ptr<FeatureDescriptors> GetDescriptors(image_t image_id);
+
+  // Load the keypoints and descriptors of the given images into the cache with
+  // batched database reads. Images that are already cached are skipped and at
+  // most as many images as fit into the cache are loaded.
+  void PrefetchFeatures(const std::vector<image_t>& image_ids);
   FeatureMatches GetMatches(image_t image_id1, image_t image_id2);
   TwoViewGeometry GetTwoViewGeometry(image_t image_id1, image_t image_id2);
   std::vector<frame_t> GetFrameIds();
@@ -68,6 +112,12 @@ class FeatureMatcherCache {
   ThreadSafeLRUCache<image_t, FeatureDescriptorIndex>&
   GetFeatureDescriptorIndexCache();
 
+  // Sets the directory in which the built feature descriptor indices are
+  // persisted, so that later runs read them instead of training them again.
+  // Persisted indices are only used if the descriptors of the image did not
+  // change. Must be set before the descriptor index cache is used.
+  void SetFeatureDescriptorIndexPath(const std::filesystem::path& path);
+
   bool ExistsKeypoints(image_t image_id);
   bool ExistsDescriptors(image_t image_id);
 
@@ -92,27 +142,85 @@ class FeatureMatcherCache {
 
   size_t MaxNumKeypoints();
 
+  // Statistics of the cache since its construction.
+  struct Stats {
+    size_t num_keypoints_hits = 0;
+    size_t num_keypoints_misses = 0;
+    size_t num_descriptors_hits = 0;
+    size_t num_descriptors_misses = 0;
+    // Time spent by the calling threads in reading features, accessing the
+    // database, and waiting for pending writes, summed over all threads.
+    double database_wait_time_sec = 0;
+  };
+
+  Stats GetStats() const;
+
  private:
+  struct PendingWrite {
+    image_t image_id1 = kInvalidImageId;
+    image_t image_id2 = kInvalidImageId;
+    std::optional<FeatureMatches> matches;
+    std::optional<TwoViewGeometry> two_view_geometry;
+  };
+
   void MaybeLoadCameras();
   void MaybeLoadFrames();
   void MaybeLoadImages();
   void MaybeLoadPosePriors();
 
+  std::unique_ptr<FeatureDescriptorIndex> LoadFeatureDescriptorIndex(
+      image_t image_id);
+
+  // Executes a function that only reads features from the database.
+  void ReadFeatures(const std::function<void(const Database& database)>& func);
+
+  void PushPendingWrite(PendingWrite write);
+  // Blocks until the pending writes of the given image pair are committed.
+  void MaybeFlushWrites(image_t image_id1, image_t image_id2);
+  void RunWriter();
+
   const size_t cache_size_;
   const std::shared_ptr<Database> database_;
   std::mutex database_mutex_;
+  const std::shared_ptr<DatabaseReadPool> read_pool_;
+
+  const size_t max_num_pending_writes_;
+  std::thread writer_thread_;
+  std::mutex writer_mutex_;
+  std::condition_variable writer_push_condition_;
+  std::condition_variable writer_pop_condition_;
+  std::condition_variable writer_commit_condition_;
+  std::vector<PendingWrite> pending_writes_;
+  // Pairs with queued or uncommitted matches / two-view geometries.
+  std::unordered_set<image_pair_t> pending_matches_pair_ids_;
+  std::unordered_set<image_pair_t> pending_two_view_geometry_pair_ids_;
+  size_t num_uncommitted_writes_ = 0;
+  bool stop_writer_ = false;
+  std::exception_ptr writer_exception_;
+
   std::unique_ptr<std::unordered_map<camera_t, Camera>> cameras_cache_;
   std::unique_ptr<std::unordered_map<frame_t, Frame>> frames_cache_;
   std::unique_ptr<std::unordered_map<image_t, Image>> images_cache_;
   std::unique_ptr<std::unordered_map<image_t, PosePrior>> pose_priors_cache_;
-  std::unique_ptr<ThreadSafeLRUCache<image_t, FeatureKeypoints>>
+  std::unique_ptr<
+      ThreadSafeMemoryConstrainedLRUCache<image_t, FeatureKeypoints>>
       keypoints_cache_;
-  std::unique_ptr<ThreadSafeLRUCache<image_t, FeatureDescriptors>>
+  std::unique_ptr<
+      ThreadSafeMemoryConstrainedLRUCache<image_t, FeatureDescriptors>>
       descriptors_cache_;
+  std::unique_ptr<FileSpillCache<image_t, FeatureKeypoints>>
+      keypoints_spill_cache_;
+  std::unique_ptr<FileSpillCache<image_t, FeatureDescriptors>>
+      descriptors_spill_cache_;
   std::unique_ptr<ThreadSafeLRUCache<image_t, bool>> keypoints_exists_cache_;
   std::unique_ptr<ThreadSafeLRUCache<image_t, bool>> descriptors_exists_cache_;
   ThreadSafeLRUCache<image_t, FeatureDescriptorIndex> descriptor_index_cache_;
+  std::filesystem::path descriptor_index_path_;
   std::optional<size_t> max_num_keypoints_;
+  std::atomic<int64_t> database_wait_time_us_{0};
+  // Declared last, so that the metrics are unregistered before the caches
+  // are destroyed.
+  std::vector<std::unique_ptr<ScopedMetricFn>> metric_fns_;
 };
 
 }  // namespace colmap
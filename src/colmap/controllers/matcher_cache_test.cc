@@ -32,6 +32,8 @@
 #include "colmap/scene/synthetic.h"
 #include "colmap/util/testing.h"
 
+#include <thread>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -39,6 +41,7 @@ namespace colmap {
 namespace {
 
 struct TestData {
+  std::filesystem::path database_path;
   std::shared_ptr<Database> database;
   Reconstruction reconstruction;
 };
@@ -48,8 +51,8 @@ TestData CreateTestData(int num_images,
                         int num_cameras_per_rig = 1) {
   TestData data;
   const auto test_dir = CreateTestDir();
-  const auto database_path = test_dir / "database.db";
-  data.database = Database::Open(database_path);
+  data.database_path = test_dir / "database.db";
+  data.database = Database::Open(data.database_path);
 
   SyntheticDatasetOptions options;
   options.num_rigs = num_images / num_cameras_per_rig;
@@ -174,6 +177,106 @@ TEST(FeatureMatcherCache, Features) {
   }
 }
 
+TEST(FeatureMatcherCache, FeaturesCountLimit) {
+  auto data = CreateTestData(4);
+  FeatureMatcherCache cache(2, data.database);
+
+  const std::vector<Image> images = data.database->ReadAllImages();
+  ASSERT_EQ(images.size(), 4);
+
+  const auto keypoints = cache.GetKeypoints(images[0].ImageId());
+  const auto descriptors = cache.GetDescriptors(images[0].ImageId());
+  EXPECT_EQ(cache.GetKeypoints(images[0].ImageId()), keypoints);
+  EXPECT_EQ(cache.GetDescriptors(images[0].ImageId()), descriptors);
+
+  // The features of at most two images are cached, regardless of how the
+  // image identifiers are distributed internally.
+  for (int i = 1; i < 3; ++i) {
+    cache.GetKeypoints(images[i].ImageId());
+    cache.GetDescriptors(images[i].ImageId());
+  }
+  EXPECT_NE(cache.GetKeypoints(images[0].ImageId()), keypoints);
+  EXPECT_NE(cache.GetDescriptors(images[0].ImageId()), descriptors);
+}
+
+TEST(FeatureMatcherCache, PrefetchFeatures) {
+  auto data = CreateTestData(4);
+  FeatureMatcherCache cache(3, data.database);
+
+  std::vector<image_t> image_ids = cache.GetImageIds();
+  ASSERT_EQ(image_ids.size(), 4);
+  image_ids.push_back(image_ids.front());
+  cache.PrefetchFeatures(image_ids);
+
+  // Hide the database to verify that the features are served from the cache.
+  cache.AccessDatabase([](Database& database) { database.ClearImages(); });
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_FALSE(cache.GetKeypoints(image_ids[i])->empty());
+    EXPECT_GT(cache.GetDescriptors(image_ids[i])->data.rows(), 0);
+  }
+  EXPECT_TRUE(cache.GetKeypoints(image_ids[3])->empty());
+}
+
+TEST(FeatureMatcherCache, PersistedFeatureDescriptorIndex) {
+  auto data = CreateTestData(4);
+  const auto index_path = CreateTestDir() / "indices";
+  const std::vector<Image> images = data.database->ReadAllImages();
+  ASSERT_FALSE(images.empty());
+  const image_t image_id = images.front().ImageId();
+  const FeatureDescriptorsFloat descriptors =
+      data.database->ReadDescriptors(image_id).ToFloat();
+
+  Eigen::RowMajorMatrixXi indices;
+  Eigen::RowMajorMatrixXf distances;
+  {
+    FeatureMatcherCache cache(5, data.database);
+    cache.SetFeatureDescriptorIndexPath(index_path);
+    cache.GetFeatureDescriptorIndexCache().Get(image_id)->Search(
+        /*num_neighbors=*/1, descriptors, indices, distances);
+  }
+  EXPECT_TRUE(ExistsFile(index_path / (std::to_string(image_id) + ".bin")));
+
+  FeatureMatcherCache cache(5, data.database);
+  cache.SetFeatureDescriptorIndexPath(index_path);
+  Eigen::RowMajorMatrixXi read_indices;
+  Eigen::RowMajorMatrixXf read_distances;
+  cache.GetFeatureDescriptorIndexCache().Get(image_id)->Search(
+      /*num_neighbors=*/1, descriptors, read_indices, read_distances);
+  EXPECT_EQ(read_indices, indices);
+  EXPECT_EQ(read_distances, distances);
+}
+
+TEST(FeatureMatcherCache, ReadPool) {
+  auto data = CreateTestData(4);
+  auto read_pool = Database::OpenReadOnlyPool(data.database_path, 2);
+  ASSERT_NE(read_pool, nullptr);
+  FeatureMatcherCache cache(
+      2, data.database, /*max_num_pending_writes=*/0, read_pool);
+
+  const std::vector<image_t> image_ids = cache.GetImageIds();
+  std::vector<FeatureKeypoints> expected_keypoints;
+  std::vector<FeatureDescriptors> expected_descriptors;
+  for (const image_t image_id : image_ids) {
+    expected_keypoints.push_back(data.database->ReadKeypoints(image_id));
+    expected_descriptors.push_back(data.database->ReadDescriptors(image_id));
+  }
+
+  cache.PrefetchFeatures({image_ids[0]});
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < image_ids.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      EXPECT_TRUE(cache.ExistsKeypoints(image_ids[i]));
+      EXPECT_TRUE(cache.ExistsDescriptors(image_ids[i]));
+      EXPECT_EQ(*cache.GetKeypoints(image_ids[i]), expected_keypoints[i]);
+      EXPECT_EQ(cache.GetDescriptors(image_ids[i])->data,
+                expected_descriptors[i].data);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
 TEST(FeatureMatcherCache, Matches) {
   auto data = CreateTestData(4);
   FeatureMatcherCache cache(5, data.database);
@@ -258,6 +361,65 @@ TEST(FeatureMatcherCache, WriteAndGetTwoViewGeometry) {
   EXPECT_EQ(read_tvg.inlier_matches.size(), 10);
 }
 
+TEST(FeatureMatcherCache, AsyncWrites) {
+  auto data = CreateTestData(4);
+  const std::vector<Image> images = data.database->ReadAllImages();
+  ASSERT_EQ(images.size(), 4);
+
+  FeatureMatches matches(5);
+  for (size_t i = 0; i < matches.size(); ++i) {
+    matches[i].point2D_idx1 = i;
+    matches[i].point2D_idx2 = i;
+  }
+  TwoViewGeometry tvg;
+  tvg.config = TwoViewGeometry::CALIBRATED;
+  tvg.inlier_matches = matches;
+
+  {
+    // A small queue exercises the back-pressure on the writers.
+    FeatureMatcherCache cache(5, data.database, /*max_num_pending_writes=*/2);
+    for (size_t i = 0; i < images.size(); ++i) {
+      for (size_t j = 0; j < i; ++j) {
+        const image_t id1 = images[i].ImageId();
+        const image_t id2 = images[j].ImageId();
+        cache.DeleteMatches(id1, id2);
+        cache.DeleteTwoViewGeometry(id1, id2);
+        cache.WriteMatches(id1, id2, matches);
+        cache.WriteTwoViewGeometry(id1, id2, tvg);
+        EXPECT_TRUE(cache.ExistsMatches(id1, id2));
+        EXPECT_TRUE(cache.ExistsTwoViewGeometry(id1, id2));
+      }
+    }
+
+    const image_t id1 = images[0].ImageId();
+    const image_t id2 = images[1].ImageId();
+    EXPECT_EQ(cache.GetMatches(id1, id2).size(), matches.size());
+    EXPECT_TRUE(cache.ExistsInlierMatches(id1, id2));
+    cache.DeleteInlierMatches(id1, id2);
+    EXPECT_FALSE(cache.ExistsInlierMatches(id1, id2));
+    cache.DeleteMatches(id1, id2);
+    cache.WriteMatches(id1, id2, {});
+
+    cache.FlushWrites();
+    cache.AccessDatabase([&](Database& database) {
+      EXPECT_TRUE(database.ReadMatches(id1, id2).empty());
+      EXPECT_EQ(database.ReadTwoViewGeometry(id1, id2).config,
+                TwoViewGeometry::CALIBRATED);
+    });
+  }
+
+  // Pending writes are committed when the cache is destructed.
+  const image_t id1 = images[2].ImageId();
+  const image_t id2 = images[3].ImageId();
+  {
+    FeatureMatcherCache cache(5, data.database, /*max_num_pending_writes=*/10);
+    cache.DeleteMatches(id1, id2);
+    cache.WriteMatches(id1, id2, {});
+  }
+  EXPECT_TRUE(data.database->ExistsMatches(id1, id2));
+  EXPECT_TRUE(data.database->ReadMatches(id1, id2).empty());
+}
+
 TEST(FeatureMatcherCache, UpdateTwoViewGeometry) {
   auto data = CreateTestData(4);
   FeatureMatcherCache cache(5, data.database);
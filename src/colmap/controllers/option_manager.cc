@@ -48,6 +48,7 @@
 #include "colmap/mvs/delaunay_meshing.h"
 #include "colmap/mvs/fusion.h"
 #include "colmap/mvs/mesh_simplification.h"
+#include "colmap/mvs/mesh_tiling.h"
 #include "colmap/mvs/patch_match_options.h"
 #include "colmap/mvs/poisson_meshing.h"
 #include "colmap/mvs/texture_mapping.h"
@@ -70,6 +71,8 @@ OptionManager::OptionManager(bool add_project_options)
   exhaustive_pairing = std::make_shared<ExhaustivePairingOptions>();
   sequential_pairing = std::make_shared<SequentialPairingOptions>();
   vocab_tree_pairing = std::make_shared<VocabTreePairingOptions>();
+  global_descriptor_pairing =
+      std::make_shared<GlobalDescriptorPairingOptions>();
   spatial_pairing = std::make_shared<SpatialPairingOptions>();
   transitive_pairing = std::make_shared<TransitivePairingOptions>();
   imported_pairing = std::make_shared<ImportedPairingOptions>();
@@ -89,6 +92,7 @@ OptionManager::OptionManager(bool add_project_options)
       std::make_shared<mvs::AdvancingFrontMeshingOptions>();
   mesh_texture_mapping = std::make_shared<mvs::MeshTextureMappingOptions>();
   mesh_simplification = std::make_shared<mvs::MeshSimplificationOptions>();
+  mesh_tiling = std::make_shared<mvs::MeshTilingOptions>();
 #endif
   render = std::make_shared<RenderOptions>();
 }
@@ -201,6 +205,7 @@ void OptionManager::AddAllOptions() {
   AddExhaustivePairingOptions();
   AddSequentialPairingOptions();
   AddVocabTreePairingOptions();
+  AddGlobalDescriptorPairingOptions();
   AddSpatialPairingOptions();
   AddTransitivePairingOptions();
   AddImportedPairingOptions();
@@ -214,6 +219,7 @@ void OptionManager::AddAllOptions() {
   AddAdvancingFrontMeshingOptions();
   AddMeshTextureMappingOptions();
   AddMeshSimplificationOptions();
+  AddMeshTilingOptions();
 #endif
   AddRenderOptions();
 }
@@ -238,6 +244,12 @@ void OptionManager::AddFeatureExtractionOptions() {
                    &image_reader->default_focal_length_factor);
   AddDefaultOption("ImageReader.camera_mask_path",
                    &image_reader->camera_mask_path);
+  AddDefaultOption("ImageReader.read_video_frames",
+                   &image_reader->read_video_frames);
+  AddDefaultOption("ImageReader.video_min_frame_difference",
+                   &image_reader->video_min_frame_difference);
+  AddDefaultOption("ImageReader.video_min_relative_sharpness",
+                   &image_reader->video_min_relative_sharpness);
 
   AddDefaultEnumOption("FeatureExtraction.type",
                        &feature_extraction->type,
@@ -248,8 +260,16 @@ void OptionManager::AddFeatureExtractionOptions() {
   AddDefaultOption("FeatureExtraction.use_gpu", &feature_extraction->use_gpu);
   AddDefaultOption("FeatureExtraction.gpu_index",
                    &feature_extraction->gpu_index);
+  AddDefaultOption("FeatureExtraction.num_cpu_workers",
+                   &feature_extraction->num_cpu_workers);
+  AddDefaultOption("FeatureExtraction.use_gpu_decoding",
+                   &feature_extraction->use_gpu_decoding);
   AddDefaultOption("FeatureExtraction.max_image_size",
                    &feature_extraction->max_image_size);
+  AddDefaultOption("FeatureExtraction.batch_size",
+                   &feature_extraction->batch_size);
+  AddDefaultOption("FeatureExtraction.batch_timeout_ms",
+                   &feature_extraction->batch_timeout_ms);
 
   AddDefaultOption("SiftExtraction.max_num_features",
                    &feature_extraction->sift->max_num_features);
@@ -277,6 +297,12 @@ void OptionManager::AddFeatureExtractionOptions() {
                    &feature_extraction->sift->dsp_max_scale);
   AddDefaultOption("SiftExtraction.dsp_num_scales",
                    &feature_extraction->sift->dsp_num_scales);
+  AddDefaultOption("SiftExtraction.tile_size",
+                   &feature_extraction->sift->tile_size);
+  AddDefaultOption("SiftExtraction.tile_overlap",
+                   &feature_extraction->sift->tile_overlap);
+  AddDefaultOption("SiftExtraction.tile_num_threads",
+                   &feature_extraction->sift->tile_num_threads);
 
   AddDefaultOption("AlikedExtraction.max_num_features",
                    &feature_extraction->aliked->max_num_features);
@@ -286,6 +312,10 @@ void OptionManager::AddFeatureExtractionOptions() {
                    &feature_extraction->aliked->n16rot_model_path);
   AddDefaultOption("AlikedExtraction.n32_model_path",
                    &feature_extraction->aliked->n32_model_path);
+  AddDefaultEnumOption("AlikedExtraction.descriptor_precision",
+                       &feature_extraction->aliked->descriptor_precision,
+                       FeatureDescriptorPrecisionToString,
+                       FeatureDescriptorPrecisionFromString);
 }
 
 void OptionManager::AddFeatureMatchingOptions() {
@@ -312,6 +342,28 @@ void OptionManager::AddFeatureMatchingOptions() {
                    &feature_matching->skip_image_pairs_in_same_frame);
   AddDefaultOption("FeatureMatching.max_num_matches",
                    &feature_matching->max_num_matches);
+  AddDefaultOption("FeatureMatching.max_num_features",
+                   &feature_matching->max_num_features);
+  AddDefaultOption("FeatureMatching.num_shards",
+                   &feature_matching->num_shards);
+  AddDefaultOption("FeatureMatching.shard_index",
+                   &feature_matching->shard_index);
+  AddDefaultOption("FeatureMatching.shard_database_path",
+                   &feature_matching->shard_database_path);
+  AddDefaultOption("FeatureMatching.feature_cache_size",
+                   &feature_matching->feature_cache_size);
+  AddDefaultOption("FeatureMatching.spill_cache_path",
+                   &feature_matching->spill_cache_path);
+  AddDefaultOption("FeatureMatching.spill_cache_size",
+                   &feature_matching->spill_cache_size);
+  AddDefaultOption("FeatureMatching.checkpoint_path",
+                   &feature_matching->checkpoint_path);
+  AddDefaultOption("FeatureMatching.progress_interval",
+                   &feature_matching->progress_interval);
+  AddDefaultOption("FeatureMatching.batch_size",
+                   &feature_matching->batch_size);
+  AddDefaultOption("FeatureMatching.batch_timeout_ms",
+                   &feature_matching->batch_timeout_ms);
 
   AddDefaultOption("SiftMatching.max_ratio",
                    &feature_matching->sift->max_ratio);
@@ -321,8 +373,18 @@ void OptionManager::AddFeatureMatchingOptions() {
                    &feature_matching->sift->cross_check);
   AddDefaultOption("SiftMatching.cpu_brute_force_matcher",
                    &feature_matching->sift->cpu_brute_force_matcher);
+  AddDefaultOption("SiftMatching.cpu_descriptor_index_path",
+                   &feature_matching->sift->cpu_descriptor_index_path);
   AddDefaultOption("SiftMatching.lightglue_min_score",
                    &feature_matching->sift->lightglue.min_score);
+  AddDefaultOption(
+      "SiftMatching.lightglue_prefilter_min_num_matches",
+      &feature_matching->sift->lightglue.prefilter_min_num_matches);
+  AddDefaultOption(
+      "SiftMatching.lightglue_prefilter_max_num_features",
+      &feature_matching->sift->lightglue.prefilter_max_num_features);
+  AddDefaultOption("SiftMatching.lightglue_prefilter_max_ratio",
+                   &feature_matching->sift->lightglue.prefilter_max_ratio);
   AddDefaultOption("SiftMatching.lightglue_model_path",
                    &feature_matching->sift->lightglue.model_path);
 
@@ -336,6 +398,14 @@ void OptionManager::AddFeatureMatchingOptions() {
                    &feature_matching->aliked->brute_force.model_path);
   AddDefaultOption("AlikedMatching.lightglue_min_score",
                    &feature_matching->aliked->lightglue.min_score);
+  AddDefaultOption(
+      "AlikedMatching.lightglue_prefilter_min_num_matches",
+      &feature_matching->aliked->lightglue.prefilter_min_num_matches);
+  AddDefaultOption(
+      "AlikedMatching.lightglue_prefilter_max_num_features",
+      &feature_matching->aliked->lightglue.prefilter_max_num_features);
+  AddDefaultOption("AlikedMatching.lightglue_prefilter_max_ratio",
+                   &feature_matching->aliked->lightglue.prefilter_max_ratio);
   AddDefaultOption("AlikedMatching.lightglue_model_path",
                    &feature_matching->aliked->lightglue.model_path);
 }
@@ -384,6 +454,10 @@ void OptionManager::AddExhaustivePairingOptions() {
 
   AddDefaultOption("ExhaustiveMatching.block_size",
                    &exhaustive_pairing->block_size);
+  AddDefaultOption("ExhaustiveMatching.hilbert_order",
+                   &exhaustive_pairing->hilbert_order);
+  AddDefaultOption("ExhaustiveMatching.num_cached_blocks",
+                   &exhaustive_pairing->num_cached_blocks);
 }
 
 void OptionManager::AddSequentialPairingOptions() {
@@ -398,6 +472,10 @@ void OptionManager::AddSequentialPairingOptions() {
   AddDefaultOption("SequentialMatching.overlap", &sequential_pairing->overlap);
   AddDefaultOption("SequentialMatching.quadratic_overlap",
                    &sequential_pairing->quadratic_overlap);
+  AddDefaultOption("SequentialMatching.adaptive_overlap",
+                   &sequential_pairing->adaptive_overlap);
+  AddDefaultOption("SequentialMatching.adaptive_overlap_min_num_inliers",
+                   &sequential_pairing->adaptive_overlap_min_num_inliers);
   AddDefaultOption("SequentialMatching.expand_rig_images",
                    &sequential_pairing->expand_rig_images);
   AddDefaultOption("SequentialMatching.loop_detection",
@@ -415,6 +493,8 @@ void OptionManager::AddSequentialPairingOptions() {
       &sequential_pairing->loop_detection_num_images_after_verification);
   AddDefaultOption("SequentialMatching.loop_detection_max_num_features",
                    &sequential_pairing->loop_detection_max_num_features);
+  AddDefaultOption("SequentialMatching.loop_detection_query_batch_size",
+                   &sequential_pairing->loop_detection_query_batch_size);
   AddDefaultOption("SequentialMatching.vocab_tree_path",
                    &sequential_pairing->vocab_tree_path);
   AddDefaultOption("SequentialMatching.num_threads",
@@ -446,6 +526,36 @@ void OptionManager::AddVocabTreePairingOptions() {
                    &vocab_tree_pairing->match_list_path);
   AddDefaultOption("VocabTreeMatching.num_threads",
                    &vocab_tree_pairing->num_threads);
+  AddDefaultOption("VocabTreeMatching.query_batch_size",
+                   &vocab_tree_pairing->query_batch_size);
+  AddDefaultOption("VocabTreeMatching.index_batch_size",
+                   &vocab_tree_pairing->index_batch_size);
+  AddDefaultOption("VocabTreeMatching.index_path",
+                   &vocab_tree_pairing->index_path);
+}
+
+void OptionManager::AddGlobalDescriptorPairingOptions() {
+  if (added_global_descriptor_pairing_options_) {
+    return;
+  }
+  added_global_descriptor_pairing_options_ = true;
+
+  AddFeatureMatchingOptions();
+  AddTwoViewGeometryOptions();
+
+  AddDefaultOption("GlobalDescriptorMatching.num_images",
+                   &global_descriptor_pairing->num_images);
+  AddDefaultOption("GlobalDescriptorMatching.num_clusters",
+                   &global_descriptor_pairing->num_clusters);
+  AddDefaultOption(
+      "GlobalDescriptorMatching.codebook_num_training_features",
+      &global_descriptor_pairing->codebook_num_training_features);
+  AddDefaultOption("GlobalDescriptorMatching.max_num_features",
+                   &global_descriptor_pairing->max_num_features);
+  AddDefaultOption("GlobalDescriptorMatching.codebook_path",
+                   &global_descriptor_pairing->codebook_path);
+  AddDefaultOption("GlobalDescriptorMatching.num_threads",
+                   &global_descriptor_pairing->num_threads);
 }
 
 void OptionManager::AddSpatialPairingOptions() {
@@ -479,6 +589,10 @@ void OptionManager::AddTransitivePairingOptions() {
                    &transitive_pairing->batch_size);
   AddDefaultOption("TransitiveMatching.num_iterations",
                    &transitive_pairing->num_iterations);
+  AddDefaultOption("TransitiveMatching.max_num_candidates_per_image",
+                   &transitive_pairing->max_num_candidates_per_image);
+  AddDefaultOption("TransitiveMatching.num_threads",
+                   &transitive_pairing->num_threads);
 }
 
 void OptionManager::AddImportedPairingOptions() {
@@ -588,6 +702,12 @@ void OptionManager::AddBundleAdjustmentOptions() {
                    &bundle_adjustment->caspar->solver_rel_decrease_min);
   AddDefaultOption("BundleAdjustmentCaspar.gpu_index",
                    &bundle_adjustment->caspar->gpu_index);
+  AddDefaultOption("BundleAdjustmentCaspar.num_double_precision_iterations",
+                   &bundle_adjustment->caspar->num_double_precision_iterations);
+  AddDefaultOption("BundleAdjustmentCaspar.max_num_observations_per_solve",
+                   &bundle_adjustment->caspar->max_num_observations_per_solve);
+  AddDefaultOption("BundleAdjustmentCaspar.num_multi_gpu_iterations",
+                   &bundle_adjustment->caspar->num_multi_gpu_iterations);
 #endif  // CASPAR_ENABLED
 }
 
@@ -599,10 +719,16 @@ void OptionManager::AddMapperOptions() {
 
   AddDefaultOption("Mapper.min_num_matches", &mapper->min_num_matches);
   AddDefaultOption("Mapper.ignore_watermarks", &mapper->ignore_watermarks);
+  AddDefaultOption("Mapper.correspondence_graph_snapshot_path",
+                   &mapper->correspondence_graph_snapshot_path);
+  AddDefaultOption("Mapper.lazy_load_points2D", &mapper->lazy_load_points2D);
   AddDefaultOption("Mapper.multiple_models", &mapper->multiple_models);
   AddDefaultOption("Mapper.max_num_models", &mapper->max_num_models);
   AddDefaultOption("Mapper.max_model_overlap", &mapper->max_model_overlap);
   AddDefaultOption("Mapper.min_model_size", &mapper->min_model_size);
+  AddDefaultOption("Mapper.parallel_components", &mapper->parallel_components);
+  AddDefaultOption("Mapper.parallel_triangulation",
+                   &mapper->parallel_triangulation);
   AddDefaultOption("Mapper.init_image_id1", &mapper->init_image_id1);
   AddDefaultOption("Mapper.init_image_id2", &mapper->init_image_id2);
   AddDefaultOption("Mapper.init_num_trials", &mapper->init_num_trials);
@@ -610,6 +736,12 @@ void OptionManager::AddMapperOptions() {
                    &mapper->structure_less_registration_fallback);
   AddDefaultOption("Mapper.structure_less_registration_only",
                    &mapper->structure_less_registration_only);
+  AddDefaultOption("Mapper.structure_less_registration_first",
+                   &mapper->structure_less_registration_first);
+  AddDefaultOption("Mapper.structure_less_batch_size",
+                   &mapper->structure_less_batch_size);
+  AddDefaultOption("Mapper.num_speculative_reg_images",
+                   &mapper->num_speculative_reg_images);
   AddDefaultOption("Mapper.extract_colors", &mapper->extract_colors);
   AddDefaultOption("Mapper.num_threads", &mapper->num_threads);
   AddDefaultOption("Mapper.random_seed", &mapper->random_seed);
@@ -638,6 +770,15 @@ void OptionManager::AddMapperOptions() {
                    &mapper->ba_global_frames_freq);
   AddDefaultOption("Mapper.ba_global_points_freq",
                    &mapper->ba_global_points_freq);
+  AddDefaultOption("Mapper.ba_global_adaptive", &mapper->ba_global_adaptive);
+  AddDefaultOption("Mapper.ba_global_adaptive_min_num_frames",
+                   &mapper->ba_global_adaptive_min_num_frames);
+  AddDefaultOption("Mapper.ba_global_adaptive_max_frames_ratio",
+                   &mapper->ba_global_adaptive_max_frames_ratio);
+  AddDefaultOption("Mapper.ba_global_adaptive_max_error_increase",
+                   &mapper->ba_global_adaptive_max_error_increase);
+  AddDefaultOption("Mapper.ba_global_adaptive_max_filtered_ratio",
+                   &mapper->ba_global_adaptive_max_filtered_ratio);
   AddDefaultOption("Mapper.ba_global_function_tolerance",
                    &mapper->ba_global_function_tolerance);
   AddDefaultOption("Mapper.ba_global_max_num_iterations",
@@ -665,6 +806,11 @@ void OptionManager::AddMapperOptions() {
   AddDefaultOption("Mapper.snapshot_path", &mapper->snapshot_path);
   AddDefaultOption("Mapper.snapshot_frames_freq",
                    &mapper->snapshot_frames_freq);
+  AddDefaultOption("Mapper.checkpoint_path", &mapper->checkpoint_path);
+  AddDefaultOption("Mapper.checkpoint_frames_freq",
+                   &mapper->checkpoint_frames_freq);
+  AddDefaultOption("Mapper.resume_from_checkpoint",
+                   &mapper->resume_from_checkpoint);
   AddDefaultOption("Mapper.fix_existing_frames", &mapper->fix_existing_frames);
 
   // IncrementalMapper.
@@ -688,10 +834,18 @@ void OptionManager::AddMapperOptions() {
   AddDefaultOption("Mapper.filter_min_tri_angle",
                    &mapper->mapper.filter_min_tri_angle);
   AddDefaultOption("Mapper.max_reg_trials", &mapper->mapper.max_reg_trials);
+  AddDefaultOption("Mapper.lazy_points2D_cache_size",
+                   &mapper->mapper.lazy_points2D_cache_size);
   AddDefaultOption("Mapper.ba_local_num_images",
                    &mapper->mapper.ba_local_num_images);
   AddDefaultOption("Mapper.ba_local_min_tri_angle",
                    &mapper->mapper.ba_local_min_tri_angle);
+  AddDefaultOption("Mapper.structure_less_triangulate",
+                   &mapper->mapper.structure_less_triangulate);
+  AddDefaultOption("Mapper.ba_local_reuse_problem",
+                   &mapper->mapper.ba_local_reuse_problem);
+  AddDefaultOption("Mapper.ba_global_reuse_problem",
+                   &mapper->mapper.ba_global_reuse_problem);
   AddDefaultOption("Mapper.ba_global_ignore_redundant_points3D",
                    &mapper->mapper.ba_global_ignore_redundant_points3D);
   AddDefaultOption(
@@ -742,8 +896,12 @@ void OptionManager::AddGlobalMapperOptions() {
                    &global_mapper->min_num_matches);
   AddDefaultOption("GlobalMapper.ignore_watermarks",
                    &global_mapper->ignore_watermarks);
+  AddDefaultOption("GlobalMapper.correspondence_graph_snapshot_path",
+                   &global_mapper->correspondence_graph_snapshot_path);
   AddDefaultOption("GlobalMapper.num_threads", &global_mapper->num_threads);
   AddDefaultOption("GlobalMapper.random_seed", &global_mapper->random_seed);
+  AddDefaultOption("GlobalMapper.deterministic",
+                   &global_mapper->mapper.deterministic);
   AddDefaultOption("GlobalMapper.decompose_relative_pose",
                    &global_mapper->decompose_relative_pose);
   AddDefaultOption("GlobalMapper.ba_num_iterations",
@@ -758,6 +916,11 @@ void OptionManager::AddGlobalMapperOptions() {
                    &global_mapper->mapper.skip_bundle_adjustment);
   AddDefaultOption("GlobalMapper.skip_retriangulation",
                    &global_mapper->mapper.skip_retriangulation);
+  AddDefaultOption("GlobalMapper.extend_reconstruction",
+                   &global_mapper->mapper.extend_reconstruction);
+
+  AddDefaultOption("GlobalMapper.max_pose_graph_degree",
+                   &global_mapper->mapper.max_pose_graph_degree);
 
   // Track establishment options.
   AddDefaultOption(
@@ -846,6 +1009,27 @@ void OptionManager::AddGlobalMapperOptions() {
   AddDefaultOption(
       "GlobalMapper.ra_max_rotation_error_deg",
       &global_mapper->mapper.rotation_averaging.max_rotation_error_deg);
+  AddDefaultOption(
+      "GlobalMapper.ra_max_cycle_error_deg",
+      &global_mapper->mapper.rotation_averaging.max_cycle_error_deg);
+  AddDefaultEnumOption(
+      "GlobalMapper.ra_linear_solver",
+      &global_mapper->mapper.rotation_averaging.linear_solver,
+      RotationAveragingLinearSolverToString,
+      RotationAveragingLinearSolverFromString);
+  AddDefaultOption(
+      "GlobalMapper.ra_max_num_cg_iterations",
+      &global_mapper->mapper.rotation_averaging.max_num_cg_iterations);
+  AddDefaultEnumOption(
+      "GlobalMapper.ra_sparse_cholesky_backend",
+      &global_mapper->mapper.rotation_averaging.sparse_cholesky.backend,
+      SparseCholeskyOptions::BackendToString,
+      SparseCholeskyOptions::BackendFromString);
+  AddDefaultEnumOption(
+      "GlobalMapper.ra_sparse_cholesky_ordering",
+      &global_mapper->mapper.rotation_averaging.sparse_cholesky.ordering,
+      SparseCholeskyOptions::OrderingToString,
+      SparseCholeskyOptions::OrderingFromString);
 
   // Threshold options.
   AddDefaultOption("GlobalMapper.max_angular_reproj_error_deg",
@@ -863,14 +1047,18 @@ void OptionManager::AddHierarchicalMapperOptions() {
   added_hierarchical_mapper_options_ = true;
 
   // The per-cluster reconstruction is configured through the incremental mapper
-  // options (Mapper.*), so only the hierarchical-specific options are added
-  // here. The incremental_options member is populated from `mapper` by callers.
+  // options (Mapper.*) or the global mapper options (GlobalMapper.*), so only
+  // the hierarchical-specific options are added here. The incremental_options
+  // and global_options members are populated from `mapper` and `global_mapper`
+  // by callers.
   AddDefaultOption("HierarchicalMapper.init_num_trials",
                    &hierarchical_mapper->init_num_trials);
   AddDefaultOption("HierarchicalMapper.num_threads",
                    &hierarchical_mapper->num_threads);
   AddDefaultOption("HierarchicalMapper.num_workers",
                    &hierarchical_mapper->num_workers);
+  AddDefaultOption("HierarchicalMapper.use_global_mapper",
+                   &hierarchical_mapper->use_global_mapper);
   AddDefaultOption("HierarchicalMapper.is_hierarchical",
                    &hierarchical_mapper->clustering_options.is_hierarchical);
   AddDefaultOption("HierarchicalMapper.branching",
@@ -882,6 +1070,16 @@ void OptionManager::AddHierarchicalMapperOptions() {
   AddDefaultOption(
       "HierarchicalMapper.leaf_max_num_images",
       &hierarchical_mapper->clustering_options.leaf_max_num_images);
+  AddDefaultOption("HierarchicalMapper.balanced_leaves",
+                   &hierarchical_mapper->clustering_options.balanced_leaves);
+  AddDefaultOption("HierarchicalMapper.max_imbalance",
+                   &hierarchical_mapper->clustering_options.max_imbalance);
+  AddDefaultOption("HierarchicalMapper.job_queue_path",
+                   &hierarchical_mapper->job_queue_path);
+  AddDefaultOption("HierarchicalMapper.job_max_num_attempts",
+                   &hierarchical_mapper->job_max_num_attempts);
+  AddDefaultOption("HierarchicalMapper.job_timeout",
+                   &hierarchical_mapper->job_timeout);
 }
 
 void OptionManager::AddGravityRefinerOptions() {
@@ -921,6 +1119,7 @@ void OptionManager::AddPatchMatchStereoOptions() {
 
   AddDefaultOption("PatchMatchStereo.max_image_size",
                    &patch_match_stereo->max_image_size);
+  AddDefaultOption("PatchMatchStereo.use_gpu", &patch_match_stereo->use_gpu);
   AddDefaultOption("PatchMatchStereo.gpu_index",
                    &patch_match_stereo->gpu_index);
   AddDefaultOption("PatchMatchStereo.depth_min",
@@ -937,6 +1136,12 @@ void OptionManager::AddPatchMatchStereoOptions() {
                    &patch_match_stereo->sigma_color);
   AddDefaultOption("PatchMatchStereo.num_samples",
                    &patch_match_stereo->num_samples);
+  AddDefaultOption("PatchMatchStereo.src_image_selection",
+                   &patch_match_stereo->src_image_selection);
+  AddDefaultOption("PatchMatchStereo.src_image_prune_min_sel_prob",
+                   &patch_match_stereo->src_image_prune_min_sel_prob);
+  AddDefaultOption("PatchMatchStereo.src_image_prune_tile_size",
+                   &patch_match_stereo->src_image_prune_tile_size);
   AddDefaultOption("PatchMatchStereo.ncc_sigma",
                    &patch_match_stereo->ncc_sigma);
   AddDefaultOption("PatchMatchStereo.min_triangulation_angle",
@@ -945,6 +1150,20 @@ void OptionManager::AddPatchMatchStereoOptions() {
                    &patch_match_stereo->incident_angle_sigma);
   AddDefaultOption("PatchMatchStereo.num_iterations",
                    &patch_match_stereo->num_iterations);
+  AddDefaultOption("PatchMatchStereo.pyramid_num_levels",
+                   &patch_match_stereo->pyramid_num_levels);
+  AddDefaultOption("PatchMatchStereo.pyramid_num_iterations",
+                   &patch_match_stereo->pyramid_num_iterations);
+  AddDefaultOption("PatchMatchStereo.init_mode",
+                   &patch_match_stereo->init_mode);
+  AddDefaultOption("PatchMatchStereo.init_num_iterations",
+                   &patch_match_stereo->init_num_iterations);
+  AddDefaultOption("PatchMatchStereo.half_precision",
+                   &patch_match_stereo->half_precision);
+  AddDefaultOption("PatchMatchStereo.tile_size",
+                   &patch_match_stereo->tile_size);
+  AddDefaultOption("PatchMatchStereo.tile_overlap",
+                   &patch_match_stereo->tile_overlap);
   AddDefaultOption("PatchMatchStereo.geom_consistency",
                    &patch_match_stereo->geom_consistency);
   AddDefaultOption("PatchMatchStereo.geom_consistency_regularizer",
@@ -966,6 +1185,12 @@ void OptionManager::AddPatchMatchStereoOptions() {
                    &patch_match_stereo->allow_missing_files);
   AddDefaultOption("PatchMatchStereo.write_consistency_graph",
                    &patch_match_stereo->write_consistency_graph);
+  AddDefaultOption("PatchMatchStereo.map_compression",
+                   &patch_match_stereo->map_compression);
+  AddDefaultOption("PatchMatchStereo.distributed",
+                   &patch_match_stereo->distributed);
+  AddDefaultOption("PatchMatchStereo.io_pipeline_depth",
+                   &patch_match_stereo->io_pipeline_depth);
   AddDefaultOption("PatchMatchStereo.num_threads",
                    &patch_match_stereo->num_threads);
 }
@@ -996,6 +1221,17 @@ void OptionManager::AddStereoFusionOptions() {
                    &stereo_fusion->check_num_images);
   AddDefaultOption("StereoFusion.cache_size", &stereo_fusion->cache_size);
   AddDefaultOption("StereoFusion.use_cache", &stereo_fusion->use_cache);
+  AddDefaultOption("StereoFusion.use_gpu", &stereo_fusion->use_gpu);
+  AddDefaultOption("StereoFusion.gpu_index", &stereo_fusion->gpu_index);
+  AddDefaultOption("StereoFusion.stream_output_path",
+                   &stereo_fusion->stream_output_path);
+  AddDefaultOption("StereoFusion.input_fused_path",
+                   &stereo_fusion->input_fused_path);
+  AddDefaultOption("StereoFusion.spill_cache_path",
+                   &stereo_fusion->spill_cache_path);
+  AddDefaultOption("StereoFusion.spill_cache_size",
+                   &stereo_fusion->spill_cache_size);
+  AddDefaultOption("StereoFusion.merge_radius", &stereo_fusion->merge_radius);
 }
 
 void OptionManager::AddPoissonMeshingOptions() {
@@ -1010,6 +1246,10 @@ void OptionManager::AddPoissonMeshingOptions() {
   AddDefaultOption("PoissonMeshing.color", &poisson_meshing->color);
   AddDefaultOption("PoissonMeshing.trim", &poisson_meshing->trim);
   AddDefaultOption("PoissonMeshing.num_threads", &poisson_meshing->num_threads);
+  AddDefaultOption("PoissonMeshing.max_num_points_per_block",
+                   &poisson_meshing->max_num_points_per_block);
+  AddDefaultOption("PoissonMeshing.block_overlap",
+                   &poisson_meshing->block_overlap);
 }
 
 void OptionManager::AddDelaunayMeshingOptions() {
@@ -1032,6 +1272,10 @@ void OptionManager::AddDelaunayMeshingOptions() {
                    &delaunay_meshing->max_side_length_factor);
   AddDefaultOption("DelaunayMeshing.max_side_length_percentile",
                    &delaunay_meshing->max_side_length_percentile);
+  AddDefaultOption("DelaunayMeshing.max_num_points_per_partition",
+                   &delaunay_meshing->max_num_points_per_partition);
+  AddDefaultOption("DelaunayMeshing.partition_overlap",
+                   &delaunay_meshing->partition_overlap);
   AddDefaultOption("DelaunayMeshing.num_threads",
                    &delaunay_meshing->num_threads);
 }
@@ -1073,6 +1317,8 @@ void OptionManager::AddMeshTextureMappingOptions() {
                    &mesh_texture_mapping->min_visible_vertices);
   AddDefaultOption("MeshTextureMapping.view_selection_smoothing_iterations",
                    &mesh_texture_mapping->view_selection_smoothing_iterations);
+  AddDefaultOption("MeshTextureMapping.rasterize_visibility",
+                   &mesh_texture_mapping->rasterize_visibility);
   AddDefaultOption("MeshTextureMapping.atlas_patch_padding",
                    &mesh_texture_mapping->atlas_patch_padding);
   AddDefaultOption("MeshTextureMapping.inpaint_radius",
@@ -1103,6 +1349,19 @@ void OptionManager::AddMeshSimplificationOptions() {
                    &mesh_simplification->interpolate_colors);
   AddDefaultOption("MeshSimplification.num_threads",
                    &mesh_simplification->num_threads);
+  AddDefaultOption("MeshSimplification.max_num_faces_per_block",
+                   &mesh_simplification->max_num_faces_per_block);
+}
+
+void OptionManager::AddMeshTilingOptions() {
+  if (added_mesh_tiling_options_) {
+    return;
+  }
+  added_mesh_tiling_options_ = true;
+
+  AddDefaultOption("MeshTiling.max_num_faces_per_tile",
+                   &mesh_tiling->max_num_faces_per_tile);
+  AddDefaultOption("MeshTiling.num_threads", &mesh_tiling->num_threads);
 }
 #endif  // COLMAP_MVS_ENABLED
 
@@ -1114,6 +1373,7 @@ void OptionManager::AddRenderOptions() {
 
   AddDefaultOption("Render.min_track_len", &render->min_track_len);
   AddDefaultOption("Render.max_error", &render->max_error);
+  AddDefaultOption("Render.max_num_points", &render->max_num_points);
   AddDefaultOption("Render.refresh_rate", &render->refresh_rate);
   AddDefaultOption("Render.adapt_refresh_rate", &render->adapt_refresh_rate);
   AddDefaultOption("Render.image_connections", &render->image_connections);
@@ -1129,6 +1389,7 @@ void OptionManager::Reset(bool reset_logging) {
   added_exhaustive_pairing_options_ = false;
   added_sequential_pairing_options_ = false;
   added_vocab_tree_pairing_options_ = false;
+  added_global_descriptor_pairing_options_ = false;
   added_spatial_pairing_options_ = false;
   added_transitive_pairing_options_ = false;
   added_image_pairs_pairing_options_ = false;
@@ -1145,6 +1406,7 @@ void OptionManager::Reset(bool reset_logging) {
   added_advancing_front_meshing_options_ = false;
   added_mesh_texture_mapping_options_ = false;
   added_mesh_simplification_options_ = false;
+  added_mesh_tiling_options_ = false;
 #endif
   added_render_options_ = false;
 }
@@ -1156,6 +1418,7 @@ void OptionManager::ResetOptions(const bool reset_paths) {
   *exhaustive_pairing = ExhaustivePairingOptions();
   *sequential_pairing = SequentialPairingOptions();
   *vocab_tree_pairing = VocabTreePairingOptions();
+  *global_descriptor_pairing = GlobalDescriptorPairingOptions();
   *spatial_pairing = SpatialPairingOptions();
   *transitive_pairing = TransitivePairingOptions();
   *imported_pairing = ImportedPairingOptions();
@@ -1172,6 +1435,7 @@ void OptionManager::ResetOptions(const bool reset_paths) {
   *delaunay_meshing = mvs::DelaunayMeshingOptions();
   *mesh_texture_mapping = mvs::MeshTextureMappingOptions();
   *mesh_simplification = mvs::MeshSimplificationOptions();
+  *mesh_tiling = mvs::MeshTilingOptions();
 #endif
   *render = RenderOptions();
 
@@ -1193,6 +1457,9 @@ bool OptionManager::Check() {
   if (exhaustive_pairing) success = success && exhaustive_pairing->Check();
   if (sequential_pairing) success = success && sequential_pairing->Check();
   if (vocab_tree_pairing) success = success && vocab_tree_pairing->Check();
+  if (global_descriptor_pairing) {
+    success = success && global_descriptor_pairing->Check();
+  }
   if (spatial_pairing) success = success && spatial_pairing->Check();
   if (transitive_pairing) success = success && transitive_pairing->Check();
   if (imported_pairing) success = success && imported_pairing->Check();
@@ -43,6 +43,7 @@ struct TwoViewGeometryOptions;
 struct ExhaustivePairingOptions;
 struct SequentialPairingOptions;
 struct VocabTreePairingOptions;
+struct GlobalDescriptorPairingOptions;
 struct SpatialPairingOptions;
 struct TransitivePairingOptions;
 struct ImportedPairingOptions;
@@ -63,6 +64,7 @@ struct DelaunayMeshingOptions;
 struct AdvancingFrontMeshingOptions;
 struct MeshTextureMappingOptions;
 struct MeshSimplificationOptions;
+struct MeshTilingOptions;
 }  // namespace mvs
 #endif
 
@@ -96,6 +98,7 @@ class OptionManager : public BaseOptionManager {
   void AddExhaustivePairingOptions();
   void AddSequentialPairingOptions();
   void AddVocabTreePairingOptions();
+  void AddGlobalDescriptorPairingOptions();
   void AddSpatialPairingOptions();
   void AddTransitivePairingOptions();
   void AddImportedPairingOptions();
@@ -113,6 +116,7 @@ class OptionManager : public BaseOptionManager {
   void AddAdvancingFrontMeshingOptions();
   void AddMeshTextureMappingOptions();
   void AddMeshSimplificationOptions();
+  void AddMeshTilingOptions();
 #endif
   void AddRenderOptions();
 
@@ -129,6 +133,7 @@ class OptionManager : public BaseOptionManager {
   std::shared_ptr<ExhaustivePairingOptions> exhaustive_pairing;
   std::shared_ptr<SequentialPairingOptions> sequential_pairing;
   std::shared_ptr<VocabTreePairingOptions> vocab_tree_pairing;
+  std::shared_ptr<GlobalDescriptorPairingOptions> global_descriptor_pairing;
   std::shared_ptr<SpatialPairingOptions> spatial_pairing;
   std::shared_ptr<TransitivePairingOptions> transitive_pairing;
   std::shared_ptr<ImportedPairingOptions> imported_pairing;
@@ -148,6 +153,7 @@ class OptionManager : public BaseOptionManager {
   std::shared_ptr<mvs::AdvancingFrontMeshingOptions> advancing_front_meshing;
   std::shared_ptr<mvs::MeshTextureMappingOptions> mesh_texture_mapping;
   std::shared_ptr<mvs::MeshSimplificationOptions> mesh_simplification;
+  std::shared_ptr<mvs::MeshTilingOptions> mesh_tiling;
 #endif
 
   std::shared_ptr<RenderOptions> render;
@@ -167,6 +173,7 @@ class OptionManager : public BaseOptionManager {
   bool added_exhaustive_pairing_options_ = false;
   bool added_sequential_pairing_options_ = false;
   bool added_vocab_tree_pairing_options_ = false;
+  bool added_global_descriptor_pairing_options_ = false;
   bool added_spatial_pairing_options_ = false;
   bool added_transitive_pairing_options_ = false;
   bool added_image_pairs_pairing_options_ = false;
@@ -184,6 +191,7 @@ class OptionManager : public BaseOptionManager {
   bool added_advancing_front_meshing_options_ = false;
   bool added_mesh_texture_mapping_options_ = false;
   bool added_mesh_simplification_options_ = false;
+  bool added_mesh_tiling_options_ = false;
 #endif
   bool added_render_options_ = false;
 };
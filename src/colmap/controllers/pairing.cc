@@ -29,22 +29,27 @@
 
 #include "colmap/controllers/pairing.h"
 
+#include "colmap/feature/index.h"
 #include "colmap/feature/utils.h"
 #include "colmap/geometry/gps.h"
+#include "colmap/math/kd_tree.h"
+#include "colmap/retrieval/global_descriptor.h"
 #include "colmap/retrieval/resources.h"
 #include "colmap/util/file.h"
 #include "colmap/util/logging.h"
 #include "colmap/util/misc.h"
 #include "colmap/util/timer.h"
 
+#include <algorithm>
 #include <fstream>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
-#include <faiss/IndexFlat.h>
-#include <omp.h>
-
 namespace colmap {
 namespace {
 
@@ -94,6 +99,144 @@ std::vector<std::pair<image_t, image_t>> ReadImagePairsText(
   return image_pairs;
 }
 
+// Returns the distance of the cell (x, y) along the Hilbert curve covering a
+// grid of at least size x size cells.
+uint64_t HilbertCurveIndex(const size_t size, size_t x, size_t y) {
+  size_t n = 1;
+  while (n < size) {
+    n *= 2;
+  }
+  uint64_t index = 0;
+  for (size_t s = n / 2; s > 0; s /= 2) {
+    const size_t rx = (x & s) > 0 ? 1 : 0;
+    const size_t ry = (y & s) > 0 ? 1 : 0;
+    index += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+    // Rotate the quadrant so that the curve is continuous.
+    if (ry == 0) {
+      if (rx == 1) {
+        x = n - 1 - x;
+        y = n - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return index;
+}
+
+// Serializes the position of a pair generator as its type tag followed by
+// the values of its position and an optional cursor of a nested generator.
+std::string FormatCursor(const std::string& type,
+                         const std::vector<size_t>& values,
+                         const std::string& nested_cursor = "") {
+  std::ostringstream cursor;
+  cursor << type;
+  for (const size_t value : values) {
+    cursor << " " << value;
+  }
+  if (!nested_cursor.empty()) {
+    cursor << " " << nested_cursor;
+  }
+  return cursor.str();
+}
+
+// Returns the L2-normalized local descriptors of an image, optionally limited
+// to its largest-scale features, for the aggregation into global descriptors.
+FeatureDescriptorsFloatData ReadNormalizedDescriptors(
+    FeatureMatcherCache& cache,
+    const image_t image_id,
+    const int max_num_features) {
+  FeatureDescriptors descriptors = *cache.GetDescriptors(image_id);
+  if (max_num_features > 0 && descriptors.data.rows() > max_num_features) {
+    FeatureKeypoints keypoints = *cache.GetKeypoints(image_id);
+    ExtractTopScaleFeatures(&keypoints, &descriptors, max_num_features);
+  }
+  FeatureDescriptorsFloatData data = descriptors.ToFloat().data;
+  L2NormalizeFeatureDescriptors(&data);
+  return data;
+}
+
+retrieval::VLADCodebook TrainVLADCodebook(
+    const GlobalDescriptorPairingOptions& options,
+    FeatureMatcherCache& cache,
+    const std::vector<image_t>& image_ids) {
+  // Sample the training features evenly from a subset of the images.
+  constexpr int kMaxNumFeaturesPerImage = 100;
+  const size_t num_training_images = std::min<size_t>(
+      image_ids.size(),
+      (options.codebook_num_training_features + kMaxNumFeaturesPerImage - 1) /
+          kMaxNumFeaturesPerImage);
+  std::vector<FeatureDescriptorsFloatData> image_descriptors(
+      num_training_images);
+  ParallelFor(
+      0,
+      num_training_images,
+      [&](const int64_t begin, const int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          const size_t image_idx = i * image_ids.size() / num_training_images;
+          const FeatureDescriptorsFloatData descriptors =
+              ReadNormalizedDescriptors(cache,
+                                        image_ids[image_idx],
+                                        options.max_num_features);
+          const Eigen::Index num_features = std::min<Eigen::Index>(
+              descriptors.rows(), kMaxNumFeaturesPerImage);
+          image_descriptors[i].resize(num_features, descriptors.cols());
+          for (Eigen::Index j = 0; j < num_features; ++j) {
+            image_descriptors[i].row(j) =
+                descriptors.row(j * descriptors.rows() / num_features);
+          }
+        }
+      },
+      options.num_threads);
+
+  Eigen::Index num_features = 0;
+  Eigen::Index desc_dim = 0;
+  for (const auto& descriptors : image_descriptors) {
+    num_features += descriptors.rows();
+    if (descriptors.rows() > 0) {
+      desc_dim = descriptors.cols();
+    }
+  }
+  FeatureDescriptorsFloatData training_descriptors(num_features, desc_dim);
+  Eigen::Index row = 0;
+  for (const auto& descriptors : image_descriptors) {
+    if (descriptors.rows() > 0) {
+      training_descriptors.middleRows(row, descriptors.rows()) = descriptors;
+      row += descriptors.rows();
+    }
+  }
+
+  retrieval::VLADCodebook::BuildOptions build_options;
+  build_options.num_clusters =
+      std::min<int>(options.num_clusters, training_descriptors.rows());
+  build_options.num_threads = options.num_threads;
+  retrieval::VLADCodebook codebook;
+  codebook.Build(build_options, training_descriptors);
+  return codebook;
+}
+
+std::vector<size_t> ParseCursor(const std::string& type,
+                                const std::string& cursor,
+                                const size_t num_values,
+                                std::string* nested_cursor = nullptr) {
+  std::istringstream cursor_stream(cursor);
+  std::string cursor_type;
+  cursor_stream >> cursor_type;
+  THROW_CHECK_EQ(cursor_type, type) << "Incompatible pair generator cursor";
+  std::vector<size_t> values(num_values);
+  for (size_t& value : values) {
+    THROW_CHECK(cursor_stream >> value) << "Invalid pair generator cursor";
+  }
+  cursor_stream >> std::ws;
+  std::string remainder;
+  std::getline(cursor_stream, remainder);
+  if (nested_cursor == nullptr) {
+    THROW_CHECK(remainder.empty()) << "Invalid pair generator cursor";
+  } else {
+    *nested_cursor = std::move(remainder);
+  }
+  return values;
+}
+
 }  // namespace
 
 bool ExistingMatchedPairingOptions::Check() const {
@@ -103,6 +246,7 @@ bool ExistingMatchedPairingOptions::Check() const {
 
 bool ExhaustivePairingOptions::Check() const {
   CHECK_OPTION_GT(block_size, 1);
+  CHECK_OPTION_GE(num_cached_blocks, 2);
   return true;
 }
 
@@ -110,15 +254,26 @@ bool VocabTreePairingOptions::Check() const {
   CHECK_OPTION_GT(num_images, 0);
   CHECK_OPTION_GT(num_nearest_neighbors, 0);
   CHECK_OPTION_GT(num_checks, 0);
+  CHECK_OPTION_GT(query_batch_size, 0);
+  CHECK_OPTION_GT(index_batch_size, 0);
+  return true;
+}
+
+bool GlobalDescriptorPairingOptions::Check() const {
+  CHECK_OPTION_GT(num_images, 0);
+  CHECK_OPTION_GT(num_clusters, 0);
+  CHECK_OPTION_GE(codebook_num_training_features, num_clusters);
   return true;
 }
 
 bool SequentialPairingOptions::Check() const {
   CHECK_OPTION_GT(overlap, 0);
+  CHECK_OPTION_GE(adaptive_overlap_min_num_inliers, 0);
   CHECK_OPTION_GT(loop_detection_period, 0);
   CHECK_OPTION_GT(loop_detection_num_images, 0);
   CHECK_OPTION_GT(loop_detection_num_nearest_neighbors, 0);
   CHECK_OPTION_GT(loop_detection_num_checks, 0);
+  CHECK_OPTION_GT(loop_detection_query_batch_size, 0);
   return true;
 }
 
@@ -132,6 +287,7 @@ VocabTreePairingOptions SequentialPairingOptions::VocabTreeOptions() const {
   options.max_num_features = loop_detection_max_num_features;
   options.vocab_tree_path = vocab_tree_path;
   options.num_threads = num_threads;
+  options.query_batch_size = loop_detection_query_batch_size;
   return options;
 }
 
@@ -147,6 +303,8 @@ bool SpatialPairingOptions::Check() const {
 bool TransitivePairingOptions::Check() const {
   CHECK_OPTION_GT(batch_size, 0);
   CHECK_OPTION_GT(num_iterations, 0);
+  CHECK_OPTION(max_num_candidates_per_image == -1 ||
+               max_num_candidates_per_image > 0);
   return true;
 }
 
@@ -157,6 +315,14 @@ bool ImportedPairingOptions::Check() const {
 
 bool FeaturePairsMatchingOptions::Check() const { return true; }
 
+double PairGenerator::Progress() const { return -1; }
+
+std::string PairGenerator::Cursor() const { return ""; }
+
+void PairGenerator::Seek(const std::string& cursor) {
+  throw std::runtime_error("Pair generator cannot be resumed");
+}
+
 std::vector<std::pair<image_t, image_t>> PairGenerator::AllPairs() {
   std::vector<std::pair<image_t, image_t>> image_pairs;
   while (!this->HasFinished()) {
@@ -178,8 +344,32 @@ ExhaustivePairGenerator::ExhaustivePairGenerator(
           std::ceil(static_cast<double>(image_ids_.size()) / block_size_))) {
   THROW_CHECK(options.Check());
   LOG(INFO) << "Generating exhaustive image pairs...";
-  const size_t num_pairs_per_block = block_size_ * (block_size_ - 1) / 2;
-  image_pairs_.reserve(num_pairs_per_block);
+  if (options_.hilbert_order) {
+    block_schedule_.reserve(num_blocks_ * (num_blocks_ + 1) / 2);
+    for (size_t block_idx1 = 0; block_idx1 < num_blocks_; ++block_idx1) {
+      for (size_t block_idx2 = block_idx1; block_idx2 < num_blocks_;
+           ++block_idx2) {
+        block_schedule_.emplace_back(block_idx1, block_idx2);
+      }
+    }
+    std::sort(block_schedule_.begin(),
+              block_schedule_.end(),
+              [this](const std::pair<size_t, size_t>& block1,
+                     const std::pair<size_t, size_t>& block2) {
+                return HilbertCurveIndex(
+                           num_blocks_, block1.first, block1.second) <
+                       HilbertCurveIndex(
+                           num_blocks_, block2.first, block2.second);
+              });
+    for (auto& [start_idx1, start_idx2] : block_schedule_) {
+      start_idx1 *= block_size_;
+      start_idx2 *= block_size_;
+    }
+    image_pairs_.reserve(block_size_ * block_size_);
+  } else {
+    const size_t num_pairs_per_block = block_size_ * (block_size_ - 1) / 2;
+    image_pairs_.reserve(num_pairs_per_block);
+  }
 }
 
 ExhaustivePairGenerator::ExhaustivePairGenerator(
@@ -193,18 +383,61 @@ ExhaustivePairGenerator::ExhaustivePairGenerator(
 void ExhaustivePairGenerator::Reset() {
   start_idx1_ = 0;
   start_idx2_ = 0;
+  schedule_idx_ = 0;
 }
 
 bool ExhaustivePairGenerator::HasFinished() const {
+  if (options_.hilbert_order) {
+    return schedule_idx_ >= block_schedule_.size();
+  }
   return start_idx1_ >= image_ids_.size();
 }
 
+double ExhaustivePairGenerator::Progress() const {
+  if (HasFinished()) {
+    return 1;
+  }
+  if (options_.hilbert_order) {
+    return static_cast<double>(schedule_idx_) / block_schedule_.size();
+  }
+  const size_t block_idx =
+      start_idx1_ / block_size_ * num_blocks_ + start_idx2_ / block_size_;
+  return static_cast<double>(block_idx) / (num_blocks_ * num_blocks_);
+}
+
 std::vector<std::pair<image_t, image_t>> ExhaustivePairGenerator::Next() {
   image_pairs_.clear();
   if (HasFinished()) {
     return image_pairs_;
   }
 
+  if (options_.hilbert_order) {
+    // Blocks on and above the diagonal of the block matrix cover all image
+    // pairs, so each block matches all pairs between its two image sets.
+    const auto [start_idx1, start_idx2] = block_schedule_[schedule_idx_];
+    const size_t end_idx1 =
+        std::min(image_ids_.size(), start_idx1 + block_size_);
+    const size_t end_idx2 =
+        std::min(image_ids_.size(), start_idx2 + block_size_);
+
+    LOG(INFO) << StringPrintf("Processing block [%d/%d, %d/%d] (%d/%d)",
+                              start_idx1 / block_size_ + 1,
+                              num_blocks_,
+                              start_idx2 / block_size_ + 1,
+                              num_blocks_,
+                              schedule_idx_ + 1,
+                              block_schedule_.size());
+
+    for (size_t idx1 = start_idx1; idx1 < end_idx1; ++idx1) {
+      for (size_t idx2 = std::max(start_idx2, idx1 + 1); idx2 < end_idx2;
+           ++idx2) {
+        image_pairs_.emplace_back(image_ids_[idx1], image_ids_[idx2]);
+      }
+    }
+    ++schedule_idx_;
+    return image_pairs_;
+  }
+
   const size_t end_idx1 =
       std::min(image_ids_.size(), start_idx1_ + block_size_) - 1;
   const size_t end_idx2 =
@@ -234,6 +467,23 @@ std::vector<std::pair<image_t, image_t>> ExhaustivePairGenerator::Next() {
   return image_pairs_;
 }
 
+std::string ExhaustivePairGenerator::Cursor() const {
+  return FormatCursor(
+      "exhaustive",
+      {image_ids_.size(), block_size_, start_idx1_, start_idx2_, schedule_idx_});
+}
+
+void ExhaustivePairGenerator::Seek(const std::string& cursor) {
+  const std::vector<size_t> values =
+      ParseCursor("exhaustive", cursor, /*num_values=*/5);
+  THROW_CHECK_EQ(values[0], image_ids_.size());
+  THROW_CHECK_EQ(values[1], block_size_);
+  THROW_CHECK_LE(values[4], block_schedule_.size());
+  start_idx1_ = values[2];
+  start_idx2_ = values[3];
+  schedule_idx_ = values[4];
+}
+
 VocabTreePairGenerator::VocabTreePairGenerator(
     const VocabTreePairingOptions& options,
     const std::shared_ptr<FeatureMatcherCache>& cache,
@@ -301,6 +551,12 @@ VocabTreePairGenerator::VocabTreePairGenerator(
           query_image_ids) {}
 
 void VocabTreePairGenerator::Reset() {
+  // Wait for the outstanding queries and discard their results.
+  while (result_idx_ + pending_retrievals_.size() < query_idx_) {
+    THROW_CHECK(queue_.Pop().IsValid());
+    ++result_idx_;
+  }
+  pending_retrievals_.clear();
   query_idx_ = 0;
   result_idx_ = 0;
 }
@@ -309,47 +565,93 @@ bool VocabTreePairGenerator::HasFinished() const {
   return result_idx_ >= query_image_ids_.size();
 }
 
+double VocabTreePairGenerator::Progress() const {
+  if (HasFinished()) {
+    return 1;
+  }
+  return static_cast<double>(result_idx_) / query_image_ids_.size();
+}
+
 std::vector<std::pair<image_t, image_t>> VocabTreePairGenerator::Next() {
   image_pairs_.clear();
   if (HasFinished()) {
     return {};
   }
-  if (query_idx_ == 0) {
-    // Initially, make all retrieval threads busy and continue with the
-    // matching.
-    const size_t init_num_tasks =
-        std::min(query_image_ids_.size(), 2 * thread_pool_.NumThreads());
-    for (; query_idx_ < init_num_tasks; ++query_idx_) {
-      thread_pool_.AddTask(
-          &VocabTreePairGenerator::Query, this, query_image_ids_[query_idx_]);
-    }
-  }
+
+  Prefetch();
 
   LOG(INFO) << StringPrintf(
       "Processing image [%d/%d]", result_idx_ + 1, query_image_ids_.size());
 
-  // Push the next image to the retrieval queue.
-  if (query_idx_ < query_image_ids_.size()) {
-    thread_pool_.AddTask(
-        &VocabTreePairGenerator::Query, this, query_image_ids_[query_idx_++]);
+  // Pop results from the retrieval queue until the next query in order has
+  // finished, so that the generated pairs and the cursor are independent of
+  // the order, in which the retrieval threads finish.
+  auto pending_retrieval = pending_retrievals_.find(result_idx_);
+  while (pending_retrieval == pending_retrievals_.end()) {
+    auto retrieval = queue_.Pop();
+    THROW_CHECK(retrieval.IsValid());
+    const size_t query_idx = retrieval.Data().query_idx;
+    pending_retrieval =
+        pending_retrievals_.emplace(query_idx, std::move(retrieval.Data()))
+            .first;
+    if (query_idx != result_idx_) {
+      pending_retrieval = pending_retrievals_.end();
+    }
   }
 
-  // Pop the next results from the retrieval queue.
-  auto retrieval = queue_.Pop();
-  THROW_CHECK(retrieval.IsValid());
-
-  const auto& image_id = retrieval.Data().image_id;
-  const auto& image_scores = retrieval.Data().image_scores;
+  const Retrieval retrieval = std::move(pending_retrieval->second);
+  pending_retrievals_.erase(pending_retrieval);
 
   // Compose the image pairs from the scores.
-  image_pairs_.reserve(image_scores.size());
-  for (const auto& image_score : image_scores) {
-    image_pairs_.emplace_back(image_id, image_score.image_id);
+  image_pairs_.reserve(retrieval.image_scores.size());
+  for (const auto& image_score : retrieval.image_scores) {
+    image_pairs_.emplace_back(retrieval.image_id, image_score.image_id);
   }
   ++result_idx_;
   return image_pairs_;
 }
 
+std::string VocabTreePairGenerator::Cursor() const {
+  return FormatCursor("vocab_tree", {query_image_ids_.size(), result_idx_});
+}
+
+void VocabTreePairGenerator::Seek(const std::string& cursor) {
+  const std::vector<size_t> values =
+      ParseCursor("vocab_tree", cursor, /*num_values=*/2);
+  THROW_CHECK_EQ(values[0], query_image_ids_.size());
+  THROW_CHECK_LE(values[1], query_image_ids_.size());
+  Reset();
+  query_idx_ = values[1];
+  result_idx_ = values[1];
+}
+
+void VocabTreePairGenerator::Prefetch() {
+  // Keep all retrieval threads busy and continue with the matching. The
+  // number of outstanding queries stays bounded, since every query result is
+  // buffered until it is consumed.
+  const size_t max_num_pending_queries =
+      2 * thread_pool_.NumThreads() * options_.query_batch_size;
+  while (query_idx_ < query_image_ids_.size() &&
+         query_idx_ - result_idx_ < max_num_pending_queries) {
+    AddQueryTask();
+  }
+}
+
+void VocabTreePairGenerator::AddQueryTask() {
+  const size_t batch_size =
+      std::min(static_cast<size_t>(options_.query_batch_size),
+               query_image_ids_.size() - query_idx_);
+  if (batch_size == 1) {
+    thread_pool_.AddTask(&VocabTreePairGenerator::Query, this, query_idx_);
+  } else {
+    thread_pool_.AddTask(&VocabTreePairGenerator::QueryBatch,
+                         this,
+                         query_idx_,
+                         query_idx_ + batch_size);
+  }
+  query_idx_ += batch_size;
+}
+
 void VocabTreePairGenerator::IndexImages(
     const std::vector<image_t>& image_ids) {
   retrieval::VisualIndex::IndexOptions index_options;
@@ -361,35 +663,148 @@ void VocabTreePairGenerator::IndexImages(
   index_options.num_checks = options_.num_checks;
   index_options.num_threads = options_.num_threads;
 
-  for (size_t i = 0; i < image_ids.size(); ++i) {
+  const bool has_index_file =
+      !options_.index_path.empty() && ExistsFile(options_.index_path);
+  if (has_index_file) {
+    LOG(INFO) << "Reading visual index...";
+    visual_index_ = retrieval::VisualIndex::Read(options_.index_path);
+  }
+
+  std::vector<image_t> missing_image_ids;
+  missing_image_ids.reserve(image_ids.size());
+  for (const image_t image_id : image_ids) {
+    if (visual_index_ == nullptr || !visual_index_->IsImageIndexed(image_id)) {
+      missing_image_ids.push_back(image_id);
+    }
+  }
+
+  struct IndexBatch {
+    std::vector<int> image_ids;
+    std::vector<FeatureKeypoints> keypoints;
+    std::vector<FeatureDescriptorsFloat> descriptors;
+  };
+
+  auto load_batch = [this](const std::vector<image_t>& batch_image_ids) {
+    cache_->PrefetchFeatures(batch_image_ids);
+    IndexBatch batch;
+    batch.image_ids.reserve(batch_image_ids.size());
+    batch.keypoints.reserve(batch_image_ids.size());
+    batch.descriptors.reserve(batch_image_ids.size());
+    for (const image_t image_id : batch_image_ids) {
+      auto keypoints = *cache_->GetKeypoints(image_id);
+      auto descriptors = *cache_->GetDescriptors(image_id);
+      if (options_.max_num_features > 0 &&
+          descriptors.data.rows() > options_.max_num_features) {
+        ExtractTopScaleFeatures(
+            &keypoints, &descriptors, options_.max_num_features);
+      }
+      batch.image_ids.push_back(image_id);
+      batch.keypoints.push_back(std::move(keypoints));
+      batch.descriptors.push_back(descriptors.ToFloat());
+    }
+    return batch;
+  };
+
+  auto add_load_batch_task = [&](const size_t begin_idx) {
+    const size_t end_idx =
+        std::min(missing_image_ids.size(),
+                 begin_idx + static_cast<size_t>(options_.index_batch_size));
+    return thread_pool_.AddTask(
+        load_batch,
+        std::vector<image_t>(missing_image_ids.begin() + begin_idx,
+                             missing_image_ids.begin() + end_idx));
+  };
+
+  // Read the features of the next batch in the background, while the
+  // descriptors of the current batch are quantized.
+  std::shared_future<IndexBatch> next_batch;
+  if (!missing_image_ids.empty()) {
+    next_batch = add_load_batch_task(0);
+  }
+
+  for (size_t begin_idx = 0; begin_idx < missing_image_ids.size();
+       begin_idx += options_.index_batch_size) {
     Timer timer;
     timer.Start();
-    LOG(INFO) << StringPrintf(
-        "Indexing image [%d/%d]", i + 1, image_ids.size());
-    auto keypoints = *cache_->GetKeypoints(image_ids[i]);
-    auto descriptors = *cache_->GetDescriptors(image_ids[i]);
+    const size_t end_idx =
+        std::min(missing_image_ids.size(),
+                 begin_idx + static_cast<size_t>(options_.index_batch_size));
+    LOG(INFO) << StringPrintf("Indexing images [%d-%d/%d]",
+                              begin_idx + 1,
+                              end_idx,
+                              missing_image_ids.size());
+
+    const std::shared_future<IndexBatch> batch_future = next_batch;
+    const IndexBatch& batch = batch_future.get();
+    if (end_idx < missing_image_ids.size()) {
+      next_batch = add_load_batch_task(end_idx);
+    }
+
     if (visual_index_ == nullptr) {
       visual_index_ = retrieval::VisualIndex::Read(
           options_.vocab_tree_path.empty()
-              ? GetVocabTreeUriForFeatureType(descriptors.type)
+              ? GetVocabTreeUriForFeatureType(batch.descriptors.front().type)
               : options_.vocab_tree_path);
     }
-    if (options_.max_num_features > 0 &&
-        descriptors.data.rows() > options_.max_num_features) {
-      ExtractTopScaleFeatures(
-          &keypoints, &descriptors, options_.max_num_features);
+
+    std::vector<const FeatureKeypoints*> keypoints_ptrs(batch.keypoints.size());
+    std::vector<const FeatureDescriptorsFloat*> descriptors_ptrs(
+        batch.descriptors.size());
+    for (size_t i = 0; i < batch.image_ids.size(); ++i) {
+      keypoints_ptrs[i] = &batch.keypoints[i];
+      descriptors_ptrs[i] = &batch.descriptors[i];
     }
-    visual_index_->Add(
-        index_options, image_ids[i], keypoints, descriptors.ToFloat());
+    visual_index_->AddBatch(
+        index_options, batch.image_ids, keypoints_ptrs, descriptors_ptrs);
     LOG(INFO) << StringPrintf(" in %.3fs", timer.ElapsedSeconds());
   }
 
+  if (visual_index_ == nullptr) {
+    return;
+  }
+
   // Compute the TF-IDF weights, etc.
   visual_index_->Prepare();
+
+  // Save the newly indexed images. Appending them as a delta segment avoids
+  // rewriting a large index for a few new images, until the index file is
+  // compacted again.
+  constexpr int kMaxNumDeltaSegments = 10;
+  if (!options_.index_path.empty() && !missing_image_ids.empty()) {
+    if (has_index_file &&
+        visual_index_->NumDeltaSegments() < kMaxNumDeltaSegments) {
+      visual_index_->AppendImages(options_.index_path);
+    } else {
+      visual_index_->Write(options_.index_path);
+    }
+  }
+
+  // A persisted index may contain images that were since deleted from the
+  // database, which must not be retrieved.
+  if (visual_index_->NumImages() > image_ids.size()) {
+    database_image_ids_.insert(image_ids.begin(), image_ids.end());
+  }
+}
+
+void VocabTreePairGenerator::FilterImageScores(
+    std::vector<retrieval::ImageScore>* image_scores) const {
+  if (database_image_ids_.empty()) {
+    return;
+  }
+  image_scores->erase(
+      std::remove_if(image_scores->begin(),
+                     image_scores->end(),
+                     [this](const retrieval::ImageScore& image_score) {
+                       return database_image_ids_.count(
+                                  image_score.image_id) == 0;
+                     }),
+      image_scores->end());
 }
 
-void VocabTreePairGenerator::Query(const image_t image_id) {
+void VocabTreePairGenerator::Query(const size_t query_idx) {
+  const image_t image_id = query_image_ids_[query_idx];
   Retrieval retrieval;
+  retrieval.query_idx = query_idx;
   retrieval.image_id = image_id;
 
   // Each query must push exactly one result, because the consuming Next() pops
@@ -410,6 +825,7 @@ void VocabTreePairGenerator::Query(const image_t image_id) {
                          keypoints,
                          descriptors.ToFloat(),
                          &retrieval.image_scores);
+    FilterImageScores(&retrieval.image_scores);
   } catch (const std::exception& error) {
     LOG(ERROR) << "Failed to query image " << image_id
                << " against vocabulary tree, skipping: " << error.what();
@@ -419,6 +835,215 @@ void VocabTreePairGenerator::Query(const image_t image_id) {
   THROW_CHECK(queue_.Push(std::move(retrieval)));
 }
 
+void VocabTreePairGenerator::QueryBatch(const size_t begin_idx,
+                                        const size_t end_idx) {
+  const std::vector<image_t> image_ids(query_image_ids_.begin() + begin_idx,
+                                       query_image_ids_.begin() + end_idx);
+  std::vector<std::vector<retrieval::ImageScore>> image_scores;
+  try {
+    std::vector<FeatureKeypoints> keypoints(image_ids.size());
+    std::vector<FeatureDescriptorsFloat> descriptors(image_ids.size());
+    std::vector<const FeatureKeypoints*> keypoints_ptrs(image_ids.size());
+    std::vector<const FeatureDescriptorsFloat*> descriptors_ptrs(
+        image_ids.size());
+    for (size_t i = 0; i < image_ids.size(); ++i) {
+      keypoints[i] = *cache_->GetKeypoints(image_ids[i]);
+      auto image_descriptors = *cache_->GetDescriptors(image_ids[i]);
+      if (options_.max_num_features > 0 &&
+          image_descriptors.data.rows() > options_.max_num_features) {
+        ExtractTopScaleFeatures(
+            &keypoints[i], &image_descriptors, options_.max_num_features);
+      }
+      descriptors[i] = image_descriptors.ToFloat();
+      keypoints_ptrs[i] = &keypoints[i];
+      descriptors_ptrs[i] = &descriptors[i];
+    }
+
+    visual_index_->QueryBatch(
+        query_options_, keypoints_ptrs, descriptors_ptrs, &image_scores);
+  } catch (const std::exception& error) {
+    // Fall back to individual queries, so that a single failing image does
+    // not discard the retrieval results of the entire batch.
+    LOG(WARNING) << "Failed to query batch of " << image_ids.size()
+                 << " images against vocabulary tree, querying individually: "
+                 << error.what();
+    for (size_t query_idx = begin_idx; query_idx < end_idx; ++query_idx) {
+      Query(query_idx);
+    }
+    return;
+  }
+
+  THROW_CHECK_EQ(image_scores.size(), image_ids.size());
+  for (size_t i = 0; i < image_ids.size(); ++i) {
+    Retrieval retrieval;
+    retrieval.query_idx = begin_idx + i;
+    retrieval.image_id = image_ids[i];
+    retrieval.image_scores = std::move(image_scores[i]);
+    FilterImageScores(&retrieval.image_scores);
+    THROW_CHECK(queue_.Push(std::move(retrieval)));
+  }
+}
+
+GlobalDescriptorPairGenerator::GlobalDescriptorPairGenerator(
+    const GlobalDescriptorPairingOptions& options,
+    const std::shared_ptr<FeatureMatcherCache>& cache)
+    : options_(options), image_ids_(THROW_CHECK_NOTNULL(cache)->GetImageIds()) {
+  THROW_CHECK(options.Check());
+  LOG(INFO) << "Generating image pairs with global image descriptors...";
+
+  const int num_images = image_ids_.size();
+  if (num_images == 0) {
+    return;
+  }
+
+  Timer timer;
+  timer.Start();
+  retrieval::VLADCodebook codebook;
+  if (!options_.codebook_path.empty() &&
+      ExistsFile(options_.codebook_path)) {
+    LOG(INFO) << "Reading codebook...";
+    codebook.Read(options_.codebook_path);
+  } else {
+    LOG(INFO) << "Training codebook...";
+    codebook = TrainVLADCodebook(options_, *cache, image_ids_);
+    if (!options_.codebook_path.empty()) {
+      codebook.Write(options_.codebook_path);
+    }
+  }
+  const uint64_t codebook_hash = codebook.Hash();
+  LOG(INFO) << StringPrintf(" in %.3fs", timer.ElapsedSeconds());
+
+  timer.Restart();
+  LOG(INFO) << "Computing global image descriptors...";
+
+  std::vector<std::optional<GlobalImageDescriptor>> stored_descriptors(
+      num_images);
+  cache->AccessDatabase([&](Database& database) {
+    for (int i = 0; i < num_images; ++i) {
+      stored_descriptors[i] = database.ReadGlobalImageDescriptor(image_ids_[i]);
+    }
+  });
+
+  // Descriptors of another codebook are not comparable and are recomputed.
+  FeatureDescriptorsFloat global_descriptors(
+      FeatureExtractorType::UNDEFINED,
+      FeatureDescriptorsFloatData(num_images, codebook.Dim()));
+  std::vector<char> is_computed(num_images, false);
+  ParallelFor(
+      0,
+      num_images,
+      [&](const int64_t begin, const int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          const std::optional<GlobalImageDescriptor>& stored_descriptor =
+              stored_descriptors[i];
+          if (stored_descriptor.has_value() &&
+              stored_descriptor->model_hash == codebook_hash &&
+              stored_descriptor->data.size() == codebook.Dim()) {
+            global_descriptors.data.row(i) =
+                stored_descriptor->data.transpose();
+          } else {
+            global_descriptors.data.row(i) =
+                codebook
+                    .Aggregate(ReadNormalizedDescriptors(
+                        *cache, image_ids_[i], options_.max_num_features))
+                    .transpose();
+            is_computed[i] = true;
+          }
+        }
+      },
+      options_.num_threads);
+
+  int num_computed = 0;
+  cache->AccessDatabase([&](Database& database) {
+    GlobalImageDescriptor descriptor;
+    descriptor.model_hash = codebook_hash;
+    for (int i = 0; i < num_images; ++i) {
+      if (is_computed[i]) {
+        descriptor.data = global_descriptors.data.row(i).transpose();
+        database.WriteGlobalImageDescriptor(image_ids_[i], descriptor);
+        ++num_computed;
+      }
+    }
+  });
+
+  LOG(INFO) << StringPrintf(" in %.3fs (%d computed, %d reused)",
+                            timer.ElapsedSeconds(),
+                            num_computed,
+                            num_images - num_computed);
+
+  timer.Restart();
+  LOG(INFO) << "Searching for nearest neighbors...";
+
+  const int num_threads = GetEffectiveNumThreads(options_.num_threads);
+  auto index = FeatureDescriptorIndex::Create(
+      FeatureDescriptorIndex::Type::DEFAULT, num_threads);
+  index->Build(global_descriptors);
+  Eigen::RowMajorMatrixXf l2_dists;
+  index->Search(/*num_neighbors=*/options_.num_images + 1,
+                global_descriptors,
+                index_matrix_,
+                l2_dists);
+
+  LOG(INFO) << StringPrintf(" in %.3fs", timer.ElapsedSeconds());
+}
+
+GlobalDescriptorPairGenerator::GlobalDescriptorPairGenerator(
+    const GlobalDescriptorPairingOptions& options,
+    const std::shared_ptr<Database>& database)
+    : GlobalDescriptorPairGenerator(
+          options,
+          std::make_shared<FeatureMatcherCache>(
+              options.CacheSize(), THROW_CHECK_NOTNULL(database))) {}
+
+void GlobalDescriptorPairGenerator::Reset() { current_idx_ = 0; }
+
+bool GlobalDescriptorPairGenerator::HasFinished() const {
+  return current_idx_ >= static_cast<size_t>(index_matrix_.rows());
+}
+
+double GlobalDescriptorPairGenerator::Progress() const {
+  if (HasFinished()) {
+    return 1;
+  }
+  return static_cast<double>(current_idx_) / index_matrix_.rows();
+}
+
+std::vector<std::pair<image_t, image_t>> GlobalDescriptorPairGenerator::Next() {
+  image_pairs_.clear();
+  if (HasFinished()) {
+    return image_pairs_;
+  }
+
+  LOG(INFO) << StringPrintf(
+      "Processing image [%d/%d]", current_idx_ + 1, index_matrix_.rows());
+  const image_t image_id = image_ids_[current_idx_];
+  for (Eigen::Index j = 0; j < index_matrix_.cols(); ++j) {
+    const int nn_idx = index_matrix_(current_idx_, j);
+    // Missing neighbors are marked with an invalid index.
+    if (nn_idx < 0 || nn_idx == static_cast<int>(current_idx_)) {
+      continue;
+    }
+    image_pairs_.emplace_back(image_id, image_ids_[nn_idx]);
+    if (image_pairs_.size() >= static_cast<size_t>(options_.num_images)) {
+      break;
+    }
+  }
+  ++current_idx_;
+  return image_pairs_;
+}
+
+std::string GlobalDescriptorPairGenerator::Cursor() const {
+  return FormatCursor("global_descriptor", {image_ids_.size(), current_idx_});
+}
+
+void GlobalDescriptorPairGenerator::Seek(const std::string& cursor) {
+  const std::vector<size_t> values =
+      ParseCursor("global_descriptor", cursor, /*num_values=*/2);
+  THROW_CHECK_EQ(values[0], image_ids_.size());
+  THROW_CHECK_LE(values[1], static_cast<size_t>(index_matrix_.rows()));
+  current_idx_ = values[1];
+}
+
 SequentialPairGenerator::SequentialPairGenerator(
     const SequentialPairingOptions& options,
     const std::shared_ptr<FeatureMatcherCache>& cache)
@@ -474,6 +1099,20 @@ bool SequentialPairGenerator::HasFinished() const {
                                      : true);
 }
 
+double SequentialPairGenerator::Progress() const {
+  if (HasFinished()) {
+    return 1;
+  }
+  const double progress =
+      static_cast<double>(std::min(image_idx_, image_ids_.size())) /
+      image_ids_.size();
+  if (vocab_tree_pair_generator_) {
+    // Loop detection runs after the sequential pairs.
+    return 0.5 * (progress + vocab_tree_pair_generator_->Progress());
+  }
+  return progress;
+}
+
 std::vector<std::pair<image_t, image_t>> SequentialPairGenerator::Next() {
   image_pairs_.clear();
   if (image_idx_ >= image_ids_.size()) {
@@ -485,6 +1124,12 @@ std::vector<std::pair<image_t, image_t>> SequentialPairGenerator::Next() {
   LOG(INFO) << StringPrintf(
       "Processing image [%d/%d]", image_idx_ + 1, image_ids_.size());
 
+  // Retrieve the loop detection pairs in the background while the sequential
+  // pairs are matched, instead of only once all sequential pairs are done.
+  if (vocab_tree_pair_generator_) {
+    vocab_tree_pair_generator_->Prefetch();
+  }
+
   const auto image_id1 = image_ids_.at(image_idx_);
 
   // If image is part of a rig, then pair the other images in the same frame.
@@ -516,7 +1161,8 @@ std::vector<std::pair<image_t, image_t>> SequentialPairGenerator::Next() {
     }
   };
 
-  for (int i = 0; i < options_.overlap; ++i) {
+  const int overlap = CurrentOverlap();
+  for (int i = 0; i < overlap; ++i) {
     if (options_.quadratic_overlap) {
       const size_t image_idx_2_quadratic = image_idx_ + (1ull << i);
       if (image_idx_2_quadratic < image_ids_.size()) {
@@ -541,6 +1187,68 @@ std::vector<std::pair<image_t, image_t>> SequentialPairGenerator::Next() {
   return image_pairs_;
 }
 
+std::string SequentialPairGenerator::Cursor() const {
+  return FormatCursor(
+      "sequential",
+      {image_ids_.size(), image_idx_},
+      vocab_tree_pair_generator_ ? vocab_tree_pair_generator_->Cursor() : "");
+}
+
+void SequentialPairGenerator::Seek(const std::string& cursor) {
+  std::string vocab_tree_cursor;
+  const std::vector<size_t> values = ParseCursor(
+      "sequential", cursor, /*num_values=*/2, &vocab_tree_cursor);
+  THROW_CHECK_EQ(values[0], image_ids_.size());
+  THROW_CHECK_LE(values[1], image_ids_.size());
+  THROW_CHECK_EQ(vocab_tree_pair_generator_ != nullptr,
+                 !vocab_tree_cursor.empty());
+  if (vocab_tree_pair_generator_) {
+    vocab_tree_pair_generator_->Seek(vocab_tree_cursor);
+  }
+  image_idx_ = values[1];
+}
+
+int SequentialPairGenerator::CurrentOverlap() const {
+  if (!options_.adaptive_overlap || image_idx_ == 0) {
+    return options_.overlap;
+  }
+
+  // Find the farthest neighbor of the previous image with sufficiently many
+  // inlier matches. The overlap is derived from the matching results in the
+  // database, so that it is also restored after seeking to a cursor.
+  const size_t prev_image_idx = image_idx_ - 1;
+  const image_t prev_image_id = image_ids_[prev_image_idx];
+  int max_inlier_neighbor_idx = -1;
+  for (int i = 0; i < options_.overlap; ++i) {
+    const size_t neighbor_image_idx =
+        prev_image_idx +
+        (options_.quadratic_overlap ? (size_t{1} << i) : (i + 1));
+    if (neighbor_image_idx >= image_ids_.size()) {
+      break;
+    }
+    const image_t neighbor_image_id = image_ids_[neighbor_image_idx];
+    size_t num_inliers = 0;
+    if (cache_->ExistsTwoViewGeometry(prev_image_id, neighbor_image_id)) {
+      num_inliers =
+          cache_->GetTwoViewGeometry(prev_image_id, neighbor_image_id)
+              .inlier_matches.size();
+    } else if (cache_->ExistsMatches(prev_image_id, neighbor_image_id)) {
+      num_inliers = cache_->GetMatches(prev_image_id, neighbor_image_id).size();
+    } else {
+      // Neighbors beyond the overlap of the previous image were not matched.
+      break;
+    }
+    if (num_inliers >=
+        static_cast<size_t>(options_.adaptive_overlap_min_num_inliers)) {
+      max_inlier_neighbor_idx = i;
+    }
+  }
+
+  // Grow the overlap by at most one neighbor per image, so that it recovers
+  // once the number of inlier matches increases again.
+  return std::clamp(max_inlier_neighbor_idx + 2, 1, options_.overlap);
+}
+
 std::vector<image_t> SequentialPairGenerator::GetOrderedImageIds() const {
   const std::vector<image_t> image_ids = cache_->GetImageIds();
 
@@ -595,8 +1303,11 @@ SpatialPairGenerator::SpatialPairGenerator(
   timer.Restart();
   LOG(INFO) << "Building search index...";
 
-  faiss::IndexFlatL2 search_index(/*d=*/3);
-  search_index.add(position_matrix.rows(), position_matrix.data());
+  std::vector<Eigen::Vector3d> positions(num_positions);
+  for (int i = 0; i < num_positions; ++i) {
+    positions[i] = position_matrix.row(i).transpose().cast<double>();
+  }
+  const KdTree search_index(positions);
 
   LOG(INFO) << StringPrintf(" in %.3fs", timer.ElapsedSeconds());
 
@@ -606,16 +1317,45 @@ SpatialPairGenerator::SpatialPairGenerator(
   knn_ = std::min(options_.max_num_neighbors + 1, num_positions);
   image_pairs_.reserve(knn_);
 
-  index_matrix_.resize(num_positions, knn_);
-  distance_squared_matrix_.resize(num_positions, knn_);
-
-  omp_set_num_threads(GetEffectiveNumThreads(options_.num_threads));
+  // Missing neighbors are marked with an invalid index.
+  index_matrix_.setConstant(num_positions, knn_, -1);
+  distance_squared_matrix_.setConstant(
+      num_positions, knn_, std::numeric_limits<float>::infinity());
+
+  // Without a minimum number of neighbors, neighbors beyond the maximum
+  // distance are never paired, so the search can be limited to that radius.
+  const double max_search_distance =
+      options_.min_num_neighbors > 0 ? std::numeric_limits<double>::infinity()
+                                     : options_.max_distance;
+
+  auto SearchNeighbors = [&](const int begin_idx, const int end_idx) {
+    std::vector<KdTree::Neighbor> neighbors;
+    for (int i = begin_idx; i < end_idx; ++i) {
+      search_index.KnnSearch(
+          positions[i], knn_, &neighbors, max_search_distance);
+      for (size_t j = 0; j < neighbors.size(); ++j) {
+        index_matrix_(i, j) = static_cast<int64_t>(neighbors[j].first);
+        distance_squared_matrix_(i, j) =
+            static_cast<float>(neighbors[j].second);
+      }
+    }
+  };
 
-  search_index.search(position_matrix.rows(),
-                      position_matrix.data(),
-                      knn_,
-                      distance_squared_matrix_.data(),
-                      index_matrix_.data());
+  const int num_threads = GetEffectiveNumThreads(options_.num_threads);
+  constexpr int kNumPositionsPerTask = 1024;
+  if (num_threads == 1 || num_positions <= kNumPositionsPerTask) {
+    SearchNeighbors(0, num_positions);
+  } else {
+    ThreadPool thread_pool(num_threads);
+    for (int begin_idx = 0; begin_idx < num_positions;
+         begin_idx += kNumPositionsPerTask) {
+      thread_pool.AddTask(SearchNeighbors,
+                          begin_idx,
+                          std::min(begin_idx + kNumPositionsPerTask,
+                                   num_positions));
+    }
+    thread_pool.Wait();
+  }
 
   LOG(INFO) << StringPrintf(" in %.3fs", timer.ElapsedSeconds());
 }
@@ -634,6 +1374,13 @@ bool SpatialPairGenerator::HasFinished() const {
   return current_idx_ >= position_idxs_.size();
 }
 
+double SpatialPairGenerator::Progress() const {
+  if (HasFinished()) {
+    return 1;
+  }
+  return static_cast<double>(current_idx_) / position_idxs_.size();
+}
+
 std::vector<std::pair<image_t, image_t>> SpatialPairGenerator::Next() {
   image_pairs_.clear();
   if (HasFinished()) {
@@ -645,6 +1392,11 @@ std::vector<std::pair<image_t, image_t>> SpatialPairGenerator::Next() {
   const float max_distance_squared =
       static_cast<float>(options_.max_distance * options_.max_distance);
   for (int j = 0; j < knn_; ++j) {
+    // The remaining neighbors are beyond the search radius.
+    if (index_matrix_(current_idx_, j) < 0) {
+      break;
+    }
+
     // Check if query equals result.
     if (index_matrix_(current_idx_, j) == static_cast<int>(current_idx_)) {
       continue;
@@ -666,10 +1418,25 @@ std::vector<std::pair<image_t, image_t>> SpatialPairGenerator::Next() {
   return image_pairs_;
 }
 
+std::string SpatialPairGenerator::Cursor() const {
+  return FormatCursor("spatial",
+                      {image_ids_.size(), position_idxs_.size(), current_idx_});
+}
+
+void SpatialPairGenerator::Seek(const std::string& cursor) {
+  const std::vector<size_t> values =
+      ParseCursor("spatial", cursor, /*num_values=*/3);
+  THROW_CHECK_EQ(values[0], image_ids_.size());
+  THROW_CHECK_EQ(values[1], position_idxs_.size());
+  THROW_CHECK_LE(values[2], position_idxs_.size());
+  current_idx_ = values[2];
+}
+
 Eigen::RowMajorMatrixXf SpatialPairGenerator::ReadPositionPriorData(
     FeatureMatcherCache& cache) {
-  GPSTransform gps_transform;
-  std::vector<Eigen::Vector3d> ells(1);
+  // GPS positions are collected and converted in a single batch.
+  std::vector<Eigen::Vector3d> ells;
+  std::vector<size_t> ell_position_idxs;
 
   Eigen::RowMajorMatrixXd position_matrix(image_ids_.size(), 3);
   position_idxs_.clear();
@@ -690,17 +1457,12 @@ Eigen::RowMajorMatrixXf SpatialPairGenerator::ReadPositionPriorData(
     position_idxs_.push_back(i);
 
     switch (pose_prior->coordinate_system) {
-      case PosePrior::CoordinateSystem::WGS84: {
-        ells[0](0) = pose_prior->position(0);
-        ells[0](1) = pose_prior->position(1);
-        ells[0](2) = options_.ignore_z ? 0 : pose_prior->position(2);
-
-        const std::vector<Eigen::Vector3d> xyzs =
-            gps_transform.EllipsoidToECEF(ells);
-        position_matrix(position_idx, 0) = xyzs[0](0);
-        position_matrix(position_idx, 1) = xyzs[0](1);
-        position_matrix(position_idx, 2) = xyzs[0](2);
-      } break;
+      case PosePrior::CoordinateSystem::WGS84:
+        ells.emplace_back(pose_prior->position(0),
+                          pose_prior->position(1),
+                          options_.ignore_z ? 0 : pose_prior->position(2));
+        ell_position_idxs.push_back(position_idx);
+        break;
       case PosePrior::CoordinateSystem::UNDEFINED:
       default:
         LOG(WARNING) << "Unknown coordinate system for image " << image_ids_[i]
@@ -713,6 +1475,14 @@ Eigen::RowMajorMatrixXf SpatialPairGenerator::ReadPositionPriorData(
     }
   }
 
+  if (!ells.empty()) {
+    const std::vector<Eigen::Vector3d> xyzs =
+        GPSTransform().EllipsoidToECEF(ells);
+    for (size_t i = 0; i < xyzs.size(); ++i) {
+      position_matrix.row(ell_position_idxs[i]) = xyzs[i].transpose();
+    }
+  }
+
   // Subtract the mean coordinate before casting to float for better numerical
   // precision when dealing with large coordinates (e.g. GPS). For even better
   // precision, we could also rescale the coordinates.
@@ -778,31 +1548,81 @@ std::vector<std::pair<image_t, image_t>> TransitivePairGenerator::Next() {
             database.ReadTwoViewGeometryNumInliers();
       });
 
-  std::map<image_t, std::vector<image_t>> adjacency;
-  for (const auto& [pair_id, _] : existing_pair_ids_and_num_inliers) {
+  std::map<image_t, std::vector<std::pair<image_t, int>>> adjacency;
+  for (const auto& [pair_id, num_inliers] : existing_pair_ids_and_num_inliers) {
     const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
-    adjacency[image_id1].push_back(image_id2);
-    adjacency[image_id2].push_back(image_id1);
+    adjacency[image_id1].emplace_back(image_id2, num_inliers);
+    adjacency[image_id2].emplace_back(image_id1, num_inliers);
     image_pair_ids_.insert(pair_id);
   }
 
-  for (const auto& image : adjacency) {
-    const auto image_id1 = image.first;
-    for (const auto& image_id2 : image.second) {
-      const auto it = adjacency.find(image_id2);
-      if (it == adjacency.end()) {
-        continue;
-      }
-      for (const auto& image_id3 : it->second) {
-        if (image_id1 == image_id3) {
-          continue;
-        }
-        const auto image_pair_id = ImagePairToPairId(image_id1, image_id3);
-        if (image_pair_ids_.count(image_pair_id) != 0) {
-          continue;
+  std::vector<decltype(adjacency)::const_iterator> images;
+  images.reserve(adjacency.size());
+  for (auto it = adjacency.cbegin(); it != adjacency.cend(); ++it) {
+    images.push_back(it);
+  }
+
+  // Expand the neighbors of all images in parallel. Every image keeps its
+  // best candidates, scored by the product of the inlier counts along the
+  // best path. The adjacency and the existing pairs are only read here.
+  std::vector<std::vector<std::pair<image_t, double>>> candidates(
+      images.size());
+  ParallelFor(
+      0,
+      images.size(),
+      [&](const int64_t begin, const int64_t end) {
+        std::unordered_map<image_t, double> scores;
+        for (int64_t image_idx = begin; image_idx < end; ++image_idx) {
+          const auto& [image_id1, neighbors1] = *images[image_idx];
+          scores.clear();
+          for (const auto& [image_id2, num_inliers12] : neighbors1) {
+            const auto it = adjacency.find(image_id2);
+            if (it == adjacency.end()) {
+              continue;
+            }
+            for (const auto& [image_id3, num_inliers23] : it->second) {
+              if (image_id1 == image_id3 ||
+                  image_pair_ids_.count(
+                      ImagePairToPairId(image_id1, image_id3)) != 0) {
+                continue;
+              }
+              double& score = scores[image_id3];
+              score = std::max(
+                  score, static_cast<double>(num_inliers12) * num_inliers23);
+            }
+          }
+
+          auto& image_candidates = candidates[image_idx];
+          image_candidates.assign(scores.begin(), scores.end());
+          const size_t max_num_candidates =
+              options_.max_num_candidates_per_image;
+          if (options_.max_num_candidates_per_image > 0 &&
+              image_candidates.size() > max_num_candidates) {
+            std::partial_sort(
+                image_candidates.begin(),
+                image_candidates.begin() + max_num_candidates,
+                image_candidates.end(),
+                [](const auto& candidate1, const auto& candidate2) {
+                  if (candidate1.second != candidate2.second) {
+                    return candidate1.second > candidate2.second;
+                  }
+                  return candidate1.first < candidate2.first;
+                });
+            image_candidates.resize(max_num_candidates);
+          }
         }
+      },
+      GetEffectiveNumThreads(options_.num_threads),
+      /*grain_size=*/16);
+
+  // Keep a pair if it is among the best candidates of either image and
+  // deduplicate the pairs in the order of the images.
+  for (size_t image_idx = 0; image_idx < images.size(); ++image_idx) {
+    const image_t image_id1 = images[image_idx]->first;
+    for (const auto& [image_id3, _] : candidates[image_idx]) {
+      if (image_pair_ids_.insert(ImagePairToPairId(image_id1, image_id3))
+              .second) {
         image_pairs_.emplace_back(std::minmax(image_id1, image_id3));
-        image_pair_ids_.insert(image_pair_id);
       }
     }
   }
@@ -846,6 +1666,13 @@ bool ImportedPairGenerator::HasFinished() const {
   return pair_idx_ >= image_pairs_.size();
 }
 
+double ImportedPairGenerator::Progress() const {
+  if (HasFinished()) {
+    return 1;
+  }
+  return static_cast<double>(pair_idx_) / image_pairs_.size();
+}
+
 std::vector<std::pair<image_t, image_t>> ImportedPairGenerator::Next() {
   block_image_pairs_.clear();
   if (HasFinished()) {
@@ -865,6 +1692,17 @@ std::vector<std::pair<image_t, image_t>> ImportedPairGenerator::Next() {
   return block_image_pairs_;
 }
 
+std::string ImportedPairGenerator::Cursor() const {
+  return FormatCursor("imported", {image_pairs_.size(), pair_idx_});
+}
+
+void ImportedPairGenerator::Seek(const std::string& cursor) {
+  const std::vector<size_t> values =
+      ParseCursor("imported", cursor, /*num_values=*/2);
+  THROW_CHECK_EQ(values[0], image_pairs_.size());
+  pair_idx_ = values[1];
+}
+
 ExistingMatchedPairGenerator::ExistingMatchedPairGenerator(
     const ExistingMatchedPairingOptions& options,
     const std::shared_ptr<FeatureMatcherCache>& cache)
@@ -896,6 +1734,13 @@ bool ExistingMatchedPairGenerator::HasFinished() const {
   return start_idx_ >= image_pairs_.size();
 }
 
+double ExistingMatchedPairGenerator::Progress() const {
+  if (HasFinished()) {
+    return 1;
+  }
+  return static_cast<double>(start_idx_) / image_pairs_.size();
+}
+
 std::vector<std::pair<image_t, image_t>> ExistingMatchedPairGenerator::Next() {
   if (HasFinished()) {
     return {};
@@ -919,4 +1764,75 @@ std::vector<std::pair<image_t, image_t>> ExistingMatchedPairGenerator::Next() {
   return batch;
 }
 
+ShardedPairGenerator::ShardedPairGenerator(
+    std::unique_ptr<PairGenerator> generator,
+    const int shard_index,
+    const int num_shards)
+    : generator_(std::move(THROW_CHECK_NOTNULL(generator))),
+      shard_index_(shard_index),
+      num_shards_(num_shards) {
+  THROW_CHECK_GT(num_shards_, 0);
+  THROW_CHECK_GE(shard_index_, 0);
+  THROW_CHECK_LT(shard_index_, num_shards_);
+}
+
+void ShardedPairGenerator::Reset() { generator_->Reset(); }
+
+bool ShardedPairGenerator::HasFinished() const {
+  return generator_->HasFinished();
+}
+
+double ShardedPairGenerator::Progress() const {
+  return generator_->Progress();
+}
+
+std::vector<std::pair<image_t, image_t>> ShardedPairGenerator::Next() {
+  // Skip batches without any pairs of this shard, so that the matcher is not
+  // invoked for empty batches.
+  std::vector<std::pair<image_t, image_t>> image_pairs;
+  while (image_pairs.empty() && !generator_->HasFinished()) {
+    image_pairs = generator_->Next();
+    image_pairs.erase(
+        std::remove_if(image_pairs.begin(),
+                       image_pairs.end(),
+                       [this](const std::pair<image_t, image_t>& image_pair) {
+                         return !IsInShard(image_pair.first,
+                                           image_pair.second,
+                                           shard_index_,
+                                           num_shards_);
+                       }),
+        image_pairs.end());
+  }
+  return image_pairs;
+}
+
+std::string ShardedPairGenerator::Cursor() const {
+  const std::string cursor = generator_->Cursor();
+  if (cursor.empty()) {
+    return "";
+  }
+  return FormatCursor("sharded",
+                      {static_cast<size_t>(shard_index_),
+                       static_cast<size_t>(num_shards_)},
+                      cursor);
+}
+
+void ShardedPairGenerator::Seek(const std::string& cursor) {
+  std::string nested_cursor;
+  const std::vector<size_t> values =
+      ParseCursor("sharded", cursor, /*num_values=*/2, &nested_cursor);
+  THROW_CHECK_EQ(values[0], static_cast<size_t>(shard_index_));
+  THROW_CHECK_EQ(values[1], static_cast<size_t>(num_shards_));
+  generator_->Seek(nested_cursor);
+}
+
+bool ShardedPairGenerator::IsInShard(const image_t image_id1,
+                                     const image_t image_id2,
+                                     const int shard_index,
+                                     const int num_shards) {
+  return ImagePairToPairId(image_id1, image_id2) %
+             static_cast<image_pair_t>(num_shards) ==
+         static_cast<image_pair_t>(shard_index);
+}
+
 }  // namespace colmap
@@ -36,6 +36,9 @@
 #include "colmap/util/types.h"
 
 #include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace colmap {
@@ -44,11 +47,21 @@ struct ExhaustivePairingOptions {
   // Block size, i.e. number of images to simultaneously load into memory.
   int block_size = 50;
 
+  // Whether to visit the blocks along a Hilbert curve over the upper triangle
+  // of the block matrix instead of row by row. Consecutive blocks then share
+  // one set of images and blocks close on the curve share many images, so
+  // that, together with a cache of more than two sets of images, features are
+  // read from the database far fewer times.
+  bool hilbert_order = false;
+
+  // Number of image sets of size block_size to hold in the cache.
+  int num_cached_blocks = 2;
+
   bool Check() const;
 
   // Each block matches two sets of images with size block_size. To hold all
-  // images in the block, the cache thus needs to hold 2 * block_size.
-  inline size_t CacheSize() const { return 2 * block_size; }
+  // images in the block, the cache needs to hold at least 2 * block_size.
+  inline size_t CacheSize() const { return num_cached_blocks * block_size; }
 };
 
 struct VocabTreePairingOptions {
@@ -78,6 +91,53 @@ struct VocabTreePairingOptions {
   // Number of threads for indexing and retrieval.
   int num_threads = -1;
 
+  // Number of query images retrieved together in one batch. Batched queries
+  // quantize all descriptors at once and walk every inverted file once.
+  int query_batch_size = 1;
+
+  // Number of images indexed together in one batch. The features of the next
+  // batch are read while the descriptors of the current batch are quantized.
+  int index_batch_size = 16;
+
+  // Optional path to the index of the database images. If the file exists,
+  // the index is read from it instead of the vocabulary tree and only images
+  // missing from the index are indexed. The newly indexed images are then
+  // saved to the file, such that later runs skip indexing. Images must not
+  // change their features while their identifiers remain in the index.
+  std::filesystem::path index_path;
+
+  bool Check() const;
+
+  inline size_t CacheSize() const { return 5 * num_images; }
+};
+
+struct GlobalDescriptorPairingOptions {
+  // Number of images to retrieve for each query image.
+  int num_images = 50;
+
+  // Number of centroids of the codebook, which aggregates the local features
+  // of an image into its global descriptor. The global descriptors have the
+  // number of centroids times the local descriptor dimension.
+  int num_clusters = 16;
+
+  // Maximum number of local features used to train the codebook. The features
+  // are sampled evenly from all images.
+  int codebook_num_training_features = 100000;
+
+  // The maximum number of features aggregated into the global descriptor of
+  // an image. If an image has more features, only the largest-scale features
+  // are aggregated.
+  int max_num_features = -1;
+
+  // Optional path to the codebook. If the file exists, the codebook is read
+  // from it. Otherwise, the codebook is trained on the images and written to
+  // it, such that later runs reuse the codebook and the global descriptors
+  // stored in the database.
+  std::filesystem::path codebook_path;
+
+  // Number of threads for computing the descriptors and for retrieval.
+  int num_threads = -1;
+
   bool Check() const;
 
   inline size_t CacheSize() const { return 5 * num_images; }
@@ -90,6 +150,15 @@ struct SequentialPairingOptions {
   // Whether to match images against their quadratic neighbors.
   bool quadratic_overlap = true;
 
+  // Whether to adapt the overlap to the decay of the number of inlier matches
+  // along the sequence. The overlap of an image is then one neighbor more than
+  // the farthest neighbor of the previous image with at least
+  // adaptive_overlap_min_num_inliers inlier matches, and at most `overlap`.
+  // This avoids matching many redundant pairs, if the number of inlier matches
+  // quickly decays along the sequence, e.g., for fast camera motion.
+  bool adaptive_overlap = false;
+  int adaptive_overlap_min_num_inliers = 15;
+
   // Whether to match an image against all images within the same rig frame
   // and all images in neighboring rig frames. Note that this assumes that
   // images are appropriate named according to the following scheme:
@@ -147,6 +216,9 @@ struct SequentialPairingOptions {
   // image has more features, only the largest-scale features will be indexed.
   int loop_detection_max_num_features = -1;
 
+  // Number of loop detection query images retrieved together in one batch.
+  int loop_detection_query_batch_size = 1;
+
   // Number of threads for loop detection indexing and retrieval.
   int num_threads = -1;
 
@@ -192,6 +264,15 @@ struct TransitivePairingOptions {
   // The number of transitive closure iterations.
   int num_iterations = 3;
 
+  // The maximum number of transitive candidates of an image per iteration,
+  // ranked by the product of the inlier counts along the best connecting path.
+  // This bounds the number of candidates on dense graphs. Set to -1 to keep
+  // all candidates.
+  int max_num_candidates_per_image = -1;
+
+  // Number of threads for expanding the matched graph.
+  int num_threads = -1;
+
   bool Check() const;
 
   inline size_t CacheSize() const { return 2 * batch_size; }
@@ -238,8 +319,22 @@ class PairGenerator {
 
   virtual bool HasFinished() const = 0;
 
+  // Returns the fraction of the image pairs returned by Next() so far in
+  // [0, 1], or a negative value if the total number is unknown.
+  virtual double Progress() const;
+
   virtual std::vector<std::pair<image_t, image_t>> Next() = 0;
 
+  // Returns the position of the generator after the image pairs returned by
+  // Next() so far as a serialized cursor, or an empty string, if the
+  // generator cannot be resumed.
+  virtual std::string Cursor() const;
+
+  // Resumes the generator from a cursor returned by Cursor() of a generator
+  // with the same options and inputs. Throws if the cursor is not compatible
+  // with the generator, in which case the generator is left unchanged.
+  virtual void Seek(const std::string& cursor);
+
   std::vector<std::pair<image_t, image_t>> AllPairs();
 };
 
@@ -257,8 +352,14 @@ class ExhaustivePairGenerator : public PairGenerator {
 
   bool HasFinished() const override;
 
+  double Progress() const override;
+
   std::vector<std::pair<image_t, image_t>> Next() override;
 
+  std::string Cursor() const override;
+
+  void Seek(const std::string& cursor) override;
+
  private:
   const ExhaustivePairingOptions options_;
   const std::vector<image_t> image_ids_;
@@ -266,6 +367,9 @@ class ExhaustivePairGenerator : public PairGenerator {
   const size_t num_blocks_;
   size_t start_idx1_ = 0;
   size_t start_idx2_ = 0;
+  // Start indices of the blocks in Hilbert order, if enabled.
+  std::vector<std::pair<size_t, size_t>> block_schedule_;
+  size_t schedule_idx_ = 0;
   std::vector<std::pair<image_t, image_t>> image_pairs_;
 };
 
@@ -285,17 +389,34 @@ class VocabTreePairGenerator : public PairGenerator {
 
   bool HasFinished() const override;
 
+  double Progress() const override;
+
   std::vector<std::pair<image_t, image_t>> Next() override;
 
+  std::string Cursor() const override;
+
+  void Seek(const std::string& cursor) override;
+
+  // Starts the retrieval of the next query images in the background, such that
+  // their results are ready once they are requested by Next().
+  void Prefetch();
+
  private:
   void IndexImages(const std::vector<image_t>& image_ids);
 
   struct Retrieval {
+    size_t query_idx = 0;
     image_t image_id = kInvalidImageId;
     std::vector<retrieval::ImageScore> image_scores;
   };
 
-  void Query(image_t image_id);
+  void Query(size_t query_idx);
+  void QueryBatch(size_t begin_idx, size_t end_idx);
+  void AddQueryTask();
+  // Removes retrieved images that are in the persisted index but no longer
+  // in the database.
+  void FilterImageScores(
+      std::vector<retrieval::ImageScore>* image_scores) const;
 
   const VocabTreePairingOptions options_;
   const std::shared_ptr<FeatureMatcherCache> cache_;
@@ -304,11 +425,51 @@ class VocabTreePairGenerator : public PairGenerator {
   std::unique_ptr<retrieval::VisualIndex> visual_index_;
   retrieval::VisualIndex::QueryOptions query_options_;
   std::vector<image_t> query_image_ids_;
+  // Only set if the index contains images that are not in the database.
+  std::unordered_set<image_t> database_image_ids_;
   std::vector<std::pair<image_t, image_t>> image_pairs_;
+  // Finished retrievals that are consumed after earlier queries.
+  std::unordered_map<size_t, Retrieval> pending_retrievals_;
   size_t query_idx_ = 0;
   size_t result_idx_ = 0;
 };
 
+// Retrieves the most similar images of each image by the nearest neighbor
+// search of their global descriptors, which are aggregated from the local
+// features of the images and stored in the database for reuse. Compared to
+// the vocabulary tree, this requires only a small codebook trained on the
+// images themselves and a single compact descriptor per image.
+class GlobalDescriptorPairGenerator : public PairGenerator {
+ public:
+  using PairingOptions = GlobalDescriptorPairingOptions;
+
+  GlobalDescriptorPairGenerator(
+      const GlobalDescriptorPairingOptions& options,
+      const std::shared_ptr<FeatureMatcherCache>& cache);
+
+  GlobalDescriptorPairGenerator(const GlobalDescriptorPairingOptions& options,
+                                const std::shared_ptr<Database>& database);
+
+  void Reset() override;
+
+  bool HasFinished() const override;
+
+  double Progress() const override;
+
+  std::vector<std::pair<image_t, image_t>> Next() override;
+
+  std::string Cursor() const override;
+
+  void Seek(const std::string& cursor) override;
+
+ private:
+  const GlobalDescriptorPairingOptions options_;
+  const std::vector<image_t> image_ids_;
+  std::vector<std::pair<image_t, image_t>> image_pairs_;
+  Eigen::RowMajorMatrixXi index_matrix_;
+  size_t current_idx_ = 0;
+};
+
 class SequentialPairGenerator : public PairGenerator {
  public:
   using PairingOptions = SequentialPairingOptions;
@@ -323,11 +484,20 @@ class SequentialPairGenerator : public PairGenerator {
 
   bool HasFinished() const override;
 
+  double Progress() const override;
+
   std::vector<std::pair<image_t, image_t>> Next() override;
 
+  std::string Cursor() const override;
+
+  void Seek(const std::string& cursor) override;
+
  private:
   std::vector<image_t> GetOrderedImageIds() const;
 
+  // The number of sequential neighbors to match the current image against.
+  int CurrentOverlap() const;
+
   const SequentialPairingOptions options_;
   const std::shared_ptr<FeatureMatcherCache> cache_;
   std::vector<image_t> image_ids_;
@@ -353,8 +523,14 @@ class SpatialPairGenerator : public PairGenerator {
 
   bool HasFinished() const override;
 
+  double Progress() const override;
+
   std::vector<std::pair<image_t, image_t>> Next() override;
 
+  std::string Cursor() const override;
+
+  void Seek(const std::string& cursor) override;
+
   Eigen::RowMajorMatrixXf ReadPositionPriorData(FeatureMatcherCache& cache);
 
  private:
@@ -409,8 +585,14 @@ class ImportedPairGenerator : public PairGenerator {
 
   bool HasFinished() const override;
 
+  double Progress() const override;
+
   std::vector<std::pair<image_t, image_t>> Next() override;
 
+  std::string Cursor() const override;
+
+  void Seek(const std::string& cursor) override;
+
  private:
   const ImportedPairingOptions options_;
   std::vector<std::pair<image_t, image_t>> image_pairs_;
@@ -433,6 +615,8 @@ class ExistingMatchedPairGenerator : public PairGenerator {
 
   bool HasFinished() const override;
 
+  double Progress() const override;
+
   std::vector<std::pair<image_t, image_t>> Next() override;
 
  private:
@@ -442,4 +626,38 @@ class ExistingMatchedPairGenerator : public PairGenerator {
   size_t num_batches_ = 0;
 };
 
+// Restricts the image pairs of another pair generator to one of multiple
+// disjoint shards, e.g., to distribute feature matching across multiple
+// workers, where each worker matches the image pairs of the shard at
+// `shard_index`. Image pairs are assigned to shards by their pair identifier,
+// which is independent of the order of the two images and of the batches.
+class ShardedPairGenerator : public PairGenerator {
+ public:
+  ShardedPairGenerator(std::unique_ptr<PairGenerator> generator,
+                       int shard_index,
+                       int num_shards);
+
+  void Reset() override;
+
+  bool HasFinished() const override;
+
+  double Progress() const override;
+
+  std::vector<std::pair<image_t, image_t>> Next() override;
+
+  std::string Cursor() const override;
+
+  void Seek(const std::string& cursor) override;
+
+  static bool IsInShard(image_t image_id1,
+                        image_t image_id2,
+                        int shard_index,
+                        int num_shards);
+
+ private:
+  const std::unique_ptr<PairGenerator> generator_;
+  const int shard_index_;
+  const int num_shards_;
+};
+
 }  // namespace colmap
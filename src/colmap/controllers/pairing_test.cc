@@ -33,6 +33,7 @@
 #include "colmap/retrieval/visual_index.h"
 #include "colmap/scene/database_sqlite.h"
 #include "colmap/scene/synthetic.h"
+#include "colmap/util/file.h"
 #include "colmap/util/testing.h"
 
 #include <fstream>
@@ -77,6 +78,124 @@ TEST(ExhaustivePairGenerator, Nominal) {
   EXPECT_TRUE(generator.HasFinished());
 }
 
+TEST(ExhaustivePairGenerator, HilbertOrder) {
+  constexpr int kNumImages = 34;
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  CreateSyntheticDatabase(kNumImages, *database);
+
+  ExhaustivePairingOptions options;
+  options.block_size = 5;
+  options.hilbert_order = true;
+  options.num_cached_blocks = 4;
+  EXPECT_EQ(options.CacheSize(), 20);
+  ExhaustivePairGenerator generator(options, database);
+  const int num_blocks =
+      std::ceil(static_cast<double>(kNumImages) / options.block_size);
+  std::set<image_pair_t> pair_ids;
+  for (int i = 0; i < num_blocks * (num_blocks + 1) / 2; ++i) {
+    EXPECT_FALSE(generator.HasFinished());
+    for (const auto& [image_id1, image_id2] : generator.Next()) {
+      EXPECT_NE(image_id1, image_id2);
+      EXPECT_TRUE(pair_ids.insert(ImagePairToPairId(image_id1, image_id2))
+                      .second);
+    }
+  }
+  EXPECT_EQ(pair_ids.size(), kNumImages * (kNumImages - 1) / 2);
+  EXPECT_TRUE(generator.Next().empty());
+  EXPECT_TRUE(generator.HasFinished());
+
+  generator.Reset();
+  EXPECT_EQ(generator.AllPairs().size(), pair_ids.size());
+}
+
+TEST(ExhaustivePairGenerator, Cursor) {
+  constexpr int kNumImages = 34;
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  CreateSyntheticDatabase(kNumImages, *database);
+
+  for (const bool hilbert_order : {false, true}) {
+    ExhaustivePairingOptions options;
+    options.block_size = 10;
+    options.hilbert_order = hilbert_order;
+    const std::vector<std::pair<image_t, image_t>> expected_pairs =
+        ExhaustivePairGenerator(options, database).AllPairs();
+
+    ExhaustivePairGenerator generator(options, database);
+    std::vector<std::pair<image_t, image_t>> pairs = generator.Next();
+    const std::vector<std::pair<image_t, image_t>> pairs2 = generator.Next();
+    pairs.insert(pairs.end(), pairs2.begin(), pairs2.end());
+
+    ExhaustivePairGenerator resumed_generator(options, database);
+    resumed_generator.Seek(generator.Cursor());
+    const std::vector<std::pair<image_t, image_t>> resumed_pairs =
+        resumed_generator.AllPairs();
+    pairs.insert(pairs.end(), resumed_pairs.begin(), resumed_pairs.end());
+    EXPECT_EQ(pairs, expected_pairs);
+
+    // Cursors of incompatible generators are rejected.
+    options.block_size = 5;
+    ExhaustivePairGenerator other_generator(options, database);
+    EXPECT_ANY_THROW(other_generator.Seek(generator.Cursor()));
+    EXPECT_ANY_THROW(other_generator.Seek("spatial 34 34 0"));
+    EXPECT_ANY_THROW(other_generator.Seek("exhaustive 34"));
+  }
+}
+
+TEST(ExhaustivePairGenerator, Progress) {
+  constexpr int kNumImages = 34;
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  CreateSyntheticDatabase(kNumImages, *database);
+
+  for (const bool hilbert_order : {false, true}) {
+    ExhaustivePairingOptions options;
+    options.block_size = 10;
+    options.hilbert_order = hilbert_order;
+    ExhaustivePairGenerator generator(options, database);
+    double prev_progress = generator.Progress();
+    EXPECT_EQ(prev_progress, 0);
+    while (!generator.HasFinished()) {
+      generator.Next();
+      const double progress = generator.Progress();
+      EXPECT_GT(progress, prev_progress);
+      EXPECT_LE(progress, 1);
+      prev_progress = progress;
+    }
+    EXPECT_EQ(prev_progress, 1);
+
+    generator.Reset();
+    EXPECT_EQ(generator.Progress(), 0);
+  }
+}
+
+TEST(ShardedPairGenerator, Nominal) {
+  constexpr int kNumImages = 34;
+  constexpr int kNumShards = 3;
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  CreateSyntheticDatabase(kNumImages, *database);
+
+  ExhaustivePairingOptions options;
+  options.block_size = 10;
+  std::set<image_pair_t> all_pair_ids;
+  for (int shard_index = 0; shard_index < kNumShards; ++shard_index) {
+    ShardedPairGenerator generator(
+        std::make_unique<ExhaustivePairGenerator>(options, database),
+        shard_index,
+        kNumShards);
+    const std::vector<std::pair<image_t, image_t>> pairs =
+        generator.AllPairs();
+    EXPECT_FALSE(pairs.empty());
+    for (const auto& [image_id1, image_id2] : pairs) {
+      EXPECT_TRUE(ShardedPairGenerator::IsInShard(
+          image_id1, image_id2, shard_index, kNumShards));
+      EXPECT_TRUE(
+          all_pair_ids.insert(ImagePairToPairId(image_id1, image_id2)).second);
+    }
+    EXPECT_TRUE(generator.HasFinished());
+    EXPECT_TRUE(generator.Next().empty());
+  }
+  EXPECT_EQ(all_pair_ids.size(), kNumImages * (kNumImages - 1) / 2);
+}
+
 std::unique_ptr<retrieval::VisualIndex> CreateSyntheticVisualIndex() {
   auto visual_index = retrieval::VisualIndex::Create();
   retrieval::VisualIndex::BuildOptions build_options;
@@ -129,6 +248,60 @@ TEST(VocabTreePairGenerator, Nominal) {
   }
 }
 
+TEST(VocabTreePairGenerator, Cursor) {
+  constexpr int kNumImages = 5;
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  CreateSyntheticDatabase(kNumImages, *database);
+
+  VocabTreePairingOptions options;
+  options.vocab_tree_path = CreateTestDir() / "vocab_tree.txt";
+  options.num_images = 3;
+  options.num_threads = 3;
+  CreateSyntheticVisualIndex()->Write(options.vocab_tree_path);
+
+  const std::vector<std::pair<image_t, image_t>> expected_pairs =
+      VocabTreePairGenerator(options, database).AllPairs();
+
+  VocabTreePairGenerator generator(options, database);
+  std::vector<std::pair<image_t, image_t>> pairs = generator.Next();
+  const std::vector<std::pair<image_t, image_t>> pairs2 = generator.Next();
+  pairs.insert(pairs.end(), pairs2.begin(), pairs2.end());
+
+  VocabTreePairGenerator resumed_generator(options, database);
+  resumed_generator.Seek(generator.Cursor());
+  const std::vector<std::pair<image_t, image_t>> resumed_pairs =
+      resumed_generator.AllPairs();
+  pairs.insert(pairs.end(), resumed_pairs.begin(), resumed_pairs.end());
+  EXPECT_EQ(pairs, expected_pairs);
+}
+
+TEST(VocabTreePairGenerator, IndexPath) {
+  constexpr int kNumImages = 5;
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  CreateSyntheticDatabase(kNumImages, *database);
+
+  VocabTreePairingOptions options;
+  const auto test_dir = CreateTestDir();
+  options.vocab_tree_path = test_dir / "vocab_tree.txt";
+  options.num_images = 3;
+  options.index_batch_size = 2;
+  CreateSyntheticVisualIndex()->Write(options.vocab_tree_path);
+
+  const std::vector<std::pair<image_t, image_t>> expected_pairs =
+      VocabTreePairGenerator(options, database).AllPairs();
+
+  // The first run writes the index and later runs read it.
+  options.index_path = test_dir / "index.bin";
+  EXPECT_EQ(VocabTreePairGenerator(options, database).AllPairs(),
+            expected_pairs);
+  EXPECT_TRUE(ExistsFile(options.index_path));
+  EXPECT_EQ(retrieval::VisualIndex::Read(options.index_path)->NumImages(),
+            kNumImages);
+  options.vocab_tree_path = test_dir / "missing_vocab_tree.txt";
+  EXPECT_EQ(VocabTreePairGenerator(options, database).AllPairs(),
+            expected_pairs);
+}
+
 TEST(VocabTreePairGenerator, DoesNotDeadlockOnFailedQuery) {
   constexpr int kNumImages = 5;
   auto database = Database::Open(kInMemorySqliteDatabasePath);
@@ -162,6 +335,89 @@ TEST(VocabTreePairGenerator, DoesNotDeadlockOnFailedQuery) {
   EXPECT_TRUE(generator.HasFinished());
 }
 
+TEST(GlobalDescriptorPairGenerator, Nominal) {
+  constexpr int kNumImages = 6;
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  CreateSyntheticDatabase(kNumImages, *database);
+  const std::vector<Image> images = database->ReadAllImages();
+  CHECK_EQ(images.size(), kNumImages);
+
+  GlobalDescriptorPairingOptions options;
+  options.num_clusters = 4;
+  options.codebook_path = CreateTestDir() / "codebook.bin";
+
+  {
+    options.num_images = 3;
+    GlobalDescriptorPairGenerator generator(options, database);
+    for (int i = 0; i < kNumImages; ++i) {
+      const auto pairs = generator.Next();
+      EXPECT_EQ(pairs.size(), options.num_images);
+      EXPECT_EQ(
+          (std::set<std::pair<image_t, image_t>>(pairs.begin(), pairs.end())
+               .size()),
+          pairs.size());
+      for (const auto& [image_id1, image_id2] : pairs) {
+        EXPECT_EQ(image_id1, images[i].ImageId());
+        EXPECT_NE(image_id1, image_id2);
+      }
+    }
+    EXPECT_TRUE(generator.Next().empty());
+    EXPECT_TRUE(generator.HasFinished());
+  }
+
+  // The codebook was written and the descriptors are stored in the database.
+  EXPECT_TRUE(ExistsFile(options.codebook_path));
+  std::vector<GlobalImageDescriptor> descriptors;
+  for (const Image& image : images) {
+    const std::optional<GlobalImageDescriptor> descriptor =
+        database->ReadGlobalImageDescriptor(image.ImageId());
+    ASSERT_TRUE(descriptor.has_value());
+    descriptors.push_back(*descriptor);
+  }
+
+  {
+    options.num_images = 100;
+    GlobalDescriptorPairGenerator generator(options, database);
+    for (int i = 0; i < kNumImages; ++i) {
+      const auto pairs = generator.Next();
+      EXPECT_EQ(pairs.size(), kNumImages - 1);
+    }
+    EXPECT_TRUE(generator.Next().empty());
+    EXPECT_TRUE(generator.HasFinished());
+  }
+
+  for (size_t i = 0; i < images.size(); ++i) {
+    EXPECT_EQ(database->ReadGlobalImageDescriptor(images[i].ImageId()),
+              descriptors[i]);
+  }
+}
+
+TEST(GlobalDescriptorPairGenerator, Cursor) {
+  constexpr int kNumImages = 5;
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  CreateSyntheticDatabase(kNumImages, *database);
+
+  GlobalDescriptorPairingOptions options;
+  options.num_images = 2;
+  options.num_clusters = 4;
+  options.codebook_path = CreateTestDir() / "codebook.bin";
+
+  const std::vector<std::pair<image_t, image_t>> expected_pairs =
+      GlobalDescriptorPairGenerator(options, database).AllPairs();
+
+  GlobalDescriptorPairGenerator generator(options, database);
+  std::vector<std::pair<image_t, image_t>> pairs = generator.Next();
+  const std::vector<std::pair<image_t, image_t>> pairs2 = generator.Next();
+  pairs.insert(pairs.end(), pairs2.begin(), pairs2.end());
+
+  GlobalDescriptorPairGenerator resumed_generator(options, database);
+  resumed_generator.Seek(generator.Cursor());
+  const std::vector<std::pair<image_t, image_t>> resumed_pairs =
+      resumed_generator.AllPairs();
+  pairs.insert(pairs.end(), resumed_pairs.begin(), resumed_pairs.end());
+  EXPECT_EQ(pairs, expected_pairs);
+}
+
 TEST(SequentialPairGenerator, Linear) {
   constexpr int kNumImages = 5;
   auto database = Database::Open(kInMemorySqliteDatabasePath);
@@ -275,6 +531,69 @@ TEST(SequentialPairGenerator, Quadratic) {
   EXPECT_TRUE(generator.HasFinished());
 }
 
+TEST(SequentialPairGenerator, AdaptiveOverlap) {
+  constexpr int kNumImages = 6;
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  CreateSyntheticDatabase(kNumImages, *database);
+  database->ClearMatches();
+  database->ClearTwoViewGeometries();
+  const std::vector<Image> images = database->ReadAllImages();
+  CHECK_EQ(images.size(), kNumImages);
+
+  auto WriteNumInliers = [&](int image_idx1, int image_idx2, int num_inliers) {
+    TwoViewGeometry two_view_geometry;
+    two_view_geometry.inlier_matches = FeatureMatches(num_inliers);
+    database->WriteTwoViewGeometry(images[image_idx1].ImageId(),
+                                   images[image_idx2].ImageId(),
+                                   two_view_geometry);
+  };
+
+  SequentialPairingOptions options;
+  options.overlap = 3;
+  options.quadratic_overlap = false;
+  options.adaptive_overlap = true;
+  options.adaptive_overlap_min_num_inliers = 10;
+  SequentialPairGenerator generator(options, database);
+  EXPECT_THAT(generator.Next(),
+              testing::ElementsAre(
+                  std::make_pair(images[0].ImageId(), images[1].ImageId()),
+                  std::make_pair(images[0].ImageId(), images[2].ImageId()),
+                  std::make_pair(images[0].ImageId(), images[3].ImageId())));
+  WriteNumInliers(0, 1, 20);
+  WriteNumInliers(0, 2, 5);
+  WriteNumInliers(0, 3, 5);
+  EXPECT_THAT(generator.Next(),
+              testing::ElementsAre(
+                  std::make_pair(images[1].ImageId(), images[2].ImageId()),
+                  std::make_pair(images[1].ImageId(), images[3].ImageId())));
+  WriteNumInliers(1, 2, 20);
+  WriteNumInliers(1, 3, 20);
+  EXPECT_THAT(generator.Next(),
+              testing::ElementsAre(
+                  std::make_pair(images[2].ImageId(), images[3].ImageId()),
+                  std::make_pair(images[2].ImageId(), images[4].ImageId()),
+                  std::make_pair(images[2].ImageId(), images[5].ImageId())));
+  WriteNumInliers(2, 3, 0);
+  WriteNumInliers(2, 4, 0);
+  WriteNumInliers(2, 5, 0);
+  EXPECT_THAT(generator.Next(),
+              testing::ElementsAre(
+                  std::make_pair(images[3].ImageId(), images[4].ImageId())));
+  EXPECT_THAT(generator.Next(),
+              testing::ElementsAre(
+                  std::make_pair(images[4].ImageId(), images[5].ImageId())));
+  EXPECT_TRUE(generator.Next().empty());
+  EXPECT_TRUE(generator.HasFinished());
+
+  // The overlap is derived from the database after resuming.
+  SequentialPairGenerator generator2(options, database);
+  generator2.Next();
+  generator2.Next();
+  SequentialPairGenerator resumed_generator(options, database);
+  resumed_generator.Seek(generator2.Cursor());
+  EXPECT_EQ(resumed_generator.Next().size(), 3);
+}
+
 TEST(SpatialPairGenerator, Nominal) {
   constexpr int kNumImages = 3;
   auto database = Database::Open(kInMemorySqliteDatabasePath);
@@ -781,6 +1100,41 @@ TEST(TransitivePairGenerator, Nominal) {
   EXPECT_TRUE(generator.HasFinished());
 }
 
+TEST(TransitivePairGenerator, MaxNumCandidatesPerImage) {
+  constexpr int kNumImages = 5;
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  CreateSyntheticDatabase(kNumImages, *database);
+  const std::vector<Image> images = database->ReadAllImages();
+  CHECK_EQ(images.size(), kNumImages);
+
+  database->ClearTwoViewGeometries();
+  for (int i = 1; i < kNumImages; ++i) {
+    TwoViewGeometry two_view_geometry;
+    two_view_geometry.inlier_matches.resize(10 * i);
+    database->WriteTwoViewGeometry(
+        images[0].ImageId(), images[i].ImageId(), two_view_geometry);
+  }
+
+  TransitivePairingOptions options;
+  options.num_iterations = 1;
+  options.max_num_candidates_per_image = 1;
+  TransitivePairGenerator generator(options, database);
+  EXPECT_THAT(generator.Next(),
+              testing::UnorderedElementsAre(
+                  std::make_pair(images[1].ImageId(), images[4].ImageId()),
+                  std::make_pair(images[2].ImageId(), images[4].ImageId()),
+                  std::make_pair(images[3].ImageId(), images[4].ImageId())));
+  EXPECT_TRUE(generator.Next().empty());
+  EXPECT_TRUE(generator.HasFinished());
+
+  options.max_num_candidates_per_image = -1;
+  TransitivePairGenerator unbounded_generator(options, database);
+  EXPECT_EQ(unbounded_generator.Next().size(), 6);
+
+  options.max_num_candidates_per_image = 0;
+  EXPECT_FALSE(options.Check());
+}
+
 TEST(ImportedPairGenerator, Nominal) {
   constexpr int kNumImages = 10;
   auto database = Database::Open(kInMemorySqliteDatabasePath);
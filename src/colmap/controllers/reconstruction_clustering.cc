@@ -33,6 +33,7 @@
 #include "colmap/util/file.h"
 #include "colmap/util/logging.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/resource_usage.h"
 #include "colmap/util/timer.h"
 
 namespace colmap {
@@ -85,6 +86,7 @@ ReconstructionClustererController::ReconstructionClustererController(
       reconstruction_manager_(std::move(reconstruction_manager)) {}
 
 void ReconstructionClustererController::Run() {
+  ScopedResourceUsage resource_usage("ReconstructionClustererController");
   THROW_CHECK_NOTNULL(reconstruction_);
   THROW_CHECK_NOTNULL(reconstruction_manager_);
 
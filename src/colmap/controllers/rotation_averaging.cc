@@ -36,6 +36,7 @@
 #include "colmap/scene/pose_graph.h"
 #include "colmap/util/logging.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/resource_usage.h"
 #include "colmap/util/timer.h"
 
 #include <limits>
@@ -57,11 +58,12 @@ RotationAveragingPipeline::RotationAveragingPipeline(
                                         options_.image_names.end()};
   database_cache_ = DatabaseCache::Create(*database, database_cache_options);
   if (options_.decompose_relative_pose) {
-    MaybeDecomposeRelativePoses(database_cache_.get());
+    MaybeDecomposeRelativePoses(database_cache_.get(), options_.num_threads);
   }
 }
 
 void RotationAveragingPipeline::Run() {
+  ScopedResourceUsage resource_usage("RotationAveragingPipeline");
   // Propagate options to component options.
   RotationAveragingPipelineOptions options = options_;
   options.rotation_estimation.random_seed = options.random_seed;
@@ -32,6 +32,7 @@
 #include "colmap/scene/reconstruction_io.h"
 #include "colmap/sensor/models.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/resource_usage.h"
 #include "colmap/util/threading.h"
 
 #include <fstream>
@@ -41,6 +42,37 @@
 namespace colmap {
 namespace {
 
+// Maximum number of cached undistortion warp maps, which bounds the memory
+// for reconstructions with a separate camera per image.
+constexpr size_t kMaxNumCachedWarpMaps = 16;
+
+ThreadSafeLRUCache<camera_t, CameraWarpMap>::LoadFn CreateWarpMapLoader(
+    const UndistortCameraOptions& camera_options,
+    const Reconstruction& reconstruction) {
+  return [&camera_options, &reconstruction](const camera_t camera_id) {
+    return std::make_shared<CameraWarpMap>(
+        CreateUndistortionWarpMap(camera_options,
+                                  reconstruction.Camera(camera_id),
+                                  /*reduce_distorted_resolution=*/true));
+  };
+}
+
+// Read the distorted image at the resolution of the source camera of the warp
+// map, which may be downscaled from the original resolution of the image.
+bool ReadDistortedBitmap(const std::filesystem::path& path,
+                         const Camera& distorted_camera,
+                         const CameraWarpMap& warp_map,
+                         Bitmap* bitmap) {
+  const Camera& source_camera = warp_map.SourceCamera();
+  if (source_camera.width == distorted_camera.width &&
+      source_camera.height == distorted_camera.height) {
+    return bitmap->Read(path);
+  }
+  return bitmap->ReadRescaled(path,
+                              static_cast<int>(source_camera.width),
+                              static_cast<int>(source_camera.height));
+}
+
 void MaybeSetJpegQuality(const std::filesystem::path& path,
                          Bitmap& bitmap,
                          int jpeg_quality) {
@@ -156,13 +188,16 @@ COLMAPUndistorter::COLMAPUndistorter(
       camera_options_(camera_options),
       reconstruction_(reconstruction),
       image_path_(image_path),
-      output_path_(output_path) {
+      output_path_(output_path),
+      warp_maps_(kMaxNumCachedWarpMaps,
+                 CreateWarpMapLoader(camera_options_, reconstruction_)) {
   THROW_CHECK_GE(options_.num_patch_match_src_images, 1);
   THROW_CHECK_GE(options_.jpeg_quality, -1);
   THROW_CHECK_LE(options_.jpeg_quality, 100);
 }
 
 void COLMAPUndistorter::Run() {
+  ScopedResourceUsage resource_usage("COLMAPUndistorter");
   LOG_HEADING1("Image undistortion");
 
   Timer run_timer;
@@ -256,17 +291,20 @@ bool COLMAPUndistorter::Undistort(const image_t image_id) const {
     return true;
   }
 
+  const std::shared_ptr<CameraWarpMap> warp_map =
+      warp_maps_.Get(image.CameraId());
+
   Bitmap distorted_bitmap;
-  if (!distorted_bitmap.Read(input_image_path)) {
+  if (!ReadDistortedBitmap(
+          input_image_path, camera, *warp_map, &distorted_bitmap)) {
     LOG(ERROR) << "Cannot read image at path: " << input_image_path;
     return false;
   }
 
   Bitmap undistorted_bitmap;
   Camera undistorted_camera;
-  UndistortImage(camera_options_,
+  UndistortImage(*warp_map,
                  distorted_bitmap,
-                 camera,
                  &undistorted_bitmap,
                  &undistorted_camera);
 
@@ -318,12 +356,15 @@ PMVSUndistorter::PMVSUndistorter(const Options& options,
       camera_options_(camera_options),
       reconstruction_(reconstruction),
       image_path_(image_path),
-      output_path_(output_path) {
+      output_path_(output_path),
+      warp_maps_(kMaxNumCachedWarpMaps,
+                 CreateWarpMapLoader(camera_options_, reconstruction_)) {
   THROW_CHECK_GE(options_.jpeg_quality, -1);
   THROW_CHECK_LE(options_.jpeg_quality, 100);
 }
 
 void PMVSUndistorter::Run() {
+  ScopedResourceUsage resource_usage("PMVSUndistorter");
   LOG_HEADING1("Image undistortion (CMVS/PMVS)");
 
   Timer run_timer;
@@ -334,12 +375,13 @@ void PMVSUndistorter::Run() {
   CreateDirIfNotExists(output_path_ / "pmvs" / "visualize");
   CreateDirIfNotExists(output_path_ / "pmvs" / "models");
 
+  const std::vector<image_t> reg_image_ids = reconstruction_.RegImageIds();
   ThreadPool thread_pool(options_.num_threads);
   std::vector<std::shared_future<bool>> futures;
-  futures.reserve(reconstruction_.NumRegImages());
-  for (size_t i = 0; i < reconstruction_.NumRegImages(); ++i) {
-    futures.push_back(
-        thread_pool.AddTask(&PMVSUndistorter::Undistort, this, i));
+  futures.reserve(reg_image_ids.size());
+  for (size_t i = 0; i < reg_image_ids.size(); ++i) {
+    futures.push_back(thread_pool.AddTask(
+        &PMVSUndistorter::Undistort, this, i, reg_image_ids[i]));
   }
 
   for (size_t i = 0; i < futures.size(); ++i) {
@@ -382,29 +424,32 @@ void PMVSUndistorter::Run() {
   run_timer.PrintMinutes();
 }
 
-bool PMVSUndistorter::Undistort(const size_t reg_image_idx) const {
+bool PMVSUndistorter::Undistort(const size_t reg_image_idx,
+                            const image_t image_id) const {
   const auto output_image_path =
       output_path_ / StringPrintf("pmvs/visualize/%08d.jpg", reg_image_idx);
   const auto proj_matrix_path =
       output_path_ / StringPrintf("pmvs/txt/%08d.txt", reg_image_idx);
 
-  const image_t image_id =
-      *std::next(reconstruction_.RegImageIds().begin(), reg_image_idx);
   const Image& image = reconstruction_.Image(image_id);
-  const Camera& camera = *image.CameraPtr();
+
+  const std::shared_ptr<CameraWarpMap> warp_map =
+      warp_maps_.Get(image.CameraId());
 
   Bitmap distorted_bitmap;
   const auto input_image_path = image_path_ / image.Name();
-  if (!distorted_bitmap.Read(input_image_path)) {
+  if (!ReadDistortedBitmap(input_image_path,
+                           *image.CameraPtr(),
+                           *warp_map,
+                           &distorted_bitmap)) {
     LOG(ERROR) << "Cannot read image at path " << input_image_path;
     return false;
   }
 
   Bitmap undistorted_bitmap;
   Camera undistorted_camera;
-  UndistortImage(camera_options_,
+  UndistortImage(*warp_map,
                  distorted_bitmap,
-                 camera,
                  &undistorted_bitmap,
                  &undistorted_camera);
 
@@ -562,23 +607,27 @@ CMPMVSUndistorter::CMPMVSUndistorter(
       camera_options_(camera_options),
       image_path_(image_path),
       output_path_(output_path),
-      reconstruction_(reconstruction) {
+      reconstruction_(reconstruction),
+      warp_maps_(kMaxNumCachedWarpMaps,
+                 CreateWarpMapLoader(camera_options_, reconstruction_)) {
   THROW_CHECK_GE(options_.jpeg_quality, -1);
   THROW_CHECK_LE(options_.jpeg_quality, 100);
 }
 
 void CMPMVSUndistorter::Run() {
+  ScopedResourceUsage resource_usage("CMPMVSUndistorter");
   LOG_HEADING1("Image undistortion (CMP-MVS)");
 
   Timer run_timer;
   run_timer.Start();
 
+  const std::vector<image_t> reg_image_ids = reconstruction_.RegImageIds();
   ThreadPool thread_pool(options_.num_threads);
   std::vector<std::shared_future<bool>> futures;
-  futures.reserve(reconstruction_.NumRegImages());
-  for (size_t i = 0; i < reconstruction_.NumRegImages(); ++i) {
-    futures.push_back(
-        thread_pool.AddTask(&CMPMVSUndistorter::Undistort, this, i));
+  futures.reserve(reg_image_ids.size());
+  for (size_t i = 0; i < reg_image_ids.size(); ++i) {
+    futures.push_back(thread_pool.AddTask(
+        &CMPMVSUndistorter::Undistort, this, i, reg_image_ids[i]));
   }
 
   for (size_t i = 0; i < futures.size(); ++i) {
@@ -595,29 +644,32 @@ void CMPMVSUndistorter::Run() {
   run_timer.PrintMinutes();
 }
 
-bool CMPMVSUndistorter::Undistort(const size_t reg_image_idx) const {
+bool CMPMVSUndistorter::Undistort(const size_t reg_image_idx,
+                            const image_t image_id) const {
   const auto output_image_path =
       output_path_ / StringPrintf("%05d.jpg", reg_image_idx + 1);
   const auto proj_matrix_path =
       output_path_ / StringPrintf("%05d_P.txt", reg_image_idx + 1);
 
-  const image_t image_id =
-      *std::next(reconstruction_.RegImageIds().begin(), reg_image_idx);
   const Image& image = reconstruction_.Image(image_id);
-  const Camera& camera = *image.CameraPtr();
+
+  const std::shared_ptr<CameraWarpMap> warp_map =
+      warp_maps_.Get(image.CameraId());
 
   Bitmap distorted_bitmap;
   const auto input_image_path = image_path_ / image.Name();
-  if (!distorted_bitmap.Read(input_image_path)) {
+  if (!ReadDistortedBitmap(input_image_path,
+                           *image.CameraPtr(),
+                           *warp_map,
+                           &distorted_bitmap)) {
     LOG(ERROR) << "Cannot read image at path " << input_image_path;
     return false;
   }
 
   Bitmap undistorted_bitmap;
   Camera undistorted_camera;
-  UndistortImage(camera_options_,
+  UndistortImage(*warp_map,
                  distorted_bitmap,
-                 camera,
                  &undistorted_bitmap,
                  &undistorted_camera);
 
@@ -641,6 +693,7 @@ StandaloneImageUndistorter::StandaloneImageUndistorter(
 }
 
 void StandaloneImageUndistorter::Run() {
+  ScopedResourceUsage resource_usage("StandaloneImageUndistorter");
   LOG_HEADING1("Image undistortion");
 
   Timer run_timer;
@@ -686,17 +739,22 @@ bool StandaloneImageUndistorter::Undistort(const size_t image_idx) const {
     return true;
   }
 
+  const CameraWarpMap warp_map =
+      CreateUndistortionWarpMap(camera_options_,
+                                camera,
+                                /*reduce_distorted_resolution=*/true);
+
   Bitmap distorted_bitmap;
-  if (!distorted_bitmap.Read(input_image_path)) {
+  if (!ReadDistortedBitmap(
+          input_image_path, camera, warp_map, &distorted_bitmap)) {
     LOG(ERROR) << "Cannot read image at path " << input_image_path;
     return false;
   }
 
   Bitmap undistorted_bitmap;
   Camera undistorted_camera;
-  UndistortImage(camera_options_,
+  UndistortImage(warp_map,
                  distorted_bitmap,
-                 camera,
                  &undistorted_bitmap,
                  &undistorted_camera);
 
@@ -722,6 +780,7 @@ StereoImageRectifier::StereoImageRectifier(
 }
 
 void StereoImageRectifier::Run() {
+  ScopedResourceUsage resource_usage("StereoImageRectifier");
   LOG_HEADING1("Stereo rectification");
 
   Timer run_timer;
@@ -32,6 +32,7 @@
 #include "colmap/image/undistortion.h"
 #include "colmap/scene/reconstruction.h"
 #include "colmap/util/base_controller.h"
+#include "colmap/util/cache.h"
 #include "colmap/util/file.h"
 
 namespace colmap {
@@ -82,6 +83,8 @@ class COLMAPUndistorter : public BaseController {
   const Reconstruction& reconstruction_;
   const std::filesystem::path image_path_;
   const std::filesystem::path output_path_;
+  // Undistortion warp maps of the most recently used cameras.
+  mutable ThreadSafeLRUCache<camera_t, CameraWarpMap> warp_maps_;
 };
 
 // Undistort images and prepare data for CMVS/PMVS.
@@ -106,7 +109,7 @@ class PMVSUndistorter : public BaseController {
   void Run();
 
  private:
-  bool Undistort(size_t reg_image_idx) const;
+  bool Undistort(size_t reg_image_idx, image_t image_id) const;
   void WriteVisibilityData() const;
   void WriteOptionFile() const;
   void WritePMVSScript() const;
@@ -119,6 +122,8 @@ class PMVSUndistorter : public BaseController {
   const Reconstruction& reconstruction_;
   const std::filesystem::path image_path_;
   const std::filesystem::path output_path_;
+  // Undistortion warp maps of the most recently used cameras.
+  mutable ThreadSafeLRUCache<camera_t, CameraWarpMap> warp_maps_;
 };
 
 // Undistort images and prepare data for CMP-MVS.
@@ -143,13 +148,15 @@ class CMPMVSUndistorter : public BaseController {
   void Run();
 
  private:
-  bool Undistort(size_t reg_image_idx) const;
+  bool Undistort(size_t reg_image_idx, image_t image_id) const;
 
   const Options options_;
   const UndistortCameraOptions camera_options_;
   const std::filesystem::path image_path_;
   const std::filesystem::path output_path_;
   const Reconstruction& reconstruction_;
+  // Undistortion warp maps of the most recently used cameras.
+  mutable ThreadSafeLRUCache<camera_t, CameraWarpMap> warp_maps_;
 };
 
 // Undistort images and export undistorted cameras without the need for a
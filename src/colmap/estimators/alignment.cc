@@ -35,7 +35,9 @@
 #include "colmap/optim/loransac.h"
 #include "colmap/scene/projection.h"
 #include "colmap/util/logging.h"
+#include "colmap/util/threading.h"
 
+#include <string_view>
 #include <unordered_map>
 
 namespace colmap {
@@ -104,78 +106,91 @@ struct ReconstructionAlignmentEstimator {
 
     residuals->resize(src_images.size());
 
-    for (size_t i = 0; i < src_images.size(); ++i) {
-      const Image& src_image = *src_images[i];
-      const Image& tgt_image = *tgt_images[i];
+    // The residuals of the images are independent and each requires the
+    // reprojection of all their points, so they are computed in parallel.
+    ParallelFor(
+        0,
+        src_images.size(),
+        [&](const int64_t begin, const int64_t end) {
+          for (int64_t i = begin; i < end; ++i) {
+            (*residuals)[i] = ImageResidual(
+                *src_images[i], *tgt_images[i], tgt_from_src, src_from_tgt);
+          }
+        },
+        ThreadPool::kMaxNumThreads,
+        /*grain_size=*/16);
+  }
 
-      THROW_CHECK_EQ(src_image.ImageId(), tgt_image.ImageId());
+ private:
+  double ImageResidual(const Image& src_image,
+                       const Image& tgt_image,
+                       const Sim3d& tgt_from_src,
+                       const Sim3d& src_from_tgt) const {
+    THROW_CHECK_EQ(src_image.ImageId(), tgt_image.ImageId());
 
-      const Camera& src_camera = *src_image.CameraPtr();
-      const Camera& tgt_camera = *tgt_image.CameraPtr();
+    const Camera& src_camera = *src_image.CameraPtr();
+    const Camera& tgt_camera = *tgt_image.CameraPtr();
 
-      const Eigen::Matrix3x4d src_cam_from_world =
-          src_image.CamFromWorld().ToMatrix();
-      const Eigen::Matrix3x4d tgt_cam_from_world =
-          tgt_image.CamFromWorld().ToMatrix();
+    const Eigen::Matrix3x4d src_cam_from_world =
+        src_image.CamFromWorld().ToMatrix();
+    const Eigen::Matrix3x4d tgt_cam_from_world =
+        tgt_image.CamFromWorld().ToMatrix();
 
-      THROW_CHECK_EQ(src_image.NumPoints2D(), tgt_image.NumPoints2D());
+    THROW_CHECK_EQ(src_image.NumPoints2D(), tgt_image.NumPoints2D());
 
-      size_t num_inliers = 0;
-      size_t num_common_points = 0;
+    size_t num_inliers = 0;
+    size_t num_common_points = 0;
 
-      for (point2D_t point2D_idx = 0; point2D_idx < src_image.NumPoints2D();
-           ++point2D_idx) {
-        // Check if both images have a 3D point.
+    for (point2D_t point2D_idx = 0; point2D_idx < src_image.NumPoints2D();
+         ++point2D_idx) {
+      // Check if both images have a 3D point.
 
-        const auto& src_point2D = src_image.Point2D(point2D_idx);
-        if (!src_point2D.HasPoint3D()) {
-          continue;
-        }
-
-        const auto& tgt_point2D = tgt_image.Point2D(point2D_idx);
-        if (!tgt_point2D.HasPoint3D()) {
-          continue;
-        }
+      const auto& src_point2D = src_image.Point2D(point2D_idx);
+      if (!src_point2D.HasPoint3D()) {
+        continue;
+      }
 
-        num_common_points += 1;
-
-        const Eigen::Vector3d src_point_in_tgt =
-            tgt_from_src *
-            src_reconstruction_->Point3D(src_point2D.point3D_id).xyz;
-        if (CalculateSquaredReprojectionError(tgt_point2D.xy,
-                                              src_point_in_tgt,
-                                              tgt_cam_from_world,
-                                              tgt_camera) >
-            max_squared_reproj_error_) {
-          continue;
-        }
+      const auto& tgt_point2D = tgt_image.Point2D(point2D_idx);
+      if (!tgt_point2D.HasPoint3D()) {
+        continue;
+      }
 
-        const Eigen::Vector3d tgt_point_in_src =
-            src_from_tgt *
-            tgt_reconstruction_->Point3D(tgt_point2D.point3D_id).xyz;
-        if (CalculateSquaredReprojectionError(src_point2D.xy,
-                                              tgt_point_in_src,
-                                              src_cam_from_world,
-                                              src_camera) >
-            max_squared_reproj_error_) {
-          continue;
-        }
+      num_common_points += 1;
 
-        num_inliers += 1;
+      const Eigen::Vector3d src_point_in_tgt =
+          tgt_from_src *
+          src_reconstruction_->Point3D(src_point2D.point3D_id).xyz;
+      if (CalculateSquaredReprojectionError(tgt_point2D.xy,
+                                            src_point_in_tgt,
+                                            tgt_cam_from_world,
+                                            tgt_camera) >
+          max_squared_reproj_error_) {
+        continue;
       }
 
-      if (num_common_points == 0) {
-        (*residuals)[i] = 1.0;
-      } else {
-        const double negative_inlier_ratio =
-            1.0 - static_cast<double>(num_inliers) /
-                      static_cast<double>(num_common_points);
-        (*residuals)[i] = negative_inlier_ratio * negative_inlier_ratio;
+      const Eigen::Vector3d tgt_point_in_src =
+          src_from_tgt *
+          tgt_reconstruction_->Point3D(tgt_point2D.point3D_id).xyz;
+      if (CalculateSquaredReprojectionError(src_point2D.xy,
+                                            tgt_point_in_src,
+                                            src_cam_from_world,
+                                            src_camera) >
+          max_squared_reproj_error_) {
+        continue;
       }
+
+      num_inliers += 1;
+    }
+
+    if (num_common_points == 0) {
+      return 1.0;
     }
+    const double negative_inlier_ratio =
+        1.0 - static_cast<double>(num_inliers) /
+                  static_cast<double>(num_common_points);
+    return negative_inlier_ratio * negative_inlier_ratio;
   }
 
- private:
   double max_squared_reproj_error_;
   const Reconstruction* src_reconstruction_;
   const Reconstruction* tgt_reconstruction_;
@@ -195,15 +210,21 @@ bool AlignReconstructionToLocations(
 
   // Find out which images are contained in the reconstruction and get the
   // positions of their camera centers.
+  std::unordered_map<std::string_view, const class Image*> src_images;
+  src_images.reserve(src_reconstruction.NumImages());
+  for (const auto& [_, image] : src_reconstruction.Images()) {
+    src_images.emplace(image.Name(), &image);
+  }
+
   std::unordered_set<image_t> common_image_ids;
   std::vector<Eigen::Vector3d> src;
   std::vector<Eigen::Vector3d> dst;
   for (size_t i = 0; i < tgt_image_names.size(); ++i) {
-    const class Image* src_image =
-        src_reconstruction.FindImageWithName(tgt_image_names[i]);
-    if (src_image == nullptr) {
+    const auto src_image_it = src_images.find(tgt_image_names[i]);
+    if (src_image_it == src_images.end()) {
       continue;
     }
+    const class Image* src_image = src_image_it->second;
 
     if (!src_image->HasPose()) {
       continue;
@@ -356,25 +377,31 @@ std::vector<ImageAlignmentError> ComputeImageAlignmentError(
   const std::vector<std::pair<image_t, image_t>> common_image_ids =
       src_reconstruction.FindCommonRegImageIds(tgt_reconstruction);
   const int num_common_images = common_image_ids.size();
-  std::vector<ImageAlignmentError> errors;
-  errors.reserve(num_common_images);
-  for (const auto& image_ids : common_image_ids) {
-    const auto& src_image = src_reconstruction.Image(image_ids.first);
-    const Rigid3d tgt_world_from_src_cam =
-        Inverse(TransformCameraWorld(tgt_from_src, src_image.CamFromWorld()));
-    const Rigid3d tgt_world_from_tgt_cam =
-        Inverse(tgt_reconstruction.Image(image_ids.second).CamFromWorld());
-
-    ImageAlignmentError error;
-    error.image_name = src_image.Name();
-    error.rotation_error_deg =
-        RadToDeg(tgt_world_from_src_cam.rotation().angularDistance(
-            tgt_world_from_tgt_cam.rotation()));
-    error.proj_center_error = (tgt_world_from_src_cam.translation() -
-                               tgt_world_from_tgt_cam.translation())
-                                  .norm();
-    errors.push_back(error);
-  }
+  std::vector<ImageAlignmentError> errors(num_common_images);
+  ParallelFor(
+      0,
+      num_common_images,
+      [&](const int64_t begin, const int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          const auto& [src_image_id, tgt_image_id] = common_image_ids[i];
+          const auto& src_image = src_reconstruction.Image(src_image_id);
+          const Rigid3d tgt_world_from_src_cam = Inverse(
+              TransformCameraWorld(tgt_from_src, src_image.CamFromWorld()));
+          const Rigid3d tgt_world_from_tgt_cam =
+              Inverse(tgt_reconstruction.Image(tgt_image_id).CamFromWorld());
+
+          ImageAlignmentError& error = errors[i];
+          error.image_name = src_image.Name();
+          error.rotation_error_deg =
+              RadToDeg(tgt_world_from_src_cam.rotation().angularDistance(
+                  tgt_world_from_tgt_cam.rotation()));
+          error.proj_center_error = (tgt_world_from_src_cam.translation() -
+                                     tgt_world_from_tgt_cam.translation())
+                                        .norm();
+        }
+      },
+      ThreadPool::kMaxNumThreads,
+      /*grain_size=*/256);
   return errors;
 }
 
@@ -482,7 +509,14 @@ bool MergeReconstructions(const double max_reproj_error,
                                             &tgt_from_src)) {
     return false;
   }
+  MergeAlignedReconstructions(
+      tgt_from_src, src_reconstruction, tgt_reconstruction);
+  return true;
+}
 
+void MergeAlignedReconstructions(const Sim3d& tgt_from_src,
+                                 const Reconstruction& src_reconstruction,
+                                 Reconstruction& tgt_reconstruction) {
   // Find common and missing images in the two reconstructions.
   std::unordered_set<image_t> common_image_ids;
   common_image_ids.reserve(src_reconstruction.NumRegImages());
@@ -544,8 +578,6 @@ bool MergeReconstructions(const double max_reproj_error,
       }
     }
   }
-
-  return true;
 }
 
 bool AlignReconstructionToOrigRigScales(
@@ -121,6 +121,12 @@ bool MergeReconstructions(double max_reproj_error,
                           const Reconstruction& src_reconstruction,
                           Reconstruction& tgt_reconstruction);
 
+// Merges cameras, images, points3D of the source into the target
+// reconstruction using a known alignment.
+void MergeAlignedReconstructions(const Sim3d& tgt_from_src,
+                                 const Reconstruction& src_reconstruction,
+                                 Reconstruction& tgt_reconstruction);
+
 // Align reconstruction to the original metric scales in rig extrinsics. Returns
 // false if there is no available non-panoramic rig in the alignment process.
 bool AlignReconstructionToOrigRigScales(
@@ -31,6 +31,15 @@
 
 #include "colmap/estimators/bundle_adjustment_caspar.h"
 #include "colmap/estimators/bundle_adjustment_ceres.h"
+#include "colmap/util/metrics.h"
+#include "colmap/util/misc.h"
+#include "colmap/util/string.h"
+#include "colmap/util/threading.h"
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <utility>
 
 namespace colmap {
 
@@ -47,6 +56,37 @@ std::string BundleAdjustmentSummary::BriefReport() const {
          ", num_residuals=" + std::to_string(num_residuals);
 }
 
+void RecordBundleAdjustmentMetrics(const BundleAdjustmentBackend backend,
+                                   const BundleAdjustmentSummary& summary) {
+  std::string backend_name(BundleAdjustmentBackendToString(backend));
+  StringToLower(&backend_name);
+  const std::string labels = "{backend=\"" + backend_name + "\"";
+  IncrementMetricCounter("colmap_bundle_adjustment_solves_total" + labels +
+                         "}");
+  IncrementMetricCounter(
+      "colmap_bundle_adjustment_iterations_total" + labels + "}",
+      summary.num_iterations);
+  IncrementMetricCounter(
+      "colmap_bundle_adjustment_linear_solver_iterations_total" + labels + "}",
+      summary.num_linear_solver_iterations);
+
+  const std::pair<const char*, double> stage_times[] = {
+      {"total", summary.total_time_sec},
+      {"jacobian_evaluation", summary.jacobian_evaluation_time_sec},
+      {"residual_evaluation", summary.residual_evaluation_time_sec},
+      {"linear_solver", summary.linear_solver_time_sec},
+      {"line_search", summary.line_search_time_sec},
+      {"device_transfer", summary.device_transfer_time_sec},
+  };
+  for (const auto& [stage, time_sec] : stage_times) {
+    if (time_sec >= 0) {
+      IncrementMetricCounter("colmap_bundle_adjustment_seconds_total" +
+                                 labels + ",stage=\"" + stage + "\"}",
+                             time_sec);
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // BundleAdjustmentConfig
 ////////////////////////////////////////////////////////////////////////////////
@@ -334,6 +374,79 @@ std::unique_ptr<BundleAdjuster> CreateDefaultBundleAdjuster(
   return nullptr;
 }
 
+std::vector<std::shared_ptr<BundleAdjustmentSummary>>
+SolveBundleAdjustmentBatch(const BundleAdjustmentOptions& options,
+                           const std::vector<BundleAdjustmentConfig>& configs,
+                           const std::vector<Reconstruction*>& reconstructions,
+                           int num_threads) {
+  THROW_CHECK_EQ(configs.size(), reconstructions.size());
+  std::vector<std::shared_ptr<BundleAdjustmentSummary>> summaries(
+      configs.size());
+  if (configs.empty()) {
+    return summaries;
+  }
+
+  // Each worker gets its own copy of the options, so that the solver threads
+  // or devices can be assigned per worker.
+  std::vector<BundleAdjustmentOptions> worker_options;
+  if (options.backend == BundleAdjustmentBackend::CASPAR && options.caspar) {
+    // Solves on the same device would only compete for its memory, so the
+    // problems are distributed over the listed devices instead.
+    for (const int gpu_index : CSVToVector<int>(options.caspar->gpu_index)) {
+      BundleAdjustmentOptions& device_options =
+          worker_options.emplace_back(options);
+      device_options.caspar->gpu_index = std::to_string(gpu_index);
+    }
+  } else {
+    num_threads = GetEffectiveNumThreads(num_threads);
+    const int num_workers =
+        std::min(num_threads, static_cast<int>(configs.size()));
+    worker_options.resize(num_workers, options);
+    if (options.ceres) {
+      for (BundleAdjustmentOptions& thread_options : worker_options) {
+        thread_options.ceres->solver_options.num_threads =
+            std::max(1, num_threads / num_workers);
+      }
+    }
+  }
+  if (worker_options.empty()) {
+    worker_options.push_back(options);
+  }
+  if (worker_options.size() > 1) {
+    // Avoid interleaved reports of concurrent solves.
+    for (BundleAdjustmentOptions& thread_options : worker_options) {
+      thread_options.print_summary = false;
+    }
+  }
+
+  // Start with the largest problems for better load balancing.
+  std::vector<size_t> order(configs.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::vector<size_t> num_residuals(configs.size());
+  for (size_t i = 0; i < configs.size(); ++i) {
+    num_residuals[i] =
+        configs[i].NumResiduals(*THROW_CHECK_NOTNULL(reconstructions[i]));
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t i, size_t j) {
+    return num_residuals[i] > num_residuals[j];
+  });
+
+  ThreadPool thread_pool(static_cast<int>(worker_options.size()));
+  for (const size_t i : order) {
+    thread_pool.AddTask([&, i]() {
+      std::unique_ptr<BundleAdjuster> bundle_adjuster =
+          CreateDefaultBundleAdjuster(
+              worker_options.at(thread_pool.GetThreadIndex()),
+              configs[i],
+              *reconstructions[i]);
+      summaries[i] = bundle_adjuster->Solve();
+    });
+  }
+  thread_pool.Wait();
+
+  return summaries;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // PosePriorBundleAdjustmentOptions
 ////////////////////////////////////////////////////////////////////////////////
@@ -34,8 +34,11 @@
 #include "colmap/util/eigen_alignment.h"
 #include "colmap/util/enum_utils.h"
 
+#include <functional>
 #include <memory>
+#include <string>
 #include <unordered_set>
+#include <vector>
 
 #include <Eigen/Core>
 
@@ -59,6 +62,24 @@ MAKE_ENUM_CLASS_OVERLOAD_STREAM(BundleAdjustmentTerminationType,
 // Backend for bundle adjustment solver.
 MAKE_ENUM_CLASS_OVERLOAD_STREAM(BundleAdjustmentBackend, 0, CERES, CASPAR);
 
+// Statistics of a single solver iteration, independent of solver backend.
+// Times are in seconds and negative if not reported by the backend.
+struct BundleAdjustmentIterationSummary {
+  int iteration = 0;
+  double cost = 0.0;
+  bool step_accepted = false;
+  double iteration_time_sec = -1.0;
+  double cumulative_time_sec = -1.0;
+  // Time to solve the linear system for the step.
+  double linear_solver_time_sec = -1.0;
+  // Time to evaluate the residuals and Jacobians, i.e., the remainder of the
+  // iteration time besides the linear solve.
+  double evaluation_time_sec = -1.0;
+  // Number of iterations of iterative linear solvers, e.g., the number of
+  // preconditioned conjugate gradient iterations.
+  int num_linear_solver_iterations = 0;
+};
+
 // Summary of bundle adjustment results, independent of solver backend.
 struct BundleAdjustmentSummary {
   BundleAdjustmentTerminationType termination_type =
@@ -66,6 +87,23 @@ struct BundleAdjustmentSummary {
   // Number of residuals connected to at least one variable parameter block.
   // Excludes residuals where all connected parameters are constant.
   int num_residuals = 0;
+  // Number of solver iterations.
+  int num_iterations = 0;
+
+  // Per-iteration statistics of the solver. The Caspar backend only reports
+  // them if the iteration data is collected.
+  std::vector<BundleAdjustmentIterationSummary> iteration_summaries;
+
+  // Breakdown of the solver time in seconds. Negative if not reported by the
+  // solver backend.
+  double total_time_sec = -1.0;
+  double jacobian_evaluation_time_sec = -1.0;
+  double residual_evaluation_time_sec = -1.0;
+  double linear_solver_time_sec = -1.0;
+  double line_search_time_sec = -1.0;
+  // Time to transfer the problem to and the solution from the device.
+  double device_transfer_time_sec = -1.0;
+  int num_linear_solver_iterations = 0;
 
   bool IsSolutionUsable() const;
   virtual std::string BriefReport() const;
@@ -205,6 +243,13 @@ struct BundleAdjustmentOptions : public BundleAdjustmentBackendOptions {
   // Solver backend to use for bundle adjustment.
   BundleAdjustmentBackend backend = BundleAdjustmentBackend::CERES;
 
+  // Optional callback invoked with the statistics of every solver iteration.
+  // The Ceres backend invokes it during the solve, whereas the Caspar backend
+  // invokes it for all iterations once the solve finished. The callback must
+  // be thread-safe when multiple problems or blocks are solved concurrently.
+  std::function<void(const BundleAdjustmentIterationSummary&)>
+      iteration_callback;
+
   bool Check() const;
 };
 
@@ -225,6 +270,11 @@ class BundleAdjuster {
   BundleAdjustmentConfig config_;
 };
 
+// Export the number of iterations and the time breakdown of a solve as
+// metrics labeled by the solver backend.
+void RecordBundleAdjustmentMetrics(BundleAdjustmentBackend backend,
+                                   const BundleAdjustmentSummary& summary);
+
 // Factory function to create bundle adjusters.
 // Currently uses Ceres as the backend, but can be extended to support
 // other backends (e.g., Caspar) in the future.
@@ -233,6 +283,18 @@ std::unique_ptr<BundleAdjuster> CreateDefaultBundleAdjuster(
     const BundleAdjustmentConfig& config,
     Reconstruction& reconstruction);
 
+// Solves many independent bundle adjustment problems, e.g., the sub-models of
+// a hierarchical reconstruction, where configs[i] refers to reconstructions[i].
+// The problems are distributed over a pool of num_threads workers with the
+// largest problems first and the available solver threads split between the
+// workers. With the Caspar backend, there is one worker per listed GPU device.
+// Returns one summary per problem in the input order.
+std::vector<std::shared_ptr<BundleAdjustmentSummary>>
+SolveBundleAdjustmentBatch(const BundleAdjustmentOptions& options,
+                           const std::vector<BundleAdjustmentConfig>& configs,
+                           const std::vector<Reconstruction*>& reconstructions,
+                           int num_threads = -1);
+
 struct PosePriorBundleAdjustmentBackendOptions {
   // Ceres-specific options (only used when backend == CERES).
   std::shared_ptr<CeresPosePriorBundleAdjustmentOptions> ceres;
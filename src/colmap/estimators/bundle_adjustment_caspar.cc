@@ -1,19 +1,56 @@
 #include "colmap/estimators/bundle_adjustment_caspar.h"
 
 #include "colmap/estimators/bundle_adjustment.h"
+#include "colmap/estimators/bundle_adjustment_ceres.h"
 #include "colmap/geometry/rigid3.h"
 #include "colmap/scene/camera.h"
 #include "colmap/scene/image.h"
 #include "colmap/sensor/models.h"
 #include "colmap/util/cuda.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/threading.h"
+#include "colmap/util/timer.h"
+#include "colmap/util/tracing.h"
 #ifdef CASPAR_ENABLED
 #include "colmap/estimators/caspar/caspar_model_adapter.h"
 #endif
 
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <queue>
+#include <tuple>
+#include <unordered_set>
+
 namespace colmap {
 namespace {
 
+// Polishes the solution of the Caspar solver with a few iterations of the
+// double-precision Ceres solver, if enabled in the options. Caspar is
+// typically built in single precision, which is fast for the bulk of the
+// optimization but limits the attainable accuracy.
+void MaybeRefineInDoublePrecision(const BundleAdjustmentOptions& options,
+                                  const BundleAdjustmentConfig& config,
+                                  Reconstruction& reconstruction,
+                                  BundleAdjustmentSummary& summary) {
+  const int num_iterations =
+      options.caspar ? options.caspar->num_double_precision_iterations : 0;
+  if (num_iterations <= 0 || !summary.IsSolutionUsable()) {
+    return;
+  }
+
+  BundleAdjustmentOptions refine_options = options;
+  refine_options.backend = BundleAdjustmentBackend::CERES;
+  if (!refine_options.ceres) {
+    refine_options.ceres = std::make_shared<CeresBundleAdjustmentOptions>();
+  }
+  refine_options.ceres->solver_options.max_num_iterations = num_iterations;
+  const std::shared_ptr<BundleAdjustmentSummary> refine_summary =
+      CreateDefaultCeresBundleAdjuster(refine_options, config, reconstruction)
+          ->Solve();
+  VLOG(1) << "Double-precision refinement: " << refine_summary->BriefReport();
+}
+
 class CasparBundleAdjuster : public BundleAdjuster {
  public:
   CasparBundleAdjuster(BundleAdjustmentOptions options,
@@ -91,6 +128,69 @@ class CasparBundleAdjuster : public BundleAdjuster {
     CreatePointNodes();
     AddFactors();
     AddExternalFactors();
+    SortFactors();
+  }
+
+  // Sorts the factors of each variant by point and then by pose, such that
+  // the observations of a point are contiguous in memory. The factors are
+  // otherwise in image iteration order, which leads to poorly coalesced memory
+  // accesses when eliminating the points in the Schur complement.
+  void SortFactors() {
+    for (auto& [model_id, md] : model_data_per_model_) {
+      for (VariantData& vd : md.variants) {
+        if (vd.num_factors < 2) {
+          continue;
+        }
+
+        auto IndexOrZero = [](const std::vector<unsigned int>& indices,
+                              const size_t i) {
+          return indices.empty() ? 0u : indices[i];
+        };
+        std::vector<size_t> order(vd.num_factors);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(
+            order.begin(), order.end(), [&](const size_t i, const size_t j) {
+              return std::make_tuple(
+                         IndexOrZero(vd.point_indices, i),
+                         IndexOrZero(vd.pose_indices, i),
+                         IndexOrZero(vd.focal_and_extra_indices, i),
+                         IndexOrZero(vd.principal_point_indices, i)) <
+                     std::make_tuple(
+                         IndexOrZero(vd.point_indices, j),
+                         IndexOrZero(vd.pose_indices, j),
+                         IndexOrZero(vd.focal_and_extra_indices, j),
+                         IndexOrZero(vd.principal_point_indices, j));
+            });
+
+        PermuteFactorData(order, vd.pose_indices);
+        PermuteFactorData(order, vd.sensor_from_rig_data);
+        PermuteFactorData(order, vd.focal_and_extra_indices);
+        PermuteFactorData(order, vd.principal_point_indices);
+        PermuteFactorData(order, vd.point_indices);
+        PermuteFactorData(order, vd.const_poses);
+        PermuteFactorData(order, vd.const_focal_and_extra);
+        PermuteFactorData(order, vd.const_principal_point);
+        PermuteFactorData(order, vd.const_points);
+        PermuteFactorData(order, vd.pixels);
+      }
+    }
+  }
+
+  // Reorders per-factor data with a fixed number of entries per factor.
+  template <typename T>
+  static void PermuteFactorData(const std::vector<size_t>& order,
+                                std::vector<T>& data) {
+    if (data.empty()) {
+      return;
+    }
+    const size_t stride = data.size() / order.size();
+    std::vector<T> permuted_data(data.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      std::copy_n(data.begin() + order[i] * stride,
+                  stride,
+                  permuted_data.begin() + i * stride);
+    }
+    data = std::move(permuted_data);
   }
 
   void CreateCalibrationNodes() {
@@ -930,16 +1030,40 @@ class CasparBundleAdjuster : public BundleAdjuster {
     LogFactorDistribution();
 
     auto solver = CreateSolver(params, BuildSizing(), device_id);
-    SetupSolverData(solver);
+    Timer transfer_timer;
+    {
+      COLMAP_TRACE_ZONE("CasparUploadData");
+      transfer_timer.Start();
+      SetupSolverData(solver);
+      transfer_timer.Pause();
+    }
     const bool collect_iters =
-        options_.caspar && options_.caspar->collect_iteration_data;
-    caspar::SolveResult result = solver.solve(
-        /*print_progress=*/false, /*verbose_logging=*/collect_iters);
-    ReadSolverResults(solver);
+        (options_.caspar && options_.caspar->collect_iteration_data) ||
+        options_.iteration_callback;
+    caspar::SolveResult result;
+    {
+      COLMAP_TRACE_ZONE("CasparSolve");
+      result = solver.solve(
+          /*print_progress=*/false, /*verbose_logging=*/collect_iters);
+    }
+    {
+      COLMAP_TRACE_ZONE("CasparDownloadData");
+      transfer_timer.Resume();
+      ReadSolverResults(solver);
+      transfer_timer.Pause();
+    }
     WriteResultsToReconstruction();
 
     auto summary = CasparBundleAdjustmentSummary::Create(result);
     summary->num_residuals = ComputeTotalResiduals();
+    summary->device_transfer_time_sec = transfer_timer.ElapsedSeconds();
+    RecordBundleAdjustmentMetrics(BundleAdjustmentBackend::CASPAR, *summary);
+    if (options_.iteration_callback) {
+      for (const auto& iteration : summary->iteration_summaries) {
+        options_.iteration_callback(iteration);
+      }
+    }
+    MaybeRefineInDoublePrecision(options_, config_, reconstruction_, *summary);
     return summary;
   }
 
@@ -976,6 +1100,366 @@ class CasparBundleAdjuster : public BundleAdjuster {
   std::unordered_set<point3D_t> gauge_fixed_points_;
   std::unordered_map<point3D_t, size_t> point3D_num_observations_;
 };
+
+size_t NumObservations(const BundleAdjustmentConfig& config,
+                       const Reconstruction& reconstruction) {
+  size_t num_observations = 0;
+  for (const image_t image_id : config.Images()) {
+    num_observations += reconstruction.Image(image_id).NumPoints3D();
+  }
+  return num_observations;
+}
+
+// Solves bundle adjustment in blocks of frames, either to distribute it over
+// multiple GPUs or to bound the problem size resident on a single device. The
+// generated Caspar solver operates on a single device, so the problem is
+// solved by block coordinate descent: the frames are split into connected
+// blocks and each outer iteration first refines the poses and the points
+// exclusive to each block, holding points shared between blocks and the
+// intrinsics constant. Afterwards, the points and intrinsics are refined with
+// the poses held constant, either jointly or, if the problem exceeds the
+// device budget, again in blocks. Blocks are solved concurrently with one
+// block per device. Their factors are assembled on the host upfront, so only
+// the blocks currently being solved are resident in device memory.
+class PartitionedCasparBundleAdjuster : public BundleAdjuster {
+ public:
+  PartitionedCasparBundleAdjuster(BundleAdjustmentOptions options,
+                                  BundleAdjustmentConfig config,
+                                  Reconstruction& reconstruction,
+                                  std::vector<int> gpu_indices)
+      : BundleAdjuster(options, config),
+        reconstruction_(reconstruction),
+        gpu_indices_(std::move(gpu_indices)) {
+    THROW_CHECK_GT(options_.caspar->num_multi_gpu_iterations, 0);
+    const size_t num_observations = NumObservations(config_, reconstruction_);
+    const int max_num_observations =
+        options_.caspar->max_num_observations_per_solve;
+    num_partitions_ = gpu_indices_.size();
+    if (max_num_observations > 0) {
+      num_partitions_ = std::max(
+          num_partitions_,
+          (num_observations + max_num_observations - 1) / max_num_observations);
+    }
+    out_of_core_ = max_num_observations > 0 &&
+                   num_observations > static_cast<size_t>(max_num_observations);
+    VLOG(1) << "Using partitioned Caspar bundle adjuster with "
+            << num_partitions_ << " blocks on " << gpu_indices_.size()
+            << " devices";
+  }
+
+  std::shared_ptr<BundleAdjustmentSummary> Solve() override {
+    const std::vector<std::vector<frame_t>> partitions = PartitionFrames();
+
+    std::shared_ptr<BundleAdjustmentSummary> summary;
+    for (int iter = 0; iter < options_.caspar->num_multi_gpu_iterations;
+         ++iter) {
+      if (options_.refine_rig_from_world && partitions.size() > 1) {
+        SolvePartitions(partitions);
+      }
+      if (out_of_core_) {
+        summary = SolvePartitionedPointsAndIntrinsics(partitions);
+      } else {
+        summary = SolvePointsAndIntrinsics();
+      }
+      if (summary->termination_type ==
+          BundleAdjustmentTerminationType::USER_FAILURE) {
+        break;
+      }
+    }
+    MaybeRefineInDoublePrecision(options_, config_, reconstruction_, *summary);
+    return summary;
+  }
+
+ private:
+  // Orders the frames by a breadth-first traversal of the co-visibility graph
+  // and splits the order into contiguous blocks with a similar number of
+  // observations, such that most points are observed by a single block.
+  std::vector<std::vector<frame_t>> PartitionFrames() const {
+    std::map<frame_t, std::vector<image_t>> frame_to_image_ids;
+    for (const image_t image_id : config_.Images()) {
+      frame_to_image_ids[reconstruction_.Image(image_id).FrameId()].push_back(
+          image_id);
+    }
+
+    std::vector<frame_t> ordered_frame_ids;
+    ordered_frame_ids.reserve(frame_to_image_ids.size());
+    std::unordered_set<frame_t> visited_frame_ids;
+    std::unordered_set<point3D_t> visited_point3D_ids;
+    for (const auto& [root_frame_id, _] : frame_to_image_ids) {
+      if (!visited_frame_ids.insert(root_frame_id).second) {
+        continue;
+      }
+      std::queue<frame_t> queue;
+      queue.push(root_frame_id);
+      while (!queue.empty()) {
+        const frame_t frame_id = queue.front();
+        queue.pop();
+        ordered_frame_ids.push_back(frame_id);
+        for (const image_t image_id : frame_to_image_ids.at(frame_id)) {
+          for (const Point2D& point2D :
+               reconstruction_.Image(image_id).Points2D()) {
+            if (!point2D.HasPoint3D() ||
+                !visited_point3D_ids.insert(point2D.point3D_id).second) {
+              continue;
+            }
+            for (const auto& track_el :
+                 reconstruction_.Point3D(point2D.point3D_id).track.Elements()) {
+              if (!config_.HasImage(track_el.image_id)) {
+                continue;
+              }
+              const frame_t other_frame_id =
+                  reconstruction_.Image(track_el.image_id).FrameId();
+              if (visited_frame_ids.insert(other_frame_id).second) {
+                queue.push(other_frame_id);
+              }
+            }
+          }
+        }
+      }
+    }
+
+    const size_t num_partitions =
+        std::min(num_partitions_, ordered_frame_ids.size());
+    const size_t num_observations =
+        std::max<size_t>(NumObservations(config_, reconstruction_), 1);
+    std::vector<std::vector<frame_t>> partitions(num_partitions);
+    size_t cum_num_observations = 0;
+    for (const frame_t frame_id : ordered_frame_ids) {
+      const size_t partition_idx =
+          std::min(num_partitions - 1,
+                   cum_num_observations * num_partitions / num_observations);
+      partitions[partition_idx].push_back(frame_id);
+      for (const image_t image_id : frame_to_image_ids.at(frame_id)) {
+        cum_num_observations += reconstruction_.Image(image_id).NumPoints3D();
+      }
+    }
+    partitions.erase(
+        std::remove_if(partitions.begin(),
+                       partitions.end(),
+                       [](const auto& partition) { return partition.empty(); }),
+        partitions.end());
+    return partitions;
+  }
+
+  BundleAdjustmentOptions CreateDeviceOptions(const int gpu_index) const {
+    BundleAdjustmentOptions device_options = options_;
+    device_options.caspar->gpu_index = std::to_string(gpu_index);
+    // Refinement reads the whole reconstruction and thus cannot run
+    // concurrently with other blocks, so it is applied once at the end.
+    device_options.caspar->num_double_precision_iterations = 0;
+    device_options.print_summary = false;
+    return device_options;
+  }
+
+  BundleAdjustmentConfig CreatePartitionConfig(
+      const std::vector<frame_t>& partition) const {
+    BundleAdjustmentConfig partition_config;
+    for (const frame_t frame_id : partition) {
+      const Frame& frame = reconstruction_.Frame(frame_id);
+      for (const data_t& data_id : frame.ImageIds()) {
+        if (config_.HasImage(data_id.id)) {
+          partition_config.AddImage(data_id.id);
+        }
+      }
+      if (config_.HasConstantRigFromWorldPose(frame_id)) {
+        partition_config.SetConstantRigFromWorldPose(frame_id);
+      }
+    }
+    for (const image_t image_id : partition_config.Images()) {
+      const Image& image = reconstruction_.Image(image_id);
+      for (const Point2D& point2D : image.Points2D()) {
+        if (!point2D.HasPoint3D()) {
+          continue;
+        }
+        if (config_.IsIgnoredPoint(point2D.point3D_id)) {
+          partition_config.IgnorePoint(point2D.point3D_id);
+        } else if (config_.HasConstantPoint(point2D.point3D_id)) {
+          partition_config.AddConstantPoint(point2D.point3D_id);
+        }
+      }
+    }
+    return partition_config;
+  }
+
+  // Solves the given blocks in waves of one block per device. The adjusters
+  // read the shared reconstruction on construction, so they are all created
+  // before any of them writes back its results. The caller must ensure that
+  // the blocks write back disjoint parameters.
+  std::shared_ptr<BundleAdjustmentSummary> SolveBlocks(
+      const std::vector<BundleAdjustmentOptions>& block_options,
+      std::vector<BundleAdjustmentConfig> block_configs) {
+    std::vector<std::unique_ptr<BundleAdjuster>> bundle_adjusters;
+    bundle_adjusters.reserve(block_configs.size());
+    for (size_t i = 0; i < block_configs.size(); ++i) {
+      bundle_adjusters.push_back(std::make_unique<CasparBundleAdjuster>(
+          block_options[i], std::move(block_configs[i]), reconstruction_));
+    }
+
+    auto summary = std::make_shared<BundleAdjustmentSummary>();
+    summary->termination_type = BundleAdjustmentTerminationType::CONVERGENCE;
+    std::vector<std::shared_ptr<BundleAdjustmentSummary>> block_summaries(
+        bundle_adjusters.size());
+    ThreadPool thread_pool(gpu_indices_.size());
+    for (size_t begin = 0; begin < bundle_adjusters.size();
+         begin += gpu_indices_.size()) {
+      const size_t end =
+          std::min(begin + gpu_indices_.size(), bundle_adjusters.size());
+      for (size_t i = begin; i < end; ++i) {
+        thread_pool.AddTask([&bundle_adjusters, &block_summaries, i]() {
+          block_summaries[i] = bundle_adjusters[i]->Solve();
+          // Release the host copy of the factors as soon as possible.
+          bundle_adjusters[i].reset();
+        });
+      }
+      thread_pool.Wait();
+    }
+
+    // Blocks without any variable parameters are skipped by the adjuster and
+    // only fail the overall solve if no block could be solved.
+    size_t num_solved_blocks = 0;
+    for (const auto& block_summary : block_summaries) {
+      if (block_summary->termination_type ==
+          BundleAdjustmentTerminationType::USER_FAILURE) {
+        continue;
+      }
+      ++num_solved_blocks;
+      summary->num_residuals += block_summary->num_residuals;
+      if (block_summary->termination_type !=
+          BundleAdjustmentTerminationType::CONVERGENCE) {
+        summary->termination_type = block_summary->termination_type;
+      }
+    }
+    if (num_solved_blocks == 0) {
+      summary->termination_type = BundleAdjustmentTerminationType::USER_FAILURE;
+    }
+    return summary;
+  }
+
+  // Points observed by images of several blocks, or by images outside of the
+  // config, are not added to a block and thus held constant by the adjuster.
+  void SolvePartitions(const std::vector<std::vector<frame_t>>& partitions) {
+    std::vector<BundleAdjustmentOptions> block_options;
+    std::vector<BundleAdjustmentConfig> block_configs;
+    for (size_t i = 0; i < partitions.size(); ++i) {
+      BundleAdjustmentOptions partition_options =
+          CreateDeviceOptions(gpu_indices_[i % gpu_indices_.size()]);
+      partition_options.refine_focal_length = false;
+      partition_options.refine_principal_point = false;
+      partition_options.refine_extra_params = false;
+      block_options.push_back(std::move(partition_options));
+      block_configs.push_back(CreatePartitionConfig(partitions[i]));
+    }
+    SolveBlocks(block_options, std::move(block_configs));
+  }
+
+  std::shared_ptr<BundleAdjustmentSummary> SolvePointsAndIntrinsics() {
+    BundleAdjustmentConfig points_config = config_;
+    points_config.FixGauge(BundleAdjustmentGauge::UNSPECIFIED);
+    for (const image_t image_id : config_.Images()) {
+      points_config.SetConstantRigFromWorldPose(
+          reconstruction_.Image(image_id).FrameId());
+    }
+    BundleAdjustmentOptions points_options =
+        CreateDeviceOptions(gpu_indices_[0]);
+    points_options.refine_rig_from_world = false;
+    CasparBundleAdjuster bundle_adjuster(
+        std::move(points_options), std::move(points_config), reconstruction_);
+    return bundle_adjuster.Solve();
+  }
+
+  // With constant poses, each point only depends on its own observations.
+  // Every point is therefore refined in exactly one block, which includes its
+  // observations from other blocks as constant factors. Intrinsics of cameras
+  // shared between blocks are held constant.
+  std::shared_ptr<BundleAdjustmentSummary> SolvePartitionedPointsAndIntrinsics(
+      const std::vector<std::vector<frame_t>>& partitions) {
+    std::vector<BundleAdjustmentConfig> block_configs;
+    std::unordered_map<camera_t, size_t> camera_to_partition_idx;
+    std::unordered_set<camera_t> shared_camera_ids;
+    std::unordered_set<point3D_t> assigned_point3D_ids;
+    for (size_t i = 0; i < partitions.size(); ++i) {
+      BundleAdjustmentConfig block_config =
+          CreatePartitionConfig(partitions[i]);
+      for (const image_t image_id : block_config.Images()) {
+        const Image& image = reconstruction_.Image(image_id);
+        block_config.SetConstantRigFromWorldPose(image.FrameId());
+        const auto [it, inserted] =
+            camera_to_partition_idx.emplace(image.CameraId(), i);
+        if (!inserted && it->second != i) {
+          shared_camera_ids.insert(image.CameraId());
+        }
+        if (config_.HasConstantCamIntrinsics(image.CameraId())) {
+          block_config.SetConstantCamIntrinsics(image.CameraId());
+        }
+        for (const Point2D& point2D : image.Points2D()) {
+          if (point2D.HasPoint3D() &&
+              !block_config.IsIgnoredPoint(point2D.point3D_id) &&
+              !block_config.HasConstantPoint(point2D.point3D_id) &&
+              assigned_point3D_ids.insert(point2D.point3D_id).second) {
+            block_config.AddVariablePoint(point2D.point3D_id);
+          }
+        }
+      }
+      block_configs.push_back(std::move(block_config));
+    }
+
+    std::vector<BundleAdjustmentOptions> block_options;
+    for (size_t i = 0; i < block_configs.size(); ++i) {
+      for (const camera_t camera_id : shared_camera_ids) {
+        block_configs[i].SetConstantCamIntrinsics(camera_id);
+      }
+      BundleAdjustmentOptions points_options =
+          CreateDeviceOptions(gpu_indices_[i % gpu_indices_.size()]);
+      points_options.refine_rig_from_world = false;
+      block_options.push_back(std::move(points_options));
+    }
+    return SolveBlocks(block_options, std::move(block_configs));
+  }
+
+  Reconstruction& reconstruction_;
+  const std::vector<int> gpu_indices_;
+  size_t num_partitions_ = 1;
+  bool out_of_core_ = false;
+};
+
+// Returns a camera of the problem whose model has no generated Caspar factors
+// or nullptr if there is none. This includes the cameras of the images outside
+// the config that observe its points, which are added as external factors.
+const Camera* FindUnsupportedCamera(const BundleAdjustmentConfig& config,
+                                    const Reconstruction& reconstruction) {
+  std::unordered_set<CameraModelId> checked_model_ids;
+  const auto is_unsupported = [&checked_model_ids](const Camera& camera) {
+    return checked_model_ids.insert(camera.model_id).second &&
+           !CreateCasparAdapter(camera.model_id);
+  };
+
+  for (const image_t image_id : config.Images()) {
+    const Camera& camera = *reconstruction.Image(image_id).CameraPtr();
+    if (is_unsupported(camera)) {
+      return &camera;
+    }
+  }
+
+  for (const auto* point3D_ids : {&config.VariablePoints(),
+                                  &config.ConstantPoints()}) {
+    for (const point3D_t point3D_id : *point3D_ids) {
+      const Point3D& point3D = reconstruction.Point3D(point3D_id);
+      for (const auto& track_el : point3D.track.Elements()) {
+        if (config.HasImage(track_el.image_id)) {
+          continue;
+        }
+        const Camera& camera =
+            *reconstruction.Image(track_el.image_id).CameraPtr();
+        if (is_unsupported(camera)) {
+          return &camera;
+        }
+      }
+    }
+  }
+
+  return nullptr;
+}
+
 }  // namespace
 
 std::shared_ptr<CasparBundleAdjustmentSummary>
@@ -985,6 +1469,29 @@ CasparBundleAdjustmentSummary::Create(
   summary->iteration_count = caspar_summary.iteration_count;
   summary->initial_score = caspar_summary.initial_score;
   summary->iterations = caspar_summary.iterations;
+  summary->num_iterations = caspar_summary.iteration_count;
+  summary->total_time_sec = caspar_summary.runtime;
+  // The solver only measures the cumulative time and only accepts steps that
+  // decrease the best score, so the iteration time and acceptance are derived
+  // from consecutive iterations.
+  double prev_cumulative_time = 0.0;
+  double prev_best_score = caspar_summary.initial_score;
+  summary->iteration_summaries.reserve(caspar_summary.iterations.size());
+  for (const caspar::IterationData& caspar_iteration :
+       caspar_summary.iterations) {
+    BundleAdjustmentIterationSummary& iteration =
+        summary->iteration_summaries.emplace_back();
+    iteration.iteration = caspar_iteration.solver_iter;
+    iteration.cost = caspar_iteration.score_current;
+    iteration.step_accepted = caspar_iteration.score_best < prev_best_score;
+    iteration.iteration_time_sec =
+        caspar_iteration.dt_tot - prev_cumulative_time;
+    iteration.cumulative_time_sec = caspar_iteration.dt_tot;
+    iteration.num_linear_solver_iterations = caspar_iteration.pcg_iter;
+    summary->num_linear_solver_iterations += caspar_iteration.pcg_iter;
+    prev_cumulative_time = caspar_iteration.dt_tot;
+    prev_best_score = caspar_iteration.score_best;
+  }
   switch (caspar_summary.exit_reason) {
     case caspar::ExitReason::CONVERGED_DIAG_EXIT:
       VLOG(1) << "Caspar: CONVERGED_DIAG_EXIT after "
@@ -1013,6 +1520,27 @@ std::unique_ptr<BundleAdjuster> CreateDefaultCasparBundleAdjuster(
     const BundleAdjustmentOptions& options,
     const BundleAdjustmentConfig& config,
     Reconstruction& reconstruction) {
+  // Observations of unsupported camera models cannot be expressed by the
+  // generated Caspar factors. Rather than silently dropping them, solve the
+  // whole problem with Ceres.
+  if (const Camera* camera = FindUnsupportedCamera(config, reconstruction)) {
+    LOG(WARNING) << "Caspar does not support the " << camera->ModelName()
+                 << " camera model, falling back to Ceres bundle adjustment";
+    return CreateDefaultCeresBundleAdjuster(options, config, reconstruction);
+  }
+
+  if (options.caspar) {
+    std::vector<int> gpu_indices = CSVToVector<int>(options.caspar->gpu_index);
+    const int max_num_observations =
+        options.caspar->max_num_observations_per_solve;
+    if (gpu_indices.size() > 1 ||
+        (max_num_observations > 0 &&
+         NumObservations(config, reconstruction) >
+             static_cast<size_t>(max_num_observations))) {
+      return std::make_unique<PartitionedCasparBundleAdjuster>(
+          options, config, reconstruction, std::move(gpu_indices));
+    }
+  }
   return std::make_unique<CasparBundleAdjuster>(
       options, config, reconstruction);
 }
@@ -118,10 +118,28 @@ struct CasparBundleAdjustmentOptions {
   double pcg_rel_score_exit = -1.0;
   double pcg_rel_decrease_min = -1.0;
   double solver_rel_decrease_min = 1.0;
+  // Comma-separated list of GPU indices. If multiple GPUs are given, the
+  // frames are partitioned into one block per GPU and the problem is solved
+  // by alternating between concurrent per-block pose refinement and joint
+  // point and intrinsics refinement.
   std::string gpu_index = "-1";
+  // Number of double-precision Ceres iterations to refine the solution of
+  // the (typically single-precision) Caspar solver. The bulk of the
+  // optimization runs on the GPU, while the refinement recovers the accuracy
+  // of a double-precision solve. Zero disables the refinement.
+  int num_double_precision_iterations = 0;
+  // Maximum number of observations solved at once on a single GPU. Larger
+  // problems are split into blocks of frames that are assembled on the host
+  // and solved one after another using the same alternation as for multiple
+  // GPUs. Negative value disables the limit.
+  int max_num_observations_per_solve = -1;
+  // Number of alternations when solving in blocks.
+  int num_multi_gpu_iterations = 3;
   bool collect_iteration_data = false;
 };
 
+// Creates a Caspar bundle adjuster, or a Ceres bundle adjuster if any image of
+// the config uses a camera model that is not supported by Caspar.
 std::unique_ptr<BundleAdjuster> CreateDefaultCasparBundleAdjuster(
     const BundleAdjustmentOptions& options,
     const BundleAdjustmentConfig& config,
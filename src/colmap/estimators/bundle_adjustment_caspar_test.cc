@@ -165,6 +165,175 @@ TEST(DefaultBundleAdjuster, RigThrowsErrorOnVariableSensorFromRig) {
       std::invalid_argument);
 }
 
+TEST(DefaultBundleAdjuster, DoublePrecisionRefinement) {
+  SetPRNGSeed(0);
+  Reconstruction gt_reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 10;
+  synthetic_dataset_options.num_points3D = 200;
+  SynthesizeDataset(synthetic_dataset_options, &gt_reconstruction);
+
+  Reconstruction reconstruction = gt_reconstruction;
+
+  SyntheticNoiseOptions synthetic_noise_options;
+  synthetic_noise_options.point2D_stddev = 0.5;
+  synthetic_noise_options.point3D_stddev = 0.1;
+  synthetic_noise_options.rig_from_world_rotation_stddev = 0.5;
+  synthetic_noise_options.rig_from_world_translation_stddev = 0.1;
+  SynthesizeNoise(synthetic_noise_options, &reconstruction);
+
+  BundleAdjustmentConfig config;
+  for (const image_t image_id : reconstruction.RegImageIds()) {
+    config.AddImage(image_id);
+  }
+
+  BundleAdjustmentOptions options;
+  options.caspar->num_double_precision_iterations = 10;
+  std::unique_ptr<BundleAdjuster> bundle_adjuster =
+      CreateDefaultCasparBundleAdjuster(options, config, reconstruction);
+  const auto summary = bundle_adjuster->Solve();
+  ASSERT_NE(summary->termination_type,
+            BundleAdjustmentTerminationType::FAILURE);
+
+  EXPECT_THAT(gt_reconstruction,
+              ReconstructionNear(reconstruction,
+                                 /*max_rotation_error_deg=*/0.1,
+                                 /*max_proj_center_error=*/0.1,
+                                 /*max_scale_error=*/std::nullopt,
+                                 /*num_obs_tolerance=*/0.0));
+}
+
+TEST(DefaultBundleAdjuster, MaxNumObservationsPerSolve) {
+  SetPRNGSeed(0);
+  Reconstruction gt_reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 10;
+  synthetic_dataset_options.num_points3D = 200;
+  SynthesizeDataset(synthetic_dataset_options, &gt_reconstruction);
+
+  Reconstruction reconstruction = gt_reconstruction;
+
+  SyntheticNoiseOptions synthetic_noise_options;
+  synthetic_noise_options.point2D_stddev = 0.5;
+  synthetic_noise_options.point3D_stddev = 0.1;
+  synthetic_noise_options.rig_from_world_rotation_stddev = 0.1;
+  synthetic_noise_options.rig_from_world_translation_stddev = 0.01;
+  SynthesizeNoise(synthetic_noise_options, &reconstruction);
+
+  BundleAdjustmentConfig config;
+  for (const image_t image_id : reconstruction.RegImageIds()) {
+    config.AddImage(image_id);
+  }
+
+  // Split the problem into blocks of about a third of the observations.
+  BundleAdjustmentOptions options;
+  options.caspar->max_num_observations_per_solve =
+      reconstruction.ComputeNumObservations() / 3;
+  options.caspar->num_multi_gpu_iterations = 10;
+  std::unique_ptr<BundleAdjuster> bundle_adjuster =
+      CreateDefaultCasparBundleAdjuster(options, config, reconstruction);
+  const auto summary = bundle_adjuster->Solve();
+  ASSERT_NE(summary->termination_type,
+            BundleAdjustmentTerminationType::FAILURE);
+
+  EXPECT_THAT(gt_reconstruction,
+              ReconstructionNear(reconstruction,
+                                 /*max_rotation_error_deg=*/0.1,
+                                 /*max_proj_center_error=*/0.1,
+                                 /*max_scale_error=*/std::nullopt,
+                                 /*num_obs_tolerance=*/0.0));
+}
+
+TEST(DefaultBundleAdjuster, UnsupportedCameraModelFallsBackToCeres) {
+  SetPRNGSeed(0);
+  Reconstruction gt_reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 10;
+  synthetic_dataset_options.num_points3D = 200;
+  synthetic_dataset_options.camera_model_id = OpenCVCameraModel::model_id;
+  SynthesizeDataset(synthetic_dataset_options, &gt_reconstruction);
+
+  Reconstruction reconstruction = gt_reconstruction;
+
+  SyntheticNoiseOptions synthetic_noise_options;
+  synthetic_noise_options.point2D_stddev = 0.5;
+  synthetic_noise_options.point3D_stddev = 0.1;
+  SynthesizeNoise(synthetic_noise_options, &reconstruction);
+
+  BundleAdjustmentConfig config;
+  for (const image_t image_id : reconstruction.RegImageIds()) {
+    config.AddImage(image_id);
+  }
+
+  BundleAdjustmentOptions options;
+  options.backend = BundleAdjustmentBackend::CASPAR;
+  std::unique_ptr<BundleAdjuster> bundle_adjuster =
+      CreateDefaultCasparBundleAdjuster(options, config, reconstruction);
+  EXPECT_NE(dynamic_cast<CeresBundleAdjuster*>(bundle_adjuster.get()),
+            nullptr);
+  const auto summary = bundle_adjuster->Solve();
+  ASSERT_NE(summary->termination_type,
+            BundleAdjustmentTerminationType::FAILURE);
+
+  EXPECT_THAT(gt_reconstruction,
+              ReconstructionNear(reconstruction,
+                                 /*max_rotation_error_deg=*/0.1,
+                                 /*max_proj_center_error=*/0.1,
+                                 /*max_scale_error=*/std::nullopt,
+                                 /*num_obs_tolerance=*/0.0));
+}
+
+TEST(DefaultBundleAdjuster,
+     UnsupportedCameraModelOfExternalObservationFallsBackToCeres) {
+  SetPRNGSeed(0);
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 5;
+  synthetic_dataset_options.num_points3D = 100;
+  synthetic_dataset_options.camera_model_id = SimpleRadialCameraModel::model_id;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+
+  // Only the images of the first camera are part of the problem, while the
+  // images of the second camera observe its points from outside.
+  const camera_t camera_id1 = reconstruction.Cameras().begin()->first;
+  camera_t camera_id2 = kInvalidCameraId;
+  BundleAdjustmentConfig config;
+  for (const image_t image_id : reconstruction.RegImageIds()) {
+    const Image& image = reconstruction.Image(image_id);
+    if (image.CameraId() == camera_id1) {
+      config.AddImage(image_id);
+    } else {
+      camera_id2 = image.CameraId();
+    }
+  }
+  ASSERT_NE(camera_id2, kInvalidCameraId);
+  for (const auto& [point3D_id, _] : reconstruction.Points3D()) {
+    config.AddVariablePoint(point3D_id);
+  }
+
+  Camera& camera2 = reconstruction.Camera(camera_id2);
+  camera2 = Camera::CreateFromModelId(camera_id2,
+                                      OpenCVCameraModel::model_id,
+                                      camera2.MeanFocalLength(),
+                                      camera2.width,
+                                      camera2.height);
+
+  BundleAdjustmentOptions options;
+  options.backend = BundleAdjustmentBackend::CASPAR;
+  std::unique_ptr<BundleAdjuster> bundle_adjuster =
+      CreateDefaultCasparBundleAdjuster(options, config, reconstruction);
+  EXPECT_NE(dynamic_cast<CeresBundleAdjuster*>(bundle_adjuster.get()),
+            nullptr);
+}
+
 TEST(DefaultBundleAdjuster, NominalMultiCameraRigConstantSensorFromRig) {
   // Exercises the sensor_from_rig code path: 2 cameras per rig, one of which
   // has a non-identity sensor_from_rig. Verifies that Caspar converges to the
@@ -37,8 +37,13 @@
 #include "colmap/util/cuda.h"
 #include "colmap/util/misc.h"
 #include "colmap/util/threading.h"
+#include "colmap/util/tracing.h"
 
+#include <algorithm>
+#include <array>
+#include <functional>
 #include <iomanip>
+#include <optional>
 
 namespace colmap {
 
@@ -62,6 +67,25 @@ BundleAdjustmentTerminationType CeresTerminationTypeToTerminationType(
   return BundleAdjustmentTerminationType::FAILURE;
 }
 
+BundleAdjustmentIterationSummary CeresIterationSummaryToIterationSummary(
+    const ceres::IterationSummary& ceres_iteration) {
+  BundleAdjustmentIterationSummary iteration;
+  iteration.iteration = ceres_iteration.iteration;
+  iteration.cost = ceres_iteration.cost;
+  iteration.step_accepted = ceres_iteration.step_is_successful;
+  iteration.iteration_time_sec = ceres_iteration.iteration_time_in_seconds;
+  iteration.cumulative_time_sec = ceres_iteration.cumulative_time_in_seconds;
+  iteration.linear_solver_time_sec =
+      ceres_iteration.step_solver_time_in_seconds;
+  iteration.evaluation_time_sec =
+      std::max(0.0,
+               ceres_iteration.iteration_time_in_seconds -
+                   ceres_iteration.step_solver_time_in_seconds);
+  iteration.num_linear_solver_iterations =
+      ceres_iteration.linear_solver_iterations;
+  return iteration;
+}
+
 std::unique_ptr<ceres::LossFunction> CreateLossFunction(
     CeresBundleAdjustmentOptions::LossFunctionType loss_function_type,
     double loss_function_scale) {
@@ -86,6 +110,25 @@ CeresBundleAdjustmentSummary::Create(ceres::Solver::Summary ceres_summary) {
   summary->termination_type =
       CeresTerminationTypeToTerminationType(ceres_summary.termination_type);
   summary->num_residuals = ceres_summary.num_residuals_reduced;
+  summary->num_iterations = ceres_summary.num_successful_steps +
+                            ceres_summary.num_unsuccessful_steps;
+  summary->iteration_summaries.reserve(ceres_summary.iterations.size());
+  for (const ceres::IterationSummary& ceres_iteration :
+       ceres_summary.iterations) {
+    summary->iteration_summaries.push_back(
+        CeresIterationSummaryToIterationSummary(ceres_iteration));
+    summary->num_linear_solver_iterations +=
+        ceres_iteration.linear_solver_iterations;
+  }
+  summary->total_time_sec = ceres_summary.total_time_in_seconds;
+  summary->jacobian_evaluation_time_sec =
+      ceres_summary.jacobian_evaluation_time_in_seconds;
+  summary->residual_evaluation_time_sec =
+      ceres_summary.residual_evaluation_time_in_seconds;
+  summary->linear_solver_time_sec =
+      ceres_summary.linear_solver_time_in_seconds;
+  summary->line_search_time_sec =
+      ceres_summary.line_search_total_time_in_seconds;
   summary->ceres_summary = std::move(ceres_summary);
   return summary;
 }
@@ -295,8 +338,9 @@ void FixGaugeWithThreePoints(
 // cases well, e.g., where the selected two cameras are not well constrained
 // with respect to each other with shared observations. Furthermore, the
 // implementation could be more sophisticated for multi-camera rigs by selecting
-// camera pairs within a rig, etc.
-void FixGaugeWithTwoCamsFromWorld(
+// camera pairs within a rig, etc. Returns the frame whose manifold was changed
+// to fix the translation along one baseline dimension, if any.
+frame_t FixGaugeWithTwoCamsFromWorld(
     const BundleAdjustmentOptions& options,
     const BundleAdjustmentConfig& config,
     const std::set<image_t>& image_ids,
@@ -305,7 +349,7 @@ void FixGaugeWithTwoCamsFromWorld(
     ceres::Problem& problem) {
   // No need to fix the Gauge if all frames are constant.
   if (!options.refine_rig_from_world) {
-    return;
+    return kInvalidFrameId;
   }
 
   Image* image1 = nullptr;
@@ -342,7 +386,7 @@ void FixGaugeWithTwoCamsFromWorld(
         image1 = &image;
       } else if (image1 != nullptr && image1->FrameId() != image.FrameId()) {
         // No need to fix the Gauge if two frames are already fixed.
-        return;
+        return kInvalidFrameId;
       }
     }
   }
@@ -382,7 +426,7 @@ void FixGaugeWithTwoCamsFromWorld(
     LOG(WARNING) << "Failed to fix Gauge with two cameras. "
                     "Falling back to fixing Gauge with three points.";
     FixGaugeWithThreePoints(point3D_num_observations, reconstruction, problem);
-    return;
+    return kInvalidFrameId;
   }
 
   if (!config.HasConstantRigFromWorldPose(image1->FrameId())) {
@@ -390,21 +434,24 @@ void FixGaugeWithTwoCamsFromWorld(
     problem.SetParameterBlockConstant(frame1_from_world.params.data());
   }
 
-  if (!config.HasConstantRigFromWorldPose(image2->FrameId())) {
-    Rigid3d& frame2_from_world = image2->FramePtr()->RigFromWorld();
-    if (options.constant_rig_from_world_rotation) {
-      SetManifold(&problem,
-                  frame2_from_world.params.data(),
-                  CreateSubsetManifold(
-                      7, {0, 1, 2, 3, 4 + frame2_from_world_fixed_dim}));
-    } else {
-      SetManifold(&problem,
-                  frame2_from_world.params.data(),
-                  CreateProductManifold(
-                      CreateEigenQuaternionManifold(),
-                      CreateSubsetManifold(3, {frame2_from_world_fixed_dim})));
-    }
+  if (config.HasConstantRigFromWorldPose(image2->FrameId())) {
+    return kInvalidFrameId;
   }
+
+  Rigid3d& frame2_from_world = image2->FramePtr()->RigFromWorld();
+  if (options.constant_rig_from_world_rotation) {
+    SetManifold(&problem,
+                frame2_from_world.params.data(),
+                CreateSubsetManifold(
+                    7, {0, 1, 2, 3, 4 + frame2_from_world_fixed_dim}));
+  } else {
+    SetManifold(&problem,
+                frame2_from_world.params.data(),
+                CreateProductManifold(
+                    CreateEigenQuaternionManifold(),
+                    CreateSubsetManifold(3, {frame2_from_world_fixed_dim})));
+  }
+  return image2->FrameId();
 }
 
 void ParameterizeCameras(const BundleAdjustmentOptions& options,
@@ -559,15 +606,78 @@ std::shared_ptr<CeresBundleAdjustmentSummary> CreateSummaryAndLogFailure(
   if (!summary->IsSolutionUsable()) {
     LOG(ERROR) << context << " failed: " << summary->ceres_summary.message;
   }
+  RecordBundleAdjustmentMetrics(BundleAdjustmentBackend::CERES, *summary);
   return summary;
 }
 
+// Use the given elimination ordering for Schur-type linear solvers instead of
+// letting Ceres compute one from scratch.
+void MaybeSetLinearSolverOrdering(const ceres::ParameterBlockOrdering* ordering,
+                                  ceres::Solver::Options* solver_options) {
+  if (ordering == nullptr) {
+    return;
+  }
+  switch (solver_options->linear_solver_type) {
+    case ceres::DENSE_SCHUR:
+    case ceres::SPARSE_SCHUR:
+    case ceres::ITERATIVE_SCHUR:
+      // Ceres removes constant and unused parameter blocks from the ordering
+      // during preprocessing, so it must operate on a copy.
+      solver_options->linear_solver_ordering =
+          std::make_shared<ceres::ParameterBlockOrdering>(*ordering);
+      break;
+    default:
+      break;
+  }
+}
+
+// Reports the statistics of every iteration to the trace and the iteration
+// callback of the options while the solver is running.
+class IterationReporter : public ceres::IterationCallback {
+ public:
+  explicit IterationReporter(
+      std::function<void(const BundleAdjustmentIterationSummary&)> callback)
+      : callback_(std::move(callback)) {}
+
+  ceres::CallbackReturnType operator()(
+      const ceres::IterationSummary& ceres_iteration) override {
+    const BundleAdjustmentIterationSummary iteration =
+        CeresIterationSummaryToIterationSummary(ceres_iteration);
+    RecordTraceZone("BundleAdjustmentIteration",
+                    static_cast<int64_t>(1e6 * iteration.iteration_time_sec),
+                    iteration.num_linear_solver_iterations);
+    RecordTraceZone(
+        "BundleAdjustmentLinearSolve",
+        static_cast<int64_t>(1e6 * iteration.linear_solver_time_sec));
+    if (callback_) {
+      callback_(iteration);
+    }
+    return ceres::SOLVER_CONTINUE;
+  }
+
+ private:
+  const std::function<void(const BundleAdjustmentIterationSummary&)>
+      callback_;
+};
+
 ceres::Solver::Summary SolveWithGpuFallback(
     const BundleAdjustmentOptions& options,
     const BundleAdjustmentConfig& config,
-    ceres::Problem* problem) {
-  const ceres::Solver::Options solver_options =
+    ceres::Problem* problem,
+    const ceres::ParameterBlockOrdering* ordering = nullptr) {
+  TraceZone trace_zone("SolveBundleAdjustment");
+  trace_zone.SetNumItems(problem->NumResidualBlocks());
+
+  ceres::Solver::Options solver_options =
       options.ceres->CreateSolverOptions(config, *problem);
+  MaybeSetLinearSolverOrdering(ordering, &solver_options);
+
+  IterationReporter iteration_reporter(options.iteration_callback);
+  const bool report_iterations =
+      IsTracingEnabled() || options.iteration_callback;
+  if (report_iterations) {
+    solver_options.callbacks.push_back(&iteration_reporter);
+  }
 
   ceres::Solver::Summary ceres_summary;
   ceres::Solve(solver_options, problem, &ceres_summary);
@@ -583,8 +693,12 @@ ceres::Solver::Summary SolveWithGpuFallback(
       auto cpu_options =
           std::make_shared<CeresBundleAdjustmentOptions>(*options.ceres);
       cpu_options->use_gpu = false;
-      const ceres::Solver::Options cpu_solver_options =
+      ceres::Solver::Options cpu_solver_options =
           cpu_options->CreateSolverOptions(config, *problem);
+      MaybeSetLinearSolverOrdering(ordering, &cpu_solver_options);
+      if (report_iterations) {
+        cpu_solver_options.callbacks.push_back(&iteration_reporter);
+      }
       ceres::Solve(cpu_solver_options, problem, &ceres_summary);
     }
   }
@@ -607,11 +721,9 @@ class DefaultBundleAdjuster : public CeresBundleAdjuster {
     THROW_CHECK(reconstruction.IsValid());
 
     // Set up problem.
-    // Warning: AddPointsToProblem assumes that AddImageToProblem is called
+    // Warning: AddPointsToProblem assumes that AddImagesToProblem is called
     // first. Do not change order of instructions!
-    for (const image_t image_id : config_.Images()) {
-      AddImageToProblem(image_id, reconstruction);
-    }
+    AddImagesToProblem(reconstruction);
     for (const auto point3D_id : config_.VariablePoints()) {
       AddPointToProblem(point3D_id, reconstruction);
     }
@@ -674,94 +786,102 @@ class DefaultBundleAdjuster : public CeresBundleAdjuster {
     return parameterized_image_ids_;
   }
 
-  void AddImageToProblem(const image_t image_id,
-                         Reconstruction& reconstruction) {
-    Image& image = reconstruction.Image(image_id);
-
-    if (image.IsRefInFrame()) {
-      AddImageWithTrivialFrame(image, reconstruction);
-    } else {
-      AddImageWithNonTrivialFrame(image, reconstruction);
-    }
-  }
-
-  void AddImageWithTrivialFrame(Image& image, Reconstruction& reconstruction) {
-    Camera& camera = *image.CameraPtr();
-
-    const bool constant_cam_from_world =
-        !options_.refine_rig_from_world ||
-        config_.HasConstantRigFromWorldPose(image.FrameId());
-
-    THROW_CHECK(image.IsRefInFrame());
-    Rigid3d& rig_from_world = image.FramePtr()->RigFromWorld();
+  // Residual of an observation whose cost function was created but not yet
+  // added to the problem.
+  struct PendingResidual {
+    ceres::CostFunction* cost_function = nullptr;
+    std::array<double*, 4> parameter_blocks;
+    int num_parameter_blocks = 0;
+    point3D_t point3D_id = kInvalidPoint3DId;
+  };
+
+  // Adds the residuals of all images in the config. Creating the cost
+  // functions is independent across images and dominates the setup of large
+  // problems, so it runs in parallel over chunks of images. Adding the
+  // residual blocks to the problem is not thread-safe and happens serially in
+  // the original image order.
+  void AddImagesToProblem(Reconstruction& reconstruction) {
+    const std::vector<image_t> image_ids(config_.Images().begin(),
+                                         config_.Images().end());
 
-    // Add residuals to bundle adjustment problem.
     size_t num_observations = 0;
-    for (const Point2D& point2D : image.Points2D()) {
-      if (!point2D.HasPoint3D() || config_.IsIgnoredPoint(point2D.point3D_id)) {
-        continue;
+    for (const image_t image_id : image_ids) {
+      num_observations += reconstruction.Image(image_id).NumPoints3D();
+    }
+    const int num_threads =
+        2 * num_observations <
+                static_cast<size_t>(
+                    options_.ceres->min_num_residuals_for_cpu_multi_threading)
+            ? 1
+            : GetEffectiveNumThreads(
+                  options_.ceres->solver_options.num_threads);
+
+    std::vector<std::vector<PendingResidual>> image_residuals(
+        image_ids.size());
+    if (num_threads == 1) {
+      for (size_t i = 0; i < image_ids.size(); ++i) {
+        image_residuals[i] = CreateImageResiduals(image_ids[i], reconstruction);
       }
+    } else {
+      const size_t chunk_size =
+          (image_ids.size() + num_threads - 1) / num_threads;
+      ThreadPool thread_pool(num_threads);
+      for (size_t begin = 0; begin < image_ids.size(); begin += chunk_size) {
+        const size_t end = std::min(begin + chunk_size, image_ids.size());
+        thread_pool.AddTask([&, begin, end]() {
+          for (size_t i = begin; i < end; ++i) {
+            image_residuals[i] =
+                CreateImageResiduals(image_ids[i], reconstruction);
+          }
+        });
+      }
+      thread_pool.Wait();
+    }
 
-      Point3D& point3D = reconstruction.Point3D(point2D.point3D_id);
-      THROW_CHECK_GT(point3D.track.Length(), 1);
-
-      // Skip points with track length below minimum.
-      if (options_.min_track_length > 0 &&
-          static_cast<int>(point3D.track.Length()) <
-              options_.min_track_length) {
+    for (size_t i = 0; i < image_ids.size(); ++i) {
+      if (image_residuals[i].empty()) {
         continue;
       }
-
-      num_observations += 1;
-      point3D_num_observations_[point2D.point3D_id] += 1;
-
-      if (constant_cam_from_world) {
-        problem_->AddResidualBlock(
-            CreateCameraCostFunction<ReprojErrorConstantPoseCostFunctor>(
-                camera.model_id, point2D.xy, rig_from_world),
-            loss_function_.get(),
-            point3D.xyz.data(),
-            camera.params.data());
-      } else {
-        problem_->AddResidualBlock(
-            CreateCameraCostFunction<ReprojErrorCostFunctor>(camera.model_id,
-                                                             point2D.xy),
-            loss_function_.get(),
-            point3D.xyz.data(),
-            rig_from_world.params.data(),
-            camera.params.data());
+      for (const PendingResidual& residual : image_residuals[i]) {
+        problem_->AddResidualBlock(residual.cost_function,
+                                   loss_function_.get(),
+                                   residual.parameter_blocks.data(),
+                                   residual.num_parameter_blocks);
+        point3D_num_observations_[residual.point3D_id] += 1;
       }
-    }
-
-    if (num_observations > 0) {
+      const Image& image = reconstruction.Image(image_ids[i]);
       parameterized_camera_ids_.insert(image.CameraId());
       parameterized_image_ids_.insert(image.ImageId());
     }
   }
 
-  void AddImageWithNonTrivialFrame(Image& image,
-                                   Reconstruction& reconstruction) {
+  std::vector<PendingResidual> CreateImageResiduals(
+      const image_t image_id, Reconstruction& reconstruction) const {
+    Image& image = reconstruction.Image(image_id);
     Camera& camera = *image.CameraPtr();
     const sensor_t sensor_id = camera.SensorId();
 
+    const bool is_ref_in_frame = image.IsRefInFrame();
     const bool constant_sensor_from_rig =
-        !options_.refine_sensor_from_rig ||
+        is_ref_in_frame || !options_.refine_sensor_from_rig ||
         config_.HasConstantSensorFromRigPose(sensor_id);
     const bool constant_rig_from_world =
         !options_.refine_rig_from_world ||
         config_.HasConstantRigFromWorldPose(image.FrameId());
 
-    THROW_CHECK(!image.IsRefInFrame());
-    Rigid3d& sensor_from_rig =
-        image.FramePtr()->RigPtr()->SensorFromRig(sensor_id);
     Rigid3d& rig_from_world = image.FramePtr()->RigFromWorld();
-    const std::optional<Rigid3d> cam_from_world =
-        (constant_sensor_from_rig && constant_rig_from_world)
-            ? std::make_optional<Rigid3d>(sensor_from_rig * rig_from_world)
-            : std::nullopt;
+    Rigid3d* sensor_from_rig =
+        is_ref_in_frame
+            ? nullptr
+            : &image.FramePtr()->RigPtr()->SensorFromRig(sensor_id);
+    std::optional<Rigid3d> cam_from_world;
+    if (constant_sensor_from_rig && constant_rig_from_world) {
+      cam_from_world = is_ref_in_frame ? rig_from_world
+                                       : *sensor_from_rig * rig_from_world;
+    }
 
-    // Add residuals to bundle adjustment problem.
-    size_t num_observations = 0;
+    std::vector<PendingResidual> residuals;
+    residuals.reserve(image.NumPoints3D());
     for (const Point2D& point2D : image.Points2D()) {
       if (!point2D.HasPoint3D() || config_.IsIgnoredPoint(point2D.point3D_id)) {
         continue;
@@ -777,42 +897,43 @@ class DefaultBundleAdjuster : public CeresBundleAdjuster {
         continue;
       }
 
-      num_observations += 1;
-      point3D_num_observations_[point2D.point3D_id] += 1;
+      PendingResidual& residual = residuals.emplace_back();
+      residual.point3D_id = point2D.point3D_id;
+      residual.parameter_blocks[0] = point3D.xyz.data();
 
       // The !constant_sensor_from_rig && constant_rig_from_world is
       // rare enough that we do not have a specialized cost function for it.
-      if (constant_sensor_from_rig && constant_rig_from_world) {
-        problem_->AddResidualBlock(
+      if (cam_from_world.has_value()) {
+        residual.cost_function =
             CreateCameraCostFunction<ReprojErrorConstantPoseCostFunctor>(
-                camera.model_id, point2D.xy, cam_from_world.value()),
-            loss_function_.get(),
-            point3D.xyz.data(),
-            camera.params.data());
-      } else if (!constant_rig_from_world && constant_sensor_from_rig) {
-        problem_->AddResidualBlock(
+                camera.model_id, point2D.xy, cam_from_world.value());
+        residual.parameter_blocks[1] = camera.params.data();
+        residual.num_parameter_blocks = 2;
+      } else if (is_ref_in_frame) {
+        residual.cost_function =
+            CreateCameraCostFunction<ReprojErrorCostFunctor>(camera.model_id,
+                                                             point2D.xy);
+        residual.parameter_blocks[1] = rig_from_world.params.data();
+        residual.parameter_blocks[2] = camera.params.data();
+        residual.num_parameter_blocks = 3;
+      } else if (constant_sensor_from_rig) {
+        residual.cost_function =
             CreateCameraCostFunction<RigReprojErrorConstantRigCostFunctor>(
-                camera.model_id, point2D.xy, sensor_from_rig),
-            loss_function_.get(),
-            point3D.xyz.data(),
-            rig_from_world.params.data(),
-            camera.params.data());
+                camera.model_id, point2D.xy, *sensor_from_rig);
+        residual.parameter_blocks[1] = rig_from_world.params.data();
+        residual.parameter_blocks[2] = camera.params.data();
+        residual.num_parameter_blocks = 3;
       } else {
-        problem_->AddResidualBlock(
+        residual.cost_function =
             CreateCameraCostFunction<RigReprojErrorCostFunctor>(camera.model_id,
-                                                                point2D.xy),
-            loss_function_.get(),
-            point3D.xyz.data(),
-            sensor_from_rig.params.data(),
-            rig_from_world.params.data(),
-            camera.params.data());
+                                                                point2D.xy);
+        residual.parameter_blocks[1] = sensor_from_rig->params.data();
+        residual.parameter_blocks[2] = rig_from_world.params.data();
+        residual.parameter_blocks[3] = camera.params.data();
+        residual.num_parameter_blocks = 4;
       }
     }
-
-    if (num_observations > 0) {
-      parameterized_camera_ids_.insert(image.CameraId());
-      parameterized_image_ids_.insert(image.ImageId());
-    }
+    return residuals;
   }
 
   void AddPointToProblem(const point3D_t point3D_id,
@@ -1089,6 +1210,509 @@ class PosePriorBundleAdjuster : public CeresBundleAdjuster {
   Sim3d normalized_from_metric_;
 };
 
+class IncrementalBundleAdjuster : public CeresIncrementalBundleAdjuster {
+ public:
+  IncrementalBundleAdjuster(const BundleAdjustmentOptions& options,
+                            const BundleAdjustmentConfig& config,
+                            Reconstruction& reconstruction)
+      : CeresIncrementalBundleAdjuster(options, config),
+        reconstruction_(reconstruction),
+        loss_function_(std::make_unique<ceres::LossFunctionWrapper>(
+            nullptr, ceres::TAKE_OWNERSHIP)) {
+    // Verify that reconstruction is internally consistent.
+    THROW_CHECK(reconstruction.IsValid());
+    ResetProblem();
+    Update(options, config);
+  }
+
+  void Update(const BundleAdjustmentOptions& options,
+              const BundleAdjustmentConfig& config) override {
+    THROW_CHECK_NOTNULL(options.ceres);
+
+    // The manifolds of the parameter blocks are only set once when the blocks
+    // are added, so the problem must be rebuilt if they change.
+    if (options.refine_focal_length != options_.refine_focal_length ||
+        options.refine_principal_point != options_.refine_principal_point ||
+        options.refine_extra_params != options_.refine_extra_params ||
+        options.constant_rig_from_world_rotation !=
+            options_.constant_rig_from_world_rotation) {
+      ResetProblem();
+    }
+
+    options_ = options;
+    config_ = config;
+    loss_function_->Reset(options_.ceres->CreateLossFunction().release(),
+                          ceres::TAKE_OWNERSHIP);
+    num_added_residuals_ = 0;
+    num_removed_residuals_ = 0;
+
+    RemoveDeletedPoints();
+
+    // Collect the observations of the new configuration.
+    std::unordered_map<uint64_t, point3D_t> observations;
+    CollectObservations(&observations);
+
+    // Remove the residuals of observations that are no longer part of the
+    // configuration or which now observe a different 3D point.
+    for (auto it = residuals_.begin(); it != residuals_.end();) {
+      const auto obs_it = observations.find(it->first);
+      if (obs_it == observations.end() ||
+          obs_it->second != it->second.point3D_id) {
+        problem_->RemoveResidualBlock(it->second.residual_block_id);
+        point_blocks_.at(it->second.point3D_id).num_residuals -= 1;
+        num_removed_residuals_ += 1;
+        it = residuals_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    // Add the residuals of the new observations.
+    for (const auto& [obs_key, point3D_id] : observations) {
+      if (residuals_.count(obs_key) == 0) {
+        AddResidual(obs_key, point3D_id);
+      }
+    }
+
+    // Remove the 3D points that are no longer observed.
+    for (auto it = point_blocks_.begin(); it != point_blocks_.end();) {
+      if (it->second.num_residuals == 0) {
+        RemoveParameterBlock(it->second.xyz);
+        it = point_blocks_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    ParameterizeBlocks();
+  }
+
+  std::shared_ptr<BundleAdjustmentSummary> Solve() override {
+    if (problem_->NumResiduals() == 0) {
+      return std::make_shared<BundleAdjustmentSummary>();
+    }
+
+    ceres::Solver::Summary ceres_summary = SolveWithGpuFallback(
+        options_, config_, problem_.get(), ordering_.get());
+
+    if (options_.print_summary || VLOG_IS_ON(1)) {
+      PrintSolverSummary(ceres_summary, "Bundle adjustment report");
+    }
+
+    return CreateSummaryAndLogFailure(std::move(ceres_summary),
+                                      "Bundle adjustment");
+  }
+
+  std::shared_ptr<ceres::Problem>& Problem() override { return problem_; }
+
+  size_t NumAddedResiduals() const override { return num_added_residuals_; }
+
+  size_t NumRemovedResiduals() const override {
+    return num_removed_residuals_;
+  }
+
+ private:
+  struct Residual {
+    ceres::ResidualBlockId residual_block_id;
+    point3D_t point3D_id;
+  };
+
+  struct PointBlock {
+    double* xyz;
+    size_t num_residuals;
+  };
+
+  struct CameraBlock {
+    double* params;
+    // Whether all parameters are constant due to the refinement options.
+    bool constant;
+  };
+
+  static uint64_t ObservationKey(const image_t image_id,
+                                 const point2D_t point2D_idx) {
+    return (static_cast<uint64_t>(image_id) << 32) |
+           static_cast<uint64_t>(point2D_idx);
+  }
+
+  void ResetProblem() {
+    ceres::Problem::Options problem_options;
+    problem_options.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+    problem_options.enable_fast_removal = true;
+    problem_ = std::make_shared<ceres::Problem>(problem_options);
+    ordering_ = std::make_shared<ceres::ParameterBlockOrdering>();
+    residuals_.clear();
+    point_blocks_.clear();
+    camera_blocks_.clear();
+    frame_blocks_.clear();
+    sensor_blocks_.clear();
+    gauge_frame_id_ = kInvalidFrameId;
+  }
+
+  void RemoveParameterBlock(double* values) {
+    problem_->RemoveParameterBlock(values);
+    ordering_->Remove(values);
+  }
+
+  // Remove the parameter blocks of deleted 3D points together with their
+  // residuals. This must happen before adding any new parameter blocks,
+  // because new 3D points may reuse the memory of deleted ones.
+  void RemoveDeletedPoints() {
+    std::unordered_set<point3D_t> deleted_point3D_ids;
+    for (auto it = point_blocks_.begin(); it != point_blocks_.end();) {
+      if (!reconstruction_.ExistsPoint3D(it->first) ||
+          reconstruction_.Point3D(it->first).xyz.data() != it->second.xyz) {
+        RemoveParameterBlock(it->second.xyz);
+        deleted_point3D_ids.insert(it->first);
+        it = point_blocks_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    if (deleted_point3D_ids.empty()) {
+      return;
+    }
+
+    for (auto it = residuals_.begin(); it != residuals_.end();) {
+      if (deleted_point3D_ids.count(it->second.point3D_id)) {
+        num_removed_residuals_ += 1;
+        it = residuals_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  // Determine the observations of the configuration following the same rules
+  // as the default bundle adjuster.
+  void CollectObservations(
+      std::unordered_map<uint64_t, point3D_t>* observations) {
+    point3D_num_observations_.clear();
+    parameterized_image_ids_.clear();
+    parameterized_camera_ids_.clear();
+    parameterized_frame_ids_.clear();
+    parameterized_sensor_ids_.clear();
+
+    auto IsSkippedPoint = [this](const Point3D& point3D) {
+      return options_.min_track_length > 0 &&
+             static_cast<int>(point3D.track.Length()) <
+                 options_.min_track_length;
+    };
+
+    for (const image_t image_id : config_.Images()) {
+      const Image& image = reconstruction_.Image(image_id);
+      size_t num_observations = 0;
+      for (point2D_t point2D_idx = 0; point2D_idx < image.NumPoints2D();
+           ++point2D_idx) {
+        const Point2D& point2D = image.Point2D(point2D_idx);
+        if (!point2D.HasPoint3D() ||
+            config_.IsIgnoredPoint(point2D.point3D_id)) {
+          continue;
+        }
+        const Point3D& point3D = reconstruction_.Point3D(point2D.point3D_id);
+        THROW_CHECK_GT(point3D.track.Length(), 1);
+        if (IsSkippedPoint(point3D)) {
+          continue;
+        }
+        num_observations += 1;
+        point3D_num_observations_[point2D.point3D_id] += 1;
+        observations->emplace(ObservationKey(image_id, point2D_idx),
+                              point2D.point3D_id);
+      }
+
+      if (num_observations > 0) {
+        parameterized_image_ids_.insert(image_id);
+        parameterized_camera_ids_.insert(image.CameraId());
+        parameterized_frame_ids_.insert(image.FrameId());
+        parameterized_sensor_ids_.insert(image.CameraPtr()->SensorId());
+      }
+    }
+
+    auto AddPointObservations = [&](const point3D_t point3D_id) {
+      THROW_CHECK(!config_.IsIgnoredPoint(point3D_id));
+      const Point3D& point3D = reconstruction_.Point3D(point3D_id);
+      if (IsSkippedPoint(point3D)) {
+        return;
+      }
+      size_t& num_observations = point3D_num_observations_[point3D_id];
+      if (num_observations == point3D.track.Length()) {
+        return;
+      }
+      for (const auto& track_el : point3D.track.Elements()) {
+        if (config_.HasImage(track_el.image_id)) {
+          continue;
+        }
+        num_observations += 1;
+        observations->emplace(
+            ObservationKey(track_el.image_id, track_el.point2D_idx),
+            point3D_id);
+        // Do not optimize intrinsics if the corresponding images were not
+        // included explicitly in the config.
+        const camera_t camera_id =
+            reconstruction_.Image(track_el.image_id).CameraId();
+        if (parameterized_camera_ids_.insert(camera_id).second) {
+          config_.SetConstantCamIntrinsics(camera_id);
+        }
+      }
+    };
+
+    for (const point3D_t point3D_id : config_.VariablePoints()) {
+      AddPointObservations(point3D_id);
+    }
+    for (const point3D_t point3D_id : config_.ConstantPoints()) {
+      AddPointObservations(point3D_id);
+    }
+  }
+
+  // Add the residual for the given observation. Constant poses are modeled as
+  // constant parameter blocks instead of being baked into the cost functions,
+  // such that the residuals remain valid across updates.
+  void AddResidual(const uint64_t obs_key, const point3D_t point3D_id) {
+    const image_t image_id = static_cast<image_t>(obs_key >> 32);
+    const point2D_t point2D_idx =
+        static_cast<point2D_t>(obs_key & 0xFFFFFFFF);
+    Image& image = reconstruction_.Image(image_id);
+    Camera& camera = *image.CameraPtr();
+    const Point2D& point2D = image.Point2D(point2D_idx);
+    Point3D& point3D = reconstruction_.Point3D(point3D_id);
+
+    auto point_it = point_blocks_.find(point3D_id);
+    if (point_it == point_blocks_.end()) {
+      problem_->AddParameterBlock(point3D.xyz.data(), 3);
+      ordering_->AddElementToGroup(point3D.xyz.data(), 0);
+      point_it =
+          point_blocks_.emplace(point3D_id, PointBlock{point3D.xyz.data(), 0})
+              .first;
+    }
+    point_it->second.num_residuals += 1;
+
+    double* camera_params = AddCameraBlock(camera);
+    double* rig_from_world_params = AddFrameBlock(*image.FramePtr());
+
+    Residual residual;
+    residual.point3D_id = point3D_id;
+    if (image.IsRefInFrame()) {
+      residual.residual_block_id = problem_->AddResidualBlock(
+          CreateCameraCostFunction<ReprojErrorCostFunctor>(camera.model_id,
+                                                           point2D.xy),
+          loss_function_.get(),
+          point3D.xyz.data(),
+          rig_from_world_params,
+          camera_params);
+    } else {
+      double* sensor_from_rig_params = AddSensorBlock(image);
+      residual.residual_block_id = problem_->AddResidualBlock(
+          CreateCameraCostFunction<RigReprojErrorCostFunctor>(camera.model_id,
+                                                              point2D.xy),
+          loss_function_.get(),
+          point3D.xyz.data(),
+          sensor_from_rig_params,
+          rig_from_world_params,
+          camera_params);
+    }
+    residuals_.emplace(obs_key, residual);
+    num_added_residuals_ += 1;
+  }
+
+  double* AddCameraBlock(Camera& camera) {
+    auto it = camera_blocks_.find(camera.camera_id);
+    if (it != camera_blocks_.end()) {
+      return it->second.params;
+    }
+
+    problem_->AddParameterBlock(camera.params.data(), camera.params.size());
+    ordering_->AddElementToGroup(camera.params.data(), 1);
+
+    std::vector<int> const_camera_params;
+    {
+      const span<const size_t> params_idxs = camera.MetaDataParamsIdxs();
+      const_camera_params.insert(
+          const_camera_params.end(), params_idxs.begin(), params_idxs.end());
+    }
+    if (!options_.refine_focal_length) {
+      const span<const size_t> params_idxs = camera.FocalLengthIdxs();
+      const_camera_params.insert(
+          const_camera_params.end(), params_idxs.begin(), params_idxs.end());
+    }
+    if (!options_.refine_principal_point) {
+      const span<const size_t> params_idxs = camera.PrincipalPointIdxs();
+      const_camera_params.insert(
+          const_camera_params.end(), params_idxs.begin(), params_idxs.end());
+    }
+    if (!options_.refine_extra_params) {
+      const span<const size_t> params_idxs = camera.ExtraParamsIdxs();
+      const_camera_params.insert(
+          const_camera_params.end(), params_idxs.begin(), params_idxs.end());
+    }
+
+    const bool constant = const_camera_params.size() == camera.params.size();
+    if (!constant && !const_camera_params.empty()) {
+      SetManifold(
+          problem_.get(),
+          camera.params.data(),
+          CreateSubsetManifold(camera.params.size(), const_camera_params));
+    }
+
+    camera_blocks_.emplace(camera.camera_id,
+                           CameraBlock{camera.params.data(), constant});
+    return camera.params.data();
+  }
+
+  double* AddFrameBlock(Frame& frame) {
+    auto it = frame_blocks_.find(frame.FrameId());
+    if (it != frame_blocks_.end()) {
+      return it->second;
+    }
+
+    Rigid3d& rig_from_world = frame.RigFromWorld();
+    // CostFunction assumes unit quaternions.
+    rig_from_world.rotation().normalize();
+    problem_->AddParameterBlock(rig_from_world.params.data(), 7);
+    ordering_->AddElementToGroup(rig_from_world.params.data(), 1);
+    SetFrameManifold(rig_from_world.params.data());
+
+    frame_blocks_.emplace(frame.FrameId(), rig_from_world.params.data());
+    return rig_from_world.params.data();
+  }
+
+  void SetFrameManifold(double* rig_from_world_params) {
+    if (options_.constant_rig_from_world_rotation) {
+      SetManifold(problem_.get(),
+                  rig_from_world_params,
+                  CreateSubsetManifold(7, {0, 1, 2, 3}));
+    } else {
+      SetManifold(problem_.get(),
+                  rig_from_world_params,
+                  CreateProductManifold(CreateEigenQuaternionManifold(),
+                                        CreateEuclideanManifold<3>()));
+    }
+  }
+
+  double* AddSensorBlock(Image& image) {
+    const sensor_t sensor_id = image.CameraPtr()->SensorId();
+    auto it = sensor_blocks_.find(sensor_id);
+    if (it != sensor_blocks_.end()) {
+      return it->second.second;
+    }
+
+    Rig& rig = *image.FramePtr()->RigPtr();
+    Rigid3d& sensor_from_rig = rig.SensorFromRig(sensor_id);
+    // CostFunction assumes unit quaternions.
+    sensor_from_rig.rotation().normalize();
+    problem_->AddParameterBlock(sensor_from_rig.params.data(), 7);
+    ordering_->AddElementToGroup(sensor_from_rig.params.data(), 1);
+    SetManifold(problem_.get(),
+                sensor_from_rig.params.data(),
+                CreateProductManifold(CreateEigenQuaternionManifold(),
+                                      CreateEuclideanManifold<3>()));
+
+    sensor_blocks_.emplace(
+        sensor_id, std::make_pair(rig.RigId(), sensor_from_rig.params.data()));
+    return sensor_from_rig.params.data();
+  }
+
+  void SetParameterBlockConstant(double* values, const bool constant) {
+    if (constant) {
+      problem_->SetParameterBlockConstant(values);
+    } else {
+      problem_->SetParameterBlockVariable(values);
+    }
+  }
+
+  // Set the constant/variable state of all parameter blocks for the current
+  // configuration. Blocks outside of the configuration are held constant.
+  void ParameterizeBlocks() {
+    for (const auto& [camera_id, camera_block] : camera_blocks_) {
+      SetParameterBlockConstant(
+          camera_block.params,
+          camera_block.constant ||
+              parameterized_camera_ids_.count(camera_id) == 0 ||
+              config_.HasConstantCamIntrinsics(camera_id));
+    }
+
+    for (const auto& [frame_id, rig_from_world_params] : frame_blocks_) {
+      SetParameterBlockConstant(
+          rig_from_world_params,
+          !options_.refine_rig_from_world ||
+              parameterized_frame_ids_.count(frame_id) == 0 ||
+              config_.HasConstantRigFromWorldPose(frame_id));
+    }
+
+    // Set the sensor poses as constant, if the reference sensor of the rig is
+    // not part of the problem. Otherwise, the relative pose between the
+    // sensors is not well constrained.
+    for (const auto& [sensor_id, rig_and_params] : sensor_blocks_) {
+      const Rig& rig = reconstruction_.Rig(rig_and_params.first);
+      SetParameterBlockConstant(
+          rig_and_params.second,
+          !options_.refine_sensor_from_rig ||
+              parameterized_sensor_ids_.count(sensor_id) == 0 ||
+              parameterized_sensor_ids_.count(rig.RefSensorId()) == 0 ||
+              config_.HasConstantSensorFromRigPose(sensor_id));
+    }
+
+    for (const auto& [point3D_id, point_block] : point_blocks_) {
+      const Point3D& point3D = reconstruction_.Point3D(point3D_id);
+      SetParameterBlockConstant(
+          point_block.xyz,
+          !options_.refine_points3D ||
+              point3D.track.Length() >
+                  point3D_num_observations_.at(point3D_id) ||
+              config_.HasConstantPoint(point3D_id));
+    }
+
+    // Restore the manifold of the frame that fixed the gauge in the previous
+    // update, since the gauge may now be fixed by a different frame.
+    if (gauge_frame_id_ != kInvalidFrameId) {
+      SetFrameManifold(frame_blocks_.at(gauge_frame_id_));
+      gauge_frame_id_ = kInvalidFrameId;
+    }
+
+    switch (config_.FixedGauge()) {
+      case BundleAdjustmentGauge::UNSPECIFIED:
+        break;
+      case BundleAdjustmentGauge::TWO_CAMS_FROM_WORLD:
+        gauge_frame_id_ =
+            FixGaugeWithTwoCamsFromWorld(options_,
+                                         config_,
+                                         parameterized_image_ids_,
+                                         point3D_num_observations_,
+                                         reconstruction_,
+                                         *problem_);
+        break;
+      case BundleAdjustmentGauge::THREE_POINTS:
+        FixGaugeWithThreePoints(
+            point3D_num_observations_, reconstruction_, *problem_);
+        break;
+      default:
+        LOG(FATAL_THROW) << "Unsupported BundleAdjustmentGauge";
+    }
+  }
+
+  Reconstruction& reconstruction_;
+
+  std::shared_ptr<ceres::Problem> problem_;
+  std::unique_ptr<ceres::LossFunctionWrapper> loss_function_;
+  std::shared_ptr<ceres::ParameterBlockOrdering> ordering_;
+
+  std::unordered_map<uint64_t, Residual> residuals_;
+  std::unordered_map<point3D_t, PointBlock> point_blocks_;
+  std::unordered_map<camera_t, CameraBlock> camera_blocks_;
+  std::unordered_map<frame_t, double*> frame_blocks_;
+  std::unordered_map<sensor_t, std::pair<rig_t, double*>> sensor_blocks_;
+
+  std::set<image_t> parameterized_image_ids_;
+  std::unordered_set<camera_t> parameterized_camera_ids_;
+  std::unordered_set<frame_t> parameterized_frame_ids_;
+  std::unordered_set<sensor_t> parameterized_sensor_ids_;
+  std::unordered_map<point3D_t, size_t> point3D_num_observations_;
+  // Frame whose manifold was changed to fix the gauge.
+  frame_t gauge_frame_id_ = kInvalidFrameId;
+
+  size_t num_added_residuals_ = 0;
+  size_t num_removed_residuals_ = 0;
+};
+
 }  // namespace
 
 std::unique_ptr<CeresBundleAdjuster> CreateDefaultCeresBundleAdjuster(
@@ -1109,6 +1733,14 @@ std::unique_ptr<CeresBundleAdjuster> CreatePosePriorCeresBundleAdjuster(
       options, prior_options, config, std::move(pose_priors), reconstruction);
 }
 
+std::unique_ptr<CeresIncrementalBundleAdjuster>
+CreateIncrementalCeresBundleAdjuster(const BundleAdjustmentOptions& options,
+                                     const BundleAdjustmentConfig& config,
+                                     Reconstruction& reconstruction) {
+  return std::make_unique<IncrementalBundleAdjuster>(
+      options, config, reconstruction);
+}
+
 void PrintSolverSummary(const ceres::Solver::Summary& summary,
                         const std::string& header) {
   if (VLOG_IS_ON(3)) {
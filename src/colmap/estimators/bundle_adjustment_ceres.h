@@ -120,6 +120,32 @@ class CeresBundleAdjuster : public BundleAdjuster {
   virtual std::shared_ptr<ceres::Problem>& Problem() = 0;
 };
 
+// Ceres bundle adjuster that keeps its problem alive across successive
+// configurations, e.g., the sliding window of local bundle adjustments during
+// incremental mapping. Each update only adds and removes the residual and
+// parameter blocks of observations that changed since the previous update and
+// the Schur elimination ordering is maintained alongside the problem instead of
+// being recomputed by Ceres for every solve. Constant poses are modeled as
+// constant parameter blocks, so residuals remain valid when frames switch
+// between constant and variable.
+//
+// The images, frames, rigs, and cameras must not be deleted from the
+// reconstruction during the lifetime of the adjuster, whereas 3D points may
+// change arbitrarily between updates.
+class CeresIncrementalBundleAdjuster : public CeresBundleAdjuster {
+ public:
+  using CeresBundleAdjuster::CeresBundleAdjuster;
+
+  // Synchronize the problem with the given options, config, and the current
+  // state of the reconstruction.
+  virtual void Update(const BundleAdjustmentOptions& options,
+                      const BundleAdjustmentConfig& config) = 0;
+
+  // Number of residual blocks added/removed in the last update.
+  virtual size_t NumAddedResiduals() const = 0;
+  virtual size_t NumRemovedResiduals() const = 0;
+};
+
 std::unique_ptr<CeresBundleAdjuster> CreateDefaultCeresBundleAdjuster(
     const BundleAdjustmentOptions& options,
     const BundleAdjustmentConfig& config,
@@ -132,6 +158,11 @@ std::unique_ptr<CeresBundleAdjuster> CreatePosePriorCeresBundleAdjuster(
     std::vector<PosePrior> pose_priors,
     Reconstruction& reconstruction);
 
+std::unique_ptr<CeresIncrementalBundleAdjuster>
+CreateIncrementalCeresBundleAdjuster(const BundleAdjustmentOptions& options,
+                                     const BundleAdjustmentConfig& config,
+                                     Reconstruction& reconstruction);
+
 void PrintSolverSummary(const ceres::Solver::Summary& summary,
                         const std::string& header);
 
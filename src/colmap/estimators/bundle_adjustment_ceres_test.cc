@@ -35,6 +35,8 @@
 #include "colmap/sensor/models.h"
 #include "colmap/util/testing.h"
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
 // Due to pose normalization operations, constant variables may not be perfectly
@@ -250,6 +252,56 @@ TEST(DefaultBundleAdjuster, TwoView) {
   }
 }
 
+TEST(DefaultBundleAdjuster, IterationSummaries) {
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 1;
+  synthetic_dataset_options.num_points3D = 100;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+  SyntheticNoiseOptions synthetic_noise_options;
+  synthetic_noise_options.point2D_stddev = 1;
+  SynthesizeNoise(synthetic_noise_options, &reconstruction);
+
+  BundleAdjustmentConfig config;
+  config.AddImage(1);
+  config.AddImage(2);
+  config.FixGauge(BundleAdjustmentGauge::TWO_CAMS_FROM_WORLD);
+
+  std::vector<BundleAdjustmentIterationSummary> iterations;
+  BundleAdjustmentOptions options;
+  options.iteration_callback =
+      [&iterations](const BundleAdjustmentIterationSummary& iteration) {
+        iterations.push_back(iteration);
+      };
+  std::unique_ptr<BundleAdjuster> bundle_adjuster =
+      CreateDefaultCeresBundleAdjuster(options, config, reconstruction);
+  const auto summary = bundle_adjuster->Solve();
+  ASSERT_NE(summary->termination_type,
+            BundleAdjustmentTerminationType::FAILURE);
+
+  EXPECT_GT(summary->num_iterations, 0);
+  ASSERT_EQ(iterations.size(), summary->iteration_summaries.size());
+  for (size_t i = 0; i < iterations.size(); ++i) {
+    EXPECT_EQ(iterations[i].iteration, static_cast<int>(i));
+    EXPECT_EQ(iterations[i].iteration,
+              summary->iteration_summaries[i].iteration);
+    EXPECT_EQ(iterations[i].cost, summary->iteration_summaries[i].cost);
+    EXPECT_GE(iterations[i].iteration_time_sec, 0);
+    EXPECT_GE(iterations[i].linear_solver_time_sec, 0);
+    EXPECT_GE(iterations[i].evaluation_time_sec, 0);
+  }
+  EXPECT_LE(iterations.back().cost, iterations.front().cost);
+
+  EXPECT_GE(summary->total_time_sec, 0);
+  EXPECT_GE(summary->jacobian_evaluation_time_sec, 0);
+  EXPECT_GE(summary->residual_evaluation_time_sec, 0);
+  EXPECT_GE(summary->linear_solver_time_sec, 0);
+  EXPECT_LE(summary->linear_solver_time_sec, summary->total_time_sec);
+  EXPECT_LT(summary->device_transfer_time_sec, 0);
+}
+
 TEST(DefaultBundleAdjuster, ThreeViewSpherical) {
   Reconstruction reconstruction;
   SyntheticDatasetOptions synthetic_dataset_options;
@@ -1440,6 +1492,219 @@ TEST(DefaultBundleAdjuster, IgnorePoint) {
             306);
 }
 
+TEST(DefaultBundleAdjuster, ParallelProblemConstruction) {
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 2;
+  synthetic_dataset_options.num_frames_per_rig = 4;
+  synthetic_dataset_options.num_points3D = 100;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+  SyntheticNoiseOptions synthetic_noise_options;
+  synthetic_noise_options.point2D_stddev = 1;
+  SynthesizeNoise(synthetic_noise_options, &reconstruction);
+
+  BundleAdjustmentConfig config;
+  for (const image_t image_id : reconstruction.RegImageIds()) {
+    config.AddImage(image_id);
+  }
+  config.SetConstantRigFromWorldPose(reconstruction.RegFrameIds().front());
+  config.FixGauge(BundleAdjustmentGauge::TWO_CAMS_FROM_WORLD);
+
+  BundleAdjustmentOptions options;
+  options.refine_sensor_from_rig = false;
+  options.ceres->min_num_residuals_for_cpu_multi_threading = 0;
+
+  auto ComputeCost = [&](int num_threads, int* num_residuals) {
+    options.ceres->solver_options.num_threads = num_threads;
+    std::unique_ptr<BundleAdjuster> bundle_adjuster =
+        CreateDefaultCeresBundleAdjuster(options, config, reconstruction);
+    ceres::Problem& problem = GetCeresProblem(*bundle_adjuster);
+    *num_residuals = problem.NumResiduals();
+    double cost = 0;
+    problem.Evaluate(ceres::Problem::EvaluateOptions(),
+                     &cost,
+                     nullptr,
+                     nullptr,
+                     nullptr);
+    return cost;
+  };
+
+  int num_residuals1 = 0;
+  int num_residuals4 = 0;
+  const double cost1 = ComputeCost(/*num_threads=*/1, &num_residuals1);
+  const double cost4 = ComputeCost(/*num_threads=*/4, &num_residuals4);
+  EXPECT_EQ(num_residuals1, config.NumResiduals(reconstruction));
+  EXPECT_EQ(num_residuals1, num_residuals4);
+  EXPECT_EQ(cost1, cost4);
+}
+
+TEST(IncrementalBundleAdjuster, PartiallyContainedTracks) {
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 3;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 1;
+  synthetic_dataset_options.num_points3D = 100;
+  synthetic_dataset_options.num_points2D_without_point3D = 0;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+  SyntheticNoiseOptions synthetic_noise_options;
+  synthetic_noise_options.point2D_stddev = 1;
+  SynthesizeNoise(synthetic_noise_options, &reconstruction);
+  const auto variable_point3D_id =
+      reconstruction.Image(3).Point2D(0).point3D_id;
+  reconstruction.DeleteObservation(3, 0);
+  const Reconstruction orig_reconstruction = reconstruction;
+
+  BundleAdjustmentConfig config;
+  config.AddImage(1);
+  config.AddImage(2);
+  config.SetConstantRigFromWorldPose(1);
+  config.SetConstantRigFromWorldPose(2);
+
+  BundleAdjustmentOptions options;
+  std::unique_ptr<CeresIncrementalBundleAdjuster> bundle_adjuster =
+      CreateIncrementalCeresBundleAdjuster(options, config, reconstruction);
+  const auto summary = bundle_adjuster->Solve();
+  ASSERT_NE(summary->termination_type,
+            BundleAdjustmentTerminationType::FAILURE);
+
+  EXPECT_EQ(config.NumResiduals(reconstruction),
+            GetCeresProblem(*bundle_adjuster).NumResiduals());
+
+  // Same reduced problem as the default bundle adjuster, because the constant
+  // poses are removed by Ceres.
+  EXPECT_EQ(GetCeresSummary(summary.get()).num_residuals_reduced, 400);
+  EXPECT_EQ(GetCeresSummary(summary.get()).num_effective_parameters_reduced, 7);
+
+  CheckVariableCamera(reconstruction.Camera(1), orig_reconstruction.Camera(1));
+  CheckConstantCamFromWorld(reconstruction.Image(1),
+                            orig_reconstruction.Image(1));
+  CheckVariableCamera(reconstruction.Camera(2), orig_reconstruction.Camera(2));
+  CheckConstantCamFromWorld(reconstruction.Image(2),
+                            orig_reconstruction.Image(2));
+  CheckConstantCamera(reconstruction.Camera(3), orig_reconstruction.Camera(3));
+  CheckConstantCamFromWorld(reconstruction.Image(3),
+                            orig_reconstruction.Image(3));
+
+  for (const auto& point3D : reconstruction.Points3D()) {
+    if (point3D.first == variable_point3D_id) {
+      CheckVariablePoint(point3D.second,
+                         orig_reconstruction.Point3D(point3D.first));
+    } else {
+      CheckConstantPoint(point3D.second,
+                         orig_reconstruction.Point3D(point3D.first));
+    }
+  }
+}
+
+TEST(IncrementalBundleAdjuster, SlidingWindow) {
+  SetPRNGSeed(0);
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 5;
+  synthetic_dataset_options.num_points3D = 100;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+  SyntheticNoiseOptions synthetic_noise_options;
+  synthetic_noise_options.point2D_stddev = 0.5;
+  SynthesizeNoise(synthetic_noise_options, &reconstruction);
+
+  BundleAdjustmentConfig config;
+  config.AddImage(1);
+  config.AddImage(2);
+  config.AddImage(3);
+  config.FixGauge(BundleAdjustmentGauge::THREE_POINTS);
+
+  BundleAdjustmentOptions options;
+  std::unique_ptr<CeresIncrementalBundleAdjuster> bundle_adjuster =
+      CreateIncrementalCeresBundleAdjuster(options, config, reconstruction);
+  EXPECT_EQ(bundle_adjuster->NumRemovedResiduals(), 0);
+  EXPECT_EQ(config.NumResiduals(reconstruction),
+            GetCeresProblem(*bundle_adjuster).NumResiduals());
+  ASSERT_TRUE(bundle_adjuster->Solve()->IsSolutionUsable());
+
+  // Slide the window by one image.
+  config.RemoveImage(1);
+  config.AddImage(4);
+  bundle_adjuster->Update(options, config);
+  EXPECT_EQ(bundle_adjuster->NumAddedResiduals(),
+            reconstruction.Image(4).NumPoints3D());
+  EXPECT_EQ(bundle_adjuster->NumRemovedResiduals(),
+            reconstruction.Image(1).NumPoints3D());
+  EXPECT_EQ(config.NumResiduals(reconstruction),
+            GetCeresProblem(*bundle_adjuster).NumResiduals());
+  ASSERT_TRUE(bundle_adjuster->Solve()->IsSolutionUsable());
+
+  // Unchanged configuration does not modify the problem.
+  bundle_adjuster->Update(options, config);
+  EXPECT_EQ(bundle_adjuster->NumAddedResiduals(), 0);
+  EXPECT_EQ(bundle_adjuster->NumRemovedResiduals(), 0);
+
+  // Deleted points are removed from the problem.
+  point3D_t deleted_point3D_id = kInvalidPoint3DId;
+  for (const Point2D& point2D : reconstruction.Image(2).Points2D()) {
+    if (point2D.HasPoint3D()) {
+      deleted_point3D_id = point2D.point3D_id;
+      break;
+    }
+  }
+  ASSERT_NE(deleted_point3D_id, kInvalidPoint3DId);
+  reconstruction.DeletePoint3D(deleted_point3D_id);
+  bundle_adjuster->Update(options, config);
+  EXPECT_EQ(bundle_adjuster->NumAddedResiduals(), 0);
+  EXPECT_GT(bundle_adjuster->NumRemovedResiduals(), 0);
+  EXPECT_EQ(config.NumResiduals(reconstruction),
+            GetCeresProblem(*bundle_adjuster).NumResiduals());
+  EXPECT_TRUE(bundle_adjuster->Solve()->IsSolutionUsable());
+}
+
+TEST(IncrementalBundleAdjuster, TwoCamsFromWorldGauge) {
+  SetPRNGSeed(0);
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 4;
+  synthetic_dataset_options.num_points3D = 100;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+  SyntheticNoiseOptions synthetic_noise_options;
+  synthetic_noise_options.point2D_stddev = 0.5;
+  SynthesizeNoise(synthetic_noise_options, &reconstruction);
+
+  BundleAdjustmentConfig config;
+  config.AddImage(1);
+  config.AddImage(2);
+  config.AddImage(3);
+  config.FixGauge(BundleAdjustmentGauge::TWO_CAMS_FROM_WORLD);
+
+  BundleAdjustmentOptions options;
+  std::unique_ptr<CeresIncrementalBundleAdjuster> bundle_adjuster =
+      CreateIncrementalCeresBundleAdjuster(options, config, reconstruction);
+
+  // The gauge must be fixed in the same way as by the default adjuster, also
+  // after the frames fixing the gauge have changed.
+  auto ExpectSameGauge = [&]() {
+    Reconstruction ref_reconstruction = reconstruction;
+    const auto ref_summary =
+        CreateDefaultCeresBundleAdjuster(options, config, ref_reconstruction)
+            ->Solve();
+    const auto summary = bundle_adjuster->Solve();
+    ASSERT_TRUE(summary->IsSolutionUsable());
+    EXPECT_EQ(
+        GetCeresSummary(summary.get()).num_effective_parameters_reduced,
+        GetCeresSummary(ref_summary.get()).num_effective_parameters_reduced);
+  };
+
+  ExpectSameGauge();
+
+  config.RemoveImage(1);
+  config.AddImage(4);
+  bundle_adjuster->Update(options, config);
+  ExpectSameGauge();
+}
+
 TEST(PosePriorBundleAdjuster, AlignmentRobustToOutliers) {
   SetPRNGSeed(0);
   Reconstruction gt_reconstruction;
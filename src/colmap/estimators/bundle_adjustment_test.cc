@@ -352,6 +352,58 @@ INSTANTIATE_TEST_SUITE_P(BundleAdjusterBackends,
                          BundleAdjusterBackendTest,
                          ::testing::Values(BundleAdjustmentBackend::CERES));
 
+TEST(SolveBundleAdjustmentBatch, Nominal) {
+  SetPRNGSeed(0);
+  constexpr size_t kNumProblems = 3;
+  std::vector<Reconstruction> gt_reconstructions(kNumProblems);
+  std::vector<Reconstruction> reconstructions(kNumProblems);
+  std::vector<Reconstruction*> reconstruction_ptrs;
+  std::vector<BundleAdjustmentConfig> configs(kNumProblems);
+  for (size_t i = 0; i < kNumProblems; ++i) {
+    SyntheticDatasetOptions synthetic_dataset_options;
+    synthetic_dataset_options.num_rigs = 1;
+    synthetic_dataset_options.num_cameras_per_rig = 1;
+    synthetic_dataset_options.num_frames_per_rig = 5 + 2 * i;
+    synthetic_dataset_options.num_points3D = 100;
+    SynthesizeDataset(synthetic_dataset_options, &gt_reconstructions[i]);
+
+    reconstructions[i] = gt_reconstructions[i];
+    SyntheticNoiseOptions synthetic_noise_options;
+    synthetic_noise_options.point2D_stddev = 0.5;
+    synthetic_noise_options.point3D_stddev = 0.1;
+    synthetic_noise_options.rig_from_world_rotation_stddev = 0.5;
+    synthetic_noise_options.rig_from_world_translation_stddev = 0.1;
+    SynthesizeNoise(synthetic_noise_options, &reconstructions[i]);
+    reconstruction_ptrs.push_back(&reconstructions[i]);
+
+    for (const image_t image_id : reconstructions[i].RegImageIds()) {
+      configs[i].AddImage(image_id);
+    }
+    configs[i].FixGauge(BundleAdjustmentGauge::TWO_CAMS_FROM_WORLD);
+  }
+
+  const std::vector<std::shared_ptr<BundleAdjustmentSummary>> summaries =
+      SolveBundleAdjustmentBatch(BundleAdjustmentOptions(),
+                                 configs,
+                                 reconstruction_ptrs,
+                                 /*num_threads=*/2);
+  ASSERT_EQ(summaries.size(), kNumProblems);
+  for (size_t i = 0; i < kNumProblems; ++i) {
+    ASSERT_NE(summaries[i], nullptr);
+    EXPECT_TRUE(summaries[i]->IsSolutionUsable());
+    EXPECT_GT(summaries[i]->num_residuals, 0);
+    EXPECT_THAT(gt_reconstructions[i],
+                ReconstructionNear(reconstructions[i],
+                                   /*max_rotation_error_deg=*/0.1,
+                                   /*max_proj_center_error=*/0.1,
+                                   /*max_scale_error=*/std::nullopt,
+                                   /*num_obs_tolerance=*/0.0));
+  }
+
+  EXPECT_TRUE(SolveBundleAdjustmentBatch(BundleAdjustmentOptions(), {}, {})
+                  .empty());
+}
+
 // Parameterized test for generic PosePriorBundleAdjuster interface across
 // backends.
 class PosePriorBundleAdjusterBackendTest
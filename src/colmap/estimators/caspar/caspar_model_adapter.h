@@ -901,6 +901,10 @@ class PinholeAdapter : public ICasparModelAdapter {
   }
 };
 
+// Returns null for camera models without generated Caspar factors, for which
+// CreateDefaultCasparBundleAdjuster falls back to Ceres. Supporting another
+// model requires adding its nodes and factors to caspar_generate.py and
+// regenerating the f32 and f64 kernels.
 inline std::unique_ptr<ICasparModelAdapter> CreateCasparAdapter(
     const CameraModelId model_id) {
   switch (model_id) {
@@ -37,6 +37,9 @@
 #include "colmap/optim/ransac.h"
 #include "colmap/util/logging.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/threading.h"
+
+#include <optional>
 
 namespace colmap {
 namespace {
@@ -158,119 +161,144 @@ struct VanishingPointEstimator {
   }
 };
 
-Eigen::Matrix3d EstimateManhattanWorldFrame(
+namespace {
+
+struct ImageManhattanAxes {
+  std::optional<Eigen::Vector3d> horizontal_axis_in_world;
+  std::optional<Eigen::Vector3d> vertical_axis_in_world;
+};
+
+ImageManhattanAxes EstimateImageManhattanAxes(
     const ManhattanWorldFrameEstimationOptions& options,
-    const Reconstruction& reconstruction,
+    const Image& image,
     const std::filesystem::path& image_path) {
-  std::vector<Eigen::Vector3d> rightward_axes;
-  std::vector<Eigen::Vector3d> downward_axes;
-  size_t image_idx = 0;
-  for (const image_t image_id : reconstruction.RegImageIds()) {
-    const auto& image = reconstruction.Image(image_id);
-    const auto& camera = *image.CameraPtr();
-
-    LOG_HEADING1(StringPrintf("Processing image %s (%d / %d)",
-                              image.Name().c_str(),
-                              ++image_idx,
-                              reconstruction.NumRegImages()));
-
-    LOG(INFO) << "Reading image...";
-
-    Bitmap bitmap;
-    THROW_CHECK(bitmap.Read(image_path / image.Name()));
-
-    LOG(INFO) << "Undistorting image...";
-
-    UndistortCameraOptions undistortion_options;
-    undistortion_options.max_image_size = options.max_image_size;
-
-    Bitmap undistorted_bitmap;
-    Camera undistorted_camera;
-    UndistortImage(undistortion_options,
-                   bitmap,
-                   camera,
-                   &undistorted_bitmap,
-                   &undistorted_camera);
-
-    LOG(INFO) << "Detecting lines...";
-
-    const std::vector<LineSegment> line_segments =
-        DetectLineSegments(undistorted_bitmap, options.min_line_length);
-    const std::vector<LineSegmentOrientation> line_orientations =
-        ClassifyLineSegmentOrientations(line_segments,
-                                        options.line_orientation_tolerance);
-
-    LOG(INFO) << StringPrintf(" %d", line_segments.size());
-
-    std::vector<LineSegment> horizontal_line_segments;
-    std::vector<LineSegment> vertical_line_segments;
-    std::vector<Eigen::Vector3d> horizontal_lines;
-    std::vector<Eigen::Vector3d> vertical_lines;
-    for (size_t i = 0; i < line_segments.size(); ++i) {
-      const auto& line_segment = line_segments[i];
-      const Eigen::Vector3d line_segment_start =
-          line_segment.start.homogeneous();
-      const Eigen::Vector3d line_segment_end = line_segment.end.homogeneous();
-      const Eigen::Vector3d line = line_segment_start.cross(line_segment_end);
-      if (line_orientations[i] == LineSegmentOrientation::HORIZONTAL) {
-        horizontal_line_segments.push_back(line_segment);
-        horizontal_lines.push_back(line);
-      } else if (line_orientations[i] == LineSegmentOrientation::VERTICAL) {
-        vertical_line_segments.push_back(line_segment);
-        vertical_lines.push_back(line);
-      }
+  const auto& camera = *image.CameraPtr();
+
+  Bitmap bitmap;
+  THROW_CHECK(bitmap.Read(image_path / image.Name()));
+
+  UndistortCameraOptions undistortion_options;
+  undistortion_options.max_image_size = options.max_image_size;
+
+  Bitmap undistorted_bitmap;
+  Camera undistorted_camera;
+  UndistortImage(undistortion_options,
+                 bitmap,
+                 camera,
+                 &undistorted_bitmap,
+                 &undistorted_camera);
+
+  const std::vector<LineSegment> line_segments =
+      DetectLineSegments(undistorted_bitmap, options.min_line_length);
+  const std::vector<LineSegmentOrientation> line_orientations =
+      ClassifyLineSegmentOrientations(line_segments,
+                                      options.line_orientation_tolerance);
+
+  std::vector<LineSegment> horizontal_line_segments;
+  std::vector<LineSegment> vertical_line_segments;
+  std::vector<Eigen::Vector3d> horizontal_lines;
+  std::vector<Eigen::Vector3d> vertical_lines;
+  for (size_t i = 0; i < line_segments.size(); ++i) {
+    const auto& line_segment = line_segments[i];
+    const Eigen::Vector3d line_segment_start = line_segment.start.homogeneous();
+    const Eigen::Vector3d line_segment_end = line_segment.end.homogeneous();
+    const Eigen::Vector3d line = line_segment_start.cross(line_segment_end);
+    if (line_orientations[i] == LineSegmentOrientation::HORIZONTAL) {
+      horizontal_line_segments.push_back(line_segment);
+      horizontal_lines.push_back(line);
+    } else if (line_orientations[i] == LineSegmentOrientation::VERTICAL) {
+      vertical_line_segments.push_back(line_segment);
+      vertical_lines.push_back(line);
     }
+  }
 
-    LOG(INFO) << StringPrintf(" (%d horizontal, %d vertical)",
-                              horizontal_lines.size(),
-                              vertical_lines.size());
-
-    LOG(INFO) << "Estimating vanishing points...";
+  RANSACOptions ransac_options;
+  ransac_options.max_error = options.max_line_vp_distance;
+  RANSAC<VanishingPointEstimator> ransac(ransac_options);
+  const auto horizontal_report =
+      ransac.Estimate(horizontal_line_segments, horizontal_lines);
+  const auto vertical_report =
+      ransac.Estimate(vertical_line_segments, vertical_lines);
+
+  LOG(INFO) << StringPrintf(
+      "Image %s: %d lines (%d horizontal, %d vertical), "
+      "%d horizontal inliers, %d vertical inliers",
+      image.Name().c_str(),
+      static_cast<int>(line_segments.size()),
+      static_cast<int>(horizontal_lines.size()),
+      static_cast<int>(vertical_lines.size()),
+      static_cast<int>(horizontal_report.support.num_inliers),
+      static_cast<int>(vertical_report.support.num_inliers));
+
+  const Eigen::Matrix3d inv_calib_matrix =
+      undistorted_camera.CalibrationMatrix().inverse();
+  const Eigen::Quaterniond world_from_cam_rotation =
+      image.CamFromWorld().rotation().inverse();
+
+  ImageManhattanAxes axes;
+
+  if (horizontal_report.success) {
+    axes.horizontal_axis_in_world =
+        world_from_cam_rotation *
+        (inv_calib_matrix * horizontal_report.model).normalized();
+  }
 
-    RANSACOptions ransac_options;
-    ransac_options.max_error = options.max_line_vp_distance;
-    RANSAC<VanishingPointEstimator> ransac(ransac_options);
-    const auto horizontal_report =
-        ransac.Estimate(horizontal_line_segments, horizontal_lines);
-    const auto vertical_report =
-        ransac.Estimate(vertical_line_segments, vertical_lines);
+  if (vertical_report.success) {
+    const Eigen::Vector3d vertical_axis_in_cam =
+        (inv_calib_matrix * vertical_report.model).normalized();
+    Eigen::Vector3d vertical_axis_in_world =
+        (world_from_cam_rotation * vertical_axis_in_cam).normalized();
+    // Make sure axis points downwards in the image, assuming that the image
+    // was taken in upright orientation.
+    if (vertical_axis_in_world.dot(Eigen::Vector3d(0, 1, 0)) < 0) {
+      vertical_axis_in_world = -vertical_axis_in_world;
+    }
+    axes.vertical_axis_in_world = vertical_axis_in_world;
+  }
 
-    LOG(INFO) << StringPrintf(" (%d horizontal inliers, %d vertical inliers)",
-                              horizontal_report.support.num_inliers,
-                              vertical_report.support.num_inliers);
+  return axes;
+}
 
-    LOG(INFO) << "Composing coordinate axes...";
+}  // namespace
 
-    const Eigen::Matrix3d inv_calib_matrix =
-        undistorted_camera.CalibrationMatrix().inverse();
-    const Eigen::Quaterniond world_from_cam_rotation =
-        image.CamFromWorld().rotation().inverse();
+Eigen::Matrix3d EstimateManhattanWorldFrame(
+    const ManhattanWorldFrameEstimationOptions& options,
+    const Reconstruction& reconstruction,
+    const std::filesystem::path& image_path) {
+  const std::vector<image_t> reg_image_ids(
+      reconstruction.RegImageIds().begin(), reconstruction.RegImageIds().end());
+
+  LOG_HEADING1("Detecting vanishing points");
+
+  // The images are processed independently in parallel, since reading,
+  // undistortion, and line detection dominate the run time.
+  std::vector<ImageManhattanAxes> image_axes(reg_image_ids.size());
+  ParallelFor(
+      0,
+      reg_image_ids.size(),
+      [&](const int64_t begin, const int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          image_axes[i] = EstimateImageManhattanAxes(
+              options, reconstruction.Image(reg_image_ids[i]), image_path);
+        }
+      },
+      GetEffectiveNumThreads(options.num_threads),
+      /*grain_size=*/1);
 
-    if (horizontal_report.success) {
-      Eigen::Vector3d horizontal_axis_in_world =
-          world_from_cam_rotation *
-          (inv_calib_matrix * horizontal_report.model).normalized();
+  std::vector<Eigen::Vector3d> rightward_axes;
+  std::vector<Eigen::Vector3d> downward_axes;
+  for (const ImageManhattanAxes& axes : image_axes) {
+    if (axes.horizontal_axis_in_world) {
+      Eigen::Vector3d horizontal_axis_in_world = *axes.horizontal_axis_in_world;
       // Make sure all axes point into the same direction.
       if (rightward_axes.size() > 0 &&
           rightward_axes[0].dot(horizontal_axis_in_world) < 0) {
         horizontal_axis_in_world = -horizontal_axis_in_world;
       }
       rightward_axes.push_back(horizontal_axis_in_world);
-      LOG(INFO) << "Horizontal: " << horizontal_axis_in_world.transpose();
     }
-
-    if (vertical_report.success) {
-      const Eigen::Vector3d vertical_axis_in_cam =
-          (inv_calib_matrix * vertical_report.model).normalized();
-      Eigen::Vector3d vertical_axis_in_world =
-          (world_from_cam_rotation * vertical_axis_in_cam).normalized();
-      // Make sure axis points downwards in the image, assuming that the image
-      // was taken in upright orientation.
-      if (vertical_axis_in_world.dot(Eigen::Vector3d(0, 1, 0)) < 0) {
-        vertical_axis_in_world = -vertical_axis_in_world;
-      }
-      downward_axes.push_back(vertical_axis_in_world);
-      LOG(INFO) << "Vertical: " << vertical_axis_in_world.transpose();
+    if (axes.vertical_axis_in_world) {
+      downward_axes.push_back(*axes.vertical_axis_in_world);
     }
   }
 
@@ -137,6 +137,265 @@ class AnalyticalReprojErrorCostFunction
   const Eigen::Vector2d point2D_;
 };
 
+// Reprojection error cost function with analytical Jacobians for variable
+// camera calibration and point parameters, and fixed camera pose. The rotation
+// matrix of the fixed pose is computed once on construction.
+template <typename CameraModel>
+class AnalyticalReprojErrorConstantPoseCostFunction
+    : public ceres::SizedCostFunction<2, 3, CameraModel::num_params> {
+ public:
+  AnalyticalReprojErrorConstantPoseCostFunction(const Eigen::Vector2d& point2D,
+                                                const Rigid3d& cam_from_world)
+      : point2D_(point2D),
+        cam_from_world_rotation_(cam_from_world.rotation().toRotationMatrix()),
+        cam_from_world_translation_(cam_from_world.translation()) {}
+
+  bool Evaluate(double const* const* parameters,
+                double* residuals,
+                double** jacobians) const override {
+    const double* point3D_in_world = parameters[0];
+    const double* camera_params = parameters[1];
+
+    double* J_point = jacobians ? jacobians[0] : nullptr;
+    double* J_params = jacobians ? jacobians[1] : nullptr;
+
+    Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J_point_mat(
+        J_point);
+    Eigen::Matrix<double, 2, 3, Eigen::RowMajor> J_uvw_mat;
+
+    const Eigen::Vector3d point3D_in_cam =
+        cam_from_world_rotation_ *
+            Eigen::Map<const Eigen::Vector3d>(point3D_in_world) +
+        cam_from_world_translation_;
+
+    if (!CameraModel::ImgFromCamWithJac(camera_params,
+                                        point3D_in_cam[0],
+                                        point3D_in_cam[1],
+                                        point3D_in_cam[2],
+                                        &residuals[0],
+                                        &residuals[1],
+                                        J_params,
+                                        J_point ? J_uvw_mat.data() : nullptr)) {
+      Eigen::Map<Eigen::Vector2d>(residuals).setZero();
+      if (J_point) {
+        J_point_mat.setZero();
+      }
+      if (J_params) {
+        Eigen::Map<Eigen::Matrix<double, 2, CameraModel::num_params>>(J_params)
+            .setZero();
+      }
+      return true;
+    }
+
+    Eigen::Map<Eigen::Vector2d>(residuals) -= point2D_;
+    WrapEquirectangularHorizontalSeam<CameraModel>(camera_params, residuals);
+
+    if (J_point) {
+      J_point_mat = J_uvw_mat * cam_from_world_rotation_;
+    }
+
+    return true;
+  }
+
+ private:
+  const Eigen::Vector2d point2D_;
+  const Eigen::Matrix3d cam_from_world_rotation_;
+  const Eigen::Vector3d cam_from_world_translation_;
+};
+
+// Rig reprojection error cost function with analytical Jacobians for variable
+// camera pose, calibration, and point parameters.
+template <typename CameraModel>
+class AnalyticalRigReprojErrorCostFunction
+    : public ceres::SizedCostFunction<2, 3, 7, 7, CameraModel::num_params> {
+ public:
+  explicit AnalyticalRigReprojErrorCostFunction(const Eigen::Vector2d& point2D)
+      : point2D_(point2D) {}
+
+  bool Evaluate(double const* const* parameters,
+                double* residuals,
+                double** jacobians) const override {
+    const double* point3D_in_world = parameters[0];
+    const double* cam_from_rig = parameters[1];
+    const double* rig_from_world = parameters[2];
+    const double* camera_params = parameters[3];
+
+    double* J_point = jacobians ? jacobians[0] : nullptr;
+    double* J_cam_from_rig = jacobians ? jacobians[1] : nullptr;
+    double* J_rig_from_world = jacobians ? jacobians[2] : nullptr;
+    double* J_params = jacobians ? jacobians[3] : nullptr;
+
+    Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J_point_mat(
+        J_point);
+    Eigen::Map<Eigen::Matrix<double, 2, 7, Eigen::RowMajor>>
+        J_cam_from_rig_mat(J_cam_from_rig);
+    Eigen::Map<Eigen::Matrix<double, 2, 7, Eigen::RowMajor>>
+        J_rig_from_world_mat(J_rig_from_world);
+    Eigen::Matrix<double, 3, 4, Eigen::RowMajor> J_cam_quat_mat;
+    Eigen::Matrix<double, 3, 4, Eigen::RowMajor> J_rig_quat_mat;
+    Eigen::Matrix<double, 2, 3, Eigen::RowMajor> J_uvw_mat;
+
+    const Eigen::Vector3d point3D_in_rig =
+        QuaternionRotatePointWithJac(
+            rig_from_world,
+            point3D_in_world,
+            J_rig_from_world ? J_rig_quat_mat.data() : nullptr) +
+        Eigen::Map<const Eigen::Vector3d>(rig_from_world + 4);
+    const Eigen::Vector3d point3D_in_cam =
+        QuaternionRotatePointWithJac(
+            cam_from_rig,
+            point3D_in_rig.data(),
+            J_cam_from_rig ? J_cam_quat_mat.data() : nullptr) +
+        Eigen::Map<const Eigen::Vector3d>(cam_from_rig + 4);
+
+    const bool need_J_uvw = J_point || J_cam_from_rig || J_rig_from_world;
+    if (!CameraModel::ImgFromCamWithJac(
+            camera_params,
+            point3D_in_cam[0],
+            point3D_in_cam[1],
+            point3D_in_cam[2],
+            &residuals[0],
+            &residuals[1],
+            J_params,
+            need_J_uvw ? J_uvw_mat.data() : nullptr)) {
+      Eigen::Map<Eigen::Vector2d>(residuals).setZero();
+      if (J_point) {
+        J_point_mat.setZero();
+      }
+      if (J_cam_from_rig) {
+        J_cam_from_rig_mat.setZero();
+      }
+      if (J_rig_from_world) {
+        J_rig_from_world_mat.setZero();
+      }
+      if (J_params) {
+        Eigen::Map<Eigen::Matrix<double, 2, CameraModel::num_params>>(J_params)
+            .setZero();
+      }
+      return true;
+    }
+
+    Eigen::Map<Eigen::Vector2d>(residuals) -= point2D_;
+    WrapEquirectangularHorizontalSeam<CameraModel>(camera_params, residuals);
+
+    if (J_cam_from_rig) {
+      J_cam_from_rig_mat.leftCols<4>() = J_uvw_mat * J_cam_quat_mat;
+      J_cam_from_rig_mat.rightCols<3>() = J_uvw_mat;
+    }
+    if (J_point || J_rig_from_world) {
+      // Jacobian of the residual w.r.t. the point in the rig frame.
+      const Eigen::Matrix<double, 2, 3, Eigen::RowMajor> J_uvw_rig_mat =
+          J_uvw_mat *
+          EigenQuaternionMap<double>(cam_from_rig).toRotationMatrix();
+      if (J_point) {
+        J_point_mat =
+            J_uvw_rig_mat *
+            EigenQuaternionMap<double>(rig_from_world).toRotationMatrix();
+      }
+      if (J_rig_from_world) {
+        J_rig_from_world_mat.leftCols<4>() = J_uvw_rig_mat * J_rig_quat_mat;
+        J_rig_from_world_mat.rightCols<3>() = J_uvw_rig_mat;
+      }
+    }
+
+    return true;
+  }
+
+ private:
+  const Eigen::Vector2d point2D_;
+};
+
+// Rig reprojection error cost function with analytical Jacobians for variable
+// rig pose, calibration, and point parameters, and fixed camera pose in the
+// rig. The rotation matrix of the fixed pose is computed once on construction.
+template <typename CameraModel>
+class AnalyticalRigReprojErrorConstantRigCostFunction
+    : public ceres::SizedCostFunction<2, 3, 7, CameraModel::num_params> {
+ public:
+  AnalyticalRigReprojErrorConstantRigCostFunction(
+      const Eigen::Vector2d& point2D, const Rigid3d& cam_from_rig)
+      : point2D_(point2D),
+        cam_from_rig_rotation_(cam_from_rig.rotation().toRotationMatrix()),
+        cam_from_rig_translation_(cam_from_rig.translation()) {}
+
+  bool Evaluate(double const* const* parameters,
+                double* residuals,
+                double** jacobians) const override {
+    const double* point3D_in_world = parameters[0];
+    const double* rig_from_world = parameters[1];
+    const double* camera_params = parameters[2];
+
+    double* J_point = jacobians ? jacobians[0] : nullptr;
+    double* J_rig_from_world = jacobians ? jacobians[1] : nullptr;
+    double* J_params = jacobians ? jacobians[2] : nullptr;
+
+    Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J_point_mat(
+        J_point);
+    Eigen::Map<Eigen::Matrix<double, 2, 7, Eigen::RowMajor>>
+        J_rig_from_world_mat(J_rig_from_world);
+    Eigen::Matrix<double, 3, 4, Eigen::RowMajor> J_rig_quat_mat;
+    Eigen::Matrix<double, 2, 3, Eigen::RowMajor> J_uvw_mat;
+
+    const Eigen::Vector3d point3D_in_rig =
+        QuaternionRotatePointWithJac(
+            rig_from_world,
+            point3D_in_world,
+            J_rig_from_world ? J_rig_quat_mat.data() : nullptr) +
+        Eigen::Map<const Eigen::Vector3d>(rig_from_world + 4);
+    const Eigen::Vector3d point3D_in_cam =
+        cam_from_rig_rotation_ * point3D_in_rig + cam_from_rig_translation_;
+
+    const bool need_J_uvw = J_point || J_rig_from_world;
+    if (!CameraModel::ImgFromCamWithJac(
+            camera_params,
+            point3D_in_cam[0],
+            point3D_in_cam[1],
+            point3D_in_cam[2],
+            &residuals[0],
+            &residuals[1],
+            J_params,
+            need_J_uvw ? J_uvw_mat.data() : nullptr)) {
+      Eigen::Map<Eigen::Vector2d>(residuals).setZero();
+      if (J_point) {
+        J_point_mat.setZero();
+      }
+      if (J_rig_from_world) {
+        J_rig_from_world_mat.setZero();
+      }
+      if (J_params) {
+        Eigen::Map<Eigen::Matrix<double, 2, CameraModel::num_params>>(J_params)
+            .setZero();
+      }
+      return true;
+    }
+
+    Eigen::Map<Eigen::Vector2d>(residuals) -= point2D_;
+    WrapEquirectangularHorizontalSeam<CameraModel>(camera_params, residuals);
+
+    if (need_J_uvw) {
+      // Jacobian of the residual w.r.t. the point in the rig frame.
+      const Eigen::Matrix<double, 2, 3, Eigen::RowMajor> J_uvw_rig_mat =
+          J_uvw_mat * cam_from_rig_rotation_;
+      if (J_point) {
+        J_point_mat =
+            J_uvw_rig_mat *
+            EigenQuaternionMap<double>(rig_from_world).toRotationMatrix();
+      }
+      if (J_rig_from_world) {
+        J_rig_from_world_mat.leftCols<4>() = J_uvw_rig_mat * J_rig_quat_mat;
+        J_rig_from_world_mat.rightCols<3>() = J_uvw_rig_mat;
+      }
+    }
+
+    return true;
+  }
+
+ private:
+  const Eigen::Vector2d point2D_;
+  const Eigen::Matrix3d cam_from_rig_rotation_;
+  const Eigen::Vector3d cam_from_rig_translation_;
+};
+
 // Standard bundle adjustment cost function for variable
 // camera pose, calibration, and point parameters.
 template <typename CameraModel>
@@ -318,22 +577,60 @@ class RigReprojErrorConstantRigCostFunctor
   const RigReprojErrorCostFunctor<CameraModel> reproj_cost_;
 };
 
-// Creates the analytical reprojection error cost function for camera models
-// that implement ImgFromCamWithJac(). The overloads are selected via SFINAE so
-// that AnalyticalReprojErrorCostFunction<CameraModel> is only ever named (and
-// thus instantiated) for qualifying models. This avoids instantiating its
-// virtual Evaluate() member for models without an analytical Jacobian, which
-// would reference the SFINAE-disabled ImgFromCamWithJac() overload.
-template <typename CameraModel, typename... Args>
+// Maps the auto-differentiated cost functors to their counterparts with
+// analytical Jacobians, which are used for camera models that implement
+// ImgFromCamWithJac().
+template <template <typename> class CostFunctor>
+struct AnalyticalCostFunctionTraits : std::false_type {};
+
+template <>
+struct AnalyticalCostFunctionTraits<ReprojErrorCostFunctor> : std::true_type {
+  template <typename CameraModel>
+  using CostFunction = AnalyticalReprojErrorCostFunction<CameraModel>;
+};
+
+template <>
+struct AnalyticalCostFunctionTraits<ReprojErrorConstantPoseCostFunctor>
+    : std::true_type {
+  template <typename CameraModel>
+  using CostFunction =
+      AnalyticalReprojErrorConstantPoseCostFunction<CameraModel>;
+};
+
+template <>
+struct AnalyticalCostFunctionTraits<RigReprojErrorCostFunctor>
+    : std::true_type {
+  template <typename CameraModel>
+  using CostFunction = AnalyticalRigReprojErrorCostFunction<CameraModel>;
+};
+
+template <>
+struct AnalyticalCostFunctionTraits<RigReprojErrorConstantRigCostFunctor>
+    : std::true_type {
+  template <typename CameraModel>
+  using CostFunction =
+      AnalyticalRigReprojErrorConstantRigCostFunction<CameraModel>;
+};
+
+// Creates the analytical cost function for camera models that implement
+// ImgFromCamWithJac(). The overloads are selected via SFINAE so that the
+// analytical cost function is only ever instantiated for qualifying models.
+// This avoids instantiating its virtual Evaluate() member for models without
+// an analytical Jacobian, which would reference the SFINAE-disabled
+// ImgFromCamWithJac() overload.
+template <template <typename> class AnalyticalCostFunction,
+          typename CameraModel,
+          typename... Args>
 std::enable_if_t<CameraModel::has_img_from_cam_with_jac, ceres::CostFunction*>
-CreateAnalyticalReprojErrorCostFunction(Args&&... args) {
-  return new AnalyticalReprojErrorCostFunction<CameraModel>(
-      std::forward<Args>(args)...);
+CreateAnalyticalCostFunction(Args&&... args) {
+  return new AnalyticalCostFunction<CameraModel>(std::forward<Args>(args)...);
 }
 
-template <typename CameraModel, typename... Args>
+template <template <typename> class AnalyticalCostFunction,
+          typename CameraModel,
+          typename... Args>
 std::enable_if_t<!CameraModel::has_img_from_cam_with_jac, ceres::CostFunction*>
-CreateAnalyticalReprojErrorCostFunction(Args&&... /*args*/) {
+CreateAnalyticalCostFunction(Args&&... /*args*/) {
   // Unreachable: callers guard on has_img_from_cam_with_jac.
   return nullptr;
 }
@@ -343,16 +640,16 @@ ceres::CostFunction* CreateCameraCostFunction(
     const CameraModelId camera_model_id, Args&&... args) {
   // NOLINTBEGIN(bugprone-macro-parentheses)
   switch (camera_model_id) {
-#define CAMERA_MODEL_CASE(CameraModel)                                        \
-  case CameraModel::model_id:                                                 \
-    if constexpr (std::is_same<CostFunctor<CameraModel>,                      \
-                               ReprojErrorCostFunctor<CameraModel>>::value && \
-                  CameraModel::has_img_from_cam_with_jac) {                   \
-      return CreateAnalyticalReprojErrorCostFunction<CameraModel>(            \
-          std::forward<Args>(args)...);                                       \
-    } else {                                                                  \
-      return CostFunctor<CameraModel>::Create(std::forward<Args>(args)...);   \
-    }                                                                         \
+#define CAMERA_MODEL_CASE(CameraModel)                                       \
+  case CameraModel::model_id:                                                \
+    if constexpr (AnalyticalCostFunctionTraits<CostFunctor>::value &&        \
+                  CameraModel::has_img_from_cam_with_jac) {                  \
+      return CreateAnalyticalCostFunction<                                   \
+          AnalyticalCostFunctionTraits<CostFunctor>::template CostFunction,  \
+          CameraModel>(std::forward<Args>(args)...);                         \
+    } else {                                                                 \
+      return CostFunctor<CameraModel>::Create(std::forward<Args>(args)...);  \
+    }                                                                        \
     break;
 
     CAMERA_MODEL_SWITCH_CASES
@@ -126,6 +126,177 @@ TEST(ReprojErrorCostFunctor, AnalyticalVersusAutoDiff) {
   }
 }
 
+// Evaluates both cost functions with Jacobians for all parameter blocks and
+// checks that their residuals and Jacobians agree.
+void ExpectEqualResidualsAndJacobians(
+    const ceres::CostFunction& analytical_cost_function,
+    const ceres::CostFunction& auto_diff_cost_function,
+    const std::vector<double*>& parameter_blocks) {
+  const std::vector<int32_t>& block_sizes =
+      auto_diff_cost_function.parameter_block_sizes();
+  ASSERT_EQ(analytical_cost_function.parameter_block_sizes(), block_sizes);
+  ASSERT_EQ(block_sizes.size(), parameter_blocks.size());
+
+  std::vector<std::vector<double>> analytical_jacobians;
+  std::vector<std::vector<double>> auto_diff_jacobians;
+  std::vector<double*> analytical_jacobian_ptrs;
+  std::vector<double*> auto_diff_jacobian_ptrs;
+  for (const int32_t block_size : block_sizes) {
+    analytical_jacobians.emplace_back(2 * block_size);
+    auto_diff_jacobians.emplace_back(2 * block_size);
+  }
+  for (size_t i = 0; i < block_sizes.size(); ++i) {
+    analytical_jacobian_ptrs.push_back(analytical_jacobians[i].data());
+    auto_diff_jacobian_ptrs.push_back(auto_diff_jacobians[i].data());
+  }
+
+  Eigen::Vector2d analytical_residuals;
+  Eigen::Vector2d auto_diff_residuals;
+  ASSERT_TRUE(
+      analytical_cost_function.Evaluate(parameter_blocks.data(),
+                                        analytical_residuals.data(),
+                                        analytical_jacobian_ptrs.data()));
+  ASSERT_TRUE(auto_diff_cost_function.Evaluate(parameter_blocks.data(),
+                                               auto_diff_residuals.data(),
+                                               auto_diff_jacobian_ptrs.data()));
+
+  constexpr double kEps = 1e-8;
+  EXPECT_NEAR(analytical_residuals[0], auto_diff_residuals[0], kEps);
+  EXPECT_NEAR(analytical_residuals[1], auto_diff_residuals[1], kEps);
+  for (size_t i = 0; i < block_sizes.size(); ++i) {
+    for (int j = 0; j < 2 * block_sizes[i]; ++j) {
+      EXPECT_NEAR(analytical_jacobians[i][j], auto_diff_jacobians[i][j], kEps)
+          << "parameter block " << i << ", entry " << j;
+    }
+  }
+
+  // Residuals without Jacobians are consistent.
+  Eigen::Vector2d residuals;
+  ASSERT_TRUE(analytical_cost_function.Evaluate(
+      parameter_blocks.data(), residuals.data(), nullptr));
+  EXPECT_EQ(residuals, analytical_residuals);
+}
+
+template <typename CameraModel>
+void TestAnalyticalVersusAutoDiff(std::vector<double> camera_params) {
+  SetPRNGSeed(42);
+
+  const Eigen::Vector2d point2D(200, 300);
+  const Rigid3d cam_from_rig(
+      Eigen::Quaterniond(
+          Eigen::AngleAxisd(0.2, Eigen::Vector3d(1, 0.5, -0.2).normalized())),
+      Eigen::Vector3d(0.1, -0.2, 0.3));
+
+  for (const double x : {-1, 0, 1}) {
+    for (const double y : {-1, 0, 1}) {
+      for (const double z : {0, 1, 2, 3}) {
+        Rigid3d rig_from_world(Eigen::Quaterniond(Eigen::AngleAxisd(
+                                   RandomUniformReal<double>(0, 2 * EIGEN_PI),
+                                   Eigen::Vector3d(0.1, -0.1, 1).normalized())),
+                               Eigen::Vector3d(1, 2, 3));
+        Rigid3d cam_from_world = cam_from_rig * rig_from_world;
+        Eigen::Vector3d point3D(x, y, z);
+
+        ExpectEqualResidualsAndJacobians(
+            AnalyticalReprojErrorCostFunction<CameraModel>(point2D),
+            *std::unique_ptr<ceres::CostFunction>(
+                ReprojErrorCostFunctor<CameraModel>::Create(point2D)),
+            {point3D.data(),
+             cam_from_world.params.data(),
+             camera_params.data()});
+
+        ExpectEqualResidualsAndJacobians(
+            AnalyticalReprojErrorConstantPoseCostFunction<CameraModel>(
+                point2D, cam_from_world),
+            *std::unique_ptr<ceres::CostFunction>(
+                ReprojErrorConstantPoseCostFunctor<CameraModel>::Create(
+                    point2D, cam_from_world)),
+            {point3D.data(), camera_params.data()});
+
+        Rigid3d mutable_cam_from_rig = cam_from_rig;
+        ExpectEqualResidualsAndJacobians(
+            AnalyticalRigReprojErrorCostFunction<CameraModel>(point2D),
+            *std::unique_ptr<ceres::CostFunction>(
+                RigReprojErrorCostFunctor<CameraModel>::Create(point2D)),
+            {point3D.data(),
+             mutable_cam_from_rig.params.data(),
+             rig_from_world.params.data(),
+             camera_params.data()});
+
+        ExpectEqualResidualsAndJacobians(
+            AnalyticalRigReprojErrorConstantRigCostFunction<CameraModel>(
+                point2D, cam_from_rig),
+            *std::unique_ptr<ceres::CostFunction>(
+                RigReprojErrorConstantRigCostFunctor<CameraModel>::Create(
+                    point2D, cam_from_rig)),
+            {point3D.data(),
+             rig_from_world.params.data(),
+             camera_params.data()});
+      }
+    }
+  }
+
+  // Points behind the camera have zero residuals and Jacobians.
+  Eigen::Vector3d point3D(0, 0, -1);
+  Rigid3d cam_from_world;
+  ExpectEqualResidualsAndJacobians(
+      AnalyticalReprojErrorCostFunction<CameraModel>(point2D),
+      *std::unique_ptr<ceres::CostFunction>(
+          ReprojErrorCostFunctor<CameraModel>::Create(point2D)),
+      {point3D.data(), cam_from_world.params.data(), camera_params.data()});
+}
+
+TEST(AnalyticalCostFunctions, SimplePinhole) {
+  TestAnalyticalVersusAutoDiff<SimplePinholeCameraModel>({200, 100, 120});
+}
+
+TEST(AnalyticalCostFunctions, Pinhole) {
+  TestAnalyticalVersusAutoDiff<PinholeCameraModel>({200, 210, 100, 120});
+}
+
+TEST(AnalyticalCostFunctions, SimpleRadial) {
+  TestAnalyticalVersusAutoDiff<SimpleRadialCameraModel>({200, 100, 120, 0.1});
+}
+
+TEST(AnalyticalCostFunctions, OpenCV) {
+  TestAnalyticalVersusAutoDiff<OpenCVCameraModel>(
+      {200, 210, 100, 120, 0.1, -0.02, 0.003, -0.004});
+}
+
+TEST(CreateCameraCostFunction, Analytical) {
+  const Eigen::Vector2d point2D(1, 2);
+  const Rigid3d cam_from_rig;
+  EXPECT_NE(dynamic_cast<AnalyticalReprojErrorCostFunction<OpenCVCameraModel>*>(
+                std::unique_ptr<ceres::CostFunction>(
+                    CreateCameraCostFunction<ReprojErrorCostFunctor>(
+                        CameraModelId::kOpenCV, point2D))
+                    .get()),
+            nullptr);
+  EXPECT_NE(
+      dynamic_cast<
+          AnalyticalRigReprojErrorConstantRigCostFunction<PinholeCameraModel>*>(
+          std::unique_ptr<ceres::CostFunction>(
+              CreateCameraCostFunction<RigReprojErrorConstantRigCostFunctor>(
+                  CameraModelId::kPinhole, point2D, cam_from_rig))
+              .get()),
+      nullptr);
+  // Cost functors without an analytical counterpart and camera models without
+  // analytical Jacobians are auto-differentiated.
+  EXPECT_EQ(
+      dynamic_cast<
+          AnalyticalReprojErrorCostFunction<FullOpenCVCameraModel>*>(
+          std::unique_ptr<ceres::CostFunction>(
+              CreateCameraCostFunction<ReprojErrorCostFunctor>(
+                  CameraModelId::kFullOpenCV, point2D))
+              .get()),
+      nullptr);
+  EXPECT_NE(std::unique_ptr<ceres::CostFunction>(
+                CreateCameraCostFunction<ReprojErrorConstantPoint3DCostFunctor>(
+                    CameraModelId::kOpenCV, point2D, Eigen::Vector3d(0, 0, 1)))
+                .get(),
+            nullptr);
+}
+
 TEST(ReprojErrorConstantPoseCostFunctor, Nominal) {
   Rigid3d cam_from_world;
   std::unique_ptr<ceres::CostFunction> cost_function(
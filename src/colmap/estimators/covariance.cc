@@ -30,7 +30,10 @@
 #include "colmap/estimators/covariance.h"
 
 #include "colmap/estimators/cost_functions/manifold.h"
+#include "colmap/optim/sparse_cholesky.h"
+#include "colmap/util/threading.h"
 
+#include <algorithm>
 #include <unordered_set>
 
 #include <ceres/crs_matrix.h>
@@ -43,6 +46,7 @@ bool ComputeSchurComplement(
     bool estimate_pose_covs,
     bool estimate_other_covs,
     double damping,
+    int num_threads,
     int point_num_params,
     const std::vector<internal::PointParam>& points,
     const std::vector<internal::PoseParam>& poses,
@@ -103,16 +107,46 @@ bool ComputeSchurComplement(
   const Eigen::SparseMatrix<double> H_ap = J_a.transpose() * J_p;
   const Eigen::SparseMatrix<double> H_pa = H_ap.transpose();
   Eigen::SparseMatrix<double> H_pp = J_p.transpose() * J_p;
+
+  // Invert the independent per-point blocks in parallel.
+  std::vector<int> point_tangent_sizes(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    point_tangent_sizes[i] = ParameterBlockTangentSize(problem, points[i].xyz);
+  }
+  std::vector<Eigen::MatrixXd> H_pp_inv_blocks(points.size());
+  const Eigen::SparseMatrix<double>& H_pp_const = H_pp;
+  auto InvertPointBlocks = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const int point_param_idx = 3 * static_cast<int>(i);
+      const int tangent_size = point_tangent_sizes[i];
+      const Eigen::MatrixXd H_pp_idx =
+          H_pp_const.block(
+              point_param_idx, point_param_idx, tangent_size, tangent_size) +
+          damping * Eigen::MatrixXd::Identity(tangent_size, tangent_size);
+      H_pp_inv_blocks[i] = H_pp_idx.inverse();
+    }
+  };
+  num_threads = std::min<int>(GetEffectiveNumThreads(num_threads),
+                              std::max<size_t>(1, points.size() / 1000));
+  if (num_threads > 1) {
+    ThreadPool thread_pool(num_threads);
+    const size_t chunk_size = (points.size() + num_threads - 1) / num_threads;
+    for (size_t begin = 0; begin < points.size(); begin += chunk_size) {
+      thread_pool.AddTask(InvertPointBlocks,
+                          begin,
+                          std::min(begin + chunk_size, points.size()));
+    }
+    thread_pool.Wait();
+  } else {
+    InvertPointBlocks(0, points.size());
+  }
+
   // In-place computation of H_pp_inv.
   Eigen::SparseMatrix<double>& H_pp_inv = H_pp;
   int point_param_idx = 0;
-  for (const internal::PointParam& point : points) {
-    const int tangent_size = ParameterBlockTangentSize(problem, point.xyz);
-    const Eigen::MatrixXd H_pp_idx =
-        H_pp.block(
-            point_param_idx, point_param_idx, tangent_size, tangent_size) +
-        damping * Eigen::MatrixXd::Identity(tangent_size, tangent_size);
-    const Eigen::MatrixXd H_pp_idx_inv = H_pp_idx.inverse();
+  for (size_t point_idx = 0; point_idx < points.size(); ++point_idx) {
+    const int tangent_size = point_tangent_sizes[point_idx];
+    const Eigen::MatrixXd& H_pp_idx_inv = H_pp_inv_blocks[point_idx];
     for (int i = 0; i < tangent_size; ++i) {
       for (int j = 0; j < tangent_size; ++j) {
         H_pp_inv.coeffRef(point_param_idx + i, point_param_idx + j) =
@@ -121,7 +155,8 @@ bool ComputeSchurComplement(
     }
     if (estimate_point_covs) {
       // Point covariance conditioned on fixed pose/other parameters.
-      point_covs.emplace(point.point3D_id, H_pp_idx_inv);
+      point_covs.emplace(points[point_idx].point3D_id,
+                         std::move(H_pp_inv_blocks[point_idx]));
     }
     point_param_idx += 3;
   }
@@ -206,6 +241,64 @@ bool ComputeLInverse(Eigen::SparseMatrix<double>& S, Eigen::MatrixXd& L_inv) {
   return true;
 }
 
+bool ComputeBlockDiagonalCovs(
+    const SparseCholeskyOptions& sparse_cholesky_options,
+    const Eigen::SparseMatrix<double>& S,
+    const std::vector<std::pair<int, int>>& blocks,
+    std::unordered_map<int, Eigen::MatrixXd>& block_diagonal_covs) {
+  VLOG(2) << "Start sparse Cholesky factorization (n = " << S.rows() << ")";
+  SparseCholeskyWithFallbackSolver solver(sparse_cholesky_options);
+  if (!solver.Compute(S)) {
+    LOG(WARNING) << "Unable to compute covariance. The Schur complement on "
+                    "pose/other parameters is not positive definite. This is "
+                    "likely due to the pose/other parameters being "
+                    "underconstrained with Gauge ambiguity or other "
+                    "degeneracies.";
+    return false;
+  }
+
+  // Recover the diagonal blocks of the inverse by solving against batches of
+  // unit vectors. This bounds the memory to a fixed number of dense columns
+  // instead of the full dense inverse.
+  constexpr int kMaxNumColsPerBatch = 256;
+  block_diagonal_covs.reserve(blocks.size());
+  size_t batch_end = 0;
+  while (batch_end < blocks.size()) {
+    const size_t batch_begin = batch_end;
+    int num_cols = 0;
+    while (batch_end < blocks.size() &&
+           (num_cols == 0 ||
+            num_cols + blocks[batch_end].second <= kMaxNumColsPerBatch)) {
+      num_cols += blocks[batch_end].second;
+      ++batch_end;
+    }
+
+    Eigen::MatrixXd B = Eigen::MatrixXd::Zero(S.rows(), num_cols);
+    int col = 0;
+    for (size_t i = batch_begin; i < batch_end; ++i) {
+      const auto [start, size] = blocks[i];
+      B.block(start, col, size, size).setIdentity();
+      col += size;
+    }
+
+    Eigen::MatrixXd X;
+    if (!solver.Solve(B, &X) || !X.allFinite()) {
+      LOG(WARNING) << "Failed to solve for block-diagonal covariances";
+      return false;
+    }
+
+    col = 0;
+    for (size_t i = batch_begin; i < batch_end; ++i) {
+      const auto [start, size] = blocks[i];
+      block_diagonal_covs.emplace(start, X.block(start, col, size, size));
+      col += size;
+    }
+  }
+
+  VLOG(2) << "Finish block-diagonal covariances.";
+  return true;
+}
+
 Eigen::MatrixXd ExtractCovFromLInverse(const Eigen::MatrixXd& L_inv,
                                        int row_start,
                                        int col_start,
@@ -221,11 +314,32 @@ BACovariance::BACovariance(
     std::unordered_map<point3D_t, Eigen::MatrixXd> point_covs,
     std::unordered_map<image_t, std::pair<int, int>> pose_L_start_size,
     std::unordered_map<const double*, std::pair<int, int>> other_L_start_size,
-    Eigen::MatrixXd L_inv)
+    Eigen::MatrixXd L_inv,
+    std::unordered_map<int, Eigen::MatrixXd> block_diagonal_covs)
     : point_covs_(std::move(point_covs)),
       pose_L_start_size_(std::move(pose_L_start_size)),
       other_L_start_size_(std::move(other_L_start_size)),
-      L_inv_(std::move(L_inv)) {}
+      L_inv_(std::move(L_inv)),
+      block_diagonal_covs_(std::move(block_diagonal_covs)) {}
+
+std::optional<Eigen::MatrixXd> BACovariance::ExtractCov(
+    int row_start,
+    int col_start,
+    int row_block_size,
+    int col_block_size) const {
+  if (L_inv_.size() > 0) {
+    return ExtractCovFromLInverse(
+        L_inv_, row_start, col_start, row_block_size, col_block_size);
+  }
+  if (row_start != col_start) {
+    return std::nullopt;
+  }
+  const auto it = block_diagonal_covs_.find(row_start);
+  if (it == block_diagonal_covs_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
 
 std::optional<Eigen::MatrixXd> BACovariance::GetPointCov(
     point3D_t point3D_id) const {
@@ -243,7 +357,7 @@ std::optional<Eigen::MatrixXd> BACovariance::GetCamCovFromWorld(
     return std::nullopt;
   }
   const auto [start, size] = it->second;
-  return ExtractCovFromLInverse(L_inv_, start, start, size, size);
+  return ExtractCov(start, start, size, size);
 }
 
 std::optional<Eigen::MatrixXd> BACovariance::GetCamCrossCovFromWorld(
@@ -255,7 +369,7 @@ std::optional<Eigen::MatrixXd> BACovariance::GetCamCrossCovFromWorld(
   }
   const auto [start1, size1] = it1->second;
   const auto [start2, size2] = it2->second;
-  return ExtractCovFromLInverse(L_inv_, start1, start2, size1, size2);
+  return ExtractCov(start1, start2, size1, size2);
 }
 
 std::optional<Eigen::MatrixXd> BACovariance::GetCam2CovFromCam1(
@@ -278,7 +392,7 @@ std::optional<Eigen::MatrixXd> BACovariance::GetCam2CovFromCam1(
     return std::nullopt;
   }
   auto cov_12 = GetCamCrossCovFromWorld(image_id1, image_id2);
-  THROW_CHECK(cov_12.has_value());
+  if (!cov_12.has_value()) return std::nullopt;
   Eigen::Matrix<double, 12, 12> cov;
   cov.block<6, 6>(0, 0) = *cov_11;
   cov.block<6, 6>(6, 6) = *cov_22;
@@ -294,7 +408,7 @@ std::optional<Eigen::MatrixXd> BACovariance::GetOtherParamsCov(
     return std::nullopt;
   }
   const auto [start, size] = it->second;
-  return ExtractCovFromLInverse(L_inv_, start, start, size, size);
+  return ExtractCov(start, start, size, size);
 }
 
 std::optional<BACovariance> EstimateBACovariance(
@@ -363,6 +477,7 @@ std::optional<BACovariance> EstimateBACovarianceFromProblem(
                               estimate_pose_covs,
                               estimate_other_covs,
                               options.damping,
+                              options.num_threads,
                               point_num_params,
                               points,
                               poses,
@@ -387,6 +502,36 @@ std::optional<BACovariance> EstimateBACovarianceFromProblem(
     }
   }
 
+  if (options.block_diagonal) {
+    VLOG(2) << "Computing block-diagonal covariances";
+
+    std::vector<std::pair<int, int>> blocks;
+    blocks.reserve(pose_L_start_size.size() + other_L_start_size.size());
+    for (const auto& [_, start_size] : pose_L_start_size) {
+      blocks.push_back(start_size);
+    }
+    if (estimate_other_covs) {
+      for (const auto& [_, start_size] : other_L_start_size) {
+        blocks.push_back(start_size);
+      }
+    }
+    // Contiguous columns make for sparser right-hand sides per batch.
+    std::sort(blocks.begin(), blocks.end());
+
+    std::unordered_map<int, Eigen::MatrixXd> block_diagonal_covs;
+    if (!blocks.empty() &&
+        !ComputeBlockDiagonalCovs(
+            options.sparse_cholesky, S, blocks, block_diagonal_covs)) {
+      return std::nullopt;
+    }
+
+    return BACovariance(std::move(point_covs),
+                        std::move(pose_L_start_size),
+                        std::move(other_L_start_size),
+                        /*L_inv=*/Eigen::MatrixXd(),
+                        std::move(block_diagonal_covs));
+  }
+
   VLOG(2) << "Computing L inverse";
 
   Eigen::MatrixXd L_inv;
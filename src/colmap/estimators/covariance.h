@@ -31,6 +31,7 @@
 
 #include "colmap/estimators/bundle_adjustment_ceres.h"
 #include "colmap/geometry/rigid3.h"
+#include "colmap/optim/sparse_cholesky.h"
 #include "colmap/scene/reconstruction.h"
 
 #include <optional>
@@ -52,7 +53,8 @@ struct BACovariance {
       std::unordered_map<point3D_t, Eigen::MatrixXd> point_covs,
       std::unordered_map<image_t, std::pair<int, int>> pose_L_start_size,
       std::unordered_map<const double*, std::pair<int, int>> other_L_start_size,
-      Eigen::MatrixXd L_inv);
+      Eigen::MatrixXd L_inv,
+      std::unordered_map<int, Eigen::MatrixXd> block_diagonal_covs = {});
 
   // Covariance for 3D points, conditioned on all other variables set constant.
   // If some dimensions are kept constant, the respective rows/columns are
@@ -63,13 +65,15 @@ struct BACovariance {
   // dimensions are kept constant, the respective rows/columns are omitted.
   // Returns null if image is not a variable in the problem.
   std::optional<Eigen::MatrixXd> GetCamCovFromWorld(image_t image_id) const;
+  // Returns null if only block-diagonal covariances were estimated.
   std::optional<Eigen::MatrixXd> GetCamCrossCovFromWorld(
       image_t image_id1, image_t image_id2) const;
   // Get relative pose covariance in the order [rotation, translation]. This
   // function returns null if some dimensions are kept constant for either of
   // the two poses. This does not mean that one cannot get relative pose
   // covariance for such case, but requires custom logic to fill in zero block
-  // in the covariance matrix.
+  // in the covariance matrix. Also returns null if only block-diagonal
+  // covariances were estimated.
   std::optional<Eigen::MatrixXd> GetCam2CovFromCam1(
       image_t image_id1,
       const Rigid3d& cam1_from_world,
@@ -83,11 +87,19 @@ struct BACovariance {
   std::optional<Eigen::MatrixXd> GetOtherParamsCov(const double* params) const;
 
  private:
+  std::optional<Eigen::MatrixXd> ExtractCov(int row_start,
+                                            int col_start,
+                                            int row_block_size,
+                                            int col_block_size) const;
+
   const std::unordered_map<point3D_t, Eigen::MatrixXd> point_covs_;
   const std::unordered_map<image_t, std::pair<int, int>> pose_L_start_size_;
   const std::unordered_map<const double*, std::pair<int, int>>
       other_L_start_size_;
   const Eigen::MatrixXd L_inv_;
+  // Diagonal blocks of the pose/other covariance keyed by their start index.
+  // Only set if the dense L_inv was not computed.
+  const std::unordered_map<int, Eigen::MatrixXd> block_diagonal_covs_;
 };
 
 struct BACovarianceOptions {
@@ -105,6 +117,21 @@ struct BACovarianceOptions {
   // Enables to robustly deal with poorly conditioned parameters.
   double damping = 1e-8;
 
+  // Whether to only compute the diagonal blocks of the pose/other covariance,
+  // i.e., the marginal covariance of each parameter block without the
+  // cross-covariances between different blocks. The blocks are recovered by
+  // solving against the sparse factorization of the Schur complement, which
+  // avoids the dense inverse with quadratic memory and cubic runtime in the
+  // number of images. Recommended for large reconstructions.
+  bool block_diagonal = false;
+
+  // Sparse Cholesky factorization of the Schur complement in block-diagonal
+  // mode.
+  SparseCholeskyOptions sparse_cholesky;
+
+  // The number of threads to use, -1 for all available threads.
+  int num_threads = -1;
+
   // WARNING: This option will be removed in a future release, use at your own
   // risk. For custom bundle adjustment problems, this enables to specify a
   // custom set of pose parameter blocks to consider. Note that these pose
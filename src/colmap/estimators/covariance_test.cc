@@ -190,6 +190,10 @@ TEST_P(ParameterizedBACovarianceTests, CompareWithCeres) {
         } else {
           const std::optional<Eigen::MatrixXd> cov =
               ba_cov->GetCamCrossCovFromWorld(pose1.image_id, pose2.image_id);
+          if (options.block_diagonal) {
+            ASSERT_FALSE(cov.has_value());
+            continue;
+          }
           ASSERT_TRUE(cov.has_value());
           ExpectNearEigenMatrixXd(
               ceres_cov.block(0, tangent_size1, tangent_size1, tangent_size2),
@@ -323,6 +327,20 @@ INSTANTIATE_TEST_SUITE_P(
           options.params = BACovarianceOptions::Params::POSES_AND_POINTS;
           BACovarianceTestOptions test_options;
           return std::make_pair(options, test_options);
+        }(),
+        []() {
+          BACovarianceOptions options;
+          options.params = BACovarianceOptions::Params::ALL;
+          options.block_diagonal = true;
+          BACovarianceTestOptions test_options;
+          return std::make_pair(options, test_options);
+        }(),
+        []() {
+          BACovarianceOptions options;
+          options.params = BACovarianceOptions::Params::POSES;
+          options.block_diagonal = true;
+          BACovarianceTestOptions test_options;
+          return std::make_pair(options, test_options);
         }()));
 
 }  // namespace
@@ -135,9 +135,13 @@ bool EstimateGeneralizedAbsolutePose(
     const std::vector<Camera>& cameras,
     Rigid3d* rig_from_world,
     size_t* num_inliers,
-    std::vector<char>* inlier_mask) {
+    std::vector<char>* inlier_mask,
+    const std::vector<point3D_t>* point3D_ids) {
   THROW_CHECK_EQ(points2D.size(), points3D.size());
   THROW_CHECK_EQ(points2D.size(), camera_idxs.size());
+  if (point3D_ids != nullptr) {
+    THROW_CHECK_EQ(points2D.size(), point3D_ids->size());
+  }
   ThrowCheckCameras(camera_idxs, cams_from_rig, cameras);
   options.Check();
   if (points2D.size() == 0) {
@@ -162,8 +166,12 @@ bool EstimateGeneralizedAbsolutePose(
   // Associate unique ids to each 3D point.
   // Needed for UniqueInlierSupportMeasurer to avoid counting the same
   // 3D point multiple times due to FoV overlap in rig.
-  // TODO(sarlinpe): Allow passing unique_point3D_ids as argument.
-  std::vector<size_t> unique_point3D_ids = ComputeUniquePointIds(points3D);
+  std::vector<size_t> unique_point3D_ids;
+  if (point3D_ids == nullptr) {
+    unique_point3D_ids = ComputeUniquePointIds(points3D);
+  } else {
+    unique_point3D_ids.assign(point3D_ids->begin(), point3D_ids->end());
+  }
 
   // Average of the errors over the cameras, weighted by the number of
   // correspondences
@@ -34,6 +34,7 @@
 #include "colmap/optim/ransac.h"
 #include "colmap/scene/camera.h"
 #include "colmap/util/eigen_alignment.h"
+#include "colmap/util/types.h"
 
 #include <vector>
 
@@ -52,6 +53,10 @@ namespace colmap {
 // @param rig_from_world       Estimated rig from world pose.
 // @param num_inliers          Number of inliers in RANSAC.
 // @param inlier_mask          Inlier mask for 2D-3D correspondences.
+// @param point3D_ids          Optional identifiers of the 3D points, such that
+//                             every 3D point is counted once among the inliers.
+//                             If not given, the identical 3D points are found
+//                             by comparing their coordinates.
 //
 // @return                     Whether pose is estimated successfully.
 bool EstimateGeneralizedAbsolutePose(
@@ -63,7 +68,8 @@ bool EstimateGeneralizedAbsolutePose(
     const std::vector<Camera>& cameras,
     Rigid3d* rig_from_world,
     size_t* num_inliers,
-    std::vector<char>* inlier_mask);
+    std::vector<char>* inlier_mask,
+    const std::vector<point3D_t>* point3D_ids = nullptr);
 
 // Estimate generalized relative pose from 2D-2D correspondences.
 //
@@ -139,6 +139,39 @@ TEST(EstimateGeneralizedAbsolutePose, Nominal) {
       Rigid3dNear(problem.gt_rig_from_world, /*rtol=*/1e-6, /*ttol=*/1e-6));
 }
 
+TEST(EstimateGeneralizedAbsolutePose, WithPoint3DIds) {
+  SetPRNGSeed();
+
+  const GeneralizedAbsolutePoseProblem problem =
+      BuildGeneralizedAbsolutePoseProblem();
+  const std::vector<point3D_t> point3D_ids(problem.point3D_ids.begin(),
+                                           problem.point3D_ids.end());
+  const std::unordered_set<point3D_t> unique_point3D_ids(point3D_ids.begin(),
+                                                         point3D_ids.end());
+
+  RANSACOptions ransac_options;
+  ransac_options.max_error = 2;
+
+  Rigid3d rig_from_world;
+  size_t num_inliers;
+  std::vector<char> inlier_mask;
+  EXPECT_TRUE(EstimateGeneralizedAbsolutePose(ransac_options,
+                                              problem.points2D,
+                                              problem.points3D,
+                                              problem.camera_idxs,
+                                              problem.cams_from_rig,
+                                              problem.cameras,
+                                              &rig_from_world,
+                                              &num_inliers,
+                                              &inlier_mask,
+                                              &point3D_ids));
+  EXPECT_EQ(num_inliers, unique_point3D_ids.size());
+  EXPECT_EQ(inlier_mask, std::vector<char>(problem.points2D.size(), true));
+  EXPECT_THAT(
+      rig_from_world,
+      Rigid3dNear(problem.gt_rig_from_world, /*rtol=*/1e-6, /*ttol=*/1e-6));
+}
+
 TEST(RefineGeneralizedAbsolutePose, Nominal) {
   GeneralizedAbsolutePoseProblem problem =
       BuildGeneralizedAbsolutePoseProblem();
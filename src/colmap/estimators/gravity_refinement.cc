@@ -6,6 +6,8 @@
 #include "colmap/util/logging.h"
 #include "colmap/util/threading.h"
 
+#include <optional>
+
 namespace colmap {
 
 using GravityCostFunctor = NormalPriorCostFunctor<3>;
@@ -85,100 +87,133 @@ void GravityRefiner::RefineGravity(const PoseGraph& pose_graph,
 
   loss_function_ = options_.CreateLossFunction();
 
-  // Iterate through the error prone images
-  for (const frame_t frame_id : error_prone_frames) {
-    const std::unordered_set<image_pair_t>& neighbors =
-        adjacency_list_frames_to_pair_id.at(frame_id);
-    std::vector<Eigen::Vector3d> gravities;
-    gravities.reserve(neighbors.size());
-
-    ceres::Problem::Options problem_options;
-    problem_options.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
-    ceres::Problem problem(problem_options);
-    int counter = 0;
-    Eigen::Vector3d gravity = frame_to_pose_prior.at(frame_id)->gravity;
-    for (const auto& pair_id : neighbors) {
-      const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
-      const PoseGraph::Edge& edge =
-          pose_graph.EdgeRef(image_id1, image_id2).first;
-
-      Eigen::Vector3d* image_gravity1 =
-          GetImageGravityOrNull(image_to_pose_prior, image_id1);
-      Eigen::Vector3d* image_gravity2 =
-          GetImageGravityOrNull(image_to_pose_prior, image_id2);
-      if (image_gravity1 == nullptr || image_gravity2 == nullptr) {
-        continue;
-      }
-
-      const auto& image1 = reconstruction.Image(image_id1);
-      const auto& image2 = reconstruction.Image(image_id2);
+  // Refine the error prone frames in parallel. All frames are refined against
+  // the input gravities of their neighbors, and the accepted results are only
+  // written back once all frames are processed.
+  const std::vector<frame_t> frame_ids(error_prone_frames.begin(),
+                                       error_prone_frames.end());
+  std::vector<std::optional<Eigen::Vector3d>> refined_gravities(
+      frame_ids.size());
+  ThreadPool thread_pool(
+      GetEffectiveNumThreads(options_.solver_options.num_threads));
+  for (size_t i = 0; i < frame_ids.size(); ++i) {
+    thread_pool.AddTask([&, i]() {
+      const frame_t frame_id = frame_ids[i];
+      refined_gravities[i] =
+          RefineFrameGravity(pose_graph,
+                             reconstruction,
+                             frame_id,
+                             adjacency_list_frames_to_pair_id.at(frame_id),
+                             frame_to_pose_prior.at(frame_id)->gravity,
+                             image_to_pose_prior);
+    });
+  }
+  thread_pool.Wait();
 
-      // Get the cam_from_rig
-      Rigid3d cam1_from_rig1, cam2_from_rig2;
-      if (!image1.IsRefInFrame()) {
-        cam1_from_rig1 = image1.FramePtr()->RigPtr()->SensorFromRig(
-            sensor_t(SensorType::CAMERA, image1.CameraId()));
-      }
-      if (!image2.IsRefInFrame()) {
-        cam2_from_rig2 = image2.FramePtr()->RigPtr()->SensorFromRig(
-            sensor_t(SensorType::CAMERA, image2.CameraId()));
-      }
+  for (size_t i = 0; i < frame_ids.size(); ++i) {
+    if (refined_gravities[i].has_value()) {
+      counter_rect++;
+      frame_to_pose_prior.at(frame_ids[i])->gravity = *refined_gravities[i];
+    }
+  }
 
-      // Note: for the case where both cameras are from the same frames, we only
-      // consider a single cost term
-      if (image1.FrameId() == frame_id) {
-        gravities.emplace_back(Inverse(edge.cam2_from_cam1 * cam1_from_rig1)
-                                   .rotation()
-                                   .toRotationMatrix() *
-                               *image_gravity2);
-      } else if (image2.FrameId() == frame_id) {
-        gravities.emplace_back((Inverse(cam2_from_rig2) * edge.cam2_from_cam1)
-                                   .rotation()
-                                   .toRotationMatrix() *
-                               *image_gravity1);
-      }
+  LOG(INFO) << "Number of refined gravities: " << counter_rect << " / "
+            << error_prone_frames.size();
+}
 
-      problem.AddResidualBlock(GravityCostFunctor::Create(gravities[counter]),
-                               loss_function_.get(),
-                               gravity.data());
-      counter++;
-    }
+std::optional<Eigen::Vector3d> GravityRefiner::RefineFrameGravity(
+    const PoseGraph& pose_graph,
+    const Reconstruction& reconstruction,
+    frame_t frame_id,
+    const std::unordered_set<image_pair_t>& neighbors,
+    const Eigen::Vector3d& init_gravity,
+    const std::unordered_map<image_t, PosePrior*>& image_to_pose_prior) const {
+  std::vector<Eigen::Vector3d> gravities;
+  gravities.reserve(neighbors.size());
+
+  ceres::Problem::Options problem_options;
+  problem_options.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+  ceres::Problem problem(problem_options);
+  Eigen::Vector3d gravity = init_gravity;
+  for (const auto& pair_id : neighbors) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    const PoseGraph::Edge& edge =
+        pose_graph.EdgeRef(image_id1, image_id2).first;
 
-    if (gravities.size() < static_cast<size_t>(options_.min_num_neighbors)) {
+    const Eigen::Vector3d* image_gravity1 =
+        GetImageGravityOrNull(image_to_pose_prior, image_id1);
+    const Eigen::Vector3d* image_gravity2 =
+        GetImageGravityOrNull(image_to_pose_prior, image_id2);
+    if (image_gravity1 == nullptr || image_gravity2 == nullptr) {
       continue;
     }
 
-    // Initialize and set the manifold
-    gravity = AverageDirections(gravities);
-    SetManifold(&problem, gravity.data(), CreateSphereManifold<3>());
-
-    // Then, run refinment
-    ceres::Solver::Options solver_options = options_.solver_options;
-    solver_options.num_threads =
-        GetEffectiveNumThreads(solver_options.num_threads);
-    ceres::Solver::Summary summary_solver;
-    ceres::Solve(solver_options, &problem, &summary_solver);
-
-    // Check the error with respect to the neighbors
-    int counter_outlier = 0;
-    for (const Eigen::Vector3d& gravity : gravities) {
-      const double error = RadToDeg(
-          std::acos(std::max(std::min(gravity.dot(gravity), 1.), -1.)));
-      if (error > options_.max_gravity_error * 2) {
-        counter_outlier++;
-      }
+    const auto& image1 = reconstruction.Image(image_id1);
+    const auto& image2 = reconstruction.Image(image_id2);
+
+    // Get the cam_from_rig
+    Rigid3d cam1_from_rig1, cam2_from_rig2;
+    if (!image1.IsRefInFrame()) {
+      cam1_from_rig1 = image1.FramePtr()->RigPtr()->SensorFromRig(
+          sensor_t(SensorType::CAMERA, image1.CameraId()));
     }
-    // If the refined gravity now consistent with more images, then accept it
-    if (static_cast<double>(counter_outlier) /
-            static_cast<double>(gravities.size()) <
-        options_.max_outlier_ratio) {
-      counter_rect++;
-      frame_to_pose_prior.at(frame_id)->gravity = gravity;
+    if (!image2.IsRefInFrame()) {
+      cam2_from_rig2 = image2.FramePtr()->RigPtr()->SensorFromRig(
+          sensor_t(SensorType::CAMERA, image2.CameraId()));
+    }
+
+    // Note: for the case where both cameras are from the same frames, we only
+    // consider a single cost term
+    if (image1.FrameId() == frame_id) {
+      gravities.emplace_back(Inverse(edge.cam2_from_cam1 * cam1_from_rig1)
+                                 .rotation()
+                                 .toRotationMatrix() *
+                             *image_gravity2);
+    } else if (image2.FrameId() == frame_id) {
+      gravities.emplace_back((Inverse(cam2_from_rig2) * edge.cam2_from_cam1)
+                                 .rotation()
+                                 .toRotationMatrix() *
+                             *image_gravity1);
+    } else {
+      continue;
     }
+
+    problem.AddResidualBlock(GravityCostFunctor::Create(gravities.back()),
+                             loss_function_.get(),
+                             gravity.data());
   }
 
-  LOG(INFO) << "Number of refined gravities: " << counter_rect << " / "
-            << error_prone_frames.size();
+  if (gravities.size() < static_cast<size_t>(options_.min_num_neighbors)) {
+    return std::nullopt;
+  }
+
+  // Initialize and set the manifold
+  gravity = AverageDirections(gravities);
+  SetManifold(&problem, gravity.data(), CreateSphereManifold<3>());
+
+  // Then, run refinement. The frames are already refined in parallel, so
+  // each problem is solved on a single thread.
+  ceres::Solver::Options solver_options = options_.solver_options;
+  solver_options.num_threads = 1;
+  ceres::Solver::Summary summary_solver;
+  ceres::Solve(solver_options, &problem, &summary_solver);
+
+  // Check the error with respect to the neighbors
+  int counter_outlier = 0;
+  for (const Eigen::Vector3d& neighbor_gravity : gravities) {
+    const double error = RadToDeg(std::acos(
+        std::max(std::min(gravity.dot(neighbor_gravity), 1.), -1.)));
+    if (error > options_.max_gravity_error * 2) {
+      counter_outlier++;
+    }
+  }
+  // If the refined gravity now consistent with more images, then accept it
+  if (static_cast<double>(counter_outlier) /
+          static_cast<double>(gravities.size()) <
+      options_.max_outlier_ratio) {
+    return gravity;
+  }
+  return std::nullopt;
 }
 
 void GravityRefiner::IdentifyErrorProneGravity(
@@ -5,6 +5,8 @@
 #include "colmap/scene/pose_graph.h"
 #include "colmap/scene/reconstruction.h"
 
+#include <optional>
+
 #include <ceres/ceres.h>
 
 namespace colmap {
@@ -42,6 +44,17 @@ class GravityRefiner {
                      std::vector<PosePrior>& pose_priors);
 
  private:
+  // Refine the gravity of a single frame from the gravities of its neighbors
+  // in the pose graph. Returns std::nullopt if the frame has too few
+  // neighbors or the refined gravity is inconsistent with them.
+  std::optional<Eigen::Vector3d> RefineFrameGravity(
+      const PoseGraph& pose_graph,
+      const Reconstruction& reconstruction,
+      frame_t frame_id,
+      const std::unordered_set<image_pair_t>& neighbors,
+      const Eigen::Vector3d& init_gravity,
+      const std::unordered_map<image_t, PosePrior*>& image_to_pose_prior)
+      const;
   void IdentifyErrorProneGravity(
       const PoseGraph& pose_graph,
       const Reconstruction& reconstruction,
@@ -155,5 +155,50 @@ TEST(GravityRefinement, RefineGravityWithNonTrivialRigs) {
                      /*max_gravity_error_deg=*/1e-2);
 }
 
+TEST(GravityRefinement, RefineGravityIndependentOfNumThreads) {
+  SetPRNGSeed(1);
+
+  const auto database_path = CreateTestDir() / "database.db";
+
+  auto database = Database::Open(database_path);
+  Reconstruction gt_reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 25;
+  synthetic_dataset_options.num_points3D = 100;
+  synthetic_dataset_options.prior_gravity = true;
+  synthetic_dataset_options.two_view_geometry_has_relative_pose = true;
+  SynthesizeDataset(
+      synthetic_dataset_options, &gt_reconstruction, database.get());
+
+  Reconstruction reconstruction;
+  PoseGraph pose_graph;
+  LoadReconstructionAndPoseGraph(*database, &reconstruction, &pose_graph);
+
+  std::vector<PosePrior> pose_priors = database->ReadAllPosePriors();
+  SynthesizeGravityOutliers(pose_priors, /*outlier_ratio=*/0.3);
+
+  std::vector<PosePrior> pose_priors_single_thread = pose_priors;
+  GravityRefinerOptions opt_grav_refine;
+  opt_grav_refine.solver_options.num_threads = 1;
+  RunGravityRefinement(
+      opt_grav_refine, pose_graph, reconstruction, pose_priors_single_thread);
+
+  std::vector<PosePrior> pose_priors_multi_thread = pose_priors;
+  opt_grav_refine.solver_options.num_threads = 4;
+  RunGravityRefinement(
+      opt_grav_refine, pose_graph, reconstruction, pose_priors_multi_thread);
+
+  ASSERT_EQ(pose_priors_single_thread.size(), pose_priors_multi_thread.size());
+  for (size_t i = 0; i < pose_priors_single_thread.size(); ++i) {
+    if (!pose_priors_single_thread[i].HasGravity()) {
+      continue;
+    }
+    EXPECT_EQ(pose_priors_single_thread[i].gravity,
+              pose_priors_multi_thread[i].gravity);
+  }
+}
+
 }  // namespace
 }  // namespace colmap
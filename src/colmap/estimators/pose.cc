@@ -83,26 +83,40 @@ bool EstimateAbsolutePose(const AbsolutePoseEstimationOptions& options,
       return true;
     }
   } else {
+    std::vector<std::optional<Eigen::Vector3d>> cam_rays(points2D.size());
+    camera->CamRayFromImgBatch({points2D.data(), points2D.size()},
+                               {cam_rays.data(), cam_rays.size()});
     std::vector<P3PEstimator::X_t> points2D_with_rays(points2D.size());
     for (size_t i = 0; i < points2D.size(); ++i) {
       points2D_with_rays[i].image_point = points2D[i];
       points2D_with_rays[i].camera_ray =
-          camera->CamRayFromImg(points2D[i]).value_or(Eigen::Vector3d::Zero());
+          cam_rays[i].value_or(Eigen::Vector3d::Zero());
     }
 
     ImgFromCamFunc img_from_cam_func =
         std::bind(&Camera::ImgFromCam, camera, std::placeholders::_1);
-    LORANSAC<P3PEstimator, EPNPEstimator> ransac(
-        options.ransac_options,
-        P3PEstimator(img_from_cam_func),
-        EPNPEstimator(img_from_cam_func));
-    auto report = ransac.Estimate(points2D_with_rays, points3D);
-    if (report.success) {
+    auto estimate = [&](auto ransac) {
+      auto report = ransac.Estimate(points2D_with_rays, points3D);
+      if (!report.success) {
+        return false;
+      }
       *cam_from_world = Rigid3d(Eigen::Quaterniond(report.model.leftCols<3>()),
                                 report.model.col(3));
       *num_inliers = report.support.num_inliers;
       *inlier_mask = std::move(report.inlier_mask);
       return true;
+    };
+    if (options.use_marginalized_scoring) {
+      return estimate(
+          LORANSAC<P3PEstimator, EPNPEstimator, MarginalizedSupportMeasurer>(
+              options.ransac_options,
+              P3PEstimator(img_from_cam_func),
+              EPNPEstimator(img_from_cam_func)));
+    } else {
+      return estimate(LORANSAC<P3PEstimator, EPNPEstimator>(
+          options.ransac_options,
+          P3PEstimator(img_from_cam_func),
+          EPNPEstimator(img_from_cam_func)));
     }
   }
 
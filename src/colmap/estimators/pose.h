@@ -47,6 +47,11 @@ struct AbsolutePoseEstimationOptions {
   // Whether to estimate the focal length.
   bool estimate_focal_length = false;
 
+  // Whether to score P3P hypotheses by their loss marginalized over the noise
+  // scale (MAGSAC++) instead of their number of inliers. This is less
+  // sensitive to the choice of the maximum error.
+  bool use_marginalized_scoring = false;
+
   // Options used for P3P RANSAC.
   RANSACOptions ransac_options;
 
@@ -97,6 +97,29 @@ TEST(EstimateAbsolutePose, Nominal) {
   EXPECT_THAT(inlier_mask, testing::Each(testing::Eq(true)));
 }
 
+TEST(EstimateAbsolutePose, MarginalizedScoring) {
+  const AbsolutePoseProblem problem = CreateAbsolutePoseTestData();
+
+  AbsolutePoseEstimationOptions options;
+  options.use_marginalized_scoring = true;
+  Rigid3d cam_from_world;
+  size_t num_inliers = 0;
+  std::vector<char> inlier_mask;
+  Camera camera = problem.camera;
+  EXPECT_TRUE(EstimateAbsolutePose(options,
+                                   problem.points2D,
+                                   problem.points3D,
+                                   &cam_from_world,
+                                   &camera,
+                                   &num_inliers,
+                                   &inlier_mask));
+  EXPECT_THAT(
+      cam_from_world,
+      Rigid3dNear(problem.image.CamFromWorld(), /*rtol=*/1e-6, /*ttol=*/1e-6));
+  EXPECT_EQ(num_inliers, problem.points2D.size());
+  EXPECT_THAT(inlier_mask, testing::Each(testing::Eq(true)));
+}
+
 TEST(EstimateAbsolutePose, EstimateFocalLength) {
   const AbsolutePoseProblem problem = CreateAbsolutePoseTestData();
 
@@ -4,6 +4,7 @@
 #include "colmap/geometry/pose.h"
 #include "colmap/math/math.h"
 #include "colmap/math/spanning_tree.h"
+#include "colmap/util/threading.h"
 
 #include <algorithm>
 #include <queue>
@@ -598,12 +599,131 @@ bool InitializeRigRotationsFromImages(
   return true;
 }
 
+size_t FilterEdgesByCycleConsistency(PoseGraph& pose_graph,
+                                     double max_cycle_error_deg,
+                                     int num_threads) {
+  THROW_CHECK_GT(max_cycle_error_deg, 0);
+
+  // Index the images in order of their ids, such that the relative rotation
+  // of each edge maps from the image with the smaller to the larger index.
+  std::vector<image_pair_t> pair_ids;
+  std::vector<image_t> image_ids;
+  for (const auto& [pair_id, edge] : pose_graph.ValidEdges()) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    pair_ids.push_back(pair_id);
+    image_ids.push_back(image_id1);
+    image_ids.push_back(image_id2);
+  }
+  std::sort(pair_ids.begin(), pair_ids.end());
+  std::sort(image_ids.begin(), image_ids.end());
+  image_ids.erase(std::unique(image_ids.begin(), image_ids.end()),
+                  image_ids.end());
+  const auto image_idx = [&image_ids](image_t image_id) {
+    return static_cast<int>(
+        std::lower_bound(image_ids.begin(), image_ids.end(), image_id) -
+        image_ids.begin());
+  };
+
+  const size_t num_edges = pair_ids.size();
+  std::vector<std::pair<int, int>> edge_image_idxs(num_edges);
+  std::vector<Eigen::Quaterniond> edge_rotations(num_edges);
+  // Sorted (neighbor image index, edge index) pairs for each image.
+  std::vector<std::vector<std::pair<int, int>>> neighbors(image_ids.size());
+  for (size_t edge_idx = 0; edge_idx < num_edges; ++edge_idx) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_ids[edge_idx]);
+    const int idx1 = image_idx(image_id1);
+    const int idx2 = image_idx(image_id2);
+    edge_image_idxs[edge_idx] = {idx1, idx2};
+    edge_rotations[edge_idx] =
+        pose_graph.Edges().at(pair_ids[edge_idx]).cam2_from_cam1.rotation();
+    neighbors[idx1].emplace_back(idx2, static_cast<int>(edge_idx));
+    neighbors[idx2].emplace_back(idx1, static_cast<int>(edge_idx));
+  }
+  for (auto& image_neighbors : neighbors) {
+    std::sort(image_neighbors.begin(), image_neighbors.end());
+  }
+
+  // Returns the rotation from image src to image tgt along the given edge.
+  const auto tgt_from_src = [&](int edge_idx, int src_idx) {
+    return edge_image_idxs[edge_idx].first == src_idx
+               ? edge_rotations[edge_idx]
+               : edge_rotations[edge_idx].conjugate();
+  };
+
+  const double max_cycle_error_rad = DegToRad(max_cycle_error_deg);
+  std::vector<char> inconsistent(num_edges, false);
+  const auto check_edges = [&](size_t begin, size_t end) {
+    for (size_t edge_idx = begin; edge_idx < end; ++edge_idx) {
+      const auto [idx1, idx2] = edge_image_idxs[edge_idx];
+      const Eigen::Quaterniond& cam2_from_cam1 = edge_rotations[edge_idx];
+      const auto& neighbors1 = neighbors[idx1];
+      const auto& neighbors2 = neighbors[idx2];
+      bool has_triangle = false;
+      bool has_consistent_triangle = false;
+      // Intersect the sorted neighbor lists to find the triangles.
+      auto it1 = neighbors1.begin();
+      auto it2 = neighbors2.begin();
+      while (it1 != neighbors1.end() && it2 != neighbors2.end()) {
+        if (it1->first < it2->first) {
+          ++it1;
+        } else if (it2->first < it1->first) {
+          ++it2;
+        } else {
+          has_triangle = true;
+          const int idx3 = it1->first;
+          const Eigen::Quaterniond cam1_from_cam1 =
+              tgt_from_src(it1->second, idx3) *
+              tgt_from_src(it2->second, idx2) * cam2_from_cam1;
+          if (cam1_from_cam1.angularDistance(Eigen::Quaterniond::Identity()) <=
+              max_cycle_error_rad) {
+            has_consistent_triangle = true;
+            break;
+          }
+          ++it1;
+          ++it2;
+        }
+      }
+      inconsistent[edge_idx] = has_triangle && !has_consistent_triangle;
+    }
+  };
+
+  const int num_eff_threads = GetEffectiveNumThreads(num_threads);
+  const size_t chunk_size =
+      std::max<size_t>(1, num_edges / (4 * num_eff_threads) + 1);
+  ThreadPool thread_pool(num_eff_threads);
+  for (size_t begin = 0; begin < num_edges; begin += chunk_size) {
+    thread_pool.AddTask(
+        check_edges, begin, std::min(begin + chunk_size, num_edges));
+  }
+  thread_pool.Wait();
+
+  size_t num_invalid = 0;
+  for (size_t edge_idx = 0; edge_idx < num_edges; ++edge_idx) {
+    if (inconsistent[edge_idx]) {
+      pose_graph.SetInvalidEdge(pair_ids[edge_idx]);
+      ++num_invalid;
+    }
+  }
+
+  LOG(INFO) << "Marked " << num_invalid
+            << " image pairs as invalid with cycle error > "
+            << max_cycle_error_deg << " degrees";
+
+  return num_invalid;
+}
+
 bool RunRotationAveraging(const RotationEstimatorOptions& options,
                           PoseGraph& pose_graph,
                           Reconstruction& reconstruction,
                           const std::vector<PosePrior>& pose_priors) {
   std::unordered_set<image_t> active_image_ids;
 
+  // Step 0: Reject pairs with inconsistent relative rotations before solving.
+  if (options.max_cycle_error_deg > 0) {
+    FilterEdgesByCycleConsistency(
+        pose_graph, options.max_cycle_error_deg, options.num_threads);
+  }
+
   // Step 1: Solve rotation averaging on the largest connected component.
   if (!HasUnknownCamsFromRig(reconstruction)) {
     // All cam_from_rig are known, solve directly.
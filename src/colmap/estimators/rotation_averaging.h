@@ -1,8 +1,10 @@
 #pragma once
 
 #include "colmap/geometry/pose_prior.h"
+#include "colmap/optim/sparse_cholesky.h"
 #include "colmap/scene/pose_graph.h"
 #include "colmap/scene/reconstruction.h"
+#include "colmap/util/enum_utils.h"
 
 #include <unordered_set>
 #include <vector>
@@ -14,6 +16,15 @@
 // to the paper "Gravity Aligned Rotation Averaging"
 namespace colmap {
 
+// Linear solver for rotation averaging. SPARSE_CHOLESKY factorizes the normal
+// equations. CONJUGATE_GRADIENT uses Jacobi-preconditioned conjugate gradients,
+// which reuse the sparsity pattern of the constraints across iterations and
+// are faster for large view graphs, in which the factorization dominates.
+MAKE_ENUM_CLASS_OVERLOAD_STREAM(RotationAveragingLinearSolver,
+                                0,
+                                SPARSE_CHOLESKY,
+                                CONJUGATE_GRADIENT);
+
 struct RotationEstimatorOptions {
   // PRNG seed for stochastic methods during rotation averaging.
   // If -1 (default), the seed is derived from the current time
@@ -48,6 +59,18 @@ struct RotationEstimatorOptions {
   // such systems. Zero disables regularization (no computational overhead).
   double ridge_regularization = 1e-9;
 
+  // Linear solver for the normal equations in the L1 and IRLS phases.
+  RotationAveragingLinearSolver linear_solver =
+      RotationAveragingLinearSolver::SPARSE_CHOLESKY;
+
+  // Backend and ordering of the SPARSE_CHOLESKY linear solver.
+  SparseCholeskyOptions sparse_cholesky;
+
+  // Maximum number of iterations and relative residual tolerance of each
+  // conjugate gradient solve.
+  int max_num_cg_iterations = 500;
+  double cg_tolerance = 1e-10;
+
   enum WeightType {
     // Geman-McClure weight from "Efficient and robust large-scale rotation
     // averaging" (Chatterjee et al., 2013)
@@ -76,6 +99,14 @@ struct RotationEstimatorOptions {
   // after solving, then recompute active set.
   double max_rotation_error_deg = 10.0;
 
+  // If > 0, filter image pairs before solving whose relative rotation is
+  // inconsistent with all the triangles of the pose graph it is part of, i.e.,
+  // the rotation error around each triangle exceeds this threshold.
+  double max_cycle_error_deg = 0.0;
+
+  // Number of threads for the cycle consistency filter.
+  int num_threads = -1;
+
   // When false, treat each non-ref sensor's cam_from_rig rotation as a
   // pre-calibrated constant
   bool refine_sensor_from_rig = true;
@@ -134,6 +165,15 @@ bool InitializeRigRotationsFromImages(
     Reconstruction& reconstruction,
     bool refine_sensor_from_rig = true);
 
+// Invalidate image pairs whose relative rotation is inconsistent with all the
+// triangles of the pose graph it is part of. The cycle error of a triangle is
+// the rotation angle of the chained relative rotations around it. Pairs that
+// are not part of any triangle cannot be verified and are kept. The pairs are
+// checked independently in parallel. Returns the number of invalidated pairs.
+size_t FilterEdgesByCycleConsistency(PoseGraph& pose_graph,
+                                     double max_cycle_error_deg,
+                                     int num_threads = -1);
+
 // High-level rotation averaging solver that handles rig expansion.
 // For cameras with unknown cam_from_rig, first estimates their orientations
 // independently using an expanded reconstruction, then initializes the
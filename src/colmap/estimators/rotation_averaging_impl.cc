@@ -3,6 +3,7 @@
 #include "colmap/geometry/pose.h"
 #include "colmap/math/math.h"
 #include "colmap/math/random.h"
+#include "colmap/optim/conjugate_gradient.h"
 #include "colmap/optim/least_absolute_deviations.h"
 #include "colmap/optim/sparse_cholesky.h"
 
@@ -36,7 +37,7 @@ double ComputeGravityAligned1DOFResidual(double angle_12,
 }
 
 std::unordered_map<frame_t, const PosePrior*> ExtractFrameToPosePrior(
-    const std::unordered_map<image_t, Image>& images,
+    const DenseIdMap<image_t, Image>& images,
     const std::vector<PosePrior>& pose_priors) {
   std::unordered_map<image_t, frame_t> image_to_frame;
   image_to_frame.reserve(images.size());
@@ -656,8 +657,17 @@ bool RotationAveragingSolver::SolveL1Regression(
     RotationAveragingProblem& problem) {
   LeastAbsoluteDeviationSolver::Options l1_solver_options;
   l1_solver_options.max_num_iterations = 10;
-  l1_solver_options.solver_type =
-      LeastAbsoluteDeviationSolver::Options::SolverType::SupernodalCholmodLLT;
+  if (options_.linear_solver ==
+      RotationAveragingLinearSolver::CONJUGATE_GRADIENT) {
+    l1_solver_options.solver_type =
+        LeastAbsoluteDeviationSolver::Options::SolverType::ConjugateGradient;
+    l1_solver_options.cg_max_num_iterations = options_.max_num_cg_iterations;
+    l1_solver_options.cg_tolerance = options_.cg_tolerance;
+  } else {
+    l1_solver_options.solver_type =
+        LeastAbsoluteDeviationSolver::Options::SolverType::SupernodalCholmodLLT;
+    l1_solver_options.sparse_cholesky = options_.sparse_cholesky;
+  }
   l1_solver_options.ridge_regularization = options_.ridge_regularization;
 
   LeastAbsoluteDeviationSolver l1_solver(l1_solver_options,
@@ -772,8 +782,61 @@ std::optional<Eigen::VectorXd> RotationAveragingSolver::ComputeIRLSWeights(
   return weights;
 }
 
+bool RotationAveragingSolver::SolveIRLSConjugateGradient(
+    RotationAveragingProblem& problem) {
+  NormalEquationsCGSolver::Options cg_options;
+  cg_options.max_num_iterations = options_.max_num_cg_iterations;
+  cg_options.tolerance = options_.cg_tolerance;
+  cg_options.ridge_regularization = options_.ridge_regularization;
+  NormalEquationsCGSolver solver(cg_options, problem.ConstraintMatrix());
+
+  const double sigma = DegToRad(options_.irls_loss_parameter_sigma);
+
+  Eigen::VectorXd step(problem.NumParameters());
+
+  int iteration = 0;
+  for (iteration = 0; iteration < options_.max_num_irls_iterations;
+       iteration++) {
+    problem.ComputeResiduals();
+
+    auto weights_irls = ComputeIRLSWeights(problem, sigma);
+    if (!weights_irls) {
+      return false;
+    }
+    solver.SetWeights(*weights_irls);
+
+    // The step is relative to the current estimate, which is initialized from
+    // the maximum spanning tree, so a zero step warm-starts from it.
+    step.setZero();
+    if (!solver.Solve(problem.ConstraintMatrix().transpose() *
+                          weights_irls->cwiseProduct(problem.Residuals()),
+                      &step)) {
+      LOG(ERROR) << "IRLS solve failed (iteration " << iteration << ")";
+      return false;
+    }
+    problem.UpdateState(step);
+
+    const double avg_step = problem.AverageStepSize(step);
+    VLOG(2) << "IRLS iteration " << iteration << ", average step: " << avg_step
+            << ", CG iterations: " << solver.NumIterations();
+
+    if (avg_step < options_.irls_step_convergence_threshold) {
+      iteration++;
+      break;
+    }
+  }
+  VLOG(2) << "IRLS total iteration: " << iteration;
+
+  return true;
+}
+
 bool RotationAveragingSolver::SolveIRLS(RotationAveragingProblem& problem) {
-  SparseCholeskyWithFallbackSolver solver;
+  if (options_.linear_solver ==
+      RotationAveragingLinearSolver::CONJUGATE_GRADIENT) {
+    return SolveIRLSConjugateGradient(problem);
+  }
+
+  SparseCholeskyWithFallbackSolver solver(options_.sparse_cholesky);
   bool pattern_analyzed = false;
 
   const double sigma = DegToRad(options_.irls_loss_parameter_sigma);
@@ -133,6 +133,9 @@ class RotationAveragingSolver {
   // Iteratively reweighted least squares phase.
   bool SolveIRLS(RotationAveragingProblem& problem);
 
+  // Iteratively reweighted least squares phase with conjugate gradients.
+  bool SolveIRLSConjugateGradient(RotationAveragingProblem& problem);
+
   // Computes IRLS weights for all constraints.
   // Returns nullopt if any weight is NaN.
   std::optional<Eigen::VectorXd> ComputeIRLSWeights(
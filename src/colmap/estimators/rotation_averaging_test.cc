@@ -252,6 +252,50 @@ TEST(RotationAveraging, WithNoiseAndOutliersWithNonTrivialKnownRigs) {
                                 /*max_rotation_error_deg=*/2.);
 }
 
+TEST(RotationAveraging, ConjugateGradient) {
+  SetPRNGSeed(1);
+
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 7;
+  synthetic_dataset_options.num_points3D = 100;
+  synthetic_dataset_options.inlier_match_ratio = 0.6;
+  synthetic_dataset_options.prior_gravity = true;
+  synthetic_dataset_options.two_view_geometry_has_relative_pose = true;
+  SyntheticNoiseOptions synthetic_noise_options;
+  synthetic_noise_options.point2D_stddev = 1;
+  synthetic_noise_options.prior_gravity_stddev = 3e-1;
+  auto data =
+      CreateTestData(synthetic_dataset_options, &synthetic_noise_options);
+
+  for (const bool use_gravity : {true, false}) {
+    RotationEstimatorOptions options = CreateRATestOptions(use_gravity);
+    options.random_seed = 42;
+
+    Reconstruction cholesky_reconstruction = data.reconstruction;
+    PoseGraph cholesky_pose_graph = data.pose_graph;
+    options.linear_solver = RotationAveragingLinearSolver::SPARSE_CHOLESKY;
+    ASSERT_TRUE(RunRotationAveraging(options,
+                                     cholesky_pose_graph,
+                                     cholesky_reconstruction,
+                                     data.pose_priors));
+
+    Reconstruction cg_reconstruction = data.reconstruction;
+    PoseGraph cg_pose_graph = data.pose_graph;
+    options.linear_solver = RotationAveragingLinearSolver::CONJUGATE_GRADIENT;
+    ASSERT_TRUE(RunRotationAveraging(
+        options, cg_pose_graph, cg_reconstruction, data.pose_priors));
+
+    ExpectEqualRotations(data.gt_reconstruction,
+                         cg_reconstruction,
+                         /*max_rotation_error_deg=*/3);
+    ExpectEqualRotations(cholesky_reconstruction,
+                         cg_reconstruction,
+                         /*max_rotation_error_deg=*/1e-2);
+  }
+}
+
 TEST(RotationAveraging, DeterministicRandomSeed) {
   SetPRNGSeed(1);
 
@@ -586,5 +630,52 @@ TEST(RotationAveraging, RefineSensorFromRigFalsePreservesRig) {
   }
 }
 
+TEST(RotationAveraging, FilterEdgesByCycleConsistency) {
+  // Four cameras with random orientations and a complete pose graph, plus a
+  // fifth camera that is only connected by a single edge.
+  std::vector<Eigen::Quaterniond> cams_from_world;
+  for (int i = 0; i < 5; ++i) {
+    cams_from_world.push_back(Eigen::Quaterniond::UnitRandom());
+  }
+  PoseGraph pose_graph;
+  const auto add_edge = [&](image_t image_id1, image_t image_id2) {
+    PoseGraph::Edge edge;
+    edge.cam2_from_cam1 =
+        Rigid3d(cams_from_world[image_id2 - 1] *
+                    cams_from_world[image_id1 - 1].inverse(),
+                Eigen::Vector3d::Zero());
+    pose_graph.AddEdge(image_id1, image_id2, edge);
+  };
+  for (image_t image_id1 = 1; image_id1 <= 4; ++image_id1) {
+    for (image_t image_id2 = image_id1 + 1; image_id2 <= 4; ++image_id2) {
+      add_edge(image_id1, image_id2);
+    }
+  }
+  add_edge(4, 5);
+
+  // Corrupt the rotations of two edges.
+  const Eigen::Quaterniond outlier_rotation(
+      Eigen::AngleAxisd(DegToRad(20), Eigen::Vector3d::UnitX()));
+  for (const image_pair_t pair_id :
+       {ImagePairToPairId(1, 2), ImagePairToPairId(4, 5)}) {
+    Rigid3d& cam2_from_cam1 = pose_graph.Edges().at(pair_id).cam2_from_cam1;
+    cam2_from_cam1.rotation() = outlier_rotation * cam2_from_cam1.rotation();
+  }
+
+  EXPECT_EQ(FilterEdgesByCycleConsistency(pose_graph,
+                                          /*max_cycle_error_deg=*/5,
+                                          /*num_threads=*/2),
+            1);
+  EXPECT_FALSE(pose_graph.IsValid(ImagePairToPairId(1, 2)));
+  // The edge without triangles cannot be verified and is kept.
+  EXPECT_TRUE(pose_graph.IsValid(ImagePairToPairId(4, 5)));
+  EXPECT_EQ(pose_graph.NumEdges(), 7);
+  int num_valid_edges = 0;
+  for (const auto& [pair_id, edge] : pose_graph.ValidEdges()) {
+    ++num_valid_edges;
+  }
+  EXPECT_EQ(num_valid_edges, 6);
+}
+
 }  // namespace
 }  // namespace colmap
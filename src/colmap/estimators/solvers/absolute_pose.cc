@@ -50,12 +50,14 @@ void P3PEstimator::Estimate(const std::vector<X_t>& points2D,
 
   cams_from_world->clear();
 
-  std::vector<Eigen::Vector3d> rays(3);
+  // Thread-local buffers to avoid heap allocations in the inner RANSAC loop.
+  thread_local std::vector<Eigen::Vector3d> rays(3);
+  thread_local std::vector<poselib::CameraPose> poses;
   for (int i = 0; i < 3; ++i) {
     rays[i] = points2D[i].camera_ray;
   }
 
-  std::vector<poselib::CameraPose> poses;
+  poses.clear();
   const int num_poses = poselib::p3p(rays, points3D, &poses);
 
   cams_from_world->resize(num_poses);
@@ -84,9 +86,13 @@ void P4PFEstimator::Estimate(const std::vector<X_t>& points2D,
 
   models->clear();
 
-  std::vector<poselib::CameraPose> poses;
-  std::vector<double> focals_x;
-  std::vector<double> focals_y;
+  // Thread-local buffers to avoid heap allocations in the inner RANSAC loop.
+  thread_local std::vector<poselib::CameraPose> poses;
+  thread_local std::vector<double> focals_x;
+  thread_local std::vector<double> focals_y;
+  poses.clear();
+  focals_x.clear();
+  focals_y.clear();
   int num_poses;
   if (share_focal_length_) {
     // Estimate a single shared focal length. filter_solutions additionally
@@ -107,30 +107,51 @@ void EssentialMatrixFivePointEstimator::Estimate(
     return;
   }
 
-  const int num_roots = roots_real.size();
-  models->reserve(num_roots);
-
-  for (int i = 0; i < num_roots; ++i) {
-    const double kMaxRootImag = 1e-10;
-    if (std::abs(roots_imag(i)) > kMaxRootImag) {
-      continue;
+  // Step 5: Back-substitution of the real roots into the polynomial matrix B.
+  //         All roots are substituted at once, which vectorizes the
+  //         evaluation of the polynomials over the roots.
+
+  const double kMaxRootImag = 1e-10;
+  Eigen::ArrayXd z(roots_real.size());
+  int num_real_roots = 0;
+  for (Eigen::Index i = 0; i < roots_real.size(); ++i) {
+    if (std::abs(roots_imag(i)) <= kMaxRootImag) {
+      z(num_real_roots++) = roots_real(i);
     }
+  }
+  z.conservativeResize(num_real_roots);
+
+  Eigen::Array<double, Eigen::Dynamic, 9> Bz(num_real_roots, 9);
+  for (int j = 0; j < 3; ++j) {
+    Bz.col(3 * j) = EvaluatePolynomialBatch(B.block<4, 1>(0, j), z);
+    Bz.col(3 * j + 1) = EvaluatePolynomialBatch(B.block<4, 1>(4, j), z);
+    Bz.col(3 * j + 2) = EvaluatePolynomialBatch(B.block<5, 1>(8, j), z);
+  }
 
-    const double z1 = roots_real(i);
-    const double z2 = z1 * z1;
-    const double z3 = z2 * z1;
-    const double z4 = z3 * z1;
-
-    Eigen::Matrix3d Bz;
-    for (int j = 0; j < 3; ++j) {
-      Bz(j, 0) = B(0, j) * z3 + B(1, j) * z2 + B(2, j) * z1 + B(3, j);
-      Bz(j, 1) = B(4, j) * z3 + B(5, j) * z2 + B(6, j) * z1 + B(7, j);
-      Bz(j, 2) = B(8, j) * z4 + B(9, j) * z3 + B(10, j) * z2 + B(11, j) * z1 +
-                 B(12, j);
+  models->reserve(num_real_roots);
+
+  for (int i = 0; i < num_real_roots; ++i) {
+    // The rank-2 matrix Bz has the null vector X, which is orthogonal to all
+    // of its rows. Take the most stable cross product of two of its rows
+    // instead of a full SVD.
+    const Eigen::Vector3d row0 = Bz.block<1, 3>(i, 0).transpose();
+    const Eigen::Vector3d row1 = Bz.block<1, 3>(i, 3).transpose();
+    const Eigen::Vector3d row2 = Bz.block<1, 3>(i, 6).transpose();
+    Eigen::Vector3d X = row0.cross(row1);
+    const Eigen::Vector3d X02 = row0.cross(row2);
+    const Eigen::Vector3d X12 = row1.cross(row2);
+    if (X02.squaredNorm() > X.squaredNorm()) {
+      X = X02;
+    }
+    if (X12.squaredNorm() > X.squaredNorm()) {
+      X = X12;
     }
 
-    const Eigen::JacobiSVD<Eigen::Matrix3d> svd(Bz, Eigen::ComputeFullV);
-    const Eigen::Vector3d X = svd.matrixV().rightCols<1>();
+    const double X_norm = X.norm();
+    if (X_norm == 0) {
+      continue;
+    }
+    X /= X_norm;
 
     const double kMaxX3 = 1e-10;
     if (std::abs(X(2)) < kMaxX3) {
@@ -138,8 +159,8 @@ void EssentialMatrixFivePointEstimator::Estimate(
     }
 
     const Eigen::Matrix<double, 9, 1> e =
-        (E.col(0) * (X(0) / X(2)) + E.col(1) * (X(1) / X(2)) + E.col(2) * z1 +
-         E.col(3))
+        (E.col(0) * (X(0) / X(2)) + E.col(1) * (X(1) / X(2)) +
+         E.col(2) * z(i) + E.col(3))
             .normalized();
 
     models->push_back(
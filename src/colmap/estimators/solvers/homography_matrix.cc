@@ -37,6 +37,27 @@
 #include <Eigen/SVD>
 
 namespace colmap {
+namespace {
+
+template <typename MatrixType>
+void SetupConstraintMatrix(
+    const std::vector<HomographyMatrixEstimator::X_t>& points1,
+    const std::vector<HomographyMatrixEstimator::Y_t>& points2,
+    MatrixType* A) {
+  for (size_t i = 0; i < points1.size(); ++i) {
+    A->template block<1, 3>(2 * i, 0) = points1[i].transpose().homogeneous();
+    A->template block<1, 3>(2 * i, 3).setZero();
+    A->template block<1, 3>(2 * i, 6) =
+        -points2[i].x() * points1[i].transpose().homogeneous();
+    A->template block<1, 3>(2 * i + 1, 0).setZero();
+    A->template block<1, 3>(2 * i + 1, 3) =
+        points1[i].transpose().homogeneous();
+    A->template block<1, 3>(2 * i + 1, 6) =
+        -points2[i].y() * points1[i].transpose().homogeneous();
+  }
+}
+
+}  // namespace
 
 void HomographyMatrixEstimator::Estimate(const std::vector<X_t>& points1,
                                          const std::vector<Y_t>& points2,
@@ -49,21 +70,12 @@ void HomographyMatrixEstimator::Estimate(const std::vector<X_t>& points1,
 
   const size_t num_points = points1.size();
 
-  // Setup constraint matrix.
-  Eigen::Matrix<double, Eigen::Dynamic, 9> A(2 * num_points, 9);
-  for (size_t i = 0; i < num_points; ++i) {
-    A.block<1, 3>(2 * i, 0) = points1[i].transpose().homogeneous();
-    A.block<1, 3>(2 * i, 3).setZero();
-    A.block<1, 3>(2 * i, 6) =
-        -points2[i].x() * points1[i].transpose().homogeneous();
-    A.block<1, 3>(2 * i + 1, 0).setZero();
-    A.block<1, 3>(2 * i + 1, 3) = points1[i].transpose().homogeneous();
-    A.block<1, 3>(2 * i + 1, 6) =
-        -points2[i].y() * points1[i].transpose().homogeneous();
-  }
-
   Eigen::Matrix3d H;
   if (num_points == 4) {
+    // Fixed-size system for the minimal case, which avoids heap allocations
+    // in the inner RANSAC loop.
+    Eigen::Matrix<double, 8, 9> A;
+    SetupConstraintMatrix(points1, points2, &A);
     const Eigen::Matrix<double, 9, 1> h = A.block<8, 8>(0, 0)
                                               .partialPivLu()
                                               .solve(-A.block<8, 1>(0, 8))
@@ -73,13 +85,15 @@ void HomographyMatrixEstimator::Estimate(const std::vector<X_t>& points1,
     }
     H = Eigen::Map<const Eigen::Matrix3d>(h.data()).transpose();
   } else {
+    Eigen::Matrix<double, Eigen::Dynamic, 9> A(2 * num_points, 9);
+    SetupConstraintMatrix(points1, points2, &A);
     // Solve for the nullspace of the constraint matrix.
     Eigen::JacobiSVD<Eigen::Matrix<double, Eigen::Dynamic, 9>> svd(
         A, Eigen::ComputeFullV);
     if (svd.rank() < 8) {
       return;
     }
-    const Eigen::VectorXd nullspace = svd.matrixV().col(8);
+    const Eigen::Matrix<double, 9, 1> nullspace = svd.matrixV().col(8);
     H = Eigen::Map<const Eigen::Matrix3d>(nullspace.data()).transpose();
   }
 
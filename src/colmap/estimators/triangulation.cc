@@ -35,6 +35,7 @@
 #include "colmap/scene/projection.h"
 #include "colmap/util/eigen_alignment.h"
 #include "colmap/util/logging.h"
+#include "colmap/util/threading.h"
 
 #include <algorithm>
 
@@ -151,6 +152,62 @@ void TriangulationEstimator::Residuals(const std::vector<X_t>& point_data,
   }
 }
 
+namespace {
+
+// Robustly estimate the 3D point from the prepared observations of a track.
+// The two-view case has a single minimal sample and no local optimization in
+// LORANSAC, so its result is computed directly without the RANSAC overhead.
+bool EstimateTriangulationImpl(
+    const EstimateTriangulationOptions& options,
+    const std::vector<TriangulationEstimator::PointData>& point_data,
+    const std::vector<TriangulationEstimator::PoseData>& pose_data,
+    std::vector<Eigen::Vector3d>* models,
+    std::vector<double>* residuals,
+    std::vector<char>* inlier_mask,
+    Eigen::Vector3d* xyz) {
+  const TriangulationEstimator estimator(options.min_tri_angle,
+                                         options.residual_type);
+
+  if (point_data.size() == TriangulationEstimator::kMinNumSamples) {
+    if (options.ransac_options.max_num_trials == 0) {
+      return false;
+    }
+    estimator.Estimate(point_data, pose_data, models);
+    if (models->empty()) {
+      return false;
+    }
+    estimator.Residuals(point_data, pose_data, (*models)[0], residuals);
+    const double max_residual =
+        options.ransac_options.max_error * options.ransac_options.max_error;
+    for (const double residual : *residuals) {
+      if (!(residual <= max_residual)) {
+        return false;
+      }
+    }
+    inlier_mask->assign(residuals->size(), true);
+    *xyz = (*models)[0];
+    return true;
+  }
+
+  // Robustly estimate track using LORANSAC.
+  LORANSAC<TriangulationEstimator,
+           TriangulationEstimator,
+           InlierSupportMeasurer,
+           CombinationSampler>
+      ransac(options.ransac_options, estimator, estimator);
+  auto report = ransac.Estimate(point_data, pose_data);
+  if (!report.success) {
+    return false;
+  }
+
+  *inlier_mask = std::move(report.inlier_mask);
+  *xyz = report.model;
+
+  return report.success;
+}
+
+}  // namespace
+
 bool EstimateTriangulation(const EstimateTriangulationOptions& options,
                            const std::vector<Eigen::Vector2d>& points,
                            const std::vector<Rigid3d>& cams_from_world,
@@ -183,24 +240,100 @@ bool EstimateTriangulation(const EstimateTriangulationOptions& options,
     pose_data[i].camera = cameras[i];
   }
 
-  // Robustly estimate track using LORANSAC.
-  LORANSAC<TriangulationEstimator,
-           TriangulationEstimator,
-           InlierSupportMeasurer,
-           CombinationSampler>
-      ransac(
-          options.ransac_options,
-          TriangulationEstimator(options.min_tri_angle, options.residual_type),
-          TriangulationEstimator(options.min_tri_angle, options.residual_type));
-  auto report = ransac.Estimate(point_data, pose_data);
-  if (!report.success) {
-    return false;
+  std::vector<Eigen::Vector3d> models;
+  std::vector<double> residuals;
+  return EstimateTriangulationImpl(
+      options, point_data, pose_data, &models, &residuals, inlier_mask, xyz);
+}
+
+void TriangulationBatch::AddObservation(const uint32_t image_idx,
+                                        const Eigen::Vector2d& point) {
+  points.push_back(point);
+  image_idxs.push_back(image_idx);
+}
+
+void TriangulationBatch::FinishTrack() {
+  track_offsets.push_back(points.size());
+}
+
+void TriangulationBatch::ClearTracks() {
+  points.clear();
+  image_idxs.clear();
+  track_offsets.assign(1, 0);
+}
+
+void EstimateTriangulationBatch(const EstimateTriangulationOptions& options,
+                                const TriangulationBatch& batch,
+                                std::vector<char>* success,
+                                std::vector<Eigen::Vector3d>* xyzs,
+                                std::vector<char>* inlier_masks,
+                                const int num_threads) {
+  THROW_CHECK_NOTNULL(success);
+  THROW_CHECK_NOTNULL(xyzs);
+  THROW_CHECK_NOTNULL(inlier_masks);
+  THROW_CHECK_EQ(batch.cams_from_world.size(), batch.cameras.size());
+  THROW_CHECK_EQ(batch.points.size(), batch.image_idxs.size());
+  THROW_CHECK(!batch.track_offsets.empty());
+  THROW_CHECK_EQ(batch.track_offsets.back(), batch.points.size());
+  options.Check();
+
+  const size_t num_images = batch.cams_from_world.size();
+  const size_t num_tracks = batch.NumTracks();
+
+  std::vector<TriangulationEstimator::PoseData> image_pose_data(num_images);
+  for (size_t image_idx = 0; image_idx < num_images; ++image_idx) {
+    TriangulationEstimator::PoseData& pose_data = image_pose_data[image_idx];
+    pose_data.cam_from_world = batch.cams_from_world[image_idx].ToMatrix();
+    pose_data.proj_center = batch.cams_from_world[image_idx].TgtOriginInSrc();
+    pose_data.camera = THROW_CHECK_NOTNULL(batch.cameras[image_idx]);
   }
 
-  *inlier_mask = std::move(report.inlier_mask);
-  *xyz = report.model;
+  success->assign(num_tracks, false);
+  xyzs->assign(num_tracks, Eigen::Vector3d::Zero());
+  inlier_masks->assign(batch.NumObservations(), false);
 
-  return report.success;
+  ParallelFor(
+      0,
+      num_tracks,
+      [&](const int64_t begin, const int64_t end) {
+        // Working buffers shared by all tracks of the chunk.
+        std::vector<TriangulationEstimator::PointData> point_data;
+        std::vector<TriangulationEstimator::PoseData> pose_data;
+        std::vector<Eigen::Vector3d> models;
+        std::vector<double> residuals;
+        std::vector<char> inlier_mask;
+        for (int64_t track_idx = begin; track_idx < end; ++track_idx) {
+          const size_t track_begin = batch.track_offsets[track_idx];
+          const size_t track_end = batch.track_offsets[track_idx + 1];
+          THROW_CHECK_GE(track_end - track_begin, 2);
+          point_data.resize(track_end - track_begin);
+          pose_data.resize(track_end - track_begin);
+          for (size_t i = track_begin; i < track_end; ++i) {
+            const uint32_t image_idx = batch.image_idxs[i];
+            THROW_CHECK_LT(image_idx, num_images);
+            pose_data[i - track_begin] = image_pose_data[image_idx];
+            point_data[i - track_begin].img_point = batch.points[i];
+            point_data[i - track_begin].cam_ray =
+                pose_data[i - track_begin]
+                    .camera->CamRayFromImg(batch.points[i])
+                    .value_or(Eigen::Vector3d::UnitZ());
+          }
+
+          if (EstimateTriangulationImpl(options,
+                                        point_data,
+                                        pose_data,
+                                        &models,
+                                        &residuals,
+                                        &inlier_mask,
+                                        &(*xyzs)[track_idx])) {
+            (*success)[track_idx] = true;
+            std::copy(inlier_mask.begin(),
+                      inlier_mask.end(),
+                      inlier_masks->begin() + track_begin);
+          }
+        }
+      },
+      num_threads);
 }
 
 }  // namespace colmap
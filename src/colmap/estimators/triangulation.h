@@ -155,4 +155,47 @@ bool EstimateTriangulation(const EstimateTriangulationOptions& options,
                            std::vector<char>* inlier_mask,
                            Eigen::Vector3d* xyz);
 
+// Observations of many independent tracks in a flattened structure-of-arrays
+// layout. The poses and cameras are stored once per image and referenced by
+// the observations through their index. The observations of the i-th track are
+// in the range [track_offsets[i], track_offsets[i + 1]).
+struct TriangulationBatch {
+  // Per-image data.
+  std::vector<Rigid3d> cams_from_world;
+  std::vector<Camera const*> cameras;
+
+  // Per-observation data.
+  std::vector<Eigen::Vector2d> points;
+  std::vector<uint32_t> image_idxs;
+
+  // Offsets of the tracks into the per-observation data.
+  std::vector<size_t> track_offsets = {0};
+
+  size_t NumTracks() const { return track_offsets.size() - 1; }
+  size_t NumObservations() const { return points.size(); }
+
+  // Add an observation of the given image to the current track.
+  void AddObservation(uint32_t image_idx, const Eigen::Vector2d& point);
+
+  // Finish the current track, such that subsequent observations are added to
+  // a new track.
+  void FinishTrack();
+
+  // Remove all tracks while keeping the images.
+  void ClearTracks();
+};
+
+// Batched version of EstimateTriangulation, which triangulates all tracks of
+// the batch concurrently using at most num_threads threads. The poses are only
+// converted once per image and no memory is allocated per track. The results
+// are identical to calling EstimateTriangulation for every track, where the
+// success flag and the point are stored per track and the inlier mask per
+// observation.
+void EstimateTriangulationBatch(const EstimateTriangulationOptions& options,
+                                const TriangulationBatch& batch,
+                                std::vector<char>* success,
+                                std::vector<Eigen::Vector3d>* xyzs,
+                                std::vector<char>* inlier_masks,
+                                int num_threads = -1);
+
 }  // namespace colmap
@@ -0,0 +1,186 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/estimators/triangulation.h"
+
+#include "colmap/scene/synthetic.h"
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+struct TriangulationProblem {
+  Reconstruction reconstruction;
+  TriangulationBatch batch;
+  std::vector<image_t> image_ids;
+};
+
+// Create a batch with the full track of every 3D point and the two-view track
+// of its first two observations. The second observation of every third full
+// track is corrupted.
+TriangulationProblem CreateTriangulationTestData() {
+  TriangulationProblem problem;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 5;
+  synthetic_dataset_options.num_points3D = 100;
+  SynthesizeDataset(synthetic_dataset_options, &problem.reconstruction);
+
+  std::unordered_map<image_t, uint32_t> image_id_to_idx;
+  for (const image_t image_id : problem.reconstruction.RegImageIds()) {
+    const Image& image = problem.reconstruction.Image(image_id);
+    image_id_to_idx.emplace(image_id, problem.image_ids.size());
+    problem.image_ids.push_back(image_id);
+    problem.batch.cams_from_world.push_back(image.CamFromWorld());
+    problem.batch.cameras.push_back(image.CameraPtr());
+  }
+
+  for (const auto& [point3D_id, point3D] : problem.reconstruction.Points3D()) {
+    const size_t track_idx = problem.batch.NumTracks();
+    for (const auto& track_el : point3D.track.Elements()) {
+      Eigen::Vector2d point = problem.reconstruction.Image(track_el.image_id)
+                                  .Point2D(track_el.point2D_idx)
+                                  .xy;
+      if (track_idx % 6 == 0 &&
+          problem.batch.NumObservations() ==
+              problem.batch.track_offsets.back() + 1) {
+        point += Eigen::Vector2d(100, 100);
+      }
+      problem.batch.AddObservation(image_id_to_idx.at(track_el.image_id),
+                                   point);
+    }
+    problem.batch.FinishTrack();
+    for (int i = 0; i < 2; ++i) {
+      const size_t obs_idx = problem.batch.track_offsets[track_idx] + i;
+      problem.batch.AddObservation(problem.batch.image_idxs[obs_idx],
+                                   problem.batch.points[obs_idx]);
+    }
+    problem.batch.FinishTrack();
+  }
+
+  return problem;
+}
+
+TEST(EstimateTriangulationBatch, Nominal) {
+  const TriangulationProblem problem = CreateTriangulationTestData();
+  const TriangulationBatch& batch = problem.batch;
+  ASSERT_EQ(batch.NumTracks(), 2 * problem.reconstruction.NumPoints3D());
+
+  EstimateTriangulationOptions options;
+  options.residual_type =
+      TriangulationEstimator::ResidualType::REPROJECTION_ERROR;
+  options.ransac_options.max_error = 1.0;
+
+  size_t num_corrupted_tracks = 0;
+  for (const int num_threads : {1, 4}) {
+    std::vector<char> success;
+    std::vector<Eigen::Vector3d> xyzs;
+    std::vector<char> inlier_masks;
+    EstimateTriangulationBatch(
+        options, batch, &success, &xyzs, &inlier_masks, num_threads);
+    ASSERT_EQ(success.size(), batch.NumTracks());
+    ASSERT_EQ(xyzs.size(), batch.NumTracks());
+    ASSERT_EQ(inlier_masks.size(), batch.NumObservations());
+
+    num_corrupted_tracks = 0;
+    for (size_t track_idx = 0; track_idx < batch.NumTracks(); ++track_idx) {
+      const size_t track_begin = batch.track_offsets[track_idx];
+      const size_t track_end = batch.track_offsets[track_idx + 1];
+      std::vector<Eigen::Vector2d> points;
+      std::vector<Rigid3d> cams_from_world;
+      std::vector<Camera const*> cameras;
+      for (size_t i = track_begin; i < track_end; ++i) {
+        points.push_back(batch.points[i]);
+        cams_from_world.push_back(batch.cams_from_world[batch.image_idxs[i]]);
+        cameras.push_back(batch.cameras[batch.image_idxs[i]]);
+      }
+
+      std::vector<char> inlier_mask;
+      Eigen::Vector3d xyz;
+      const bool expected_success = EstimateTriangulation(
+          options, points, cams_from_world, cameras, &inlier_mask, &xyz);
+      ASSERT_EQ(success[track_idx], expected_success);
+      if (!expected_success) {
+        continue;
+      }
+
+      EXPECT_EQ(xyzs[track_idx], xyz);
+      EXPECT_EQ(std::vector<char>(inlier_masks.begin() + track_begin,
+                                  inlier_masks.begin() + track_end),
+                inlier_mask);
+      if (std::count(inlier_mask.begin(), inlier_mask.end(), 0) > 0) {
+        EXPECT_FALSE(inlier_mask[1]);
+        ++num_corrupted_tracks;
+      }
+    }
+  }
+
+  EXPECT_GT(num_corrupted_tracks, 0);
+}
+
+TEST(EstimateTriangulationBatch, Empty) {
+  TriangulationBatch batch;
+  std::vector<char> success;
+  std::vector<Eigen::Vector3d> xyzs;
+  std::vector<char> inlier_masks;
+  EstimateTriangulationBatch(EstimateTriangulationOptions(),
+                             batch,
+                             &success,
+                             &xyzs,
+                             &inlier_masks);
+  EXPECT_TRUE(success.empty());
+  EXPECT_TRUE(xyzs.empty());
+  EXPECT_TRUE(inlier_masks.empty());
+}
+
+TEST(TriangulationBatch, AddObservation) {
+  TriangulationBatch batch;
+  EXPECT_EQ(batch.NumTracks(), 0);
+  EXPECT_EQ(batch.NumObservations(), 0);
+  batch.AddObservation(0, Eigen::Vector2d(1, 2));
+  batch.AddObservation(1, Eigen::Vector2d(3, 4));
+  batch.FinishTrack();
+  batch.AddObservation(2, Eigen::Vector2d(5, 6));
+  batch.AddObservation(0, Eigen::Vector2d(7, 8));
+  batch.AddObservation(1, Eigen::Vector2d(9, 10));
+  batch.FinishTrack();
+  EXPECT_EQ(batch.NumTracks(), 2);
+  EXPECT_EQ(batch.NumObservations(), 5);
+  EXPECT_EQ(batch.track_offsets, (std::vector<size_t>{0, 2, 5}));
+  EXPECT_EQ(batch.image_idxs, (std::vector<uint32_t>{0, 1, 2, 0, 1}));
+  batch.ClearTracks();
+  EXPECT_EQ(batch.NumTracks(), 0);
+  EXPECT_EQ(batch.NumObservations(), 0);
+}
+
+}  // namespace
+}  // namespace colmap
@@ -42,6 +42,7 @@
 #include "colmap/optim/ransac.h"
 #include "colmap/scene/camera.h"
 #include "colmap/util/logging.h"
+#include "colmap/util/threading.h"
 #include "colmap/util/timer.h"
 
 #include <unordered_set>
@@ -88,6 +89,137 @@ FeatureMatches ExtractOutlierMatches(const FeatureMatches& matches,
   return outlier_matches;
 }
 
+void ExtractInlierCamRays(const Camera& camera1,
+                          const std::vector<Eigen::Vector2d>& points1,
+                          const Camera& camera2,
+                          const std::vector<Eigen::Vector2d>& points2,
+                          const FeatureMatches& inlier_matches,
+                          std::vector<Eigen::Vector3d>* inlier_cam_rays1,
+                          std::vector<Eigen::Vector3d>* inlier_cam_rays2) {
+  inlier_cam_rays1->resize(inlier_matches.size());
+  inlier_cam_rays2->resize(inlier_matches.size());
+  for (size_t i = 0; i < inlier_matches.size(); ++i) {
+    const FeatureMatch& match = inlier_matches[i];
+    (*inlier_cam_rays1)[i] = camera1.CamRayFromImg(points1[match.point2D_idx1])
+                                 .value_or(Eigen::Vector3d::Zero());
+    (*inlier_cam_rays2)[i] = camera2.CamRayFromImg(points2[match.point2D_idx2])
+                                 .value_or(Eigen::Vector3d::Zero());
+  }
+}
+
+bool EstimateTwoViewGeometryPoseFromCamRays(
+    const Camera& camera1,
+    const Camera& camera2,
+    const std::vector<Eigen::Vector3d>& inlier_cam_rays1,
+    const std::vector<Eigen::Vector3d>& inlier_cam_rays2,
+    TwoViewGeometry* geometry) {
+  std::vector<Eigen::Vector3d> points3D;
+
+  // Omnidirectional cameras (no focal length, e.g. EQUIRECTANGULAR) have no
+  // calibration matrix, so only the bearing-based essential-matrix path is
+  // valid for them. EstimateTwoViewGeometry already commits such pairs to the
+  // CALIBRATED configuration (or DEGENERATE), so they are handled by the
+  // CALIBRATED branch below and never reach the CalibrationMatrix() calls.
+  Rigid3d cam2_from_cam1;
+  if (geometry->config == TwoViewGeometry::ConfigurationType::CALIBRATED) {
+    THROW_CHECK(geometry->E.has_value());
+    PoseFromEssentialMatrix(*geometry->E,
+                            inlier_cam_rays1,
+                            inlier_cam_rays2,
+                            &cam2_from_cam1,
+                            &points3D);
+    if (points3D.empty()) {
+      return false;
+    }
+  } else if (geometry->config ==
+             TwoViewGeometry::ConfigurationType::UNCALIBRATED) {
+    THROW_CHECK(geometry->F.has_value());
+    const Eigen::Matrix3d E = EssentialFromFundamentalMatrix(
+        camera2.CalibrationMatrix(), *geometry->F, camera1.CalibrationMatrix());
+    PoseFromEssentialMatrix(
+        E, inlier_cam_rays1, inlier_cam_rays2, &cam2_from_cam1, &points3D);
+    if (points3D.empty()) {
+      return false;
+    }
+  } else if (geometry->config == TwoViewGeometry::ConfigurationType::PLANAR ||
+             geometry->config ==
+                 TwoViewGeometry::ConfigurationType::PANORAMIC ||
+             geometry->config ==
+                 TwoViewGeometry::ConfigurationType::PLANAR_OR_PANORAMIC) {
+    THROW_CHECK(geometry->H.has_value());
+    Eigen::Vector3d normal;
+    PoseFromHomographyMatrix(*geometry->H,
+                             camera1.CalibrationMatrix(),
+                             camera2.CalibrationMatrix(),
+                             inlier_cam_rays1,
+                             inlier_cam_rays2,
+                             &cam2_from_cam1,
+                             &normal,
+                             &points3D);
+    if (geometry->config ==
+        TwoViewGeometry::ConfigurationType::PLANAR_OR_PANORAMIC) {
+      if (cam2_from_cam1.translation().squaredNorm() < 1e-12) {
+        geometry->config = TwoViewGeometry::ConfigurationType::PANORAMIC;
+      } else {
+        geometry->config = TwoViewGeometry::ConfigurationType::PLANAR;
+      }
+    }
+
+    if (geometry->config == TwoViewGeometry::ConfigurationType::PANORAMIC) {
+      geometry->tri_angle = 0;
+    }
+
+    if (geometry->config == TwoViewGeometry::ConfigurationType::PLANAR &&
+        points3D.empty()) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+
+  geometry->cam2_from_cam1 = cam2_from_cam1;
+
+  if (!points3D.empty()) {
+    const Eigen::Vector3d proj_center1 = Eigen::Vector3d::Zero();
+    const Eigen::Vector3d proj_center2 = cam2_from_cam1.TgtOriginInSrc();
+    geometry->tri_angle = Median(
+        CalculateTriangulationAngles(proj_center1, proj_center2, points3D));
+  }
+
+  return true;
+}
+
+// Same as EstimateTwoViewGeometryPoseFromCamRays but selects the inlier rays
+// from the already unprojected rays of all matches, which avoids repeating the
+// (potentially iterative) unprojection of the inlier points.
+bool EstimateTwoViewGeometryPoseFromMatchedCamRays(
+    const Camera& camera1,
+    const Camera& camera2,
+    const std::vector<Eigen::Vector3d>& matched_cam_rays1,
+    const std::vector<Eigen::Vector3d>& matched_cam_rays2,
+    const std::vector<char>& inlier_mask,
+    TwoViewGeometry* geometry) {
+  THROW_CHECK_EQ(matched_cam_rays1.size(), inlier_mask.size());
+  THROW_CHECK_EQ(matched_cam_rays2.size(), inlier_mask.size());
+  if (geometry->inlier_matches.empty()) {
+    return false;
+  }
+
+  std::vector<Eigen::Vector3d> inlier_cam_rays1;
+  std::vector<Eigen::Vector3d> inlier_cam_rays2;
+  inlier_cam_rays1.reserve(geometry->inlier_matches.size());
+  inlier_cam_rays2.reserve(geometry->inlier_matches.size());
+  for (size_t i = 0; i < inlier_mask.size(); ++i) {
+    if (inlier_mask[i]) {
+      inlier_cam_rays1.push_back(matched_cam_rays1[i]);
+      inlier_cam_rays2.push_back(matched_cam_rays2[i]);
+    }
+  }
+
+  return EstimateTwoViewGeometryPoseFromCamRays(
+      camera1, camera2, inlier_cam_rays1, inlier_cam_rays2, geometry);
+}
+
 TwoViewGeometry EstimateCalibratedHomography(
     const Camera& camera1,
     const std::vector<Eigen::Vector2d>& points1,
@@ -373,7 +505,12 @@ TwoViewGeometry EstimateSphericalTwoViewGeometry(
   }
 
   if (options.compute_relative_pose) {
-    EstimateTwoViewGeometryPose(camera1, points1, camera2, points2, &geometry);
+    EstimateTwoViewGeometryPoseFromMatchedCamRays(camera1,
+                                                  camera2,
+                                                  matched_cam_rays1,
+                                                  matched_cam_rays2,
+                                                  E_report.inlier_mask,
+                                                  &geometry);
   }
 
   return geometry;
@@ -593,110 +730,6 @@ EstimateRigTwoViewGeometries(
   return two_view_geometries;
 }
 
-namespace {
-
-void ExtractInlierCamRays(const Camera& camera1,
-                          const std::vector<Eigen::Vector2d>& points1,
-                          const Camera& camera2,
-                          const std::vector<Eigen::Vector2d>& points2,
-                          const FeatureMatches& inlier_matches,
-                          std::vector<Eigen::Vector3d>* inlier_cam_rays1,
-                          std::vector<Eigen::Vector3d>* inlier_cam_rays2) {
-  inlier_cam_rays1->resize(inlier_matches.size());
-  inlier_cam_rays2->resize(inlier_matches.size());
-  for (size_t i = 0; i < inlier_matches.size(); ++i) {
-    const FeatureMatch& match = inlier_matches[i];
-    (*inlier_cam_rays1)[i] = camera1.CamRayFromImg(points1[match.point2D_idx1])
-                                 .value_or(Eigen::Vector3d::Zero());
-    (*inlier_cam_rays2)[i] = camera2.CamRayFromImg(points2[match.point2D_idx2])
-                                 .value_or(Eigen::Vector3d::Zero());
-  }
-}
-
-bool EstimateTwoViewGeometryPoseFromCamRays(
-    const Camera& camera1,
-    const Camera& camera2,
-    const std::vector<Eigen::Vector3d>& inlier_cam_rays1,
-    const std::vector<Eigen::Vector3d>& inlier_cam_rays2,
-    TwoViewGeometry* geometry) {
-  std::vector<Eigen::Vector3d> points3D;
-
-  // Omnidirectional cameras (no focal length, e.g. EQUIRECTANGULAR) have no
-  // calibration matrix, so only the bearing-based essential-matrix path is
-  // valid for them. EstimateTwoViewGeometry already commits such pairs to the
-  // CALIBRATED configuration (or DEGENERATE), so they are handled by the
-  // CALIBRATED branch below and never reach the CalibrationMatrix() calls.
-  Rigid3d cam2_from_cam1;
-  if (geometry->config == TwoViewGeometry::ConfigurationType::CALIBRATED) {
-    THROW_CHECK(geometry->E.has_value());
-    PoseFromEssentialMatrix(*geometry->E,
-                            inlier_cam_rays1,
-                            inlier_cam_rays2,
-                            &cam2_from_cam1,
-                            &points3D);
-    if (points3D.empty()) {
-      return false;
-    }
-  } else if (geometry->config ==
-             TwoViewGeometry::ConfigurationType::UNCALIBRATED) {
-    THROW_CHECK(geometry->F.has_value());
-    const Eigen::Matrix3d E = EssentialFromFundamentalMatrix(
-        camera2.CalibrationMatrix(), *geometry->F, camera1.CalibrationMatrix());
-    PoseFromEssentialMatrix(
-        E, inlier_cam_rays1, inlier_cam_rays2, &cam2_from_cam1, &points3D);
-    if (points3D.empty()) {
-      return false;
-    }
-  } else if (geometry->config == TwoViewGeometry::ConfigurationType::PLANAR ||
-             geometry->config ==
-                 TwoViewGeometry::ConfigurationType::PANORAMIC ||
-             geometry->config ==
-                 TwoViewGeometry::ConfigurationType::PLANAR_OR_PANORAMIC) {
-    THROW_CHECK(geometry->H.has_value());
-    Eigen::Vector3d normal;
-    PoseFromHomographyMatrix(*geometry->H,
-                             camera1.CalibrationMatrix(),
-                             camera2.CalibrationMatrix(),
-                             inlier_cam_rays1,
-                             inlier_cam_rays2,
-                             &cam2_from_cam1,
-                             &normal,
-                             &points3D);
-    if (geometry->config ==
-        TwoViewGeometry::ConfigurationType::PLANAR_OR_PANORAMIC) {
-      if (cam2_from_cam1.translation().squaredNorm() < 1e-12) {
-        geometry->config = TwoViewGeometry::ConfigurationType::PANORAMIC;
-      } else {
-        geometry->config = TwoViewGeometry::ConfigurationType::PLANAR;
-      }
-    }
-
-    if (geometry->config == TwoViewGeometry::ConfigurationType::PANORAMIC) {
-      geometry->tri_angle = 0;
-    }
-
-    if (geometry->config == TwoViewGeometry::ConfigurationType::PLANAR &&
-        points3D.empty()) {
-      return false;
-    }
-  } else {
-    return false;
-  }
-
-  geometry->cam2_from_cam1 = cam2_from_cam1;
-
-  if (!points3D.empty()) {
-    const Eigen::Vector3d proj_center1 = Eigen::Vector3d::Zero();
-    const Eigen::Vector3d proj_center2 = cam2_from_cam1.TgtOriginInSrc();
-    geometry->tri_angle = Median(
-        CalculateTriangulationAngles(proj_center1, proj_center2, points3D));
-  }
-
-  return true;
-}
-
-}  // namespace
-
 bool EstimateTwoViewGeometryPose(const Camera& camera1,
                                  const std::vector<Eigen::Vector2d>& points1,
                                  const Camera& camera2,
@@ -895,8 +928,12 @@ TwoViewGeometry EstimateCalibratedTwoViewGeometry(
     }
 
     if (options.compute_relative_pose) {
-      EstimateTwoViewGeometryPose(
-          camera1, points1, camera2, points2, &geometry);
+      EstimateTwoViewGeometryPoseFromMatchedCamRays(camera1,
+                                                    camera2,
+                                                    matched_cam_rays1,
+                                                    matched_cam_rays2,
+                                                    *best_inlier_mask,
+                                                    &geometry);
     }
   }
 
@@ -929,31 +966,33 @@ bool DetectWatermarkMatches(const Camera& camera1,
       Eigen::Vector2d(camera2.width - border_size2,
                       camera2.height - border_size2));
 
-  std::vector<Eigen::Vector2d> inlier_points1(num_inliers);
-  std::vector<Eigen::Vector2d> inlier_points2(num_inliers);
-
   size_t num_matches_in_border = 0;
-
-  size_t j = 0;
   for (size_t i = 0; i < inlier_mask.size(); ++i) {
-    if (inlier_mask[i]) {
-      inlier_points1[j] = points1[i];
-      inlier_points2[j] = points2[i];
-      ++j;
-
-      if (!box1.contains(points1[i]) && !box2.contains(points2[i])) {
-        ++num_matches_in_border;
-      }
+    if (inlier_mask[i] && !box1.contains(points1[i]) &&
+        !box2.contains(points2[i])) {
+      ++num_matches_in_border;
     }
   }
 
   const double matches_in_border_ratio =
       static_cast<double>(num_matches_in_border) / num_inliers;
 
+  // Most pairs exit here, so only gather the inlier points afterwards.
   if (matches_in_border_ratio < options.watermark_min_inlier_ratio) {
     return false;
   }
 
+  std::vector<Eigen::Vector2d> inlier_points1;
+  std::vector<Eigen::Vector2d> inlier_points2;
+  inlier_points1.reserve(num_inliers);
+  inlier_points2.reserve(num_inliers);
+  for (size_t i = 0; i < inlier_mask.size(); ++i) {
+    if (inlier_mask[i]) {
+      inlier_points1.push_back(points1[i]);
+      inlier_points2.push_back(points2[i]);
+    }
+  }
+
   // Check if matches follow a translational model.
 
   RANSACOptions ransac_options = options.ransac_options;
@@ -1160,7 +1199,8 @@ bool MaybeFitMissingTwoViewGeometryMatrix(
 
 }  // namespace
 
-void MaybeDecomposeRelativePoses(DatabaseCache* database_cache) {
+void MaybeDecomposeRelativePoses(DatabaseCache* database_cache,
+                                 int num_threads) {
   Timer timer;
   timer.Start();
   LOG(INFO) << "Decomposing relative poses...";
@@ -1169,18 +1209,24 @@ void MaybeDecomposeRelativePoses(DatabaseCache* database_cache) {
   const auto& images = database_cache->Images();
   auto correspondence_graph = database_cache->CorrespondenceGraph();
 
-  size_t decompose_count = 0;
-  size_t decompose_failed_count = 0;
+  const std::vector<image_pair_t> pair_ids =
+      correspondence_graph->ImagePairs();
+
+  // Decompose the pairs in parallel. The correspondence graph is only read
+  // concurrently and the decomposed geometries are written back serially.
+  enum class Status { SKIPPED, FAILED, SUCCEEDED };
+  std::vector<Status> statuses(pair_ids.size(), Status::SKIPPED);
+  std::vector<TwoViewGeometry> two_view_geometries(pair_ids.size());
 
-  for (const image_pair_t pair_id : correspondence_graph->ImagePairs()) {
-    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+  const auto decompose = [&](size_t pair_idx) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_ids[pair_idx]);
 
     TwoViewGeometry two_view_geometry =
         correspondence_graph->ExtractTwoViewGeometry(
             image_id1, image_id2, /*extract_inlier_matches=*/true);
 
     if (two_view_geometry.cam2_from_cam1.has_value()) {
-      continue;
+      return Status::SKIPPED;
     }
 
     const bool is_invalid =
@@ -1190,13 +1236,11 @@ void MaybeDecomposeRelativePoses(DatabaseCache* database_cache) {
         two_view_geometry.config == TwoViewGeometry::MULTIPLE;
 
     if (is_invalid) {
-      continue;
+      return Status::SKIPPED;
     }
 
     if (two_view_geometry.inlier_matches.empty()) {
-      decompose_count++;
-      decompose_failed_count++;
-      continue;
+      return Status::FAILED;
     }
 
     const Image& image1 = images.at(image_id1);
@@ -1215,8 +1259,6 @@ void MaybeDecomposeRelativePoses(DatabaseCache* database_cache) {
       points2.push_back(point.xy);
     }
 
-    decompose_count++;
-
     std::vector<Eigen::Vector3d> inlier_cam_rays1;
     std::vector<Eigen::Vector3d> inlier_cam_rays2;
     ExtractInlierCamRays(camera1,
@@ -1232,8 +1274,7 @@ void MaybeDecomposeRelativePoses(DatabaseCache* database_cache) {
                                               inlier_cam_rays1,
                                               inlier_cam_rays2,
                                               &two_view_geometry)) {
-      decompose_failed_count++;
-      continue;
+      return Status::FAILED;
     }
 
     const bool success =
@@ -1243,17 +1284,43 @@ void MaybeDecomposeRelativePoses(DatabaseCache* database_cache) {
                                                inlier_cam_rays2,
                                                &two_view_geometry);
 
-    if (success && two_view_geometry.cam2_from_cam1.has_value()) {
-      const double norm =
-          two_view_geometry.cam2_from_cam1->translation().norm();
-      if (norm > 1e-12) {
-        two_view_geometry.cam2_from_cam1->translation() /= norm;
-      }
-      correspondence_graph->UpdateTwoViewGeometry(
-          image_id1, image_id2, two_view_geometry);
-    } else {
+    if (!success || !two_view_geometry.cam2_from_cam1.has_value()) {
+      return Status::FAILED;
+    }
+
+    const double norm = two_view_geometry.cam2_from_cam1->translation().norm();
+    if (norm > 1e-12) {
+      two_view_geometry.cam2_from_cam1->translation() /= norm;
+    }
+    // The inlier matches are not stored in the correspondence graph.
+    FeatureMatches().swap(two_view_geometry.inlier_matches);
+    two_view_geometries[pair_idx] = std::move(two_view_geometry);
+    return Status::SUCCEEDED;
+  };
+
+  {
+    ThreadPool thread_pool(GetEffectiveNumThreads(num_threads));
+    for (size_t pair_idx = 0; pair_idx < pair_ids.size(); ++pair_idx) {
+      thread_pool.AddTask(
+          [&, pair_idx]() { statuses[pair_idx] = decompose(pair_idx); });
+    }
+    thread_pool.Wait();
+  }
+
+  size_t decompose_count = 0;
+  size_t decompose_failed_count = 0;
+  for (size_t pair_idx = 0; pair_idx < pair_ids.size(); ++pair_idx) {
+    if (statuses[pair_idx] == Status::SKIPPED) {
+      continue;
+    }
+    decompose_count++;
+    if (statuses[pair_idx] == Status::FAILED) {
       decompose_failed_count++;
+      continue;
     }
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_ids[pair_idx]);
+    correspondence_graph->UpdateTwoViewGeometry(
+        image_id1, image_id2, std::move(two_view_geometries[pair_idx]));
   }
 
   LOG(INFO) << StringPrintf("Decomposed %d relative poses (%d failed) in %.3fs",
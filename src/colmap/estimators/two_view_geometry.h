@@ -224,7 +224,9 @@ TwoViewGeometry TwoViewGeometryFromKnownRelativePose(
 // Decompose relative poses from two-view geometries in the database cache and
 // update the results in-memory. Skips pairs that already have a relative
 // pose or have invalid two-view geometries (UNDEFINED, DEGENERATE, WATERMARK,
-// MULTIPLE).
-void MaybeDecomposeRelativePoses(DatabaseCache* database_cache);
+// MULTIPLE). The pairs are decomposed in parallel using the given number of
+// threads (-1 for all available threads).
+void MaybeDecomposeRelativePoses(DatabaseCache* database_cache,
+                                 int num_threads = -1);
 
 }  // namespace colmap
@@ -865,10 +865,13 @@ TEST(EstimateRigTwoViewGeometries, Nominal) {
 
   TwoViewGeometryOptions two_view_geometry_options;
   two_view_geometry_options.ransac_options.random_seed = 42;
+  const std::unordered_map<image_t, Image> images(
+      test_data.reconstruction.Images().begin(),
+      test_data.reconstruction.Images().end());
   const auto geometries =
       EstimateRigTwoViewGeometries(test_data.rig1,
                                    test_data.rig2,
-                                   test_data.reconstruction.Images(),
+                                   images,
                                    test_data.reconstruction.Cameras(),
                                    test_data.matches,
                                    two_view_geometry_options);
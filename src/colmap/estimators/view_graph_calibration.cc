@@ -32,10 +32,13 @@
 #include "colmap/estimators/cost_functions/calibration.h"
 #include "colmap/estimators/two_view_geometry.h"
 #include "colmap/geometry/essential_matrix.h"
+#include "colmap/math/connected_components.h"
 #include "colmap/scene/two_view_geometry.h"
 #include "colmap/util/logging.h"
 #include "colmap/util/threading.h"
 
+#include <algorithm>
+#include <cmath>
 #include <mutex>
 #include <unordered_set>
 
@@ -191,10 +194,123 @@ void ReestimateRelativePoses(
   thread_pool.Wait();
 }
 
+struct FocalLengthState {
+  double optimized = 0.0;
+  double initial = 0.0;
+};
+
+ceres::CostFunction* CreateFocalLengthCostFunction(
+    const FocalLengthCalibInput& input,
+    const std::unordered_map<camera_t, Camera>& cameras) {
+  if (input.camera_id1 == input.camera_id2) {
+    return FetzerFocalLengthSameCameraCostFunctor::Create(
+        input.F, cameras.at(input.camera_id1).PrincipalPoint());
+  }
+  return FetzerFocalLengthCostFunctor::Create(
+      input.F,
+      cameras.at(input.camera_id1).PrincipalPoint(),
+      cameras.at(input.camera_id2).PrincipalPoint());
+}
+
+// Optimize the focal lengths of a cluster of cameras, which is only connected
+// to other cameras through image pairs with constant (prior) focal lengths.
+// Focal lengths outside of the valid ratio range are reverted to their initial
+// value. Only the focal lengths of the cluster's cameras are modified, such
+// that separate clusters can be solved concurrently.
+bool SolveFocalLengthCluster(
+    const ViewGraphCalibrationOptions& options,
+    const std::vector<FocalLengthCalibInput>& inputs,
+    const std::vector<size_t>& input_indices,
+    const std::vector<camera_t>& camera_ids,
+    const std::unordered_map<camera_t, Camera>& cameras,
+    int num_threads,
+    std::unordered_map<camera_t, FocalLengthState>& focal_lengths,
+    size_t& num_rejected_cameras) {
+  // Build Ceres problem.
+  ceres::Problem::Options problem_options;
+  problem_options.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+  ceres::Problem problem(problem_options);
+  auto loss_function = options.CreateLossFunction();
+
+  // Cameras with prior focal length are held constant. They use local copies,
+  // because they may be shared with other clusters.
+  std::unordered_map<camera_t, double> constant_focal_lengths;
+  const auto get_focal_ptr = [&](camera_t camera_id) {
+    FocalLengthState& focal = focal_lengths.at(camera_id);
+    if (!cameras.at(camera_id).has_prior_focal_length) {
+      return &focal.optimized;
+    }
+    return &constant_focal_lengths.emplace(camera_id, focal.optimized)
+                .first->second;
+  };
+
+  std::vector<double*> parameter_blocks;
+  for (const size_t input_idx : input_indices) {
+    const FocalLengthCalibInput& input = inputs[input_idx];
+    parameter_blocks.clear();
+    parameter_blocks.push_back(get_focal_ptr(input.camera_id1));
+    if (input.camera_id1 != input.camera_id2) {
+      parameter_blocks.push_back(get_focal_ptr(input.camera_id2));
+    }
+    problem.AddResidualBlock(CreateFocalLengthCostFunction(input, cameras),
+                             loss_function.get(),
+                             parameter_blocks);
+  }
+
+  // Parameterize cameras (fix those with prior, set lower bound).
+  for (const camera_t camera_id : camera_ids) {
+    problem.SetParameterLowerBound(
+        &focal_lengths.at(camera_id).optimized, 0, kFocalLengthLowerBound);
+  }
+  for (auto& [camera_id, focal_length] : constant_focal_lengths) {
+    problem.SetParameterBlockConstant(&focal_length);
+  }
+
+  // Set solver options.
+  ceres::Solver::Options solver_options = options.solver_options;
+  if (camera_ids.size() < 50) {
+    solver_options.linear_solver_type = ceres::DENSE_NORMAL_CHOLESKY;
+  } else {
+    solver_options.linear_solver_type = ceres::SPARSE_NORMAL_CHOLESKY;
+  }
+  solver_options.num_threads = num_threads;
+  solver_options.minimizer_progress_to_stdout = VLOG_IS_ON(2);
+
+  // Solve.
+  ceres::Solver::Summary summary;
+  ceres::Solve(solver_options, &problem, &summary);
+  VLOG(2) << summary.FullReport();
+
+  if (!summary.IsSolutionUsable()) {
+    return false;
+  }
+
+  // Validate focal lengths and revert degenerate ones.
+  for (const camera_t camera_id : camera_ids) {
+    auto& focal = focal_lengths.at(camera_id);
+    const double focal_length_ratio = focal.optimized / focal.initial;
+    if (focal_length_ratio > options.max_focal_length_ratio ||
+        focal_length_ratio < options.min_focal_length_ratio) {
+      VLOG(2) << "Ignoring degenerate camera " << camera_id
+              << " focal: " << focal.optimized
+              << " original focal: " << focal.initial;
+      num_rejected_cameras++;
+      // Reset to original focal length.
+      focal.optimized = focal.initial;
+    }
+  }
+
+  return true;
+}
+
 // Core Ceres optimization for focal length calibration.
 // This is a pure function with no I/O dependencies.
 // See: "Stable Intrinsic Auto-Calibration from Fundamental Matrices of Devices
 // with Uncorrelated Camera Parameters", Fetzer et al., WACV 2020.
+//
+// The cameras without prior focal length are partitioned into clusters that
+// are connected through image pairs, and each cluster is solved as an
+// independent subproblem. The clusters are solved concurrently.
 FocalLengthCalibResult CalibrateFocalLengths(
     const ViewGraphCalibrationOptions& options,
     const std::vector<FocalLengthCalibInput>& inputs,
@@ -207,10 +323,6 @@ FocalLengthCalibResult CalibrateFocalLengths(
   }
 
   // Initialize focal lengths from all perspective cameras.
-  struct FocalLengthState {
-    double optimized = 0.0;
-    double initial = 0.0;
-  };
   std::unordered_map<camera_t, FocalLengthState> focal_lengths;
   focal_lengths.reserve(cameras.size());
   for (const auto& [camera_id, camera] : cameras) {
@@ -220,51 +332,33 @@ FocalLengthCalibResult CalibrateFocalLengths(
     }
   }
 
-  // Build Ceres problem.
-  ceres::Problem::Options problem_options;
-  problem_options.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
-  ceres::Problem problem(problem_options);
-  auto loss_function = options.CreateLossFunction();
-
-  for (const auto& input : inputs) {
+  // Partition the cameras to optimize into clusters.
+  const auto is_variable = [&cameras](camera_t camera_id) {
+    return !cameras.at(camera_id).has_prior_focal_length;
+  };
+  std::vector<size_t> valid_input_indices;
+  valid_input_indices.reserve(inputs.size());
+  std::unordered_set<camera_t> variable_camera_ids;
+  std::vector<std::pair<camera_t, camera_t>> variable_camera_pairs;
+  for (size_t input_idx = 0; input_idx < inputs.size(); ++input_idx) {
+    const FocalLengthCalibInput& input = inputs[input_idx];
     if (!cameras.at(input.camera_id1).IsPerspective() ||
         !cameras.at(input.camera_id2).IsPerspective()) {
       continue;
     }
-    if (input.camera_id1 == input.camera_id2) {
-      problem.AddResidualBlock(
-          FetzerFocalLengthSameCameraCostFunctor::Create(
-              input.F, cameras.at(input.camera_id1).PrincipalPoint()),
-          loss_function.get(),
-          &focal_lengths[input.camera_id1].optimized);
-    } else {
-      problem.AddResidualBlock(
-          FetzerFocalLengthCostFunctor::Create(
-              input.F,
-              cameras.at(input.camera_id1).PrincipalPoint(),
-              cameras.at(input.camera_id2).PrincipalPoint()),
-          loss_function.get(),
-          &focal_lengths[input.camera_id1].optimized,
-          &focal_lengths[input.camera_id2].optimized);
+    valid_input_indices.push_back(input_idx);
+    if (is_variable(input.camera_id1)) {
+      variable_camera_ids.insert(input.camera_id1);
     }
-  }
-
-  // Parameterize cameras (fix those with prior, set lower bound).
-  size_t num_cameras = 0;
-  for (const auto& [camera_id, camera] : cameras) {
-    if (!camera.IsPerspective()) continue;
-    double* focal_ptr = &focal_lengths[camera_id].optimized;
-    if (!problem.HasParameterBlock(focal_ptr)) continue;
-
-    problem.SetParameterLowerBound(focal_ptr, 0, kFocalLengthLowerBound);
-    if (camera.has_prior_focal_length) {
-      problem.SetParameterBlockConstant(focal_ptr);
-    } else {
-      num_cameras++;
+    if (is_variable(input.camera_id2)) {
+      variable_camera_ids.insert(input.camera_id2);
+    }
+    if (is_variable(input.camera_id1) && is_variable(input.camera_id2)) {
+      variable_camera_pairs.emplace_back(input.camera_id1, input.camera_id2);
     }
   }
 
-  if (num_cameras == 0) {
+  if (variable_camera_ids.empty()) {
     LOG(INFO) << "No cameras to optimize";
     for (const auto& [camera_id, focal] : focal_lengths) {
       result.focal_lengths[camera_id] = focal.initial;
@@ -273,45 +367,71 @@ FocalLengthCalibResult CalibrateFocalLengths(
     return result;
   }
 
-  // Set solver options.
-  ceres::Solver::Options solver_options = options.solver_options;
-  if (cameras.size() < 50) {
-    solver_options.linear_solver_type = ceres::DENSE_NORMAL_CHOLESKY;
-  } else {
-    solver_options.linear_solver_type = ceres::SPARSE_NORMAL_CHOLESKY;
+  std::vector<std::vector<camera_t>> clusters =
+      FindConnectedComponents(variable_camera_ids, variable_camera_pairs);
+  std::sort(clusters.begin(),
+            clusters.end(),
+            [](const auto& cluster1, const auto& cluster2) {
+              return cluster1.size() > cluster2.size();
+            });
+  std::unordered_map<camera_t, size_t> camera_id_to_cluster_idx;
+  for (size_t cluster_idx = 0; cluster_idx < clusters.size(); ++cluster_idx) {
+    for (const camera_t camera_id : clusters[cluster_idx]) {
+      camera_id_to_cluster_idx.emplace(camera_id, cluster_idx);
+    }
+  }
+  std::vector<std::vector<size_t>> cluster_input_indices(clusters.size());
+  for (const size_t input_idx : valid_input_indices) {
+    const FocalLengthCalibInput& input = inputs[input_idx];
+    const camera_t camera_id =
+        is_variable(input.camera_id1) ? input.camera_id1 : input.camera_id2;
+    if (is_variable(camera_id)) {
+      cluster_input_indices[camera_id_to_cluster_idx.at(camera_id)].push_back(
+          input_idx);
+    }
   }
-  solver_options.num_threads =
-      GetEffectiveNumThreads(solver_options.num_threads);
-  solver_options.minimizer_progress_to_stdout = VLOG_IS_ON(2);
 
-  // Solve.
-  ceres::Solver::Summary summary;
-  ceres::Solve(solver_options, &problem, &summary);
-  VLOG(2) << summary.FullReport();
+  LOG(INFO) << "Calibrating focal lengths of " << variable_camera_ids.size()
+            << " cameras in " << clusters.size() << " clusters";
+
+  // Solve the clusters concurrently. The available threads are distributed
+  // evenly over the clusters.
+  const int num_threads =
+      GetEffectiveNumThreads(options.solver_options.num_threads);
+  const int num_cluster_threads =
+      std::max(1, num_threads / static_cast<int>(clusters.size()));
+  std::vector<char> cluster_success(clusters.size(), 0);
+  std::vector<size_t> cluster_num_rejected_cameras(clusters.size(), 0);
+  {
+    ThreadPool thread_pool(
+        std::min(num_threads, static_cast<int>(clusters.size())));
+    for (size_t cluster_idx = 0; cluster_idx < clusters.size();
+         ++cluster_idx) {
+      thread_pool.AddTask([&, cluster_idx]() {
+        cluster_success[cluster_idx] =
+            SolveFocalLengthCluster(options,
+                                    inputs,
+                                    cluster_input_indices[cluster_idx],
+                                    clusters[cluster_idx],
+                                    cameras,
+                                    num_cluster_threads,
+                                    focal_lengths,
+                                    cluster_num_rejected_cameras[cluster_idx]);
+      });
+    }
+    thread_pool.Wait();
+  }
 
-  if (!summary.IsSolutionUsable()) {
+  if (std::find(cluster_success.begin(), cluster_success.end(), 0) !=
+      cluster_success.end()) {
     LOG(ERROR) << "Ceres solver failed";
     result.success = false;
     return result;
   }
 
-  // Validate focal lengths and revert degenerate ones.
   size_t rejected_cameras = 0;
-  for (const auto& [camera_id, camera] : cameras) {
-    if (!camera.IsPerspective()) continue;
-    auto& focal = focal_lengths[camera_id];
-    if (!problem.HasParameterBlock(&focal.optimized)) continue;
-
-    const double focal_length_ratio = focal.optimized / focal.initial;
-    if (focal_length_ratio > options.max_focal_length_ratio ||
-        focal_length_ratio < options.min_focal_length_ratio) {
-      VLOG(2) << "Ignoring degenerate camera " << camera_id
-              << " focal: " << focal.optimized
-              << " original focal: " << focal.initial;
-      rejected_cameras++;
-      // Reset to original focal length.
-      focal.optimized = focal.initial;
-    }
+  for (const size_t num_rejected_cameras : cluster_num_rejected_cameras) {
+    rejected_cameras += num_rejected_cameras;
   }
   LOG(INFO) << rejected_cameras
             << " cameras rejected in view graph calibration";
@@ -320,19 +440,17 @@ FocalLengthCalibResult CalibrateFocalLengths(
     result.focal_lengths[camera_id] = focal.optimized;
   }
 
-  // Evaluate calibration errors.
-  ceres::Problem::EvaluateOptions eval_options;
-  eval_options.num_threads = solver_options.num_threads;
-  eval_options.apply_loss_function = false;
-  std::vector<double> residuals;
-  problem.Evaluate(eval_options, nullptr, &residuals, nullptr, nullptr);
-
-  size_t residual_idx = 0;
-  for (const auto& input : inputs) {
-    const Eigen::Vector2d error(residuals[residual_idx],
-                                residuals[residual_idx + 1]);
+  // Evaluate calibration errors without loss function.
+  for (const size_t input_idx : valid_input_indices) {
+    const FocalLengthCalibInput& input = inputs[input_idx];
+    const std::unique_ptr<ceres::CostFunction> cost_function(
+        CreateFocalLengthCostFunction(input, cameras));
+    const double* parameters[2] = {
+        &focal_lengths.at(input.camera_id1).optimized,
+        &focal_lengths.at(input.camera_id2).optimized};
+    Eigen::Vector2d error;
+    cost_function->Evaluate(parameters, error.data(), nullptr);
     result.calibration_errors_sq[input.pair_id] = error.squaredNorm();
-    residual_idx += 2;
   }
 
   result.success = true;
@@ -376,6 +494,16 @@ bool CalibrateViewGraph(const ViewGraphCalibrationOptions& options,
 
   LOG(INFO) << "Calibrating view graph with " << pairs.size() << " pairs";
 
+  // Pairs that are already calibrated with a relative pose do not need to be
+  // re-estimated if the calibration of their cameras does not change.
+  std::unordered_set<image_pair_t> posed_calibrated_pair_ids;
+  for (const auto& [pair_id, tvg] : pairs) {
+    if (tvg.config == TwoViewGeometry::CALIBRATED &&
+        tvg.cam2_from_cam1.has_value()) {
+      posed_calibrated_pair_ids.insert(pair_id);
+    }
+  }
+
   if (options.cross_validate_prior_focal_lengths) {
     CrossValidatePriorFocalLengths(
         options.min_calibrated_pair_ratio, image_id_to_camera, pairs);
@@ -422,17 +550,28 @@ bool CalibrateViewGraph(const ViewGraphCalibrationOptions& options,
   }
 
   // Update cameras with estimated focal lengths.
+  std::unordered_set<camera_t> changed_camera_ids;
   for (const auto& [camera_id, focal_length] : calib_result.focal_lengths) {
     Camera& camera = cameras.at(camera_id);
+    const std::vector<double> prev_params = camera.params;
     camera.SetFocalLength(focal_length);
     camera.has_prior_focal_length = true;
     database->UpdateCamera(camera);
+    for (const size_t idx : camera.FocalLengthIdxs()) {
+      if (std::abs(camera.params[idx] - prev_params[idx]) >
+          options.max_unchanged_focal_length_change *
+              std::abs(prev_params[idx])) {
+        changed_camera_ids.insert(camera_id);
+        break;
+      }
+    }
   }
 
   // Process pairs: tag degenerate or compute E matrix.
   const double max_calibration_error_sq =
       options.max_calibration_error * options.max_calibration_error;
   size_t invalid_counter = 0;
+  size_t unchanged_counter = 0;
   std::vector<size_t> valid_pair_indices;
 
   for (size_t i = 0; i < pairs.size(); ++i) {
@@ -452,10 +591,18 @@ bool CalibrateViewGraph(const ViewGraphCalibrationOptions& options,
       tvg.config = TwoViewGeometry::DEGENERATE;
       database->UpdateTwoViewGeometry(image_id1, image_id2, tvg);
     } else {
-      THROW_CHECK(tvg.F.has_value())
-          << "Two-view geometry must have F matrix for E computation";
       const Camera& camera1 = *image_id_to_camera.at(image_id1);
       const Camera& camera2 = *image_id_to_camera.at(image_id2);
+      if (options.skip_unchanged_pairs &&
+          posed_calibrated_pair_ids.count(pair_id) > 0 &&
+          changed_camera_ids.count(camera1.camera_id) == 0 &&
+          changed_camera_ids.count(camera2.camera_id) == 0) {
+        // The two-view geometry in the database remains valid.
+        unchanged_counter++;
+        continue;
+      }
+      THROW_CHECK(tvg.F.has_value())
+          << "Two-view geometry must have F matrix for E computation";
       tvg.E = EssentialFromFundamentalMatrix(camera2.CalibrationMatrix(),
                                              tvg.F.value(),
                                              camera1.CalibrationMatrix());
@@ -465,6 +612,8 @@ bool CalibrateViewGraph(const ViewGraphCalibrationOptions& options,
   }
   LOG(INFO) << "Invalid / total number of two-view geometry: "
             << invalid_counter << " / " << pairs.size();
+  LOG(INFO) << "Unchanged / total number of two-view geometry: "
+            << unchanged_counter << " / " << pairs.size();
 
   // Re-estimate relative poses for valid pairs.
   if (options.reestimate_relative_pose && !valid_pair_indices.empty()) {
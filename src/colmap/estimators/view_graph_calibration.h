@@ -52,6 +52,14 @@ struct ViewGraphCalibrationOptions {
   // Whether to re-estimate relative poses after focal length calibration.
   bool reestimate_relative_pose = true;
 
+  // Whether to leave CALIBRATED pairs with an existing relative pose untouched
+  // if the focal lengths of both their cameras did not change. Otherwise, all
+  // valid pairs are updated and their relative poses re-estimated.
+  bool skip_unchanged_pairs = true;
+  // The maximum relative focal length change for a camera to be considered
+  // unchanged by the calibration.
+  double max_unchanged_focal_length_change = 1e-4;
+
   // The minimum ratio of the estimated focal length to the prior focal length.
   double min_focal_length_ratio = 0.1;
   // The maximum ratio of the estimated focal length to the prior focal length.
@@ -88,6 +96,8 @@ struct ViewGraphCalibrationOptions {
 // database. Image pairs with low calibration error have their essential
 // matrices computed and relative poses re-estimated, then are upgraded to
 // CALIBRATED. Pairs with high calibration error are tagged as DEGENERATE.
+// Optionally, already calibrated pairs between cameras with unchanged focal
+// lengths keep their existing two-view geometry.
 bool CalibrateViewGraph(const ViewGraphCalibrationOptions& options,
                         Database* database);
 
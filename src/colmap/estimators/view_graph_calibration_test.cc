@@ -130,6 +130,56 @@ TEST(CalibrateViewGraph, PriorFocalLength) {
   }
 }
 
+TEST(CalibrateViewGraph, IndependentCameraClusters) {
+  SetPRNGSeed(42);
+
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+
+  SyntheticDatasetOptions options;
+  options.num_rigs = 10;
+  options.num_cameras_per_rig = 1;
+  options.num_frames_per_rig = 1;
+  options.num_points3D = 200;
+  options.camera_model_id = SimplePinholeCameraModel::model_id;
+  options.camera_params = {1280, 512, 384};
+  options.camera_has_prior_focal_length = true;
+
+  Reconstruction reconstruction;
+  SynthesizeDataset(options, &reconstruction, database.get());
+
+  std::unordered_map<camera_t, double> gt_focals;
+  for (const auto& [camera_id, camera] : reconstruction.Cameras()) {
+    gt_focals[camera_id] = camera.MeanFocalLength();
+  }
+
+  // Only cameras 1 and 3 are calibrated. Without a valid pair between them,
+  // they are only connected through cameras with prior focal lengths and
+  // are thus solved as separate clusters.
+  const std::vector<camera_t> noisy_camera_ids = {1, 3};
+  for (const camera_t camera_id : noisy_camera_ids) {
+    Camera camera = database->ReadCamera(camera_id);
+    const double noise = RandomUniformReal(-50.0, 50.0);
+    for (const size_t idx : camera.FocalLengthIdxs()) {
+      camera.params[idx] += noise;
+    }
+    camera.has_prior_focal_length = false;
+    database->UpdateCamera(camera);
+  }
+  TwoViewGeometry tvg = database->ReadTwoViewGeometry(1, 3);
+  tvg.config = TwoViewGeometry::DEGENERATE;
+  database->UpdateTwoViewGeometry(1, 3, tvg);
+
+  ViewGraphCalibrationOptions calib_options;
+  calib_options.reestimate_relative_pose = false;
+  EXPECT_TRUE(CalibrateViewGraph(calib_options, database.get()));
+
+  for (const auto& [camera_id, gt_focal] : gt_focals) {
+    const Camera camera = database->ReadCamera(camera_id);
+    EXPECT_TRUE(camera.has_prior_focal_length);
+    EXPECT_NEAR(camera.MeanFocalLength(), gt_focal, 1.0);
+  }
+}
+
 TEST(CalibrateViewGraph, ConfigTagging) {
   SetPRNGSeed(42);
 
@@ -240,6 +290,57 @@ TEST(CalibrateViewGraph, RelativePoseReestimation) {
   }
 }
 
+TEST(CalibrateViewGraph, SkipUnchangedPairs) {
+  SetPRNGSeed(42);
+
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+
+  SyntheticDatasetOptions options;
+  options.num_rigs = 10;
+  options.num_cameras_per_rig = 1;
+  options.num_frames_per_rig = 1;
+  options.num_points3D = 200;
+  options.camera_model_id = SimplePinholeCameraModel::model_id;
+  options.camera_params = {1280, 512, 384};
+  options.camera_has_prior_focal_length = false;
+
+  Reconstruction reconstruction;
+  SynthesizeDataset(options, &reconstruction, database.get());
+
+  // Store calibrated pairs with perturbed relative poses, which are only
+  // corrected if the pairs are re-estimated.
+  std::unordered_map<image_pair_t, TwoViewGeometry> perturbed_tvgs;
+  for (const auto& [pair_id, tvg] : database->ReadTwoViewGeometries()) {
+    if (!tvg.cam2_from_cam1.has_value()) {
+      continue;
+    }
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    TwoViewGeometry perturbed_tvg = tvg;
+    perturbed_tvg.config = TwoViewGeometry::CALIBRATED;
+    perturbed_tvg.cam2_from_cam1->translation() = Eigen::Vector3d(1, 0, 0);
+    database->UpdateTwoViewGeometry(image_id1, image_id2, perturbed_tvg);
+    perturbed_tvgs.emplace(pair_id, std::move(perturbed_tvg));
+  }
+  ASSERT_FALSE(perturbed_tvgs.empty());
+
+  // Treat any focal length change as negligible, so all pairs are unchanged.
+  ViewGraphCalibrationOptions calib_options;
+  calib_options.reestimate_relative_pose = true;
+  calib_options.skip_unchanged_pairs = true;
+  calib_options.max_unchanged_focal_length_change = 1.0;
+  EXPECT_TRUE(CalibrateViewGraph(calib_options, database.get()));
+
+  for (const auto& [pair_id, perturbed_tvg] : perturbed_tvgs) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    const TwoViewGeometry tvg =
+        database->ReadTwoViewGeometry(image_id1, image_id2);
+    EXPECT_EQ(tvg.config, TwoViewGeometry::CALIBRATED);
+    ASSERT_TRUE(tvg.cam2_from_cam1.has_value());
+    EXPECT_EQ(tvg.cam2_from_cam1->translation(),
+              perturbed_tvg.cam2_from_cam1->translation());
+  }
+}
+
 TEST(CalibrateViewGraph, SphericalCamerasAreIgnored) {
   SetPRNGSeed(42);
 
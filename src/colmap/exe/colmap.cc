@@ -27,6 +27,7 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include "colmap/controllers/option_manager.h"
 #include "colmap/exe/database.h"
 #include "colmap/exe/feature.h"
 #include "colmap/exe/gui.h"
@@ -37,9 +38,23 @@
 #endif
 #include "colmap/exe/sfm.h"
 #include "colmap/exe/vocab_tree.h"
+#include "colmap/util/file.h"
+#include "colmap/util/metrics.h"
 #include "colmap/util/oiio_utils.h"
+#include "colmap/util/threading.h"
+#include "colmap/util/tracing.h"
 #include "colmap/util/version.h"
 
+#if defined(COLMAP_CUDA_ENABLED)
+#include "colmap/util/cuda.h"
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
 namespace {
 
 using command_func_t = std::function<int(int, char**)>;
@@ -82,6 +97,136 @@ void ShowHelp(
   std::cout << '\n';
 }
 
+// Starts a thread that periodically writes the metrics of the command to the
+// file given by the environment variable COLMAP_METRICS_PATH, if it is set.
+std::unique_ptr<colmap::MetricsWriterThread> MaybeStartMetricsWriter(
+    std::vector<std::unique_ptr<colmap::ScopedMetricFn>>* metric_fns) {
+  const std::optional<std::string> metrics_path =
+      colmap::GetEnvSafe("COLMAP_METRICS_PATH");
+  if (!metrics_path.has_value() || metrics_path->empty()) {
+    return nullptr;
+  }
+
+  double interval_seconds = 10;
+  const std::optional<std::string> metrics_interval =
+      colmap::GetEnvSafe("COLMAP_METRICS_INTERVAL");
+  if (metrics_interval.has_value() && !metrics_interval->empty()) {
+    interval_seconds = std::stod(*metrics_interval);
+  }
+
+#if defined(COLMAP_CUDA_ENABLED)
+  int num_cuda_devices = 0;
+  try {
+    num_cuda_devices = colmap::GetNumCudaDevices();
+  } catch (const std::exception&) {
+    // No CUDA devices available.
+  }
+  for (int gpu_index = 0; gpu_index < num_cuda_devices; ++gpu_index) {
+    metric_fns->push_back(std::make_unique<colmap::ScopedMetricFn>(
+        "colmap_gpu_memory_used_bytes{gpu=\"" + std::to_string(gpu_index) +
+            "\"}",
+        colmap::MetricType::kGauge,
+        [gpu_index]() {
+          size_t num_free_bytes = 0;
+          size_t num_total_bytes = 0;
+          colmap::GetCudaMemoryInfo(
+              gpu_index, &num_free_bytes, &num_total_bytes);
+          return num_total_bytes - num_free_bytes;
+        }));
+  }
+#endif
+
+  LOG(INFO) << "Writing metrics to " << *metrics_path << " every "
+            << interval_seconds << "s";
+  auto metrics_writer = std::make_unique<colmap::MetricsWriterThread>(
+      *metrics_path, interval_seconds);
+  metrics_writer->Start();
+  return metrics_writer;
+}
+
+// Runs the commands given one per line in the same process, such that many
+// short commands do not each pay for the start-up of a new process. The
+// commands are read from commands_path or, if it is empty, from the standard
+// input until the end of the stream. Arguments containing whitespace can be
+// quoted. Empty lines and lines starting with # are ignored.
+int RunCommandBatch(
+    const std::vector<std::pair<std::string, command_func_t>>& commands,
+    int argc,
+    char** argv) {
+  std::filesystem::path commands_path;
+  bool stop_on_error = false;
+
+  colmap::OptionManager options;
+  options.AddDefaultOption("commands_path",
+                           &commands_path,
+                           "Text file with one command and its options per "
+                           "line. Reads from the standard input, if empty.");
+  options.AddDefaultOption("stop_on_error", &stop_on_error);
+  if (!options.Parse(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  std::ifstream commands_file;
+  if (!commands_path.empty()) {
+    commands_file.open(commands_path);
+    THROW_CHECK_FILE_OPEN(commands_file, commands_path);
+  }
+  std::istream& commands_stream =
+      commands_path.empty() ? std::cin : commands_file;
+
+  int num_commands = 0;
+  int num_failed_commands = 0;
+  std::string line;
+  while (std::getline(commands_stream, line)) {
+    std::istringstream line_stream(line);
+    std::vector<std::string> args = {argv[0]};
+    std::string arg;
+    while (line_stream >> std::quoted(arg)) {
+      args.push_back(arg);
+    }
+    if (args.size() == 1 || args[1].front() == '#') {
+      continue;
+    }
+
+    num_commands += 1;
+    int return_code = EXIT_FAILURE;
+    const auto command_it =
+        std::find_if(commands.begin(),
+                     commands.end(),
+                     [&args](const auto& command) {
+                       return command.first == args[1];
+                     });
+    if (command_it == commands.end()) {
+      LOG(ERROR) << "Command `" << args[1] << "` not recognized.";
+    } else {
+      std::vector<char*> command_argv;
+      command_argv.reserve(args.size() - 1);
+      command_argv.push_back(args[0].data());
+      for (size_t i = 2; i < args.size(); ++i) {
+        command_argv.push_back(args[i].data());
+      }
+      try {
+        return_code = command_it->second(
+            static_cast<int>(command_argv.size()), command_argv.data());
+      } catch (const std::exception& exc) {
+        LOG(ERROR) << "Command `" << args[1] << "` failed: " << exc.what();
+      }
+    }
+
+    if (return_code != EXIT_SUCCESS) {
+      num_failed_commands += 1;
+      LOG(ERROR) << "Failed to run command: " << line;
+      if (stop_on_error) {
+        break;
+      }
+    }
+  }
+
+  LOG(INFO) << "Ran " << num_commands << " commands, "
+            << num_failed_commands << " failed.";
+  return num_failed_commands == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -92,11 +237,17 @@ int main(int argc, char** argv) {
   commands.emplace_back("gui", &colmap::RunGraphicalUserInterface);
   commands.emplace_back("automatic_reconstructor",
                         &colmap::RunAutomaticReconstructor);
+  commands.emplace_back("batch", [&commands](int argc, char** argv) {
+    return RunCommandBatch(commands, argc, argv);
+  });
   commands.emplace_back("bundle_adjuster", &colmap::RunBundleAdjuster);
   commands.emplace_back("color_extractor", &colmap::RunColorExtractor);
   commands.emplace_back("database_cleaner", &colmap::RunDatabaseCleaner);
+  commands.emplace_back("database_converter", &colmap::RunDatabaseConverter);
   commands.emplace_back("database_creator", &colmap::RunDatabaseCreator);
   commands.emplace_back("database_merger", &colmap::RunDatabaseMerger);
+  commands.emplace_back("database_shard_reducer",
+                        &colmap::RunDatabaseShardReducer);
 #if defined(COLMAP_MVS_ENABLED)
   commands.emplace_back("advancing_front_mesher",
                         &colmap::RunAdvancingFrontMesher);
@@ -106,10 +257,14 @@ int main(int argc, char** argv) {
   commands.emplace_back("feature_extractor", &colmap::RunFeatureExtractor);
   commands.emplace_back("feature_importer", &colmap::RunFeatureImporter);
   commands.emplace_back("geometric_verifier", &colmap::RunGeometricVerifier);
+  commands.emplace_back("global_descriptor_matcher",
+                        &colmap::RunGlobalDescriptorMatcher);
   commands.emplace_back("global_mapper", &colmap::RunGlobalMapper);
   commands.emplace_back("guided_geometric_verifier",
                         &colmap::RunGuidedGeometricVerifier);
   commands.emplace_back("hierarchical_mapper", &colmap::RunHierarchicalMapper);
+  commands.emplace_back("hierarchical_mapper_worker",
+                        &colmap::RunHierarchicalMapperWorker);
   commands.emplace_back("image_deleter", &colmap::RunImageDeleter);
   commands.emplace_back("image_filterer", &colmap::RunImageFilterer);
   commands.emplace_back("image_rectifier", &colmap::RunImageRectifier);
@@ -117,11 +272,14 @@ int main(int argc, char** argv) {
   commands.emplace_back("image_undistorter", &colmap::RunImageUndistorter);
   commands.emplace_back("image_undistorter_standalone",
                         &colmap::RunImageUndistorterStandalone);
+  commands.emplace_back("localization_server",
+                        &colmap::RunLocalizationServer);
   commands.emplace_back("mapper", &colmap::RunMapper);
   commands.emplace_back("matches_importer", &colmap::RunMatchesImporter);
 #if defined(COLMAP_MVS_ENABLED)
   commands.emplace_back("mesh_simplifier", &colmap::RunMeshSimplifier);
   commands.emplace_back("mesh_texturer", &colmap::RunMeshTexturer);
+  commands.emplace_back("mesh_tiler", &colmap::RunMeshTiler);
 #endif
   commands.emplace_back("model_aligner", &colmap::RunModelAligner);
   commands.emplace_back("model_analyzer", &colmap::RunModelAnalyzer);
@@ -189,7 +347,40 @@ int main(int argc, char** argv) {
       int command_argc = argc - 1;
       char** command_argv = &argv[1];
       command_argv[0] = argv[0];
-      return matched_command_func(command_argc, command_argv);
+      // Optionally record a trace of the command, which can be inspected in
+      // chrome://tracing or https://ui.perfetto.dev.
+      const std::optional<std::string> trace_path =
+          colmap::GetEnvSafe("COLMAP_TRACE_PATH");
+      const bool tracing = trace_path.has_value() && !trace_path->empty();
+      colmap::SetTracingEnabled(tracing);
+      // Optionally pin the worker threads of CPU-heavy stages to NUMA nodes.
+      const std::optional<std::string> numa_aware =
+          colmap::GetEnvSafe("COLMAP_NUMA_AWARE");
+      colmap::SetNumaAwareThreading(numa_aware.has_value() &&
+                                    *numa_aware == "1");
+#if defined(COLMAP_CUDA_ENABLED)
+      // Optionally limit the device memory of the individual CUDA components.
+      const std::optional<std::string> cuda_memory_budgets =
+          colmap::GetEnvSafe("COLMAP_CUDA_MEMORY_BUDGETS");
+      if (cuda_memory_budgets.has_value()) {
+        colmap::SetCudaMemoryBudgets(*cuda_memory_budgets);
+      }
+#endif
+      std::vector<std::unique_ptr<colmap::ScopedMetricFn>> metric_fns;
+      const std::unique_ptr<colmap::MetricsWriterThread> metrics_writer =
+          MaybeStartMetricsWriter(&metric_fns);
+      const int return_code =
+          matched_command_func(command_argc, command_argv);
+      if (metrics_writer) {
+        metrics_writer->Stop();
+        metrics_writer->Wait();
+      }
+      if (tracing) {
+        colmap::SetTracingEnabled(false);
+        LOG(INFO) << "Writing trace to " << *trace_path;
+        colmap::WriteTrace(*trace_path);
+      }
+      return return_code;
     }
   }
 
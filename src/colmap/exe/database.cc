@@ -31,9 +31,13 @@
 
 #include "colmap/controllers/option_manager.h"
 #include "colmap/scene/database.h"
+#include "colmap/scene/database_mmap.h"
+#include "colmap/scene/database_shard.h"
+#include "colmap/scene/database_sqlite.h"
 #include "colmap/scene/reconstruction.h"
 #include "colmap/scene/rig.h"
 #include "colmap/util/file.h"
+#include "colmap/util/string.h"
 
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -84,6 +88,48 @@ int RunDatabaseCleaner(int argc, char** argv) {
   return EXIT_SUCCESS;
 }
 
+int RunDatabaseConverter(int argc, char** argv) {
+  std::filesystem::path input_path;
+  std::filesystem::path output_path;
+  std::string output_type = "mmap";
+  bool compress_blobs = false;
+
+  OptionManager options;
+  options.AddRequiredOption("input_path", &input_path);
+  options.AddRequiredOption("output_path", &output_path);
+  options.AddDefaultOption("output_type", &output_type, "{sqlite, mmap}");
+  options.AddDefaultOption("compress_blobs", &compress_blobs);
+  if (!options.Parse(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  if (ExistsPath(output_path)) {
+    LOG(ERROR) << "Output database must not exist.";
+    return EXIT_FAILURE;
+  }
+
+  StringToLower(&output_type);
+  std::shared_ptr<Database> output_database;
+  if (output_type == "sqlite") {
+    output_database = OpenSqliteDatabase(output_path);
+  } else if (output_type == "mmap") {
+    output_database = OpenMmapDatabase(output_path);
+  } else {
+    LOG(ERROR) << "Invalid output type";
+    return EXIT_FAILURE;
+  }
+
+  output_database->SetBlobCompression(compress_blobs);
+
+  auto input_database = Database::Open(input_path);
+  {
+    DatabaseTransaction transaction(output_database.get());
+    Database::Copy(*input_database, output_database.get());
+  }
+
+  return EXIT_SUCCESS;
+}
+
 int RunDatabaseCreator(int argc, char** argv) {
   OptionManager options;
   options.AddDatabaseOptions();
@@ -99,25 +145,92 @@ int RunDatabaseCreator(int argc, char** argv) {
 int RunDatabaseMerger(int argc, char** argv) {
   std::filesystem::path database_path1;
   std::filesystem::path database_path2;
+  std::string database_paths;
   std::filesystem::path merged_database_path;
+  bool append = false;
 
   OptionManager options;
-  options.AddRequiredOption("database_path1", &database_path1);
-  options.AddRequiredOption("database_path2", &database_path2);
+  options.AddDefaultOption("database_path1", &database_path1);
+  options.AddDefaultOption("database_path2", &database_path2);
+  options.AddDefaultOption(
+      "database_paths",
+      &database_paths,
+      "Comma-separated list of further databases to merge in one pass.");
   options.AddRequiredOption("merged_database_path", &merged_database_path);
+  options.AddDefaultOption(
+      "append",
+      &append,
+      "Whether to append the databases to an existing merged database "
+      "instead of creating a new one.");
   if (!options.Parse(argc, argv)) {
     return EXIT_FAILURE;
   }
 
-  if (ExistsFile(merged_database_path)) {
-    LOG(ERROR) << "Merged database file must not exist.";
+  std::vector<std::filesystem::path> input_paths;
+  for (const auto& path : {database_path1, database_path2}) {
+    if (!path.empty()) {
+      input_paths.push_back(path);
+    }
+  }
+  for (const std::string& path : StringSplit(database_paths, ",")) {
+    if (!path.empty()) {
+      input_paths.emplace_back(path);
+    }
+  }
+  if (input_paths.empty()) {
+    LOG(ERROR) << "At least one database to merge must be specified.";
+    return EXIT_FAILURE;
+  }
+
+  if (!append && ExistsFile(merged_database_path)) {
+    LOG(ERROR) << "Merged database file must not exist. Use --append 1 to "
+                  "merge into an existing database.";
     return EXIT_FAILURE;
   }
 
-  auto database1 = Database::Open(database_path1);
-  auto database2 = Database::Open(database_path2);
+  std::vector<std::shared_ptr<Database>> databases;
+  std::vector<const Database*> database_ptrs;
+  for (const auto& path : input_paths) {
+    databases.push_back(Database::Open(path));
+    database_ptrs.push_back(databases.back().get());
+  }
   auto merged_database = Database::Open(merged_database_path);
-  Database::Merge(*database1, *database2, merged_database.get());
+  Database::Merge(database_ptrs, merged_database.get());
+
+  return EXIT_SUCCESS;
+}
+
+int RunDatabaseShardReducer(int argc, char** argv) {
+  std::filesystem::path database_path;
+  std::string shard_paths;
+
+  OptionManager options;
+  options.AddRequiredOption("database_path", &database_path);
+  options.AddRequiredOption(
+      "shard_paths",
+      &shard_paths,
+      "Comma-separated list of shard databases written by the matchers with "
+      "--FeatureMatching.shard_database_path.");
+  if (!options.Parse(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::shared_ptr<Database>> shards;
+  std::vector<const Database*> shard_ptrs;
+  for (const std::string& path : StringSplit(shard_paths, ",")) {
+    if (path.empty()) {
+      continue;
+    }
+    if (!ExistsFile(path)) {
+      LOG(ERROR) << "Shard database " << path << " does not exist.";
+      return EXIT_FAILURE;
+    }
+    shards.push_back(Database::Open(path));
+    shard_ptrs.push_back(shards.back().get());
+  }
+
+  auto database = Database::Open(database_path);
+  ReduceDatabaseShards(shard_ptrs, database.get());
 
   return EXIT_SUCCESS;
 }
@@ -32,8 +32,10 @@
 namespace colmap {
 
 int RunDatabaseCleaner(int argc, char** argv);
+int RunDatabaseConverter(int argc, char** argv);
 int RunDatabaseCreator(int argc, char** argv);
 int RunDatabaseMerger(int argc, char** argv);
+int RunDatabaseShardReducer(int argc, char** argv);
 int RunRigConfigurator(int argc, char** argv);
 
 }  // namespace colmap
@@ -387,6 +387,35 @@ int RunVocabTreeMatcher(int argc, char** argv) {
   return EXIT_SUCCESS;
 }
 
+int RunGlobalDescriptorMatcher(int argc, char** argv) {
+  OptionManager options;
+  options.AddDatabaseOptions();
+  options.AddGlobalDescriptorPairingOptions();
+  if (!options.Parse(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  std::unique_ptr<QApplication> app;
+  if (options.feature_matching->RequiresOpenGL()) {
+    app = std::make_unique<QApplication>(argc, argv);
+  }
+
+  auto matcher =
+      CreateGlobalDescriptorFeatureMatcher(*options.global_descriptor_pairing,
+                                           *options.feature_matching,
+                                           *options.two_view_geometry,
+                                           *options.database_path);
+
+  if (app != nullptr) {
+    RunThreadWithOpenGLContext(matcher.get());
+  } else {
+    matcher->Start();
+    matcher->Wait();
+  }
+
+  return EXIT_SUCCESS;
+}
+
 int RunGeometricVerifier(int argc, char** argv) {
   ExistingMatchedPairingOptions pairing_options;
   GeometricVerifierOptions verifier_options;
@@ -91,6 +91,7 @@ void RunGuidedGeometricVerifierImpl(
 int RunFeatureExtractor(int argc, char** argv);
 int RunFeatureImporter(int argc, char** argv);
 int RunExhaustiveMatcher(int argc, char** argv);
+int RunGlobalDescriptorMatcher(int argc, char** argv);
 int RunMatchesImporter(int argc, char** argv);
 int RunSequentialMatcher(int argc, char** argv);
 int RunSpatialMatcher(int argc, char** argv);
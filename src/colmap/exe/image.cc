@@ -29,19 +29,28 @@
 
 #include "colmap/exe/image.h"
 
+#include "colmap/controllers/image_reader.h"
 #include "colmap/controllers/incremental_pipeline.h"
+#include "colmap/controllers/localizer.h"
 #include "colmap/controllers/option_manager.h"
 #include "colmap/controllers/undistorters.h"
+#include "colmap/exe/feature.h"
+#include "colmap/feature/extractor.h"
+#include "colmap/scene/database.h"
 #include "colmap/scene/reconstruction.h"
+#include "colmap/sensor/bitmap.h"
 #include "colmap/sfm/incremental_mapper.h"
 #include "colmap/sfm/observation_manager.h"
 #include "colmap/util/base_controller.h"
 #include "colmap/util/misc.h"
 #include "colmap/util/string.h"
+#include "colmap/util/threading.h"
 #include "colmap/util/timer.h"
 
 #include <fstream>
+#include <iostream>
 #include <locale>
+#include <mutex>
 #include <sstream>
 
 namespace colmap {
@@ -324,6 +333,222 @@ int RunImageRegistrator(int argc, char** argv) {
   return EXIT_SUCCESS;
 }
 
+// Localizes query images against a fixed reconstruction. The reconstruction,
+// the visual index and the descriptors of the registered images are loaded
+// once and kept in memory, while query image names relative to the image path
+// are read line by line from the standard input until it is closed. The poses
+// are written in completion order to the standard output, one line per query:
+//
+//      IMAGE_NAME QW QX QY QZ TX TY TZ NUM_INLIERS
+//      IMAGE_NAME FAILED
+//
+int RunLocalizationServer(int argc, char** argv) {
+  std::filesystem::path input_path;
+  std::filesystem::path vocab_tree_path;
+  int num_workers = -1;
+  LocalizerOptions localizer_options;
+
+  OptionManager options;
+  options.AddDatabaseOptions();
+  options.AddImageOptions();
+  options.AddRequiredOption("input_path", &input_path);
+  options.AddDefaultOption("vocab_tree_path", &vocab_tree_path);
+  options.AddDefaultOption("num_workers", &num_workers);
+  options.AddDefaultOption("Localizer.num_images",
+                           &localizer_options.num_images);
+  options.AddDefaultOption("Localizer.num_nearest_neighbors",
+                           &localizer_options.num_nearest_neighbors);
+  options.AddDefaultOption("Localizer.num_checks",
+                           &localizer_options.num_checks);
+  options.AddDefaultOption("Localizer.num_images_after_verification",
+                           &localizer_options.num_images_after_verification);
+  options.AddDefaultOption("Localizer.max_num_features",
+                           &localizer_options.max_num_features);
+  options.AddDefaultOption("Localizer.max_ratio", &localizer_options.max_ratio);
+  options.AddDefaultOption("Localizer.min_num_inliers",
+                           &localizer_options.min_num_inliers);
+  options.AddDefaultOption(
+      "Localizer.abs_pose_max_error",
+      &localizer_options.abs_pose_options.ransac_options.max_error);
+  options.AddDefaultOption("Localizer.estimate_unknown_focal_length",
+                           &localizer_options.estimate_unknown_focal_length);
+  options.AddDefaultOption("Localizer.refine_pose",
+                           &localizer_options.refine_pose);
+  options.AddDefaultOption("Localizer.num_threads",
+                           &localizer_options.num_threads);
+  options.AddFeatureExtractionOptions();
+  if (!options.Parse(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  if (!ExistsDir(input_path)) {
+    LOG(ERROR) << "`input_path` is not a directory";
+    return EXIT_FAILURE;
+  }
+
+  const ImageReaderOptions& reader_options = *options.image_reader;
+  if (!ExistsCameraModelWithName(reader_options.camera_model)) {
+    LOG(ERROR) << "Camera model does not exist";
+    return EXIT_FAILURE;
+  }
+
+  if (!VerifyCameraParams(reader_options.camera_model,
+                          reader_options.camera_params)) {
+    return EXIT_FAILURE;
+  }
+
+  const FeatureExtractionOptions& extraction_options =
+      *options.feature_extraction;
+  if (extraction_options.RequiresOpenGL()) {
+    LOG(ERROR) << "Feature extraction with OpenGL is not supported by the "
+                  "localization server, use CPU or CUDA extraction instead";
+    return EXIT_FAILURE;
+  }
+
+  LOG_HEADING1("Loading model");
+
+  std::unique_ptr<Localizer> localizer;
+
+  {
+    Timer timer;
+    timer.Start();
+
+    auto reconstruction = std::make_shared<Reconstruction>();
+    reconstruction->Read(input_path);
+
+    std::unique_ptr<retrieval::VisualIndex> visual_index;
+    if (!vocab_tree_path.empty()) {
+      visual_index = retrieval::VisualIndex::Read(vocab_tree_path);
+    }
+
+    auto database = Database::Open(*options.database_path);
+    localizer = std::make_unique<Localizer>(localizer_options,
+                                            std::move(reconstruction),
+                                            *database,
+                                            std::move(visual_index));
+
+    timer.PrintMinutes();
+  }
+
+  LOG_HEADING1("Localizing images");
+
+  const int max_image_size = extraction_options.EffMaxImageSize();
+  const CameraModelId camera_model_id =
+      CameraModelNameToId(reader_options.camera_model);
+
+  std::mutex output_mutex;
+  const auto LocalizeImage = [&](FeatureExtractor* extractor,
+                                 const std::string& image_name) {
+    Timer timer;
+    timer.Start();
+
+    std::optional<LocalizationResult> result;
+
+    Bitmap bitmap;
+    if (bitmap.Read(*options.image_path / image_name,
+                    extraction_options.RequiresRGB())) {
+      const int width = bitmap.Width();
+      const int height = bitmap.Height();
+
+      Camera camera;
+      if (reader_options.camera_params.empty()) {
+        const std::optional<double> focal_length = bitmap.ExifFocalLength();
+        camera = Camera::CreateFromModelId(
+            kInvalidCameraId,
+            camera_model_id,
+            focal_length.value_or(reader_options.default_focal_length_factor *
+                                  std::max(width, height)),
+            width,
+            height);
+        camera.has_prior_focal_length = focal_length.has_value();
+      } else {
+        camera.model_id = camera_model_id;
+        camera.width = width;
+        camera.height = height;
+        THROW_CHECK(camera.SetParamsFromString(reader_options.camera_params));
+        camera.has_prior_focal_length = true;
+      }
+
+      if (std::max(width, height) > max_image_size) {
+        bitmap.Thumbnail(max_image_size);
+      }
+
+      FeatureKeypoints keypoints;
+      FeatureDescriptors descriptors;
+      if (extractor->Extract(bitmap, &keypoints, &descriptors)) {
+        if (bitmap.Width() != width || bitmap.Height() != height) {
+          const float scale_x = static_cast<float>(width) / bitmap.Width();
+          const float scale_y = static_cast<float>(height) / bitmap.Height();
+          for (auto& keypoint : keypoints) {
+            keypoint.Rescale(scale_x, scale_y);
+          }
+        }
+        result = localizer->Localize(camera, keypoints, descriptors);
+      }
+    } else {
+      LOG(ERROR) << "Failed to read image " << image_name;
+    }
+
+    std::ostringstream line;
+    line.precision(17);
+    line << image_name;
+    if (result.has_value()) {
+      const Rigid3d& cam_from_world = result->cam_from_world;
+      line << " " << cam_from_world.rotation().w() << " "
+           << cam_from_world.rotation().x() << " "
+           << cam_from_world.rotation().y() << " "
+           << cam_from_world.rotation().z() << " "
+           << cam_from_world.translation().x() << " "
+           << cam_from_world.translation().y() << " "
+           << cam_from_world.translation().z() << " " << result->num_inliers;
+    } else {
+      line << " FAILED";
+    }
+
+    VLOG(1) << StringPrintf("Localized image %s in %.3fs",
+                            image_name.c_str(),
+                            timer.ElapsedSeconds());
+
+    std::lock_guard<std::mutex> lock(output_mutex);
+    std::cout << line.str() << std::endl;
+  };
+
+  // Each worker owns a feature extractor and processes queries until the
+  // input is exhausted. The bounded queue keeps the reader from running
+  // arbitrarily far ahead of the workers.
+  const int eff_num_workers = GetEffectiveNumThreads(num_workers);
+  JobQueue<std::string> query_queue(eff_num_workers);
+  ThreadPool thread_pool(eff_num_workers);
+  for (int i = 0; i < eff_num_workers; ++i) {
+    thread_pool.AddTask([&]() {
+      FeatureExtractionOptions worker_extraction_options = extraction_options;
+      worker_extraction_options.num_threads = 1;
+      std::unique_ptr<FeatureExtractor> extractor =
+          FeatureExtractor::Create(worker_extraction_options);
+      while (true) {
+        auto query = query_queue.Pop();
+        if (!query.IsValid()) {
+          break;
+        }
+        LocalizeImage(extractor.get(), query.Data());
+      }
+    });
+  }
+
+  std::string image_name;
+  while (std::getline(std::cin, image_name)) {
+    StringTrim(&image_name);
+    if (!image_name.empty()) {
+      query_queue.Push(std::move(image_name));
+    }
+  }
+
+  query_queue.Wait();
+  thread_pool.Wait();
+
+  return EXIT_SUCCESS;
+}
+
 int RunImageUndistorter(int argc, char** argv) {
   std::filesystem::path input_path;
   std::filesystem::path output_path;
@@ -355,6 +580,8 @@ int RunImageUndistorter(int argc, char** argv) {
   options.AddDefaultOption("roi_min_y", &undistort_camera_options.roi_min_y);
   options.AddDefaultOption("roi_max_x", &undistort_camera_options.roi_max_x);
   options.AddDefaultOption("roi_max_y", &undistort_camera_options.roi_max_y);
+  options.AddDefaultOption("warp_map_max_error",
+                           &undistort_camera_options.warp_map_max_error);
   options.AddDefaultOption("num_patch_match_src_images",
                            &undistorter_options.num_patch_match_src_images);
   options.AddDefaultOption("jpeg_quality", &jpeg_quality);
@@ -449,6 +676,8 @@ int RunImageUndistorterStandalone(int argc, char** argv) {
   options.AddDefaultOption("roi_min_y", &undistort_camera_options.roi_min_y);
   options.AddDefaultOption("roi_max_x", &undistort_camera_options.roi_max_x);
   options.AddDefaultOption("roi_max_y", &undistort_camera_options.roi_max_y);
+  options.AddDefaultOption("warp_map_max_error",
+                           &undistort_camera_options.warp_map_max_error);
   options.AddDefaultOption("jpeg_quality", &undistorter_options.jpeg_quality);
   options.AddDefaultOption("num_threads", &num_threads);
   if (!options.Parse(argc, argv)) {
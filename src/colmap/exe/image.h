@@ -35,6 +35,7 @@ int RunImageDeleter(int argc, char** argv);
 int RunImageFilterer(int argc, char** argv);
 int RunImageRectifier(int argc, char** argv);
 int RunImageRegistrator(int argc, char** argv);
+int RunLocalizationServer(int argc, char** argv);
 int RunImageUndistorter(int argc, char** argv);
 int RunImageUndistorterStandalone(int argc, char** argv);
 
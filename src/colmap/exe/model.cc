@@ -42,10 +42,12 @@
 #include "colmap/sfm/observation_manager.h"
 #include "colmap/util/file.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/quantized_points.h"
 #include "colmap/util/threading.h"
 
 #include <fstream>
 #include <locale>
+#include <optional>
 #include <unordered_map>
 
 namespace colmap {
@@ -214,6 +216,31 @@ void PrintComparisonSummary(std::ostream& out,
   PrintErrorStats(out, summary.proj_center_errors);
 }
 
+// Returns the memory-mapped 3D points of a binary model stored in the
+// points3D.mbin format. In this case, only the rigs, cameras, frames, and
+// images are loaded into the reconstruction and the points are left in the
+// mapping, so that large models can be inspected without parsing them.
+std::optional<MappedPoints3D> ReadModelWithMappedPoints3D(
+    const std::filesystem::path& path, Reconstruction& reconstruction) {
+  const auto mapped_points3D_path = path / "points3D.mbin";
+  if (ExistsFile(path / "points3D.bin") || !ExistsFile(mapped_points3D_path)) {
+    reconstruction.Read(path);
+    return std::nullopt;
+  }
+
+  ReadCamerasBinary(reconstruction, path / "cameras.bin");
+  const auto rigs_path = path / "rigs.bin";
+  if (ExistsFile(rigs_path)) {
+    ReadRigsBinary(reconstruction, rigs_path);
+  }
+  const auto frames_path = path / "frames.bin";
+  if (ExistsFile(frames_path)) {
+    ReadFramesBinary(reconstruction, frames_path);
+  }
+  ReadImagesBinary(reconstruction, path / "images.bin");
+  return std::make_optional<MappedPoints3D>(mapped_points3D_path);
+}
+
 }  // namespace
 
 // Align given reconstruction with user provided cameras positions
@@ -435,7 +462,29 @@ int RunModelAnalyzer(int argc, char** argv) {
   }
 
   Reconstruction reconstruction;
-  reconstruction.Read(path);
+  const std::optional<MappedPoints3D> mapped_points3D =
+      ReadModelWithMappedPoints3D(path, reconstruction);
+
+  size_t num_points3D = reconstruction.NumPoints3D();
+  double mean_reproj_error = 0;
+  if (mapped_points3D.has_value()) {
+    num_points3D = mapped_points3D->NumPoints3D();
+    size_t num_valid_errors = 0;
+    for (size_t i = 0; i < num_points3D; ++i) {
+      const MappedPoint3D& point3D = mapped_points3D->Point3D(i);
+      if (point3D.error != -1) {
+        mean_reproj_error += point3D.error;
+        num_valid_errors += 1;
+      }
+    }
+    if (num_valid_errors > 0) {
+      mean_reproj_error /= num_valid_errors;
+    }
+  } else {
+    mean_reproj_error = reconstruction.ComputeMeanReprojectionError();
+  }
+
+  const size_t num_observations = reconstruction.ComputeNumObservations();
 
   LOG(INFO) << StringPrintf("Rigs: %d", reconstruction.NumRigs());
   LOG(INFO) << StringPrintf("Cameras: %d", reconstruction.NumCameras());
@@ -445,16 +494,17 @@ int RunModelAnalyzer(int argc, char** argv) {
   LOG(INFO) << StringPrintf("Images: %d", reconstruction.NumImages());
   LOG(INFO) << StringPrintf("Registered images: %d",
                             reconstruction.NumRegImages());
-  LOG(INFO) << StringPrintf("Points: %d", reconstruction.NumPoints3D());
-  LOG(INFO) << StringPrintf("Observations: %d",
-                            reconstruction.ComputeNumObservations());
-  LOG(INFO) << StringPrintf("Mean track length: %f",
-                            reconstruction.ComputeMeanTrackLength());
+  LOG(INFO) << StringPrintf("Points: %d", num_points3D);
+  LOG(INFO) << StringPrintf("Observations: %d", num_observations);
+  LOG(INFO) << StringPrintf(
+      "Mean track length: %f",
+      num_points3D == 0 ? 0.0
+                        : num_observations / static_cast<double>(num_points3D));
   LOG(INFO) << StringPrintf(
       "Mean observations per image: %f",
       reconstruction.ComputeMeanObservationsPerRegImage());
   LOG(INFO) << StringPrintf("Mean reprojection error: %fpx",
-                            reconstruction.ComputeMeanReprojectionError());
+                            mean_reproj_error);
 
   // verbose information
   if (verbose) {
@@ -639,20 +689,43 @@ int RunModelConverter(int argc, char** argv) {
   OptionManager options;
   options.AddRequiredOption("input_path", &input_path);
   options.AddRequiredOption("output_path", &output_path);
-  options.AddRequiredOption("output_type",
-                            &output_type,
-                            "{BIN, TXT, NVM, Bundler, VRML, PLY, R3D, CAM}");
+  options.AddRequiredOption(
+      "output_type",
+      &output_type,
+      "{BIN, MBIN, TXT, NVM, Bundler, VRML, PLY, QPC, R3D, CAM}");
   options.AddDefaultOption("skip_distortion", &skip_distortion);
   if (!options.Parse(argc, argv)) {
     return EXIT_FAILURE;
   }
 
+  StringToLower(&output_type);
+
+  // Point clouds can be exported directly from the mapped 3D points.
   Reconstruction reconstruction;
-  reconstruction.Read(input_path);
+  const std::optional<MappedPoints3D> mapped_points3D =
+      ReadModelWithMappedPoints3D(input_path, reconstruction);
+  if (mapped_points3D.has_value()) {
+    if (output_type == "ply") {
+      WriteBinaryPlyPoints(output_path,
+                           mapped_points3D->ConvertToPLY(),
+                           /*write_normal=*/false,
+                           /*write_rgb=*/true);
+      return EXIT_SUCCESS;
+    } else if (output_type == "qpc") {
+      QuantizedPointsOptions quantized_points_options;
+      quantized_points_options.write_normal = false;
+      WriteQuantizedPoints(output_path,
+                           mapped_points3D->ConvertToPLY(),
+                           quantized_points_options);
+      return EXIT_SUCCESS;
+    }
+    ReadPoints3DMapped(reconstruction, *mapped_points3D);
+  }
 
-  StringToLower(&output_type);
   if (output_type == "bin") {
     reconstruction.WriteBinary(output_path);
+  } else if (output_type == "mbin") {
+    reconstruction.WriteMappedBinary(output_path);
   } else if (output_type == "txt") {
     reconstruction.WriteText(output_path);
   } else if (output_type == "nvm") {
@@ -668,6 +741,11 @@ int RunModelConverter(int argc, char** argv) {
     ExportCam(reconstruction, output_path, skip_distortion);
   } else if (output_type == "ply") {
     ExportPLY(reconstruction, output_path);
+  } else if (output_type == "qpc") {
+    QuantizedPointsOptions quantized_points_options;
+    quantized_points_options.write_normal = false;
+    WriteQuantizedPoints(
+        output_path, reconstruction.ConvertToPLY(), quantized_points_options);
   } else if (output_type == "vrml") {
     const auto base_path = output_path.parent_path() / output_path.stem();
     ExportVRML(reconstruction,
@@ -827,6 +905,8 @@ int RunModelOrientationAligner(int argc, char** argv) {
 #endif
   options.AddDefaultOption("max_image_size",
                            &frame_estimation_options.max_image_size);
+  options.AddDefaultOption("num_threads",
+                           &frame_estimation_options.num_threads);
   if (!options.Parse(argc, argv)) {
     return EXIT_FAILURE;
   }
@@ -1022,6 +1102,8 @@ int RunModelSplitter(int argc, char** argv) {
   }
 
   LOG_HEADING2("Applying split and writing reconstructions");
+  // Index the points once instead of scanning all points for every part.
+  reconstruction.BuildPoints3DIndex();
   const size_t num_parts = padded_bboxes.size();
   LOG(INFO) << StringPrintf("=> Splitting to %d parts", num_parts);
 
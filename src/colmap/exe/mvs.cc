@@ -34,6 +34,7 @@
 #include "colmap/mvs/delaunay_meshing.h"
 #include "colmap/mvs/fusion.h"
 #include "colmap/mvs/mesh_simplification.h"
+#include "colmap/mvs/mesh_tiling.h"
 #include "colmap/mvs/model.h"
 #include "colmap/mvs/patch_match.h"
 #include "colmap/mvs/patch_match_options.h"
@@ -42,6 +43,8 @@
 #include "colmap/scene/reconstruction.h"
 #include "colmap/util/file.h"
 #include "colmap/util/ply.h"
+#include "colmap/util/quantized_points.h"
+#include "colmap/util/resource_usage.h"
 
 #include <utility>
 
@@ -143,6 +146,37 @@ int RunMeshSimplifier(int argc, char** argv) {
   return EXIT_SUCCESS;
 }
 
+int RunMeshTiler(int argc, char** argv) {
+  std::filesystem::path input_path;
+  std::filesystem::path output_path;
+
+  OptionManager options;
+  options.AddRequiredOption(
+      "input_path", &input_path, "Path to input PLY mesh");
+  options.AddRequiredOption(
+      "output_path",
+      &output_path,
+      "Path to the output directory. The tiles and the tile index will be "
+      "written here");
+  options.AddMeshTilingOptions();
+  if (!options.Parse(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  THROW_CHECK_HAS_FILE_EXTENSION(input_path, ".ply");
+  THROW_CHECK_FILE_EXISTS(input_path);
+  CreateDirIfNotExists(output_path);
+
+  LOG(INFO) << "Reading mesh from " << input_path;
+  const PlyMesh mesh = ReadPlyMesh(input_path).mesh;
+  LOG(INFO) << "Input mesh: " << mesh.vertices.size() << " vertices, "
+            << mesh.faces.size() << " faces";
+
+  mvs::WriteMeshTiles(*options.mesh_tiling, mesh, output_path);
+
+  return EXIT_SUCCESS;
+}
+
 int RunMeshTexturer(int argc, char** argv) {
   std::filesystem::path workspace_path;
   std::filesystem::path input_path;
@@ -249,6 +283,12 @@ int RunPatchMatchStereo(int argc, char** argv) {
                           pmvs_option_name,
                           *options.patch_match_stereo,
                           config_path);
+
+  const std::filesystem::path resource_usage_path =
+      workspace_path / "resource_usage.json";
+  WriteResourceUsageSummary(resource_usage_path);
+  LOG(INFO) << "Wrote resource usage to " << resource_usage_path;
+
   return EXIT_SUCCESS;
 }
 
@@ -257,10 +297,6 @@ void RunPatchMatchStereoImpl(const std::filesystem::path& workspace_path,
                              const std::string& pmvs_option_name,
                              const mvs::PatchMatchOptions& options,
                              const std::filesystem::path& config_path) {
-#if !defined(COLMAP_CUDA_ENABLED)
-  LOG(FATAL_THROW) << "Dense stereo reconstruction requires CUDA, which is not "
-                      "available on your system.";
-#else   // COLMAP_CUDA_ENABLED
   std::string workspace_format_lower = workspace_format;
   StringToLower(&workspace_format_lower);
   THROW_CHECK(workspace_format_lower == "colmap" ||
@@ -275,7 +311,6 @@ void RunPatchMatchStereoImpl(const std::filesystem::path& workspace_path,
                                        config_path);
 
   controller.Run();
-#endif  // COLMAP_CUDA_ENABLED
 }
 
 int RunPoissonMesher(int argc, char** argv) {
@@ -311,7 +346,8 @@ int RunStereoFuser(int argc, char** argv) {
   options.AddDefaultOption("pmvs_option_name", &pmvs_option_name);
   options.AddDefaultOption(
       "input_type", &input_type, "{photometric, geometric}");
-  options.AddDefaultOption("output_type", &output_type, "{BIN, TXT, PLY}");
+  options.AddDefaultOption(
+      "output_type", &output_type, "{BIN, TXT, PLY, QPC}");
   options.AddRequiredOption("output_path", &output_path);
   options.AddStereoFusionOptions();
   if (!options.Parse(argc, argv)) {
@@ -348,9 +384,9 @@ Reconstruction RunStereoFuserImpl(const std::filesystem::path& output_path,
 
   StringToLower(&output_type);
   THROW_CHECK(output_type == "bin" || output_type == "ply" ||
-              output_type == "txt")
+              output_type == "qpc" || output_type == "txt")
       << "Invalid `output_type` " << output_type
-      << " - supported values are 'bin', 'ply' and 'txt'.";
+      << " - supported values are 'bin', 'ply', 'qpc' and 'txt'.";
 
   mvs::StereoFusion fuser(
       options, workspace_path, workspace_format, pmvs_option_name, input_type);
@@ -364,6 +400,12 @@ Reconstruction RunStereoFuserImpl(const std::filesystem::path& output_path,
     reconstruction.Read(workspace_path / "sparse");
   }
 
+  if (!options.stream_output_path.empty()) {
+    LOG(INFO) << "Fused points were streamed to: "
+              << options.stream_output_path;
+    return reconstruction;
+  }
+
   // overwrite sparse point cloud with dense point cloud from fuser
   reconstruction.ImportPLY(fuser.GetFusedPoints());
 
@@ -378,6 +420,8 @@ Reconstruction RunStereoFuserImpl(const std::filesystem::path& output_path,
     WriteBinaryPlyPoints(output_path, fuser.GetFusedPoints());
     mvs::WritePointsVisibility(AddFileExtension(output_path, ".vis"),
                                fuser.GetFusedPointsVisibility());
+  } else if (output_type == "qpc") {
+    WriteQuantizedPoints(output_path, fuser.GetFusedPoints());
   } else {
     LOG(FATAL_THROW) << "Invalid output_type: " << output_type;
   }
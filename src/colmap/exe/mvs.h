@@ -55,6 +55,7 @@ int RunAdvancingFrontMesher(int argc, char** argv);
 int RunDelaunayMesher(int argc, char** argv);
 int RunMeshSimplifier(int argc, char** argv);
 int RunMeshTexturer(int argc, char** argv);
+int RunMeshTiler(int argc, char** argv);
 int RunPatchMatchStereo(int argc, char** argv);
 int RunPoissonMesher(int argc, char** argv);
 int RunStereoFuser(int argc, char** argv);
@@ -44,6 +44,7 @@
 #include "colmap/util/file.h"
 #include "colmap/util/misc.h"
 #include "colmap/util/opengl_utils.h"
+#include "colmap/util/resource_usage.h"
 
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -114,6 +115,10 @@ int RunAutomaticReconstructor(int argc, char** argv) {
   options.AddDefaultOption("matching", &reconstruction_options.matching);
   options.AddDefaultOption("sparse", &reconstruction_options.sparse);
   options.AddDefaultOption("dense", &reconstruction_options.dense);
+  options.AddDefaultOption("pipelined", &reconstruction_options.pipelined);
+  options.AddDefaultOption("progressive", &reconstruction_options.progressive);
+  options.AddDefaultOption("progressive_num_features",
+                           &reconstruction_options.progressive_num_features);
   options.AddDefaultOption("feature", &feature, "{sift, aliked}");
   options.AddDefaultOption(
       "mapper", &mapper, "{incremental, hierarchical, global}");
@@ -169,6 +174,11 @@ int RunAutomaticReconstructor(int argc, char** argv) {
     controller.Wait();
   }
 
+  const std::filesystem::path resource_usage_path =
+      reconstruction_options.workspace_path / "resource_usage.json";
+  WriteResourceUsageSummary(resource_usage_path);
+  LOG(INFO) << "Wrote resource usage to " << resource_usage_path;
+
   return EXIT_SUCCESS;
 }
 
@@ -366,6 +376,11 @@ int RunMapper(int argc, char** argv) {
     }
   }
 
+  const std::filesystem::path resource_usage_path =
+      output_path / "resource_usage.json";
+  WriteResourceUsageSummary(resource_usage_path);
+  LOG(INFO) << "Wrote resource usage to " << resource_usage_path;
+
   return EXIT_SUCCESS;
 }
 
@@ -393,11 +408,13 @@ bool RunGlobalMapperImpl(
 }
 
 int RunGlobalMapper(int argc, char** argv) {
+  std::filesystem::path input_path;
   std::filesystem::path output_path;
 
   OptionManager options;
   options.AddDatabaseOptions();
   options.AddImageOptions();
+  options.AddDefaultOption("input_path", &input_path);
   options.AddRequiredOption("output_path", &output_path);
   options.AddGlobalMapperOptions();
   if (!options.Parse(argc, argv)) {
@@ -410,6 +427,19 @@ int RunGlobalMapper(int argc, char** argv) {
   }
 
   auto reconstruction_manager = std::make_shared<ReconstructionManager>();
+  if (!input_path.empty()) {
+    if (!ExistsDir(input_path)) {
+      LOG(ERROR) << "`input_path` is not a directory.";
+      return EXIT_FAILURE;
+    }
+    if (!options.global_mapper->mapper.extend_reconstruction) {
+      LOG(ERROR) << "`input_path` requires "
+                    "`GlobalMapper.extend_reconstruction`.";
+      return EXIT_FAILURE;
+    }
+    reconstruction_manager->Read(input_path);
+  }
+
   if (!RunGlobalMapperImpl(*options.database_path,
                            *options.image_path,
                            output_path,
@@ -432,6 +462,7 @@ int RunHierarchicalMapper(int argc, char** argv) {
   options.AddRequiredOption("output_path", &output_path);
   options.AddHierarchicalMapperOptions();
   options.AddMapperOptions();
+  options.AddGlobalMapperOptions();
   if (!options.Parse(argc, argv)) {
     return EXIT_FAILURE;
   }
@@ -442,6 +473,7 @@ int RunHierarchicalMapper(int argc, char** argv) {
   }
 
   options.hierarchical_mapper->incremental_options = *options.mapper;
+  options.hierarchical_mapper->global_options = *options.global_mapper;
   auto reconstruction_manager = std::make_shared<ReconstructionManager>();
   HierarchicalPipeline hierarchical_mapper(
       *options.hierarchical_mapper,
@@ -460,6 +492,30 @@ int RunHierarchicalMapper(int argc, char** argv) {
   return EXIT_SUCCESS;
 }
 
+int RunHierarchicalMapperWorker(int argc, char** argv) {
+  OptionManager options;
+  options.AddDefaultOption("image_path",
+                           &options.hierarchical_mapper->image_path);
+  options.AddHierarchicalMapperOptions();
+  options.AddMapperOptions();
+  options.AddGlobalMapperOptions();
+  if (!options.Parse(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  if (options.hierarchical_mapper->job_queue_path.empty()) {
+    LOG(ERROR) << "`HierarchicalMapper.job_queue_path` must be set.";
+    return EXIT_FAILURE;
+  }
+
+  options.hierarchical_mapper->incremental_options = *options.mapper;
+  options.hierarchical_mapper->global_options = *options.global_mapper;
+  HierarchicalClusterWorker worker(*options.hierarchical_mapper);
+  worker.Run();
+
+  return EXIT_SUCCESS;
+}
+
 int RunPosePriorMapper(int argc, char** argv) {
   std::filesystem::path input_path;
   std::filesystem::path output_path;
@@ -722,6 +778,14 @@ int RunViewGraphCalibrator(int argc, char** argv) {
   options.AddDefaultOption("reestimate_relative_pose",
                            &calibration_options.reestimate_relative_pose,
                            "Re-estimate relative poses after calibration");
+  options.AddDefaultOption(
+      "skip_unchanged_pairs",
+      &calibration_options.skip_unchanged_pairs,
+      "Keep calibrated pairs whose cameras' focal lengths did not change");
+  options.AddDefaultOption(
+      "max_unchanged_focal_length_change",
+      &calibration_options.max_unchanged_focal_length_change,
+      "Maximum relative focal length change of an unchanged camera");
   options.AddDefaultOption("min_focal_length_ratio",
                            &calibration_options.min_focal_length_ratio,
                            "Minimum ratio of estimated to prior focal length");
@@ -69,6 +69,7 @@ int RunColorExtractor(int argc, char** argv);
 int RunMapper(int argc, char** argv);
 int RunGlobalMapper(int argc, char** argv);
 int RunHierarchicalMapper(int argc, char** argv);
+int RunHierarchicalMapperWorker(int argc, char** argv);
 int RunPosePriorMapper(int argc, char** argv);
 int RunPointFiltering(int argc, char** argv);
 int RunPointTriangulator(int argc, char** argv);
@@ -77,6 +77,8 @@ int RunVocabTreeBuilder(int argc, char** argv) {
   options.AddDefaultOption("num_checks", &build_options.num_checks);
   options.AddDefaultOption("num_threads", &build_options.num_threads);
   options.AddDefaultOption("num_rounds", &build_options.num_rounds);
+  options.AddDefaultOption("use_gpu", &build_options.use_gpu);
+  options.AddDefaultOption("gpu_index", &build_options.gpu_index);
   options.AddDefaultOption("max_num_descriptors", &max_num_descriptors);
   if (!options.Parse(argc, argv)) {
     return EXIT_FAILURE;
@@ -108,6 +110,7 @@ int RunVocabTreeRetriever(int argc, char** argv) {
   std::filesystem::path database_image_list_path;
   std::filesystem::path query_image_list_path;
   std::filesystem::path output_index_path;
+  int max_num_delta_segments = 0;
   retrieval::VisualIndex::QueryOptions query_options;
   retrieval::VisualIndex::IndexOptions index_options;
   int max_num_features = -1;
@@ -119,6 +122,7 @@ int RunVocabTreeRetriever(int argc, char** argv) {
                            &database_image_list_path);
   options.AddDefaultOption("query_image_list_path", &query_image_list_path);
   options.AddDefaultOption("output_index_path", &output_index_path);
+  options.AddDefaultOption("max_num_delta_segments", &max_num_delta_segments);
   options.AddDefaultOption("num_images", &query_options.max_num_images);
   options.AddDefaultOption("num_neighbors", &query_options.num_neighbors);
   options.AddDefaultOption("num_checks", &query_options.num_checks);
@@ -181,8 +185,17 @@ int RunVocabTreeRetriever(int argc, char** argv) {
 
   // Optionally save the indexing data for the database images (as well as the
   // original vocabulary tree data) to speed up future indexing.
+  // If the output index is the input index, newly indexed images are appended
+  // as a delta segment instead of rewriting the whole index, until the index
+  // has max_num_delta_segments segments and is compacted again.
   if (!output_index_path.empty()) {
-    visual_index->Write(output_index_path);
+    if (visual_index->NumDeltaSegments() < max_num_delta_segments &&
+        ExistsFile(output_index_path) && ExistsFile(vocab_tree_path) &&
+        std::filesystem::equivalent(output_index_path, vocab_tree_path)) {
+      visual_index->AppendImages(output_index_path);
+    } else {
+      visual_index->Write(output_index_path);
+    }
   }
 
   if (query_images.empty()) {
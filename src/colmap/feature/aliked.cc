@@ -33,6 +33,7 @@
 #include "colmap/feature/onnx_utils.h"
 
 #include <algorithm>
+#include <map>
 #include <memory>
 
 namespace colmap {
@@ -52,30 +53,6 @@ const std::string& GetExtractorModelPath(
   }
 }
 
-// Convert bitmap to row-major [C, H, W] float tensor, normalized to [0, 1].
-std::vector<float> BitmapToInputTensor(const Bitmap& bitmap) {
-  THROW_CHECK(bitmap.IsRGB());
-
-  const int width = bitmap.Width();
-  const int height = bitmap.Height();
-  const int pitch = bitmap.Pitch();
-  const int num_pixels = width * height;
-
-  std::vector<float> input(num_pixels * 3);
-  const std::vector<uint8_t>& data = bitmap.RowMajorData();
-  for (int y = 0; y < height; ++y) {
-    for (int x = 0; x < width; ++x) {
-      for (int c = 0; c < 3; ++c) {
-        constexpr float kImageNormalization = 1.0f / 255.0f;
-        input[c * num_pixels + y * width + x] =
-            kImageNormalization * data[y * pitch + 3 * x + c];
-      }
-    }
-  }
-
-  return input;
-}
-
 // Pads image dimensions to be divisible by a given factor.
 struct InputPadder {
   InputPadder(int height, int width, int divisor = 32)
@@ -88,33 +65,37 @@ struct InputPadder {
   const int original_width;
   const int padded_height;
   const int padded_width;
+};
 
-  // Pad a [C, H, W] float array by replicating edge pixels on the right and
-  // bottom of the multi-channel image. Either returns a reference to the
-  // input, if no padding is necessary, or a reference to the padded data.
-  std::vector<float>* MaybePad(std::vector<float>& input, int channels) {
-    if (padded_height == original_height && padded_width == original_width) {
-      return &input;
-    }
+// Convert bitmap to row-major [C, H, W] float tensor, normalized to [0, 1],
+// and pad it to the given size by replicating edge pixels on the right and
+// bottom of the image.
+void BitmapToInputTensor(const Bitmap& bitmap,
+                         const int padded_height,
+                         const int padded_width,
+                         float* input) {
+  THROW_CHECK(bitmap.IsRGB());
 
-    padded_.resize(channels * padded_height * padded_width, 0.0f);
-    for (int c = 0; c < channels; ++c) {
-      for (int y = 0; y < padded_height; ++y) {
-        const int src_y = std::min(y, original_height - 1);
-        for (int x = 0; x < padded_width; ++x) {
-          const int src_x = std::min(x, original_width - 1);
-          padded_[c * padded_height * padded_width + y * padded_width + x] =
-              input[c * original_height * original_width +
-                    src_y * original_width + src_x];
-        }
+  const int width = bitmap.Width();
+  const int height = bitmap.Height();
+  const int pitch = bitmap.Pitch();
+  THROW_CHECK_LE(height, padded_height);
+  THROW_CHECK_LE(width, padded_width);
+  const int num_padded_pixels = padded_width * padded_height;
+
+  const std::vector<uint8_t>& data = bitmap.RowMajorData();
+  for (int y = 0; y < padded_height; ++y) {
+    const int src_y = std::min(y, height - 1);
+    for (int x = 0; x < padded_width; ++x) {
+      const int src_x = std::min(x, width - 1);
+      for (int c = 0; c < 3; ++c) {
+        constexpr float kImageNormalization = 1.0f / 255.0f;
+        input[c * num_padded_pixels + y * padded_width + x] =
+            kImageNormalization * data[src_y * pitch + 3 * src_x + c];
       }
     }
-    return &padded_;
   }
-
- private:
-  std::vector<float> padded_;
-};
+}
 
 class AlikedFeatureExtractor : public FeatureExtractor {
  public:
@@ -165,28 +146,91 @@ class AlikedFeatureExtractor : public FeatureExtractor {
     THROW_CHECK_NOTNULL(descriptors);
     THROW_CHECK(bitmap.IsRGB());
 
-    const int width = bitmap.Width();
-    const int height = bitmap.Height();
+    // Pad image to dimensions divisible by 32.
+    const InputPadder padder(bitmap.Height(), bitmap.Width(), /*divisor=*/32);
+    ExtractPaddedBatch(padder.padded_height,
+                       padder.padded_width,
+                       {&bitmap},
+                       {keypoints},
+                       {descriptors});
+    return true;
+  }
 
-    std::vector<float> input = BitmapToInputTensor(bitmap);
+  std::vector<bool> ExtractBatch(
+      const std::vector<const Bitmap*>& bitmaps,
+      const std::vector<FeatureKeypoints*>& keypoints,
+      const std::vector<FeatureDescriptors*>& descriptors) override {
+    THROW_CHECK_EQ(bitmaps.size(), keypoints.size());
+    THROW_CHECK_EQ(bitmaps.size(), descriptors.size());
+
+    // Only images with the same padded size can be stacked into one batch.
+    std::map<std::pair<int, int>, std::vector<size_t>> batch_idxs;
+    for (size_t i = 0; i < bitmaps.size(); ++i) {
+      THROW_CHECK_NOTNULL(bitmaps[i]);
+      THROW_CHECK_NOTNULL(keypoints[i]);
+      THROW_CHECK_NOTNULL(descriptors[i]);
+      THROW_CHECK(bitmaps[i]->IsRGB());
+      const InputPadder padder(
+          bitmaps[i]->Height(), bitmaps[i]->Width(), /*divisor=*/32);
+      batch_idxs[{padder.padded_height, padder.padded_width}].push_back(i);
+    }
 
-    // Pad image to dimensions divisible by 32.
-    InputPadder padder(height, width, /*divisor=*/32);
-    std::vector<float>* padded_input = padder.MaybePad(input, 3);
+    const size_t max_batch_size = options_.batch_size;
+    for (const auto& [padded_size, idxs] : batch_idxs) {
+      for (size_t beg = 0; beg < idxs.size(); beg += max_batch_size) {
+        const size_t end = std::min(idxs.size(), beg + max_batch_size);
+        std::vector<const Bitmap*> batch_bitmaps;
+        std::vector<FeatureKeypoints*> batch_keypoints;
+        std::vector<FeatureDescriptors*> batch_descriptors;
+        for (size_t i = beg; i < end; ++i) {
+          batch_bitmaps.push_back(bitmaps[idxs[i]]);
+          batch_keypoints.push_back(keypoints[idxs[i]]);
+          batch_descriptors.push_back(descriptors[idxs[i]]);
+        }
+        ExtractPaddedBatch(padded_size.first,
+                           padded_size.second,
+                           batch_bitmaps,
+                           batch_keypoints,
+                           batch_descriptors);
+      }
+    }
+
+    return std::vector<bool>(bitmaps.size(), true);
+  }
+
+ private:
+  // Run the model on a batch of images that are padded to the same size.
+  void ExtractPaddedBatch(const int padded_height,
+                          const int padded_width,
+                          const std::vector<const Bitmap*>& bitmaps,
+                          const std::vector<FeatureKeypoints*>& keypoints,
+                          const std::vector<FeatureDescriptors*>& descriptors) {
+    const int batch_size = static_cast<int>(bitmaps.size());
+    THROW_CHECK_GT(batch_size, 0);
+
+    // Stack the padded images into one [B, 3, H, W] input tensor.
+    const size_t image_size = 3 * padded_height * padded_width;
+    std::vector<float> input(batch_size * image_size);
+    for (int b = 0; b < batch_size; ++b) {
+      BitmapToInputTensor(*bitmaps[b],
+                          padded_height,
+                          padded_width,
+                          input.data() + b * image_size);
+    }
 
     // Prepare image input tensor.
     std::vector<int64_t> image_shape = model_.input_shapes()[0];
-    image_shape[0] = 1;
+    image_shape[0] = batch_size;
     image_shape[1] = 3;
-    image_shape[2] = padder.padded_height;
-    image_shape[3] = padder.padded_width;
+    image_shape[2] = padded_height;
+    image_shape[3] = padded_width;
 
     std::vector<Ort::Value> input_tensors;
     input_tensors.emplace_back(Ort::Value::CreateTensor<float>(
         Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtDeviceAllocator,
                                    OrtMemType::OrtMemTypeCPU),
-        padded_input->data(),
-        padded_input->size(),
+        input.data(),
+        input.size(),
         image_shape.data(),
         image_shape.size()));
 
@@ -214,40 +258,66 @@ class AlikedFeatureExtractor : public FeatureExtractor {
     const std::vector<Ort::Value> output_tensors = model_.Run(input_tensors);
     THROW_CHECK_EQ(output_tensors.size(), 3);
 
-    // Parse keypoints shape: [1, K, 2].
+    // Parse keypoints shape: [B, K, 2].
     const std::vector<int64_t> keypoints_shape =
         output_tensors[0].GetTensorTypeAndShapeInfo().GetShape();
     THROW_CHECK_EQ(keypoints_shape.size(), 3);
-    THROW_CHECK_EQ(keypoints_shape[0], 1);
+    THROW_CHECK_EQ(keypoints_shape[0], batch_size);
     const int num_keypoints = static_cast<int>(keypoints_shape[1]);
     THROW_CHECK_EQ(keypoints_shape[2], 2);
 
-    // Parse descriptors shape: [1, K, D].
+    // Parse descriptors shape: [B, K, D].
     const std::vector<int64_t> descriptors_shape =
         output_tensors[1].GetTensorTypeAndShapeInfo().GetShape();
     THROW_CHECK_EQ(descriptors_shape.size(), 3);
-    THROW_CHECK_EQ(descriptors_shape[0], 1);
+    THROW_CHECK_EQ(descriptors_shape[0], batch_size);
     THROW_CHECK_EQ(descriptors_shape[1], num_keypoints);
     THROW_CHECK_EQ(descriptors_shape[2], descriptor_dim_);
 
-    // Parse scores shape: [1, K].
+    // Parse scores shape: [B, K].
     const std::vector<int64_t> scores_shape =
         output_tensors[2].GetTensorTypeAndShapeInfo().GetShape();
     THROW_CHECK_EQ(scores_shape.size(), 2);
-    THROW_CHECK_EQ(scores_shape[0], 1);
+    THROW_CHECK_EQ(scores_shape[0], batch_size);
     THROW_CHECK_EQ(scores_shape[1], num_keypoints);
 
     const float* keypoints_data = output_tensors[0].GetTensorData<float>();
     const float* descriptors_data = output_tensors[1].GetTensorData<float>();
     const float* scores_data = output_tensors[2].GetTensorData<float>();
 
+    for (int b = 0; b < batch_size; ++b) {
+      ParseOutputs(num_keypoints,
+                   keypoints_data + b * num_keypoints * 2,
+                   descriptors_data + b * num_keypoints * descriptor_dim_,
+                   scores_data + b * num_keypoints,
+                   padded_height,
+                   padded_width,
+                   *bitmaps[b],
+                   keypoints[b],
+                   descriptors[b]);
+    }
+  }
+
+  void ParseOutputs(const int num_keypoints,
+                    const float* keypoints_data,
+                    const float* descriptors_data,
+                    const float* scores_data,
+                    const int padded_height,
+                    const int padded_width,
+                    const Bitmap& bitmap,
+                    FeatureKeypoints* keypoints,
+                    FeatureDescriptors* descriptors) const {
+    const int width = bitmap.Width();
+    const int height = bitmap.Height();
+    const float min_score = static_cast<float>(options_.aliked->min_score);
+
     // Convert keypoints from normalized [-1, 1] to pixel coordinates,
     // where ALIKED uses the center of the top-left pixel as (0, 0),
     // while COLMAP uses the top-left pixel's corner as (0, 0).
     // Filter out keypoints in the padded region (outside original image
     // bounds) and keypoints below the min_score threshold.
-    const float scale_x = 0.5f * static_cast<float>(padder.padded_width - 1);
-    const float scale_y = 0.5f * static_cast<float>(padder.padded_height - 1);
+    const float scale_x = 0.5f * static_cast<float>(padded_width - 1);
+    const float scale_y = 0.5f * static_cast<float>(padded_height - 1);
 
     // Collect valid keypoints, their pixel coordinates, and descriptor indices.
     struct ValidKeypoint {
@@ -272,22 +342,21 @@ class AlikedFeatureExtractor : public FeatureExtractor {
     // Populate output with valid keypoints and descriptors.
     const int num_valid = static_cast<int>(valid_keypoints.size());
     keypoints->resize(num_valid);
-    descriptors->type = options_.type;
-    descriptors->data.resize(num_valid, descriptor_dim_ * sizeof(float));
+    FeatureDescriptorsFloat descriptors_float(
+        options_.type,
+        FeatureDescriptorsFloatData(num_valid, descriptor_dim_),
+        options_.aliked->descriptor_precision);
     for (int j = 0; j < num_valid; ++j) {
       const auto& kp = valid_keypoints[j];
       (*keypoints)[j].x = kp.x;
       (*keypoints)[j].y = kp.y;
-      std::memcpy(
-          descriptors->data.data() + j * descriptor_dim_ * sizeof(float),
-          descriptors_data + kp.index * descriptor_dim_,
-          descriptor_dim_ * sizeof(float));
+      std::memcpy(descriptors_float.data.row(j).data(),
+                  descriptors_data + kp.index * descriptor_dim_,
+                  descriptor_dim_ * sizeof(float));
     }
-
-    return true;
+    *descriptors = descriptors_float.ToBytes();
   }
 
- private:
   const FeatureExtractionOptions options_;
   ONNXModel model_;
   int descriptor_dim_;
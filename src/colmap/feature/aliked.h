@@ -53,6 +53,12 @@ struct AlikedExtractionOptions {
   std::string n16rot_model_path = kDefaultAlikedN16RotFeatureExtractorUri;
   std::string n32_model_path = kDefaultAlikedN32FeatureExtractorUri;
 
+  // The storage precision of the float32 descriptors. The compact FLOAT16 and
+  // INT8 precisions reduce the database size and memory bandwidth during
+  // matching by 2x and 4x at a small loss in accuracy.
+  FeatureDescriptorPrecision descriptor_precision =
+      FeatureDescriptorPrecision::NATIVE;
+
   bool Check() const;
 };
 
@@ -183,6 +183,50 @@ TEST_P(ParameterizedAlikedTests, MinScore) {
   }
 }
 
+TEST_P(ParameterizedAlikedTests, ExtractBatch) {
+  // The first two images are padded to the same size and stacked into one
+  // batch, while the last image is extracted in a separate batch.
+  std::vector<Bitmap> images(3);
+  CreateRandomRgbImage(200, 100, &images[0]);
+  CreateRandomRgbImage(210, 110, &images[1]);
+  CreateRandomRgbImage(100, 50, &images[2]);
+
+  FeatureExtractionOptions extraction_options(GetParam());
+  extraction_options.use_gpu = false;
+  extraction_options.batch_size = 4;
+  extraction_options.aliked->min_score = 0.0;
+  auto extractor = CreateAlikedFeatureExtractor(extraction_options);
+
+  std::vector<FeatureKeypoints> keypoints(images.size());
+  std::vector<FeatureDescriptors> descriptors(images.size());
+  std::vector<const Bitmap*> image_ptrs;
+  std::vector<FeatureKeypoints*> keypoints_ptrs;
+  std::vector<FeatureDescriptors*> descriptors_ptrs;
+  for (size_t i = 0; i < images.size(); ++i) {
+    image_ptrs.push_back(&images[i]);
+    keypoints_ptrs.push_back(&keypoints[i]);
+    descriptors_ptrs.push_back(&descriptors[i]);
+  }
+  const std::vector<bool> success =
+      extractor->ExtractBatch(image_ptrs, keypoints_ptrs, descriptors_ptrs);
+  ASSERT_EQ(success.size(), images.size());
+
+  for (size_t i = 0; i < images.size(); ++i) {
+    EXPECT_TRUE(success[i]);
+    FeatureKeypoints expected_keypoints;
+    FeatureDescriptors expected_descriptors;
+    ASSERT_TRUE(extractor->Extract(
+        images[i], &expected_keypoints, &expected_descriptors));
+    ASSERT_EQ(keypoints[i].size(), expected_keypoints.size());
+    EXPECT_EQ(descriptors[i].type, GetParam());
+    EXPECT_EQ(descriptors[i].data.rows(), expected_descriptors.data.rows());
+    for (size_t j = 0; j < keypoints[i].size(); ++j) {
+      EXPECT_NEAR(keypoints[i][j].x, expected_keypoints[j].x, 1e-3);
+      EXPECT_NEAR(keypoints[i][j].y, expected_keypoints[j].y, 1e-3);
+    }
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(AlikedTests,
                          ParameterizedAlikedTests,
                          testing::Values(FeatureExtractorType::ALIKED_N16ROT,
@@ -134,6 +134,9 @@ int FeatureExtractionOptions::EffMaxImageSize() const {
 
 bool FeatureExtractionOptions::Check() const {
   CHECK_OPTION_GT(EffMaxImageSize(), 0);
+  CHECK_OPTION_GT(batch_size, 0);
+  CHECK_OPTION_GE(batch_timeout_ms, 0);
+  CHECK_OPTION_GE(num_cpu_workers, 0);
   if (use_gpu) {
     CHECK_OPTION_GT(CSVToVector<int>(gpu_index).size(), 0);
 #if !defined(COLMAP_GPU_ENABLED) && !defined(COLMAP_CUDA_ENABLED)
@@ -168,4 +171,19 @@ std::unique_ptr<FeatureExtractor> FeatureExtractor::Create(
   return nullptr;
 }
 
+std::vector<bool> FeatureExtractor::ExtractBatch(
+    const std::vector<const Bitmap*>& bitmaps,
+    const std::vector<FeatureKeypoints*>& keypoints,
+    const std::vector<FeatureDescriptors*>& descriptors) {
+  THROW_CHECK_EQ(bitmaps.size(), keypoints.size());
+  THROW_CHECK_EQ(bitmaps.size(), descriptors.size());
+  std::vector<bool> success(bitmaps.size());
+  for (size_t i = 0; i < bitmaps.size(); ++i) {
+    success[i] = Extract(*THROW_CHECK_NOTNULL(bitmaps[i]),
+                         keypoints[i],
+                         descriptors[i]);
+  }
+  return success;
+}
+
 }  // namespace colmap
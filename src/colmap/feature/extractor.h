@@ -34,6 +34,8 @@
 #include "colmap/util/enum_utils.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace colmap {
 
@@ -79,6 +81,27 @@ struct FeatureExtractionOptions : public FeatureExtractionTypeOptions {
   // you should separate multiple GPU indices by comma, e.g., "0,1,2,3".
   std::string gpu_index = "-1";
 
+  // Number of additional feature extraction threads on the CPU when
+  // extracting on the GPU. The images are then scheduled among the GPU and CPU
+  // workers by their measured throughput, so that large images are preferably
+  // extracted on the GPU and small images on the CPU. GPU workers that fail to
+  // extract an image, e.g., due to insufficient memory, fall back to the CPU
+  // and only receive smaller images afterwards.
+  int num_cpu_workers = 0;
+
+  // Whether to decode and downscale JPEG images with nvJPEG on the GPU(s)
+  // given by gpu_index instead of on the CPU. Other image formats are still
+  // decoded on the CPU. Requires COLMAP to be built with nvJPEG support.
+  bool use_gpu_decoding = false;
+
+  // Maximum number of images that are extracted together in one batch.
+  // Extractors with batched inference (e.g., ALIKED) stack images of the same
+  // padded size into one model run to improve the GPU utilization. A partial
+  // batch is extracted, if it was not filled within batch_timeout_ms
+  // milliseconds after its first image arrived.
+  int batch_size = 1;
+  int batch_timeout_ms = 20;
+
   // Whether the selected extractor requires RGB (or grayscale) images.
   bool RequiresRGB() const;
 
@@ -102,6 +125,14 @@ class FeatureExtractor {
   virtual bool Extract(const Bitmap& bitmap,
                        FeatureKeypoints* keypoints,
                        FeatureDescriptors* descriptors) = 0;
+
+  // Extract features for multiple images at once and return for each image
+  // whether the extraction succeeded. The default implementation extracts the
+  // images one by one.
+  virtual std::vector<bool> ExtractBatch(
+      const std::vector<const Bitmap*>& bitmaps,
+      const std::vector<FeatureKeypoints*>& keypoints,
+      const std::vector<FeatureDescriptors*>& descriptors);
 };
 
 }  // namespace colmap
@@ -152,5 +152,52 @@ TEST(FeatureExtractionOptions, CheckAndRequiresOpenGLWithNoGpu) {
   }
 }
 
+class TestFeatureExtractor : public FeatureExtractor {
+ public:
+  bool Extract(const Bitmap& bitmap,
+               FeatureKeypoints* keypoints,
+               FeatureDescriptors* descriptors) override {
+    if (bitmap.Width() <= 1) {
+      return false;
+    }
+    keypoints->resize(bitmap.Width());
+    descriptors->data.resize(bitmap.Width(), 2);
+    return true;
+  }
+};
+
+TEST(FeatureExtractor, ExtractBatch) {
+  const Bitmap bitmap1(/*width=*/2, /*height=*/2, /*as_rgb=*/false);
+  const Bitmap bitmap2(/*width=*/1, /*height=*/2, /*as_rgb=*/false);
+  const Bitmap bitmap3(/*width=*/3, /*height=*/2, /*as_rgb=*/false);
+  std::vector<FeatureKeypoints> keypoints(3);
+  std::vector<FeatureDescriptors> descriptors(3);
+  TestFeatureExtractor extractor;
+  EXPECT_EQ(extractor.ExtractBatch(
+                {&bitmap1, &bitmap2, &bitmap3},
+                {&keypoints[0], &keypoints[1], &keypoints[2]},
+                {&descriptors[0], &descriptors[1], &descriptors[2]}),
+            std::vector<bool>({true, false, true}));
+  EXPECT_EQ(keypoints[0].size(), 2);
+  EXPECT_EQ(keypoints[1].size(), 0);
+  EXPECT_EQ(keypoints[2].size(), 3);
+  EXPECT_EQ(descriptors[2].data.rows(), 3);
+  EXPECT_ANY_THROW(extractor.ExtractBatch(
+      {&bitmap1}, {&keypoints[0], &keypoints[1]}, {&descriptors[0]}));
+}
+
+TEST(FeatureExtractionOptions, CheckBatch) {
+  FeatureExtractionOptions options;
+  options.use_gpu = false;
+  EXPECT_TRUE(options.Check());
+  options.batch_size = 0;
+  EXPECT_FALSE(options.Check());
+  options.batch_size = 8;
+  options.batch_timeout_ms = -1;
+  EXPECT_FALSE(options.Check());
+  options.batch_timeout_ms = 0;
+  EXPECT_TRUE(options.Check());
+}
+
 }  // namespace
 }  // namespace colmap
@@ -29,6 +29,7 @@
 
 #include "colmap/feature/index.h"
 
+#include "colmap/util/endian.h"
 #include "colmap/util/logging.h"
 
 #include <faiss/IndexFlat.h>
@@ -36,6 +37,8 @@
 #include <faiss/IndexIVFPQ.h>
 #include <faiss/IndexPQ.h>
 #include <faiss/IndexScalarQuantizer.h>
+#include <faiss/impl/io.h>
+#include <faiss/index_io.h>
 #include <omp.h>
 
 namespace colmap {
@@ -79,6 +82,25 @@ class FaissFeatureDescriptorIndex : public FeatureDescriptorIndex {
           auto* index_impl =
               static_cast<faiss::IndexIVFScalarQuantizer*>(index_.get());
           index_impl->cp.min_points_per_centroid = 1;
+        } else if (index_descriptors.precision !=
+                   FeatureDescriptorPrecision::NATIVE) {
+          // Compact descriptors were already rounded to half precision or
+          // 8-bit levels, so a matching scalar quantizer loses little to no
+          // accuracy while reducing the index memory by 2x or 4x.
+          const faiss::ScalarQuantizer::QuantizerType quantizer_type =
+              index_descriptors.precision == FeatureDescriptorPrecision::FLOAT16
+                  ? faiss::ScalarQuantizer::QT_fp16
+                  : faiss::ScalarQuantizer::QT_8bit;
+          index_ = std::make_unique<faiss::IndexIVFScalarQuantizer>(
+              /*quantizer=*/coarse_quantizer_.get(),
+              /*d=*/index_descriptors.data.cols(),
+              /*nlist=*/num_centroids,
+              quantizer_type,
+              faiss::METRIC_L2,
+              /*by_residual=*/false);
+          auto* index_impl =
+              static_cast<faiss::IndexIVFScalarQuantizer*>(index_.get());
+          index_impl->cp.min_points_per_centroid = 1;
         } else {
           index_ = std::make_unique<faiss::IndexIVFFlat>(
               /*quantizer=*/coarse_quantizer_.get(),
@@ -148,7 +170,42 @@ class FaissFeatureDescriptorIndex : public FeatureDescriptorIndex {
     indices = indices_long.cast<int>();
   }
 
+  void Read(std::istream* stream) override {
+    THROW_CHECK_NOTNULL(stream);
+    const int version = ReadBinaryLittleEndian<int>(stream);
+    THROW_CHECK_EQ(version, kFileVersion);
+    type_ = static_cast<FeatureExtractorType>(
+        ReadBinaryLittleEndian<int>(stream));
+    coarse_quantizer_.reset();
+    faiss::VectorIOReader reader;
+    reader.data.resize(ReadBinaryLittleEndian<uint64_t>(stream));
+    if (reader.data.empty()) {
+      index_ = nullptr;
+      return;
+    }
+    stream->read(reinterpret_cast<char*>(reader.data.data()),
+                 reader.data.size());
+    THROW_CHECK(stream->good()) << "Truncated feature descriptor index";
+    // The read index owns its coarse quantizer.
+    index_.reset(THROW_CHECK_NOTNULL(faiss::read_index(&reader)));
+  }
+
+  void Write(std::ostream* stream) const override {
+    THROW_CHECK_NOTNULL(stream);
+    WriteBinaryLittleEndian<int>(stream, kFileVersion);
+    WriteBinaryLittleEndian<int>(stream, static_cast<int>(type_));
+    faiss::VectorIOWriter writer;
+    if (index_ != nullptr) {
+      faiss::write_index(index_.get(), &writer);
+    }
+    WriteBinaryLittleEndian<uint64_t>(stream, writer.data.size());
+    stream->write(reinterpret_cast<const char*>(writer.data.data()),
+                  writer.data.size());
+  }
+
  private:
+  static constexpr int kFileVersion = 1;
+
   const int num_threads_;
   FeatureExtractorType type_ = FeatureExtractorType::UNDEFINED;
   std::unique_ptr<faiss::Index> index_;
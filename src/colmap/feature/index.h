@@ -32,6 +32,7 @@
 #include "colmap/feature/types.h"
 #include "colmap/util/types.h"
 
+#include <iostream>
 #include <memory>
 
 namespace colmap {
@@ -54,6 +55,11 @@ class FeatureDescriptorIndex {
                       const FeatureDescriptorsFloat& query_descriptors,
                       Eigen::RowMajorMatrixXi& indices,
                       Eigen::RowMajorMatrixXf& l2_dists) const = 0;
+
+  // Read and write the built index. Reading a written index is much faster
+  // than building it again, because it skips the training of the index.
+  virtual void Read(std::istream* stream) = 0;
+  virtual void Write(std::ostream* stream) const = 0;
 };
 
 }  // namespace colmap
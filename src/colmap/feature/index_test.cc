@@ -32,6 +32,8 @@
 #include "colmap/feature/utils.h"
 #include "colmap/math/random.h"
 
+#include <sstream>
+
 #include <gtest/gtest.h>
 #include <omp.h>
 
@@ -39,7 +41,10 @@ namespace colmap {
 namespace {
 
 FeatureDescriptorsFloat CreateRandomFeatureDescriptors(
-    const FeatureExtractorType type, const size_t num_features) {
+    const FeatureExtractorType type,
+    const size_t num_features,
+    const FeatureDescriptorPrecision precision =
+        FeatureDescriptorPrecision::NATIVE) {
   SetPRNGSeed(0);
   FeatureDescriptorsFloat descriptors;
   descriptors.type = type;
@@ -56,6 +61,10 @@ FeatureDescriptorsFloat CreateRandomFeatureDescriptors(
     // which is required for QT_8bit_direct quantization.
     descriptors.data =
         FeatureDescriptorsToUnsignedByte(descriptors.data).cast<float>();
+  } else if (precision != FeatureDescriptorPrecision::NATIVE) {
+    // Mimic descriptors read from compact storage.
+    descriptors.precision = precision;
+    descriptors = descriptors.ToBytes().ToFloat();
   }
   return descriptors;
 }
@@ -64,6 +73,7 @@ struct FeatureDescriptorIndexTestParams {
   FeatureDescriptorIndex::Type index_type;
   FeatureExtractorType extractor_type;
   int num_descriptors;
+  FeatureDescriptorPrecision precision = FeatureDescriptorPrecision::NATIVE;
 };
 
 class ParameterizedFeatureDescriptorIndexTests
@@ -82,8 +92,11 @@ TEST_P(ParameterizedFeatureDescriptorIndexTests, Nominal) {
   EXPECT_NE(index, nullptr);
 
   const FeatureDescriptorsFloat index_descriptors =
-      CreateRandomFeatureDescriptors(params.extractor_type,
-                                     params.num_descriptors);
+      CreateRandomFeatureDescriptors(
+          params.extractor_type, params.num_descriptors, params.precision);
+  // The 8-bit scalar quantizer of INT8 descriptors is not exactly lossless.
+  const double kMaxDistError =
+      params.precision == FeatureDescriptorPrecision::INT8 ? 1e-3 : 1e-6;
   const FeatureDescriptorsFloat& query_descriptors = index_descriptors;
   index->Build(index_descriptors);
 
@@ -98,7 +111,7 @@ TEST_P(ParameterizedFeatureDescriptorIndexTests, Nominal) {
 
   for (int i = 0; i < query_descriptors.data.rows(); ++i) {
     EXPECT_EQ(indices(i, 0), i);
-    EXPECT_NEAR(distances(i, 0), 0, 1e-6);
+    EXPECT_NEAR(distances(i, 0), 0, kMaxDistError);
   }
 
   index->Search(/*num_neighbors=*/2, query_descriptors, indices, distances);
@@ -109,13 +122,13 @@ TEST_P(ParameterizedFeatureDescriptorIndexTests, Nominal) {
 
   for (int i = 0; i < query_descriptors.data.rows(); ++i) {
     EXPECT_EQ(indices(i, 0), i);
-    EXPECT_NEAR(distances(i, 0), 0, 1e-6);
+    EXPECT_NEAR(distances(i, 0), 0, kMaxDistError);
     EXPECT_NE(indices(i, 1), i);
     EXPECT_NEAR(distances(i, 1),
                 (query_descriptors.data.row(i) -
                  index_descriptors.data.row(indices(i, 1)))
                     .squaredNorm(),
-                1e-6);
+                kMaxDistError);
   }
 
   index->Search(/*num_neighbors=*/index_descriptors.data.rows() + 1,
@@ -128,6 +141,38 @@ TEST_P(ParameterizedFeatureDescriptorIndexTests, Nominal) {
   ASSERT_EQ(distances.cols(), index_descriptors.data.rows());
 }
 
+TEST(FeatureDescriptorIndexTests, ReadWrite) {
+  for (const int num_descriptors : {0, 100, 1000}) {
+    std::unique_ptr<FeatureDescriptorIndex> index;
+    try {
+      index =
+          FeatureDescriptorIndex::Create(FeatureDescriptorIndex::Type::FAISS);
+    } catch (const std::runtime_error& e) {
+      GTEST_SKIP() << "Skipping test due to: " << e.what();
+    }
+
+    const FeatureDescriptorsFloat descriptors = CreateRandomFeatureDescriptors(
+        FeatureExtractorType::SIFT, num_descriptors);
+    index->Build(descriptors);
+
+    std::stringstream stream;
+    index->Write(&stream);
+    auto read_index =
+        FeatureDescriptorIndex::Create(FeatureDescriptorIndex::Type::FAISS);
+    read_index->Read(&stream);
+
+    Eigen::RowMajorMatrixXi indices;
+    Eigen::RowMajorMatrixXf distances;
+    index->Search(/*num_neighbors=*/2, descriptors, indices, distances);
+    Eigen::RowMajorMatrixXi read_indices;
+    Eigen::RowMajorMatrixXf read_distances;
+    read_index->Search(
+        /*num_neighbors=*/2, descriptors, read_indices, read_distances);
+    EXPECT_EQ(read_indices, indices);
+    EXPECT_EQ(read_distances, distances);
+  }
+}
+
 TEST(FeatureDescriptorIndexTests, TypeMismatch) {
   constexpr int kNumDescriptors = 100;
 
@@ -176,7 +221,15 @@ INSTANTIATE_TEST_SUITE_P(
                                          100},
         FeatureDescriptorIndexTestParams{FeatureDescriptorIndex::Type::FAISS,
                                          FeatureExtractorType::ALIKED_N16ROT,
-                                         1000}));
+                                         1000},
+        FeatureDescriptorIndexTestParams{FeatureDescriptorIndex::Type::FAISS,
+                                         FeatureExtractorType::ALIKED_N16ROT,
+                                         1000,
+                                         FeatureDescriptorPrecision::FLOAT16},
+        FeatureDescriptorIndexTestParams{FeatureDescriptorIndex::Type::FAISS,
+                                         FeatureExtractorType::ALIKED_N16ROT,
+                                         1000,
+                                         FeatureDescriptorPrecision::INT8}));
 
 }  // namespace
 }  // namespace colmap
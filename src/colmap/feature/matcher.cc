@@ -33,6 +33,9 @@
 #include "colmap/feature/onnx_matchers.h"
 #include "colmap/feature/sift.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/string.h"
+
+#include <sstream>
 
 namespace colmap {
 namespace {
@@ -45,6 +48,29 @@ void ThrowUnknownFeatureMatcherType(FeatureMatcherType type) {
 
 }  // namespace
 
+std::string FeatureMatchingProgress::ToString() const {
+  const auto FormatRatio = [](const double ratio) {
+    return ratio < 0 ? std::string("-") : StringPrintf("%.1f%%", 100 * ratio);
+  };
+  std::ostringstream stream;
+  stream << "Matching progress: " << FormatRatio(progress);
+  if (remaining_time_sec >= 0) {
+    stream << StringPrintf(" (%.1f min remaining)", remaining_time_sec / 60);
+  }
+  stream << StringPrintf(", %.1f pairs/s", pairs_per_sec)
+         << ", processed=" << num_processed_pairs
+         << ", skipped=" << num_skipped_pairs
+         << ", matched=" << num_matched_pairs
+         << ", verified=" << num_verified_pairs;
+  stream << StringPrintf(", queues: matcher=%.1f, verifier=%.1f",
+                         mean_matcher_queue_size,
+                         mean_verifier_queue_size);
+  stream << ", cache hits: keypoints=" << FormatRatio(keypoints_cache_hit_ratio)
+         << ", descriptors=" << FormatRatio(descriptors_cache_hit_ratio);
+  stream << StringPrintf(", database wait: %.1fs", database_wait_time_sec);
+  return stream.str();
+}
+
 FeatureMatchingTypeOptions::FeatureMatchingTypeOptions()
     : sift(std::make_shared<SiftMatchingOptions>()),
       aliked(std::make_shared<AlikedMatchingOptions>()) {}
@@ -109,6 +135,18 @@ bool FeatureMatchingOptions::Check() const {
 #endif
   }
   CHECK_OPTION_GE(max_num_matches, 0);
+  CHECK_OPTION_NE(max_num_features, 0);
+  CHECK_OPTION_GT(batch_size, 0);
+  CHECK_OPTION_GE(batch_timeout_ms, 0);
+  CHECK_OPTION_GE(feature_cache_size, 0);
+  CHECK_OPTION_GE(spill_cache_size, 0);
+  CHECK_OPTION_GT(num_shards, 0);
+  CHECK_OPTION_GE(shard_index, 0);
+  CHECK_OPTION_LT(shard_index, num_shards);
+  if (num_shards > 1) {
+    CHECK_OPTION(!shard_database_path.empty());
+    CHECK_OPTION(!rig_verification);
+  }
   switch (type) {
     case FeatureMatcherType::SIFT_BRUTEFORCE:
     case FeatureMatcherType::SIFT_LIGHTGLUE:
@@ -138,4 +176,15 @@ std::unique_ptr<FeatureMatcher> FeatureMatcher::Create(
   return nullptr;
 }
 
+void FeatureMatcher::MatchBatch(
+    const std::vector<std::pair<const Image*, const Image*>>& image_pairs,
+    const std::vector<FeatureMatches*>& matches) {
+  THROW_CHECK_EQ(image_pairs.size(), matches.size());
+  for (size_t i = 0; i < image_pairs.size(); ++i) {
+    Match(*THROW_CHECK_NOTNULL(image_pairs[i].first),
+          *THROW_CHECK_NOTNULL(image_pairs[i].second),
+          THROW_CHECK_NOTNULL(matches[i]));
+  }
+}
+
 }  // namespace colmap
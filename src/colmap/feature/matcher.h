@@ -35,8 +35,12 @@
 #include "colmap/scene/two_view_geometry.h"
 #include "colmap/util/types.h"
 
+#include <filesystem>
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace colmap {
 
@@ -57,6 +61,48 @@ struct FeatureMatchingTypeOptions {
       default;
 };
 
+// Progress record of feature matching, which is reported in regular intervals
+// to monitor long running matching jobs.
+struct FeatureMatchingProgress {
+  // Time since the start of matching and duration of the reported interval.
+  double elapsed_time_sec = 0;
+  double interval_time_sec = 0;
+
+  // Fraction of the generated image pairs in [0, 1] and the estimated
+  // remaining time, or negative if the pair generator cannot tell.
+  double progress = -1;
+  double remaining_time_sec = -1;
+
+  // Total number of image pairs processed by the matchers, skipped because
+  // their results already exist, with at least min_num_inliers matches, and
+  // with at least min_num_inliers verified inlier matches.
+  size_t num_processed_pairs = 0;
+  size_t num_skipped_pairs = 0;
+  size_t num_matched_pairs = 0;
+  size_t num_verified_pairs = 0;
+
+  // Processed image pairs per second in the interval.
+  double pairs_per_sec = 0;
+
+  // Mean number of queued image pairs of the matchers and verifiers in the
+  // interval. Persistently full matcher queues indicate that matching is the
+  // bottleneck (e.g., on the GPU), while persistently empty queues together
+  // with a high database wait time indicate that reading features is.
+  double mean_matcher_queue_size = 0;
+  double mean_verifier_queue_size = 0;
+
+  // Hit ratios of the keypoint and descriptor caches in the interval, or
+  // negative if the caches were not accessed.
+  double keypoints_cache_hit_ratio = -1;
+  double descriptors_cache_hit_ratio = -1;
+
+  // Time spent waiting for the database in the interval, summed over all
+  // threads.
+  double database_wait_time_sec = 0;
+
+  std::string ToString() const;
+};
+
 struct FeatureMatchingOptions : public FeatureMatchingTypeOptions {
   explicit FeatureMatchingOptions(
       FeatureMatcherType type = FeatureMatcherType::SIFT_BRUTEFORCE);
@@ -80,6 +126,12 @@ struct FeatureMatchingOptions : public FeatureMatchingTypeOptions {
   // Maximum number of matches.
   int max_num_matches = 32768;
 
+  // Maximum number of features per image used for matching. If positive, only
+  // the features with the largest scale are matched, e.g., to quickly compute
+  // a preview reconstruction. The matches still refer to the indices of all
+  // features of an image.
+  int max_num_features = -1;
+
   // Whether to perform guided matching.
   bool guided_matching = false;
 
@@ -99,6 +151,50 @@ struct FeatureMatchingOptions : public FeatureMatchingTypeOptions {
   // This is useful for the case of non-overlapping cameras in a rig.
   bool skip_image_pairs_in_same_frame = false;
 
+  // Maximum number of image pairs that are matched together in one batch.
+  // Matchers with batched inference (e.g., LightGlue) stack image pairs with
+  // the same number of keypoints into one model run to improve the GPU
+  // utilization. A partial batch is matched, if it was not filled within
+  // batch_timeout_ms milliseconds after its first image pair arrived. Guided
+  // matching does not use batches.
+  int batch_size = 1;
+  int batch_timeout_ms = 20;
+
+  // Number of shards and index of the matched shard for distributed feature
+  // matching. If num_shards > 1, only the image pairs of the shard are matched
+  // and their matches and two-view geometries are written into the separate
+  // shard database at shard_database_path, while the features are read from
+  // the main database. The shards can then be reduced into the main database.
+  // Rig verification requires all image pairs between two frames and should
+  // be run after reducing the shards.
+  int num_shards = 1;
+  int shard_index = 0;
+  std::filesystem::path shard_database_path;
+
+  // Maximum memory in gigabytes of the cached keypoints and descriptors. If
+  // positive, the features are cached up to this memory instead of for the
+  // fixed number of images given by the pairing options, which bounds the
+  // memory usage when the number of features varies widely between images.
+  double feature_cache_size = 0;
+
+  // Optional directory, e.g., on a local SSD, into which the features that are
+  // evicted from the in-memory cache are spilled, up to spill_cache_size
+  // gigabytes. Later cache misses are then served from the spilled files
+  // instead of the database, which avoids repeated reads from slow storage.
+  std::filesystem::path spill_cache_path;
+  double spill_cache_size = 64;
+
+  // Optional path to a checkpoint file of the matching progress. The position
+  // of the pair generator is periodically written to this file. If the file
+  // exists when matching starts, matching resumes after the checkpointed image
+  // pairs. The file is removed once all image pairs are matched.
+  std::filesystem::path checkpoint_path;
+
+  // Interval in seconds in which the progress of matching is logged and
+  // passed to the optional progress callback. Disabled if not positive.
+  double progress_interval = 60;
+  std::function<void(const FeatureMatchingProgress&)> progress_callback;
+
   // Whether the selected matcher requires OpenGL.
   bool RequiresOpenGL() const;
 
@@ -126,6 +222,12 @@ class FeatureMatcher {
                      const Image& image2,
                      FeatureMatches* matches) = 0;
 
+  // Match multiple image pairs at once. The default implementation matches
+  // the image pairs one by one.
+  virtual void MatchBatch(
+      const std::vector<std::pair<const Image*, const Image*>>& image_pairs,
+      const std::vector<FeatureMatches*>& matches);
+
   virtual void MatchGuided(double max_error,
                            const Image& image1,
                            const Image& image2,
@@ -119,5 +119,50 @@ TEST(FeatureMatchingOptions, Check) {
   }
 }
 
+TEST(FeatureMatchingOptions, CheckBatch) {
+  FeatureMatchingOptions options;
+  options.use_gpu = false;
+  EXPECT_TRUE(options.Check());
+  options.batch_size = 0;
+  EXPECT_FALSE(options.Check());
+  options.batch_size = 8;
+  options.batch_timeout_ms = -1;
+  EXPECT_FALSE(options.Check());
+  options.batch_timeout_ms = 0;
+  EXPECT_TRUE(options.Check());
+}
+
+class TestFeatureMatcher : public FeatureMatcher {
+ public:
+  void Match(const Image& image1,
+             const Image& image2,
+             FeatureMatches* matches) override {
+    matches->clear();
+    matches->emplace_back(image1.image_id, image2.image_id);
+  }
+
+  void MatchGuided(double max_error,
+                   const Image& image1,
+                   const Image& image2,
+                   TwoViewGeometry* two_view_geometry) override {}
+};
+
+TEST(FeatureMatcher, MatchBatch) {
+  const FeatureMatcher::Image image1{/*image_id=*/1};
+  const FeatureMatcher::Image image2{/*image_id=*/2};
+  const FeatureMatcher::Image image3{/*image_id=*/3};
+  std::vector<FeatureMatches> matches(2);
+  TestFeatureMatcher matcher;
+  matcher.MatchBatch({{&image1, &image2}, {&image3, &image1}},
+                     {&matches[0], &matches[1]});
+  ASSERT_EQ(matches[0].size(), 1);
+  EXPECT_EQ(matches[0][0].point2D_idx1, 1);
+  EXPECT_EQ(matches[0][0].point2D_idx2, 2);
+  ASSERT_EQ(matches[1].size(), 1);
+  EXPECT_EQ(matches[1][0].point2D_idx1, 3);
+  EXPECT_EQ(matches[1][0].point2D_idx2, 1);
+  EXPECT_ANY_THROW(matcher.MatchBatch({{&image1, &image2}}, {}));
+}
+
 }  // namespace
 }  // namespace colmap
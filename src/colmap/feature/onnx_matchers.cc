@@ -34,11 +34,47 @@
 #include "colmap/geometry/pose_prior.h"
 
 #include <algorithm>
+#include <limits>
+#include <map>
 #include <memory>
 
 namespace colmap {
 namespace {
 
+// Writes the ALIKED descriptors as a row-major float32 array, as expected by
+// the ONNX models. Native float32 descriptors are reinterpreted directly, while
+// compact FLOAT16 and INT8 descriptors are decoded.
+void AlikedDescriptorsToFloat(const FeatureDescriptors& descriptors,
+                              std::vector<float>* data) {
+  if (descriptors.precision == FeatureDescriptorPrecision::NATIVE) {
+    THROW_CHECK_EQ(descriptors.data.cols() % sizeof(float), 0);
+    data->resize(descriptors.data.size() / sizeof(float));
+    std::memcpy(data->data(),
+                reinterpret_cast<const void*>(descriptors.data.data()),
+                descriptors.data.size());
+  } else {
+    const FeatureDescriptorsFloat descriptors_float = descriptors.ToFloat();
+    data->resize(descriptors_float.data.size());
+    std::memcpy(data->data(),
+                reinterpret_cast<const void*>(descriptors_float.data.data()),
+                descriptors_float.data.size() * sizeof(float));
+  }
+}
+
+FeatureDescriptorsFloatData PrefilterDescriptors(
+    const FeatureDescriptors& descriptors, const int max_num_features) {
+  const Eigen::Index num_features =
+      std::min<Eigen::Index>(descriptors.data.rows(), max_num_features);
+  FeatureDescriptorsFloatData data =
+      FeatureDescriptors(descriptors.type,
+                         descriptors.data.topRows(num_features),
+                         descriptors.precision)
+          .ToFloat()
+          .data;
+  L2NormalizeFeatureDescriptors(&data);
+  return data;
+}
+
 #ifdef COLMAP_ONNX_ENABLED
 
 class BruteForceONNXFeatureMatcher : public FeatureMatcher {
@@ -203,21 +239,15 @@ class BruteForceONNXFeatureMatcher : public FeatureMatcher {
                 image.descriptors->type == FeatureExtractorType::ALIKED_N32)
         << "Unsupported feature type: "
         << FeatureExtractorTypeToString(image.descriptors->type);
-    THROW_CHECK_EQ(image.descriptors->data.cols() % sizeof(float), 0);
 
     const int num_keypoints = image.descriptors->data.rows();
-    const int descriptor_dim = image.descriptors->data.cols() / sizeof(float);
+    const int descriptor_dim = image.descriptors->NumDims();
     THROW_CHECK_GT(descriptor_dim, 0);
 
     Features features;
     features.image_id = image.image_id;
     features.descriptors_shape = {num_keypoints, descriptor_dim};
-    features.descriptors_data.resize(num_keypoints * descriptor_dim);
-    THROW_CHECK_EQ(image.descriptors->data.size(),
-                   features.descriptors_data.size() * sizeof(float));
-    std::memcpy(features.descriptors_data.data(),
-                reinterpret_cast<const void*>(image.descriptors->data.data()),
-                image.descriptors->data.size());
+    AlikedDescriptorsToFloat(*image.descriptors, &features.descriptors_data);
 
     return features;
   }
@@ -319,7 +349,8 @@ class LightGlueONNXFeatureMatcher : public FeatureMatcher {
 
     const int num_keypoints1 = image1.descriptors->data.rows();
     const int num_keypoints2 = image2.descriptors->data.rows();
-    if (num_keypoints1 < 1 || num_keypoints2 < 1) {
+    if (num_keypoints1 < 1 || num_keypoints2 < 1 ||
+        !PassesPrefilter(image1, image2)) {
       return;
     }
 
@@ -343,117 +374,258 @@ class LightGlueONNXFeatureMatcher : public FeatureMatcher {
       }
     }
 
-    // Create input tensors.
-    std::vector<Ort::Value> input_tensors;
-    input_tensors.reserve(has_scale_ori_ ? 10 : 6);
+    // Run model inference.
+    const std::vector<Ort::Value> output_tensors =
+        Run(prev_features1_, prev_features2_);
+    THROW_CHECK(ParseMatches(output_tensors,
+                             /*batch_size=*/1,
+                             /*batch_idx=*/0,
+                             num_keypoints1,
+                             num_keypoints2,
+                             matches));
+  }
 
-    input_tensors.emplace_back(Ort::Value::CreateTensor<float>(
-        Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtDeviceAllocator,
-                                   OrtMemType::OrtMemTypeCPU),
-        prev_features1_.keypoints_data.data(),
-        prev_features1_.keypoints_data.size(),
-        prev_features1_.keypoints_shape.data(),
-        prev_features1_.keypoints_shape.size()));
+  void MatchBatch(
+      const std::vector<std::pair<const Image*, const Image*>>& image_pairs,
+      const std::vector<FeatureMatches*>& matches) override {
+    THROW_CHECK_EQ(image_pairs.size(), matches.size());
+    if (!supports_batching_ || image_pairs.size() == 1) {
+      FeatureMatcher::MatchBatch(image_pairs, matches);
+      return;
+    }
 
-    input_tensors.emplace_back(Ort::Value::CreateTensor<float>(
-        Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtDeviceAllocator,
-                                   OrtMemType::OrtMemTypeCPU),
-        prev_features2_.keypoints_data.data(),
-        prev_features2_.keypoints_data.size(),
-        prev_features2_.keypoints_shape.data(),
-        prev_features2_.keypoints_shape.size()));
+    // LightGlue attends over all keypoints of both images, so padding would
+    // change the matches. Only pairs with the same number of keypoints in the
+    // first and second image can therefore be stacked into one batch.
+    std::map<std::pair<int, int>, std::vector<size_t>> batch_idxs;
+    for (size_t i = 0; i < image_pairs.size(); ++i) {
+      const Image& image1 = *THROW_CHECK_NOTNULL(image_pairs[i].first);
+      const Image& image2 = *THROW_CHECK_NOTNULL(image_pairs[i].second);
+      THROW_CHECK_NOTNULL(matches[i])->clear();
+      const int num_keypoints1 = image1.descriptors->data.rows();
+      const int num_keypoints2 = image2.descriptors->data.rows();
+      if (num_keypoints1 < 1 || num_keypoints2 < 1 ||
+          !PassesPrefilter(image1, image2)) {
+        continue;
+      }
+      batch_idxs[{num_keypoints1, num_keypoints2}].push_back(i);
+    }
 
-    input_tensors.emplace_back(Ort::Value::CreateTensor<float>(
-        Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtDeviceAllocator,
-                                   OrtMemType::OrtMemTypeCPU),
-        prev_features1_.descriptors_data.data(),
-        prev_features1_.descriptors_data.size(),
-        prev_features1_.descriptors_shape.data(),
-        prev_features1_.descriptors_shape.size()));
+    const size_t max_batch_size = options_.batch_size;
+    for (const auto& [num_keypoints, idxs] : batch_idxs) {
+      for (size_t beg = 0; beg < idxs.size(); beg += max_batch_size) {
+        const size_t end = std::min(idxs.size(), beg + max_batch_size);
+        if (end - beg == 1 || !supports_batching_) {
+          for (size_t i = beg; i < end; ++i) {
+            Match(*image_pairs[idxs[i]].first,
+                  *image_pairs[idxs[i]].second,
+                  matches[idxs[i]]);
+          }
+          continue;
+        }
 
-    input_tensors.emplace_back(Ort::Value::CreateTensor<float>(
-        Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtDeviceAllocator,
-                                   OrtMemType::OrtMemTypeCPU),
-        prev_features2_.descriptors_data.data(),
-        prev_features2_.descriptors_data.size(),
-        prev_features2_.descriptors_shape.data(),
-        prev_features2_.descriptors_shape.size()));
+        std::vector<CachedFeatures> features1;
+        std::vector<CachedFeatures> features2;
+        features1.reserve(end - beg);
+        features2.reserve(end - beg);
+        for (size_t i = beg; i < end; ++i) {
+          features1.push_back(FeaturesFromImage(*image_pairs[idxs[i]].first));
+          features2.push_back(FeaturesFromImage(*image_pairs[idxs[i]].second));
+        }
+        CachedFeatures stacked_features1 = StackFeatures(features1);
+        CachedFeatures stacked_features2 = StackFeatures(features2);
+
+        // Models exported with a fixed batch dimension either fail to run or
+        // only return the matches of the first image pair.
+        const int batch_size = static_cast<int>(end - beg);
+        std::vector<Ort::Value> output_tensors;
+        bool success = true;
+        try {
+          output_tensors = Run(stacked_features1, stacked_features2);
+        } catch (const std::exception& e) {
+          VLOG(2) << "Batched LightGlue inference failed: " << e.what();
+          success = false;
+        }
+        for (int b = 0; b < batch_size && success; ++b) {
+          success = ParseMatches(output_tensors,
+                                 batch_size,
+                                 b,
+                                 num_keypoints.first,
+                                 num_keypoints.second,
+                                 matches[idxs[beg + b]]);
+        }
 
-    std::vector<int64_t> image_size_shape = {1, 2};
-    input_tensors.emplace_back(Ort::Value::CreateTensor<float>(
-        Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtDeviceAllocator,
-                                   OrtMemType::OrtMemTypeCPU),
-        prev_features1_.image_size,
-        2,
-        image_size_shape.data(),
-        image_size_shape.size()));
+        if (!success) {
+          LOG(WARNING) << "LightGlue ONNX model does not support batched "
+                          "inference, matching image pairs one by one.";
+          supports_batching_ = false;
+          for (size_t i = beg; i < end; ++i) {
+            Match(*image_pairs[idxs[i]].first,
+                  *image_pairs[idxs[i]].second,
+                  matches[idxs[i]]);
+          }
+        }
+      }
+    }
+  }
 
-    input_tensors.emplace_back(Ort::Value::CreateTensor<float>(
-        Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtDeviceAllocator,
-                                   OrtMemType::OrtMemTypeCPU),
-        prev_features2_.image_size,
-        2,
-        image_size_shape.data(),
-        image_size_shape.size()));
+  void MatchGuided(double max_error,
+                   const Image& image1,
+                   const Image& image2,
+                   TwoViewGeometry* two_view_geometry) override {
+    LOG(FATAL_THROW) << "Guided matching not supported for LightGlue.";
+  }
+
+ private:
+  bool PassesPrefilter(const Image& image1, const Image& image2) const {
+    if (lightglue_options_.prefilter_min_num_matches <= 0) {
+      return true;
+    }
+    const int num_matches = CountLightGluePrefilterMatches(
+        *image1.descriptors,
+        *image2.descriptors,
+        lightglue_options_.prefilter_max_num_features,
+        lightglue_options_.prefilter_max_ratio);
+    if (num_matches < lightglue_options_.prefilter_min_num_matches) {
+      VLOG(3) << "Skipping image pair " << image1.image_id << ", "
+              << image2.image_id << " with " << num_matches
+              << " prefilter matches";
+      return false;
+    }
+    return true;
+  }
+
+  struct CachedFeatures {
+    image_t image_id = kInvalidImageId;
+    std::vector<float> keypoints_data;
+    std::vector<int64_t> keypoints_shape;
+    std::vector<float> descriptors_data;
+    std::vector<int64_t> descriptors_shape;
+    std::vector<float> image_size_data;
+    std::vector<int64_t> image_size_shape;
+    std::vector<float> scales_data;
+    std::vector<int64_t> scales_shape;
+    std::vector<float> orientations_data;
+    std::vector<int64_t> orientations_shape;
+  };
 
+  // Stack the features of multiple images along the batch dimension.
+  static CachedFeatures StackFeatures(
+      const std::vector<CachedFeatures>& features) {
+    THROW_CHECK(!features.empty());
+    CachedFeatures stacked;
+    auto stack = [&features](std::vector<float> CachedFeatures::*data,
+                             std::vector<int64_t> CachedFeatures::*shape,
+                             CachedFeatures& stacked) {
+      stacked.*shape = features[0].*shape;
+      if ((stacked.*shape).empty()) {
+        return;
+      }
+      (stacked.*shape)[0] = features.size();
+      (stacked.*data).reserve(features.size() * (features[0].*data).size());
+      for (const CachedFeatures& image_features : features) {
+        THROW_CHECK(image_features.*shape == features[0].*shape);
+        (stacked.*data).insert((stacked.*data).end(),
+                               (image_features.*data).begin(),
+                               (image_features.*data).end());
+      }
+    };
+    stack(&CachedFeatures::keypoints_data,
+          &CachedFeatures::keypoints_shape,
+          stacked);
+    stack(&CachedFeatures::descriptors_data,
+          &CachedFeatures::descriptors_shape,
+          stacked);
+    stack(&CachedFeatures::image_size_data,
+          &CachedFeatures::image_size_shape,
+          stacked);
+    stack(
+        &CachedFeatures::scales_data, &CachedFeatures::scales_shape, stacked);
+    stack(&CachedFeatures::orientations_data,
+          &CachedFeatures::orientations_shape,
+          stacked);
+    return stacked;
+  }
+
+  std::vector<Ort::Value> Run(CachedFeatures& features1,
+                              CachedFeatures& features2) const {
+    const auto memory_info = Ort::MemoryInfo::CreateCpu(
+        OrtAllocatorType::OrtDeviceAllocator, OrtMemType::OrtMemTypeCPU);
+    auto create_tensor = [&memory_info](std::vector<float>& data,
+                                        const std::vector<int64_t>& shape) {
+      return Ort::Value::CreateTensor<float>(
+          memory_info, data.data(), data.size(), shape.data(), shape.size());
+    };
+
+    std::vector<Ort::Value> input_tensors;
+    input_tensors.reserve(has_scale_ori_ ? 10 : 6);
+    input_tensors.emplace_back(
+        create_tensor(features1.keypoints_data, features1.keypoints_shape));
+    input_tensors.emplace_back(
+        create_tensor(features2.keypoints_data, features2.keypoints_shape));
+    input_tensors.emplace_back(
+        create_tensor(features1.descriptors_data, features1.descriptors_shape));
+    input_tensors.emplace_back(
+        create_tensor(features2.descriptors_data, features2.descriptors_shape));
+    input_tensors.emplace_back(
+        create_tensor(features1.image_size_data, features1.image_size_shape));
+    input_tensors.emplace_back(
+        create_tensor(features2.image_size_data, features2.image_size_shape));
     if (has_scale_ori_) {
-      input_tensors.emplace_back(Ort::Value::CreateTensor<float>(
-          Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtDeviceAllocator,
-                                     OrtMemType::OrtMemTypeCPU),
-          prev_features1_.scales_data.data(),
-          prev_features1_.scales_data.size(),
-          prev_features1_.scales_shape.data(),
-          prev_features1_.scales_shape.size()));
-
-      input_tensors.emplace_back(Ort::Value::CreateTensor<float>(
-          Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtDeviceAllocator,
-                                     OrtMemType::OrtMemTypeCPU),
-          prev_features2_.scales_data.data(),
-          prev_features2_.scales_data.size(),
-          prev_features2_.scales_shape.data(),
-          prev_features2_.scales_shape.size()));
-
-      input_tensors.emplace_back(Ort::Value::CreateTensor<float>(
-          Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtDeviceAllocator,
-                                     OrtMemType::OrtMemTypeCPU),
-          prev_features1_.orientations_data.data(),
-          prev_features1_.orientations_data.size(),
-          prev_features1_.orientations_shape.data(),
-          prev_features1_.orientations_shape.size()));
-
-      input_tensors.emplace_back(Ort::Value::CreateTensor<float>(
-          Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtDeviceAllocator,
-                                     OrtMemType::OrtMemTypeCPU),
-          prev_features2_.orientations_data.data(),
-          prev_features2_.orientations_data.size(),
-          prev_features2_.orientations_shape.data(),
-          prev_features2_.orientations_shape.size()));
+      input_tensors.emplace_back(
+          create_tensor(features1.scales_data, features1.scales_shape));
+      input_tensors.emplace_back(
+          create_tensor(features2.scales_data, features2.scales_shape));
+      input_tensors.emplace_back(create_tensor(features1.orientations_data,
+                                               features1.orientations_shape));
+      input_tensors.emplace_back(create_tensor(features2.orientations_data,
+                                               features2.orientations_shape));
     }
 
-    // Run model inference.
-    const std::vector<Ort::Value> output_tensors = model_.Run(input_tensors);
+    std::vector<Ort::Value> output_tensors = model_.Run(input_tensors);
     THROW_CHECK_EQ(output_tensors.size(), 2);
+    return output_tensors;
+  }
 
-    // Parse matches0 shape: [M].
-    const auto matches0_info = output_tensors[0].GetTensorTypeAndShapeInfo();
-    const std::vector<int64_t> matches0_shape = matches0_info.GetShape();
-    THROW_CHECK_EQ(matches0_shape.size(), 1);
-    const int64_t num_kpts = matches0_shape[0];
-    THROW_CHECK_EQ(num_kpts, num_keypoints1);
+  // Parse the matches of one image pair in the batch. The matches0 and
+  // mscores0 outputs hold num_keypoints1 values per image pair. Returns false,
+  // if the outputs do not match the batch size, i.e., if the model does not
+  // support batched inference.
+  bool ParseMatches(const std::vector<Ort::Value>& output_tensors,
+                    const int batch_size,
+                    const int batch_idx,
+                    const int num_keypoints1,
+                    const int num_keypoints2,
+                    FeatureMatches* matches) const {
+    matches->clear();
 
-    // Parse mscores0 shape: [M].
+    const auto matches0_info = output_tensors[0].GetTensorTypeAndShapeInfo();
     const auto mscores0_info = output_tensors[1].GetTensorTypeAndShapeInfo();
-    const std::vector<int64_t> mscores0_shape = mscores0_info.GetShape();
-    THROW_CHECK_EQ(mscores0_shape.size(), 1);
-    THROW_CHECK_EQ(mscores0_shape[0], num_kpts);
+    const int64_t num_kpts = num_keypoints1;
+    if (static_cast<int64_t>(matches0_info.GetElementCount()) !=
+            batch_size * num_kpts ||
+        static_cast<int64_t>(mscores0_info.GetElementCount()) !=
+            batch_size * num_kpts) {
+      if (batch_size > 1) {
+        return false;
+      }
+      LOG(FATAL_THROW) << "Invalid shape for matches0 or mscores0: "
+                       << FormatONNXTensorShape(matches0_info.GetShape())
+                       << ", "
+                       << FormatONNXTensorShape(mscores0_info.GetShape())
+                       << " for " << num_kpts << " keypoints";
+    }
 
+    const int64_t offset = batch_idx * num_kpts;
     const float min_score = static_cast<float>(lightglue_options_.min_score);
-    const float* mscores0_data = output_tensors[1].GetTensorData<float>();
+    const float* mscores0_data =
+        output_tensors[1].GetTensorData<float>() + offset;
 
     // Handle both int64 and float output types for matches0.
     const auto matches0_type = matches0_info.GetElementType();
     if (matches0_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64) {
-      const int64_t* matches0_data = output_tensors[0].GetTensorData<int64_t>();
+      const int64_t* matches0_data =
+          output_tensors[0].GetTensorData<int64_t>() + offset;
       for (int64_t i = 0; i < num_kpts; ++i) {
         if (matches0_data[i] >= 0 && mscores0_data[i] >= min_score) {
           THROW_CHECK_LT(matches0_data[i], num_keypoints2);
@@ -462,7 +634,8 @@ class LightGlueONNXFeatureMatcher : public FeatureMatcher {
         }
       }
     } else if (matches0_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
-      const float* matches0_data = output_tensors[0].GetTensorData<float>();
+      const float* matches0_data =
+          output_tensors[0].GetTensorData<float>() + offset;
       for (int64_t i = 0; i < num_kpts; ++i) {
         const int64_t match_idx = static_cast<int64_t>(matches0_data[i]);
         if (match_idx >= 0 && mscores0_data[i] >= min_score) {
@@ -474,29 +647,10 @@ class LightGlueONNXFeatureMatcher : public FeatureMatcher {
     } else {
       LOG(FATAL_THROW) << "Unexpected matches0 output type: " << matches0_type;
     }
-  }
 
-  void MatchGuided(double max_error,
-                   const Image& image1,
-                   const Image& image2,
-                   TwoViewGeometry* two_view_geometry) override {
-    LOG(FATAL_THROW) << "Guided matching not supported for LightGlue.";
+    return true;
   }
 
- private:
-  struct CachedFeatures {
-    image_t image_id = kInvalidImageId;
-    std::vector<float> keypoints_data;
-    std::vector<int64_t> keypoints_shape;
-    std::vector<float> descriptors_data;
-    std::vector<int64_t> descriptors_shape;
-    float image_size[2];
-    std::vector<float> scales_data;
-    std::vector<int64_t> scales_shape;
-    std::vector<float> orientations_data;
-    std::vector<int64_t> orientations_shape;
-  };
-
   CachedFeatures FeaturesFromImage(const Image& image) {
     THROW_CHECK_NOTNULL(image.keypoints);
     THROW_CHECK_NOTNULL(image.descriptors);
@@ -551,18 +705,11 @@ class LightGlueONNXFeatureMatcher : public FeatureMatcher {
     }
 
     if (is_aliked) {
-      // ALIKED descriptors: stored as float bytes, reinterpret directly.
-      THROW_CHECK_EQ(image.descriptors->data.cols() % sizeof(float), 0);
-      const int descriptor_dim = image.descriptors->data.cols() / sizeof(float);
+      const int descriptor_dim = image.descriptors->NumDims();
       THROW_CHECK_GT(descriptor_dim, 0);
 
       features.descriptors_shape = {1, num_keypoints, descriptor_dim};
-      features.descriptors_data.resize(num_keypoints * descriptor_dim);
-      THROW_CHECK_EQ(image.descriptors->data.size(),
-                     features.descriptors_data.size() * sizeof(float));
-      std::memcpy(features.descriptors_data.data(),
-                  reinterpret_cast<const void*>(image.descriptors->data.data()),
-                  image.descriptors->data.size());
+      AlikedDescriptorsToFloat(*image.descriptors, &features.descriptors_data);
     } else {
       // SIFT descriptors: stored as uint8, cast to float32 and L2-normalize.
       // LightGlue was trained on root-normalized (RootSIFT) descriptors. The
@@ -599,10 +746,10 @@ class LightGlueONNXFeatureMatcher : public FeatureMatcher {
 
     // Image size as (width, height).
     const bool swap_dims = rot90 % 2;
-    features.image_size[0] =
-        static_cast<float>(swap_dims ? image_height : image_width);
-    features.image_size[1] =
-        static_cast<float>(swap_dims ? image_width : image_height);
+    features.image_size_shape = {1, 2};
+    features.image_size_data = {
+        static_cast<float>(swap_dims ? image_height : image_width),
+        static_cast<float>(swap_dims ? image_width : image_height)};
 
     return features;
   }
@@ -611,6 +758,7 @@ class LightGlueONNXFeatureMatcher : public FeatureMatcher {
   const LightGlueONNXMatchingOptions lightglue_options_;
   ONNXModel model_;
   bool has_scale_ori_ = false;
+  bool supports_batching_ = true;
 
   CachedFeatures prev_features1_;
   CachedFeatures prev_features2_;
@@ -642,6 +790,10 @@ std::unique_ptr<FeatureMatcher> CreateBruteForceONNXFeatureMatcher(
 bool LightGlueONNXMatchingOptions::Check() const {
   CHECK_OPTION_GE(min_score, 0);
   CHECK_OPTION_LE(min_score, 1);
+  CHECK_OPTION_GE(prefilter_min_num_matches, 0);
+  CHECK_OPTION_GT(prefilter_max_num_features, 0);
+  CHECK_OPTION_GT(prefilter_max_ratio, 0);
+  CHECK_OPTION_LE(prefilter_max_ratio, 1);
   return true;
 }
 
@@ -656,4 +808,59 @@ std::unique_ptr<FeatureMatcher> CreateLightGlueONNXFeatureMatcher(
 #endif
 }
 
+int CountLightGluePrefilterMatches(const FeatureDescriptors& descriptors1,
+                                   const FeatureDescriptors& descriptors2,
+                                   const int max_num_features,
+                                   const double max_ratio) {
+  THROW_CHECK_GT(max_num_features, 0);
+  if (descriptors1.data.rows() == 0 || descriptors2.data.rows() == 0) {
+    return 0;
+  }
+  const FeatureDescriptorsFloatData data1 =
+      PrefilterDescriptors(descriptors1, max_num_features);
+  const FeatureDescriptorsFloatData data2 =
+      PrefilterDescriptors(descriptors2, max_num_features);
+  THROW_CHECK_EQ(data1.cols(), data2.cols());
+
+  // The descriptors are normalized, so the squared distance of two
+  // descriptors is 2 - 2 * their dot product.
+  const Eigen::MatrixXf dots = data1 * data2.transpose();
+  Eigen::VectorXi best_idxs1(dots.cols());
+  for (Eigen::Index j = 0; j < dots.cols(); ++j) {
+    dots.col(j).maxCoeff(&best_idxs1(j));
+  }
+
+  const float max_squared_ratio = static_cast<float>(max_ratio * max_ratio);
+  int num_matches = 0;
+  for (Eigen::Index i = 0; i < dots.rows(); ++i) {
+    float best_dot = -std::numeric_limits<float>::max();
+    float second_best_dot = -std::numeric_limits<float>::max();
+    Eigen::Index best_idx2 = -1;
+    for (Eigen::Index j = 0; j < dots.cols(); ++j) {
+      const float dot = dots(i, j);
+      if (dot > best_dot) {
+        second_best_dot = best_dot;
+        best_dot = dot;
+        best_idx2 = j;
+      } else if (dot > second_best_dot) {
+        second_best_dot = dot;
+      }
+    }
+    if (best_idxs1(best_idx2) != i) {
+      continue;
+    }
+    if (dots.cols() > 1) {
+      const float best_squared_dist = std::max(0.f, 2 - 2 * best_dot);
+      const float second_best_squared_dist =
+          std::max(0.f, 2 - 2 * second_best_dot);
+      if (best_squared_dist > max_squared_ratio * second_best_squared_dist) {
+        continue;
+      }
+    }
+    ++num_matches;
+  }
+
+  return num_matches;
+}
+
 }  // namespace colmap
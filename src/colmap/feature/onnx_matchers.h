@@ -64,6 +64,20 @@ struct LightGlueONNXMatchingOptions {
   // value are discarded (post-model filtering).
   double min_score = 0.1;
 
+  // Skip image pairs with fewer mutual nearest neighbor matches among their
+  // first prefilter_max_num_features descriptors, before running the much more
+  // expensive LightGlue inference. This mostly avoids the inference for
+  // non-overlapping pairs, e.g., from vocabulary tree retrieval. Set to 0 to
+  // match all pairs.
+  int prefilter_min_num_matches = 0;
+
+  // The number of descriptors per image used by the prefilter.
+  int prefilter_max_num_features = 512;
+
+  // Maximum distance ratio between the best and second best nearest neighbor
+  // for a prefilter match.
+  double prefilter_max_ratio = 0.9;
+
   // Path to the LightGlue ONNX model file.
   std::string model_path;
 
@@ -74,4 +88,12 @@ std::unique_ptr<FeatureMatcher> CreateLightGlueONNXFeatureMatcher(
     const FeatureMatchingOptions& options,
     const LightGlueONNXMatchingOptions& lightglue_options);
 
+// Count the mutual nearest neighbor matches between the first
+// max_num_features L2-normalized descriptors of two images, which pass the
+// ratio test. Used as a cheap prefilter for the LightGlue matcher.
+int CountLightGluePrefilterMatches(const FeatureDescriptors& descriptors1,
+                                   const FeatureDescriptors& descriptors2,
+                                   int max_num_features,
+                                   double max_ratio);
+
 }  // namespace colmap
@@ -716,5 +716,45 @@ TEST_F(SiftLightGlueONNXMatcherTest, Caching) {
   }
 }
 
+TEST(CountLightGluePrefilterMatches, Nominal) {
+  SetPRNGSeed(42);
+  constexpr int kNumDescriptors = 100;
+  constexpr int kDescriptorDim = 128;
+  FeatureDescriptorsFloatData float_data =
+      FeatureDescriptorsFloatData::Random(kNumDescriptors, kDescriptorDim);
+  L2NormalizeFeatureDescriptors(&float_data);
+  const FeatureDescriptors descriptors = FeatureDescriptors::FromFloat(
+      FeatureDescriptorsFloat(FeatureExtractorType::ALIKED_N16ROT, float_data));
+
+  EXPECT_EQ(CountLightGluePrefilterMatches(descriptors,
+                                           descriptors,
+                                           /*max_num_features=*/512,
+                                           /*max_ratio=*/0.9),
+            kNumDescriptors);
+  EXPECT_EQ(CountLightGluePrefilterMatches(descriptors,
+                                           descriptors,
+                                           /*max_num_features=*/10,
+                                           /*max_ratio=*/0.9),
+            10);
+
+  FeatureDescriptorsFloatData other_float_data =
+      FeatureDescriptorsFloatData::Random(kNumDescriptors, kDescriptorDim);
+  L2NormalizeFeatureDescriptors(&other_float_data);
+  const FeatureDescriptors other_descriptors =
+      FeatureDescriptors::FromFloat(FeatureDescriptorsFloat(
+          FeatureExtractorType::ALIKED_N16ROT, other_float_data));
+  EXPECT_LT(CountLightGluePrefilterMatches(descriptors,
+                                           other_descriptors,
+                                           /*max_num_features=*/512,
+                                           /*max_ratio=*/0.8),
+            kNumDescriptors / 10);
+
+  EXPECT_EQ(CountLightGluePrefilterMatches(descriptors,
+                                           FeatureDescriptors(),
+                                           /*max_num_features=*/512,
+                                           /*max_ratio=*/0.9),
+            0);
+}
+
 }  // namespace
 }  // namespace colmap
@@ -32,10 +32,16 @@
 #include "colmap/util/file.h"
 #include "colmap/util/misc.h"
 #include "colmap/util/threading.h"
+#ifdef COLMAP_CUDA_ENABLED
+#include "colmap/util/cuda.h"
+#endif
 
+#include <filesystem>
 #include <iostream>
 #include <mutex>
+#include <random>
 #include <sstream>
+#include <unordered_map>
 #ifdef _WIN32
 #include <Windows.h>
 #endif
@@ -62,6 +68,21 @@ namespace {
     throw;
   }
 }
+
+std::basic_string<ORTCHAR_T> ToORTPath(const std::string& path) {
+#ifdef _WIN32
+  const unsigned int code_page = GetACP();
+  const int wide_len =
+      MultiByteToWideChar(code_page, 0, path.c_str(), -1, nullptr, 0);
+  std::wstring path_wide(wide_len, L'\0');
+  MultiByteToWideChar(code_page, 0, path.c_str(), -1, &path_wide[0], wide_len);
+  // Drop the null terminator written by MultiByteToWideChar.
+  path_wide.resize(wide_len - 1);
+  return path_wide;
+#else
+  return path;
+#endif
+}
 }  // namespace
 
 std::string FormatONNXTensorShape(const std::vector<int64_t>& shape) {
@@ -96,10 +117,25 @@ void ThrowCheckONNXNode(const std::string_view name,
   }
 }
 
+struct ONNXModel::Session {
+  // Keeps the process-wide environment alive as long as the session.
+  std::shared_ptr<Ort::Env> env;
+  Ort::AllocatorWithDefaultOptions allocator;
+  Ort::SessionOptions session_options;
+  std::unique_ptr<Ort::Session> session;
+  std::vector<std::vector<int64_t>> input_shapes;
+  std::vector<Ort::AllocatedStringPtr> input_name_strs;
+  std::vector<char*> input_names;
+  std::vector<std::vector<int64_t>> output_shapes;
+  std::vector<Ort::AllocatedStringPtr> output_name_strs;
+  std::vector<char*> output_names;
+};
+
 ONNXModel::ONNXModel(std::string model_path,
                      int num_threads,
                      bool use_gpu,
                      const std::string& gpu_index) {
+  const bool is_downloaded_model = IsURI(model_path);
   {
     static std::mutex download_mutex;
     const std::lock_guard<std::mutex> lock(download_mutex);
@@ -109,27 +145,53 @@ ONNXModel::ONNXModel(std::string model_path,
   const int num_eff_threads = GetEffectiveNumThreads(num_threads);
 
   try {
-    InitializeSession(model_path, num_eff_threads, use_gpu, gpu_index);
+    session_ = GetOrCreateSession(
+        model_path, is_downloaded_model, num_eff_threads, use_gpu, gpu_index);
   } catch (...) {
     RethrowONNXException();
   }
 }
 
-void ONNXModel::InitializeSession(const std::string& model_path,
-                                  int num_threads,
-                                  bool use_gpu,
-                                  const std::string& gpu_index) {
+std::shared_ptr<const ONNXModel::Session> ONNXModel::GetOrCreateSession(
+    const std::string& model_path,
+    const bool is_downloaded_model,
+    const int num_threads,
+    const bool use_gpu,
+    const std::string& gpu_index) {
+  std::ostringstream key;
+  key << model_path << ';' << num_threads << ';' << use_gpu << ';'
+      << gpu_index;
+
+  // Sessions are only kept alive by the models, so that their memory is
+  // released once no model uses them anymore. Creation is serialized, so
+  // that concurrently constructed models wait for the first one.
+  static std::mutex sessions_mutex;
+  static std::unordered_map<std::string, std::weak_ptr<const Session>>
+      sessions;
+  const std::lock_guard<std::mutex> lock(sessions_mutex);
+  std::weak_ptr<const Session>& cached_session = sessions[key.str()];
+  if (std::shared_ptr<const Session> session = cached_session.lock()) {
+    VLOG(2) << "Reusing ONNX session for " << model_path;
+    return session;
+  }
+
+  static const std::shared_ptr<Ort::Env> env = std::make_shared<Ort::Env>();
+
+  auto session = std::make_shared<Session>();
+  session->env = env;
+
   // Use sequential execution mode with a single inter-op thread, since our
   // models (ALIKED, LightGlue) are sequential CNNs/Transformers without
   // independent graph branches. Inter-op parallelism would only cause thread
   // contention. Intra-op threads parallelize within individual operators
   // (convolutions, matrix multiplications) and are managed at the caller level.
-  session_options_.SetInterOpNumThreads(1);
-  session_options_.SetIntraOpNumThreads(num_threads);
-  session_options_.SetExecutionMode(ORT_SEQUENTIAL);
-  session_options_.SetGraphOptimizationLevel(
+  Ort::SessionOptions& session_options = session->session_options;
+  session_options.SetInterOpNumThreads(1);
+  session_options.SetIntraOpNumThreads(num_threads);
+  session_options.SetExecutionMode(ORT_SEQUENTIAL);
+  session_options.SetGraphOptimizationLevel(
       GraphOptimizationLevel::ORT_ENABLE_ALL);
-  session_options_.SetLogSeverityLevel(ORT_LOGGING_LEVEL_FATAL);
+  session_options.SetLogSeverityLevel(ORT_LOGGING_LEVEL_FATAL);
 
 #ifdef COLMAP_CUDA_ENABLED
   if (use_gpu) {
@@ -140,66 +202,121 @@ void ONNXModel::InitializeSession(const std::string& model_path,
     if (gpu_indices[0] >= 0) {
       cuda_options.device_id = gpu_indices[0];
     }
-    session_options_.AppendExecutionProvider_CUDA(cuda_options);
+    // ONNX Runtime allocates from its own arena, which is limited to the
+    // shared budget and only grows by the requested sizes.
+    const size_t gpu_mem_limit = GetCudaMemoryBudget("onnx");
+    if (gpu_mem_limit > 0) {
+      cuda_options.gpu_mem_limit = gpu_mem_limit;
+      cuda_options.arena_extend_strategy = 1;
+    }
+    session_options.AppendExecutionProvider_CUDA(cuda_options);
   }
 #endif
 
-  VLOG(2) << "Loading ONNX model from " << model_path;
-#ifdef _WIN32
-  const unsigned int code_page = GetACP();
-  const int wide_len =
-      MultiByteToWideChar(code_page, 0, model_path.c_str(), -1, nullptr, 0);
-  std::wstring model_path_wide(wide_len, L'\0');
-  MultiByteToWideChar(
-      code_page, 0, model_path.c_str(), -1, &model_path_wide[0], wide_len);
-  const wchar_t* model_path_cstr = model_path_wide.c_str();
-#else
-  const char* model_path_cstr = model_path.c_str();
-#endif
-  session_ =
-      std::make_unique<Ort::Session>(env_, model_path_cstr, session_options_);
+  // Downloaded models are immutable, so their optimized graph can be cached on
+  // disk. The cached graph only contains the hardware independent (extended)
+  // optimizations, which would otherwise be repeated for every session.
+  // Layout optimizations are cheap and still applied at load time. GPU
+  // sessions are not cached, as their graphs are partitioned across providers.
+  std::string load_model_path = model_path;
+  std::string optimized_model_path;
+  std::string tmp_optimized_model_path;
+  if (is_downloaded_model && !use_gpu) {
+    optimized_model_path = model_path + ".ort" +
+                           OrtGetApiBase()->GetVersionString() +
+                           ".optimized.onnx";
+    if (ExistsFile(optimized_model_path)) {
+      VLOG(2) << "Loading cached optimized ONNX model";
+      load_model_path = optimized_model_path;
+    } else {
+      // Write to a unique temporary file first, so that concurrent processes
+      // never load a partially written model.
+      tmp_optimized_model_path = optimized_model_path + "." +
+                                 std::to_string(std::random_device()()) +
+                                 ".tmp";
+      session_options.SetGraphOptimizationLevel(
+          GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
+      session_options.SetOptimizedModelFilePath(
+          ToORTPath(tmp_optimized_model_path).c_str());
+    }
+  }
+
+  VLOG(2) << "Loading ONNX model from " << load_model_path;
+  session->session = std::make_unique<Ort::Session>(
+      *env, ToORTPath(load_model_path).c_str(), session_options);
+
+  if (!tmp_optimized_model_path.empty()) {
+    std::error_code error;
+    std::filesystem::rename(
+        tmp_optimized_model_path, optimized_model_path, error);
+    if (error) {
+      VLOG(2) << "Failed to cache optimized ONNX model: " << error.message();
+      std::filesystem::remove(tmp_optimized_model_path, error);
+    }
+  }
 
   VLOG(2) << "Parsing the inputs";
-  const int num_inputs = session_->GetInputCount();
-  input_name_strs_.reserve(num_inputs);
-  input_names_.reserve(num_inputs);
-  input_shapes_.reserve(num_inputs);
+  const int num_inputs = session->session->GetInputCount();
+  session->input_name_strs.reserve(num_inputs);
+  session->input_names.reserve(num_inputs);
+  session->input_shapes.reserve(num_inputs);
   for (int i = 0; i < num_inputs; ++i) {
-    input_name_strs_.emplace_back(
-        session_->GetInputNameAllocated(i, allocator_));
-    input_names_.emplace_back(input_name_strs_[i].get());
-    input_shapes_.emplace_back(
-        session_->GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape());
+    session->input_name_strs.emplace_back(
+        session->session->GetInputNameAllocated(i, session->allocator));
+    session->input_names.emplace_back(session->input_name_strs[i].get());
+    session->input_shapes.emplace_back(session->session->GetInputTypeInfo(i)
+                                           .GetTensorTypeAndShapeInfo()
+                                           .GetShape());
   }
 
   VLOG(2) << "Parsing the outputs";
-  const int num_outputs = session_->GetOutputCount();
-  output_name_strs_.reserve(num_outputs);
-  output_names_.reserve(num_outputs);
-  output_shapes_.reserve(num_outputs);
+  const int num_outputs = session->session->GetOutputCount();
+  session->output_name_strs.reserve(num_outputs);
+  session->output_names.reserve(num_outputs);
+  session->output_shapes.reserve(num_outputs);
   for (int i = 0; i < num_outputs; ++i) {
-    output_name_strs_.emplace_back(
-        session_->GetOutputNameAllocated(i, allocator_));
-    output_names_.emplace_back(output_name_strs_[i].get());
-    output_shapes_.emplace_back(
-        session_->GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape());
+    session->output_name_strs.emplace_back(
+        session->session->GetOutputNameAllocated(i, session->allocator));
+    session->output_names.emplace_back(session->output_name_strs[i].get());
+    session->output_shapes.emplace_back(session->session->GetOutputTypeInfo(i)
+                                            .GetTensorTypeAndShapeInfo()
+                                            .GetShape());
   }
+
+  cached_session = session;
+  return session;
 }
 
 std::vector<Ort::Value> ONNXModel::Run(
     const std::vector<Ort::Value>& input_tensors) const {
   try {
-    return session_->Run(Ort::RunOptions(),
-                         input_names_.data(),
-                         input_tensors.data(),
-                         input_tensors.size(),
-                         output_names_.data(),
-                         output_names_.size());
+    return session_->session->Run(Ort::RunOptions(),
+                                  session_->input_names.data(),
+                                  input_tensors.data(),
+                                  input_tensors.size(),
+                                  session_->output_names.data(),
+                                  session_->output_names.size());
   } catch (...) {
     RethrowONNXException();
   }
 }
 
+const std::vector<std::vector<int64_t>>& ONNXModel::input_shapes() const {
+  return session_->input_shapes;
+}
+
+const std::vector<char*>& ONNXModel::input_names() const {
+  return session_->input_names;
+}
+
+const std::vector<std::vector<int64_t>>& ONNXModel::output_shapes() const {
+  return session_->output_shapes;
+}
+
+const std::vector<char*>& ONNXModel::output_names() const {
+  return session_->output_names;
+}
+
 #endif  // COLMAP_ONNX_ENABLED
 
 }  // namespace colmap
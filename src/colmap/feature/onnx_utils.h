@@ -53,6 +53,13 @@ void ThrowCheckONNXNode(std::string_view name,
 
 // Wrapper for ONNX Runtime session management.
 // Handles model loading, input/output shape parsing, and inference.
+//
+// Sessions are shared process-wide between all models with the same model
+// path and session options, so that extractor and matcher threads only load
+// and optimize a model once, and concurrent inference on a shared session is
+// thread-safe. For CPU sessions of downloaded models, the optimized graph is
+// additionally cached on disk next to the downloaded model file, so that later
+// processes skip the graph optimization.
 class ONNXModel {
  public:
   ONNXModel(std::string model_path,
@@ -63,31 +70,22 @@ class ONNXModel {
   std::vector<Ort::Value> Run(
       const std::vector<Ort::Value>& input_tensors) const;
 
-  const std::vector<std::vector<int64_t>>& input_shapes() const {
-    return input_shapes_;
-  }
-  const std::vector<char*>& input_names() const { return input_names_; }
-  const std::vector<std::vector<int64_t>>& output_shapes() const {
-    return output_shapes_;
-  }
-  const std::vector<char*>& output_names() const { return output_names_; }
+  const std::vector<std::vector<int64_t>>& input_shapes() const;
+  const std::vector<char*>& input_names() const;
+  const std::vector<std::vector<int64_t>>& output_shapes() const;
+  const std::vector<char*>& output_names() const;
 
  private:
-  void InitializeSession(const std::string& model_path,
-                         int num_threads,
-                         bool use_gpu,
-                         const std::string& gpu_index);
+  struct Session;
+
+  static std::shared_ptr<const Session> GetOrCreateSession(
+      const std::string& model_path,
+      bool is_downloaded_model,
+      int num_threads,
+      bool use_gpu,
+      const std::string& gpu_index);
 
-  Ort::Env env_;
-  Ort::AllocatorWithDefaultOptions allocator_;
-  Ort::SessionOptions session_options_;
-  std::unique_ptr<Ort::Session> session_;
-  std::vector<std::vector<int64_t>> input_shapes_;
-  std::vector<Ort::AllocatedStringPtr> input_name_strs_;
-  std::vector<char*> input_names_;
-  std::vector<std::vector<int64_t>> output_shapes_;
-  std::vector<Ort::AllocatedStringPtr> output_name_strs_;
-  std::vector<char*> output_names_;
+  std::shared_ptr<const Session> session_;
 };
 
 }  // namespace colmap
@@ -37,6 +37,7 @@
 #include "colmap/util/misc.h"
 #include "colmap/util/opengl_utils.h"
 #include "colmap/util/string.h"
+#include "colmap/util/threading.h"
 
 #if defined(COLMAP_GPU_ENABLED)
 #include "thirdparty/SiftGPU/SiftGPU.h"
@@ -50,13 +51,17 @@
 #include "thirdparty/VLFeat/covdet.h"
 #include "thirdparty/VLFeat/sift.h"
 
+#include <algorithm>
 #include <array>
 #include <fstream>
+#include <functional>
 #include <locale>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #include <sstream>
+#include <unordered_map>
 
 #include <Eigen/Geometry>
 
@@ -78,6 +83,11 @@ bool SiftExtractionOptions::Check() const {
     CHECK_OPTION_GE(dsp_max_scale, dsp_min_scale);
     CHECK_OPTION_GT(dsp_num_scales, 0);
   }
+  CHECK_OPTION_GE(tile_size, 0);
+  if (tile_size > 0) {
+    CHECK_OPTION_GE(tile_overlap, 0);
+    CHECK_OPTION_LT(tile_overlap, tile_size);
+  }
   return true;
 }
 
@@ -547,6 +557,195 @@ class CovariantSiftCPUFeatureExtractor : public FeatureExtractor {
   const FeatureExtractionOptions options_;
 };
 
+// Splits one image dimension into overlapping tiles. Each pixel is owned by
+// exactly one tile core, which starts and ends in the middle of the overlap
+// with the neighboring tiles.
+struct SiftTileRange {
+  int begin = 0;
+  int end = 0;
+  int core_begin = 0;
+  int core_end = 0;
+};
+
+std::vector<SiftTileRange> ComputeSiftTileRanges(const int size,
+                                                 const int tile_size,
+                                                 const int tile_overlap) {
+  if (size <= tile_size) {
+    return {{0, size, 0, size}};
+  }
+
+  // Distribute the pixels evenly across the minimum number of tiles.
+  const int step = tile_size - tile_overlap;
+  const int num_tiles = (size - tile_overlap + step - 1) / step;
+  const int even_step = (size - tile_overlap + num_tiles - 1) / num_tiles;
+
+  std::vector<SiftTileRange> ranges(num_tiles);
+  for (int i = 0; i < num_tiles; ++i) {
+    SiftTileRange& range = ranges[i];
+    range.begin = i * even_step;
+    range.end = std::min(size, range.begin + even_step + tile_overlap);
+    range.core_begin = i == 0 ? 0 : range.begin + tile_overlap / 2;
+    range.core_end =
+        i == num_tiles - 1 ? size : (i + 1) * even_step + tile_overlap / 2;
+  }
+  return ranges;
+}
+
+// Extracts features from overlapping tiles of the image in parallel, such
+// that the memory of the scale space is bounded by the tile size instead of
+// the image size. Features are only kept in the tile whose core contains
+// their location, which removes the duplicates detected in the overlaps.
+class TiledSiftCPUFeatureExtractor : public FeatureExtractor {
+ public:
+  TiledSiftCPUFeatureExtractor(
+      const FeatureExtractionOptions& options,
+      std::function<std::unique_ptr<FeatureExtractor>()> create_extractor)
+      : options_(options), create_extractor_(std::move(create_extractor)) {
+    THROW_CHECK(options_.Check());
+    THROW_CHECK_GT(options_.sift->tile_size, 0);
+    extractors_.push_back(create_extractor_());
+  }
+
+  bool Extract(const Bitmap& bitmap,
+               FeatureKeypoints* keypoints,
+               FeatureDescriptors* descriptors) override {
+    THROW_CHECK(bitmap.IsGrey());
+    THROW_CHECK_NOTNULL(keypoints);
+
+    const int tile_size = options_.sift->tile_size;
+    const int tile_overlap = options_.sift->tile_overlap;
+    if (bitmap.Width() <= tile_size && bitmap.Height() <= tile_size) {
+      return extractors_[0]->Extract(bitmap, keypoints, descriptors);
+    }
+
+    const std::vector<SiftTileRange> col_ranges =
+        ComputeSiftTileRanges(bitmap.Width(), tile_size, tile_overlap);
+    const std::vector<SiftTileRange> row_ranges =
+        ComputeSiftTileRanges(bitmap.Height(), tile_size, tile_overlap);
+    const size_t num_tiles = col_ranges.size() * row_ranges.size();
+
+    if (thread_pool_ == nullptr) {
+      const int num_threads =
+          std::min(GetEffectiveNumThreads(options_.sift->tile_num_threads),
+                   static_cast<int>(num_tiles));
+      thread_pool_ = std::make_unique<ThreadPool>(num_threads);
+      while (extractors_.size() < thread_pool_->NumThreads()) {
+        extractors_.push_back(create_extractor_());
+      }
+    }
+
+    std::vector<FeatureKeypoints> tile_keypoints(num_tiles);
+    std::vector<FeatureDescriptors> tile_descriptors(num_tiles);
+    std::vector<char> tile_success(num_tiles, 0);
+    for (size_t row_idx = 0; row_idx < row_ranges.size(); ++row_idx) {
+      for (size_t col_idx = 0; col_idx < col_ranges.size(); ++col_idx) {
+        const size_t tile_idx = row_idx * col_ranges.size() + col_idx;
+        thread_pool_->AddTask([&, tile_idx, row_idx, col_idx]() {
+          tile_success[tile_idx] =
+              ExtractTile(bitmap,
+                          row_ranges[row_idx],
+                          col_ranges[col_idx],
+                          extractors_[thread_pool_->GetThreadIndex()].get(),
+                          &tile_keypoints[tile_idx],
+                          &tile_descriptors[tile_idx]);
+        });
+      }
+    }
+    thread_pool_->Wait();
+
+    size_t num_features = 0;
+    for (size_t tile_idx = 0; tile_idx < num_tiles; ++tile_idx) {
+      if (!tile_success[tile_idx]) {
+        return false;
+      }
+      num_features += tile_keypoints[tile_idx].size();
+    }
+
+    // Concatenate the tiles in order, so that the result does not depend on
+    // the scheduling of the threads.
+    FeatureDescriptors all_descriptors(
+        FeatureExtractorType::SIFT,
+        FeatureDescriptorsData(num_features, kSiftDescriptorDim));
+    keypoints->clear();
+    keypoints->reserve(num_features);
+    for (size_t tile_idx = 0; tile_idx < num_tiles; ++tile_idx) {
+      all_descriptors.data.middleRows(keypoints->size(),
+                                      tile_keypoints[tile_idx].size()) =
+          tile_descriptors[tile_idx].data;
+      keypoints->insert(keypoints->end(),
+                        tile_keypoints[tile_idx].begin(),
+                        tile_keypoints[tile_idx].end());
+    }
+
+    ExtractTopScaleFeatures(
+        keypoints, &all_descriptors, options_.sift->max_num_features);
+    if (descriptors != nullptr) {
+      *descriptors = std::move(all_descriptors);
+    }
+
+    return true;
+  }
+
+ private:
+  static bool ExtractTile(const Bitmap& bitmap,
+                          const SiftTileRange& row_range,
+                          const SiftTileRange& col_range,
+                          FeatureExtractor* extractor,
+                          FeatureKeypoints* keypoints,
+                          FeatureDescriptors* descriptors) {
+    const int tile_width = col_range.end - col_range.begin;
+    const int tile_height = row_range.end - row_range.begin;
+    Bitmap tile(tile_width, tile_height, /*as_rgb=*/false);
+    const uint8_t* src = bitmap.RowMajorData().data();
+    uint8_t* dst = tile.RowMajorData().data();
+    for (int r = 0; r < tile_height; ++r) {
+      std::copy_n(src + static_cast<size_t>(row_range.begin + r) *
+                            bitmap.Width() +
+                      col_range.begin,
+                  tile_width,
+                  dst + static_cast<size_t>(r) * tile_width);
+    }
+
+    FeatureKeypoints tile_keypoints;
+    FeatureDescriptors tile_descriptors;
+    if (!extractor->Extract(tile, &tile_keypoints, &tile_descriptors)) {
+      return false;
+    }
+    THROW_CHECK_EQ(tile_keypoints.size(), tile_descriptors.data.rows());
+
+    // Keep the features in the core of the tile in image coordinates.
+    std::vector<Eigen::Index> core_indices;
+    core_indices.reserve(tile_keypoints.size());
+    for (size_t i = 0; i < tile_keypoints.size(); ++i) {
+      FeatureKeypoint& keypoint = tile_keypoints[i];
+      keypoint.x += col_range.begin;
+      keypoint.y += row_range.begin;
+      if (keypoint.x >= col_range.core_begin &&
+          keypoint.x < col_range.core_end &&
+          keypoint.y >= row_range.core_begin &&
+          keypoint.y < row_range.core_end) {
+        core_indices.push_back(i);
+      }
+    }
+
+    keypoints->resize(core_indices.size());
+    descriptors->type = tile_descriptors.type;
+    descriptors->data.resize(core_indices.size(), kSiftDescriptorDim);
+    for (size_t i = 0; i < core_indices.size(); ++i) {
+      (*keypoints)[i] = tile_keypoints[core_indices[i]];
+      descriptors->data.row(i) = tile_descriptors.data.row(core_indices[i]);
+    }
+
+    return true;
+  }
+
+  const FeatureExtractionOptions options_;
+  const std::function<std::unique_ptr<FeatureExtractor>()> create_extractor_;
+  // One extractor per thread, since extractors are not thread-safe.
+  std::vector<std::unique_ptr<FeatureExtractor>> extractors_;
+  std::unique_ptr<ThreadPool> thread_pool_;
+};
+
 #if defined(COLMAP_GPU_ENABLED)
 // Mutexes that ensure that only one thread extracts/matches on the same GPU
 // at the same time, since SiftGPU internally uses static variables.
@@ -747,13 +946,29 @@ class SiftGPUFeatureExtractor : public FeatureExtractor {
 
 std::unique_ptr<FeatureExtractor> CreateSiftFeatureExtractor(
     const FeatureExtractionOptions& options) {
-  if (options.sift->estimate_affine_shape ||
+  const bool use_covariant_extractor =
+      options.sift->estimate_affine_shape ||
       options.sift->domain_size_pooling ||
-      options.sift->force_covariant_extractor) {
+      options.sift->force_covariant_extractor;
+  if (options.sift->tile_size > 0 &&
+      (use_covariant_extractor || !options.use_gpu)) {
+    LOG(INFO) << "Creating tiled SIFT CPU feature extractor";
+    return std::make_unique<TiledSiftCPUFeatureExtractor>(
+        options, [options, use_covariant_extractor]() {
+          return use_covariant_extractor
+                     ? CovariantSiftCPUFeatureExtractor::Create(options)
+                     : SiftCPUFeatureExtractor::Create(options);
+        });
+  }
+
+  if (use_covariant_extractor) {
     LOG(INFO) << "Creating Covariant SIFT CPU feature extractor";
     return CovariantSiftCPUFeatureExtractor::Create(options);
   } else if (options.use_gpu) {
 #if defined(COLMAP_GPU_ENABLED)
+    if (options.sift->tile_size > 0) {
+      LOG(WARNING) << "Tiled SIFT extraction is only supported on the CPU.";
+    }
     LOG(INFO) << "Creating SIFT GPU feature extractor";
     return SiftGPUFeatureExtractor::Create(options);
 #else
@@ -951,60 +1166,131 @@ void FindBestMatchesIndex(const Eigen::RowMajorMatrixXi& indices_1to2,
   }
 }
 
-enum class DistanceType {
-  L2,
-  DOT_PRODUCT,
-};
-
-Eigen::RowMajorMatrixXf ComputeSiftDistanceMatrix(
-    const DistanceType distance_type,
-    const FeatureKeypoints* keypoints1,
-    const FeatureKeypoints* keypoints2,
+// Find the best guided matches from sparse candidate lists. Only descriptor
+// pairs passing the geometric filter are compared, which avoids computing and
+// storing the dense distance matrix. The results are equivalent to matching
+// the dense distance matrix, in which geometrically rejected pairs have the
+// maximum distance.
+void FindGuidedMatchesSparse(
     const FeatureDescriptorsData& descriptors1,
     const FeatureDescriptorsData& descriptors2,
-    const std::function<bool(float, float, float, float)>& guided_filter) {
-  if (guided_filter != nullptr) {
-    THROW_CHECK_NOTNULL(keypoints1);
-    THROW_CHECK_NOTNULL(keypoints2);
-    THROW_CHECK_EQ(keypoints1->size(), descriptors1.rows());
-    THROW_CHECK_EQ(keypoints2->size(), descriptors2.rows());
+    const std::function<void(int, std::vector<int>*)>& find_candidates,
+    const float max_ratio,
+    const float max_distance,
+    const bool cross_check,
+    FeatureMatches* matches) {
+  matches->clear();
+
+  const int num_descriptors1 = descriptors1.rows();
+  const int num_descriptors2 = descriptors2.rows();
+  if (num_descriptors1 == 0 || num_descriptors2 == 0) {
+    return;
   }
 
+  const float max_l2_dist = kSqSiftDescriptorNorm * max_distance * max_distance;
+
+  struct BestMatch {
+    int idx = -1;
+    int num_candidates = 0;
+    float best_l2_dist = std::numeric_limits<float>::max();
+    float second_best_l2_dist = std::numeric_limits<float>::max();
+
+    void Update(const int other_idx, const float l2_dist) {
+      ++num_candidates;
+      if (l2_dist < best_l2_dist) {
+        idx = other_idx;
+        second_best_l2_dist = best_l2_dist;
+        best_l2_dist = l2_dist;
+      } else if (l2_dist < second_best_l2_dist) {
+        second_best_l2_dist = l2_dist;
+      }
+    }
+
+    int Finalize(const int num_total,
+                 const float max_l2_dist,
+                 const float max_ratio) {
+      // Geometrically rejected pairs have the maximum distance.
+      if (num_candidates < num_total) {
+        const float rejected_l2_dist = kSqSiftDescriptorNorm;
+        if (rejected_l2_dist < best_l2_dist) {
+          idx = -1;
+          second_best_l2_dist = best_l2_dist;
+          best_l2_dist = rejected_l2_dist;
+        } else if (rejected_l2_dist < second_best_l2_dist) {
+          second_best_l2_dist = rejected_l2_dist;
+        }
+      }
+      if (idx == -1 || best_l2_dist > max_l2_dist ||
+          std::sqrt(best_l2_dist) >=
+              max_ratio * std::sqrt(second_best_l2_dist)) {
+        return -1;
+      }
+      return idx;
+    }
+  };
+
   const Eigen::Matrix<int, Eigen::Dynamic, kSiftDescriptorDim>
       descriptors1_int = descriptors1.cast<int>();
   const Eigen::Matrix<int, Eigen::Dynamic, kSiftDescriptorDim>
       descriptors2_int = descriptors2.cast<int>();
 
-  Eigen::RowMajorMatrixXf distances(descriptors1.rows(), descriptors2.rows());
+  std::vector<BestMatch> best_matches_2to1(num_descriptors2);
+  std::vector<int> matches_1to2(num_descriptors1, -1);
+  std::vector<int> candidates;
+
+  for (int i1 = 0; i1 < num_descriptors1; ++i1) {
+    candidates.clear();
+    find_candidates(i1, &candidates);
+    BestMatch best_match_1to2;
+    for (const int i2 : candidates) {
+      const float l2_dist =
+          (descriptors1_int.row(i1) - descriptors2_int.row(i2)).squaredNorm();
+      best_match_1to2.Update(i2, l2_dist);
+      best_matches_2to1[i2].Update(i1, l2_dist);
+    }
+    matches_1to2[i1] =
+        best_match_1to2.Finalize(num_descriptors2, max_l2_dist, max_ratio);
+  }
+
+  std::vector<int> matches_2to1;
+  if (cross_check) {
+    matches_2to1.resize(num_descriptors2);
+    for (int i2 = 0; i2 < num_descriptors2; ++i2) {
+      matches_2to1[i2] = best_matches_2to1[i2].Finalize(
+          num_descriptors1, max_l2_dist, max_ratio);
+    }
+  }
+
+  for (int i1 = 0; i1 < num_descriptors1; ++i1) {
+    const int i2 = matches_1to2[i1];
+    if (i2 == -1 || (cross_check && matches_2to1[i2] != i1)) {
+      continue;
+    }
+    FeatureMatch match;
+    match.point2D_idx1 = i1;
+    match.point2D_idx2 = i2;
+    matches->push_back(match);
+  }
+}
+
+Eigen::RowMajorMatrixXf ComputeSiftDotProductMatrix(
+    const FeatureDescriptorsData& descriptors1,
+    const FeatureDescriptorsData& descriptors2) {
+  const Eigen::Matrix<int, Eigen::Dynamic, kSiftDescriptorDim>
+      descriptors1_int = descriptors1.cast<int>();
+  const Eigen::Matrix<int, Eigen::Dynamic, kSiftDescriptorDim>
+      descriptors2_int = descriptors2.cast<int>();
+
+  Eigen::RowMajorMatrixXf dot_products(descriptors1.rows(),
+                                       descriptors2.rows());
   for (Eigen::Index i1 = 0; i1 < descriptors1.rows(); ++i1) {
     for (Eigen::Index i2 = 0; i2 < descriptors2.rows(); ++i2) {
-      if (guided_filter != nullptr && guided_filter((*keypoints1)[i1].x,
-                                                    (*keypoints1)[i1].y,
-                                                    (*keypoints2)[i2].x,
-                                                    (*keypoints2)[i2].y)) {
-        if (distance_type == DistanceType::L2) {
-          distances(i1, i2) = kSqSiftDescriptorNorm;
-        } else if (distance_type == DistanceType::DOT_PRODUCT) {
-          distances(i1, i2) = 0;
-        } else {
-          LOG(FATAL_THROW) << "Distance type not supported";
-        }
-      } else {
-        if (distance_type == DistanceType::L2) {
-          distances(i1, i2) =
-              (descriptors1_int.row(i1) - descriptors2_int.row(i2))
-                  .squaredNorm();
-        } else if (distance_type == DistanceType::DOT_PRODUCT) {
-          distances(i1, i2) =
-              descriptors1_int.row(i1).dot(descriptors2_int.row(i2));
-        } else {
-          LOG(FATAL_THROW) << "Distance type not supported";
-        }
-      }
+      dot_products(i1, i2) =
+          descriptors1_int.row(i1).dot(descriptors2_int.row(i2));
     }
   }
 
-  return distances;
+  return dot_products;
 }
 
 FeatureKeypoints NormalizeFeatureKeypoints(const Camera& camera,
@@ -1073,12 +1359,8 @@ class SiftCPUFeatureMatcher : public FeatureMatcher {
 
     if (options_.sift->cpu_brute_force_matcher) {
       const Eigen::RowMajorMatrixXf dot_products =
-          ComputeSiftDistanceMatrix(DistanceType::DOT_PRODUCT,
-                                    nullptr,
-                                    nullptr,
-                                    image1.descriptors->data,
-                                    image2.descriptors->data,
-                                    nullptr);
+          ComputeSiftDotProductMatrix(image1.descriptors->data,
+                                      image2.descriptors->data);
       FindBestMatchesBruteForce(dot_products,
                                 options_.sift->max_ratio,
                                 options_.sift->max_distance,
@@ -1178,64 +1460,107 @@ class SiftCPUFeatureMatcher : public FeatureMatcher {
                   *image1.camera, *image2.camera, max_error))
             : static_cast<float>(max_error * max_error);
 
-    std::function<bool(float, float, float, float)> guided_filter;
+    const FeatureKeypoints& keypoints1 =
+        use_essential_matrix ? normalized_keypoints1 : *image1.keypoints;
+    const FeatureKeypoints& keypoints2 =
+        use_essential_matrix ? normalized_keypoints2 : *image2.keypoints;
+
+    std::function<void(int, std::vector<int>*)> find_candidates;
+
+    // Precomputed epipolar lines of the keypoints in the other image.
+    std::vector<Eigen::Vector3f> epipolar_lines1;
+    std::vector<Eigen::Vector3f> epipolar_lines2;
+
+    // Keypoints of the second image bucketed into a grid with a cell size of
+    // at least the maximum transfer error, such that all candidates of a
+    // projected point lie in its 3x3 cell neighborhood.
+    std::unordered_map<uint64_t, std::vector<int>> grid2;
+    float grid_cell_size = 0;
+    const auto grid_cell = [&grid_cell_size](const float x) {
+      return static_cast<int64_t>(std::floor(x / grid_cell_size));
+    };
+    const auto grid_key = [](const int64_t cx, const int64_t cy) {
+      return (static_cast<uint64_t>(cx) << 32) ^
+             (static_cast<uint64_t>(cy) & 0xFFFFFFFF);
+    };
+
     if (use_essential_matrix || use_fundamental_matrix) {
-      guided_filter =
-          [&](const float x1, const float y1, const float x2, const float y2) {
-            const Eigen::Vector3f p1(x1, y1, 1.0f);
-            const Eigen::Vector3f p2(x2, y2, 1.0f);
-            const Eigen::Vector3f epipolar_line1 = E_or_F * p1;
-            const Eigen::Vector3f epipolar_line2 = E_or_F.transpose() * p2;
-            const float nom = p2.transpose() * epipolar_line1;
-            const float denom_sq = epipolar_line1(0) * epipolar_line1(0) +
-                                   epipolar_line1(1) * epipolar_line1(1) +
-                                   epipolar_line2(0) * epipolar_line2(0) +
-                                   epipolar_line2(1) * epipolar_line2(1);
-            return nom * nom > max_residual * denom_sq;
-          };
+      epipolar_lines1.resize(keypoints1.size());
+      for (size_t i1 = 0; i1 < keypoints1.size(); ++i1) {
+        epipolar_lines1[i1] =
+            E_or_F * Eigen::Vector3f(keypoints1[i1].x, keypoints1[i1].y, 1.0f);
+      }
+      epipolar_lines2.resize(keypoints2.size());
+      for (size_t i2 = 0; i2 < keypoints2.size(); ++i2) {
+        epipolar_lines2[i2] = E_or_F.transpose() *
+                              Eigen::Vector3f(keypoints2[i2].x,
+                                              keypoints2[i2].y,
+                                              1.0f);
+      }
+      find_candidates = [&](const int i1, std::vector<int>* candidates) {
+        const Eigen::Vector3f& epipolar_line1 = epipolar_lines1[i1];
+        const float line1_sq_norm = epipolar_line1(0) * epipolar_line1(0) +
+                                    epipolar_line1(1) * epipolar_line1(1);
+        for (size_t i2 = 0; i2 < keypoints2.size(); ++i2) {
+          const Eigen::Vector3f& epipolar_line2 = epipolar_lines2[i2];
+          const float nom = keypoints2[i2].x * epipolar_line1(0) +
+                            keypoints2[i2].y * epipolar_line1(1) +
+                            epipolar_line1(2);
+          const float denom_sq = line1_sq_norm +
+                                 epipolar_line2(0) * epipolar_line2(0) +
+                                 epipolar_line2(1) * epipolar_line2(1);
+          if (nom * nom <= max_residual * denom_sq) {
+            candidates->push_back(i2);
+          }
+        }
+      };
     } else if (use_homography) {
-      guided_filter =
-          [&](const float x1, const float y1, const float x2, const float y2) {
-            const Eigen::Vector3f p1(x1, y1, 1.0f);
-            const Eigen::Vector2f p2(x2, y2);
-            return ((H * p1).hnormalized() - p2).squaredNorm() > max_residual;
-          };
+      grid_cell_size = std::max(1.01f * std::sqrt(max_residual), 1e-3f);
+      for (size_t i2 = 0; i2 < keypoints2.size(); ++i2) {
+        grid2[grid_key(grid_cell(keypoints2[i2].x),
+                       grid_cell(keypoints2[i2].y))]
+            .push_back(i2);
+      }
+      find_candidates = [&](const int i1, std::vector<int>* candidates) {
+        const Eigen::Vector2f proj1 =
+            (H * Eigen::Vector3f(keypoints1[i1].x, keypoints1[i1].y, 1.0f))
+                .hnormalized();
+        if (!proj1.allFinite()) {
+          return;
+        }
+        const int64_t cx = grid_cell(proj1.x());
+        const int64_t cy = grid_cell(proj1.y());
+        for (int64_t dx = -1; dx <= 1; ++dx) {
+          for (int64_t dy = -1; dy <= 1; ++dy) {
+            const auto it = grid2.find(grid_key(cx + dx, cy + dy));
+            if (it == grid2.end()) {
+              continue;
+            }
+            for (const int i2 : it->second) {
+              const Eigen::Vector2f p2(keypoints2[i2].x, keypoints2[i2].y);
+              if ((proj1 - p2).squaredNorm() <= max_residual) {
+                candidates->push_back(i2);
+              }
+            }
+          }
+        }
+        // Visit candidates in index order to break ties as in the dense case.
+        std::sort(candidates->begin(), candidates->end());
+      };
     } else {
       return;
     }
 
-    THROW_CHECK(guided_filter);
+    THROW_CHECK_EQ(keypoints1.size(), image1.descriptors->data.rows());
+    THROW_CHECK_EQ(keypoints2.size(), image2.descriptors->data.rows());
 
-    const Eigen::RowMajorMatrixXf l2_dists_1to2 = ComputeSiftDistanceMatrix(
-        DistanceType::L2,
-        use_essential_matrix ? &normalized_keypoints1 : image1.keypoints.get(),
-        use_essential_matrix ? &normalized_keypoints2 : image2.keypoints.get(),
-        image1.descriptors->data,
-        image2.descriptors->data,
-        guided_filter);
-    const Eigen::RowMajorMatrixXf l2_dists_2to1 = l2_dists_1to2.transpose();
-
-    Eigen::RowMajorMatrixXi indices_1to2(l2_dists_1to2.rows(),
-                                         l2_dists_1to2.cols());
-    for (int i = 0; i < indices_1to2.rows(); ++i) {
-      indices_1to2.row(i) = Eigen::VectorXi::LinSpaced(
-          indices_1to2.cols(), 0, indices_1to2.cols() - 1);
-    }
-    Eigen::RowMajorMatrixXi indices_2to1(l2_dists_1to2.cols(),
-                                         l2_dists_1to2.rows());
-    for (int i = 0; i < indices_2to1.rows(); ++i) {
-      indices_2to1.row(i) = Eigen::VectorXi::LinSpaced(
-          indices_2to1.cols(), 0, indices_2to1.cols() - 1);
-    }
-
-    FindBestMatchesIndex(indices_1to2,
-                         l2_dists_1to2,
-                         indices_2to1,
-                         l2_dists_2to1,
-                         options_.sift->max_ratio,
-                         options_.sift->max_distance,
-                         options_.sift->cross_check,
-                         &two_view_geometry->inlier_matches);
+    FindGuidedMatchesSparse(image1.descriptors->data,
+                            image2.descriptors->data,
+                            find_candidates,
+                            options_.sift->max_ratio,
+                            options_.sift->max_distance,
+                            options_.sift->cross_check,
+                            &two_view_geometry->inlier_matches);
   }
 
  private:
@@ -1335,14 +1660,56 @@ class SiftGPUFeatureMatcher : public FeatureMatcher {
     THROW_CHECK_NOTNULL(matches);
     ThrowCheckFeatureTypesMatch(image1, image2);
 
-    matches->clear();
-
     // Protect OpenGL operations with global mutex based on runtime backend
-    std::unique_lock<std::mutex> lock;
+    std::unique_lock<std::mutex> lock = LockBackend();
+    MatchResident(image1, image2, matches);
+  }
+
+  void MatchBatch(
+      const std::vector<std::pair<const Image*, const Image*>>& image_pairs,
+      const std::vector<FeatureMatches*>& matches) override {
+    THROW_CHECK_EQ(image_pairs.size(), matches.size());
+    for (size_t i = 0; i < image_pairs.size(); ++i) {
+      THROW_CHECK_NOTNULL(image_pairs[i].first);
+      THROW_CHECK_NOTNULL(image_pairs[i].second);
+      THROW_CHECK_NOTNULL(matches[i]);
+      ThrowCheckFeatureTypesMatch(*image_pairs[i].first,
+                                  *image_pairs[i].second);
+    }
+
+    // Match the pairs grouped by their images, so that the descriptors of an
+    // image shared by consecutive pairs stay resident on the GPU and are only
+    // uploaded once per batch instead of once per pair.
+    std::vector<size_t> order(image_pairs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t i, size_t j) {
+      return std::make_pair(image_pairs[i].first->image_id,
+                            image_pairs[i].second->image_id) <
+             std::make_pair(image_pairs[j].first->image_id,
+                            image_pairs[j].second->image_id);
+    });
+
+    std::unique_lock<std::mutex> lock = LockBackend();
+    for (const size_t i : order) {
+      MatchResident(*image_pairs[i].first, *image_pairs[i].second, matches[i]);
+    }
+  }
+
+ private:
+  std::unique_lock<std::mutex> LockBackend() {
     if (backend_ == SiftBackend::GLSL) {
-      lock = std::unique_lock<std::mutex>(
+      return std::unique_lock<std::mutex>(
           *sift_opengl_mutexes_.at(sift_match_gpu_.gpu_index));
     }
+    return std::unique_lock<std::mutex>();
+  }
+
+  // Matches the image pair with the backend locked, uploading the descriptors
+  // of an image only if it differs from the previous image in its slot.
+  void MatchResident(const Image& image1,
+                     const Image& image2,
+                     FeatureMatches* matches) {
+    matches->clear();
 
     if (prev_image_id1_ == kInvalidImageId || prev_is_guided_ ||
         prev_image_id1_ != image1.image_id) {
@@ -89,6 +89,21 @@ struct SiftExtractionOptions {
   // Sift implementation is faster.
   bool force_covariant_extractor = false;
 
+  // Tiled extraction for very large images on the CPU. If the width or height
+  // of an image exceeds tile_size, the image is split into overlapping tiles
+  // of at most tile_size pixels, which bounds the memory of the scale space
+  // independent of the image size. Features in the overlaps are deduplicated
+  // by keeping them only in the tile closest to them and max_num_features is
+  // applied across all tiles. The overlap should be large enough to contain
+  // the support region of the largest features of interest. Note that
+  // max_image_size must be increased as well to extract at full resolution.
+  // A tile_size of 0 disables tiling.
+  int tile_size = 0;
+  int tile_overlap = 256;
+
+  // Number of threads for extracting tiles of the same image in parallel.
+  int tile_num_threads = -1;
+
   // L1_ROOT: L1-normalizes each descriptor followed by element-wise square
   // rooting. This normalization is usually better than standard
   // L2-normalization. See "Three things everyone should know to improve object
@@ -126,6 +141,11 @@ struct SiftMatchingOptions {
   ThreadSafeLRUCache<image_t, FeatureDescriptorIndex>*
       cpu_descriptor_index_cache = nullptr;
 
+  // Optional directory in which the descriptor indices of the faiss based
+  // CPU matching are persisted. Indices are then trained once and reused by
+  // all following matching runs on the same database.
+  std::filesystem::path cpu_descriptor_index_path;
+
   // LightGlue matching options.
   LightGlueONNXMatchingOptions lightglue = []() {
     LightGlueONNXMatchingOptions options;
@@ -41,6 +41,8 @@
 #include "colmap/math/random.h"
 #include "colmap/util/opengl_utils.h"
 
+#include "thirdparty/VLFeat/generic.h"
+
 #include <functional>
 
 namespace colmap {
@@ -168,6 +170,53 @@ TEST_P(SiftCpuExtractionTest, Nominal) {
   ValidateDescriptorNorms(descriptors);
 }
 
+TEST_P(SiftCpuExtractionTest, SimdMatchesScalar) {
+  const auto& p = GetParam();
+  SetPRNGSeed(0);
+  Bitmap bitmap = CreateImageWithSquare(256);
+  for (int r = 0; r < bitmap.Height(); ++r) {
+    for (int c = 0; c < bitmap.Width(); ++c) {
+      BitmapColor<uint8_t> color = *bitmap.GetPixel(c, r);
+      color.r = std::min(255, color.r + RandomUniformInteger(0, 31));
+      bitmap.SetPixel(c, r, color);
+    }
+  }
+
+  FeatureExtractionOptions options(FeatureExtractorType::SIFT);
+  options.use_gpu = false;
+  options.sift->estimate_affine_shape = p.estimate_affine_shape;
+  options.sift->domain_size_pooling = p.domain_size_pooling;
+  options.sift->force_covariant_extractor = p.force_covariant_extractor;
+  options.sift->upright = p.upright;
+
+  const auto extract = [&](bool simd_enabled,
+                           FeatureKeypoints* keypoints,
+                           FeatureDescriptors* descriptors) {
+    vl_set_simd_enabled(simd_enabled);
+    auto extractor = CreateSiftFeatureExtractor(options);
+    EXPECT_TRUE(extractor->Extract(bitmap, keypoints, descriptors));
+  };
+
+  FeatureKeypoints scalar_keypoints;
+  FeatureDescriptors scalar_descriptors;
+  extract(false, &scalar_keypoints, &scalar_descriptors);
+  FeatureKeypoints simd_keypoints;
+  FeatureDescriptors simd_descriptors;
+  extract(true, &simd_keypoints, &simd_descriptors);
+
+  EXPECT_GT(scalar_keypoints.size(), 0);
+  ASSERT_EQ(simd_keypoints.size(), scalar_keypoints.size());
+  for (size_t i = 0; i < scalar_keypoints.size(); ++i) {
+    EXPECT_EQ(simd_keypoints[i].x, scalar_keypoints[i].x);
+    EXPECT_EQ(simd_keypoints[i].y, scalar_keypoints[i].y);
+    EXPECT_EQ(simd_keypoints[i].a11, scalar_keypoints[i].a11);
+    EXPECT_EQ(simd_keypoints[i].a12, scalar_keypoints[i].a12);
+    EXPECT_EQ(simd_keypoints[i].a21, scalar_keypoints[i].a21);
+    EXPECT_EQ(simd_keypoints[i].a22, scalar_keypoints[i].a22);
+  }
+  EXPECT_EQ(simd_descriptors.data, scalar_descriptors.data);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     SiftCpuExtraction,
     SiftCpuExtractionTest,
@@ -184,6 +233,112 @@ INSTANTIATE_TEST_SUITE_P(
             "CovariantAffineDSPSift", true, true, false, false, 22}),
     [](const auto& info) { return info.param.name; });
 
+Bitmap CreateImageWithSquares(const int width, const int height) {
+  SetPRNGSeed(0);
+  Bitmap bitmap(width, height, false);
+  bitmap.Fill(BitmapColor<uint8_t>(0, 0, 0));
+  for (int i = 0; i < 40; ++i) {
+    const int size = RandomUniformInteger(8, 48);
+    const int x = RandomUniformInteger(0, width - size);
+    const int y = RandomUniformInteger(0, height - size);
+    const uint8_t value = RandomUniformInteger(64, 255);
+    for (int r = y; r < y + size; ++r) {
+      for (int c = x; c < x + size; ++c) {
+        bitmap.SetPixel(c, r, BitmapColor<uint8_t>(value));
+      }
+    }
+  }
+  return bitmap;
+}
+
+TEST(SiftCpuTiledExtraction, Nominal) {
+  const Bitmap bitmap = CreateImageWithSquares(640, 400);
+
+  FeatureExtractionOptions options(FeatureExtractorType::SIFT);
+  options.use_gpu = false;
+  FeatureKeypoints keypoints;
+  FeatureDescriptors descriptors;
+  EXPECT_TRUE(CreateSiftFeatureExtractor(options)->Extract(
+      bitmap, &keypoints, &descriptors));
+
+  options.sift->tile_size = 256;
+  options.sift->tile_overlap = 96;
+  options.sift->tile_num_threads = 3;
+  FeatureKeypoints tiled_keypoints;
+  FeatureDescriptors tiled_descriptors;
+  EXPECT_TRUE(CreateSiftFeatureExtractor(options)->Extract(
+      bitmap, &tiled_keypoints, &tiled_descriptors));
+
+  ValidateKeypoints(tiled_keypoints, bitmap);
+  EXPECT_EQ(tiled_descriptors.data.rows(), tiled_keypoints.size());
+  EXPECT_EQ(tiled_descriptors.type, FeatureExtractorType::SIFT);
+
+  // Features detected in multiple tiles must not be duplicated and most of
+  // the features must be re-detected at the same location.
+  const auto has_neighbor = [](const FeatureKeypoint& keypoint,
+                               const FeatureKeypoints& others,
+                               const bool skip_self) {
+    for (const FeatureKeypoint& other : others) {
+      if (skip_self && &other == &keypoint) {
+        continue;
+      }
+      if (std::abs(other.x - keypoint.x) < 0.5 &&
+          std::abs(other.y - keypoint.y) < 0.5 &&
+          std::abs(other.ComputeScale() - keypoint.ComputeScale()) < 0.1 &&
+          std::abs(other.ComputeOrientation() -
+                   keypoint.ComputeOrientation()) < 0.1) {
+        return true;
+      }
+    }
+    return false;
+  };
+  size_t num_redetected = 0;
+  for (const FeatureKeypoint& keypoint : tiled_keypoints) {
+    EXPECT_FALSE(has_neighbor(keypoint, tiled_keypoints, true));
+    if (has_neighbor(keypoint, keypoints, false)) {
+      ++num_redetected;
+    }
+  }
+  EXPECT_GT(keypoints.size(), 100);
+  EXPECT_GT(num_redetected, 0.8 * keypoints.size());
+}
+
+TEST(SiftCpuTiledExtraction, MaxNumFeatures) {
+  const Bitmap bitmap = CreateImageWithSquares(640, 400);
+
+  FeatureExtractionOptions options(FeatureExtractorType::SIFT);
+  options.use_gpu = false;
+  options.sift->max_num_features = 50;
+  options.sift->tile_size = 256;
+  options.sift->tile_overlap = 96;
+  FeatureKeypoints keypoints;
+  FeatureDescriptors descriptors;
+  EXPECT_TRUE(CreateSiftFeatureExtractor(options)->Extract(
+      bitmap, &keypoints, &descriptors));
+  EXPECT_EQ(keypoints.size(), 50);
+  EXPECT_EQ(descriptors.data.rows(), 50);
+}
+
+TEST(SiftCpuTiledExtraction, SmallImage) {
+  const Bitmap bitmap = CreateImageWithSquare(256);
+
+  FeatureExtractionOptions options(FeatureExtractorType::SIFT);
+  options.use_gpu = false;
+  FeatureKeypoints keypoints;
+  FeatureDescriptors descriptors;
+  EXPECT_TRUE(CreateSiftFeatureExtractor(options)->Extract(
+      bitmap, &keypoints, &descriptors));
+
+  options.sift->tile_size = 256;
+  options.sift->tile_overlap = 64;
+  FeatureKeypoints tiled_keypoints;
+  FeatureDescriptors tiled_descriptors;
+  EXPECT_TRUE(CreateSiftFeatureExtractor(options)->Extract(
+      bitmap, &tiled_keypoints, &tiled_descriptors));
+  EXPECT_EQ(tiled_keypoints, keypoints);
+  EXPECT_EQ(tiled_descriptors.data, descriptors.data);
+}
+
 TEST(ExtractSiftFeaturesGPU, Nominal) {
   RunGpuTest([] {
     const Bitmap bitmap = CreateImageWithSquare(256);
@@ -774,6 +929,55 @@ TEST(MatchSiftFeaturesGPU, Nominal) {
   });
 }
 
+TEST(MatchSiftFeaturesGPU, Batch) {
+  RunGpuTest([] {
+    FeatureMatchingOptions options(FeatureMatcherType::SIFT_BRUTEFORCE);
+    options.use_gpu = true;
+    options.max_num_matches = 1000;
+    auto matcher = THROW_CHECK_NOTNULL(CreateSiftFeatureMatcher(options));
+
+    const Camera camera = Camera::CreateFromModelId(
+        1, CameraModelId::kSimplePinhole, 100.0, 100, 200);
+    const FeatureMatcher::Image image0 = {
+        /*image_id=*/0,
+        /*camera=*/&camera,
+        /*keypoints=*/nullptr,
+        std::make_shared<FeatureDescriptors>(CreateEmptyDescriptors())};
+    const FeatureMatcher::Image image1 = {
+        /*image_id=*/1,
+        /*camera=*/&camera,
+        /*keypoints=*/nullptr,
+        std::make_shared<FeatureDescriptors>(
+            CreateRandomFeatureDescriptors(2))};
+    const FeatureMatcher::Image image2 = {
+        /*image_id=*/2,
+        /*camera=*/&camera,
+        /*keypoints=*/nullptr,
+        std::make_shared<FeatureDescriptors>(
+            CreateReversedDescriptors(*image1.descriptors))};
+
+    FeatureMatches matches12;
+    FeatureMatches matches02;
+    FeatureMatches matches12_repeated;
+    matcher->MatchBatch(
+        {{&image1, &image2}, {&image0, &image2}, {&image1, &image2}},
+        {&matches12, &matches02, &matches12_repeated});
+    ExpectReversedMatches(matches12);
+    EXPECT_EQ(matches02.size(), 0);
+    ExpectReversedMatches(matches12_repeated);
+
+    // Single pair matching must not be affected by the resident descriptors
+    // of the previous batch.
+    FeatureMatches matches;
+    matcher->Match(image1, image0, &matches);
+    EXPECT_EQ(matches.size(), 0);
+    matcher->Match(image1, image2, &matches);
+    ExpectReversedMatches(matches);
+
+    EXPECT_ANY_THROW(matcher->MatchBatch({{&image1, &image2}}, {}));
+  });
+}
+
 TEST(MatchSiftFeaturesCPUvsGPU, Nominal) {
   RunGpuTest([] {
     auto TestCPUvsGPU = [](const FeatureMatchingOptions& options,
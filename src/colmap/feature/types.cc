@@ -154,31 +154,90 @@ float FeatureKeypoint::ComputeShear() const {
   return std::atan2(-a12, a22) - ComputeOrientation();
 }
 
+namespace {
+
+using FeatureDescriptorsHalfData = Eigen::
+    Matrix<Eigen::half, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+using FeatureDescriptorsInt8Data =
+    Eigen::Matrix<int8_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+// Scale of the linear INT8 quantization of values in [-1, 1].
+constexpr float kInt8DescriptorScale = 127.0f;
+
+// Offset between precisions in the integer representation of the type.
+constexpr int kDescriptorPrecisionTypeStride = 1 << 16;
+
+bool IsFloatFeatureType(const FeatureExtractorType type) {
+  switch (type) {
+    case FeatureExtractorType::SIFT:
+      return false;
+    case FeatureExtractorType::ALIKED_N16ROT:
+    case FeatureExtractorType::ALIKED_N32:
+      return true;
+    default:
+      LOG(FATAL_THROW) << "Unsupported feature type: "
+                       << FeatureExtractorTypeToString(type);
+  }
+  return false;
+}
+
+template <typename Scalar, typename Derived>
+void CopyToBytes(const Eigen::MatrixBase<Derived>& matrix,
+                 FeatureDescriptorsData* data) {
+  data->resize(matrix.rows(), matrix.cols() * sizeof(Scalar));
+  std::memcpy(data->data(), matrix.derived().data(), data->size());
+}
+
+template <typename Matrix>
+Matrix CopyFromBytes(const FeatureDescriptorsData& data) {
+  using Scalar = typename Matrix::Scalar;
+  THROW_CHECK_EQ(data.cols() % sizeof(Scalar), 0);
+  Matrix matrix(data.rows(), data.cols() / sizeof(Scalar));
+  std::memcpy(matrix.data(), data.data(), data.size());
+  return matrix;
+}
+
+}  // namespace
+
 FeatureDescriptors FeatureDescriptors::FromFloat(
     const FeatureDescriptorsFloat& float_desc) {
   FeatureDescriptors result;
   result.type = float_desc.type;
-  const Eigen::Index rows = float_desc.data.rows();
-  const Eigen::Index float_cols = float_desc.data.cols();
+  result.precision = float_desc.precision;
 
-  switch (float_desc.type) {
-    case FeatureExtractorType::SIFT:
-      // cast each float value to uint8
-      result.data = float_desc.data.cast<uint8_t>();
-      break;
-    case FeatureExtractorType::ALIKED_N16ROT:
-    case FeatureExtractorType::ALIKED_N32: {
+  if (!IsFloatFeatureType(float_desc.type)) {
+    THROW_CHECK_EQ(float_desc.precision, FeatureDescriptorPrecision::NATIVE)
+        << "Only float descriptors support compact precisions";
+    // cast each float value to uint8
+    result.data = float_desc.data.cast<uint8_t>();
+    return result;
+  }
+
+  switch (float_desc.precision) {
+    case FeatureDescriptorPrecision::NATIVE:
       // reinterpret float32 data as uint8 bytes
-      const Eigen::Index uint8_cols = float_cols * sizeof(float);
-      result.data.resize(rows, uint8_cols);
-      std::memcpy(result.data.data(),
-                  float_desc.data.data(),
-                  rows * float_cols * sizeof(float));
+      CopyToBytes<float>(float_desc.data, &result.data);
+      break;
+    case FeatureDescriptorPrecision::FLOAT16:
+      CopyToBytes<Eigen::half>(
+          FeatureDescriptorsHalfData(float_desc.data.cast<Eigen::half>()),
+          &result.data);
+      break;
+    case FeatureDescriptorPrecision::INT8:
+      CopyToBytes<int8_t>(
+          FeatureDescriptorsInt8Data(
+              (float_desc.data * kInt8DescriptorScale)
+                  .array()
+                  .round()
+                  .min(kInt8DescriptorScale)
+                  .max(-kInt8DescriptorScale)
+                  .cast<int8_t>()),
+          &result.data);
       break;
-    }
     default:
-      LOG(FATAL_THROW) << "Unsupported feature type: "
-                       << FeatureExtractorTypeToString(float_desc.type);
+      LOG(FATAL_THROW) << "Unsupported descriptor precision: "
+                       << FeatureDescriptorPrecisionToString(
+                              float_desc.precision);
   }
   return result;
 }
@@ -187,30 +246,44 @@ FeatureDescriptorsFloat FeatureDescriptors::ToFloat() const {
   return FeatureDescriptorsFloat::FromBytes(*this);
 }
 
+Eigen::Index FeatureDescriptors::NumDims() const {
+  const size_t element_size = FeatureDescriptorsElementSize(type, precision);
+  THROW_CHECK_EQ(data.cols() % element_size, 0);
+  return data.cols() / element_size;
+}
+
 FeatureDescriptorsFloat FeatureDescriptorsFloat::FromBytes(
     const FeatureDescriptors& byte_desc) {
   FeatureDescriptorsFloat result;
   result.type = byte_desc.type;
-  const Eigen::Index rows = byte_desc.data.rows();
-  const Eigen::Index uint8_cols = byte_desc.data.cols();
+  result.precision = byte_desc.precision;
 
-  switch (byte_desc.type) {
-    case FeatureExtractorType::SIFT:
-      // cast each uint8 value to float
-      result.data = byte_desc.data.cast<float>();
-      break;
-    case FeatureExtractorType::ALIKED_N16ROT:
-    case FeatureExtractorType::ALIKED_N32: {
+  if (!IsFloatFeatureType(byte_desc.type)) {
+    THROW_CHECK_EQ(byte_desc.precision, FeatureDescriptorPrecision::NATIVE)
+        << "Only float descriptors support compact precisions";
+    // cast each uint8 value to float
+    result.data = byte_desc.data.cast<float>();
+    return result;
+  }
+
+  switch (byte_desc.precision) {
+    case FeatureDescriptorPrecision::NATIVE:
       // reinterpret uint8 bytes as float32 data
-      THROW_CHECK_EQ(uint8_cols % sizeof(float), 0);
-      const Eigen::Index float_cols = uint8_cols / sizeof(float);
-      result.data.resize(rows, float_cols);
-      std::memcpy(result.data.data(), byte_desc.data.data(), rows * uint8_cols);
+      result.data = CopyFromBytes<FeatureDescriptorsFloatData>(byte_desc.data);
+      break;
+    case FeatureDescriptorPrecision::FLOAT16:
+      result.data = CopyFromBytes<FeatureDescriptorsHalfData>(byte_desc.data)
+                        .cast<float>();
+      break;
+    case FeatureDescriptorPrecision::INT8:
+      result.data = CopyFromBytes<FeatureDescriptorsInt8Data>(byte_desc.data)
+                        .cast<float>() /
+                    kInt8DescriptorScale;
       break;
-    }
     default:
-      LOG(FATAL_THROW) << "Unsupported feature type: "
-                       << FeatureExtractorTypeToString(byte_desc.type);
+      LOG(FATAL_THROW) << "Unsupported descriptor precision: "
+                       << FeatureDescriptorPrecisionToString(
+                              byte_desc.precision);
   }
   return result;
 }
@@ -219,6 +292,42 @@ FeatureDescriptors FeatureDescriptorsFloat::ToBytes() const {
   return FeatureDescriptors::FromFloat(*this);
 }
 
+size_t FeatureDescriptorsElementSize(
+    const FeatureExtractorType type,
+    const FeatureDescriptorPrecision precision) {
+  if (type == FeatureExtractorType::UNDEFINED || !IsFloatFeatureType(type)) {
+    return sizeof(uint8_t);
+  }
+  switch (precision) {
+    case FeatureDescriptorPrecision::NATIVE:
+      return sizeof(float);
+    case FeatureDescriptorPrecision::FLOAT16:
+      return sizeof(Eigen::half);
+    case FeatureDescriptorPrecision::INT8:
+      return sizeof(int8_t);
+    default:
+      LOG(FATAL_THROW) << "Unsupported descriptor precision: "
+                       << FeatureDescriptorPrecisionToString(precision);
+  }
+  return 0;
+}
+
+int FeatureDescriptorsTypeToInt(const FeatureExtractorType type,
+                                const FeatureDescriptorPrecision precision) {
+  return static_cast<int>(type) +
+         static_cast<int>(precision) * kDescriptorPrecisionTypeStride;
+}
+
+void FeatureDescriptorsTypeFromInt(const int value,
+                                   FeatureExtractorType* type,
+                                   FeatureDescriptorPrecision* precision) {
+  // The offset maps UNDEFINED (-1) to the start of each precision range.
+  const int precision_value = (value + 1) / kDescriptorPrecisionTypeStride;
+  *precision = static_cast<FeatureDescriptorPrecision>(precision_value);
+  *type = static_cast<FeatureExtractorType>(
+      value - precision_value * kDescriptorPrecisionTypeStride);
+}
+
 FeatureKeypointsMatrix KeypointsToMatrix(
     const FeatureKeypoints& feature_keypoints) {
   const size_t num_features = feature_keypoints.size();
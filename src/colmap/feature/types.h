@@ -48,6 +48,13 @@ MAKE_ENUM_CLASS_OVERLOAD_STREAM(FeatureMatcherType,
                                 SIFT_LIGHTGLUE,
                                 ALIKED_BRUTEFORCE,
                                 ALIKED_LIGHTGLUE);
+// Storage precision of feature descriptors. NATIVE stores the descriptors in
+// the precision of the extractor, i.e., uint8 for SIFT and float32 for ALIKED.
+// The compact FLOAT16 and INT8 precisions are only supported for float-valued
+// descriptors, where INT8 linearly quantizes values in [-1, 1] (e.g., of unit
+// normalized descriptors) to [-127, 127].
+MAKE_ENUM_CLASS_OVERLOAD_STREAM(
+    FeatureDescriptorPrecision, 0, NATIVE, FLOAT16, INT8);
 
 struct FeatureKeypoint {
   FeatureKeypoint();
@@ -112,39 +119,66 @@ using FeatureDescriptorsFloatData =
 // Forward declaration for conversion methods.
 struct FeatureDescriptorsFloat;
 
-// Feature descriptors with associated extractor type metadata.
+// Feature descriptors with associated extractor type and precision metadata.
 struct FeatureDescriptors {
   FeatureDescriptors() = default;
-  FeatureDescriptors(FeatureExtractorType type, FeatureDescriptorsData data)
-      : type(type), data(std::move(data)) {}
-
-  // Create from float descriptors by reinterpreting as uint8 bytes.
+  FeatureDescriptors(
+      FeatureExtractorType type,
+      FeatureDescriptorsData data,
+      FeatureDescriptorPrecision precision = FeatureDescriptorPrecision::NATIVE)
+      : type(type), precision(precision), data(std::move(data)) {}
+
+  // Create from float descriptors by encoding them as uint8 bytes in the
+  // precision of the float descriptors.
   static FeatureDescriptors FromFloat(
       const FeatureDescriptorsFloat& float_desc);
 
-  // Convert to float descriptors by reinterpreting uint8 data as float32.
+  // Convert to float descriptors by decoding the uint8 data.
   FeatureDescriptorsFloat ToFloat() const;
 
+  // The number of descriptor dimensions, which differs from the number of
+  // byte columns for float-valued descriptors.
+  Eigen::Index NumDims() const;
+
   FeatureExtractorType type = FeatureExtractorType::UNDEFINED;
+  FeatureDescriptorPrecision precision = FeatureDescriptorPrecision::NATIVE;
   FeatureDescriptorsData data;
 };
 
 struct FeatureDescriptorsFloat {
   FeatureDescriptorsFloat() = default;
-  FeatureDescriptorsFloat(FeatureExtractorType type,
-                          FeatureDescriptorsFloatData data)
-      : type(type), data(std::move(data)) {}
+  FeatureDescriptorsFloat(
+      FeatureExtractorType type,
+      FeatureDescriptorsFloatData data,
+      FeatureDescriptorPrecision precision = FeatureDescriptorPrecision::NATIVE)
+      : type(type), precision(precision), data(std::move(data)) {}
 
-  // Create from byte descriptors by reinterpreting uint8 data as float32.
+  // Create from byte descriptors by decoding the uint8 data.
   static FeatureDescriptorsFloat FromBytes(const FeatureDescriptors& byte_desc);
 
-  // Convert to byte descriptors by reinterpreting float32 data as uint8.
+  // Convert to byte descriptors by encoding the float data in the precision.
   FeatureDescriptors ToBytes() const;
 
   FeatureExtractorType type = FeatureExtractorType::UNDEFINED;
+  // The storage precision of the byte descriptors that the float descriptors
+  // were decoded from or are encoded to.
+  FeatureDescriptorPrecision precision = FeatureDescriptorPrecision::NATIVE;
   FeatureDescriptorsFloatData data;
 };
 
+// Number of bytes per stored descriptor dimension.
+size_t FeatureDescriptorsElementSize(FeatureExtractorType type,
+                                     FeatureDescriptorPrecision precision);
+
+// The extractor type and precision of descriptors are stored as one integer,
+// which equals the extractor type for NATIVE precision for compatibility with
+// databases without precision.
+int FeatureDescriptorsTypeToInt(FeatureExtractorType type,
+                                FeatureDescriptorPrecision precision);
+void FeatureDescriptorsTypeFromInt(int value,
+                                   FeatureExtractorType* type,
+                                   FeatureDescriptorPrecision* precision);
+
 struct FeatureMatch {
   FeatureMatch()
       : point2D_idx1(kInvalidPoint2DIdx), point2D_idx2(kInvalidPoint2DIdx) {}
@@ -31,6 +31,9 @@
 
 #include "colmap/math/math.h"
 
+#include <tuple>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 namespace colmap {
@@ -299,6 +302,80 @@ TEST(FeatureDescriptors, AlikedConversion) {
   EXPECT_EQ(recovered.data, original.data);
 }
 
+TEST(FeatureDescriptors, AlikedCompactConversion) {
+  const FeatureDescriptorsFloat original(
+      FeatureExtractorType::ALIKED_N32,
+      FeatureDescriptorsFloatData::Random(10, 128).rowwise().normalized());
+  for (const auto& [precision, element_size, max_error] :
+       std::vector<std::tuple<FeatureDescriptorPrecision, size_t, float>>{
+           {FeatureDescriptorPrecision::FLOAT16, 2, 1e-3f},
+           {FeatureDescriptorPrecision::INT8, 1, 0.5f / 127}}) {
+    FeatureDescriptorsFloat original_compact = original;
+    original_compact.precision = precision;
+    const FeatureDescriptors encoded = original_compact.ToBytes();
+    EXPECT_EQ(encoded.type, FeatureExtractorType::ALIKED_N32);
+    EXPECT_EQ(encoded.precision, precision);
+    EXPECT_EQ(encoded.data.rows(), 10);
+    EXPECT_EQ(encoded.data.cols(), 128 * element_size);
+    EXPECT_EQ(encoded.NumDims(), 128);
+
+    const FeatureDescriptorsFloat decoded = encoded.ToFloat();
+    EXPECT_EQ(decoded.type, FeatureExtractorType::ALIKED_N32);
+    EXPECT_EQ(decoded.precision, precision);
+    ASSERT_EQ(decoded.data.rows(), 10);
+    ASSERT_EQ(decoded.data.cols(), 128);
+    EXPECT_LE((decoded.data - original.data).cwiseAbs().maxCoeff(),
+              max_error);
+    // Encoding the decoded descriptors is lossless.
+    EXPECT_EQ(decoded.ToBytes().data, encoded.data);
+  }
+
+  // Values outside of [-1, 1] are clamped.
+  FeatureDescriptorsFloat out_of_range(FeatureExtractorType::ALIKED_N32,
+                                       FeatureDescriptorsFloatData(1, 2),
+                                       FeatureDescriptorPrecision::INT8);
+  out_of_range.data << -2, 2;
+  FeatureDescriptorsFloatData clamped(1, 2);
+  clamped << -1, 1;
+  EXPECT_EQ(out_of_range.ToBytes().ToFloat().data, clamped);
+}
+
+TEST(FeatureDescriptors, SiftCompactConversion) {
+  FeatureDescriptors descriptors(FeatureExtractorType::SIFT,
+                                 FeatureDescriptorsData::Random(2, 128),
+                                 FeatureDescriptorPrecision::INT8);
+  EXPECT_ANY_THROW(descriptors.ToFloat());
+  descriptors.precision = FeatureDescriptorPrecision::NATIVE;
+  EXPECT_EQ(descriptors.NumDims(), 128);
+  FeatureDescriptorsFloat descriptors_float = descriptors.ToFloat();
+  descriptors_float.precision = FeatureDescriptorPrecision::FLOAT16;
+  EXPECT_ANY_THROW(descriptors_float.ToBytes());
+}
+
+TEST(FeatureDescriptors, TypeToInt) {
+  for (const FeatureExtractorType type : {FeatureExtractorType::UNDEFINED,
+                                          FeatureExtractorType::SIFT,
+                                          FeatureExtractorType::ALIKED_N16ROT,
+                                          FeatureExtractorType::ALIKED_N32}) {
+    EXPECT_EQ(
+        FeatureDescriptorsTypeToInt(type, FeatureDescriptorPrecision::NATIVE),
+        static_cast<int>(type));
+    for (const FeatureDescriptorPrecision precision :
+         {FeatureDescriptorPrecision::NATIVE,
+          FeatureDescriptorPrecision::FLOAT16,
+          FeatureDescriptorPrecision::INT8}) {
+      FeatureExtractorType decoded_type;
+      FeatureDescriptorPrecision decoded_precision;
+      FeatureDescriptorsTypeFromInt(
+          FeatureDescriptorsTypeToInt(type, precision),
+          &decoded_type,
+          &decoded_precision);
+      EXPECT_EQ(decoded_type, type);
+      EXPECT_EQ(decoded_precision, precision);
+    }
+  }
+}
+
 TEST(FeatureMatches, Nominal) {
   FeatureMatch match;
   EXPECT_EQ(match.point2D_idx1, kInvalidPoint2DIdx);
@@ -31,6 +31,8 @@
 
 #include "colmap/math/math.h"
 
+#include <numeric>
+
 namespace colmap {
 
 std::vector<Eigen::Vector2d> FeatureKeypointsToPointsVector(
@@ -70,11 +72,16 @@ FeatureDescriptorsData FeatureDescriptorsToUnsignedByte(
 
 void ExtractTopScaleFeatures(FeatureKeypoints* keypoints,
                              FeatureDescriptors* descriptors,
-                             const size_t num_features) {
+                             const size_t num_features,
+                             std::vector<point2D_t>* indices) {
   THROW_CHECK_EQ(keypoints->size(), descriptors->data.rows());
   THROW_CHECK_GT(num_features, 0);
 
   if (static_cast<size_t>(descriptors->data.rows()) <= num_features) {
+    if (indices != nullptr) {
+      indices->resize(keypoints->size());
+      std::iota(indices->begin(), indices->end(), 0);
+    }
     return;
   }
 
@@ -96,11 +103,19 @@ void ExtractTopScaleFeatures(FeatureKeypoints* keypoints,
   FeatureDescriptors top_scale_descriptors;
   top_scale_descriptors.data.resize(num_features, descriptors->data.cols());
   top_scale_descriptors.type = descriptors->type;
+  top_scale_descriptors.precision = descriptors->precision;
   for (size_t i = 0; i < num_features; ++i) {
     top_scale_keypoints[i] = (*keypoints)[scales[i].first];
     top_scale_descriptors.data.row(i) = descriptors->data.row(scales[i].first);
   }
 
+  if (indices != nullptr) {
+    indices->resize(num_features);
+    for (size_t i = 0; i < num_features; ++i) {
+      (*indices)[i] = static_cast<point2D_t>(scales[i].first);
+    }
+  }
+
   *keypoints = std::move(top_scale_keypoints);
   *descriptors = std::move(top_scale_descriptors);
 }
@@ -53,9 +53,12 @@ void L1RootNormalizeFeatureDescriptors(
 FeatureDescriptorsData FeatureDescriptorsToUnsignedByte(
     const Eigen::Ref<const FeatureDescriptorsFloatData>& descriptors);
 
-// Extract the descriptors corresponding to the largest-scale features.
+// Extract the descriptors corresponding to the largest-scale features. If
+// given, the original indices of the extracted features are returned in
+// `indices`, e.g., to map matches of the extracted features back.
 void ExtractTopScaleFeatures(FeatureKeypoints* keypoints,
                              FeatureDescriptors* descriptors,
-                             size_t num_features);
+                             size_t num_features,
+                             std::vector<point2D_t>* indices = nullptr);
 
 }  // namespace colmap
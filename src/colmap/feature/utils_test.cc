@@ -29,6 +29,7 @@
 
 #include "colmap/feature/utils.h"
 
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 namespace colmap {
@@ -111,5 +112,27 @@ TEST(ExtractTopScaleFeatures, Nominal) {
   EXPECT_EQ(top_descriptors6.data, descriptors.data);
 }
 
+TEST(ExtractTopScaleFeatures, Indices) {
+  FeatureKeypoints keypoints(5);
+  keypoints[0].Rescale(3);
+  keypoints[1].Rescale(4);
+  keypoints[2].Rescale(1);
+  keypoints[3].Rescale(5);
+  keypoints[4].Rescale(2);
+  FeatureDescriptors descriptors;
+  descriptors.data = FeatureDescriptorsData::Random(5, 128);
+
+  std::vector<point2D_t> indices;
+  auto top_keypoints2 = keypoints;
+  auto top_descriptors2 = descriptors;
+  ExtractTopScaleFeatures(&top_keypoints2, &top_descriptors2, 2, &indices);
+  EXPECT_THAT(indices, testing::ElementsAre(3, 1));
+
+  auto top_keypoints6 = keypoints;
+  auto top_descriptors6 = descriptors;
+  ExtractTopScaleFeatures(&top_keypoints6, &top_descriptors6, 6, &indices);
+  EXPECT_THAT(indices, testing::ElementsAre(0, 1, 2, 3, 4));
+}
+
 }  // namespace
 }  // namespace colmap
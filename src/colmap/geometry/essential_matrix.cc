@@ -188,9 +188,47 @@ void ComputeSquaredSampsonError(const std::vector<Eigen::Vector2d>& points1,
   const size_t num_points1 = points1.size();
   THROW_CHECK_EQ(num_points1, points2.size());
   residuals->resize(num_points1);
+
+  // Note that this code might not be as nice as Eigen expressions, but the
+  // loop body is branch-free and free of aliasing, such that the compiler can
+  // vectorize it. This is the hot path when scoring RANSAC hypotheses.
+
+  const double E_00 = E(0, 0);
+  const double E_01 = E(0, 1);
+  const double E_02 = E(0, 2);
+  const double E_10 = E(1, 0);
+  const double E_11 = E(1, 1);
+  const double E_12 = E(1, 2);
+  const double E_20 = E(2, 0);
+  const double E_21 = E(2, 1);
+  const double E_22 = E(2, 2);
+
+  const double* points1_data = points1.empty() ? nullptr : points1[0].data();
+  const double* points2_data = points2.empty() ? nullptr : points2[0].data();
+  double* residuals_data = residuals->data();
+
   for (size_t i = 0; i < num_points1; ++i) {
-    (*residuals)[i] = ComputeSquaredSampsonError(
-        points1[i].homogeneous(), points2[i].homogeneous(), E);
+    const double x1_0 = points1_data[2 * i + 0];
+    const double x1_1 = points1_data[2 * i + 1];
+    const double x2_0 = points2_data[2 * i + 0];
+    const double x2_1 = points2_data[2 * i + 1];
+
+    // Epipolar line in the second image: E * x1.
+    const double Ex1_0 = E_00 * x1_0 + E_01 * x1_1 + E_02;
+    const double Ex1_1 = E_10 * x1_0 + E_11 * x1_1 + E_12;
+    const double Ex1_2 = E_20 * x1_0 + E_21 * x1_1 + E_22;
+
+    // Epipolar line in the first image: E^T * x2.
+    const double Etx2_0 = E_00 * x2_0 + E_10 * x2_1 + E_20;
+    const double Etx2_1 = E_01 * x2_0 + E_11 * x2_1 + E_21;
+
+    const double num = x2_0 * Ex1_0 + x2_1 * Ex1_1 + Ex1_2;
+    const double denom_sq_norm =
+        Etx2_0 * Etx2_0 + Etx2_1 * Etx2_1 + Ex1_0 * Ex1_0 + Ex1_1 * Ex1_1;
+
+    residuals_data[i] = denom_sq_norm == 0
+                            ? std::numeric_limits<double>::max()
+                            : num * num / denom_sq_norm;
   }
 }
 
@@ -201,8 +239,45 @@ void ComputeSquaredSampsonError(const std::vector<Eigen::Vector3d>& ray1,
   const size_t num_ray1 = ray1.size();
   THROW_CHECK_EQ(num_ray1, ray2.size());
   residuals->resize(num_ray1);
+
+  // See the 2D overload for why this is written out in scalar form.
+
+  const double E_00 = E(0, 0);
+  const double E_01 = E(0, 1);
+  const double E_02 = E(0, 2);
+  const double E_10 = E(1, 0);
+  const double E_11 = E(1, 1);
+  const double E_12 = E(1, 2);
+  const double E_20 = E(2, 0);
+  const double E_21 = E(2, 1);
+  const double E_22 = E(2, 2);
+
+  const double* ray1_data = ray1.empty() ? nullptr : ray1[0].data();
+  const double* ray2_data = ray2.empty() ? nullptr : ray2[0].data();
+  double* residuals_data = residuals->data();
+
   for (size_t i = 0; i < num_ray1; ++i) {
-    (*residuals)[i] = ComputeSquaredSampsonError(ray1[i], ray2[i], E);
+    const double r1_0 = ray1_data[3 * i + 0];
+    const double r1_1 = ray1_data[3 * i + 1];
+    const double r1_2 = ray1_data[3 * i + 2];
+    const double r2_0 = ray2_data[3 * i + 0];
+    const double r2_1 = ray2_data[3 * i + 1];
+    const double r2_2 = ray2_data[3 * i + 2];
+
+    const double Er1_0 = E_00 * r1_0 + E_01 * r1_1 + E_02 * r1_2;
+    const double Er1_1 = E_10 * r1_0 + E_11 * r1_1 + E_12 * r1_2;
+    const double Er1_2 = E_20 * r1_0 + E_21 * r1_1 + E_22 * r1_2;
+
+    const double Etr2_0 = E_00 * r2_0 + E_10 * r2_1 + E_20 * r2_2;
+    const double Etr2_1 = E_01 * r2_0 + E_11 * r2_1 + E_21 * r2_2;
+
+    const double num = r2_0 * Er1_0 + r2_1 * Er1_1 + r2_2 * Er1_2;
+    const double denom_sq_norm =
+        Etr2_0 * Etr2_0 + Etr2_1 * Etr2_1 + Er1_0 * Er1_0 + Er1_1 * Er1_1;
+
+    residuals_data[i] = denom_sq_norm == 0
+                            ? std::numeric_limits<double>::max()
+                            : num * num / denom_sq_norm;
   }
 }
 
@@ -37,6 +37,8 @@
 #include <Eigen/Geometry>
 #include <gtest/gtest.h>
 
+#include <limits>
+
 namespace colmap {
 namespace {
 
@@ -197,5 +199,54 @@ TEST(ComputeSquaredSampsonError, Nominal) {
   EXPECT_EQ(residuals[2], 2);
 }
 
+TEST(ComputeSquaredSampsonError, BatchMatchesSingle) {
+  const Eigen::Matrix3d E = EssentialMatrixFromPose(
+      Rigid3d(Eigen::Quaterniond::UnitRandom(), Eigen::Vector3d(1, -0.5, 0.2)));
+
+  std::vector<Eigen::Vector2d> points1;
+  std::vector<Eigen::Vector2d> points2;
+  std::vector<Eigen::Vector3d> rays1;
+  std::vector<Eigen::Vector3d> rays2;
+  for (int i = 0; i < 103; ++i) {
+    points1.push_back(Eigen::Vector2d::Random());
+    points2.push_back(Eigen::Vector2d::Random());
+    rays1.push_back(Eigen::Vector3d::Random().normalized());
+    rays2.push_back(Eigen::Vector3d::Random().normalized());
+  }
+
+  std::vector<double> residuals;
+  ComputeSquaredSampsonError(points1, points2, E, &residuals);
+  ASSERT_EQ(residuals.size(), points1.size());
+  for (size_t i = 0; i < points1.size(); ++i) {
+    EXPECT_NEAR(residuals[i],
+                ComputeSquaredSampsonError(
+                    points1[i].homogeneous(), points2[i].homogeneous(), E),
+                1e-12);
+  }
+
+  ComputeSquaredSampsonError(rays1, rays2, E, &residuals);
+  ASSERT_EQ(residuals.size(), rays1.size());
+  for (size_t i = 0; i < rays1.size(); ++i) {
+    EXPECT_NEAR(residuals[i],
+                ComputeSquaredSampsonError(rays1[i], rays2[i], E),
+                1e-12);
+  }
+
+  ComputeSquaredSampsonError(std::vector<Eigen::Vector2d>(),
+                             std::vector<Eigen::Vector2d>(),
+                             E,
+                             &residuals);
+  EXPECT_TRUE(residuals.empty());
+}
+
+TEST(ComputeSquaredSampsonError, Degenerate) {
+  std::vector<double> residuals;
+  const std::vector<Eigen::Vector3d> rays1 = {Eigen::Vector3d(1, 0, 0)};
+  const std::vector<Eigen::Vector3d> rays2 = {Eigen::Vector3d(0, 1, 0)};
+  ComputeSquaredSampsonError(rays1, rays2, Eigen::Matrix3d::Zero(), &residuals);
+  ASSERT_EQ(residuals.size(), 1);
+  EXPECT_EQ(residuals[0], std::numeric_limits<double>::max());
+}
+
 }  // namespace
 }  // namespace colmap
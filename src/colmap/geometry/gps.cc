@@ -30,10 +30,28 @@
 #include "colmap/geometry/gps.h"
 
 #include "colmap/math/math.h"
+#include "colmap/util/threading.h"
 
 namespace colmap {
 namespace {
 
+// Calls func(i) for all points in parallel. The conversion of a single point
+// is cheap, so inputs with up to kGrainSize points run in the calling thread.
+template <typename Func>
+void ParallelForEachPoint(const size_t num_points, const Func& func) {
+  constexpr int64_t kGrainSize = 1024;
+  ParallelFor(
+      0,
+      num_points,
+      [&func](const int64_t begin, const int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          func(i);
+        }
+      },
+      ThreadPool::kMaxNumThreads,
+      kGrainSize);
+}
+
 struct UTMParams {
   // Order of the series expansion, determining the precision.
   static constexpr int kOrder = 4;
@@ -119,7 +137,7 @@ std::vector<Eigen::Vector3d> GPSTransform::EllipsoidToECEF(
     const std::vector<Eigen::Vector3d>& lat_lon_alt) const {
   std::vector<Eigen::Vector3d> xyz_in_ecef(lat_lon_alt.size());
 
-  for (size_t i = 0; i < lat_lon_alt.size(); ++i) {
+  ParallelForEachPoint(lat_lon_alt.size(), [&](const size_t i) {
     const double lat = DegToRad(lat_lon_alt[i](0));
     const double lon = DegToRad(lat_lon_alt[i](1));
     const double alt = lat_lon_alt[i](2);
@@ -135,7 +153,7 @@ std::vector<Eigen::Vector3d> GPSTransform::EllipsoidToECEF(
     xyz_in_ecef[i](0) = (N + alt) * cos_lat * cos_lon;
     xyz_in_ecef[i](1) = (N + alt) * cos_lat * sin_lon;
     xyz_in_ecef[i](2) = (N * (1 - e2_) + alt) * sin_lat;
-  }
+  });
 
   return xyz_in_ecef;
 }
@@ -144,7 +162,7 @@ std::vector<Eigen::Vector3d> GPSTransform::ECEFToEllipsoid(
     const std::vector<Eigen::Vector3d>& xyz_in_ecef) const {
   std::vector<Eigen::Vector3d> lat_lon_alt(xyz_in_ecef.size());
 
-  for (size_t i = 0; i < lat_lon_alt.size(); ++i) {
+  ParallelForEachPoint(lat_lon_alt.size(), [&](const size_t i) {
     const double x = xyz_in_ecef[i](0);
     const double y = xyz_in_ecef[i](1);
     const double z = xyz_in_ecef[i](2);
@@ -172,7 +190,7 @@ std::vector<Eigen::Vector3d> GPSTransform::ECEFToEllipsoid(
     lat_lon_alt[i](0) = RadToDeg(lat);
     lat_lon_alt[i](1) = RadToDeg(std::atan2(y, x));
     lat_lon_alt[i](2) = alt;
-  }
+  });
 
   return lat_lon_alt;
 }
@@ -209,9 +227,9 @@ std::vector<Eigen::Vector3d> GPSTransform::ECEFToENU(
   R << -sin_lon, cos_lon, 0., -sin_lat * cos_lon, -sin_lat * sin_lon, cos_lat,
       cos_lat * cos_lon, cos_lat * sin_lon, sin_lat;
 
-  for (size_t i = 0; i < xyz_in_ecef.size(); ++i) {
+  ParallelForEachPoint(xyz_in_ecef.size(), [&](const size_t i) {
     xyz_in_enu[i] = R * (xyz_in_ecef[i] - ref_ecef);
-  }
+  });
 
   return xyz_in_enu;
 }
@@ -246,9 +264,9 @@ std::vector<Eigen::Vector3d> GPSTransform::ENUToECEF(
       cos_lat * cos_lon, cos_lat * sin_lon, sin_lat;
   R.transposeInPlace();
 
-  for (size_t i = 0; i < xyz_in_enu.size(); ++i) {
+  ParallelForEachPoint(xyz_in_enu.size(), [&](const size_t i) {
     xyz_in_ecef[i] = (R * xyz_in_enu[i]) + ref_xyz_in_ecef;
-  }
+  });
 
   return xyz_in_ecef;
 }
@@ -279,10 +297,10 @@ std::pair<std::vector<Eigen::Vector3d>, int> GPSTransform::EllipsoidToUTM(
       1;
   const double lambda0 = DegToRad(UTMParams::ZoneToCentralMeridian(zone));
 
-  std::vector<Eigen::Vector3d> xyz_in_utm;
-  xyz_in_utm.reserve(lat_lon_alt.size());
+  std::vector<Eigen::Vector3d> xyz_in_utm(lat_lon_alt.size());
 
-  for (const Eigen::Vector3d& lla : lat_lon_alt) {
+  ParallelForEachPoint(lat_lon_alt.size(), [&](const size_t i) {
+    const Eigen::Vector3d& lla = lat_lon_alt[i];
     const double phi = DegToRad(lla[0]);
     const double lambda = DegToRad(lla[1]);
 
@@ -306,8 +324,9 @@ std::pair<std::vector<Eigen::Vector3d>, int> GPSTransform::EllipsoidToUTM(
     E = params.E0 + params.k0 * params.A * E;
     N = params.N0(lla[0]) + params.k0 * params.A * N;
 
-    xyz_in_utm.emplace_back(E * 1000, N * 1000, lla[2]);  // Convert to meters.
-  }
+    // Convert to meters.
+    xyz_in_utm[i] = Eigen::Vector3d(E * 1000, N * 1000, lla[2]);
+  });
 
   return std::make_pair(std::move(xyz_in_utm), zone);
 }
@@ -324,10 +343,10 @@ std::vector<Eigen::Vector3d> GPSTransform::UTMToEllipsoid(
 
   const UTMParams params(a_ / 1000.0, f_);  // Convert to kilometers.
 
-  std::vector<Eigen::Vector3d> lat_lon_alt;
-  lat_lon_alt.reserve(xyz_in_utm.size());
+  std::vector<Eigen::Vector3d> lat_lon_alt(xyz_in_utm.size());
 
-  for (const Eigen::Vector3d& ena : xyz_in_utm) {
+  ParallelForEachPoint(xyz_in_utm.size(), [&](const size_t i) {
+    const Eigen::Vector3d& ena = xyz_in_utm[i];
     const double xi =
         (ena[1] / 1000.0 - params.N0(is_north)) / (params.k0 * params.A);
     const double eta = (ena[0] / 1000.0 - params.E0) / (params.k0 * params.A);
@@ -355,8 +374,8 @@ std::vector<Eigen::Vector3d> GPSTransform::UTMToEllipsoid(
         UTMParams::ZoneToCentralMeridian(zone) +
         RadToDeg(std::atan(std::sinh(eta_prime) / std::cos(xi_prime)));
 
-    lat_lon_alt.emplace_back(lat, lon, ena[2]);
-  }
+    lat_lon_alt[i] = Eigen::Vector3d(lat, lon, ena[2]);
+  });
 
   return lat_lon_alt;
 }
@@ -452,5 +452,35 @@ TEST(GPS, UTMToEllipsoidGRS80) {
   }
 }
 
+TEST(GPS, ManyPoints) {
+  // More points than a single parallel chunk to convert in parallel.
+  std::vector<Eigen::Vector3d> lat_lon_alt;
+  for (int i = 0; i < 5000; ++i) {
+    lat_lon_alt.emplace_back(47 + 1e-4 * i, 8 + 2e-4 * i, 400 + 0.1 * i);
+  }
+
+  GPSTransform gps_tform(GPSTransform::Ellipsoid::WGS84);
+
+  const auto xyz = gps_tform.EllipsoidToECEF(lat_lon_alt);
+  const auto lat_lon_alt2 = gps_tform.ECEFToEllipsoid(xyz);
+  const auto xyz_in_enu = gps_tform.EllipsoidToENU(lat_lon_alt, 47, 8, 400);
+  const auto lat_lon_alt3 = gps_tform.ENUToEllipsoid(xyz_in_enu, 47, 8, 400);
+  const auto [xyz_in_utm, zone] = gps_tform.EllipsoidToUTM(lat_lon_alt);
+  const auto lat_lon_alt4 =
+      gps_tform.UTMToEllipsoid(xyz_in_utm, zone, /*is_north=*/true);
+  ASSERT_EQ(xyz.size(), lat_lon_alt.size());
+  ASSERT_EQ(lat_lon_alt2.size(), lat_lon_alt.size());
+  ASSERT_EQ(lat_lon_alt3.size(), lat_lon_alt.size());
+  ASSERT_EQ(lat_lon_alt4.size(), lat_lon_alt.size());
+  for (size_t i = 0; i < lat_lon_alt.size(); ++i) {
+    EXPECT_EQ(xyz[i], gps_tform.EllipsoidToECEF({lat_lon_alt[i]})[0]);
+    EXPECT_THAT(lat_lon_alt2[i], EigenMatrixNear(lat_lon_alt[i], 1e-6));
+    EXPECT_THAT(lat_lon_alt3[i], EigenMatrixNear(lat_lon_alt[i], 1e-6));
+    EXPECT_THAT(Eigen::Vector2d(lat_lon_alt4[i].head<2>()),
+                EigenMatrixNear(Eigen::Vector2d(lat_lon_alt[i].head<2>()),
+                                1e-5));
+  }
+}
+
 }  // namespace
 }  // namespace colmap
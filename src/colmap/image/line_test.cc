@@ -29,6 +29,8 @@
 
 #include "colmap/image/line.h"
 
+#include "colmap/util/threading.h"
+
 #include <gtest/gtest.h>
 
 namespace colmap {
@@ -56,6 +58,39 @@ TEST(DetectLineSegments, Nominal) {
   EXPECT_EQ(DetectLineSegments(bitmap, 150).size(), 0);
 }
 
+TEST(DetectLineSegments, Concurrent) {
+  std::vector<Bitmap> bitmaps;
+  for (int i = 0; i < 8; ++i) {
+    Bitmap bitmap(100, 100, false);
+    for (int j = 10 * i; j < 100; ++j) {
+      bitmap.SetPixel(j, j, BitmapColor<uint8_t>(255));
+      bitmap.SetPixel(j, 50, BitmapColor<uint8_t>(255));
+    }
+    bitmaps.push_back(std::move(bitmap));
+  }
+
+  std::vector<std::vector<LineSegment>> line_segments(bitmaps.size());
+  ParallelFor(
+      0,
+      bitmaps.size(),
+      [&](const int64_t begin, const int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          line_segments[i] = DetectLineSegments(bitmaps[i], 0);
+        }
+      },
+      /*num_threads=*/4,
+      /*grain_size=*/1);
+
+  for (size_t i = 0; i < bitmaps.size(); ++i) {
+    const auto expected_line_segments = DetectLineSegments(bitmaps[i], 0);
+    ASSERT_EQ(line_segments[i].size(), expected_line_segments.size());
+    for (size_t j = 0; j < expected_line_segments.size(); ++j) {
+      EXPECT_EQ(line_segments[i][j].start, expected_line_segments[j].start);
+      EXPECT_EQ(line_segments[i][j].end, expected_line_segments[j].end);
+    }
+  }
+}
+
 TEST(ClassifyLineSegmentOrientations, Nominal) {
   Bitmap bitmap(100, 100, false);
   for (size_t i = 60; i < 100; ++i) {
@@ -31,8 +31,14 @@
 
 #include "colmap/image/warp.h"
 #include "colmap/math/math.h"
+#include "colmap/scene/cam_from_img_lookup_table.h"
 #include "colmap/sensor/models.h"
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <unordered_map>
+
 namespace colmap {
 
 Camera UndistortCamera(const UndistortCameraOptions& options,
@@ -269,6 +275,46 @@ void UndistortImage(const UndistortCameraOptions& options,
   distorted_bitmap.CloneMetadata(undistorted_bitmap);
 }
 
+CameraWarpMap CreateUndistortionWarpMap(
+    const UndistortCameraOptions& options,
+    const Camera& distorted_camera,
+    const bool reduce_distorted_resolution) {
+  const Camera undistorted_camera = UndistortCamera(options, distorted_camera);
+
+  Camera source_camera = distorted_camera;
+  if (reduce_distorted_resolution) {
+    // The image is warped at the resolution of the source camera and then
+    // rescaled to the undistorted camera, so the downscaled source camera
+    // must not have fewer pixels than the undistorted camera in any dimension.
+    const double scale = std::max(
+        static_cast<double>(undistorted_camera.width) / distorted_camera.width,
+        static_cast<double>(undistorted_camera.height) /
+            distorted_camera.height);
+    const size_t new_width =
+        static_cast<size_t>(std::ceil(scale * distorted_camera.width));
+    const size_t new_height =
+        static_cast<size_t>(std::ceil(scale * distorted_camera.height));
+    if (2 * new_width <= distorted_camera.width &&
+        2 * new_height <= distorted_camera.height) {
+      source_camera.Rescale(new_width, new_height);
+    }
+  }
+
+  return CameraWarpMap(source_camera,
+                       undistorted_camera,
+                       /*grid_step=*/8,
+                       options.warp_map_max_error);
+}
+
+void UndistortImage(const CameraWarpMap& warp_map,
+                    const Bitmap& distorted_bitmap,
+                    Bitmap* undistorted_bitmap,
+                    Camera* undistorted_camera) {
+  *undistorted_camera = warp_map.TargetCamera();
+  warp_map.Warp(distorted_bitmap, undistorted_bitmap);
+  distorted_bitmap.CloneMetadata(undistorted_bitmap);
+}
+
 void UndistortReconstruction(const UndistortCameraOptions& options,
                              Reconstruction* reconstruction) {
   const std::unordered_map<camera_t, Camera> distorted_cameras =
@@ -284,6 +330,34 @@ void UndistortReconstruction(const UndistortCameraOptions& options,
         UndistortCamera(options, camera.second);
   }
 
+  // Build lookup tables for the unprojection of cameras whose number of
+  // observations clearly exceeds the number of unprojections to build the
+  // table.
+  std::unordered_map<camera_t, std::unique_ptr<CamFromImgLookupTable>>
+      lookup_tables;
+  if (options.lookup_table_max_error >= 0) {
+    constexpr int kGridStep = 8;
+    std::unordered_map<camera_t, size_t> num_points2D_per_camera;
+    for (const auto& [_, image] : reconstruction->Images()) {
+      num_points2D_per_camera[image.CameraId()] += image.NumPoints2D();
+    }
+    for (const auto& [camera_id, num_points2D] : num_points2D_per_camera) {
+      const Camera& distorted_camera = distorted_cameras.at(camera_id);
+      if (distorted_camera.IsUndistorted()) {
+        continue;
+      }
+      const size_t num_grid_cells = (distorted_camera.width / kGridStep + 1) *
+                                    (distorted_camera.height / kGridStep + 1);
+      if (num_points2D > 4 * num_grid_cells) {
+        lookup_tables.emplace(camera_id,
+                              std::make_unique<CamFromImgLookupTable>(
+                                  distorted_camera,
+                                  kGridStep,
+                                  options.lookup_table_max_error));
+      }
+    }
+  }
+
   for (const auto& distorted_image : reconstruction->Images()) {
     Image& image = reconstruction->Image(distorted_image.first);
     const Camera& distorted_camera = distorted_cameras.at(image.CameraId());
@@ -293,12 +367,17 @@ void UndistortReconstruction(const UndistortCameraOptions& options,
     if (distorted_camera.IsUndistorted()) {
       continue;
     }
+    const auto lookup_table_it = lookup_tables.find(image.CameraId());
+    const CamFromImgLookupTable* lookup_table =
+        lookup_table_it == lookup_tables.end() ? nullptr
+                                               : lookup_table_it->second.get();
     const Camera& undistorted_camera = *image.CameraPtr();
     for (point2D_t point2D_idx = 0; point2D_idx < image.NumPoints2D();
          ++point2D_idx) {
       auto& point2D = image.Point2D(point2D_idx);
       const std::optional<Eigen::Vector2d> cam_point =
-          distorted_camera.CamFromImg(point2D.xy);
+          lookup_table ? lookup_table->CamFromImg(point2D.xy)
+                       : distorted_camera.CamFromImg(point2D.xy);
       if (!cam_point) {
         point2D.xy =
             Eigen::Vector2d::Constant(std::numeric_limits<double>::quiet_NaN());
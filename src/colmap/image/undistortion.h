@@ -30,6 +30,7 @@
 #pragma once
 
 #include "colmap/geometry/rigid3.h"
+#include "colmap/image/warp.h"
 #include "colmap/scene/reconstruction.h"
 #include "colmap/sensor/bitmap.h"
 
@@ -64,6 +65,18 @@ struct UndistortCameraOptions {
   // output dimensions. Points with norm exceeding this threshold are skipped.
   // Set to -1 to disable the check (default).
   double max_cam_point_norm = -1;
+
+  // Maximum error in pixels when unprojecting the 2D points of a
+  // reconstruction through a precomputed lookup table (see
+  // CamFromImgLookupTable) instead of the iterative undistortion of the camera
+  // model. The table is only used for cameras with many observations. Set to
+  // -1 to always unproject exactly (default).
+  double lookup_table_max_error = -1;
+
+  // Maximum error in pixels of the distorted pixel positions interpolated from
+  // the warp map when undistorting images with a precomputed map (see
+  // CreateUndistortionWarpMap). Set to -1 to warp every pixel exactly.
+  double warp_map_max_error = 0.01;
 };
 
 // Undistort camera by resizing the image and shifting the principal point.
@@ -95,6 +108,27 @@ void UndistortImage(const UndistortCameraOptions& options,
                     Bitmap* undistorted_image,
                     Camera* undistorted_camera);
 
+// Create the warp map from the undistorted camera (see `UndistortCamera`) to
+// the distorted camera, which undistorts all images of the same camera without
+// recomputing the distortion of every pixel. If `reduce_distorted_resolution`
+// is true and the undistorted camera has at most half the resolution of the
+// distorted camera (e.g., due to `max_image_size`), the source camera of the
+// warp map is the distorted camera downscaled to just cover the undistorted
+// resolution. The distorted images must then be read at the dimensions of
+// `CameraWarpMap::SourceCamera`, e.g., with `Bitmap::ReadRescaled`, which
+// avoids decoding them at full resolution.
+CameraWarpMap CreateUndistortionWarpMap(
+    const UndistortCameraOptions& options,
+    const Camera& distorted_camera,
+    bool reduce_distorted_resolution = false);
+
+// Undistort image with a precomputed warp map of its camera, see
+// `CreateUndistortionWarpMap`.
+void UndistortImage(const CameraWarpMap& warp_map,
+                    const Bitmap& distorted_image,
+                    Bitmap* undistorted_image,
+                    Camera* undistorted_camera);
+
 // Undistort all cameras in the reconstruction and accordingly all
 // observations in their corresponding images.
 void UndistortReconstruction(const UndistortCameraOptions& options,
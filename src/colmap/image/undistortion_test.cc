@@ -225,10 +225,9 @@ TEST(UndistortCamera, NoBlankPixels) {
   }
 }
 
-TEST(UndistortReconstruction, Nominal) {
-  const size_t kNumImages = 10;
-  const size_t kNumPoints2D = 10;
-
+Reconstruction CreateDistortedReconstruction(
+    const size_t num_images,
+    const std::vector<Eigen::Vector2d>& points2D) {
   Reconstruction reconstruction;
 
   Camera camera = Camera::CreateFromModelId(1, CameraModelId::kOpenCV, 1, 1, 1);
@@ -239,7 +238,7 @@ TEST(UndistortReconstruction, Nominal) {
   rig.AddRefSensor(sensor_t(SensorType::CAMERA, 1));
   reconstruction.AddRig(rig);
 
-  for (image_t image_id = 1; image_id <= kNumImages; ++image_id) {
+  for (image_t image_id = 1; image_id <= num_images; ++image_id) {
     Frame frame;
     frame.SetRigId(1);
     frame.SetFrameId(image_id);
@@ -249,14 +248,117 @@ TEST(UndistortReconstruction, Nominal) {
     image.SetCameraId(1);
     image.SetFrameId(frame.FrameId());
     image.SetName("image" + std::to_string(image_id));
-    image.SetPoints2D(
-        std::vector<Eigen::Vector2d>(kNumPoints2D, Eigen::Vector2d::Ones()));
+    image.SetPoints2D(points2D);
     frame.AddDataId(image.DataId());
     reconstruction.AddFrame(frame);
     reconstruction.AddImage(image);
     reconstruction.RegisterFrame(frame.FrameId());
   }
 
+  return reconstruction;
+}
+
+TEST(UndistortImage, WarpMap) {
+  UndistortCameraOptions options;
+  options.warp_map_max_error = -1;
+
+  Camera distorted_camera =
+      Camera::CreateFromModelId(1, CameraModelId::kSimpleRadial, 200, 100, 80);
+  distorted_camera.params[3] = 0.05;
+
+  Bitmap distorted_image(100, 80, /*as_rgb=*/true);
+  for (int y = 0; y < distorted_image.Height(); ++y) {
+    for (int x = 0; x < distorted_image.Width(); ++x) {
+      distorted_image.SetPixel(
+          x, y, BitmapColor<uint8_t>(2 * x, 3 * y, x + y));
+    }
+  }
+
+  Bitmap expected_undistorted_image;
+  Camera expected_undistorted_camera;
+  UndistortImage(options,
+                 distorted_image,
+                 distorted_camera,
+                 &expected_undistorted_image,
+                 &expected_undistorted_camera);
+
+  // Without interpolation, the warp map is exact.
+  Bitmap undistorted_image;
+  Camera undistorted_camera;
+  UndistortImage(CreateUndistortionWarpMap(options, distorted_camera),
+                 distorted_image,
+                 &undistorted_image,
+                 &undistorted_camera);
+  EXPECT_EQ(undistorted_camera, expected_undistorted_camera);
+  EXPECT_EQ(undistorted_image.RowMajorData(),
+            expected_undistorted_image.RowMajorData());
+
+  options.warp_map_max_error = 0.01;
+  const CameraWarpMap warp_map =
+      CreateUndistortionWarpMap(options, distorted_camera);
+  EXPECT_GT(warp_map.InterpolatedCellRatio(), 0.5);
+  UndistortImage(
+      warp_map, distorted_image, &undistorted_image, &undistorted_camera);
+  EXPECT_EQ(undistorted_camera, expected_undistorted_camera);
+  ASSERT_EQ(undistorted_image.RowMajorData().size(),
+            expected_undistorted_image.RowMajorData().size());
+  for (size_t i = 0; i < undistorted_image.RowMajorData().size(); ++i) {
+    EXPECT_NEAR(undistorted_image.RowMajorData()[i],
+                expected_undistorted_image.RowMajorData()[i],
+                1);
+  }
+}
+
+TEST(UndistortImage, WarpMapReducedDistortedResolution) {
+  UndistortCameraOptions options;
+  options.max_image_size = 40;
+  Camera distorted_camera =
+      Camera::CreateFromModelId(1, CameraModelId::kSimpleRadial, 200, 100, 80);
+  distorted_camera.params[3] = 0.05;
+
+  const CameraWarpMap full_warp_map =
+      CreateUndistortionWarpMap(options, distorted_camera);
+  EXPECT_EQ(full_warp_map.SourceCamera(), distorted_camera);
+
+  const CameraWarpMap warp_map =
+      CreateUndistortionWarpMap(options,
+                                distorted_camera,
+                                /*reduce_distorted_resolution=*/true);
+  EXPECT_EQ(warp_map.TargetCamera(), full_warp_map.TargetCamera());
+  EXPECT_LE(2 * warp_map.SourceCamera().width, distorted_camera.width);
+  EXPECT_LE(2 * warp_map.SourceCamera().height, distorted_camera.height);
+  EXPECT_GE(warp_map.SourceCamera().width, warp_map.TargetCamera().width);
+  EXPECT_GE(warp_map.SourceCamera().height, warp_map.TargetCamera().height);
+
+  Bitmap distorted_image(static_cast<int>(warp_map.SourceCamera().width),
+                         static_cast<int>(warp_map.SourceCamera().height),
+                         /*as_rgb=*/false);
+  distorted_image.Fill(BitmapColor<uint8_t>(100));
+  Bitmap undistorted_image;
+  Camera undistorted_camera;
+  UndistortImage(
+      warp_map, distorted_image, &undistorted_image, &undistorted_camera);
+  EXPECT_EQ(undistorted_camera, warp_map.TargetCamera());
+  EXPECT_EQ(undistorted_image.Width(), undistorted_camera.width);
+  EXPECT_EQ(undistorted_image.Height(), undistorted_camera.height);
+
+  // No reduction if the undistorted camera is not small enough.
+  options.max_image_size = 60;
+  EXPECT_EQ(CreateUndistortionWarpMap(options,
+                                      distorted_camera,
+                                      /*reduce_distorted_resolution=*/true)
+                .SourceCamera(),
+            distorted_camera);
+}
+
+TEST(UndistortReconstruction, Nominal) {
+  const size_t kNumImages = 10;
+  const size_t kNumPoints2D = 10;
+
+  Reconstruction reconstruction = CreateDistortedReconstruction(
+      kNumImages,
+      std::vector<Eigen::Vector2d>(kNumPoints2D, Eigen::Vector2d::Ones()));
+
   UndistortCameraOptions options;
   UndistortReconstruction(options, &reconstruction);
   for (const auto& camera : reconstruction.Cameras()) {
@@ -270,6 +372,37 @@ TEST(UndistortReconstruction, Nominal) {
   }
 }
 
+TEST(UndistortReconstruction, LookupTable) {
+  std::vector<Eigen::Vector2d> points2D;
+  for (int i = 0; i <= 10; ++i) {
+    for (int j = 0; j <= 10; ++j) {
+      points2D.emplace_back(0.1 * i, 0.1 * j);
+    }
+  }
+
+  Reconstruction reconstruction = CreateDistortedReconstruction(3, points2D);
+  Reconstruction lookup_reconstruction = reconstruction;
+
+  UndistortCameraOptions options;
+  UndistortReconstruction(options, &reconstruction);
+  options.lookup_table_max_error = 1e-3;
+  UndistortReconstruction(options, &lookup_reconstruction);
+
+  for (const auto& [image_id, image] : reconstruction.Images()) {
+    const Image& lookup_image = lookup_reconstruction.Image(image_id);
+    ASSERT_EQ(image.NumPoints2D(), lookup_image.NumPoints2D());
+    for (point2D_t i = 0; i < image.NumPoints2D(); ++i) {
+      const Eigen::Vector2d& xy = image.Point2D(i).xy;
+      const Eigen::Vector2d& lookup_xy = lookup_image.Point2D(i).xy;
+      if (xy.allFinite()) {
+        EXPECT_LE((xy - lookup_xy).norm(), 2e-3);
+      } else {
+        EXPECT_FALSE(lookup_xy.allFinite());
+      }
+    }
+  }
+}
+
 TEST(RectifyStereoCameras, Nominal) {
   Camera camera1;
   camera1 = Camera::CreateFromModelId(1, CameraModelId::kPinhole, 1, 1, 1);
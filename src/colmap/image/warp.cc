@@ -31,9 +31,15 @@
 
 #include "colmap/util/eigen_alignment.h"
 #include "colmap/util/logging.h"
+#include "colmap/util/threading.h"
 
 #include "thirdparty/VLFeat/imopv.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
 #include <Eigen/Geometry>
 
 namespace colmap {
@@ -51,6 +57,70 @@ float GetPixelConstantBorder(const float* data,
   }
 }
 
+// Samples the source image at the source points of each row in parallel and
+// writes the colors to the target image. Pixels without a valid source point
+// or with a source point outside the source image are set to black.
+// source_point_fn(x, y) returns the source point of the target pixel (x, y),
+// where the upper left pixel center is (0.5, 0.5).
+void WarpImageRows(
+    const Bitmap& source_image,
+    const std::function<std::optional<Eigen::Vector2d>(int, int)>&
+        source_point_fn,
+    Bitmap* target_image) {
+  const int width = target_image->Width();
+  ParallelFor(0,
+              target_image->Height(),
+              [&](const int64_t y_begin, const int64_t y_end) {
+                std::vector<Eigen::Vector2d> source_points(width);
+                std::vector<std::optional<BitmapColor<float>>> colors(width);
+                for (int y = y_begin; y < y_end; ++y) {
+                  for (int x = 0; x < width; ++x) {
+                    // Invalid points are mapped outside the source image.
+                    const std::optional<Eigen::Vector2d> source_point =
+                        source_point_fn(x, y);
+                    source_points[x] =
+                        source_point ? Eigen::Vector2d(source_point->x() - 0.5,
+                                                       source_point->y() - 0.5)
+                                     : Eigen::Vector2d(-1, -1);
+                  }
+                  source_image.InterpolateBilinearBatch(
+                      {source_points.data(), source_points.size()},
+                      {colors.data(), colors.size()});
+                  for (int x = 0; x < width; ++x) {
+                    target_image->SetPixel(
+                        x,
+                        y,
+                        colors[x] ? colors[x]->Cast<uint8_t>()
+                                  : BitmapColor<uint8_t>(0));
+                  }
+                }
+              });
+}
+
+// To avoid aliasing, images are warped in the resolution of the source camera
+// and then rescaled to the resolution of the target camera.
+Camera ScaleTargetCameraToSource(const Camera& source_camera,
+                                 const Camera& target_camera) {
+  Camera scaled_target_camera = target_camera;
+  if (target_camera.width != source_camera.width ||
+      target_camera.height != source_camera.height) {
+    scaled_target_camera.Rescale(source_camera.width, source_camera.height);
+  }
+  return scaled_target_camera;
+}
+
+std::optional<Eigen::Vector2d> SourceFromTargetExact(
+    const Camera& source_camera,
+    const Camera& target_camera,
+    const Eigen::Vector2d& target_point) {
+  const std::optional<Eigen::Vector2d> cam_point =
+      target_camera.CamFromImg(target_point);
+  if (!cam_point) {
+    return std::nullopt;
+  }
+  return source_camera.ImgFromCam(cam_point->homogeneous());
+}
+
 }  // namespace
 
 void WarpImageBetweenCameras(const Camera& source_camera,
@@ -65,47 +135,153 @@ void WarpImageBetweenCameras(const Camera& source_camera,
                          static_cast<int>(source_camera.height),
                          source_image.IsRGB());
 
-  // To avoid aliasing, perform the warping in the source resolution and
-  // then rescale the image at the end.
-  Camera scaled_target_camera = target_camera;
+  const Camera scaled_target_camera =
+      ScaleTargetCameraToSource(source_camera, target_camera);
+
+  WarpImageRows(
+      source_image,
+      [&](const int x, const int y) {
+        // Camera models assume that the upper left pixel center is (0.5, 0.5).
+        return SourceFromTargetExact(source_camera,
+                                     scaled_target_camera,
+                                     Eigen::Vector2d(x + 0.5, y + 0.5));
+      },
+      target_image);
+
   if (target_camera.width != source_camera.width ||
       target_camera.height != source_camera.height) {
-    scaled_target_camera.Rescale(source_camera.width, source_camera.height);
+    target_image->Rescale(target_camera.width, target_camera.height);
   }
+}
 
-  Eigen::Vector2d image_point;
-  for (int y = 0; y < target_image->Height(); ++y) {
-    image_point.y() = y + 0.5;
-    for (int x = 0; x < target_image->Width(); ++x) {
-      image_point.x() = x + 0.5;
-
-      // Camera models assume that the upper left pixel center is (0.5, 0.5).
-      const std::optional<Eigen::Vector2d> cam_point =
-          scaled_target_camera.CamFromImg(image_point);
-      if (!cam_point) {
-        target_image->SetPixel(x, y, BitmapColor<uint8_t>(0));
-        continue;
-      }
+CameraWarpMap::CameraWarpMap(const Camera& source_camera,
+                             const Camera& target_camera,
+                             const int grid_step,
+                             const double max_error)
+    : source_camera_(source_camera),
+      target_camera_(target_camera),
+      scaled_target_camera_(
+          ScaleTargetCameraToSource(source_camera, target_camera)),
+      grid_step_(grid_step) {
+  THROW_CHECK_GT(grid_step_, 0);
+  if (max_error < 0) {
+    return;
+  }
 
-      const std::optional<Eigen::Vector2d> source_point =
-          source_camera.ImgFromCam(cam_point->homogeneous());
-
-      const auto color =
-          source_point ? source_image.InterpolateBilinear(
-                             source_point->x() - 0.5, source_point->y() - 0.5)
-                       : std::nullopt;
-      if (color) {
-        target_image->SetPixel(x, y, color->Cast<uint8_t>());
-      } else {
-        target_image->SetPixel(x, y, BitmapColor<uint8_t>(0));
+  num_cells_x_ =
+      (static_cast<int>(scaled_target_camera_.width) + grid_step_ - 1) /
+      grid_step_;
+  num_cells_y_ =
+      (static_cast<int>(scaled_target_camera_.height) + grid_step_ - 1) /
+      grid_step_;
+
+  const int num_nodes_x = num_cells_x_ + 1;
+  const int num_nodes_y = num_cells_y_ + 1;
+  nodes_.resize(num_nodes_x * num_nodes_y);
+  std::vector<char> valid_nodes(nodes_.size(), 0);
+  ParallelFor(0, num_nodes_y, [&](const int64_t y_begin, const int64_t y_end) {
+    for (int y = y_begin; y < y_end; ++y) {
+      for (int x = 0; x < num_nodes_x; ++x) {
+        const int idx = y * num_nodes_x + x;
+        if (const std::optional<Eigen::Vector2d> source_point =
+                SourceFromTargetExact(
+                    source_camera_,
+                    scaled_target_camera_,
+                    Eigen::Vector2d(x * grid_step_, y * grid_step_));
+            source_point.has_value() && source_point->allFinite()) {
+          nodes_[idx] = *source_point;
+          valid_nodes[idx] = 1;
+        }
+      }
+    }
+  });
+
+  interpolate_cells_.resize(num_cells_x_ * num_cells_y_, 0);
+  ParallelFor(0, num_cells_y_, [&](const int64_t y_begin, const int64_t y_end) {
+    for (int y = y_begin; y < y_end; ++y) {
+      for (int x = 0; x < num_cells_x_; ++x) {
+        const int idx00 = y * num_nodes_x + x;
+        const int idx01 = idx00 + 1;
+        const int idx10 = idx00 + num_nodes_x;
+        const int idx11 = idx10 + 1;
+        if (!valid_nodes[idx00] || !valid_nodes[idx01] ||
+            !valid_nodes[idx10] || !valid_nodes[idx11]) {
+          continue;
+        }
+        const std::optional<Eigen::Vector2d> source_point =
+            SourceFromTargetExact(source_camera_,
+                                  scaled_target_camera_,
+                                  Eigen::Vector2d((x + 0.5) * grid_step_,
+                                                  (y + 0.5) * grid_step_));
+        if (!source_point.has_value()) {
+          continue;
+        }
+        const Eigen::Vector2d interpolated_source_point =
+            0.25 * (nodes_[idx00] + nodes_[idx01] + nodes_[idx10] +
+                    nodes_[idx11]);
+        if ((*source_point - interpolated_source_point).norm() <= max_error) {
+          interpolate_cells_[y * num_cells_x_ + x] = 1;
+        }
       }
     }
+  });
+}
+
+void CameraWarpMap::Warp(const Bitmap& source_image,
+                         Bitmap* target_image) const {
+  THROW_CHECK_EQ(source_camera_.width, source_image.Width());
+  THROW_CHECK_EQ(source_camera_.height, source_image.Height());
+  THROW_CHECK_NOTNULL(target_image);
+
+  *target_image = Bitmap(static_cast<int>(source_camera_.width),
+                         static_cast<int>(source_camera_.height),
+                         source_image.IsRGB());
+
+  WarpImageRows(
+      source_image,
+      [this](const int x, const int y) { return SourceFromTarget(x, y); },
+      target_image);
+
+  if (target_camera_.width != source_camera_.width ||
+      target_camera_.height != source_camera_.height) {
+    target_image->Rescale(target_camera_.width, target_camera_.height);
+  }
+}
+
+double CameraWarpMap::InterpolatedCellRatio() const {
+  if (interpolate_cells_.empty()) {
+    return 0;
+  }
+  size_t num_interpolated_cells = 0;
+  for (const char interpolate : interpolate_cells_) {
+    num_interpolated_cells += interpolate;
   }
+  return static_cast<double>(num_interpolated_cells) /
+         interpolate_cells_.size();
+}
 
-  if (target_camera.width != source_camera.width ||
-      target_camera.height != source_camera.height) {
-    target_image->Rescale(target_camera.width, target_camera.height);
+std::optional<Eigen::Vector2d> CameraWarpMap::SourceFromTarget(
+    const int x, const int y) const {
+  // Camera models assume that the upper left pixel center is (0.5, 0.5).
+  const Eigen::Vector2d target_point(x + 0.5, y + 0.5);
+  const double grid_x = target_point.x() / grid_step_;
+  const double grid_y = target_point.y() / grid_step_;
+  const int cell_x = static_cast<int>(grid_x);
+  const int cell_y = static_cast<int>(grid_y);
+  if (cell_x >= num_cells_x_ || cell_y >= num_cells_y_ ||
+      !interpolate_cells_[cell_y * num_cells_x_ + cell_x]) {
+    return SourceFromTargetExact(
+        source_camera_, scaled_target_camera_, target_point);
   }
+
+  const double dx = grid_x - cell_x;
+  const double dy = grid_y - cell_y;
+  const int num_nodes_x = num_cells_x_ + 1;
+  const int idx00 = cell_y * num_nodes_x + cell_x;
+  const int idx10 = idx00 + num_nodes_x;
+  return Eigen::Vector2d(
+      (1 - dy) * ((1 - dx) * nodes_[idx00] + dx * nodes_[idx00 + 1]) +
+      dy * ((1 - dx) * nodes_[idx10] + dx * nodes_[idx10 + 1]));
 }
 
 void WarpImageWithHomography(const Eigen::Matrix3d& H,
@@ -116,22 +292,12 @@ void WarpImageWithHomography(const Eigen::Matrix3d& H,
   THROW_CHECK_GT(target_image->Height(), 0);
   THROW_CHECK_EQ(source_image.IsRGB(), target_image->IsRGB());
 
-  Eigen::Vector3d target_pixel(0, 0, 1);
-  for (int y = 0; y < target_image->Height(); ++y) {
-    target_pixel.y() = y + 0.5;
-    for (int x = 0; x < target_image->Width(); ++x) {
-      target_pixel.x() = x + 0.5;
-
-      const Eigen::Vector2d source_pixel = (H * target_pixel).hnormalized();
-
-      if (const auto color = source_image.InterpolateBilinear(
-              source_pixel.x() - 0.5, source_pixel.y() - 0.5)) {
-        target_image->SetPixel(x, y, color->Cast<uint8_t>());
-      } else {
-        target_image->SetPixel(x, y, BitmapColor<uint8_t>(0));
-      }
-    }
-  }
+  WarpImageRows(
+      source_image,
+      [&](const int x, const int y) -> std::optional<Eigen::Vector2d> {
+        return (H * Eigen::Vector3d(x + 0.5, y + 0.5, 1)).hnormalized();
+      },
+      target_image);
 }
 
 void WarpImageWithHomographyBetweenCameras(const Eigen::Matrix3d& H,
@@ -147,47 +313,23 @@ void WarpImageWithHomographyBetweenCameras(const Eigen::Matrix3d& H,
                          static_cast<int>(source_camera.height),
                          source_image.IsRGB());
 
-  // To avoid aliasing, perform the warping in the source resolution and
-  // then rescale the image at the end.
-  Camera scaled_target_camera = target_camera;
-  if (target_camera.width != source_camera.width ||
-      target_camera.height != source_camera.height) {
-    scaled_target_camera.Rescale(source_camera.width, source_camera.height);
-  }
-
-  Eigen::Vector3d image_point(0, 0, 1);
-  for (int y = 0; y < target_image->Height(); ++y) {
-    image_point.y() = y + 0.5;
-    for (int x = 0; x < target_image->Width(); ++x) {
-      image_point.x() = x + 0.5;
-
-      // Camera models assume that the upper left pixel center is (0.5, 0.5).
-      const Eigen::Vector3d warped_point = H * image_point;
-      if (warped_point.z() == 0) {
-        continue;
-      }
-
-      const std::optional<Eigen::Vector2d> cam_point =
-          target_camera.CamFromImg(warped_point.hnormalized());
-      if (!cam_point) {
-        target_image->SetPixel(x, y, BitmapColor<uint8_t>(0));
-        continue;
-      }
-
-      const std::optional<Eigen::Vector2d> source_point =
-          source_camera.ImgFromCam(cam_point->homogeneous());
-
-      const auto color =
-          source_point ? source_image.InterpolateBilinear(
-                             source_point->x() - 0.5, source_point->y() - 0.5)
-                       : std::nullopt;
-      if (color) {
-        target_image->SetPixel(x, y, color->Cast<uint8_t>());
-      } else {
-        target_image->SetPixel(x, y, BitmapColor<uint8_t>(0));
-      }
-    }
-  }
+  WarpImageRows(
+      source_image,
+      [&](const int x, const int y) -> std::optional<Eigen::Vector2d> {
+        // Camera models assume that the upper left pixel center is (0.5, 0.5).
+        const Eigen::Vector3d warped_point =
+            H * Eigen::Vector3d(x + 0.5, y + 0.5, 1);
+        if (warped_point.z() == 0) {
+          return std::nullopt;
+        }
+        const std::optional<Eigen::Vector2d> cam_point =
+            target_camera.CamFromImg(warped_point.hnormalized());
+        if (!cam_point) {
+          return std::nullopt;
+        }
+        return source_camera.ImgFromCam(cam_point->homogeneous());
+      },
+      target_image);
 
   if (target_camera.width != source_camera.width ||
       target_camera.height != source_camera.height) {
@@ -211,32 +353,87 @@ void ResampleImageBilinear(const float* data,
   const float scale_r = static_cast<float>(rows) / static_cast<float>(new_rows);
   const float scale_c = static_cast<float>(cols) / static_cast<float>(new_cols);
 
-  for (int r = 0; r < new_rows; ++r) {
-    const float r_i = (r + 0.5f) * scale_r - 0.5f;
-    const int r_i_min = std::floor(r_i);
-    const int r_i_max = r_i_min + 1;
-    const float d_r_min = r_i - r_i_min;
-    const float d_r_max = r_i_max - r_i;
-
-    for (int c = 0; c < new_cols; ++c) {
-      const float c_i = (c + 0.5f) * scale_c - 0.5f;
-      const int c_i_min = std::floor(c_i);
-      const int c_i_max = c_i_min + 1;
-      const float d_c_min = c_i - c_i_min;
-      const float d_c_max = c_i_max - c_i;
-
-      // Interpolation in column direction.
-      const float value1 =
-          d_c_max * GetPixelConstantBorder(data, rows, cols, r_i_min, c_i_min) +
-          d_c_min * GetPixelConstantBorder(data, rows, cols, r_i_min, c_i_max);
-      const float value2 =
-          d_c_max * GetPixelConstantBorder(data, rows, cols, r_i_max, c_i_min) +
-          d_c_min * GetPixelConstantBorder(data, rows, cols, r_i_max, c_i_max);
-
-      // Interpolation in row direction.
-      resampled[r * new_cols + c] = d_r_max * value1 + d_r_min * value2;
+  // The column indices and weights are the same for all rows. Since c_i_min
+  // is monotonic in c, the columns whose both neighbors are inside the image
+  // form a contiguous range that is interpolated without border checks.
+  std::vector<int> c_i_mins(new_cols);
+  std::vector<float> d_c_mins(new_cols);
+  std::vector<float> d_c_maxs(new_cols);
+  int c_inner_begin = new_cols;
+  int c_inner_end = 0;
+  for (int c = 0; c < new_cols; ++c) {
+    const float c_i = (c + 0.5f) * scale_c - 0.5f;
+    const int c_i_min = std::floor(c_i);
+    const int c_i_max = c_i_min + 1;
+    c_i_mins[c] = c_i_min;
+    d_c_mins[c] = c_i - c_i_min;
+    d_c_maxs[c] = c_i_max - c_i;
+    if (c_i_min >= 0 && c_i_max < cols) {
+      c_inner_begin = std::min(c_inner_begin, c);
+      c_inner_end = c + 1;
     }
   }
+  c_inner_begin = std::min(c_inner_begin, c_inner_end);
+
+  // Rows outside the image are read from a row of zeros.
+  const std::vector<float> zero_row(cols, 0.f);
+
+  ParallelFor(0, new_rows, [&](const int64_t r_begin, const int64_t r_end) {
+    for (int r = r_begin; r < r_end; ++r) {
+      const float r_i = (r + 0.5f) * scale_r - 0.5f;
+      const int r_i_min = std::floor(r_i);
+      const int r_i_max = r_i_min + 1;
+      const float d_r_min = r_i - r_i_min;
+      const float d_r_max = r_i_max - r_i;
+
+      const float* row_min = (r_i_min >= 0 && r_i_min < rows)
+                                 ? data + r_i_min * cols
+                                 : zero_row.data();
+      const float* row_max = (r_i_max >= 0 && r_i_max < rows)
+                                 ? data + r_i_max * cols
+                                 : zero_row.data();
+      float* resampled_row = resampled + r * new_cols;
+
+      const auto interpolate = [&](const int c,
+                                   const float value_min_min,
+                                   const float value_min_max,
+                                   const float value_max_min,
+                                   const float value_max_max) {
+        // Interpolation in column direction.
+        const float value1 =
+            d_c_maxs[c] * value_min_min + d_c_mins[c] * value_min_max;
+        const float value2 =
+            d_c_maxs[c] * value_max_min + d_c_mins[c] * value_max_max;
+        // Interpolation in row direction.
+        resampled_row[c] = d_r_max * value1 + d_r_min * value2;
+      };
+
+      const auto interpolate_border = [&](const int c) {
+        const int c_i_min = c_i_mins[c];
+        const int c_i_max = c_i_min + 1;
+        interpolate(c,
+                    GetPixelConstantBorder(row_min, 1, cols, 0, c_i_min),
+                    GetPixelConstantBorder(row_min, 1, cols, 0, c_i_max),
+                    GetPixelConstantBorder(row_max, 1, cols, 0, c_i_min),
+                    GetPixelConstantBorder(row_max, 1, cols, 0, c_i_max));
+      };
+
+      for (int c = 0; c < c_inner_begin; ++c) {
+        interpolate_border(c);
+      }
+      for (int c = c_inner_begin; c < c_inner_end; ++c) {
+        const int c_i_min = c_i_mins[c];
+        interpolate(c,
+                    row_min[c_i_min],
+                    row_min[c_i_min + 1],
+                    row_max[c_i_min],
+                    row_max[c_i_min + 1]);
+      }
+      for (int c = c_inner_end; c < new_cols; ++c) {
+        interpolate_border(c);
+      }
+    }
+  });
 }
 
 void SmoothImage(const float* data,
@@ -31,6 +31,12 @@
 
 #include "colmap/scene/camera.h"
 #include "colmap/sensor/bitmap.h"
+#include "colmap/util/eigen_alignment.h"
+
+#include <optional>
+#include <vector>
+
+#include <Eigen/Core>
 
 namespace colmap {
 
@@ -42,6 +48,53 @@ void WarpImageBetweenCameras(const Camera& source_camera,
                              const Bitmap& source_image,
                              Bitmap* target_image);
 
+// Precomputed warp from a target camera to a source camera, which warps
+// images like WarpImageBetweenCameras and can be reused for all images of the
+// same camera pair. Unprojecting through a camera model with distortion is
+// iterative and dominates the cost of warping every pixel. The map stores the
+// exact source pixel positions on a regular grid of the target image and
+// bilinearly interpolates in between. During construction, the interpolation
+// error is measured at the center of each grid cell. Cells exceeding the
+// maximum error and cells with an invalid corner fall back to the exact warp.
+class CameraWarpMap {
+ public:
+  // @param grid_step   Grid spacing in pixels.
+  // @param max_error   Maximum interpolation error in source image pixels. If
+  //                    negative, all pixels are warped exactly.
+  CameraWarpMap(const Camera& source_camera,
+                const Camera& target_camera,
+                int grid_step = 8,
+                double max_error = 0.01);
+
+  inline const Camera& SourceCamera() const;
+  inline const Camera& TargetCamera() const;
+
+  // Warp source image to target image, equivalent to WarpImageBetweenCameras
+  // up to the maximum error. The function allocates the target image.
+  void Warp(const Bitmap& source_image, Bitmap* target_image) const;
+
+  // Fraction of grid cells that are interpolated rather than falling back to
+  // the exact warp.
+  double InterpolatedCellRatio() const;
+
+ private:
+  std::optional<Eigen::Vector2d> SourceFromTarget(int x, int y) const;
+
+  const Camera source_camera_;
+  const Camera target_camera_;
+  // The target camera scaled to the resolution of the source camera, in which
+  // the images are warped before rescaling them to the target resolution.
+  const Camera scaled_target_camera_;
+  const int grid_step_;
+  int num_cells_x_ = 0;
+  int num_cells_y_ = 0;
+  // Source pixel positions of the grid nodes in row-major order with
+  // (num_cells_x_ + 1) columns.
+  std::vector<Eigen::Vector2d> nodes_;
+  // Whether each cell in row-major order can be interpolated.
+  std::vector<char> interpolate_cells_;
+};
+
 // Warp an image with the given homography, where H defines the pixel mapping
 // from the target to source image. Note that the pixel centers are assumed to
 // have coordinates (0.5, 0.5).
@@ -83,4 +136,12 @@ void DownsampleImage(const float* data,
                      int new_cols,
                      float* downsampled);
 
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////////////////////////////////////
+
+const Camera& CameraWarpMap::SourceCamera() const { return source_camera_; }
+
+const Camera& CameraWarpMap::TargetCamera() const { return target_camera_; }
+
 }  // namespace colmap
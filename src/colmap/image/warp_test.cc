@@ -31,6 +31,8 @@
 
 #include "colmap/math/random.h"
 
+#include <cmath>
+
 #include <gtest/gtest.h>
 
 namespace colmap {
@@ -128,6 +130,55 @@ TEST(Warp, ShiftedCameras) {
   }
 }
 
+TEST(CameraWarpMap, IdenticalCameras) {
+  const Camera camera =
+      Camera::CreateFromModelId(1, CameraModelId::kPinhole, 1, 100, 100);
+  const CameraWarpMap warp_map(camera, camera);
+  EXPECT_EQ(warp_map.InterpolatedCellRatio(), 1);
+  const Bitmap source_image = GenerateRandomBitmap(100, 100, true);
+  Bitmap target_image;
+  warp_map.Warp(source_image, &target_image);
+  CheckBitmapsEqual(source_image, target_image);
+}
+
+TEST(CameraWarpMap, Distortion) {
+  Camera source_camera =
+      Camera::CreateFromModelId(1, CameraModelId::kOpenCV, 200, 100, 80);
+  source_camera.params[4] = 0.1;
+  source_camera.params[5] = -0.05;
+  const Camera target_camera =
+      Camera::CreateFromModelId(2, CameraModelId::kPinhole, 200, 100, 80);
+  const Bitmap source_image = GenerateRandomBitmap(100, 80, false);
+
+  Bitmap expected_target_image;
+  WarpImageBetweenCameras(
+      source_camera, target_camera, source_image, &expected_target_image);
+
+  constexpr double kMaxError = 0.01;
+  const CameraWarpMap warp_map(
+      source_camera, target_camera, /*grid_step=*/8, kMaxError);
+  EXPECT_GT(warp_map.InterpolatedCellRatio(), 0.5);
+  Bitmap target_image;
+  warp_map.Warp(source_image, &target_image);
+  ASSERT_EQ(target_image.Width(), expected_target_image.Width());
+  ASSERT_EQ(target_image.Height(), expected_target_image.Height());
+  // The intensity error is bounded by the maximum gradient of the random
+  // image times the position error plus the rounding.
+  for (size_t i = 0; i < target_image.RowMajorData().size(); ++i) {
+    EXPECT_NEAR(target_image.RowMajorData()[i],
+                expected_target_image.RowMajorData()[i],
+                255 * kMaxError + 1);
+  }
+
+  const CameraWarpMap exact_warp_map(source_camera,
+                                     target_camera,
+                                     /*grid_step=*/8,
+                                     /*max_error=*/-1);
+  EXPECT_EQ(exact_warp_map.InterpolatedCellRatio(), 0);
+  exact_warp_map.Warp(source_image, &target_image);
+  EXPECT_EQ(target_image.RowMajorData(), expected_target_image.RowMajorData());
+}
+
 TEST(Warp, WarpImageWithHomographyIdentity) {
   const Bitmap source_image_gray = GenerateRandomBitmap(100, 100, false);
   Bitmap target_image_gray(100, 100, false);
@@ -214,6 +265,46 @@ TEST(Warp, ResampleImageBilinear) {
   EXPECT_EQ(resampled[3], 12.5);
 }
 
+TEST(Warp, ResampleImageBilinearBorder) {
+  const int rows = 7;
+  const int cols = 9;
+  std::vector<float> image(rows * cols);
+  for (size_t i = 0; i < image.size(); ++i) {
+    image[i] = RandomUniformReal<float>(0, 1);
+  }
+
+  const auto get_pixel = [&](const int r, const int c) {
+    return (r >= 0 && c >= 0 && r < rows && c < cols) ? image[r * cols + c]
+                                                      : 0.f;
+  };
+
+  for (const auto& [new_rows, new_cols] :
+       std::vector<std::pair<int, int>>{{3, 4}, {7, 9}, {13, 20}, {1, 1}}) {
+    std::vector<float> resampled(new_rows * new_cols);
+    ResampleImageBilinear(
+        image.data(), rows, cols, new_rows, new_cols, resampled.data());
+
+    const float scale_r = static_cast<float>(rows) / new_rows;
+    const float scale_c = static_cast<float>(cols) / new_cols;
+    for (int r = 0; r < new_rows; ++r) {
+      const float r_i = (r + 0.5f) * scale_r - 0.5f;
+      const int r0 = std::floor(r_i);
+      const float dr = r_i - r0;
+      for (int c = 0; c < new_cols; ++c) {
+        const float c_i = (c + 0.5f) * scale_c - 0.5f;
+        const int c0 = std::floor(c_i);
+        const float dc = c_i - c0;
+        const float expected =
+            (1 - dr) * ((1 - dc) * get_pixel(r0, c0) +
+                        dc * get_pixel(r0, c0 + 1)) +
+            dr * ((1 - dc) * get_pixel(r0 + 1, c0) +
+                  dc * get_pixel(r0 + 1, c0 + 1));
+        EXPECT_NEAR(resampled[r * new_cols + c], expected, 1e-5);
+      }
+    }
+  }
+}
+
 TEST(Warp, SmoothImage) {
   std::vector<float> image(16);
   for (size_t i = 0; i < image.size(); ++i) {
@@ -65,43 +65,41 @@ class MetisGraph {
  public:
   MetisGraph(const std::vector<std::pair<int, int>>& edges,
              const std::vector<int>& weights) {
-    std::unordered_map<int, std::vector<std::pair<int, int>>> adjacency_list;
-    for (size_t i = 0; i < edges.size(); ++i) {
-      const auto& edge = edges[i];
-      const auto weight = weights[i];
-      const int vertex_idx1 = GetVertexIdx(edge.first);
-      const int vertex_idx2 = GetVertexIdx(edge.second);
-      adjacency_list[vertex_idx1].emplace_back(vertex_idx2, weight);
-      adjacency_list[vertex_idx2].emplace_back(vertex_idx1, weight);
+    // Build the adjacency structure in compressed form by counting the degrees
+    // of the vertices, which avoids a separate list per vertex.
+    std::vector<std::pair<int, int>> edge_idxs;
+    edge_idxs.reserve(edges.size());
+    for (const auto& edge : edges) {
+      edge_idxs.emplace_back(GetVertexIdx(edge.first),
+                             GetVertexIdx(edge.second));
     }
 
-    xadj_.reserve(vertex_id_to_idx_.size() + 1);
-    adjncy_.reserve(2 * edges.size());
-    adjwgt_.reserve(2 * edges.size());
-
-    idx_t edge_idx = 0;
-    for (size_t i = 0; i < vertex_id_to_idx_.size(); ++i) {
-      xadj_.push_back(edge_idx);
-
-      if (adjacency_list.count(i) == 0) {
-        continue;
-      }
-
-      for (const auto& [neighbor_idx, weight] : adjacency_list[i]) {
-        edge_idx += 1;
-        adjncy_.push_back(neighbor_idx);
-        adjwgt_.push_back(weight);
-      }
+    const size_t num_vertices = vertex_idx_to_id_.size();
+    xadj_.assign(num_vertices + 1, 0);
+    for (const auto& [vertex_idx1, vertex_idx2] : edge_idxs) {
+      xadj_[vertex_idx1 + 1] += 1;
+      xadj_[vertex_idx2 + 1] += 1;
+    }
+    for (size_t i = 0; i < num_vertices; ++i) {
+      xadj_[i + 1] += xadj_[i];
     }
 
-    xadj_.push_back(edge_idx);
+    adjncy_.resize(2 * edges.size());
+    adjwgt_.resize(2 * edges.size());
+    std::vector<idx_t> next_edge_idxs(xadj_.begin(), xadj_.end() - 1);
+    for (size_t i = 0; i < edge_idxs.size(); ++i) {
+      const auto& [vertex_idx1, vertex_idx2] = edge_idxs[i];
+      const idx_t edge_idx1 = next_edge_idxs[vertex_idx1]++;
+      adjncy_[edge_idx1] = vertex_idx2;
+      adjwgt_[edge_idx1] = weights[i];
+      const idx_t edge_idx2 = next_edge_idxs[vertex_idx2]++;
+      adjncy_[edge_idx2] = vertex_idx1;
+      adjwgt_[edge_idx2] = weights[i];
+    }
 
-    THROW_CHECK_EQ(edge_idx, 2 * edges.size());
-    THROW_CHECK_EQ(xadj_.size(), vertex_id_to_idx_.size() + 1);
-    THROW_CHECK_EQ(adjncy_.size(), 2 * edges.size());
-    THROW_CHECK_EQ(adjwgt_.size(), 2 * edges.size());
+    THROW_CHECK_EQ(xadj_.back(), 2 * edges.size());
 
-    nvtxs = vertex_id_to_idx_.size();
+    nvtxs = num_vertices;
 
     xadj = xadj_.data();
     adjncy = adjncy_.data();
@@ -115,7 +113,7 @@ class MetisGraph {
     if (it == vertex_id_to_idx_.end()) {
       const int idx = vertex_id_to_idx_.size();
       vertex_id_to_idx_.emplace(id, idx);
-      vertex_idx_to_id_.emplace(idx, id);
+      vertex_idx_to_id_.push_back(id);
       return idx;
     } else {
       return it->second;
@@ -132,7 +130,7 @@ class MetisGraph {
 
  private:
   std::unordered_map<int, int> vertex_id_to_idx_;
-  std::unordered_map<int, int> vertex_idx_to_id_;
+  std::vector<int> vertex_idx_to_id_;
   std::vector<idx_t> xadj_;
   std::vector<idx_t> adjncy_;
   std::vector<idx_t> adjwgt_;
@@ -187,33 +185,64 @@ std::unordered_map<int, int> ComputeNormalizedMinGraphCut(
     const std::vector<std::pair<int, int>>& edges,
     const std::vector<int>& weights,
     const int num_parts) {
+  THROW_CHECK_GT(num_parts, 0);
+  return ComputeNormalizedMinGraphCut(
+      edges,
+      weights,
+      std::vector<double>(num_parts, 1.0 / num_parts),
+      /*max_imbalance=*/0);
+}
+
+std::unordered_map<int, int> ComputeNormalizedMinGraphCut(
+    const std::vector<std::pair<int, int>>& edges,
+    const std::vector<int>& weights,
+    const std::vector<double>& part_weights,
+    const double max_imbalance) {
   THROW_CHECK(!edges.empty());
   THROW_CHECK_EQ(edges.size(), weights.size());
-  THROW_CHECK_GT(num_parts, 0);
+  THROW_CHECK(!part_weights.empty());
+  THROW_CHECK(max_imbalance == 0 || max_imbalance >= 1);
 
   MetisGraph graph(edges, weights);
 
   idx_t ncon = 1;
   idx_t edgecut = -1;
-  idx_t nparts = num_parts;
+  idx_t nparts = part_weights.size();
+
+  // Use the default target weights and load imbalance of Metis, if all parts
+  // have the same target weight and no imbalance is given.
+  double part_weight_sum = 0;
+  std::vector<real_t> tpwgts;
+  tpwgts.reserve(part_weights.size());
+  for (const double part_weight : part_weights) {
+    THROW_CHECK_GT(part_weight, 0);
+    part_weight_sum += part_weight;
+  }
+  bool has_uniform_part_weights = true;
+  for (const double part_weight : part_weights) {
+    tpwgts.push_back(static_cast<real_t>(part_weight / part_weight_sum));
+    has_uniform_part_weights &= part_weight == part_weights[0];
+  }
+  real_t ubvec = static_cast<real_t>(max_imbalance);
 
   idx_t metisOptions[METIS_NOPTIONS];
   METIS_SetDefaultOptions(metisOptions);
 
   std::vector<idx_t> cut_labels(graph.nvtxs, -1);
-  const int metisResult = METIS_PartGraphKway(&graph.nvtxs,
-                                              /*ncon=*/&ncon,
-                                              graph.xadj,
-                                              graph.adjncy,
-                                              /*vwgt=*/nullptr,
-                                              /*vsize=*/nullptr,
-                                              graph.adjwgt,
-                                              &nparts,
-                                              /*tpwgts=*/nullptr,
-                                              /*ubvec=*/nullptr,
-                                              metisOptions,
-                                              &edgecut,
-                                              cut_labels.data());
+  const int metisResult = METIS_PartGraphKway(
+      &graph.nvtxs,
+      /*ncon=*/&ncon,
+      graph.xadj,
+      graph.adjncy,
+      /*vwgt=*/nullptr,
+      /*vsize=*/nullptr,
+      graph.adjwgt,
+      &nparts,
+      /*tpwgts=*/has_uniform_part_weights ? nullptr : tpwgts.data(),
+      /*ubvec=*/max_imbalance == 0 ? nullptr : &ubvec,
+      metisOptions,
+      &edgecut,
+      cut_labels.data());
 
   if (metisResult == METIS_ERROR_INPUT) {
     LOG(FATAL_THROW) << "INTERNAL: Metis input error";
@@ -224,6 +253,7 @@ std::unordered_map<int, int> ComputeNormalizedMinGraphCut(
   }
 
   std::unordered_map<int, int> labels;
+  labels.reserve(cut_labels.size());
   for (size_t idx = 0; idx < cut_labels.size(); ++idx) {
     labels.emplace(graph.GetVertexId(idx), cut_labels[idx]);
   }
@@ -64,6 +64,16 @@ std::unordered_map<int, int> ComputeNormalizedMinGraphCut(
     const std::vector<int>& weights,
     int num_parts);
 
+// Variant of the normalized min-cut, where the i-th part receives the
+// fraction part_weights[i] / sum(part_weights) of the vertices. The size of
+// every part may exceed its target by at most the factor max_imbalance, e.g.,
+// 1.03 for 3%, where 0 uses the default tolerance of Metis.
+std::unordered_map<int, int> ComputeNormalizedMinGraphCut(
+    const std::vector<std::pair<int, int>>& edges,
+    const std::vector<int>& weights,
+    const std::vector<double>& part_weights,
+    double max_imbalance);
+
 // Compute the minimum graph cut of a directed S-T graph using the
 // Boykov-Kolmogorov max-flow min-cut algorithm, as descibed in:
 //   "An Experimental Comparison of Min-Cut/Max-Flow Algorithms for Energy
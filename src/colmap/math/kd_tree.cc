@@ -0,0 +1,191 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/math/kd_tree.h"
+
+#include "colmap/util/logging.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace colmap {
+namespace {
+
+// Maximum number of points in a leaf node.
+constexpr size_t kMaxLeafSize = 8;
+
+bool CompareNeighbors(const KdTree::Neighbor& neighbor1,
+                      const KdTree::Neighbor& neighbor2) {
+  return neighbor1.second < neighbor2.second ||
+         (neighbor1.second == neighbor2.second &&
+          neighbor1.first < neighbor2.first);
+}
+
+}  // namespace
+
+KdTree::KdTree(std::vector<Eigen::Vector3d> points)
+    : points_(std::move(points)) {
+  point_idxs_.resize(points_.size());
+  std::iota(point_idxs_.begin(), point_idxs_.end(), 0);
+  if (!points_.empty()) {
+    nodes_.reserve(2 * points_.size() / kMaxLeafSize + 1);
+    BuildNode(0, points_.size());
+  }
+}
+
+size_t KdTree::BuildNode(const size_t begin, const size_t end) {
+  const size_t node_idx = nodes_.size();
+  nodes_.emplace_back();
+  nodes_[node_idx].begin = begin;
+  nodes_[node_idx].end = end;
+  if (end - begin <= kMaxLeafSize) {
+    return node_idx;
+  }
+
+  // Split along the dimension with the largest extent at the median.
+  Eigen::Vector3d min_bound = points_[point_idxs_[begin]];
+  Eigen::Vector3d max_bound = min_bound;
+  for (size_t i = begin + 1; i < end; ++i) {
+    min_bound = min_bound.cwiseMin(points_[point_idxs_[i]]);
+    max_bound = max_bound.cwiseMax(points_[point_idxs_[i]]);
+  }
+  int split_dim = 0;
+  (max_bound - min_bound).maxCoeff(&split_dim);
+
+  const size_t mid = begin + (end - begin) / 2;
+  std::nth_element(point_idxs_.begin() + begin,
+                   point_idxs_.begin() + mid,
+                   point_idxs_.begin() + end,
+                   [this, split_dim](const size_t idx1, const size_t idx2) {
+                     return points_[idx1](split_dim) < points_[idx2](split_dim);
+                   });
+
+  nodes_[node_idx].split_dim = split_dim;
+  nodes_[node_idx].split_value = points_[point_idxs_[mid]](split_dim);
+  const size_t left = BuildNode(begin, mid);
+  const size_t right = BuildNode(mid, end);
+  nodes_[node_idx].left = left;
+  nodes_[node_idx].right = right;
+  return node_idx;
+}
+
+void KdTree::KnnSearch(const Eigen::Vector3d& query,
+                       const int k,
+                       std::vector<Neighbor>* neighbors,
+                       const double max_distance) const {
+  THROW_CHECK_NOTNULL(neighbors);
+  THROW_CHECK_GE(k, 0);
+  THROW_CHECK_GE(max_distance, 0);
+  neighbors->clear();
+  if (nodes_.empty() || k == 0) {
+    return;
+  }
+  neighbors->reserve(k);
+  double max_squared_distance = max_distance * max_distance;
+  KnnSearchNode(0, query, k, &max_squared_distance, neighbors);
+  std::sort(neighbors->begin(), neighbors->end(), CompareNeighbors);
+}
+
+void KdTree::KnnSearchNode(const size_t node_idx,
+                           const Eigen::Vector3d& query,
+                           const size_t k,
+                           double* max_squared_distance,
+                           std::vector<Neighbor>* heap) const {
+  const Node& node = nodes_[node_idx];
+  if (node.split_dim == -1) {
+    for (size_t i = node.begin; i < node.end; ++i) {
+      const size_t point_idx = point_idxs_[i];
+      const double squared_distance = (points_[point_idx] - query).squaredNorm();
+      if (squared_distance > *max_squared_distance) {
+        continue;
+      }
+      const Neighbor neighbor(point_idx, squared_distance);
+      if (heap->size() < k) {
+        heap->push_back(neighbor);
+        std::push_heap(heap->begin(), heap->end(), CompareNeighbors);
+      } else if (CompareNeighbors(neighbor, heap->front())) {
+        std::pop_heap(heap->begin(), heap->end(), CompareNeighbors);
+        heap->back() = neighbor;
+        std::push_heap(heap->begin(), heap->end(), CompareNeighbors);
+      }
+      if (heap->size() == k) {
+        *max_squared_distance = heap->front().second;
+      }
+    }
+    return;
+  }
+
+  const double diff = query(node.split_dim) - node.split_value;
+  const size_t near_node_idx = diff < 0 ? node.left : node.right;
+  const size_t far_node_idx = diff < 0 ? node.right : node.left;
+  KnnSearchNode(near_node_idx, query, k, max_squared_distance, heap);
+  if (diff * diff <= *max_squared_distance) {
+    KnnSearchNode(far_node_idx, query, k, max_squared_distance, heap);
+  }
+}
+
+void KdTree::RadiusSearch(const Eigen::Vector3d& query,
+                          const double radius,
+                          std::vector<Neighbor>* neighbors) const {
+  THROW_CHECK_NOTNULL(neighbors);
+  THROW_CHECK_GE(radius, 0);
+  neighbors->clear();
+  if (nodes_.empty()) {
+    return;
+  }
+  RadiusSearchNode(0, query, radius * radius, neighbors);
+  std::sort(neighbors->begin(), neighbors->end(), CompareNeighbors);
+}
+
+void KdTree::RadiusSearchNode(const size_t node_idx,
+                              const Eigen::Vector3d& query,
+                              const double squared_radius,
+                              std::vector<Neighbor>* neighbors) const {
+  const Node& node = nodes_[node_idx];
+  if (node.split_dim == -1) {
+    for (size_t i = node.begin; i < node.end; ++i) {
+      const size_t point_idx = point_idxs_[i];
+      const double squared_distance = (points_[point_idx] - query).squaredNorm();
+      if (squared_distance <= squared_radius) {
+        neighbors->emplace_back(point_idx, squared_distance);
+      }
+    }
+    return;
+  }
+
+  const double diff = query(node.split_dim) - node.split_value;
+  const size_t near_node_idx = diff < 0 ? node.left : node.right;
+  const size_t far_node_idx = diff < 0 ? node.right : node.left;
+  RadiusSearchNode(near_node_idx, query, squared_radius, neighbors);
+  if (diff * diff <= squared_radius) {
+    RadiusSearchNode(far_node_idx, query, squared_radius, neighbors);
+  }
+}
+
+}  // namespace colmap
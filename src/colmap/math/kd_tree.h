@@ -0,0 +1,98 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace colmap {
+
+// Static kd-tree over 3D points for exact nearest neighbor and radius queries.
+// The queries are const and can be run concurrently from multiple threads.
+class KdTree {
+ public:
+  // Pair of point index and squared distance to the query.
+  using Neighbor = std::pair<size_t, double>;
+
+  KdTree() = default;
+  explicit KdTree(std::vector<Eigen::Vector3d> points);
+
+  inline size_t NumPoints() const { return points_.size(); }
+
+  // Find the (at most) k nearest points within the maximum distance, sorted by
+  // increasing distance to the query.
+  void KnnSearch(
+      const Eigen::Vector3d& query,
+      int k,
+      std::vector<Neighbor>* neighbors,
+      double max_distance = std::numeric_limits<double>::infinity()) const;
+
+  // Find all points within the given radius, sorted by increasing distance to
+  // the query.
+  void RadiusSearch(const Eigen::Vector3d& query,
+                    double radius,
+                    std::vector<Neighbor>* neighbors) const;
+
+ private:
+  struct Node {
+    // Range of the node's points in point_idxs_.
+    size_t begin = 0;
+    size_t end = 0;
+    // Split dimension and value for inner nodes, -1 for leaf nodes.
+    int split_dim = -1;
+    double split_value = 0;
+    // Indices of the child nodes.
+    size_t left = 0;
+    size_t right = 0;
+  };
+
+  size_t BuildNode(size_t begin, size_t end);
+
+  void KnnSearchNode(size_t node_idx,
+                     const Eigen::Vector3d& query,
+                     size_t k,
+                     double* max_squared_distance,
+                     std::vector<Neighbor>* heap) const;
+
+  void RadiusSearchNode(size_t node_idx,
+                        const Eigen::Vector3d& query,
+                        double squared_radius,
+                        std::vector<Neighbor>* neighbors) const;
+
+  std::vector<Eigen::Vector3d> points_;
+  std::vector<size_t> point_idxs_;
+  std::vector<Node> nodes_;
+};
+
+}  // namespace colmap
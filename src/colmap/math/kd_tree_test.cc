@@ -0,0 +1,137 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/math/kd_tree.h"
+
+#include "colmap/math/random.h"
+
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+std::vector<KdTree::Neighbor> BruteForceSearch(
+    const std::vector<Eigen::Vector3d>& points,
+    const Eigen::Vector3d& query,
+    const size_t k,
+    const double max_distance) {
+  std::vector<KdTree::Neighbor> neighbors;
+  for (size_t i = 0; i < points.size(); ++i) {
+    const double squared_distance = (points[i] - query).squaredNorm();
+    if (squared_distance <= max_distance * max_distance) {
+      neighbors.emplace_back(i, squared_distance);
+    }
+  }
+  std::sort(neighbors.begin(),
+            neighbors.end(),
+            [](const KdTree::Neighbor& neighbor1,
+               const KdTree::Neighbor& neighbor2) {
+              return neighbor1.second < neighbor2.second ||
+                     (neighbor1.second == neighbor2.second &&
+                      neighbor1.first < neighbor2.first);
+            });
+  neighbors.resize(std::min(neighbors.size(), k));
+  return neighbors;
+}
+
+std::vector<Eigen::Vector3d> RandomPoints(const int num_points) {
+  std::vector<Eigen::Vector3d> points(num_points);
+  for (auto& point : points) {
+    point = Eigen::Vector3d(RandomUniformReal(-10.0, 10.0),
+                            RandomUniformReal(-10.0, 10.0),
+                            RandomUniformReal(-1.0, 1.0));
+  }
+  return points;
+}
+
+TEST(KdTree, Empty) {
+  KdTree kd_tree;
+  EXPECT_EQ(kd_tree.NumPoints(), 0);
+  std::vector<KdTree::Neighbor> neighbors = {{0, 0}};
+  kd_tree.KnnSearch(Eigen::Vector3d::Zero(), 3, &neighbors);
+  EXPECT_TRUE(neighbors.empty());
+  neighbors = {{0, 0}};
+  kd_tree.RadiusSearch(Eigen::Vector3d::Zero(), 1, &neighbors);
+  EXPECT_TRUE(neighbors.empty());
+}
+
+TEST(KdTree, KnnSearch) {
+  SetPRNGSeed(0);
+  const std::vector<Eigen::Vector3d> points = RandomPoints(1000);
+  const KdTree kd_tree(points);
+  EXPECT_EQ(kd_tree.NumPoints(), points.size());
+
+  std::vector<KdTree::Neighbor> neighbors;
+  for (const auto& query : RandomPoints(100)) {
+    for (const int k : {1, 5, 50}) {
+      kd_tree.KnnSearch(query, k, &neighbors);
+      EXPECT_EQ(neighbors,
+                BruteForceSearch(points,
+                                 query,
+                                 k,
+                                 std::numeric_limits<double>::infinity()));
+      kd_tree.KnnSearch(query, k, &neighbors, /*max_distance=*/1.5);
+      EXPECT_EQ(neighbors, BruteForceSearch(points, query, k, 1.5));
+    }
+  }
+}
+
+TEST(KdTree, RadiusSearch) {
+  SetPRNGSeed(0);
+  const std::vector<Eigen::Vector3d> points = RandomPoints(1000);
+  const KdTree kd_tree(points);
+
+  std::vector<KdTree::Neighbor> neighbors;
+  for (const auto& query : RandomPoints(100)) {
+    for (const double radius : {0.0, 0.5, 2.0}) {
+      kd_tree.RadiusSearch(query, radius, &neighbors);
+      EXPECT_EQ(neighbors,
+                BruteForceSearch(points, query, points.size(), radius));
+    }
+  }
+}
+
+TEST(KdTree, DuplicatePoints) {
+  const std::vector<Eigen::Vector3d> points(20, Eigen::Vector3d(1, 2, 3));
+  const KdTree kd_tree(points);
+  std::vector<KdTree::Neighbor> neighbors;
+  kd_tree.KnnSearch(Eigen::Vector3d(1, 2, 3), 3, &neighbors);
+  ASSERT_EQ(neighbors.size(), 3);
+  for (size_t i = 0; i < neighbors.size(); ++i) {
+    EXPECT_EQ(neighbors[i].first, i);
+    EXPECT_EQ(neighbors[i].second, 0);
+  }
+  kd_tree.RadiusSearch(Eigen::Vector3d(1, 2, 3.5), 1, &neighbors);
+  EXPECT_EQ(neighbors.size(), points.size());
+}
+
+}  // namespace
+}  // namespace colmap
@@ -61,6 +61,16 @@ Eigen::VectorXd RemoveTrailingZeros(const Eigen::VectorXd& coeffs) {
 
 }  // namespace
 
+Eigen::ArrayXd EvaluatePolynomialBatch(
+    const Eigen::Ref<const Eigen::VectorXd>& coeffs,
+    const Eigen::Ref<const Eigen::ArrayXd>& x) {
+  Eigen::ArrayXd values = Eigen::ArrayXd::Zero(x.size());
+  for (Eigen::VectorXd::Index i = 0; i < coeffs.size(); ++i) {
+    values = values * x + coeffs(i);
+  }
+  return values;
+}
+
 bool FindLinearPolynomialRoots(const Eigen::VectorXd& coeffs,
                                Eigen::VectorXd* real,
                                Eigen::VectorXd* imag) {
@@ -51,6 +51,13 @@ namespace colmap {
 template <typename T>
 T EvaluatePolynomial(const Eigen::VectorXd& coeffs, const T& x);
 
+// Evaluate the polynomial for the given coefficients at all points x at once.
+// The Horner scheme then operates on whole arrays, which vectorizes over the
+// evaluated points, e.g., when substituting multiple roots into a solver.
+Eigen::ArrayXd EvaluatePolynomialBatch(
+    const Eigen::Ref<const Eigen::VectorXd>& coeffs,
+    const Eigen::Ref<const Eigen::ArrayXd>& x);
+
 // Find the root of polynomials of the form: a * x + b = 0.
 // The real and/or imaginary variable may be NULL if the output is not needed.
 bool FindLinearPolynomialRoots(const Eigen::VectorXd& coeffs,
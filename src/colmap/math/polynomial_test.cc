@@ -61,6 +61,18 @@ TEST(EvaluatePolynomial, Nominal) {
       1e-6);
 }
 
+TEST(EvaluatePolynomialBatch, Nominal) {
+  const Eigen::VectorXd coeffs =
+      (Eigen::VectorXd(5) << 1, -3, 3, -5, 10).finished();
+  const Eigen::ArrayXd x = (Eigen::ArrayXd(4) << -1.5, 0, 1, 2.5).finished();
+  const Eigen::ArrayXd values = EvaluatePolynomialBatch(coeffs, x);
+  ASSERT_EQ(values.size(), x.size());
+  for (Eigen::Index i = 0; i < x.size(); ++i) {
+    EXPECT_NEAR(values(i), EvaluatePolynomial(coeffs, x(i)), 1e-12);
+  }
+  EXPECT_EQ(EvaluatePolynomialBatch(coeffs, Eigen::ArrayXd()).size(), 0);
+}
+
 TEST(FindLinearPolynomialRoots, Nominal) {
   Eigen::VectorXd real;
   Eigen::VectorXd imag;
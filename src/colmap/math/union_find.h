@@ -29,9 +29,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace colmap {
 
@@ -91,4 +95,77 @@ class UnionFind {
   std::unordered_map<T, T> parent_;
 };
 
+// Lock-free union-find over the dense element range [0, num_elements), which
+// supports concurrent Find and Union calls from multiple threads. Sets are
+// always linked under their smallest element, so the resulting roots do not
+// depend on the order in which the unions are performed.
+class ConcurrentUnionFind {
+ public:
+  explicit ConcurrentUnionFind(uint32_t num_elements)
+      : parent_(num_elements) {
+    for (uint32_t i = 0; i < num_elements; ++i) {
+      parent_[i].store(i, std::memory_order_relaxed);
+    }
+  }
+
+  uint32_t NumElements() const { return parent_.size(); }
+
+  // Find the root of the element x. Uses path halving, which is safe under
+  // concurrent modification, as parents only ever move closer to the root.
+  uint32_t Find(uint32_t x) {
+    while (true) {
+      uint32_t parent = parent_[x].load(std::memory_order_relaxed);
+      if (parent == x) {
+        return x;
+      }
+      const uint32_t grand_parent =
+          parent_[parent].load(std::memory_order_relaxed);
+      if (parent != grand_parent) {
+        parent_[x].compare_exchange_weak(
+            parent, grand_parent, std::memory_order_relaxed);
+      }
+      x = grand_parent;
+    }
+  }
+
+  // Unite the sets containing x and y.
+  void Union(uint32_t x, uint32_t y) {
+    while (true) {
+      x = Find(x);
+      y = Find(y);
+      if (x == y) {
+        return;
+      }
+      if (x < y) {
+        std::swap(x, y);
+      }
+      // Link the larger root under the smaller one. Retry if another thread
+      // linked x in the meantime, such that it is no longer a root.
+      uint32_t expected = x;
+      if (parent_[x].compare_exchange_strong(expected, y)) {
+        return;
+      }
+    }
+  }
+
+  // Make every element point directly to its root. Must not be called
+  // concurrently with Union. Runs in a single linear pass, because parents
+  // always have smaller indices than their children.
+  void Compress() {
+    for (uint32_t i = 0; i < parent_.size(); ++i) {
+      const uint32_t parent = parent_[i].load(std::memory_order_relaxed);
+      parent_[i].store(parent_[parent].load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+    }
+  }
+
+  // Parent of the element x, which is its root after calling Compress().
+  uint32_t Parent(uint32_t x) const {
+    return parent_[x].load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::vector<std::atomic<uint32_t>> parent_;
+};
+
 }  // namespace colmap
@@ -29,6 +29,9 @@
 
 #include "colmap/math/union_find.h"
 
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 namespace colmap {
@@ -308,5 +311,59 @@ TEST(UnionFind, ParentsGroupByRoot) {
   EXPECT_EQ(groups[uf.Find(10)].size(), 2);
 }
 
+TEST(ConcurrentUnionFind, Nominal) {
+  ConcurrentUnionFind uf(8);
+  EXPECT_EQ(uf.NumElements(), 8);
+  for (uint32_t i = 0; i < 8; ++i) {
+    EXPECT_EQ(uf.Find(i), i);
+  }
+
+  uf.Union(5, 3);
+  uf.Union(7, 5);
+  uf.Union(6, 1);
+  uf.Union(3, 3);
+
+  // Sets are linked under their smallest element.
+  EXPECT_EQ(uf.Find(7), 3);
+  EXPECT_EQ(uf.Find(5), 3);
+  EXPECT_EQ(uf.Find(6), 1);
+  EXPECT_EQ(uf.Find(0), 0);
+  EXPECT_NE(uf.Find(3), uf.Find(1));
+
+  uf.Union(7, 6);
+  uf.Compress();
+  const std::vector<uint32_t> expected_parents = {0, 1, 2, 1, 4, 1, 1, 1};
+  for (uint32_t i = 0; i < 8; ++i) {
+    EXPECT_EQ(uf.Parent(i), expected_parents[i]);
+  }
+}
+
+TEST(ConcurrentUnionFind, MultiThreaded) {
+  constexpr uint32_t kNumElements = 10000;
+  constexpr uint32_t kNumSets = 7;
+  constexpr int kNumThreads = 4;
+  ConcurrentUnionFind uf(kNumElements);
+
+  // Each thread unites a strided subset of the elements with the next element
+  // of the same residue class, such that the threads race on shared sets.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&uf, t]() {
+      for (uint32_t i = t; i + kNumSets < kNumElements; i += kNumThreads) {
+        uf.Union(i + kNumSets, i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  uf.Compress();
+  for (uint32_t i = 0; i < kNumElements; ++i) {
+    EXPECT_EQ(uf.Parent(i), i % kNumSets);
+    EXPECT_EQ(uf.Find(i), i % kNumSets);
+  }
+}
+
 }  // namespace
 }  // namespace colmap
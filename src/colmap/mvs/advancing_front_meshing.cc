@@ -52,10 +52,12 @@
 #include "colmap/util/timer.h"
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstdint>
 #include <limits>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <CGAL/AABB_face_graph_triangle_primitive.h>
@@ -529,18 +531,30 @@ struct BlockGrid {
   int nx, ny, nz;
 
   // Total number of blocks in the grid.
-  int NumBlocks() const { return nx * ny * nz; }
+  int64_t NumBlocks() const { return static_cast<int64_t>(nx) * ny * nz; }
 
   // Convert 3D block coordinates to a flat index.
-  int BlockIndex(int bx, int by, int bz) const {
-    return bx * ny * nz + by * nz + bz;
+  int64_t BlockIndex(int bx, int by, int bz) const {
+    return (static_cast<int64_t>(bx) * ny + by) * nz + bz;
   }
 
   // Convert a flat block index back to 3D block coordinates.
-  void BlockCoords(int block_idx, int& bx, int& by, int& bz) const {
-    bx = block_idx / (ny * nz);
-    by = (block_idx % (ny * nz)) / nz;
-    bz = block_idx % nz;
+  void BlockCoords(int64_t block_idx, int& bx, int& by, int& bz) const {
+    bx = static_cast<int>(block_idx / (static_cast<int64_t>(ny) * nz));
+    by = static_cast<int>((block_idx / nz) % ny);
+    bz = static_cast<int>(block_idx % nz);
+  }
+
+  // Compute the core region of a block without overlap. Every point of the
+  // grid's bounding box lies in exactly one half-open core region.
+  Eigen::AlignedBox3d BlockCoreBox(int bx, int by, int bz) const {
+    return Eigen::AlignedBox3d(
+        Eigen::Vector3d(min.x() + bx * block_size,
+                        min.y() + by * block_size,
+                        min.z() + bz * block_size),
+        Eigen::Vector3d(min.x() + (bx + 1) * block_size,
+                        min.y() + (by + 1) * block_size,
+                        min.z() + (bz + 1) * block_size));
   }
 
   // Compute the axis-aligned bounding box for a block, including overlap.
@@ -554,6 +568,11 @@ struct BlockGrid {
   }
 };
 
+// Spatial hash from the flat index of the non-empty blocks to the indices of
+// their points or rays, so that memory scales with the number of occupied
+// blocks instead of the volume of the grid.
+using BlockIndexMap = std::unordered_map<int64_t, std::vector<size_t>>;
+
 BlockGrid ComputeBlockGrid(const std::vector<colmap::PlyPoint>& points,
                            const double block_size,
                            const double block_overlap) {
@@ -572,12 +591,12 @@ BlockGrid ComputeBlockGrid(const std::vector<colmap::PlyPoint>& points,
   return grid;
 }
 
-std::vector<std::vector<size_t>> AssignPointsToBlocks(
+BlockIndexMap AssignPointsToBlocks(
     const std::vector<colmap::PlyPoint>& points, const BlockGrid& grid) {
   const Eigen::Vector3i grid_dims(grid.nx, grid.ny, grid.nz);
   const double inv_block_size = 1.0 / grid.block_size;
 
-  std::vector<std::vector<size_t>> block_point_indices(grid.NumBlocks());
+  BlockIndexMap block_point_indices;
   for (size_t i = 0; i < points.size(); ++i) {
     const Eigen::Vector3d rel(points[i].x - grid.min.x(),
                               points[i].y - grid.min.y(),
@@ -604,9 +623,9 @@ std::vector<std::vector<size_t>> AssignPointsToBlocks(
   return block_point_indices;
 }
 
-std::vector<std::vector<size_t>> AssignRaysToBlocks(
+BlockIndexMap AssignRaysToBlocks(
     const std::vector<K::Segment_3>& rays,
-    const std::vector<std::vector<size_t>>& block_point_indices,
+    const BlockIndexMap& block_point_indices,
     const BlockGrid& grid) {
   // For each ray, compute the range of blocks its AABB overlaps with,
   // then do an exact segment-box intersection test only on those blocks.
@@ -614,7 +633,7 @@ std::vector<std::vector<size_t>> AssignRaysToBlocks(
   const Eigen::Vector3i grid_dims(grid.nx, grid.ny, grid.nz);
   const double inv_block_size = 1.0 / grid.block_size;
 
-  std::vector<std::vector<size_t>> block_ray_indices(grid.NumBlocks());
+  BlockIndexMap block_ray_indices;
   const size_t log_interval = std::max(rays.size() / 10, size_t{1});
   for (size_t ray_idx = 0; ray_idx < rays.size(); ++ray_idx) {
     if (ray_idx % log_interval == 0) {
@@ -648,8 +667,8 @@ std::vector<std::vector<size_t>> AssignRaysToBlocks(
     for (int bx = b_min.x(); bx <= b_max.x(); ++bx) {
       for (int by = b_min.y(); by <= b_max.y(); ++by) {
         for (int bz = b_min.z(); bz <= b_max.z(); ++bz) {
-          const int idx = grid.BlockIndex(bx, by, bz);
-          if (block_point_indices[idx].empty()) {
+          const int64_t idx = grid.BlockIndex(bx, by, bz);
+          if (block_point_indices.count(idx) == 0) {
             continue;
           }
           if (CGAL::do_intersect(seg, grid.BlockBbox(bx, by, bz))) {
@@ -673,6 +692,7 @@ std::vector<K::Segment_3> GatherBlockRays(
   return block_rays;
 }
 
+// Keep the faces whose centroid lies inside the half-open crop box.
 colmap::PlyMesh CropMeshToRegion(const colmap::PlyMesh& mesh,
                                  const Eigen::AlignedBox3d& crop_box) {
   colmap::PlyMesh cropped;
@@ -695,7 +715,8 @@ colmap::PlyMesh CropMeshToRegion(const colmap::PlyMesh& mesh,
     const Eigen::Vector3d centroid((v0.x + v1.x + v2.x) / 3.0,
                                    (v0.y + v1.y + v2.y) / 3.0,
                                    (v0.z + v1.z + v2.z) / 3.0);
-    if (crop_box.contains(centroid)) {
+    if ((centroid.array() >= crop_box.min().array()).all() &&
+        (centroid.array() < crop_box.max().array()).all()) {
       cropped.faces.emplace_back(remap_vertex(face.vertex_idx1),
                                  remap_vertex(face.vertex_idx2),
                                  remap_vertex(face.vertex_idx3));
@@ -704,6 +725,134 @@ colmap::PlyMesh CropMeshToRegion(const colmap::PlyMesh& mesh,
   return cropped;
 }
 
+// Merge the cropped meshes of all blocks into a single mesh. Neighboring
+// blocks triangulate the same input points in their overlap, so vertices at
+// identical positions are welded into one. Faces that touch a vertex shared
+// by multiple blocks are border faces, where the independently grown fronts
+// of the blocks may conflict. These are accepted greedily in order of their
+// circumradius, mirroring the priority of the advancing front, and rejected
+// if they duplicate an accepted face or would make an edge non-manifold.
+colmap::PlyMesh MergeBlockMeshes(
+    const std::vector<colmap::PlyMesh>& block_meshes) {
+  using Position = std::array<float, 3>;
+
+  colmap::PlyMesh merged_mesh;
+  std::unordered_map<Position, size_t, boost::hash<Position>> vertex_idx_map;
+  // The index of the block that first added the vertex, or -1 if the vertex
+  // is shared by multiple blocks.
+  std::vector<int> vertex_blocks;
+  std::vector<std::array<size_t, 3>> faces;
+  for (size_t block_idx = 0; block_idx < block_meshes.size(); ++block_idx) {
+    const colmap::PlyMesh& block_mesh = block_meshes[block_idx];
+    std::vector<size_t> merged_vertex_idxs(block_mesh.vertices.size());
+    for (size_t i = 0; i < block_mesh.vertices.size(); ++i) {
+      const auto& vertex = block_mesh.vertices[i];
+      const auto [it, inserted] = vertex_idx_map.emplace(
+          Position{vertex.x, vertex.y, vertex.z}, merged_mesh.vertices.size());
+      if (inserted) {
+        merged_mesh.vertices.push_back(vertex);
+        vertex_blocks.push_back(static_cast<int>(block_idx));
+      } else if (vertex_blocks[it->second] != static_cast<int>(block_idx)) {
+        vertex_blocks[it->second] = -1;
+      }
+      merged_vertex_idxs[i] = it->second;
+    }
+    for (const auto& face : block_mesh.faces) {
+      faces.push_back({merged_vertex_idxs[face.vertex_idx1],
+                       merged_vertex_idxs[face.vertex_idx2],
+                       merged_vertex_idxs[face.vertex_idx3]});
+    }
+  }
+  vertex_idx_map.clear();
+
+  const auto IsBorderFace = [&](const std::array<size_t, 3>& face) {
+    return vertex_blocks[face[0]] == -1 || vertex_blocks[face[1]] == -1 ||
+           vertex_blocks[face[2]] == -1;
+  };
+
+  // Only edges between vertices of border faces can be in conflict.
+  std::vector<bool> is_border_vertex(merged_mesh.vertices.size(), false);
+  std::vector<std::pair<double, size_t>> border_faces;
+  for (size_t face_idx = 0; face_idx < faces.size(); ++face_idx) {
+    const std::array<size_t, 3>& face = faces[face_idx];
+    if (!IsBorderFace(face)) {
+      continue;
+    }
+    for (const size_t vertex_idx : face) {
+      is_border_vertex[vertex_idx] = true;
+    }
+    const auto VertexPosition = [&](const size_t vertex_idx) {
+      const auto& vertex = merged_mesh.vertices[vertex_idx];
+      return Eigen::Vector3d(vertex.x, vertex.y, vertex.z);
+    };
+    const Eigen::Vector3d v0 = VertexPosition(face[0]);
+    const Eigen::Vector3d v1 = VertexPosition(face[1]);
+    const Eigen::Vector3d v2 = VertexPosition(face[2]);
+    const double double_area = (v1 - v0).cross(v2 - v0).norm();
+    const double circumradius =
+        double_area > 0 ? (v1 - v0).norm() * (v2 - v1).norm() *
+                              (v0 - v2).norm() / (2 * double_area)
+                        : std::numeric_limits<double>::max();
+    border_faces.emplace_back(circumradius, face_idx);
+  }
+
+  const auto EdgeKey = [](size_t vertex_idx1, size_t vertex_idx2) {
+    if (vertex_idx1 > vertex_idx2) {
+      std::swap(vertex_idx1, vertex_idx2);
+    }
+    return (static_cast<uint64_t>(vertex_idx1) << 32) |
+           static_cast<uint64_t>(vertex_idx2);
+  };
+
+  std::unordered_map<uint64_t, int> edge_num_faces;
+  const auto AddFace = [&](const std::array<size_t, 3>& face) {
+    merged_mesh.faces.emplace_back(face[0], face[1], face[2]);
+    for (int i = 0; i < 3; ++i) {
+      const size_t vertex_idx1 = face[i];
+      const size_t vertex_idx2 = face[(i + 1) % 3];
+      if (is_border_vertex[vertex_idx1] && is_border_vertex[vertex_idx2]) {
+        ++edge_num_faces[EdgeKey(vertex_idx1, vertex_idx2)];
+      }
+    }
+  };
+
+  merged_mesh.faces.reserve(faces.size());
+  for (const auto& face : faces) {
+    if (!IsBorderFace(face)) {
+      AddFace(face);
+    }
+  }
+
+  std::sort(border_faces.begin(), border_faces.end());
+
+  size_t num_rejected_faces = 0;
+  std::unordered_set<std::array<size_t, 3>, boost::hash<std::array<size_t, 3>>>
+      accepted_border_faces;
+  for (const auto& [circumradius, face_idx] : border_faces) {
+    const std::array<size_t, 3>& face = faces[face_idx];
+    std::array<size_t, 3> sorted_face = face;
+    std::sort(sorted_face.begin(), sorted_face.end());
+    bool conflict = sorted_face[0] == sorted_face[1] ||
+                    sorted_face[1] == sorted_face[2] ||
+                    accepted_border_faces.count(sorted_face) > 0;
+    for (int i = 0; i < 3 && !conflict; ++i) {
+      const auto it = edge_num_faces.find(EdgeKey(face[i], face[(i + 1) % 3]));
+      conflict = it != edge_num_faces.end() && it->second >= 2;
+    }
+    if (conflict) {
+      ++num_rejected_faces;
+      continue;
+    }
+    accepted_border_faces.insert(sorted_face);
+    AddFace(face);
+  }
+
+  LOG(INFO) << "Resolved block borders: " << border_faces.size()
+            << " border faces, " << num_rejected_faces << " rejected.";
+
+  return merged_mesh;
+}
+
 // Assign points to spatial blocks and reconstruct each block independently.
 colmap::PlyMesh ReconstructBlocks(
     const std::vector<colmap::PlyPoint>& points,
@@ -723,7 +872,7 @@ colmap::PlyMesh ReconstructBlocks(
   const bool use_vis =
       options.visibility_filtering && !vis_data.cam_positions.empty();
   std::vector<K::Segment_3> all_rays;
-  std::vector<std::vector<size_t>> block_ray_indices(grid.NumBlocks());
+  BlockIndexMap block_ray_indices;
 
   if (use_vis) {
     all_rays = BuildVisibilityRays(points,
@@ -736,25 +885,23 @@ colmap::PlyMesh ReconstructBlocks(
     block_ray_indices = AssignRaysToBlocks(all_rays, block_point_indices, grid);
   }
 
-  colmap::PlyMesh merged_mesh;
-  std::mutex merge_mutex;
-  std::atomic<int> blocks_completed{0};
-  int num_active_blocks = 0;
-  for (int i = 0; i < grid.NumBlocks(); ++i) {
-    if (!block_point_indices[i].empty()) {
-      ++num_active_blocks;
-    }
+  // Process the occupied blocks in a deterministic order.
+  std::vector<int64_t> block_idxs;
+  block_idxs.reserve(block_point_indices.size());
+  for (const auto& [block_idx, indices] : block_point_indices) {
+    block_idxs.push_back(block_idx);
   }
+  std::sort(block_idxs.begin(), block_idxs.end());
+  const int num_active_blocks = static_cast<int>(block_idxs.size());
+
+  std::vector<colmap::PlyMesh> block_meshes(block_idxs.size());
+  std::atomic<int> blocks_completed{0};
 
   const int num_threads = colmap::GetEffectiveNumThreads(options.num_threads);
   colmap::ThreadPool thread_pool(num_threads);
 
-  for (int block_idx = 0; block_idx < grid.NumBlocks(); ++block_idx) {
-    if (block_point_indices[block_idx].empty()) {
-      continue;
-    }
-
-    thread_pool.AddTask([&, block_idx]() {
+  for (size_t i = 0; i < block_idxs.size(); ++i) {
+    thread_pool.AddTask([&, i]() {
       // Disable OMP parallelism within each block task to avoid
       // oversubscription since ThreadPool handles inter-block parallelism.
       omp_set_num_threads(1);
@@ -764,7 +911,8 @@ colmap::PlyMesh ReconstructBlocks(
       omp_set_max_active_levels(1);
 #endif
 
-      const auto& indices = block_point_indices[block_idx];
+      const int64_t block_idx = block_idxs[i];
+      const auto& indices = block_point_indices.at(block_idx);
       std::vector<colmap::PlyPoint> block_points;
       block_points.reserve(indices.size());
       for (const size_t idx : indices) {
@@ -773,24 +921,31 @@ colmap::PlyMesh ReconstructBlocks(
 
       std::vector<K::Segment_3> block_rays;
       if (use_vis) {
-        block_rays = GatherBlockRays(all_rays, block_ray_indices[block_idx]);
+        const auto ray_indices = block_ray_indices.find(block_idx);
+        if (ray_indices != block_ray_indices.end()) {
+          block_rays = GatherBlockRays(all_rays, ray_indices->second);
+        }
       }
 
       const auto block_mesh =
           ReconstructBlock(block_points, block_rays, options);
 
-      // Crop to the core region plus half the overlap as seam margin.
+      // Crop to the core region, so that every face is owned by exactly one
+      // block. The outer blocks own everything beyond the grid.
       int bx, by, bz;
       grid.BlockCoords(block_idx, bx, by, bz);
-      const double margin = grid.overlap * 0.5;
-      const Eigen::AlignedBox3d crop_box(
-          Eigen::Vector3d(grid.min.x() + bx * grid.block_size - margin,
-                          grid.min.y() + by * grid.block_size - margin,
-                          grid.min.z() + bz * grid.block_size - margin),
-          Eigen::Vector3d(grid.min.x() + (bx + 1) * grid.block_size + margin,
-                          grid.min.y() + (by + 1) * grid.block_size + margin,
-                          grid.min.z() + (bz + 1) * grid.block_size + margin));
-      const auto cropped_mesh = CropMeshToRegion(block_mesh, crop_box);
+      Eigen::AlignedBox3d crop_box = grid.BlockCoreBox(bx, by, bz);
+      const Eigen::Vector3i block_coords(bx, by, bz);
+      const Eigen::Vector3i grid_dims(grid.nx, grid.ny, grid.nz);
+      for (int d = 0; d < 3; ++d) {
+        if (block_coords(d) == 0) {
+          crop_box.min()(d) = std::numeric_limits<double>::lowest();
+        }
+        if (block_coords(d) == grid_dims(d) - 1) {
+          crop_box.max()(d) = std::numeric_limits<double>::max();
+        }
+      }
+      block_meshes[i] = CropMeshToRegion(block_mesh, crop_box);
 
       const int completed = blocks_completed.fetch_add(1) + 1;
       LOG(INFO) << colmap::StringPrintf(
@@ -799,23 +954,15 @@ colmap::PlyMesh ReconstructBlocks(
           num_active_blocks,
           block_points.size(),
           block_rays.size(),
-          cropped_mesh.faces.size());
-
-      std::lock_guard<std::mutex> lock(merge_mutex);
-      const size_t vertex_offset = merged_mesh.vertices.size();
-      merged_mesh.vertices.insert(merged_mesh.vertices.end(),
-                                  cropped_mesh.vertices.begin(),
-                                  cropped_mesh.vertices.end());
-      for (const auto& face : cropped_mesh.faces) {
-        merged_mesh.faces.emplace_back(face.vertex_idx1 + vertex_offset,
-                                       face.vertex_idx2 + vertex_offset,
-                                       face.vertex_idx3 + vertex_offset);
-      }
+          block_meshes[i].faces.size());
     });
   }
 
   thread_pool.Wait();
 
+  LOG(INFO) << "Merging " << block_meshes.size() << " block meshes...";
+  colmap::PlyMesh merged_mesh = MergeBlockMeshes(block_meshes);
+
   LOG(INFO) << "Merged mesh: " << merged_mesh.vertices.size() << " vertices, "
             << merged_mesh.faces.size() << " faces.";
 
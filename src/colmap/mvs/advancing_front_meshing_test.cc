@@ -35,7 +35,10 @@
 #include "colmap/util/ply.h"
 #include "colmap/util/testing.h"
 
+#include <array>
 #include <fstream>
+#include <map>
+#include <set>
 
 #if defined(COLMAP_CGAL_ENABLED)
 #include <CGAL/version.h>
@@ -217,6 +220,57 @@ TEST(AdvancingFrontMeshing, BlockWise) {
   EXPECT_GE(mesh.mesh.faces.size(), 1);
 }
 
+TEST(AdvancingFrontMeshing, BlockWiseMergesBorders) {
+  const auto test_dir = CreateTestDir();
+  const auto output_path = test_dir / "mesh.ply";
+
+  std::vector<PlyPoint> ply_points;
+  for (int i = 0; i < 2000; ++i) {
+    const Eigen::Vector3f point3D = Eigen::Vector3f::Random().normalized();
+    PlyPoint ply_point;
+    ply_point.x = point3D.x();
+    ply_point.y = point3D.y();
+    ply_point.z = point3D.z();
+    ply_points.push_back(ply_point);
+  }
+  WriteBinaryPlyPoints(test_dir / "fused.ply",
+                       ply_points,
+                       /*write_normal=*/false,
+                       /*write_rgb=*/true);
+
+  AdvancingFrontMeshingOptions options;
+  options.visibility_filtering = false;
+  options.block_size = 1.0;
+  options.block_overlap = 0.2;
+  options.num_threads = 4;
+
+  AdvancingFrontMeshing(options, test_dir, output_path);
+
+  const auto mesh = ReadPlyMesh(output_path).mesh;
+  EXPECT_GE(mesh.faces.size(), 1);
+
+  // Vertices shared by neighboring blocks are welded.
+  std::set<std::array<float, 3>> positions;
+  for (const auto& vertex : mesh.vertices) {
+    EXPECT_TRUE(positions.insert({vertex.x, vertex.y, vertex.z}).second);
+  }
+
+  // Conflicting faces at the block borders are resolved.
+  std::map<std::pair<size_t, size_t>, int> edge_num_faces;
+  for (const auto& face : mesh.faces) {
+    const std::array<size_t, 3> idxs = {
+        face.vertex_idx1, face.vertex_idx2, face.vertex_idx3};
+    for (int i = 0; i < 3; ++i) {
+      const size_t idx1 = idxs[i];
+      const size_t idx2 = idxs[(i + 1) % 3];
+      ++edge_num_faces[{std::min(idx1, idx2), std::max(idx1, idx2)}];
+    }
+  }
+  for (const auto& [edge, num_faces] : edge_num_faces) {
+    EXPECT_LE(num_faces, 2);
+  }
+}
+
 TEST(AdvancingFrontMeshing, BlockWiseWithVisibility) {
   const auto test_dir = CreateTestDir();
   const auto sparse_path = test_dir / "sparse";
@@ -38,7 +38,11 @@
 #include "colmap/util/file.h"
 #include "colmap/util/logging.h"
 
+#include <array>
 #include <fstream>
+#include <limits>
+#include <map>
+#include <numeric>
 #include <unordered_map>
 #include <vector>
 
@@ -104,6 +108,8 @@ bool DelaunayMeshingOptions::Check() const {
   CHECK_OPTION_GE(max_side_length_factor, 0);
   CHECK_OPTION_GE(max_side_length_percentile, 0);
   CHECK_OPTION_LE(max_side_length_percentile, 100);
+  CHECK_OPTION_GE(max_num_points_per_partition, 0);
+  CHECK_OPTION_GE(partition_overlap, 0);
   CHECK_OPTION_GE(num_threads, -1);
   CHECK_OPTION_NE(num_threads, 0);
   return true;
@@ -133,6 +139,9 @@ class DelaunayMeshingInput {
     uint32_t num_visible_images = 0;
   };
 
+  static constexpr size_t kInvalidPointIdx =
+      std::numeric_limits<size_t>::max();
+
   std::unordered_map<camera_t, Camera> cameras;
   std::vector<Image> images;
   std::vector<Point> points;
@@ -214,6 +223,36 @@ class DelaunayMeshingInput {
     }
   }
 
+  // Extract the subset of points inside the given box. The images keep their
+  // indices and only observe the extracted points.
+  DelaunayMeshingInput ExtractPoints(const Eigen::AlignedBox3f& box) const {
+    DelaunayMeshingInput subset;
+    subset.cameras = cameras;
+
+    std::vector<size_t> point_idx_map(points.size(), kInvalidPointIdx);
+    for (size_t point_idx = 0; point_idx < points.size(); ++point_idx) {
+      if (box.contains(points[point_idx].position)) {
+        point_idx_map[point_idx] = subset.points.size();
+        subset.points.push_back(points[point_idx]);
+      }
+    }
+
+    subset.images.reserve(images.size());
+    for (const auto& image : images) {
+      DelaunayMeshingInput::Image& subset_image = subset.images.emplace_back();
+      subset_image.camera_id = image.camera_id;
+      subset_image.cam_from_world = image.cam_from_world;
+      subset_image.cam_in_world = image.cam_in_world;
+      for (const auto point_idx : image.point_idxs) {
+        if (point_idx_map[point_idx] != kInvalidPointIdx) {
+          subset_image.point_idxs.push_back(point_idx_map[point_idx]);
+        }
+      }
+    }
+
+    return subset;
+  }
+
   Delaunay CreateDelaunayTriangulation() const {
     std::vector<Delaunay::Point> delaunay_points(points.size());
     for (size_t i = 0; i < points.size(); ++i) {
@@ -607,10 +646,97 @@ struct DelaunayCellData {
   std::array<float, 4> edge_weights;
 };
 
-PlyMesh DelaunayMeshing(const DelaunayMeshingOptions& options,
-                        const DelaunayMeshingInput& input_data) {
-  THROW_CHECK(options.Check());
+// Spatial partition of the input points. The boxes of all partitions tile the
+// space without overlap, where the outer partitions extend to infinity.
+struct DelaunayMeshingPartition {
+  Eigen::AlignedBox3f box;
+  std::vector<size_t> point_idxs;
+};
+
+Eigen::AlignedBox3f UnboundedPartitionBox() {
+  return Eigen::AlignedBox3f(
+      Eigen::Vector3f::Constant(-std::numeric_limits<float>::infinity()),
+      Eigen::Vector3f::Constant(std::numeric_limits<float>::infinity()));
+}
+
+// Half-open containment test, such that every position on the shared boundary
+// of two neighboring partitions belongs to exactly one of them.
+bool IsInsidePartition(const Eigen::AlignedBox3f& box,
+                       const Eigen::Vector3f& position) {
+  return (position.array() >= box.min().array()).all() &&
+         (position.array() < box.max().array()).all();
+}
+
+// Recursively split the points at the median of the longest axis of their
+// bounding box until each partition has at most the given number of points.
+void PartitionPoints(const DelaunayMeshingInput& input_data,
+                     const int max_num_points,
+                     DelaunayMeshingPartition partition,
+                     std::vector<DelaunayMeshingPartition>* partitions) {
+  auto& point_idxs = partition.point_idxs;
+  if (point_idxs.size() <= static_cast<size_t>(max_num_points)) {
+    partitions->push_back(std::move(partition));
+    return;
+  }
+
+  Eigen::AlignedBox3f bbox;
+  for (const auto point_idx : point_idxs) {
+    bbox.extend(input_data.points[point_idx].position);
+  }
 
+  int axis;
+  bbox.sizes().maxCoeff(&axis);
+
+  const auto Coordinate = [&](const size_t point_idx) {
+    return input_data.points[point_idx].position(axis);
+  };
+
+  const auto median_it = point_idxs.begin() + point_idxs.size() / 2;
+  std::nth_element(point_idxs.begin(),
+                   median_it,
+                   point_idxs.end(),
+                   [&](const size_t point_idx1, const size_t point_idx2) {
+                     return Coordinate(point_idx1) < Coordinate(point_idx2);
+                   });
+  const float split = Coordinate(*median_it);
+  const auto split_it =
+      std::partition(point_idxs.begin(),
+                     point_idxs.end(),
+                     [&](const size_t point_idx) {
+                       return Coordinate(point_idx) < split;
+                     });
+
+  // All points share the same coordinate and cannot be split any further.
+  if (split_it == point_idxs.begin()) {
+    partitions->push_back(std::move(partition));
+    return;
+  }
+
+  DelaunayMeshingPartition left_partition;
+  left_partition.box = partition.box;
+  left_partition.box.max()(axis) = split;
+  left_partition.point_idxs.assign(point_idxs.begin(), split_it);
+
+  DelaunayMeshingPartition right_partition;
+  right_partition.box = partition.box;
+  right_partition.box.min()(axis) = split;
+  right_partition.point_idxs.assign(split_it, point_idxs.end());
+
+  point_idxs.clear();
+  point_idxs.shrink_to_fit();
+
+  PartitionPoints(
+      input_data, max_num_points, std::move(left_partition), partitions);
+  PartitionPoints(
+      input_data, max_num_points, std::move(right_partition), partitions);
+}
+
+// Computes the surface mesh of the input points and only keeps the faces
+// whose centroid lies inside the given partition box. The returned mesh is
+// not yet filtered for outlier faces.
+PlyMesh ComputeDelaunaySurfaceMesh(const DelaunayMeshingOptions& options,
+                                   const DelaunayMeshingInput& input_data,
+                                   const Eigen::AlignedBox3f& partition_box) {
   // Create a delaunay triangulation of all input points.
   LOG(INFO) << "Triangulating points...";
   const auto triangulation = input_data.CreateSubSampledDelaunayTriangulation(
@@ -838,7 +964,6 @@ PlyMesh DelaunayMeshing(const DelaunayMeshingOptions& options,
 
   std::unordered_set<Delaunay::Vertex_handle> surface_vertices;
   std::vector<Delaunay::Facet> surface_facets;
-  std::vector<float> surface_facet_side_lengths;
 
   for (auto it = triangulation.finite_facets_begin();
        it != triangulation.finite_facets_end();
@@ -858,6 +983,14 @@ PlyMesh DelaunayMeshing(const DelaunayMeshingOptions& options,
       continue;
     }
 
+    // Facets outside of the partition are extracted by a neighboring one.
+    const K::Triangle_3 triangle = triangulation.triangle(*it);
+    const K::Point_3 centroid =
+        CGAL::centroid(triangle[0], triangle[1], triangle[2]);
+    if (!IsInsidePartition(partition_box, CGALToEigen(centroid))) {
+      continue;
+    }
+
     // Remember all unique vertices of the surface mesh.
     for (int i = 0; i < 3; ++i) {
       const auto& vertex =
@@ -865,14 +998,6 @@ PlyMesh DelaunayMeshing(const DelaunayMeshingOptions& options,
       surface_vertices.insert(vertex);
     }
 
-    // Determine maximum side length of facet.
-    const K::Triangle_3 triangle = triangulation.triangle(*it);
-    const float max_squared_side_length =
-        std::max({(triangle[0] - triangle[1]).squared_length(),
-                  (triangle[0] - triangle[2]).squared_length(),
-                  (triangle[1] - triangle[2]).squared_length()});
-    surface_facet_side_lengths.push_back(std::sqrt(max_squared_side_length));
-
     // Remember surface mesh facet and make sure it is oriented correctly.
     if (cell_is_source) {
       surface_facets.push_back(*it);
@@ -895,21 +1020,8 @@ PlyMesh DelaunayMeshing(const DelaunayMeshingOptions& options,
     surface_vertex_indices.emplace(vertex, surface_vertex_indices.size());
   }
 
-  const float max_facet_side_length =
-      options.max_side_length_factor *
-      Percentile(std::vector<float>(surface_facet_side_lengths),
-                 options.max_side_length_percentile);
-
   mesh.faces.reserve(surface_facets.size());
-
-  for (size_t i = 0; i < surface_facets.size(); ++i) {
-    // Note that skipping some of the facets here means that there will be
-    // some unused vertices in the final mesh.
-    if (surface_facet_side_lengths[i] > max_facet_side_length) {
-      continue;
-    }
-
-    const auto& facet = surface_facets[i];
+  for (const auto& facet : surface_facets) {
     mesh.faces.emplace_back(
         surface_vertex_indices.at(facet.first->vertex(
             triangulation.vertex_triple_index(facet.second, 0))),
@@ -922,6 +1034,154 @@ PlyMesh DelaunayMeshing(const DelaunayMeshingOptions& options,
   return mesh;
 }
 
+// Meshes the partitions of the input points in parallel and stitches their
+// surfaces together by merging the vertices at identical positions. Each
+// partition is triangulated with an overlap to its neighbors, such that the
+// graph-cut labels near the partition boundary are constrained by the
+// visibility information of the surrounding points.
+PlyMesh ComputePartitionedDelaunaySurfaceMesh(
+    const DelaunayMeshingOptions& options,
+    const DelaunayMeshingInput& input_data) {
+  DelaunayMeshingPartition root_partition;
+  root_partition.box = UnboundedPartitionBox();
+  root_partition.point_idxs.resize(input_data.points.size());
+  std::iota(root_partition.point_idxs.begin(),
+            root_partition.point_idxs.end(),
+            0);
+
+  std::vector<DelaunayMeshingPartition> partitions;
+  PartitionPoints(input_data,
+                  options.max_num_points_per_partition,
+                  std::move(root_partition),
+                  &partitions);
+
+  LOG(INFO) << StringPrintf("Meshing %zu partitions...", partitions.size());
+
+  const int num_threads = GetEffectiveNumThreads(options.num_threads);
+  ThreadPool thread_pool(
+      std::min(num_threads, static_cast<int>(partitions.size())));
+
+  // Distribute the remaining threads over the partitions meshed in parallel.
+  DelaunayMeshingOptions partition_options = options;
+  partition_options.num_threads = std::max(
+      1, num_threads / static_cast<int>(thread_pool.NumThreads()));
+
+  std::vector<PlyMesh> partition_meshes(partitions.size());
+  for (size_t i = 0; i < partitions.size(); ++i) {
+    thread_pool.AddTask([&, i]() {
+      const auto& partition = partitions[i];
+
+      Eigen::AlignedBox3f overlap_box;
+      for (const auto point_idx : partition.point_idxs) {
+        overlap_box.extend(input_data.points[point_idx].position);
+      }
+      const Eigen::Vector3f overlap =
+          options.partition_overlap * overlap_box.sizes();
+      overlap_box.min() -= overlap;
+      overlap_box.max() += overlap;
+
+      const DelaunayMeshingInput partition_input =
+          input_data.ExtractPoints(overlap_box);
+      if (partition_input.points.size() < 4) {
+        return;
+      }
+
+      partition_meshes[i] = ComputeDelaunaySurfaceMesh(
+          partition_options, partition_input, partition.box);
+    });
+  }
+  thread_pool.Wait();
+
+  LOG(INFO) << "Stitching partition surface meshes...";
+
+  PlyMesh mesh;
+  std::map<std::array<float, 3>, size_t> vertex_indices;
+  for (auto& partition_mesh : partition_meshes) {
+    std::vector<size_t> partition_vertex_indices;
+    partition_vertex_indices.reserve(partition_mesh.vertices.size());
+    for (const auto& vertex : partition_mesh.vertices) {
+      const auto [it, inserted] = vertex_indices.emplace(
+          std::array<float, 3>{vertex.x, vertex.y, vertex.z},
+          mesh.vertices.size());
+      if (inserted) {
+        mesh.vertices.push_back(vertex);
+      }
+      partition_vertex_indices.push_back(it->second);
+    }
+
+    for (const auto& face : partition_mesh.faces) {
+      mesh.faces.emplace_back(partition_vertex_indices[face.vertex_idx1],
+                              partition_vertex_indices[face.vertex_idx2],
+                              partition_vertex_indices[face.vertex_idx3]);
+    }
+
+    partition_mesh = PlyMesh();
+  }
+
+  return mesh;
+}
+
+// Removes outlier faces whose longest side exceeds the given percentile of the
+// longest sides of all faces by the given factor.
+void FilterLongMeshFaces(const DelaunayMeshingOptions& options,
+                         PlyMesh* mesh) {
+  if (mesh->faces.empty()) {
+    return;
+  }
+
+  const auto VertexPosition = [&](const size_t vertex_idx) {
+    const auto& vertex = mesh->vertices[vertex_idx];
+    return Eigen::Vector3f(vertex.x, vertex.y, vertex.z);
+  };
+
+  std::vector<float> face_side_lengths;
+  face_side_lengths.reserve(mesh->faces.size());
+  for (const auto& face : mesh->faces) {
+    const Eigen::Vector3f vertex1 = VertexPosition(face.vertex_idx1);
+    const Eigen::Vector3f vertex2 = VertexPosition(face.vertex_idx2);
+    const Eigen::Vector3f vertex3 = VertexPosition(face.vertex_idx3);
+    face_side_lengths.push_back(
+        std::sqrt(std::max({(vertex1 - vertex2).squaredNorm(),
+                            (vertex1 - vertex3).squaredNorm(),
+                            (vertex2 - vertex3).squaredNorm()})));
+  }
+
+  const float max_face_side_length =
+      options.max_side_length_factor *
+      Percentile(std::vector<float>(face_side_lengths),
+                 options.max_side_length_percentile);
+
+  // Note that skipping some of the faces here means that there will be some
+  // unused vertices in the final mesh.
+  size_t num_faces = 0;
+  for (size_t i = 0; i < mesh->faces.size(); ++i) {
+    if (face_side_lengths[i] <= max_face_side_length) {
+      mesh->faces[num_faces] = mesh->faces[i];
+      num_faces += 1;
+    }
+  }
+  mesh->faces.resize(num_faces);
+}
+
+PlyMesh DelaunayMeshing(const DelaunayMeshingOptions& options,
+                        const DelaunayMeshingInput& input_data) {
+  THROW_CHECK(options.Check());
+
+  PlyMesh mesh;
+  if (options.max_num_points_per_partition > 0 &&
+      input_data.points.size() >
+          static_cast<size_t>(options.max_num_points_per_partition)) {
+    mesh = ComputePartitionedDelaunaySurfaceMesh(options, input_data);
+  } else {
+    mesh = ComputeDelaunaySurfaceMesh(
+        options, input_data, UnboundedPartitionBox());
+  }
+
+  FilterLongMeshFaces(options, &mesh);
+
+  return mesh;
+}
+
 void SparseDelaunayMeshing(const DelaunayMeshingOptions& options,
                            const std::filesystem::path& input_path,
                            const std::filesystem::path& output_path) {
@@ -63,6 +63,18 @@ struct DelaunayMeshingOptions {
   double max_side_length_factor = 25.0;
   double max_side_length_percentile = 95.0;
 
+  // Maximum number of input points per spatial partition. If positive, the
+  // points are recursively split at the median of the longest axis until each
+  // partition has at most this many points. The partitions are then meshed
+  // independently in parallel and their surfaces are stitched together, which
+  // bounds the memory usage for large point clouds. Disabled if zero.
+  int max_num_points_per_partition = 0;
+
+  // Overlap between neighboring partitions relative to the partition extent.
+  // Points within the overlap are triangulated and labeled by the graph-cut of
+  // both partitions, but only the faces inside a partition are kept.
+  double partition_overlap = 0.1;
+
   // The number of threads to use for reconstruction. Default is all threads.
   int num_threads = -1;
 
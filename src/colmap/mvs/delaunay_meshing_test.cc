@@ -61,46 +61,12 @@ Reconstruction CreateAndWriteSyntheticReconstruction(
 
 #if defined(COLMAP_CGAL_ENABLED)
 
-TEST(SparseDelaunayMeshing, Integration) {
-  const auto test_dir = CreateTestDir();
-  const auto sparse_path = test_dir / "sparse";
-  const auto output_path = test_dir / "mesh.ply";
-  CreateAndWriteSyntheticReconstruction(sparse_path);
-
-  DelaunayMeshingOptions options;
-  options.num_threads = 1;
-  SparseDelaunayMeshing(options, sparse_path, output_path);
-
-  EXPECT_TRUE(ExistsFile(output_path));
-  const std::vector<PlyPoint> mesh_vertices = ReadPly(output_path);
-  EXPECT_GE(mesh_vertices.size(), 3);
-}
-
-TEST(SparseDelaunayMeshing, NonSubsampled) {
-  const auto test_dir = CreateTestDir();
-  const auto sparse_path = test_dir / "sparse";
-  const auto output_path = test_dir / "mesh.ply";
-  CreateAndWriteSyntheticReconstruction(sparse_path);
-
-  // Setting max_proj_dist=0 exercises the non-subsampled
-  // CreateDelaunayTriangulation() path instead of
-  // CreateSubSampledDelaunayTriangulation().
-  DelaunayMeshingOptions options;
-  options.max_proj_dist = 0;
-  options.num_threads = 1;
-  SparseDelaunayMeshing(options, sparse_path, output_path);
-
-  EXPECT_TRUE(ExistsFile(output_path));
-  const std::vector<PlyPoint> mesh_vertices = ReadPly(output_path);
-  EXPECT_GE(mesh_vertices.size(), 3);
-}
-
-TEST(DenseDelaunayMeshing, Integration) {
-  const auto test_dir = CreateTestDir();
-  const auto sparse_path = test_dir / "sparse";
-  const auto output_path = test_dir / "mesh.ply";
-  const auto reconstruction =
-      CreateAndWriteSyntheticReconstruction(sparse_path, 3, 50);
+void CreateAndWriteSyntheticDenseWorkspace(
+    const std::filesystem::path& test_dir,
+    int num_frames = 3,
+    int num_points3D = 50) {
+  const auto reconstruction = CreateAndWriteSyntheticReconstruction(
+      test_dir / "sparse", num_frames, num_points3D);
 
   // Create fused.ply from reconstruction points
   std::vector<PlyPoint> ply_points;
@@ -140,9 +106,64 @@ TEST(DenseDelaunayMeshing, Integration) {
     }
   }
   vis_file.close();
+}
+
+TEST(SparseDelaunayMeshing, Integration) {
+  const auto test_dir = CreateTestDir();
+  const auto sparse_path = test_dir / "sparse";
+  const auto output_path = test_dir / "mesh.ply";
+  CreateAndWriteSyntheticReconstruction(sparse_path);
 
   DelaunayMeshingOptions options;
   options.num_threads = 1;
+  SparseDelaunayMeshing(options, sparse_path, output_path);
+
+  EXPECT_TRUE(ExistsFile(output_path));
+  const std::vector<PlyPoint> mesh_vertices = ReadPly(output_path);
+  EXPECT_GE(mesh_vertices.size(), 3);
+}
+
+TEST(SparseDelaunayMeshing, NonSubsampled) {
+  const auto test_dir = CreateTestDir();
+  const auto sparse_path = test_dir / "sparse";
+  const auto output_path = test_dir / "mesh.ply";
+  CreateAndWriteSyntheticReconstruction(sparse_path);
+
+  // Setting max_proj_dist=0 exercises the non-subsampled
+  // CreateDelaunayTriangulation() path instead of
+  // CreateSubSampledDelaunayTriangulation().
+  DelaunayMeshingOptions options;
+  options.max_proj_dist = 0;
+  options.num_threads = 1;
+  SparseDelaunayMeshing(options, sparse_path, output_path);
+
+  EXPECT_TRUE(ExistsFile(output_path));
+  const std::vector<PlyPoint> mesh_vertices = ReadPly(output_path);
+  EXPECT_GE(mesh_vertices.size(), 3);
+}
+
+TEST(DenseDelaunayMeshing, Integration) {
+  const auto test_dir = CreateTestDir();
+  const auto output_path = test_dir / "mesh.ply";
+  CreateAndWriteSyntheticDenseWorkspace(test_dir);
+
+  DelaunayMeshingOptions options;
+  options.num_threads = 1;
+  DenseDelaunayMeshing(options, test_dir, output_path);
+
+  EXPECT_TRUE(ExistsFile(output_path));
+  const std::vector<PlyPoint> mesh_vertices = ReadPly(output_path);
+  EXPECT_GE(mesh_vertices.size(), 3);
+}
+
+TEST(DenseDelaunayMeshing, Partitioned) {
+  const auto test_dir = CreateTestDir();
+  const auto output_path = test_dir / "mesh.ply";
+  CreateAndWriteSyntheticDenseWorkspace(test_dir, 3, 400);
+
+  DelaunayMeshingOptions options;
+  options.max_num_points_per_partition = 100;
+  options.num_threads = 2;
   DenseDelaunayMeshing(options, test_dir, output_path);
 
   EXPECT_TRUE(ExistsFile(output_path));
@@ -152,6 +173,16 @@ TEST(DenseDelaunayMeshing, Integration) {
 
 #endif  // COLMAP_CGAL_ENABLED
 
+TEST(DelaunayMeshingOptions, Check) {
+  DelaunayMeshingOptions options;
+  EXPECT_TRUE(options.Check());
+  options.max_num_points_per_partition = -1;
+  EXPECT_FALSE(options.Check());
+  options.max_num_points_per_partition = 100;
+  options.partition_overlap = -0.1;
+  EXPECT_FALSE(options.Check());
+}
+
 }  // namespace
 }  // namespace mvs
 }  // namespace colmap
@@ -0,0 +1,378 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/mvs/depth_prior.h"
+
+#include "colmap/math/random.h"
+#include "colmap/util/logging.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+#include <Eigen/Geometry>
+
+namespace colmap {
+namespace mvs {
+namespace {
+
+struct DelaunayTriangle {
+  DelaunayTriangle(const int v0,
+                   const int v1,
+                   const int v2,
+                   const std::vector<Eigen::Vector2d>& vertices)
+      : v(v0, v1, v2) {
+    // Compute the circumcircle relative to the first vertex for numerical
+    // stability. Degenerate triangles get an infinite circumcircle.
+    const Eigen::Vector2d b = vertices[v1] - vertices[v0];
+    const Eigen::Vector2d c = vertices[v2] - vertices[v0];
+    const double d = 2 * (b.x() * c.y() - b.y() * c.x());
+    if (d == 0) {
+      center = vertices[v0];
+      radius_sq = std::numeric_limits<double>::infinity();
+      return;
+    }
+    const double b_sq = b.squaredNorm();
+    const double c_sq = c.squaredNorm();
+    const Eigen::Vector2d offset((c.y() * b_sq - b.y() * c_sq) / d,
+                                 (b.x() * c_sq - c.x() * b_sq) / d);
+    center = vertices[v0] + offset;
+    radius_sq = offset.squaredNorm();
+  }
+
+  Eigen::Vector3i v;
+  Eigen::Vector2d center;
+  double radius_sq;
+};
+
+}  // namespace
+
+std::vector<Eigen::Vector3i> DelaunayTriangulation2D(
+    const std::vector<Eigen::Vector2d>& points) {
+  // Sort the points by their x-coordinate, so that triangles whose
+  // circumcircle lies entirely left of the current point can be finalized.
+  std::vector<int> order(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&points](const int i, const int j) {
+    return points[i].x() < points[j].x() ||
+           (points[i].x() == points[j].x() && points[i].y() < points[j].y());
+  });
+  order.erase(std::unique(order.begin(),
+                          order.end(),
+                          [&points](const int i, const int j) {
+                            return points[i] == points[j];
+                          }),
+              order.end());
+  if (order.size() < 3) {
+    return {};
+  }
+
+  const int num_points = order.size();
+  std::vector<Eigen::Vector2d> vertices;
+  vertices.reserve(num_points + 3);
+  Eigen::Vector2d min_point = points[order[0]];
+  Eigen::Vector2d max_point = points[order[0]];
+  for (const int idx : order) {
+    vertices.push_back(points[idx]);
+    min_point = min_point.cwiseMin(points[idx]);
+    max_point = max_point.cwiseMax(points[idx]);
+  }
+
+  // Super triangle that contains all points well inside of it.
+  const Eigen::Vector2d mid_point = 0.5 * (min_point + max_point);
+  const double extent = std::max((max_point - min_point).maxCoeff(), 1.0);
+  vertices.emplace_back(mid_point.x() - 20 * extent, mid_point.y() - extent);
+  vertices.emplace_back(mid_point.x(), mid_point.y() + 20 * extent);
+  vertices.emplace_back(mid_point.x() + 20 * extent, mid_point.y() - extent);
+
+  std::vector<DelaunayTriangle> open_triangles;
+  std::vector<DelaunayTriangle> closed_triangles;
+  open_triangles.emplace_back(
+      num_points, num_points + 1, num_points + 2, vertices);
+
+  // Bowyer-Watson: remove all triangles whose circumcircle contains the new
+  // point and re-triangulate the resulting cavity from its boundary edges.
+  std::vector<std::pair<int, int>> edges;
+  for (int point_idx = 0; point_idx < num_points; ++point_idx) {
+    const Eigen::Vector2d& point = vertices[point_idx];
+    edges.clear();
+    for (size_t i = 0; i < open_triangles.size();) {
+      const DelaunayTriangle& triangle = open_triangles[i];
+      const Eigen::Vector2d diff = point - triangle.center;
+      const bool is_closed =
+          diff.x() > 0 && diff.x() * diff.x() > triangle.radius_sq;
+      const bool is_bad = !is_closed && diff.squaredNorm() < triangle.radius_sq;
+      if (is_closed) {
+        closed_triangles.push_back(triangle);
+      } else if (is_bad) {
+        for (int k = 0; k < 3; ++k) {
+          const int v0 = triangle.v(k);
+          const int v1 = triangle.v((k + 1) % 3);
+          edges.emplace_back(std::min(v0, v1), std::max(v0, v1));
+        }
+      }
+      if (is_closed || is_bad) {
+        open_triangles[i] = open_triangles.back();
+        open_triangles.pop_back();
+      } else {
+        ++i;
+      }
+    }
+
+    // Edges shared by two removed triangles are interior to the cavity.
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size(); ++i) {
+      if (i + 1 < edges.size() && edges[i] == edges[i + 1]) {
+        ++i;
+        continue;
+      }
+      open_triangles.emplace_back(
+          edges[i].first, edges[i].second, point_idx, vertices);
+    }
+  }
+
+  closed_triangles.insert(
+      closed_triangles.end(), open_triangles.begin(), open_triangles.end());
+
+  std::vector<Eigen::Vector3i> triangles;
+  triangles.reserve(closed_triangles.size());
+  for (const DelaunayTriangle& triangle : closed_triangles) {
+    if (triangle.v.maxCoeff() >= num_points) {
+      continue;
+    }
+    const Eigen::Vector2d& p0 = vertices[triangle.v(0)];
+    const Eigen::Vector2d& p1 = vertices[triangle.v(1)];
+    const Eigen::Vector2d& p2 = vertices[triangle.v(2)];
+    const double area = (p1.x() - p0.x()) * (p2.y() - p0.y()) -
+                        (p1.y() - p0.y()) * (p2.x() - p0.x());
+    if (area == 0) {
+      continue;
+    }
+    Eigen::Vector3i triangle_idxs(
+        order[triangle.v(0)], order[triangle.v(1)], order[triangle.v(2)]);
+    if (area < 0) {
+      std::swap(triangle_idxs(1), triangle_idxs(2));
+    }
+    triangles.push_back(triangle_idxs);
+  }
+
+  return triangles;
+}
+
+DepthMap ComputeSparseDepthPrior(const Image& image,
+                                 const int image_idx,
+                                 const std::vector<Model::Point>& points) {
+  const int width = image.GetWidth();
+  const int height = image.GetHeight();
+  const float* K = image.GetK();
+  const Eigen::Map<const Eigen::Matrix<float, 3, 3, Eigen::RowMajor>> R(
+      image.GetR());
+  const Eigen::Map<const Eigen::Vector3f> T(image.GetT());
+
+  // Project the observed points and keep the closest point per pixel, since
+  // coincident projections would result in degenerate triangles.
+  std::unordered_map<int, std::pair<Eigen::Vector2d, float>> pixel_points;
+  for (const auto& point : points) {
+    if (std::find(point.track.begin(), point.track.end(), image_idx) ==
+        point.track.end()) {
+      continue;
+    }
+    const Eigen::Vector3f xyz =
+        R * Eigen::Vector3f(point.x, point.y, point.z) + T;
+    if (xyz.z() <= 0) {
+      continue;
+    }
+    const double x = K[0] * xyz.x() / xyz.z() + K[2];
+    const double y = K[4] * xyz.y() / xyz.z() + K[5];
+    const int col = std::round(x);
+    const int row = std::round(y);
+    if (col < 0 || row < 0 || col >= width || row >= height) {
+      continue;
+    }
+    auto it = pixel_points.emplace(
+        row * width + col, std::make_pair(Eigen::Vector2d(x, y), xyz.z()));
+    if (!it.second && xyz.z() < it.first->second.second) {
+      it.first->second = std::make_pair(Eigen::Vector2d(x, y), xyz.z());
+    }
+  }
+
+  std::vector<Eigen::Vector2d> proj_points;
+  std::vector<float> inv_depths;
+  proj_points.reserve(pixel_points.size());
+  inv_depths.reserve(pixel_points.size());
+  for (const auto& pixel_point : pixel_points) {
+    proj_points.push_back(pixel_point.second.first);
+    inv_depths.push_back(1.0f / pixel_point.second.second);
+  }
+
+  DepthMap depth_map(width, height, -1.0f, -1.0f);
+  depth_map.Fill(0);
+
+  // The inverse depth is an affine function of the pixel coordinates on a
+  // planar triangle, so barycentric interpolation of it is exact.
+  for (const Eigen::Vector3i& triangle : DelaunayTriangulation2D(proj_points)) {
+    const Eigen::Vector2d& p0 = proj_points[triangle(0)];
+    const Eigen::Vector2d& p1 = proj_points[triangle(1)];
+    const Eigen::Vector2d& p2 = proj_points[triangle(2)];
+    const double area = (p1.x() - p0.x()) * (p2.y() - p0.y()) -
+                        (p1.y() - p0.y()) * (p2.x() - p0.x());
+    // Include pixels on the boundary despite the rounding of the projections.
+    constexpr double kEps = 1e-6;
+    const Eigen::Vector2d min_point = p0.cwiseMin(p1).cwiseMin(p2);
+    const Eigen::Vector2d max_point = p0.cwiseMax(p1).cwiseMax(p2);
+    const int min_col =
+        std::max(0, static_cast<int>(std::ceil(min_point.x() - kEps)));
+    const int max_col =
+        std::min(width - 1, static_cast<int>(std::floor(max_point.x() + kEps)));
+    const int min_row =
+        std::max(0, static_cast<int>(std::ceil(min_point.y() - kEps)));
+    const int max_row = std::min(
+        height - 1, static_cast<int>(std::floor(max_point.y() + kEps)));
+    for (int row = min_row; row <= max_row; ++row) {
+      for (int col = min_col; col <= max_col; ++col) {
+        const double w0 = ((p1.x() - col) * (p2.y() - row) -
+                           (p1.y() - row) * (p2.x() - col)) /
+                          area;
+        const double w1 = ((p2.x() - col) * (p0.y() - row) -
+                           (p2.y() - row) * (p0.x() - col)) /
+                          area;
+        const double w2 = 1 - w0 - w1;
+        if (w0 < -kEps || w1 < -kEps || w2 < -kEps) {
+          continue;
+        }
+        const double inv_depth = w0 * inv_depths[triangle(0)] +
+                                 w1 * inv_depths[triangle(1)] +
+                                 w2 * inv_depths[triangle(2)];
+        depth_map.Set(row, col, 1.0 / inv_depth);
+      }
+    }
+  }
+
+  return depth_map;
+}
+
+void CompleteDepthPrior(const Image& image,
+                        const float depth_min,
+                        const float depth_max,
+                        DepthMap* depth_map,
+                        NormalMap* normal_map) {
+  THROW_CHECK_NOTNULL(depth_map);
+  THROW_CHECK_NOTNULL(normal_map);
+  THROW_CHECK_GT(depth_min, 0);
+  THROW_CHECK_LE(depth_min, depth_max);
+
+  const int width = image.GetWidth();
+  const int height = image.GetHeight();
+  const float* K = image.GetK();
+
+  // Nearest neighbor resampling, since bilinear interpolation would blend
+  // valid depths with missing ones.
+  if (depth_map->GetWidth() != static_cast<size_t>(width) ||
+      depth_map->GetHeight() != static_cast<size_t>(height)) {
+    DepthMap resampled_depth_map(width, height, depth_min, depth_max);
+    for (int row = 0; row < height; ++row) {
+      const size_t src_row = std::min<size_t>(
+          (row + 0.5) * depth_map->GetHeight() / height,
+          depth_map->GetHeight() - 1);
+      for (int col = 0; col < width; ++col) {
+        const size_t src_col = std::min<size_t>(
+            (col + 0.5) * depth_map->GetWidth() / width,
+            depth_map->GetWidth() - 1);
+        resampled_depth_map.Set(row, col, depth_map->Get(src_row, src_col));
+      }
+    }
+    *depth_map = std::move(resampled_depth_map);
+  }
+
+  const auto BackProject = [&](const int row, const int col) {
+    const float depth = depth_map->Get(row, col);
+    return Eigen::Vector3f(depth * (col - K[2]) / K[0],
+                           depth * (row - K[5]) / K[4],
+                           depth);
+  };
+
+  const auto HasDepth = [&](const int row, const int col) {
+    return row >= 0 && col >= 0 && row < height && col < width &&
+           depth_map->Get(row, col) > 0;
+  };
+
+  *normal_map = NormalMap(width, height);
+  for (int row = 0; row < height; ++row) {
+    for (int col = 0; col < width; ++col) {
+      // Default to fronto-parallel normals where no gradient is available.
+      Eigen::Vector3f normal(0, 0, -1);
+      if (HasDepth(row, col)) {
+        const Eigen::Vector3f point = BackProject(row, col);
+        Eigen::Vector3f dx = Eigen::Vector3f::Zero();
+        if (HasDepth(row, col + 1)) {
+          dx = BackProject(row, col + 1) - point;
+        } else if (HasDepth(row, col - 1)) {
+          dx = point - BackProject(row, col - 1);
+        }
+        Eigen::Vector3f dy = Eigen::Vector3f::Zero();
+        if (HasDepth(row + 1, col)) {
+          dy = BackProject(row + 1, col) - point;
+        } else if (HasDepth(row - 1, col)) {
+          dy = point - BackProject(row - 1, col);
+        }
+        const Eigen::Vector3f cross = dx.cross(dy);
+        const float norm = cross.norm();
+        if (norm > 0) {
+          normal = cross / norm;
+          if (normal.dot(point) > 0) {
+            normal = -normal;
+          }
+        }
+      }
+      for (int d = 0; d < 3; ++d) {
+        normal_map->Set(row, col, d, normal(d));
+      }
+    }
+  }
+
+  for (int row = 0; row < height; ++row) {
+    for (int col = 0; col < width; ++col) {
+      const float depth = depth_map->Get(row, col);
+      if (depth > 0) {
+        depth_map->Set(row, col, std::clamp(depth, depth_min, depth_max));
+      } else {
+        depth_map->Set(
+            row, col, RandomUniformReal<float>(depth_min, depth_max));
+      }
+    }
+  }
+
+  *depth_map = DepthMap(*depth_map, depth_min, depth_max);
+}
+
+}  // namespace mvs
+}  // namespace colmap
@@ -0,0 +1,72 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "colmap/mvs/depth_map.h"
+#include "colmap/mvs/image.h"
+#include "colmap/mvs/model.h"
+#include "colmap/mvs/normal_map.h"
+
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace colmap {
+namespace mvs {
+
+// Compute the Delaunay triangulation of the given 2D points. Returns the
+// vertex indices of the triangles in counter-clockwise order. Duplicate
+// points are ignored.
+std::vector<Eigen::Vector3i> DelaunayTriangulation2D(
+    const std::vector<Eigen::Vector2d>& points);
+
+// Render a depth map for the image from the sparse points observed by it.
+// The points are projected into the image and their inverse depths are
+// interpolated over the Delaunay triangulation of the projections, which is
+// exact for planar triangles. Pixels outside the convex hull of the
+// projections have zero depth.
+DepthMap ComputeSparseDepthPrior(const Image& image,
+                                 int image_idx,
+                                 const std::vector<Model::Point>& points);
+
+// Convert a prior depth map, e.g. rendered from the sparse model, a mesh, or
+// LiDAR scans, into an initialization for PatchMatch. Pixels without a prior,
+// i.e. with non-positive depth, are assigned a random depth in the given
+// range, and all depths are clamped to the range. The normals are estimated
+// from the depth gradients and oriented towards the camera.
+void CompleteDepthPrior(const Image& image,
+                        float depth_min,
+                        float depth_max,
+                        DepthMap* depth_map,
+                        NormalMap* normal_map);
+
+}  // namespace mvs
+}  // namespace colmap
@@ -0,0 +1,218 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/mvs/depth_prior.h"
+
+#include "colmap/math/random.h"
+
+#include <set>
+
+#include <Eigen/LU>
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace mvs {
+namespace {
+
+Image CreateTestImage() {
+  const float K[9] = {100, 0, 50, 0, 100, 40, 0, 0, 1};
+  const float R[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  const float T[3] = {0, 0, 0};
+  return Image("image.png", 100, 80, K, R, T);
+}
+
+// Depth of the plane 0.1 * x + 0.2 * y + z = 2 along the ray of the pixel.
+float PlaneDepth(const Image& image, const float row, const float col) {
+  const float* K = image.GetK();
+  const float x = (col - K[2]) / K[0];
+  const float y = (row - K[5]) / K[4];
+  return 2 / (0.1f * x + 0.2f * y + 1);
+}
+
+std::vector<Model::Point> CreatePlanePoints(const Image& image,
+                                            const int image_idx) {
+  std::vector<Model::Point> points;
+  for (int row = 10; row <= 70; row += 20) {
+    for (int col = 10; col <= 90; col += 20) {
+      const float* K = image.GetK();
+      const float depth = PlaneDepth(image, row, col);
+      Model::Point point;
+      point.x = depth * (col - K[2]) / K[0];
+      point.y = depth * (row - K[5]) / K[4];
+      point.z = depth;
+      point.track = {image_idx};
+      points.push_back(point);
+    }
+  }
+  return points;
+}
+
+TEST(DelaunayTriangulation2D, Degenerate) {
+  EXPECT_TRUE(DelaunayTriangulation2D({}).empty());
+  EXPECT_TRUE(DelaunayTriangulation2D({Eigen::Vector2d(0, 0),
+                                       Eigen::Vector2d(1, 0),
+                                       Eigen::Vector2d(1, 0)})
+                  .empty());
+  EXPECT_TRUE(DelaunayTriangulation2D({Eigen::Vector2d(0, 0),
+                                       Eigen::Vector2d(1, 0),
+                                       Eigen::Vector2d(2, 0)})
+                  .empty());
+}
+
+TEST(DelaunayTriangulation2D, Square) {
+  const std::vector<Eigen::Vector2d> points = {Eigen::Vector2d(0, 0),
+                                               Eigen::Vector2d(1, 0),
+                                               Eigen::Vector2d(1, 1),
+                                               Eigen::Vector2d(0, 1.1),
+                                               Eigen::Vector2d(0, 0)};
+  const auto triangles = DelaunayTriangulation2D(points);
+  ASSERT_EQ(triangles.size(), 2);
+  for (const auto& triangle : triangles) {
+    EXPECT_LT(triangle.maxCoeff(), 4);
+  }
+}
+
+TEST(DelaunayTriangulation2D, Random) {
+  SetPRNGSeed(0);
+  std::vector<Eigen::Vector2d> points(200);
+  for (auto& point : points) {
+    point = Eigen::Vector2d(RandomUniformReal(0.0, 100.0),
+                            RandomUniformReal(0.0, 50.0));
+  }
+
+  const auto triangles = DelaunayTriangulation2D(points);
+
+  // Euler's formula for a triangulation with h points on the convex hull.
+  std::set<std::pair<int, int>> edges;
+  for (const auto& triangle : triangles) {
+    for (int k = 0; k < 3; ++k) {
+      const int v0 = triangle(k);
+      const int v1 = triangle((k + 1) % 3);
+      const auto edge = std::make_pair(std::min(v0, v1), std::max(v0, v1));
+      if (!edges.insert(edge).second) {
+        edges.erase(edge);
+      }
+    }
+  }
+  const int num_hull_points = edges.size();
+  EXPECT_EQ(triangles.size(), 2 * points.size() - 2 - num_hull_points);
+
+  for (const auto& triangle : triangles) {
+    const Eigen::Vector2d& a = points[triangle(0)];
+    const Eigen::Vector2d& b = points[triangle(1)];
+    const Eigen::Vector2d& c = points[triangle(2)];
+    EXPECT_GT((b - a).x() * (c - a).y() - (b - a).y() * (c - a).x(), 0);
+    // No point lies strictly inside the circumcircle of any triangle.
+    for (const auto& d : points) {
+      Eigen::Matrix3d incircle;
+      incircle << a.x() - d.x(), a.y() - d.y(), (a - d).squaredNorm(),
+          b.x() - d.x(), b.y() - d.y(), (b - d).squaredNorm(), c.x() - d.x(),
+          c.y() - d.y(), (c - d).squaredNorm();
+      EXPECT_LE(incircle.determinant(), 1e-6);
+    }
+  }
+}
+
+TEST(ComputeSparseDepthPrior, Plane) {
+  const Image image = CreateTestImage();
+  std::vector<Model::Point> points = CreatePlanePoints(image, 1);
+  // Points not observed by the image and behind the image are ignored.
+  Model::Point other_point;
+  other_point.z = 10;
+  other_point.track = {0};
+  points.push_back(other_point);
+  Model::Point behind_point = points.front();
+  behind_point.z = -1;
+  points.push_back(behind_point);
+
+  const DepthMap depth_map = ComputeSparseDepthPrior(image, 1, points);
+  EXPECT_EQ(depth_map.GetWidth(), image.GetWidth());
+  EXPECT_EQ(depth_map.GetHeight(), image.GetHeight());
+  for (int row = 0; row < 80; ++row) {
+    for (int col = 0; col < 100; ++col) {
+      if (row >= 10 && row <= 70 && col >= 10 && col <= 90) {
+        EXPECT_NEAR(depth_map.Get(row, col), PlaneDepth(image, row, col), 1e-4);
+      } else {
+        EXPECT_EQ(depth_map.Get(row, col), 0);
+      }
+    }
+  }
+}
+
+TEST(CompleteDepthPrior, Plane) {
+  SetPRNGSeed(0);
+  const Image image = CreateTestImage();
+  const DepthMap sparse_depth_map =
+      ComputeSparseDepthPrior(image, 0, CreatePlanePoints(image, 0));
+
+  DepthMap depth_map = sparse_depth_map;
+  NormalMap normal_map;
+  CompleteDepthPrior(image, 1.5f, 2.5f, &depth_map, &normal_map);
+  EXPECT_EQ(depth_map.GetDepthMin(), 1.5f);
+  EXPECT_EQ(depth_map.GetDepthMax(), 2.5f);
+  EXPECT_EQ(normal_map.GetWidth(), image.GetWidth());
+  EXPECT_EQ(normal_map.GetHeight(), image.GetHeight());
+
+  const Eigen::Vector3f plane_normal =
+      -Eigen::Vector3f(0.1f, 0.2f, 1).normalized();
+  for (int row = 0; row < 80; ++row) {
+    for (int col = 0; col < 100; ++col) {
+      EXPECT_GE(depth_map.Get(row, col), 1.5f);
+      EXPECT_LE(depth_map.Get(row, col), 2.5f);
+      Eigen::Vector3f normal;
+      normal_map.GetSlice(row, col, normal.data());
+      EXPECT_NEAR(normal.norm(), 1, 1e-5);
+      if (sparse_depth_map.Get(row, col) > 0) {
+        EXPECT_EQ(depth_map.Get(row, col), sparse_depth_map.Get(row, col));
+        EXPECT_GT(normal.dot(plane_normal), 0.999f);
+      }
+    }
+  }
+}
+
+TEST(CompleteDepthPrior, Resample) {
+  const Image image = CreateTestImage();
+  DepthMap depth_map(50, 40, -1, -1);
+  depth_map.Fill(2);
+  NormalMap normal_map;
+  CompleteDepthPrior(image, 1, 3, &depth_map, &normal_map);
+  EXPECT_EQ(depth_map.GetWidth(), image.GetWidth());
+  EXPECT_EQ(depth_map.GetHeight(), image.GetHeight());
+  for (int row = 0; row < 80; ++row) {
+    for (int col = 0; col < 100; ++col) {
+      EXPECT_EQ(depth_map.Get(row, col), 2);
+      EXPECT_EQ(normal_map.Get(row, col, 2), -1);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace mvs
+}  // namespace colmap
@@ -33,17 +33,44 @@
 #include "colmap/util/eigen_alignment.h"
 #include "colmap/util/endian.h"
 #include "colmap/util/file.h"
+#include "colmap/util/metrics.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/resource_usage.h"
 #include "colmap/util/threading.h"
 #include "colmap/util/timer.h"
+#include "colmap/util/tracing.h"
 
+#if defined(COLMAP_CUDA_ENABLED)
+#include "colmap/mvs/fusion_cuda.h"
+#include "colmap/util/cuda.h"
+#endif  // COLMAP_CUDA_ENABLED
+
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <limits>
+#include <tuple>
 #include <unordered_set>
 
 #include <Eigen/Geometry>
 
 namespace colmap {
 namespace mvs {
+namespace {
+
+// Width and height of the tiles, which are fused concurrently.
+constexpr int kTileSize = 32;
+
+// Number of tiles per thread, which are fused against the same masks.
+constexpr int kNumTilesPerThread = 4;
+
+uint64_t PixelKey(const int image_idx, const int row, const int col) {
+  return (static_cast<uint64_t>(image_idx) << 40) |
+         (static_cast<uint64_t>(row) << 20) | static_cast<uint64_t>(col);
+}
+
+}  // namespace
+
 namespace internal {
 
 // Use the sparse model to find most connected image that has not yet been
@@ -88,6 +115,13 @@ void StereoFusionOptions::Print() const {
   PrintOption(check_num_images);
   PrintOption(use_cache);
   PrintOption(cache_size);
+  PrintOption(use_gpu);
+  PrintOption(gpu_index);
+  PrintOption(stream_output_path);
+  PrintOption(input_fused_path);
+  PrintOption(spill_cache_path);
+  PrintOption(spill_cache_size);
+  PrintOption(merge_radius);
   const auto& bbox_min = bounding_box.first.transpose().eval();
   const auto& bbox_max = bounding_box.second.transpose().eval();
   PrintOption(bbox_min);
@@ -104,6 +138,8 @@ bool StereoFusionOptions::Check() const {
   CHECK_OPTION_GE(max_normal_error, 0);
   CHECK_OPTION_GT(check_num_images, 0);
   CHECK_OPTION_GT(cache_size, 0);
+  CHECK_OPTION_GE(spill_cache_size, 0);
+  CHECK_OPTION_GE(merge_radius, 0);
   return true;
 }
 
@@ -133,11 +169,14 @@ const std::vector<std::vector<int>>& StereoFusion::GetFusedPointsVisibility()
 }
 
 void StereoFusion::Run() {
+  ScopedResourceUsage resource_usage("StereoFusion");
   Timer run_timer;
   run_timer.Start();
 
   fused_points_.clear();
   fused_points_visibility_.clear();
+  fused_points_writer_.reset();
+  fused_points_visibility_writer_.reset();
 
   options_.Print();
 
@@ -156,6 +195,8 @@ void StereoFusion::Run() {
   workspace_options.max_image_size = options_.max_image_size;
   workspace_options.image_as_rgb = true;
   workspace_options.cache_size = options_.cache_size;
+  workspace_options.spill_cache_path = options_.spill_cache_path;
+  workspace_options.spill_cache_size = options_.spill_cache_size;
   workspace_options.workspace_path = workspace_path_;
   workspace_options.workspace_format = workspace_format_;
   workspace_options.input_type = input_type_;
@@ -188,9 +229,6 @@ void StereoFusion::Run() {
     overlapping_images_ = model.GetMaxOverlappingImagesFromPMVS();
   }
 
-  task_fused_points_.resize(num_threads);
-  task_fused_points_visibility_.resize(num_threads);
-
   used_images_.resize(model.images.size(), false);
   fused_images_.resize(model.images.size(), false);
   fused_pixel_masks_.resize(model.images.size());
@@ -244,100 +282,304 @@ void StereoFusion::Run() {
             .transpose();
   }
 
+  use_gpu_ = false;
+  if (options_.use_gpu) {
+#if defined(COLMAP_CUDA_ENABLED)
+    const std::vector<int> gpu_indices = CSVToVector<int>(options_.gpu_index);
+    THROW_CHECK_GT(gpu_indices.size(), 0);
+    SetBestCudaDevice(gpu_indices[0]);
+    use_gpu_ = true;
+#else
+    LOG(WARNING) << "Requested to use GPU for fusion, but COLMAP was "
+                    "compiled without CUDA support. Falling back to CPU.";
+#endif  // COLMAP_CUDA_ENABLED
+  }
+
+  seed_images_ = used_images_;
+  if (!options_.input_fused_path.empty()) {
+    ReadInputFusedPoints();
+  }
+
   LOG(INFO) << StringPrintf("Starting fusion with %d threads", num_threads);
-  ThreadPool thread_pool(num_threads);
-
-  // Using a row stride of 10 to avoid starting parallel processing in rows that
-  // are too close to each other which may lead to duplicated work, since nearby
-  // pixels are likely to get fused into the same point.
-  const int kRowStride = 10;
-  auto ProcessImageRows = [&, this](const int row_start,
-                                    const int height,
-                                    const int width,
-                                    const int image_idx,
-                                    const Mat<char>& fused_pixel_mask) {
-    const int row_end = std::min(height, row_start + kRowStride);
-    for (int row = row_start; row < row_end; ++row) {
-      for (int col = 0; col < width; ++col) {
-        if (fused_pixel_mask.Get(row, col) > 0) {
-          continue;
-        }
-        const int thread_id = thread_pool.GetThreadIndex();
-        Fuse(thread_id, image_idx, row, col);
-      }
-    }
+  NumaThreadPool thread_pool(num_threads);
+
+  if (!options_.stream_output_path.empty()) {
+    fused_points_writer_ =
+        std::make_unique<BinaryPlyPointsWriter>(options_.stream_output_path);
+    fused_points_visibility_writer_ = std::make_unique<PointsVisibilityWriter>(
+        AddFileExtension(options_.stream_output_path, ".vis"));
+    fused_points_writer_->Write(fused_points_);
+    fused_points_visibility_writer_->Write(fused_points_visibility_);
+    fused_points_.clear();
+    fused_points_visibility_.clear();
+  }
+
+  auto NumFusedPoints = [this]() {
+    return fused_points_.size() +
+           (fused_points_writer_ ? fused_points_writer_->NumPoints() : 0);
   };
 
+  const int num_batch_tiles = kNumTilesPerThread * num_threads;
+  std::vector<std::vector<SeedFusion>> tile_seeds(num_batch_tiles);
+
+  const size_t num_seed_images =
+      std::count(seed_images_.begin(), seed_images_.end(), true);
   size_t num_fused_images = 0;
-  size_t total_fused_points = 0;
-  for (int image_idx = 0; image_idx >= 0;
+  for (int image_idx =
+           seed_images_.at(0) ? 0
+                              : internal::FindNextImage(overlapping_images_,
+                                                        seed_images_,
+                                                        fused_images_,
+                                                        0);
+       image_idx >= 0;
        image_idx = internal::FindNextImage(
-           overlapping_images_, used_images_, fused_images_, image_idx)) {
+           overlapping_images_, seed_images_, fused_images_, image_idx)) {
     if (CheckIfStopped()) {
       break;
     }
 
+    TraceZone trace_zone("FuseImage");
+    const size_t num_prev_fused_points = NumFusedPoints();
+
     Timer timer;
     timer.Start();
 
     LOG(INFO) << StringPrintf("Fusing image [%d/%d] with index %d",
                               num_fused_images + 1,
-                              model.images.size(),
+                              num_seed_images,
                               image_idx)
               << std::flush;
 
+    // Load the overlapping images in the background, while the fusion of
+    // the first rows only needs the current image.
+    workspace_->Prefetch(overlapping_images_.at(image_idx));
+
+    if (use_gpu_) {
+      CheckConsistencyOnGpu(image_idx);
+    }
+
     const int width = depth_map_sizes_.at(image_idx).first;
     const int height = depth_map_sizes_.at(image_idx).second;
-    const auto& fused_pixel_mask = fused_pixel_masks_.at(image_idx);
+    const int num_tiles = ((width + kTileSize - 1) / kTileSize) *
+                          ((height + kTileSize - 1) / kTileSize);
+
+    // The tiles of a batch are fused concurrently against the masks at the
+    // start of the batch and then committed in order, so that the result
+    // does not depend on the number of threads.
+    for (int batch_begin = 0; batch_begin < num_tiles;
+         batch_begin += num_batch_tiles) {
+      const int batch_end = std::min(batch_begin + num_batch_tiles, num_tiles);
+      // Neighboring tiles access the same rows of the depth maps and masks,
+      // so consecutive ranges of tiles are fused on the same NUMA node.
+      const int num_tiles_in_batch = batch_end - batch_begin;
+      for (int tile_idx = batch_begin; tile_idx < batch_end; ++tile_idx) {
+        const int node = (tile_idx - batch_begin) * thread_pool.NumNodes() /
+                         num_tiles_in_batch;
+        thread_pool.Node(node).AddTask(&StereoFusion::FuseTile,
+                                       this,
+                                       image_idx,
+                                       tile_idx,
+                                       &tile_seeds[tile_idx - batch_begin]);
+      }
+      thread_pool.Wait();
 
-    for (int row_start = 0; row_start < height; row_start += kRowStride) {
-      thread_pool.AddTask(ProcessImageRows,
-                          row_start,
-                          height,
-                          width,
-                          image_idx,
-                          fused_pixel_mask);
+      for (int tile_idx = batch_begin; tile_idx < batch_end; ++tile_idx) {
+        for (auto& seed : tile_seeds[tile_idx - batch_begin]) {
+          CommitSeed(image_idx, &seed);
+        }
+      }
     }
-    thread_pool.Wait();
 
     num_fused_images += 1;
     fused_images_.at(image_idx) = true;
 
-    total_fused_points = 0;
-    for (const auto& task_fused_points : task_fused_points_) {
-      total_fused_points += task_fused_points.size();
+    // Pixels of fused images are never visited again.
+    workspace_->Evict({image_idx});
+    fused_pixel_masks_.at(image_idx) = Mat<char>();
+
+    if (fused_points_writer_) {
+      MergeFusedPoints();
+      fused_points_writer_->Write(fused_points_);
+      fused_points_visibility_writer_->Write(fused_points_visibility_);
+      fused_points_.clear();
+      fused_points_visibility_.clear();
     }
-    LOG(INFO) << StringPrintf(
-        " in %.3fs (%d points)", timer.ElapsedSeconds(), total_fused_points);
-  }
 
-  fused_points_.reserve(total_fused_points);
-  fused_points_visibility_.reserve(total_fused_points);
-  for (size_t thread_id = 0; thread_id < task_fused_points_.size();
-       ++thread_id) {
-    fused_points_.insert(fused_points_.end(),
-                         task_fused_points_[thread_id].begin(),
-                         task_fused_points_[thread_id].end());
-    task_fused_points_[thread_id].clear();
-
-    fused_points_visibility_.insert(
-        fused_points_visibility_.end(),
-        task_fused_points_visibility_[thread_id].begin(),
-        task_fused_points_visibility_[thread_id].end());
-    task_fused_points_visibility_[thread_id].clear();
+    trace_zone.SetNumItems(NumFusedPoints() - num_prev_fused_points);
+    IncrementTraceCounter("NumFusedImages");
+    IncrementMetricCounter("colmap_fused_images_total");
+
+    LOG(INFO) << StringPrintf(" in %.3fs (%d points)",
+                              timer.ElapsedSeconds(),
+                              NumFusedPoints());
   }
 
-  if (fused_points_.empty()) {
+  if (NumFusedPoints() == 0) {
     LOG(WARNING)
         << "Could not fuse any points. This is likely caused by "
            "incorrect settings - filtering must be enabled for the last "
            "call to patch match stereo.";
   }
 
-  LOG(INFO) << "Number of fused points: " << fused_points_.size();
+  if (!fused_points_writer_) {
+    MergeFusedPoints();
+  }
+
+  LOG(INFO) << "Number of fused points: " << NumFusedPoints();
+
+  fused_points_writer_.reset();
+  fused_points_visibility_writer_.reset();
+
   run_timer.PrintMinutes();
 }
 
+void StereoFusion::MergeFusedPoints() {
+  if (options_.merge_radius <= 0 || fused_points_.empty()) {
+    return;
+  }
+
+  // The footprint of a point is the size of a pixel at its depth in the
+  // closest observing image.
+  const auto& model = workspace_->GetModel();
+  std::vector<float> footprints(fused_points_.size(), 0);
+  for (size_t i = 0; i < fused_points_.size(); ++i) {
+    const PlyPoint& point = fused_points_[i];
+    float min_footprint = std::numeric_limits<float>::max();
+    for (const int image_idx : fused_points_visibility_[i]) {
+      const Image& image = model.images.at(image_idx);
+      const float* R = image.GetR();
+      const float depth = R[6] * point.x + R[7] * point.y + R[8] * point.z +
+                          image.GetT()[2];
+      if (depth > 0) {
+        min_footprint = std::min(min_footprint, depth / image.GetK()[0]);
+      }
+    }
+    if (min_footprint < std::numeric_limits<float>::max()) {
+      footprints[i] = min_footprint;
+    }
+  }
+
+  const size_t num_points = fused_points_.size();
+  mvs::MergeFusedPoints(options_.merge_radius,
+                        footprints,
+                        &fused_points_,
+                        &fused_points_visibility_,
+                        options_.num_threads);
+  VLOG(2) << "Merged " << num_points << " into " << fused_points_.size()
+          << " fused points";
+}
+
+void StereoFusion::ReadInputFusedPoints() {
+  const auto& input_path = options_.input_fused_path;
+  LOG(INFO) << "Reading input fused points: " << input_path;
+
+  const auto input_time = std::filesystem::last_write_time(input_path);
+  std::vector<PlyPoint> input_points = ReadPly(input_path);
+  std::vector<std::vector<int>> input_visibility = ReadPointsVisibility(
+      AddFileExtension(input_path, ".vis"), input_points.size());
+
+  // Images with depth maps that were (re-)computed after the input fusion.
+  const int num_images = used_images_.size();
+  std::vector<char> changed_images(num_images, false);
+  for (int image_idx = 0; image_idx < num_images; ++image_idx) {
+    changed_images[image_idx] =
+        used_images_[image_idx] &&
+        std::filesystem::last_write_time(workspace_->GetDepthMapPath(
+            image_idx)) > input_time;
+  }
+
+  // Points observed by changed or removed images are fused again from all
+  // their observing images.
+  seed_images_ = changed_images;
+  std::vector<char> kept_points(input_points.size(), false);
+  for (size_t point_idx = 0; point_idx < input_points.size(); ++point_idx) {
+    const std::vector<int>& visibility = input_visibility[point_idx];
+    kept_points[point_idx] = std::none_of(
+        visibility.begin(), visibility.end(), [&](const int image_idx) {
+          return image_idx < 0 || image_idx >= num_images ||
+                 !used_images_[image_idx] || changed_images[image_idx];
+        });
+    if (!kept_points[point_idx]) {
+      for (const int image_idx : visibility) {
+        if (image_idx >= 0 && image_idx < num_images &&
+            used_images_[image_idx]) {
+          seed_images_[image_idx] = true;
+        }
+      }
+    }
+  }
+
+  // The pixels of the kept points are approximated by their projections into
+  // the observing images, such that they are not fused again.
+  size_t num_kept_points = 0;
+  for (size_t point_idx = 0; point_idx < input_points.size(); ++point_idx) {
+    if (!kept_points[point_idx]) {
+      continue;
+    }
+    const PlyPoint& point = input_points[point_idx];
+    const Eigen::Vector4f xyz(point.x, point.y, point.z, 1.0f);
+    for (const int image_idx : input_visibility[point_idx]) {
+      const Eigen::Vector3f proj = P_.at(image_idx) * xyz;
+      if (proj(2) <= 0) {
+        continue;
+      }
+      const int col = static_cast<int>(std::round(proj(0) / proj(2)));
+      const int row = static_cast<int>(std::round(proj(1) / proj(2)));
+      if (col >= 0 && row >= 0 && col < depth_map_sizes_.at(image_idx).first &&
+          row < depth_map_sizes_.at(image_idx).second) {
+        fused_pixel_masks_.at(image_idx).Set(row, col, 1);
+      }
+    }
+    fused_points_.push_back(point);
+    fused_points_visibility_.push_back(std::move(input_visibility[point_idx]));
+    num_kept_points += 1;
+  }
+
+  LOG(INFO) << StringPrintf(
+      "Kept %d of %d input points, fusing %d images (%d changed)",
+      num_kept_points,
+      input_points.size(),
+      std::count(seed_images_.begin(), seed_images_.end(), true),
+      std::count(changed_images.begin(), changed_images.end(), true));
+}
+
+void StereoFusion::CheckConsistencyOnGpu(const int image_idx) {
+#if defined(COLMAP_CUDA_ENABLED)
+  auto GetImage = [this](const int image_idx) {
+    const auto& depth_map = workspace_->GetDepthMap(image_idx);
+    const auto& normal_map = workspace_->GetNormalMap(image_idx);
+    FusionCudaImage image;
+    image.width = depth_map.GetWidth();
+    image.height = depth_map.GetHeight();
+    image.depth_map = depth_map.GetPtr();
+    image.normal_map = normal_map.GetPtr();
+    std::copy_n(P_.at(image_idx).data(), 12, image.P);
+    std::copy_n(inv_P_.at(image_idx).data(), 12, image.inv_P);
+    std::copy_n(inv_R_.at(image_idx).data(), 9, image.inv_R);
+    return image;
+  };
+
+  // Same order as the traversal of the overlapping images on the CPU.
+  ref_src_image_idxs_.clear();
+  std::vector<FusionCudaImage> src_images;
+  for (const auto src_image_idx : overlapping_images_.at(image_idx)) {
+    if (used_images_.at(src_image_idx) && !fused_images_.at(src_image_idx)) {
+      ref_src_image_idxs_.push_back(src_image_idx);
+      src_images.push_back(GetImage(src_image_idx));
+    }
+  }
+
+  ref_consistent_pixels_ =
+      ComputeFusionConsistencyCuda(GetImage(image_idx),
+                                   src_images,
+                                   max_squared_reproj_error_,
+                                   static_cast<float>(options_.max_depth_error),
+                                   min_cos_normal_error_);
+#else
+  LOG(FATAL_THROW) << "Fusion on the GPU requires CUDA support.";
+#endif  // COLMAP_CUDA_ENABLED
+}
+
 void StereoFusion::InitFusedPixelMask(int image_idx,
                                       size_t width,
                                       size_t height) {
@@ -366,10 +608,82 @@ void StereoFusion::InitFusedPixelMask(int image_idx,
   }
 }
 
-void StereoFusion::Fuse(const int thread_id,
-                        const int image_idx,
+void StereoFusion::FuseTile(const int image_idx,
+                            const int tile_idx,
+                            std::vector<SeedFusion>* seeds) {
+  const int width = depth_map_sizes_.at(image_idx).first;
+  const int height = depth_map_sizes_.at(image_idx).second;
+  const int num_tile_cols = (width + kTileSize - 1) / kTileSize;
+  const int row_begin = (tile_idx / num_tile_cols) * kTileSize;
+  const int col_begin = (tile_idx % num_tile_cols) * kTileSize;
+  const int row_end = std::min(row_begin + kTileSize, height);
+  const int col_end = std::min(col_begin + kTileSize, width);
+
+  const auto& fused_pixel_mask = fused_pixel_masks_.at(image_idx);
+
+  // Pixels fused by the previous seeds of this tile.
+  std::unordered_set<uint64_t> claimed_pixels;
+
+  seeds->clear();
+  for (int row = row_begin; row < row_end; ++row) {
+    for (int col = col_begin; col < col_end; ++col) {
+      if (fused_pixel_mask.Get(row, col) > 0) {
+        continue;
+      }
+      seeds->emplace_back();
+      Fuse(image_idx, row, col, &claimed_pixels, &seeds->back());
+    }
+  }
+}
+
+void StereoFusion::CommitSeed(const int image_idx, SeedFusion* seed) {
+  // The seed was fused against a snapshot of the masks. It is only valid, if
+  // all its reads observe the same state after committing the previous seeds.
+  bool is_valid = true;
+  std::unordered_set<uint64_t> written_pixels;
+  for (const auto& access : seed->accesses) {
+    const uint64_t key = PixelKey(access.image_idx, access.row, access.col);
+    if (access.write) {
+      written_pixels.insert(key);
+      continue;
+    }
+    const bool fused = fused_pixel_masks_.at(access.image_idx)
+                               .Get(access.row, access.col) > 0 ||
+                       written_pixels.count(key) > 0;
+    if (fused != access.fused) {
+      is_valid = false;
+      break;
+    }
+  }
+
+  if (is_valid) {
+    for (const auto& access : seed->accesses) {
+      if (access.write) {
+        fused_pixel_masks_.at(access.image_idx)
+            .Set(access.row, access.col, 1);
+      }
+    }
+  } else {
+    Fuse(image_idx, seed->row, seed->col, nullptr, seed);
+  }
+
+  if (seed->has_point) {
+    fused_points_.push_back(seed->point);
+    fused_points_visibility_.push_back(std::move(seed->visibility));
+  }
+}
+
+void StereoFusion::Fuse(const int image_idx,
                         const int row,
-                        const int col) {
+                        const int col,
+                        std::unordered_set<uint64_t>* claimed_pixels,
+                        SeedFusion* seed) {
+  seed->row = row;
+  seed->col = col;
+  seed->has_point = false;
+  seed->visibility.clear();
+  seed->accesses.clear();
+
   // Next points to fuse.
   std::vector<FusionData> fusion_queue;
   fusion_queue.emplace_back(image_idx, row, col, 0);
@@ -398,11 +712,20 @@ void StereoFusion::Fuse(const int thread_id,
 
     fusion_queue.pop_back();
 
-    // Check if pixel already fused.
+    // Check if pixel already fused. Pixels claimed by a speculative fusion
+    // are only fused, if the recorded reads still hold when committing.
     auto& fused_pixel_mask = fused_pixel_masks_.at(image_idx);
     if (fused_pixel_mask.Get(row, col) > 0) {
       continue;
     }
+    if (claimed_pixels != nullptr) {
+      const bool claimed =
+          claimed_pixels->count(PixelKey(image_idx, row, col)) > 0;
+      seed->accesses.push_back({image_idx, row, col, false, claimed});
+      if (claimed) {
+        continue;
+      }
+    }
 
     const auto& depth_map = workspace_->GetDepthMap(image_idx);
     const float depth = depth_map.Get(row, col);
@@ -414,7 +737,7 @@ void StereoFusion::Fuse(const int thread_id,
 
     // If the traversal depth is greater than zero, the initial reference
     // pixel has already been added and we need to check for consistency.
-    if (traversal_depth > 0) {
+    if (traversal_depth > 0 && !data.consistency_checked) {
       // Project reference point into current view.
       const Eigen::Vector3f proj = P_.at(image_idx) * fused_ref_point;
 
@@ -442,7 +765,7 @@ void StereoFusion::Fuse(const int thread_id,
                                                normal_map.Get(row, col, 2));
 
     // Check for consistent normal direction with reference normal.
-    if (traversal_depth > 0) {
+    if (traversal_depth > 0 && !data.consistency_checked) {
       const float cos_normal_error = fused_ref_normal.dot(normal);
       if (cos_normal_error < min_cos_normal_error_) {
         continue;
@@ -463,7 +786,12 @@ void StereoFusion::Fuse(const int thread_id,
             .value_or(BitmapColor<uint8_t>(0));
 
     // Set the current pixel as visited.
-    fused_pixel_mask.Set(row, col, 1);
+    if (claimed_pixels == nullptr) {
+      fused_pixel_mask.Set(row, col, 1);
+    } else {
+      claimed_pixels->insert(PixelKey(image_idx, row, col));
+      seed->accesses.push_back({image_idx, row, col, true, true});
+    }
 
     // Pixels out of bounds are filtered
     if (xyz(0) < options_.bounding_box.first(0) ||
@@ -501,6 +829,24 @@ void StereoFusion::Fuse(const int thread_id,
       continue;
     }
 
+    // The consistent pixels of the reference pixel were checked on the GPU.
+    if (traversal_depth == 0 && use_gpu_) {
+      for (size_t i = 0; i < ref_src_image_idxs_.size(); ++i) {
+        const int pixel_idx = ref_consistent_pixels_.Get(row, col, i);
+        if (pixel_idx < 0) {
+          continue;
+        }
+        const int next_image_idx = ref_src_image_idxs_[i];
+        const int next_width = depth_map_sizes_.at(next_image_idx).first;
+        fusion_queue.emplace_back(next_image_idx,
+                                  pixel_idx / next_width,
+                                  pixel_idx % next_width,
+                                  traversal_depth + 1);
+        fusion_queue.back().consistency_checked = true;
+      }
+      continue;
+    }
+
     for (const auto next_image_idx : overlapping_images_.at(image_idx)) {
       if (!used_images_.at(next_image_idx) ||
           fused_images_.at(next_image_idx)) {
@@ -526,7 +872,7 @@ void StereoFusion::Fuse(const int thread_id,
 
   const size_t num_pixels = fused_point_x.size();
   if (num_pixels >= static_cast<size_t>(options_.min_num_pixels)) {
-    PlyPoint fused_point;
+    PlyPoint& fused_point = seed->point;
 
     Eigen::Vector3f fused_normal;
     fused_normal.x() = Median(fused_point_nx);
@@ -552,26 +898,44 @@ void StereoFusion::Fuse(const int thread_id,
     fused_point.b =
         TruncateCast<float, uint8_t>(std::round(Median(fused_point_b)));
 
-    task_fused_points_[thread_id].push_back(fused_point);
-    task_fused_points_visibility_[thread_id].emplace_back(
-        fused_point_visibility.begin(), fused_point_visibility.end());
+    seed->has_point = true;
+    seed->visibility.assign(fused_point_visibility.begin(),
+                            fused_point_visibility.end());
   }
 }
 
-void WritePointsVisibility(
-    const std::filesystem::path& path,
-    const std::vector<std::vector<int>>& points_visibility) {
-  std::fstream file(path, std::ios::out | std::ios::binary);
-  THROW_CHECK_FILE_OPEN(file, path);
-
-  WriteBinaryLittleEndian<uint64_t>(&file, points_visibility.size());
+PointsVisibilityWriter::PointsVisibilityWriter(
+    const std::filesystem::path& path)
+    : file_(path,
+            std::ios::in | std::ios::out | std::ios::binary |
+                std::ios::trunc) {
+  THROW_CHECK_FILE_OPEN(file_, path);
+  WriteBinaryLittleEndian<uint64_t>(&file_, num_points_);
+  file_.flush();
+}
 
+void PointsVisibilityWriter::Write(
+    const std::vector<std::vector<int>>& points_visibility) {
+  file_.seekp(0, std::ios::end);
   for (const auto& visibility : points_visibility) {
-    WriteBinaryLittleEndian<uint32_t>(&file, visibility.size());
+    WriteBinaryLittleEndian<uint32_t>(&file_, visibility.size());
     for (const auto& image_idx : visibility) {
-      WriteBinaryLittleEndian<uint32_t>(&file, image_idx);
+      WriteBinaryLittleEndian<uint32_t>(&file_, image_idx);
     }
   }
+
+  num_points_ += points_visibility.size();
+  file_.seekp(0);
+  WriteBinaryLittleEndian<uint64_t>(&file_, num_points_);
+  file_.flush();
+  THROW_CHECK(file_.good());
+}
+
+void WritePointsVisibility(
+    const std::filesystem::path& path,
+    const std::vector<std::vector<int>>& points_visibility) {
+  PointsVisibilityWriter writer(path);
+  writer.Write(points_visibility);
 }
 
 std::vector<std::vector<int>> ReadPointsVisibility(
@@ -594,5 +958,140 @@ std::vector<std::vector<int>> ReadPointsVisibility(
   return visibility;
 }
 
+void MergeFusedPoints(double radius_factor,
+                      const std::vector<float>& footprints,
+                      std::vector<PlyPoint>* points,
+                      std::vector<std::vector<int>>* points_visibility,
+                      int num_threads) {
+  THROW_CHECK_GT(radius_factor, 0);
+  THROW_CHECK_NOTNULL(points);
+  THROW_CHECK_NOTNULL(points_visibility);
+  THROW_CHECK_EQ(footprints.size(), points->size());
+  THROW_CHECK_EQ(points_visibility->size(), points->size());
+
+  // Hash the points into the cells of the grid of their scale level. Points
+  // without valid footprint get a unique cell in an invalid level.
+  struct Cell {
+    int level;
+    int64_t x;
+    int64_t y;
+    int64_t z;
+    int64_t point_idx;
+    bool operator<(const Cell& other) const {
+      return std::tie(level, x, y, z, point_idx) <
+             std::tie(other.level, other.x, other.y, other.z, other.point_idx);
+    }
+    bool SameCell(const Cell& other) const {
+      return level == other.level && x == other.x && y == other.y &&
+             z == other.z;
+    }
+  };
+
+  const int64_t num_points = points->size();
+  std::vector<Cell> cells(num_points);
+  ParallelFor(
+      0,
+      num_points,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          Cell& cell = cells[i];
+          cell.point_idx = i;
+          const double radius = radius_factor * footprints[i];
+          const PlyPoint& point = (*points)[i];
+          if (!(radius > 0) || !std::isfinite(radius)) {
+            cell.level = std::numeric_limits<int>::max();
+            cell.x = i;
+            cell.y = 0;
+            cell.z = 0;
+            continue;
+          }
+          cell.level = static_cast<int>(std::ceil(std::log2(radius)));
+          const double inv_size = std::ldexp(1.0, -cell.level);
+          cell.x = static_cast<int64_t>(std::floor(point.x * inv_size));
+          cell.y = static_cast<int64_t>(std::floor(point.y * inv_size));
+          cell.z = static_cast<int64_t>(std::floor(point.z * inv_size));
+        }
+      },
+      num_threads);
+
+  std::sort(cells.begin(), cells.end());
+
+  // Ranges of points in the same cell, ordered by their first point.
+  std::vector<std::pair<int64_t, int64_t>> groups;
+  for (int64_t begin = 0; begin < num_points;) {
+    int64_t end = begin + 1;
+    while (end < num_points && cells[end].SameCell(cells[begin])) {
+      ++end;
+    }
+    groups.emplace_back(begin, end);
+    begin = end;
+  }
+  std::sort(groups.begin(),
+            groups.end(),
+            [&cells](const auto& group1, const auto& group2) {
+              return cells[group1.first].point_idx <
+                     cells[group2.first].point_idx;
+            });
+
+  std::vector<PlyPoint> merged_points(groups.size());
+  std::vector<std::vector<int>> merged_visibility(groups.size());
+  ParallelFor(
+      0,
+      groups.size(),
+      [&](int64_t begin, int64_t end) {
+        for (int64_t group_idx = begin; group_idx < end; ++group_idx) {
+          const auto [cell_begin, cell_end] = groups[group_idx];
+          std::vector<int>& visibility = merged_visibility[group_idx];
+          if (cell_end - cell_begin == 1) {
+            const int64_t point_idx = cells[cell_begin].point_idx;
+            merged_points[group_idx] = (*points)[point_idx];
+            visibility = std::move((*points_visibility)[point_idx]);
+            continue;
+          }
+
+          Eigen::Vector3d xyz = Eigen::Vector3d::Zero();
+          Eigen::Vector3d normal = Eigen::Vector3d::Zero();
+          Eigen::Vector3d color = Eigen::Vector3d::Zero();
+          for (int64_t i = cell_begin; i < cell_end; ++i) {
+            const int64_t point_idx = cells[i].point_idx;
+            const PlyPoint& point = (*points)[point_idx];
+            xyz += Eigen::Vector3d(point.x, point.y, point.z);
+            normal += Eigen::Vector3d(point.nx, point.ny, point.nz);
+            color += Eigen::Vector3d(point.r, point.g, point.b);
+            const auto& point_visibility = (*points_visibility)[point_idx];
+            visibility.insert(visibility.end(),
+                              point_visibility.begin(),
+                              point_visibility.end());
+          }
+          std::sort(visibility.begin(), visibility.end());
+          visibility.erase(std::unique(visibility.begin(), visibility.end()),
+                           visibility.end());
+
+          const double inv_num_points = 1.0 / (cell_end - cell_begin);
+          xyz *= inv_num_points;
+          color *= inv_num_points;
+          const double normal_norm = normal.norm();
+          if (normal_norm > 0) {
+            normal /= normal_norm;
+          }
+
+          PlyPoint& merged_point = merged_points[group_idx];
+          merged_point.x = static_cast<float>(xyz(0));
+          merged_point.y = static_cast<float>(xyz(1));
+          merged_point.z = static_cast<float>(xyz(2));
+          merged_point.nx = static_cast<float>(normal(0));
+          merged_point.ny = static_cast<float>(normal(1));
+          merged_point.nz = static_cast<float>(normal(2));
+          merged_point.r = TruncateCast<double, uint8_t>(std::round(color(0)));
+          merged_point.g = TruncateCast<double, uint8_t>(std::round(color(1)));
+          merged_point.b = TruncateCast<double, uint8_t>(std::round(color(2)));
+        }
+      },
+      num_threads);
+
+  *points = std::move(merged_points);
+  *points_visibility = std::move(merged_visibility);
+}
+
 }  // namespace mvs
 }  // namespace colmap
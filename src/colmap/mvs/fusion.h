@@ -36,7 +36,12 @@
 #include "colmap/util/ply.h"
 
 #include <cfloat>
+#include <cstdint>
 #include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_set>
 #include <vector>
 
 #include <Eigen/Core>
@@ -85,6 +90,44 @@ struct StereoFusionOptions {
   // consume a lot of memory, if the consistency graph is dense.
   double cache_size = 32.0;
 
+  // Whether to check the consistency of the reference pixels with the
+  // overlapping images on the GPU. The traversal beyond these pixels and the
+  // aggregation of the fused points remain on the CPU.
+  bool use_gpu = false;
+
+  // Index of the GPU used for fusion. Set to -1 to select the best GPU.
+  std::string gpu_index = "-1";
+
+  // If not empty, the fused points are written to this binary PLY file and
+  // their visibility to the same path with an additional ".vis" extension
+  // after every fused image, instead of keeping all of them in memory. In
+  // combination with `use_cache`, this bounds the memory usage for large
+  // scenes.
+  std::filesystem::path stream_output_path = "";
+
+  // If not empty, the fused points of a previous fusion of the same workspace
+  // are read from this PLY file and its ".vis" file and updated incrementally,
+  // e.g., after adding images to the workspace. Only the images, whose depth
+  // maps were written after the file, and the images observing their
+  // previously fused points are fused again. All other points are kept as is.
+  // The path may be the same as the output path.
+  std::filesystem::path input_fused_path = "";
+
+  // Optional directory, e.g., on a local SSD, into which the cached data
+  // evicted from memory is spilled in combination with `use_cache`, up to
+  // spill_cache_size gigabytes. Later cache misses are served from the spilled
+  // files, which avoids repeated reads of the workspace from slow storage.
+  std::filesystem::path spill_cache_path = "";
+  double spill_cache_size = 64.0;
+
+  // If positive, fused points within the same cell of a scale-adaptive voxel
+  // grid are merged into a single point with the union of their visibility.
+  // The cell size of a point is this factor times its footprint, i.e., the
+  // size of a pixel at its depth in the closest observing image, rounded up
+  // to a power of two. This reduces the input size of the meshers. With
+  // `stream_output_path`, only the points of each streamed chunk are merged.
+  double merge_radius = 0.0;
+
   std::pair<Eigen::Vector3f, Eigen::Vector3f> bounding_box =
       std::make_pair(Eigen::Vector3f(-FLT_MAX, -FLT_MAX, -FLT_MAX),
                      Eigen::Vector3f(FLT_MAX, FLT_MAX, FLT_MAX));
@@ -96,7 +139,33 @@ struct StereoFusionOptions {
   void Print() const;
 };
 
+// Write the visibility information in chunks into a binary file with the
+// format of WritePointsVisibility. The number of points is updated after every
+// chunk, so that the file is always valid.
+class PointsVisibilityWriter {
+ public:
+  explicit PointsVisibilityWriter(const std::filesystem::path& path);
+
+  // Append the visibility of the points to the file.
+  void Write(const std::vector<std::vector<int>>& points_visibility);
+
+  inline size_t NumPoints() const { return num_points_; }
+
+ private:
+  std::fstream file_;
+  size_t num_points_ = 0;
+};
+
 // Fuses per-view depth and normal maps into a consistent 3D point cloud.
+//
+// The pixels of each image are fused in tiles, which are processed
+// concurrently against the fused pixel masks at the start of a batch of tiles.
+// The tile results are then committed in a fixed order. A fusion is only
+// committed as is, if none of the fused pixel masks it depends on were
+// changed by previously committed fusions, e.g., where tiles meet. Otherwise,
+// it is repeated against the updated masks. The fused points are hence
+// identical to fusing all tiles sequentially and do not depend on the number
+// of threads.
 class StereoFusion : public BaseController {
  public:
   StereoFusion(const StereoFusionOptions& options,
@@ -105,7 +174,8 @@ class StereoFusion : public BaseController {
                const std::string& pmvs_option_name,
                const std::string& input_type);
 
-  // Get the fused 3D points as PLY points.
+  // Get the fused 3D points as PLY points. Points streamed to disk are not
+  // included, i.e., the result is empty if `stream_output_path` is set.
   const std::vector<PlyPoint>& GetFusedPoints() const;
   // Get per-point visibility lists (indices of images that observe each point).
   const std::vector<std::vector<int>>& GetFusedPointsVisibility() const;
@@ -114,8 +184,59 @@ class StereoFusion : public BaseController {
   void Run();
 
  private:
+  // Access of a fusion to the fused pixel masks.
+  struct PixelAccess {
+    int image_idx = -1;
+    int row = -1;
+    int col = -1;
+    // Whether the pixel was set to fused. Otherwise, the pixel was read.
+    bool write = false;
+    // The value of the read pixel.
+    bool fused = false;
+  };
+
+  // Result of fusing a seed pixel.
+  struct SeedFusion {
+    int row = -1;
+    int col = -1;
+    bool has_point = false;
+    PlyPoint point;
+    std::vector<int> visibility;
+    // Accesses that must be validated before committing a speculative fusion.
+    std::vector<PixelAccess> accesses;
+  };
+
   void InitFusedPixelMask(int image_idx, size_t width, size_t height);
-  void Fuse(int thread_id, int image_idx, int row, int col);
+
+  // Read the points of a previous fusion, keep the points that are not
+  // observed by any changed image, and select the images to fuse again. The
+  // pixels of the kept points are marked as fused.
+  void ReadInputFusedPoints();
+
+  // Check the consistency of the pixels of the reference image with the
+  // overlapping images on the GPU before fusing its pixels.
+  void CheckConsistencyOnGpu(int image_idx);
+
+  // Speculatively fuse all unfused pixels of the tile in the reference image.
+  void FuseTile(int image_idx, int tile_idx, std::vector<SeedFusion>* seeds);
+
+  // Commit the speculative fusion of a seed pixel or repeat it, if any of the
+  // accessed pixels changed since.
+  void CommitSeed(int image_idx, SeedFusion* seed);
+
+  // Fuse the pixel with all consistent pixels in the overlapping images. If
+  // `claimed_pixels` is not null, the fusion is speculative and does not
+  // modify the fused pixel masks. Instead, fused pixels are added to
+  // `claimed_pixels` and all accesses, which may change before the fusion is
+  // committed, are recorded in the seed.
+  void Fuse(int image_idx,
+            int row,
+            int col,
+            std::unordered_set<uint64_t>* claimed_pixels,
+            SeedFusion* seed);
+
+  // Merge the fused points in memory, if enabled by `merge_radius`.
+  void MergeFusedPoints();
 
   const StereoFusionOptions options_;
   const std::filesystem::path workspace_path_;
@@ -127,6 +248,9 @@ class StereoFusion : public BaseController {
 
   std::unique_ptr<Workspace> workspace_;
   std::vector<char> used_images_;
+  // The used images, whose pixels are fused as reference pixels. All other
+  // used images are only visited as overlapping images.
+  std::vector<char> seed_images_;
   std::vector<char> fused_images_;
   std::vector<std::vector<int>> overlapping_images_;
   // Contains image masks of pre-masked and already fused pixels.
@@ -138,11 +262,19 @@ class StereoFusion : public BaseController {
   std::vector<Eigen::Matrix<float, 3, 4, Eigen::RowMajor>> inv_P_;
   std::vector<Eigen::Matrix<float, 3, 3, Eigen::RowMajor>> inv_R_;
 
+  // Consistent pixels of the reference image in its overlapping source
+  // images, if checked on the GPU. See ComputeFusionConsistencyCuda.
+  bool use_gpu_ = false;
+  std::vector<int> ref_src_image_idxs_;
+  Mat<int> ref_consistent_pixels_;
+
   struct FusionData {
     int image_idx = kInvalidImageId;
     int row = 0;
     int col = 0;
     int traversal_depth = -1;
+    // Whether the consistency with the reference point was already checked.
+    bool consistency_checked = false;
     FusionData(int image_idx, int row, int col, int traversal_depth)
         : image_idx(image_idx),
           row(row),
@@ -153,12 +285,11 @@ class StereoFusion : public BaseController {
     }
   };
 
-  // Already fused points.
+  // Already fused points, which were not yet streamed to disk.
   std::vector<PlyPoint> fused_points_;
   std::vector<std::vector<int>> fused_points_visibility_;
-
-  std::vector<std::vector<PlyPoint>> task_fused_points_;
-  std::vector<std::vector<std::vector<int>>> task_fused_points_visibility_;
+  std::unique_ptr<BinaryPlyPointsWriter> fused_points_writer_;
+  std::unique_ptr<PointsVisibilityWriter> fused_points_visibility_writer_;
 };
 
 // Write the visibility information into a binary file of the following format:
@@ -183,5 +314,18 @@ void WritePointsVisibility(
 std::vector<std::vector<int>> ReadPointsVisibility(
     const std::filesystem::path& path, size_t num_points);
 
+// Merge the points, which fall into the same cell of a spatial hash grid, into
+// a single point with the mean position, normal, and color and the union of
+// their visibility. The cell size of each point is `radius_factor` times its
+// footprint rounded up to the next power of two, so that points of similar
+// scale share the same grid. Points with non-positive or non-finite footprint
+// are kept as is. The merged points are ordered by their first original point
+// and the result does not depend on the number of threads.
+void MergeFusedPoints(double radius_factor,
+                      const std::vector<float>& footprints,
+                      std::vector<PlyPoint>* points,
+                      std::vector<std::vector<int>>* points_visibility,
+                      int num_threads = -1);
+
 }  // namespace mvs
 }  // namespace colmap
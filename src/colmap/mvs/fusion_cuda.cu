@@ -0,0 +1,213 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/mvs/fusion_cuda.h"
+
+#include "colmap/mvs/gpu_mat.h"
+#include "colmap/util/cudacc.h"
+
+#include <cmath>
+
+namespace colmap {
+namespace mvs {
+namespace {
+
+// Dimensions of the pixel tile processed by one thread block.
+constexpr int kBlockDimX = 32;
+constexpr int kBlockDimY = 16;
+
+// Trivially copyable projection matrices, which can be passed to kernels.
+struct Projection {
+  float P[12];
+  float inv_P[12];
+  float inv_R[9];
+};
+
+Projection GetProjection(const FusionCudaImage& image) {
+  Projection projection;
+  for (int i = 0; i < 12; ++i) {
+    projection.P[i] = image.P[i];
+    projection.inv_P[i] = image.inv_P[i];
+  }
+  for (int i = 0; i < 9; ++i) {
+    projection.inv_R[i] = image.inv_R[i];
+  }
+  return projection;
+}
+
+__device__ inline void Mat34DotVec4(const float mat[12],
+                                    const float vec[4],
+                                    float result[3]) {
+  for (int r = 0; r < 3; ++r) {
+    result[r] = mat[4 * r + 0] * vec[0] + mat[4 * r + 1] * vec[1] +
+                mat[4 * r + 2] * vec[2] + mat[4 * r + 3] * vec[3];
+  }
+}
+
+__device__ inline void Mat33DotVec3(const float mat[9],
+                                    const float vec[3],
+                                    float result[3]) {
+  for (int r = 0; r < 3; ++r) {
+    result[r] = mat[3 * r + 0] * vec[0] + mat[3 * r + 1] * vec[1] +
+                mat[3 * r + 2] * vec[2];
+  }
+}
+
+__global__ void CheckConsistency(const GpuMatView<float> ref_depth_map,
+                                 const GpuMatView<float> ref_normal_map,
+                                 const GpuMatView<float> src_depth_map,
+                                 const GpuMatView<float> src_normal_map,
+                                 const Projection ref_projection,
+                                 const Projection src_projection,
+                                 const int src_image_idx,
+                                 const float max_squared_reproj_error,
+                                 const float max_depth_error,
+                                 const float min_cos_normal_error,
+                                 GpuMatView<int> consistent_pixels) {
+  const int col = blockDim.x * blockIdx.x + threadIdx.x;
+  const int row = blockDim.y * blockIdx.y + threadIdx.y;
+  if (col >= static_cast<int>(ref_depth_map.GetWidth()) ||
+      row >= static_cast<int>(ref_depth_map.GetHeight())) {
+    return;
+  }
+
+  consistent_pixels.Set(row, col, src_image_idx, -1);
+
+  const float depth = ref_depth_map.Get(row, col);
+  if (depth <= 0.0f) {
+    return;
+  }
+
+  // Reference point and normal in the global frame.
+  const float ref_pixel[4] = {col * depth, row * depth, depth, 1.0f};
+  float xyz[4];
+  Mat34DotVec4(ref_projection.inv_P, ref_pixel, xyz);
+  xyz[3] = 1.0f;
+  float ref_normal[3];
+  ref_normal_map.GetSlice(row, col, ref_normal);
+  float normal[3];
+  Mat33DotVec3(ref_projection.inv_R, ref_normal, normal);
+
+  float proj[3];
+  Mat34DotVec4(src_projection.P, xyz, proj);
+  const int src_col = static_cast<int>(roundf(proj[0] / proj[2]));
+  const int src_row = static_cast<int>(roundf(proj[1] / proj[2]));
+  const int src_width = static_cast<int>(src_depth_map.GetWidth());
+  const int src_height = static_cast<int>(src_depth_map.GetHeight());
+  if (src_col < 0 || src_row < 0 || src_col >= src_width ||
+      src_row >= src_height) {
+    return;
+  }
+
+  const float src_depth = src_depth_map.Get(src_row, src_col);
+  if (src_depth <= 0.0f) {
+    return;
+  }
+
+  const float depth_error = fabsf((proj[2] - src_depth) / src_depth);
+  if (depth_error > max_depth_error) {
+    return;
+  }
+
+  const float col_diff = proj[0] / proj[2] - src_col;
+  const float row_diff = proj[1] / proj[2] - src_row;
+  if (col_diff * col_diff + row_diff * row_diff > max_squared_reproj_error) {
+    return;
+  }
+
+  float src_normal[3];
+  src_normal_map.GetSlice(src_row, src_col, src_normal);
+  float src_global_normal[3];
+  Mat33DotVec3(src_projection.inv_R, src_normal, src_global_normal);
+  const float cos_normal_error = normal[0] * src_global_normal[0] +
+                                 normal[1] * src_global_normal[1] +
+                                 normal[2] * src_global_normal[2];
+  if (cos_normal_error < min_cos_normal_error) {
+    return;
+  }
+
+  consistent_pixels.Set(row, col, src_image_idx, src_row * src_width + src_col);
+}
+
+}  // namespace
+
+Mat<int> ComputeFusionConsistencyCuda(
+    const FusionCudaImage& ref_image,
+    const std::vector<FusionCudaImage>& src_images,
+    const float max_squared_reproj_error,
+    const float max_depth_error,
+    const float min_cos_normal_error) {
+  if (src_images.empty()) {
+    return Mat<int>(ref_image.width, ref_image.height, 0);
+  }
+
+  GpuMat<float> ref_depth_map(ref_image.width, ref_image.height, 1);
+  ref_depth_map.CopyToDevice(ref_image.depth_map,
+                             ref_image.width * sizeof(float));
+  GpuMat<float> ref_normal_map(ref_image.width, ref_image.height, 3);
+  ref_normal_map.CopyToDevice(ref_image.normal_map,
+                              ref_image.width * sizeof(float));
+  const Projection ref_projection = GetProjection(ref_image);
+
+  GpuMat<int> consistent_pixels(
+      ref_image.width, ref_image.height, src_images.size());
+
+  const dim3 block_size(kBlockDimX, kBlockDimY);
+  const dim3 grid_size((ref_image.width + kBlockDimX - 1) / kBlockDimX,
+                       (ref_image.height + kBlockDimY - 1) / kBlockDimY);
+
+  for (size_t i = 0; i < src_images.size(); ++i) {
+    const FusionCudaImage& src_image = src_images[i];
+    GpuMat<float> src_depth_map(src_image.width, src_image.height, 1);
+    src_depth_map.CopyToDevice(src_image.depth_map,
+                               src_image.width * sizeof(float));
+    GpuMat<float> src_normal_map(src_image.width, src_image.height, 3);
+    src_normal_map.CopyToDevice(src_image.normal_map,
+                                src_image.width * sizeof(float));
+
+    CheckConsistency<<<grid_size, block_size>>>(ref_depth_map.View(),
+                                                ref_normal_map.View(),
+                                                src_depth_map.View(),
+                                                src_normal_map.View(),
+                                                ref_projection,
+                                                GetProjection(src_image),
+                                                static_cast<int>(i),
+                                                max_squared_reproj_error,
+                                                max_depth_error,
+                                                min_cos_normal_error,
+                                                consistent_pixels.View());
+    CUDA_SYNC_AND_CHECK();
+  }
+
+  return consistent_pixels.CopyToMat();
+}
+
+}  // namespace mvs
+}  // namespace colmap
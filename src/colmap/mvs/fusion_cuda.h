@@ -0,0 +1,65 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "colmap/mvs/mat.h"
+
+#include <vector>
+
+namespace colmap {
+namespace mvs {
+
+// Depth and normal map of an image in the layout of Mat<float> together with
+// its projection matrices in row-major order.
+struct FusionCudaImage {
+  int width = 0;
+  int height = 0;
+  const float* depth_map = nullptr;
+  const float* normal_map = nullptr;
+  float P[12];
+  float inv_P[12];
+  float inv_R[9];
+};
+
+// Check on the GPU, whether the pixels of the reference image are consistent
+// with the pixels of the source images onto which they project, using the
+// same criteria as the first step of the traversal in StereoFusion. Returns a
+// map with one slice per source image, which contains the index
+// row * width + col of the consistent pixel in the source image or -1.
+Mat<int> ComputeFusionConsistencyCuda(
+    const FusionCudaImage& ref_image,
+    const std::vector<FusionCudaImage>& src_images,
+    float max_squared_reproj_error,
+    float max_depth_error,
+    float min_cos_normal_error);
+
+}  // namespace mvs
+}  // namespace colmap
@@ -34,7 +34,12 @@
 #include "colmap/util/file.h"
 #include "colmap/util/testing.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
 #include <fstream>
+#include <limits>
 
 #include <gtest/gtest.h>
 
@@ -42,55 +47,94 @@ namespace colmap {
 namespace mvs {
 namespace {
 
-TEST(StereoFusion, Integration) {
-  const auto temp_dir = CreateTestDir();
+// Writes a synthetic reconstruction with the given number of images to the
+// workspace. The depth and normal maps are either constant or a rendering of
+// a sphere around the origin, which is consistent across all images.
+void CreateFusionWorkspace(const std::filesystem::path& temp_dir,
+                           int num_frames,
+                           int width,
+                           int height,
+                           bool render_sphere) {
   CreateDirIfNotExists(temp_dir / "sparse");
   CreateDirIfNotExists(temp_dir / "images");
   CreateDirIfNotExists(temp_dir / "stereo");
   CreateDirIfNotExists(temp_dir / "stereo" / "depth_maps");
   CreateDirIfNotExists(temp_dir / "stereo" / "normal_maps");
 
-  // Create synthetic reconstruction with 2 overlapping images.
+  // Create synthetic reconstruction with overlapping images.
   SyntheticDatasetOptions synthetic_dataset_options;
   synthetic_dataset_options.num_rigs = 1;
   synthetic_dataset_options.num_cameras_per_rig = 1;
-  synthetic_dataset_options.num_frames_per_rig = 2;
-  synthetic_dataset_options.camera_width = 30;
-  synthetic_dataset_options.camera_height = 20;
+  synthetic_dataset_options.num_frames_per_rig = num_frames;
+  synthetic_dataset_options.camera_width = width;
+  synthetic_dataset_options.camera_height = height;
+  synthetic_dataset_options.camera_params = {
+      1.25 * width, 0.5 * width, 0.5 * height, 0.0};
   Reconstruction reconstruction;
   SynthesizeDataset(synthetic_dataset_options, &reconstruction);
   reconstruction.Write(temp_dir / "sparse");
 
-  // Create depth maps, normal maps, and consistency graphs for both images.
+  double sphere_radius = std::numeric_limits<double>::max();
+  for (const auto& [image_id, image] : reconstruction.Images()) {
+    sphere_radius =
+        std::min(sphere_radius, 0.3 * image.ProjectionCenter().norm());
+  }
+
+  // Create depth maps, normal maps, and consistency graphs for all images.
   std::vector<std::string> image_names;
   for (const auto& [image_id, image] : reconstruction.Images()) {
     image_names.push_back(image.Name());
 
-    // Create depth map with constant depth.
-    Mat<float> depth_map(synthetic_dataset_options.camera_width,
-                         synthetic_dataset_options.camera_height,
-                         1);
+    // Create constant depth map and normal map pointing in z direction.
+    Mat<float> depth_map(width, height, 1);
     depth_map.Fill(5.0f);
-    depth_map.Write(temp_dir / "stereo" / "depth_maps" /
-                    (image.Name() + ".geometric.bin"));
-
-    // Create normal map pointing in z direction.
-    Mat<float> normal_map(synthetic_dataset_options.camera_width,
-                          synthetic_dataset_options.camera_height,
-                          3);
+    Mat<float> normal_map(width, height, 3);
     const size_t num_pixels = normal_map.GetHeight() * normal_map.GetWidth();
     for (size_t i = 0; i < num_pixels; ++i) {
       normal_map.GetPtr()[3 * i + 0] = 0.0f;  // nx
       normal_map.GetPtr()[3 * i + 1] = 0.0f;  // ny
       normal_map.GetPtr()[3 * i + 2] = 1.0f;  // nz
     }
+
+    if (render_sphere) {
+      const Rigid3d cam_from_world = image.CamFromWorld();
+      const Eigen::Vector3d center = image.ProjectionCenter();
+      const Eigen::Matrix3d inv_K =
+          image.CameraPtr()->CalibrationMatrix().inverse();
+      for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+          // Intersect the ray with the sphere, where the ray direction has
+          // unit depth in the camera frame.
+          const Eigen::Vector3d ray =
+              cam_from_world.rotation().inverse() *
+              (inv_K * Eigen::Vector3d(col, row, 1));
+          const double a = ray.squaredNorm();
+          const double b = 2 * ray.dot(center);
+          const double c =
+              center.squaredNorm() - sphere_radius * sphere_radius;
+          const double discriminant = b * b - 4 * a * c;
+          if (discriminant < 0) {
+            depth_map.Set(row, col, 0.0f);
+            continue;
+          }
+          const double depth = (-b - std::sqrt(discriminant)) / (2 * a);
+          depth_map.Set(row, col, depth);
+          const Eigen::Vector3d normal =
+              cam_from_world.rotation() * (center + depth * ray).normalized();
+          for (int d = 0; d < 3; ++d) {
+            normal_map.Set(row, col, d, normal(d));
+          }
+        }
+      }
+    }
+
+    depth_map.Write(temp_dir / "stereo" / "depth_maps" /
+                    (image.Name() + ".geometric.bin"));
     normal_map.Write(temp_dir / "stereo" / "normal_maps" /
                      (image.Name() + ".geometric.bin"));
 
     // Create bitmap.
-    Bitmap bitmap(synthetic_dataset_options.camera_width,
-                  synthetic_dataset_options.camera_height,
-                  true);
+    Bitmap bitmap(width, height, true);
     bitmap.Fill(BitmapColor<uint8_t>(0, 64, 128));
     bitmap.Write(temp_dir / "images" / image.Name());
   }
@@ -101,6 +145,15 @@ TEST(StereoFusion, Integration) {
     fusion_cfg << name << "\n";
   }
   fusion_cfg.close();
+}
+
+TEST(StereoFusion, Integration) {
+  const auto temp_dir = CreateTestDir();
+  CreateFusionWorkspace(temp_dir,
+                        /*num_frames=*/2,
+                        /*width=*/30,
+                        /*height=*/20,
+                        /*render_sphere=*/false);
 
   // Run fusion
   StereoFusionOptions options;
@@ -139,6 +192,210 @@ TEST(StereoFusion, Integration) {
   }
 }
 
+TEST(StereoFusion, IndependentOfNumThreads) {
+  const auto temp_dir = CreateTestDir();
+  // Multiple tiles per image, so that the fusions of different tiles overlap.
+  CreateFusionWorkspace(temp_dir,
+                        /*num_frames=*/3,
+                        /*width=*/100,
+                        /*height=*/80,
+                        /*render_sphere=*/true);
+
+  StereoFusionOptions options;
+  options.min_num_pixels = 1;
+  options.max_num_pixels = 50;
+  options.max_traversal_depth = 10;
+  options.check_num_images = 10;
+  options.use_cache = false;
+
+  options.num_threads = 1;
+  StereoFusion fusion1(options, temp_dir, "COLMAP", "", "geometric");
+  fusion1.Run();
+
+  options.num_threads = 4;
+  StereoFusion fusion4(options, temp_dir, "COLMAP", "", "geometric");
+  fusion4.Run();
+
+  const auto& fused_points1 = fusion1.GetFusedPoints();
+  const auto& fused_points4 = fusion4.GetFusedPoints();
+  ASSERT_GT(fused_points1.size(), 0);
+  ASSERT_EQ(fused_points1.size(), fused_points4.size());
+  for (size_t i = 0; i < fused_points1.size(); ++i) {
+    EXPECT_EQ(fused_points1[i].x, fused_points4[i].x);
+    EXPECT_EQ(fused_points1[i].y, fused_points4[i].y);
+    EXPECT_EQ(fused_points1[i].z, fused_points4[i].z);
+  }
+  EXPECT_EQ(fusion1.GetFusedPointsVisibility(),
+            fusion4.GetFusedPointsVisibility());
+}
+
+TEST(StereoFusion, MergeRadius) {
+  const auto temp_dir = CreateTestDir();
+  CreateFusionWorkspace(temp_dir,
+                        /*num_frames=*/3,
+                        /*width=*/100,
+                        /*height=*/80,
+                        /*render_sphere=*/true);
+
+  StereoFusionOptions options;
+  options.min_num_pixels = 1;
+  options.max_num_pixels = 50;
+  options.max_traversal_depth = 10;
+  options.check_num_images = 10;
+  options.use_cache = false;
+
+  StereoFusion fusion(options, temp_dir, "COLMAP", "", "geometric");
+  fusion.Run();
+
+  options.merge_radius = 8;
+  StereoFusion merged_fusion(options, temp_dir, "COLMAP", "", "geometric");
+  merged_fusion.Run();
+
+  const auto& fused_points = fusion.GetFusedPoints();
+  const auto& merged_points = merged_fusion.GetFusedPoints();
+  const auto& merged_visibility = merged_fusion.GetFusedPointsVisibility();
+  ASSERT_GT(merged_points.size(), 0);
+  EXPECT_LT(merged_points.size(), fused_points.size());
+  EXPECT_EQ(merged_points.size(), merged_visibility.size());
+  for (const auto& visibility : merged_visibility) {
+    EXPECT_GT(visibility.size(), 0);
+    EXPECT_TRUE(std::is_sorted(visibility.begin(), visibility.end()));
+  }
+}
+
+TEST(StereoFusion, StreamOutput) {
+  const auto temp_dir = CreateTestDir();
+  CreateFusionWorkspace(temp_dir,
+                        /*num_frames=*/3,
+                        /*width=*/60,
+                        /*height=*/40,
+                        /*render_sphere=*/true);
+
+  StereoFusionOptions options;
+  options.min_num_pixels = 1;
+  options.max_num_pixels = 50;
+  options.max_traversal_depth = 10;
+  options.check_num_images = 10;
+
+  options.use_cache = false;
+  StereoFusion fusion(options, temp_dir, "COLMAP", "", "geometric");
+  fusion.Run();
+  const auto& fused_points = fusion.GetFusedPoints();
+  ASSERT_GT(fused_points.size(), 0);
+
+  options.use_cache = true;
+  options.stream_output_path = temp_dir / "fused.ply";
+  StereoFusion stream_fusion(options, temp_dir, "COLMAP", "", "geometric");
+  stream_fusion.Run();
+  EXPECT_TRUE(stream_fusion.GetFusedPoints().empty());
+  EXPECT_TRUE(stream_fusion.GetFusedPointsVisibility().empty());
+
+  const std::vector<PlyPoint> stream_fused_points =
+      ReadPly(options.stream_output_path);
+  ASSERT_EQ(stream_fused_points.size(), fused_points.size());
+  for (size_t i = 0; i < fused_points.size(); ++i) {
+    EXPECT_EQ(stream_fused_points[i].x, fused_points[i].x);
+    EXPECT_EQ(stream_fused_points[i].y, fused_points[i].y);
+    EXPECT_EQ(stream_fused_points[i].z, fused_points[i].z);
+  }
+  EXPECT_EQ(ReadPointsVisibility(
+                AddFileExtension(options.stream_output_path, ".vis"),
+                fused_points.size()),
+            fusion.GetFusedPointsVisibility());
+}
+
+TEST(StereoFusion, IncrementalInput) {
+  const auto temp_dir = CreateTestDir();
+  CreateFusionWorkspace(temp_dir,
+                        /*num_frames=*/3,
+                        /*width=*/60,
+                        /*height=*/40,
+                        /*render_sphere=*/true);
+
+  StereoFusionOptions options;
+  options.min_num_pixels = 1;
+  options.max_num_pixels = 50;
+  options.max_traversal_depth = 10;
+  options.check_num_images = 10;
+  options.use_cache = false;
+
+  StereoFusion fusion(options, temp_dir, "COLMAP", "", "geometric");
+  fusion.Run();
+  const auto& fused_points = fusion.GetFusedPoints();
+  const auto& fused_points_visibility = fusion.GetFusedPointsVisibility();
+  ASSERT_GT(fused_points.size(), 0);
+
+  const auto fused_path = temp_dir / "fused.ply";
+  WriteBinaryPlyPoints(fused_path, fused_points);
+  WritePointsVisibility(AddFileExtension(fused_path, ".vis"),
+                        fused_points_visibility);
+
+  // Without any changed depth maps, all input points are kept.
+  options.input_fused_path = fused_path;
+  StereoFusion unchanged_fusion(options, temp_dir, "COLMAP", "", "geometric");
+  unchanged_fusion.Run();
+  ASSERT_EQ(unchanged_fusion.GetFusedPoints().size(), fused_points.size());
+  for (size_t i = 0; i < fused_points.size(); ++i) {
+    EXPECT_EQ(unchanged_fusion.GetFusedPoints()[i].x, fused_points[i].x);
+    EXPECT_EQ(unchanged_fusion.GetFusedPoints()[i].y, fused_points[i].y);
+    EXPECT_EQ(unchanged_fusion.GetFusedPoints()[i].z, fused_points[i].z);
+  }
+  EXPECT_EQ(unchanged_fusion.GetFusedPointsVisibility(),
+            fused_points_visibility);
+
+  // The points of an image with a recomputed depth map are fused again.
+  const std::string changed_image_name =
+      ReadTextFileLines(temp_dir / "stereo" / "fusion.cfg").front();
+  const auto changed_depth_map_path = temp_dir / "stereo" / "depth_maps" /
+                                      (changed_image_name + ".geometric.bin");
+  std::filesystem::last_write_time(
+      changed_depth_map_path,
+      std::filesystem::last_write_time(fused_path) + std::chrono::seconds(1));
+
+  StereoFusion changed_fusion(options, temp_dir, "COLMAP", "", "geometric");
+  changed_fusion.Run();
+  const double num_points = fused_points.size();
+  const double num_changed_points = changed_fusion.GetFusedPoints().size();
+  EXPECT_NEAR(num_changed_points, num_points, 0.2 * num_points);
+  EXPECT_EQ(changed_fusion.GetFusedPoints().size(),
+            changed_fusion.GetFusedPointsVisibility().size());
+  for (const auto& visibility : changed_fusion.GetFusedPointsVisibility()) {
+    EXPECT_GT(visibility.size(), 0);
+  }
+}
+
+#if defined(COLMAP_CUDA_ENABLED)
+TEST(StereoFusion, Gpu) {
+  const auto temp_dir = CreateTestDir();
+  CreateFusionWorkspace(temp_dir,
+                        /*num_frames=*/3,
+                        /*width=*/100,
+                        /*height=*/80,
+                        /*render_sphere=*/true);
+
+  StereoFusionOptions options;
+  options.min_num_pixels = 1;
+  options.max_num_pixels = 50;
+  options.max_traversal_depth = 10;
+  options.check_num_images = 10;
+  options.use_cache = false;
+
+  options.use_gpu = false;
+  StereoFusion cpu_fusion(options, temp_dir, "COLMAP", "", "geometric");
+  cpu_fusion.Run();
+
+  options.use_gpu = true;
+  StereoFusion gpu_fusion(options, temp_dir, "COLMAP", "", "geometric");
+  gpu_fusion.Run();
+
+  // The GPU and CPU may round differently close to the thresholds.
+  const double num_cpu_points = cpu_fusion.GetFusedPoints().size();
+  const double num_gpu_points = gpu_fusion.GetFusedPoints().size();
+  ASSERT_GT(num_cpu_points, 0);
+  EXPECT_NEAR(num_gpu_points, num_cpu_points, 0.01 * num_cpu_points);
+}
+#endif  // COLMAP_CUDA_ENABLED
+
 TEST(ReadPointsVisibility, RoundTrip) {
   const auto test_dir = CreateTestDir();
   const auto vis_path = test_dir / "test.vis";
@@ -172,6 +429,46 @@ TEST(ReadPointsVisibility, SizeMismatch) {
   EXPECT_THROW(ReadPointsVisibility(vis_path, 5), std::invalid_argument);
 }
 
+TEST(MergeFusedPoints, Nominal) {
+  std::vector<PlyPoint> points(5);
+  points[0].x = 0.1f;
+  points[0].nx = 1;
+  points[0].r = 10;
+  points[1].x = 0.2f;
+  points[1].ny = 1;
+  points[1].r = 20;
+  // Neighboring cell.
+  points[2].x = 0.3f;
+  // No valid footprint.
+  points[3].x = 0.1f;
+  // Same position as the first point, but coarser scale.
+  points[4].x = 0.1f;
+  std::vector<std::vector<int>> visibility = {{2, 0}, {1, 2}, {3}, {4}, {5}};
+  const std::vector<float> footprints = {0.25f, 0.2f, 0.25f, 0.0f, 1.0f};
+
+  MergeFusedPoints(/*radius_factor=*/1, footprints, &points, &visibility);
+
+  ASSERT_EQ(points.size(), 4);
+  EXPECT_NEAR(points[0].x, 0.15f, 1e-6f);
+  EXPECT_NEAR(points[0].nx, std::sqrt(0.5f), 1e-6f);
+  EXPECT_NEAR(points[0].ny, std::sqrt(0.5f), 1e-6f);
+  EXPECT_EQ(points[0].r, 15);
+  EXPECT_EQ(points[1].x, 0.3f);
+  EXPECT_EQ(points[2].x, 0.1f);
+  EXPECT_EQ(points[3].x, 0.1f);
+  EXPECT_EQ(visibility,
+            (std::vector<std::vector<int>>{{0, 1, 2}, {3}, {4}, {5}}));
+}
+
+TEST(MergeFusedPoints, InvalidInput) {
+  std::vector<PlyPoint> points(2);
+  std::vector<std::vector<int>> visibility(2);
+  EXPECT_THROW(MergeFusedPoints(1, {1.0f}, &points, &visibility),
+               std::invalid_argument);
+  EXPECT_THROW(MergeFusedPoints(0, {1.0f, 1.0f}, &points, &visibility),
+               std::invalid_argument);
+}
+
 }  // namespace
 }  // namespace mvs
 }  // namespace colmap
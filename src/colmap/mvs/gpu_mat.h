@@ -30,6 +30,7 @@
 #pragma once
 
 #include "colmap/mvs/mat.h"
+#include "colmap/util/cuda.h"
 #include "colmap/util/cudacc.h"
 #include "colmap/util/endian.h"
 #include "colmap/util/logging.h"
@@ -185,15 +186,15 @@ class GpuMat {
 template <typename T>
 GpuMat<T>::GpuMat(const size_t width, const size_t height, const size_t depth)
     : array_ptr_(nullptr), width_(width), height_(height), depth_(depth) {
-  CUDA_SAFE_CALL(cudaMallocPitch(
-      (void**)&array_ptr_, &pitch_, width_ * sizeof(T), height_ * depth_));
+  array_ptr_ = static_cast<T*>(AllocateCudaMemoryPitch(
+      width_ * sizeof(T), height_ * depth_, "mvs", &pitch_));
 
   ComputeCudaConfig();
 }
 
 template <typename T>
 GpuMat<T>::~GpuMat() {
-  cudaFree(array_ptr_);
+  FreeCudaMemory(array_ptr_);
 }
 
 template <typename T>
@@ -398,13 +399,14 @@ void GpuMat<T>::FillWithScalar(const T value) {
 template <typename T>
 void GpuMat<T>::FillWithVector(const T* values) {
   T* values_device;
-  CUDA_SAFE_CALL(cudaMalloc((void**)&values_device, depth_ * sizeof(T)));
+  values_device =
+      static_cast<T*>(AllocateCudaMemory(depth_ * sizeof(T), "mvs"));
   CUDA_SAFE_CALL(cudaMemcpy(
       values_device, values, depth_ * sizeof(T), cudaMemcpyHostToDevice));
   internal::FillWithVectorKernel<T>
       <<<gridSize_, blockSize_>>>(values_device, View());
   CUDA_SYNC_AND_CHECK();
-  CUDA_SAFE_CALL(cudaFree(values_device));
+  FreeCudaMemory(values_device);
 }
 
 template <typename T>
@@ -94,6 +94,35 @@ void Image::Downsize(const size_t max_width, const size_t max_height) {
   Rescale(std::min(factor_x, factor_y));
 }
 
+Image Image::Crop(const size_t x,
+                  const size_t y,
+                  const size_t width,
+                  const size_t height) const {
+  THROW_CHECK_LE(x + width, width_);
+  THROW_CHECK_LE(y + height, height_);
+
+  float K[9];
+  memcpy(K, K_, 9 * sizeof(float));
+  K[2] -= x;
+  K[5] -= y;
+  Image image(path_, width, height, K, R_, T_);
+
+  if (!bitmap_.IsEmpty()) {
+    Bitmap bitmap(width, height, bitmap_.IsRGB());
+    const size_t channels = bitmap_.Channels();
+    const uint8_t* data = bitmap_.RowMajorData().data();
+    uint8_t* cropped_data = bitmap.RowMajorData().data();
+    for (size_t r = 0; r < height; ++r) {
+      memcpy(cropped_data + r * width * channels,
+             data + ((y + r) * width_ + x) * channels,
+             width * channels);
+    }
+    image.SetBitmap(std::move(bitmap));
+  }
+
+  return image;
+}
+
 void ComputeRelativePose(const float R1[9],
                          const float T1[3],
                          const float R2[9],
@@ -64,6 +64,10 @@ class Image {
   void Rescale(float factor_x, float factor_y);
   void Downsize(size_t max_width, size_t max_height);
 
+  // Extract the given region of the image, including its bitmap if loaded,
+  // with the principal point shifted accordingly.
+  Image Crop(size_t x, size_t y, size_t width, size_t height) const;
+
  private:
   std::filesystem::path path_;
   size_t width_ = 0;
@@ -29,6 +29,7 @@
 
 #include "colmap/mvs/image.h"
 
+#include <Eigen/Geometry>
 #include <gtest/gtest.h>
 
 namespace colmap {
@@ -133,6 +134,50 @@ TEST(Image, DownsizeNoChange) {
   EXPECT_EQ(image.GetHeight(), 100);
 }
 
+TEST(Image, Crop) {
+  const float K[9] = {100, 0, 50, 0, 100, 50, 0, 0, 1};
+  const float R[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  const float T[3] = {0, 0, 0};
+
+  Image image("test.jpg", 4, 3, K, R, T);
+  Bitmap bitmap(4, 3, /*as_rgb=*/false);
+  for (int y = 0; y < 3; ++y) {
+    for (int x = 0; x < 4; ++x) {
+      bitmap.SetPixel(x, y, BitmapColor<uint8_t>(10 * y + x));
+    }
+  }
+  image.SetBitmap(bitmap);
+
+  const Image cropped_image = image.Crop(1, 1, 2, 2);
+  EXPECT_EQ(cropped_image.GetWidth(), 2);
+  EXPECT_EQ(cropped_image.GetHeight(), 2);
+  EXPECT_EQ(cropped_image.GetPath(), "test.jpg");
+  EXPECT_FLOAT_EQ(cropped_image.GetK()[2], 49.0f);
+  EXPECT_FLOAT_EQ(cropped_image.GetK()[5], 49.0f);
+  ASSERT_EQ(cropped_image.GetBitmap().Width(), 2);
+  ASSERT_EQ(cropped_image.GetBitmap().Height(), 2);
+  for (int y = 0; y < 2; ++y) {
+    for (int x = 0; x < 2; ++x) {
+      EXPECT_EQ(cropped_image.GetBitmap().GetPixel(x, y)->r,
+                10 * (y + 1) + x + 1);
+    }
+  }
+
+  // The projection of a point is shifted by the crop offset.
+  const Eigen::Vector3f point(0.1f, -0.2f, 2.0f);
+  const Eigen::Map<const Eigen::Matrix<float, 3, 4, Eigen::RowMajor>> P(
+      image.GetP());
+  const Eigen::Map<const Eigen::Matrix<float, 3, 4, Eigen::RowMajor>>
+      cropped_P(cropped_image.GetP());
+  const Eigen::Vector2f proj = (P * point.homogeneous()).hnormalized();
+  const Eigen::Vector2f cropped_proj =
+      (cropped_P * point.homogeneous()).hnormalized();
+  EXPECT_NEAR(cropped_proj.x(), proj.x() - 1, 1e-4);
+  EXPECT_NEAR(cropped_proj.y(), proj.y() - 1, 1e-4);
+
+  EXPECT_ANY_THROW(image.Crop(3, 0, 2, 1));
+}
+
 TEST(Image, GetViewingDirection) {
   const float K[9] = {100, 0, 50, 0, 100, 50, 0, 0, 1};
   const float R[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
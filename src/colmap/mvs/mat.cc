@@ -31,18 +31,311 @@
 
 #include "colmap/util/endian.h"
 #include "colmap/util/file.h"
+#include "colmap/util/logging.h"
 
+#include <cmath>
+#include <cstring>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace colmap {
 namespace mvs {
+namespace {
+
+constexpr char kCompressedMagic[8] = {'C', 'O', 'L', 'M', 'A', 'P', 'M', 'Z'};
+constexpr uint32_t kCompressedVersion = 1;
+
+struct CompressedHeader {
+  size_t width = 0;
+  size_t height = 0;
+  size_t depth = 0;
+  size_t tile_size = 0;
+  bool quantize = false;
+  size_t num_tiles_x = 0;
+  size_t num_tiles_y = 0;
+  // Offsets of the tiles relative to the beginning of the tile data with an
+  // additional entry for the end of the last tile.
+  std::vector<uint64_t> tile_offsets;
+  std::streampos data_begin;
+
+  size_t TileIdx(const size_t slice,
+                 const size_t tile_y,
+                 const size_t tile_x) const {
+    return (slice * num_tiles_y + tile_y) * num_tiles_x + tile_x;
+  }
+};
+
+// Returns true if the stream starts with the magic of the compressed format.
+// Otherwise, the stream is rewound to its beginning.
+bool ReadCompressedMagic(std::istream* stream) {
+  char magic[sizeof(kCompressedMagic)];
+  stream->read(magic, sizeof(magic));
+  if (stream->gcount() == sizeof(magic) &&
+      std::equal(magic, magic + sizeof(magic), kCompressedMagic)) {
+    return true;
+  }
+  stream->clear();
+  stream->seekg(0);
+  return false;
+}
+
+CompressedHeader ReadCompressedHeader(std::istream* stream) {
+  CompressedHeader header;
+  const uint32_t version = ReadBinaryLittleEndian<uint32_t>(stream);
+  THROW_CHECK_EQ(version, kCompressedVersion);
+  header.width = ReadBinaryLittleEndian<uint64_t>(stream);
+  header.height = ReadBinaryLittleEndian<uint64_t>(stream);
+  header.depth = ReadBinaryLittleEndian<uint64_t>(stream);
+  header.tile_size = ReadBinaryLittleEndian<uint32_t>(stream);
+  header.quantize = ReadBinaryLittleEndian<uint8_t>(stream) != 0;
+  THROW_CHECK_GT(header.width, 0);
+  THROW_CHECK_GT(header.height, 0);
+  THROW_CHECK_GT(header.depth, 0);
+  THROW_CHECK_GT(header.tile_size, 0);
+  header.num_tiles_x = (header.width - 1) / header.tile_size + 1;
+  header.num_tiles_y = (header.height - 1) / header.tile_size + 1;
+  header.tile_offsets.resize(
+      header.depth * header.num_tiles_y * header.num_tiles_x + 1);
+  ReadBinaryLittleEndian<uint64_t>(stream, &header.tile_offsets);
+  header.data_begin = stream->tellg();
+  return header;
+}
+
+void AppendVarint(uint64_t value, std::string* data) {
+  while (value >= 0x80) {
+    data->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  data->push_back(static_cast<char>(value));
+}
+
+uint64_t ReadVarint(const std::string& data, size_t* pos) {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    THROW_CHECK_LT(*pos, data.size()) << "Truncated compressed tile";
+    const uint8_t byte = static_cast<uint8_t>(data[(*pos)++]);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  LOG(FATAL_THROW) << "Invalid varint in compressed tile";
+  return value;
+}
+
+uint32_t FloatToBits(const float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+float BitsToFloat(const uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+uint64_t ZigZagEncode(const int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigZagDecode(const uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Predicts the code at the given index from its causal neighbors using the
+// median edge detector of LOCO-I, which predicts planar regions exactly.
+// Zero codes represent zero values and are ignored as neighbors.
+int64_t PredictCode(const std::vector<int64_t>& codes,
+                    const size_t tile_width,
+                    const size_t idx,
+                    const int64_t last_code) {
+  const size_t col = idx % tile_width;
+  const int64_t a = col > 0 ? codes[idx - 1] : 0;
+  const int64_t b = idx >= tile_width ? codes[idx - tile_width] : 0;
+  const int64_t c = col > 0 && idx >= tile_width ? codes[idx - tile_width - 1]
+                                                 : 0;
+  if (a != 0 && b != 0 && c != 0) {
+    if (c >= std::max(a, b)) {
+      return std::min(a, b);
+    } else if (c <= std::min(a, b)) {
+      return std::max(a, b);
+    }
+    return a + b - c;
+  } else if (a != 0) {
+    return a;
+  } else if (b != 0) {
+    return b;
+  }
+  return last_code;
+}
+
+// Encodes the row-major values of a tile as codes, which are the bits of the
+// values for lossless tiles. Quantized tiles start with the range of the
+// non-zero values and use 16 bit codes relative to this range. Each value is
+// stored as a varint, which is zero for zero values and otherwise the
+// difference of the code to its prediction.
+std::string EncodeTile(const std::vector<float>& values,
+                       const size_t tile_width,
+                       const bool quantize) {
+  std::string data;
+  std::vector<int64_t> codes(values.size(), 0);
+  if (quantize) {
+    float min_value = std::numeric_limits<float>::max();
+    float max_value = std::numeric_limits<float>::lowest();
+    for (const float value : values) {
+      if (value != 0) {
+        min_value = std::min(min_value, value);
+        max_value = std::max(max_value, value);
+      }
+    }
+    if (min_value > max_value) {
+      min_value = max_value = 0;
+    }
+    AppendVarint(FloatToBits(min_value), &data);
+    AppendVarint(FloatToBits(max_value), &data);
+    const double scale =
+        max_value > min_value ? 65534.0 / (max_value - min_value) : 0.0;
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (values[i] != 0) {
+        codes[i] = 1 + static_cast<int64_t>(std::min(
+                           65534.0,
+                           std::round((values[i] - min_value) * scale)));
+      }
+    }
+  } else {
+    for (size_t i = 0; i < values.size(); ++i) {
+      codes[i] = FloatToBits(values[i]);
+    }
+  }
+
+  int64_t last_code = 0;
+  for (size_t i = 0; i < codes.size(); ++i) {
+    if (codes[i] == 0) {
+      AppendVarint(0, &data);
+    } else {
+      const int64_t pred = PredictCode(codes, tile_width, i, last_code);
+      AppendVarint(ZigZagEncode(codes[i] - pred) + 1, &data);
+      last_code = codes[i];
+    }
+  }
+
+  return data;
+}
+
+std::vector<float> DecodeTile(const std::string& data,
+                              const size_t tile_width,
+                              const size_t tile_height,
+                              const bool quantize) {
+  size_t pos = 0;
+  float min_value = 0;
+  float max_value = 0;
+  if (quantize) {
+    min_value = BitsToFloat(static_cast<uint32_t>(ReadVarint(data, &pos)));
+    max_value = BitsToFloat(static_cast<uint32_t>(ReadVarint(data, &pos)));
+  }
+  const double step =
+      max_value > min_value ? (max_value - min_value) / 65534.0 : 0.0;
+
+  std::vector<float> values(tile_width * tile_height, 0.0f);
+  std::vector<int64_t> codes(values.size(), 0);
+  int64_t last_code = 0;
+  for (size_t i = 0; i < codes.size(); ++i) {
+    const uint64_t symbol = ReadVarint(data, &pos);
+    if (symbol == 0) {
+      continue;
+    }
+    codes[i] = PredictCode(codes, tile_width, i, last_code) +
+               ZigZagDecode(symbol - 1);
+    last_code = codes[i];
+    if (quantize) {
+      values[i] = static_cast<float>(min_value + (codes[i] - 1) * step);
+    } else {
+      values[i] = BitsToFloat(static_cast<uint32_t>(codes[i]));
+    }
+  }
+
+  return values;
+}
+
+// Decodes the tiles of the compressed matrix overlapping the region and
+// copies the overlapping values into the region.
+void ReadCompressedRegion(std::istream* stream,
+                          const CompressedHeader& header,
+                          const size_t row,
+                          const size_t col,
+                          const size_t height,
+                          const size_t width,
+                          std::vector<float>* data) {
+  data->resize(width * height * header.depth);
+  const size_t tile_size = header.tile_size;
+  std::string tile_data;
+  for (size_t slice = 0; slice < header.depth; ++slice) {
+    for (size_t tile_y = row / tile_size; tile_y * tile_size < row + height;
+         ++tile_y) {
+      for (size_t tile_x = col / tile_size; tile_x * tile_size < col + width;
+           ++tile_x) {
+        const size_t tile_idx = header.TileIdx(slice, tile_y, tile_x);
+        const uint64_t tile_begin = header.tile_offsets.at(tile_idx);
+        const uint64_t tile_end = header.tile_offsets.at(tile_idx + 1);
+        THROW_CHECK_LE(tile_begin, tile_end);
+        tile_data.resize(tile_end - tile_begin);
+        stream->seekg(header.data_begin +
+                      static_cast<std::streamoff>(tile_begin));
+        stream->read(tile_data.data(), tile_data.size());
+        THROW_CHECK(stream->good()) << "Truncated compressed matrix";
+
+        const size_t tile_row = tile_y * tile_size;
+        const size_t tile_col = tile_x * tile_size;
+        const size_t tile_height =
+            std::min(tile_size, header.height - tile_row);
+        const size_t tile_width = std::min(tile_size, header.width - tile_col);
+        const std::vector<float> values =
+            DecodeTile(tile_data, tile_width, tile_height, header.quantize);
+
+        const size_t row_begin = std::max(row, tile_row);
+        const size_t row_end = std::min(row + height, tile_row + tile_height);
+        const size_t col_begin = std::max(col, tile_col);
+        const size_t col_end = std::min(col + width, tile_col + tile_width);
+        for (size_t r = row_begin; r < row_end; ++r) {
+          std::copy(
+              values.begin() + (r - tile_row) * tile_width +
+                  (col_begin - tile_col),
+              values.begin() + (r - tile_row) * tile_width +
+                  (col_end - tile_col),
+              data->begin() + (slice * height + r - row) * width +
+                  (col_begin - col));
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+bool MatCompressionOptions::Check() const {
+  CHECK_OPTION_GT(tile_size, 0);
+  return true;
+}
 
 template <>
 void Mat<float>::Read(const std::filesystem::path& path) {
   std::ifstream file(path, std::ios::binary);
   THROW_CHECK_FILE_OPEN(file, path);
 
+  if (ReadCompressedMagic(&file)) {
+    const CompressedHeader header = ReadCompressedHeader(&file);
+    width_ = header.width;
+    height_ = header.height;
+    depth_ = header.depth;
+    ReadCompressedRegion(&file, header, 0, 0, height_, width_, &data_);
+    return;
+  }
+
   char unused_char;
   file >> width_ >> unused_char >> height_ >> unused_char >> depth_ >>
       unused_char;
@@ -55,6 +348,62 @@ void Mat<float>::Read(const std::filesystem::path& path) {
   file.close();
 }
 
+template <>
+void Mat<float>::ReadRegion(const std::filesystem::path& path,
+                            const size_t row,
+                            const size_t col,
+                            const size_t height,
+                            const size_t width) {
+  std::ifstream file(path, std::ios::binary);
+  THROW_CHECK_FILE_OPEN(file, path);
+
+  size_t file_width;
+  size_t file_height;
+  size_t file_depth;
+  std::unique_ptr<CompressedHeader> header;
+  if (ReadCompressedMagic(&file)) {
+    header = std::make_unique<CompressedHeader>(ReadCompressedHeader(&file));
+    file_width = header->width;
+    file_height = header->height;
+    file_depth = header->depth;
+  } else {
+    char unused_char;
+    file >> file_width >> unused_char >> file_height >> unused_char >>
+        file_depth >> unused_char;
+    THROW_CHECK_GT(file_depth, 0) << path;
+  }
+
+  THROW_CHECK_GT(width, 0);
+  THROW_CHECK_GT(height, 0);
+  THROW_CHECK_LE(col + width, file_width) << path;
+  THROW_CHECK_LE(row + height, file_height) << path;
+
+  width_ = width;
+  height_ = height;
+  depth_ = file_depth;
+
+  if (header) {
+    ReadCompressedRegion(&file, *header, row, col, height, width, &data_);
+    return;
+  }
+
+  data_.resize(width_ * height_ * depth_);
+  const std::streampos data_begin = file.tellg();
+  std::vector<float> row_data(width);
+  for (size_t slice = 0; slice < depth_; ++slice) {
+    for (size_t r = 0; r < height; ++r) {
+      file.seekg(data_begin +
+                 static_cast<std::streamoff>(
+                     ((slice * file_height + row + r) * file_width + col) *
+                     sizeof(float)));
+      ReadBinaryLittleEndian<float>(&file, &row_data);
+      std::copy(row_data.begin(),
+                row_data.end(),
+                data_.begin() + (slice * height + r) * width);
+    }
+  }
+}
+
 template <>
 void Mat<float>::Write(const std::filesystem::path& path) const {
   std::ofstream file(path, std::ios::binary);
@@ -64,5 +413,62 @@ void Mat<float>::Write(const std::filesystem::path& path) const {
   file.close();
 }
 
+template <>
+void Mat<float>::WriteCompressed(const std::filesystem::path& path,
+                                 const MatCompressionOptions& options) const {
+  THROW_CHECK(options.Check());
+  THROW_CHECK_GT(width_, 0);
+  THROW_CHECK_GT(height_, 0);
+  THROW_CHECK_GT(depth_, 0);
+
+  const size_t tile_size = options.tile_size;
+  const size_t num_tiles_x = (width_ - 1) / tile_size + 1;
+  const size_t num_tiles_y = (height_ - 1) / tile_size + 1;
+
+  std::vector<std::string> tiles;
+  tiles.reserve(depth_ * num_tiles_y * num_tiles_x);
+  std::vector<float> values;
+  for (size_t slice = 0; slice < depth_; ++slice) {
+    for (size_t tile_y = 0; tile_y < num_tiles_y; ++tile_y) {
+      for (size_t tile_x = 0; tile_x < num_tiles_x; ++tile_x) {
+        const size_t tile_row = tile_y * tile_size;
+        const size_t tile_col = tile_x * tile_size;
+        const size_t tile_height = std::min(tile_size, height_ - tile_row);
+        const size_t tile_width = std::min(tile_size, width_ - tile_col);
+        values.clear();
+        for (size_t r = tile_row; r < tile_row + tile_height; ++r) {
+          const auto row_begin =
+              data_.begin() + (slice * height_ + r) * width_ + tile_col;
+          values.insert(values.end(), row_begin, row_begin + tile_width);
+        }
+        tiles.push_back(EncodeTile(values, tile_width, options.quantize));
+      }
+    }
+  }
+
+  std::vector<uint64_t> tile_offsets;
+  tile_offsets.reserve(tiles.size() + 1);
+  tile_offsets.push_back(0);
+  for (const auto& tile : tiles) {
+    tile_offsets.push_back(tile_offsets.back() + tile.size());
+  }
+
+  std::ofstream file(path, std::ios::binary);
+  THROW_CHECK_FILE_OPEN(file, path);
+  file.write(kCompressedMagic, sizeof(kCompressedMagic));
+  WriteBinaryLittleEndian<uint32_t>(&file, kCompressedVersion);
+  WriteBinaryLittleEndian<uint64_t>(&file, width_);
+  WriteBinaryLittleEndian<uint64_t>(&file, height_);
+  WriteBinaryLittleEndian<uint64_t>(&file, depth_);
+  WriteBinaryLittleEndian<uint32_t>(&file, tile_size);
+  WriteBinaryLittleEndian<uint8_t>(&file, options.quantize ? 1 : 0);
+  WriteBinaryLittleEndian<uint64_t>(
+      &file, {tile_offsets.data(), tile_offsets.size()});
+  for (const auto& tile : tiles) {
+    file.write(tile.data(), tile.size());
+  }
+  file.close();
+}
+
 }  // namespace mvs
 }  // namespace colmap
@@ -36,6 +36,21 @@
 namespace colmap {
 namespace mvs {
 
+// Options for writing matrices in the compressed format. The matrix is split
+// into square tiles per slice, which are encoded independently, so that
+// regions of the matrix can be read without decoding the entire file.
+struct MatCompressionOptions {
+  // Whether to quantize the values to 16 bit relative to the value range of
+  // each tile. Otherwise, the values are compressed losslessly. Zero values,
+  // e.g., invalid depths, are always stored exactly.
+  bool quantize = false;
+
+  // Width and height of the tiles.
+  int tile_size = 256;
+
+  bool Check() const;
+};
+
 template <typename T>
 class Mat {
  public:
@@ -60,8 +75,21 @@ class Mat {
 
   void Fill(T value);
 
+  // Read the matrix in either the raw or the compressed format.
   void Read(const std::filesystem::path& path);
+
+  // Read the region of the given size starting at the given row and column of
+  // the matrix in the file. Only the overlapping tiles are decoded for the
+  // compressed format.
+  void ReadRegion(const std::filesystem::path& path,
+                  size_t row,
+                  size_t col,
+                  size_t height,
+                  size_t width);
+
   void Write(const std::filesystem::path& path) const;
+  void WriteCompressed(const std::filesystem::path& path,
+                       const MatCompressionOptions& options) const;
 
  protected:
   size_t width_ = 0;
@@ -29,6 +29,8 @@
 
 #include "colmap/mvs/mat.h"
 
+#include "colmap/util/testing.h"
+
 #include <gtest/gtest.h>
 
 namespace colmap {
@@ -95,6 +97,93 @@ TEST(Mat, Fill) {
   mat.Set(1, 0, 2, 10);
 }
 
+Mat<float> CreateTestMat(const size_t width,
+                         const size_t height,
+                         const size_t depth) {
+  Mat<float> mat(width, height, depth);
+  for (size_t slice = 0; slice < depth; ++slice) {
+    for (size_t row = 0; row < height; ++row) {
+      for (size_t col = 0; col < width; ++col) {
+        // Leave some values at zero, e.g., like invalid depths.
+        if ((row + col) % 7 != 0) {
+          mat.Set(row, col, slice, 1.0f + 0.01f * row + 0.1f * col - slice);
+        }
+      }
+    }
+  }
+  return mat;
+}
+
+TEST(Mat, ReadWrite) {
+  const auto path = CreateTestDir() / "mat.bin";
+  const Mat<float> mat = CreateTestMat(13, 11, 2);
+  mat.Write(path);
+  Mat<float> read_mat;
+  read_mat.Read(path);
+  EXPECT_EQ(read_mat.GetWidth(), mat.GetWidth());
+  EXPECT_EQ(read_mat.GetHeight(), mat.GetHeight());
+  EXPECT_EQ(read_mat.GetDepth(), mat.GetDepth());
+  EXPECT_EQ(read_mat.GetData(), mat.GetData());
+}
+
+TEST(Mat, ReadWriteCompressedLossless) {
+  const auto path = CreateTestDir() / "mat.bin";
+  const Mat<float> mat = CreateTestMat(13, 11, 2);
+  MatCompressionOptions options;
+  options.tile_size = 4;
+  mat.WriteCompressed(path, options);
+  Mat<float> read_mat;
+  read_mat.Read(path);
+  EXPECT_EQ(read_mat.GetWidth(), mat.GetWidth());
+  EXPECT_EQ(read_mat.GetHeight(), mat.GetHeight());
+  EXPECT_EQ(read_mat.GetDepth(), mat.GetDepth());
+  EXPECT_EQ(read_mat.GetData(), mat.GetData());
+}
+
+TEST(Mat, ReadWriteCompressedQuantized) {
+  const auto path = CreateTestDir() / "mat.bin";
+  const Mat<float> mat = CreateTestMat(100, 80, 1);
+  MatCompressionOptions options;
+  options.quantize = true;
+  options.tile_size = 32;
+  mat.WriteCompressed(path, options);
+  EXPECT_LT(std::filesystem::file_size(path), mat.GetNumBytes() / 2);
+  Mat<float> read_mat;
+  read_mat.Read(path);
+  ASSERT_EQ(read_mat.GetData().size(), mat.GetData().size());
+  for (size_t i = 0; i < mat.GetData().size(); ++i) {
+    if (mat.GetData()[i] == 0) {
+      EXPECT_EQ(read_mat.GetData()[i], 0);
+    } else {
+      EXPECT_NEAR(read_mat.GetData()[i], mat.GetData()[i], 1e-4);
+    }
+  }
+}
+
+TEST(Mat, ReadRegion) {
+  const auto test_dir = CreateTestDir();
+  const Mat<float> mat = CreateTestMat(13, 11, 2);
+  mat.Write(test_dir / "raw.bin");
+  MatCompressionOptions options;
+  options.tile_size = 4;
+  mat.WriteCompressed(test_dir / "compressed.bin", options);
+  for (const auto& name : {"raw.bin", "compressed.bin"}) {
+    Mat<float> region;
+    region.ReadRegion(test_dir / name, 3, 2, 6, 9);
+    EXPECT_EQ(region.GetWidth(), 9);
+    EXPECT_EQ(region.GetHeight(), 6);
+    EXPECT_EQ(region.GetDepth(), 2);
+    for (size_t slice = 0; slice < 2; ++slice) {
+      for (size_t row = 0; row < 6; ++row) {
+        for (size_t col = 0; col < 9; ++col) {
+          EXPECT_EQ(region.Get(row, col, slice),
+                    mat.Get(row + 3, col + 2, slice));
+        }
+      }
+    }
+  }
+}
+
 }  // namespace
 }  // namespace mvs
 }  // namespace colmap
@@ -36,11 +36,14 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <limits>
+#include <numeric>
 #include <queue>
 #include <unordered_map>
 #include <vector>
 
 #include <Eigen/Dense>
+#include <Eigen/Geometry>
 #include <omp.h>
 
 namespace colmap {
@@ -53,6 +56,7 @@ bool MeshSimplificationOptions::Check() const {
   CHECK_OPTION_GE(boundary_weight, 0.0);
   CHECK_OPTION_GE(num_threads, -1);
   CHECK_OPTION_NE(num_threads, 0);
+  CHECK_OPTION_GE(max_num_faces_per_block, 0);
   return true;
 }
 
@@ -232,38 +236,21 @@ bool WouldCauseFlip(const std::vector<VertexData>& vertices,
   return would_flip_vertex(v1, v2) || would_flip_vertex(v2, v1);
 }
 
-}  // namespace
-
-PlyMesh SimplifyMesh(const PlyMesh& mesh,
-                     const MeshSimplificationOptions& options) {
-  THROW_CHECK(options.Check());
-
-  if (mesh.faces.empty() || mesh.vertices.empty()) {
-    return mesh;
-  }
-
-  // Validate that all face vertex indices are within bounds.
-  const size_t num_verts = mesh.vertices.size();
-  for (size_t fi = 0; fi < mesh.faces.size(); ++fi) {
-    const auto& face = mesh.faces[fi];
-    THROW_CHECK_LT(face.vertex_idx1, num_verts)
-        << "Face " << fi << " has out-of-bounds vertex index";
-    THROW_CHECK_LT(face.vertex_idx2, num_verts)
-        << "Face " << fi << " has out-of-bounds vertex index";
-    THROW_CHECK_LT(face.vertex_idx3, num_verts)
-        << "Face " << fi << " has out-of-bounds vertex index";
-  }
-
+// Decimates the mesh until it has the target number of faces. Edges with a
+// locked vertex are never collapsed, so that locked vertices keep their
+// position and remain in the output mesh. If given, new_to_old_vertex_idxs
+// maps the vertices of the output mesh to the vertices of the input mesh.
+PlyMesh SimplifyMeshImpl(const PlyMesh& mesh,
+                         const MeshSimplificationOptions& options,
+                         const size_t target_faces,
+                         const std::vector<bool>& locked_vertices,
+                         std::vector<size_t>* new_to_old_vertex_idxs) {
   const size_t num_faces = mesh.faces.size();
-  const size_t target_faces = std::max(
-      static_cast<size_t>(1),
-      static_cast<size_t>(std::floor(num_faces * options.target_face_ratio)));
-
-  if (target_faces >= num_faces) {
-    return mesh;
-  }
-
   const size_t num_vertices = mesh.vertices.size();
+
+  const auto IsLocked = [&](const size_t vertex_idx) {
+    return !locked_vertices.empty() && locked_vertices[vertex_idx];
+  };
   std::vector<VertexData> vertex_data(num_vertices);
   for (size_t i = 0; i < num_vertices; ++i) {
     vertex_data[i].position = Eigen::Vector3d(
@@ -398,8 +385,9 @@ PlyMesh SimplifyMesh(const PlyMesh& mesh,
   std::vector<Edge> unique_edges;
   for (size_t vi = 0; vi < num_vertices; ++vi) {
     if (vertex_data[vi].removed) continue;
+    if (IsLocked(vi)) continue;
     for (const size_t vj : vertex_data[vi].adjacent_vertices) {
-      if (vi < vj) {
+      if (vi < vj && !IsLocked(vj)) {
         unique_edges.emplace_back(vi, vj);
       }
     }
@@ -428,7 +416,8 @@ PlyMesh SimplifyMesh(const PlyMesh& mesh,
             << " target faces, " << pq.size() << " initial edge candidates";
 
   // Step 5: Iterative collapse loop.
-  const size_t faces_to_remove = current_faces - target_faces;
+  const size_t faces_to_remove =
+      current_faces - std::min(current_faces, target_faces);
   size_t faces_removed = 0;
   int last_progress_percent = -1;
 
@@ -529,7 +518,7 @@ PlyMesh SimplifyMesh(const PlyMesh& mesh,
 
     // Recompute candidates for all edges incident to v1.
     for (const size_t u : vertex_data[v1].adjacent_vertices) {
-      if (vertex_data[u].removed) continue;
+      if (vertex_data[u].removed || IsLocked(u)) continue;
       pq.push(
           ComputeEdgeCollapse(vertex_data, v1, u, options.interpolate_colors));
     }
@@ -557,6 +546,9 @@ PlyMesh SimplifyMesh(const PlyMesh& mesh,
     for (int j = 0; j < 3; ++j) {
       if (old_to_new[f[j]] == kUnmapped) {
         old_to_new[f[j]] = result.vertices.size();
+        if (new_to_old_vertex_idxs) {
+          new_to_old_vertex_idxs->push_back(f[j]);
+        }
         const auto& vd = vertex_data[f[j]];
         const Eigen::Vector3f clamped_color =
             vd.color.array().round().max(0.0f).min(255.0f);
@@ -579,5 +571,256 @@ PlyMesh SimplifyMesh(const PlyMesh& mesh,
   return result;
 }
 
+// Recursively split the faces at the median of their centroids along the
+// longest axis until each block has at most the given number of faces.
+void PartitionFaces(const std::vector<Eigen::Vector3f>& face_centroids,
+                    const int max_num_faces,
+                    std::vector<size_t> face_idxs,
+                    std::vector<std::vector<size_t>>* blocks) {
+  if (face_idxs.size() <= static_cast<size_t>(max_num_faces)) {
+    blocks->push_back(std::move(face_idxs));
+    return;
+  }
+
+  Eigen::AlignedBox3f bbox;
+  for (const size_t fi : face_idxs) {
+    bbox.extend(face_centroids[fi]);
+  }
+
+  int axis;
+  bbox.sizes().maxCoeff(&axis);
+
+  const auto median_it = face_idxs.begin() + face_idxs.size() / 2;
+  std::nth_element(face_idxs.begin(),
+                   median_it,
+                   face_idxs.end(),
+                   [&](const size_t fi1, const size_t fi2) {
+                     return face_centroids[fi1](axis) <
+                            face_centroids[fi2](axis);
+                   });
+
+  std::vector<size_t> right_face_idxs(median_it, face_idxs.end());
+  face_idxs.erase(median_it, face_idxs.end());
+  face_idxs.shrink_to_fit();
+
+  PartitionFaces(face_centroids, max_num_faces, std::move(face_idxs), blocks);
+  PartitionFaces(
+      face_centroids, max_num_faces, std::move(right_face_idxs), blocks);
+}
+
+// Decimates spatial blocks of the mesh in parallel and then runs a final pass
+// over the seams between the blocks. The seam vertices are locked during the
+// simplification of the blocks, so that the block meshes can be stitched
+// together exactly. The final pass only unlocks the seam vertices and their
+// direct neighbors. The decimation state is only held in memory for the
+// blocks that are processed concurrently.
+PlyMesh SimplifyMeshInBlocks(const PlyMesh& mesh,
+                             const MeshSimplificationOptions& options,
+                             const size_t target_faces) {
+  const size_t num_faces = mesh.faces.size();
+  const size_t num_vertices = mesh.vertices.size();
+
+  const auto VertexPosition = [&](const size_t vertex_idx) {
+    const auto& vertex = mesh.vertices[vertex_idx];
+    return Eigen::Vector3f(vertex.x, vertex.y, vertex.z);
+  };
+
+  std::vector<Eigen::Vector3f> face_centroids(num_faces);
+  for (size_t fi = 0; fi < num_faces; ++fi) {
+    const auto& face = mesh.faces[fi];
+    face_centroids[fi] = (VertexPosition(face.vertex_idx1) +
+                          VertexPosition(face.vertex_idx2) +
+                          VertexPosition(face.vertex_idx3)) /
+                         3.0f;
+  }
+
+  std::vector<size_t> face_idxs(num_faces);
+  std::iota(face_idxs.begin(), face_idxs.end(), 0);
+  std::vector<std::vector<size_t>> blocks;
+  PartitionFaces(face_centroids,
+                 options.max_num_faces_per_block,
+                 std::move(face_idxs),
+                 &blocks);
+  face_centroids.clear();
+  face_centroids.shrink_to_fit();
+
+  // Find the seam vertices, which are shared by faces of multiple blocks.
+  constexpr int kNoBlock = -1;
+  constexpr int kSeamBlock = -2;
+  std::vector<int> vertex_blocks(num_vertices, kNoBlock);
+  for (size_t block_idx = 0; block_idx < blocks.size(); ++block_idx) {
+    for (const size_t fi : blocks[block_idx]) {
+      const auto& face = mesh.faces[fi];
+      for (const size_t vertex_idx :
+           {face.vertex_idx1, face.vertex_idx2, face.vertex_idx3}) {
+        int& vertex_block = vertex_blocks[vertex_idx];
+        if (vertex_block == kNoBlock) {
+          vertex_block = static_cast<int>(block_idx);
+        } else if (vertex_block != static_cast<int>(block_idx)) {
+          vertex_block = kSeamBlock;
+        }
+      }
+    }
+  }
+
+  LOG(INFO) << "Simplifying " << blocks.size() << " mesh blocks...";
+
+  const int num_threads = GetEffectiveNumThreads(options.num_threads);
+  MeshSimplificationOptions block_options = options;
+  block_options.num_threads = 1;
+
+  struct BlockResult {
+    PlyMesh mesh;
+    // The vertex indices of the block mesh in the input mesh.
+    std::vector<size_t> vertex_idxs;
+  };
+  std::vector<BlockResult> block_results(blocks.size());
+
+  GetSharedThreadPool().ParallelFor(
+      0,
+      blocks.size(),
+      [&](const int64_t block_idx) {
+        // Extract the block as a separate mesh with locked seam vertices.
+        PlyMesh block_mesh;
+        std::vector<size_t> block_vertex_idxs;
+        std::vector<bool> block_locked_vertices;
+        std::unordered_map<size_t, size_t> vertex_idx_map;
+        const auto MapVertex = [&](const size_t vertex_idx) {
+          const auto [it, inserted] =
+              vertex_idx_map.emplace(vertex_idx, block_mesh.vertices.size());
+          if (inserted) {
+            block_mesh.vertices.push_back(mesh.vertices[vertex_idx]);
+            block_vertex_idxs.push_back(vertex_idx);
+            block_locked_vertices.push_back(vertex_blocks[vertex_idx] ==
+                                            kSeamBlock);
+          }
+          return it->second;
+        };
+
+        const std::vector<size_t>& block_face_idxs = blocks[block_idx];
+        block_mesh.faces.reserve(block_face_idxs.size());
+        for (const size_t fi : block_face_idxs) {
+          const auto& face = mesh.faces[fi];
+          block_mesh.faces.emplace_back(MapVertex(face.vertex_idx1),
+                                        MapVertex(face.vertex_idx2),
+                                        MapVertex(face.vertex_idx3));
+        }
+        vertex_idx_map.clear();
+
+        const size_t block_target_faces = static_cast<size_t>(
+            std::floor(block_mesh.faces.size() * options.target_face_ratio));
+
+        std::vector<size_t> new_to_old_vertex_idxs;
+        BlockResult& result = block_results[block_idx];
+        result.mesh = SimplifyMeshImpl(block_mesh,
+                                       block_options,
+                                       block_target_faces,
+                                       block_locked_vertices,
+                                       &new_to_old_vertex_idxs);
+        result.vertex_idxs.reserve(new_to_old_vertex_idxs.size());
+        for (const size_t block_vertex_idx : new_to_old_vertex_idxs) {
+          result.vertex_idxs.push_back(block_vertex_idxs[block_vertex_idx]);
+        }
+      },
+      num_threads);
+
+  LOG(INFO) << "Stitching mesh blocks...";
+
+  // Merge the block meshes, where each seam vertex is only added once.
+  PlyMesh merged_mesh;
+  std::vector<bool> is_seam_vertex;
+  std::unordered_map<size_t, size_t> seam_vertex_idx_map;
+  for (auto& result : block_results) {
+    std::vector<size_t> merged_vertex_idxs(result.mesh.vertices.size());
+    for (size_t i = 0; i < result.mesh.vertices.size(); ++i) {
+      const size_t vertex_idx = result.vertex_idxs[i];
+      const bool is_seam = vertex_blocks[vertex_idx] == kSeamBlock;
+      if (is_seam) {
+        const auto [it, inserted] = seam_vertex_idx_map.emplace(
+            vertex_idx, merged_mesh.vertices.size());
+        merged_vertex_idxs[i] = it->second;
+        if (!inserted) {
+          continue;
+        }
+      } else {
+        merged_vertex_idxs[i] = merged_mesh.vertices.size();
+      }
+      merged_mesh.vertices.push_back(result.mesh.vertices[i]);
+      is_seam_vertex.push_back(is_seam);
+    }
+
+    for (const auto& face : result.mesh.faces) {
+      merged_mesh.faces.emplace_back(merged_vertex_idxs[face.vertex_idx1],
+                                     merged_vertex_idxs[face.vertex_idx2],
+                                     merged_vertex_idxs[face.vertex_idx3]);
+    }
+
+    result = BlockResult();
+  }
+
+  // Lock all vertices except the seam vertices and their direct neighbors.
+  std::vector<bool> locked_vertices(merged_mesh.vertices.size(), true);
+  for (const auto& face : merged_mesh.faces) {
+    const std::array<size_t, 3> f = {
+        face.vertex_idx1, face.vertex_idx2, face.vertex_idx3};
+    if (is_seam_vertex[f[0]] || is_seam_vertex[f[1]] || is_seam_vertex[f[2]]) {
+      for (const size_t vertex_idx : f) {
+        locked_vertices[vertex_idx] = false;
+      }
+    }
+  }
+
+  LOG(INFO) << "Simplifying seams of mesh blocks...";
+
+  return SimplifyMeshImpl(merged_mesh,
+                          options,
+                          target_faces,
+                          locked_vertices,
+                          /*new_to_old_vertex_idxs=*/nullptr);
+}
+
+}  // namespace
+
+PlyMesh SimplifyMesh(const PlyMesh& mesh,
+                     const MeshSimplificationOptions& options) {
+  THROW_CHECK(options.Check());
+
+  if (mesh.faces.empty() || mesh.vertices.empty()) {
+    return mesh;
+  }
+
+  // Validate that all face vertex indices are within bounds.
+  const size_t num_verts = mesh.vertices.size();
+  for (size_t fi = 0; fi < mesh.faces.size(); ++fi) {
+    const auto& face = mesh.faces[fi];
+    THROW_CHECK_LT(face.vertex_idx1, num_verts)
+        << "Face " << fi << " has out-of-bounds vertex index";
+    THROW_CHECK_LT(face.vertex_idx2, num_verts)
+        << "Face " << fi << " has out-of-bounds vertex index";
+    THROW_CHECK_LT(face.vertex_idx3, num_verts)
+        << "Face " << fi << " has out-of-bounds vertex index";
+  }
+
+  const size_t num_faces = mesh.faces.size();
+  const size_t target_faces = std::max(
+      static_cast<size_t>(1),
+      static_cast<size_t>(std::floor(num_faces * options.target_face_ratio)));
+
+  if (target_faces >= num_faces) {
+    return mesh;
+  }
+
+  if (options.max_num_faces_per_block > 0 &&
+      num_faces > static_cast<size_t>(options.max_num_faces_per_block)) {
+    return SimplifyMeshInBlocks(mesh, options, target_faces);
+  }
+
+  return SimplifyMeshImpl(mesh,
+                          options,
+                          target_faces,
+                          /*locked_vertices=*/{},
+                          /*new_to_old_vertex_idxs=*/nullptr);
+}
+
 }  // namespace mvs
 }  // namespace colmap
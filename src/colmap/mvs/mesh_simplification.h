@@ -50,6 +50,11 @@ struct MeshSimplificationOptions {
   // The number of threads to use for initialization. Default is all threads.
   int num_threads = -1;
 
+  // Maximum number of faces per spatial block; 0 = disabled. If enabled,
+  // larger meshes are split into blocks that are simplified in parallel with
+  // locked seam vertices, followed by a final pass over the seams.
+  int max_num_faces_per_block = 0;
+
   bool Check() const;
 };
 
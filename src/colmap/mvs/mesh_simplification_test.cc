@@ -29,8 +29,10 @@
 
 #include "colmap/mvs/mesh_simplification.h"
 
+#include <array>
 #include <cmath>
 #include <limits>
+#include <map>
 
 #include <gtest/gtest.h>
 
@@ -125,6 +127,12 @@ TEST(MeshSimplificationOptions, InvalidMaxError) {
   EXPECT_FALSE(options.Check());
 }
 
+TEST(MeshSimplificationOptions, InvalidMaxNumFacesPerBlock) {
+  MeshSimplificationOptions options;
+  options.max_num_faces_per_block = -1;
+  EXPECT_FALSE(options.Check());
+}
+
 TEST(SimplifyMesh, IdentityWithRatioOne) {
   const auto mesh = CreateTetrahedronMesh();
 
@@ -324,6 +332,46 @@ TEST(SimplifyMesh, OptimalVertexPlacement) {
   }
 }
 
+TEST(SimplifyMesh, InBlocks) {
+  const auto mesh = CreateWavyGridMesh(50);  // 5000 faces
+  ASSERT_EQ(mesh.faces.size(), 5000);
+
+  MeshSimplificationOptions options;
+  options.target_face_ratio = 0.1;
+  options.max_num_faces_per_block = 600;
+  options.num_threads = 4;
+
+  const auto result = SimplifyMesh(mesh, options);
+
+  EXPECT_LE(result.faces.size(), 500);
+  EXPECT_GE(result.faces.size(), 100);
+
+  // The blocks must be stitched into a single manifold surface without any
+  // holes at the seams, i.e., every interior edge is shared by two faces and
+  // the boundary has the same length as the boundary of the input grid.
+  std::map<std::pair<size_t, size_t>, int> edge_num_faces;
+  for (const auto& face : result.faces) {
+    EXPECT_LT(face.vertex_idx1, result.vertices.size());
+    EXPECT_LT(face.vertex_idx2, result.vertices.size());
+    EXPECT_LT(face.vertex_idx3, result.vertices.size());
+    const std::array<size_t, 3> f = {
+        face.vertex_idx1, face.vertex_idx2, face.vertex_idx3};
+    for (int i = 0; i < 3; ++i) {
+      edge_num_faces[std::minmax(f[i], f[(i + 1) % 3])] += 1;
+    }
+  }
+  double boundary_length = 0;
+  for (const auto& [edge, num_faces] : edge_num_faces) {
+    EXPECT_LE(num_faces, 2);
+    if (num_faces == 1) {
+      const auto& v1 = result.vertices[edge.first];
+      const auto& v2 = result.vertices[edge.second];
+      boundary_length += std::hypot(v1.x - v2.x, v1.y - v2.y);
+    }
+  }
+  EXPECT_NEAR(boundary_length, 4 * 50, 1);
+}
+
 }  // namespace
 }  // namespace mvs
 }  // namespace colmap
@@ -0,0 +1,303 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/mvs/mesh_tiling.h"
+
+#include "colmap/mvs/mesh_simplification.h"
+#include "colmap/util/file.h"
+#include "colmap/util/logging.h"
+#include "colmap/util/threading.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Geometry>
+
+namespace colmap {
+namespace mvs {
+namespace {
+
+struct MeshTile {
+  std::string id;
+  int parent_idx = -1;
+  int level = 0;
+  std::array<int, 2> child_idxs = {-1, -1};
+  // The faces of the input mesh in the tile. Only set for leaf tiles until
+  // they have been written.
+  std::vector<size_t> face_idxs;
+  size_t num_faces = 0;
+  Eigen::AlignedBox3f bbox;
+
+  bool IsLeaf() const { return child_idxs[0] == -1; }
+};
+
+// Recursively split the faces at the median of their centroids along the
+// longest axis until each leaf tile has at most the given number of faces.
+int BuildTileTree(const std::vector<Eigen::Vector3f>& face_centroids,
+                  const int max_num_faces,
+                  std::vector<size_t> face_idxs,
+                  const std::string& id,
+                  const int parent_idx,
+                  const int level,
+                  std::vector<MeshTile>* tiles) {
+  const int tile_idx = static_cast<int>(tiles->size());
+  tiles->emplace_back();
+  tiles->back().id = id;
+  tiles->back().parent_idx = parent_idx;
+  tiles->back().level = level;
+
+  if (face_idxs.size() <= static_cast<size_t>(max_num_faces)) {
+    (*tiles)[tile_idx].face_idxs = std::move(face_idxs);
+    return tile_idx;
+  }
+
+  Eigen::AlignedBox3f bbox;
+  for (const size_t fi : face_idxs) {
+    bbox.extend(face_centroids[fi]);
+  }
+
+  int axis;
+  bbox.sizes().maxCoeff(&axis);
+
+  const auto median_it = face_idxs.begin() + face_idxs.size() / 2;
+  std::nth_element(face_idxs.begin(),
+                   median_it,
+                   face_idxs.end(),
+                   [&](const size_t fi1, const size_t fi2) {
+                     return face_centroids[fi1](axis) <
+                            face_centroids[fi2](axis);
+                   });
+
+  std::vector<size_t> right_face_idxs(median_it, face_idxs.end());
+  face_idxs.erase(median_it, face_idxs.end());
+  face_idxs.shrink_to_fit();
+
+  const int left_idx = BuildTileTree(face_centroids,
+                                     max_num_faces,
+                                     std::move(face_idxs),
+                                     id + "0",
+                                     tile_idx,
+                                     level + 1,
+                                     tiles);
+  const int right_idx = BuildTileTree(face_centroids,
+                                      max_num_faces,
+                                      std::move(right_face_idxs),
+                                      id + "1",
+                                      tile_idx,
+                                      level + 1,
+                                      tiles);
+  (*tiles)[tile_idx].child_idxs = {left_idx, right_idx};
+  return tile_idx;
+}
+
+// Extract the given faces of the mesh with their referenced vertices.
+PlyMesh ExtractSubMesh(const PlyMesh& mesh,
+                       const std::vector<size_t>& face_idxs) {
+  PlyMesh sub_mesh;
+  sub_mesh.faces.reserve(face_idxs.size());
+  std::unordered_map<size_t, size_t> vertex_idx_map;
+  const auto MapVertex = [&](const size_t vertex_idx) {
+    const auto [it, inserted] =
+        vertex_idx_map.emplace(vertex_idx, sub_mesh.vertices.size());
+    if (inserted) {
+      sub_mesh.vertices.push_back(mesh.vertices[vertex_idx]);
+    }
+    return it->second;
+  };
+  for (const size_t fi : face_idxs) {
+    const auto& face = mesh.faces[fi];
+    sub_mesh.faces.emplace_back(MapVertex(face.vertex_idx1),
+                                MapVertex(face.vertex_idx2),
+                                MapVertex(face.vertex_idx3));
+  }
+  return sub_mesh;
+}
+
+// Merge the meshes and weld the vertices at identical positions, which the
+// neighboring tiles share at their common border.
+PlyMesh MergeTileMeshes(const std::vector<PlyMesh>& meshes) {
+  PlyMesh merged_mesh;
+  std::map<std::array<float, 3>, size_t> vertex_idx_map;
+  for (const PlyMesh& mesh : meshes) {
+    std::vector<size_t> merged_vertex_idxs(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+      const auto& vertex = mesh.vertices[i];
+      const auto [it, inserted] = vertex_idx_map.emplace(
+          std::array<float, 3>{vertex.x, vertex.y, vertex.z},
+          merged_mesh.vertices.size());
+      if (inserted) {
+        merged_mesh.vertices.push_back(vertex);
+      }
+      merged_vertex_idxs[i] = it->second;
+    }
+    for (const auto& face : mesh.faces) {
+      merged_mesh.faces.emplace_back(merged_vertex_idxs[face.vertex_idx1],
+                                     merged_vertex_idxs[face.vertex_idx2],
+                                     merged_vertex_idxs[face.vertex_idx3]);
+    }
+  }
+  return merged_mesh;
+}
+
+Eigen::AlignedBox3f ComputeMeshBoundingBox(const PlyMesh& mesh) {
+  Eigen::AlignedBox3f bbox;
+  for (const auto& vertex : mesh.vertices) {
+    bbox.extend(Eigen::Vector3f(vertex.x, vertex.y, vertex.z));
+  }
+  return bbox;
+}
+
+}  // namespace
+
+bool MeshTilingOptions::Check() const {
+  CHECK_OPTION_GT(max_num_faces_per_tile, 0);
+  CHECK_OPTION_GE(num_threads, -1);
+  CHECK_OPTION_NE(num_threads, 0);
+  return true;
+}
+
+void WriteMeshTiles(const MeshTilingOptions& options,
+                    const PlyMesh& mesh,
+                    const std::filesystem::path& output_path) {
+  THROW_CHECK(options.Check());
+  THROW_CHECK_DIR_EXISTS(output_path);
+
+  const size_t num_faces = mesh.faces.size();
+
+  std::vector<Eigen::Vector3f> face_centroids(num_faces);
+  for (size_t fi = 0; fi < num_faces; ++fi) {
+    const auto& face = mesh.faces[fi];
+    face_centroids[fi].setZero();
+    for (const size_t vertex_idx :
+         {face.vertex_idx1, face.vertex_idx2, face.vertex_idx3}) {
+      const auto& vertex = mesh.vertices[vertex_idx];
+      face_centroids[fi] += Eigen::Vector3f(vertex.x, vertex.y, vertex.z);
+    }
+    face_centroids[fi] /= 3.0f;
+  }
+
+  std::vector<size_t> face_idxs(num_faces);
+  std::iota(face_idxs.begin(), face_idxs.end(), 0);
+  std::vector<MeshTile> tiles;
+  BuildTileTree(face_centroids,
+                options.max_num_faces_per_tile,
+                std::move(face_idxs),
+                /*id=*/"0",
+                /*parent_idx=*/-1,
+                /*level=*/0,
+                &tiles);
+  face_centroids.clear();
+  face_centroids.shrink_to_fit();
+
+  int max_level = 0;
+  for (const MeshTile& tile : tiles) {
+    max_level = std::max(max_level, tile.level);
+  }
+  LOG(INFO) << "Writing " << tiles.size() << " mesh tiles in "
+            << max_level + 1 << " levels of detail...";
+
+  const auto TilePath = [&](const MeshTile& tile) {
+    return output_path / (tile.id + ".ply");
+  };
+
+  const int num_threads = GetEffectiveNumThreads(options.num_threads);
+
+  // Write the full resolution leaf tiles.
+  GetSharedThreadPool().ParallelFor(
+      0,
+      tiles.size(),
+      [&](const int64_t tile_idx) {
+        MeshTile& tile = tiles[tile_idx];
+        if (!tile.IsLeaf()) {
+          return;
+        }
+        const PlyMesh tile_mesh = ExtractSubMesh(mesh, tile.face_idxs);
+        tile.face_idxs.clear();
+        tile.face_idxs.shrink_to_fit();
+        tile.num_faces = tile_mesh.faces.size();
+        tile.bbox = ComputeMeshBoundingBox(tile_mesh);
+        WriteBinaryPlyMesh(
+            TilePath(tile), PlyTexturedMesh{tile_mesh}, /*write_rgb=*/true);
+      },
+      num_threads);
+
+  // Generate the coarser levels bottom-up from the tiles of the finer level.
+  MeshSimplificationOptions simplification_options;
+  simplification_options.target_face_ratio = 0.5;
+  simplification_options.num_threads = 1;
+  for (int level = max_level - 1; level >= 0; --level) {
+    GetSharedThreadPool().ParallelFor(
+        0,
+        tiles.size(),
+        [&](const int64_t tile_idx) {
+          MeshTile& tile = tiles[tile_idx];
+          if (tile.level != level || tile.IsLeaf()) {
+            return;
+          }
+          std::vector<PlyMesh> child_meshes;
+          for (const int child_idx : tile.child_idxs) {
+            const MeshTile& child = tiles[child_idx];
+            child_meshes.push_back(ReadPlyMesh(TilePath(child)).mesh);
+            tile.bbox.extend(child.bbox);
+          }
+          const PlyMesh tile_mesh = SimplifyMesh(
+              MergeTileMeshes(child_meshes), simplification_options);
+          tile.num_faces = tile_mesh.faces.size();
+          WriteBinaryPlyMesh(
+              TilePath(tile), PlyTexturedMesh{tile_mesh}, /*write_rgb=*/true);
+        },
+        num_threads);
+  }
+
+  const auto index_path = output_path / "tiles.txt";
+  std::ofstream file(index_path, std::ios::trunc);
+  THROW_CHECK_FILE_OPEN(file, index_path);
+  // Ensure that we don't loose any precision by storing in text.
+  file.precision(17);
+  file << "# Tile list with one line of data per tile:\n";
+  file << "#   TILE_ID PARENT_ID LEVEL NUM_FACES "
+          "MIN_X MIN_Y MIN_Z MAX_X MAX_Y MAX_Z\n";
+  for (const MeshTile& tile : tiles) {
+    file << tile.id << " "
+         << (tile.parent_idx == -1 ? "-" : tiles[tile.parent_idx].id) << " "
+         << tile.level << " " << tile.num_faces << " "
+         << tile.bbox.min().x() << " " << tile.bbox.min().y() << " "
+         << tile.bbox.min().z() << " " << tile.bbox.max().x() << " "
+         << tile.bbox.max().y() << " " << tile.bbox.max().z() << "\n";
+  }
+}
+
+}  // namespace mvs
+}  // namespace colmap
@@ -0,0 +1,69 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "colmap/util/ply.h"
+
+#include <filesystem>
+
+namespace colmap {
+namespace mvs {
+
+struct MeshTilingOptions {
+  // Maximum number of faces per tile at any level of detail. The mesh is
+  // recursively split at the median of the longest axis into full resolution
+  // leaf tiles with at most this many faces. Every coarser tile merges its two
+  // child tiles and simplifies them to half of their faces.
+  int max_num_faces_per_tile = 100000;
+
+  // The number of threads to use. Default is all threads.
+  int num_threads = -1;
+
+  bool Check() const;
+};
+
+// Write the mesh as a binary hierarchy of tiles with levels of detail, so that
+// viewers can stream the coarse tiles first and refine on demand. The output
+// directory contains one binary PLY file per tile and a "tiles.txt" index,
+// where each line describes one tile as:
+//
+//    TILE_ID PARENT_ID LEVEL NUM_FACES MIN_X MIN_Y MIN_Z MAX_X MAX_Y MAX_Z
+//
+// The root tile has the identifier "0" and the parent identifier "-". The
+// children of a tile append "0" or "1" to its identifier. The tile file is
+// named "TILE_ID.ply". Leaf tiles are written first and every coarser level is
+// generated from the tile files of the finer level, so that apart from the
+// input mesh only the tiles processed concurrently are held in memory.
+void WriteMeshTiles(const MeshTilingOptions& options,
+                    const PlyMesh& mesh,
+                    const std::filesystem::path& output_path);
+
+}  // namespace mvs
+}  // namespace colmap
@@ -0,0 +1,151 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/mvs/mesh_tiling.h"
+
+#include "colmap/util/file.h"
+#include "colmap/util/testing.h"
+
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace mvs {
+namespace {
+
+PlyMesh CreateGridMesh(const int n) {
+  PlyMesh mesh;
+  for (int j = 0; j <= n; ++j) {
+    for (int i = 0; i <= n; ++i) {
+      mesh.vertices.emplace_back(static_cast<float>(i),
+                                 static_cast<float>(j),
+                                 0.1f * std::sin(0.5f * i),
+                                 static_cast<uint8_t>(i),
+                                 static_cast<uint8_t>(j),
+                                 0);
+    }
+  }
+  for (int j = 0; j < n; ++j) {
+    for (int i = 0; i < n; ++i) {
+      const size_t v00 = j * (n + 1) + i;
+      const size_t v10 = j * (n + 1) + (i + 1);
+      const size_t v01 = (j + 1) * (n + 1) + i;
+      const size_t v11 = (j + 1) * (n + 1) + (i + 1);
+      mesh.faces.emplace_back(v00, v10, v11);
+      mesh.faces.emplace_back(v00, v11, v01);
+    }
+  }
+  return mesh;
+}
+
+struct TileEntry {
+  std::string parent_id;
+  int level = 0;
+  size_t num_faces = 0;
+};
+
+std::map<std::string, TileEntry> ReadTileIndex(
+    const std::filesystem::path& path) {
+  std::map<std::string, TileEntry> tiles;
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream line_stream(line);
+    std::string id;
+    TileEntry tile;
+    line_stream >> id >> tile.parent_id >> tile.level >> tile.num_faces;
+    tiles.emplace(id, tile);
+  }
+  return tiles;
+}
+
+TEST(WriteMeshTiles, Nominal) {
+  const auto test_dir = CreateTestDir();
+  const PlyMesh mesh = CreateGridMesh(40);
+
+  MeshTilingOptions options;
+  options.max_num_faces_per_tile = 500;
+  WriteMeshTiles(options, mesh, test_dir);
+
+  const auto tiles = ReadTileIndex(test_dir / "tiles.txt");
+  ASSERT_EQ(tiles.count("0"), 1);
+  EXPECT_EQ(tiles.at("0").parent_id, "-");
+  EXPECT_EQ(tiles.at("0").level, 0);
+
+  size_t num_leaf_faces = 0;
+  for (const auto& [id, tile] : tiles) {
+    const PlyMesh tile_mesh = ReadPlyMesh(test_dir / (id + ".ply")).mesh;
+    EXPECT_EQ(tile_mesh.faces.size(), tile.num_faces);
+    EXPECT_LE(tile.num_faces, options.max_num_faces_per_tile);
+    EXPECT_GT(tile.num_faces, 0);
+    EXPECT_EQ(tile.level, id.size() - 1);
+    if (id != "0") {
+      EXPECT_EQ(tile.parent_id, id.substr(0, id.size() - 1));
+    }
+    if (tiles.count(id + "0") == 0) {
+      EXPECT_EQ(tiles.count(id + "1"), 0);
+      num_leaf_faces += tile.num_faces;
+    }
+  }
+  EXPECT_EQ(num_leaf_faces, mesh.faces.size());
+}
+
+TEST(WriteMeshTiles, SingleTile) {
+  const auto test_dir = CreateTestDir();
+  const PlyMesh mesh = CreateGridMesh(4);
+
+  MeshTilingOptions options;
+  WriteMeshTiles(options, mesh, test_dir);
+
+  const auto tiles = ReadTileIndex(test_dir / "tiles.txt");
+  ASSERT_EQ(tiles.size(), 1);
+  EXPECT_EQ(tiles.at("0").num_faces, mesh.faces.size());
+  const PlyMesh tile_mesh = ReadPlyMesh(test_dir / "0.ply").mesh;
+  EXPECT_EQ(tile_mesh.vertices.size(), mesh.vertices.size());
+  EXPECT_EQ(tile_mesh.faces.size(), mesh.faces.size());
+}
+
+TEST(MeshTilingOptions, Check) {
+  MeshTilingOptions options;
+  EXPECT_TRUE(options.Check());
+  options.max_num_faces_per_tile = 0;
+  EXPECT_FALSE(options.Check());
+}
+
+}  // namespace
+}  // namespace mvs
+}  // namespace colmap
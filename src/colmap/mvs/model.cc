@@ -275,6 +275,62 @@ std::vector<std::map<int, float>> Model::ComputeTriangulationAngles(
   return triangulation_angles;
 }
 
+std::vector<std::map<int, float>> Model::ComputeSourceImageScores() const {
+  std::vector<Eigen::Vector3d> proj_centers(images.size());
+  for (size_t image_idx = 0; image_idx < images.size(); ++image_idx) {
+    const auto& image = images[image_idx];
+    Eigen::Vector3f C;
+    ComputeProjectionCenter(image.GetR(), image.GetT(), C.data());
+    proj_centers[image_idx] = C.cast<double>();
+  }
+
+  // Weighting of the triangulation angles as in MVSNet [Yao et al., ECCV
+  // 2018], where very small angles are penalized more than large ones.
+  const double kBestAngle = DegToRad(5.0);
+  const double kSigmaBelow = DegToRad(1.0);
+  const double kSigmaAbove = DegToRad(10.0);
+
+  std::vector<std::map<int, float>> scores(images.size());
+  std::vector<double> resolutions;
+  for (const auto& point : points) {
+    const Eigen::Vector3d xyz(point.x, point.y, point.z);
+
+    // Number of pixels per unit length at the point.
+    resolutions.resize(point.track.size());
+    for (size_t i = 0; i < point.track.size(); ++i) {
+      const auto& image = images.at(point.track[i]);
+      const float* R = image.GetR();
+      const double depth =
+          R[6] * xyz.x() + R[7] * xyz.y() + R[8] * xyz.z() + image.GetT()[2];
+      resolutions[i] = 0.5 * (image.GetK()[0] + image.GetK()[4]) / depth;
+    }
+
+    for (size_t i = 0; i < point.track.size(); ++i) {
+      const int image_idx1 = point.track[i];
+      for (size_t j = 0; j < i; ++j) {
+        const int image_idx2 = point.track[j];
+        if (image_idx1 == image_idx2 || resolutions[i] <= 0 ||
+            resolutions[j] <= 0) {
+          continue;
+        }
+        const double angle = CalculateTriangulationAngle(
+            proj_centers.at(image_idx1), proj_centers.at(image_idx2), xyz);
+        const double sigma = angle < kBestAngle ? kSigmaBelow : kSigmaAbove;
+        const double angle_weight = std::exp(
+            -(angle - kBestAngle) * (angle - kBestAngle) / (2 * sigma * sigma));
+        const double resolution_ratio =
+            std::min(resolutions[i], resolutions[j]) /
+            std::max(resolutions[i], resolutions[j]);
+        const float score = angle_weight * resolution_ratio;
+        scores.at(image_idx1)[image_idx2] += score;
+        scores.at(image_idx2)[image_idx1] += score;
+      }
+    }
+  }
+
+  return scores;
+}
+
 bool Model::ReadFromBundlerPMVS(const std::filesystem::path& path) {
   const auto bundle_file_path = path / "bundle.rd.out";
 
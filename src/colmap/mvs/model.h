@@ -79,6 +79,13 @@ struct Model {
   std::vector<std::map<int, float>> ComputeTriangulationAngles(
       float percentile = 50) const;
 
+  // Compute the scores of all overlapping images as source images. Each
+  // shared point contributes a weight that peaks at a triangulation angle of
+  // 5 degrees and falls off faster towards smaller angles, scaled by the ratio
+  // of the point's resolutions in both images. The score thus rewards overlap,
+  // sufficient baseline, and similar resolution.
+  std::vector<std::map<int, float>> ComputeSourceImageScores() const;
+
   // Note that in case the data is read from a COLMAP reconstruction, the index
   // of an image or point does not correspond to its original identifier in the
   // reconstruction, but it corresponds to the position in the
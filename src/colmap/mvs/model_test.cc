@@ -191,6 +191,36 @@ TEST(Model, GetMaxOverlappingImages) {
   EXPECT_EQ(overlapping[0][0], 1);
 }
 
+TEST(Model, ComputeSourceImageScores) {
+  Model model;
+  const float K[9] = {100, 0, 50, 0, 100, 50, 0, 0, 1};
+  const float R[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  // Projection center = -R^T * T = -T (for R=I).
+  const float T1[3] = {0, 0, 0};
+  const float T2[3] = {-0.01f, 0, 0};
+  const float T3[3] = {-1, 0, 0};
+  const float T4[3] = {-1, 0, 5};
+  model.images.emplace_back("img0.jpg", 100, 100, K, R, T1);
+  model.images.emplace_back("img1.jpg", 100, 100, K, R, T2);
+  model.images.emplace_back("img2.jpg", 100, 100, K, R, T3);
+  model.images.emplace_back("img3.jpg", 100, 100, K, R, T4);
+  for (int i = 0; i < 10; ++i) {
+    model.points.emplace_back(
+        Model::Point{0.5f, 0.1f * i, 10.0f, {0, 1, 2, 3}});
+  }
+
+  const std::vector<std::map<int, float>> scores =
+      model.ComputeSourceImageScores();
+  ASSERT_EQ(scores.size(), 4);
+  EXPECT_FLOAT_EQ(scores[0].at(1), scores[1].at(0));
+  // Image 2 has a triangulation angle close to the optimum, whereas image 1
+  // has almost no baseline and image 3 is at lower resolution.
+  EXPECT_GT(scores[0].at(2), scores[0].at(1));
+  EXPECT_GT(scores[0].at(2), scores[0].at(3));
+  EXPECT_GT(scores[0].at(2), 5);
+  EXPECT_LE(scores[0].at(2), 10);
+}
+
 }  // namespace
 }  // namespace mvs
 }  // namespace colmap
@@ -31,22 +31,236 @@
 
 #include "colmap/math/math.h"
 #include "colmap/mvs/consistency_graph.h"
-#include "colmap/mvs/patch_match_cuda.h"
+#include "colmap/mvs/depth_prior.h"
+#include "colmap/mvs/patch_match_cpu.h"
 #include "colmap/mvs/workspace.h"
-#include "colmap/util/cuda.h"
 #include "colmap/util/file.h"
+#include "colmap/util/metrics.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/resource_usage.h"
 #include "colmap/util/threading.h"
+#include "colmap/util/tracing.h"
 
+#if defined(COLMAP_CUDA_ENABLED)
+#include "colmap/mvs/patch_match_cuda.h"
+#include "colmap/util/cuda.h"
+#endif  // COLMAP_CUDA_ENABLED
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
 #include <numeric>
 #include <set>
+#include <thread>
 #include <unordered_set>
 
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
 #define PrintOption(option) LOG(INFO) << #option ": " << option << std::endl
 
 namespace colmap {
 namespace mvs {
 
+namespace {
+
+std::unique_ptr<PatchMatchSolver> CreateSolver(
+    const PatchMatchOptions& options,
+    const PatchMatch::Problem& problem,
+    const DepthMap* init_depth_map,
+    const NormalMap* init_normal_map) {
+  if (options.use_gpu) {
+#if defined(COLMAP_CUDA_ENABLED)
+    return std::make_unique<PatchMatchCuda>(
+        options, problem, init_depth_map, init_normal_map);
+#else   // COLMAP_CUDA_ENABLED
+    LOG(FATAL_THROW) << "PatchMatch on the GPU requires CUDA, which is not "
+                        "available on your system. Set use_gpu to false.";
+#endif  // COLMAP_CUDA_ENABLED
+  }
+  return std::make_unique<PatchMatchCpu>(
+      options, problem, init_depth_map, init_normal_map);
+}
+
+// Bilinearly resample all slices of the map to the size of the output map.
+void ResampleMap(const Mat<float>& map, Mat<float>* resampled_map) {
+  const float scale_x =
+      static_cast<float>(map.GetWidth()) / resampled_map->GetWidth();
+  const float scale_y =
+      static_cast<float>(map.GetHeight()) / resampled_map->GetHeight();
+  const float max_x = map.GetWidth() - 1;
+  const float max_y = map.GetHeight() - 1;
+  for (size_t r = 0; r < resampled_map->GetHeight(); ++r) {
+    const float y = std::clamp((r + 0.5f) * scale_y - 0.5f, 0.0f, max_y);
+    const size_t r0 = static_cast<size_t>(y);
+    const size_t r1 = std::min(r0 + 1, map.GetHeight() - 1);
+    const float wy = y - r0;
+    for (size_t c = 0; c < resampled_map->GetWidth(); ++c) {
+      const float x = std::clamp((c + 0.5f) * scale_x - 0.5f, 0.0f, max_x);
+      const size_t c0 = static_cast<size_t>(x);
+      const size_t c1 = std::min(c0 + 1, map.GetWidth() - 1);
+      const float wx = x - c0;
+      for (size_t d = 0; d < map.GetDepth(); ++d) {
+        const float top =
+            (1 - wx) * map.Get(r0, c0, d) + wx * map.Get(r0, c1, d);
+        const float bottom =
+            (1 - wx) * map.Get(r1, c0, d) + wx * map.Get(r1, c1, d);
+        resampled_map->Set(r, c, d, (1 - wy) * top + wy * bottom);
+      }
+    }
+  }
+}
+
+NormalMap ResampleNormalMap(const NormalMap& normal_map,
+                            const size_t width,
+                            const size_t height) {
+  NormalMap resampled_normal_map(width, height);
+  ResampleMap(normal_map, &resampled_normal_map);
+  for (size_t r = 0; r < height; ++r) {
+    for (size_t c = 0; c < width; ++c) {
+      Eigen::Vector3f normal;
+      resampled_normal_map.GetSlice(r, c, normal.data());
+      const float norm = normal.norm();
+      if (norm > 0) {
+        normal /= norm;
+      }
+      for (int d = 0; d < 3; ++d) {
+        resampled_normal_map.Set(r, c, d, normal(d));
+      }
+    }
+  }
+  return resampled_normal_map;
+}
+
+Mat<float> CropMap(const Mat<float>& map,
+                   const size_t x,
+                   const size_t y,
+                   const size_t width,
+                   const size_t height) {
+  Mat<float> cropped_map(width, height, map.GetDepth());
+  for (size_t r = 0; r < height; ++r) {
+    for (size_t c = 0; c < width; ++c) {
+      for (size_t d = 0; d < map.GetDepth(); ++d) {
+        cropped_map.Set(r, c, d, map.Get(y + r, x + c, d));
+      }
+    }
+  }
+  return cropped_map;
+}
+
+// Offsets of the tiles covering the extent, such that neighboring tiles
+// overlap by at least the given number of pixels.
+std::vector<size_t> ComputeTileOffsets(const size_t extent,
+                                       const size_t tile_size,
+                                       const size_t tile_overlap) {
+  std::vector<size_t> offsets = {0};
+  while (offsets.back() + tile_size < extent) {
+    offsets.push_back(std::min(offsets.back() + tile_size - tile_overlap,
+                               extent - tile_size));
+  }
+  return offsets;
+}
+
+// Boundary between the pixels owned by the tile and its successor, which is
+// the center of their overlap.
+size_t ComputeTileBoundary(const std::vector<size_t>& offsets,
+                           const size_t tile_idx,
+                           const size_t tile_size,
+                           const size_t extent) {
+  if (tile_idx + 1 >= offsets.size()) {
+    return extent;
+  }
+  return (offsets[tile_idx] + tile_size + offsets[tile_idx + 1]) / 2;
+}
+
+// Blending weight of the pixel, which ramps up linearly across the overlap
+// with the neighboring tiles, so that the weights in the overlap sum to one.
+float ComputeTileWeight(const size_t pos,
+                        const size_t offset,
+                        const size_t tile_size,
+                        const size_t extent,
+                        const size_t tile_overlap) {
+  float weight = 1;
+  if (offset > 0) {
+    weight = std::min(weight, (pos - offset + 1.0f) / (tile_overlap + 1));
+  }
+  if (offset + tile_size < extent) {
+    weight =
+        std::min(weight, (offset + tile_size - pos) / (tile_overlap + 1.0f));
+  }
+  return weight;
+}
+
+// Compute the bounding box of the region in the source image, in which the
+// given region of the reference image is observed within the depth range,
+// padded by the margin. Returns false if the region is not observed.
+bool ComputeSourceWindow(const Image& ref_image,
+                         const Image& src_image,
+                         const float depth_min,
+                         const float depth_max,
+                         const int margin,
+                         size_t* x,
+                         size_t* y,
+                         size_t* width,
+                         size_t* height) {
+  const Eigen::Map<const Eigen::Matrix<float, 3, 4, Eigen::RowMajor>>
+      ref_inv_P(ref_image.GetInvP());
+  const Eigen::Map<const Eigen::Matrix<float, 3, 4, Eigen::RowMajor>> src_P(
+      src_image.GetP());
+
+  // The frustum of the region within the depth range is convex, so its
+  // projection is the convex hull of the projected corners.
+  const float min_x = -margin;
+  const float min_y = -margin;
+  const float max_x = ref_image.GetWidth() - 1 + margin;
+  const float max_y = ref_image.GetHeight() - 1 + margin;
+  Eigen::Vector2f min_proj = Eigen::Vector2f::Constant(
+      std::numeric_limits<float>::max());
+  Eigen::Vector2f max_proj = Eigen::Vector2f::Constant(
+      std::numeric_limits<float>::lowest());
+  bool is_behind = false;
+  for (const float depth : {depth_min, depth_max}) {
+    for (const float ref_x : {min_x, max_x}) {
+      for (const float ref_y : {min_y, max_y}) {
+        const Eigen::Vector3f point =
+            ref_inv_P * Eigen::Vector4f(depth * ref_x, depth * ref_y, depth, 1);
+        const Eigen::Vector3f proj = src_P * point.homogeneous();
+        if (proj.z() <= std::numeric_limits<float>::epsilon()) {
+          is_behind = true;
+          continue;
+        }
+        min_proj = min_proj.cwiseMin(proj.hnormalized());
+        max_proj = max_proj.cwiseMax(proj.hnormalized());
+      }
+    }
+  }
+
+  // Without the corners behind the source camera, the projection is unbounded.
+  const float src_width = src_image.GetWidth();
+  const float src_height = src_image.GetHeight();
+  if (is_behind) {
+    min_proj.setZero();
+    max_proj = Eigen::Vector2f(src_width - 1, src_height - 1);
+  }
+
+  const float x0 = std::max(std::floor(min_proj.x()) - margin, 0.0f);
+  const float y0 = std::max(std::floor(min_proj.y()) - margin, 0.0f);
+  const float x1 = std::min(std::ceil(max_proj.x()) + margin, src_width - 1);
+  const float y1 = std::min(std::ceil(max_proj.y()) + margin, src_height - 1);
+  if (x0 > x1 || y0 > y1) {
+    return false;
+  }
+
+  *x = x0;
+  *y = y0;
+  *width = x1 - x0 + 1;
+  *height = y1 - y0 + 1;
+  return true;
+}
+
+}  // namespace
+
 PatchMatch::PatchMatch(const PatchMatchOptions& options, const Problem& problem)
     : options_(options), problem_(problem) {}
 
@@ -130,27 +344,344 @@ void PatchMatch::Run() {
 
   Check();
 
-  patch_match_cuda_ = std::make_unique<PatchMatchCuda>(options_, problem_);
-  patch_match_cuda_->Run();
+  const Image& ref_image = problem_.images->at(problem_.ref_image_idx);
+  if (options_.tile_size > 0 &&
+      std::max(ref_image.GetWidth(), ref_image.GetHeight()) >
+          static_cast<size_t>(options_.tile_size)) {
+    RunTiled();
+    return;
+  }
+
+  // Coarser levels must still contain a reasonable number of windows.
+  const size_t min_level_size = 8 * (2 * options_.window_radius + 1);
+  int num_levels = 1;
+  while (num_levels < options_.pyramid_num_levels &&
+         (std::min(ref_image.GetWidth(), ref_image.GetHeight()) >>
+          num_levels) >= min_level_size) {
+    ++num_levels;
+  }
+
+  std::unique_ptr<DepthMap> init_depth_map;
+  std::unique_ptr<NormalMap> init_normal_map;
+  PatchMatchOptions init_options = options_;
+  if (problem_.prior_depth_map != nullptr && !options_.geom_consistency) {
+    init_depth_map = std::make_unique<DepthMap>(*problem_.prior_depth_map);
+    init_normal_map = std::make_unique<NormalMap>();
+    CompleteDepthPrior(ref_image,
+                       options_.depth_min,
+                       options_.depth_max,
+                       init_depth_map.get(),
+                       init_normal_map.get());
+    if (options_.init_num_iterations > 0) {
+      init_options.num_iterations = options_.init_num_iterations;
+    }
+  }
+
+  // The geometric consistency problem is initialized from the photometric
+  // depth and normal maps and hence does not benefit from the pyramid.
+  if (num_levels == 1 || options_.geom_consistency) {
+    solver_ = CreateSolver(
+        init_options, problem_, init_depth_map.get(), init_normal_map.get());
+    solver_->Run();
+    return;
+  }
+
+  for (int level = num_levels - 1; level >= 0; --level) {
+    LOG(INFO) << StringPrintf("Pyramid level %d", level);
+
+    PatchMatchOptions level_options = init_options;
+    if (level < num_levels - 1) {
+      level_options.num_iterations = options_.pyramid_num_iterations;
+    }
+
+    // The coarser levels solve a downscaled copy of the problem with the
+    // reference image at index 0, followed by the source images.
+    std::vector<Image> level_images;
+    Problem level_problem;
+    if (level > 0) {
+      const float scale = 1.0f / (1 << level);
+      level_images.reserve(problem_.src_image_idxs.size() + 1);
+      level_images.push_back(ref_image);
+      for (const int image_idx : problem_.src_image_idxs) {
+        level_images.push_back(problem_.images->at(image_idx));
+      }
+      for (Image& image : level_images) {
+        image.Rescale(scale);
+      }
+      level_problem.ref_image_idx = 0;
+      level_problem.src_image_idxs.resize(problem_.src_image_idxs.size());
+      std::iota(level_problem.src_image_idxs.begin(),
+                level_problem.src_image_idxs.end(),
+                1);
+      level_problem.images = &level_images;
+      // Filtering is only relevant for the final depth and normal maps.
+      level_options.filter = false;
+    }
+
+    const Problem& problem = level > 0 ? level_problem : problem_;
+    const Image& level_ref_image = problem.images->at(problem.ref_image_idx);
+    if (init_depth_map) {
+      DepthMap resampled_depth_map(level_ref_image.GetWidth(),
+                                   level_ref_image.GetHeight(),
+                                   init_depth_map->GetDepthMin(),
+                                   init_depth_map->GetDepthMax());
+      ResampleMap(*init_depth_map, &resampled_depth_map);
+      *init_depth_map = std::move(resampled_depth_map);
+      *init_normal_map = ResampleNormalMap(*init_normal_map,
+                                           level_ref_image.GetWidth(),
+                                           level_ref_image.GetHeight());
+    }
+
+    auto solver = CreateSolver(
+        level_options, problem, init_depth_map.get(), init_normal_map.get());
+    solver->Run();
+
+    if (level > 0) {
+      init_depth_map = std::make_unique<DepthMap>(solver->GetDepthMap());
+      init_normal_map = std::make_unique<NormalMap>(solver->GetNormalMap());
+    } else {
+      solver_ = std::move(solver);
+    }
+  }
+}
+
+void PatchMatch::RunTiled() {
+  const Image& ref_image = problem_.images->at(problem_.ref_image_idx);
+  const size_t width = ref_image.GetWidth();
+  const size_t height = ref_image.GetHeight();
+  const size_t tile_overlap = options_.tile_overlap;
+  const size_t tile_width = std::min<size_t>(width, options_.tile_size);
+  const size_t tile_height = std::min<size_t>(height, options_.tile_size);
+  const std::vector<size_t> col_offsets =
+      ComputeTileOffsets(width, tile_width, tile_overlap);
+  const std::vector<size_t> row_offsets =
+      ComputeTileOffsets(height, tile_height, tile_overlap);
+
+  // The patches around the pixels at the tile border extend beyond the tile.
+  const int margin = options_.window_radius * options_.window_step + 1;
+
+  PatchMatchOptions tile_options = options_;
+  tile_options.tile_size = 0;
+
+  tiled_outputs_ = std::make_unique<TiledOutputs>();
+  DepthMap& depth_map = tiled_outputs_->depth_map;
+  NormalMap& normal_map = tiled_outputs_->normal_map;
+  depth_map = DepthMap(width, height, options_.depth_min, options_.depth_max);
+  depth_map.Fill(0);
+  normal_map = NormalMap(width, height);
+  normal_map.Fill(0);
+  Mat<float> weight_map(width, height, 1);
+  weight_map.Fill(0);
+
+  for (size_t row_idx = 0; row_idx < row_offsets.size(); ++row_idx) {
+    for (size_t col_idx = 0; col_idx < col_offsets.size(); ++col_idx) {
+      const size_t tile_x = col_offsets[col_idx];
+      const size_t tile_y = row_offsets[row_idx];
+      LOG(INFO) << StringPrintf(
+          "Tile %d / %d",
+          row_idx * col_offsets.size() + col_idx + 1,
+          row_offsets.size() * col_offsets.size());
+
+      // The tile problem consists of the cropped reference image at index 0,
+      // followed by the cropped source images observing the tile.
+      std::vector<int> tile_image_idxs;
+      std::vector<Image> tile_images;
+      std::vector<DepthMap> tile_depth_maps;
+      std::vector<NormalMap> tile_normal_maps;
+      const auto AddTileImage = [&](const int image_idx,
+                                    const size_t x,
+                                    const size_t y,
+                                    const size_t crop_width,
+                                    const size_t crop_height) {
+        tile_image_idxs.push_back(image_idx);
+        tile_images.push_back(
+            problem_.images->at(image_idx).Crop(x, y, crop_width, crop_height));
+        if (!options_.geom_consistency) {
+          return;
+        }
+        const DepthMap& full_depth_map = problem_.depth_maps->at(image_idx);
+        tile_depth_maps.emplace_back(
+            CropMap(full_depth_map, x, y, crop_width, crop_height),
+            full_depth_map.GetDepthMin(),
+            full_depth_map.GetDepthMax());
+        if (image_idx == problem_.ref_image_idx) {
+          tile_normal_maps.emplace_back(
+              CropMap(problem_.normal_maps->at(image_idx),
+                      x,
+                      y,
+                      crop_width,
+                      crop_height));
+        } else {
+          // Only the normal map of the reference image is used.
+          tile_normal_maps.emplace_back();
+        }
+      };
+
+      AddTileImage(
+          problem_.ref_image_idx, tile_x, tile_y, tile_width, tile_height);
+      for (const int src_image_idx : problem_.src_image_idxs) {
+        size_t x, y, src_width, src_height;
+        if (ComputeSourceWindow(tile_images[0],
+                                problem_.images->at(src_image_idx),
+                                options_.depth_min,
+                                options_.depth_max,
+                                margin,
+                                &x,
+                                &y,
+                                &src_width,
+                                &src_height)) {
+          AddTileImage(src_image_idx, x, y, src_width, src_height);
+        }
+      }
+
+      if (tile_images.size() == 1) {
+        LOG(WARNING) << "Tile is not observed by any source image";
+        continue;
+      }
+
+      Problem tile_problem;
+      tile_problem.ref_image_idx = 0;
+      tile_problem.src_image_idxs.resize(tile_images.size() - 1);
+      std::iota(tile_problem.src_image_idxs.begin(),
+                tile_problem.src_image_idxs.end(),
+                1);
+      tile_problem.images = &tile_images;
+      if (options_.geom_consistency) {
+        tile_problem.depth_maps = &tile_depth_maps;
+        tile_problem.normal_maps = &tile_normal_maps;
+      }
+
+      // The prior may have a different resolution than the reference image.
+      DepthMap tile_prior_depth_map;
+      if (problem_.prior_depth_map != nullptr) {
+        const DepthMap& prior_depth_map = *problem_.prior_depth_map;
+        const size_t prior_width = prior_depth_map.GetWidth();
+        const size_t prior_height = prior_depth_map.GetHeight();
+        tile_prior_depth_map = DepthMap(tile_width, tile_height, -1, -1);
+        for (size_t r = 0; r < tile_height; ++r) {
+          const size_t prior_r = std::min<size_t>(
+              (tile_y + r + 0.5f) * prior_height / height, prior_height - 1);
+          for (size_t c = 0; c < tile_width; ++c) {
+            const size_t prior_c = std::min<size_t>(
+                (tile_x + c + 0.5f) * prior_width / width, prior_width - 1);
+            tile_prior_depth_map.Set(
+                r, c, prior_depth_map.Get(prior_r, prior_c));
+          }
+        }
+        tile_problem.prior_depth_map = &tile_prior_depth_map;
+      }
+
+      PatchMatch tile_patch_match(tile_options, tile_problem);
+      tile_patch_match.Run();
+
+      const DepthMap tile_depth_map = tile_patch_match.GetDepthMap();
+      const NormalMap tile_normal_map = tile_patch_match.GetNormalMap();
+      for (size_t r = 0; r < tile_height; ++r) {
+        const float weight_y = ComputeTileWeight(
+            tile_y + r, tile_y, tile_height, height, tile_overlap);
+        for (size_t c = 0; c < tile_width; ++c) {
+          const float depth = tile_depth_map.Get(r, c);
+          if (depth <= 0) {
+            continue;
+          }
+          const float weight_x = ComputeTileWeight(
+              tile_x + c, tile_x, tile_width, width, tile_overlap);
+          const float weight = weight_x * weight_y;
+          const size_t row = tile_y + r;
+          const size_t col = tile_x + c;
+          depth_map.Set(row, col, depth_map.Get(row, col) + weight * depth);
+          for (int d = 0; d < 3; ++d) {
+            normal_map.Set(row,
+                           col,
+                           d,
+                           normal_map.Get(row, col, d) +
+                               weight * tile_normal_map.Get(r, c, d));
+          }
+          weight_map.Set(row, col, weight_map.Get(row, col) + weight);
+        }
+      }
+
+      // The consistency graph cannot be blended, so each pixel is taken from
+      // the tile, in which it is closest to the center.
+      const size_t min_col =
+          col_idx == 0 ? 0
+                       : ComputeTileBoundary(
+                             col_offsets, col_idx - 1, tile_width, width);
+      const size_t max_col =
+          ComputeTileBoundary(col_offsets, col_idx, tile_width, width);
+      const size_t min_row =
+          row_idx == 0 ? 0
+                       : ComputeTileBoundary(
+                             row_offsets, row_idx - 1, tile_height, height);
+      const size_t max_row =
+          ComputeTileBoundary(row_offsets, row_idx, tile_height, height);
+      const std::vector<int> tile_consistent_image_idxs =
+          tile_patch_match.solver_->GetConsistentImageIdxs();
+      std::vector<int>& consistent_image_idxs =
+          tiled_outputs_->consistent_image_idxs;
+      for (size_t i = 0; i < tile_consistent_image_idxs.size();) {
+        const size_t col = tile_x + tile_consistent_image_idxs[i];
+        const size_t row = tile_y + tile_consistent_image_idxs[i + 1];
+        const int num_images = tile_consistent_image_idxs[i + 2];
+        if (col >= min_col && col < max_col && row >= min_row &&
+            row < max_row) {
+          consistent_image_idxs.push_back(col);
+          consistent_image_idxs.push_back(row);
+          consistent_image_idxs.push_back(num_images);
+          for (int j = 0; j < num_images; ++j) {
+            consistent_image_idxs.push_back(
+                tile_image_idxs.at(tile_consistent_image_idxs[i + 3 + j]));
+          }
+        }
+        i += 3 + num_images;
+      }
+    }
+  }
+
+  for (size_t row = 0; row < height; ++row) {
+    for (size_t col = 0; col < width; ++col) {
+      const float weight = weight_map.Get(row, col);
+      if (weight <= 0) {
+        continue;
+      }
+      depth_map.Set(row, col, depth_map.Get(row, col) / weight);
+      Eigen::Vector3f normal;
+      normal_map.GetSlice(row, col, normal.data());
+      normal.normalize();
+      for (int d = 0; d < 3; ++d) {
+        normal_map.Set(row, col, d, normal(d));
+      }
+    }
+  }
 }
 
 DepthMap PatchMatch::GetDepthMap() const {
-  return patch_match_cuda_->GetDepthMap();
+  if (tiled_outputs_) {
+    return tiled_outputs_->depth_map;
+  }
+  return solver_->GetDepthMap();
 }
 
 NormalMap PatchMatch::GetNormalMap() const {
-  return patch_match_cuda_->GetNormalMap();
+  if (tiled_outputs_) {
+    return tiled_outputs_->normal_map;
+  }
+  return solver_->GetNormalMap();
 }
 
 Mat<float> PatchMatch::GetSelProbMap() const {
-  return patch_match_cuda_->GetSelProbMap();
+  THROW_CHECK(!tiled_outputs_)
+      << "Selection probabilities are not retained for tiled problems";
+  return solver_->GetSelProbMap();
 }
 
 ConsistencyGraph PatchMatch::GetConsistencyGraph() const {
   const auto& ref_image = problem_.images->at(problem_.ref_image_idx);
   return ConsistencyGraph(ref_image.GetWidth(),
                           ref_image.GetHeight(),
-                          patch_match_cuda_->GetConsistentImageIdxs());
+                          tiled_outputs_
+                              ? tiled_outputs_->consistent_image_idxs
+                              : solver_->GetConsistentImageIdxs());
 }
 
 PatchMatchController::PatchMatchController(
@@ -168,6 +699,7 @@ PatchMatchController::PatchMatchController(
 }
 
 void PatchMatchController::Run() {
+  ScopedResourceUsage resource_usage("PatchMatchController");
   Timer run_timer;
   run_timer.Start();
   ReadWorkspace();
@@ -177,6 +709,10 @@ void PatchMatchController::Run() {
   thread_pool_ = std::make_unique<ThreadPool>(gpu_indices_.size());
   io_thread_pool_ = std::make_unique<ThreadPool>(
       GetEffectiveNumThreads(options_.num_threads));
+  // Separate pools for the pipelined reads and writes, since the reads
+  // themselves wait on tasks in the I/O thread pool.
+  read_thread_pool_ = std::make_unique<ThreadPool>(gpu_indices_.size());
+  write_thread_pool_ = std::make_unique<ThreadPool>(gpu_indices_.size());
 
   // If geometric consistency is enabled, then photometric output must be
   // computed first for all images without filtering.
@@ -185,25 +721,217 @@ void PatchMatchController::Run() {
     photometric_options.geom_consistency = false;
     photometric_options.filter = false;
 
+    ProcessProblems(photometric_options);
+
+    // Other processes may still be computing photometric outputs.
+    if (options_.distributed) {
+      for (size_t problem_idx = 0; problem_idx < problems_.size();
+           ++problem_idx) {
+        while (!CheckIfStopped() &&
+               !HasOutputs(photometric_options, problem_idx)) {
+          LOG(INFO) << "Waiting for photometric outputs of other processes...";
+          std::this_thread::sleep_for(std::chrono::seconds(10));
+        }
+      }
+    }
+  }
+
+  ProcessProblems(options_);
+
+  run_timer.PrintMinutes();
+}
+
+void PatchMatchController::ProcessProblems(const PatchMatchOptions& options) {
+  claimed_problems_.assign(problems_.size(), false);
+  for (size_t i = 0; i < gpu_indices_.size(); ++i) {
+    thread_pool_->AddTask([this, &options]() {
+      const int gpu_index = gpu_indices_.at(thread_pool_->GetThreadIndex());
+      THROW_CHECK_GE(gpu_index, -1);
+
+      using ProblemInputsFuture =
+          std::shared_future<std::shared_ptr<ProblemInputs>>;
+      std::deque<std::pair<int, ProblemInputsFuture>> next_problems;
+      std::deque<std::shared_future<void>> pending_writes;
+      int problem_idx = -1;
+      while (true) {
+        while (!CheckIfStopped() &&
+               next_problems.size() <=
+                   static_cast<size_t>(options.io_pipeline_depth) &&
+               (problem_idx = ClaimNextProblem(options, problem_idx)) != -1) {
+          next_problems.emplace_back(
+              problem_idx,
+              read_thread_pool_->AddTask(
+                  &PatchMatchController::ReadProblemInputs,
+                  this,
+                  options,
+                  problem_idx));
+        }
+
+        if (next_problems.empty()) {
+          break;
+        }
+
+        const int curr_problem_idx = next_problems.front().first;
+        const std::shared_ptr<ProblemInputs> inputs =
+            next_problems.front().second.get();
+        next_problems.pop_front();
+
+        if (inputs == nullptr || CheckIfStopped()) {
+          ReleaseProblem(options, curr_problem_idx);
+          continue;
+        }
+
+        ProcessProblem(options,
+                       curr_problem_idx,
+                       gpu_index,
+                       inputs.get(),
+                       &pending_writes);
+      }
+
+      for (auto& pending_write : pending_writes) {
+        pending_write.get();
+      }
+    });
+  }
+  thread_pool_->Wait();
+}
+
+int PatchMatchController::ClaimNextProblem(const PatchMatchOptions& options,
+                                           const int prev_problem_idx) {
+  std::lock_guard<std::mutex> lock(schedule_mutex_);
+  while (true) {
+    int best_problem_idx = -1;
+    size_t best_num_shared_images = 0;
     for (size_t problem_idx = 0; problem_idx < problems_.size();
          ++problem_idx) {
-      thread_pool_->AddTask(&PatchMatchController::ProcessProblem,
-                            this,
-                            photometric_options,
-                            problem_idx);
+      if (claimed_problems_[problem_idx]) {
+        continue;
+      }
+      size_t num_shared_images = 0;
+      if (prev_problem_idx != -1) {
+        const std::vector<int>& image_idxs = problem_image_idxs_[problem_idx];
+        const std::vector<int>& prev_image_idxs =
+            problem_image_idxs_[prev_problem_idx];
+        auto it = image_idxs.begin();
+        auto prev_it = prev_image_idxs.begin();
+        while (it != image_idxs.end() && prev_it != prev_image_idxs.end()) {
+          if (*it < *prev_it) {
+            ++it;
+          } else if (*prev_it < *it) {
+            ++prev_it;
+          } else {
+            ++num_shared_images;
+            ++it;
+            ++prev_it;
+          }
+        }
+      }
+      if (best_problem_idx == -1 ||
+          num_shared_images > best_num_shared_images) {
+        best_problem_idx = problem_idx;
+        best_num_shared_images = num_shared_images;
+      }
     }
 
-    thread_pool_->Wait();
+    if (best_problem_idx == -1) {
+      return -1;
+    }
+
+    claimed_problems_[best_problem_idx] = true;
+
+    // Creating a directory is atomic also on network file systems, so it
+    // serves as a lock between processes.
+    if (options.distributed) {
+      const auto lock_path = GetOutputPath(options, best_problem_idx, "locks");
+      std::filesystem::create_directories(lock_path.parent_path());
+      if (!std::filesystem::create_directory(lock_path)) {
+        continue;
+      }
+    }
+
+    return best_problem_idx;
   }
+}
 
-  for (size_t problem_idx = 0; problem_idx < problems_.size(); ++problem_idx) {
-    thread_pool_->AddTask(
-        &PatchMatchController::ProcessProblem, this, options_, problem_idx);
+void PatchMatchController::ReleaseProblem(const PatchMatchOptions& options,
+                                          const size_t problem_idx) {
+  if (options.distributed) {
+    std::filesystem::remove(GetOutputPath(options, problem_idx, "locks"));
   }
+}
 
-  thread_pool_->Wait();
+std::filesystem::path PatchMatchController::GetOutputPath(
+    const PatchMatchOptions& options,
+    const size_t problem_idx,
+    const std::string& folder) const {
+  return GetImageOutputPath(
+      options, problems_.at(problem_idx).ref_image_idx, folder);
+}
 
-  run_timer.PrintMinutes();
+std::filesystem::path PatchMatchController::GetImageOutputPath(
+    const PatchMatchOptions& options,
+    const int image_idx,
+    const std::string& folder) const {
+  const std::string output_type =
+      options.geom_consistency ? "geometric" : "photometric";
+  const std::string image_name = workspace_->GetModel().GetImageName(image_idx);
+  return workspace_path_ / workspace_->GetOptions().stereo_folder / folder /
+         StringPrintf("%s.%s.bin", image_name.c_str(), output_type.c_str());
+}
+
+bool PatchMatchController::HasOutputs(const PatchMatchOptions& options,
+                                      const size_t problem_idx) const {
+  return ExistsFile(GetOutputPath(options, problem_idx, "depth_maps")) &&
+         ExistsFile(GetOutputPath(options, problem_idx, "normal_maps")) &&
+         (!options.write_consistency_graph ||
+          ExistsFile(
+              GetOutputPath(options, problem_idx, "consistency_graphs"))) &&
+         !HasOutdatedOutputs(options, problem_idx);
+}
+
+bool PatchMatchController::HasOutdatedOutputs(
+    const PatchMatchOptions& options, const size_t problem_idx) const {
+  // Outputs without recorded dependencies, e.g., of previous versions, are
+  // assumed to be up to date.
+  const auto dependencies_path = GetDependenciesPath(options, problem_idx);
+  if (ExistsFile(dependencies_path) &&
+      ReadTextFileLines(dependencies_path) !=
+          GetSourceImageNames(problem_idx)) {
+    return true;
+  }
+
+  if (options.geom_consistency) {
+    PatchMatchOptions photometric_options = options;
+    photometric_options.geom_consistency = false;
+    const auto output_time = std::filesystem::last_write_time(
+        GetOutputPath(options, problem_idx, "depth_maps"));
+    for (const int image_idx : problem_image_idxs_.at(problem_idx)) {
+      const auto photometric_path =
+          GetImageOutputPath(photometric_options, image_idx, "depth_maps");
+      if (ExistsFile(photometric_path) &&
+          std::filesystem::last_write_time(photometric_path) > output_time) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+std::filesystem::path PatchMatchController::GetDependenciesPath(
+    const PatchMatchOptions& options, const size_t problem_idx) const {
+  return GetOutputPath(options, problem_idx, "dependencies")
+      .replace_extension(".txt");
+}
+
+std::vector<std::string> PatchMatchController::GetSourceImageNames(
+    const size_t problem_idx) const {
+  const auto& model = workspace_->GetModel();
+  std::vector<std::string> src_image_names;
+  for (const int src_image_idx : problems_.at(problem_idx).src_image_idxs) {
+    src_image_names.push_back(model.GetImageName(src_image_idx));
+  }
+  return src_image_names;
 }
 
 void PatchMatchController::ReadWorkspace() {
@@ -252,6 +980,7 @@ void PatchMatchController::ReadProblems() {
 
   std::vector<std::map<int, int>> shared_num_points;
   std::vector<std::map<int, float>> triangulation_angles;
+  std::vector<std::map<int, float>> src_image_scores;
 
   const float min_triangulation_angle_rad =
       DegToRad(options_.min_triangulation_angle);
@@ -307,12 +1036,17 @@ void PatchMatchController::ReadProblems() {
                problem_config.src_image_names[0] == "__auto__") {
       // Use maximum number of overlapping images as source images. Overlapping
       // will be sorted based on the number of shared points to the reference
-      // image and the top ranked images are selected. Note that images are only
-      // selected if some points have a sufficient triangulation angle.
+      // image or their scores and the top ranked images are selected. Note
+      // that images are only selected if some points have a sufficient
+      // triangulation angle.
 
       if (shared_num_points.empty()) {
         shared_num_points = model.ComputeSharedPoints();
       }
+      if (src_image_scores.empty() &&
+          options_.src_image_selection == "score") {
+        src_image_scores = model.ComputeSourceImageScores();
+      }
       if (triangulation_angles.empty()) {
         const float kTriangulationAnglePercentile = 75;
         triangulation_angles =
@@ -327,12 +1061,18 @@ void PatchMatchController::ReadProblems() {
       const auto& overlapping_triangulation_angles =
           triangulation_angles.at(problem.ref_image_idx);
 
-      std::vector<std::pair<int, int>> src_images;
+      std::vector<std::pair<int, float>> src_images;
       src_images.reserve(overlapping_images.size());
       for (const auto& image : overlapping_images) {
         if (overlapping_triangulation_angles.at(image.first) >=
             min_triangulation_angle_rad) {
-          src_images.emplace_back(image.first, image.second);
+          float score = image.second;
+          if (!src_image_scores.empty()) {
+            const auto& scores = src_image_scores.at(problem.ref_image_idx);
+            const auto score_it = scores.find(image.first);
+            score = score_it == scores.end() ? 0 : score_it->second;
+          }
+          src_images.emplace_back(image.first, score);
         }
       }
 
@@ -342,8 +1082,8 @@ void PatchMatchController::ReadProblems() {
       std::partial_sort(src_images.begin(),
                         src_images.begin() + eff_max_num_src_images,
                         src_images.end(),
-                        [](const std::pair<int, int>& image1,
-                           const std::pair<int, int>& image2) {
+                        [](const std::pair<int, float>& image1,
+                           const std::pair<int, float>& image2) {
                           return image1.second > image2.second;
                         });
 
@@ -368,57 +1108,53 @@ void PatchMatchController::ReadProblems() {
     }
   }
 
+  problem_image_idxs_.clear();
+  problem_image_idxs_.reserve(problems_.size());
+  for (const auto& problem : problems_) {
+    std::vector<int> image_idxs = problem.src_image_idxs;
+    image_idxs.push_back(problem.ref_image_idx);
+    std::sort(image_idxs.begin(), image_idxs.end());
+    problem_image_idxs_.push_back(std::move(image_idxs));
+  }
+
   LOG(INFO) << StringPrintf("Configuration has %d problems...",
                             problems_.size());
 }
 
 void PatchMatchController::ReadGpuIndices() {
+  // The CPU implementation is multi-threaded per problem, so a single worker
+  // processes all problems.
+  if (!options_.use_gpu) {
+    gpu_indices_ = {-1};
+    return;
+  }
+
   gpu_indices_ = CSVToVector<int>(options_.gpu_index);
+#if defined(COLMAP_CUDA_ENABLED)
   if (gpu_indices_.size() == 1 && gpu_indices_[0] == -1) {
     const int num_cuda_devices = GetNumCudaDevices();
     THROW_CHECK_GT(num_cuda_devices, 0);
     gpu_indices_.resize(num_cuda_devices);
     std::iota(gpu_indices_.begin(), gpu_indices_.end(), 0);
   }
+#endif  // COLMAP_CUDA_ENABLED
 }
 
-void PatchMatchController::ProcessProblem(const PatchMatchOptions& options,
-                                          const size_t problem_idx) {
-  if (CheckIfStopped()) {
-    return;
+std::shared_ptr<PatchMatchController::ProblemInputs>
+PatchMatchController::ReadProblemInputs(const PatchMatchOptions& options,
+                                        const size_t problem_idx) {
+  if (CheckIfStopped() || HasOutputs(options, problem_idx)) {
+    return nullptr;
   }
 
   const auto& model = workspace_->GetModel();
 
-  auto& problem = problems_.at(problem_idx);
-  const int gpu_index = gpu_indices_.at(thread_pool_->GetThreadIndex());
-  THROW_CHECK_GE(gpu_index, -1);
+  auto inputs = std::make_shared<ProblemInputs>();
+  PatchMatch::Problem& problem = inputs->problem;
+  problem = problems_.at(problem_idx);
 
-  const std::string& stereo_folder = workspace_->GetOptions().stereo_folder;
-  const std::string output_type =
-      options.geom_consistency ? "geometric" : "photometric";
-  const std::string image_name = model.GetImageName(problem.ref_image_idx);
-  const std::string file_name =
-      StringPrintf("%s.%s.bin", image_name.c_str(), output_type.c_str());
-  const auto depth_map_path =
-      workspace_path_ / stereo_folder / "depth_maps" / file_name;
-  const auto normal_map_path =
-      workspace_path_ / stereo_folder / "normal_maps" / file_name;
-  const auto consistency_graph_path =
-      workspace_path_ / stereo_folder / "consistency_graphs" / file_name;
-
-  if (ExistsFile(depth_map_path) && ExistsFile(normal_map_path) &&
-      (!options.write_consistency_graph ||
-       ExistsFile(consistency_graph_path))) {
-    return;
-  }
-
-  LOG_HEADING1(StringPrintf("Processing view %d / %d for %s",
-                            problem_idx + 1,
-                            problems_.size(),
-                            image_name.c_str()));
-
-  auto patch_match_options = options;
+  auto& patch_match_options = inputs->options;
+  patch_match_options = options;
 
   if (patch_match_options.depth_min < 0 || patch_match_options.depth_max < 0) {
     patch_match_options.depth_min =
@@ -431,15 +1167,14 @@ void PatchMatchController::ProcessProblem(const PatchMatchOptions& options,
            "sparse model is provided in the workspace.";
   }
 
-  patch_match_options.gpu_index = std::to_string(gpu_index);
-
   if (patch_match_options.sigma_spatial <= 0.0f) {
     patch_match_options.sigma_spatial = patch_match_options.window_radius;
   }
 
-  std::vector<Image> images = model.images;
-  std::vector<DepthMap> depth_maps;
-  std::vector<NormalMap> normal_maps;
+  std::vector<Image>& images = inputs->images;
+  std::vector<DepthMap>& depth_maps = inputs->depth_maps;
+  std::vector<NormalMap>& normal_maps = inputs->normal_maps;
+  images = model.images;
   if (options.geom_consistency) {
     depth_maps.resize(model.images.size());
     normal_maps.resize(model.images.size());
@@ -516,10 +1251,54 @@ void PatchMatchController::ProcessProblem(const PatchMatchOptions& options,
     problem.src_image_idxs = src_image_idxs;
   }
 
-  problem.Print();
-  patch_match_options.Print();
+  if (!options.geom_consistency && options.init_mode != "random") {
+    const Image& ref_image = images.at(problem.ref_image_idx);
+    if (options.init_mode == "sparse") {
+      inputs->prior_depth_map = ComputeSparseDepthPrior(
+          ref_image, problem.ref_image_idx, model.points);
+      problem.prior_depth_map = &inputs->prior_depth_map;
+    } else if (options.init_mode == "prior") {
+      const auto& workspace_options = workspace_->GetOptions();
+      const auto prior_path =
+          workspace_options.workspace_path / workspace_options.stereo_folder /
+          "prior_depth_maps" /
+          (model.GetImageName(problem.ref_image_idx) + ".bin");
+      if (ExistsFile(prior_path)) {
+        inputs->prior_depth_map.Read(prior_path);
+        problem.prior_depth_map = &inputs->prior_depth_map;
+      } else {
+        LOG(WARNING) << "Missing prior depth map " << prior_path
+                     << ", initializing randomly";
+      }
+    }
+  }
+
+  return inputs;
+}
+
+void PatchMatchController::ProcessProblem(
+    const PatchMatchOptions& options,
+    const size_t problem_idx,
+    const int gpu_index,
+    ProblemInputs* inputs,
+    std::deque<std::shared_future<void>>* pending_writes) {
+  COLMAP_TRACE_ZONE("PatchMatchProblem");
+  const std::string output_type =
+      options.geom_consistency ? "geometric" : "photometric";
+  const std::string image_name =
+      workspace_->GetModel().GetImageName(inputs->problem.ref_image_idx);
+
+  LOG_HEADING1(StringPrintf("Processing view %d / %d for %s",
+                            problem_idx + 1,
+                            problems_.size(),
+                            image_name.c_str()));
 
-  PatchMatch patch_match(patch_match_options, problem);
+  inputs->options.gpu_index = std::to_string(gpu_index);
+
+  inputs->problem.Print();
+  inputs->options.Print();
+
+  PatchMatch patch_match(inputs->options, inputs->problem);
   patch_match.Run();
 
   LOG(INFO) << std::endl
@@ -527,10 +1306,63 @@ void PatchMatchController::ProcessProblem(const PatchMatchOptions& options,
                             output_type.c_str(),
                             image_name.c_str());
 
-  patch_match.GetDepthMap().Write(depth_map_path);
-  patch_match.GetNormalMap().Write(normal_map_path);
+  // Limit the number of outputs held in memory.
+  while (pending_writes->size() >
+         static_cast<size_t>(options.io_pipeline_depth)) {
+    pending_writes->front().get();
+    pending_writes->pop_front();
+  }
+
+  DepthMap depth_map = patch_match.GetDepthMap();
+  NormalMap normal_map = patch_match.GetNormalMap();
+  ConsistencyGraph consistency_graph;
   if (options.write_consistency_graph) {
-    patch_match.GetConsistencyGraph().Write(consistency_graph_path);
+    consistency_graph = patch_match.GetConsistencyGraph();
+  }
+
+  pending_writes->push_back(write_thread_pool_->AddTask(
+      [this,
+       &options,
+       problem_idx,
+       depth_map = std::move(depth_map),
+       normal_map = std::move(normal_map),
+       consistency_graph = std::move(consistency_graph)]() {
+        const auto depth_map_path =
+            GetOutputPath(options, problem_idx, "depth_maps");
+        const auto normal_map_path =
+            GetOutputPath(options, problem_idx, "normal_maps");
+        if (options.map_compression == "none") {
+          depth_map.Write(depth_map_path);
+          normal_map.Write(normal_map_path);
+        } else {
+          MatCompressionOptions compression_options;
+          compression_options.quantize = options.map_compression == "quantized";
+          depth_map.WriteCompressed(depth_map_path, compression_options);
+          normal_map.WriteCompressed(normal_map_path, compression_options);
+        }
+        if (options.write_consistency_graph) {
+          consistency_graph.Write(
+              GetOutputPath(options, problem_idx, "consistency_graphs"));
+        }
+        // Record the source images, so that the outputs are recomputed once
+        // they change, e.g., when adding images to the workspace.
+        const auto dependencies_path =
+            GetDependenciesPath(options, problem_idx);
+        std::filesystem::create_directories(dependencies_path.parent_path());
+        std::ofstream dependencies_file(dependencies_path);
+        THROW_CHECK_FILE_OPEN(dependencies_file, dependencies_path);
+        for (const auto& src_image_name : GetSourceImageNames(problem_idx)) {
+          dependencies_file << src_image_name << "\n";
+        }
+        dependencies_file.close();
+        ReleaseProblem(options, problem_idx);
+      }));
+
+  IncrementMetricCounter("colmap_patch_match_problems_total");
+
+  if (options.io_pipeline_depth == 0) {
+    pending_writes->back().get();
+    pending_writes->pop_back();
   }
 }
 
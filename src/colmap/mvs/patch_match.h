@@ -38,6 +38,7 @@
 #include "colmap/util/threading.h"
 #endif
 
+#include <deque>
 #include <filesystem>
 #include <memory>
 #include <vector>
@@ -46,12 +47,13 @@ namespace colmap {
 namespace mvs {
 
 class ConsistencyGraph;
-class PatchMatchCuda;
+class PatchMatchSolver;
 class Workspace;
 
-// This is a wrapper class around the actual PatchMatchCuda implementation. This
-// class is necessary to hide Cuda code from any boost or Eigen code, since
-// NVCC/MSVC cannot compile complex C++ code.
+// This is a wrapper class around the actual PatchMatchCuda or PatchMatchCpu
+// implementation, see `PatchMatchOptions::use_gpu`. This class is necessary to
+// hide Cuda code from any boost or Eigen code, since NVCC/MSVC cannot compile
+// complex C++ code.
 class PatchMatch {
  public:
   struct Problem {
@@ -70,6 +72,11 @@ class PatchMatch {
     // Input normal maps for the geometric consistency term.
     std::vector<NormalMap>* normal_maps = nullptr;
 
+    // Optional prior depth map of the reference image for the initialization
+    // of the photometric problem, see `PatchMatchOptions::init_mode`. Pixels
+    // with non-positive depth have no prior.
+    const DepthMap* prior_depth_map = nullptr;
+
     // Print the configuration to stdout.
     void Print() const;
   };
@@ -90,9 +97,35 @@ class PatchMatch {
   Mat<float> GetSelProbMap() const;
 
  private:
+  // Solve the problem in overlapping tiles of the reference image and blend
+  // the outputs of the tiles, see `PatchMatchOptions::tile_size`.
+  void RunTiled();
+
   const PatchMatchOptions options_;
   const Problem problem_;
-  std::unique_ptr<PatchMatchCuda> patch_match_cuda_;
+  std::unique_ptr<PatchMatchSolver> solver_;
+
+  // Blended outputs, if the reference image was solved in tiles.
+  struct TiledOutputs {
+    DepthMap depth_map;
+    NormalMap normal_map;
+    std::vector<int> consistent_image_idxs;
+  };
+  std::unique_ptr<TiledOutputs> tiled_outputs_;
+};
+
+// Interface of the PatchMatch implementations, which solve a single problem on
+// either the GPU or the CPU.
+class PatchMatchSolver {
+ public:
+  virtual ~PatchMatchSolver() = default;
+
+  virtual void Run() = 0;
+
+  virtual DepthMap GetDepthMap() const = 0;
+  virtual NormalMap GetNormalMap() const = 0;
+  virtual Mat<float> GetSelProbMap() const = 0;
+  virtual std::vector<int> GetConsistentImageIdxs() const = 0;
 };
 
 // This thread processes all problems in a workspace. A workspace has the
@@ -139,7 +172,52 @@ class PatchMatchController : public BaseController {
   void ReadWorkspace();
   void ReadProblems();
   void ReadGpuIndices();
-  void ProcessProblem(const PatchMatchOptions& options, size_t problem_idx);
+
+  // Inputs of a problem read from the workspace. The problem points to the
+  // images and maps owned by this struct.
+  struct ProblemInputs {
+    PatchMatchOptions options;
+    PatchMatch::Problem problem;
+    std::vector<Image> images;
+    std::vector<DepthMap> depth_maps;
+    std::vector<NormalMap> normal_maps;
+    DepthMap prior_depth_map;
+  };
+
+  // Process all problems with one worker per GPU. Each worker continues with
+  // the unprocessed problem sharing the most images with its previous
+  // problem, so that the inputs are likely still in the workspace cache.
+  // The inputs of the next problems are read and the outputs of the previous
+  // problems are written in the background, see `io_pipeline_depth`.
+  void ProcessProblems(const PatchMatchOptions& options);
+  int ClaimNextProblem(const PatchMatchOptions& options, int prev_problem_idx);
+  void ReleaseProblem(const PatchMatchOptions& options, size_t problem_idx);
+  // Returns null if the problem has already been processed.
+  std::shared_ptr<ProblemInputs> ReadProblemInputs(
+      const PatchMatchOptions& options, size_t problem_idx);
+  void ProcessProblem(const PatchMatchOptions& options,
+                      size_t problem_idx,
+                      int gpu_index,
+                      ProblemInputs* inputs,
+                      std::deque<std::shared_future<void>>* pending_writes);
+
+  std::filesystem::path GetOutputPath(const PatchMatchOptions& options,
+                                      size_t problem_idx,
+                                      const std::string& folder) const;
+  std::filesystem::path GetImageOutputPath(const PatchMatchOptions& options,
+                                           int image_idx,
+                                           const std::string& folder) const;
+  // Returns true if the outputs of the problem exist and are up to date.
+  bool HasOutputs(const PatchMatchOptions& options, size_t problem_idx) const;
+  // The outputs of a problem are outdated, if its source images changed since
+  // they were computed, e.g., after adding new images to the workspace, or if
+  // the photometric outputs of any of its images were recomputed after the
+  // geometric outputs.
+  bool HasOutdatedOutputs(const PatchMatchOptions& options,
+                          size_t problem_idx) const;
+  std::filesystem::path GetDependenciesPath(const PatchMatchOptions& options,
+                                            size_t problem_idx) const;
+  std::vector<std::string> GetSourceImageNames(size_t problem_idx) const;
 
   const PatchMatchOptions options_;
   const std::filesystem::path workspace_path_;
@@ -149,9 +227,15 @@ class PatchMatchController : public BaseController {
 
   std::unique_ptr<ThreadPool> thread_pool_;
   std::unique_ptr<ThreadPool> io_thread_pool_;
+  std::unique_ptr<ThreadPool> read_thread_pool_;
+  std::unique_ptr<ThreadPool> write_thread_pool_;
   std::mutex workspace_mutex_;
   std::unique_ptr<Workspace> workspace_;
   std::vector<PatchMatch::Problem> problems_;
+  // Sorted reference and source images of each problem.
+  std::vector<std::vector<int>> problem_image_idxs_;
+  std::mutex schedule_mutex_;
+  std::vector<bool> claimed_problems_;
   std::vector<int> gpu_indices_;
   std::vector<std::pair<float, float>> depth_ranges_;
 };
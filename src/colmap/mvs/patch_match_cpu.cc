@@ -0,0 +1,847 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/mvs/patch_match_cpu.h"
+
+#include "colmap/math/math.h"
+#include "colmap/util/logging.h"
+#include "colmap/util/misc.h"
+#include "colmap/util/string.h"
+#include "colmap/util/timer.h"
+#include "colmap/util/tracing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#include <Eigen/Geometry>
+#include <Eigen/LU>
+
+namespace colmap {
+namespace mvs {
+namespace {
+
+using RowMajorMatrix3f = Eigen::Matrix<float, 3, 3, Eigen::RowMajor>;
+using RowMajorMatrix3x4f = Eigen::Matrix<float, 3, 4, Eigen::RowMajor>;
+
+// Maximum photo consistency cost as 1 - min(NCC).
+constexpr float kMaxCost = 2.0f;
+
+// Minimum variance of the window colors, below which the NCC is undefined.
+constexpr float kMinVar = 1e-5f;
+
+// Probability of the source image not observing the pixel, for which the
+// emission probability is uniform.
+constexpr float kUniformProb = 0.5f;
+
+// Width and height of the tiles, which are claimed by the worker threads.
+constexpr int kTileSize = 64;
+
+// Source images with a lower sampling probability are not evaluated.
+constexpr float kMinSamplingProb = 1e-3f;
+
+// Offsets of the propagated neighbors. All offsets are odd, so that the
+// neighbors have the other checkerboard color than the updated pixel.
+constexpr int kNumNeighbors = 8;
+constexpr int kNeighborOffsets[kNumNeighbors][2] = {
+    {-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-3, 0}, {3, 0}, {0, -3}, {0, 3}};
+
+std::vector<float> ReadIntensities(const Bitmap& bitmap) {
+  const std::vector<uint8_t>& data = bitmap.RowMajorData();
+  std::vector<float> intensities(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    intensities[i] = data[i] / 255.0f;
+  }
+  return intensities;
+}
+
+// Bilinear interpolation with zero intensity outside of the image.
+float ReadBilinear(const std::vector<float>& data,
+                   const int width,
+                   const int height,
+                   const float x,
+                   const float y) {
+  if (!(x > -1.0f && y > -1.0f && x < width && y < height)) {
+    return 0.0f;
+  }
+
+  const float x0_floor = std::floor(x);
+  const float y0_floor = std::floor(y);
+  const int x0 = static_cast<int>(x0_floor);
+  const int y0 = static_cast<int>(y0_floor);
+  const float dx = x - x0_floor;
+  const float dy = y - y0_floor;
+
+  const auto Read = [&](const int xx, const int yy) {
+    if (xx < 0 || yy < 0 || xx >= width || yy >= height) {
+      return 0.0f;
+    }
+    return data[yy * width + xx];
+  };
+
+  return (1.0f - dy) * ((1.0f - dx) * Read(x0, y0) + dx * Read(x0 + 1, y0)) +
+         dy * ((1.0f - dx) * Read(x0, y0 + 1) + dx * Read(x0 + 1, y0 + 1));
+}
+
+}  // namespace
+
+PatchMatchCpu::PatchMatchCpu(const PatchMatchOptions& options,
+                             const PatchMatch::Problem& problem,
+                             const DepthMap* init_depth_map,
+                             const NormalMap* init_normal_map)
+    : options_(options),
+      problem_(problem),
+      num_threads_(GetEffectiveNumThreads(options.num_threads)) {
+  const Image& ref_image = problem_.images->at(problem_.ref_image_idx);
+  width_ = ref_image.GetWidth();
+  height_ = ref_image.GetHeight();
+  num_tiles_x_ = (width_ + kTileSize - 1) / kTileSize;
+  num_tiles_y_ = (height_ + kTileSize - 1) / kTileSize;
+
+  ref_K_ = Eigen::Map<const RowMajorMatrix3f>(ref_image.GetK());
+  ref_inv_K_ = ref_K_.inverse();
+  ref_image_ = ReadIntensities(ref_image.GetBitmap());
+
+  cos_min_triangulation_angle_ =
+      std::cos(DegToRad(options_.min_triangulation_angle));
+  inv_incident_angle_sigma_square_ =
+      -0.5f / (options_.incident_angle_sigma * options_.incident_angle_sigma);
+  inv_ncc_sigma_square_ = -0.5f / (options_.ncc_sigma * options_.ncc_sigma);
+  // The normalization of the likelihood, see PatchMatchCuda.
+  ncc_norm_factor_ =
+      2.0f / (std::sqrt(2.0f * EIGEN_PI) * options_.ncc_sigma *
+              std::erf(2.0f / (options_.ncc_sigma * std::sqrt(2.0f))));
+
+  // Offsets and spatial bilateral weights of the window samples.
+  std::vector<float> row_offsets;
+  std::vector<float> col_offsets;
+  for (int row = -options_.window_radius; row <= options_.window_radius;
+       row += options_.window_step) {
+    for (int col = -options_.window_radius; col <= options_.window_radius;
+         col += options_.window_step) {
+      row_offsets.push_back(row);
+      col_offsets.push_back(col);
+    }
+  }
+  window_row_offsets_ =
+      Eigen::Map<const Eigen::ArrayXf>(row_offsets.data(), row_offsets.size());
+  window_col_offsets_ =
+      Eigen::Map<const Eigen::ArrayXf>(col_offsets.data(), col_offsets.size());
+  window_spatial_weights_ =
+      -(window_row_offsets_.square() + window_col_offsets_.square()) /
+      (2.0f * options_.sigma_spatial * options_.sigma_spatial);
+
+  InitSourceImages();
+  InitWorkspace(init_depth_map, init_normal_map);
+}
+
+void PatchMatchCpu::Run() {
+  Timer total_timer;
+  total_timer.Start();
+
+  thread_pool_ = std::make_unique<ThreadPool>(
+      std::min(num_threads_, num_tiles_x_ * num_tiles_y_));
+
+  Timer init_timer;
+  init_timer.Start();
+  {
+    TraceZone trace_zone("PatchMatchInitialCost");
+    trace_zone.SetNumItems(static_cast<int64_t>(width_) * height_);
+    ParallelForTiles(
+        0, [this](const int tile_idx, std::mt19937*, Window* window) {
+          ForEachPixelInTile(tile_idx, -1, [&](const int row, const int col) {
+            ComputeInitialCost(row, col, window);
+          });
+        });
+  }
+  LOG(INFO) << StringPrintf("Initialization: %.4fs",
+                            init_timer.ElapsedSeconds());
+
+  // Every iteration updates both checkerboard colors once.
+  const float total_num_steps = 2 * options_.num_iterations;
+  for (int iter = 0; iter < options_.num_iterations; ++iter) {
+    Timer iter_timer;
+    iter_timer.Start();
+
+    for (int color = 0; color < 2; ++color) {
+      // Each pass updates the pixels of one checkerboard color.
+      TraceZone trace_zone("PatchMatchSweep");
+      trace_zone.SetNumItems(static_cast<int64_t>(width_) * height_ / 2);
+      const int step = 2 * iter + color;
+      // Exponentially reduce amount of perturbation during the optimization.
+      const float perturbation = 1.0f / std::pow(2.0f, iter + color / 2.0f);
+      // Linearly increase the influence of previous selection probabilities.
+      const float prev_sel_prob_weight = step / total_num_steps;
+      ParallelForTiles(
+          step + 1,
+          [&](const int tile_idx, std::mt19937* prng, Window* window) {
+            ForEachPixelInTile(
+                tile_idx, color, [&](const int row, const int col) {
+                  UpdatePixel(row,
+                              col,
+                              perturbation,
+                              prev_sel_prob_weight,
+                              prng,
+                              window);
+                });
+          });
+    }
+
+    LOG(INFO) << StringPrintf(
+        "Iteration %d: %.4fs", iter + 1, iter_timer.ElapsedSeconds());
+  }
+
+  if (options_.filter) {
+    ParallelForTiles(
+        0, [this](const int tile_idx, std::mt19937*, Window*) {
+          ForEachPixelInTile(tile_idx, -1, [&](const int row, const int col) {
+            FilterPixel(row, col);
+          });
+        });
+  }
+
+  thread_pool_.reset();
+
+  LOG(INFO) << StringPrintf("Total: %.4fs", total_timer.ElapsedSeconds());
+}
+
+DepthMap PatchMatchCpu::GetDepthMap() const {
+  return DepthMap(depth_map_, options_.depth_min, options_.depth_max);
+}
+
+NormalMap PatchMatchCpu::GetNormalMap() const {
+  return NormalMap(normal_map_);
+}
+
+Mat<float> PatchMatchCpu::GetSelProbMap() const { return sel_prob_map_; }
+
+std::vector<int> PatchMatchCpu::GetConsistentImageIdxs() const {
+  std::vector<int> consistent_image_idxs;
+  std::vector<int> pixel_consistent_image_idxs;
+  pixel_consistent_image_idxs.reserve(consistency_mask_.GetDepth());
+  for (size_t r = 0; r < consistency_mask_.GetHeight(); ++r) {
+    for (size_t c = 0; c < consistency_mask_.GetWidth(); ++c) {
+      pixel_consistent_image_idxs.clear();
+      for (size_t d = 0; d < consistency_mask_.GetDepth(); ++d) {
+        if (consistency_mask_.Get(r, c, d)) {
+          pixel_consistent_image_idxs.push_back(problem_.src_image_idxs[d]);
+        }
+      }
+      if (pixel_consistent_image_idxs.size() > 0) {
+        consistent_image_idxs.push_back(c);
+        consistent_image_idxs.push_back(r);
+        consistent_image_idxs.push_back(pixel_consistent_image_idxs.size());
+        consistent_image_idxs.insert(consistent_image_idxs.end(),
+                                     pixel_consistent_image_idxs.begin(),
+                                     pixel_consistent_image_idxs.end());
+      }
+    }
+  }
+  return consistent_image_idxs;
+}
+
+void PatchMatchCpu::InitSourceImages() {
+  const Image& ref_image = problem_.images->at(problem_.ref_image_idx);
+  src_images_.resize(problem_.src_image_idxs.size());
+  for (size_t i = 0; i < problem_.src_image_idxs.size(); ++i) {
+    const int image_idx = problem_.src_image_idxs[i];
+    const Image& image = problem_.images->at(image_idx);
+    SourceImage& src_image = src_images_[i];
+    src_image.width = image.GetWidth();
+    src_image.height = image.GetHeight();
+    src_image.data = ReadIntensities(image.GetBitmap());
+    if (options_.geom_consistency) {
+      src_image.depth_map = &problem_.depth_maps->at(image_idx);
+    }
+
+    float R[9];
+    float T[3];
+    ComputeRelativePose(
+        ref_image.GetR(), ref_image.GetT(), image.GetR(), image.GetT(), R, T);
+    float C[3];
+    ComputeProjectionCenter(R, T, C);
+    float P[12];
+    ComposeProjectionMatrix(image.GetK(), R, T, P);
+    float inv_P[12];
+    ComposeInverseProjectionMatrix(image.GetK(), R, T, inv_P);
+
+    src_image.K = Eigen::Map<const RowMajorMatrix3f>(image.GetK());
+    src_image.R = Eigen::Map<const RowMajorMatrix3f>(R);
+    src_image.T = Eigen::Map<const Eigen::Vector3f>(T);
+    src_image.C = Eigen::Map<const Eigen::Vector3f>(C);
+    src_image.P = Eigen::Map<const RowMajorMatrix3x4f>(P);
+    src_image.inv_P = Eigen::Map<const RowMajorMatrix3x4f>(inv_P);
+  }
+}
+
+void PatchMatchCpu::InitWorkspace(const DepthMap* init_depth_map,
+                                  const NormalMap* init_normal_map) {
+  const size_t num_src_images = src_images_.size();
+  depth_map_ = Mat<float>(width_, height_, 1);
+  normal_map_ = Mat<float>(width_, height_, 3);
+  cost_map_ = Mat<float>(width_, height_, num_src_images);
+  sel_prob_map_ = Mat<float>(width_, height_, num_src_images);
+  sel_prob_map_.Fill(0.5f);
+  if (options_.filter) {
+    consistency_mask_ = Mat<uint8_t>(width_, height_, num_src_images);
+    consistency_mask_.Fill(0);
+  }
+
+  const Mat<float>* init_depths = init_depth_map;
+  const Mat<float>* init_normals = init_normal_map;
+  if (options_.geom_consistency) {
+    if (init_depths == nullptr) {
+      init_depths = &problem_.depth_maps->at(problem_.ref_image_idx);
+    }
+    if (init_normals == nullptr) {
+      init_normals = &problem_.normal_maps->at(problem_.ref_image_idx);
+    }
+  }
+
+  // Pixels without a valid initial depth or normal, e.g., filtered pixels in
+  // the input depth maps, are initialized randomly.
+  std::mt19937 prng(0);
+  std::uniform_real_distribution<float> depth_distribution(options_.depth_min,
+                                                           options_.depth_max);
+  for (int row = 0; row < height_; ++row) {
+    for (int col = 0; col < width_; ++col) {
+      Hypothesis hypothesis;
+      if (init_depths != nullptr) {
+        hypothesis.depth = init_depths->Get(row, col);
+      }
+      if (hypothesis.depth <= 0.0f) {
+        hypothesis.depth = depth_distribution(prng);
+      }
+      if (init_normals != nullptr) {
+        init_normals->GetSlice(row, col, hypothesis.normal.data());
+      }
+      if (hypothesis.normal.squaredNorm() == 0.0f) {
+        hypothesis.normal = GenerateRandomNormal(row, col, &prng);
+      }
+      SetHypothesis(row, col, hypothesis);
+    }
+  }
+}
+
+void PatchMatchCpu::ParallelForTiles(
+    const int seed,
+    const std::function<void(int, std::mt19937*, Window*)>& func) {
+  const int num_tiles = num_tiles_x_ * num_tiles_y_;
+  std::atomic<int> next_tile_idx(0);
+  for (size_t i = 0; i < thread_pool_->NumThreads(); ++i) {
+    thread_pool_->AddTask([&]() {
+      Window window;
+      window.ref_colors.resize(window_row_offsets_.size());
+      window.view_weights.resize(src_images_.size());
+      int tile_idx;
+      while ((tile_idx = next_tile_idx.fetch_add(1)) < num_tiles) {
+        // Seed per tile, so that the result is independent of the schedule.
+        std::mt19937 prng(seed * num_tiles + tile_idx);
+        func(tile_idx, &prng, &window);
+      }
+    });
+  }
+  thread_pool_->Wait();
+}
+
+void PatchMatchCpu::ForEachPixelInTile(
+    const int tile_idx,
+    const int color,
+    const std::function<void(int, int)>& func) const {
+  const int row_begin = (tile_idx / num_tiles_x_) * kTileSize;
+  const int col_begin = (tile_idx % num_tiles_x_) * kTileSize;
+  const int row_end = std::min(row_begin + kTileSize, height_);
+  const int col_end = std::min(col_begin + kTileSize, width_);
+  for (int row = row_begin; row < row_end; ++row) {
+    if (color < 0) {
+      for (int col = col_begin; col < col_end; ++col) {
+        func(row, col);
+      }
+    } else {
+      for (int col = col_begin + ((row + col_begin + color) & 1);
+           col < col_end;
+           col += 2) {
+        func(row, col);
+      }
+    }
+  }
+}
+
+void PatchMatchCpu::ComputeInitialCost(const int row,
+                                       const int col,
+                                       Window* window) {
+  const bool textured = ComputeRefWindow(row, col, window);
+  const Hypothesis hypothesis = GetHypothesis(row, col);
+  for (size_t image_idx = 0; image_idx < src_images_.size(); ++image_idx) {
+    cost_map_.Set(row,
+                  col,
+                  image_idx,
+                  textured ? ComputePhotoConsistencyCost(
+                                 row, col, hypothesis, image_idx, window)
+                           : kMaxCost);
+  }
+}
+
+void PatchMatchCpu::UpdatePixel(const int row,
+                                const int col,
+                                const float perturbation,
+                                const float prev_sel_prob_weight,
+                                std::mt19937* prng,
+                                Window* window) {
+  // The costs of textureless windows are maximal for any hypothesis.
+  if (!ComputeRefWindow(row, col, window)) {
+    return;
+  }
+
+  const int num_src_images = src_images_.size();
+  const Hypothesis curr_hypothesis = GetHypothesis(row, col);
+
+  // Sampling probabilities of the source images from the selection
+  // probabilities and the viewing angle priors of the current hypothesis.
+  float view_weight_sum = 0.0f;
+  for (int image_idx = 0; image_idx < num_src_images; ++image_idx) {
+    const float view_weight =
+        sel_prob_map_.Get(row, col, image_idx) *
+        ComputeViewPrior(row, col, curr_hypothesis, image_idx);
+    window->view_weights[image_idx] = view_weight;
+    view_weight_sum += view_weight;
+  }
+  if (view_weight_sum <= 0.0f) {
+    return;
+  }
+  for (float& view_weight : window->view_weights) {
+    view_weight /= view_weight_sum;
+    if (view_weight < kMinSamplingProb) {
+      view_weight = 0.0f;
+    }
+  }
+
+  // Expected cost of the hypothesis under the sampling probabilities. The
+  // evaluation is terminated early, once the cost exceeds the given bound,
+  // since all costs are non-negative.
+  const auto ComputeCost = [&](const Hypothesis& hypothesis,
+                               const bool is_curr,
+                               const float max_cost) {
+    float cost = 0.0f;
+    for (int image_idx = 0; image_idx < num_src_images; ++image_idx) {
+      const float view_weight = window->view_weights[image_idx];
+      if (view_weight == 0.0f) {
+        continue;
+      }
+      float view_cost = is_curr ? cost_map_.Get(row, col, image_idx)
+                                : ComputePhotoConsistencyCost(
+                                      row, col, hypothesis, image_idx, window);
+      if (options_.geom_consistency) {
+        view_cost +=
+            options_.geom_consistency_regularizer *
+            ComputeGeomConsistencyCost(row, col, hypothesis.depth, image_idx);
+      }
+      cost += view_weight * view_cost;
+      if (cost >= max_cost) {
+        break;
+      }
+    }
+    return cost;
+  };
+
+  // Random perturbation of the current hypothesis.
+  Hypothesis rand_hypothesis;
+  rand_hypothesis.depth = std::uniform_real_distribution<float>(
+      (1.0f - perturbation) * curr_hypothesis.depth,
+      (1.0f + perturbation) * curr_hypothesis.depth)(*prng);
+  rand_hypothesis.normal = PerturbNormal(
+      row, col, curr_hypothesis.normal, perturbation * EIGEN_PI, prng);
+
+  Hypothesis best_hypothesis = curr_hypothesis;
+  float best_cost =
+      ComputeCost(curr_hypothesis, true, std::numeric_limits<float>::max());
+  bool is_curr_best = true;
+  const auto EvaluateCandidate = [&](const Hypothesis& hypothesis) {
+    if (!(hypothesis.depth > 0.0f)) {
+      return;
+    }
+    const float cost = ComputeCost(hypothesis, false, best_cost);
+    if (cost < best_cost) {
+      best_cost = cost;
+      best_hypothesis = hypothesis;
+      is_curr_best = false;
+    }
+  };
+
+  for (const auto& offset : kNeighborOffsets) {
+    const int neighbor_row = row + offset[0];
+    const int neighbor_col = col + offset[1];
+    if (neighbor_row < 0 || neighbor_col < 0 || neighbor_row >= height_ ||
+        neighbor_col >= width_) {
+      continue;
+    }
+    Hypothesis neighbor_hypothesis = GetHypothesis(neighbor_row, neighbor_col);
+    // Propagate the depth at which the current ray intersects with the plane
+    // of the neighbor, which helps for very oblique structures.
+    const float denom =
+        neighbor_hypothesis.normal.dot(ComputeViewRay(row, col));
+    constexpr float kEps = 1e-5f;
+    if (std::abs(denom) > kEps) {
+      const float propagated_depth =
+          neighbor_hypothesis.depth *
+          neighbor_hypothesis.normal.dot(
+              ComputeViewRay(neighbor_row, neighbor_col)) /
+          denom;
+      if (propagated_depth > 0.0f) {
+        neighbor_hypothesis.depth = propagated_depth;
+      }
+    }
+    EvaluateCandidate(neighbor_hypothesis);
+  }
+
+  EvaluateCandidate(rand_hypothesis);
+  Hypothesis mixed_hypothesis = curr_hypothesis;
+  mixed_hypothesis.normal = rand_hypothesis.normal;
+  EvaluateCandidate(mixed_hypothesis);
+  mixed_hypothesis = rand_hypothesis;
+  mixed_hypothesis.normal = curr_hypothesis.normal;
+  EvaluateCandidate(mixed_hypothesis);
+
+  if (!is_curr_best) {
+    SetHypothesis(row, col, best_hypothesis);
+  }
+
+  // Update the costs and selection probabilities of all source images for
+  // the best hypothesis.
+  for (int image_idx = 0; image_idx < num_src_images; ++image_idx) {
+    float cost;
+    if (is_curr_best) {
+      cost = cost_map_.Get(row, col, image_idx);
+    } else {
+      cost = ComputePhotoConsistencyCost(
+          row, col, best_hypothesis, image_idx, window);
+      cost_map_.Set(row, col, image_idx, cost);
+    }
+    const float emission = ComputeNCCProb(cost);
+    const float curr_sel_prob = emission / (emission + kUniformProb);
+    const float prev_sel_prob = sel_prob_map_.Get(row, col, image_idx);
+    sel_prob_map_.Set(row,
+                      col,
+                      image_idx,
+                      prev_sel_prob_weight * prev_sel_prob +
+                          (1.0f - prev_sel_prob_weight) * curr_sel_prob);
+  }
+}
+
+void PatchMatchCpu::FilterPixel(const int row, const int col) {
+  const Hypothesis hypothesis = GetHypothesis(row, col);
+  const Eigen::Vector3f point = hypothesis.depth * ComputeViewRay(row, col);
+
+  const float min_ncc_prob = ComputeNCCProb(1.0f - options_.filter_min_ncc);
+  const float cos_min_triangulation_angle =
+      std::cos(DegToRad(options_.filter_min_triangulation_angle));
+
+  int num_consistent = 0;
+  for (size_t image_idx = 0; image_idx < src_images_.size(); ++image_idx) {
+    float cos_triangulation_angle;
+    float cos_incident_angle;
+    ComputeViewingAngles(point,
+                         hypothesis.normal,
+                         image_idx,
+                         &cos_triangulation_angle,
+                         &cos_incident_angle);
+    if (cos_triangulation_angle > cos_min_triangulation_angle ||
+        cos_incident_angle <= 0.0f) {
+      continue;
+    }
+    if (sel_prob_map_.Get(row, col, image_idx) < min_ncc_prob) {
+      continue;
+    }
+    if (options_.geom_consistency &&
+        ComputeGeomConsistencyCost(row, col, hypothesis.depth, image_idx) >
+            options_.filter_geom_consistency_max_cost) {
+      continue;
+    }
+    consistency_mask_.Set(row, col, image_idx, 1);
+    num_consistent += 1;
+  }
+
+  if (num_consistent < options_.filter_min_num_consistent) {
+    SetHypothesis(row, col, Hypothesis());
+    for (size_t image_idx = 0; image_idx < src_images_.size(); ++image_idx) {
+      consistency_mask_.Set(row, col, image_idx, 0);
+    }
+  }
+}
+
+bool PatchMatchCpu::ComputeRefWindow(const int row,
+                                     const int col,
+                                     Window* window) const {
+  window->rows = window_row_offsets_ + static_cast<float>(row);
+  window->cols = window_col_offsets_ + static_cast<float>(col);
+  for (Eigen::Index i = 0; i < window->rows.size(); ++i) {
+    const int window_row = row + static_cast<int>(window_row_offsets_[i]);
+    const int window_col = col + static_cast<int>(window_col_offsets_[i]);
+    window->ref_colors[i] =
+        (window_row < 0 || window_col < 0 || window_row >= height_ ||
+         window_col >= width_)
+            ? 0.0f
+            : ref_image_[window_row * width_ + window_col];
+  }
+
+  // Bilateral weights with respect to the center color.
+  const float ref_center_color = ref_image_[row * width_ + col];
+  const float color_normalization =
+      1.0f / (2.0f * options_.sigma_color * options_.sigma_color);
+  window->weights =
+      (window_spatial_weights_ -
+       (window->ref_colors - ref_center_color).square() * color_normalization)
+          .exp();
+  window->weights /= window->weights.sum();
+
+  window->ref_color_mean = (window->weights * window->ref_colors).sum();
+  window->ref_color_var =
+      (window->weights * window->ref_colors.square()).sum() -
+      window->ref_color_mean * window->ref_color_mean;
+  return window->ref_color_var >= kMinVar;
+}
+
+float PatchMatchCpu::ComputePhotoConsistencyCost(const int row,
+                                                 const int col,
+                                                 const Hypothesis& hypothesis,
+                                                 const int image_idx,
+                                                 Window* window) const {
+  const SourceImage& src_image = src_images_[image_idx];
+
+  // Homography induced by the plane of the hypothesis as
+  // H = K * (R + T * n' / d) * Kref^-1.
+  const Eigen::Vector3f point = hypothesis.depth * ComputeViewRay(row, col);
+  const float dist = hypothesis.normal.dot(point);
+  if (std::abs(dist) < std::numeric_limits<float>::epsilon() ||
+      (src_image.R * point + src_image.T).z() <= 0.0f) {
+    return kMaxCost;
+  }
+  const Eigen::Matrix3f H =
+      src_image.K *
+      (src_image.R + src_image.T * hypothesis.normal.transpose() / dist) *
+      ref_inv_K_;
+
+  // Warp all window samples at once, which vectorizes over the window.
+  window->src_colors =
+      (H(2, 0) * window->cols + H(2, 1) * window->rows + H(2, 2)).inverse();
+  window->src_cols =
+      (H(0, 0) * window->cols + H(0, 1) * window->rows + H(0, 2)) *
+      window->src_colors;
+  window->src_rows =
+      (H(1, 0) * window->cols + H(1, 1) * window->rows + H(1, 2)) *
+      window->src_colors;
+  for (Eigen::Index i = 0; i < window->src_colors.size(); ++i) {
+    window->src_colors[i] = ReadBilinear(src_image.data,
+                                         src_image.width,
+                                         src_image.height,
+                                         window->src_cols[i],
+                                         window->src_rows[i]);
+  }
+
+  const float src_color_mean = (window->weights * window->src_colors).sum();
+  const float src_color_var =
+      (window->weights * window->src_colors.square()).sum() -
+      src_color_mean * src_color_mean;
+  if (src_color_var < kMinVar) {
+    return kMaxCost;
+  }
+
+  const float src_ref_color_covar =
+      (window->weights * window->src_colors * window->ref_colors).sum() -
+      window->ref_color_mean * src_color_mean;
+  const float ncc = src_ref_color_covar /
+                    std::sqrt(window->ref_color_var * src_color_var);
+  return std::max(0.0f, std::min(kMaxCost, 1.0f - ncc));
+}
+
+float PatchMatchCpu::ComputeGeomConsistencyCost(const int row,
+                                                const int col,
+                                                const float depth,
+                                                const int image_idx) const {
+  const SourceImage& src_image = src_images_[image_idx];
+  const float max_cost = options_.geom_consistency_max_cost;
+
+  // Project point in reference image to source image.
+  const Eigen::Vector3f forward_point = depth * ComputeViewRay(row, col);
+  const Eigen::Vector3f proj = src_image.P * forward_point.homogeneous();
+  if (proj.z() <= 0.0f) {
+    return max_cost;
+  }
+  const float src_col = proj.x() / proj.z();
+  const float src_row = proj.y() / proj.z();
+  if (!(src_col > -0.5f && src_row > -0.5f &&
+        src_col < src_image.width - 0.5f &&
+        src_row < src_image.height - 0.5f)) {
+    return max_cost;
+  }
+
+  // Extract depth in source image.
+  const float src_depth = src_image.depth_map->Get(
+      static_cast<int>(src_row + 0.5f), static_cast<int>(src_col + 0.5f));
+  if (src_depth <= 0.0f) {
+    return max_cost;
+  }
+
+  // Project point in source image back to reference image.
+  const Eigen::Vector3f backward_point =
+      src_image.inv_P *
+      Eigen::Vector4f(src_col * src_depth, src_row * src_depth, src_depth, 1);
+  const Eigen::Vector3f backward_proj = ref_K_ * backward_point;
+  if (backward_proj.z() <= 0.0f) {
+    return max_cost;
+  }
+
+  // Return truncated reprojection error between original observation and
+  // the forward-backward projected observation.
+  const float diff_col = col - backward_proj.x() / backward_proj.z();
+  const float diff_row = row - backward_proj.y() / backward_proj.z();
+  return std::min(max_cost,
+                  std::sqrt(diff_col * diff_col + diff_row * diff_row));
+}
+
+void PatchMatchCpu::ComputeViewingAngles(const Eigen::Vector3f& point,
+                                         const Eigen::Vector3f& normal,
+                                         const int image_idx,
+                                         float* cos_triangulation_angle,
+                                         float* cos_incident_angle) const {
+  // Ray from point to source camera.
+  const Eigen::Vector3f SX = src_images_[image_idx].C - point;
+  const float SX_norm = SX.norm();
+  *cos_incident_angle = SX.dot(normal) / SX_norm;
+  *cos_triangulation_angle = -SX.dot(point) / (point.norm() * SX_norm);
+}
+
+float PatchMatchCpu::ComputeViewPrior(const int row,
+                                      const int col,
+                                      const Hypothesis& hypothesis,
+                                      const int image_idx) const {
+  float cos_triangulation_angle;
+  float cos_incident_angle;
+  ComputeViewingAngles(hypothesis.depth * ComputeViewRay(row, col),
+                       hypothesis.normal,
+                       image_idx,
+                       &cos_triangulation_angle,
+                       &cos_incident_angle);
+
+  float tri_prob = 1.0f;
+  if (cos_triangulation_angle > cos_min_triangulation_angle_) {
+    const float scaled = 1.0f - (1.0f - cos_triangulation_angle) /
+                                    (1.0f - cos_min_triangulation_angle_);
+    tri_prob = std::min(1.0f, std::max(0.0f, 1.0f - scaled * scaled));
+  }
+
+  const float x = 1.0f - std::max(0.0f, cos_incident_angle);
+  const float inc_prob = std::exp(x * x * inv_incident_angle_sigma_square_);
+
+  return tri_prob * inc_prob;
+}
+
+float PatchMatchCpu::ComputeNCCProb(const float cost) const {
+  return std::exp(cost * cost * inv_ncc_sigma_square_) * ncc_norm_factor_;
+}
+
+Eigen::Vector3f PatchMatchCpu::ComputeViewRay(const int row,
+                                              const int col) const {
+  return ref_inv_K_ * Eigen::Vector3f(col, row, 1.0f);
+}
+
+Eigen::Vector3f PatchMatchCpu::GenerateRandomNormal(
+    const int row, const int col, std::mt19937* prng) const {
+  // Unbiased sampling of normal, according to George Marsaglia, "Choosing a
+  // Point from the Surface of a Sphere", 1972.
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  float v1 = 0.0f;
+  float v2 = 0.0f;
+  float s = 2.0f;
+  while (s >= 1.0f) {
+    v1 = distribution(*prng);
+    v2 = distribution(*prng);
+    s = v1 * v1 + v2 * v2;
+  }
+
+  const float s_norm = std::sqrt(1.0f - s);
+  Eigen::Vector3f normal(
+      2.0f * v1 * s_norm, 2.0f * v2 * s_norm, 1.0f - 2.0f * s);
+
+  // Make sure normal is looking away from camera.
+  if (normal.dot(ComputeViewRay(row, col)) > 0.0f) {
+    normal = -normal;
+  }
+  return normal;
+}
+
+Eigen::Vector3f PatchMatchCpu::PerturbNormal(const int row,
+                                             const int col,
+                                             const Eigen::Vector3f& normal,
+                                             float perturbation,
+                                             std::mt19937* prng) const {
+  const Eigen::Vector3f view_ray = ComputeViewRay(row, col);
+  std::uniform_real_distribution<float> distribution(-0.5f, 0.5f);
+  // Make sure the perturbed normal is still looking in the same direction as
+  // the viewing direction, otherwise try again but with smaller perturbation.
+  constexpr int kMaxNumTrials = 3;
+  for (int trial = 0; trial <= kMaxNumTrials; ++trial) {
+    const Eigen::Matrix3f R =
+        (Eigen::AngleAxisf(distribution(*prng) * perturbation,
+                           Eigen::Vector3f::UnitX()) *
+         Eigen::AngleAxisf(distribution(*prng) * perturbation,
+                           Eigen::Vector3f::UnitY()) *
+         Eigen::AngleAxisf(distribution(*prng) * perturbation,
+                           Eigen::Vector3f::UnitZ()))
+            .toRotationMatrix();
+    const Eigen::Vector3f perturbed_normal = (R * normal).normalized();
+    if (perturbed_normal.dot(view_ray) < 0.0f) {
+      return perturbed_normal;
+    }
+    perturbation *= 0.5f;
+  }
+  return normal;
+}
+
+PatchMatchCpu::Hypothesis PatchMatchCpu::GetHypothesis(const int row,
+                                                       const int col) const {
+  Hypothesis hypothesis;
+  hypothesis.depth = depth_map_.Get(row, col);
+  normal_map_.GetSlice(row, col, hypothesis.normal.data());
+  return hypothesis;
+}
+
+void PatchMatchCpu::SetHypothesis(const int row,
+                                  const int col,
+                                  const Hypothesis& hypothesis) {
+  depth_map_.Set(row, col, hypothesis.depth);
+  for (int d = 0; d < 3; ++d) {
+    normal_map_.Set(row, col, d, hypothesis.normal(d));
+  }
+}
+
+}  // namespace mvs
+}  // namespace colmap
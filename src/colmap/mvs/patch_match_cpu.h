@@ -0,0 +1,227 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "colmap/mvs/depth_map.h"
+#include "colmap/mvs/mat.h"
+#include "colmap/mvs/normal_map.h"
+#include "colmap/mvs/patch_match.h"
+#include "colmap/util/threading.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace colmap {
+namespace mvs {
+
+// Multi-threaded CPU implementation of PatchMatch with the same options,
+// inputs, and outputs as PatchMatchCuda for systems without a CUDA device.
+//
+// Instead of sweeping the image in four directions, the pixels are updated in
+// a red-black checkerboard pattern. All pixels of one color only propagate
+// from their neighbors of the other color and can hence be updated in
+// parallel. The image is split into tiles, which the worker threads claim from
+// a shared counter, such that threads that finish early take over the
+// remaining tiles of slower threads. Instead of Monte Carlo sampling of the
+// source images, the matching costs are weighted by the sampling
+// probabilities, i.e., their expected value is computed directly.
+class PatchMatchCpu : public PatchMatchSolver {
+ public:
+  // The depth and normal maps are initialized from the given maps, if not
+  // null, e.g., from a coarser level of the pyramid. Otherwise, they are
+  // initialized from the problem for geometric consistency or randomly.
+  PatchMatchCpu(const PatchMatchOptions& options,
+                const PatchMatch::Problem& problem,
+                const DepthMap* init_depth_map = nullptr,
+                const NormalMap* init_normal_map = nullptr);
+
+  void Run() override;
+
+  DepthMap GetDepthMap() const override;
+  NormalMap GetNormalMap() const override;
+  Mat<float> GetSelProbMap() const override;
+  std::vector<int> GetConsistentImageIdxs() const override;
+
+ private:
+  // Grayscale source image with intensities in [0, 1] and its relative pose
+  // with respect to the reference image.
+  struct SourceImage {
+    int width = 0;
+    int height = 0;
+    std::vector<float> data;
+    // Pointer to the depth map, if geometric consistency is enabled.
+    const DepthMap* depth_map = nullptr;
+    Eigen::Matrix3f K;
+    Eigen::Matrix3f R;
+    Eigen::Vector3f T;
+    // Projection center in the reference camera frame.
+    Eigen::Vector3f C;
+    // Projection from the reference camera frame into the image and inverse
+    // projection of (col * depth, row * depth, depth) into the reference
+    // camera frame.
+    Eigen::Matrix<float, 3, 4> P;
+    Eigen::Matrix<float, 3, 4> inv_P;
+  };
+
+  struct Hypothesis {
+    float depth = 0.0f;
+    Eigen::Vector3f normal = Eigen::Vector3f::Zero();
+  };
+
+  // Per-thread scratch memory for the window around the current pixel.
+  struct Window {
+    Eigen::ArrayXf rows;
+    Eigen::ArrayXf cols;
+    Eigen::ArrayXf ref_colors;
+    // Normalized bilateral weights of the window samples.
+    Eigen::ArrayXf weights;
+    Eigen::ArrayXf src_rows;
+    Eigen::ArrayXf src_cols;
+    Eigen::ArrayXf src_colors;
+    float ref_color_mean = 0.0f;
+    float ref_color_var = 0.0f;
+    // Sampling probabilities of the source images.
+    std::vector<float> view_weights;
+  };
+
+  void InitSourceImages();
+  void InitWorkspace(const DepthMap* init_depth_map,
+                     const NormalMap* init_normal_map);
+
+  // Call the function for all tiles of the reference image in parallel. The
+  // random number generator is seeded from the seed and the tile index.
+  void ParallelForTiles(
+      int seed, const std::function<void(int, std::mt19937*, Window*)>& func);
+
+  // Call the function for all pixels in the tile of the given checkerboard
+  // color or for all pixels, if the color is negative.
+  void ForEachPixelInTile(int tile_idx,
+                          int color,
+                          const std::function<void(int, int)>& func) const;
+
+  void ComputeInitialCost(int row, int col, Window* window);
+  void UpdatePixel(int row,
+                   int col,
+                   float perturbation,
+                   float prev_sel_prob_weight,
+                   std::mt19937* prng,
+                   Window* window);
+  void FilterPixel(int row, int col);
+
+  // Compute the reference image window around the pixel. Returns false, if
+  // the window is textureless, in which case all costs are maximal.
+  bool ComputeRefWindow(int row, int col, Window* window) const;
+
+  // Compute 1 - NCC between the reference window and the source image warped
+  // by the homography induced by the plane of the hypothesis.
+  float ComputePhotoConsistencyCost(int row,
+                                    int col,
+                                    const Hypothesis& hypothesis,
+                                    int image_idx,
+                                    Window* window) const;
+
+  // Compute the truncated forward-backward reprojection error in pixels.
+  float ComputeGeomConsistencyCost(int row,
+                                   int col,
+                                   float depth,
+                                   int image_idx) const;
+
+  // Cosine of the triangulation angle between the reference and source image
+  // and of the incident angle between the source ray and the normal.
+  void ComputeViewingAngles(const Eigen::Vector3f& point,
+                            const Eigen::Vector3f& normal,
+                            int image_idx,
+                            float* cos_triangulation_angle,
+                            float* cos_incident_angle) const;
+
+  // Prior probability of sampling the source image for the hypothesis from
+  // the triangulation and incident angles.
+  float ComputeViewPrior(int row,
+                         int col,
+                         const Hypothesis& hypothesis,
+                         int image_idx) const;
+
+  // Likelihood of the cost, where cost = 1 - NCC.
+  float ComputeNCCProb(float cost) const;
+
+  Eigen::Vector3f ComputeViewRay(int row, int col) const;
+  Eigen::Vector3f GenerateRandomNormal(int row,
+                                       int col,
+                                       std::mt19937* prng) const;
+  Eigen::Vector3f PerturbNormal(int row,
+                                int col,
+                                const Eigen::Vector3f& normal,
+                                float perturbation,
+                                std::mt19937* prng) const;
+
+  Hypothesis GetHypothesis(int row, int col) const;
+  void SetHypothesis(int row, int col, const Hypothesis& hypothesis);
+
+  const PatchMatchOptions options_;
+  const PatchMatch::Problem problem_;
+  const int num_threads_;
+
+  int width_ = 0;
+  int height_ = 0;
+  int num_tiles_x_ = 0;
+  int num_tiles_y_ = 0;
+  std::unique_ptr<ThreadPool> thread_pool_;
+
+  float cos_min_triangulation_angle_ = 0.0f;
+  float inv_incident_angle_sigma_square_ = 0.0f;
+  float inv_ncc_sigma_square_ = 0.0f;
+  float ncc_norm_factor_ = 0.0f;
+
+  // Offsets and logarithmic spatial bilateral weights of the window samples.
+  Eigen::ArrayXf window_row_offsets_;
+  Eigen::ArrayXf window_col_offsets_;
+  Eigen::ArrayXf window_spatial_weights_;
+
+  Eigen::Matrix3f ref_K_;
+  Eigen::Matrix3f ref_inv_K_;
+  std::vector<float> ref_image_;
+  std::vector<SourceImage> src_images_;
+
+  Mat<float> depth_map_;
+  Mat<float> normal_map_;
+  Mat<float> cost_map_;
+  Mat<float> sel_prob_map_;
+  // Empty, if filtering is disabled.
+  Mat<uint8_t> consistency_mask_;
+};
+
+}  // namespace mvs
+}  // namespace colmap
@@ -0,0 +1,197 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/mvs/patch_match_cpu.h"
+
+#include "colmap/sensor/bitmap.h"
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace mvs {
+namespace {
+
+constexpr int kWidth = 144;
+constexpr int kHeight = 80;
+constexpr float kPlaneDepth = 5.0f;
+
+// Render a textured fronto-parallel plane at kPlaneDepth for a camera
+// translated along the x-axis.
+Image CreateImage(const float tx) {
+  const float K[9] = {100, 0, kWidth / 2.0f, 0, 100, kHeight / 2.0f, 0, 0, 1};
+  const float R[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  const float T[3] = {tx, 0, 0};
+  Image image("", kWidth, kHeight, K, R, T);
+  Bitmap bitmap(kWidth, kHeight, /*as_rgb=*/false);
+  for (int y = 0; y < kHeight; ++y) {
+    for (int x = 0; x < kWidth; ++x) {
+      const float X = (x - K[2]) / K[0] * kPlaneDepth - tx;
+      const float Y = (y - K[5]) / K[4] * kPlaneDepth;
+      const float intensity = 127.5f + 60.0f * std::sin(7.0f * X) +
+                              60.0f * std::cos(5.0f * Y + 3.0f * X * X);
+      bitmap.SetPixel(x, y, BitmapColor<uint8_t>(intensity));
+    }
+  }
+  image.SetBitmap(bitmap);
+  return image;
+}
+
+PatchMatchOptions CreateOptions() {
+  PatchMatchOptions options;
+  options.use_gpu = false;
+  options.depth_min = 1.0f;
+  options.depth_max = 10.0f;
+  options.window_radius = 3;
+  options.num_iterations = 5;
+  options.geom_consistency = false;
+  options.filter = false;
+  return options;
+}
+
+class PatchMatchCpuTests : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    images_ = {CreateImage(0), CreateImage(-0.5f), CreateImage(0.5f)};
+    problem_.ref_image_idx = 0;
+    problem_.src_image_idxs = {1, 2};
+    problem_.images = &images_;
+  }
+
+  std::vector<Image> images_;
+  PatchMatch::Problem problem_;
+};
+
+TEST_F(PatchMatchCpuTests, Photometric) {
+  PatchMatchCpu patch_match(CreateOptions(), problem_);
+  patch_match.Run();
+
+  const DepthMap depth_map = patch_match.GetDepthMap();
+  const NormalMap normal_map = patch_match.GetNormalMap();
+  ASSERT_EQ(depth_map.GetWidth(), kWidth);
+  ASSERT_EQ(depth_map.GetHeight(), kHeight);
+  ASSERT_EQ(normal_map.GetDepth(), 3);
+  EXPECT_EQ(patch_match.GetSelProbMap().GetDepth(), 2);
+  EXPECT_TRUE(patch_match.GetConsistentImageIdxs().empty());
+
+  int num_accurate = 0;
+  int num_pixels = 0;
+  for (int row = 8; row < kHeight - 8; ++row) {
+    for (int col = 8; col < kWidth - 8; ++col) {
+      num_pixels += 1;
+      if (std::abs(depth_map.Get(row, col) - kPlaneDepth) < 0.05f) {
+        num_accurate += 1;
+      }
+    }
+  }
+  EXPECT_GT(num_accurate, 0.9 * num_pixels);
+}
+
+TEST_F(PatchMatchCpuTests, IndependentOfNumThreads) {
+  PatchMatchOptions options = CreateOptions();
+  options.num_iterations = 2;
+  options.num_threads = 1;
+  PatchMatchCpu patch_match1(options, problem_);
+  patch_match1.Run();
+  options.num_threads = 3;
+  PatchMatchCpu patch_match3(options, problem_);
+  patch_match3.Run();
+  EXPECT_EQ(patch_match1.GetDepthMap().GetData(),
+            patch_match3.GetDepthMap().GetData());
+  EXPECT_EQ(patch_match1.GetNormalMap().GetData(),
+            patch_match3.GetNormalMap().GetData());
+}
+
+TEST_F(PatchMatchCpuTests, Filter) {
+  PatchMatchOptions options = CreateOptions();
+  options.filter = true;
+  options.filter_min_num_consistent = 2;
+  options.filter_min_triangulation_angle = 1.0f;
+  PatchMatchCpu patch_match(options, problem_);
+  patch_match.Run();
+
+  const DepthMap depth_map = patch_match.GetDepthMap();
+  const std::vector<int> consistent_image_idxs =
+      patch_match.GetConsistentImageIdxs();
+  ASSERT_FALSE(consistent_image_idxs.empty());
+  int num_consistent_pixels = 0;
+  for (size_t i = 0; i < consistent_image_idxs.size();) {
+    const int col = consistent_image_idxs[i];
+    const int row = consistent_image_idxs[i + 1];
+    const int num_images = consistent_image_idxs[i + 2];
+    EXPECT_EQ(num_images, 2);
+    EXPECT_GT(depth_map.Get(row, col), 0.0f);
+    num_consistent_pixels += 1;
+    i += 3 + num_images;
+  }
+
+  for (int row = 0; row < kHeight; ++row) {
+    for (int col = 0; col < kWidth; ++col) {
+      if (depth_map.Get(row, col) > 0.0f) {
+        num_consistent_pixels -= 1;
+      }
+    }
+  }
+  EXPECT_EQ(num_consistent_pixels, 0);
+}
+
+TEST_F(PatchMatchCpuTests, GeometricConsistency) {
+  std::vector<DepthMap> depth_maps;
+  std::vector<NormalMap> normal_maps;
+  for (int i = 0; i < 3; ++i) {
+    DepthMap depth_map(kWidth, kHeight, 1.0f, 10.0f);
+    depth_map.Fill(kPlaneDepth);
+    depth_maps.push_back(depth_map);
+    NormalMap normal_map(kWidth, kHeight);
+    for (int row = 0; row < kHeight; ++row) {
+      for (int col = 0; col < kWidth; ++col) {
+        normal_map.Set(row, col, 2, -1.0f);
+      }
+    }
+    normal_maps.push_back(normal_map);
+  }
+  problem_.depth_maps = &depth_maps;
+  problem_.normal_maps = &normal_maps;
+
+  PatchMatchOptions options = CreateOptions();
+  options.geom_consistency = true;
+  options.filter = true;
+  options.num_iterations = 1;
+  PatchMatchCpu patch_match(options, problem_);
+  patch_match.Run();
+
+  const DepthMap depth_map = patch_match.GetDepthMap();
+  EXPECT_NEAR(depth_map.Get(kHeight / 2, kWidth / 2), kPlaneDepth, 1e-2f);
+}
+
+}  // namespace
+}  // namespace mvs
+}  // namespace colmap
@@ -40,6 +40,7 @@
 #include "colmap/util/cuda.h"
 #include "colmap/util/cudacc.h"
 #include "colmap/util/logging.h"
+#include "colmap/util/tracing.h"
 
 #include <algorithm>
 #include <cfloat>
@@ -826,9 +827,9 @@ __global__ void RotateNormalMap(GpuMatView<float> normal_map) {
   }
 }
 
-template <int kWindowSize, int kWindowStep>
+template <int kWindowSize, int kWindowStep, typename T>
 __global__ void ComputeInitialCost(
-    GpuMatView<float> cost_map,
+    GpuMatView<T> cost_map,
     const GpuMatView<float> depth_map,
     const GpuMatView<float> normal_map,
     const cudaTextureObject_t ref_image_texture,
@@ -896,20 +897,60 @@ struct SweepOptions {
   float filter_geom_consistency_max_cost = 1.0f;
 };
 
+// Deactivate the source images for all pixels of a tile, if their selection
+// probability is below the threshold for all active pixels of the tile.
+template <typename T>
+__global__ void PruneSourceImages(const GpuMatView<T> sel_prob_map,
+                                  GpuMatView<uint8_t> src_image_mask,
+                                  const int tile_size,
+                                  const float min_sel_prob) {
+  const int min_row = (blockDim.y * blockIdx.y + threadIdx.y) * tile_size;
+  const int min_col = (blockDim.x * blockIdx.x + threadIdx.x) * tile_size;
+  const int image_idx = blockIdx.z;
+  const int height = src_image_mask.GetHeight();
+  const int width = src_image_mask.GetWidth();
+  if (min_row >= height || min_col >= width) {
+    return;
+  }
+
+  const int max_row = min(min_row + tile_size, height);
+  const int max_col = min(min_col + tile_size, width);
+  float max_sel_prob = 0.0f;
+  for (int row = min_row; row < max_row; ++row) {
+    for (int col = min_col; col < max_col; ++col) {
+      if (src_image_mask.Get(row, col, image_idx)) {
+        max_sel_prob = fmaxf(
+            max_sel_prob,
+            static_cast<float>(sel_prob_map.Get(row, col, image_idx)));
+      }
+    }
+  }
+
+  if (max_sel_prob < min_sel_prob) {
+    for (int row = min_row; row < max_row; ++row) {
+      for (int col = min_col; col < max_col; ++col) {
+        src_image_mask.Set(row, col, image_idx, 0);
+      }
+    }
+  }
+}
+
 template <int kWindowSize,
           int kWindowStep,
+          typename T,
           bool kGeomConsistencyTerm = false,
           bool kFilterPhotoConsistency = false,
           bool kFilterGeomConsistency = false>
 __global__ void SweepFromTopToBottom(
     GpuMatView<float> global_workspace,
     GpuMatView<curandState> rand_state_map,
-    GpuMatView<float> cost_map,
+    GpuMatView<T> cost_map,
     GpuMatView<float> depth_map,
     GpuMatView<float> normal_map,
     GpuMatView<uint8_t> consistency_mask,
-    GpuMatView<float> sel_prob_map,
-    const GpuMatView<float> prev_sel_prob_map,
+    GpuMatView<T> sel_prob_map,
+    const GpuMatView<T> prev_sel_prob_map,
+    const GpuMatView<uint8_t> src_image_mask,
     const cudaTextureObject_t ref_image_texture,
     const GpuMatView<float> ref_sum_image,
     const GpuMatView<float> ref_squared_sum_image,
@@ -918,6 +959,7 @@ __global__ void SweepFromTopToBottom(
     const cudaTextureObject_t poses_texture,
     const SweepOptions options) {
   const int col = blockDim.x * blockIdx.x + threadIdx.x;
+  const bool prune_src_images = src_image_mask.GetWidth() > 0;
 
   // Probability for boundary pixels.
   constexpr float kUniformProb = 0.5f;
@@ -944,7 +986,8 @@ __global__ void SweepFromTopToBottom(
       // Compute backward message.
       float beta = kUniformProb;
       for (int row = cost_map.GetHeight() - 1; row >= 0; --row) {
-        const float cost = cost_map.Get(row, col, image_idx);
+        const float cost =
+            static_cast<float>(cost_map.Get(row, col, image_idx));
         beta = likelihood_computer.ComputeBackwardMessage(cost, beta);
         sel_prob_map.Set(row, col, image_idx, beta);
       }
@@ -1034,11 +1077,18 @@ __global__ void SweepFromTopToBottom(
     ComputePointAtDepth(row, col, curr_param_state.depth, point);
 
     for (int image_idx = 0; image_idx < cost_map.GetDepth(); ++image_idx) {
-      const float cost = cost_map.Get(row, col, image_idx);
+      if (prune_src_images && !src_image_mask.Get(row, col, image_idx)) {
+        sampling_probs[image_idx] = 0.0f;
+        continue;
+      }
+
+      const float cost = static_cast<float>(cost_map.Get(row, col, image_idx));
       const float alpha = likelihood_computer.ComputeForwardMessage(
           cost, forward_message[image_idx]);
-      const float beta = sel_prob_map.Get(row, col, image_idx);
-      const float prev_prob = prev_sel_prob_map.Get(row, col, image_idx);
+      const float beta =
+          static_cast<float>(sel_prob_map.Get(row, col, image_idx));
+      const float prev_prob =
+          static_cast<float>(prev_sel_prob_map.Get(row, col, image_idx));
       const float sel_prob = likelihood_computer.ComputeSelProb(
           alpha, beta, prev_prob, options.prev_sel_prob_weight);
 
@@ -1107,7 +1157,8 @@ __global__ void SweepFromTopToBottom(
         continue;
       }
 
-      costs[0] += cost_map.Get(row, col, pcc_computer.src_image_idx);
+      costs[0] += static_cast<float>(
+          cost_map.Get(row, col, pcc_computer.src_image_idx));
       if (kGeomConsistencyTerm) {
         costs[0] +=
             options.geom_consistency_regularizer *
@@ -1152,10 +1203,16 @@ __global__ void SweepFromTopToBottom(
     pcc_computer.depth = best_depth;
     pcc_computer.normal = best_normal;
     for (int image_idx = 0; image_idx < cost_map.GetDepth(); ++image_idx) {
+      // Pruned source images are never sampled or considered consistent.
+      if (prune_src_images && !src_image_mask.Get(row, col, image_idx)) {
+        sel_prob_map.Set(row, col, image_idx, 0.0f);
+        continue;
+      }
+
       // Determine the cost for best depth.
       float cost;
       if (min_cost_idx == 0) {
-        cost = cost_map.Get(row, col, image_idx);
+        cost = static_cast<float>(cost_map.Get(row, col, image_idx));
       } else {
         pcc_computer.src_image_idx = image_idx;
         cost = pcc_computer.Compute();
@@ -1164,8 +1221,10 @@ __global__ void SweepFromTopToBottom(
 
       const float alpha = likelihood_computer.ComputeForwardMessage(
           cost, forward_message[image_idx]);
-      const float beta = sel_prob_map.Get(row, col, image_idx);
-      const float prev_prob = prev_sel_prob_map.Get(row, col, image_idx);
+      const float beta =
+          static_cast<float>(sel_prob_map.Get(row, col, image_idx));
+      const float prev_prob =
+          static_cast<float>(prev_sel_prob_map.Get(row, col, image_idx));
       const float prob = likelihood_computer.ComputeSelProb(
           alpha, beta, prev_prob, options.prev_sel_prob_weight);
       forward_message[image_idx] = alpha;
@@ -1198,7 +1257,8 @@ __global__ void SweepFromTopToBottom(
         }
 
         if (!kFilterGeomConsistency) {
-          if (sel_prob_map.Get(row, col, image_idx) >= min_ncc_prob) {
+          if (static_cast<float>(sel_prob_map.Get(row, col, image_idx)) >=
+              min_ncc_prob) {
             consistency_mask.Set(row, col, image_idx, 1);
             num_consistent += 1;
           }
@@ -1215,7 +1275,8 @@ __global__ void SweepFromTopToBottom(
             num_consistent += 1;
           }
         } else {
-          if (sel_prob_map.Get(row, col, image_idx) >= min_ncc_prob &&
+          if (static_cast<float>(sel_prob_map.Get(row, col, image_idx)) >=
+                  min_ncc_prob &&
               ComputeGeomConsistencyCost(poses_texture,
                                          src_depth_maps_texture,
                                          row,
@@ -1254,7 +1315,9 @@ __global__ void SweepFromTopToBottom(
 }
 
 PatchMatchCuda::PatchMatchCuda(const PatchMatchOptions& options,
-                               const PatchMatch::Problem& problem)
+                               const PatchMatch::Problem& problem,
+                               const DepthMap* init_depth_map,
+                               const NormalMap* init_normal_map)
     : options_(options),
       problem_(problem),
       ref_width_(0),
@@ -1264,7 +1327,7 @@ PatchMatchCuda::PatchMatchCuda(const PatchMatchOptions& options,
   InitRefImage();
   InitSourceImages();
   InitTransforms();
-  InitWorkspaceMemory();
+  InitWorkspaceMemory(init_depth_map, init_normal_map);
 }
 
 void PatchMatchCuda::Run() {
@@ -1327,7 +1390,20 @@ NormalMap PatchMatchCuda::GetNormalMap() const {
 }
 
 Mat<float> PatchMatchCuda::GetSelProbMap() const {
-  return prev_sel_prob_map_->CopyToMat();
+  if (src_image_maps_half_ == nullptr) {
+    return src_image_maps_->prev_sel_prob_map->CopyToMat();
+  }
+  const Mat<__half> half_sel_prob_map =
+      src_image_maps_half_->prev_sel_prob_map->CopyToMat();
+  Mat<float> sel_prob_map(half_sel_prob_map.GetWidth(),
+                          half_sel_prob_map.GetHeight(),
+                          half_sel_prob_map.GetDepth());
+  const std::vector<__half>& half_data = half_sel_prob_map.GetData();
+  float* data = sel_prob_map.GetPtr();
+  for (size_t i = 0; i < half_data.size(); ++i) {
+    data[i] = __half2float(half_data[i]);
+  }
+  return sel_prob_map;
 }
 
 std::vector<int> PatchMatchCuda::GetConsistentImageIdxs() const {
@@ -1358,6 +1434,17 @@ std::vector<int> PatchMatchCuda::GetConsistentImageIdxs() const {
 
 template <int kWindowSize, int kWindowStep>
 void PatchMatchCuda::RunWithWindowSizeAndStep() {
+  if (src_image_maps_half_ == nullptr) {
+    RunWithWindowSizeAndStep<kWindowSize, kWindowStep>(src_image_maps_.get());
+  } else {
+    RunWithWindowSizeAndStep<kWindowSize, kWindowStep>(
+        src_image_maps_half_.get());
+  }
+}
+
+template <int kWindowSize, int kWindowStep, typename T>
+void PatchMatchCuda::RunWithWindowSizeAndStep(
+    SourceImageMaps<T>* src_image_maps) {
   // Wait for all initializations to finish.
   CUDA_SYNC_AND_CHECK();
 
@@ -1365,19 +1452,23 @@ void PatchMatchCuda::RunWithWindowSizeAndStep() {
   CudaTimer init_timer;
 
   ComputeCudaConfig();
-  ComputeInitialCost<kWindowSize, kWindowStep>
-      <<<sweep_grid_size_, sweep_block_size_>>>(
-          cost_map_->View(),
-          depth_map_->View(),
-          normal_map_->View(),
-          ref_image_texture_->GetObj(),
-          ref_image_->sum_image->View(),
-          ref_image_->squared_sum_image->View(),
-          src_images_texture_->GetObj(),
-          poses_texture_[0]->GetObj(),
-          options_.sigma_spatial,
-          options_.sigma_color);
-  CUDA_SYNC_AND_CHECK();
+  {
+    TraceZone trace_zone("PatchMatchInitialCost");
+    trace_zone.SetNumItems(static_cast<int64_t>(ref_width_) * ref_height_);
+    ComputeInitialCost<kWindowSize, kWindowStep, T>
+        <<<sweep_grid_size_, sweep_block_size_>>>(
+            src_image_maps->cost_map->View(),
+            depth_map_->View(),
+            normal_map_->View(),
+            ref_image_texture_->GetObj(),
+            ref_image_->sum_image->View(),
+            ref_image_->squared_sum_image->View(),
+            src_images_texture_->GetObj(),
+            poses_texture_[0]->GetObj(),
+            options_.sigma_spatial,
+            options_.sigma_color);
+    CUDA_SYNC_AND_CHECK();
+  }
 
   init_timer.Print("Initialization");
 
@@ -1403,11 +1494,21 @@ void PatchMatchCuda::RunWithWindowSizeAndStep() {
   sweep_options.filter_geom_consistency_max_cost =
       options_.filter_geom_consistency_max_cost;
 
+  cudaTextureObject_t src_depth_maps_texture_obj = 0;
+  if (src_depth_maps_texture_ != nullptr) {
+    src_depth_maps_texture_obj = src_depth_maps_texture_->GetObj();
+  } else if (src_depth_maps_half_texture_ != nullptr) {
+    src_depth_maps_texture_obj = src_depth_maps_half_texture_->GetObj();
+  }
+
   for (int iter = 0; iter < options_.num_iterations; ++iter) {
     CudaTimer iter_timer;
 
     for (int sweep = 0; sweep < 4; ++sweep) {
       CudaTimer sweep_timer;
+      TraceZone sweep_trace_zone("PatchMatchSweep");
+      sweep_trace_zone.SetNumItems(static_cast<int64_t>(ref_width_) *
+                                   ref_height_);
 
       // Expenentially reduce amount of perturbation during the optimization.
       sweep_options.perturbation = 1.0f / std::pow(2.0f, iter + sweep / 4.0f);
@@ -1421,34 +1522,34 @@ void PatchMatchCuda::RunWithWindowSizeAndStep() {
 #define CALL_SWEEP_FUNC                                   \
   SweepFromTopToBottom<kWindowSize,                       \
                        kWindowStep,                       \
+                       T,                                 \
                        kGeomConsistencyTerm,              \
                        kFilterPhotoConsistency,           \
                        kFilterGeomConsistency>            \
       <<<sweep_grid_size_, sweep_block_size_>>>(          \
           global_workspace_->View(),                      \
           rand_state_map_->View(),                        \
-          cost_map_->View(),                              \
+          src_image_maps->cost_map->View(),               \
           depth_map_->View(),                             \
           normal_map_->View(),                            \
           consistency_mask_->View(),                      \
-          sel_prob_map_->View(),                          \
-          prev_sel_prob_map_->View(),                     \
+          src_image_maps->sel_prob_map->View(),           \
+          src_image_maps->prev_sel_prob_map->View(),      \
+          src_image_mask_->View(),                        \
           ref_image_texture_->GetObj(),                   \
           ref_image_->sum_image->View(),                  \
           ref_image_->squared_sum_image->View(),          \
           src_images_texture_->GetObj(),                  \
-          src_depth_maps_texture_ == nullptr              \
-              ? 0                                         \
-              : src_depth_maps_texture_->GetObj(),        \
+          src_depth_maps_texture_obj,                     \
           poses_texture_[rotation_in_half_pi_]->GetObj(), \
           sweep_options);
 
       if (last_sweep) {
         if (options_.filter) {
-          consistency_mask_ =
-              std::make_unique<GpuMat<uint8_t>>(cost_map_->GetWidth(),
-                                                cost_map_->GetHeight(),
-                                                cost_map_->GetDepth());
+          consistency_mask_ = std::make_unique<GpuMat<uint8_t>>(
+              depth_map_->GetWidth(),
+              depth_map_->GetHeight(),
+              problem_.src_image_idxs.size());
           consistency_mask_->FillWithScalar(0);
         }
         if (options_.geom_consistency) {
@@ -1495,9 +1596,9 @@ void PatchMatchCuda::RunWithWindowSizeAndStep() {
       // Rotate selected image map.
       if (last_sweep && options_.filter) {
         std::unique_ptr<GpuMat<uint8_t>> rot_consistency_mask_(
-            new GpuMat<uint8_t>(cost_map_->GetWidth(),
-                                cost_map_->GetHeight(),
-                                cost_map_->GetDepth()));
+            new GpuMat<uint8_t>(depth_map_->GetWidth(),
+                                depth_map_->GetHeight(),
+                                problem_.src_image_idxs.size()));
         consistency_mask_->Rotate(rot_consistency_mask_.get());
         consistency_mask_.swap(rot_consistency_mask_);
       }
@@ -1505,6 +1606,23 @@ void PatchMatchCuda::RunWithWindowSizeAndStep() {
       sweep_timer.Print(" Sweep " + std::to_string(sweep + 1));
     }
 
+    // After the four sweeps, the maps are in their original orientation.
+    if (src_image_mask_->GetWidth() > 0 && iter >= 1 &&
+        iter + 1 < options_.num_iterations) {
+      const int tile_size = options_.src_image_prune_tile_size;
+      const dim3 block_size(16, 16, 1);
+      const dim3 grid_size(
+          ((ref_width_ - 1) / tile_size) / block_size.x + 1,
+          ((ref_height_ - 1) / tile_size) / block_size.y + 1,
+          problem_.src_image_idxs.size());
+      PruneSourceImages<T><<<grid_size, block_size>>>(
+          src_image_maps->prev_sel_prob_map->View(),
+          src_image_mask_->View(),
+          tile_size,
+          options_.src_image_prune_min_sel_prob);
+      CUDA_SYNC_AND_CHECK();
+    }
+
     iter_timer.Print("Iteration " + std::to_string(iter + 1));
   }
 
@@ -1624,7 +1742,8 @@ void PatchMatchCuda::InitSourceImages() {
       }
     }
 
-    // Create source depth maps texture.
+    // Create source depth maps texture. Half precision textures are
+    // transparently promoted to single precision when fetched.
     cudaTextureDesc texture_desc;
     memset(&texture_desc, 0, sizeof(texture_desc));
     texture_desc.addressMode[0] = cudaAddressModeBorder;
@@ -1633,12 +1752,28 @@ void PatchMatchCuda::InitSourceImages() {
     texture_desc.filterMode = cudaFilterModePoint;
     texture_desc.readMode = cudaReadModeElementType;
     texture_desc.normalizedCoords = false;
-    src_depth_maps_texture_ = CudaArrayLayeredTexture<float>::FromHostArray(
-        texture_desc,
-        max_width,
-        max_height,
-        problem_.src_image_idxs.size(),
-        src_depth_maps_host_data.data());
+    if (options_.half_precision) {
+      std::vector<__half> src_depth_maps_half_host_data(
+          src_depth_maps_host_data.size());
+      for (size_t i = 0; i < src_depth_maps_host_data.size(); ++i) {
+        src_depth_maps_half_host_data[i] =
+            __float2half(src_depth_maps_host_data[i]);
+      }
+      src_depth_maps_half_texture_ =
+          CudaArrayLayeredTexture<__half>::FromHostArray(
+              texture_desc,
+              max_width,
+              max_height,
+              problem_.src_image_idxs.size(),
+              src_depth_maps_half_host_data.data());
+    } else {
+      src_depth_maps_texture_ = CudaArrayLayeredTexture<float>::FromHostArray(
+          texture_desc,
+          max_width,
+          max_height,
+          problem_.src_image_idxs.size(),
+          src_depth_maps_host_data.data());
+    }
   }
 }
 
@@ -1758,15 +1893,19 @@ void PatchMatchCuda::InitTransforms() {
   }
 }
 
-void PatchMatchCuda::InitWorkspaceMemory() {
+void PatchMatchCuda::InitWorkspaceMemory(const DepthMap* init_depth_map,
+                                         const NormalMap* init_normal_map) {
   rand_state_map_ = std::make_unique<GpuMatPRNG>(ref_width_, ref_height_);
 
   depth_map_ = std::make_unique<GpuMat<float>>(ref_width_, ref_height_);
-  if (options_.geom_consistency) {
-    const DepthMap& init_depth_map =
+  if (init_depth_map != nullptr) {
+    depth_map_->CopyToDevice(init_depth_map->GetPtr(),
+                             init_depth_map->GetWidth() * sizeof(float));
+  } else if (options_.geom_consistency) {
+    const DepthMap& ref_depth_map =
         problem_.depth_maps->at(problem_.ref_image_idx);
-    depth_map_->CopyToDevice(init_depth_map.GetPtr(),
-                             init_depth_map.GetWidth() * sizeof(float));
+    depth_map_->CopyToDevice(ref_depth_map.GetPtr(),
+                             ref_depth_map.GetWidth() * sizeof(float));
   } else {
     depth_map_->FillWithRandomNumbers(
         options_.depth_min, options_.depth_max, *rand_state_map_);
@@ -1779,14 +1918,13 @@ void PatchMatchCuda::InitWorkspaceMemory() {
   // the temporary selection probabilities in the global_workspace_.
   // However, it is useful to keep the probabilities for the entire image
   // in memory, so that it can be exported.
-  sel_prob_map_ = std::make_unique<GpuMat<float>>(
-      ref_width_, ref_height_, problem_.src_image_idxs.size());
-  prev_sel_prob_map_ = std::make_unique<GpuMat<float>>(
-      ref_width_, ref_height_, problem_.src_image_idxs.size());
-  prev_sel_prob_map_->FillWithScalar(0.5f);
-
-  cost_map_ = std::make_unique<GpuMat<float>>(
-      ref_width_, ref_height_, problem_.src_image_idxs.size());
+  if (options_.half_precision) {
+    src_image_maps_half_ = std::make_unique<SourceImageMaps<__half>>(
+        ref_width_, ref_height_, problem_.src_image_idxs.size());
+  } else {
+    src_image_maps_ = std::make_unique<SourceImageMaps<float>>(
+        ref_width_, ref_height_, problem_.src_image_idxs.size());
+  }
 
   const int ref_max_dim = std::max(ref_width_, ref_height_);
   global_workspace_ = std::make_unique<GpuMat<float>>(
@@ -1794,19 +1932,56 @@ void PatchMatchCuda::InitWorkspaceMemory() {
 
   consistency_mask_ = std::make_unique<GpuMat<uint8_t>>(0, 0, 0);
 
+  if (options_.src_image_prune_min_sel_prob > 0) {
+    src_image_mask_ = std::make_unique<GpuMat<uint8_t>>(
+        ref_width_, ref_height_, problem_.src_image_idxs.size());
+    src_image_mask_->FillWithScalar(1);
+  } else {
+    src_image_mask_ = std::make_unique<GpuMat<uint8_t>>(0, 0, 0);
+  }
+
   ComputeCudaConfig();
 
-  if (options_.geom_consistency) {
-    const NormalMap& init_normal_map =
+  if (init_normal_map != nullptr) {
+    normal_map_->CopyToDevice(init_normal_map->GetPtr(),
+                              init_normal_map->GetWidth() * sizeof(float));
+  } else if (options_.geom_consistency) {
+    const NormalMap& ref_normal_map =
         problem_.normal_maps->at(problem_.ref_image_idx);
-    normal_map_->CopyToDevice(init_normal_map.GetPtr(),
-                              init_normal_map.GetWidth() * sizeof(float));
+    normal_map_->CopyToDevice(ref_normal_map.GetPtr(),
+                              ref_normal_map.GetWidth() * sizeof(float));
   } else {
     InitNormalMap<<<elem_wise_grid_size_, elem_wise_block_size_>>>(
         normal_map_->View(), rand_state_map_->View());
   }
 }
 
+template <typename T>
+PatchMatchCuda::SourceImageMaps<T>::SourceImageMaps(
+    const size_t width, const size_t height, const size_t num_src_images)
+    : sel_prob_map(std::make_unique<GpuMat<T>>(width, height, num_src_images)),
+      prev_sel_prob_map(
+          std::make_unique<GpuMat<T>>(width, height, num_src_images)),
+      cost_map(std::make_unique<GpuMat<T>>(width, height, num_src_images)) {
+  prev_sel_prob_map->FillWithScalar(static_cast<T>(0.5f));
+}
+
+template <typename T>
+void PatchMatchCuda::SourceImageMaps<T>::Rotate(const size_t width,
+                                                const size_t height) {
+  const size_t num_src_images = cost_map->GetDepth();
+
+  prev_sel_prob_map =
+      std::make_unique<GpuMat<T>>(width, height, num_src_images);
+  sel_prob_map->Rotate(prev_sel_prob_map.get());
+  sel_prob_map = std::make_unique<GpuMat<T>>(width, height, num_src_images);
+
+  auto rotated_cost_map =
+      std::make_unique<GpuMat<T>>(width, height, num_src_images);
+  cost_map->Rotate(rotated_cost_map.get());
+  cost_map.swap(rotated_cost_map);
+}
+
 void PatchMatchCuda::Rotate() {
   rotation_in_half_pi_ = (rotation_in_half_pi_ + 1) % 4;
 
@@ -1858,19 +2033,19 @@ void PatchMatchCuda::Rotate() {
     BindRefImageTexture();
   }
 
-  // Rotate selection probability map.
-  prev_sel_prob_map_ = std::make_unique<GpuMat<float>>(
-      width, height, problem_.src_image_idxs.size());
-  sel_prob_map_->Rotate(prev_sel_prob_map_.get());
-  sel_prob_map_ = std::make_unique<GpuMat<float>>(
-      width, height, problem_.src_image_idxs.size());
+  // Rotate source image mask.
+  if (src_image_mask_->GetWidth() > 0) {
+    auto rotated_src_image_mask = std::make_unique<GpuMat<uint8_t>>(
+        width, height, problem_.src_image_idxs.size());
+    src_image_mask_->Rotate(rotated_src_image_mask.get());
+    src_image_mask_.swap(rotated_src_image_mask);
+  }
 
-  // Rotate cost map.
-  {
-    std::unique_ptr<GpuMat<float>> rotated_cost_map(
-        new GpuMat<float>(width, height, problem_.src_image_idxs.size()));
-    cost_map_->Rotate(rotated_cost_map.get());
-    cost_map_.swap(rotated_cost_map);
+  // Rotate selection probability and cost maps.
+  if (src_image_maps_half_ == nullptr) {
+    src_image_maps_->Rotate(width, height);
+  } else {
+    src_image_maps_half_->Rotate(width, height);
   }
 
   // Rotate calibration.
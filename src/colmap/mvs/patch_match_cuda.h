@@ -42,27 +42,51 @@
 #include <memory>
 #include <vector>
 
+#include <cuda_fp16.h>
 #include <cuda_runtime.h>
 
 namespace colmap {
 namespace mvs {
 
-class PatchMatchCuda {
+class PatchMatchCuda : public PatchMatchSolver {
  public:
+  // The depth and normal maps are initialized from the given maps, if not
+  // null, e.g., from a coarser level of the pyramid. Otherwise, they are
+  // initialized from the problem for geometric consistency or randomly.
   PatchMatchCuda(const PatchMatchOptions& options,
-                 const PatchMatch::Problem& problem);
+                 const PatchMatch::Problem& problem,
+                 const DepthMap* init_depth_map = nullptr,
+                 const NormalMap* init_normal_map = nullptr);
 
-  void Run();
+  void Run() override;
 
-  DepthMap GetDepthMap() const;
-  NormalMap GetNormalMap() const;
-  Mat<float> GetSelProbMap() const;
-  std::vector<int> GetConsistentImageIdxs() const;
+  DepthMap GetDepthMap() const override;
+  NormalMap GetNormalMap() const override;
+  Mat<float> GetSelProbMap() const override;
+  std::vector<int> GetConsistentImageIdxs() const override;
 
  private:
+  // Maps of the reference image with one slice per source image. Their memory
+  // grows linearly with the number of source images, so they are stored in
+  // either single or half precision.
+  template <typename T>
+  struct SourceImageMaps {
+    std::unique_ptr<GpuMat<T>> sel_prob_map;
+    std::unique_ptr<GpuMat<T>> prev_sel_prob_map;
+    std::unique_ptr<GpuMat<T>> cost_map;
+
+    SourceImageMaps(size_t width, size_t height, size_t num_src_images);
+
+    // Rotate the maps to the given, already rotated dimensions.
+    void Rotate(size_t width, size_t height);
+  };
+
   template <int kWindowSize, int kWindowStep>
   void RunWithWindowSizeAndStep();
 
+  template <int kWindowSize, int kWindowStep, typename T>
+  void RunWithWindowSizeAndStep(SourceImageMaps<T>* src_image_maps);
+
   void ComputeCudaConfig();
 
   void BindRefImageTexture();
@@ -70,7 +94,8 @@ class PatchMatchCuda {
   void InitRefImage();
   void InitSourceImages();
   void InitTransforms();
-  void InitWorkspaceMemory();
+  void InitWorkspaceMemory(const DepthMap* init_depth_map,
+                           const NormalMap* init_normal_map);
 
   // Rotate reference image by 90 degrees in counter-clockwise direction.
   void Rotate();
@@ -97,6 +122,7 @@ class PatchMatchCuda {
   std::unique_ptr<CudaArrayLayeredTexture<uint8_t>> ref_image_texture_;
   std::unique_ptr<CudaArrayLayeredTexture<uint8_t>> src_images_texture_;
   std::unique_ptr<CudaArrayLayeredTexture<float>> src_depth_maps_texture_;
+  std::unique_ptr<CudaArrayLayeredTexture<__half>> src_depth_maps_half_texture_;
 
   // Relative poses from rotated versions of reference image to source images
   // corresponding to _rotationInHalfPi:
@@ -123,11 +149,14 @@ class PatchMatchCuda {
   std::unique_ptr<GpuMatRefImage> ref_image_;
   std::unique_ptr<GpuMat<float>> depth_map_;
   std::unique_ptr<GpuMat<float>> normal_map_;
-  std::unique_ptr<GpuMat<float>> sel_prob_map_;
-  std::unique_ptr<GpuMat<float>> prev_sel_prob_map_;
-  std::unique_ptr<GpuMat<float>> cost_map_;
+  // Exactly one of these is set depending on options_.half_precision.
+  std::unique_ptr<SourceImageMaps<float>> src_image_maps_;
+  std::unique_ptr<SourceImageMaps<__half>> src_image_maps_half_;
   std::unique_ptr<GpuMatPRNG> rand_state_map_;
   std::unique_ptr<GpuMat<uint8_t>> consistency_mask_;
+  // Whether the costs of a source image are computed for a pixel. Empty, if
+  // source image pruning is disabled.
+  std::unique_ptr<GpuMat<uint8_t>> src_image_mask_;
 
   // Shared memory is too small to hold local state for each thread,
   // so this is workspace memory in global memory.
@@ -45,6 +45,7 @@ const static size_t kMaxPatchMatchWindowRadius = 32;
 void PatchMatchOptions::Print() const {
   LOG_HEADING2("PatchMatchOptions");
   PrintOption(max_image_size);
+  PrintOption(use_gpu);
   PrintOption(gpu_index);
   PrintOption(depth_min);
   PrintOption(depth_max);
@@ -53,10 +54,20 @@ void PatchMatchOptions::Print() const {
   PrintOption(sigma_spatial);
   PrintOption(sigma_color);
   PrintOption(num_samples);
+  PrintOption(src_image_selection);
+  PrintOption(src_image_prune_min_sel_prob);
+  PrintOption(src_image_prune_tile_size);
   PrintOption(ncc_sigma);
   PrintOption(min_triangulation_angle);
   PrintOption(incident_angle_sigma);
   PrintOption(num_iterations);
+  PrintOption(pyramid_num_levels);
+  PrintOption(pyramid_num_iterations);
+  PrintOption(init_mode);
+  PrintOption(init_num_iterations);
+  PrintOption(half_precision);
+  PrintOption(tile_size);
+  PrintOption(tile_overlap);
   PrintOption(geom_consistency);
   PrintOption(geom_consistency_regularizer);
   PrintOption(geom_consistency_max_cost);
@@ -66,7 +77,10 @@ void PatchMatchOptions::Print() const {
   PrintOption(filter_min_num_consistent);
   PrintOption(filter_geom_consistency_max_cost);
   PrintOption(write_consistency_graph);
+  PrintOption(map_compression);
   PrintOption(allow_missing_files);
+  PrintOption(distributed);
+  PrintOption(io_pipeline_depth);
   PrintOption(num_threads);
 }
 
@@ -86,6 +100,21 @@ bool PatchMatchOptions::Check() const {
   CHECK_OPTION_LT(min_triangulation_angle, 180.0f);
   CHECK_OPTION_GT(incident_angle_sigma, 0.0f);
   CHECK_OPTION_GT(num_iterations, 0);
+  CHECK_OPTION_GT(pyramid_num_levels, 0);
+  CHECK_OPTION_GT(pyramid_num_iterations, 0);
+  CHECK_OPTION(init_mode == "random" || init_mode == "sparse" ||
+               init_mode == "prior");
+  CHECK_OPTION(init_num_iterations == -1 || init_num_iterations > 0);
+  CHECK_OPTION(src_image_selection == "shared_points" ||
+               src_image_selection == "score");
+  CHECK_OPTION_GE(src_image_prune_min_sel_prob, 0);
+  CHECK_OPTION_LE(src_image_prune_min_sel_prob, 1);
+  CHECK_OPTION_GT(src_image_prune_tile_size, 0);
+  CHECK_OPTION_GE(tile_size, 0);
+  CHECK_OPTION_GE(tile_overlap, 0);
+  if (tile_size > 0) {
+    CHECK_OPTION_GT(tile_size, 2 * tile_overlap);
+  }
   CHECK_OPTION_GE(geom_consistency_regularizer, 0.0f);
   CHECK_OPTION_GE(geom_consistency_max_cost, 0.0f);
   CHECK_OPTION_GE(filter_min_ncc, -1.0f);
@@ -96,6 +125,9 @@ bool PatchMatchOptions::Check() const {
   CHECK_OPTION_GE(filter_geom_consistency_max_cost, 0.0f);
   CHECK_OPTION_GT(cache_size, 0);
   CHECK_OPTION_GE(num_threads, -1);
+  CHECK_OPTION_GE(io_pipeline_depth, 0);
+  CHECK_OPTION(map_compression == "none" || map_compression == "lossless" ||
+               map_compression == "quantized");
   return true;
 }
 
@@ -77,6 +77,15 @@ struct PatchMatchOptions {
   // of memory, if the consistency graph is dense.
   double cache_size = 32.0;
 
+  // Whether to run PatchMatch on the GPU. Otherwise, the multi-threaded CPU
+  // implementation is used, which is considerably slower but does not
+  // require CUDA.
+#if defined(COLMAP_CUDA_ENABLED)
+  bool use_gpu = true;
+#else
+  bool use_gpu = false;
+#endif
+
   // Index of the GPU used for patch match. For multi-GPU usage,
   // you should separate multiple GPU indices by comma, e.g., "0,1,2,3".
   std::string gpu_index = "-1";
@@ -97,10 +106,68 @@ struct PatchMatchOptions {
   // Number of random samples to draw in Monte Carlo sampling.
   int num_samples = 15;
 
+  // Ranking of the candidate source images for the "__auto__" configuration:
+  // "shared_points" by the number of shared sparse points, "score" by the
+  // shared points weighted by their triangulation angle and resolution ratio,
+  // see `Model::ComputeSourceImageScores`.
+  std::string src_image_selection = "shared_points";
+
+  // Source images, whose selection probability is below this threshold for
+  // all pixels of a tile of src_image_prune_tile_size^2 pixels after an
+  // iteration, are excluded from the cost computation for the pixels of the
+  // tile in the remaining iterations. Pruning starts after the second
+  // iteration, once the selection probabilities have settled. 0 disables it.
+  double src_image_prune_min_sel_prob = 0;
+  int src_image_prune_tile_size = 32;
+
   // Number of coordinate descent iterations. Each iteration consists
   // of four sweeps from left to right, top to bottom, and vice versa.
   int num_iterations = 5;
 
+  // Number of levels for coarse-to-fine estimation. For more than one level,
+  // the photometric problem is first solved at half the resolution per level
+  // using num_iterations, and each finer level is initialized with the
+  // upsampled depth and normal maps of the coarser level and refined using
+  // pyramid_num_iterations. Levels that would be smaller than a few windows
+  // are skipped. The geometric consistency problem is initialized from the
+  // photometric results and always solved at full resolution.
+  int pyramid_num_levels = 1;
+
+  // Number of coordinate descent iterations at the levels finer than the
+  // coarsest level of the pyramid.
+  int pyramid_num_iterations = 2;
+
+  // Initialization of the photometric problem: "random" samples the depths
+  // uniformly in the depth range, "sparse" interpolates the depths of the
+  // sparse points observed by the reference image over the Delaunay
+  // triangulation of their projections, and "prior" reads a depth map, e.g.,
+  // rendered from a mesh or LiDAR scans, for each reference image from the
+  // `prior_depth_maps` folder of the stereo folder as `<image_name>.bin`.
+  // Pixels without prior depth are initialized randomly.
+  std::string init_mode = "random";
+
+  // Number of coordinate descent iterations at the coarsest level, if the
+  // problem is initialized from sparse or prior depths. Good initial depths
+  // typically converge within one or two iterations. -1 uses num_iterations.
+  int init_num_iterations = -1;
+
+  // Whether to store the per source image cost and selection probability
+  // maps and the source depth maps in half precision on the GPU. All
+  // computations are still performed in single precision. This roughly
+  // halves the GPU memory that grows with the number of source images.
+  bool half_precision = false;
+
+  // Maximum width and height of the reference image tiles. Larger reference
+  // images are solved in overlapping tiles one after another, each with the
+  // source images cropped to the region observed by the tile within the
+  // depth range, so that the GPU memory is bounded by the tile rather than
+  // the image size. 0 disables tiling.
+  int tile_size = 0;
+
+  // Overlap of neighboring tiles in pixels, across which the depth and normal
+  // maps of the tiles are blended linearly.
+  int tile_overlap = 64;
+
   // Minimum number of source images have to be consistent
   // for pixel not to be filtered.
   int filter_min_num_consistent = 2;
@@ -121,6 +188,23 @@ struct PatchMatchOptions {
   // Whether to write the consistency graph.
   bool write_consistency_graph = false;
 
+  // Format of the written depth and normal maps: "none" for the raw format,
+  // "lossless" or "quantized" for the tiled compressed format, see
+  // `MatCompressionOptions`. Readers detect the format automatically.
+  std::string map_compression = "none";
+
+  // Whether to claim problems through lock directories in the workspace, so
+  // that multiple processes, e.g., on the nodes of a cluster with a shared
+  // file system, can process the same workspace concurrently. Problems with
+  // existing outputs are skipped. The locks of crashed processes remain in
+  // the `locks` folder of the stereo folder and must be removed manually.
+  bool distributed = false;
+
+  // Number of problems per GPU whose inputs are read ahead and whose outputs
+  // are written in the background while the GPU processes the current
+  // problem. Zero reads and writes each problem synchronously.
+  int io_pipeline_depth = 1;
+
   void Print() const;
   bool Check() const;
 };
@@ -31,6 +31,8 @@
 
 #include "colmap/util/file.h"
 #include "colmap/util/logging.h"
+#include "colmap/util/ply.h"
+#include "colmap/util/string.h"
 #include "colmap/util/threading.h"
 
 #if defined(__GNUC__) && !defined(__clang__)
@@ -47,8 +49,14 @@
 #include "thirdparty/PoissonRecon/PoissonRecon.h"
 #include "thirdparty/PoissonRecon/SurfaceTrimmer.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
 #include <vector>
 
+#include <Eigen/Geometry>
+
 namespace colmap {
 namespace mvs {
 
@@ -58,38 +66,21 @@ bool PoissonMeshingOptions::Check() const {
   CHECK_OPTION_GE(trim, 0);
   CHECK_OPTION_GE(num_threads, -1);
   CHECK_OPTION_NE(num_threads, 0);
+  CHECK_OPTION_GE(max_num_points_per_block, 0);
+  CHECK_OPTION_GE(block_overlap, 0);
   return true;
 }
 
-bool PoissonMeshing(const PoissonMeshingOptions& options,
-                    const std::filesystem::path& input_path,
-                    const std::filesystem::path& output_path) {
-  THROW_CHECK(options.Check());
-  THROW_CHECK_HAS_FILE_EXTENSION(input_path, ".ply");
-  THROW_CHECK_FILE_EXISTS(input_path);
-  THROW_CHECK_HAS_FILE_EXTENSION(output_path, ".ply");
-  THROW_CHECK_PATH_OPEN(output_path);
+namespace {
 
+// Runs the Poisson reconstruction and the optional trimming of the surface on
+// the given input points.
+bool RunPoissonMeshing(const PoissonMeshingOptions& options,
+                       const int depth,
+                       const std::filesystem::path& input_path,
+                       const std::filesystem::path& output_path) {
   bool success = true;
 
-  const int num_effective_threads = GetEffectiveNumThreads(options.num_threads);
-
-  // Configure PoissonRecon's internal thread pool directly, since it uses its
-  // own threading mechanism that is not controlled by OMP settings.
-  PoissonRecon::ThreadPool::SetNumThreads(num_effective_threads);
-  if (num_effective_threads > 1) {
-#ifdef _OPENMP
-    PoissonRecon::ThreadPool::ParallelizationType =
-        PoissonRecon::ThreadPool::OPEN_MP;
-#else
-    PoissonRecon::ThreadPool::ParallelizationType =
-        PoissonRecon::ThreadPool::ASYNC;
-#endif
-  } else {
-    PoissonRecon::ThreadPool::ParallelizationType =
-        PoissonRecon::ThreadPool::NONE;
-  }
-
   try {
     std::vector<std::string> args;
 
@@ -105,12 +96,12 @@ bool PoissonMeshing(const PoissonMeshingOptions& options,
     args.push_back(std::to_string(options.point_weight));
 
     args.push_back("--depth");
-    args.push_back(std::to_string(options.depth));
+    args.push_back(std::to_string(depth));
 
     // Full depth cannot exceed system depth.
-    if (options.depth < 5) {
+    if (depth < 5) {
       args.push_back("--fullDepth");
-      args.push_back(std::to_string(options.depth));
+      args.push_back(std::to_string(depth));
     }
 
     if (options.color) {
@@ -166,5 +157,253 @@ bool PoissonMeshing(const PoissonMeshingOptions& options,
   return success;
 }
 
+// Block of the input points. The boxes of all blocks tile the space without
+// overlap, where the outer blocks extend to infinity.
+struct PoissonMeshingBlock {
+  Eigen::AlignedBox3f box;
+  std::vector<size_t> point_idxs;
+};
+
+Eigen::Vector3f PlyPointPosition(const PlyPoint& point) {
+  return Eigen::Vector3f(point.x, point.y, point.z);
+}
+
+// Half-open containment test, such that every position on the shared boundary
+// of two neighboring blocks belongs to exactly one of them.
+bool IsInsideBlock(const Eigen::AlignedBox3f& box,
+                   const Eigen::Vector3f& position) {
+  return (position.array() >= box.min().array()).all() &&
+         (position.array() < box.max().array()).all();
+}
+
+// Recursively split the points at the median of the longest axis of their
+// bounding box until each block has at most the given number of points.
+void PartitionPoints(const std::vector<PlyPoint>& points,
+                     const int max_num_points,
+                     PoissonMeshingBlock block,
+                     std::vector<PoissonMeshingBlock>* blocks) {
+  auto& point_idxs = block.point_idxs;
+  if (point_idxs.size() <= static_cast<size_t>(max_num_points)) {
+    blocks->push_back(std::move(block));
+    return;
+  }
+
+  Eigen::AlignedBox3f bbox;
+  for (const auto point_idx : point_idxs) {
+    bbox.extend(PlyPointPosition(points[point_idx]));
+  }
+
+  int axis;
+  bbox.sizes().maxCoeff(&axis);
+
+  const auto Coordinate = [&](const size_t point_idx) {
+    return PlyPointPosition(points[point_idx])(axis);
+  };
+
+  const auto median_it = point_idxs.begin() + point_idxs.size() / 2;
+  std::nth_element(point_idxs.begin(),
+                   median_it,
+                   point_idxs.end(),
+                   [&](const size_t point_idx1, const size_t point_idx2) {
+                     return Coordinate(point_idx1) < Coordinate(point_idx2);
+                   });
+  const float split = Coordinate(*median_it);
+  const auto split_it =
+      std::partition(point_idxs.begin(),
+                     point_idxs.end(),
+                     [&](const size_t point_idx) {
+                       return Coordinate(point_idx) < split;
+                     });
+
+  // All points share the same coordinate and cannot be split any further.
+  if (split_it == point_idxs.begin()) {
+    blocks->push_back(std::move(block));
+    return;
+  }
+
+  PoissonMeshingBlock left_block;
+  left_block.box = block.box;
+  left_block.box.max()(axis) = split;
+  left_block.point_idxs.assign(point_idxs.begin(), split_it);
+
+  PoissonMeshingBlock right_block;
+  right_block.box = block.box;
+  right_block.box.min()(axis) = split;
+  right_block.point_idxs.assign(split_it, point_idxs.end());
+
+  point_idxs.clear();
+  point_idxs.shrink_to_fit();
+
+  PartitionPoints(points, max_num_points, std::move(left_block), blocks);
+  PartitionPoints(points, max_num_points, std::move(right_block), blocks);
+}
+
+// Reconstructs the blocks of the input points one after another and merges
+// their surfaces. The faces of each block are clipped to the block's box
+// after trimming, so that the overlapping parts of neighboring blocks are not
+// duplicated. Note that the vertices of neighboring blocks are not shared, so
+// that small cracks may remain at the seams.
+bool ChunkedPoissonMeshing(const PoissonMeshingOptions& options,
+                           const std::vector<PlyPoint>& points,
+                           const std::filesystem::path& output_path) {
+  PoissonMeshingBlock root_block;
+  root_block.box = Eigen::AlignedBox3f(
+      Eigen::Vector3f::Constant(-std::numeric_limits<float>::infinity()),
+      Eigen::Vector3f::Constant(std::numeric_limits<float>::infinity()));
+  root_block.point_idxs.resize(points.size());
+  std::iota(root_block.point_idxs.begin(), root_block.point_idxs.end(), 0);
+
+  std::vector<PoissonMeshingBlock> blocks;
+  PartitionPoints(points,
+                  options.max_num_points_per_block,
+                  std::move(root_block),
+                  &blocks);
+
+  Eigen::AlignedBox3f scene_box;
+  for (const auto& point : points) {
+    scene_box.extend(PlyPointPosition(point));
+  }
+  const float scene_extent = scene_box.sizes().maxCoeff();
+
+  std::filesystem::path block_points_path = output_path;
+  block_points_path += ".block-points.ply";
+  std::filesystem::path block_mesh_path = output_path;
+  block_mesh_path += ".block-mesh.ply";
+
+  PlyMesh mesh;
+  size_t num_failed_blocks = 0;
+  for (size_t block_idx = 0; block_idx < blocks.size(); ++block_idx) {
+    const auto& block = blocks[block_idx];
+
+    Eigen::AlignedBox3f overlap_box;
+    for (const auto point_idx : block.point_idxs) {
+      overlap_box.extend(PlyPointPosition(points[point_idx]));
+    }
+    const Eigen::Vector3f overlap = options.block_overlap * overlap_box.sizes();
+    overlap_box.min() -= overlap;
+    overlap_box.max() += overlap;
+
+    const float block_extent = overlap_box.sizes().maxCoeff();
+    if (block_extent <= 0) {
+      continue;
+    }
+
+    // Reduce the depth by the number of octree levels between the scene and
+    // the block, so that both have the same finest voxel size.
+    const int num_coarser_levels =
+        static_cast<int>(std::floor(std::log2(scene_extent / block_extent)));
+    const int block_depth = std::max(1, options.depth - num_coarser_levels);
+
+    std::vector<PlyPoint> block_points;
+    for (const auto& point : points) {
+      if (overlap_box.contains(PlyPointPosition(point))) {
+        block_points.push_back(point);
+      }
+    }
+
+    LOG(INFO) << StringPrintf(
+        "Reconstructing block [%d/%d] with %d points at depth %d",
+        block_idx + 1,
+        blocks.size(),
+        block_points.size(),
+        block_depth);
+
+    WriteBinaryPlyPoints(block_points_path,
+                         block_points,
+                         /*write_normal=*/true,
+                         /*write_rgb=*/options.color);
+    block_points.clear();
+    block_points.shrink_to_fit();
+
+    if (!RunPoissonMeshing(
+            options, block_depth, block_points_path, block_mesh_path)) {
+      LOG(WARNING) << "Failed to reconstruct block " << block_idx;
+      num_failed_blocks += 1;
+      continue;
+    }
+
+    const PlyMesh block_mesh = ReadPlyMesh(block_mesh_path).mesh;
+
+    constexpr size_t kInvalidVertexIdx = std::numeric_limits<size_t>::max();
+    std::vector<size_t> vertex_idx_map(block_mesh.vertices.size(),
+                                       kInvalidVertexIdx);
+    const auto MapVertex = [&](const size_t vertex_idx) {
+      if (vertex_idx_map[vertex_idx] == kInvalidVertexIdx) {
+        vertex_idx_map[vertex_idx] = mesh.vertices.size();
+        mesh.vertices.push_back(block_mesh.vertices[vertex_idx]);
+      }
+      return vertex_idx_map[vertex_idx];
+    };
+
+    const auto VertexPosition = [&](const size_t vertex_idx) {
+      const auto& vertex = block_mesh.vertices[vertex_idx];
+      return Eigen::Vector3f(vertex.x, vertex.y, vertex.z);
+    };
+
+    for (const auto& face : block_mesh.faces) {
+      const Eigen::Vector3f centroid = (VertexPosition(face.vertex_idx1) +
+                                        VertexPosition(face.vertex_idx2) +
+                                        VertexPosition(face.vertex_idx3)) /
+                                       3.0f;
+      if (IsInsideBlock(block.box, centroid)) {
+        mesh.faces.emplace_back(MapVertex(face.vertex_idx1),
+                                MapVertex(face.vertex_idx2),
+                                MapVertex(face.vertex_idx3));
+      }
+    }
+  }
+
+  std::filesystem::remove(block_points_path);
+  std::filesystem::remove(block_mesh_path);
+
+  if (num_failed_blocks == blocks.size()) {
+    return false;
+  }
+
+  WriteBinaryPlyMesh(output_path, PlyTexturedMesh{mesh}, options.color);
+
+  return true;
+}
+
+}  // namespace
+
+bool PoissonMeshing(const PoissonMeshingOptions& options,
+                    const std::filesystem::path& input_path,
+                    const std::filesystem::path& output_path) {
+  THROW_CHECK(options.Check());
+  THROW_CHECK_HAS_FILE_EXTENSION(input_path, ".ply");
+  THROW_CHECK_FILE_EXISTS(input_path);
+  THROW_CHECK_HAS_FILE_EXTENSION(output_path, ".ply");
+  THROW_CHECK_PATH_OPEN(output_path);
+
+  const int num_effective_threads = GetEffectiveNumThreads(options.num_threads);
+
+  // Configure PoissonRecon's internal thread pool directly, since it uses its
+  // own threading mechanism that is not controlled by OMP settings.
+  PoissonRecon::ThreadPool::SetNumThreads(num_effective_threads);
+  if (num_effective_threads > 1) {
+#ifdef _OPENMP
+    PoissonRecon::ThreadPool::ParallelizationType =
+        PoissonRecon::ThreadPool::OPEN_MP;
+#else
+    PoissonRecon::ThreadPool::ParallelizationType =
+        PoissonRecon::ThreadPool::ASYNC;
+#endif
+  } else {
+    PoissonRecon::ThreadPool::ParallelizationType =
+        PoissonRecon::ThreadPool::NONE;
+  }
+
+  if (options.max_num_points_per_block > 0) {
+    const std::vector<PlyPoint> points = ReadPly(input_path);
+    if (points.size() >
+        static_cast<size_t>(options.max_num_points_per_block)) {
+      return ChunkedPoissonMeshing(options, points, output_path);
+    }
+  }
+
+  return RunPoissonMeshing(options, options.depth, input_path, output_path);
+}
+
 }  // namespace mvs
 }  // namespace colmap
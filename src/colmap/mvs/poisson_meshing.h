@@ -58,6 +58,20 @@ struct PoissonMeshingOptions {
   // The number of threads used for the Poisson reconstruction.
   int num_threads = -1;
 
+  // Maximum number of input points per block, which bounds the memory usage
+  // of the reconstruction. If positive, the points are recursively split at
+  // the median of the longest axis of their bounding box until each block has
+  // at most this many points. The blocks are then reconstructed separately
+  // with the depth reduced by their size relative to the entire scene, such
+  // that the resolution is the same as for a single reconstruction at the
+  // given depth. Disabled if zero.
+  int max_num_points_per_block = 0;
+
+  // Overlap between neighboring blocks relative to the block extent. Each
+  // block is reconstructed with the points in the overlap, but only the faces
+  // inside the block are kept when merging the meshes.
+  double block_overlap = 0.1;
+
   bool Check() const;
 };
 
@@ -100,6 +100,54 @@ TEST(PoissonMeshing, WithTrimming) {
   EXPECT_GE(mesh_vertices.size(), 0);
 }
 
+TEST(PoissonMeshing, Chunked) {
+  const auto test_dir = CreateTestDir();
+  const auto input_path = test_dir / "points.ply";
+  const auto output_path = test_dir / "mesh.ply";
+
+  // Sample points with outward normals on the unit sphere.
+  std::vector<PlyPoint> ply_points;
+  for (int i = 0; i < 2000; ++i) {
+    const Eigen::Vector3f normal = Eigen::Vector3f::Random().normalized();
+    PlyPoint ply_point;
+    ply_point.x = normal.x();
+    ply_point.y = normal.y();
+    ply_point.z = normal.z();
+    ply_point.nx = normal.x();
+    ply_point.ny = normal.y();
+    ply_point.nz = normal.z();
+    ply_points.push_back(ply_point);
+  }
+  WriteBinaryPlyPoints(
+      input_path, ply_points, /*write_normal=*/true, /*write_rgb=*/true);
+
+  PoissonMeshingOptions options;
+  options.depth = 6;
+  options.trim = 0.0;
+  options.num_threads = 1;
+  options.max_num_points_per_block = 500;
+
+  EXPECT_TRUE(PoissonMeshing(options, input_path, output_path));
+  EXPECT_FALSE(ExistsFile(test_dir / "mesh.ply.block-points.ply"));
+  EXPECT_FALSE(ExistsFile(test_dir / "mesh.ply.block-mesh.ply"));
+
+  const PlyMesh mesh = ReadPlyMesh(output_path).mesh;
+  EXPECT_GE(mesh.faces.size(), 100);
+  for (const auto& vertex : mesh.vertices) {
+    EXPECT_NEAR(Eigen::Vector3f(vertex.x, vertex.y, vertex.z).norm(), 1, 0.2);
+  }
+}
+
+TEST(PoissonMeshingOptions, Check) {
+  PoissonMeshingOptions options;
+  EXPECT_TRUE(options.Check());
+  options.max_num_points_per_block = -1;
+  EXPECT_FALSE(options.Check());
+  options.max_num_points_per_block = 100;
+  options.block_overlap = -0.1;
+  EXPECT_FALSE(options.Check());
+}
+
 }  // namespace
 }  // namespace mvs
 }  // namespace colmap
@@ -31,6 +31,7 @@
 
 #include "colmap/util/logging.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/threading.h"
 
 #include <algorithm>
 #include <array>
@@ -269,31 +270,190 @@ struct OcclusionTester {
 
 #endif  // COLMAP_CGAL_ENABLED
 
-std::vector<int> SelectViews(const PlyMesh& mesh,
-                             const std::vector<Eigen::Vector3f>& face_normals,
-                             const std::vector<Image>& images,
-                             const FaceAdjacencyMap& adjacency,
-                             const MeshTextureMappingOptions& options) {
+// Renders all faces in front of the camera into a depth buffer and scores the
+// faces that are visible in the view by their projected area, similar to
+// rasterizing a face index buffer on the GPU. A face is visible if most of its
+// pixels are not occluded by other faces in the depth buffer. Faces that do not
+// cover any pixel center are tested by their centroid.
+void ScoreFacesByRasterization(const PlyMesh& mesh,
+                               const std::vector<Eigen::Vector3f>& face_normals,
+                               const Image& image,
+                               const MeshTextureMappingOptions& options,
+                               double* scores,
+                               const size_t scores_stride) {
+  // Relative depth tolerance for pixels on shared edges and coplanar faces.
+  constexpr float kDepthTolerance = 1e-3f;
+  // Minimum ratio of non-occluded pixels for a face to be visible.
+  constexpr double kMinVisiblePixelRatio = 0.9;
+
   const size_t num_faces = mesh.faces.size();
-  const size_t num_images = images.size();
+  const size_t num_vertices = mesh.vertices.size();
+  const int width = static_cast<int>(image.GetWidth());
+  const int height = static_cast<int>(image.GetHeight());
+  const float* P = image.GetP();
+
+  std::vector<Eigen::Vector2f> proj_vertices(num_vertices);
+  std::vector<float> vertex_depths(num_vertices);
+  for (size_t vi = 0; vi < num_vertices; ++vi) {
+    const Eigen::Vector3f v = GetVertex(mesh, vi);
+    vertex_depths[vi] = ProjectPointDepth(P, v);
+    if (vertex_depths[vi] > 0) {
+      proj_vertices[vi] = ProjectPoint(P, v);
+    }
+  }
 
-  if (num_faces == 0 || num_images == 0) {
-    return std::vector<int>(num_faces, -1);
+  std::vector<float> depth_map(static_cast<size_t>(width) * height,
+                               std::numeric_limits<float>::infinity());
+
+  // Calls the callback with the pixel index and the perspective-correct depth
+  // for all pixel centers inside the projected face.
+  const auto RasterizeFace = [&](const std::array<size_t, 3>& idx,
+                                 const auto& callback) {
+    const Eigen::Vector2f& p0 = proj_vertices[idx[0]];
+    const Eigen::Vector2f& p1 = proj_vertices[idx[1]];
+    const Eigen::Vector2f& p2 = proj_vertices[idx[2]];
+    const float area = (p1 - p0).x() * (p2 - p0).y() -
+                       (p1 - p0).y() * (p2 - p0).x();
+    if (std::abs(area) < 1e-12f) {
+      return;
+    }
+
+    const float min_x = std::min({p0.x(), p1.x(), p2.x()});
+    const float min_y = std::min({p0.y(), p1.y(), p2.y()});
+    const float max_x = std::max({p0.x(), p1.x(), p2.x()});
+    const float max_y = std::max({p0.y(), p1.y(), p2.y()});
+    if (max_x < 0 || max_y < 0 || min_x >= width || min_y >= height) {
+      return;
+    }
+    const int min_px = static_cast<int>(std::max(0.0f, std::floor(min_x)));
+    const int min_py = static_cast<int>(std::max(0.0f, std::floor(min_y)));
+    const int max_px = static_cast<int>(
+        std::min(static_cast<float>(width - 1), std::ceil(max_x)));
+    const int max_py = static_cast<int>(
+        std::min(static_cast<float>(height - 1), std::ceil(max_y)));
+
+    const float inv_area = 1.0f / area;
+    const float inv_depth0 = 1.0f / vertex_depths[idx[0]];
+    const float inv_depth1 = 1.0f / vertex_depths[idx[1]];
+    const float inv_depth2 = 1.0f / vertex_depths[idx[2]];
+
+    for (int py = min_py; py <= max_py; ++py) {
+      for (int px = min_px; px <= max_px; ++px) {
+        const Eigen::Vector2f p(px + 0.5f, py + 0.5f);
+        const float w0 = ((p2 - p1).x() * (p - p1).y() -
+                          (p2 - p1).y() * (p - p1).x()) *
+                         inv_area;
+        const float w1 = ((p0 - p2).x() * (p - p2).y() -
+                          (p0 - p2).y() * (p - p2).x()) *
+                         inv_area;
+        const float w2 = 1.0f - w0 - w1;
+        if (w0 < 0 || w1 < 0 || w2 < 0) {
+          continue;
+        }
+        // Depth is interpolated linearly in inverse depth.
+        const float depth =
+            1.0f / (w0 * inv_depth0 + w1 * inv_depth1 + w2 * inv_depth2);
+        callback(static_cast<size_t>(py) * width + px, depth);
+      }
+    }
+  };
+
+  const auto IsInFront = [&](const std::array<size_t, 3>& idx) {
+    return vertex_depths[idx[0]] > 0 && vertex_depths[idx[1]] > 0 &&
+           vertex_depths[idx[2]] > 0;
+  };
+
+  for (size_t fi = 0; fi < num_faces; ++fi) {
+    const std::array<size_t, 3> idx = GetFaceIndices(mesh.faces[fi]);
+    if (!IsInFront(idx)) {
+      continue;
+    }
+    RasterizeFace(idx, [&](const size_t pixel_idx, const float depth) {
+      depth_map[pixel_idx] = std::min(depth_map[pixel_idx], depth);
+    });
+  }
+
+  const Eigen::Vector3f cam_center =
+      ComputeCameraCenter(image.GetR(), image.GetT());
+
+  for (size_t fi = 0; fi < num_faces; ++fi) {
+    const Eigen::Vector3f& normal = face_normals[fi];
+    if (normal.squaredNorm() < 1e-10f) continue;
+
+    const std::array<size_t, 3> idx = GetFaceIndices(mesh.faces[fi]);
+    if (!IsInFront(idx)) continue;
+
+    const Eigen::Vector3f centroid = (GetVertex(mesh, idx[0]) +
+                                      GetVertex(mesh, idx[1]) +
+                                      GetVertex(mesh, idx[2])) /
+                                     3.0f;
+    const Eigen::Vector3f view_dir = (cam_center - centroid).normalized();
+    if (normal.dot(view_dir) <
+        static_cast<float>(options.min_cos_normal_angle)) {
+      continue;
+    }
+
+    int visible_count = 0;
+    for (int vi = 0; vi < 3; ++vi) {
+      const Eigen::Vector2f& proj = proj_vertices[idx[vi]];
+      if (proj.x() >= 0 && proj.x() < static_cast<float>(width) &&
+          proj.y() >= 0 && proj.y() < static_cast<float>(height)) {
+        ++visible_count;
+      }
+    }
+    if (visible_count < options.min_visible_vertices) continue;
+
+    int num_pixels = 0;
+    int num_visible_pixels = 0;
+    RasterizeFace(idx, [&](const size_t pixel_idx, const float depth) {
+      ++num_pixels;
+      if (depth <= depth_map[pixel_idx] * (1.0f + kDepthTolerance)) {
+        ++num_visible_pixels;
+      }
+    });
+
+    if (num_pixels > 0) {
+      if (num_visible_pixels < kMinVisiblePixelRatio * num_pixels) {
+        continue;
+      }
+    } else {
+      const Eigen::Vector2f proj = ProjectPoint(P, centroid);
+      const int px = static_cast<int>(std::floor(proj.x()));
+      const int py = static_cast<int>(std::floor(proj.y()));
+      if (px < 0 || py < 0 || px >= width || py >= height) continue;
+      const float depth = ProjectPointDepth(P, centroid);
+      if (depth > depth_map[static_cast<size_t>(py) * width + px] *
+                      (1.0f + kDepthTolerance)) {
+        continue;
+      }
+    }
+
+    const Eigen::Vector2f e1 = proj_vertices[idx[1]] - proj_vertices[idx[0]];
+    const Eigen::Vector2f e2 = proj_vertices[idx[2]] - proj_vertices[idx[0]];
+    scores[fi * scores_stride] =
+        std::abs(static_cast<double>(e1.x()) * static_cast<double>(e2.y()) -
+                 static_cast<double>(e1.y()) * static_cast<double>(e2.x()));
   }
+}
+
+// Scores the faces in all views by their projected area, where the faces are
+// projected individually and tested for occlusions by ray casting.
+void ScoreFacesByProjection(const PlyMesh& mesh,
+                            const std::vector<Eigen::Vector3f>& face_normals,
+                            const std::vector<Image>& images,
+                            const MeshTextureMappingOptions& options,
+                            std::vector<double>* scores) {
+  const size_t num_faces = mesh.faces.size();
+  const size_t num_images = images.size();
 
 #if defined(COLMAP_CGAL_ENABLED)
   OcclusionTester occlusion_tester;
   occlusion_tester.Build(mesh);
 #endif
 
-  // Flat score buffer: scores[fi * num_images + ii].
-  std::vector<double> scores(num_faces * num_images, -1.0);
-
 #ifdef _OPENMP
   [[maybe_unused]] const int num_threads =
-      options.num_threads > 0
-          ? options.num_threads
-          : std::max(1, static_cast<int>(omp_get_max_threads()));
+      GetEffectiveNumThreads(options.num_threads);
 #pragma omp parallel for schedule(dynamic) num_threads(num_threads)
 #endif
   for (int64_t fi = 0; fi < static_cast<int64_t>(num_faces); ++fi) {
@@ -354,8 +514,38 @@ std::vector<int> SelectViews(const PlyMesh& mesh,
       const double area =
           std::abs(static_cast<double>(e1.x()) * static_cast<double>(e2.y()) -
                    static_cast<double>(e1.y()) * static_cast<double>(e2.x()));
-      scores[fi * num_images + ii] = area;
+      (*scores)[fi * num_images + ii] = area;
+    }
+  }
+}
+
+std::vector<int> SelectViews(const PlyMesh& mesh,
+                             const std::vector<Eigen::Vector3f>& face_normals,
+                             const std::vector<Image>& images,
+                             const FaceAdjacencyMap& adjacency,
+                             const MeshTextureMappingOptions& options) {
+  const size_t num_faces = mesh.faces.size();
+  const size_t num_images = images.size();
+
+  if (num_faces == 0 || num_images == 0) {
+    return std::vector<int>(num_faces, -1);
+  }
+
+  // Flat score buffer: scores[fi * num_images + ii].
+  std::vector<double> scores(num_faces * num_images, -1.0);
+
+  if (options.rasterize_visibility) {
+#ifdef _OPENMP
+    [[maybe_unused]] const int num_threads =
+        GetEffectiveNumThreads(options.num_threads);
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+#endif
+    for (int64_t ii = 0; ii < static_cast<int64_t>(num_images); ++ii) {
+      ScoreFacesByRasterization(
+          mesh, face_normals, images[ii], options, &scores[ii], num_images);
     }
+  } else {
+    ScoreFacesByProjection(mesh, face_normals, images, options, &scores);
   }
 
   std::vector<int> view_per_face(num_faces, -1);
@@ -439,10 +629,14 @@ std::vector<FaceRegion> ExtractFaceRegions(
 std::vector<RegionProjection> ComputeRegionProjections(
     const PlyMesh& mesh,
     const std::vector<FaceRegion>& regions,
-    const std::vector<Image>& images) {
+    const std::vector<Image>& images,
+    const int num_threads) {
   std::vector<RegionProjection> projections(regions.size());
 
-  for (size_t ri = 0; ri < regions.size(); ++ri) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+#endif
+  for (int64_t ri = 0; ri < static_cast<int64_t>(regions.size()); ++ri) {
     const FaceRegion& region = regions[ri];
     const Image& img = images[region.view_id];
     RegionProjection& rp = projections[ri];
@@ -477,9 +671,14 @@ std::vector<RegionProjection> ComputeRegionProjections(
 }
 
 void ScaleRegionProjections(std::vector<RegionProjection>& projections,
-                            const double scale) {
+                            const double scale,
+                            const int num_threads) {
   const float sf = static_cast<float>(scale);
-  for (auto& rp : projections) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+#endif
+  for (int64_t ri = 0; ri < static_cast<int64_t>(projections.size()); ++ri) {
+    RegionProjection& rp = projections[ri];
     for (auto& fp : rp.face_projections) {
       for (auto& p : fp) {
         p *= sf;
@@ -664,7 +863,7 @@ std::array<Eigen::Vector2f, 3> ComputeAtlasVerts(const RegionProjection& rp,
 }
 
 void BakeTexture(Bitmap* atlas,
-                 std::vector<bool>* baked_mask,
+                 std::vector<uint8_t>* baked_mask,
                  const PlyMesh& mesh,
                  const std::vector<FaceRegion>& regions,
                  const std::vector<RegionProjection>& projections,
@@ -674,9 +873,19 @@ void BakeTexture(Bitmap* atlas,
   const int aw = layout.atlas_width;
   const int ah = layout.atlas_height;
 
-  baked_mask->assign(static_cast<size_t>(aw) * ah, false);
+  baked_mask->assign(static_cast<size_t>(aw) * ah, 0);
 
-  for (size_t ri = 0; ri < regions.size(); ++ri) {
+  // The regions are baked in parallel, since the pixels written for a region,
+  // including the 1-pixel border around its faces, lie inside its padded
+  // atlas rectangle and thus never overlap with those of other regions.
+#ifdef _OPENMP
+  [[maybe_unused]] const int num_threads =
+      options.atlas_patch_padding >= 1
+          ? GetEffectiveNumThreads(options.num_threads)
+          : 1;
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+#endif
+  for (int64_t ri = 0; ri < static_cast<int64_t>(regions.size()); ++ri) {
     const FaceRegion& region = regions[ri];
     const RegionProjection& rp = projections[ri];
     const PackRect& placement = layout.placements[ri];
@@ -735,7 +944,7 @@ void BakeTexture(Bitmap* atlas,
           }
 
           atlas->SetPixel(px, py, color->Cast<uint8_t>());
-          (*baked_mask)[static_cast<size_t>(py) * aw + px] = true;
+          (*baked_mask)[static_cast<size_t>(py) * aw + px] = 1;
         }
       }
     }
@@ -751,7 +960,7 @@ void ApplyGlobalColorCorrection(
     const std::vector<Image>& images,
     const FaceAdjacencyMap& adjacency,
     const std::vector<int>& view_per_face,
-    const std::vector<bool>& baked_mask,
+    const std::vector<uint8_t>& baked_mask,
     const MeshTextureMappingOptions& options) {
   struct SeamEdge {
     size_t face_l;
@@ -972,7 +1181,7 @@ void ApplyGlobalColorCorrection(
 }
 
 void InpaintAtlas(Bitmap* atlas,
-                  const std::vector<bool>& baked_mask,
+                  const std::vector<uint8_t>& baked_mask,
                   const int inpaint_radius) {
   const int aw = atlas->Width();
   const int ah = atlas->Height();
@@ -1051,6 +1260,7 @@ void MeshTextureMappingOptions::Print() const {
   PrintOption(min_cos_normal_angle);
   PrintOption(min_visible_vertices);
   PrintOption(view_selection_smoothing_iterations);
+  PrintOption(rasterize_visibility);
   PrintOption(atlas_patch_padding);
   PrintOption(inpaint_radius);
   PrintOption(apply_color_correction);
@@ -1068,9 +1278,10 @@ MeshTextureMappingResult MeshTextureMapping(
   THROW_CHECK(options.Check());
 
 #if !defined(COLMAP_CGAL_ENABLED)
-  LOG(WARNING) << "CGAL is disabled; occlusion testing will be skipped. "
-                  "Some faces may be textured from views where they are "
-                  "occluded by other geometry.";
+  LOG_IF(WARNING, !options.rasterize_visibility)
+      << "CGAL is disabled; occlusion testing will be skipped. "
+         "Some faces may be textured from views where they are "
+         "occluded by other geometry.";
 #endif
 
   MeshTextureMappingResult result;
@@ -1081,6 +1292,8 @@ MeshTextureMappingResult MeshTextureMapping(
     return result;
   }
 
+  const int num_threads = GetEffectiveNumThreads(options.num_threads);
+
   LOG(INFO) << "Computing face normals...";
   const std::vector<Eigen::Vector3f> face_normals = ComputeFaceNormals(mesh);
 
@@ -1111,12 +1324,13 @@ MeshTextureMappingResult MeshTextureMapping(
 
   LOG(INFO) << "Computing region projections...";
   std::vector<RegionProjection> projections =
-      ComputeRegionProjections(mesh, regions, images);
+      ComputeRegionProjections(mesh, regions, images, num_threads);
 
   if (options.texture_scale_factor != 1.0) {
     LOG(INFO) << "Scaling region projections by factor "
               << options.texture_scale_factor << "...";
-    ScaleRegionProjections(projections, options.texture_scale_factor);
+    ScaleRegionProjections(
+        projections, options.texture_scale_factor, num_threads);
   }
 
   LOG(INFO) << "Packing texture atlas...";
@@ -1135,7 +1349,7 @@ MeshTextureMappingResult MeshTextureMapping(
   result.texture_atlas =
       Bitmap(layout.atlas_width, layout.atlas_height, /*as_rgb=*/true);
   result.texture_atlas.Fill(BitmapColor<uint8_t>(0));
-  std::vector<bool> baked_mask;
+  std::vector<uint8_t> baked_mask;
   BakeTexture(&result.texture_atlas,
               &baked_mask,
               mesh,
@@ -51,6 +51,11 @@ struct MeshTextureMappingOptions {
   // Reduces fragmentation by swapping face labels to match neighbors.
   int view_selection_smoothing_iterations = 3;
 
+  // Whether to determine the visibility of faces by rendering per-view depth
+  // buffers of the mesh. This accounts for occlusions without CGAL and is
+  // much faster than projecting and ray casting each face separately.
+  bool rasterize_visibility = true;
+
   // Padding in pixels between atlas patches.
   int atlas_patch_padding = 2;
 
@@ -364,6 +364,50 @@ TEST(MeshTextureMapping, FaceBehindCamera) {
   EXPECT_EQ(result.face_view_ids[0], -1);
 }
 
+TEST(MeshTextureMapping, OccludedFacesRejected) {
+  // Quad at Z=0 that is fully hidden behind a larger quad at Z=1.
+  PlyMesh mesh = MakeTriangleMesh();
+  mesh.vertices.emplace_back(-1.0f, -1.0f, 1.0f);
+  mesh.vertices.emplace_back(2.0f, -1.0f, 1.0f);
+  mesh.vertices.emplace_back(2.0f, 2.0f, 1.0f);
+  mesh.vertices.emplace_back(-1.0f, 2.0f, 1.0f);
+  mesh.faces.emplace_back(4, 5, 6);
+  mesh.faces.emplace_back(4, 6, 7);
+
+  std::vector<Image> images;
+  images.push_back(MakeTestImage(256, 256, BitmapColor<uint8_t>(128)));
+
+  MeshTextureMappingOptions options;
+  options.apply_color_correction = false;
+  options.view_selection_smoothing_iterations = 0;
+  options.inpaint_radius = 0;
+  options.rasterize_visibility = true;
+
+  const auto result = MeshTextureMapping(mesh, images, options);
+  ASSERT_EQ(result.face_view_ids.size(), 4u);
+  EXPECT_EQ(result.face_view_ids[0], -1);
+  EXPECT_EQ(result.face_view_ids[1], -1);
+  EXPECT_EQ(result.face_view_ids[2], 0);
+  EXPECT_EQ(result.face_view_ids[3], 0);
+}
+
+TEST(MeshTextureMapping, RasterizedAndProjectedVisibilityAgree) {
+  const PlyMesh mesh = MakeCubeMesh();
+  std::vector<Image> images;
+  images.push_back(MakeTestImage(256, 256, BitmapColor<uint8_t>(128)));
+
+  MeshTextureMappingOptions options;
+  options.apply_color_correction = false;
+  options.inpaint_radius = 0;
+  options.min_visible_vertices = 1;
+
+  options.rasterize_visibility = true;
+  const auto rasterized_result = MeshTextureMapping(mesh, images, options);
+  options.rasterize_visibility = false;
+  const auto projected_result = MeshTextureMapping(mesh, images, options);
+  EXPECT_EQ(rasterized_result.face_view_ids, projected_result.face_view_ids);
+}
+
 TEST(MeshTextureMapping, GrazingAngleRejected) {
   PlyMesh mesh;
   mesh.vertices = {
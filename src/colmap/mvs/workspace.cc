@@ -32,6 +32,7 @@
 #include "colmap/util/file.h"
 #include "colmap/util/threading.h"
 
+#include <array>
 #include <fstream>
 #include <numeric>
 
@@ -69,13 +70,12 @@ void Workspace::Load(const std::vector<std::string>& image_names) {
     const size_t width = model_.images.at(image_idx).GetWidth();
     const size_t height = model_.images.at(image_idx).GetHeight();
 
-    // Read and rescale bitmap
+    // Read bitmap at the (potentially reduced) resolution of the model.
     auto bitmap = std::make_unique<Bitmap>();
-    bitmap->Read(GetBitmapPath(image_idx), options_.image_as_rgb);
-    if (bitmap->Width() != static_cast<int>(width) ||
-        bitmap->Height() != static_cast<int>(height)) {
-      bitmap->Rescale(static_cast<int>(width), static_cast<int>(height));
-    }
+    bitmap->ReadRescaled(GetBitmapPath(image_idx),
+                         static_cast<int>(width),
+                         static_cast<int>(height),
+                         options_.image_as_rgb);
     bitmaps_[image_idx] = std::move(bitmap);
 
     // Read and rescale depth map
@@ -152,15 +152,16 @@ bool Workspace::HasNormalMap(const int image_idx) const {
   return ExistsFile(GetNormalMapPath(image_idx));
 }
 
-CachedWorkspace::CachedImage::CachedImage(CachedImage&& other) noexcept {
+CachedWorkspace::CachedComponent::CachedComponent(
+    CachedComponent&& other) noexcept {
   num_bytes = other.num_bytes;
   bitmap = std::move(other.bitmap);
   depth_map = std::move(other.depth_map);
   normal_map = std::move(other.normal_map);
 }
 
-CachedWorkspace::CachedImage& CachedWorkspace::CachedImage::operator=(
-    CachedImage&& other) noexcept {
+CachedWorkspace::CachedComponent& CachedWorkspace::CachedComponent::operator=(
+    CachedComponent&& other) noexcept {
   if (this != &other) {
     num_bytes = other.num_bytes;
     bitmap = std::move(other.bitmap);
@@ -173,80 +174,307 @@ CachedWorkspace::CachedImage& CachedWorkspace::CachedImage::operator=(
 CachedWorkspace::CachedWorkspace(const Options& options)
     : Workspace(options),
       cache_((size_t)(1024.0 * 1024.0 * 1024.0 * options.cache_size),
-             [](const int) { return std::make_shared<CachedImage>(); }) {}
+             [](const int64_t) { return std::make_shared<CachedComponent>(); }),
+      prefetch_thread_pool_(std::make_unique<ThreadPool>(
+          GetEffectiveNumThreads(options.num_threads))) {
+  metric_fns_.push_back(std::make_unique<ScopedMetricFn>(
+      "colmap_workspace_cache_hits_total", MetricType::kCounter, [this]() {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        return cache_.NumHits();
+      }));
+  metric_fns_.push_back(std::make_unique<ScopedMetricFn>(
+      "colmap_workspace_cache_misses_total", MetricType::kCounter, [this]() {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        return cache_.NumMisses();
+      }));
+  metric_fns_.push_back(std::make_unique<ScopedMetricFn>(
+      "colmap_workspace_cache_bytes", MetricType::kGauge, [this]() {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        return cache_.NumBytes();
+      }));
+
+  if (options.spill_cache_path.empty() || options.spill_cache_size <= 0) {
+    return;
+  }
+  spill_cache_ = std::make_unique<FileSpillCache<int64_t, CachedComponent>>(
+      options.spill_cache_path,
+      (size_t)(1024.0 * 1024.0 * 1024.0 * options.spill_cache_size),
+      WriteSpilledComponent,
+      ReadSpilledComponent);
+  cache_.SetEvictFn([this](const int64_t key,
+                           const std::shared_ptr<CachedComponent>& component) {
+    evicted_components_.emplace_back(key, component);
+  });
+}
 
-const Bitmap& CachedWorkspace::GetBitmap(const int image_idx) {
-  std::shared_ptr<CachedImage> cached_image;
+void CachedWorkspace::Prefetch(const std::vector<int>& image_idxs) {
+  for (const int image_idx : image_idxs) {
+    prefetch_thread_pool_->AddTask([this, image_idx]() {
+      // Exceptions would otherwise surface in unrelated calls to the pool.
+      try {
+        if (HasBitmap(image_idx)) {
+          GetBitmap(image_idx);
+        }
+        if (HasDepthMap(image_idx)) {
+          GetDepthMap(image_idx);
+        }
+        if (HasNormalMap(image_idx)) {
+          GetNormalMap(image_idx);
+        }
+      } catch (const std::exception& e) {
+        LOG(WARNING) << "Failed to prefetch image " << image_idx << ": "
+                     << e.what();
+      }
+    });
+  }
+}
+
+void CachedWorkspace::Evict(const std::vector<int>& image_idxs) {
+  std::lock_guard<std::mutex> cache_lock(cache_mutex_);
+  for (const int image_idx : image_idxs) {
+    cache_.Evict(CacheKey(image_idx, Component::kBitmap));
+    cache_.Evict(CacheKey(image_idx, Component::kDepthMap));
+    cache_.Evict(CacheKey(image_idx, Component::kNormalMap));
+  }
+}
+
+void CachedWorkspace::WriteSpilledComponent(
+    const CachedComponent& cached_component, std::ostream* stream) {
+  const auto WriteMat = [stream](const Mat<float>& mat) {
+    const std::array<uint64_t, 3> shape = {
+        mat.GetWidth(), mat.GetHeight(), mat.GetDepth()};
+    stream->write(reinterpret_cast<const char*>(shape.data()), sizeof(shape));
+    stream->write(reinterpret_cast<const char*>(mat.GetPtr()),
+                  mat.GetData().size() * sizeof(float));
+  };
+
+  if (cached_component.bitmap) {
+    const Bitmap& bitmap = *cached_component.bitmap;
+    const std::array<int32_t, 4> header = {
+        static_cast<int32_t>(Component::kBitmap),
+        bitmap.Width(),
+        bitmap.Height(),
+        bitmap.IsRGB()};
+    stream->write(reinterpret_cast<const char*>(header.data()),
+                  sizeof(header));
+    stream->write(reinterpret_cast<const char*>(bitmap.RowMajorData().data()),
+                  bitmap.RowMajorData().size());
+  } else if (cached_component.depth_map) {
+    const DepthMap& depth_map = *cached_component.depth_map;
+    const int32_t type = static_cast<int32_t>(Component::kDepthMap);
+    const std::array<float, 2> depth_range = {depth_map.GetDepthMin(),
+                                              depth_map.GetDepthMax()};
+    stream->write(reinterpret_cast<const char*>(&type), sizeof(type));
+    stream->write(reinterpret_cast<const char*>(depth_range.data()),
+                  sizeof(depth_range));
+    WriteMat(depth_map);
+  } else if (cached_component.normal_map) {
+    const int32_t type = static_cast<int32_t>(Component::kNormalMap);
+    stream->write(reinterpret_cast<const char*>(&type), sizeof(type));
+    WriteMat(*cached_component.normal_map);
+  }
+}
+
+std::shared_ptr<CachedWorkspace::CachedComponent>
+CachedWorkspace::ReadSpilledComponent(std::istream* stream) {
+  const auto ReadMat = [stream](const auto& create_mat) {
+    std::array<uint64_t, 3> shape;
+    stream->read(reinterpret_cast<char*>(shape.data()), sizeof(shape));
+    THROW_CHECK(stream->good()) << "Failed to read spilled component";
+    auto mat = create_mat(shape[0], shape[1]);
+    THROW_CHECK_EQ(mat->GetDepth(), shape[2]);
+    stream->read(reinterpret_cast<char*>(mat->GetPtr()),
+                 mat->GetData().size() * sizeof(float));
+    return mat;
+  };
+
+  auto cached_component = std::make_shared<CachedComponent>();
+  int32_t type = -1;
+  stream->read(reinterpret_cast<char*>(&type), sizeof(type));
+  switch (static_cast<Component>(type)) {
+    case Component::kBitmap: {
+      std::array<int32_t, 3> header;
+      stream->read(reinterpret_cast<char*>(header.data()), sizeof(header));
+      THROW_CHECK(stream->good()) << "Failed to read spilled component";
+      auto bitmap =
+          std::make_unique<Bitmap>(header[0], header[1], header[2] != 0);
+      std::vector<uint8_t>& data = bitmap->RowMajorData();
+      stream->read(reinterpret_cast<char*>(data.data()), data.size());
+      cached_component->num_bytes = bitmap->NumBytes();
+      cached_component->bitmap = std::move(bitmap);
+      break;
+    }
+    case Component::kDepthMap: {
+      std::array<float, 2> depth_range;
+      stream->read(reinterpret_cast<char*>(depth_range.data()),
+                   sizeof(depth_range));
+      cached_component->depth_map =
+          ReadMat([&depth_range](const size_t width, const size_t height) {
+            return std::make_unique<DepthMap>(
+                width, height, depth_range[0], depth_range[1]);
+          });
+      cached_component->num_bytes =
+          cached_component->depth_map->GetNumBytes();
+      break;
+    }
+    case Component::kNormalMap: {
+      cached_component->normal_map =
+          ReadMat([](const size_t width, const size_t height) {
+            return std::make_unique<NormalMap>(width, height);
+          });
+      cached_component->num_bytes =
+          cached_component->normal_map->GetNumBytes();
+      break;
+    }
+    default:
+      LOG(FATAL_THROW) << "Invalid spilled component type: " << type;
+  }
+  THROW_CHECK(stream->good()) << "Failed to read spilled component";
+  return cached_component;
+}
+
+int64_t CachedWorkspace::CacheKey(const int image_idx,
+                                  const Component component) {
+  return 3 * static_cast<int64_t>(image_idx) + static_cast<int64_t>(component);
+}
+
+std::shared_ptr<CachedWorkspace::CachedComponent>
+CachedWorkspace::GetCachedComponent(const int image_idx,
+                                    const Component component) {
+  std::shared_ptr<CachedComponent> cached_component;
   {
     std::lock_guard<std::mutex> cache_lock(cache_mutex_);
-    cached_image = cache_.Get(image_idx);
+    cached_component = cache_.Get(CacheKey(image_idx, component));
   }
-  std::lock_guard<std::mutex> lock(cached_image->mutex);
-  if (!cached_image->bitmap) {
-    cached_image->bitmap = std::make_unique<Bitmap>();
-    cached_image->bitmap->Read(GetBitmapPath(image_idx), options_.image_as_rgb);
-    if (options_.max_image_size > 0) {
-      cached_image->bitmap->Rescale(model_.images.at(image_idx).GetWidth(),
-                                    model_.images.at(image_idx).GetHeight());
-    }
-    cached_image->num_bytes += cached_image->bitmap->NumBytes();
+  SpillEvictedComponents();
+  return cached_component;
+}
+
+void CachedWorkspace::UpdateNumBytes(const int image_idx,
+                                     const Component component,
+                                     CachedComponent* cached_component,
+                                     const size_t num_bytes) {
+  const int64_t key = CacheKey(image_idx, component);
+  cached_component->num_bytes = num_bytes;
+  {
     std::lock_guard<std::mutex> cache_lock(cache_mutex_);
-    // Handle the case where another thread has already evicted the image.
-    if (cache_.Exists(image_idx)) {
-      cache_.UpdateNumBytes(image_idx);
+    // Handle the case where another thread has already evicted the component.
+    if (cache_.Exists(key)) {
+      cache_.UpdateNumBytes(key);
     }
   }
-  return *cached_image->bitmap;
+  SpillEvictedComponents();
 }
 
-const DepthMap& CachedWorkspace::GetDepthMap(const int image_idx) {
-  std::shared_ptr<CachedImage> cached_image;
+bool CachedWorkspace::LoadSpilledComponent(const int image_idx,
+                                           const Component component,
+                                           CachedComponent* cached_component) {
+  if (!spill_cache_) {
+    return false;
+  }
+  std::shared_ptr<CachedComponent> spilled_component =
+      spill_cache_->Get(CacheKey(image_idx, component));
+  if (!spilled_component) {
+    return false;
+  }
+  const size_t num_bytes = spilled_component->num_bytes;
+  *cached_component = std::move(*spilled_component);
+  UpdateNumBytes(image_idx, component, cached_component, num_bytes);
+  return true;
+}
+
+void CachedWorkspace::SpillEvictedComponents() {
+  if (!spill_cache_) {
+    return;
+  }
+
+  std::vector<std::pair<int64_t, std::shared_ptr<CachedComponent>>>
+      evicted_components;
   {
     std::lock_guard<std::mutex> cache_lock(cache_mutex_);
-    cached_image = cache_.Get(image_idx);
+    evicted_components.swap(evicted_components_);
+  }
+
+  for (const auto& [key, cached_component] : evicted_components) {
+    // Components that are locked by another thread are still being loaded or
+    // that thread is itself spilling and waiting for the component, which
+    // would deadlock. Such components are not spilled.
+    std::unique_lock<std::mutex> lock(cached_component->mutex,
+                                      std::try_to_lock);
+    if (lock.owns_lock() && cached_component->num_bytes > 0) {
+      spill_cache_->Put(key, *cached_component);
+    }
   }
-  std::lock_guard<std::mutex> lock(cached_image->mutex);
-  if (!cached_image->depth_map) {
-    cached_image->depth_map = std::make_unique<DepthMap>();
-    cached_image->depth_map->Read(GetDepthMapPath(image_idx));
+}
+
+const Bitmap& CachedWorkspace::GetBitmap(const int image_idx) {
+  std::shared_ptr<CachedComponent> cached_component =
+      GetCachedComponent(image_idx, Component::kBitmap);
+  std::lock_guard<std::mutex> lock(cached_component->mutex);
+  if (!cached_component->bitmap &&
+      !LoadSpilledComponent(
+          image_idx, Component::kBitmap, cached_component.get())) {
+    cached_component->bitmap = std::make_unique<Bitmap>();
     if (options_.max_image_size > 0) {
-      cached_image->depth_map->Downsize(
+      cached_component->bitmap->ReadRescaled(
+          GetBitmapPath(image_idx),
           model_.images.at(image_idx).GetWidth(),
-          model_.images.at(image_idx).GetHeight());
+          model_.images.at(image_idx).GetHeight(),
+          options_.image_as_rgb);
+    } else {
+      cached_component->bitmap->Read(GetBitmapPath(image_idx),
+                                     options_.image_as_rgb);
     }
-    cached_image->num_bytes += cached_image->depth_map->GetNumBytes();
-    std::lock_guard<std::mutex> cache_lock(cache_mutex_);
-    // Handle the case where another thread has already evicted the image.
-    if (cache_.Exists(image_idx)) {
-      cache_.UpdateNumBytes(image_idx);
+    UpdateNumBytes(image_idx,
+                   Component::kBitmap,
+                   cached_component.get(),
+                   cached_component->bitmap->NumBytes());
+  }
+  return *cached_component->bitmap;
+}
+
+const DepthMap& CachedWorkspace::GetDepthMap(const int image_idx) {
+  std::shared_ptr<CachedComponent> cached_component =
+      GetCachedComponent(image_idx, Component::kDepthMap);
+  std::lock_guard<std::mutex> lock(cached_component->mutex);
+  if (!cached_component->depth_map &&
+      !LoadSpilledComponent(
+          image_idx, Component::kDepthMap, cached_component.get())) {
+    cached_component->depth_map = std::make_unique<DepthMap>();
+    cached_component->depth_map->Read(GetDepthMapPath(image_idx));
+    if (options_.max_image_size > 0) {
+      cached_component->depth_map->Downsize(
+          model_.images.at(image_idx).GetWidth(),
+          model_.images.at(image_idx).GetHeight());
     }
+    UpdateNumBytes(image_idx,
+                   Component::kDepthMap,
+                   cached_component.get(),
+                   cached_component->depth_map->GetNumBytes());
   }
-  return *cached_image->depth_map;
+  return *cached_component->depth_map;
 }
 
 const NormalMap& CachedWorkspace::GetNormalMap(const int image_idx) {
-  std::shared_ptr<CachedImage> cached_image;
-  {
-    std::lock_guard<std::mutex> cache_lock(cache_mutex_);
-    cached_image = cache_.Get(image_idx);
-  }
-  std::lock_guard<std::mutex> lock(cached_image->mutex);
-  if (!cached_image->normal_map) {
-    cached_image->normal_map = std::make_unique<NormalMap>();
-    cached_image->normal_map->Read(GetNormalMapPath(image_idx));
+  std::shared_ptr<CachedComponent> cached_component =
+      GetCachedComponent(image_idx, Component::kNormalMap);
+  std::lock_guard<std::mutex> lock(cached_component->mutex);
+  if (!cached_component->normal_map &&
+      !LoadSpilledComponent(
+          image_idx, Component::kNormalMap, cached_component.get())) {
+    cached_component->normal_map = std::make_unique<NormalMap>();
+    cached_component->normal_map->Read(GetNormalMapPath(image_idx));
     if (options_.max_image_size > 0) {
-      cached_image->normal_map->Downsize(
+      cached_component->normal_map->Downsize(
           model_.images.at(image_idx).GetWidth(),
           model_.images.at(image_idx).GetHeight());
     }
-    cached_image->num_bytes += cached_image->normal_map->GetNumBytes();
-    std::lock_guard<std::mutex> cache_lock(cache_mutex_);
-    // Handle the case where another thread has already evicted the image.
-    if (cache_.Exists(image_idx)) {
-      cache_.UpdateNumBytes(image_idx);
-    }
+    UpdateNumBytes(image_idx,
+                   Component::kNormalMap,
+                   cached_component.get(),
+                   cached_component->normal_map->GetNumBytes());
   }
-  return *cached_image->normal_map;
+  return *cached_component->normal_map;
 }
 
 void ImportPMVSWorkspace(const Workspace& workspace,
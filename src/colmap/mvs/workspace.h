@@ -35,6 +35,8 @@
 #include "colmap/mvs/normal_map.h"
 #include "colmap/sensor/bitmap.h"
 #include "colmap/util/cache.h"
+#include "colmap/util/metrics.h"
+#include "colmap/util/threading.h"
 #include "colmap/util/types.h"
 
 #include <filesystem>
@@ -50,6 +52,13 @@ class Workspace {
     // The maximum cache size in gigabytes.
     double cache_size = 32.0;
 
+    // Optional directory, e.g., on a local SSD, into which the cached data
+    // evicted from memory is spilled, up to spill_cache_size gigabytes. Later
+    // cache misses are then served from the spilled files instead of the
+    // workspace, which avoids repeated reads from slow storage.
+    std::filesystem::path spill_cache_path;
+    double spill_cache_size = 64.0;
+
     // The number of threads to use when pre-loading workspace.
     int num_threads = -1;
 
@@ -72,6 +81,16 @@ class Workspace {
   // Do nothing when we use a cache. Data is loaded as needed.
   virtual void Load(const std::vector<std::string>& image_names);
 
+  // Asynchronously load the data of the given images, e.g., the images
+  // overlapping with the image processed next. Do nothing without a cache,
+  // since all data is loaded upfront.
+  virtual void Prefetch(const std::vector<int>& image_idxs) {}
+
+  // Release the data of the given images, e.g., once they are no longer
+  // needed, which invalidates any references to it. Do nothing without a
+  // cache, since all data is loaded upfront.
+  virtual void Evict(const std::vector<int>& image_idxs) {}
+
   inline const Options& GetOptions() const { return options_; }
 
   inline const Model& GetModel() const { return model_; }
@@ -104,12 +123,22 @@ class Workspace {
   std::vector<std::unique_ptr<NormalMap>> normal_maps_;
 };
 
+// Workspace that loads data as needed and caches it up to `cache_size`. The
+// bitmap, depth map, and normal map of an image are cached and evicted
+// independently according to their actual size in memory. If a spill cache
+// path is set, the data evicted to fit into the cache is spilled into files.
 class CachedWorkspace : public Workspace {
  public:
   explicit CachedWorkspace(const Options& options);
 
   void Load(const std::vector<std::string>& image_names) override {}
 
+  // Load the data of the given images into the cache on background threads.
+  void Prefetch(const std::vector<int>& image_idxs) override;
+
+  // Evict the data of the given images from the cache.
+  void Evict(const std::vector<int>& image_idxs) override;
+
   inline void ClearCache() { cache_.Clear(); }
 
   const Bitmap& GetBitmap(int image_idx) override;
@@ -117,11 +146,18 @@ class CachedWorkspace : public Workspace {
   const NormalMap& GetNormalMap(int image_idx) override;
 
  private:
-  class CachedImage {
+  enum class Component {
+    kBitmap = 0,
+    kDepthMap = 1,
+    kNormalMap = 2,
+  };
+
+  // One component of an image, of which only the respective member is set.
+  class CachedComponent {
    public:
-    CachedImage() {}
-    CachedImage(CachedImage&& other) noexcept;
-    CachedImage& operator=(CachedImage&& other) noexcept;
+    CachedComponent() {}
+    CachedComponent(CachedComponent&& other) noexcept;
+    CachedComponent& operator=(CachedComponent&& other) noexcept;
     inline size_t NumBytes() const { return num_bytes; }
     size_t num_bytes = 0;
     std::mutex mutex;
@@ -130,11 +166,39 @@ class CachedWorkspace : public Workspace {
     std::unique_ptr<NormalMap> normal_map;
 
    private:
-    NON_COPYABLE(CachedImage)
+    NON_COPYABLE(CachedComponent)
   };
 
+  static void WriteSpilledComponent(const CachedComponent& cached_component,
+                                    std::ostream* stream);
+  static std::shared_ptr<CachedComponent> ReadSpilledComponent(
+      std::istream* stream);
+
+  static int64_t CacheKey(int image_idx, Component component);
+  std::shared_ptr<CachedComponent> GetCachedComponent(int image_idx,
+                                                      Component component);
+  void UpdateNumBytes(int image_idx,
+                      Component component,
+                      CachedComponent* cached_component,
+                      size_t num_bytes);
+
+  // Loads the component from the spill cache, if it was spilled before.
+  bool LoadSpilledComponent(int image_idx,
+                            Component component,
+                            CachedComponent* cached_component);
+  // Writes the components evicted from the cache into the spill cache. Must be
+  // called without the cache lock.
+  void SpillEvictedComponents();
+
   std::mutex cache_mutex_;
-  MemoryConstrainedLRUCache<int, CachedImage> cache_;
+  MemoryConstrainedLRUCache<int64_t, CachedComponent> cache_;
+  std::unique_ptr<FileSpillCache<int64_t, CachedComponent>> spill_cache_;
+  // Components evicted from the cache that are not yet spilled.
+  std::vector<std::pair<int64_t, std::shared_ptr<CachedComponent>>>
+      evicted_components_;
+  // Destroyed first, so that pending prefetches finish before the cache.
+  std::unique_ptr<ThreadPool> prefetch_thread_pool_;
+  std::vector<std::unique_ptr<ScopedMetricFn>> metric_fns_;
 };
 
 // Import a PMVS workspace into the COLMAP workspace format. Only images in the
@@ -129,6 +129,60 @@ TEST_P(ParameterizedWorkspaceTests, MaxImageSize) {
   EXPECT_EQ(workspace->GetNormalMap(0).GetHeight(), 2);
 }
 
+TEST_P(ParameterizedWorkspaceTests, Prefetch) {
+  auto workspace = GetParam()(GetOptions());
+  workspace->Load({image_name_});
+  workspace->Prefetch({0});
+  EXPECT_FALSE(workspace->GetBitmap(0).IsEmpty());
+  EXPECT_GT(workspace->GetDepthMap(0).GetNumBytes(), 0);
+  EXPECT_GT(workspace->GetNormalMap(0).GetNumBytes(), 0);
+}
+
+TEST_P(ParameterizedWorkspaceTests, Evict) {
+  auto workspace = GetParam()(GetOptions());
+  workspace->Load({image_name_});
+  EXPECT_EQ(workspace->GetDepthMap(0).Get(2, 3), 1.0f);
+  workspace->Evict({0});
+  // Evicted data is read again on access.
+  EXPECT_FALSE(workspace->GetBitmap(0).IsEmpty());
+  EXPECT_EQ(workspace->GetDepthMap(0).Get(2, 3), 1.0f);
+  EXPECT_GT(workspace->GetNormalMap(0).GetNumBytes(), 0);
+}
+
+TEST_P(ParameterizedWorkspaceTests, CompressedMaps) {
+  MatCompressionOptions compression_options;
+  Mat<float> depth_map(10, 5, 1);
+  depth_map.Fill(2.0f);
+  depth_map.WriteCompressed(temp_dir_ / "stereo" / "depth_maps" /
+                                (image_name_ + ".geometric.bin"),
+                            compression_options);
+  auto workspace = GetParam()(GetOptions());
+  workspace->Load({image_name_});
+  EXPECT_EQ(workspace->GetDepthMap(0).GetWidth(), 10);
+  EXPECT_EQ(workspace->GetDepthMap(0).GetHeight(), 5);
+  EXPECT_EQ(workspace->GetDepthMap(0).Get(2, 3), 2.0f);
+}
+
+TEST_P(ParameterizedWorkspaceTests, SpillCache) {
+  Workspace::Options options = GetOptions();
+  // Only fits a single component, so that every access evicts the previous.
+  options.cache_size = 1e-9;
+  options.spill_cache_path = temp_dir_ / "spill";
+  auto workspace = GetParam()(options);
+  workspace->Load({image_name_});
+  EXPECT_EQ(workspace->GetBitmap(0).Width(), 10);
+  EXPECT_EQ(workspace->GetDepthMap(0).Get(2, 3), 1.0f);
+  EXPECT_EQ(workspace->GetNormalMap(0).Get(2, 3, 2), 1.0f);
+
+  // The evicted data is served from the spill cache.
+  std::filesystem::remove(workspace->GetBitmapPath(0));
+  std::filesystem::remove(workspace->GetDepthMapPath(0));
+  EXPECT_EQ(workspace->GetBitmap(0).Width(), 10);
+  EXPECT_EQ(workspace->GetBitmap(0).Height(), 5);
+  EXPECT_EQ(workspace->GetDepthMap(0).Get(2, 3), 1.0f);
+  EXPECT_EQ(workspace->GetNormalMap(0).Get(2, 3, 2), 1.0f);
+}
+
 TEST_P(ParameterizedWorkspaceTests, Load) {
   auto workspace = GetParam()(GetOptions());
   workspace->Load({image_name_});
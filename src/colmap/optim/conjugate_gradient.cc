@@ -0,0 +1,123 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/optim/conjugate_gradient.h"
+
+#include "colmap/util/logging.h"
+
+namespace colmap {
+
+bool NormalEquationsCGSolver::Options::Check() const {
+  CHECK_OPTION_GT(max_num_iterations, 0);
+  CHECK_OPTION_GE(tolerance, 0);
+  CHECK_OPTION_GE(ridge_regularization, 0);
+  return true;
+}
+
+NormalEquationsCGSolver::NormalEquationsCGSolver(
+    const Options& options, const Eigen::SparseMatrix<double>& A)
+    : options_(options), A_(A), At_(A.transpose()) {
+  THROW_CHECK(options_.Check());
+  SetWeights(Eigen::VectorXd::Ones(A_.rows()));
+}
+
+void NormalEquationsCGSolver::SetWeights(const Eigen::VectorXd& weights) {
+  THROW_CHECK_EQ(weights.size(), A_.rows());
+  weights_ = weights;
+
+  // Jacobi preconditioner from the diagonal of A^T W A. Each row of A^T holds
+  // the entries of a column of A.
+  inv_diagonal_.resize(At_.rows());
+  for (int col = 0; col < At_.outerSize(); ++col) {
+    double diagonal = options_.ridge_regularization;
+    for (RowMajorMatrix::InnerIterator it(At_, col); it; ++it) {
+      diagonal += weights_[it.col()] * it.value() * it.value();
+    }
+    inv_diagonal_[col] = diagonal > 0 ? 1 / diagonal : 1;
+  }
+}
+
+Eigen::VectorXd NormalEquationsCGSolver::ApplyNormalEquations(
+    const Eigen::VectorXd& x) const {
+  const Eigen::VectorXd weighted_Ax = weights_.cwiseProduct(A_ * x);
+  Eigen::VectorXd AtWAx = At_ * weighted_Ax;
+  if (options_.ridge_regularization > 0) {
+    AtWAx += options_.ridge_regularization * x;
+  }
+  return AtWAx;
+}
+
+bool NormalEquationsCGSolver::Solve(const Eigen::VectorXd& rhs,
+                                    Eigen::VectorXd* x) const {
+  THROW_CHECK_NOTNULL(x);
+  THROW_CHECK_EQ(rhs.size(), A_.cols());
+  num_iterations_ = 0;
+
+  if (x->size() != A_.cols()) {
+    x->setZero(A_.cols());
+  }
+
+  const double rhs_norm = rhs.norm();
+  if (rhs_norm == 0) {
+    x->setZero();
+    return true;
+  }
+  const double max_residual_norm = options_.tolerance * rhs_norm;
+
+  Eigen::VectorXd residual = rhs - ApplyNormalEquations(*x);
+  Eigen::VectorXd preconditioned = inv_diagonal_.cwiseProduct(residual);
+  Eigen::VectorXd direction = preconditioned;
+  double residual_dot = residual.dot(preconditioned);
+
+  for (; num_iterations_ < options_.max_num_iterations; ++num_iterations_) {
+    if (residual.norm() <= max_residual_norm) {
+      break;
+    }
+
+    const Eigen::VectorXd AtWA_direction = ApplyNormalEquations(direction);
+    const double curvature = direction.dot(AtWA_direction);
+    if (!(curvature > 0)) {
+      VLOG(2) << "Conjugate gradients broke down with non-positive curvature";
+      return false;
+    }
+
+    const double alpha = residual_dot / curvature;
+    *x += alpha * direction;
+    residual -= alpha * AtWA_direction;
+
+    preconditioned = inv_diagonal_.cwiseProduct(residual);
+    const double prev_residual_dot = residual_dot;
+    residual_dot = residual.dot(preconditioned);
+    direction = preconditioned + (residual_dot / prev_residual_dot) * direction;
+  }
+
+  return x->allFinite();
+}
+
+}  // namespace colmap
@@ -0,0 +1,91 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+namespace colmap {
+
+// Iterative solver for the (weighted) normal equations
+//
+//        (A^T W A + lambda I) x = rhs
+//
+// using conjugate gradients with a Jacobi preconditioner. The normal equations
+// are never formed explicitly, such that the sparsity pattern of A is reused
+// across solves with changing weights, e.g., in iteratively reweighted least
+// squares. The sparse matrix-vector products are multi-threaded if Eigen is
+// compiled with OpenMP support.
+class NormalEquationsCGSolver {
+ public:
+  struct Options {
+    // Maximum number of conjugate gradient iterations per solve.
+    int max_num_iterations = 500;
+
+    // Terminate once the residual norm falls below this fraction of the
+    // norm of the right-hand side.
+    double tolerance = 1e-10;
+
+    // Tikhonov ridge lambda added to the diagonal of the normal equations.
+    double ridge_regularization = 0;
+
+    bool Check() const;
+  };
+
+  NormalEquationsCGSolver(const Options& options,
+                          const Eigen::SparseMatrix<double>& A);
+
+  // Set the diagonal weights W of the residuals. All weights are one by
+  // default.
+  void SetWeights(const Eigen::VectorXd& weights);
+
+  // Solve the normal equations for the given right-hand side. The given value
+  // of x is used as the initial guess. Returns false if the iterations broke
+  // down, e.g., because the normal equations are not positive definite.
+  bool Solve(const Eigen::VectorXd& rhs, Eigen::VectorXd* x) const;
+
+  // Number of iterations of the last solve.
+  int NumIterations() const { return num_iterations_; }
+
+ private:
+  using RowMajorMatrix = Eigen::SparseMatrix<double, Eigen::RowMajor>;
+
+  Eigen::VectorXd ApplyNormalEquations(const Eigen::VectorXd& x) const;
+
+  const Options options_;
+  // Row-major copies of A and its transpose for multi-threaded products.
+  const RowMajorMatrix A_;
+  const RowMajorMatrix At_;
+  Eigen::VectorXd weights_;
+  Eigen::VectorXd inv_diagonal_;
+  mutable int num_iterations_ = 0;
+};
+
+}  // namespace colmap
@@ -0,0 +1,125 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/optim/conjugate_gradient.h"
+
+#include "colmap/util/eigen_matchers.h"
+
+#include <Eigen/SparseCholesky>
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+// Incidence matrix of a chain of n nodes with an additional row pinning the
+// first node, similar to the constraint matrix of rotation averaging.
+Eigen::SparseMatrix<double> ChainIncidenceGaugeFixed(int n) {
+  Eigen::SparseMatrix<double> A(n, n);
+  std::vector<Eigen::Triplet<double>> triplets;
+  for (int i = 0; i < n - 1; ++i) {
+    triplets.emplace_back(i, i, -1);
+    triplets.emplace_back(i, i + 1, 1);
+  }
+  triplets.emplace_back(n - 1, 0, 1);
+  A.setFromTriplets(triplets.begin(), triplets.end());
+  return A;
+}
+
+TEST(NormalEquationsCGSolver, Diagonal) {
+  Eigen::SparseMatrix<double> A(3, 3);
+  A.insert(0, 0) = 1;
+  A.insert(1, 1) = 2;
+  A.insert(2, 2) = 3;
+
+  NormalEquationsCGSolver solver(NormalEquationsCGSolver::Options(), A);
+  Eigen::VectorXd x = Eigen::VectorXd::Zero(3);
+  ASSERT_TRUE(solver.Solve(Eigen::Vector3d(1, 8, 27), &x));
+  EXPECT_THAT(x, EigenMatrixNear(Eigen::Vector3d(1, 2, 3), 1e-8));
+  // The Jacobi preconditioner solves diagonal systems in a single iteration.
+  EXPECT_EQ(solver.NumIterations(), 1);
+}
+
+TEST(NormalEquationsCGSolver, WeightedChainMatchesCholesky) {
+  const int n = 100;
+  const Eigen::SparseMatrix<double> A = ChainIncidenceGaugeFixed(n);
+  Eigen::VectorXd weights(n);
+  Eigen::VectorXd b(n);
+  for (int i = 0; i < n; ++i) {
+    weights[i] = 1 + i % 3;
+    b[i] = std::sin(i);
+  }
+
+  NormalEquationsCGSolver::Options options;
+  options.ridge_regularization = 1e-9;
+  NormalEquationsCGSolver solver(options, A);
+  solver.SetWeights(weights);
+  const Eigen::VectorXd rhs = A.transpose() * weights.cwiseProduct(b);
+  Eigen::VectorXd x = Eigen::VectorXd::Zero(n);
+  ASSERT_TRUE(solver.Solve(rhs, &x));
+
+  Eigen::SparseMatrix<double> AtWA =
+      Eigen::SparseMatrix<double>(A.transpose() * weights.asDiagonal() * A);
+  for (int i = 0; i < n; ++i) {
+    AtWA.coeffRef(i, i) += options.ridge_regularization;
+  }
+  Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> ldlt(AtWA);
+  ASSERT_EQ(ldlt.info(), Eigen::Success);
+  const Eigen::VectorXd expected_x = ldlt.solve(rhs);
+  EXPECT_THAT(x, EigenMatrixNear(expected_x, 1e-6));
+}
+
+TEST(NormalEquationsCGSolver, WarmStart) {
+  const int n = 100;
+  const Eigen::SparseMatrix<double> A = ChainIncidenceGaugeFixed(n);
+  const Eigen::VectorXd rhs = A.transpose() * Eigen::VectorXd::Ones(n);
+
+  NormalEquationsCGSolver::Options options;
+  options.tolerance = 1e-12;
+  NormalEquationsCGSolver accurate_solver(options, A);
+  Eigen::VectorXd x = Eigen::VectorXd::Zero(n);
+  ASSERT_TRUE(accurate_solver.Solve(rhs, &x));
+  EXPECT_GT(accurate_solver.NumIterations(), 1);
+
+  // Starting from the solution requires no further iterations.
+  options.tolerance = 1e-8;
+  NormalEquationsCGSolver solver(options, A);
+  ASSERT_TRUE(solver.Solve(rhs, &x));
+  EXPECT_EQ(solver.NumIterations(), 0);
+}
+
+TEST(NormalEquationsCGSolver, ZeroRightHandSide) {
+  const Eigen::SparseMatrix<double> A = ChainIncidenceGaugeFixed(10);
+  NormalEquationsCGSolver solver(NormalEquationsCGSolver::Options(), A);
+  Eigen::VectorXd x = Eigen::VectorXd::Ones(10);
+  ASSERT_TRUE(solver.Solve(Eigen::VectorXd::Zero(10), &x));
+  EXPECT_EQ(x, Eigen::VectorXd::Zero(10));
+}
+
+}  // namespace
+}  // namespace colmap
@@ -29,6 +29,7 @@
 
 #include "colmap/optim/least_absolute_deviations.h"
 
+#include "colmap/optim/conjugate_gradient.h"
 #include "colmap/optim/sparse_cholesky.h"
 #include "colmap/util/eigen_alignment.h"
 #include "colmap/util/logging.h"
@@ -88,8 +89,11 @@ struct SimplicialLLTLinearSolver
 
 struct SupernodalCholmodLLTLinearSolver
     : public LeastAbsoluteDeviationLinearSolverImpl {
-  explicit SupernodalCholmodLLTLinearSolver(double ridge_regularization)
-      : ridge_regularization_(ridge_regularization) {}
+  SupernodalCholmodLLTLinearSolver(
+      const SparseCholeskyOptions& sparse_cholesky_options,
+      double ridge_regularization)
+      : solver_(sparse_cholesky_options),
+        ridge_regularization_(ridge_regularization) {}
 
   bool Compute(const Eigen::SparseMatrix<double>& A) override {
     return solver_.Compute(NormalEquations(A, ridge_regularization_));
@@ -104,6 +108,26 @@ struct SupernodalCholmodLLTLinearSolver
   const double ridge_regularization_;
 };
 
+struct ConjugateGradientLinearSolver
+    : public LeastAbsoluteDeviationLinearSolverImpl {
+  explicit ConjugateGradientLinearSolver(
+      const NormalEquationsCGSolver::Options& options)
+      : options_(options) {}
+
+  bool Compute(const Eigen::SparseMatrix<double>& A) override {
+    solver_ = std::make_unique<NormalEquationsCGSolver>(options_, A);
+    return true;
+  }
+
+  bool Solve(const Eigen::VectorXd& b, Eigen::VectorXd* x) override {
+    return solver_->Solve(b, x);
+  }
+
+ private:
+  const NormalEquationsCGSolver::Options options_;
+  std::unique_ptr<NormalEquationsCGSolver> solver_;
+};
+
 std::shared_ptr<LeastAbsoluteDeviationLinearSolverImpl> CreateLinearSolver(
     const LeastAbsoluteDeviationSolver::Options& options,
     const Eigen::SparseMatrix<double>& A) {
@@ -115,8 +139,15 @@ std::shared_ptr<LeastAbsoluteDeviationLinearSolverImpl> CreateLinearSolver(
     case LeastAbsoluteDeviationSolver::Options::SolverType::
         SupernodalCholmodLLT:
       return std::make_shared<SupernodalCholmodLLTLinearSolver>(
-          options.ridge_regularization);
+          options.sparse_cholesky, options.ridge_regularization);
       break;
+    case LeastAbsoluteDeviationSolver::Options::SolverType::ConjugateGradient: {
+      NormalEquationsCGSolver::Options cg_options;
+      cg_options.max_num_iterations = options.cg_max_num_iterations;
+      cg_options.tolerance = options.cg_tolerance;
+      cg_options.ridge_regularization = options.ridge_regularization;
+      return std::make_shared<ConjugateGradientLinearSolver>(cg_options);
+    }
     default:
       throw std::runtime_error("Unknown linear solver type");
   }
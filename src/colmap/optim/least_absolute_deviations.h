@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include "colmap/optim/sparse_cholesky.h"
 #include "colmap/util/eigen_alignment.h"
 
 #include <memory>
@@ -74,8 +75,19 @@ struct LeastAbsoluteDeviationSolver {
     enum class SolverType {
       SimplicialLLT,
       SupernodalCholmodLLT,
+      // Iterative solver without factorization of A^T A, which is warm-started
+      // from the previous ADMM iterate, see NormalEquationsCGSolver.
+      ConjugateGradient,
     };
     SolverType solver_type = SolverType::SimplicialLLT;
+
+    // Options of the SupernodalCholmodLLT solver.
+    SparseCholeskyOptions sparse_cholesky;
+
+    // Maximum number of iterations and relative residual tolerance of the
+    // conjugate gradient solver.
+    int cg_max_num_iterations = 500;
+    double cg_tolerance = 1e-10;
   };
 
   LeastAbsoluteDeviationSolver(const Options& options,
@@ -304,8 +304,11 @@ TEST_P(ParameterizedLeastAbsoluteDeviationsTests, RidgeRegularization) {
   Eigen::VectorXd b(3);
   b << 2.0, 4.0, 6.0;
 
-  // Without regularization, the singular A^T A is not factorizable.
-  {
+  // Without regularization, the singular A^T A is not factorizable. Conjugate
+  // gradients do not factorize A^T A and also converge on this consistent
+  // singular system.
+  if (GetParam() !=
+      LeastAbsoluteDeviationSolver::Options::SolverType::ConjugateGradient) {
     LeastAbsoluteDeviationSolver::Options options = GetOptions();
     LeastAbsoluteDeviationSolver solver(options, A);
     EXPECT_FALSE(solver.Valid());
@@ -334,7 +337,8 @@ INSTANTIATE_TEST_SUITE_P(
     ::testing::Values(
         LeastAbsoluteDeviationSolver::Options::SolverType::SimplicialLLT,
         LeastAbsoluteDeviationSolver::Options::SolverType::
-            SupernodalCholmodLLT));
+            SupernodalCholmodLLT,
+        LeastAbsoluteDeviationSolver::Options::SolverType::ConjugateGradient));
 
 }  // namespace
 }  // namespace colmap
@@ -31,11 +31,54 @@
 
 #include "colmap/util/logging.h"
 
+#include <stdexcept>
+
 namespace colmap {
 
+namespace {
+
+int CholmodOrdering(SparseCholeskyOptions::Ordering ordering) {
+  switch (ordering) {
+    case SparseCholeskyOptions::Ordering::AMD:
+      return CHOLMOD_AMD;
+    case SparseCholeskyOptions::Ordering::METIS:
+      return CHOLMOD_METIS;
+    case SparseCholeskyOptions::Ordering::NESDIS:
+      return CHOLMOD_NESDIS;
+    default:
+      throw std::runtime_error("Unknown ordering");
+  }
+}
+
+}  // namespace
+
+SparseCholeskyWithFallbackSolver::SparseCholeskyWithFallbackSolver(
+    const SparseCholeskyOptions& options)
+    : options_(options),
+      use_ldlt_(options.backend == SparseCholeskyOptions::Backend::SIMPLICIAL) {
+  if (options_.ordering != SparseCholeskyOptions::Ordering::AUTO) {
+    cholmod_common& common = supernodal_.cholmod();
+    common.nmethods = 1;
+    common.method[0].ordering = CholmodOrdering(options_.ordering);
+  }
+}
+
 void SparseCholeskyWithFallbackSolver::AnalyzePattern(
     const Eigen::SparseMatrix<double>& A) {
+  use_ldlt_ = options_.backend == SparseCholeskyOptions::Backend::SIMPLICIAL;
+  if (use_ldlt_) {
+    ldlt_.analyzePattern(A);
+    return;
+  }
+
   supernodal_.analyzePattern(A);
+  cholmod_common& common = supernodal_.cholmod();
+  if (common.status < CHOLMOD_OK && common.nmethods != 0) {
+    LOG(WARNING) << "CHOLMOD analysis with the requested ordering failed; "
+                    "falling back to the default ordering.";
+    common.nmethods = 0;
+    supernodal_.analyzePattern(A);
+  }
   // LDLT pattern is analyzed lazily on first fallback, since the common case
   // never needs it.
 }
@@ -73,4 +116,15 @@ bool SparseCholeskyWithFallbackSolver::Solve(const Eigen::VectorXd& b,
   return supernodal_.info() == Eigen::Success;
 }
 
+bool SparseCholeskyWithFallbackSolver::Solve(const Eigen::MatrixXd& B,
+                                             Eigen::MatrixXd* X) const {
+  THROW_CHECK_NOTNULL(X);
+  if (use_ldlt_) {
+    X->noalias() = ldlt_.solve(B);
+    return ldlt_.info() == Eigen::Success;
+  }
+  X->noalias() = supernodal_.solve(B);
+  return supernodal_.info() == Eigen::Success;
+}
+
 }  // namespace colmap
@@ -29,12 +29,31 @@
 
 #pragma once
 
+#include "colmap/util/enum_utils.h"
+
 #include <Eigen/CholmodSupport>
 #include <Eigen/SparseCholesky>
 #include <Eigen/SparseCore>
 
 namespace colmap {
 
+struct SparseCholeskyOptions {
+  // SUPERNODAL: CHOLMOD supernodal LLT with fallback to simplicial LDLT.
+  // SIMPLICIAL: Eigen's simplicial LDLT only. Slower for large systems but
+  // more tolerant to ill-conditioning.
+  MAKE_ENUM_CLASS(Backend, 0, SUPERNODAL, SIMPLICIAL);
+  Backend backend = Backend::SUPERNODAL;
+
+  // AUTO: CHOLMOD's default strategy, which tries AMD and only resorts to
+  // METIS if the fill-in is high.
+  // METIS/NESDIS: Graph partitioning orderings, which typically produce less
+  // fill-in for large pose graphs at a higher analysis cost. Fall back to
+  // AUTO if CHOLMOD was built without METIS.
+  MAKE_ENUM_CLASS(Ordering, 0, AUTO, AMD, METIS, NESDIS);
+  // Fill-reducing ordering of the supernodal backend.
+  Ordering ordering = Ordering::AUTO;
+};
+
 // Sparse Cholesky solver that tries CHOLMOD supernodal LLT first (fastest for
 // large systems) and falls back to Eigen's simplicial LDLT (more numerically
 // tolerant) once supernodal reports the matrix is not positive definite.
@@ -42,17 +61,26 @@ namespace colmap {
 // which can trigger on mathematically PD but ill-conditioned systems.
 class SparseCholeskyWithFallbackSolver {
  public:
+  SparseCholeskyWithFallbackSolver() = default;
+  explicit SparseCholeskyWithFallbackSolver(
+      const SparseCholeskyOptions& options);
+
   // One-shot factorization (analyze + factorize).
   bool Compute(const Eigen::SparseMatrix<double>& A);
 
   // For iterative reuse with matrices of identical sparsity but changing
-  // values, call AnalyzePattern once then Factorize per iteration.
+  // values, call AnalyzePattern once then Factorize per iteration. The
+  // symbolic analysis, including the fill-reducing ordering, is only
+  // computed in AnalyzePattern and reused by all subsequent factorizations.
   void AnalyzePattern(const Eigen::SparseMatrix<double>& A);
   bool Factorize(const Eigen::SparseMatrix<double>& A);
 
   bool Solve(const Eigen::VectorXd& b, Eigen::VectorXd* x) const;
+  // Solves for multiple right-hand sides at once.
+  bool Solve(const Eigen::MatrixXd& B, Eigen::MatrixXd* X) const;
 
  private:
+  SparseCholeskyOptions options_;
   Eigen::CholmodSupernodalLLT<Eigen::SparseMatrix<double>> supernodal_;
   Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> ldlt_;
   bool use_ldlt_ = false;
@@ -89,6 +89,20 @@ TEST(SparseCholeskyWithFallbackSolver, ComputeAndSolveChain) {
   EXPECT_THAT(A * x, EigenMatrixNear(b, 1e-9));
 }
 
+TEST(SparseCholeskyWithFallbackSolver, ComputeAndSolveMultipleRhs) {
+  const Eigen::SparseMatrix<double> A = ChainLaplacianGaugeFixed(10);
+  const Eigen::MatrixXd B = Eigen::MatrixXd::Identity(A.rows(), 4);
+
+  SparseCholeskyWithFallbackSolver solver;
+  ASSERT_TRUE(solver.Compute(A));
+
+  Eigen::MatrixXd X;
+  ASSERT_TRUE(solver.Solve(B, &X));
+  ASSERT_EQ(X.rows(), A.rows());
+  ASSERT_EQ(X.cols(), B.cols());
+  EXPECT_THAT(Eigen::MatrixXd(A * X), EigenMatrixNear(B, 1e-9));
+}
+
 TEST(SparseCholeskyWithFallbackSolver,
      AnalyzeAndFactorizeReusedAcrossMatrices) {
   // Same sparsity, different numeric values — mirrors IRLS reuse pattern.
@@ -182,5 +196,44 @@ TEST(SparseCholeskyWithFallbackSolver, IllConditionedChain) {
   EXPECT_THAT(A * x, EigenMatrixNear(b, 1e-6));
 }
 
+TEST(SparseCholeskyWithFallbackSolver, Backends) {
+  const Eigen::SparseMatrix<double> A = ChainLaplacianGaugeFixed(50);
+  const Eigen::VectorXd b = Eigen::VectorXd::LinSpaced(A.rows(), 1, 50);
+
+  for (const auto backend : {SparseCholeskyOptions::Backend::SUPERNODAL,
+                             SparseCholeskyOptions::Backend::SIMPLICIAL}) {
+    SparseCholeskyOptions options;
+    options.backend = backend;
+    SparseCholeskyWithFallbackSolver solver(options);
+    ASSERT_TRUE(solver.Compute(A));
+
+    Eigen::VectorXd x;
+    ASSERT_TRUE(solver.Solve(b, &x));
+    EXPECT_THAT(A * x, EigenMatrixNear(b, 1e-9));
+  }
+}
+
+TEST(SparseCholeskyWithFallbackSolver, Orderings) {
+  const Eigen::SparseMatrix<double> A = ChainLaplacianGaugeFixed(50);
+  const Eigen::VectorXd b = Eigen::VectorXd::LinSpaced(A.rows(), 1, 50);
+
+  // METIS and NESDIS fall back to the default ordering if CHOLMOD was built
+  // without METIS, so all orderings must succeed.
+  for (const auto ordering : {SparseCholeskyOptions::Ordering::AUTO,
+                              SparseCholeskyOptions::Ordering::AMD,
+                              SparseCholeskyOptions::Ordering::METIS,
+                              SparseCholeskyOptions::Ordering::NESDIS}) {
+    SparseCholeskyOptions options;
+    options.ordering = ordering;
+    SparseCholeskyWithFallbackSolver solver(options);
+    solver.AnalyzePattern(A);
+    ASSERT_TRUE(solver.Factorize(A));
+
+    Eigen::VectorXd x;
+    ASSERT_TRUE(solver.Solve(b, &x));
+    EXPECT_THAT(A * x, EigenMatrixNear(b, 1e-9));
+  }
+}
+
 }  // namespace
 }  // namespace colmap
@@ -31,6 +31,8 @@
 
 #include "colmap/util/logging.h"
 
+#include <algorithm>
+#include <cmath>
 #include <unordered_set>
 
 namespace colmap {
@@ -124,4 +126,38 @@ bool MEstimatorSupportMeasurer::IsLeftBetter(const Support& left,
   return left.score < right.score;
 }
 
+MarginalizedSupportMeasurer::Support MarginalizedSupportMeasurer::Evaluate(
+    const std::vector<double>& residuals, const double max_residual) {
+  Support support;
+  support.num_inliers = 0;
+  support.score = 0;
+
+  // The inlier weight exp(-r^2 / (2 sigma^2)) integrated over sigma in
+  // [0, sigma_max] and normalized by sigma_max has the closed form
+  // exp(-a / s) - sqrt(pi * a / s) * erfc(sqrt(a / s)) with a = r^2 / 2 and
+  // s = sigma_max^2.
+  const double sigma_max_sq = max_residual / 4.0;
+  const double inv_sigma_max_sq = sigma_max_sq > 0 ? 1.0 / sigma_max_sq : 0;
+  const double kPi = 3.14159265358979323846;
+
+  for (const auto residual : residuals) {
+    if (residual <= max_residual) {
+      support.num_inliers += 1;
+      const double a = 0.5 * std::max(residual, 0.0) * inv_sigma_max_sq;
+      const double weight =
+          std::exp(-a) - std::sqrt(kPi * a) * std::erfc(std::sqrt(a));
+      support.score += 1.0 - weight;
+    } else {
+      support.score += 1.0;
+    }
+  }
+
+  return support;
+}
+
+bool MarginalizedSupportMeasurer::IsLeftBetter(const Support& left,
+                                               const Support& right) {
+  return left.score < right.score;
+}
+
 }  // namespace colmap
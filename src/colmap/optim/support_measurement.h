@@ -102,4 +102,30 @@ struct MEstimatorSupportMeasurer {
   bool IsLeftBetter(const Support& left, const Support& right);
 };
 
+// Measure the support of a model by its marginalized loss as used in
+// MAGSAC++. Instead of assuming a fixed noise scale, the inlier likelihood
+// of each residual is marginalized over noise scales sigma in
+// [0, sigma_max], where the inlier threshold corresponds to 2 * sigma_max.
+// Residuals beyond the threshold contribute the maximum loss of 1. This is
+// less sensitive to the choice of threshold than MSAC scoring. A support is
+// better if it has a smaller loss.
+//
+//   "MAGSAC++, a fast, reliable and accurate robust estimator",
+//   Barath et al., CVPR 2020
+struct MarginalizedSupportMeasurer {
+  struct Support {
+    // The number of inliers.
+    size_t num_inliers = 0;
+
+    // The marginalized loss, summed over all residuals.
+    double score = std::numeric_limits<double>::max();
+  };
+
+  // Compute the support of the residuals.
+  Support Evaluate(const std::vector<double>& residuals, double max_residual);
+
+  // Compare the two supports.
+  bool IsLeftBetter(const Support& left, const Support& right);
+};
+
 }  // namespace colmap
@@ -132,5 +132,39 @@ TEST(MEstimatorSupportMeasurer, Nominal) {
   EXPECT_TRUE(measurer.IsLeftBetter(support2, support1));
 }
 
+TEST(MarginalizedSupportMeasurer, Nominal) {
+  MarginalizedSupportMeasurer::Support support1;
+  EXPECT_EQ(support1.num_inliers, 0);
+  EXPECT_EQ(support1.score, std::numeric_limits<double>::max());
+  MarginalizedSupportMeasurer measurer;
+  std::vector<double> residuals = {-1.0, 0.0, 0.5, 1.0, 2.0};
+  support1 = measurer.Evaluate(residuals, 1.0);
+  EXPECT_EQ(support1.num_inliers, 4);
+  // Zero residuals have no loss, residuals at the threshold almost the full
+  // loss of an outlier.
+  EXPECT_GT(support1.score, 1.0);
+  EXPECT_LT(support1.score, 3.0);
+
+  // The loss increases monotonically with the residual.
+  double prev_score = 0;
+  for (const double residual : {0.0, 0.1, 0.2, 0.5, 0.8, 1.0, 1.5}) {
+    const double score = measurer.Evaluate({residual}, 1.0).score;
+    EXPECT_GE(score, 0.0);
+    EXPECT_LE(score, 1.0);
+    EXPECT_GE(score, prev_score);
+    prev_score = score;
+  }
+  EXPECT_EQ(measurer.Evaluate({0.0}, 1.0).score, 0.0);
+  EXPECT_NEAR(measurer.Evaluate({1.0}, 1.0).score, 1.0, 0.05);
+  EXPECT_EQ(measurer.Evaluate({1.5}, 1.0).score, 1.0);
+
+  MarginalizedSupportMeasurer::Support support2 = support1;
+  EXPECT_FALSE(measurer.IsLeftBetter(support1, support2));
+  EXPECT_FALSE(measurer.IsLeftBetter(support2, support1));
+  support2.score += 0.01;
+  EXPECT_TRUE(measurer.IsLeftBetter(support1, support2));
+  EXPECT_FALSE(measurer.IsLeftBetter(support2, support1));
+}
+
 }  // namespace
 }  // namespace colmap
@@ -0,0 +1,170 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/retrieval/global_descriptor.h"
+
+#include "colmap/util/endian.h"
+#include "colmap/util/file.h"
+#include "colmap/util/logging.h"
+#include "colmap/util/threading.h"
+
+#include <fstream>
+#include <string_view>
+
+#include <faiss/Clustering.h>
+#include <faiss/IndexFlat.h>
+#include <omp.h>
+
+namespace colmap {
+namespace retrieval {
+
+bool VLADCodebook::BuildOptions::Check() const {
+  CHECK_OPTION_GT(num_clusters, 0);
+  CHECK_OPTION_GT(num_iterations, 0);
+  return true;
+}
+
+VLADCodebook::VLADCodebook(Eigen::RowMajorMatrixXf centroids)
+    : centroids_(std::move(centroids)) {
+  UpdateCentroidSquaredNorms();
+}
+
+void VLADCodebook::Build(const BuildOptions& options,
+                         const FeatureDescriptorsFloatData& descriptors) {
+  THROW_CHECK(options.Check());
+  THROW_CHECK_GE(descriptors.rows(), options.num_clusters);
+  THROW_CHECK_GT(descriptors.cols(), 0);
+
+  VLOG(2) << "Clustering " << descriptors.rows()
+          << " descriptors into codebook using kmeans";
+
+  faiss::Clustering clustering(descriptors.cols(), options.num_clusters);
+  clustering.niter = options.num_iterations;
+  clustering.verbose = VLOG_IS_ON(3);
+
+#pragma omp parallel num_threads(1)
+  {
+    omp_set_num_threads(GetEffectiveNumThreads(options.num_threads));
+#ifdef _MSC_VER
+    omp_set_nested(1);
+#else
+    omp_set_max_active_levels(1);
+#endif
+
+    faiss::IndexFlatL2 index(descriptors.cols());
+    clustering.train(descriptors.rows(), descriptors.data(), index);
+  }
+
+  centroids_ = Eigen::Map<const Eigen::RowMajorMatrixXf>(
+      clustering.centroids.data(), options.num_clusters, descriptors.cols());
+  UpdateCentroidSquaredNorms();
+}
+
+uint64_t VLADCodebook::Hash() const {
+  return ComputeFNV1aHash(
+      std::string_view(reinterpret_cast<const char*>(centroids_.data()),
+                       centroids_.size() * sizeof(float)));
+}
+
+Eigen::VectorXf VLADCodebook::Aggregate(
+    const FeatureDescriptorsFloatData& descriptors) const {
+  THROW_CHECK_GT(NumClusters(), 0);
+
+  Eigen::RowMajorMatrixXf residuals =
+      Eigen::RowMajorMatrixXf::Zero(NumClusters(), DescDim());
+  if (descriptors.rows() == 0) {
+    return Eigen::Map<Eigen::VectorXf>(residuals.data(), residuals.size());
+  }
+  THROW_CHECK_EQ(descriptors.cols(), DescDim());
+
+  // The nearest centroid minimizes |c|^2 - 2 * <c, d>.
+  const Eigen::MatrixXf dists =
+      (-2 * descriptors * centroids_.transpose()).rowwise() +
+      centroid_squared_norms_.transpose();
+  for (Eigen::Index i = 0; i < descriptors.rows(); ++i) {
+    Eigen::Index cluster_idx;
+    dists.row(i).minCoeff(&cluster_idx);
+    residuals.row(cluster_idx) +=
+        descriptors.row(i) - centroids_.row(cluster_idx);
+  }
+
+  // Intra-normalization avoids that bursts of similar descriptors dominate a
+  // single centroid and power normalization further dampens large components.
+  for (Eigen::Index k = 0; k < residuals.rows(); ++k) {
+    const float norm = residuals.row(k).norm();
+    if (norm > 0) {
+      residuals.row(k) /= norm;
+    }
+  }
+  residuals = residuals.array().sign() * residuals.array().abs().sqrt();
+
+  Eigen::VectorXf descriptor =
+      Eigen::Map<Eigen::VectorXf>(residuals.data(), residuals.size());
+  const float norm = descriptor.norm();
+  if (norm > 0) {
+    descriptor /= norm;
+  }
+  return descriptor;
+}
+
+void VLADCodebook::Read(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  THROW_CHECK_FILE_OPEN(file, path);
+  const int file_version = ReadBinaryLittleEndian<int>(&file);
+  THROW_CHECK_EQ(file_version, 1);
+  const int num_clusters = ReadBinaryLittleEndian<int>(&file);
+  const int desc_dim = ReadBinaryLittleEndian<int>(&file);
+  THROW_CHECK_GT(num_clusters, 0);
+  THROW_CHECK_GT(desc_dim, 0);
+  centroids_.resize(num_clusters, desc_dim);
+  for (Eigen::Index i = 0; i < centroids_.size(); ++i) {
+    centroids_.data()[i] = ReadBinaryLittleEndian<float>(&file);
+  }
+  THROW_CHECK(file.good()) << "Truncated codebook " << path;
+  UpdateCentroidSquaredNorms();
+}
+
+void VLADCodebook::Write(const std::filesystem::path& path) const {
+  std::ofstream file(path, std::ios::binary);
+  THROW_CHECK_FILE_OPEN(file, path);
+  WriteBinaryLittleEndian<int>(&file, 1);
+  WriteBinaryLittleEndian<int>(&file, NumClusters());
+  WriteBinaryLittleEndian<int>(&file, DescDim());
+  for (Eigen::Index i = 0; i < centroids_.size(); ++i) {
+    WriteBinaryLittleEndian<float>(&file, centroids_.data()[i]);
+  }
+}
+
+void VLADCodebook::UpdateCentroidSquaredNorms() {
+  centroid_squared_norms_ = centroids_.rowwise().squaredNorm();
+}
+
+}  // namespace retrieval
+}  // namespace colmap
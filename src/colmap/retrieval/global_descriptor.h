@@ -0,0 +1,117 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "colmap/feature/types.h"
+#include "colmap/util/eigen_alignment.h"
+
+#include <cstdint>
+#include <filesystem>
+
+#include <Eigen/Core>
+
+namespace colmap {
+namespace retrieval {
+
+// Codebook to aggregate the local features of an image into a single compact
+// global descriptor for retrieval, based on the paper:
+//
+//    Jegou, Douze, Schmid, Perez. "Aggregating local descriptors into a
+//    compact image representation". CVPR 2010.
+//
+// The aggregated VLAD descriptor concatenates the sums of the residuals of the
+// local descriptors to their nearest centroid. It is intra-normalized, power
+// normalized, and L2-normalized, such that the similarity of two images is
+// measured by the Euclidean distance of their global descriptors.
+class VLADCodebook {
+ public:
+  struct BuildOptions {
+    // The number of centroids. The dimension of the global descriptors is the
+    // number of centroids times the local descriptor dimension.
+    int num_clusters = 16;
+
+    // The number of iterations for the clustering.
+    int num_iterations = 25;
+
+    // Number of threads to use.
+    int num_threads = -1;
+
+    bool Check() const;
+  };
+
+  VLADCodebook() = default;
+  explicit VLADCodebook(Eigen::RowMajorMatrixXf centroids);
+
+  // Cluster the local training descriptors into the centroids of the codebook.
+  void Build(const BuildOptions& options,
+             const FeatureDescriptorsFloatData& descriptors);
+
+  inline int NumClusters() const;
+  inline int DescDim() const;
+  // Dimension of the aggregated global descriptors.
+  inline int Dim() const;
+  inline const Eigen::RowMajorMatrixXf& Centroids() const;
+
+  // Hash of the centroids, which identifies the global descriptors aggregated
+  // with this codebook.
+  uint64_t Hash() const;
+
+  // Aggregate the local descriptors of an image into its global descriptor.
+  // Images without local descriptors have an all-zero global descriptor.
+  Eigen::VectorXf Aggregate(
+      const FeatureDescriptorsFloatData& descriptors) const;
+
+  void Read(const std::filesystem::path& path);
+  void Write(const std::filesystem::path& path) const;
+
+ private:
+  void UpdateCentroidSquaredNorms();
+
+  Eigen::RowMajorMatrixXf centroids_;
+  Eigen::VectorXf centroid_squared_norms_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////////////////////////////////////
+
+int VLADCodebook::NumClusters() const { return centroids_.rows(); }
+
+int VLADCodebook::DescDim() const { return centroids_.cols(); }
+
+int VLADCodebook::Dim() const { return centroids_.size(); }
+
+const Eigen::RowMajorMatrixXf& VLADCodebook::Centroids() const {
+  return centroids_;
+}
+
+}  // namespace retrieval
+}  // namespace colmap
@@ -0,0 +1,121 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/retrieval/global_descriptor.h"
+
+#include "colmap/math/random.h"
+#include "colmap/util/testing.h"
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace retrieval {
+namespace {
+
+FeatureDescriptorsFloatData CreateRandomDescriptors(int num_descriptors,
+                                                    int desc_dim) {
+  FeatureDescriptorsFloatData descriptors =
+      FeatureDescriptorsFloatData::Random(num_descriptors, desc_dim);
+  descriptors.rowwise().normalize();
+  return descriptors;
+}
+
+TEST(VLADCodebook, Empty) {
+  VLADCodebook codebook;
+  EXPECT_EQ(codebook.NumClusters(), 0);
+  EXPECT_EQ(codebook.DescDim(), 0);
+  EXPECT_EQ(codebook.Dim(), 0);
+}
+
+TEST(VLADCodebook, Build) {
+  SetPRNGSeed(0);
+  VLADCodebook::BuildOptions options;
+  options.num_clusters = 4;
+  VLADCodebook codebook;
+  codebook.Build(options, CreateRandomDescriptors(100, 8));
+  EXPECT_EQ(codebook.NumClusters(), 4);
+  EXPECT_EQ(codebook.DescDim(), 8);
+  EXPECT_EQ(codebook.Dim(), 32);
+}
+
+TEST(VLADCodebook, Aggregate) {
+  SetPRNGSeed(0);
+  const VLADCodebook codebook(CreateRandomDescriptors(4, 8));
+  EXPECT_EQ(codebook.Dim(), 32);
+
+  EXPECT_EQ(codebook.Aggregate(FeatureDescriptorsFloatData(0, 8)),
+            Eigen::VectorXf::Zero(32));
+
+  const FeatureDescriptorsFloatData descriptors1 =
+      CreateRandomDescriptors(50, 8);
+  const Eigen::VectorXf descriptor1 = codebook.Aggregate(descriptors1);
+  EXPECT_EQ(descriptor1.size(), 32);
+  EXPECT_NEAR(descriptor1.norm(), 1, 1e-6);
+
+  // The aggregation is invariant to the order of the local descriptors.
+  EXPECT_TRUE(descriptor1.isApprox(
+      codebook.Aggregate(descriptors1.colwise().reverse())));
+
+  // Images sharing most of their local descriptors are more similar than
+  // unrelated images.
+  FeatureDescriptorsFloatData descriptors2 = descriptors1;
+  descriptors2.topRows(10) = CreateRandomDescriptors(10, 8);
+  const FeatureDescriptorsFloatData descriptors3 =
+      CreateRandomDescriptors(50, 8);
+  EXPECT_LT((descriptor1 - codebook.Aggregate(descriptors2)).norm(),
+            (descriptor1 - codebook.Aggregate(descriptors3)).norm());
+}
+
+TEST(VLADCodebook, Hash) {
+  SetPRNGSeed(0);
+  const Eigen::RowMajorMatrixXf centroids = CreateRandomDescriptors(4, 8);
+  EXPECT_EQ(VLADCodebook(centroids).Hash(), VLADCodebook(centroids).Hash());
+  EXPECT_NE(VLADCodebook(centroids).Hash(),
+            VLADCodebook(CreateRandomDescriptors(4, 8)).Hash());
+}
+
+TEST(VLADCodebook, ReadWrite) {
+  SetPRNGSeed(0);
+  const VLADCodebook codebook(CreateRandomDescriptors(4, 8));
+  const auto path = CreateTestDir() / "codebook.bin";
+  codebook.Write(path);
+  VLADCodebook read_codebook;
+  read_codebook.Read(path);
+  EXPECT_EQ(read_codebook.Centroids(), codebook.Centroids());
+  EXPECT_EQ(read_codebook.Hash(), codebook.Hash());
+  const FeatureDescriptorsFloatData descriptors =
+      CreateRandomDescriptors(20, 8);
+  EXPECT_EQ(read_codebook.Aggregate(descriptors),
+            codebook.Aggregate(descriptors));
+}
+
+}  // namespace
+}  // namespace retrieval
+}  // namespace colmap
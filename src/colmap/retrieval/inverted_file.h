@@ -94,6 +94,10 @@ class InvertedFile {
                 const DescType& descriptor,
                 const GeomType& geometry);
 
+  // Adds an inverted file entry with an already computed binary descriptor,
+  // e.g., an entry that was previously read from another inverted file.
+  void AddEntry(const EntryType& entry);
+
   // Sorts the inverted file entries in ascending order of image ids. This is
   // required for efficient scoring and must be called before ScoreFeature.
   void SortEntries();
@@ -146,9 +150,18 @@ class InvertedFile {
   // The inverse document frequency weight of this inverted file.
   float squared_idf_weight_;
 
+  // Rebuilds the contiguous scoring data from the entries.
+  void UpdateScoringData();
+
   // The entries of the inverted file system.
   std::vector<EntryType> entries_;
 
+  // The image identifiers and bit-packed binary signatures of the entries in
+  // the same order as the entries. Scoring only walks these contiguous arrays
+  // instead of the much larger entries.
+  std::vector<int> entry_image_ids_;
+  std::vector<uint64_t> entry_embeddings_;
+
   // The thresholds used for Hamming embedding.
   DescType thresholds_;
 
@@ -173,6 +186,8 @@ InvertedFile<kEmbeddingDim>::InvertedFile()
                 " be a multiple of 8.");
   static_assert(kEmbeddingDim > 0,
                 "Dimensionality of projected space needs to be > 0.");
+  static_assert(kEmbeddingDim <= 64,
+                "Dimensionality of projected space needs to be <= 64.");
 
   thresholds_.resize(kEmbeddingDim);
   thresholds_.setZero();
@@ -216,7 +231,15 @@ void InvertedFile<kEmbeddingDim>::AddEntry(const int image_id,
   entry.feature_idx = feature_idx;
   entry.geometry = geometry;
   ConvertToBinaryDescriptor(descriptor, &entry.descriptor);
+  AddEntry(entry);
+}
+
+template <int kEmbeddingDim>
+void InvertedFile<kEmbeddingDim>::AddEntry(const EntryType& entry) {
+  THROW_CHECK_GE(entry.image_id, 0);
   entries_.push_back(entry);
+  entry_image_ids_.push_back(entry.image_id);
+  entry_embeddings_.push_back(entry.descriptor.to_ullong());
   status_ &= ~kEntriesSorted;
 }
 
@@ -227,12 +250,15 @@ void InvertedFile<kEmbeddingDim>::SortEntries() {
             [](const EntryType& entry1, const EntryType& entry2) {
               return entry1.image_id < entry2.image_id;
             });
+  UpdateScoringData();
   status_ |= kEntriesSorted;
 }
 
 template <int kEmbeddingDim>
 void InvertedFile<kEmbeddingDim>::ClearEntries() {
   entries_.clear();
+  entry_image_ids_.clear();
+  entry_embeddings_.clear();
   status_ &= ~kEntriesSorted;
 }
 
@@ -240,7 +266,7 @@ template <int kEmbeddingDim>
 void InvertedFile<kEmbeddingDim>::Reset() {
   status_ = kUnusable;
   squared_idf_weight_ = 0.0f;
-  entries_.clear();
+  ClearEntries();
   thresholds_.setZero();
 }
 
@@ -310,9 +336,21 @@ void InvertedFile<kEmbeddingDim>::ScoreFeature(
 
   std::bitset<kEmbeddingDim> bin_descriptor;
   ConvertToBinaryDescriptor(descriptor, &bin_descriptor);
+  const uint64_t query_embedding = bin_descriptor.to_ullong();
+
+  // Compute all Hamming distances in one tight loop over the contiguous
+  // signatures, which the compiler can vectorize.
+  const size_t num_entries = entry_embeddings_.size();
+  thread_local std::vector<uint8_t> hamming_dists;
+  hamming_dists.resize(num_entries);
+  const uint64_t* embeddings = entry_embeddings_.data();
+  for (size_t i = 0; i < num_entries; ++i) {
+    hamming_dists[i] =
+        static_cast<uint8_t>(PopCount(query_embedding ^ embeddings[i]));
+  }
 
   ImageScore image_score;
-  image_score.image_id = entries_.front().image_id;
+  image_score.image_id = entry_image_ids_.front();
   image_score.score = 0.0f;
   int num_image_votes = 0;
 
@@ -335,16 +373,17 @@ void InvertedFile<kEmbeddingDim>::ScoreFeature(
 
   // Note that this assumes that the entries are sorted using SortEntries
   // according to their image identifiers.
-  for (const auto& entry : entries_) {
-    if (image_score.image_id < entry.image_id) {
+  for (size_t i = 0; i < num_entries; ++i) {
+    const int image_id = entry_image_ids_[i];
+    if (image_score.image_id < image_id) {
       maybe_add_image_score();
       // Move to the next image.
-      image_score.image_id = entry.image_id;
+      image_score.image_id = image_id;
       image_score.score = 0.0f;
       num_image_votes = 0;
     }
 
-    const size_t hamming_dist = (bin_descriptor ^ entry.descriptor).count();
+    const size_t hamming_dist = hamming_dists[i];
     if (hamming_dist <= hamming_dist_weight_functor_.kMaxHammingDistance) {
       image_score.score += hamming_dist_weight_functor_(hamming_dist);
       num_image_votes += 1;
@@ -390,6 +429,7 @@ void InvertedFile<kEmbeddingDim>::Read(std::istream* in) {
   for (uint32_t i = 0; i < num_entries; ++i) {
     entries_[i].Read(in);
   }
+  UpdateScoringData();
 }
 
 template <int kEmbeddingDim>
@@ -412,5 +452,15 @@ void InvertedFile<kEmbeddingDim>::Write(std::ostream* out) const {
   }
 }
 
+template <int kEmbeddingDim>
+void InvertedFile<kEmbeddingDim>::UpdateScoringData() {
+  entry_image_ids_.resize(entries_.size());
+  entry_embeddings_.resize(entries_.size());
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    entry_image_ids_[i] = entries_[i].image_id;
+    entry_embeddings_[i] = entries_[i].descriptor.to_ullong();
+  }
+}
+
 }  // namespace retrieval
 }  // namespace colmap
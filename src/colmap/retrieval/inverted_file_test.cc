@@ -0,0 +1,115 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/retrieval/inverted_file.h"
+
+#include <cmath>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace retrieval {
+namespace {
+
+constexpr int kEmbeddingDim = 64;
+
+Eigen::VectorXf CreateDescriptor(const int num_positive) {
+  Eigen::VectorXf descriptor = -Eigen::VectorXf::Ones(kEmbeddingDim);
+  descriptor.head(num_positive).setOnes();
+  return descriptor;
+}
+
+InvertedFile<kEmbeddingDim> CreateInvertedFile() {
+  InvertedFile<kEmbeddingDim> inverted_file;
+  Eigen::Matrix<float, Eigen::Dynamic, kEmbeddingDim> descriptors(2,
+                                                                  kEmbeddingDim);
+  descriptors.row(0).setConstant(-1);
+  descriptors.row(1).setConstant(1);
+  inverted_file.ComputeHammingEmbedding(descriptors);
+  // Image 2 has one identical and one distant signature, image 1 has two
+  // signatures at Hamming distance 4 and image 3 only a distant signature.
+  inverted_file.AddEntry(2, 0, CreateDescriptor(0), FeatureGeometry());
+  inverted_file.AddEntry(1, 0, CreateDescriptor(4), FeatureGeometry());
+  inverted_file.AddEntry(3, 0, CreateDescriptor(64), FeatureGeometry());
+  inverted_file.AddEntry(2, 1, CreateDescriptor(60), FeatureGeometry());
+  inverted_file.AddEntry(1, 1, CreateDescriptor(4), FeatureGeometry());
+  inverted_file.SortEntries();
+  inverted_file.ComputeIDFWeight(/*num_total_images=*/6);
+  return inverted_file;
+}
+
+TEST(InvertedFile, ScoreFeature) {
+  const InvertedFile<kEmbeddingDim> inverted_file = CreateInvertedFile();
+  EXPECT_TRUE(inverted_file.IsUsable());
+  EXPECT_EQ(inverted_file.NumEntries(), 5);
+
+  const HammingDistWeightFunctor<kEmbeddingDim> weight_functor;
+  const float squared_idf_weight = inverted_file.SquaredIDFWeight();
+  EXPECT_NEAR(squared_idf_weight, std::pow(std::log(2.0), 2), 1e-6);
+
+  std::vector<ImageScore> image_scores;
+  inverted_file.ScoreFeature(CreateDescriptor(0), &image_scores);
+  ASSERT_EQ(image_scores.size(), 2);
+  EXPECT_EQ(image_scores[0].image_id, 1);
+  EXPECT_NEAR(image_scores[0].score,
+              2 * weight_functor(4) / std::sqrt(2.0f) * squared_idf_weight,
+              1e-6);
+  EXPECT_EQ(image_scores[1].image_id, 2);
+  EXPECT_NEAR(image_scores[1].score, squared_idf_weight, 1e-6);
+}
+
+TEST(InvertedFile, ReadWrite) {
+  const InvertedFile<kEmbeddingDim> inverted_file = CreateInvertedFile();
+  std::stringstream file;
+  inverted_file.Write(&file);
+
+  InvertedFile<kEmbeddingDim> read_inverted_file;
+  read_inverted_file.Read(&file);
+  EXPECT_EQ(read_inverted_file.NumEntries(), inverted_file.NumEntries());
+
+  std::vector<ImageScore> image_scores;
+  inverted_file.ScoreFeature(CreateDescriptor(60), &image_scores);
+  std::vector<ImageScore> read_image_scores;
+  read_inverted_file.ScoreFeature(CreateDescriptor(60), &read_image_scores);
+  ASSERT_EQ(read_image_scores.size(), image_scores.size());
+  for (size_t i = 0; i < image_scores.size(); ++i) {
+    EXPECT_EQ(read_image_scores[i].image_id, image_scores[i].image_id);
+    EXPECT_NEAR(read_image_scores[i].score, image_scores[i].score, 1e-6);
+  }
+
+  read_inverted_file.ClearEntries();
+  read_inverted_file.ScoreFeature(CreateDescriptor(60), &read_image_scores);
+  EXPECT_TRUE(read_image_scores.empty());
+}
+
+}  // namespace
+}  // namespace retrieval
+}  // namespace colmap
@@ -36,6 +36,7 @@
 
 #include <bitset>
 #include <cstdint>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -89,6 +90,9 @@ class InvertedIndex {
                 const DescType& descriptor,
                 const GeomType& geometry);
 
+  // Add single entry with an already computed binary descriptor to the index.
+  void AddEntry(int64_t word_id, const EntryType& entry);
+
   // Clear all index entries.
   void ClearEntries();
 
@@ -97,6 +101,16 @@ class InvertedIndex {
              const WordIds& word_ids,
              std::vector<ImageScore>* image_scores) const;
 
+  // Query the inverted file for multiple images at once. The descriptors and
+  // word identifiers of query i are in the rows query_offsets[i] to
+  // query_offsets[i + 1]. The features of all queries are scored grouped by
+  // their visual word, such that each inverted file is traversed once while
+  // it is hot in the cache. The image scores of each query are not sorted.
+  void QueryBatch(const DescType& descriptors,
+                  const WordIds& word_ids,
+                  const std::vector<Eigen::Index>& query_offsets,
+                  std::vector<std::vector<ImageScore>>* image_scores) const;
+
   void ConvertToBinaryDescriptor(
       int64_t word_id,
       const DescType& descriptor,
@@ -121,6 +135,9 @@ class InvertedIndex {
  private:
   void ComputeWeightsAndNormalizationConstants();
 
+  // Updates the dense normalization constants from the sparse ones.
+  void UpdateDenseNormalizationConstants();
+
   // The individual inverted indices.
   std::vector<InvertedFile<kEmbeddingDim>,
               Eigen::aligned_allocator<InvertedFile<kEmbeddingDim>>>
@@ -130,6 +147,10 @@ class InvertedIndex {
   // normalize the votes.
   std::unordered_map<int, float> normalization_constants_;
 
+  // The normalization constants densely indexed by image identifier. Scores
+  // are accumulated in dense per-thread arrays of the same size.
+  std::vector<float> dense_normalization_constants_;
+
   // The projection matrix used to project SIFT descriptors.
   ProjMatrixType proj_matrix_;
 };
@@ -238,6 +259,12 @@ void InvertedIndex<kDescType, kDescDim, kEmbeddingDim>::AddEntry(
       image_id, feature_idx, proj_desc, geometry);
 }
 
+template <typename kDescType, int kDescDim, int kEmbeddingDim>
+void InvertedIndex<kDescType, kDescDim, kEmbeddingDim>::AddEntry(
+    const int64_t word_id, const EntryType& entry) {
+  inverted_files_.at(word_id).AddEntry(entry);
+}
+
 template <typename kDescType, int kDescDim, int kEmbeddingDim>
 void InvertedIndex<kDescType, kDescDim, kEmbeddingDim>::ClearEntries() {
   for (auto& inverted_file : inverted_files_) {
@@ -261,8 +288,15 @@ void InvertedIndex<kDescType, kDescDim, kEmbeddingDim>::Query(
     normalization_weight = 1.0f / std::sqrt(self_similarity);
   }
 
-  std::unordered_map<int, int> score_map;
-  std::vector<ImageScore> inverted_file_scores;
+  // Maps each image identifier to the index of its score in image_scores or
+  // -1, if the image was not scored yet. The array is reset after the query,
+  // such that it can be reused by the next query of the same thread.
+  thread_local std::vector<int> image_score_idxs;
+  if (image_score_idxs.size() < dense_normalization_constants_.size()) {
+    image_score_idxs.resize(dense_normalization_constants_.size(), -1);
+  }
+
+  thread_local std::vector<ImageScore> inverted_file_scores;
 
   for (typename DescType::Index i = 0; i < descriptors.rows(); ++i) {
     const ProjDescType proj_descriptor =
@@ -277,24 +311,126 @@ void InvertedIndex<kDescType, kDescDim, kEmbeddingDim>::Query(
                                                &inverted_file_scores);
 
       for (const ImageScore& score : inverted_file_scores) {
-        const auto score_map_it = score_map.find(score.image_id);
-        if (score_map_it == score_map.end()) {
+        if (score.image_id >= static_cast<int>(image_score_idxs.size())) {
+          image_score_idxs.resize(score.image_id + 1, -1);
+        }
+        int& image_score_idx = image_score_idxs[score.image_id];
+        if (image_score_idx == -1) {
           // Image not found in another inverted file.
-          score_map.emplace(score.image_id,
-                            static_cast<int>(image_scores->size()));
+          image_score_idx = static_cast<int>(image_scores->size());
           image_scores->push_back(score);
         } else {
           // Image already found in another inverted file, so accumulate.
-          (*image_scores).at(score_map_it->second).score += score.score;
+          (*image_scores)[image_score_idx].score += score.score;
         }
       }
     }
   }
 
+  for (const ImageScore& score : *image_scores) {
+    image_score_idxs[score.image_id] = -1;
+  }
+
   // Normalization.
   for (ImageScore& score : *image_scores) {
-    score.score *=
-        normalization_weight * normalization_constants_.at(score.image_id);
+    THROW_CHECK_LT(score.image_id,
+                   static_cast<int>(dense_normalization_constants_.size()));
+    score.score *= normalization_weight *
+                   dense_normalization_constants_[score.image_id];
+  }
+}
+
+template <typename kDescType, int kDescDim, int kEmbeddingDim>
+void InvertedIndex<kDescType, kDescDim, kEmbeddingDim>::QueryBatch(
+    const DescType& descriptors,
+    const WordIds& word_ids,
+    const std::vector<Eigen::Index>& query_offsets,
+    std::vector<std::vector<ImageScore>>* image_scores) const {
+  THROW_CHECK_EQ(descriptors.cols(), kDescDim);
+  THROW_CHECK_EQ(descriptors.rows(), word_ids.rows());
+  THROW_CHECK_GE(query_offsets.size(), 1);
+  THROW_CHECK_EQ(query_offsets.back(), descriptors.rows());
+
+  const size_t num_queries = query_offsets.size() - 1;
+  image_scores->clear();
+  image_scores->resize(num_queries);
+
+  // Group the visual word assignments of all query features by visual word.
+  struct WordAssignment {
+    int64_t word_id;
+    int query_idx;
+    Eigen::Index descriptor_idx;
+  };
+  std::vector<WordAssignment> word_assignments;
+  word_assignments.reserve(word_ids.size());
+  for (size_t query_idx = 0; query_idx < num_queries; ++query_idx) {
+    for (Eigen::Index i = query_offsets[query_idx];
+         i < query_offsets[query_idx + 1];
+         ++i) {
+      for (Eigen::Index n = 0; n < word_ids.cols(); ++n) {
+        if (word_ids(i, n) != kInvalidWordId) {
+          word_assignments.push_back(
+              {word_ids(i, n), static_cast<int>(query_idx), i});
+        }
+      }
+    }
+  }
+  std::sort(word_assignments.begin(),
+            word_assignments.end(),
+            [](const WordAssignment& assignment1,
+               const WordAssignment& assignment2) {
+              return std::tie(assignment1.word_id,
+                              assignment1.query_idx,
+                              assignment1.descriptor_idx) <
+                     std::tie(assignment2.word_id,
+                              assignment2.query_idx,
+                              assignment2.descriptor_idx);
+            });
+
+  // Project all query descriptors once, since they are usually assigned to
+  // multiple visual words.
+  Eigen::MatrixXf proj_descriptors(kEmbeddingDim, descriptors.rows());
+  for (Eigen::Index i = 0; i < descriptors.rows(); ++i) {
+    proj_descriptors.col(i) =
+        proj_matrix_ * descriptors.row(i).transpose().template cast<float>();
+  }
+
+  // Maps each image identifier to the index of its score for each query.
+  std::vector<std::unordered_map<int, int>> score_maps(num_queries);
+  std::vector<ImageScore> inverted_file_scores;
+  for (const WordAssignment& assignment : word_assignments) {
+    inverted_files_.at(assignment.word_id)
+        .ScoreFeature(proj_descriptors.col(assignment.descriptor_idx),
+                      &inverted_file_scores);
+
+    auto& query_image_scores = (*image_scores)[assignment.query_idx];
+    auto& score_map = score_maps[assignment.query_idx];
+    for (const ImageScore& score : inverted_file_scores) {
+      const auto [score_map_it, inserted] = score_map.emplace(
+          score.image_id, static_cast<int>(query_image_scores.size()));
+      if (inserted) {
+        query_image_scores.push_back(score);
+      } else {
+        query_image_scores[score_map_it->second].score += score.score;
+      }
+    }
+  }
+
+  // Normalization.
+  for (size_t query_idx = 0; query_idx < num_queries; ++query_idx) {
+    const float self_similarity = ComputeSelfSimilarity(word_ids.middleRows(
+        query_offsets[query_idx],
+        query_offsets[query_idx + 1] - query_offsets[query_idx]));
+    float normalization_weight = 1.0f;
+    if (self_similarity > 0.0f) {
+      normalization_weight = 1.0f / std::sqrt(self_similarity);
+    }
+    for (ImageScore& score : (*image_scores)[query_idx]) {
+      THROW_CHECK_LT(score.image_id,
+                     static_cast<int>(dense_normalization_constants_.size()));
+      score.score *= normalization_weight *
+                     dense_normalization_constants_[score.image_id];
+    }
   }
 }
 
@@ -387,6 +523,7 @@ void InvertedIndex<kDescType, kDescDim, kEmbeddingDim>::Read(std::istream* in) {
     in->read(reinterpret_cast<char*>(&value), sizeof(float));
     normalization_constants_[image_id] = value;
   }
+  UpdateDenseNormalizationConstants();
 }
 
 template <typename kDescType, int kDescDim, int kEmbeddingDim>
@@ -447,6 +584,21 @@ void InvertedIndex<kDescType, kDescDim, kEmbeddingDim>::
       normalization_constants_[image_id] = 0.0f;
     }
   }
+  UpdateDenseNormalizationConstants();
+}
+
+template <typename kDescType, int kDescDim, int kEmbeddingDim>
+void InvertedIndex<kDescType, kDescDim, kEmbeddingDim>::
+    UpdateDenseNormalizationConstants() {
+  int max_image_id = -1;
+  for (const auto& [image_id, _] : normalization_constants_) {
+    max_image_id = std::max(max_image_id, image_id);
+  }
+  dense_normalization_constants_.assign(max_image_id + 1, 0.0f);
+  for (const auto& [image_id, normalization_constant] :
+       normalization_constants_) {
+    dense_normalization_constants_[image_id] = normalization_constant;
+  }
 }
 
 }  // namespace retrieval
@@ -30,7 +30,9 @@
 #pragma once
 
 #include <array>
+#include <bitset>
 #include <cmath>
+#include <cstdint>
 
 namespace colmap {
 namespace retrieval {
@@ -40,6 +42,17 @@ struct ImageScore {
   float score = 0.0f;
 };
 
+// Returns the number of set bits. Compiles to a single popcnt instruction on
+// targets supporting it, and loops over contiguous words are vectorized with
+// AVX-512 VPOPCNTDQ if enabled.
+inline int PopCount(const uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(bits);
+#else
+  return static_cast<int>(std::bitset<64>(bits).count());
+#endif
+}
+
 // Implements the weighting function used to derive a voting weight from the
 // Hamming distance of two binary signatures. See Eqn. 4 in
 // Arandjelovic, Zisserman. DisLocation: Scalable descriptor distinctiveness for
@@ -34,9 +34,12 @@
 #include "colmap/util/eigen_alignment.h"
 #include "colmap/util/file.h"
 #include "colmap/util/logging.h"
+#include "colmap/util/string.h"
 #include "colmap/util/threading.h"
 
 #include <fstream>
+#include <future>
+#include <numeric>
 
 #include <Eigen/Core>
 #include <boost/heap/fibonacci_heap.hpp>
@@ -47,6 +50,12 @@
 #include <faiss/index_io.h>
 #include <omp.h>
 
+#ifdef COLMAP_FAISS_GPU_ENABLED
+#include <faiss/gpu/GpuCloner.h>
+#include <faiss/gpu/StandardGpuResources.h>
+#include <faiss/gpu/utils/DeviceUtils.h>
+#endif
+
 namespace colmap {
 namespace retrieval {
 namespace {
@@ -84,6 +93,38 @@ std::unique_ptr<faiss::IndexIVF> BuildFaissIndex(
   return index;
 }
 
+#ifdef COLMAP_FAISS_GPU_ENABLED
+// Runs the k-means clustering with the centroid assignment replicated on all
+// selected GPUs. Each GPU assigns a slice of the training descriptors.
+void TrainClusteringOnGPU(const std::string& gpu_index,
+                          const FeatureDescriptorsFloatData& descriptors,
+                          faiss::Clustering* clustering) {
+  std::vector<int> gpu_indices = CSVToVector<int>(gpu_index);
+  if (gpu_indices.size() == 1 && gpu_indices[0] == -1) {
+    gpu_indices.resize(faiss::gpu::getNumDevices());
+    std::iota(gpu_indices.begin(), gpu_indices.end(), 0);
+  }
+  THROW_CHECK(!gpu_indices.empty()) << "No CUDA devices available";
+
+  std::vector<std::unique_ptr<faiss::gpu::StandardGpuResources>> resources;
+  std::vector<faiss::gpu::GpuResourcesProvider*> resource_providers;
+  for (size_t i = 0; i < gpu_indices.size(); ++i) {
+    resources.push_back(std::make_unique<faiss::gpu::StandardGpuResources>());
+    resource_providers.push_back(resources.back().get());
+  }
+
+  faiss::IndexFlatL2 cpu_index(descriptors.cols());
+  faiss::gpu::GpuMultipleClonerOptions cloner_options;
+  cloner_options.shard = false;
+  std::unique_ptr<faiss::Index> gpu_index_replicas(
+      faiss::gpu::index_cpu_to_gpu_multiple(
+          resource_providers, gpu_indices, &cpu_index, &cloner_options));
+
+  clustering->train(
+      descriptors.rows(), descriptors.data(), *gpu_index_replicas);
+}
+#endif
+
 template <int kDescDim = 128, int kEmbeddingDim = 64>
 class FaissVisualIndex : public VisualIndex {
  public:
@@ -124,6 +165,7 @@ class FaissVisualIndex : public VisualIndex {
     }
 
     image_ids_.insert(image_id);
+    pending_image_ids_.push_back(image_id);
 
     prepared_ = false;
 
@@ -135,23 +177,77 @@ class FaissVisualIndex : public VisualIndex {
                                          options.num_neighbors,
                                          options.num_checks,
                                          options.num_threads);
+    AddEntries(options,
+               image_id,
+               keypoints,
+               descriptors.data,
+               word_ids,
+               /*word_ids_offset=*/0);
+  }
 
-    for (Eigen::Index i = 0; i < descriptors.data.rows(); ++i) {
-      const auto& descriptor = descriptors.data.row(i);
+  void AddBatch(const IndexOptions& options,
+                const std::vector<int>& image_ids,
+                const std::vector<const FeatureKeypoints*>& keypoints,
+                const std::vector<const FeatureDescriptorsFloat*>& descriptors)
+      override {
+    THROW_CHECK_EQ(keypoints.size(), image_ids.size());
+    THROW_CHECK_EQ(descriptors.size(), image_ids.size());
+
+    // Register the images, which are not yet indexed, and stack their
+    // descriptors to find their visual words with a single nearest neighbor
+    // search.
+    std::vector<size_t> batch_idxs;
+    std::vector<Eigen::Index> offsets = {0};
+    for (size_t i = 0; i < image_ids.size(); ++i) {
+      const FeatureKeypoints& image_keypoints =
+          *THROW_CHECK_NOTNULL(keypoints[i]);
+      const FeatureDescriptorsFloat& image_descriptors =
+          *THROW_CHECK_NOTNULL(descriptors[i]);
+      THROW_CHECK_EQ(image_descriptors.data.cols(), kDescDim);
+      THROW_CHECK_EQ(image_keypoints.size(), image_descriptors.data.rows());
+      THROW_CHECK_EQ(image_descriptors.type, feature_type_)
+          << "Feature type mismatch: index was built with "
+          << FeatureExtractorTypeToString(feature_type_) << " but received "
+          << FeatureExtractorTypeToString(image_descriptors.type);
+
+      if (IsImageIndexed(image_ids[i])) {
+        continue;
+      }
 
-      typename InvertedIndexType::GeomType geometry;
-      geometry.x = keypoints[i].x;
-      geometry.y = keypoints[i].y;
-      geometry.scale = keypoints[i].ComputeScale();
-      geometry.orientation = keypoints[i].ComputeOrientation();
+      image_ids_.insert(image_ids[i]);
+      pending_image_ids_.push_back(image_ids[i]);
+      prepared_ = false;
 
-      for (int n = 0; n < options.num_neighbors; ++n) {
-        const int word_id = word_ids(i, n);
-        if (word_id != InvertedIndexType::kInvalidWordId) {
-          inverted_index_.AddEntry(image_id, word_id, i, descriptor, geometry);
-        }
+      if (image_descriptors.data.rows() > 0) {
+        batch_idxs.push_back(i);
+        offsets.push_back(offsets.back() + image_descriptors.data.rows());
       }
     }
+
+    if (batch_idxs.empty()) {
+      return;
+    }
+
+    FeatureDescriptorsFloatData stacked_descriptors(offsets.back(), kDescDim);
+    for (size_t j = 0; j < batch_idxs.size(); ++j) {
+      stacked_descriptors.middleRows(offsets[j], offsets[j + 1] - offsets[j]) =
+          descriptors[batch_idxs[j]]->data;
+    }
+
+    const WordIds word_ids = FindWordIds(stacked_descriptors,
+                                         options.num_neighbors,
+                                         options.num_checks,
+                                         options.num_threads);
+
+    for (size_t j = 0; j < batch_idxs.size(); ++j) {
+      const size_t i = batch_idxs[j];
+      AddEntries(options,
+                 image_ids[i],
+                 *keypoints[i],
+                 descriptors[i]->data,
+                 word_ids,
+                 offsets[j]);
+    }
   }
 
   bool IsImageIndexed(int image_id) const override {
@@ -182,6 +278,407 @@ class FaissVisualIndex : public VisualIndex {
     WordIds word_ids;
     QueryAndFindWordIds(options, descriptors.data, image_scores, &word_ids);
 
+    VerifyImageScores(options, keypoints, descriptors, word_ids, image_scores);
+  }
+
+  void QueryBatch(
+      const QueryOptions& options,
+      const std::vector<const FeatureKeypoints*>& keypoints,
+      const std::vector<const FeatureDescriptorsFloat*>& descriptors,
+      std::vector<std::vector<ImageScore>>* image_scores) const override {
+    THROW_CHECK(prepared_);
+    THROW_CHECK_NOTNULL(image_scores);
+    const bool verify = options.num_images_after_verification > 0;
+    if (verify) {
+      THROW_CHECK_EQ(keypoints.size(), descriptors.size());
+    }
+
+    // Stack the descriptors of all queries to find their visual words with a
+    // single nearest neighbor search.
+    const size_t num_queries = descriptors.size();
+    std::vector<Eigen::Index> query_offsets(num_queries + 1, 0);
+    for (size_t i = 0; i < num_queries; ++i) {
+      const FeatureDescriptorsFloat& query_descriptors =
+          *THROW_CHECK_NOTNULL(descriptors[i]);
+      THROW_CHECK_EQ(query_descriptors.data.cols(), kDescDim);
+      THROW_CHECK_EQ(query_descriptors.type, feature_type_)
+          << "Feature type mismatch: index was built with "
+          << FeatureExtractorTypeToString(feature_type_) << " but received "
+          << FeatureExtractorTypeToString(query_descriptors.type);
+      query_offsets[i + 1] =
+          query_offsets[i] + query_descriptors.data.rows();
+    }
+
+    image_scores->assign(num_queries, {});
+    if (query_offsets.back() == 0) {
+      return;
+    }
+
+    FeatureDescriptorsFloatData stacked_descriptors(query_offsets.back(),
+                                                    kDescDim);
+    for (size_t i = 0; i < num_queries; ++i) {
+      stacked_descriptors.middleRows(query_offsets[i],
+                                     query_offsets[i + 1] - query_offsets[i]) =
+          descriptors[i]->data;
+    }
+
+    const WordIds word_ids = FindWordIds(stacked_descriptors,
+                                         options.num_neighbors,
+                                         options.num_checks,
+                                         options.num_threads);
+    inverted_index_.QueryBatch(
+        stacked_descriptors, word_ids, query_offsets, image_scores);
+
+    for (size_t i = 0; i < num_queries; ++i) {
+      SortAndTruncateImageScores(options, &(*image_scores)[i]);
+      if (verify) {
+        const Eigen::Index num_query_descriptors =
+            query_offsets[i + 1] - query_offsets[i];
+        VerifyImageScores(
+            options,
+            *THROW_CHECK_NOTNULL(keypoints[i]),
+            *descriptors[i],
+            word_ids.middleRows(query_offsets[i], num_query_descriptors),
+            &(*image_scores)[i]);
+      }
+    }
+  }
+
+  void Prepare() override {
+    inverted_index_.Finalize();
+    prepared_ = true;
+  }
+
+  void Build(const BuildOptions& options,
+             const FeatureDescriptorsFloat& descriptors) override {
+    THROW_CHECK_EQ(descriptors.data.cols(), kDescDim);
+
+    feature_type_ = descriptors.type;
+    image_ids_.clear();
+    ResetPersistenceState(/*index_path=*/"");
+
+    const Eigen::RowMajorMatrixXf visual_words =
+        Quantize(options, descriptors.data);
+    THROW_CHECK_EQ(visual_words.cols(), kDescDim);
+
+    index_ = BuildFaissIndex(options, visual_words);
+
+    // Initialize a new inverted index.
+    inverted_index_ = InvertedIndexType();
+    inverted_index_.Initialize(index_->ntotal);
+    VLOG(2) << "Initialized inverted index";
+
+    // Generate descriptor projection matrix.
+    inverted_index_.GenerateHammingEmbeddingProjection();
+    VLOG(2) << "Generated hamming embedding";
+
+    // Learn the Hamming embedding.
+    const int kNumNeighbors = 1;
+    const WordIds word_ids = FindWordIds(descriptors.data,
+                                         kNumNeighbors,
+                                         options.num_checks,
+                                         options.num_threads);
+    inverted_index_.ComputeHammingEmbedding(descriptors.data, word_ids);
+    VLOG(2) << "Computed hamming embeddings";
+  }
+
+  void ReadFromFaiss(const std::filesystem::path& path,
+                     long offset,
+                     FeatureExtractorType feature_type) override {
+    feature_type_ = feature_type;
+
+    FILE* fin = nullptr;
+#ifdef _MSC_VER
+    THROW_CHECK_EQ(fopen_s(&fin, path.string().c_str(), "rb"), 0);
+#else
+    fin = fopen(path.string().c_str(), "rb");
+#endif
+    THROW_CHECK_NOTNULL(fin);
+    fseek(fin, offset, SEEK_SET);
+    index_ = std::unique_ptr<faiss::IndexIVF>(dynamic_cast<faiss::IndexIVF*>(
+        THROW_CHECK_NOTNULL(faiss::read_index(fin))));
+    offset = ftell(fin);
+    fclose(fin);
+
+    // Read the inverted index.
+    std::ifstream file(path, std::ios::binary);
+    THROW_CHECK_FILE_OPEN(file, path);
+    file.seekg(offset, std::ios::beg);
+    inverted_index_.Read(&file);
+    image_ids_.clear();
+    inverted_index_.GetImageIds(&image_ids_);
+
+    ResetPersistenceState(path);
+    index_file_size_ = ReadDeltaSegments(&file);
+  }
+
+  void Write(const std::filesystem::path& path) const override {
+    THROW_CHECK_NOTNULL(index_);
+
+    // Write index metadata header.
+
+    {
+      std::ofstream file(path, std::ios::binary);
+      THROW_CHECK_FILE_OPEN(file, path);
+      const int kFileVersion = 2;
+      file.write(reinterpret_cast<const char*>(&kFileVersion), sizeof(int));
+      const int desc_dim = kDescDim;
+      file.write(reinterpret_cast<const char*>(&desc_dim), sizeof(int));
+      const int embedding_dim = kEmbeddingDim;
+      file.write(reinterpret_cast<const char*>(&embedding_dim), sizeof(int));
+      const int feature_type = static_cast<int>(feature_type_);
+      file.write(reinterpret_cast<const char*>(&feature_type), sizeof(int));
+    }
+
+    // Write the visual words search index.
+
+    {
+      FILE* fout = nullptr;
+#ifdef _MSC_VER
+      THROW_CHECK_EQ(fopen_s(&fout, path.string().c_str(), "ab"), 0);
+#else
+      fout = fopen(path.string().c_str(), "ab");
+#endif
+      THROW_CHECK_NOTNULL(fout);
+      faiss::write_index(index_.get(), fout);
+      fclose(fout);
+    }
+
+    // Write the inverted index.
+
+    {
+      std::ofstream file(path, std::ios::binary | std::ios::app);
+      THROW_CHECK_FILE_OPEN(file, path);
+      inverted_index_.Write(&file);
+    }
+
+    ResetPersistenceState(path);
+  }
+
+  void AppendImages(const std::filesystem::path& path) override {
+    THROW_CHECK(!index_path_.empty() && ExistsFile(path) &&
+                std::filesystem::equivalent(path, index_path_))
+        << "Delta segments can only be appended to the index file, from which "
+           "the index was read or to which it was last written.";
+
+    if (pending_image_ids_.empty()) {
+      return;
+    }
+
+    // Drop any incomplete trailing data, e.g., of an interrupted append, that
+    // was ignored when reading the index.
+    if (std::filesystem::file_size(path) != index_file_size_) {
+      std::filesystem::resize_file(path, index_file_size_);
+    }
+
+    {
+      std::ofstream file(path, std::ios::binary | std::ios::app);
+      THROW_CHECK_FILE_OPEN(file, path);
+      WriteBinaryLittleEndian<int>(&file, kDeltaSegmentMarker);
+      WriteBinaryLittleEndian<uint32_t>(&file, pending_image_ids_.size());
+      for (const int image_id : pending_image_ids_) {
+        WriteBinaryLittleEndian<int>(&file, image_id);
+      }
+      WriteBinaryLittleEndian<uint64_t>(&file, pending_entries_.size());
+      for (const auto& [word_id, entry] : pending_entries_) {
+        WriteBinaryLittleEndian<int64_t>(&file, word_id);
+        entry.Write(&file);
+      }
+      file.flush();
+      THROW_CHECK(file.good()) << "Failed to append to " << path;
+    }
+
+    const int num_delta_segments = num_delta_segments_ + 1;
+    ResetPersistenceState(path);
+    num_delta_segments_ = num_delta_segments;
+  }
+
+  int NumDeltaSegments() const override { return num_delta_segments_; }
+
+ private:
+  using WordIds =
+      Eigen::Matrix<int64_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+  // Add the entries of the descriptors of an image to the inverted index,
+  // whose visual words start at the given row of word_ids.
+  void AddEntries(const IndexOptions& options,
+                  const int image_id,
+                  const FeatureKeypoints& keypoints,
+                  const FeatureDescriptorsFloatData& descriptors,
+                  const WordIds& word_ids,
+                  const Eigen::Index word_ids_offset) {
+    for (Eigen::Index i = 0; i < descriptors.rows(); ++i) {
+      const auto& descriptor = descriptors.row(i);
+
+      typename InvertedIndexType::GeomType geometry;
+      geometry.x = keypoints[i].x;
+      geometry.y = keypoints[i].y;
+      geometry.scale = keypoints[i].ComputeScale();
+      geometry.orientation = keypoints[i].ComputeOrientation();
+
+      for (int n = 0; n < options.num_neighbors; ++n) {
+        const int64_t word_id = word_ids(word_ids_offset + i, n);
+        if (word_id != InvertedIndexType::kInvalidWordId) {
+          EntryType entry;
+          entry.image_id = image_id;
+          entry.feature_idx = i;
+          entry.geometry = geometry;
+          inverted_index_.ConvertToBinaryDescriptor(
+              word_id, descriptor, &entry.descriptor);
+          inverted_index_.AddEntry(word_id, entry);
+          pending_entries_.emplace_back(word_id, entry);
+        }
+      }
+    }
+  }
+
+  // Quantize the descriptor space into visual words.
+  Eigen::RowMajorMatrixXf Quantize(
+      const BuildOptions& options,
+      const FeatureDescriptorsFloatData& descriptors) const {
+    THROW_CHECK_EQ(descriptors.cols(), kDescDim);
+
+    VLOG(2) << "Clustering " << descriptors.rows()
+            << " descriptors using kmeans";
+
+    faiss::Clustering clustering(kDescDim, options.num_visual_words);
+    clustering.niter = options.num_iterations;
+    clustering.nredo = options.num_rounds;
+    clustering.verbose = VLOG_IS_ON(3);
+
+    if (options.use_gpu) {
+#ifdef COLMAP_FAISS_GPU_ENABLED
+      TrainClusteringOnGPU(options.gpu_index, descriptors, &clustering);
+#else
+      LOG(FATAL_THROW) << "Cannot use GPU clustering without faiss GPU "
+                          "support. Set use_gpu to false.";
+#endif
+    } else {
+      faiss::IndexFlatL2 index(kDescDim);
+      clustering.train(descriptors.rows(), descriptors.data(), index);
+    }
+
+    VLOG(2) << "Quantized into " << options.num_visual_words
+            << " visual words with error "
+            << clustering.iteration_stats.back().obj;
+
+    return Eigen::Map<const Eigen::RowMajorMatrixXf>(
+        clustering.centroids.data(), options.num_visual_words, kDescDim);
+  }
+
+  // Query for nearest neighbor images and return nearest neighbor visual word
+  // identifiers for each descriptor.
+  void QueryAndFindWordIds(const QueryOptions& options,
+                           const FeatureDescriptorsFloatData& descriptors,
+                           std::vector<ImageScore>* image_scores,
+                           WordIds* word_ids) const {
+    THROW_CHECK(prepared_);
+    THROW_CHECK_EQ(descriptors.cols(), kDescDim);
+
+    if (descriptors.rows() == 0) {
+      image_scores->clear();
+      return;
+    }
+
+    *word_ids = FindWordIds(descriptors,
+                            options.num_neighbors,
+                            options.num_checks,
+                            options.num_threads);
+    inverted_index_.Query(descriptors, *word_ids, image_scores);
+
+    SortAndTruncateImageScores(options, image_scores);
+  }
+
+  // Sorts the image scores in descending order and keeps the
+  // options.max_num_images top-ranked images.
+  void SortAndTruncateImageScores(const QueryOptions& options,
+                                  std::vector<ImageScore>* image_scores) const {
+    auto SortFunc = [](const ImageScore& score1, const ImageScore& score2) {
+      return score1.score > score2.score;
+    };
+
+    const size_t num_images =
+        (options.max_num_images >= 0)
+            ? std::min<size_t>(image_scores->size(), options.max_num_images)
+            : image_scores->size();
+
+    // NOLINTNEXTLINE(bugprone-branch-clone)
+    if (num_images == image_scores->size()) {
+      std::sort(image_scores->begin(), image_scores->end(), SortFunc);
+    } else {
+      std::partial_sort(image_scores->begin(),
+                        image_scores->begin() + num_images,
+                        image_scores->end(),
+                        SortFunc);
+      image_scores->resize(num_images);
+    }
+  }
+
+  // Marks the beginning of a delta segment appended to an index file.
+  static constexpr int kDeltaSegmentMarker = 0x544c4544;
+
+  // Reads and applies all complete delta segments following the inverted
+  // index in the given stream. Returns the end position of the valid data.
+  uintmax_t ReadDeltaSegments(std::istream* file) {
+    num_delta_segments_ = 0;
+    uintmax_t end_pos = file->tellg();
+    while (file->peek() != std::char_traits<char>::eof()) {
+      const int marker = ReadBinaryLittleEndian<int>(file);
+      if (!file->good() || marker != kDeltaSegmentMarker) {
+        LOG(WARNING) << "Ignoring invalid trailing data in visual index.";
+        break;
+      }
+
+      std::vector<int> image_ids(ReadBinaryLittleEndian<uint32_t>(file));
+      for (int& image_id : image_ids) {
+        image_id = ReadBinaryLittleEndian<int>(file);
+      }
+      const uint64_t num_entries = ReadBinaryLittleEndian<uint64_t>(file);
+      std::vector<std::pair<int64_t, EntryType>> entries;
+      for (uint64_t i = 0; i < num_entries && file->good(); ++i) {
+        const int64_t word_id = ReadBinaryLittleEndian<int64_t>(file);
+        EntryType entry;
+        entry.Read(file);
+        entries.emplace_back(word_id, entry);
+      }
+      if (!file->good()) {
+        LOG(WARNING) << "Ignoring incomplete delta segment in visual index.";
+        break;
+      }
+
+      image_ids_.insert(image_ids.begin(), image_ids.end());
+      for (const auto& [word_id, entry] : entries) {
+        THROW_CHECK_LT(word_id, inverted_index_.NumVisualWords());
+        inverted_index_.AddEntry(word_id, entry);
+      }
+      ++num_delta_segments_;
+      end_pos = file->tellg();
+    }
+
+    if (num_delta_segments_ > 0) {
+      inverted_index_.Finalize();
+    }
+
+    return end_pos;
+  }
+
+  // Resets the state of the index file, after the index was read from or
+  // written to the given path, such that all added images are persisted.
+  void ResetPersistenceState(const std::filesystem::path& index_path) const {
+    index_path_ = index_path;
+    index_file_size_ =
+        index_path.empty() ? 0 : std::filesystem::file_size(index_path);
+    num_delta_segments_ = 0;
+    pending_image_ids_.clear();
+    pending_entries_.clear();
+  }
+
+  // Re-ranks the top-ranked images by spatial verification, if enabled.
+  void VerifyImageScores(const QueryOptions& options,
+                         const FeatureKeypoints& keypoints,
+                         const FeatureDescriptorsFloat& descriptors,
+                         const WordIds& word_ids,
+                         std::vector<ImageScore>* image_scores) const {
     if (options.num_images_after_verification <= 0) {
       return;
     }
@@ -197,6 +694,8 @@ class FaissVisualIndex : public VisualIndex {
     // Find matches for top-ranked images
     using OrderedMatchListType = std::vector<
         std::pair<float, std::pair<const EntryType*, const EntryType*>>>;
+    using FeatureMatchListsType =
+        std::unordered_map<int, OrderedMatchListType>;
 
     // Reference our matches (with their lowest distance) for both
     // {query feature => db feature} and vice versa.
@@ -280,15 +779,10 @@ class FaissVisualIndex : public VisualIndex {
       }
     }
 
-    for (auto& image_score : *image_scores) {
-      auto& query_matches = query_to_db_matches[image_score.image_id];
-      auto& db_matches = db_to_query_matches[image_score.image_id];
-
-      // No matches found.
-      if (query_matches.empty()) {
-        continue;
-      }
-
+    // Enforces 1-to-1 matching between the query and database features of one
+    // image and returns the number of spatially verified inliers.
+    auto VerifyImage = [](FeatureMatchListsType& query_matches,
+                          FeatureMatchListsType& db_matches) {
       // Enforce 1-to-1 matching: Build Fibonacci heaps for the query and
       // database features, ordered by the minimum number of matches per
       // feature. We'll select these matches one at a time. For convenience,
@@ -403,192 +897,107 @@ class FaissVisualIndex : public VisualIndex {
 
       // Finally, run verification for the current image.
       VoteAndVerifyOptions vote_and_verify_options;
-      image_score.score += VoteAndVerify(vote_and_verify_options, matches);
-    }
-
-    // Re-rank the images using the spatial verification scores.
-
-    const size_t num_images = std::min<size_t>(
-        image_scores->size(), options.num_images_after_verification);
-
-    auto SortFunc = [](const ImageScore& score1, const ImageScore& score2) {
-      return score1.score > score2.score;
+      return VoteAndVerify(vote_and_verify_options, matches);
     };
 
-    // NOLINTNEXTLINE(bugprone-branch-clone)
-    if (num_images == image_scores->size()) {
-      std::sort(image_scores->begin(), image_scores->end(), SortFunc);
-    } else {
-      std::partial_sort(image_scores->begin(),
-                        image_scores->begin() + num_images,
-                        image_scores->end(),
-                        SortFunc);
-      image_scores->resize(num_images);
+    // The verification score is bounded by the number of 1-to-1 matches,
+    // which gives an upper bound on the final score of each image. Images
+    // without matches keep their score and it is final.
+    struct Candidate {
+      ImageScore* image_score = nullptr;
+      FeatureMatchListsType* query_matches = nullptr;
+      FeatureMatchListsType* db_matches = nullptr;
+      float max_score = 0;
+    };
+    std::vector<Candidate> candidates;
+    std::vector<float> final_scores;
+    for (auto& image_score : *image_scores) {
+      const auto query_matches = query_to_db_matches.find(image_score.image_id);
+      if (query_matches == query_to_db_matches.end() ||
+          query_matches->second.empty()) {
+        final_scores.push_back(image_score.score);
+        continue;
+      }
+      Candidate candidate;
+      candidate.image_score = &image_score;
+      candidate.query_matches = &query_matches->second;
+      candidate.db_matches = &db_to_query_matches.at(image_score.image_id);
+      candidate.max_score =
+          image_score.score + static_cast<float>(std::min(
+                                  candidate.query_matches->size(),
+                                  candidate.db_matches->size()));
+      candidates.push_back(candidate);
     }
-  }
-
-  void Prepare() override {
-    inverted_index_.Finalize();
-    prepared_ = true;
-  }
-
-  void Build(const BuildOptions& options,
-             const FeatureDescriptorsFloat& descriptors) override {
-    THROW_CHECK_EQ(descriptors.data.cols(), kDescDim);
-
-    feature_type_ = descriptors.type;
-
-    const Eigen::RowMajorMatrixXf visual_words =
-        Quantize(options, descriptors.data);
-    THROW_CHECK_EQ(visual_words.cols(), kDescDim);
-
-    index_ = BuildFaissIndex(options, visual_words);
-
-    // Initialize a new inverted index.
-    inverted_index_ = InvertedIndexType();
-    inverted_index_.Initialize(index_->ntotal);
-    VLOG(2) << "Initialized inverted index";
 
-    // Generate descriptor projection matrix.
-    inverted_index_.GenerateHammingEmbeddingProjection();
-    VLOG(2) << "Generated hamming embedding";
-
-    // Learn the Hamming embedding.
-    const int kNumNeighbors = 1;
-    const WordIds word_ids = FindWordIds(descriptors.data,
-                                         kNumNeighbors,
-                                         options.num_checks,
-                                         options.num_threads);
-    inverted_index_.ComputeHammingEmbedding(descriptors.data, word_ids);
-    VLOG(2) << "Computed hamming embeddings";
-  }
-
-  void ReadFromFaiss(const std::filesystem::path& path,
-                     long offset,
-                     FeatureExtractorType feature_type) override {
-    feature_type_ = feature_type;
-
-    FILE* fin = nullptr;
-#ifdef _MSC_VER
-    THROW_CHECK_EQ(fopen_s(&fin, path.string().c_str(), "rb"), 0);
-#else
-    fin = fopen(path.string().c_str(), "rb");
-#endif
-    THROW_CHECK_NOTNULL(fin);
-    fseek(fin, offset, SEEK_SET);
-    index_ = std::unique_ptr<faiss::IndexIVF>(dynamic_cast<faiss::IndexIVF*>(
-        THROW_CHECK_NOTNULL(faiss::read_index(fin))));
-    offset = ftell(fin);
-    fclose(fin);
-
-    // Read the inverted index.
-    std::ifstream file(path, std::ios::binary);
-    THROW_CHECK_FILE_OPEN(file, path);
-    file.seekg(offset, std::ios::beg);
-    inverted_index_.Read(&file);
-    image_ids_.clear();
-    inverted_index_.GetImageIds(&image_ids_);
-  }
-
-  void Write(const std::filesystem::path& path) const override {
-    THROW_CHECK_NOTNULL(index_);
-
-    // Write index metadata header.
-
-    {
-      std::ofstream file(path, std::ios::binary);
-      THROW_CHECK_FILE_OPEN(file, path);
-      const int kFileVersion = 2;
-      file.write(reinterpret_cast<const char*>(&kFileVersion), sizeof(int));
-      const int desc_dim = kDescDim;
-      file.write(reinterpret_cast<const char*>(&desc_dim), sizeof(int));
-      const int embedding_dim = kEmbeddingDim;
-      file.write(reinterpret_cast<const char*>(&embedding_dim), sizeof(int));
-      const int feature_type = static_cast<int>(feature_type_);
-      file.write(reinterpret_cast<const char*>(&feature_type), sizeof(int));
+    // Verify the images in the order of their maximum achievable score, in
+    // rounds of one image per thread. Stop early, once the remaining images
+    // cannot make it into the re-ranked top images anymore.
+    std::sort(candidates.begin(),
+              candidates.end(),
+              [](const Candidate& candidate1, const Candidate& candidate2) {
+                return candidate1.max_score > candidate2.max_score;
+              });
+
+    const size_t num_threads = std::max<size_t>(
+        1,
+        std::min<size_t>(GetEffectiveNumThreads(options.num_threads),
+                         candidates.size()));
+    std::unique_ptr<ThreadPool> thread_pool;
+    if (num_threads > 1) {
+      thread_pool = std::make_unique<ThreadPool>(num_threads);
     }
 
-    // Write the visual words search index.
-
-    {
-      FILE* fout = nullptr;
-#ifdef _MSC_VER
-      THROW_CHECK_EQ(fopen_s(&fout, path.string().c_str(), "ab"), 0);
-#else
-      fout = fopen(path.string().c_str(), "ab");
-#endif
-      THROW_CHECK_NOTNULL(fout);
-      faiss::write_index(index_.get(), fout);
-      fclose(fout);
-    }
+    const size_t num_top_images = options.num_images_after_verification;
+    std::vector<std::future<void>> futures;
+    futures.reserve(num_threads);
+    for (size_t begin_idx = 0; begin_idx < candidates.size();
+         begin_idx += num_threads) {
+      if (final_scores.size() >= num_top_images) {
+        std::nth_element(final_scores.begin(),
+                         final_scores.begin() + num_top_images - 1,
+                         final_scores.end(),
+                         std::greater<float>());
+        if (candidates[begin_idx].max_score <
+            final_scores[num_top_images - 1]) {
+          break;
+        }
+      }
 
-    // Write the inverted index.
+      const size_t end_idx =
+          std::min(candidates.size(), begin_idx + num_threads);
+      auto VerifyCandidate = [&VerifyImage](Candidate* candidate) {
+        candidate->image_score->score +=
+            VerifyImage(*candidate->query_matches, *candidate->db_matches);
+      };
+      if (thread_pool) {
+        futures.clear();
+        for (size_t i = begin_idx; i < end_idx; ++i) {
+          futures.push_back(
+              thread_pool->AddTask(VerifyCandidate, &candidates[i]));
+        }
+        for (auto& future : futures) {
+          future.get();
+        }
+      } else {
+        for (size_t i = begin_idx; i < end_idx; ++i) {
+          VerifyCandidate(&candidates[i]);
+        }
+      }
 
-    {
-      std::ofstream file(path, std::ios::binary | std::ios::app);
-      THROW_CHECK_FILE_OPEN(file, path);
-      inverted_index_.Write(&file);
+      for (size_t i = begin_idx; i < end_idx; ++i) {
+        final_scores.push_back(candidates[i].image_score->score);
+      }
     }
-  }
-
- private:
-  using WordIds =
-      Eigen::Matrix<int64_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
-
-  // Quantize the descriptor space into visual words.
-  Eigen::RowMajorMatrixXf Quantize(
-      const BuildOptions& options,
-      const FeatureDescriptorsFloatData& descriptors) const {
-    THROW_CHECK_EQ(descriptors.cols(), kDescDim);
-
-    VLOG(2) << "Clustering " << descriptors.rows()
-            << " descriptors using kmeans";
-
-    faiss::Clustering clustering(kDescDim, options.num_visual_words);
-    clustering.niter = options.num_iterations;
-    clustering.nredo = options.num_rounds;
-    clustering.verbose = VLOG_IS_ON(3);
-
-    faiss::IndexFlatL2 index(kDescDim);
-    clustering.train(descriptors.rows(), descriptors.data(), index);
-
-    VLOG(2) << "Quantized into " << options.num_visual_words
-            << " visual words with error "
-            << clustering.iteration_stats.back().obj;
-
-    return Eigen::Map<const Eigen::RowMajorMatrixXf>(
-        clustering.centroids.data(), options.num_visual_words, kDescDim);
-  }
 
-  // Query for nearest neighbor images and return nearest neighbor visual word
-  // identifiers for each descriptor.
-  void QueryAndFindWordIds(const QueryOptions& options,
-                           const FeatureDescriptorsFloatData& descriptors,
-                           std::vector<ImageScore>* image_scores,
-                           WordIds* word_ids) const {
-    THROW_CHECK(prepared_);
-    THROW_CHECK_EQ(descriptors.cols(), kDescDim);
-
-    if (descriptors.rows() == 0) {
-      image_scores->clear();
-      return;
-    }
+    // Re-rank the images using the spatial verification scores.
 
-    *word_ids = FindWordIds(descriptors,
-                            options.num_neighbors,
-                            options.num_checks,
-                            options.num_threads);
-    inverted_index_.Query(descriptors, *word_ids, image_scores);
+    const size_t num_images = std::min<size_t>(
+        image_scores->size(), options.num_images_after_verification);
 
     auto SortFunc = [](const ImageScore& score1, const ImageScore& score2) {
       return score1.score > score2.score;
     };
 
-    const size_t num_images =
-        (options.max_num_images >= 0)
-            ? std::min<size_t>(image_scores->size(), options.max_num_images)
-            : image_scores->size();
-
     // NOLINTNEXTLINE(bugprone-branch-clone)
     if (num_images == image_scores->size()) {
       std::sort(image_scores->begin(), image_scores->end(), SortFunc);
@@ -647,6 +1056,15 @@ class FaissVisualIndex : public VisualIndex {
   // Identifiers of all indexed images.
   std::unordered_set<int> image_ids_;
 
+  // The index file, from which the index was read or to which it was last
+  // written, and the images and entries added since then. Mutable, because
+  // writing the index persists all added images.
+  mutable std::filesystem::path index_path_;
+  mutable uintmax_t index_file_size_ = 0;
+  mutable int num_delta_segments_ = 0;
+  mutable std::vector<int> pending_image_ids_;
+  mutable std::vector<std::pair<int64_t, EntryType>> pending_entries_;
+
   // Whether the index is prepared.
   bool prepared_;
 
@@ -35,6 +35,7 @@
 
 #include <filesystem>
 #include <memory>
+#include <string>
 
 #include <Eigen/Core>
 
@@ -99,6 +100,15 @@ class VisualIndex {
 
     // Number of threads to use.
     int num_threads = -1;
+
+    // Whether to use the GPU for the k-means clustering of the visual words.
+    // Requires COLMAP to be built with faiss GPU support.
+    bool use_gpu = false;
+
+    // Index of the GPU used for clustering. For multi-GPU clustering, you
+    // should separate multiple GPU indices by comma, e.g., "0,1,2,3". By
+    // default, all available GPUs are used.
+    std::string gpu_index = "-1";
   };
 
   // Create visual index with specific input feature descriptor dimension and
@@ -124,6 +134,16 @@ class VisualIndex {
                    const FeatureKeypoints& keypoints,
                    const FeatureDescriptorsFloat& descriptors) = 0;
 
+  // Add multiple images to the visual index at once. The descriptors of all
+  // images are quantized with a single nearest neighbor search, which makes
+  // better use of the threads than adding the images one by one. Produces the
+  // same index as adding each image separately.
+  virtual void AddBatch(
+      const IndexOptions& options,
+      const std::vector<int>& image_ids,
+      const std::vector<const FeatureKeypoints*>& keypoints,
+      const std::vector<const FeatureDescriptorsFloat*>& descriptors) = 0;
+
   // Check if an image has been indexed.
   virtual bool IsImageIndexed(int image_id) const = 0;
 
@@ -138,6 +158,19 @@ class VisualIndex {
                      const FeatureDescriptorsFloat& descriptors,
                      std::vector<ImageScore>* image_scores) const = 0;
 
+  // Query for the most similar images of multiple query images at once. The
+  // descriptors of all queries are quantized with a single nearest neighbor
+  // search and the inverted files are scored in the order of their visual
+  // words for all queries together, which amortizes the memory traffic over
+  // the queries. The keypoints are only required for spatial verification.
+  // Returns the same results as querying each image separately, up to
+  // floating point rounding of the accumulated scores.
+  virtual void QueryBatch(
+      const QueryOptions& options,
+      const std::vector<const FeatureKeypoints*>& keypoints,
+      const std::vector<const FeatureDescriptorsFloat*>& descriptors,
+      std::vector<std::vector<ImageScore>>* image_scores) const = 0;
+
   // Prepare the index after adding images and before querying.
   virtual void Prepare() = 0;
 
@@ -152,6 +185,19 @@ class VisualIndex {
       const std::filesystem::path& vocab_tree_path);
   virtual void Write(const std::filesystem::path& path) const = 0;
 
+  // Append the images added since the index was last read or written as a
+  // delta segment to the end of the index file at the given path, from which
+  // this index was read or to which it was last written. This avoids
+  // rewriting the whole index when adding a few images to a large index.
+  // Delta segments are applied when reading the index, and Write compacts
+  // the index into a file without delta segments.
+  virtual void AppendImages(const std::filesystem::path& path) = 0;
+
+  // The number of delta segments in the index file, from which this index was
+  // read, plus the number of segments appended since then. Can be used to
+  // decide when to compact the index file.
+  virtual int NumDeltaSegments() const = 0;
+
  protected:
   virtual void ReadFromFaiss(const std::filesystem::path& path,
                              long offset,
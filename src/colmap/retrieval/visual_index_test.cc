@@ -34,6 +34,8 @@
 #include "colmap/util/file.h"
 #include "colmap/util/testing.h"
 
+#include <filesystem>
+#include <fstream>
 #include <sstream>
 
 #include <gtest/gtest.h>
@@ -185,6 +187,228 @@ TEST_P(ParameterizedVisualIndexTests, ReadWrite) {
   EXPECT_FALSE(visual_index->IsImageIndexed(3));
 }
 
+TEST_P(ParameterizedVisualIndexTests, AppendImages) {
+  const auto [desc_dim, embedding_dim] = GetParam();
+  const auto test_dir = CreateTestDir();
+  const auto vocab_tree_path = test_dir / "vocab_tree.bin";
+
+  VisualIndex::BuildOptions build_options;
+  // Keep test runtimes low.
+  build_options.num_iterations = 10;
+  build_options.num_rounds = 1;
+  build_options.num_visual_words = 5;
+
+  auto visual_index = VisualIndex::Create(desc_dim, embedding_dim);
+  visual_index->Build(
+      build_options,
+      CreateRandomDescriptors(200, desc_dim, FeatureExtractorType::SIFT));
+  EXPECT_ANY_THROW(visual_index->AppendImages(vocab_tree_path));
+
+  VisualIndex::IndexOptions index_options;
+  std::vector<FeatureDescriptorsFloat> descriptors;
+  for (int image_id = 1; image_id <= 4; ++image_id) {
+    descriptors.push_back(
+        CreateRandomDescriptors(50, desc_dim, FeatureExtractorType::SIFT));
+  }
+  const FeatureKeypoints keypoints(50);
+  visual_index->Add(index_options, 1, keypoints, descriptors[0]);
+  visual_index->Write(vocab_tree_path);
+  const auto index_file_size = std::filesystem::file_size(vocab_tree_path);
+
+  visual_index->Add(index_options, 2, keypoints, descriptors[1]);
+  visual_index->AppendImages(vocab_tree_path);
+  EXPECT_EQ(visual_index->NumDeltaSegments(), 1);
+  EXPECT_GT(std::filesystem::file_size(vocab_tree_path), index_file_size);
+
+  auto read_visual_index = VisualIndex::Read(vocab_tree_path);
+  EXPECT_EQ(read_visual_index->NumDeltaSegments(), 1);
+  EXPECT_EQ(read_visual_index->NumImages(), 2);
+  EXPECT_TRUE(read_visual_index->IsImageIndexed(2));
+  read_visual_index->Add(index_options, 3, keypoints, descriptors[2]);
+  read_visual_index->AppendImages(vocab_tree_path);
+  EXPECT_EQ(read_visual_index->NumDeltaSegments(), 2);
+
+  // Appending to another file than the index file is not allowed.
+  read_visual_index->Add(index_options, 4, keypoints, descriptors[3]);
+  EXPECT_ANY_THROW(read_visual_index->AppendImages(test_dir / "other.bin"));
+  read_visual_index->AppendImages(vocab_tree_path);
+
+  // An incomplete trailing segment is ignored.
+  {
+    std::ofstream file(vocab_tree_path, std::ios::binary | std::ios::app);
+    file.write("\x44\x45", 2);
+  }
+  read_visual_index = VisualIndex::Read(vocab_tree_path);
+  EXPECT_EQ(read_visual_index->NumDeltaSegments(), 3);
+  EXPECT_EQ(read_visual_index->NumImages(), 4);
+  read_visual_index->Prepare();
+  visual_index->Add(index_options, 3, keypoints, descriptors[2]);
+  visual_index->Add(index_options, 4, keypoints, descriptors[3]);
+  visual_index->Prepare();
+
+  // The appended index scores like the index with all images.
+  VisualIndex::QueryOptions query_options;
+  std::vector<ImageScore> image_scores;
+  visual_index->Query(query_options, descriptors[2], &image_scores);
+  std::vector<ImageScore> read_image_scores;
+  read_visual_index->Query(query_options, descriptors[2], &read_image_scores);
+  ASSERT_EQ(read_image_scores.size(), image_scores.size());
+  for (size_t i = 0; i < image_scores.size(); ++i) {
+    EXPECT_EQ(read_image_scores[i].image_id, image_scores[i].image_id);
+    EXPECT_NEAR(read_image_scores[i].score, image_scores[i].score, 1e-6);
+  }
+
+  // Writing compacts the index.
+  read_visual_index->Write(vocab_tree_path);
+  EXPECT_EQ(read_visual_index->NumDeltaSegments(), 0);
+  EXPECT_EQ(VisualIndex::Read(vocab_tree_path)->NumImages(), 4);
+}
+
+TEST_P(ParameterizedVisualIndexTests, BuildGPU) {
+  const auto [desc_dim, embedding_dim] = GetParam();
+
+  VisualIndex::BuildOptions build_options;
+  // Keep test runtimes low.
+  build_options.num_iterations = 10;
+  build_options.num_rounds = 1;
+  build_options.num_visual_words = 5;
+  build_options.use_gpu = true;
+
+  const FeatureDescriptorsFloat descriptors =
+      CreateRandomDescriptors(200, desc_dim, FeatureExtractorType::SIFT);
+  auto visual_index = VisualIndex::Create(desc_dim, embedding_dim);
+#ifdef COLMAP_FAISS_GPU_ENABLED
+  visual_index->Build(build_options, descriptors);
+  EXPECT_EQ(visual_index->NumVisualWords(), 5);
+#else
+  EXPECT_ANY_THROW(visual_index->Build(build_options, descriptors));
+#endif
+}
+
+TEST_P(ParameterizedVisualIndexTests, QueryBatch) {
+  const auto [desc_dim, embedding_dim] = GetParam();
+
+  VisualIndex::BuildOptions build_options;
+  // Keep test runtimes low.
+  build_options.num_iterations = 10;
+  build_options.num_rounds = 1;
+  build_options.num_visual_words = 5;
+
+  auto visual_index = VisualIndex::Create(desc_dim, embedding_dim);
+  visual_index->Build(
+      build_options,
+      CreateRandomDescriptors(200, desc_dim, FeatureExtractorType::SIFT));
+
+  VisualIndex::IndexOptions index_options;
+  std::vector<FeatureKeypoints> keypoints;
+  std::vector<FeatureDescriptorsFloat> descriptors;
+  for (int image_id = 1; image_id <= 5; ++image_id) {
+    keypoints.emplace_back(30 + image_id);
+    descriptors.push_back(CreateRandomDescriptors(
+        30 + image_id, desc_dim, FeatureExtractorType::SIFT));
+    visual_index->Add(index_options,
+                      image_id,
+                      keypoints.back(),
+                      descriptors.back());
+  }
+  visual_index->Prepare();
+
+  std::vector<const FeatureKeypoints*> keypoints_ptrs;
+  std::vector<const FeatureDescriptorsFloat*> descriptors_ptrs;
+  for (size_t i = 0; i < descriptors.size(); ++i) {
+    keypoints_ptrs.push_back(&keypoints[i]);
+    descriptors_ptrs.push_back(&descriptors[i]);
+  }
+
+  VisualIndex::QueryOptions query_options;
+  query_options.max_num_images = 3;
+  std::vector<std::vector<ImageScore>> batch_image_scores;
+  visual_index->QueryBatch(
+      query_options, keypoints_ptrs, descriptors_ptrs, &batch_image_scores);
+  ASSERT_EQ(batch_image_scores.size(), descriptors.size());
+  for (size_t i = 0; i < descriptors.size(); ++i) {
+    std::vector<ImageScore> image_scores;
+    visual_index->Query(query_options, descriptors[i], &image_scores);
+    ASSERT_EQ(batch_image_scores[i].size(), image_scores.size());
+    for (size_t j = 0; j < image_scores.size(); ++j) {
+      EXPECT_EQ(batch_image_scores[i][j].image_id, image_scores[j].image_id);
+      EXPECT_NEAR(batch_image_scores[i][j].score, image_scores[j].score, 1e-5);
+    }
+  }
+
+  // An empty batch returns no results.
+  visual_index->QueryBatch(query_options, {}, {}, &batch_image_scores);
+  EXPECT_TRUE(batch_image_scores.empty());
+}
+
+TEST_P(ParameterizedVisualIndexTests, AddBatch) {
+  const auto [desc_dim, embedding_dim] = GetParam();
+  const auto test_dir = CreateTestDir();
+  const auto vocab_tree_path = test_dir / "vocab_tree.bin";
+
+  VisualIndex::BuildOptions build_options;
+  // Keep test runtimes low.
+  build_options.num_iterations = 10;
+  build_options.num_rounds = 1;
+  build_options.num_visual_words = 5;
+
+  auto visual_index = VisualIndex::Create(desc_dim, embedding_dim);
+  visual_index->Build(
+      build_options,
+      CreateRandomDescriptors(200, desc_dim, FeatureExtractorType::SIFT));
+  visual_index->Write(vocab_tree_path);
+  auto batch_visual_index = VisualIndex::Read(vocab_tree_path);
+
+  VisualIndex::IndexOptions index_options;
+  std::vector<int> image_ids;
+  std::vector<FeatureKeypoints> keypoints;
+  std::vector<FeatureDescriptorsFloat> descriptors;
+  for (int image_id = 1; image_id <= 5; ++image_id) {
+    image_ids.push_back(image_id);
+    keypoints.emplace_back(30 + image_id);
+    descriptors.push_back(CreateRandomDescriptors(
+        30 + image_id, desc_dim, FeatureExtractorType::SIFT));
+    visual_index->Add(index_options,
+                      image_id,
+                      keypoints.back(),
+                      descriptors.back());
+  }
+  visual_index->Prepare();
+
+  std::vector<const FeatureKeypoints*> keypoints_ptrs;
+  std::vector<const FeatureDescriptorsFloat*> descriptors_ptrs;
+  for (size_t i = 0; i < descriptors.size(); ++i) {
+    keypoints_ptrs.push_back(&keypoints[i]);
+    descriptors_ptrs.push_back(&descriptors[i]);
+  }
+  batch_visual_index->AddBatch(
+      index_options, image_ids, keypoints_ptrs, descriptors_ptrs);
+  // Already indexed images are skipped.
+  batch_visual_index->AddBatch(
+      index_options, image_ids, keypoints_ptrs, descriptors_ptrs);
+  batch_visual_index->Prepare();
+  EXPECT_EQ(batch_visual_index->NumImages(), visual_index->NumImages());
+
+  VisualIndex::QueryOptions query_options;
+  for (size_t i = 0; i < descriptors.size(); ++i) {
+    EXPECT_TRUE(batch_visual_index->IsImageIndexed(image_ids[i]));
+    std::vector<ImageScore> image_scores;
+    visual_index->Query(query_options, descriptors[i], &image_scores);
+    std::vector<ImageScore> batch_image_scores;
+    batch_visual_index->Query(
+        query_options, descriptors[i], &batch_image_scores);
+    ASSERT_EQ(batch_image_scores.size(), image_scores.size());
+    for (size_t j = 0; j < image_scores.size(); ++j) {
+      EXPECT_EQ(batch_image_scores[j].image_id, image_scores[j].image_id);
+      EXPECT_NEAR(batch_image_scores[j].score, image_scores[j].score, 1e-5);
+    }
+  }
+
+  // Mismatched input sizes are rejected.
+  EXPECT_ANY_THROW(batch_visual_index->AddBatch(
+      index_options, {6}, keypoints_ptrs, descriptors_ptrs));
+}
+
 TEST_P(ParameterizedVisualIndexTests, SpatialVerification) {
   const auto [desc_dim, embedding_dim] = GetParam();
 
@@ -275,6 +499,24 @@ TEST_P(ParameterizedVisualIndexTests, SpatialVerification) {
     }
   }
 
+  // Parallel verification and early termination for fewer re-ranked images
+  // must not change the top images.
+  for (const int num_threads : {1, 3}) {
+    query_options.num_threads = num_threads;
+    query_options.num_images_after_verification = 2;
+    std::vector<ImageScore> image_scores_top;
+    visual_index->Query(
+        query_options, query_keypoints, descriptors, &image_scores_top);
+    ASSERT_EQ(image_scores_top.size(), 2);
+    for (int i = 0; i < 2; ++i) {
+      EXPECT_EQ(image_scores_top[i].image_id,
+                image_scores_with_verification[i].image_id);
+      EXPECT_EQ(image_scores_top[i].score,
+                image_scores_with_verification[i].score);
+    }
+  }
+  query_options.num_threads = -1;
+
   // Test with max_num_images constraint, should respect max_num_images.
   query_options.max_num_images = 2;
   query_options.num_images_after_verification = 4;
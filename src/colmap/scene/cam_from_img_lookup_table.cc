@@ -0,0 +1,135 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/scene/cam_from_img_lookup_table.h"
+
+#include "colmap/util/logging.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace colmap {
+
+CamFromImgLookupTable::CamFromImgLookupTable(const Camera& camera,
+                                             const int grid_step,
+                                             const double max_error)
+    : camera_(camera), grid_step_(grid_step) {
+  THROW_CHECK(camera_.IsPerspective());
+  THROW_CHECK_GT(grid_step_, 0);
+  THROW_CHECK_GE(max_error, 0);
+
+  num_cells_x_ =
+      (static_cast<int>(camera_.width) + grid_step_ - 1) / grid_step_;
+  num_cells_y_ =
+      (static_cast<int>(camera_.height) + grid_step_ - 1) / grid_step_;
+
+  const int num_nodes_x = num_cells_x_ + 1;
+  const int num_nodes_y = num_cells_y_ + 1;
+  nodes_.resize(num_nodes_x * num_nodes_y);
+  std::vector<char> valid_nodes(nodes_.size(), 0);
+  for (int y = 0; y < num_nodes_y; ++y) {
+    for (int x = 0; x < num_nodes_x; ++x) {
+      const int idx = y * num_nodes_x + x;
+      if (const std::optional<Eigen::Vector2d> cam_point = camera_.CamFromImg(
+              Eigen::Vector2d(x * grid_step_, y * grid_step_));
+          cam_point.has_value() && cam_point->allFinite()) {
+        nodes_[idx] = *cam_point;
+        valid_nodes[idx] = 1;
+      }
+    }
+  }
+
+  // The interpolation error is measured in camera coordinates.
+  const double max_cam_error = camera_.CamFromImgThreshold(max_error);
+
+  interpolate_cells_.resize(num_cells_x_ * num_cells_y_, 0);
+  for (int y = 0; y < num_cells_y_; ++y) {
+    for (int x = 0; x < num_cells_x_; ++x) {
+      const int idx00 = y * num_nodes_x + x;
+      const int idx01 = idx00 + 1;
+      const int idx10 = idx00 + num_nodes_x;
+      const int idx11 = idx10 + 1;
+      if (!valid_nodes[idx00] || !valid_nodes[idx01] || !valid_nodes[idx10] ||
+          !valid_nodes[idx11]) {
+        continue;
+      }
+      const std::optional<Eigen::Vector2d> cam_point =
+          camera_.CamFromImg(Eigen::Vector2d((x + 0.5) * grid_step_,
+                                             (y + 0.5) * grid_step_));
+      if (!cam_point.has_value()) {
+        continue;
+      }
+      const Eigen::Vector2d interpolated_cam_point =
+          0.25 * (nodes_[idx00] + nodes_[idx01] + nodes_[idx10] +
+                  nodes_[idx11]);
+      if ((*cam_point - interpolated_cam_point).norm() <= max_cam_error) {
+        interpolate_cells_[y * num_cells_x_ + x] = 1;
+      }
+    }
+  }
+}
+
+std::optional<Eigen::Vector2d> CamFromImgLookupTable::CamFromImg(
+    const Eigen::Vector2d& image_point) const {
+  const double x = image_point.x() / grid_step_;
+  const double y = image_point.y() / grid_step_;
+  // Also rejects NaN coordinates.
+  if (!(x >= 0 && y >= 0 && x <= num_cells_x_ && y <= num_cells_y_)) {
+    return camera_.CamFromImg(image_point);
+  }
+
+  const int cell_x = std::min(static_cast<int>(x), num_cells_x_ - 1);
+  const int cell_y = std::min(static_cast<int>(y), num_cells_y_ - 1);
+  if (!interpolate_cells_[cell_y * num_cells_x_ + cell_x]) {
+    return camera_.CamFromImg(image_point);
+  }
+
+  const double dx = x - cell_x;
+  const double dy = y - cell_y;
+  const int num_nodes_x = num_cells_x_ + 1;
+  const int idx00 = cell_y * num_nodes_x + cell_x;
+  const int idx10 = idx00 + num_nodes_x;
+  return (1 - dy) * ((1 - dx) * nodes_[idx00] + dx * nodes_[idx00 + 1]) +
+         dy * ((1 - dx) * nodes_[idx10] + dx * nodes_[idx10 + 1]);
+}
+
+double CamFromImgLookupTable::InterpolatedCellRatio() const {
+  if (interpolate_cells_.empty()) {
+    return 0;
+  }
+  size_t num_interpolated_cells = 0;
+  for (const char interpolate : interpolate_cells_) {
+    num_interpolated_cells += interpolate;
+  }
+  return static_cast<double>(num_interpolated_cells) /
+         interpolate_cells_.size();
+}
+
+}  // namespace colmap
@@ -0,0 +1,81 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "colmap/scene/camera.h"
+#include "colmap/util/eigen_alignment.h"
+
+#include <optional>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace colmap {
+
+// Lookup table for the unprojection of a camera from image to camera
+// coordinates. For camera models with distortion, `Camera::CamFromImg` solves
+// for the undistorted point iteratively, which is expensive when unprojecting
+// many points of the same camera. The table stores the exact unprojection on a
+// regular pixel grid and bilinearly interpolates in between. During
+// construction, the interpolation error is measured at the center of each
+// grid cell. Cells exceeding the maximum error, cells with a failed
+// unprojection at any corner, and points outside the image fall back to the
+// exact unprojection.
+class CamFromImgLookupTable {
+ public:
+  // @param camera      The camera, which must be perspective.
+  // @param grid_step   Grid spacing in pixels.
+  // @param max_error   Maximum interpolation error in pixels.
+  explicit CamFromImgLookupTable(const Camera& camera,
+                                 int grid_step = 8,
+                                 double max_error = 0.01);
+
+  // Unproject point in image plane to camera frame, equivalent to
+  // `Camera::CamFromImg` up to the maximum error.
+  std::optional<Eigen::Vector2d> CamFromImg(
+      const Eigen::Vector2d& image_point) const;
+
+  // Fraction of grid cells that are interpolated rather than falling back to
+  // the exact unprojection.
+  double InterpolatedCellRatio() const;
+
+ private:
+  const Camera camera_;
+  const int grid_step_;
+  int num_cells_x_ = 0;
+  int num_cells_y_ = 0;
+  // Unprojected grid nodes in row-major order with (num_cells_x_ + 1) columns.
+  std::vector<Eigen::Vector2d> nodes_;
+  // Whether each cell in row-major order can be interpolated.
+  std::vector<char> interpolate_cells_;
+};
+
+}  // namespace colmap
@@ -0,0 +1,94 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/scene/cam_from_img_lookup_table.h"
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+void ExpectNearExact(const Camera& camera,
+                     const CamFromImgLookupTable& lookup_table,
+                     const double max_error) {
+  const double max_cam_error = camera.CamFromImgThreshold(max_error);
+  for (double y = -10; y <= camera.height + 10; y += 3.7) {
+    for (double x = -10; x <= camera.width + 10; x += 3.7) {
+      const Eigen::Vector2d image_point(x, y);
+      const std::optional<Eigen::Vector2d> expected =
+          camera.CamFromImg(image_point);
+      const std::optional<Eigen::Vector2d> actual =
+          lookup_table.CamFromImg(image_point);
+      ASSERT_EQ(expected.has_value(), actual.has_value());
+      if (expected.has_value()) {
+        // The error is only checked at the cell centers, so allow some slack.
+        EXPECT_LE((*expected - *actual).norm(), 2 * max_cam_error);
+      }
+    }
+  }
+}
+
+TEST(CamFromImgLookupTable, Pinhole) {
+  const Camera camera =
+      Camera::CreateFromModelId(1, CameraModelId::kPinhole, 100, 200, 150);
+  const CamFromImgLookupTable lookup_table(camera);
+  EXPECT_EQ(lookup_table.InterpolatedCellRatio(), 1);
+  ExpectNearExact(camera, lookup_table, 1e-6);
+}
+
+TEST(CamFromImgLookupTable, OpenCVFisheye) {
+  Camera camera = Camera::CreateFromModelId(
+      1, CameraModelId::kOpenCVFisheye, 100, 200, 150);
+  camera.params[4] = 0.1;
+  camera.params[5] = -0.05;
+  constexpr double kMaxError = 0.01;
+  const CamFromImgLookupTable lookup_table(camera, /*grid_step=*/8, kMaxError);
+  EXPECT_GT(lookup_table.InterpolatedCellRatio(), 0.5);
+  ExpectNearExact(camera, lookup_table, kMaxError);
+}
+
+TEST(CamFromImgLookupTable, ZeroMaxErrorFallsBackToExact) {
+  Camera camera =
+      Camera::CreateFromModelId(1, CameraModelId::kFullOpenCV, 100, 200, 150);
+  camera.params[4] = 0.2;
+  const CamFromImgLookupTable lookup_table(
+      camera, /*grid_step=*/8, /*max_error=*/0);
+  EXPECT_LT(lookup_table.InterpolatedCellRatio(), 1);
+  ExpectNearExact(camera, lookup_table, 0);
+}
+
+TEST(CamFromImgLookupTable, NonPerspective) {
+  const Camera camera = Camera::CreateFromModelId(
+      1, CameraModelId::kEquirectangular, 100, 200, 100);
+  EXPECT_ANY_THROW(CamFromImgLookupTable{camera});
+}
+
+}  // namespace
+}  // namespace colmap
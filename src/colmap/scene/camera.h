@@ -157,6 +157,19 @@ struct Camera {
   inline std::optional<Eigen::Vector2d> ImgFromCam(
       const Eigen::Vector3d& cam_point) const;
 
+  // Batched versions of CamFromImg, CamRayFromImg, and ImgFromCam, which
+  // dispatch on the camera model once for all points. Points that fail to
+  // (un)project are set to std::nullopt.
+  inline void CamFromImgBatch(
+      span<const Eigen::Vector2d> image_points,
+      span<std::optional<Eigen::Vector2d>> cam_points) const;
+  inline void CamRayFromImgBatch(
+      span<const Eigen::Vector2d> image_points,
+      span<std::optional<Eigen::Vector3d>> cam_rays) const;
+  inline void ImgFromCamBatch(
+      span<const Eigen::Vector3d> cam_points,
+      span<std::optional<Eigen::Vector2d>> image_points) const;
+
   // Rescale camera dimensions and accordingly the focal length and
   // and the principal point.
   void Rescale(double scale);
@@ -304,6 +317,27 @@ std::optional<Eigen::Vector2d> Camera::ImgFromCam(
   return CameraModelImgFromCam(model_id, params, cam_point);
 }
 
+void Camera::CamFromImgBatch(
+    span<const Eigen::Vector2d> image_points,
+    span<std::optional<Eigen::Vector2d>> cam_points) const {
+  THROW_CHECK_EQ(image_points.size(), cam_points.size());
+  CameraModelCamFromImgBatch(model_id, params, image_points, cam_points);
+}
+
+void Camera::CamRayFromImgBatch(
+    span<const Eigen::Vector2d> image_points,
+    span<std::optional<Eigen::Vector3d>> cam_rays) const {
+  THROW_CHECK_EQ(image_points.size(), cam_rays.size());
+  CameraModelCamRayFromImgBatch(model_id, params, image_points, cam_rays);
+}
+
+void Camera::ImgFromCamBatch(
+    span<const Eigen::Vector3d> cam_points,
+    span<std::optional<Eigen::Vector2d>> image_points) const {
+  THROW_CHECK_EQ(cam_points.size(), image_points.size());
+  CameraModelImgFromCamBatch(model_id, params, cam_points, image_points);
+}
+
 bool Camera::operator==(const Camera& other) const {
   return camera_id == other.camera_id && model_id == other.model_id &&
          width == other.width && height == other.height &&
@@ -319,6 +319,43 @@ TEST(Camera, ImgFromCam) {
             Eigen::Vector2d(0.0, 0.0));
 }
 
+TEST(Camera, Batch) {
+  const Camera camera = Camera::CreateFromModelId(
+      1, CameraModelId::kOpenCVFisheye, 100.0, 200, 100);
+  const std::vector<Eigen::Vector2d> image_points = {
+      Eigen::Vector2d(0, 0), Eigen::Vector2d(50, 60), Eigen::Vector2d(100, 50)};
+  const std::vector<Eigen::Vector3d> cam_points = {Eigen::Vector3d(0, 0, 1),
+                                                   Eigen::Vector3d(1, -1, 2),
+                                                   Eigen::Vector3d(0, 0, -1)};
+
+  std::vector<std::optional<Eigen::Vector2d>> batch_cam_points(
+      image_points.size());
+  camera.CamFromImgBatch({image_points.data(), image_points.size()},
+                         {batch_cam_points.data(), batch_cam_points.size()});
+  std::vector<std::optional<Eigen::Vector3d>> batch_cam_rays(
+      image_points.size());
+  camera.CamRayFromImgBatch({image_points.data(), image_points.size()},
+                            {batch_cam_rays.data(), batch_cam_rays.size()});
+  for (size_t i = 0; i < image_points.size(); ++i) {
+    EXPECT_EQ(batch_cam_points[i], camera.CamFromImg(image_points[i]));
+    EXPECT_EQ(batch_cam_rays[i], camera.CamRayFromImg(image_points[i]));
+  }
+
+  std::vector<std::optional<Eigen::Vector2d>> batch_image_points(
+      cam_points.size());
+  camera.ImgFromCamBatch(
+      {cam_points.data(), cam_points.size()},
+      {batch_image_points.data(), batch_image_points.size()});
+  for (size_t i = 0; i < cam_points.size(); ++i) {
+    EXPECT_EQ(batch_image_points[i], camera.ImgFromCam(cam_points[i]));
+  }
+  EXPECT_FALSE(batch_image_points[2].has_value());
+
+  EXPECT_ANY_THROW(
+      camera.ImgFromCamBatch({cam_points.data(), cam_points.size()},
+                             {batch_image_points.data(), 1}));
+}
+
 TEST(Camera, Rescale) {
   Camera camera =
       Camera::CreateFromModelId(1, CameraModelId::kSimplePinhole, 1.0, 1, 1);
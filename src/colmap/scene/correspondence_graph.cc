@@ -29,13 +29,94 @@
 
 #include "colmap/scene/correspondence_graph.h"
 
+#include "colmap/util/file.h"
 #include "colmap/util/logging.h"
 #include "colmap/util/string.h"
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <map>
 #include <set>
+#include <unordered_set>
 
 namespace colmap {
+namespace {
+
+// The magic also detects snapshots written on machines of different byte
+// order, since all values are stored in native byte order.
+// Corresponds to "COLMAPCG" in little-endian byte order.
+constexpr uint64_t kSnapshotMagic = 0x474350414D4C4F43;
+// Increment whenever the snapshot format changes.
+constexpr uint32_t kSnapshotVersion = 1;
+
+static_assert(sizeof(CorrespondenceGraph::Correspondence) ==
+                  sizeof(image_t) + sizeof(point2D_t),
+              "Correspondences must be tightly packed for snapshots");
+
+template <typename T>
+void WriteSnapshotValues(std::ostream& stream, const T* values, size_t num) {
+  stream.write(reinterpret_cast<const char*>(values), num * sizeof(T));
+}
+
+template <typename T>
+void WriteSnapshotValue(std::ostream& stream, const T& value) {
+  WriteSnapshotValues(stream, &value, 1);
+}
+
+void WriteSnapshotOptionalMatrix(std::ostream& stream,
+                                 const std::optional<Eigen::Matrix3d>& matrix) {
+  WriteSnapshotValue<uint8_t>(stream, matrix.has_value());
+  if (matrix.has_value()) {
+    WriteSnapshotValues(stream, matrix->data(), matrix->size());
+  }
+}
+
+// Bounds-checked sequential reader of the memory-mapped snapshot data.
+class SnapshotReader {
+ public:
+  SnapshotReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+  template <typename T>
+  bool ReadValues(T* values, size_t num) {
+    if (num > (size_ - pos_) / sizeof(T)) {
+      return false;
+    }
+    const size_t num_bytes = num * sizeof(T);
+    if (num_bytes > 0) {
+      std::memcpy(values, data_ + pos_, num_bytes);
+    }
+    pos_ += num_bytes;
+    return true;
+  }
+
+  template <typename T>
+  bool ReadValue(T* value) {
+    return ReadValues(value, 1);
+  }
+
+  bool ReadOptionalMatrix(std::optional<Eigen::Matrix3d>* matrix) {
+    uint8_t has_value = 0;
+    if (!ReadValue(&has_value)) {
+      return false;
+    }
+    if (has_value == 0) {
+      matrix->reset();
+      return true;
+    }
+    matrix->emplace();
+    return ReadValues((*matrix)->data(), (*matrix)->size());
+  }
+
+  bool IsEnd() const { return pos_ == size_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+}  // namespace
 
 std::unordered_map<image_pair_t, point2D_t>
 CorrespondenceGraph::NumMatchesBetweenAllImages() const {
@@ -56,12 +137,156 @@ std::vector<image_pair_t> CorrespondenceGraph::ImagePairs() const {
   return image_pairs;
 }
 
+std::vector<image_pair_t> CorrespondenceGraph::ImagePairsBetweenImages(
+    const std::unordered_set<image_t>& image_ids) const {
+  std::unordered_set<image_pair_t> pair_ids;
+  for (const image_t image_id : image_ids) {
+    const point2D_t num_points2D = NumPoints2DForImage(image_id);
+    for (point2D_t point2D_idx = 0; point2D_idx < num_points2D;
+         ++point2D_idx) {
+      const CorrespondenceRange range =
+          FindCorrespondences(image_id, point2D_idx);
+      for (const Correspondence* corr = range.beg; corr < range.end; ++corr) {
+        // Count every pair once from the image with the smaller identifier.
+        if (corr->image_id > image_id && image_ids.count(corr->image_id) > 0) {
+          pair_ids.insert(ImagePairToPairId(image_id, corr->image_id));
+        }
+      }
+    }
+  }
+  return {pair_ids.begin(), pair_ids.end()};
+}
+
+std::shared_ptr<CorrespondenceGraph> CorrespondenceGraph::CreateSubgraph(
+    const std::unordered_set<image_t>& image_ids) const {
+  auto subgraph = std::make_shared<CorrespondenceGraph>();
+  subgraph->finalized_ = true;
+  subgraph->images_.reserve(image_ids.size());
+
+  for (const image_t image_id : image_ids) {
+    const point2D_t num_points2D = NumPoints2DForImage(image_id);
+    struct Image& image = subgraph->images_[image_id];
+    image.flat_corr_begs.resize(num_points2D + 1);
+    for (point2D_t point2D_idx = 0; point2D_idx < num_points2D;
+         ++point2D_idx) {
+      image.flat_corr_begs[point2D_idx] = image.flat_corrs.size();
+      const CorrespondenceRange range =
+          FindCorrespondences(image_id, point2D_idx);
+      for (const Correspondence* corr = range.beg; corr < range.end; ++corr) {
+        if (image_ids.count(corr->image_id) == 0) {
+          continue;
+        }
+        image.flat_corrs.push_back(*corr);
+        if (corr->image_id > image_id) {
+          const image_pair_t pair_id =
+              ImagePairToPairId(image_id, corr->image_id);
+          if (const auto [it, inserted] =
+                  subgraph->image_pairs_.try_emplace(pair_id);
+              inserted) {
+            // All matches of the pair are kept, since both images are kept.
+            it->second = image_pairs_.at(pair_id);
+          }
+        }
+      }
+      if (image.flat_corrs.size() > image.flat_corr_begs[point2D_idx]) {
+        image.num_observations += 1;
+      }
+    }
+    image.flat_corr_begs[num_points2D] = image.flat_corrs.size();
+    image.num_correspondences = image.flat_corrs.size();
+    image.flat_corrs.shrink_to_fit();
+  }
+
+  return subgraph;
+}
+
+point2D_t CorrespondenceGraph::Image::NumPoints2D() const {
+  // Images with reserved correspondences and all images after Finalize()
+  // store the flattened correspondence offsets.
+  if (flat_corr_begs.empty()) {
+    return corrs.size();
+  }
+  return flat_corr_begs.size() - 1;
+}
+
+bool CorrespondenceGraph::Image::HasCorrespondence(
+    const point2D_t point2D_idx,
+    const image_t other_image_id,
+    const point2D_t other_point2D_idx) const {
+  const Correspondence* beg;
+  const Correspondence* end;
+  if (flat_corr_ends.empty()) {
+    beg = corrs[point2D_idx].data();
+    end = beg + corrs[point2D_idx].size();
+  } else {
+    beg = flat_corrs.data() + flat_corr_begs[point2D_idx];
+    end = flat_corrs.data() + flat_corr_ends[point2D_idx];
+  }
+  return std::find_if(beg,
+                      end,
+                      [other_image_id,
+                       other_point2D_idx](const Correspondence& corr) {
+           return corr.image_id == other_image_id &&
+                  corr.point2D_idx == other_point2D_idx;
+         }) != end;
+}
+
+void CorrespondenceGraph::Image::AddCorrespondence(
+    const point2D_t point2D_idx,
+    const image_t other_image_id,
+    const point2D_t other_point2D_idx) {
+  bool is_first_corr;
+  if (flat_corr_ends.empty()) {
+    std::vector<Correspondence>& point_corrs = corrs[point2D_idx];
+    point_corrs.emplace_back(other_image_id, other_point2D_idx);
+    is_first_corr = point_corrs.size() == 1;
+  } else {
+    point2D_t& point_end = flat_corr_ends[point2D_idx];
+    THROW_CHECK_LT(point_end, flat_corr_begs[point2D_idx + 1])
+        << "Exceeded reserved correspondences for point2D_idx="
+        << point2D_idx;
+    is_first_corr = point_end == flat_corr_begs[point2D_idx];
+    flat_corrs[point_end++] = Correspondence(other_image_id, other_point2D_idx);
+  }
+  // First correspondence makes this point an observation.
+  if (is_first_corr) {
+    num_observations += 1;
+  }
+}
+
 void CorrespondenceGraph::Finalize() {
   THROW_CHECK(!finalized_);
   finalized_ = true;
 
   // Flatten all correspondences into a compact representation.
   for (auto& [_, image] : images_) {
+    if (!image.flat_corr_ends.empty()) {
+      // Compact the correspondences of images with reserved space by moving
+      // the correspondences of all points to the front.
+      const point2D_t num_points2D = image.flat_corr_ends.size();
+      point2D_t num_total_corrs = 0;
+      point2D_t expected_num_observations = 0;
+      for (point2D_t point2D_idx = 0; point2D_idx < num_points2D;
+           ++point2D_idx) {
+        const point2D_t beg = image.flat_corr_begs[point2D_idx];
+        const point2D_t end = image.flat_corr_ends[point2D_idx];
+        image.flat_corr_begs[point2D_idx] = num_total_corrs;
+        for (point2D_t i = beg; i < end; ++i) {
+          image.flat_corrs[num_total_corrs++] = image.flat_corrs[i];
+        }
+        if (end > beg) {
+          expected_num_observations += 1;
+        }
+      }
+      image.flat_corr_begs[num_points2D] = num_total_corrs;
+      THROW_CHECK_EQ(image.num_observations, expected_num_observations);
+
+      image.flat_corrs.resize(num_total_corrs);
+      image.flat_corrs.shrink_to_fit();
+      std::vector<point2D_t>().swap(image.flat_corr_ends);
+      continue;
+    }
+
     // Verify incremental num_observations tracking is consistent.
     size_t num_total_corrs = 0;
     point2D_t expected_num_observations = 0;
@@ -99,6 +324,24 @@ void CorrespondenceGraph::AddImage(const image_t image_id,
   images_[image_id].corrs.resize(num_points);
 }
 
+void CorrespondenceGraph::AddImage(
+    const image_t image_id, const std::vector<point2D_t>& max_num_corrs) {
+  THROW_CHECK(!finalized_);
+  THROW_CHECK(!ExistsImage(image_id));
+  struct Image& image = images_[image_id];
+  const point2D_t num_points2D = max_num_corrs.size();
+  image.flat_corr_begs.resize(num_points2D + 1);
+  image.flat_corr_ends.resize(num_points2D);
+  point2D_t num_total_corrs = 0;
+  for (point2D_t point2D_idx = 0; point2D_idx < num_points2D; ++point2D_idx) {
+    image.flat_corr_begs[point2D_idx] = num_total_corrs;
+    image.flat_corr_ends[point2D_idx] = num_total_corrs;
+    num_total_corrs += max_num_corrs[point2D_idx];
+  }
+  image.flat_corr_begs[num_points2D] = num_total_corrs;
+  image.flat_corrs.resize(num_total_corrs);
+}
+
 void CorrespondenceGraph::AddTwoViewGeometry(
     const image_t image_id1,
     const image_t image_id2,
@@ -133,22 +376,14 @@ void CorrespondenceGraph::AddTwoViewGeometry(
   // observation is triangulated.
 
   for (const auto& match : two_view_geometry.inlier_matches) {
-    const bool valid_idx1 = match.point2D_idx1 < image1.corrs.size();
-    const bool valid_idx2 = match.point2D_idx2 < image2.corrs.size();
+    const bool valid_idx1 = match.point2D_idx1 < image1.NumPoints2D();
+    const bool valid_idx2 = match.point2D_idx2 < image2.NumPoints2D();
 
     if (valid_idx1 && valid_idx2) {
-      auto& corrs1 = image1.corrs[match.point2D_idx1];
-      auto& corrs2 = image2.corrs[match.point2D_idx2];
-
       // We add valid correspondences bidirectionally, so checking from only one
       // side is sufficient to detect duplicated matches.
-      const bool duplicate =
-          std::find_if(corrs1.begin(),
-                       corrs1.end(),
-                       [image_id2, &match](const Correspondence& corr) {
-                         return corr.image_id == image_id2 &&
-                                corr.point2D_idx == match.point2D_idx2;
-                       }) != corrs1.end();
+      const bool duplicate = image1.HasCorrespondence(
+          match.point2D_idx1, image_id2, match.point2D_idx2);
 
       if (duplicate) {
         image1.num_correspondences -= 1;
@@ -163,15 +398,10 @@ void CorrespondenceGraph::AddTwoViewGeometry(
             match.point2D_idx2,
             image_id2);
       } else {
-        corrs1.emplace_back(image_id2, match.point2D_idx2);
-        // First correspondence makes this point an observation.
-        if (corrs1.size() == 1) {
-          image1.num_observations += 1;
-        }
-        corrs2.emplace_back(image_id1, match.point2D_idx1);
-        if (corrs2.size() == 1) {
-          image2.num_observations += 1;
-        }
+        image1.AddCorrespondence(
+            match.point2D_idx1, image_id2, match.point2D_idx2);
+        image2.AddCorrespondence(
+            match.point2D_idx2, image_id1, match.point2D_idx1);
       }
     } else {
       image1.num_correspondences -= 1;
@@ -206,6 +436,11 @@ CorrespondenceGraph::CorrespondenceRange
 CorrespondenceGraph::FindCorrespondences(const image_t image_id,
                                          const point2D_t point2D_idx) const {
   const Image& image = images_.at(image_id);
+  if (!image.flat_corr_ends.empty()) {
+    return CorrespondenceRange{
+        image.flat_corrs.data() + image.flat_corr_begs.at(point2D_idx),
+        image.flat_corrs.data() + image.flat_corr_ends.at(point2D_idx)};
+  }
   if (!finalized_) {
     const auto& corrs = image.corrs.at(point2D_idx);
     return CorrespondenceRange{corrs.data(), corrs.data() + corrs.size()};
@@ -361,6 +596,153 @@ bool CorrespondenceGraph::IsTwoViewObservation(
   return (other_range.end - other_range.beg) == 1;
 }
 
+void CorrespondenceGraph::WriteSnapshot(const std::filesystem::path& path,
+                                        const uint64_t key) const {
+  THROW_CHECK(finalized_);
+
+  // Write to a temporary file first, such that concurrent or interrupted runs
+  // never observe a partially written snapshot.
+  std::filesystem::path tmp_path = path;
+  tmp_path += ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::trunc | std::ios::binary);
+    THROW_CHECK_FILE_OPEN(file, tmp_path);
+
+    WriteSnapshotValue(file, kSnapshotMagic);
+    WriteSnapshotValue(file, kSnapshotVersion);
+    WriteSnapshotValue(file, key);
+    WriteSnapshotValue<uint64_t>(file, images_.size());
+    WriteSnapshotValue<uint64_t>(file, image_pairs_.size());
+
+    for (const auto& [image_id, image] : images_) {
+      WriteSnapshotValue(file, image_id);
+      WriteSnapshotValue(file, image.num_observations);
+      WriteSnapshotValue(file, image.num_correspondences);
+      WriteSnapshotValue<uint64_t>(file, image.flat_corr_begs.size());
+      WriteSnapshotValues(
+          file, image.flat_corr_begs.data(), image.flat_corr_begs.size());
+      WriteSnapshotValue<uint64_t>(file, image.flat_corrs.size());
+      WriteSnapshotValues(
+          file, image.flat_corrs.data(), image.flat_corrs.size());
+    }
+
+    for (const auto& [pair_id, image_pair] : image_pairs_) {
+      const struct TwoViewGeometry& two_view_geometry =
+          image_pair.two_view_geometry;
+      WriteSnapshotValue(file, pair_id);
+      WriteSnapshotValue(file, image_pair.num_matches);
+      WriteSnapshotValue<int32_t>(file, two_view_geometry.config);
+      WriteSnapshotValue(file, two_view_geometry.tri_angle);
+      WriteSnapshotOptionalMatrix(file, two_view_geometry.E);
+      WriteSnapshotOptionalMatrix(file, two_view_geometry.F);
+      WriteSnapshotOptionalMatrix(file, two_view_geometry.H);
+      WriteSnapshotValue<uint8_t>(file,
+                                  two_view_geometry.cam2_from_cam1.has_value());
+      if (two_view_geometry.cam2_from_cam1.has_value()) {
+        const Eigen::Vector7d& params =
+            two_view_geometry.cam2_from_cam1->params;
+        WriteSnapshotValues(file, params.data(), params.size());
+      }
+    }
+
+    THROW_CHECK(file.good()) << "Failed to write snapshot " << tmp_path;
+  }
+
+  std::filesystem::rename(tmp_path, path);
+}
+
+bool CorrespondenceGraph::ReadSnapshot(const std::filesystem::path& path,
+                                       const uint64_t key) {
+  THROW_CHECK(images_.empty() && image_pairs_.empty());
+
+  if (!ExistsFile(path)) {
+    return false;
+  }
+
+  const MemoryMappedFile file(path);
+  SnapshotReader reader(file.Data(), file.Size());
+
+  uint64_t magic = 0;
+  uint32_t version = 0;
+  uint64_t file_key = 0;
+  if (!reader.ReadValue(&magic) || magic != kSnapshotMagic ||
+      !reader.ReadValue(&version) || version != kSnapshotVersion ||
+      !reader.ReadValue(&file_key) || file_key != key) {
+    return false;
+  }
+
+  uint64_t num_images = 0;
+  uint64_t num_image_pairs = 0;
+  if (!reader.ReadValue(&num_images) || !reader.ReadValue(&num_image_pairs)) {
+    return false;
+  }
+
+  std::unordered_map<image_t, Image> images;
+  images.reserve(num_images);
+  for (uint64_t i = 0; i < num_images; ++i) {
+    image_t image_id = kInvalidImageId;
+    Image image;
+    uint64_t num_corr_begs = 0;
+    uint64_t num_corrs = 0;
+    if (!reader.ReadValue(&image_id) ||
+        !reader.ReadValue(&image.num_observations) ||
+        !reader.ReadValue(&image.num_correspondences) ||
+        !reader.ReadValue(&num_corr_begs) || num_corr_begs == 0 ||
+        num_corr_begs > file.Size()) {
+      return false;
+    }
+    image.flat_corr_begs.resize(num_corr_begs);
+    if (!reader.ReadValues(image.flat_corr_begs.data(), num_corr_begs) ||
+        !reader.ReadValue(&num_corrs) || num_corrs > file.Size() ||
+        image.flat_corr_begs.back() != num_corrs) {
+      return false;
+    }
+    image.flat_corrs.resize(num_corrs);
+    if (!reader.ReadValues(image.flat_corrs.data(), num_corrs)) {
+      return false;
+    }
+    images.emplace(image_id, std::move(image));
+  }
+
+  std::unordered_map<image_pair_t, ImagePair> image_pairs;
+  image_pairs.reserve(num_image_pairs);
+  for (uint64_t i = 0; i < num_image_pairs; ++i) {
+    image_pair_t pair_id = 0;
+    ImagePair image_pair;
+    struct TwoViewGeometry& two_view_geometry = image_pair.two_view_geometry;
+    int32_t config = 0;
+    uint8_t has_cam2_from_cam1 = 0;
+    if (!reader.ReadValue(&pair_id) ||
+        !reader.ReadValue(&image_pair.num_matches) ||
+        !reader.ReadValue(&config) ||
+        !reader.ReadValue(&two_view_geometry.tri_angle) ||
+        !reader.ReadOptionalMatrix(&two_view_geometry.E) ||
+        !reader.ReadOptionalMatrix(&two_view_geometry.F) ||
+        !reader.ReadOptionalMatrix(&two_view_geometry.H) ||
+        !reader.ReadValue(&has_cam2_from_cam1)) {
+      return false;
+    }
+    two_view_geometry.config = config;
+    if (has_cam2_from_cam1 != 0) {
+      two_view_geometry.cam2_from_cam1.emplace();
+      Eigen::Vector7d& params = two_view_geometry.cam2_from_cam1->params;
+      if (!reader.ReadValues(params.data(), params.size())) {
+        return false;
+      }
+    }
+    image_pairs.emplace(pair_id, std::move(image_pair));
+  }
+
+  if (!reader.IsEnd()) {
+    return false;
+  }
+
+  images_ = std::move(images);
+  image_pairs_ = std::move(image_pairs);
+  finalized_ = true;
+  return true;
+}
+
 std::ostream& operator<<(
     std::ostream& stream,
     const CorrespondenceGraph::Correspondence& correspondence) {
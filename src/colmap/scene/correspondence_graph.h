@@ -34,7 +34,10 @@
 #include "colmap/util/string.h"
 #include "colmap/util/types.h"
 
+#include <filesystem>
+#include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace colmap {
@@ -79,6 +82,10 @@ class CorrespondenceGraph {
   // Number of added images.
   inline size_t NumImagePairs() const;
 
+  // Get the number of image points of an image, including points without
+  // correspondences.
+  inline point2D_t NumPoints2DForImage(image_t image_id) const;
+
   // Get the number of observations in an image. An observation is an image
   // point that has at least one correspondence.
   inline point2D_t NumObservationsForImage(image_t image_id) const;
@@ -100,9 +107,30 @@ class CorrespondenceGraph {
   // All image pairs in the correspondence graph.
   std::vector<image_pair_t> ImagePairs() const;
 
+  // Image pairs with at least one correspondence between the given images.
+  // Only the correspondences of the given images are visited, such that the
+  // cost does not depend on the size of the whole graph.
+  std::vector<image_pair_t> ImagePairsBetweenImages(
+      const std::unordered_set<image_t>& image_ids) const;
+
+  // Create a finalized graph with only the given images and the
+  // correspondences between them. As in ImagePairsBetweenImages, only the
+  // correspondences of the given images are visited. Image pairs without any
+  // correspondences are not included.
+  std::shared_ptr<CorrespondenceGraph> CreateSubgraph(
+      const std::unordered_set<image_t>& image_ids) const;
+
   // Add new image to the correspondence graph.
   void AddImage(image_t image_id, size_t num_points2D);
 
+  // Add new image with reserved space for the given maximum number of
+  // correspondences per image point. The correspondences of such an image are
+  // directly stored in the flattened layout of the finalized graph, which
+  // avoids the memory overhead of the per-point vectors before Finalize().
+  // Reserved space that remains unused, e.g., due to invalid or duplicate
+  // matches, is released in Finalize().
+  void AddImage(image_t image_id, const std::vector<point2D_t>& max_num_corrs);
+
   // Add two-view geometry and inlier matches between images. This function
   // ignores invalid matches where the point indices are out of bounds or
   // duplicate matches between the same image points. Whenever either of the two
@@ -149,6 +177,17 @@ class CorrespondenceGraph {
                              image_t image_id2,
                              struct TwoViewGeometry two_view_geometry);
 
+  // Write the finalized graph to a binary snapshot file. Its flat layout is
+  // memory-mapped and copied on reading, which is much faster than rebuilding
+  // the graph from the two-view geometries. The given key is stored in the
+  // file to identify the data the graph was built from.
+  void WriteSnapshot(const std::filesystem::path& path, uint64_t key) const;
+
+  // Read a snapshot written by WriteSnapshot into an empty graph. Returns false
+  // and leaves the graph unchanged, if the file does not exist, was written
+  // with a different format version or key, or is truncated.
+  bool ReadSnapshot(const std::filesystem::path& path, uint64_t key);
+
   // Check whether the image point has correspondences.
   inline bool HasCorrespondences(image_t image_id, point2D_t point2D_idx) const;
 
@@ -159,6 +198,14 @@ class CorrespondenceGraph {
 
  private:
   struct Image {
+    point2D_t NumPoints2D() const;
+    bool HasCorrespondence(point2D_t point2D_idx,
+                           image_t other_image_id,
+                           point2D_t other_point2D_idx) const;
+    void AddCorrespondence(point2D_t point2D_idx,
+                           image_t other_image_id,
+                           point2D_t other_point2D_idx);
+
     // Number of 2D points with at least one correspondence to another image.
     point2D_t num_observations = 0;
 
@@ -176,6 +223,10 @@ class CorrespondenceGraph {
     // the next point. The length of this vector is num_points2D + 1, where the
     // last element is equivalent to the size of flat_corrs.
     std::vector<point2D_t> flat_corr_begs;
+    // For images with reserved correspondences, determines the end of the
+    // correspondences of each point in the flat_corrs vector before
+    // Finalize(), empty otherwise.
+    std::vector<point2D_t> flat_corr_ends;
   };
 
   struct ImagePair {
@@ -210,6 +261,16 @@ bool CorrespondenceGraph::ExistsImage(const image_t image_id) const {
   return images_.find(image_id) != images_.end();
 }
 
+point2D_t CorrespondenceGraph::NumPoints2DForImage(
+    const image_t image_id) const {
+  try {
+    return images_.at(image_id).NumPoints2D();
+  } catch (const std::out_of_range&) {
+    throw std::out_of_range(
+        StringPrintf("Image with ID %d does not exist", image_id));
+  }
+}
+
 point2D_t CorrespondenceGraph::NumObservationsForImage(
     const image_t image_id) const {
   try {
@@ -30,6 +30,8 @@
 #include "colmap/scene/correspondence_graph.h"
 
 #include "colmap/geometry/rigid3_matchers.h"
+#include "colmap/util/file.h"
+#include "colmap/util/testing.h"
 
 #include <gtest/gtest.h>
 
@@ -339,6 +341,185 @@ TEST(CorrespondenceGraph, Duplicate) {
   EXPECT_EQ(correspondence_graph.NumMatchesBetweenAllImages().at(pair_id), 4);
 }
 
+TEST(CorrespondenceGraph, ReservedCorrespondences) {
+  CorrespondenceGraph correspondence_graph;
+  // Reserve one more correspondence than needed for the duplicate match.
+  correspondence_graph.AddImage(0, std::vector<point2D_t>{1, 2, 0, 1});
+  correspondence_graph.AddImage(1, std::vector<point2D_t>{1, 2, 1});
+  correspondence_graph.AddImage(2, 3);
+  TwoViewGeometry two_view_geometry;
+  two_view_geometry.inlier_matches = {
+      {0, 0},
+      {1, 1},
+      {1, 1},
+      {4, 2},
+  };
+  correspondence_graph.AddTwoViewGeometry(0, 1, two_view_geometry);
+  two_view_geometry.inlier_matches = {{3, 2}};
+  correspondence_graph.AddTwoViewGeometry(0, 2, two_view_geometry);
+  two_view_geometry.inlier_matches = {{2, 1}};
+  correspondence_graph.AddTwoViewGeometry(1, 2, two_view_geometry);
+
+  EXPECT_EQ(correspondence_graph.NumCorrespondencesForImage(0), 3);
+  EXPECT_EQ(correspondence_graph.NumObservationsForImage(0), 3);
+  EXPECT_EQ(correspondence_graph.NumCorrespondencesForImage(1), 3);
+  EXPECT_EQ(correspondence_graph.NumObservationsForImage(1), 3);
+  EXPECT_EQ(correspondence_graph.NumMatchesBetweenImages(0, 1), 2);
+  EXPECT_TRUE(correspondence_graph.HasCorrespondences(0, 1));
+  EXPECT_FALSE(correspondence_graph.HasCorrespondences(0, 2));
+
+  // Exceeding the reserved correspondences is not allowed.
+  correspondence_graph.AddImage(3, 1);
+  two_view_geometry.inlier_matches = {{0, 0}};
+  EXPECT_ANY_THROW(
+      correspondence_graph.AddTwoViewGeometry(0, 3, two_view_geometry));
+
+  correspondence_graph.Finalize();
+
+  EXPECT_EQ(correspondence_graph.NumObservationsForImage(0), 3);
+  EXPECT_EQ(correspondence_graph.NumObservationsForImage(1), 3);
+  std::vector<CorrespondenceGraph::Correspondence> corrs;
+  correspondence_graph.ExtractCorrespondences(0, 1, &corrs);
+  ASSERT_EQ(corrs.size(), 1);
+  EXPECT_EQ(corrs[0].image_id, 1);
+  EXPECT_EQ(corrs[0].point2D_idx, 1);
+  correspondence_graph.ExtractCorrespondences(0, 3, &corrs);
+  ASSERT_EQ(corrs.size(), 1);
+  EXPECT_EQ(corrs[0].image_id, 2);
+  EXPECT_EQ(corrs[0].point2D_idx, 2);
+  correspondence_graph.ExtractCorrespondences(1, 2, &corrs);
+  ASSERT_EQ(corrs.size(), 1);
+  EXPECT_EQ(corrs[0].image_id, 2);
+  EXPECT_EQ(corrs[0].point2D_idx, 1);
+  FeatureMatches matches;
+  correspondence_graph.ExtractMatchesBetweenImages(0, 1, matches);
+  EXPECT_EQ(matches.size(), 2);
+}
+
+TEST(CorrespondenceGraph, Snapshot) {
+  const std::filesystem::path test_dir = CreateTestDir();
+  const std::filesystem::path path = test_dir / "graph.snapshot";
+
+  CorrespondenceGraph correspondence_graph;
+  correspondence_graph.AddImage(0, 10);
+  correspondence_graph.AddImage(1, 5);
+  correspondence_graph.AddImage(2, 0);
+  TwoViewGeometry two_view_geometry;
+  two_view_geometry.config = TwoViewGeometry::CALIBRATED;
+  two_view_geometry.E = Eigen::Matrix3d::Random();
+  two_view_geometry.cam2_from_cam1 =
+      Rigid3d(Eigen::Quaterniond::UnitRandom(), Eigen::Vector3d::Random());
+  two_view_geometry.tri_angle = 0.5;
+  two_view_geometry.inlier_matches = {{0, 0}, {1, 3}, {9, 4}};
+  correspondence_graph.AddTwoViewGeometry(0, 1, two_view_geometry);
+
+  // Writing is only supported for finalized graphs.
+  EXPECT_ANY_THROW(correspondence_graph.WriteSnapshot(path, 42));
+  correspondence_graph.Finalize();
+  correspondence_graph.WriteSnapshot(path, 42);
+
+  CorrespondenceGraph read_correspondence_graph;
+  EXPECT_FALSE(read_correspondence_graph.ReadSnapshot(path, 43));
+  EXPECT_FALSE(
+      read_correspondence_graph.ReadSnapshot(test_dir / "missing", 42));
+  EXPECT_EQ(read_correspondence_graph.NumImages(), 0);
+  ASSERT_TRUE(read_correspondence_graph.ReadSnapshot(path, 42));
+
+  EXPECT_EQ(read_correspondence_graph.NumImages(), 3);
+  EXPECT_EQ(read_correspondence_graph.NumImagePairs(), 1);
+  for (const image_t image_id : {0, 1, 2}) {
+    EXPECT_EQ(read_correspondence_graph.NumObservationsForImage(image_id),
+              correspondence_graph.NumObservationsForImage(image_id));
+    EXPECT_EQ(read_correspondence_graph.NumCorrespondencesForImage(image_id),
+              correspondence_graph.NumCorrespondencesForImage(image_id));
+  }
+  EXPECT_TRUE(read_correspondence_graph.IsTwoViewObservation(1, 3));
+  FeatureMatches matches;
+  read_correspondence_graph.ExtractMatchesBetweenImages(0, 1, matches);
+  EXPECT_EQ(matches.size(), 3);
+  const TwoViewGeometry read_two_view_geometry =
+      read_correspondence_graph.ExtractTwoViewGeometry(
+          0, 1, /*extract_inlier_matches=*/false);
+  EXPECT_EQ(read_two_view_geometry.config, two_view_geometry.config);
+  EXPECT_EQ(read_two_view_geometry.E, two_view_geometry.E);
+  EXPECT_FALSE(read_two_view_geometry.F.has_value());
+  EXPECT_FALSE(read_two_view_geometry.H.has_value());
+  EXPECT_THAT(read_two_view_geometry.cam2_from_cam1.value(),
+              Rigid3dEq(two_view_geometry.cam2_from_cam1.value()));
+  EXPECT_EQ(read_two_view_geometry.tri_angle, two_view_geometry.tri_angle);
+
+  // Truncated snapshots are rejected.
+  std::vector<char> data;
+  ReadBinaryBlob(path, &data);
+  data.pop_back();
+  WriteBinaryBlob(path, {data.data(), data.size()});
+  CorrespondenceGraph truncated_correspondence_graph;
+  EXPECT_FALSE(truncated_correspondence_graph.ReadSnapshot(path, 42));
+}
+
+TEST(CorrespondenceGraph, Subgraph) {
+  CorrespondenceGraph correspondence_graph;
+  correspondence_graph.AddImage(0, 10);
+  correspondence_graph.AddImage(1, 10);
+  correspondence_graph.AddImage(2, 10);
+  correspondence_graph.AddImage(3, 10);
+  TwoViewGeometry two_view_geometry;
+  two_view_geometry.config = TwoViewGeometry::CALIBRATED;
+  two_view_geometry.inlier_matches = {{0, 0}, {1, 2}, {3, 7}};
+  correspondence_graph.AddTwoViewGeometry(0, 1, two_view_geometry);
+  two_view_geometry.config = TwoViewGeometry::UNCALIBRATED;
+  two_view_geometry.inlier_matches = {{0, 1}, {4, 4}};
+  correspondence_graph.AddTwoViewGeometry(2, 1, two_view_geometry);
+  two_view_geometry.inlier_matches = {{5, 5}};
+  correspondence_graph.AddTwoViewGeometry(0, 2, two_view_geometry);
+  two_view_geometry.inlier_matches = {{6, 6}};
+  correspondence_graph.AddTwoViewGeometry(2, 3, two_view_geometry);
+  correspondence_graph.Finalize();
+
+  EXPECT_THAT(correspondence_graph.ImagePairsBetweenImages({0, 1, 2}),
+              testing::UnorderedElementsAre(ImagePairToPairId(0, 1),
+                                            ImagePairToPairId(1, 2),
+                                            ImagePairToPairId(0, 2)));
+  EXPECT_THAT(correspondence_graph.ImagePairsBetweenImages({1, 2}),
+              testing::ElementsAre(ImagePairToPairId(1, 2)));
+  EXPECT_THAT(correspondence_graph.ImagePairsBetweenImages({0, 3}),
+              testing::IsEmpty());
+
+  const std::shared_ptr<CorrespondenceGraph> subgraph =
+      correspondence_graph.CreateSubgraph({1, 2});
+  EXPECT_EQ(subgraph->NumImages(), 2);
+  EXPECT_EQ(subgraph->NumImagePairs(), 1);
+  EXPECT_FALSE(subgraph->ExistsImage(0));
+  EXPECT_EQ(subgraph->NumPoints2DForImage(1), 10);
+  EXPECT_EQ(subgraph->NumObservationsForImage(1), 2);
+  EXPECT_EQ(subgraph->NumCorrespondencesForImage(1), 2);
+  EXPECT_EQ(subgraph->NumObservationsForImage(2), 2);
+  EXPECT_EQ(subgraph->NumCorrespondencesForImage(2), 2);
+  EXPECT_EQ(subgraph->NumMatchesBetweenImages(1, 2), 2);
+  EXPECT_EQ(subgraph->ExtractTwoViewGeometry(2, 1, false).config,
+            TwoViewGeometry::UNCALIBRATED);
+  FeatureMatches matches;
+  subgraph->ExtractMatchesBetweenImages(2, 1, matches);
+  EXPECT_THAT(matches,
+              testing::UnorderedElementsAreArray(
+                  FeatureMatches({{0, 1}, {4, 4}})));
+  EXPECT_FALSE(subgraph->HasCorrespondences(2, 5));
+  EXPECT_FALSE(subgraph->HasCorrespondences(1, 0));
+  EXPECT_TRUE(subgraph->HasCorrespondences(1, 1));
+
+  // The subgraph matches the graph built from the same two-view geometries.
+  const std::shared_ptr<CorrespondenceGraph> full_subgraph =
+      correspondence_graph.CreateSubgraph({0, 1, 2, 3});
+  EXPECT_EQ(full_subgraph->NumImagePairs(),
+            correspondence_graph.NumImagePairs());
+  for (const image_t image_id : {0, 1, 2, 3}) {
+    EXPECT_EQ(full_subgraph->NumObservationsForImage(image_id),
+              correspondence_graph.NumObservationsForImage(image_id));
+    EXPECT_EQ(full_subgraph->NumCorrespondencesForImage(image_id),
+              correspondence_graph.NumCorrespondencesForImage(image_id));
+  }
+}
+
 TEST(CorrespondenceGraph, UpdateTwoViewGeometry) {
   CorrespondenceGraph correspondence_graph;
   correspondence_graph.AddImage(0, 10);
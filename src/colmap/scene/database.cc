@@ -30,13 +30,92 @@
 #include "colmap/scene/database.h"
 
 #include "colmap/optim/random_sampler.h"
+#include "colmap/scene/database_mmap.h"
 #include "colmap/scene/database_sqlite.h"
+#include "colmap/util/threading.h"
 
+#include <exception>
+#include <functional>
 #include <numeric>
+#include <sstream>
 
 namespace colmap {
 
-std::vector<Database::Factory> Database::factories_ = {&OpenSqliteDatabase};
+void SwapFeatureMatchesBlob(FeatureMatchesBlob* matches) {
+  for (Eigen::Index i = 0; i < matches->rows(); ++i) {
+    std::swap((*matches)(i, 0), (*matches)(i, 1));
+  }
+}
+
+FeatureKeypointsBlob FeatureKeypointsToBlob(const FeatureKeypoints& keypoints) {
+  const FeatureKeypointsBlob::Index kNumCols = 6;
+  FeatureKeypointsBlob blob(keypoints.size(), kNumCols);
+  for (size_t i = 0; i < keypoints.size(); ++i) {
+    blob(i, 0) = keypoints[i].x;
+    blob(i, 1) = keypoints[i].y;
+    blob(i, 2) = keypoints[i].a11;
+    blob(i, 3) = keypoints[i].a12;
+    blob(i, 4) = keypoints[i].a21;
+    blob(i, 5) = keypoints[i].a22;
+  }
+  return blob;
+}
+
+FeatureKeypoints FeatureKeypointsFromBlob(const FeatureKeypointsBlob& blob) {
+  FeatureKeypoints keypoints(static_cast<size_t>(blob.rows()));
+  if (blob.rows() == 0) {
+    return keypoints;
+  } else if (blob.cols() == 2) {
+    for (FeatureKeypointsBlob::Index i = 0; i < blob.rows(); ++i) {
+      keypoints[i] = FeatureKeypoint(blob(i, 0), blob(i, 1));
+    }
+  } else if (blob.cols() == 4) {
+    for (FeatureKeypointsBlob::Index i = 0; i < blob.rows(); ++i) {
+      keypoints[i] =
+          FeatureKeypoint(blob(i, 0), blob(i, 1), blob(i, 2), blob(i, 3));
+    }
+  } else if (blob.cols() == 6) {
+    for (FeatureKeypointsBlob::Index i = 0; i < blob.rows(); ++i) {
+      keypoints[i] = FeatureKeypoint(blob(i, 0),
+                                     blob(i, 1),
+                                     blob(i, 2),
+                                     blob(i, 3),
+                                     blob(i, 4),
+                                     blob(i, 5));
+    }
+  } else {
+    LOG(FATAL_THROW) << "Keypoint format not supported";
+  }
+  return keypoints;
+}
+
+FeatureMatchesBlob FeatureMatchesToBlob(const FeatureMatches& matches) {
+  const FeatureMatchesBlob::Index kNumCols = 2;
+  FeatureMatchesBlob blob(matches.size(), kNumCols);
+  for (size_t i = 0; i < matches.size(); ++i) {
+    blob(i, 0) = matches[i].point2D_idx1;
+    blob(i, 1) = matches[i].point2D_idx2;
+  }
+  return blob;
+}
+
+FeatureMatches FeatureMatchesFromBlob(const FeatureMatchesBlob& blob) {
+  THROW_CHECK_EQ(blob.cols(), 2);
+  FeatureMatches matches(static_cast<size_t>(blob.rows()));
+  for (FeatureMatchesBlob::Index i = 0; i < blob.rows(); ++i) {
+    matches[i].point2D_idx1 = blob(i, 0);
+    matches[i].point2D_idx2 = blob(i, 1);
+  }
+  return matches;
+}
+
+std::vector<Database::Factory> Database::factories_ = {
+    &OpenSqliteDatabase, [](const std::filesystem::path& path) {
+      // Only open existing stores, so that new databases default to SQLite.
+      THROW_CHECK(IsMmapDatabase(path))
+          << path << " is not a memory-mapped database";
+      return OpenMmapDatabase(path);
+    }};
 
 void Database::Register(Factory factory) {
   factories_.push_back(std::move(factory));
@@ -45,36 +124,94 @@ void Database::Register(Factory factory) {
 Database::~Database() = default;
 
 std::shared_ptr<Database> Database::Open(const std::filesystem::path& path) {
+  std::ostringstream errors;
   for (auto it = factories_.rbegin(); it != factories_.rend(); ++it) {
     try {
       return (*it)(path);
     } catch (const std::exception& e) {
-      LOG(WARNING)
-          << "Failed to open database with registered factory, because: "
-          << e.what() << ". Trying next registered factory.";
+      VLOG(2) << "Failed to open database with registered factory, because: "
+              << e.what() << ". Trying next registered factory.";
+      errors << "\n  " << e.what();
     }
   }
-  throw std::runtime_error("No registered database factory succeeded.");
+  throw std::runtime_error("No registered database factory succeeded:" +
+                           errors.str());
 }
 
-void Database::Merge(const Database& database1,
-                     const Database& database2,
-                     Database* merged_database) {
-  // Merge the cameras.
+std::shared_ptr<DatabaseReadPool> Database::OpenReadOnlyPool(
+    const std::filesystem::path& path, const int num_connections) {
+  THROW_CHECK_GT(num_connections, 0);
+  if (path == kInMemorySqliteDatabasePath || IsMmapDatabase(path)) {
+    return nullptr;
+  }
+  std::vector<std::shared_ptr<Database>> connections;
+  connections.reserve(num_connections);
+  for (int i = 0; i < num_connections; ++i) {
+    connections.push_back(OpenReadOnlySqliteDatabase(path));
+  }
+  return std::make_shared<DatabaseReadPool>(std::move(connections));
+}
 
-  std::unordered_map<camera_t, camera_t> new_camera_ids1;
-  for (const auto& camera : database1.ReadAllCameras()) {
-    const camera_t new_camera_id = merged_database->WriteCamera(camera);
-    new_camera_ids1.emplace(camera.camera_id, new_camera_id);
+std::vector<FeatureKeypoints> Database::ReadKeypoints(
+    span<const image_t> image_ids) const {
+  std::vector<FeatureKeypoints> keypoints;
+  keypoints.reserve(image_ids.size());
+  for (const image_t image_id : image_ids) {
+    keypoints.push_back(ReadKeypoints(image_id));
   }
+  return keypoints;
+}
 
-  std::unordered_map<camera_t, camera_t> new_camera_ids2;
-  for (const auto& camera : database2.ReadAllCameras()) {
-    const camera_t new_camera_id = merged_database->WriteCamera(camera);
-    new_camera_ids2.emplace(camera.camera_id, new_camera_id);
+std::vector<FeatureDescriptors> Database::ReadDescriptors(
+    span<const image_t> image_ids) const {
+  std::vector<FeatureDescriptors> descriptors;
+  descriptors.reserve(image_ids.size());
+  for (const image_t image_id : image_ids) {
+    descriptors.push_back(ReadDescriptors(image_id));
   }
+  return descriptors;
+}
 
-  // Merge the rigs.
+std::vector<TwoViewGeometry> Database::ReadTwoViewGeometries(
+    span<const image_pair_t> pair_ids) const {
+  std::vector<TwoViewGeometry> two_view_geometries;
+  two_view_geometries.reserve(pair_ids.size());
+  for (const image_pair_t pair_id : pair_ids) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    two_view_geometries.push_back(ReadTwoViewGeometry(image_id1, image_id2));
+  }
+  return two_view_geometries;
+}
+
+std::vector<frame_t> Database::WriteFrames(span<const Frame> frames,
+                                           const bool use_frame_ids) {
+  std::vector<frame_t> frame_ids;
+  frame_ids.reserve(frames.size());
+  for (const Frame& frame : frames) {
+    frame_ids.push_back(WriteFrame(frame, use_frame_ids));
+  }
+  return frame_ids;
+}
+
+std::vector<pose_prior_t> Database::WritePosePriors(
+    span<const PosePrior> pose_priors, const bool use_pose_prior_ids) {
+  std::vector<pose_prior_t> pose_prior_ids;
+  pose_prior_ids.reserve(pose_priors.size());
+  for (const PosePrior& pose_prior : pose_priors) {
+    pose_prior_ids.push_back(WritePosePrior(pose_prior, use_pose_prior_ids));
+  }
+  return pose_prior_ids;
+}
+
+void Database::Merge(const Database& database1,
+                     const Database& database2,
+                     Database* merged_database) {
+  Merge(std::vector<const Database*>{&database1, &database2}, merged_database);
+}
+
+void Database::Merge(const std::vector<const Database*>& databases,
+                     Database* merged_database) {
+  THROW_CHECK_NOTNULL(merged_database);
 
   auto update_rig =
       [](const Rig& rig,
@@ -99,56 +236,6 @@ void Database::Merge(const Database& database1,
         return updated_rig;
       };
 
-  std::unordered_map<rig_t, rig_t> new_rig_ids1;
-  for (auto& rig : database1.ReadAllRigs()) {
-    const rig_t new_rig_id =
-        merged_database->WriteRig(update_rig(rig, new_camera_ids1));
-    new_rig_ids1.emplace(rig.RigId(), new_rig_id);
-  }
-
-  std::unordered_map<rig_t, rig_t> new_rig_ids2;
-  for (auto& rig : database2.ReadAllRigs()) {
-    const rig_t new_rig_id =
-        merged_database->WriteRig(update_rig(rig, new_camera_ids2));
-    new_rig_ids2.emplace(rig.RigId(), new_rig_id);
-  }
-
-  // Merge the images.
-
-  std::unordered_map<image_t, image_t> new_image_ids1;
-  for (auto& image : database1.ReadAllImages()) {
-    image.SetCameraId(new_camera_ids1.at(image.CameraId()));
-    image.SetFrameId(kInvalidFrameId);
-    THROW_CHECK(!merged_database->ExistsImageWithName(image.Name()))
-        << "The two databases must not contain images with the same name, but "
-           "there are images with name "
-        << image.Name() << " in both databases";
-    const image_t new_image_id = merged_database->WriteImage(image);
-    new_image_ids1.emplace(image.ImageId(), new_image_id);
-    const auto keypoints = database1.ReadKeypoints(image.ImageId());
-    const auto descriptors = database1.ReadDescriptors(image.ImageId());
-    merged_database->WriteKeypoints(new_image_id, keypoints);
-    merged_database->WriteDescriptors(new_image_id, descriptors);
-  }
-
-  std::unordered_map<image_t, image_t> new_image_ids2;
-  for (auto& image : database2.ReadAllImages()) {
-    image.SetCameraId(new_camera_ids2.at(image.CameraId()));
-    image.SetFrameId(kInvalidFrameId);
-    THROW_CHECK(!merged_database->ExistsImageWithName(image.Name()))
-        << "The two databases must not contain images with the same name, but "
-           "there are images with name "
-        << image.Name() << " in both databases";
-    const image_t new_image_id = merged_database->WriteImage(image);
-    new_image_ids2.emplace(image.ImageId(), new_image_id);
-    const auto keypoints = database2.ReadKeypoints(image.ImageId());
-    const auto descriptors = database2.ReadDescriptors(image.ImageId());
-    merged_database->WriteKeypoints(new_image_id, keypoints);
-    merged_database->WriteDescriptors(new_image_id, descriptors);
-  }
-
-  // Merge the frames.
-
   auto update_frame =
       [](const Frame& frame,
          const std::unordered_map<rig_t, rig_t>& new_rig_ids,
@@ -173,18 +260,6 @@ void Database::Merge(const Database& database1,
         return updated_frame;
       };
 
-  for (Frame& frame : database1.ReadAllFrames()) {
-    merged_database->WriteFrame(
-        update_frame(frame, new_rig_ids1, new_camera_ids1, new_image_ids1));
-  }
-
-  for (Frame& frame : database2.ReadAllFrames()) {
-    merged_database->WriteFrame(
-        update_frame(frame, new_rig_ids2, new_camera_ids2, new_image_ids2));
-  }
-
-  // Merge the pose priors.
-
   auto update_pose_prior =
       [](const PosePrior& pose_prior,
          const std::unordered_map<camera_t, camera_t>& new_camera_ids,
@@ -206,61 +281,230 @@ void Database::Merge(const Database& database1,
         return updated_pose_prior;
       };
 
-  for (auto& pose_prior : database1.ReadAllPosePriors()) {
-    merged_database->WritePosePrior(
-        update_pose_prior(pose_prior, new_camera_ids1, new_image_ids1));
-  }
+  struct NewIds {
+    std::unordered_map<camera_t, camera_t> cameras;
+    std::unordered_map<rig_t, rig_t> rigs;
+    std::unordered_map<image_t, image_t> images;
+    // Old and new image identifiers in the order of the source database.
+    std::vector<std::pair<image_t, image_t>> ordered_images;
+  };
 
-  for (auto& pose_prior : database2.ReadAllPosePriors()) {
-    merged_database->WritePosePrior(
-        update_pose_prior(pose_prior, new_camera_ids2, new_image_ids2));
-  }
+  std::vector<NewIds> new_ids(databases.size());
+
+  // Combine all writes into a single transaction, which is much faster than
+  // committing every row separately, especially when appending to an existing
+  // large database.
+  DatabaseTransaction transaction(merged_database);
+
+  // Merge the cameras, rigs, images, frames, and pose priors, which determine
+  // the new identifiers of all other entries.
 
-  // Merge the matches.
+  for (size_t i = 0; i < databases.size(); ++i) {
+    const Database& database = *THROW_CHECK_NOTNULL(databases[i]);
+    NewIds& source_new_ids = new_ids[i];
 
-  for (const auto& matches : database1.ReadAllMatches()) {
-    const auto image_pair = PairIdToImagePair(matches.first);
+    for (const auto& camera : database.ReadAllCameras()) {
+      source_new_ids.cameras.emplace(camera.camera_id,
+                                     merged_database->WriteCamera(camera));
+    }
+
+    for (const auto& rig : database.ReadAllRigs()) {
+      source_new_ids.rigs.emplace(
+          rig.RigId(),
+          merged_database->WriteRig(update_rig(rig, source_new_ids.cameras)));
+    }
 
-    const image_t new_image_id1 = new_image_ids1.at(image_pair.first);
-    const image_t new_image_id2 = new_image_ids1.at(image_pair.second);
+    for (auto& image : database.ReadAllImages()) {
+      image.SetCameraId(source_new_ids.cameras.at(image.CameraId()));
+      image.SetFrameId(kInvalidFrameId);
+      THROW_CHECK(!merged_database->ExistsImageWithName(image.Name()))
+          << "The databases must not contain images with the same name, but "
+             "there are multiple images with name "
+          << image.Name();
+      const image_t new_image_id = merged_database->WriteImage(image);
+      source_new_ids.images.emplace(image.ImageId(), new_image_id);
+      source_new_ids.ordered_images.emplace_back(image.ImageId(),
+                                                 new_image_id);
+      if (const std::optional<FeatureExtractionFingerprint> fingerprint =
+              database.ReadFeatureExtractionFingerprint(image.ImageId());
+          fingerprint.has_value()) {
+        merged_database->WriteFeatureExtractionFingerprint(new_image_id,
+                                                           *fingerprint);
+      }
+      if (const std::optional<GlobalImageDescriptor> descriptor =
+              database.ReadGlobalImageDescriptor(image.ImageId());
+          descriptor.has_value()) {
+        merged_database->WriteGlobalImageDescriptor(new_image_id, *descriptor);
+      }
+    }
 
-    merged_database->WriteMatches(new_image_id1, new_image_id2, matches.second);
+    for (const Frame& frame : database.ReadAllFrames()) {
+      merged_database->WriteFrame(update_frame(frame,
+                                               source_new_ids.rigs,
+                                               source_new_ids.cameras,
+                                               source_new_ids.images));
+    }
+
+    for (const auto& pose_prior : database.ReadAllPosePriors()) {
+      merged_database->WritePosePrior(update_pose_prior(
+          pose_prior, source_new_ids.cameras, source_new_ids.images));
+    }
   }
 
-  for (const auto& matches : database2.ReadAllMatches()) {
-    const auto image_pair = PairIdToImagePair(matches.first);
+  // Merge the keypoints, descriptors, matches, and two-view geometries. The
+  // source databases are read in a separate thread, while the merged database
+  // is written in this thread. Keypoints and matches are copied as BLOBs
+  // without converting them to features. An empty write marks the end.
 
-    const image_t new_image_id1 = new_image_ids2.at(image_pair.first);
-    const image_t new_image_id2 = new_image_ids2.at(image_pair.second);
+  using WriteFunc = std::function<void(Database*)>;
+  constexpr size_t kMaxNumPendingWrites = 256;
+  JobQueue<WriteFunc> write_queue(kMaxNumPendingWrites);
 
-    merged_database->WriteMatches(new_image_id1, new_image_id2, matches.second);
+  std::exception_ptr reader_exception;
+  std::thread reader_thread([&]() {
+    try {
+      for (size_t i = 0; i < databases.size(); ++i) {
+        const Database& database = *databases[i];
+        const NewIds& source_new_ids = new_ids[i];
+
+        for (const auto& [image_id, new_image_id] :
+             source_new_ids.ordered_images) {
+          if (database.ExistsKeypoints(image_id)) {
+            if (!write_queue.Push(
+                    [new_image_id = new_image_id,
+                     blob = database.ReadKeypointsBlob(image_id)](
+                        Database* merged_database) {
+                      merged_database->WriteKeypoints(new_image_id, blob);
+                    })) {
+              return;
+            }
+          }
+          if (database.ExistsDescriptors(image_id)) {
+            if (!write_queue.Push(
+                    [new_image_id = new_image_id,
+                     descriptors = database.ReadDescriptors(image_id)](
+                        Database* merged_database) {
+                      merged_database->WriteDescriptors(new_image_id,
+                                                        descriptors);
+                    })) {
+              return;
+            }
+          }
+        }
+
+        for (auto& [pair_id, blob] : database.ReadAllMatchesBlob()) {
+          const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+          if (!write_queue.Push(
+                  [new_image_id1 = source_new_ids.images.at(image_id1),
+                   new_image_id2 = source_new_ids.images.at(image_id2),
+                   blob = std::move(blob)](Database* merged_database) {
+                    merged_database->WriteMatches(
+                        new_image_id1, new_image_id2, blob);
+                  })) {
+            return;
+          }
+        }
+
+        for (auto& [pair_id, two_view_geometry] :
+             database.ReadTwoViewGeometries()) {
+          const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+          if (!write_queue.Push(
+                  [new_image_id1 = source_new_ids.images.at(image_id1),
+                   new_image_id2 = source_new_ids.images.at(image_id2),
+                   two_view_geometry = std::move(two_view_geometry)](
+                      Database* merged_database) {
+                    merged_database->WriteTwoViewGeometry(
+                        new_image_id1, new_image_id2, two_view_geometry);
+                  })) {
+            return;
+          }
+        }
+      }
+    } catch (...) {
+      reader_exception = std::current_exception();
+    }
+    write_queue.Push(WriteFunc());
+  });
+
+  std::exception_ptr writer_exception;
+  try {
+    while (true) {
+      auto write = write_queue.Pop();
+      if (!write.IsValid() || !write.Data()) {
+        break;
+      }
+      write.Data()(merged_database);
+    }
+  } catch (...) {
+    writer_exception = std::current_exception();
+    write_queue.Stop();
   }
 
-  // Merge the two-view geometries.
+  reader_thread.join();
 
-  for (const auto& [pair_id, two_view_geometry] :
-       database1.ReadTwoViewGeometries()) {
-    const auto image_pair = PairIdToImagePair(pair_id);
+  if (writer_exception) {
+    std::rethrow_exception(writer_exception);
+  }
+  if (reader_exception) {
+    std::rethrow_exception(reader_exception);
+  }
+}
 
-    const image_t new_image_id1 = new_image_ids1.at(image_pair.first);
-    const image_t new_image_id2 = new_image_ids1.at(image_pair.second);
+void Database::Copy(const Database& source, Database* target) {
+  THROW_CHECK_NOTNULL(target);
 
-    merged_database->WriteTwoViewGeometry(
-        new_image_id1, new_image_id2, two_view_geometry);
+  for (const auto& camera : source.ReadAllCameras()) {
+    target->WriteCamera(camera, /*use_camera_id=*/true);
   }
 
-  for (const auto& [pair_id, two_view_geometry] :
-       database2.ReadTwoViewGeometries()) {
-    const auto image_pair = PairIdToImagePair(pair_id);
+  for (const auto& rig : source.ReadAllRigs()) {
+    target->WriteRig(rig, /*use_rig_id=*/true);
+  }
 
-    const image_t new_image_id1 = new_image_ids2.at(image_pair.first);
-    const image_t new_image_id2 = new_image_ids2.at(image_pair.second);
+  for (const auto& frame : source.ReadAllFrames()) {
+    target->WriteFrame(frame, /*use_frame_id=*/true);
+  }
+
+  for (const auto& image : source.ReadAllImages()) {
+    target->WriteImage(image, /*use_image_id=*/true);
+    if (source.ExistsKeypoints(image.ImageId())) {
+      target->WriteKeypoints(image.ImageId(),
+                             source.ReadKeypointsBlob(image.ImageId()));
+    }
+    if (source.ExistsDescriptors(image.ImageId())) {
+      target->WriteDescriptors(image.ImageId(),
+                               source.ReadDescriptors(image.ImageId()));
+    }
+    if (const std::optional<FeatureExtractionFingerprint> fingerprint =
+            source.ReadFeatureExtractionFingerprint(image.ImageId());
+        fingerprint.has_value()) {
+      target->WriteFeatureExtractionFingerprint(image.ImageId(), *fingerprint);
+    }
+    if (const std::optional<GlobalImageDescriptor> descriptor =
+            source.ReadGlobalImageDescriptor(image.ImageId());
+        descriptor.has_value()) {
+      target->WriteGlobalImageDescriptor(image.ImageId(), *descriptor);
+    }
+  }
 
-    merged_database->WriteTwoViewGeometry(
-        new_image_id1, new_image_id2, two_view_geometry);
+  for (const auto& pose_prior : source.ReadAllPosePriors()) {
+    target->WritePosePrior(pose_prior, /*use_pose_prior_id=*/true);
+  }
+
+  for (const auto& [pair_id, blob] : source.ReadAllMatchesBlob()) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    target->WriteMatches(image_id1, image_id2, blob);
+  }
+
+  for (const auto& [pair_id, two_view_geometry] :
+       source.ReadTwoViewGeometries()) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    target->WriteTwoViewGeometry(image_id1, image_id2, two_view_geometry);
   }
 }
 
+void Database::SetBlobCompression(const bool /*enabled*/) {}
+
 DatabaseTransaction::DatabaseTransaction(Database* database)
     : database_(database), database_lock_(database->transaction_mutex_) {
   THROW_CHECK_NOTNULL(database_);
@@ -269,6 +513,59 @@ DatabaseTransaction::DatabaseTransaction(Database* database)
 
 DatabaseTransaction::~DatabaseTransaction() { database_->EndTransaction(); }
 
+DatabaseReadPool::DatabaseReadPool(
+    std::vector<std::shared_ptr<Database>> connections)
+    : connections_(std::move(connections)),
+      in_use_(connections_.size(), false) {
+  THROW_CHECK(!connections_.empty());
+  for (const auto& connection : connections_) {
+    THROW_CHECK_NOTNULL(connection);
+  }
+}
+
+size_t DatabaseReadPool::NumConnections() const { return connections_.size(); }
+
+void DatabaseReadPool::Read(
+    const std::function<void(const Database& database)>& func) {
+  const size_t connection_idx = AcquireConnection();
+  try {
+    func(*connections_[connection_idx]);
+  } catch (...) {
+    ReleaseConnection(connection_idx);
+    throw;
+  }
+  ReleaseConnection(connection_idx);
+}
+
+size_t DatabaseReadPool::AcquireConnection() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const std::thread::id thread_id = std::this_thread::get_id();
+  while (true) {
+    // Reuse the connection of the previous call to benefit from its cache.
+    const auto it = thread_connection_idxs_.find(thread_id);
+    if (it != thread_connection_idxs_.end() && !in_use_[it->second]) {
+      in_use_[it->second] = true;
+      return it->second;
+    }
+    for (size_t i = 0; i < connections_.size(); ++i) {
+      if (!in_use_[i]) {
+        in_use_[i] = true;
+        thread_connection_idxs_[thread_id] = i;
+        return i;
+      }
+    }
+    release_condition_.wait(lock);
+  }
+}
+
+void DatabaseReadPool::ReleaseConnection(const size_t connection_idx) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    in_use_[connection_idx] = false;
+  }
+  release_condition_.notify_one();
+}
+
 FeatureDescriptorsFloat LoadRandomDatabaseDescriptors(const Database& database,
                                                       int max_num_descriptors) {
   const std::vector<Image> images = database.ReadAllImages();
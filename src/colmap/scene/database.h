@@ -38,8 +38,11 @@
 #include "colmap/util/eigen_alignment.h"
 #include "colmap/util/types.h"
 
+#include <condition_variable>
 #include <filesystem>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <Eigen/Core>
@@ -53,6 +56,58 @@ using FeatureDescriptorsBlob =
 using FeatureMatchesBlob =
     Eigen::Matrix<point2D_t, Eigen::Dynamic, 2, Eigen::RowMajor>;
 
+// Conversion between the feature types and their dense blob representation as
+// stored by the database implementations. Keypoint blobs can have 2, 4, or 6
+// columns depending on the stored keypoint shape.
+FeatureKeypointsBlob FeatureKeypointsToBlob(const FeatureKeypoints& keypoints);
+FeatureKeypoints FeatureKeypointsFromBlob(const FeatureKeypointsBlob& blob);
+FeatureMatchesBlob FeatureMatchesToBlob(const FeatureMatches& matches);
+FeatureMatches FeatureMatchesFromBlob(const FeatureMatchesBlob& blob);
+
+// Swap the two columns of the matches blob in-place.
+void SwapFeatureMatchesBlob(FeatureMatchesBlob* matches);
+
+// Fingerprint of the image file and the extraction options from which the
+// features of an image were extracted. Used to skip the extraction of images
+// whose file and options did not change since their features were extracted.
+struct FeatureExtractionFingerprint {
+  // Hash of the image file content.
+  uint64_t file_hash = 0;
+  // Size and last modification time of the image file, which avoid hashing
+  // the content of files that were not touched.
+  uint64_t file_size = 0;
+  int64_t file_mtime = 0;
+  // Hash of the options that determine the extracted features.
+  uint64_t options_hash = 0;
+
+  inline bool operator==(const FeatureExtractionFingerprint& other) const {
+    return file_hash == other.file_hash && file_size == other.file_size &&
+           file_mtime == other.file_mtime &&
+           options_hash == other.options_hash;
+  }
+  inline bool operator!=(const FeatureExtractionFingerprint& other) const {
+    return !(*this == other);
+  }
+};
+
+// Compact global descriptor of an image for retrieval, e.g., aggregated from
+// its local features.
+struct GlobalImageDescriptor {
+  // Hash of the model, e.g., the codebook, from which the descriptor was
+  // computed. Only descriptors with the same hash are comparable.
+  uint64_t model_hash = 0;
+  Eigen::VectorXf data;
+
+  inline bool operator==(const GlobalImageDescriptor& other) const {
+    return model_hash == other.model_hash && data == other.data;
+  }
+  inline bool operator!=(const GlobalImageDescriptor& other) const {
+    return !(*this == other);
+  }
+};
+
+class DatabaseReadPool;
+
 // Database class to read and write images, features, cameras, matches, etc.
 // from a SQLite database. The class is not thread-safe and must not be accessed
 // concurrently. The class is optimized for single-thread speed and for optimal
@@ -81,6 +136,13 @@ class Database {
   // Open database and throw a runtime_error if none of the factories succeeds.
   static std::shared_ptr<Database> Open(const std::filesystem::path& path);
 
+  // Open a pool of read-only connections to an existing database, so that
+  // multiple threads can read concurrently while another connection writes to
+  // the database. Returns nullptr if the database does not support concurrent
+  // read-only connections, e.g., for memory-mapped or in-memory databases.
+  static std::shared_ptr<DatabaseReadPool> OpenReadOnlyPool(
+      const std::filesystem::path& path, int num_connections);
+
   // Explicitly close the database before destruction.
   virtual void Close() = 0;
 
@@ -174,6 +236,15 @@ class Database {
   virtual FeatureKeypoints ReadKeypoints(image_t image_id) const = 0;
   virtual FeatureDescriptors ReadDescriptors(image_t image_id) const = 0;
 
+  // Returns std::nullopt if no fingerprint was recorded for the features of
+  // the image, e.g., for databases created by older versions.
+  virtual std::optional<FeatureExtractionFingerprint>
+  ReadFeatureExtractionFingerprint(image_t image_id) const = 0;
+
+  // Returns std::nullopt if no global descriptor was computed for the image.
+  virtual std::optional<GlobalImageDescriptor> ReadGlobalImageDescriptor(
+      image_t image_id) const = 0;
+
   virtual FeatureMatchesBlob ReadMatchesBlob(image_t image_id1,
                                              image_t image_id2) const = 0;
   virtual FeatureMatches ReadMatches(image_t image_id1,
@@ -194,6 +265,19 @@ class Database {
   virtual std::vector<std::pair<image_pair_t, int>>
   ReadTwoViewGeometryNumInliers() const = 0;
 
+  // Batched variants of `ReadKeypoints`, `ReadDescriptors`, and
+  // `ReadTwoViewGeometry`, which return one entry per given identifier in the
+  // same order. Missing entries are returned empty and two-view geometries are
+  // returned in the order of the image identifiers in the pair identifier. The
+  // default implementations read the entries one by one, while database
+  // implementations may override them to read each batch with a single query.
+  virtual std::vector<FeatureKeypoints> ReadKeypoints(
+      span<const image_t> image_ids) const;
+  virtual std::vector<FeatureDescriptors> ReadDescriptors(
+      span<const image_t> image_ids) const;
+  virtual std::vector<TwoViewGeometry> ReadTwoViewGeometries(
+      span<const image_pair_t> pair_ids) const;
+
   // Add new rig and return its database identifier. If `use_rig_id`
   // is false a new identifier is automatically generated.
   virtual rig_t WriteRig(const Rig& rig, bool use_rig_id = false) = 0;
@@ -207,6 +291,13 @@ class Database {
   // is false a new identifier is automatically generated.
   virtual frame_t WriteFrame(const Frame& frame, bool use_frame_id = false) = 0;
 
+  // Batched variant of `WriteFrame`, which returns the identifiers of the
+  // frames in the same order. The default implementation writes the frames
+  // one by one, while database implementations may override it to write each
+  // batch more efficiently, e.g., in a single transaction.
+  virtual std::vector<frame_t> WriteFrames(span<const Frame> frames,
+                                           bool use_frame_ids = false);
+
   // Add new image and return its database identifier. If `use_image_id`
   // is false a new identifier is automatically generated.
   virtual image_t WriteImage(const Image& image, bool use_image_id = false) = 0;
@@ -216,6 +307,13 @@ class Database {
   virtual pose_prior_t WritePosePrior(const PosePrior& pose_prior,
                                       bool use_pose_prior_id = false) = 0;
 
+  // Batched variant of `WritePosePrior`, which returns the identifiers of the
+  // pose priors in the same order. The default implementation writes the pose
+  // priors one by one, while database implementations may override it to
+  // write each batch more efficiently, e.g., in a single transaction.
+  virtual std::vector<pose_prior_t> WritePosePriors(
+      span<const PosePrior> pose_priors, bool use_pose_prior_ids = false);
+
   // Write a new entry in the database. The user is responsible for making sure
   // that the entry does not yet exist. For image pairs, the order of
   // `image_id1` and `image_id2` does not matter.
@@ -236,6 +334,14 @@ class Database {
       image_t image_id2,
       const TwoViewGeometry& two_view_geometry) = 0;
 
+  // Add or replace the fingerprint of the features of an existing image.
+  virtual void WriteFeatureExtractionFingerprint(
+      image_t image_id, const FeatureExtractionFingerprint& fingerprint) = 0;
+
+  // Add or replace the global descriptor of an existing image.
+  virtual void WriteGlobalImageDescriptor(
+      image_t image_id, const GlobalImageDescriptor& descriptor) = 0;
+
   // Update an existing rig in the database. The user is responsible for
   // making sure that the entry already exists.
   virtual void UpdateRig(const Rig& rig) = 0;
@@ -263,6 +369,11 @@ class Database {
   virtual void UpdateKeypoints(image_t image_id,
                                const FeatureKeypointsBlob& blob) = 0;
 
+  // Update an existing image's descriptors in the database. The user is
+  // responsible for making sure that the entry already exists.
+  virtual void UpdateDescriptors(image_t image_id,
+                                 const FeatureDescriptors& descriptors) = 0;
+
   // Update an existing two view geometry in the database.
   virtual void UpdateTwoViewGeometry(
       image_t image_id1,
@@ -313,6 +424,19 @@ class Database {
                     const Database& database2,
                     Database* merged_database);
 
+  // Merge multiple databases in one pass into the merged database, which may
+  // already contain entries, e.g., to append a new capture session to an
+  // existing database without rewriting it. The identifiers of all merged
+  // entries are reassigned and the image names must be unique across all
+  // databases. Keypoints and matches are copied as BLOBs.
+  static void Merge(const std::vector<const Database*>& databases,
+                    Database* merged_database);
+
+  // Copy all entries of the source database into the empty target database,
+  // e.g., to convert between different database implementations. In contrast
+  // to `Merge`, all identifiers are preserved.
+  static void Copy(const Database& source, Database* target);
+
   // Combine multiple queries into one transaction by wrapping a code section
   // into a `BeginTransaction` and `EndTransaction`. You can create a scoped
   // transaction with `DatabaseTransaction` that ends when the transaction
@@ -322,6 +446,13 @@ class Database {
   virtual void BeginTransaction() const = 0;
   virtual void EndTransaction() const = 0;
 
+  // Enable or disable the self-described encoding of descriptor and match BLOBs
+  // in subsequent writes to reduce the size of the database. Reads always
+  // handle both raw and encoded BLOBs. Note that encoded BLOBs cannot be read
+  // by older versions of COLMAP. Implementations without encoding support
+  // ignore this setting.
+  virtual void SetBlobCompression(bool enabled);
+
  private:
   friend class DatabaseTransaction;
 
@@ -346,6 +477,33 @@ class DatabaseTransaction {
   std::unique_lock<std::mutex> database_lock_;
 };
 
+// Pool of database connections for concurrent reads from multiple threads,
+// where each connection is used by at most one thread at a time. Threads are
+// preferably handed out the connection they used before and wait if all
+// connections are in use by other threads.
+class DatabaseReadPool {
+ public:
+  explicit DatabaseReadPool(std::vector<std::shared_ptr<Database>> connections);
+
+  size_t NumConnections() const;
+
+  // Executes a function with a connection exclusive to the calling thread.
+  void Read(const std::function<void(const Database& database)>& func);
+
+ private:
+  NON_COPYABLE(DatabaseReadPool)
+  NON_MOVABLE(DatabaseReadPool)
+
+  size_t AcquireConnection();
+  void ReleaseConnection(size_t connection_idx);
+
+  const std::vector<std::shared_ptr<Database>> connections_;
+  std::vector<bool> in_use_;
+  std::unordered_map<std::thread::id, size_t> thread_connection_idxs_;
+  std::mutex mutex_;
+  std::condition_variable release_condition_;
+};
+
 // Loads random descriptors from random images in the database.
 FeatureDescriptorsFloat LoadRandomDatabaseDescriptors(const Database& database,
                                                       int max_num_descriptors);
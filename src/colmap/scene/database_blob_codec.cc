@@ -0,0 +1,280 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/scene/database_blob_codec.h"
+
+#include "colmap/util/logging.h"
+
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace colmap {
+namespace {
+
+constexpr char kBlobMagic[4] = {'C', 'B', 'L', 'B'};
+// Minimum run length of identical bytes to be coded as a run.
+constexpr size_t kMinRunLength = 3;
+
+void WriteVarint(uint64_t value, std::string* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+uint64_t ReadVarint(const char* data, size_t num_bytes, size_t* offset) {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    THROW_CHECK_LT(*offset, num_bytes) << "Truncated encoded BLOB";
+    const uint8_t byte = static_cast<uint8_t>(data[(*offset)++]);
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  LOG(FATAL_THROW) << "Invalid varint in encoded BLOB";
+  return 0;
+}
+
+uint64_t ZigzagEncode(const int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigzagDecode(const uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void EncodeDeltaVarint(const size_t num_cols,
+                       const char* data,
+                       const size_t num_bytes,
+                       std::string* encoded) {
+  const size_t num_values = num_bytes / sizeof(uint32_t);
+  int64_t prev_value = 0;
+  for (size_t i = 0; i < num_values; ++i) {
+    uint32_t value;
+    std::memcpy(&value, data + i * sizeof(uint32_t), sizeof(uint32_t));
+    if (i % num_cols == 0) {
+      WriteVarint(ZigzagEncode(static_cast<int64_t>(value) - prev_value),
+                  encoded);
+      prev_value = value;
+    } else {
+      WriteVarint(value, encoded);
+    }
+  }
+}
+
+void DecodeDeltaVarint(const size_t num_cols,
+                       const char* data,
+                       const size_t num_bytes,
+                       size_t offset,
+                       char* raw_data,
+                       const size_t raw_num_bytes) {
+  const size_t num_values = raw_num_bytes / sizeof(uint32_t);
+  int64_t prev_value = 0;
+  for (size_t i = 0; i < num_values; ++i) {
+    int64_t value;
+    if (i % num_cols == 0) {
+      value = prev_value + ZigzagDecode(ReadVarint(data, num_bytes, &offset));
+      prev_value = value;
+    } else {
+      value = static_cast<int64_t>(ReadVarint(data, num_bytes, &offset));
+    }
+    THROW_CHECK(value >= 0 && value <= std::numeric_limits<uint32_t>::max())
+        << "Invalid value in encoded BLOB";
+    const uint32_t value32 = static_cast<uint32_t>(value);
+    std::memcpy(raw_data + i * sizeof(uint32_t), &value32, sizeof(uint32_t));
+  }
+  THROW_CHECK_EQ(offset, num_bytes) << "Trailing bytes in encoded BLOB";
+}
+
+// Run-length tokens are varints of (length << 1 | is_run), followed by the
+// repeated byte for runs or the literal bytes otherwise.
+void EncodeBytePlane(const size_t element_size,
+                     const char* data,
+                     const size_t num_bytes,
+                     std::string* encoded) {
+  const size_t num_elements = num_bytes / element_size;
+  std::vector<char> planes(num_bytes);
+  for (size_t i = 0; i < num_elements; ++i) {
+    for (size_t j = 0; j < element_size; ++j) {
+      planes[j * num_elements + i] = data[i * element_size + j];
+    }
+  }
+
+  size_t literal_begin = 0;
+  const auto write_literals = [&](const size_t literal_end) {
+    if (literal_end > literal_begin) {
+      WriteVarint((literal_end - literal_begin) << 1, encoded);
+      encoded->append(planes.data() + literal_begin,
+                      literal_end - literal_begin);
+    }
+  };
+
+  size_t i = 0;
+  while (i < num_bytes) {
+    size_t run_end = i + 1;
+    while (run_end < num_bytes && planes[run_end] == planes[i]) {
+      ++run_end;
+    }
+    if (run_end - i >= kMinRunLength) {
+      write_literals(i);
+      WriteVarint(((run_end - i) << 1) | 1, encoded);
+      encoded->push_back(planes[i]);
+      literal_begin = run_end;
+    }
+    i = run_end;
+  }
+  write_literals(num_bytes);
+}
+
+void DecodeBytePlane(const size_t element_size,
+                     const char* data,
+                     const size_t num_bytes,
+                     size_t offset,
+                     char* raw_data,
+                     const size_t raw_num_bytes) {
+  std::vector<char> planes;
+  planes.reserve(raw_num_bytes);
+  while (offset < num_bytes) {
+    const uint64_t token = ReadVarint(data, num_bytes, &offset);
+    const size_t length = static_cast<size_t>(token >> 1);
+    THROW_CHECK_LE(length, raw_num_bytes - planes.size())
+        << "Invalid run length in encoded BLOB";
+    if (token & 1) {
+      THROW_CHECK_LT(offset, num_bytes) << "Truncated encoded BLOB";
+      planes.insert(planes.end(), length, data[offset++]);
+    } else {
+      THROW_CHECK_LE(length, num_bytes - offset) << "Truncated encoded BLOB";
+      planes.insert(planes.end(), data + offset, data + offset + length);
+      offset += length;
+    }
+  }
+  THROW_CHECK_EQ(planes.size(), raw_num_bytes) << "Truncated encoded BLOB";
+
+  const size_t num_elements = raw_num_bytes / element_size;
+  for (size_t i = 0; i < num_elements; ++i) {
+    for (size_t j = 0; j < element_size; ++j) {
+      raw_data[i * element_size + j] = planes[j * num_elements + i];
+    }
+  }
+}
+
+}  // namespace
+
+bool EncodeBlob(const BlobCodec codec,
+                const size_t codec_param,
+                const char* data,
+                const size_t num_bytes,
+                std::string* encoded) {
+  THROW_CHECK_NOTNULL(encoded);
+  encoded->clear();
+
+  if (num_bytes == 0 || codec_param == 0) {
+    return false;
+  }
+
+  switch (codec) {
+    case BlobCodec::DELTA_VARINT:
+      if (num_bytes % (codec_param * sizeof(uint32_t)) != 0) {
+        return false;
+      }
+      break;
+    case BlobCodec::BYTE_PLANE:
+      if (num_bytes % codec_param != 0) {
+        return false;
+      }
+      break;
+    default:
+      LOG(FATAL_THROW) << "Unknown BLOB codec";
+  }
+
+  encoded->reserve(num_bytes);
+  encoded->append(kBlobMagic, sizeof(kBlobMagic));
+  encoded->push_back(static_cast<char>(codec));
+  WriteVarint(codec_param, encoded);
+  WriteVarint(num_bytes, encoded);
+
+  switch (codec) {
+    case BlobCodec::DELTA_VARINT:
+      EncodeDeltaVarint(codec_param, data, num_bytes, encoded);
+      break;
+    case BlobCodec::BYTE_PLANE:
+      EncodeBytePlane(codec_param, data, num_bytes, encoded);
+      break;
+  }
+
+  if (encoded->size() >= num_bytes) {
+    encoded->clear();
+    return false;
+  }
+
+  return true;
+}
+
+bool IsEncodedBlob(const char* data, const size_t num_bytes) {
+  return num_bytes > sizeof(kBlobMagic) &&
+         std::memcmp(data, kBlobMagic, sizeof(kBlobMagic)) == 0;
+}
+
+void DecodeBlob(const char* data,
+                const size_t num_bytes,
+                char* raw_data,
+                const size_t raw_num_bytes) {
+  THROW_CHECK(IsEncodedBlob(data, num_bytes))
+      << "BLOB is neither raw nor encoded";
+
+  size_t offset = sizeof(kBlobMagic);
+  const BlobCodec codec = static_cast<BlobCodec>(data[offset++]);
+  const size_t codec_param =
+      static_cast<size_t>(ReadVarint(data, num_bytes, &offset));
+  THROW_CHECK_GT(codec_param, 0);
+  THROW_CHECK_EQ(ReadVarint(data, num_bytes, &offset), raw_num_bytes)
+      << "Unexpected size of encoded BLOB";
+
+  switch (codec) {
+    case BlobCodec::DELTA_VARINT:
+      THROW_CHECK_EQ(raw_num_bytes % (codec_param * sizeof(uint32_t)), 0);
+      DecodeDeltaVarint(
+          codec_param, data, num_bytes, offset, raw_data, raw_num_bytes);
+      break;
+    case BlobCodec::BYTE_PLANE:
+      THROW_CHECK_EQ(raw_num_bytes % codec_param, 0);
+      DecodeBytePlane(
+          codec_param, data, num_bytes, offset, raw_data, raw_num_bytes);
+      break;
+    default:
+      LOG(FATAL_THROW) << "Unknown BLOB codec: " << static_cast<int>(codec);
+  }
+}
+
+}  // namespace colmap
@@ -0,0 +1,74 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace colmap {
+
+// Self-described encodings of database BLOBs. An encoded BLOB starts with a
+// magic number, the codec, its parameter, and the number of raw bytes,
+// followed by the encoded payload. Encoders only succeed if the result is
+// smaller than the raw data, so that readers can tell raw and encoded BLOBs
+// apart by comparing the BLOB size against the expected raw size.
+enum class BlobCodec : uint8_t {
+  // Row-major matrix of uint32 values with the given number of columns, e.g.,
+  // feature matches. The first column is delta and zigzag coded, because it is
+  // typically sorted, and then all values are varint coded.
+  DELTA_VARINT = 1,
+  // Array of elements with the given number of bytes per element, e.g.,
+  // feature descriptors. The bytes are split into one plane per byte position
+  // of the elements and then run-length coded.
+  BYTE_PLANE = 2,
+};
+
+// Encode the raw data with the given codec and parameter. Returns false, if the
+// data is not compatible with the codec or the encoded data is not smaller
+// than the raw data.
+bool EncodeBlob(BlobCodec codec,
+                size_t codec_param,
+                const char* data,
+                size_t num_bytes,
+                std::string* encoded);
+
+// Check whether the BLOB starts with the header of an encoded BLOB.
+bool IsEncodedBlob(const char* data, size_t num_bytes);
+
+// Decode an encoded BLOB into the output buffer with the expected number of
+// raw bytes. Throws if the BLOB is corrupt or has a different raw size.
+void DecodeBlob(const char* data,
+                size_t num_bytes,
+                char* raw_data,
+                size_t raw_num_bytes);
+
+}  // namespace colmap
@@ -0,0 +1,141 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/scene/database_blob_codec.h"
+
+#include <string>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+template <typename T>
+std::vector<T> EncodeAndDecode(const BlobCodec codec,
+                               const size_t codec_param,
+                               const std::vector<T>& values) {
+  const size_t num_bytes = values.size() * sizeof(T);
+  std::string encoded;
+  EXPECT_TRUE(EncodeBlob(codec,
+                         codec_param,
+                         reinterpret_cast<const char*>(values.data()),
+                         num_bytes,
+                         &encoded));
+  EXPECT_LT(encoded.size(), num_bytes);
+  EXPECT_TRUE(IsEncodedBlob(encoded.data(), encoded.size()));
+  std::vector<T> decoded(values.size());
+  DecodeBlob(encoded.data(),
+             encoded.size(),
+             reinterpret_cast<char*>(decoded.data()),
+             num_bytes);
+  return decoded;
+}
+
+TEST(DatabaseBlobCodec, DeltaVarint) {
+  std::vector<uint32_t> matches;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    matches.push_back(2 * i);
+    matches.push_back((i * 7919) % 5000);
+  }
+  // Unsorted values in the first column.
+  matches[10] = 0;
+  matches[12] = std::numeric_limits<uint32_t>::max();
+  EXPECT_EQ(EncodeAndDecode(BlobCodec::DELTA_VARINT, 2, matches), matches);
+}
+
+TEST(DatabaseBlobCodec, BytePlane) {
+  std::vector<uint8_t> descriptors(128 * 100, 0);
+  for (size_t i = 0; i < descriptors.size(); i += 5) {
+    descriptors[i] = static_cast<uint8_t>(i % 251);
+  }
+  EXPECT_EQ(EncodeAndDecode(BlobCodec::BYTE_PLANE, 1, descriptors),
+            descriptors);
+
+  std::vector<float> float_descriptors(128 * 100);
+  for (size_t i = 0; i < float_descriptors.size(); ++i) {
+    float_descriptors[i] = (i % 3 == 0) ? 0.f : 0.25f;
+  }
+  EXPECT_EQ(EncodeAndDecode(BlobCodec::BYTE_PLANE, 4, float_descriptors),
+            float_descriptors);
+}
+
+TEST(DatabaseBlobCodec, Incompressible) {
+  std::vector<uint8_t> data(100);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>(i);
+  }
+  std::string encoded;
+  EXPECT_FALSE(EncodeBlob(BlobCodec::BYTE_PLANE,
+                          1,
+                          reinterpret_cast<const char*>(data.data()),
+                          data.size(),
+                          &encoded));
+  EXPECT_TRUE(encoded.empty());
+  // Size not divisible by the number of columns.
+  EXPECT_FALSE(EncodeBlob(BlobCodec::DELTA_VARINT,
+                          2,
+                          reinterpret_cast<const char*>(data.data()),
+                          12,
+                          &encoded));
+  EXPECT_FALSE(EncodeBlob(BlobCodec::DELTA_VARINT,
+                          2,
+                          reinterpret_cast<const char*>(data.data()),
+                          0,
+                          &encoded));
+}
+
+TEST(DatabaseBlobCodec, DecodeCorrupt) {
+  const std::vector<uint32_t> matches(200, 1);
+  const size_t num_bytes = matches.size() * sizeof(uint32_t);
+  std::string encoded;
+  ASSERT_TRUE(EncodeBlob(BlobCodec::DELTA_VARINT,
+                         2,
+                         reinterpret_cast<const char*>(matches.data()),
+                         num_bytes,
+                         &encoded));
+  std::vector<uint32_t> decoded(matches.size());
+  char* raw_data = reinterpret_cast<char*>(decoded.data());
+  EXPECT_ANY_THROW(DecodeBlob(encoded.data(),
+                              encoded.size() - 1,
+                              raw_data,
+                              num_bytes));
+  EXPECT_ANY_THROW(
+      DecodeBlob(encoded.data(), encoded.size(), raw_data, num_bytes - 8));
+  std::string corrupt = encoded;
+  corrupt[0] = 'X';
+  EXPECT_FALSE(IsEncodedBlob(corrupt.data(), corrupt.size()));
+  EXPECT_ANY_THROW(
+      DecodeBlob(corrupt.data(), corrupt.size(), raw_data, num_bytes));
+}
+
+}  // namespace
+}  // namespace colmap
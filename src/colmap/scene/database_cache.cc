@@ -33,6 +33,9 @@
 #include "colmap/util/string.h"
 #include "colmap/util/timer.h"
 
+#include <algorithm>
+#include <functional>
+
 namespace colmap {
 namespace {
 
@@ -53,12 +56,172 @@ std::vector<Eigen::Vector2d> FeatureKeypointsToPointsVector(
   return points;
 }
 
+// Reads the two-view geometries of the given image pairs in batches to bound
+// the memory of the intermediate matches.
+void ForEachTwoViewGeometry(
+    const Database& database,
+    const std::vector<image_pair_t>& pair_ids,
+    const std::function<void(image_pair_t, TwoViewGeometry&)>& func) {
+  constexpr size_t kTwoViewGeometriesBatchSize = 1000;
+  for (size_t begin = 0; begin < pair_ids.size();
+       begin += kTwoViewGeometriesBatchSize) {
+    const size_t batch_size =
+        std::min(kTwoViewGeometriesBatchSize, pair_ids.size() - begin);
+    std::vector<TwoViewGeometry> two_view_geometries =
+        database.ReadTwoViewGeometries(
+            span<const image_pair_t>(pair_ids.data() + begin, batch_size));
+    for (size_t i = 0; i < batch_size; ++i) {
+      func(pair_ids[begin + i], two_view_geometries[i]);
+    }
+  }
+}
+
+// Determines the image pairs to stream into the correspondence graph and
+// counts the maximum number of correspondences per image point, such that the
+// correspondences can be directly stored in the flattened graph layout.
+// Returns the number of ignored image pairs.
+size_t ReserveStreamedTwoViewGeometries(
+    const Database& database,
+    const DatabaseCache::Options& options,
+    const std::unordered_set<frame_t>& frame_ids,
+    const std::unordered_map<image_t, frame_t>& image_to_frame_id,
+    std::vector<image_pair_t>* pair_ids,
+    std::unordered_map<image_t, std::vector<point2D_t>>* max_num_corrs,
+    std::unordered_set<frame_t>* connected_frame_ids) {
+  // Apply the cheap filters before reading any of the matches.
+  const std::vector<std::pair<image_pair_t, int>> num_inliers_per_pair =
+      database.ReadTwoViewGeometryNumInliers();
+  std::vector<image_pair_t> candidate_pair_ids;
+  for (const auto& [pair_id, num_inliers] : num_inliers_per_pair) {
+    if (static_cast<size_t>(num_inliers) < options.min_num_matches) {
+      continue;
+    }
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    if (frame_ids.count(image_to_frame_id.at(image_id1)) > 0 &&
+        frame_ids.count(image_to_frame_id.at(image_id2)) > 0) {
+      candidate_pair_ids.push_back(pair_id);
+    }
+  }
+
+  pair_ids->clear();
+  ForEachTwoViewGeometry(
+      database,
+      candidate_pair_ids,
+      [&](const image_pair_t pair_id,
+          const TwoViewGeometry& two_view_geometry) {
+        if (!UseInlierMatchesCheck(options,
+                                   two_view_geometry.config,
+                                   two_view_geometry.inlier_matches.size())) {
+          return;
+        }
+        pair_ids->push_back(pair_id);
+
+        const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+        connected_frame_ids->insert(image_to_frame_id.at(image_id1));
+        connected_frame_ids->insert(image_to_frame_id.at(image_id2));
+
+        std::vector<point2D_t>& max_num_corrs1 = (*max_num_corrs)[image_id1];
+        std::vector<point2D_t>& max_num_corrs2 = (*max_num_corrs)[image_id2];
+        for (const auto& match : two_view_geometry.inlier_matches) {
+          if (match.point2D_idx1 >= max_num_corrs1.size()) {
+            max_num_corrs1.resize(match.point2D_idx1 + 1, 0);
+          }
+          if (match.point2D_idx2 >= max_num_corrs2.size()) {
+            max_num_corrs2.resize(match.point2D_idx2 + 1, 0);
+          }
+          max_num_corrs1[match.point2D_idx1] += 1;
+          max_num_corrs2[match.point2D_idx2] += 1;
+        }
+      });
+
+  return num_inliers_per_pair.size() - pair_ids->size();
+}
+
+// Incremental 64-bit FNV-1a hash of plain values and strings.
+class SnapshotKeyHasher {
+ public:
+  template <typename T>
+  void Add(const T& value) {
+    AddBytes(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void Add(const std::string& value) {
+    Add<uint64_t>(value.size());
+    AddBytes(value.data(), value.size());
+  }
+
+  uint64_t Hash() const { return hash_; }
+
+ private:
+  void AddBytes(const char* data, size_t num_bytes) {
+    for (size_t i = 0; i < num_bytes; ++i) {
+      hash_ ^= static_cast<uint8_t>(data[i]);
+      hash_ *= 0x100000001b3;
+    }
+  }
+
+  uint64_t hash_ = 0xcbf29ce484222325;
+};
+
+// Computes the key of the data and options that determine the correspondence
+// graph. To avoid reading all matches, they are only represented by their
+// number per image pair together with the total number of keypoints.
+uint64_t ComputeCorrespondenceGraphSnapshotKey(
+    const Database& database,
+    const DatabaseCache::Options& options,
+    const std::vector<Image>& images) {
+  SnapshotKeyHasher hasher;
+
+  hasher.Add<uint64_t>(options.min_num_matches);
+  hasher.Add<uint8_t>(options.ignore_watermarks);
+  hasher.Add<uint8_t>(options.load_all_images);
+  hasher.Add<uint8_t>(options.stream_two_view_geometries);
+  std::vector<std::string> image_names(options.image_names.begin(),
+                                       options.image_names.end());
+  std::sort(image_names.begin(), image_names.end());
+  for (const std::string& image_name : image_names) {
+    hasher.Add(image_name);
+  }
+
+  hasher.Add<uint64_t>(images.size());
+  for (const auto& image : images) {
+    hasher.Add(image.ImageId());
+    hasher.Add(image.HasFrameId() ? image.FrameId() : kInvalidFrameId);
+    hasher.Add(image.Name());
+  }
+
+  hasher.Add<uint64_t>(database.NumKeypoints());
+  for (const auto& [pair_id, num_inliers] :
+       database.ReadTwoViewGeometryNumInliers()) {
+    hasher.Add(pair_id);
+    hasher.Add(num_inliers);
+  }
+
+  return hasher.Hash();
+}
+
 }  // namespace
 
 DatabaseCache::DatabaseCache()
-    : correspondence_graph_(std::make_shared<class CorrespondenceGraph>()) {}
+    : pose_priors_(std::make_shared<std::vector<struct PosePrior>>()),
+      correspondence_graph_(std::make_shared<class CorrespondenceGraph>()) {}
 
 void DatabaseCache::Load(const Database& database, const Options& options) {
+  THROW_CHECK(!options.lazy_load_points2D)
+      << "Lazy loading of points2D requires shared ownership of the database";
+  LoadImpl(database, options);
+}
+
+void DatabaseCache::Load(std::shared_ptr<const Database> database,
+                         const Options& options) {
+  LoadImpl(*THROW_CHECK_NOTNULL(database), options);
+  if (options.lazy_load_points2D) {
+    lazy_database_ = std::move(database);
+    lazy_database_mutex_ = std::make_shared<std::mutex>();
+  }
+}
+
+void DatabaseCache::LoadImpl(const Database& database, const Options& options) {
   const bool has_rigs = database.NumRigs() > 0;
   const bool has_frames = database.NumFrames() > 0;
 
@@ -126,18 +289,50 @@ void DatabaseCache::Load(const Database& database, const Options& options) {
   LOG(INFO) << StringPrintf(
       " %d in %.3fs", frames_.size(), timer.ElapsedSeconds());
 
+  std::vector<class Image> images = database.ReadAllImages();
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Load correspondence graph snapshot
+  //////////////////////////////////////////////////////////////////////////////
+
+  // The snapshot is only used, if it was built from the same data with the
+  // same options, in which case the matches are not read at all.
+  uint64_t snapshot_key = 0;
+  std::shared_ptr<class CorrespondenceGraph> snapshot_correspondence_graph;
+  if (!options.correspondence_graph_snapshot_path.empty()) {
+    timer.Restart();
+    LOG(INFO) << "Loading correspondence graph snapshot...";
+
+    snapshot_key =
+        ComputeCorrespondenceGraphSnapshotKey(database, options, images);
+    auto correspondence_graph = std::make_shared<class CorrespondenceGraph>();
+    if (correspondence_graph->ReadSnapshot(
+            options.correspondence_graph_snapshot_path, snapshot_key)) {
+      snapshot_correspondence_graph = std::move(correspondence_graph);
+      LOG(INFO) << StringPrintf(
+          " %d image pairs in %.3fs",
+          snapshot_correspondence_graph->NumImagePairs(),
+          timer.ElapsedSeconds());
+    } else {
+      LOG(INFO) << " missing or outdated";
+    }
+  }
+
   //////////////////////////////////////////////////////////////////////////////
   // Load matches
   //////////////////////////////////////////////////////////////////////////////
 
-  timer.Restart();
-  LOG(INFO) << "Loading matches...";
+  // In streaming mode, the matches are read while loading the images below.
+  std::vector<std::pair<image_pair_t, TwoViewGeometry>> two_view_geometries;
+  if (!snapshot_correspondence_graph && !options.stream_two_view_geometries) {
+    timer.Restart();
+    LOG(INFO) << "Loading matches...";
 
-  std::vector<std::pair<image_pair_t, TwoViewGeometry>> two_view_geometries =
-      database.ReadTwoViewGeometries();
+    two_view_geometries = database.ReadTwoViewGeometries();
 
-  LOG(INFO) << StringPrintf(
-      " %d in %.3fs", two_view_geometries.size(), timer.ElapsedSeconds());
+    LOG(INFO) << StringPrintf(
+        " %d in %.3fs", two_view_geometries.size(), timer.ElapsedSeconds());
+  }
 
   //////////////////////////////////////////////////////////////////////////////
   // Load images
@@ -149,8 +344,12 @@ void DatabaseCache::Load(const Database& database, const Options& options) {
   std::unordered_set<frame_t> frame_ids;
   std::unordered_map<image_t, frame_t> image_to_frame_id;
 
+  // Image pairs and reserved correspondences in streaming mode.
+  std::vector<image_pair_t> stream_pair_ids;
+  std::unordered_map<image_t, std::vector<point2D_t>> max_num_corrs;
+  size_t num_ignored_image_pairs = 0;
+
   {
-    std::vector<class Image> images = database.ReadAllImages();
     const size_t num_images = images.size();
 
     for (auto& image : images) {
@@ -185,7 +384,25 @@ void DatabaseCache::Load(const Database& database, const Options& options) {
 
     // Collect all images that are connected in the correspondence graph.
     std::unordered_set<frame_t> connected_frame_ids;
-    if (!options.load_all_images) {
+    if (snapshot_correspondence_graph) {
+      if (!options.load_all_images) {
+        for (const image_pair_t pair_id :
+             snapshot_correspondence_graph->ImagePairs()) {
+          const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+          connected_frame_ids.insert(image_to_frame_id.at(image_id1));
+          connected_frame_ids.insert(image_to_frame_id.at(image_id2));
+        }
+      }
+    } else if (options.stream_two_view_geometries) {
+      num_ignored_image_pairs =
+          ReserveStreamedTwoViewGeometries(database,
+                                           options,
+                                           frame_ids,
+                                           image_to_frame_id,
+                                           &stream_pair_ids,
+                                           &max_num_corrs,
+                                           &connected_frame_ids);
+    } else if (!options.load_all_images) {
       connected_frame_ids.reserve(frame_ids.size());
       for (const auto& [pair_id, two_view_geometry] : two_view_geometries) {
         if (UseInlierMatchesCheck(options,
@@ -220,16 +437,47 @@ void DatabaseCache::Load(const Database& database, const Options& options) {
     // not useful for SfM. When load_all_images is true, all candidate images
     // are loaded so that their keypoints are populated (e.g., for
     // triangulation on an existing reconstruction).
-    images_.reserve(load_frame_ids.size());
-    for (auto& image : images) {
-      if (load_frame_ids.count(image.FrameId()) == 0) {
-        continue;
+    std::vector<image_t> load_image_ids;
+    load_image_ids.reserve(load_frame_ids.size());
+    for (const auto& image : images) {
+      if (load_frame_ids.count(image.FrameId()) > 0) {
+        load_image_ids.push_back(image.ImageId());
       }
+    }
 
-      const image_t image_id = image.ImageId();
-      image.SetPoints2D(
-          FeatureKeypointsToPointsVector(database.ReadKeypoints(image_id)));
-      images_.emplace(image_id, std::move(image));
+    std::unordered_map<image_t, class Image*> image_id_to_image;
+    image_id_to_image.reserve(images.size());
+    for (auto& image : images) {
+      image_id_to_image.emplace(image.ImageId(), &image);
+    }
+
+    // Read the keypoints in batches to reduce the per-query overhead while
+    // bounding the memory of the intermediate keypoints. In lazy mode, only
+    // the number of keypoints is read.
+    constexpr size_t kKeypointsBatchSize = 1000;
+    images_.reserve(load_image_ids.size());
+    if (options.lazy_load_points2D) {
+      num_lazy_points2D_.reserve(load_image_ids.size());
+      for (const image_t image_id : load_image_ids) {
+        num_lazy_points2D_.emplace(
+            image_id,
+            static_cast<point2D_t>(database.NumKeypointsForImage(image_id)));
+        images_.emplace(image_id, std::move(*image_id_to_image.at(image_id)));
+      }
+    } else {
+      for (size_t begin = 0; begin < load_image_ids.size();
+           begin += kKeypointsBatchSize) {
+        const size_t batch_size =
+            std::min(kKeypointsBatchSize, load_image_ids.size() - begin);
+        std::vector<FeatureKeypoints> keypoints = database.ReadKeypoints(
+            span<const image_t>(load_image_ids.data() + begin, batch_size));
+        for (size_t i = 0; i < batch_size; ++i) {
+          const image_t image_id = load_image_ids[begin + i];
+          class Image& image = *image_id_to_image.at(image_id);
+          image.SetPoints2D(FeatureKeypointsToPointsVector(keypoints[i]));
+          images_.emplace(image_id, std::move(image));
+        }
+      }
     }
 
     if (options.load_all_images) {
@@ -246,6 +494,8 @@ void DatabaseCache::Load(const Database& database, const Options& options) {
     }
   }
 
+  IndexImageNames();
+
   //////////////////////////////////////////////////////////////////////////////
   // Load pose priors
   //////////////////////////////////////////////////////////////////////////////
@@ -254,29 +504,58 @@ void DatabaseCache::Load(const Database& database, const Options& options) {
 
   LOG(INFO) << "Loading pose priors...";
 
-  pose_priors_ = database.ReadAllPosePriors();
+  pose_priors_ = std::make_shared<std::vector<struct PosePrior>>(
+      database.ReadAllPosePriors());
 
   if (options.convert_pose_priors_to_enu) {
     ConvertPosePriorsToENU();
   }
 
   LOG(INFO) << StringPrintf(
-      " %d in %.3fs", pose_priors_.size(), timer.ElapsedSeconds());
+      " %d in %.3fs", pose_priors_->size(), timer.ElapsedSeconds());
 
   //////////////////////////////////////////////////////////////////////////////
   // Build correspondence graph
   //////////////////////////////////////////////////////////////////////////////
 
+  if (snapshot_correspondence_graph) {
+    THROW_CHECK_EQ(snapshot_correspondence_graph->NumImages(), images_.size());
+    correspondence_graph_ = std::move(snapshot_correspondence_graph);
+    return;
+  }
+
   timer.Restart();
   LOG(INFO) << "Building correspondence graph...";
 
   correspondence_graph_ = std::make_shared<class CorrespondenceGraph>();
 
-  for (const auto& [image_id, image] : images_) {
-    correspondence_graph_->AddImage(image_id, image.NumPoints2D());
+  if (options.stream_two_view_geometries) {
+    for (const auto& [image_id, image] : images_) {
+      std::vector<point2D_t> image_max_num_corrs;
+      if (const auto it = max_num_corrs.find(image_id);
+          it != max_num_corrs.end()) {
+        image_max_num_corrs = std::move(it->second);
+        max_num_corrs.erase(it);
+      }
+      // Correspondences to non-existent points are ignored by the graph.
+      image_max_num_corrs.resize(NumPoints2D(image_id), 0);
+      correspondence_graph_->AddImage(image_id, image_max_num_corrs);
+    }
+
+    ForEachTwoViewGeometry(
+        database,
+        stream_pair_ids,
+        [this](const image_pair_t pair_id, TwoViewGeometry& two_view_geometry) {
+          const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+          correspondence_graph_->AddTwoViewGeometry(
+              image_id1, image_id2, std::move(two_view_geometry));
+        });
+  } else {
+    for (const auto& [image_id, image] : images_) {
+      correspondence_graph_->AddImage(image_id, NumPoints2D(image_id));
+    }
   }
 
-  size_t num_ignored_image_pairs = 0;
   for (auto& [pair_id, two_view_geometry] : two_view_geometries) {
     if (UseInlierMatchesCheck(options,
                               two_view_geometry.config,
@@ -300,6 +579,13 @@ void DatabaseCache::Load(const Database& database, const Options& options) {
   LOG(INFO) << StringPrintf(" in %.3fs (ignored %d)",
                             timer.ElapsedSeconds(),
                             num_ignored_image_pairs);
+
+  if (!options.correspondence_graph_snapshot_path.empty()) {
+    LOG(INFO) << "Writing correspondence graph snapshot to "
+              << options.correspondence_graph_snapshot_path;
+    correspondence_graph_->WriteSnapshot(
+        options.correspondence_graph_snapshot_path, snapshot_key);
+  }
 }
 
 std::shared_ptr<DatabaseCache> DatabaseCache::Create(const Database& database,
@@ -309,36 +595,50 @@ std::shared_ptr<DatabaseCache> DatabaseCache::Create(const Database& database,
   return cache;
 }
 
+std::shared_ptr<DatabaseCache> DatabaseCache::Create(
+    std::shared_ptr<const Database> database, const Options& options) {
+  auto cache = std::make_shared<DatabaseCache>();
+  cache->Load(std::move(database), options);
+  return cache;
+}
+
 std::shared_ptr<DatabaseCache> DatabaseCache::CreateFromCache(
     const DatabaseCache& database_cache, const Options& options) {
   auto cache = std::make_shared<DatabaseCache>();
 
-  // Collect candidate image ids matching the name filter.
-  // Empty image_names means use all images.
+  // Collect candidate image ids matching the name filter. Looking up the names
+  // instead of scanning all images keeps the cost proportional to the number
+  // of selected images. Empty image_names means use all images.
   std::unordered_set<image_t> candidate_image_ids;
-  for (const auto& [image_id, image] : database_cache.Images()) {
-    if (options.image_names.empty() ||
-        options.image_names.count(image.Name()) > 0) {
+  if (options.image_names.empty()) {
+    candidate_image_ids.reserve(database_cache.NumImages());
+    for (const auto& [image_id, image] : database_cache.Images()) {
       candidate_image_ids.insert(image_id);
     }
+  } else {
+    candidate_image_ids.reserve(options.image_names.size());
+    for (const std::string& image_name : options.image_names) {
+      if (const auto it = database_cache.image_name_to_id_.find(image_name);
+          it != database_cache.image_name_to_id_.end()) {
+        candidate_image_ids.insert(it->second);
+      }
+    }
   }
 
   const auto& source_graph = database_cache.CorrespondenceGraph();
 
   std::unordered_set<image_t> connected_image_ids;
   if (!options.load_all_images) {
-    for (const auto& [pair_id, num_matches] :
-         source_graph->NumMatchesBetweenAllImages()) {
+    for (const image_pair_t pair_id :
+         source_graph->ImagePairsBetweenImages(candidate_image_ids)) {
       const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
-      if (candidate_image_ids.count(image_id1) == 0 ||
-          candidate_image_ids.count(image_id2) == 0) {
-        continue;
-      }
       const TwoViewGeometry two_view_geometry =
           source_graph->ExtractTwoViewGeometry(
               image_id1, image_id2, /*extract_inlier_matches=*/false);
       if (!UseInlierMatchesCheck(
-              options, two_view_geometry.config, num_matches)) {
+              options,
+              two_view_geometry.config,
+              source_graph->NumMatchesBetweenImages(image_id1, image_id2))) {
         continue;
       }
       connected_image_ids.insert(image_id1);
@@ -349,76 +649,112 @@ std::shared_ptr<DatabaseCache> DatabaseCache::CreateFromCache(
   const std::unordered_set<image_t>& load_image_ids =
       options.load_all_images ? candidate_image_ids : connected_image_ids;
 
-  // Collect frame ids for images to load.
-  std::unordered_set<frame_t> filtered_frame_ids;
-  for (const image_t image_id : load_image_ids) {
-    const auto& image = database_cache.Image(image_id);
-    filtered_frame_ids.insert(image.FrameId());
-  }
-
-  // Copy all images of filtered frames (not just the images matching the
-  // name filter). This is needed for multi-camera rigs where the generalized
-  // pose solver needs all images of a frame.
   std::unordered_set<camera_t> filtered_camera_ids;
-  for (const auto& [image_id, image] : database_cache.Images()) {
-    if (filtered_frame_ids.count(image.FrameId()) > 0) {
-      cache->images_.emplace(image_id, image);
-      filtered_camera_ids.insert(image.CameraId());
+  std::unordered_set<image_t> filtered_image_ids;
+  auto AddFilteredImage = [&](const class Image& image) {
+    const image_t image_id = image.ImageId();
+    if (!filtered_image_ids.insert(image_id).second) {
+      return;
     }
-  }
+    cache->images_.emplace(image_id, image);
+    filtered_camera_ids.insert(image.CameraId());
+    if (const auto it = database_cache.num_lazy_points2D_.find(image_id);
+        it != database_cache.num_lazy_points2D_.end()) {
+      cache->num_lazy_points2D_.emplace(image_id, it->second);
+    }
+  };
 
-  // Copy filtered frames and collect rig ids.
+  // Copy the frames of the images to load and all images of these frames
+  // (not just the images matching the name filter). This is needed for
+  // multi-camera rigs where the generalized pose solver needs all images of a
+  // frame.
   std::unordered_set<rig_t> filtered_rig_ids;
-  for (const auto& [frame_id, frame] : database_cache.Frames()) {
-    if (filtered_frame_ids.count(frame_id) > 0) {
-      cache->frames_.emplace(frame_id, frame);
-      filtered_rig_ids.insert(frame.RigId());
+  for (const image_t image_id : load_image_ids) {
+    const class Image& image = database_cache.Image(image_id);
+    const auto frame_it = database_cache.frames_.find(image.FrameId());
+    if (frame_it == database_cache.frames_.end()) {
+      AddFilteredImage(image);
+      continue;
+    }
+    const auto& [frame_id, frame] = *frame_it;
+    if (!cache->frames_.emplace(frame_id, frame).second) {
+      continue;
+    }
+    filtered_rig_ids.insert(frame.RigId());
+    for (const data_t& data_id : frame.ImageIds()) {
+      if (const auto it = database_cache.images_.find(data_id.id);
+          it != database_cache.images_.end()) {
+        AddFilteredImage(it->second);
+      }
     }
   }
+  cache->lazy_database_ = database_cache.lazy_database_;
+  cache->lazy_database_mutex_ = database_cache.lazy_database_mutex_;
+  cache->IndexImageNames();
 
   // Copy filtered cameras.
-  for (const auto& [camera_id, camera] : database_cache.Cameras()) {
-    if (filtered_camera_ids.count(camera_id) > 0) {
-      cache->cameras_.emplace(camera_id, camera);
-    }
+  for (const camera_t camera_id : filtered_camera_ids) {
+    cache->cameras_.emplace(camera_id, database_cache.Camera(camera_id));
   }
 
   // Copy filtered rigs.
-  for (const auto& [rig_id, rig] : database_cache.Rigs()) {
-    if (filtered_rig_ids.count(rig_id) > 0) {
-      cache->rigs_.emplace(rig_id, rig);
-    }
+  for (const rig_t rig_id : filtered_rig_ids) {
+    cache->rigs_.emplace(rig_id, database_cache.Rig(rig_id));
   }
 
-  // Copy pose priors.
-  cache->pose_priors_ = database_cache.PosePriors();
+  // Share the pose priors, which are only copied if they are modified.
+  cache->pose_priors_ = database_cache.pose_priors_;
   if (options.convert_pose_priors_to_enu) {
     cache->ConvertPosePriorsToENU();
   }
 
-  // Build filtered correspondence graph with all images from connected frames.
-  cache->correspondence_graph_ = std::make_shared<class CorrespondenceGraph>();
+  // Extract the correspondences between the filtered images, which only
+  // visits the correspondences of these images.
+  cache->correspondence_graph_ =
+      source_graph->CreateSubgraph(filtered_image_ids);
+
+  return cache;
+}
+
+void DatabaseCache::WriteToDatabase(Database* database) const {
+  THROW_CHECK_NOTNULL(database);
 
-  for (const auto& [image_id, image] : cache->images_) {
-    cache->correspondence_graph_->AddImage(image_id, image.NumPoints2D());
+  DatabaseTransaction database_transaction(database);
+
+  for (const auto& [camera_id, camera] : cameras_) {
+    database->WriteCamera(camera, /*use_camera_id=*/true);
   }
 
-  // Copy correspondences between all image pairs in the cache.
-  for (const image_pair_t pair_id : source_graph->ImagePairs()) {
-    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
-    if (cache->images_.count(image_id1) > 0 &&
-        cache->images_.count(image_id2) > 0) {
-      cache->correspondence_graph_->AddTwoViewGeometry(
-          image_id1,
-          image_id2,
-          source_graph->ExtractTwoViewGeometry(
-              image_id1, image_id2, /*extract_inlier_matches=*/true));
+  for (const auto& [rig_id, rig] : rigs_) {
+    database->WriteRig(rig, /*use_rig_id=*/true);
+  }
+
+  for (const auto& [frame_id, frame] : frames_) {
+    database->WriteFrame(frame, /*use_frame_id=*/true);
+  }
+
+  for (const auto& [image_id, image] : images_) {
+    database->WriteImage(image, /*use_image_id=*/true);
+    const std::vector<Eigen::Vector2d> points2D = LoadPoints2D(image_id);
+    FeatureKeypoints keypoints;
+    keypoints.reserve(points2D.size());
+    for (const Eigen::Vector2d& point2D : points2D) {
+      keypoints.emplace_back(point2D.x(), point2D.y());
     }
+    database->WriteKeypoints(image_id, keypoints);
   }
 
-  cache->correspondence_graph_->Finalize();
+  database->WritePosePriors({pose_priors_->data(), pose_priors_->size()},
+                            /*use_pose_prior_ids=*/true);
 
-  return cache;
+  for (const image_pair_t pair_id : correspondence_graph_->ImagePairs()) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    database->WriteTwoViewGeometry(
+        image_id1,
+        image_id2,
+        correspondence_graph_->ExtractTwoViewGeometry(
+            image_id1, image_id2, /*extract_inlier_matches=*/true));
+  }
 }
 
 void DatabaseCache::AddRig(class Rig rig) {
@@ -443,21 +779,49 @@ void DatabaseCache::AddImage(class Image image) {
   const image_t image_id = image.ImageId();
   THROW_CHECK(!ExistsImage(image_id));
   correspondence_graph_->AddImage(image_id, image.NumPoints2D());
+  image_name_to_id_.emplace(image.Name(), image_id);
   images_.emplace(image_id, std::move(image));
 }
 
 void DatabaseCache::AddPosePrior(struct PosePrior pose_prior) {
-  pose_priors_.push_back(std::move(pose_prior));
+  MutablePosePriors().push_back(std::move(pose_prior));
 }
 
 const class Image* DatabaseCache::FindImageWithName(
     const std::string& name) const {
-  for (const auto& image : images_) {
-    if (image.second.Name() == name) {
-      return &image.second;
+  const auto it = image_name_to_id_.find(name);
+  if (it == image_name_to_id_.end()) {
+    return nullptr;
+  }
+  return &images_.at(it->second);
+}
+
+point2D_t DatabaseCache::NumPoints2D(const image_t image_id) const {
+  if (const auto it = num_lazy_points2D_.find(image_id);
+      it != num_lazy_points2D_.end()) {
+    return it->second;
+  }
+  return images_.at(image_id).NumPoints2D();
+}
+
+std::vector<Eigen::Vector2d> DatabaseCache::LoadPoints2D(
+    const image_t image_id) const {
+  if (num_lazy_points2D_.count(image_id) > 0) {
+    THROW_CHECK_NOTNULL(lazy_database_);
+    FeatureKeypoints keypoints;
+    {
+      std::lock_guard<std::mutex> lock(*lazy_database_mutex_);
+      keypoints = lazy_database_->ReadKeypoints(image_id);
     }
+    return FeatureKeypointsToPointsVector(keypoints);
+  }
+  const class Image& image = images_.at(image_id);
+  std::vector<Eigen::Vector2d> points(image.NumPoints2D());
+  for (point2D_t point2D_idx = 0; point2D_idx < image.NumPoints2D();
+       ++point2D_idx) {
+    points[point2D_idx] = image.Point2D(point2D_idx).xy;
   }
-  return nullptr;
+  return points;
 }
 
 void DatabaseCache::ConvertPosePriorsToENU() {
@@ -465,7 +829,7 @@ void DatabaseCache::ConvertPosePriorsToENU() {
 
   std::vector<Eigen::Vector3d> gps_prior_positions;
   std::set<PosePrior::CoordinateSystem> coordinate_systems;
-  for (const auto& pose_prior : pose_priors_) {
+  for (const auto& pose_prior : *pose_priors_) {
     coordinate_systems.insert(pose_prior.coordinate_system);
     if (pose_prior.coordinate_system != PosePrior::CoordinateSystem::WGS84) {
       prior_is_gps = false;
@@ -490,7 +854,7 @@ void DatabaseCache::ConvertPosePriorsToENU() {
             gps_prior_positions, ref_lat, ref_lon, ref_alt);
 
     auto xyz_prior_it = v_xyz_prior.begin();
-    for (auto& pose_prior : pose_priors_) {
+    for (auto& pose_prior : MutablePosePriors()) {
       pose_prior.position = *xyz_prior_it;
       pose_prior.coordinate_system = PosePrior::CoordinateSystem::CARTESIAN;
       ++xyz_prior_it;
@@ -498,4 +862,20 @@ void DatabaseCache::ConvertPosePriorsToENU() {
   }
 }
 
+void DatabaseCache::IndexImageNames() {
+  image_name_to_id_.clear();
+  image_name_to_id_.reserve(images_.size());
+  for (const auto& [image_id, image] : images_) {
+    image_name_to_id_.emplace(image.Name(), image_id);
+  }
+}
+
+std::vector<struct PosePrior>& DatabaseCache::MutablePosePriors() {
+  if (pose_priors_.use_count() > 1) {
+    pose_priors_ =
+        std::make_shared<std::vector<struct PosePrior>>(*pose_priors_);
+  }
+  return *pose_priors_;
+}
+
 }  // namespace colmap
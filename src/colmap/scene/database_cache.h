@@ -36,7 +36,9 @@
 #include "colmap/util/eigen_alignment.h"
 #include "colmap/util/types.h"
 
+#include <filesystem>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -68,21 +70,55 @@ class DatabaseCache {
 
     // Whether to convert pose priors to ENU coordinate system.
     bool convert_pose_priors_to_enu = false;
+
+    // Whether to stream the two-view geometries from the database in batches
+    // directly into the flattened layout of the correspondence graph instead
+    // of loading all of them at once. This bounds the peak memory usage for
+    // large databases at the cost of reading the matches twice. Image pairs
+    // without inlier matches are not loaded in this mode.
+    bool stream_two_view_geometries = false;
+
+    // Optional path to a snapshot of the finalized correspondence graph. If
+    // the snapshot was built from the same database contents with the same
+    // options, the graph is loaded from it without reading any matches.
+    // Otherwise, the graph is built from the database and written to the
+    // snapshot for subsequent runs. Changes to the matches of an image pair
+    // that preserve the number of inlier matches are not detected.
+    std::filesystem::path correspondence_graph_snapshot_path;
+
+    // Whether to load the points2D of the images on demand instead of copying
+    // all keypoints into the cached images up front. The cached images then
+    // have no points2D and their points2D are read from the database through
+    // `LoadPoints2D`, e.g., when the incremental mapper first needs them. This
+    // reduces the peak memory for large collections, in which most images
+    // are never or only late registered. Requires the cache to share the
+    // ownership of the database.
+    bool lazy_load_points2D = false;
   };
 
   DatabaseCache();
 
-  // Load cameras, images, features, and matches from database.
+  // Load cameras, images, features, and matches from database. Lazy loading
+  // of points2D is only supported when sharing the ownership of the database.
   void Load(const Database& database, const Options& options);
+  void Load(std::shared_ptr<const Database> database, const Options& options);
 
   static std::shared_ptr<DatabaseCache> Create(const Database& database,
                                                const Options& options);
+  static std::shared_ptr<DatabaseCache> Create(
+      std::shared_ptr<const Database> database, const Options& options);
 
   // Create a filtered database cache from an existing cache containing only
   // the specified images and their associated data.
   static std::shared_ptr<DatabaseCache> CreateFromCache(
       const DatabaseCache& database_cache, const Options& options);
 
+  // Write the cached cameras, rigs, frames, images with their points2D as
+  // keypoints, pose priors, and two-view geometries with their inlier matches
+  // into an empty database, such that loading the database reproduces this
+  // cache. The identifiers of all objects are preserved.
+  void WriteToDatabase(Database* database) const;
+
   // Get number of objects.
   inline size_t NumRigs() const;
   inline size_t NumCameras() const;
@@ -125,18 +161,45 @@ class DatabaseCache {
       const;
   inline std::shared_ptr<class CorrespondenceGraph> CorrespondenceGraph();
 
-  // Find specific image by name. Note that this uses linear search.
+  // Find specific image by name or return null if it does not exist.
   const class Image* FindImageWithName(const std::string& name) const;
 
+  // Whether the points2D of the cached images are loaded on demand, see
+  // `Options::lazy_load_points2D`.
+  inline bool HasLazyPoints2D() const;
+
+  // Number of points2D of an image, which is also known if its points2D are
+  // loaded on demand.
+  point2D_t NumPoints2D(image_t image_id) const;
+
+  // Read the points2D of an image from the cached image or, if they are loaded
+  // on demand, from the database. Concurrent calls are serialized.
+  std::vector<Eigen::Vector2d> LoadPoints2D(image_t image_id) const;
+
  private:
+  void LoadImpl(const Database& database, const Options& options);
+
   void ConvertPosePriorsToENU();
 
+  // Rebuild the index of the images by name.
+  void IndexImageNames();
+
+  // The pose priors are shared between a cache and the caches created from it
+  // and only copied before they are modified.
+  std::vector<struct PosePrior>& MutablePosePriors();
+
   std::unordered_map<rig_t, class Rig> rigs_;
   std::unordered_map<camera_t, struct Camera> cameras_;
   std::unordered_map<frame_t, class Frame> frames_;
   std::unordered_map<image_t, class Image> images_;
-  std::vector<struct PosePrior> pose_priors_;
+  std::shared_ptr<std::vector<struct PosePrior>> pose_priors_;
   std::shared_ptr<class CorrespondenceGraph> correspondence_graph_;
+  std::unordered_map<std::string, image_t> image_name_to_id_;
+
+  // Database and number of points2D of the images for lazy loading.
+  std::shared_ptr<const Database> lazy_database_;
+  std::shared_ptr<std::mutex> lazy_database_mutex_;
+  std::unordered_map<image_t, point2D_t> num_lazy_points2D_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -151,7 +214,7 @@ size_t DatabaseCache::NumFrames() const { return frames_.size(); }
 
 size_t DatabaseCache::NumImages() const { return images_.size(); }
 
-size_t DatabaseCache::NumPosePriors() const { return pose_priors_.size(); }
+size_t DatabaseCache::NumPosePriors() const { return pose_priors_->size(); }
 
 class Rig& DatabaseCache::Rig(const rig_t rig_id) { return rigs_.at(rig_id); }
 
@@ -201,7 +264,7 @@ const std::unordered_map<image_t, class Image>& DatabaseCache::Images() const {
 }
 
 const std::vector<struct PosePrior>& DatabaseCache::PosePriors() const {
-  return pose_priors_;
+  return *pose_priors_;
 }
 
 bool DatabaseCache::ExistsRig(const rig_t rig_id) const {
@@ -220,6 +283,10 @@ bool DatabaseCache::ExistsImage(const image_t image_id) const {
   return images_.find(image_id) != images_.end();
 }
 
+bool DatabaseCache::HasLazyPoints2D() const {
+  return lazy_database_ != nullptr;
+}
+
 std::shared_ptr<const class CorrespondenceGraph>
 DatabaseCache::CorrespondenceGraph() const {
   return correspondence_graph_;
@@ -31,6 +31,9 @@
 
 #include "colmap/geometry/rigid3_matchers.h"
 #include "colmap/scene/database_sqlite.h"
+#include "colmap/scene/reconstruction.h"
+#include "colmap/util/file.h"
+#include "colmap/util/testing.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -209,6 +212,185 @@ TEST(DatabaseCache, ConstructFromDatabaseWithCustomImages) {
             1);
 }
 
+TEST(DatabaseCache, CreateFromCacheWithCustomImages) {
+  auto database = CreateTestDatabase();
+  auto cache = DatabaseCache::Create(*database, {});
+
+  // Note that the first two images are part of the same frame.
+  const std::vector<Image> images = database->ReadAllImages();
+  DatabaseCache::Options options;
+  options.image_names = {images[0].Name(), images[1].Name(), "missing"};
+  auto filtered_cache = DatabaseCache::CreateFromCache(*cache, options);
+
+  EXPECT_EQ(filtered_cache->NumRigs(), 1);
+  EXPECT_EQ(filtered_cache->NumCameras(), 2);
+  EXPECT_EQ(filtered_cache->NumFrames(), 1);
+  EXPECT_EQ(filtered_cache->NumImages(), 2);
+  EXPECT_EQ(filtered_cache->NumPosePriors(), 2);
+  EXPECT_EQ(&filtered_cache->PosePriors(), &cache->PosePriors());
+  EXPECT_EQ(filtered_cache->FindImageWithName(images[1].Name())->ImageId(),
+            images[1].ImageId());
+  EXPECT_EQ(filtered_cache->FindImageWithName(images[2].Name()), nullptr);
+
+  const auto correspondence_graph = filtered_cache->CorrespondenceGraph();
+  EXPECT_EQ(correspondence_graph->NumImages(), 2);
+  EXPECT_EQ(correspondence_graph->NumImagePairs(), 1);
+  EXPECT_EQ(
+      correspondence_graph->NumCorrespondencesForImage(images[0].ImageId()), 1);
+  EXPECT_EQ(
+      correspondence_graph->NumCorrespondencesForImage(images[1].ImageId()), 1);
+
+  // Modifying the pose priors of the filtered cache does not affect the
+  // cache it was created from.
+  filtered_cache->AddPosePrior(PosePrior());
+  EXPECT_EQ(filtered_cache->NumPosePriors(), 3);
+  EXPECT_EQ(cache->NumPosePriors(), 2);
+
+  // The images of the other frame are only connected to the first frame
+  // through the second image.
+  options.image_names = {images[2].Name(), images[3].Name()};
+  filtered_cache = DatabaseCache::CreateFromCache(*cache, options);
+  EXPECT_EQ(filtered_cache->NumFrames(), 1);
+  EXPECT_EQ(filtered_cache->NumImages(), 2);
+  EXPECT_EQ(filtered_cache->CorrespondenceGraph()->NumImagePairs(), 1);
+}
+
+TEST(DatabaseCache, ConstructFromDatabaseWithStreaming) {
+  auto database = CreateTestDatabase();
+  const std::vector<Image> images = database->ReadAllImages();
+
+  // Add a duplicate and an out-of-bounds match that are ignored.
+  TwoViewGeometry two_view_geometry;
+  two_view_geometry.inlier_matches = {{2, 2}, {2, 2}, {3, 3}, {4, 7}};
+  database->WriteTwoViewGeometry(
+      images[0].ImageId(), images[2].ImageId(), two_view_geometry);
+  // Add a watermark pair that is filtered.
+  two_view_geometry.inlier_matches = {{5, 0}};
+  two_view_geometry.config = TwoViewGeometry::ConfigurationType::WATERMARK;
+  database->WriteTwoViewGeometry(
+      images[0].ImageId(), images[3].ImageId(), two_view_geometry);
+
+  DatabaseCache::Options options;
+  options.ignore_watermarks = true;
+  auto expected_cache = DatabaseCache::Create(*database, options);
+  options.stream_two_view_geometries = true;
+  auto cache = DatabaseCache::Create(*database, options);
+
+  EXPECT_EQ(cache->NumRigs(), expected_cache->NumRigs());
+  EXPECT_EQ(cache->NumCameras(), expected_cache->NumCameras());
+  EXPECT_EQ(cache->NumFrames(), expected_cache->NumFrames());
+  EXPECT_EQ(cache->NumImages(), expected_cache->NumImages());
+  EXPECT_EQ(cache->NumPosePriors(), expected_cache->NumPosePriors());
+
+  const auto correspondence_graph = cache->CorrespondenceGraph();
+  const auto expected_correspondence_graph =
+      expected_cache->CorrespondenceGraph();
+  EXPECT_EQ(correspondence_graph->NumImagePairs(), 4);
+  EXPECT_EQ(correspondence_graph->NumMatchesBetweenAllImages(),
+            expected_correspondence_graph->NumMatchesBetweenAllImages());
+  for (const auto& [image_id, image] : cache->Images()) {
+    EXPECT_EQ(correspondence_graph->NumCorrespondencesForImage(image_id),
+              expected_correspondence_graph->NumCorrespondencesForImage(
+                  image_id));
+    EXPECT_EQ(
+        correspondence_graph->NumObservationsForImage(image_id),
+        expected_correspondence_graph->NumObservationsForImage(image_id));
+    std::vector<CorrespondenceGraph::Correspondence> corrs;
+    std::vector<CorrespondenceGraph::Correspondence> expected_corrs;
+    for (point2D_t point2D_idx = 0; point2D_idx < image.NumPoints2D();
+         ++point2D_idx) {
+      correspondence_graph->ExtractCorrespondences(
+          image_id, point2D_idx, &corrs);
+      expected_correspondence_graph->ExtractCorrespondences(
+          image_id, point2D_idx, &expected_corrs);
+      ASSERT_EQ(corrs.size(), expected_corrs.size());
+      for (size_t i = 0; i < corrs.size(); ++i) {
+        EXPECT_EQ(corrs[i].image_id, expected_corrs[i].image_id);
+        EXPECT_EQ(corrs[i].point2D_idx, expected_corrs[i].point2D_idx);
+      }
+    }
+  }
+}
+
+TEST(DatabaseCache, ConstructFromDatabaseWithLazyPoints2D) {
+  std::shared_ptr<Database> database = CreateTestDatabase();
+  auto expected_cache = DatabaseCache::Create(*database, {});
+  EXPECT_FALSE(expected_cache->HasLazyPoints2D());
+
+  DatabaseCache::Options options;
+  options.lazy_load_points2D = true;
+  EXPECT_ANY_THROW(DatabaseCache::Create(*database, options));
+  auto cache = DatabaseCache::Create(database, options);
+  EXPECT_TRUE(cache->HasLazyPoints2D());
+  ASSERT_EQ(cache->NumImages(), expected_cache->NumImages());
+  for (const auto& [image_id, image] : cache->Images()) {
+    EXPECT_EQ(image.NumPoints2D(), 0);
+    const Image& expected_image = expected_cache->Image(image_id);
+    EXPECT_EQ(cache->NumPoints2D(image_id), expected_image.NumPoints2D());
+    EXPECT_EQ(cache->LoadPoints2D(image_id),
+              expected_cache->LoadPoints2D(image_id));
+    EXPECT_EQ(cache->CorrespondenceGraph()->NumPoints2DForImage(image_id),
+              expected_image.NumPoints2D());
+  }
+  EXPECT_EQ(
+      cache->CorrespondenceGraph()->NumMatchesBetweenAllImages(),
+      expected_cache->CorrespondenceGraph()->NumMatchesBetweenAllImages());
+
+  auto filtered_cache = DatabaseCache::CreateFromCache(*cache, {});
+  EXPECT_TRUE(filtered_cache->HasLazyPoints2D());
+  for (const auto& [image_id, _] : filtered_cache->Images()) {
+    EXPECT_EQ(filtered_cache->NumPoints2D(image_id),
+              cache->NumPoints2D(image_id));
+  }
+
+  Reconstruction reconstruction;
+  reconstruction.Load(*cache);
+  EXPECT_EQ(reconstruction.NumImages(), cache->NumImages());
+  for (const auto& [image_id, image] : reconstruction.Images()) {
+    EXPECT_EQ(image.NumPoints2D(), 0);
+  }
+}
+
+TEST(DatabaseCache, ConstructFromDatabaseWithSnapshot) {
+  auto database = CreateTestDatabase();
+  const std::vector<Image> images = database->ReadAllImages();
+
+  DatabaseCache::Options options;
+  options.correspondence_graph_snapshot_path =
+      CreateTestDir() / "correspondence_graph.snapshot";
+  auto cache = DatabaseCache::Create(*database, options);
+  EXPECT_TRUE(ExistsFile(options.correspondence_graph_snapshot_path));
+  EXPECT_EQ(cache->CorrespondenceGraph()->NumImagePairs(), 3);
+
+  auto snapshot_cache = DatabaseCache::Create(*database, options);
+  EXPECT_EQ(snapshot_cache->NumFrames(), cache->NumFrames());
+  EXPECT_EQ(snapshot_cache->NumImages(), cache->NumImages());
+  EXPECT_EQ(snapshot_cache->CorrespondenceGraph()->NumMatchesBetweenAllImages(),
+            cache->CorrespondenceGraph()->NumMatchesBetweenAllImages());
+  for (const auto& [image_id, image] : cache->Images()) {
+    EXPECT_EQ(
+        snapshot_cache->CorrespondenceGraph()->NumObservationsForImage(
+            image_id),
+        cache->CorrespondenceGraph()->NumObservationsForImage(image_id));
+  }
+
+  // Changing the options or the matches invalidates the snapshot.
+  options.image_names = {images[0].Name(), images[1].Name()};
+  EXPECT_EQ(DatabaseCache::Create(*database, options)
+                ->CorrespondenceGraph()
+                ->NumImagePairs(),
+            1);
+  options.image_names.clear();
+  TwoViewGeometry two_view_geometry;
+  two_view_geometry.inlier_matches = {{2, 2}};
+  database->WriteTwoViewGeometry(
+      images[0].ImageId(), images[2].ImageId(), two_view_geometry);
+  EXPECT_EQ(DatabaseCache::Create(*database, options)
+                ->CorrespondenceGraph()
+                ->NumImagePairs(),
+            4);
+}
+
 std::shared_ptr<Database> CreateLegacyTestDatabase() {
   auto database = Database::Open(kInMemorySqliteDatabasePath);
 
@@ -340,6 +522,51 @@ TEST(DatabaseCache, ConstructFromCustom) {
   EXPECT_THAT(cache.PosePriors(), testing::ElementsAre(pose_prior));
 }
 
+TEST(DatabaseCache, WriteToDatabase) {
+  auto database = CreateTestDatabase();
+  auto cache = DatabaseCache::Create(*database, {});
+
+  auto written_database = Database::Open(kInMemorySqliteDatabasePath);
+  cache->WriteToDatabase(written_database.get());
+
+  EXPECT_THAT(written_database->ReadAllRigs(),
+              testing::UnorderedElementsAreArray(database->ReadAllRigs()));
+  EXPECT_THAT(written_database->ReadAllCameras(),
+              testing::UnorderedElementsAreArray(database->ReadAllCameras()));
+  EXPECT_THAT(written_database->ReadAllFrames(),
+              testing::UnorderedElementsAreArray(database->ReadAllFrames()));
+  EXPECT_EQ(written_database->NumImages(), database->NumImages());
+  for (const Image& image : database->ReadAllImages()) {
+    const Image written_image = written_database->ReadImage(image.ImageId());
+    EXPECT_EQ(written_image.Name(), image.Name());
+    EXPECT_EQ(written_image.CameraId(), image.CameraId());
+    EXPECT_EQ(written_database->NumKeypointsForImage(image.ImageId()),
+              database->NumKeypointsForImage(image.ImageId()));
+  }
+  EXPECT_THAT(
+      written_database->ReadAllPosePriors(),
+      testing::UnorderedElementsAreArray(database->ReadAllPosePriors()));
+  EXPECT_EQ(written_database->NumVerifiedImagePairs(),
+            database->NumVerifiedImagePairs());
+  EXPECT_EQ(written_database->NumInlierMatches(),
+            database->NumInlierMatches());
+
+  auto written_cache = DatabaseCache::Create(*written_database, {});
+  EXPECT_EQ(written_cache->NumRigs(), cache->NumRigs());
+  EXPECT_EQ(written_cache->NumCameras(), cache->NumCameras());
+  EXPECT_EQ(written_cache->NumFrames(), cache->NumFrames());
+  EXPECT_EQ(written_cache->NumImages(), cache->NumImages());
+  EXPECT_EQ(written_cache->NumPosePriors(), cache->NumPosePriors());
+  for (const auto& [image_id, image] : cache->Images()) {
+    EXPECT_EQ(written_cache->Image(image_id).NumPoints2D(),
+              image.NumPoints2D());
+    EXPECT_EQ(written_cache->CorrespondenceGraph()->NumCorrespondencesForImage(
+                  image_id),
+              cache->CorrespondenceGraph()->NumCorrespondencesForImage(
+                  image_id));
+  }
+}
+
 TEST(DatabaseCache, NonConstCorrespondenceGraph) {
   auto database = CreateTestDatabase();
   auto cache = DatabaseCache::Create(*database, {});
@@ -0,0 +1,1013 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/scene/database_mmap.h"
+
+#include "colmap/scene/database_sqlite.h"
+#include "colmap/util/endian.h"
+#include "colmap/util/file.h"
+#include "colmap/util/logging.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+
+namespace colmap {
+namespace {
+
+static_assert(sizeof(FeatureKeypoint) == 6 * sizeof(float),
+              "FeatureKeypoint must be layout compatible with 6-column blobs");
+static_assert(sizeof(FeatureMatch) == 2 * sizeof(point2D_t),
+              "FeatureMatch must be layout compatible with matches blobs");
+
+constexpr char kKeypointsFileName[] = "keypoints.bin";
+constexpr char kDescriptorsFileName[] = "descriptors.bin";
+constexpr char kMatchesFileName[] = "matches.bin";
+
+constexpr char kColumnFileMagic[8] = {'C', 'O', 'L', 'M', 'A', 'P', 'C', 'F'};
+constexpr uint32_t kColumnFileVersion = 1;
+constexpr uint32_t kColumnRecordMagic = 0x44524352;  // "RCRD"
+
+struct ColumnFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+};
+
+// Every record is followed by its payload, which is zero-padded to a multiple
+// of 8 bytes. Records with negative rows mark the deletion of the key.
+struct ColumnRecordHeader {
+  uint32_t magic;
+  int32_t type;
+  uint64_t key;
+  int64_t rows;
+  int64_t cols;
+  uint64_t num_bytes;
+};
+
+static_assert(sizeof(ColumnFileHeader) == 16);
+static_assert(sizeof(ColumnRecordHeader) == 40);
+
+size_t PaddedNumBytes(const size_t num_bytes) {
+  return (num_bytes + 7) & ~static_cast<size_t>(7);
+}
+
+ColumnFileHeader MakeColumnFileHeader() {
+  ColumnFileHeader header;
+  std::memcpy(header.magic, kColumnFileMagic, sizeof(kColumnFileMagic));
+  header.version = kColumnFileVersion;
+  header.reserved = 0;
+  return header;
+}
+
+void WriteColumnRecord(std::ostream& stream,
+                       const ColumnRecordHeader& record,
+                       const char* data) {
+  static const char kZeros[8] = {0};
+  stream.write(reinterpret_cast<const char*>(&record), sizeof(record));
+  if (record.num_bytes > 0) {
+    stream.write(data, record.num_bytes);
+  }
+  stream.write(kZeros, PaddedNumBytes(record.num_bytes) - record.num_bytes);
+}
+
+// Append-only store of dense row-major matrices indexed by a unique key. Every
+// write appends a new record and deletions append a tombstone record, such that
+// the latest state is recovered by scanning the records on open. The file is
+// memory-mapped for reading and compacted on close, if the majority of the file
+// is occupied by stale records. Close() throws if the compaction fails. An
+// empty path creates an in-memory store.
+class ColumnStore {
+ public:
+  struct Entry {
+    int32_t type = 0;
+    int64_t rows = 0;
+    int64_t cols = 0;
+    size_t offset = 0;
+    size_t num_bytes = 0;
+  };
+
+  ColumnStore() = default;
+  // Compaction on close may fail, which is only logged when destructing. Call
+  // Close() explicitly to handle the error.
+  ~ColumnStore() {
+    try {
+      Close();
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Failed to close column store " << path_ << ": "
+                 << e.what();
+    }
+  }
+
+  NON_COPYABLE(ColumnStore)
+  NON_MOVABLE(ColumnStore)
+
+  void Open(const std::filesystem::path& path) {
+    Close();
+
+    path_ = path;
+    is_open_ = true;
+
+    if (path_.empty()) {
+      const ColumnFileHeader header = MakeColumnFileHeader();
+      memory_.resize(sizeof(header));
+      std::memcpy(memory_.data(), &header, sizeof(header));
+      size_ = memory_.size();
+      return;
+    }
+
+    if (!ExistsFile(path_)) {
+      CreateEmptyFile();
+    }
+
+    Scan();
+
+    file_.open(path_, std::ios::binary | std::ios::app);
+    THROW_CHECK_FILE_OPEN(file_, path_);
+  }
+
+  void Close() {
+    if (!is_open_) {
+      return;
+    }
+    if (!path_.empty()) {
+      if (size_ - sizeof(ColumnFileHeader) > 2 * num_live_bytes_) {
+        Compact();
+      }
+      file_.close();
+      mapped_file_.Unmap();
+    }
+    memory_.clear();
+    memory_.shrink_to_fit();
+    entries_.clear();
+    size_ = 0;
+    num_live_bytes_ = 0;
+    is_open_ = false;
+  }
+
+  const Entry* Find(const uint64_t key) const {
+    THROW_CHECK(is_open_);
+    const auto it = entries_.find(key);
+    if (it == entries_.end()) {
+      return nullptr;
+    }
+    return &it->second;
+  }
+
+  const std::map<uint64_t, Entry>& Entries() const {
+    THROW_CHECK(is_open_);
+    return entries_;
+  }
+
+  // Copy the payload of the entry into the given buffer, which must be at
+  // least of size `entry.num_bytes`.
+  void Read(const Entry& entry, void* data) const {
+    if (entry.num_bytes == 0) {
+      return;
+    }
+    if (path_.empty()) {
+      std::memcpy(data, memory_.data() + entry.offset, entry.num_bytes);
+      return;
+    }
+    // Records appended after the last mapping require a re-mapping.
+    if (entry.offset + entry.num_bytes > mapped_file_.Size()) {
+      Flush();
+      mapped_file_.Map(path_);
+    }
+    std::memcpy(data, mapped_file_.Data() + entry.offset, entry.num_bytes);
+  }
+
+  void Write(const uint64_t key,
+             const int32_t type,
+             const int64_t rows,
+             const int64_t cols,
+             const void* data,
+             const size_t num_bytes) {
+    THROW_CHECK(is_open_);
+    THROW_CHECK_GE(rows, 0);
+    THROW_CHECK_GE(cols, 0);
+    const ColumnRecordHeader record{kColumnRecordMagic,
+                                    type,
+                                    key,
+                                    rows,
+                                    cols,
+                                    static_cast<uint64_t>(num_bytes)};
+    const size_t offset = size_ + sizeof(record);
+    Append(record, static_cast<const char*>(data));
+    InsertEntry(key, Entry{type, rows, cols, offset, num_bytes});
+  }
+
+  void Delete(const uint64_t key) {
+    THROW_CHECK(is_open_);
+    if (entries_.count(key) == 0) {
+      return;
+    }
+    const ColumnRecordHeader record{kColumnRecordMagic, 0, key, -1, 0, 0};
+    Append(record, nullptr);
+    EraseEntry(key);
+  }
+
+  void Clear() {
+    THROW_CHECK(is_open_);
+    entries_.clear();
+    num_live_bytes_ = 0;
+    if (path_.empty()) {
+      memory_.resize(sizeof(ColumnFileHeader));
+      size_ = memory_.size();
+    } else {
+      file_.close();
+      mapped_file_.Unmap();
+      CreateEmptyFile();
+      file_.open(path_, std::ios::binary | std::ios::app);
+      THROW_CHECK_FILE_OPEN(file_, path_);
+    }
+  }
+
+  void Flush() const {
+    if (file_.is_open()) {
+      file_.flush();
+    }
+  }
+
+ private:
+  void CreateEmptyFile() {
+    std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+    THROW_CHECK_FILE_OPEN(file, path_);
+    const ColumnFileHeader header = MakeColumnFileHeader();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    size_ = sizeof(header);
+  }
+
+  void Scan() {
+    mapped_file_.Map(path_);
+    const char* data = mapped_file_.Data();
+    const size_t size = mapped_file_.Size();
+
+    ColumnFileHeader header;
+    THROW_CHECK_GE(size, sizeof(header)) << "Invalid column file " << path_;
+    std::memcpy(&header, data, sizeof(header));
+    THROW_CHECK_EQ(
+        std::memcmp(header.magic, kColumnFileMagic, sizeof(kColumnFileMagic)),
+        0)
+        << "Invalid column file " << path_;
+    THROW_CHECK_EQ(header.version, kColumnFileVersion)
+        << "Unsupported column file version in " << path_;
+
+    size_t offset = sizeof(header);
+    while (offset + sizeof(ColumnRecordHeader) <= size) {
+      ColumnRecordHeader record;
+      std::memcpy(&record, data + offset, sizeof(record));
+      const size_t payload_offset = offset + sizeof(record);
+      if (record.magic != kColumnRecordMagic ||
+          record.num_bytes > size - payload_offset ||
+          PaddedNumBytes(record.num_bytes) > size - payload_offset) {
+        break;
+      }
+      offset = payload_offset + PaddedNumBytes(record.num_bytes);
+      if (record.rows < 0) {
+        EraseEntry(record.key);
+      } else {
+        InsertEntry(record.key,
+                    Entry{record.type,
+                          record.rows,
+                          record.cols,
+                          payload_offset,
+                          static_cast<size_t>(record.num_bytes)});
+      }
+    }
+
+    // Drop partially written records, e.g., after the process was killed.
+    if (offset < size) {
+      LOG(WARNING) << "Discarding " << size - offset
+                   << " bytes of incomplete records at the end of " << path_;
+      mapped_file_.Unmap();
+      std::filesystem::resize_file(path_, offset);
+    }
+
+    size_ = offset;
+  }
+
+  void Compact() {
+    Flush();
+    mapped_file_.Map(path_);
+
+    std::filesystem::path compacted_path = path_;
+    compacted_path += ".tmp";
+    {
+      std::ofstream file(compacted_path, std::ios::binary | std::ios::trunc);
+      THROW_CHECK_FILE_OPEN(file, compacted_path);
+      const ColumnFileHeader header = MakeColumnFileHeader();
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      for (const auto& [key, entry] : entries_) {
+        const ColumnRecordHeader record{kColumnRecordMagic,
+                                        entry.type,
+                                        key,
+                                        entry.rows,
+                                        entry.cols,
+                                        entry.num_bytes};
+        WriteColumnRecord(file, record, mapped_file_.Data() + entry.offset);
+      }
+    }
+
+    file_.close();
+    mapped_file_.Unmap();
+    std::filesystem::rename(compacted_path, path_);
+  }
+
+  void Append(const ColumnRecordHeader& record, const char* data) {
+    const size_t num_record_bytes =
+        sizeof(record) + PaddedNumBytes(record.num_bytes);
+    if (path_.empty()) {
+      memory_.resize(size_ + num_record_bytes, 0);
+      std::memcpy(memory_.data() + size_, &record, sizeof(record));
+      if (record.num_bytes > 0) {
+        std::memcpy(
+            memory_.data() + size_ + sizeof(record), data, record.num_bytes);
+      }
+    } else {
+      WriteColumnRecord(file_, record, data);
+      THROW_CHECK(file_.good()) << "Failed to write to " << path_;
+    }
+    size_ += num_record_bytes;
+  }
+
+  void InsertEntry(const uint64_t key, const Entry& entry) {
+    EraseEntry(key);
+    entries_.emplace(key, entry);
+    num_live_bytes_ +=
+        sizeof(ColumnRecordHeader) + PaddedNumBytes(entry.num_bytes);
+  }
+
+  void EraseEntry(const uint64_t key) {
+    const auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      num_live_bytes_ -=
+          sizeof(ColumnRecordHeader) + PaddedNumBytes(it->second.num_bytes);
+      entries_.erase(it);
+    }
+  }
+
+  bool is_open_ = false;
+  std::filesystem::path path_;
+  mutable std::ofstream file_;
+  mutable MemoryMappedFile mapped_file_;
+  std::vector<char> memory_;
+  size_t size_ = 0;
+  size_t num_live_bytes_ = 0;
+  std::map<uint64_t, Entry> entries_;
+};
+
+size_t SumRows(const ColumnStore& store) {
+  size_t num_rows = 0;
+  for (const auto& [_, entry] : store.Entries()) {
+    num_rows += entry.rows;
+  }
+  return num_rows;
+}
+
+size_t MaxRows(const ColumnStore& store) {
+  size_t max_num_rows = 0;
+  for (const auto& [_, entry] : store.Entries()) {
+    max_num_rows = std::max(max_num_rows, static_cast<size_t>(entry.rows));
+  }
+  return max_num_rows;
+}
+
+size_t NumRows(const ColumnStore& store, const uint64_t key) {
+  const ColumnStore::Entry* entry = store.Find(key);
+  return entry == nullptr ? 0 : entry->rows;
+}
+
+template <typename MatrixType>
+MatrixType ReadMatrix(const ColumnStore& store,
+                      const ColumnStore::Entry& entry) {
+  MatrixType matrix(entry.rows, entry.cols);
+  THROW_CHECK_EQ(matrix.size() * sizeof(typename MatrixType::Scalar),
+                 entry.num_bytes);
+  store.Read(entry, matrix.data());
+  return matrix;
+}
+
+FeatureMatches ReadFeatureMatches(const ColumnStore& store,
+                                  const ColumnStore::Entry& entry) {
+  THROW_CHECK_EQ(entry.cols, 2);
+  FeatureMatches matches(entry.rows);
+  THROW_CHECK_EQ(matches.size() * sizeof(FeatureMatch), entry.num_bytes);
+  store.Read(entry, matches.data());
+  return matches;
+}
+
+class MmapDatabase : public Database {
+ public:
+  static std::shared_ptr<Database> Open(const std::filesystem::path& path) {
+    THROW_CHECK(IsLittleEndian())
+        << "Memory-mapped databases are only supported on little-endian "
+           "systems";
+
+    auto database = std::make_shared<MmapDatabase>();
+    if (path == kInMemorySqliteDatabasePath) {
+      database->metadata_ = OpenSqliteDatabase(kInMemorySqliteDatabasePath);
+      database->keypoints_.Open("");
+      database->descriptors_.Open("");
+      database->matches_.Open("");
+    } else {
+      CreateDirIfNotExists(path);
+      database->metadata_ =
+          OpenSqliteDatabase(path / kMmapDatabaseMetadataFileName);
+      database->keypoints_.Open(path / kKeypointsFileName);
+      database->descriptors_.Open(path / kDescriptorsFileName);
+      database->matches_.Open(path / kMatchesFileName);
+    }
+    return database;
+  }
+
+  ~MmapDatabase() override {
+    try {
+      CloseImpl();
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Failed to close memory-mapped database: " << e.what();
+    }
+  }
+
+  // Reading the features one by one is cheap, since there is no query
+  // overhead as in SQLite.
+  using Database::ReadDescriptors;
+  using Database::ReadKeypoints;
+
+  void Close() override { CloseImpl(); }
+
+  bool ExistsRig(const rig_t rig_id) const override {
+    return metadata_->ExistsRig(rig_id);
+  }
+
+  bool ExistsCamera(const camera_t camera_id) const override {
+    return metadata_->ExistsCamera(camera_id);
+  }
+
+  bool ExistsFrame(const frame_t frame_id) const override {
+    return metadata_->ExistsFrame(frame_id);
+  }
+
+  bool ExistsImage(const image_t image_id) const override {
+    return metadata_->ExistsImage(image_id);
+  }
+
+  bool ExistsImageWithName(const std::string& name) const override {
+    return metadata_->ExistsImageWithName(name);
+  }
+
+  bool ExistsPosePrior(const pose_prior_t pose_prior_id,
+                       bool is_deprecated_image_prior) const override {
+    return metadata_->ExistsPosePrior(pose_prior_id, is_deprecated_image_prior);
+  }
+
+  bool ExistsKeypoints(const image_t image_id) const override {
+    return keypoints_.Find(image_id) != nullptr;
+  }
+
+  bool ExistsDescriptors(const image_t image_id) const override {
+    return descriptors_.Find(image_id) != nullptr;
+  }
+
+  bool ExistsMatches(const image_t image_id1,
+                     const image_t image_id2) const override {
+    return matches_.Find(ImagePairToPairId(image_id1, image_id2)) != nullptr;
+  }
+
+  bool ExistsTwoViewGeometry(const image_t image_id1,
+                             const image_t image_id2) const override {
+    return metadata_->ExistsTwoViewGeometry(image_id1, image_id2);
+  }
+
+  size_t NumRigs() const override { return metadata_->NumRigs(); }
+
+  size_t NumCameras() const override { return metadata_->NumCameras(); }
+
+  size_t NumFrames() const override { return metadata_->NumFrames(); }
+
+  size_t NumImages() const override { return metadata_->NumImages(); }
+
+  size_t NumPosePriors() const override { return metadata_->NumPosePriors(); }
+
+  size_t NumKeypoints() const override { return SumRows(keypoints_); }
+
+  size_t MaxNumKeypoints() const override { return MaxRows(keypoints_); }
+
+  size_t NumKeypointsForImage(const image_t image_id) const override {
+    return NumRows(keypoints_, image_id);
+  }
+
+  size_t NumDescriptors() const override { return SumRows(descriptors_); }
+
+  size_t MaxNumDescriptors() const override { return MaxRows(descriptors_); }
+
+  size_t NumDescriptorsForImage(const image_t image_id) const override {
+    return NumRows(descriptors_, image_id);
+  }
+
+  size_t NumMatches() const override { return SumRows(matches_); }
+
+  size_t NumInlierMatches() const override {
+    return metadata_->NumInlierMatches();
+  }
+
+  size_t NumMatchedImagePairs() const override {
+    return matches_.Entries().size();
+  }
+
+  size_t NumVerifiedImagePairs() const override {
+    return metadata_->NumVerifiedImagePairs();
+  }
+
+  Rig ReadRig(const rig_t rig_id) const override {
+    return metadata_->ReadRig(rig_id);
+  }
+
+  std::optional<Rig> ReadRigWithSensor(sensor_t sensor_id) const override {
+    return metadata_->ReadRigWithSensor(sensor_id);
+  }
+
+  std::vector<Rig> ReadAllRigs() const override {
+    return metadata_->ReadAllRigs();
+  }
+
+  Camera ReadCamera(const camera_t camera_id) const override {
+    return metadata_->ReadCamera(camera_id);
+  }
+
+  std::vector<Camera> ReadAllCameras() const override {
+    return metadata_->ReadAllCameras();
+  }
+
+  Frame ReadFrame(const frame_t frame_id) const override {
+    return metadata_->ReadFrame(frame_id);
+  }
+
+  std::vector<Frame> ReadAllFrames() const override {
+    return metadata_->ReadAllFrames();
+  }
+
+  Image ReadImage(const image_t image_id) const override {
+    return metadata_->ReadImage(image_id);
+  }
+
+  std::optional<Image> ReadImageWithName(
+      const std::string& name) const override {
+    return metadata_->ReadImageWithName(name);
+  }
+
+  std::vector<Image> ReadAllImages() const override {
+    return metadata_->ReadAllImages();
+  }
+
+  PosePrior ReadPosePrior(const pose_prior_t pose_prior_id,
+                          bool is_deprecated_image_prior) const override {
+    return metadata_->ReadPosePrior(pose_prior_id, is_deprecated_image_prior);
+  }
+
+  std::vector<PosePrior> ReadAllPosePriors() const override {
+    return metadata_->ReadAllPosePriors();
+  }
+
+  FeatureKeypointsBlob ReadKeypointsBlob(
+      const image_t image_id) const override {
+    const ColumnStore::Entry* entry = keypoints_.Find(image_id);
+    if (entry == nullptr) {
+      return FeatureKeypointsBlob();
+    }
+    return ReadMatrix<FeatureKeypointsBlob>(keypoints_, *entry);
+  }
+
+  FeatureKeypoints ReadKeypoints(const image_t image_id) const override {
+    const ColumnStore::Entry* entry = keypoints_.Find(image_id);
+    if (entry == nullptr) {
+      return FeatureKeypoints();
+    }
+    // Full affine keypoints share the memory layout of the stored data.
+    if (entry->cols == 6) {
+      FeatureKeypoints keypoints(entry->rows);
+      THROW_CHECK_EQ(keypoints.size() * sizeof(FeatureKeypoint),
+                     entry->num_bytes);
+      keypoints_.Read(*entry, keypoints.data());
+      return keypoints;
+    }
+    return FeatureKeypointsFromBlob(
+        ReadMatrix<FeatureKeypointsBlob>(keypoints_, *entry));
+  }
+
+  FeatureDescriptors ReadDescriptors(const image_t image_id) const override {
+    FeatureDescriptors descriptors;
+    const ColumnStore::Entry* entry = descriptors_.Find(image_id);
+    if (entry != nullptr) {
+      FeatureDescriptorsTypeFromInt(
+          entry->type, &descriptors.type, &descriptors.precision);
+      descriptors.data =
+          ReadMatrix<FeatureDescriptorsData>(descriptors_, *entry);
+    }
+    return descriptors;
+  }
+
+  std::optional<FeatureExtractionFingerprint> ReadFeatureExtractionFingerprint(
+      const image_t image_id) const override {
+    return metadata_->ReadFeatureExtractionFingerprint(image_id);
+  }
+
+  std::optional<GlobalImageDescriptor> ReadGlobalImageDescriptor(
+      const image_t image_id) const override {
+    return metadata_->ReadGlobalImageDescriptor(image_id);
+  }
+
+  FeatureMatchesBlob ReadMatchesBlob(image_t image_id1,
+                                     image_t image_id2) const override {
+    const ColumnStore::Entry* entry =
+        matches_.Find(ImagePairToPairId(image_id1, image_id2));
+    if (entry == nullptr) {
+      return FeatureMatchesBlob();
+    }
+    FeatureMatchesBlob blob = ReadMatrix<FeatureMatchesBlob>(matches_, *entry);
+    if (ShouldSwapImagePair(image_id1, image_id2)) {
+      SwapFeatureMatchesBlob(&blob);
+    }
+    return blob;
+  }
+
+  FeatureMatches ReadMatches(image_t image_id1,
+                             image_t image_id2) const override {
+    const ColumnStore::Entry* entry =
+        matches_.Find(ImagePairToPairId(image_id1, image_id2));
+    if (entry == nullptr) {
+      return FeatureMatches();
+    }
+    FeatureMatches matches = ReadFeatureMatches(matches_, *entry);
+    if (ShouldSwapImagePair(image_id1, image_id2)) {
+      for (auto& match : matches) {
+        std::swap(match.point2D_idx1, match.point2D_idx2);
+      }
+    }
+    return matches;
+  }
+
+  std::vector<std::pair<image_pair_t, FeatureMatchesBlob>> ReadAllMatchesBlob()
+      const override {
+    std::vector<std::pair<image_pair_t, FeatureMatchesBlob>> all_matches;
+    for (const auto& [pair_id, entry] : matches_.Entries()) {
+      if (entry.rows > 0) {
+        all_matches.emplace_back(
+            pair_id, ReadMatrix<FeatureMatchesBlob>(matches_, entry));
+      }
+    }
+    return all_matches;
+  }
+
+  std::vector<std::pair<image_pair_t, FeatureMatches>> ReadAllMatches()
+      const override {
+    std::vector<std::pair<image_pair_t, FeatureMatches>> all_matches;
+    for (const auto& [pair_id, entry] : matches_.Entries()) {
+      if (entry.rows > 0) {
+        all_matches.emplace_back(pair_id, ReadFeatureMatches(matches_, entry));
+      }
+    }
+    return all_matches;
+  }
+
+  std::vector<std::pair<image_pair_t, int>> ReadNumMatches() const override {
+    std::vector<std::pair<image_pair_t, int>> num_matches;
+    for (const auto& [pair_id, entry] : matches_.Entries()) {
+      if (entry.rows > 0) {
+        num_matches.emplace_back(pair_id, static_cast<int>(entry.rows));
+      }
+    }
+    return num_matches;
+  }
+
+  TwoViewGeometry ReadTwoViewGeometry(const image_t image_id1,
+                                      const image_t image_id2) const override {
+    return metadata_->ReadTwoViewGeometry(image_id1, image_id2);
+  }
+
+  std::vector<std::pair<image_pair_t, TwoViewGeometry>> ReadTwoViewGeometries()
+      const override {
+    return metadata_->ReadTwoViewGeometries();
+  }
+
+  std::vector<TwoViewGeometry> ReadTwoViewGeometries(
+      span<const image_pair_t> pair_ids) const override {
+    return metadata_->ReadTwoViewGeometries(pair_ids);
+  }
+
+  std::vector<std::pair<image_pair_t, int>> ReadTwoViewGeometryNumInliers()
+      const override {
+    return metadata_->ReadTwoViewGeometryNumInliers();
+  }
+
+  rig_t WriteRig(const Rig& rig, const bool use_rig_id) override {
+    return metadata_->WriteRig(rig, use_rig_id);
+  }
+
+  camera_t WriteCamera(const Camera& camera,
+                       const bool use_camera_id) override {
+    return metadata_->WriteCamera(camera, use_camera_id);
+  }
+
+  frame_t WriteFrame(const Frame& frame, const bool use_frame_id) override {
+    return metadata_->WriteFrame(frame, use_frame_id);
+  }
+
+  std::vector<frame_t> WriteFrames(span<const Frame> frames,
+                                   const bool use_frame_ids) override {
+    return metadata_->WriteFrames(frames, use_frame_ids);
+  }
+
+  image_t WriteImage(const Image& image, const bool use_image_id) override {
+    return metadata_->WriteImage(image, use_image_id);
+  }
+
+  pose_prior_t WritePosePrior(const PosePrior& pose_prior,
+                              const bool use_pose_prior_id) override {
+    return metadata_->WritePosePrior(pose_prior, use_pose_prior_id);
+  }
+
+  std::vector<pose_prior_t> WritePosePriors(
+      span<const PosePrior> pose_priors,
+      const bool use_pose_prior_ids) override {
+    return metadata_->WritePosePriors(pose_priors, use_pose_prior_ids);
+  }
+
+  void WriteKeypoints(const image_t image_id,
+                      const FeatureKeypoints& keypoints) override {
+    CheckNewImageFeatures(keypoints_, image_id);
+    keypoints_.Write(image_id,
+                     /*type=*/0,
+                     keypoints.size(),
+                     /*cols=*/6,
+                     keypoints.data(),
+                     keypoints.size() * sizeof(FeatureKeypoint));
+  }
+
+  void WriteKeypoints(const image_t image_id,
+                      const FeatureKeypointsBlob& blob) override {
+    CheckNewImageFeatures(keypoints_, image_id);
+    WriteKeypointsBlob(image_id, blob);
+  }
+
+  void WriteDescriptors(const image_t image_id,
+                        const FeatureDescriptors& descriptors) override {
+    CheckNewImageFeatures(descriptors_, image_id);
+    descriptors_.Write(image_id,
+                       FeatureDescriptorsTypeToInt(descriptors.type,
+                                                   descriptors.precision),
+                       descriptors.data.rows(),
+                       descriptors.data.cols(),
+                       descriptors.data.data(),
+                       descriptors.data.size());
+  }
+
+  void WriteFeatureExtractionFingerprint(
+      const image_t image_id,
+      const FeatureExtractionFingerprint& fingerprint) override {
+    metadata_->WriteFeatureExtractionFingerprint(image_id, fingerprint);
+  }
+
+  void WriteGlobalImageDescriptor(
+      const image_t image_id,
+      const GlobalImageDescriptor& descriptor) override {
+    metadata_->WriteGlobalImageDescriptor(image_id, descriptor);
+  }
+
+  void WriteMatches(const image_t image_id1,
+                    const image_t image_id2,
+                    const FeatureMatches& matches) override {
+    if (ShouldSwapImagePair(image_id1, image_id2)) {
+      WriteMatches(image_id1, image_id2, FeatureMatchesToBlob(matches));
+      return;
+    }
+    const image_pair_t pair_id = ImagePairToPairId(image_id1, image_id2);
+    CheckNewMatches(pair_id);
+    matches_.Write(pair_id,
+                   /*type=*/0,
+                   matches.size(),
+                   /*cols=*/2,
+                   matches.data(),
+                   matches.size() * sizeof(FeatureMatch));
+  }
+
+  void WriteMatches(const image_t image_id1,
+                    const image_t image_id2,
+                    const FeatureMatchesBlob& blob) override {
+    const image_pair_t pair_id = ImagePairToPairId(image_id1, image_id2);
+    CheckNewMatches(pair_id);
+    const FeatureMatchesBlob* blob_ptr = &blob;
+    FeatureMatchesBlob swapped_blob;
+    if (ShouldSwapImagePair(image_id1, image_id2)) {
+      swapped_blob = blob;
+      SwapFeatureMatchesBlob(&swapped_blob);
+      blob_ptr = &swapped_blob;
+    }
+    matches_.Write(pair_id,
+                   /*type=*/0,
+                   blob_ptr->rows(),
+                   blob_ptr->cols(),
+                   blob_ptr->data(),
+                   blob_ptr->size() * sizeof(point2D_t));
+  }
+
+  void WriteTwoViewGeometry(const image_t image_id1,
+                            const image_t image_id2,
+                            const TwoViewGeometry& two_view_geometry) override {
+    metadata_->WriteTwoViewGeometry(image_id1, image_id2, two_view_geometry);
+  }
+
+  void UpdateRig(const Rig& rig) override { metadata_->UpdateRig(rig); }
+
+  void UpdateCamera(const Camera& camera) override {
+    metadata_->UpdateCamera(camera);
+  }
+
+  void UpdateFrame(const Frame& frame) override {
+    metadata_->UpdateFrame(frame);
+  }
+
+  void UpdateImage(const Image& image) override {
+    metadata_->UpdateImage(image);
+  }
+
+  void UpdatePosePrior(const PosePrior& pose_prior) override {
+    metadata_->UpdatePosePrior(pose_prior);
+  }
+
+  void UpdateKeypoints(const image_t image_id,
+                       const FeatureKeypoints& keypoints) override {
+    UpdateKeypoints(image_id, FeatureKeypointsToBlob(keypoints));
+  }
+
+  void UpdateKeypoints(const image_t image_id,
+                       const FeatureKeypointsBlob& blob) override {
+    // Do nothing if the keypoints do not exist, to align with the UPDATE
+    // behavior in SQL.
+    if (ExistsKeypoints(image_id)) {
+      WriteKeypointsBlob(image_id, blob);
+    }
+  }
+
+  void UpdateDescriptors(const image_t image_id,
+                         const FeatureDescriptors& descriptors) override {
+    // Do nothing if the descriptors do not exist, to align with the UPDATE
+    // behavior in SQL.
+    if (ExistsDescriptors(image_id)) {
+      descriptors_.Write(image_id,
+                         FeatureDescriptorsTypeToInt(descriptors.type,
+                                                     descriptors.precision),
+                         descriptors.data.rows(),
+                         descriptors.data.cols(),
+                         descriptors.data.data(),
+                         descriptors.data.size());
+    }
+  }
+
+  void UpdateTwoViewGeometry(
+      const image_t image_id1,
+      const image_t image_id2,
+      const TwoViewGeometry& two_view_geometry) override {
+    metadata_->UpdateTwoViewGeometry(image_id1, image_id2, two_view_geometry);
+  }
+
+  void DeleteMatches(const image_t image_id1,
+                     const image_t image_id2) override {
+    matches_.Delete(ImagePairToPairId(image_id1, image_id2));
+  }
+
+  void DeleteTwoViewGeometry(const image_t image_id1,
+                             const image_t image_id2) override {
+    metadata_->DeleteTwoViewGeometry(image_id1, image_id2);
+  }
+
+  void DeleteInlierMatches(const image_t image_id1,
+                           const image_t image_id2) override {
+    metadata_->DeleteInlierMatches(image_id1, image_id2);
+  }
+
+  void ClearAllTables() override {
+    ClearMatches();
+    ClearDescriptors();
+    ClearKeypoints();
+    metadata_->ClearAllTables();
+  }
+
+  void ClearRigs() override { metadata_->ClearRigs(); }
+
+  void ClearCameras() override { metadata_->ClearCameras(); }
+
+  void ClearFrames() override { metadata_->ClearFrames(); }
+
+  void ClearImages() override {
+    // Keypoints and descriptors are cascade deleted with their images.
+    ClearDescriptors();
+    ClearKeypoints();
+    metadata_->ClearImages();
+  }
+
+  void ClearPosePriors() override { metadata_->ClearPosePriors(); }
+
+  void ClearDescriptors() override { descriptors_.Clear(); }
+
+  void ClearKeypoints() override { keypoints_.Clear(); }
+
+  void ClearMatches() override { matches_.Clear(); }
+
+  void ClearTwoViewGeometries() override {
+    metadata_->ClearTwoViewGeometries();
+  }
+
+  void BeginTransaction() const override { metadata_->BeginTransaction(); }
+
+  void EndTransaction() const override {
+    keypoints_.Flush();
+    descriptors_.Flush();
+    matches_.Flush();
+    metadata_->EndTransaction();
+  }
+
+  // The column files are memory-mapped for reading and are stored raw, so
+  // only the inlier matches of the two-view geometries are encoded.
+  void SetBlobCompression(const bool enabled) override {
+    metadata_->SetBlobCompression(enabled);
+  }
+
+ private:
+  void CloseImpl() {
+    if (metadata_ != nullptr) {
+      metadata_->Close();
+    }
+    keypoints_.Close();
+    descriptors_.Close();
+    matches_.Close();
+  }
+
+  // Mirrors the primary and foreign key constraints of the SQLite tables.
+  void CheckNewImageFeatures(const ColumnStore& store,
+                             const image_t image_id) const {
+    THROW_CHECK(store.Find(image_id) == nullptr)
+        << "Features for image " << image_id << " already exist.";
+    THROW_CHECK(metadata_->ExistsImage(image_id))
+        << "Image " << image_id << " does not exist.";
+  }
+
+  void CheckNewMatches(const image_pair_t pair_id) const {
+    THROW_CHECK(matches_.Find(pair_id) == nullptr)
+        << "Matches for image pair " << pair_id << " already exist.";
+  }
+
+  void WriteKeypointsBlob(const image_t image_id,
+                          const FeatureKeypointsBlob& blob) {
+    keypoints_.Write(image_id,
+                     /*type=*/0,
+                     blob.rows(),
+                     blob.cols(),
+                     blob.data(),
+                     blob.size() * sizeof(float));
+  }
+
+  std::shared_ptr<Database> metadata_;
+  ColumnStore keypoints_;
+  ColumnStore descriptors_;
+  ColumnStore matches_;
+};
+
+}  // namespace
+
+std::shared_ptr<Database> OpenMmapDatabase(const std::filesystem::path& path) {
+  return MmapDatabase::Open(path);
+}
+
+bool IsMmapDatabase(const std::filesystem::path& path) {
+  return ExistsDir(path) && ExistsFile(path / kMmapDatabaseMetadataFileName);
+}
+
+}  // namespace colmap
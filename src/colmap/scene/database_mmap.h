@@ -0,0 +1,53 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "colmap/scene/database.h"
+
+#include <filesystem>
+#include <memory>
+
+namespace colmap {
+
+// Name of the SQLite database inside of a memory-mapped database directory,
+// which stores everything except for the keypoints, descriptors, and matches.
+constexpr inline char kMmapDatabaseMetadataFileName[] = "metadata.db";
+
+// Open a memory-mapped database at the given directory or create a new one, if
+// it does not exist yet. Keypoints, descriptors, and matches are stored in
+// append-only binary column files that are memory-mapped for reading, while all
+// other data is stored in an embedded SQLite database. The in-memory path
+// `kInMemorySqliteDatabasePath` creates a temporary in-memory database.
+std::shared_ptr<Database> OpenMmapDatabase(const std::filesystem::path& path);
+
+// Check whether the path points to an existing memory-mapped database.
+bool IsMmapDatabase(const std::filesystem::path& path);
+
+}  // namespace colmap
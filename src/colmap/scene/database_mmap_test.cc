@@ -0,0 +1,207 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/scene/database_mmap.h"
+
+#include "colmap/math/random.h"
+#include "colmap/scene/database_sqlite.h"
+#include "colmap/util/file.h"
+#include "colmap/util/testing.h"
+
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+image_t WriteTestImage(Database& database, const std::string& name) {
+  Camera camera = Camera::CreateFromModelId(
+      kInvalidCameraId, CameraModelId::kSimplePinhole, 1.0, 1, 1);
+  camera.camera_id = database.WriteCamera(camera);
+  Image image;
+  image.SetName(name);
+  image.SetCameraId(camera.camera_id);
+  return database.WriteImage(image);
+}
+
+FeatureKeypoints RandomKeypoints(const int num_keypoints) {
+  FeatureKeypoints keypoints(num_keypoints);
+  for (auto& keypoint : keypoints) {
+    keypoint = FeatureKeypoint(
+        RandomUniformReal(0.f, 100.f), RandomUniformReal(0.f, 100.f));
+  }
+  return keypoints;
+}
+
+TEST(MmapDatabase, CreateAndDetect) {
+  const auto database_path = CreateTestDir() / "database";
+  EXPECT_FALSE(IsMmapDatabase(database_path));
+  OpenMmapDatabase(database_path)->Close();
+  EXPECT_TRUE(IsMmapDatabase(database_path));
+  EXPECT_TRUE(ExistsFile(database_path / kMmapDatabaseMetadataFileName));
+  EXPECT_FALSE(IsMmapDatabase(CreateTestDir() / "database.db"));
+}
+
+TEST(MmapDatabase, Reopen) {
+  const auto database_path = CreateTestDir() / "database";
+
+  const FeatureKeypoints keypoints = RandomKeypoints(100);
+  const FeatureDescriptors descriptors(FeatureExtractorType::SIFT,
+                                       FeatureDescriptorsData::Random(100, 128));
+  FeatureMatches matches(50);
+  for (size_t i = 0; i < matches.size(); ++i) {
+    matches[i] = FeatureMatch(i, 2 * i);
+  }
+
+  image_t image_id1;
+  image_t image_id2;
+  {
+    auto database = OpenMmapDatabase(database_path);
+    image_id1 = WriteTestImage(*database, "image1");
+    image_id2 = WriteTestImage(*database, "image2");
+    database->WriteKeypoints(image_id1, keypoints);
+    database->WriteDescriptors(image_id1, descriptors);
+    database->WriteMatches(image_id2, image_id1, matches);
+  }
+
+  // The generic factory must detect existing memory-mapped databases.
+  auto database = Database::Open(database_path);
+  EXPECT_EQ(database->NumImages(), 2);
+  EXPECT_EQ(database->ReadKeypoints(image_id1), keypoints);
+  const FeatureDescriptors descriptors_read =
+      database->ReadDescriptors(image_id1);
+  EXPECT_EQ(descriptors_read.type, descriptors.type);
+  EXPECT_EQ(descriptors_read.data, descriptors.data);
+  EXPECT_EQ(database->ReadMatches(image_id2, image_id1), matches);
+  EXPECT_EQ(database->NumMatchedImagePairs(), 1);
+  EXPECT_FALSE(database->ExistsKeypoints(image_id2));
+
+  // Entries written after opening must be readable right away.
+  const FeatureKeypoints keypoints2 = RandomKeypoints(10);
+  database->WriteKeypoints(image_id2, keypoints2);
+  EXPECT_EQ(database->ReadKeypoints(image_id2), keypoints2);
+  EXPECT_EQ(database->ReadKeypoints(image_id1), keypoints);
+}
+
+TEST(MmapDatabase, UpdateAndDeletePersistAfterCompaction) {
+  const auto database_path = CreateTestDir() / "database";
+
+  image_t image_id1;
+  image_t image_id2;
+  const FeatureKeypoints keypoints = RandomKeypoints(1000);
+  {
+    auto database = OpenMmapDatabase(database_path);
+    image_id1 = WriteTestImage(*database, "image1");
+    image_id2 = WriteTestImage(*database, "image2");
+    database->WriteKeypoints(image_id1, RandomKeypoints(1000));
+    for (int i = 0; i < 3; ++i) {
+      database->UpdateKeypoints(image_id1, RandomKeypoints(1000));
+    }
+    database->UpdateKeypoints(image_id1, keypoints);
+    database->WriteMatches(image_id1, image_id2, FeatureMatches(10));
+    database->DeleteMatches(image_id1, image_id2);
+  }
+
+  const size_t num_bytes =
+      std::filesystem::file_size(database_path / "keypoints.bin");
+  EXPECT_LT(num_bytes, 2 * keypoints.size() * sizeof(FeatureKeypoint));
+
+  auto database = OpenMmapDatabase(database_path);
+  EXPECT_EQ(database->ReadKeypoints(image_id1), keypoints);
+  EXPECT_EQ(database->NumKeypoints(), keypoints.size());
+  EXPECT_FALSE(database->ExistsMatches(image_id1, image_id2));
+  EXPECT_EQ(database->NumMatchedImagePairs(), 0);
+}
+
+TEST(MmapDatabase, DiscardIncompleteRecords) {
+  const auto database_path = CreateTestDir() / "database";
+
+  image_t image_id;
+  const FeatureKeypoints keypoints = RandomKeypoints(10);
+  {
+    auto database = OpenMmapDatabase(database_path);
+    image_id = WriteTestImage(*database, "image");
+    database->WriteKeypoints(image_id, keypoints);
+  }
+
+  // Simulate a partially written record.
+  {
+    std::ofstream file(database_path / "keypoints.bin",
+                       std::ios::binary | std::ios::app);
+    const char kGarbage[13] = {0};
+    file.write(kGarbage, sizeof(kGarbage));
+  }
+
+  auto database = OpenMmapDatabase(database_path);
+  EXPECT_EQ(database->ReadKeypoints(image_id), keypoints);
+  EXPECT_EQ(database->NumKeypoints(), keypoints.size());
+}
+
+TEST(MmapDatabase, CopyFromAndToSqlite) {
+  auto sqlite_database = OpenSqliteDatabase(kInMemorySqliteDatabasePath);
+  const image_t image_id1 = WriteTestImage(*sqlite_database, "image1");
+  const image_t image_id2 = WriteTestImage(*sqlite_database, "image2");
+  const FeatureKeypoints keypoints = RandomKeypoints(20);
+  const FeatureDescriptors descriptors(FeatureExtractorType::SIFT,
+                                       FeatureDescriptorsData::Random(20, 128));
+  sqlite_database->WriteKeypoints(image_id2, keypoints);
+  sqlite_database->WriteDescriptors(image_id2, descriptors);
+  FeatureMatches matches(1);
+  matches[0] = FeatureMatch(1, 2);
+  sqlite_database->WriteMatches(image_id2, image_id1, matches);
+  TwoViewGeometry two_view_geometry;
+  two_view_geometry.config = TwoViewGeometry::CALIBRATED;
+  two_view_geometry.inlier_matches = matches;
+  sqlite_database->WriteTwoViewGeometry(
+      image_id2, image_id1, two_view_geometry);
+
+  const auto database_path = CreateTestDir() / "database";
+  auto mmap_database = OpenMmapDatabase(database_path);
+  Database::Copy(*sqlite_database, mmap_database.get());
+  EXPECT_EQ(mmap_database->NumCameras(), 2);
+  EXPECT_EQ(mmap_database->NumImages(), 2);
+  EXPECT_EQ(mmap_database->ReadKeypoints(image_id2), keypoints);
+  EXPECT_EQ(mmap_database->ReadDescriptors(image_id2).data, descriptors.data);
+  EXPECT_EQ(mmap_database->ReadMatches(image_id2, image_id1), matches);
+  EXPECT_EQ(mmap_database->ReadTwoViewGeometry(image_id2, image_id1)
+                .inlier_matches,
+            matches);
+
+  auto sqlite_database2 = OpenSqliteDatabase(kInMemorySqliteDatabasePath);
+  Database::Copy(*mmap_database, sqlite_database2.get());
+  EXPECT_EQ(sqlite_database2->ReadKeypoints(image_id2), keypoints);
+  EXPECT_EQ(sqlite_database2->ReadMatches(image_id1, image_id2),
+            sqlite_database->ReadMatches(image_id1, image_id2));
+  EXPECT_EQ(sqlite_database2->NumVerifiedImagePairs(), 1);
+}
+
+}  // namespace
+}  // namespace colmap
@@ -0,0 +1,505 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/scene/database_shard.h"
+
+#include "colmap/scene/database_sqlite.h"
+#include "colmap/util/logging.h"
+
+#include <future>
+
+namespace colmap {
+namespace {
+
+class ShardDatabase : public Database {
+ public:
+  ShardDatabase(std::shared_ptr<Database> database,
+                std::shared_ptr<Database> shard)
+      : database_(std::move(database)), shard_(std::move(shard)) {
+    THROW_CHECK_NOTNULL(database_);
+    THROW_CHECK_NOTNULL(shard_);
+  }
+
+  ~ShardDatabase() override { shard_->Close(); }
+
+  void Close() override { shard_->Close(); }
+
+  bool ExistsRig(const rig_t rig_id) const override {
+    return database_->ExistsRig(rig_id);
+  }
+
+  bool ExistsCamera(const camera_t camera_id) const override {
+    return database_->ExistsCamera(camera_id);
+  }
+
+  bool ExistsFrame(const frame_t frame_id) const override {
+    return database_->ExistsFrame(frame_id);
+  }
+
+  bool ExistsImage(const image_t image_id) const override {
+    return database_->ExistsImage(image_id);
+  }
+
+  bool ExistsImageWithName(const std::string& name) const override {
+    return database_->ExistsImageWithName(name);
+  }
+
+  bool ExistsPosePrior(const pose_prior_t pose_prior_id,
+                       bool is_deprecated_image_prior) const override {
+    return database_->ExistsPosePrior(pose_prior_id,
+                                      is_deprecated_image_prior);
+  }
+
+  bool ExistsKeypoints(const image_t image_id) const override {
+    return database_->ExistsKeypoints(image_id);
+  }
+
+  bool ExistsDescriptors(const image_t image_id) const override {
+    return database_->ExistsDescriptors(image_id);
+  }
+
+  bool ExistsMatches(const image_t image_id1,
+                     const image_t image_id2) const override {
+    return shard_->ExistsMatches(image_id1, image_id2);
+  }
+
+  bool ExistsTwoViewGeometry(const image_t image_id1,
+                             const image_t image_id2) const override {
+    return shard_->ExistsTwoViewGeometry(image_id1, image_id2);
+  }
+
+  size_t NumRigs() const override { return database_->NumRigs(); }
+
+  size_t NumCameras() const override { return database_->NumCameras(); }
+
+  size_t NumFrames() const override { return database_->NumFrames(); }
+
+  size_t NumImages() const override { return database_->NumImages(); }
+
+  size_t NumPosePriors() const override { return database_->NumPosePriors(); }
+
+  size_t NumKeypoints() const override { return database_->NumKeypoints(); }
+
+  size_t MaxNumKeypoints() const override {
+    return database_->MaxNumKeypoints();
+  }
+
+  size_t NumKeypointsForImage(const image_t image_id) const override {
+    return database_->NumKeypointsForImage(image_id);
+  }
+
+  size_t NumDescriptors() const override {
+    return database_->NumDescriptors();
+  }
+
+  size_t MaxNumDescriptors() const override {
+    return database_->MaxNumDescriptors();
+  }
+
+  size_t NumDescriptorsForImage(const image_t image_id) const override {
+    return database_->NumDescriptorsForImage(image_id);
+  }
+
+  size_t NumMatches() const override { return shard_->NumMatches(); }
+
+  size_t NumInlierMatches() const override {
+    return shard_->NumInlierMatches();
+  }
+
+  size_t NumMatchedImagePairs() const override {
+    return shard_->NumMatchedImagePairs();
+  }
+
+  size_t NumVerifiedImagePairs() const override {
+    return shard_->NumVerifiedImagePairs();
+  }
+
+  Rig ReadRig(const rig_t rig_id) const override {
+    return database_->ReadRig(rig_id);
+  }
+
+  std::optional<Rig> ReadRigWithSensor(sensor_t sensor_id) const override {
+    return database_->ReadRigWithSensor(sensor_id);
+  }
+
+  std::vector<Rig> ReadAllRigs() const override {
+    return database_->ReadAllRigs();
+  }
+
+  Camera ReadCamera(const camera_t camera_id) const override {
+    return database_->ReadCamera(camera_id);
+  }
+
+  std::vector<Camera> ReadAllCameras() const override {
+    return database_->ReadAllCameras();
+  }
+
+  Frame ReadFrame(const frame_t frame_id) const override {
+    return database_->ReadFrame(frame_id);
+  }
+
+  std::vector<Frame> ReadAllFrames() const override {
+    return database_->ReadAllFrames();
+  }
+
+  Image ReadImage(const image_t image_id) const override {
+    return database_->ReadImage(image_id);
+  }
+
+  std::optional<Image> ReadImageWithName(
+      const std::string& name) const override {
+    return database_->ReadImageWithName(name);
+  }
+
+  std::vector<Image> ReadAllImages() const override {
+    return database_->ReadAllImages();
+  }
+
+  PosePrior ReadPosePrior(const pose_prior_t pose_prior_id,
+                          bool is_deprecated_image_prior) const override {
+    return database_->ReadPosePrior(pose_prior_id, is_deprecated_image_prior);
+  }
+
+  std::vector<PosePrior> ReadAllPosePriors() const override {
+    return database_->ReadAllPosePriors();
+  }
+
+  FeatureKeypointsBlob ReadKeypointsBlob(
+      const image_t image_id) const override {
+    return database_->ReadKeypointsBlob(image_id);
+  }
+
+  FeatureKeypoints ReadKeypoints(const image_t image_id) const override {
+    return database_->ReadKeypoints(image_id);
+  }
+
+  FeatureDescriptors ReadDescriptors(const image_t image_id) const override {
+    return database_->ReadDescriptors(image_id);
+  }
+
+  std::optional<FeatureExtractionFingerprint> ReadFeatureExtractionFingerprint(
+      const image_t image_id) const override {
+    return database_->ReadFeatureExtractionFingerprint(image_id);
+  }
+
+  std::optional<GlobalImageDescriptor> ReadGlobalImageDescriptor(
+      const image_t image_id) const override {
+    return database_->ReadGlobalImageDescriptor(image_id);
+  }
+
+  std::vector<FeatureKeypoints> ReadKeypoints(
+      span<const image_t> image_ids) const override {
+    return database_->ReadKeypoints(image_ids);
+  }
+
+  std::vector<FeatureDescriptors> ReadDescriptors(
+      span<const image_t> image_ids) const override {
+    return database_->ReadDescriptors(image_ids);
+  }
+
+  FeatureMatchesBlob ReadMatchesBlob(image_t image_id1,
+                                     image_t image_id2) const override {
+    return shard_->ReadMatchesBlob(image_id1, image_id2);
+  }
+
+  FeatureMatches ReadMatches(image_t image_id1,
+                             image_t image_id2) const override {
+    return shard_->ReadMatches(image_id1, image_id2);
+  }
+
+  std::vector<std::pair<image_pair_t, FeatureMatchesBlob>> ReadAllMatchesBlob()
+      const override {
+    return shard_->ReadAllMatchesBlob();
+  }
+
+  std::vector<std::pair<image_pair_t, FeatureMatches>> ReadAllMatches()
+      const override {
+    return shard_->ReadAllMatches();
+  }
+
+  std::vector<std::pair<image_pair_t, int>> ReadNumMatches() const override {
+    return shard_->ReadNumMatches();
+  }
+
+  TwoViewGeometry ReadTwoViewGeometry(const image_t image_id1,
+                                      const image_t image_id2) const override {
+    return shard_->ReadTwoViewGeometry(image_id1, image_id2);
+  }
+
+  std::vector<std::pair<image_pair_t, TwoViewGeometry>> ReadTwoViewGeometries()
+      const override {
+    return shard_->ReadTwoViewGeometries();
+  }
+
+  std::vector<TwoViewGeometry> ReadTwoViewGeometries(
+      span<const image_pair_t> pair_ids) const override {
+    return shard_->ReadTwoViewGeometries(pair_ids);
+  }
+
+  std::vector<std::pair<image_pair_t, int>> ReadTwoViewGeometryNumInliers()
+      const override {
+    return shard_->ReadTwoViewGeometryNumInliers();
+  }
+
+  rig_t WriteRig(const Rig& rig, const bool use_rig_id) override {
+    return database_->WriteRig(rig, use_rig_id);
+  }
+
+  camera_t WriteCamera(const Camera& camera,
+                       const bool use_camera_id) override {
+    return database_->WriteCamera(camera, use_camera_id);
+  }
+
+  frame_t WriteFrame(const Frame& frame, const bool use_frame_id) override {
+    return database_->WriteFrame(frame, use_frame_id);
+  }
+
+  std::vector<frame_t> WriteFrames(span<const Frame> frames,
+                                   const bool use_frame_ids) override {
+    return database_->WriteFrames(frames, use_frame_ids);
+  }
+
+  image_t WriteImage(const Image& image, const bool use_image_id) override {
+    return database_->WriteImage(image, use_image_id);
+  }
+
+  pose_prior_t WritePosePrior(const PosePrior& pose_prior,
+                              const bool use_pose_prior_id) override {
+    return database_->WritePosePrior(pose_prior, use_pose_prior_id);
+  }
+
+  std::vector<pose_prior_t> WritePosePriors(
+      span<const PosePrior> pose_priors,
+      const bool use_pose_prior_ids) override {
+    return database_->WritePosePriors(pose_priors, use_pose_prior_ids);
+  }
+
+  void WriteKeypoints(const image_t image_id,
+                      const FeatureKeypoints& keypoints) override {
+    database_->WriteKeypoints(image_id, keypoints);
+  }
+
+  void WriteKeypoints(const image_t image_id,
+                      const FeatureKeypointsBlob& blob) override {
+    database_->WriteKeypoints(image_id, blob);
+  }
+
+  void WriteDescriptors(const image_t image_id,
+                        const FeatureDescriptors& descriptors) override {
+    database_->WriteDescriptors(image_id, descriptors);
+  }
+  void WriteFeatureExtractionFingerprint(
+      const image_t image_id,
+      const FeatureExtractionFingerprint& fingerprint) override {
+    database_->WriteFeatureExtractionFingerprint(image_id, fingerprint);
+  }
+
+  void WriteGlobalImageDescriptor(
+      const image_t image_id,
+      const GlobalImageDescriptor& descriptor) override {
+    database_->WriteGlobalImageDescriptor(image_id, descriptor);
+  }
+
+
+  void WriteMatches(const image_t image_id1,
+                    const image_t image_id2,
+                    const FeatureMatches& matches) override {
+    shard_->WriteMatches(image_id1, image_id2, matches);
+  }
+
+  void WriteMatches(const image_t image_id1,
+                    const image_t image_id2,
+                    const FeatureMatchesBlob& blob) override {
+    shard_->WriteMatches(image_id1, image_id2, blob);
+  }
+
+  void WriteTwoViewGeometry(const image_t image_id1,
+                            const image_t image_id2,
+                            const TwoViewGeometry& two_view_geometry) override {
+    shard_->WriteTwoViewGeometry(image_id1, image_id2, two_view_geometry);
+  }
+
+  void UpdateRig(const Rig& rig) override { database_->UpdateRig(rig); }
+
+  void UpdateCamera(const Camera& camera) override {
+    database_->UpdateCamera(camera);
+  }
+
+  void UpdateFrame(const Frame& frame) override {
+    database_->UpdateFrame(frame);
+  }
+
+  void UpdateImage(const Image& image) override {
+    database_->UpdateImage(image);
+  }
+
+  void UpdatePosePrior(const PosePrior& pose_prior) override {
+    database_->UpdatePosePrior(pose_prior);
+  }
+
+  void UpdateKeypoints(const image_t image_id,
+                       const FeatureKeypoints& keypoints) override {
+    database_->UpdateKeypoints(image_id, keypoints);
+  }
+
+  void UpdateKeypoints(const image_t image_id,
+                       const FeatureKeypointsBlob& blob) override {
+    database_->UpdateKeypoints(image_id, blob);
+  }
+
+  void UpdateDescriptors(const image_t image_id,
+                         const FeatureDescriptors& descriptors) override {
+    database_->UpdateDescriptors(image_id, descriptors);
+  }
+
+  void UpdateTwoViewGeometry(
+      const image_t image_id1,
+      const image_t image_id2,
+      const TwoViewGeometry& two_view_geometry) override {
+    shard_->UpdateTwoViewGeometry(image_id1, image_id2, two_view_geometry);
+  }
+
+  void DeleteMatches(const image_t image_id1,
+                     const image_t image_id2) override {
+    shard_->DeleteMatches(image_id1, image_id2);
+  }
+
+  void DeleteTwoViewGeometry(const image_t image_id1,
+                             const image_t image_id2) override {
+    shard_->DeleteTwoViewGeometry(image_id1, image_id2);
+  }
+
+  void DeleteInlierMatches(const image_t image_id1,
+                           const image_t image_id2) override {
+    shard_->DeleteInlierMatches(image_id1, image_id2);
+  }
+
+  void ClearAllTables() override {
+    shard_->ClearAllTables();
+    database_->ClearAllTables();
+  }
+
+  void ClearRigs() override { database_->ClearRigs(); }
+
+  void ClearCameras() override { database_->ClearCameras(); }
+
+  void ClearFrames() override { database_->ClearFrames(); }
+
+  void ClearImages() override { database_->ClearImages(); }
+
+  void ClearPosePriors() override { database_->ClearPosePriors(); }
+
+  void ClearDescriptors() override { database_->ClearDescriptors(); }
+
+  void ClearKeypoints() override { database_->ClearKeypoints(); }
+
+  void ClearMatches() override { shard_->ClearMatches(); }
+
+  void ClearTwoViewGeometries() override { shard_->ClearTwoViewGeometries(); }
+
+  // Only the shard is written during matching, so transactions are not
+  // forwarded to the main database, which may be shared with other workers.
+  void BeginTransaction() const override { shard_->BeginTransaction(); }
+
+  void EndTransaction() const override { shard_->EndTransaction(); }
+
+  void SetBlobCompression(const bool enabled) override {
+    shard_->SetBlobCompression(enabled);
+  }
+
+ private:
+  const std::shared_ptr<Database> database_;
+  const std::shared_ptr<Database> shard_;
+};
+
+struct ShardEntries {
+  std::vector<std::pair<image_pair_t, FeatureMatchesBlob>> matches;
+  std::vector<std::pair<image_pair_t, TwoViewGeometry>> two_view_geometries;
+};
+
+ShardEntries ReadShardEntries(const Database& shard) {
+  ShardEntries entries;
+  entries.matches = shard.ReadAllMatchesBlob();
+  entries.two_view_geometries = shard.ReadTwoViewGeometries();
+  return entries;
+}
+
+}  // namespace
+
+std::shared_ptr<Database> OpenShardDatabase(std::shared_ptr<Database> database,
+                                            const std::filesystem::path& path) {
+  return std::make_shared<ShardDatabase>(std::move(database),
+                                         OpenSqliteDatabase(path));
+}
+
+void ReduceDatabaseShards(const std::vector<const Database*>& shards,
+                          Database* database) {
+  THROW_CHECK_NOTNULL(database);
+  if (shards.empty()) {
+    return;
+  }
+
+  DatabaseTransaction transaction(database);
+
+  std::future<ShardEntries> next_entries =
+      std::async(std::launch::async,
+                 ReadShardEntries,
+                 std::cref(*THROW_CHECK_NOTNULL(shards[0])));
+  for (size_t i = 0; i < shards.size(); ++i) {
+    const ShardEntries entries = next_entries.get();
+    if (i + 1 < shards.size()) {
+      next_entries = std::async(std::launch::async,
+                                ReadShardEntries,
+                                std::cref(*THROW_CHECK_NOTNULL(shards[i + 1])));
+    }
+
+    for (const auto& [pair_id, blob] : entries.matches) {
+      const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+      if (database->ExistsMatches(image_id1, image_id2)) {
+        database->DeleteMatches(image_id1, image_id2);
+      }
+      database->WriteMatches(image_id1, image_id2, blob);
+    }
+
+    for (const auto& [pair_id, two_view_geometry] :
+         entries.two_view_geometries) {
+      const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+      if (database->ExistsTwoViewGeometry(image_id1, image_id2)) {
+        database->DeleteTwoViewGeometry(image_id1, image_id2);
+      }
+      database->WriteTwoViewGeometry(image_id1, image_id2, two_view_geometry);
+    }
+
+    LOG(INFO) << "Reduced shard " << i + 1 << " / " << shards.size() << " with "
+              << entries.matches.size() << " matched and "
+              << entries.two_view_geometries.size() << " verified image pairs";
+  }
+}
+
+}  // namespace colmap
@@ -0,0 +1,60 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "colmap/scene/database.h"
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace colmap {
+
+// Open a shard of the given database for distributed feature matching, where
+// multiple workers match disjoint subsets of image pairs against the same
+// database. Matches and two-view geometries are read from and written to the
+// SQLite database at `shard_path`, which is created if it does not exist yet,
+// while all other entries are read from and written to the main database. The
+// main database can thus be shared by all workers, as long as they do not
+// modify it, and the shards are unified by `ReduceDatabaseShards`.
+std::shared_ptr<Database> OpenShardDatabase(std::shared_ptr<Database> database,
+                                            const std::filesystem::path& path);
+
+// Copy the matches and two-view geometries of all shards into the database in
+// a single transaction. The identifiers are preserved, i.e., the shards must
+// have been created against the same main database. Existing entries of the
+// same image pairs are replaced, such that reducing the same shards again has
+// no effect. As in `Database::Merge`, image pairs without any matches or inlier
+// matches are not copied. Matches are copied as BLOBs and the next shard is
+// read while the entries of the current shard are written.
+void ReduceDatabaseShards(const std::vector<const Database*>& shards,
+                          Database* database);
+
+}  // namespace colmap
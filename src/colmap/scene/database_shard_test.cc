@@ -0,0 +1,128 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/scene/database_shard.h"
+
+#include "colmap/scene/database_sqlite.h"
+#include "colmap/util/testing.h"
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+image_t WriteTestImage(Database& database, const std::string& name) {
+  Camera camera = Camera::CreateFromModelId(
+      kInvalidCameraId, CameraModelId::kSimplePinhole, 1.0, 1, 1);
+  camera.camera_id = database.WriteCamera(camera);
+  Image image;
+  image.SetName(name);
+  image.SetCameraId(camera.camera_id);
+  return database.WriteImage(image);
+}
+
+FeatureMatches TestMatches(const int num_matches) {
+  FeatureMatches matches(num_matches);
+  for (int i = 0; i < num_matches; ++i) {
+    matches[i] = FeatureMatch(i, 2 * i);
+  }
+  return matches;
+}
+
+TwoViewGeometry TestTwoViewGeometry(const int num_inliers) {
+  TwoViewGeometry two_view_geometry;
+  two_view_geometry.config = num_inliers > 0 ? TwoViewGeometry::CALIBRATED
+                                             : TwoViewGeometry::UNDEFINED;
+  two_view_geometry.inlier_matches = TestMatches(num_inliers);
+  return two_view_geometry;
+}
+
+TEST(ShardDatabase, RoutesImagePairEntriesToShard) {
+  const auto test_dir = CreateTestDir();
+  auto database = OpenSqliteDatabase(test_dir / "database.db");
+  const image_t image_id1 = WriteTestImage(*database, "image1");
+  const image_t image_id2 = WriteTestImage(*database, "image2");
+  const FeatureKeypoints keypoints(10);
+  database->WriteKeypoints(image_id1, keypoints);
+
+  auto shard = OpenShardDatabase(database, test_dir / "shard.db");
+  EXPECT_EQ(shard->NumImages(), 2);
+  EXPECT_EQ(shard->ReadKeypoints(image_id1), keypoints);
+
+  shard->WriteMatches(image_id2, image_id1, TestMatches(5));
+  shard->WriteTwoViewGeometry(image_id1, image_id2, TestTwoViewGeometry(3));
+  EXPECT_TRUE(shard->ExistsMatches(image_id1, image_id2));
+  EXPECT_TRUE(shard->ExistsTwoViewGeometry(image_id1, image_id2));
+  EXPECT_EQ(shard->ReadMatches(image_id2, image_id1), TestMatches(5));
+  EXPECT_EQ(shard->NumInlierMatches(), 3);
+  EXPECT_EQ(database->NumMatchedImagePairs(), 0);
+  EXPECT_EQ(database->NumVerifiedImagePairs(), 0);
+
+  // The shard is persisted independently of the main database.
+  shard->Close();
+  auto reopened_shard = OpenSqliteDatabase(test_dir / "shard.db");
+  EXPECT_EQ(reopened_shard->NumMatchedImagePairs(), 1);
+  EXPECT_EQ(reopened_shard->NumVerifiedImagePairs(), 1);
+  EXPECT_EQ(reopened_shard->NumImages(), 0);
+}
+
+TEST(ShardDatabase, Reduce) {
+  const auto test_dir = CreateTestDir();
+  auto database = OpenSqliteDatabase(test_dir / "database.db");
+  const image_t image_id1 = WriteTestImage(*database, "image1");
+  const image_t image_id2 = WriteTestImage(*database, "image2");
+  const image_t image_id3 = WriteTestImage(*database, "image3");
+
+  auto shard1 = OpenShardDatabase(database, test_dir / "shard1.db");
+  shard1->WriteMatches(image_id1, image_id2, TestMatches(5));
+  shard1->WriteTwoViewGeometry(image_id1, image_id2, TestTwoViewGeometry(3));
+
+  auto shard2 = OpenShardDatabase(database, test_dir / "shard2.db");
+  shard2->WriteMatches(image_id3, image_id2, TestMatches(4));
+  shard2->WriteTwoViewGeometry(image_id3, image_id2, TestTwoViewGeometry(2));
+  shard2->WriteMatches(image_id1, image_id3, FeatureMatches());
+  shard2->WriteTwoViewGeometry(image_id1, image_id3, TestTwoViewGeometry(0));
+
+  for (int i = 0; i < 2; ++i) {
+    ReduceDatabaseShards({shard1.get(), shard2.get()}, database.get());
+    EXPECT_EQ(database->NumMatchedImagePairs(), 2);
+    EXPECT_EQ(database->NumVerifiedImagePairs(), 2);
+    EXPECT_EQ(database->NumMatches(), 9);
+    EXPECT_EQ(database->NumInlierMatches(), 5);
+    EXPECT_EQ(database->ReadMatches(image_id1, image_id2), TestMatches(5));
+    EXPECT_EQ(database->ReadMatches(image_id3, image_id2), TestMatches(4));
+    EXPECT_FALSE(database->ExistsMatches(image_id1, image_id3));
+    EXPECT_EQ(
+        database->ReadTwoViewGeometry(image_id3, image_id2).inlier_matches,
+        TestMatches(2));
+  }
+}
+
+}  // namespace
+}  // namespace colmap
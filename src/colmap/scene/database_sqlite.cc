@@ -28,15 +28,24 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "colmap/scene/database.h"
+#include "colmap/scene/database_blob_codec.h"
 #include "colmap/util/endian.h"
+#include "colmap/util/file.h"
 #include "colmap/util/string.h"
 #include "colmap/util/version.h"
 
+#include <functional>
+#include <memory>
+#include <optional>
+
 #include <sqlite3.h>
 
 namespace colmap {
 namespace {
 
+// Maximum time to wait for the write lock held by another connection.
+constexpr int kBusyTimeoutMs = 60000;
+
 inline int SQLite3CallHelper(int result_code,
                              const std::string& filename,
                              int line) {
@@ -77,74 +86,6 @@ struct Sqlite3StmtContext {
   sqlite3_stmt* sql_stmt_;
 };
 
-void SwapFeatureMatchesBlob(FeatureMatchesBlob* matches) {
-  for (Eigen::Index i = 0; i < matches->rows(); ++i) {
-    std::swap((*matches)(i, 0), (*matches)(i, 1));
-  }
-}
-
-FeatureKeypointsBlob FeatureKeypointsToBlob(const FeatureKeypoints& keypoints) {
-  const FeatureKeypointsBlob::Index kNumCols = 6;
-  FeatureKeypointsBlob blob(keypoints.size(), kNumCols);
-  for (size_t i = 0; i < keypoints.size(); ++i) {
-    blob(i, 0) = keypoints[i].x;
-    blob(i, 1) = keypoints[i].y;
-    blob(i, 2) = keypoints[i].a11;
-    blob(i, 3) = keypoints[i].a12;
-    blob(i, 4) = keypoints[i].a21;
-    blob(i, 5) = keypoints[i].a22;
-  }
-  return blob;
-}
-
-FeatureKeypoints FeatureKeypointsFromBlob(const FeatureKeypointsBlob& blob) {
-  FeatureKeypoints keypoints(static_cast<size_t>(blob.rows()));
-  if (blob.rows() == 0) {
-    return keypoints;
-  } else if (blob.cols() == 2) {
-    for (FeatureKeypointsBlob::Index i = 0; i < blob.rows(); ++i) {
-      keypoints[i] = FeatureKeypoint(blob(i, 0), blob(i, 1));
-    }
-  } else if (blob.cols() == 4) {
-    for (FeatureKeypointsBlob::Index i = 0; i < blob.rows(); ++i) {
-      keypoints[i] =
-          FeatureKeypoint(blob(i, 0), blob(i, 1), blob(i, 2), blob(i, 3));
-    }
-  } else if (blob.cols() == 6) {
-    for (FeatureKeypointsBlob::Index i = 0; i < blob.rows(); ++i) {
-      keypoints[i] = FeatureKeypoint(blob(i, 0),
-                                     blob(i, 1),
-                                     blob(i, 2),
-                                     blob(i, 3),
-                                     blob(i, 4),
-                                     blob(i, 5));
-    }
-  } else {
-    LOG(FATAL_THROW) << "Keypoint format not supported";
-  }
-  return keypoints;
-}
-
-FeatureMatchesBlob FeatureMatchesToBlob(const FeatureMatches& matches) {
-  const FeatureMatchesBlob::Index kNumCols = 2;
-  FeatureMatchesBlob blob(matches.size(), kNumCols);
-  for (size_t i = 0; i < matches.size(); ++i) {
-    blob(i, 0) = matches[i].point2D_idx1;
-    blob(i, 1) = matches[i].point2D_idx2;
-  }
-  return blob;
-}
-
-FeatureMatches FeatureMatchesFromBlob(const FeatureMatchesBlob& blob) {
-  THROW_CHECK_EQ(blob.cols(), 2);
-  FeatureMatches matches(static_cast<size_t>(blob.rows()));
-  for (FeatureMatchesBlob::Index i = 0; i < blob.rows(); ++i) {
-    matches[i].point2D_idx1 = blob(i, 0);
-    matches[i].point2D_idx2 = blob(i, 1);
-  }
-  return matches;
-}
-
 template <typename MatrixType>
 MatrixType ReadStaticMatrixBlob(sqlite3_stmt* sql_stmt,
                                 const int rc,
@@ -192,13 +133,22 @@ MatrixType ReadDynamicMatrixBlob(sqlite3_stmt* sql_stmt,
 
     const size_t num_bytes =
         static_cast<size_t>(sqlite3_column_bytes(sql_stmt, col + 2));
-    THROW_CHECK_EQ(matrix.size() * sizeof(typename MatrixType::Scalar),
-                   num_bytes);
-
-    if (num_bytes > 0) {
-      std::memcpy(reinterpret_cast<char*>(matrix.data()),
-                  sqlite3_column_blob(sql_stmt, col + 2),
-                  num_bytes);
+    const size_t raw_num_bytes =
+        matrix.size() * sizeof(typename MatrixType::Scalar);
+
+    if (num_bytes == raw_num_bytes) {
+      if (num_bytes > 0) {
+        std::memcpy(reinterpret_cast<char*>(matrix.data()),
+                    sqlite3_column_blob(sql_stmt, col + 2),
+                    num_bytes);
+      }
+    } else {
+      // Encoded BLOBs are always smaller than the raw data.
+      DecodeBlob(
+          reinterpret_cast<const char*>(sqlite3_column_blob(sql_stmt, col + 2)),
+          num_bytes,
+          reinterpret_cast<char*>(matrix.data()),
+          raw_num_bytes);
     }
   } else {
     const typename MatrixType::Index rows =
@@ -245,6 +195,33 @@ void WriteDynamicMatrixBlob(sqlite3_stmt* sql_stmt,
                                  SQLITE_STATIC));
 }
 
+// Write the matrix as an encoded BLOB, if the codec reduces its size, and
+// otherwise as a raw BLOB.
+template <typename MatrixType>
+void WriteEncodedDynamicMatrixBlob(sqlite3_stmt* sql_stmt,
+                                   const MatrixType& matrix,
+                                   const int col,
+                                   const BlobCodec codec,
+                                   const size_t codec_param) {
+  std::string encoded;
+  if (!EncodeBlob(codec,
+                  codec_param,
+                  reinterpret_cast<const char*>(matrix.data()),
+                  matrix.size() * sizeof(typename MatrixType::Scalar),
+                  &encoded)) {
+    WriteDynamicMatrixBlob(sql_stmt, matrix, col);
+    return;
+  }
+
+  SQLITE3_CALL(sqlite3_bind_int64(sql_stmt, col + 0, matrix.rows()));
+  SQLITE3_CALL(sqlite3_bind_int64(sql_stmt, col + 1, matrix.cols()));
+  SQLITE3_CALL(sqlite3_bind_blob(sql_stmt,
+                                 col + 2,
+                                 encoded.data(),
+                                 static_cast<int>(encoded.size()),
+                                 SQLITE_TRANSIENT));
+}
+
 std::optional<std::stringstream> BlobColumnToStringStream(
     sqlite3_stmt* sql_stmt, const int col) {
   const size_t num_bytes =
@@ -398,6 +375,60 @@ Image ReadImageRow(sqlite3_stmt* sql_stmt) {
   return image;
 }
 
+// Read a two-view geometry from all columns of the two_view_geometries table.
+TwoViewGeometry ReadTwoViewGeometryRow(sqlite3_stmt* sql_stmt) {
+  TwoViewGeometry two_view_geometry;
+
+  const FeatureMatchesBlob blob =
+      ReadDynamicMatrixBlob<FeatureMatchesBlob>(sql_stmt, SQLITE_ROW, 1);
+  two_view_geometry.inlier_matches = FeatureMatchesFromBlob(blob);
+
+  two_view_geometry.config =
+      static_cast<int>(sqlite3_column_int64(sql_stmt, 4));
+
+  // Read matrix data if present (NULL means not set).
+  if (sqlite3_column_type(sql_stmt, 5) != SQLITE_NULL) {
+    two_view_geometry.F =
+        ReadStaticMatrixBlob<Eigen::Matrix3d>(sql_stmt, SQLITE_ROW, 5);
+  }
+  if (sqlite3_column_type(sql_stmt, 6) != SQLITE_NULL) {
+    two_view_geometry.E =
+        ReadStaticMatrixBlob<Eigen::Matrix3d>(sql_stmt, SQLITE_ROW, 6);
+  }
+  if (sqlite3_column_type(sql_stmt, 7) != SQLITE_NULL) {
+    two_view_geometry.H =
+        ReadStaticMatrixBlob<Eigen::Matrix3d>(sql_stmt, SQLITE_ROW, 7);
+  }
+
+  // Read the pose data if present (NULL means not set).
+  const bool has_qvec = sqlite3_column_type(sql_stmt, 8) != SQLITE_NULL;
+  const bool has_tvec = sqlite3_column_type(sql_stmt, 9) != SQLITE_NULL;
+  THROW_CHECK_EQ(has_qvec, has_tvec)
+      << "qvec and tvec must both be NULL or both be non-NULL";
+  if (has_qvec) {
+    const Eigen::Vector4d quat_wxyz =
+        ReadStaticMatrixBlob<Eigen::Vector4d>(sql_stmt, SQLITE_ROW, 8);
+    Rigid3d cam2_from_cam1;
+    cam2_from_cam1.rotation() = Eigen::Quaterniond(
+        quat_wxyz(0), quat_wxyz(1), quat_wxyz(2), quat_wxyz(3));
+    cam2_from_cam1.translation() =
+        ReadStaticMatrixBlob<Eigen::Vector3d>(sql_stmt, SQLITE_ROW, 9);
+    two_view_geometry.cam2_from_cam1 = cam2_from_cam1;
+  }
+
+  if (two_view_geometry.F) {
+    two_view_geometry.F->transposeInPlace();
+  }
+  if (two_view_geometry.E) {
+    two_view_geometry.E->transposeInPlace();
+  }
+  if (two_view_geometry.H) {
+    two_view_geometry.H->transposeInPlace();
+  }
+
+  return two_view_geometry;
+}
+
 PosePrior ReadPosePriorRow(sqlite3_stmt* sql_stmt) {
   PosePrior pose_prior;
   pose_prior.pose_prior_id =
@@ -509,6 +540,10 @@ class SqliteDatabase : public Database {
       throw;
     }
 
+    // Wait for the write locks of other connections, e.g., of concurrently
+    // running pipeline stages, instead of failing immediately.
+    SQLITE3_CALL(sqlite3_busy_timeout(database->database_, kBusyTimeoutMs));
+
     // Don't wait for the operating system to write the changes to disk
     SQLITE3_EXEC(database->database_, "PRAGMA synchronous=OFF", nullptr);
 
@@ -532,6 +567,33 @@ class SqliteDatabase : public Database {
     return database;
   }
 
+  // Open an existing database as a read-only connection, which can be used
+  // concurrently with other connections in other threads. The schema is not
+  // migrated, so the database must have been opened for writing by the current
+  // version before.
+  static std::shared_ptr<Database> OpenReadOnly(
+      const std::filesystem::path& path) {
+    THROW_CHECK_FILE_EXISTS(path);
+
+    auto database = std::make_shared<SqliteDatabase>(path);
+
+    try {
+      SQLITE3_CALL(sqlite3_open_v2(PlatformToUTF8(path.string()).c_str(),
+                                   &database->database_,
+                                   SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX,
+                                   nullptr));
+    } catch (...) {
+      SQLITE3_CALL(sqlite3_close_v2(database->database_));
+      throw;
+    }
+
+    SQLITE3_EXEC(database->database_, "PRAGMA temp_store=MEMORY", nullptr);
+
+    database->PrepareSQLStatements();
+
+    return database;
+  }
+
   void CloseImpl() {
     if (database_ != nullptr) {
       FinalizeSQLStatements();
@@ -851,13 +913,62 @@ class SqliteDatabase : public Database {
     // Read feature type from column 3 (0-indexed after rows, cols, data).
     if (rc == SQLITE_ROW &&
         sqlite3_column_type(sql_stmt_read_descriptors_, 3) != SQLITE_NULL) {
-      descriptors.type = static_cast<FeatureExtractorType>(
-          sqlite3_column_int(sql_stmt_read_descriptors_, 3));
+      FeatureDescriptorsTypeFromInt(
+          sqlite3_column_int(sql_stmt_read_descriptors_, 3),
+          &descriptors.type,
+          &descriptors.precision);
     }
 
     return descriptors;
   }
 
+  std::optional<FeatureExtractionFingerprint> ReadFeatureExtractionFingerprint(
+      const image_t image_id) const override {
+    Sqlite3StmtContext context(sql_stmt_read_feature_extraction_fingerprint_);
+
+    SQLITE3_CALL(sqlite3_bind_int64(
+        sql_stmt_read_feature_extraction_fingerprint_, 1, image_id));
+
+    const int rc = SQLITE3_CALL(
+        sqlite3_step(sql_stmt_read_feature_extraction_fingerprint_));
+    if (rc != SQLITE_ROW) {
+      return std::nullopt;
+    }
+
+    // Unsigned values are stored as their signed 64-bit representation.
+    FeatureExtractionFingerprint fingerprint;
+    fingerprint.file_hash = static_cast<uint64_t>(sqlite3_column_int64(
+        sql_stmt_read_feature_extraction_fingerprint_, 0));
+    fingerprint.file_size = static_cast<uint64_t>(sqlite3_column_int64(
+        sql_stmt_read_feature_extraction_fingerprint_, 1));
+    fingerprint.file_mtime =
+        sqlite3_column_int64(sql_stmt_read_feature_extraction_fingerprint_, 2);
+    fingerprint.options_hash = static_cast<uint64_t>(sqlite3_column_int64(
+        sql_stmt_read_feature_extraction_fingerprint_, 3));
+    return fingerprint;
+  }
+
+  std::optional<GlobalImageDescriptor> ReadGlobalImageDescriptor(
+      const image_t image_id) const override {
+    Sqlite3StmtContext context(sql_stmt_read_global_image_descriptor_);
+
+    SQLITE3_CALL(sqlite3_bind_int64(
+        sql_stmt_read_global_image_descriptor_, 1, image_id));
+
+    const int rc =
+        SQLITE3_CALL(sqlite3_step(sql_stmt_read_global_image_descriptor_));
+    if (rc != SQLITE_ROW) {
+      return std::nullopt;
+    }
+
+    GlobalImageDescriptor descriptor;
+    descriptor.model_hash = static_cast<uint64_t>(
+        sqlite3_column_int64(sql_stmt_read_global_image_descriptor_, 0));
+    descriptor.data = ReadDynamicMatrixBlob<Eigen::VectorXf>(
+        sql_stmt_read_global_image_descriptor_, rc, 1);
+    return descriptor;
+  }
+
   FeatureMatchesBlob ReadMatchesBlob(image_t image_id1,
                                      image_t image_id2) const override {
     Sqlite3StmtContext context(sql_stmt_read_matches_);
@@ -1013,70 +1124,13 @@ class SqliteDatabase : public Database {
     std::vector<std::pair<image_pair_t, TwoViewGeometry>>
         all_two_view_geometries;
 
-    int rc;
-    while ((rc = SQLITE3_CALL(sqlite3_step(
-                sql_stmt_read_two_view_geometries_))) == SQLITE_ROW) {
+    while (SQLITE3_CALL(sqlite3_step(sql_stmt_read_two_view_geometries_)) ==
+           SQLITE_ROW) {
       const image_pair_t pair_id = static_cast<image_pair_t>(
           sqlite3_column_int64(sql_stmt_read_two_view_geometries_, 0));
 
-      TwoViewGeometry two_view_geometry;
-
-      const FeatureMatchesBlob blob = ReadDynamicMatrixBlob<FeatureMatchesBlob>(
-          sql_stmt_read_two_view_geometries_, rc, 1);
-      two_view_geometry.inlier_matches = FeatureMatchesFromBlob(blob);
-
-      two_view_geometry.config = static_cast<int>(
-          sqlite3_column_int64(sql_stmt_read_two_view_geometries_, 4));
-
-      // Read matrix data if present (NULL means not set).
-      if (sqlite3_column_type(sql_stmt_read_two_view_geometries_, 5) !=
-          SQLITE_NULL) {
-        two_view_geometry.F = ReadStaticMatrixBlob<Eigen::Matrix3d>(
-            sql_stmt_read_two_view_geometries_, rc, 5);
-      }
-      if (sqlite3_column_type(sql_stmt_read_two_view_geometries_, 6) !=
-          SQLITE_NULL) {
-        two_view_geometry.E = ReadStaticMatrixBlob<Eigen::Matrix3d>(
-            sql_stmt_read_two_view_geometries_, rc, 6);
-      }
-      if (sqlite3_column_type(sql_stmt_read_two_view_geometries_, 7) !=
-          SQLITE_NULL) {
-        two_view_geometry.H = ReadStaticMatrixBlob<Eigen::Matrix3d>(
-            sql_stmt_read_two_view_geometries_, rc, 7);
-      }
-
-      // Read the pose data if present (NULL means not set).
-      const bool has_qvec =
-          sqlite3_column_type(sql_stmt_read_two_view_geometries_, 8) !=
-          SQLITE_NULL;
-      const bool has_tvec =
-          sqlite3_column_type(sql_stmt_read_two_view_geometries_, 9) !=
-          SQLITE_NULL;
-      THROW_CHECK_EQ(has_qvec, has_tvec)
-          << "qvec and tvec must both be NULL or both be non-NULL";
-      if (has_qvec) {
-        const Eigen::Vector4d quat_wxyz = ReadStaticMatrixBlob<Eigen::Vector4d>(
-            sql_stmt_read_two_view_geometries_, rc, 8);
-        Rigid3d cam2_from_cam1;
-        cam2_from_cam1.rotation() = Eigen::Quaterniond(
-            quat_wxyz(0), quat_wxyz(1), quat_wxyz(2), quat_wxyz(3));
-        cam2_from_cam1.translation() = ReadStaticMatrixBlob<Eigen::Vector3d>(
-            sql_stmt_read_two_view_geometries_, rc, 9);
-        two_view_geometry.cam2_from_cam1 = cam2_from_cam1;
-      }
-
-      if (two_view_geometry.F) {
-        two_view_geometry.F->transposeInPlace();
-      }
-      if (two_view_geometry.E) {
-        two_view_geometry.E->transposeInPlace();
-      }
-      if (two_view_geometry.H) {
-        two_view_geometry.H->transposeInPlace();
-      }
-
-      all_two_view_geometries.emplace_back(pair_id,
-                                           std::move(two_view_geometry));
+      all_two_view_geometries.emplace_back(
+          pair_id, ReadTwoViewGeometryRow(sql_stmt_read_two_view_geometries_));
     }
 
     return all_two_view_geometries;
@@ -1101,6 +1155,92 @@ class SqliteDatabase : public Database {
     return num_inliers;
   }
 
+  std::vector<FeatureKeypoints> ReadKeypoints(
+      span<const image_t> image_ids) const override {
+    std::unordered_map<image_t, FeatureKeypointsBlob> blobs;
+    ReadRowsWithIds(
+        "SELECT image_id, rows, cols, data FROM keypoints WHERE image_id IN "
+        "(%s);",
+        image_ids,
+        [&blobs](sqlite3_stmt* sql_stmt) {
+          blobs.emplace(
+              static_cast<image_t>(sqlite3_column_int64(sql_stmt, 0)),
+              ReadDynamicMatrixBlob<FeatureKeypointsBlob>(
+                  sql_stmt, SQLITE_ROW, 1));
+        });
+
+    std::vector<FeatureKeypoints> keypoints;
+    keypoints.reserve(image_ids.size());
+    for (const image_t image_id : image_ids) {
+      const auto it = blobs.find(image_id);
+      if (it == blobs.end()) {
+        keypoints.emplace_back();
+      } else {
+        keypoints.push_back(FeatureKeypointsFromBlob(it->second));
+      }
+    }
+    return keypoints;
+  }
+
+  std::vector<FeatureDescriptors> ReadDescriptors(
+      span<const image_t> image_ids) const override {
+    std::unordered_map<image_t, FeatureDescriptors> all_descriptors;
+    ReadRowsWithIds(
+        "SELECT image_id, rows, cols, data, type FROM descriptors WHERE "
+        "image_id IN (%s);",
+        image_ids,
+        [&all_descriptors](sqlite3_stmt* sql_stmt) {
+          FeatureDescriptors descriptors;
+          descriptors.data = ReadDynamicMatrixBlob<FeatureDescriptorsData>(
+              sql_stmt, SQLITE_ROW, 1);
+          if (sqlite3_column_type(sql_stmt, 4) != SQLITE_NULL) {
+            FeatureDescriptorsTypeFromInt(sqlite3_column_int(sql_stmt, 4),
+                                          &descriptors.type,
+                                          &descriptors.precision);
+          }
+          all_descriptors.emplace(
+              static_cast<image_t>(sqlite3_column_int64(sql_stmt, 0)),
+              std::move(descriptors));
+        });
+
+    std::vector<FeatureDescriptors> descriptors;
+    descriptors.reserve(image_ids.size());
+    for (const image_t image_id : image_ids) {
+      const auto it = all_descriptors.find(image_id);
+      if (it == all_descriptors.end()) {
+        descriptors.emplace_back();
+      } else {
+        descriptors.push_back(it->second);
+      }
+    }
+    return descriptors;
+  }
+
+  std::vector<TwoViewGeometry> ReadTwoViewGeometries(
+      span<const image_pair_t> pair_ids) const override {
+    std::unordered_map<image_pair_t, TwoViewGeometry> all_two_view_geometries;
+    ReadRowsWithIds(
+        "SELECT * FROM two_view_geometries WHERE pair_id IN (%s);",
+        pair_ids,
+        [&all_two_view_geometries](sqlite3_stmt* sql_stmt) {
+          all_two_view_geometries.emplace(
+              static_cast<image_pair_t>(sqlite3_column_int64(sql_stmt, 0)),
+              ReadTwoViewGeometryRow(sql_stmt));
+        });
+
+    std::vector<TwoViewGeometry> two_view_geometries;
+    two_view_geometries.reserve(pair_ids.size());
+    for (const image_pair_t pair_id : pair_ids) {
+      const auto it = all_two_view_geometries.find(pair_id);
+      if (it == all_two_view_geometries.end()) {
+        two_view_geometries.emplace_back();
+      } else {
+        two_view_geometries.push_back(it->second);
+      }
+    }
+    return two_view_geometries;
+  }
+
   rig_t WriteRig(const Rig& rig, const bool use_rig_id) override {
     THROW_CHECK(rig.NumSensors() > 0) << "Rig must have at least one sensor";
 
@@ -1193,6 +1333,17 @@ class SqliteDatabase : public Database {
     return frame_id;
   }
 
+  std::vector<frame_t> WriteFrames(span<const Frame> frames,
+                                   const bool use_frame_ids) override {
+    // Unless the caller already started a transaction, write all frames in
+    // one transaction instead of committing each insert separately.
+    std::optional<DatabaseTransaction> transaction;
+    if (sqlite3_get_autocommit(THROW_CHECK_NOTNULL(database_))) {
+      transaction.emplace(this);
+    }
+    return Database::WriteFrames(frames, use_frame_ids);
+  }
+
   image_t WriteImage(const Image& image, const bool use_image_id) override {
     if (image.HasFrameId()) {
       const Frame frame = ReadFrame(image.FrameId());
@@ -1259,6 +1410,18 @@ class SqliteDatabase : public Database {
         sqlite3_last_insert_rowid(THROW_CHECK_NOTNULL(database_)));
   }
 
+  std::vector<pose_prior_t> WritePosePriors(
+      span<const PosePrior> pose_priors,
+      const bool use_pose_prior_ids) override {
+    // Unless the caller already started a transaction, write all pose priors
+    // in one transaction instead of committing each insert separately.
+    std::optional<DatabaseTransaction> transaction;
+    if (sqlite3_get_autocommit(THROW_CHECK_NOTNULL(database_))) {
+      transaction.emplace(this);
+    }
+    return Database::WritePosePriors(pose_priors, use_pose_prior_ids);
+  }
+
   void WriteKeypoints(const image_t image_id,
                       const FeatureKeypoints& keypoints) override {
     WriteKeypoints(image_id, FeatureKeypointsToBlob(keypoints));
@@ -1279,13 +1442,70 @@ class SqliteDatabase : public Database {
     Sqlite3StmtContext context(sql_stmt_write_descriptors_);
 
     SQLITE3_CALL(sqlite3_bind_int64(sql_stmt_write_descriptors_, 1, image_id));
-    WriteDynamicMatrixBlob(sql_stmt_write_descriptors_, descriptors.data, 2);
+    if (blob_compression_) {
+      WriteEncodedDynamicMatrixBlob(sql_stmt_write_descriptors_,
+                                    descriptors.data,
+                                    2,
+                                    BlobCodec::BYTE_PLANE,
+                                    FeatureDescriptorsElementSize(
+                                        descriptors.type,
+                                        descriptors.precision));
+    } else {
+      WriteDynamicMatrixBlob(sql_stmt_write_descriptors_, descriptors.data, 2);
+    }
     SQLITE3_CALL(sqlite3_bind_int(
-        sql_stmt_write_descriptors_, 5, static_cast<int>(descriptors.type)));
+        sql_stmt_write_descriptors_,
+        5,
+        FeatureDescriptorsTypeToInt(descriptors.type, descriptors.precision)));
 
     SQLITE3_CALL(sqlite3_step(sql_stmt_write_descriptors_));
   }
 
+  void WriteFeatureExtractionFingerprint(
+      const image_t image_id,
+      const FeatureExtractionFingerprint& fingerprint) override {
+    Sqlite3StmtContext context(sql_stmt_write_feature_extraction_fingerprint_);
+
+    SQLITE3_CALL(sqlite3_bind_int64(
+        sql_stmt_write_feature_extraction_fingerprint_, 1, image_id));
+    SQLITE3_CALL(
+        sqlite3_bind_int64(sql_stmt_write_feature_extraction_fingerprint_,
+                           2,
+                           static_cast<sqlite3_int64>(fingerprint.file_hash)));
+    SQLITE3_CALL(
+        sqlite3_bind_int64(sql_stmt_write_feature_extraction_fingerprint_,
+                           3,
+                           static_cast<sqlite3_int64>(fingerprint.file_size)));
+    SQLITE3_CALL(
+        sqlite3_bind_int64(sql_stmt_write_feature_extraction_fingerprint_,
+                           4,
+                           fingerprint.file_mtime));
+    SQLITE3_CALL(sqlite3_bind_int64(
+        sql_stmt_write_feature_extraction_fingerprint_,
+        5,
+        static_cast<sqlite3_int64>(fingerprint.options_hash)));
+
+    SQLITE3_CALL(
+        sqlite3_step(sql_stmt_write_feature_extraction_fingerprint_));
+  }
+
+  void WriteGlobalImageDescriptor(
+      const image_t image_id,
+      const GlobalImageDescriptor& descriptor) override {
+    Sqlite3StmtContext context(sql_stmt_write_global_image_descriptor_);
+
+    SQLITE3_CALL(sqlite3_bind_int64(
+        sql_stmt_write_global_image_descriptor_, 1, image_id));
+    SQLITE3_CALL(
+        sqlite3_bind_int64(sql_stmt_write_global_image_descriptor_,
+                           2,
+                           static_cast<sqlite3_int64>(descriptor.model_hash)));
+    WriteDynamicMatrixBlob(
+        sql_stmt_write_global_image_descriptor_, descriptor.data, 3);
+
+    SQLITE3_CALL(sqlite3_step(sql_stmt_write_global_image_descriptor_));
+  }
+
   void WriteMatches(const image_t image_id1,
                     const image_t image_id2,
                     const FeatureMatches& matches) override {
@@ -1305,9 +1525,9 @@ class SqliteDatabase : public Database {
     if (ShouldSwapImagePair(image_id1, image_id2)) {
       swapped_blob = blob;
       SwapFeatureMatchesBlob(&swapped_blob);
-      WriteDynamicMatrixBlob(sql_stmt_write_matches_, swapped_blob, 2);
+      WriteMatchesBlob(sql_stmt_write_matches_, swapped_blob, 2);
     } else {
-      WriteDynamicMatrixBlob(sql_stmt_write_matches_, blob, 2);
+      WriteMatchesBlob(sql_stmt_write_matches_, blob, 2);
     }
 
     SQLITE3_CALL(sqlite3_step(sql_stmt_write_matches_));
@@ -1338,8 +1558,7 @@ class SqliteDatabase : public Database {
 
     const FeatureMatchesBlob inlier_matches =
         FeatureMatchesToBlob(two_view_geometry_ptr->inlier_matches);
-    WriteDynamicMatrixBlob(
-        sql_stmt_write_two_view_geometry_, inlier_matches, 2);
+    WriteMatchesBlob(sql_stmt_write_two_view_geometry_, inlier_matches, 2);
 
     SQLITE3_CALL(sqlite3_bind_int64(
         sql_stmt_write_two_view_geometry_, 5, two_view_geometry_ptr->config));
@@ -1528,6 +1747,30 @@ class SqliteDatabase : public Database {
     SQLITE3_CALL(sqlite3_step(sql_stmt_update_keypoints_));
   }
 
+  void UpdateDescriptors(const image_t image_id,
+                         const FeatureDescriptors& descriptors) override {
+    Sqlite3StmtContext context(sql_stmt_update_descriptors_);
+
+    if (blob_compression_) {
+      WriteEncodedDynamicMatrixBlob(sql_stmt_update_descriptors_,
+                                    descriptors.data,
+                                    1,
+                                    BlobCodec::BYTE_PLANE,
+                                    FeatureDescriptorsElementSize(
+                                        descriptors.type,
+                                        descriptors.precision));
+    } else {
+      WriteDynamicMatrixBlob(sql_stmt_update_descriptors_, descriptors.data, 1);
+    }
+    SQLITE3_CALL(sqlite3_bind_int(
+        sql_stmt_update_descriptors_,
+        4,
+        FeatureDescriptorsTypeToInt(descriptors.type, descriptors.precision)));
+    SQLITE3_CALL(sqlite3_bind_int64(sql_stmt_update_descriptors_, 5, image_id));
+
+    SQLITE3_CALL(sqlite3_step(sql_stmt_update_descriptors_));
+  }
+
   void UpdateTwoViewGeometry(
       const image_t image_id1,
       const image_t image_id2,
@@ -1647,6 +1890,21 @@ class SqliteDatabase : public Database {
     SQLITE3_EXEC(THROW_CHECK_NOTNULL(database_), "END TRANSACTION", nullptr);
   }
 
+  void SetBlobCompression(const bool enabled) override {
+    blob_compression_ = enabled;
+  }
+
+  void WriteMatchesBlob(sqlite3_stmt* sql_stmt,
+                        const FeatureMatchesBlob& blob,
+                        const int col) const {
+    if (blob_compression_) {
+      WriteEncodedDynamicMatrixBlob(
+          sql_stmt, blob, col, BlobCodec::DELTA_VARINT, blob.cols());
+    } else {
+      WriteDynamicMatrixBlob(sql_stmt, blob, col);
+    }
+  }
+
   void PrepareSQLStatements() {
     sql_stmts_.clear();
 
@@ -1712,6 +1970,10 @@ class SqliteDatabase : public Database {
     prepare_sql_stmt(
         "UPDATE keypoints SET rows=?, cols=?, data=? WHERE image_id=?;",
         &sql_stmt_update_keypoints_);
+    prepare_sql_stmt(
+        "UPDATE descriptors SET rows=?, cols=?, data=?, type=? "
+        "WHERE image_id=?;",
+        &sql_stmt_update_descriptors_);
 
     //////////////////////////////////////////////////////////////////////////////
     // read_*
@@ -1794,6 +2056,14 @@ class SqliteDatabase : public Database {
         "SELECT rows, cols, data, type FROM descriptors WHERE "
         "image_id = ?;",
         &sql_stmt_read_descriptors_);
+    prepare_sql_stmt(
+        "SELECT file_hash, file_size, file_mtime, options_hash FROM "
+        "feature_extraction_fingerprints WHERE image_id = ?;",
+        &sql_stmt_read_feature_extraction_fingerprint_);
+    prepare_sql_stmt(
+        "SELECT model_hash, rows, cols, data FROM global_image_descriptors "
+        "WHERE image_id = ?;",
+        &sql_stmt_read_global_image_descriptor_);
     prepare_sql_stmt("SELECT rows, cols, data FROM matches WHERE pair_id = ?;",
                      &sql_stmt_read_matches_);
     prepare_sql_stmt("SELECT * FROM matches WHERE rows > 0;",
@@ -1849,6 +2119,15 @@ class SqliteDatabase : public Database {
         "INSERT INTO descriptors(image_id, rows, cols, data, type) "
         "VALUES(?, ?, ?, ?, ?);",
         &sql_stmt_write_descriptors_);
+    prepare_sql_stmt(
+        "INSERT OR REPLACE INTO feature_extraction_fingerprints(image_id, "
+        "file_hash, file_size, file_mtime, options_hash) "
+        "VALUES(?, ?, ?, ?, ?);",
+        &sql_stmt_write_feature_extraction_fingerprint_);
+    prepare_sql_stmt(
+        "INSERT OR REPLACE INTO global_image_descriptors(image_id, "
+        "model_hash, rows, cols, data) VALUES(?, ?, ?, ?, ?);",
+        &sql_stmt_write_global_image_descriptor_);
     prepare_sql_stmt(
         "INSERT INTO matches(pair_id, rows, cols, data) VALUES(?, ?, "
         "?, ?);",
@@ -1904,6 +2183,8 @@ class SqliteDatabase : public Database {
     CreatePosePriorTable();
     CreateKeypointsTable();
     CreateDescriptorsTable();
+    CreateFeatureExtractionFingerprintsTable();
+    CreateGlobalImageDescriptorsTable();
     CreateMatchesTable();
     CreateTwoViewGeometriesTable();
   }
@@ -2032,6 +2313,34 @@ class SqliteDatabase : public Database {
     SQLITE3_EXEC(database_, sql.c_str(), nullptr);
   }
 
+  void CreateFeatureExtractionFingerprintsTable() const {
+    const std::string sql =
+        "CREATE TABLE IF NOT EXISTS feature_extraction_fingerprints"
+        "   (image_id      INTEGER  PRIMARY KEY  NOT NULL,"
+        "    file_hash     INTEGER               NOT NULL,"
+        "    file_size     INTEGER               NOT NULL,"
+        "    file_mtime    INTEGER               NOT NULL,"
+        "    options_hash  INTEGER               NOT NULL,"
+        "    FOREIGN KEY(image_id) REFERENCES images(image_id) ON DELETE "
+        "CASCADE);";
+
+    SQLITE3_EXEC(database_, sql.c_str(), nullptr);
+  }
+
+  void CreateGlobalImageDescriptorsTable() const {
+    const std::string sql =
+        "CREATE TABLE IF NOT EXISTS global_image_descriptors"
+        "   (image_id    INTEGER  PRIMARY KEY  NOT NULL,"
+        "    model_hash  INTEGER               NOT NULL,"
+        "    rows        INTEGER               NOT NULL,"
+        "    cols        INTEGER               NOT NULL,"
+        "    data        BLOB,"
+        "    FOREIGN KEY(image_id) REFERENCES images(image_id) ON DELETE "
+        "CASCADE);";
+
+    SQLITE3_EXEC(database_, sql.c_str(), nullptr);
+  }
+
   void CreateMatchesTable() const {
     const std::string sql =
         "CREATE TABLE IF NOT EXISTS matches"
@@ -2274,6 +2583,10 @@ class SqliteDatabase : public Database {
                    nullptr);
     }
 
+    // Since version 4.2.0.1, descriptor and match BLOBs can be encoded with a
+    // self-described codec, if enabled with `SetBlobCompression`. The raw
+    // BLOBs of older databases remain valid, so existing rows are not touched.
+
     // Update user version number.
     std::unique_lock<std::mutex> lock(update_schema_mutex_);
     const std::string update_user_version_sql =
@@ -2326,6 +2639,44 @@ class SqliteDatabase : public Database {
     return exists_column;
   }
 
+  // Execute the query for the given identifiers in batches, where the query
+  // contains a single "%s" placeholder for the list of bound identifiers. The
+  // batch size stays below the default SQLITE_MAX_VARIABLE_NUMBER of older
+  // SQLite versions.
+  template <typename T>
+  void ReadRowsWithIds(
+      const std::string& sql_format,
+      const span<const T>& ids,
+      const std::function<void(sqlite3_stmt*)>& read_row) const {
+    constexpr size_t kMaxBatchSize = 999;
+    for (size_t begin = 0; begin < ids.size(); begin += kMaxBatchSize) {
+      const size_t end = std::min(ids.size(), begin + kMaxBatchSize);
+
+      std::string placeholders;
+      placeholders.reserve(2 * (end - begin));
+      for (size_t i = begin; i < end; ++i) {
+        placeholders += i == begin ? "?" : ",?";
+      }
+      const std::string sql =
+          StringPrintf(sql_format.c_str(), placeholders.c_str());
+
+      sqlite3_stmt* sql_stmt;
+      SQLITE3_CALL(sqlite3_prepare_v2(
+          THROW_CHECK_NOTNULL(database_), sql.c_str(), -1, &sql_stmt, 0));
+      std::unique_ptr<sqlite3_stmt, int (*)(sqlite3_stmt*)> sql_stmt_guard(
+          sql_stmt, &sqlite3_finalize);
+
+      for (size_t i = begin; i < end; ++i) {
+        SQLITE3_CALL(sqlite3_bind_int64(
+            sql_stmt, i - begin + 1, static_cast<sqlite3_int64>(ids[i])));
+      }
+
+      while (SQLITE3_CALL(sqlite3_step(sql_stmt)) == SQLITE_ROW) {
+        read_row(sql_stmt);
+      }
+    }
+  }
+
   bool ExistsRowId(sqlite3_stmt* sql_stmt, const sqlite3_int64 row_id) const {
     Sqlite3StmtContext context(sql_stmt);
     SQLITE3_CALL(
@@ -2419,6 +2770,9 @@ class SqliteDatabase : public Database {
   // the VACUUM command in such case
   mutable bool database_entry_deleted_ = false;
 
+  // Whether to write descriptors and matches as encoded BLOBs.
+  bool blob_compression_ = false;
+
   // Ensure that only one database object at a time updates the schema of a
   // database. Since the schema is updated every time a database is opened, this
   // is to ensure that there are no race conditions ("database locked" error
@@ -2452,6 +2806,7 @@ class SqliteDatabase : public Database {
   sqlite3_stmt* sql_stmt_update_image_ = nullptr;
   sqlite3_stmt* sql_stmt_update_pose_prior_ = nullptr;
   sqlite3_stmt* sql_stmt_update_keypoints_ = nullptr;
+  sqlite3_stmt* sql_stmt_update_descriptors_ = nullptr;
 
   // read_*
   sqlite3_stmt* sql_stmt_read_rig_ = nullptr;
@@ -2469,6 +2824,8 @@ class SqliteDatabase : public Database {
   sqlite3_stmt* sql_stmt_read_pose_priors_ = nullptr;
   sqlite3_stmt* sql_stmt_read_keypoints_ = nullptr;
   sqlite3_stmt* sql_stmt_read_descriptors_ = nullptr;
+  sqlite3_stmt* sql_stmt_read_feature_extraction_fingerprint_ = nullptr;
+  sqlite3_stmt* sql_stmt_read_global_image_descriptor_ = nullptr;
   sqlite3_stmt* sql_stmt_read_matches_ = nullptr;
   sqlite3_stmt* sql_stmt_read_matches_all_ = nullptr;
   sqlite3_stmt* sql_stmt_read_num_matches_ = nullptr;
@@ -2486,6 +2843,8 @@ class SqliteDatabase : public Database {
   sqlite3_stmt* sql_stmt_write_pose_prior_ = nullptr;
   sqlite3_stmt* sql_stmt_write_keypoints_ = nullptr;
   sqlite3_stmt* sql_stmt_write_descriptors_ = nullptr;
+  sqlite3_stmt* sql_stmt_write_feature_extraction_fingerprint_ = nullptr;
+  sqlite3_stmt* sql_stmt_write_global_image_descriptor_ = nullptr;
   sqlite3_stmt* sql_stmt_write_matches_ = nullptr;
   sqlite3_stmt* sql_stmt_write_two_view_geometry_ = nullptr;
 
@@ -2516,4 +2875,9 @@ std::shared_ptr<Database> OpenSqliteDatabase(
   return SqliteDatabase::Open(path);
 }
 
+std::shared_ptr<Database> OpenReadOnlySqliteDatabase(
+    const std::filesystem::path& path) {
+  return SqliteDatabase::OpenReadOnly(path);
+}
+
 }  // namespace colmap
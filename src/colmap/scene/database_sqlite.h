@@ -42,4 +42,11 @@ constexpr inline char kInMemorySqliteDatabasePath[] = ":memory:";
 
 std::shared_ptr<Database> OpenSqliteDatabase(const std::filesystem::path& path);
 
+// Open a read-only connection to an existing SQLite database. In contrast to
+// `OpenSqliteDatabase`, the schema is not migrated and multiple read-only
+// connections can read concurrently from different threads, while another
+// connection writes to the database.
+std::shared_ptr<Database> OpenReadOnlySqliteDatabase(
+    const std::filesystem::path& path);
+
 }  // namespace colmap
@@ -29,11 +29,13 @@
 
 #include "colmap/scene/database.h"
 
+#include "colmap/scene/database_mmap.h"
 #include "colmap/scene/database_sqlite.h"
 #include "colmap/util/eigen_alignment.h"
 #include "colmap/util/file.h"
 #include "colmap/util/testing.h"
 
+#include <atomic>
 #include <filesystem>
 #include <thread>
 
@@ -237,6 +239,42 @@ TEST_P(ParameterizedDatabaseTests, Frame) {
   EXPECT_EQ(database->NumFrames(), 0);
 }
 
+TEST_P(ParameterizedDatabaseTests, WriteFrames) {
+  std::shared_ptr<Database> database = GetParam()(kInMemorySqliteDatabasePath);
+  Rig rig;
+  rig.AddRefSensor(sensor_t(SensorType::CAMERA, 1));
+  rig.SetRigId(database->WriteRig(rig));
+
+  std::vector<Frame> frames(3);
+  for (size_t i = 0; i < frames.size(); ++i) {
+    frames[i].SetRigId(rig.RigId());
+    frames[i].AddDataId(data_t(sensor_t(SensorType::CAMERA, 1), i + 1));
+  }
+  const std::vector<frame_t> frame_ids =
+      database->WriteFrames({frames.data(), frames.size()});
+  ASSERT_EQ(frame_ids.size(), frames.size());
+  for (size_t i = 0; i < frames.size(); ++i) {
+    frames[i].SetFrameId(frame_ids[i]);
+    EXPECT_EQ(database->ReadFrame(frame_ids[i]), frames[i]);
+  }
+  EXPECT_EQ(database->NumFrames(), frames.size());
+  EXPECT_ANY_THROW(database->WriteFrames({frames.data(), frames.size()},
+                                         /*use_frame_ids=*/true));
+
+  // Batched writes within an existing transaction.
+  database->ClearFrames();
+  {
+    DatabaseTransaction transaction(database.get());
+    EXPECT_EQ(database
+                  ->WriteFrames({frames.data(), frames.size()},
+                                /*use_frame_ids=*/true)
+                  .size(),
+              frames.size());
+  }
+  EXPECT_THAT(database->ReadAllFrames(),
+              testing::UnorderedElementsAreArray(frames));
+}
+
 TEST_P(ParameterizedDatabaseTests, Image) {
   std::shared_ptr<Database> database = GetParam()(kInMemorySqliteDatabasePath);
   Camera camera = Camera::CreateFromModelId(
@@ -307,6 +345,39 @@ TEST_P(ParameterizedDatabaseTests, PosePrior) {
   EXPECT_EQ(database->NumPosePriors(), 0);
 }
 
+TEST_P(ParameterizedDatabaseTests, PosePriors) {
+  std::shared_ptr<Database> database = GetParam()(kInMemorySqliteDatabasePath);
+  std::vector<PosePrior> pose_priors(3);
+  for (size_t i = 0; i < pose_priors.size(); ++i) {
+    pose_priors[i].corr_data_id.id = i + 1;
+    pose_priors[i].position = Eigen::Vector3d::Random();
+    pose_priors[i].coordinate_system = PosePrior::CoordinateSystem::WGS84;
+  }
+  const std::vector<pose_prior_t> pose_prior_ids =
+      database->WritePosePriors({pose_priors.data(), pose_priors.size()});
+  ASSERT_EQ(pose_prior_ids.size(), pose_priors.size());
+  for (size_t i = 0; i < pose_priors.size(); ++i) {
+    pose_priors[i].pose_prior_id = pose_prior_ids[i];
+  }
+  EXPECT_THAT(database->ReadAllPosePriors(),
+              testing::UnorderedElementsAreArray(pose_priors));
+  EXPECT_ANY_THROW(database->WritePosePriors(
+      {pose_priors.data(), pose_priors.size()}, /*use_pose_prior_ids=*/true));
+
+  // Batched writes within an existing transaction.
+  database->ClearPosePriors();
+  {
+    DatabaseTransaction transaction(database.get());
+    EXPECT_EQ(database
+                  ->WritePosePriors({pose_priors.data(), pose_priors.size()},
+                                    /*use_pose_prior_ids=*/true)
+                  .size(),
+              pose_priors.size());
+  }
+  EXPECT_THAT(database->ReadAllPosePriors(),
+              testing::UnorderedElementsAreArray(pose_priors));
+}
+
 TEST_P(ParameterizedDatabaseTests, Keypoints) {
   std::shared_ptr<Database> database = GetParam()(kInMemorySqliteDatabasePath);
   Camera camera;
@@ -430,6 +501,109 @@ TEST_P(ParameterizedDatabaseTests, DescriptorFeatureTypeDefault) {
   EXPECT_EQ(descriptors_sift_read.type, FeatureExtractorType::SIFT);
 }
 
+TEST_P(ParameterizedDatabaseTests, DescriptorPrecision) {
+  std::shared_ptr<Database> database = GetParam()(kInMemorySqliteDatabasePath);
+  Camera camera;
+  camera.camera_id = database->WriteCamera(camera);
+  Image image;
+  image.SetCameraId(camera.camera_id);
+  const FeatureDescriptorsFloatData float_data =
+      FeatureDescriptorsFloatData::Random(10, 128);
+  for (const FeatureDescriptorPrecision precision :
+       {FeatureDescriptorPrecision::NATIVE,
+        FeatureDescriptorPrecision::FLOAT16,
+        FeatureDescriptorPrecision::INT8}) {
+    image.SetName(
+        std::string(FeatureDescriptorPrecisionToString(precision)));
+    image.SetImageId(database->WriteImage(image));
+    const FeatureDescriptors descriptors =
+        FeatureDescriptorsFloat(
+            FeatureExtractorType::ALIKED_N32, float_data, precision)
+            .ToBytes();
+    EXPECT_EQ(descriptors.NumDims(), 128);
+    database->WriteDescriptors(image.ImageId(), descriptors);
+    const FeatureDescriptors descriptors_read =
+        database->ReadDescriptors(image.ImageId());
+    EXPECT_EQ(descriptors_read.type, FeatureExtractorType::ALIKED_N32);
+    EXPECT_EQ(descriptors_read.precision, precision);
+    EXPECT_EQ(descriptors_read.data, descriptors.data);
+  }
+}
+
+TEST_P(ParameterizedDatabaseTests, UpdateDescriptors) {
+  std::shared_ptr<Database> database = GetParam()(kInMemorySqliteDatabasePath);
+  Camera camera;
+  camera.camera_id = database->WriteCamera(camera);
+  Image image;
+  image.SetName("test");
+  image.SetCameraId(camera.camera_id);
+  image.SetImageId(database->WriteImage(image));
+  database->WriteDescriptors(
+      image.ImageId(),
+      FeatureDescriptors(FeatureExtractorType::SIFT,
+                         FeatureDescriptorsData::Random(10, 128)));
+  const FeatureDescriptors descriptors(FeatureExtractorType::ALIKED_N16ROT,
+                                       FeatureDescriptorsData::Random(20, 64));
+  database->UpdateDescriptors(image.ImageId(), descriptors);
+  const FeatureDescriptors descriptors_read =
+      database->ReadDescriptors(image.ImageId());
+  EXPECT_EQ(descriptors_read.type, descriptors.type);
+  EXPECT_EQ(descriptors_read.data, descriptors.data);
+  EXPECT_EQ(database->NumDescriptors(), 20);
+  EXPECT_EQ(database->NumDescriptorsForImage(image.ImageId()), 20);
+}
+
+TEST_P(ParameterizedDatabaseTests, FeatureExtractionFingerprint) {
+  std::shared_ptr<Database> database = GetParam()(kInMemorySqliteDatabasePath);
+  Camera camera;
+  camera.camera_id = database->WriteCamera(camera);
+  Image image;
+  image.SetName("test");
+  image.SetCameraId(camera.camera_id);
+  image.SetImageId(database->WriteImage(image));
+  EXPECT_FALSE(
+      database->ReadFeatureExtractionFingerprint(image.ImageId()).has_value());
+  FeatureExtractionFingerprint fingerprint;
+  fingerprint.file_hash = std::numeric_limits<uint64_t>::max();
+  fingerprint.file_size = 2;
+  fingerprint.file_mtime = -3;
+  fingerprint.options_hash = 4;
+  database->WriteFeatureExtractionFingerprint(image.ImageId(), fingerprint);
+  EXPECT_EQ(database->ReadFeatureExtractionFingerprint(image.ImageId()),
+            fingerprint);
+  fingerprint.file_mtime = 5;
+  database->WriteFeatureExtractionFingerprint(image.ImageId(), fingerprint);
+  EXPECT_EQ(database->ReadFeatureExtractionFingerprint(image.ImageId()),
+            fingerprint);
+  database->ClearImages();
+  EXPECT_FALSE(
+      database->ReadFeatureExtractionFingerprint(image.ImageId()).has_value());
+}
+
+TEST_P(ParameterizedDatabaseTests, GlobalImageDescriptor) {
+  std::shared_ptr<Database> database = GetParam()(kInMemorySqliteDatabasePath);
+  Camera camera;
+  camera.camera_id = database->WriteCamera(camera);
+  Image image;
+  image.SetName("test");
+  image.SetCameraId(camera.camera_id);
+  image.SetImageId(database->WriteImage(image));
+  EXPECT_FALSE(
+      database->ReadGlobalImageDescriptor(image.ImageId()).has_value());
+  GlobalImageDescriptor descriptor;
+  descriptor.model_hash = std::numeric_limits<uint64_t>::max();
+  descriptor.data = Eigen::VectorXf::Random(64);
+  database->WriteGlobalImageDescriptor(image.ImageId(), descriptor);
+  EXPECT_EQ(database->ReadGlobalImageDescriptor(image.ImageId()), descriptor);
+  descriptor.model_hash = 2;
+  descriptor.data = Eigen::VectorXf::Random(32);
+  database->WriteGlobalImageDescriptor(image.ImageId(), descriptor);
+  EXPECT_EQ(database->ReadGlobalImageDescriptor(image.ImageId()), descriptor);
+  database->ClearImages();
+  EXPECT_FALSE(
+      database->ReadGlobalImageDescriptor(image.ImageId()).has_value());
+}
+
 TEST_P(ParameterizedDatabaseTests, Matches) {
   std::shared_ptr<Database> database = GetParam()(kInMemorySqliteDatabasePath);
   const image_t image_id1 = 1;
@@ -611,6 +785,140 @@ TEST_P(ParameterizedDatabaseTests, TwoViewGeometry) {
   EXPECT_FALSE(two_view_geometry_no_h_read.H.has_value());
 }
 
+TEST_P(ParameterizedDatabaseTests, BlobCompression) {
+  std::shared_ptr<Database> database = GetParam()(kInMemorySqliteDatabasePath);
+  Camera camera = Camera::CreateFromModelId(
+      kInvalidCameraId, CameraModelId::kSimplePinhole, 1.0, 1, 1);
+  camera.camera_id = database->WriteCamera(camera);
+
+  FeatureDescriptors sift_descriptors(FeatureExtractorType::SIFT,
+                                      FeatureDescriptorsData::Zero(100, 128));
+  sift_descriptors.data.col(3).setConstant(17);
+  FeatureDescriptorsFloatData aliked_data =
+      FeatureDescriptorsFloatData::Zero(100, 128);
+  aliked_data.col(5).setConstant(0.5f);
+  const FeatureDescriptors aliked_descriptors = FeatureDescriptors::FromFloat(
+      FeatureDescriptorsFloat(FeatureExtractorType::ALIKED_N32, aliked_data));
+  const FeatureDescriptors random_descriptors(
+      FeatureExtractorType::SIFT, FeatureDescriptorsData::Random(10, 128));
+
+  FeatureMatches matches(1000);
+  for (size_t i = 0; i < matches.size(); ++i) {
+    matches[i].point2D_idx1 = 2 * i;
+    matches[i].point2D_idx2 = (7919 * i) % 5000;
+  }
+  TwoViewGeometry two_view_geometry;
+  two_view_geometry.config = TwoViewGeometry::CALIBRATED;
+  two_view_geometry.inlier_matches = matches;
+
+  std::vector<image_t> image_ids;
+  for (int i = 0; i < 6; ++i) {
+    Image image;
+    image.SetName("image" + std::to_string(i));
+    image.SetCameraId(camera.camera_id);
+    image_ids.push_back(database->WriteImage(image));
+  }
+
+  // Mix raw and encoded BLOBs in the same database.
+  for (const bool compress : {false, true}) {
+    database->SetBlobCompression(compress);
+    const image_t image_id1 = image_ids[compress ? 3 : 0];
+    const image_t image_id2 = image_ids[compress ? 4 : 1];
+    const image_t image_id3 = image_ids[compress ? 5 : 2];
+    database->WriteDescriptors(image_id1, sift_descriptors);
+    database->WriteDescriptors(image_id2, aliked_descriptors);
+    database->WriteDescriptors(image_id3, random_descriptors);
+    database->WriteMatches(image_id2, image_id1, matches);
+    database->WriteTwoViewGeometry(image_id2, image_id1, two_view_geometry);
+  }
+
+  for (const bool compress : {false, true}) {
+    const image_t image_id1 = image_ids[compress ? 3 : 0];
+    const image_t image_id2 = image_ids[compress ? 4 : 1];
+    const image_t image_id3 = image_ids[compress ? 5 : 2];
+    EXPECT_EQ(database->ReadDescriptors(image_id1).data, sift_descriptors.data);
+    EXPECT_EQ(database->ReadDescriptors(image_id2).data,
+              aliked_descriptors.data);
+    EXPECT_EQ(database->ReadDescriptors(image_id3).data,
+              random_descriptors.data);
+    EXPECT_EQ(database->ReadMatches(image_id2, image_id1), matches);
+    EXPECT_EQ(
+        database->ReadTwoViewGeometry(image_id2, image_id1).inlier_matches,
+        matches);
+  }
+  EXPECT_EQ(database->NumMatches(), 2 * matches.size());
+  EXPECT_EQ(database->NumInlierMatches(), 2 * matches.size());
+}
+
+TEST_P(ParameterizedDatabaseTests, BatchedReads) {
+  std::shared_ptr<Database> database = GetParam()(kInMemorySqliteDatabasePath);
+  Camera camera = Camera::CreateFromModelId(
+      kInvalidCameraId, CameraModelId::kSimplePinhole, 1.0, 1, 1);
+  camera.camera_id = database->WriteCamera(camera);
+
+  constexpr int kNumImages = 1200;
+  std::vector<image_t> image_ids;
+  for (int i = 0; i < kNumImages; ++i) {
+    Image image;
+    image.SetName("image" + std::to_string(i));
+    image.SetCameraId(camera.camera_id);
+    image_ids.push_back(database->WriteImage(image));
+    // Leave some images without features.
+    if (i % 3 != 0) {
+      database->WriteKeypoints(image_ids.back(), FeatureKeypoints(i % 7));
+      database->WriteDescriptors(
+          image_ids.back(),
+          FeatureDescriptors(FeatureExtractorType::SIFT,
+                             FeatureDescriptorsData::Random(i % 7, 128)));
+    }
+  }
+
+  std::vector<image_pair_t> pair_ids;
+  for (int i = 1; i < kNumImages; i += 2) {
+    TwoViewGeometry two_view_geometry;
+    two_view_geometry.config = TwoViewGeometry::UNCALIBRATED;
+    two_view_geometry.inlier_matches.resize(i % 5);
+    two_view_geometry.F = Eigen::Matrix3d::Random();
+    database->WriteTwoViewGeometry(
+        image_ids[i - 1], image_ids[i], two_view_geometry);
+    pair_ids.push_back(ImagePairToPairId(image_ids[i - 1], image_ids[i]));
+    pair_ids.push_back(ImagePairToPairId(image_ids[i], image_ids[i - 1] + 1));
+  }
+
+  // Query in reverse order with duplicates to check the output order.
+  std::vector<image_t> query_image_ids(image_ids.rbegin(), image_ids.rend());
+  query_image_ids.push_back(image_ids[1]);
+  const std::vector<FeatureKeypoints> keypoints = database->ReadKeypoints(
+      span<const image_t>(query_image_ids.data(), query_image_ids.size()));
+  const std::vector<FeatureDescriptors> descriptors = database->ReadDescriptors(
+      span<const image_t>(query_image_ids.data(), query_image_ids.size()));
+  ASSERT_EQ(keypoints.size(), query_image_ids.size());
+  ASSERT_EQ(descriptors.size(), query_image_ids.size());
+  for (size_t i = 0; i < query_image_ids.size(); ++i) {
+    EXPECT_EQ(keypoints[i], database->ReadKeypoints(query_image_ids[i]));
+    const FeatureDescriptors expected_descriptors =
+        database->ReadDescriptors(query_image_ids[i]);
+    EXPECT_EQ(descriptors[i].type, expected_descriptors.type);
+    EXPECT_EQ(descriptors[i].data, expected_descriptors.data);
+  }
+
+  const std::vector<TwoViewGeometry> two_view_geometries =
+      database->ReadTwoViewGeometries(
+          span<const image_pair_t>(pair_ids.data(), pair_ids.size()));
+  ASSERT_EQ(two_view_geometries.size(), pair_ids.size());
+  for (size_t i = 0; i < pair_ids.size(); ++i) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_ids[i]);
+    const TwoViewGeometry expected_two_view_geometry =
+        database->ReadTwoViewGeometry(image_id1, image_id2);
+    EXPECT_EQ(two_view_geometries[i].config, expected_two_view_geometry.config);
+    EXPECT_EQ(two_view_geometries[i].inlier_matches,
+              expected_two_view_geometry.inlier_matches);
+    EXPECT_EQ(two_view_geometries[i].F, expected_two_view_geometry.F);
+  }
+
+  EXPECT_TRUE(database->ReadKeypoints(span<const image_t>(nullptr, 0)).empty());
+}
+
 TEST_P(ParameterizedDatabaseTests, Merge) {
   std::shared_ptr<Database> database1 = GetParam()(kInMemorySqliteDatabasePath);
   std::shared_ptr<Database> database2 = GetParam()(kInMemorySqliteDatabasePath);
@@ -809,12 +1117,101 @@ TEST_P(ParameterizedDatabaseTests, Merge) {
   EXPECT_EQ(merged_database->NumMatches(), 0);
 }
 
+TEST_P(ParameterizedDatabaseTests, MergeMultipleIntoExisting) {
+  auto create_session_database = [](const std::string& name_prefix,
+                                    const int num_images) {
+    std::shared_ptr<Database> database =
+        GetParam()(kInMemorySqliteDatabasePath);
+    const camera_t camera_id =
+        database->WriteCamera(Camera::CreateFromModelId(
+            kInvalidCameraId, CameraModelId::kSimplePinhole, 1.0, 1, 1));
+    std::vector<image_t> image_ids;
+    for (int i = 0; i < num_images; ++i) {
+      Image image;
+      image.SetCameraId(camera_id);
+      image.SetName(name_prefix + std::to_string(i));
+      const image_t image_id = database->WriteImage(image);
+      FeatureKeypoints keypoints(10 + i);
+      keypoints[0].x = i;
+      database->WriteKeypoints(image_id, keypoints);
+      database->WriteDescriptors(
+          image_id,
+          FeatureDescriptors(FeatureExtractorType::UNDEFINED,
+                             FeatureDescriptorsData::Random(10 + i, 128)));
+      image_ids.push_back(image_id);
+    }
+    for (int i = 1; i < num_images; ++i) {
+      FeatureMatches matches(i);
+      matches[0].point2D_idx1 = 1;
+      matches[0].point2D_idx2 = 2;
+      database->WriteMatches(image_ids[i], image_ids[i - 1], matches);
+      TwoViewGeometry two_view_geometry;
+      two_view_geometry.config = TwoViewGeometry::CALIBRATED;
+      two_view_geometry.inlier_matches = matches;
+      database->WriteTwoViewGeometry(
+          image_ids[i], image_ids[i - 1], two_view_geometry);
+    }
+    return database;
+  };
+
+  std::shared_ptr<Database> existing_database =
+      create_session_database("existing", 3);
+  std::shared_ptr<Database> database1 = create_session_database("session1_", 4);
+  std::shared_ptr<Database> database2 = create_session_database("session2_", 5);
+
+  Database::Merge({database1.get(), database2.get()}, existing_database.get());
+
+  EXPECT_EQ(existing_database->NumCameras(), 3);
+  EXPECT_EQ(existing_database->NumImages(), 12);
+  EXPECT_EQ(existing_database->NumMatchedImagePairs(), 2 + 3 + 4);
+  EXPECT_EQ(existing_database->NumVerifiedImagePairs(), 2 + 3 + 4);
+
+  for (const auto& [database, name_prefix] :
+       std::vector<std::pair<const Database*, std::string>>{
+           {database1.get(), "session1_"}, {database2.get(), "session2_"}}) {
+    for (int i = 0; i < static_cast<int>(database->NumImages()); ++i) {
+      const std::string name = name_prefix + std::to_string(i);
+      const Image image = database->ReadImageWithName(name).value();
+      const Image merged_image =
+          existing_database->ReadImageWithName(name).value();
+      EXPECT_EQ(existing_database->ReadKeypoints(merged_image.ImageId()),
+                database->ReadKeypoints(image.ImageId()));
+      EXPECT_EQ(
+          existing_database->ReadDescriptors(merged_image.ImageId()).data,
+          database->ReadDescriptors(image.ImageId()).data);
+      if (i == 0) {
+        continue;
+      }
+      const std::string prev_name = name_prefix + std::to_string(i - 1);
+      const Image prev_image = database->ReadImageWithName(prev_name).value();
+      const Image merged_prev_image =
+          existing_database->ReadImageWithName(prev_name).value();
+      EXPECT_EQ(existing_database->ReadMatches(merged_image.ImageId(),
+                                               merged_prev_image.ImageId()),
+                database->ReadMatches(image.ImageId(), prev_image.ImageId()));
+      EXPECT_EQ(existing_database
+                    ->ReadTwoViewGeometry(merged_image.ImageId(),
+                                          merged_prev_image.ImageId())
+                    .inlier_matches,
+                database
+                    ->ReadTwoViewGeometry(image.ImageId(), prev_image.ImageId())
+                    .inlier_matches);
+    }
+  }
+
+  // Image names must be unique across all databases.
+  EXPECT_ANY_THROW(
+      Database::Merge({database1.get()}, existing_database.get()));
+}
+
 INSTANTIATE_TEST_SUITE_P(
     DatabaseTests,
     ParameterizedDatabaseTests,
-    ::testing::Values([](const std::filesystem::path& path) {
-      return Database::Open(path);
-    }));
+    ::testing::Values(
+        [](const std::filesystem::path& path) { return Database::Open(path); },
+        [](const std::filesystem::path& path) {
+          return OpenMmapDatabase(path);
+        }));
 
 // Helper to create a database file with images and descriptors.
 std::shared_ptr<Database> CreateDatabaseWithRandomDescriptors(
@@ -841,6 +1238,86 @@ std::shared_ptr<Database> CreateDatabaseWithRandomDescriptors(
   return database;
 }
 
+TEST(SqliteDatabase, BlobCompressionReducesFileSize) {
+  const auto test_dir = CreateTestDir();
+  FeatureMatches matches(200);
+  for (size_t i = 0; i < matches.size(); ++i) {
+    matches[i].point2D_idx1 = i;
+    matches[i].point2D_idx2 = i + 1;
+  }
+
+  std::vector<size_t> file_sizes;
+  for (const bool compress : {false, true}) {
+    const auto path = test_dir / (compress ? "compressed.db" : "raw.db");
+    {
+      std::shared_ptr<Database> database = OpenSqliteDatabase(path);
+      database->SetBlobCompression(compress);
+      DatabaseTransaction transaction(database.get());
+      for (image_t image_id = 2; image_id < 1000; ++image_id) {
+        database->WriteMatches(1, image_id, matches);
+      }
+    }
+    file_sizes.push_back(std::filesystem::file_size(path));
+    EXPECT_EQ(OpenSqliteDatabase(path)->ReadMatches(1, 42), matches);
+  }
+  EXPECT_LT(2 * file_sizes[1], file_sizes[0]);
+}
+
+TEST(DatabaseReadPool, Nominal) {
+  const auto database_path = CreateTestDir() / "database.db";
+  std::shared_ptr<Database> database = Database::Open(database_path);
+  Camera camera = Camera::CreateFromModelId(
+      kInvalidCameraId, CameraModelId::kSimplePinhole, 1.0, 1, 1);
+  camera.camera_id = database->WriteCamera(camera);
+  std::vector<image_t> image_ids;
+  for (int i = 0; i < 20; ++i) {
+    Image image;
+    image.SetName("image" + std::to_string(i));
+    image.SetCameraId(camera.camera_id);
+    image_ids.push_back(database->WriteImage(image));
+    database->WriteKeypoints(image_ids.back(), FeatureKeypoints(i));
+  }
+
+  EXPECT_EQ(Database::OpenReadOnlyPool(kInMemorySqliteDatabasePath, 2),
+            nullptr);
+  EXPECT_ANY_THROW(Database::OpenReadOnlyPool(database_path, 0));
+  EXPECT_ANY_THROW(
+      Database::OpenReadOnlyPool(CreateTestDir() / "missing.db", 2));
+
+  std::shared_ptr<DatabaseReadPool> read_pool =
+      Database::OpenReadOnlyPool(database_path, 3);
+  ASSERT_NE(read_pool, nullptr);
+  EXPECT_EQ(read_pool->NumConnections(), 3);
+
+  // Writes of the other connection are visible to the read connections.
+  Image image;
+  image.SetName("image");
+  image.SetCameraId(camera.camera_id);
+  database->WriteKeypoints(database->WriteImage(image), FeatureKeypoints(100));
+  read_pool->Read([](const Database& database) {
+    EXPECT_EQ(database.NumKeypoints(), 190 + 100);
+  });
+
+  std::vector<std::thread> threads;
+  std::atomic<int> num_errors(0);
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&]() {
+      for (const image_t image_id : image_ids) {
+        read_pool->Read([&](const Database& database) {
+          if (database.ReadKeypoints(image_id).size() !=
+              static_cast<size_t>(image_id - image_ids[0])) {
+            ++num_errors;
+          }
+        });
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_errors, 0);
+}
+
 TEST(LoadRandomDatabaseDescriptorsTest, LoadEmpty) {
   auto database = Database::Open(kInMemorySqliteDatabasePath);
   const auto result = LoadRandomDatabaseDescriptors(*database, -1);
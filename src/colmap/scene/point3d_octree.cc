@@ -0,0 +1,471 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/scene/point3d_octree.h"
+
+#include "colmap/util/logging.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+namespace colmap {
+namespace {
+
+enum class CellOverlap { kNone, kPartial, kFull };
+
+// Number of samples per image border to bound the viewing frustum of cameras
+// with distortion, whose image borders are curved in the normalized plane.
+constexpr int kNumBorderSamples = 16;
+
+CellOverlap HalfSpacesCellOverlap(const std::vector<Eigen::Vector4d>& planes,
+                                  const Eigen::Vector3d& center,
+                                  const double half_size) {
+  bool full = true;
+  for (const Eigen::Vector4d& plane : planes) {
+    const double center_dist = plane.head<3>().dot(center) + plane(3);
+    const double radius = half_size * plane.head<3>().lpNorm<1>();
+    if (center_dist + radius < 0) {
+      return CellOverlap::kNone;
+    }
+    if (center_dist - radius < 0) {
+      full = false;
+    }
+  }
+  return full ? CellOverlap::kFull : CellOverlap::kPartial;
+}
+
+bool HalfSpacesContain(const std::vector<Eigen::Vector4d>& planes,
+                       const Eigen::Vector3d& xyz) {
+  for (const Eigen::Vector4d& plane : planes) {
+    if (plane.head<3>().dot(xyz) + plane(3) < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Computes the bounds of the image in the normalized camera plane by sampling
+// its border. Returns false if some border pixel cannot be unprojected.
+bool ComputeNormalizedImageBounds(const Camera& camera,
+                                  Eigen::AlignedBox2d* bounds) {
+  bounds->setEmpty();
+  const double width = camera.width;
+  const double height = camera.height;
+  for (int i = 0; i <= kNumBorderSamples; ++i) {
+    const double t = static_cast<double>(i) / kNumBorderSamples;
+    for (const Eigen::Vector2d& image_point :
+         {Eigen::Vector2d(t * width, 0),
+          Eigen::Vector2d(t * width, height),
+          Eigen::Vector2d(0, t * height),
+          Eigen::Vector2d(width, t * height)}) {
+      const std::optional<Eigen::Vector2d> cam_point =
+          camera.CamFromImg(image_point);
+      if (!cam_point || !cam_point->allFinite()) {
+        return false;
+      }
+      bounds->extend(*cam_point);
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+Eigen::AlignedBox3d Point3DOctree::Node::Box() const {
+  return Eigen::AlignedBox3d(center - Eigen::Vector3d::Constant(half_size),
+                             center + Eigen::Vector3d::Constant(half_size));
+}
+
+bool Point3DOctree::Node::Contains(const Eigen::Vector3d& xyz) const {
+  return ((xyz - center).array() >= -half_size).all() &&
+         ((xyz - center).array() < half_size).all();
+}
+
+int Point3DOctree::Node::ChildIndex(const Eigen::Vector3d& xyz) const {
+  return (xyz(0) >= center(0) ? 1 : 0) | (xyz(1) >= center(1) ? 2 : 0) |
+         (xyz(2) >= center(2) ? 4 : 0);
+}
+
+Point3DOctree::Point3DOctree(const int max_leaf_size, const int max_depth)
+    : max_leaf_size_(max_leaf_size), max_depth_(max_depth) {
+  THROW_CHECK_GT(max_leaf_size_, 0);
+  THROW_CHECK_GE(max_depth_, 0);
+}
+
+void Point3DOctree::Insert(const point3D_t point3D_id,
+                           const Eigen::Vector3d& xyz) {
+  THROW_CHECK(positions_.emplace(point3D_id, xyz).second)
+      << "Point " << point3D_id << " already exists";
+  if (!xyz.allFinite()) {
+    return;
+  }
+
+  if (root_idx_ == -1) {
+    root_idx_ = 0;
+    Node& root = nodes_.emplace_back();
+    root.center = xyz;
+    root.half_size = 1;
+  } else if (!nodes_[root_idx_].Contains(xyz)) {
+    GrowRoot(xyz);
+  }
+
+  int node_idx = root_idx_;
+  while (true) {
+    Node& node = nodes_[node_idx];
+    ++node.num_points;
+    if (node.first_child == -1) {
+      break;
+    }
+    node_idx = node.first_child + node.ChildIndex(xyz);
+  }
+
+  nodes_[node_idx].entries.push_back({point3D_id, xyz});
+  SplitLeaf(node_idx);
+}
+
+void Point3DOctree::Remove(const point3D_t point3D_id) {
+  const auto it = positions_.find(point3D_id);
+  THROW_CHECK(it != positions_.end())
+      << "Point " << point3D_id << " does not exist";
+  const Eigen::Vector3d xyz = it->second;
+  positions_.erase(it);
+  if (!xyz.allFinite()) {
+    return;
+  }
+
+  int node_idx = root_idx_;
+  while (true) {
+    Node& node = nodes_[node_idx];
+    --node.num_points;
+    if (node.first_child == -1) {
+      break;
+    }
+    node_idx = node.first_child + node.ChildIndex(xyz);
+  }
+
+  std::vector<Entry>& entries = nodes_[node_idx].entries;
+  const auto entry_it =
+      std::find_if(entries.begin(), entries.end(), [&](const Entry& entry) {
+        return entry.point3D_id == point3D_id;
+      });
+  THROW_CHECK(entry_it != entries.end());
+  *entry_it = entries.back();
+  entries.pop_back();
+}
+
+void Point3DOctree::Update(const point3D_t point3D_id,
+                           const Eigen::Vector3d& xyz) {
+  Remove(point3D_id);
+  Insert(point3D_id, xyz);
+}
+
+void Point3DOctree::Clear() {
+  root_idx_ = -1;
+  nodes_.clear();
+  positions_.clear();
+}
+
+void Point3DOctree::GrowRoot(const Eigen::Vector3d& xyz) {
+  // Double the root cell towards the point until it is enclosed. The new root
+  // reuses the slot of the old root, which moves to the new child nodes.
+  while (!nodes_[root_idx_].Contains(xyz)) {
+    const Eigen::Vector3d old_center = nodes_[root_idx_].center;
+    const double old_half_size = nodes_[root_idx_].half_size;
+    Eigen::Vector3d new_center;
+    int old_root_child_idx = 0;
+    for (int d = 0; d < 3; ++d) {
+      if (xyz(d) >= old_center(d)) {
+        new_center(d) = old_center(d) + old_half_size;
+      } else {
+        new_center(d) = old_center(d) - old_half_size;
+        old_root_child_idx |= 1 << d;
+      }
+    }
+
+    const int first_child = static_cast<int>(nodes_.size());
+    for (int i = 0; i < 8; ++i) {
+      Node& child = nodes_.emplace_back();
+      child.half_size = old_half_size;
+      for (int d = 0; d < 3; ++d) {
+        child.center(d) = new_center(d) +
+                          ((i >> d) & 1 ? old_half_size : -old_half_size);
+      }
+    }
+
+    Node& root = nodes_[root_idx_];
+    const int old_root_idx = first_child + old_root_child_idx;
+    std::swap(nodes_[old_root_idx], root);
+    root.center = new_center;
+    root.half_size = 2 * old_half_size;
+    root.first_child = first_child;
+    root.num_points = nodes_[old_root_idx].num_points;
+    root.entries.clear();
+  }
+}
+
+void Point3DOctree::SplitLeaf(const int node_idx) {
+  const double min_half_size =
+      std::ldexp(nodes_[root_idx_].half_size, -max_depth_);
+  if (nodes_[node_idx].entries.size() <= static_cast<size_t>(max_leaf_size_) ||
+      nodes_[node_idx].half_size <= min_half_size) {
+    return;
+  }
+
+  const int first_child = static_cast<int>(nodes_.size());
+  const Eigen::Vector3d center = nodes_[node_idx].center;
+  const double child_half_size = nodes_[node_idx].half_size / 2;
+  for (int i = 0; i < 8; ++i) {
+    Node& child = nodes_.emplace_back();
+    child.half_size = child_half_size;
+    for (int d = 0; d < 3; ++d) {
+      child.center(d) =
+          center(d) + ((i >> d) & 1 ? child_half_size : -child_half_size);
+    }
+  }
+
+  Node& node = nodes_[node_idx];
+  node.first_child = first_child;
+  for (const Entry& entry : node.entries) {
+    Node& child = nodes_[first_child + node.ChildIndex(entry.xyz)];
+    child.entries.push_back(entry);
+    ++child.num_points;
+  }
+  node.entries.clear();
+  node.entries.shrink_to_fit();
+
+  for (int i = 0; i < 8; ++i) {
+    SplitLeaf(first_child + i);
+  }
+}
+
+template <typename CellFunc, typename PointFunc>
+void Point3DOctree::Traverse(CellFunc&& cell_func,
+                             PointFunc&& point_func,
+                             std::vector<point3D_t>* point3D_ids) const {
+  if (root_idx_ == -1) {
+    return;
+  }
+  std::vector<int> stack = {root_idx_};
+  while (!stack.empty()) {
+    const int node_idx = stack.back();
+    stack.pop_back();
+    const Node& node = nodes_[node_idx];
+    if (node.num_points == 0) {
+      continue;
+    }
+    const CellOverlap overlap = cell_func(node);
+    if (overlap == CellOverlap::kNone) {
+      continue;
+    } else if (overlap == CellOverlap::kFull) {
+      CollectSubtree(node_idx, point3D_ids);
+    } else if (node.first_child == -1) {
+      for (const Entry& entry : node.entries) {
+        if (point_func(entry.xyz)) {
+          point3D_ids->push_back(entry.point3D_id);
+        }
+      }
+    } else {
+      for (int i = 0; i < 8; ++i) {
+        stack.push_back(node.first_child + i);
+      }
+    }
+  }
+}
+
+void Point3DOctree::CollectSubtree(
+    const int node_idx, std::vector<point3D_t>* point3D_ids) const {
+  std::vector<int> stack = {node_idx};
+  while (!stack.empty()) {
+    const Node& node = nodes_[stack.back()];
+    stack.pop_back();
+    if (node.num_points == 0) {
+      continue;
+    }
+    if (node.first_child == -1) {
+      for (const Entry& entry : node.entries) {
+        point3D_ids->push_back(entry.point3D_id);
+      }
+    } else {
+      for (int i = 0; i < 8; ++i) {
+        stack.push_back(node.first_child + i);
+      }
+    }
+  }
+}
+
+std::vector<point3D_t> Point3DOctree::QueryBox(
+    const Eigen::AlignedBox3d& box) const {
+  std::vector<point3D_t> point3D_ids;
+  Traverse(
+      [&box](const Node& node) {
+        const Eigen::AlignedBox3d cell = node.Box();
+        if (!box.intersects(cell)) {
+          return CellOverlap::kNone;
+        } else if (box.contains(cell)) {
+          return CellOverlap::kFull;
+        }
+        return CellOverlap::kPartial;
+      },
+      [&box](const Eigen::Vector3d& xyz) { return box.contains(xyz); },
+      &point3D_ids);
+  return point3D_ids;
+}
+
+std::vector<point3D_t> Point3DOctree::QueryHalfSpaces(
+    const std::vector<Eigen::Vector4d>& planes) const {
+  std::vector<point3D_t> point3D_ids;
+  Traverse(
+      [&planes](const Node& node) {
+        return HalfSpacesCellOverlap(planes, node.center, node.half_size);
+      },
+      [&planes](const Eigen::Vector3d& xyz) {
+        return HalfSpacesContain(planes, xyz);
+      },
+      &point3D_ids);
+  return point3D_ids;
+}
+
+std::vector<point3D_t> Point3DOctree::QueryCameraFrustum(
+    const Camera& camera,
+    const Rigid3d& cam_from_world,
+    const double max_depth) const {
+  // Conservative bounding planes of the viewing frustum in the camera frame.
+  std::vector<Eigen::Vector4d> cam_planes;
+  Eigen::AlignedBox2d bounds;
+  if (camera.IsPerspective()) {
+    cam_planes.emplace_back(0, 0, 1, 0);
+    if (max_depth < std::numeric_limits<double>::max()) {
+      cam_planes.emplace_back(0, 0, -1, max_depth);
+    }
+    if (ComputeNormalizedImageBounds(camera, &bounds)) {
+      cam_planes.emplace_back(1, 0, -bounds.min()(0), 0);
+      cam_planes.emplace_back(-1, 0, bounds.max()(0), 0);
+      cam_planes.emplace_back(0, 1, -bounds.min()(1), 0);
+      cam_planes.emplace_back(0, -1, bounds.max()(1), 0);
+    }
+  }
+
+  const Eigen::Matrix3d cam_from_world_rotation =
+      cam_from_world.rotation().toRotationMatrix();
+  std::vector<Eigen::Vector4d> world_planes;
+  world_planes.reserve(cam_planes.size());
+  for (const Eigen::Vector4d& cam_plane : cam_planes) {
+    Eigen::Vector4d& world_plane = world_planes.emplace_back();
+    world_plane.head<3>() =
+        cam_from_world_rotation.transpose() * cam_plane.head<3>();
+    world_plane(3) =
+        cam_plane.head<3>().dot(cam_from_world.translation()) + cam_plane(3);
+  }
+
+  std::vector<point3D_t> point3D_ids;
+  Traverse(
+      [&world_planes](const Node& node) {
+        // Cells inside the conservative planes still require the exact
+        // projection test of their points.
+        const CellOverlap overlap =
+            HalfSpacesCellOverlap(world_planes, node.center, node.half_size);
+        return overlap == CellOverlap::kNone ? CellOverlap::kNone
+                                             : CellOverlap::kPartial;
+      },
+      [&](const Eigen::Vector3d& xyz) {
+        if (!HalfSpacesContain(world_planes, xyz)) {
+          return false;
+        }
+        const Eigen::Vector3d cam_point = cam_from_world * xyz;
+        const double depth =
+            camera.IsPerspective() ? cam_point.z() : cam_point.norm();
+        if (depth <= 0 || depth > max_depth) {
+          return false;
+        }
+        const std::optional<Eigen::Vector2d> image_point =
+            camera.ImgFromCam(cam_point);
+        return image_point && image_point->x() >= 0 &&
+               image_point->x() < camera.width && image_point->y() >= 0 &&
+               image_point->y() < camera.height;
+      },
+      &point3D_ids);
+  return point3D_ids;
+}
+
+std::vector<point3D_t> Point3DOctree::QueryNearest(const Eigen::Vector3d& xyz,
+                                                   const size_t k) const {
+  if (root_idx_ == -1 || k == 0) {
+    return {};
+  }
+
+  // Best-first search over the cells ordered by their distance to the query,
+  // while keeping the k nearest points found so far in a max-heap.
+  using DistNode = std::pair<double, int>;
+  std::priority_queue<DistNode, std::vector<DistNode>, std::greater<>> cells;
+  using DistPoint = std::pair<double, point3D_t>;
+  std::priority_queue<DistPoint> nearest;
+
+  cells.emplace(nodes_[root_idx_].Box().squaredExteriorDistance(xyz),
+                root_idx_);
+  while (!cells.empty()) {
+    const auto [cell_dist, node_idx] = cells.top();
+    cells.pop();
+    if (nearest.size() == k && cell_dist > nearest.top().first) {
+      break;
+    }
+    const Node& node = nodes_[node_idx];
+    if (node.first_child == -1) {
+      for (const Entry& entry : node.entries) {
+        const DistPoint dist_point((entry.xyz - xyz).squaredNorm(),
+                                   entry.point3D_id);
+        if (nearest.size() < k) {
+          nearest.push(dist_point);
+        } else if (dist_point < nearest.top()) {
+          nearest.pop();
+          nearest.push(dist_point);
+        }
+      }
+    } else {
+      for (int i = 0; i < 8; ++i) {
+        const Node& child = nodes_[node.first_child + i];
+        if (child.num_points > 0) {
+          cells.emplace(child.Box().squaredExteriorDistance(xyz),
+                        node.first_child + i);
+        }
+      }
+    }
+  }
+
+  std::vector<point3D_t> point3D_ids(nearest.size());
+  for (auto it = point3D_ids.rbegin(); it != point3D_ids.rend(); ++it) {
+    *it = nearest.top().second;
+    nearest.pop();
+  }
+  return point3D_ids;
+}
+
+}  // namespace colmap
@@ -0,0 +1,142 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "colmap/geometry/rigid3.h"
+#include "colmap/scene/camera.h"
+#include "colmap/util/types.h"
+
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace colmap {
+
+// Octree over 3D point positions for spatial queries on large point clouds,
+// e.g., cropping or splitting a reconstruction into tiles, finding the points
+// in the viewing frustum of a camera, or nearest neighbor lookups. Points are
+// inserted and removed incrementally by their identifier. The root cell grows
+// automatically to enclose points outside of its bounds. Points with
+// non-finite coordinates are tracked but never returned by any query.
+class Point3DOctree {
+ public:
+  // Leaf cells are split once they contain more than `max_leaf_size` points
+  // and they are larger than 2^-`max_depth` times the root cell.
+  explicit Point3DOctree(int max_leaf_size = 32, int max_depth = 24);
+
+  // Number of indexed points.
+  inline size_t Size() const;
+
+  inline bool Exists(point3D_t point3D_id) const;
+
+  // Insert a point with a new identifier.
+  void Insert(point3D_t point3D_id, const Eigen::Vector3d& xyz);
+
+  // Remove an existing point.
+  void Remove(point3D_t point3D_id);
+
+  // Move an existing point to a new position.
+  void Update(point3D_t point3D_id, const Eigen::Vector3d& xyz);
+
+  // Remove all points.
+  void Clear();
+
+  // Find the points inside the closed box.
+  std::vector<point3D_t> QueryBox(const Eigen::AlignedBox3d& box) const;
+
+  // Find the points in the intersection of the half-spaces, where each plane
+  // (n, d) defines the half-space n^T * x + d >= 0.
+  std::vector<point3D_t> QueryHalfSpaces(
+      const std::vector<Eigen::Vector4d>& planes) const;
+
+  // Find the points in front of the camera that project into its image and
+  // have a depth of at most `max_depth`. Cells outside of the viewing frustum
+  // are culled before projecting the points of the remaining cells.
+  std::vector<point3D_t> QueryCameraFrustum(
+      const Camera& camera,
+      const Rigid3d& cam_from_world,
+      double max_depth = std::numeric_limits<double>::max()) const;
+
+  // Find the k nearest points sorted by increasing distance to the query.
+  std::vector<point3D_t> QueryNearest(const Eigen::Vector3d& xyz,
+                                      size_t k) const;
+
+ private:
+  struct Entry {
+    point3D_t point3D_id;
+    Eigen::Vector3d xyz;
+  };
+
+  // Half-open cube [center - half_size, center + half_size).
+  struct Node {
+    Eigen::Vector3d center;
+    double half_size = 0;
+    // Index of the first of the 8 consecutive child nodes, or -1 for leaves.
+    int first_child = -1;
+    // Number of points in the subtree.
+    size_t num_points = 0;
+    // Points of leaf nodes.
+    std::vector<Entry> entries;
+
+    Eigen::AlignedBox3d Box() const;
+    bool Contains(const Eigen::Vector3d& xyz) const;
+    int ChildIndex(const Eigen::Vector3d& xyz) const;
+  };
+
+  void GrowRoot(const Eigen::Vector3d& xyz);
+  void SplitLeaf(int node_idx);
+  template <typename CellFunc, typename PointFunc>
+  void Traverse(CellFunc&& cell_func,
+                PointFunc&& point_func,
+                std::vector<point3D_t>* point3D_ids) const;
+  void CollectSubtree(int node_idx, std::vector<point3D_t>* point3D_ids) const;
+
+  int max_leaf_size_;
+  int max_depth_;
+  int root_idx_ = -1;
+  std::vector<Node> nodes_;
+  std::unordered_map<point3D_t, Eigen::Vector3d> positions_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////////////////////////////////////
+
+size_t Point3DOctree::Size() const { return positions_.size(); }
+
+bool Point3DOctree::Exists(const point3D_t point3D_id) const {
+  return positions_.count(point3D_id) > 0;
+}
+
+}  // namespace colmap
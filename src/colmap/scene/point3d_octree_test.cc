@@ -0,0 +1,225 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/scene/point3d_octree.h"
+
+#include "colmap/math/random.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+std::vector<Eigen::Vector3d> RandomPoints(const size_t num_points,
+                                          const double scale) {
+  std::vector<Eigen::Vector3d> points(num_points);
+  for (Eigen::Vector3d& point : points) {
+    point = Eigen::Vector3d(RandomUniformReal<double>(-scale, scale),
+                            RandomUniformReal<double>(-scale, scale),
+                            RandomUniformReal<double>(-scale, scale));
+  }
+  return points;
+}
+
+Point3DOctree CreateOctree(const std::vector<Eigen::Vector3d>& points) {
+  Point3DOctree octree(/*max_leaf_size=*/4);
+  for (size_t i = 0; i < points.size(); ++i) {
+    octree.Insert(i, points[i]);
+  }
+  return octree;
+}
+
+template <typename Func>
+std::vector<point3D_t> FilterPoints(const std::vector<Eigen::Vector3d>& points,
+                                    Func&& func) {
+  std::vector<point3D_t> point3D_ids;
+  for (size_t i = 0; i < points.size(); ++i) {
+    if (func(points[i])) {
+      point3D_ids.push_back(i);
+    }
+  }
+  return point3D_ids;
+}
+
+TEST(Point3DOctree, Empty) {
+  Point3DOctree octree;
+  EXPECT_EQ(octree.Size(), 0);
+  EXPECT_FALSE(octree.Exists(0));
+  EXPECT_THAT(octree.QueryBox(Eigen::AlignedBox3d(Eigen::Vector3d(-1, -1, -1),
+                                                  Eigen::Vector3d(1, 1, 1))),
+              testing::IsEmpty());
+  EXPECT_THAT(octree.QueryNearest(Eigen::Vector3d::Zero(), 3),
+              testing::IsEmpty());
+  EXPECT_ANY_THROW(octree.Remove(0));
+}
+
+TEST(Point3DOctree, InsertRemoveUpdate) {
+  Point3DOctree octree(/*max_leaf_size=*/1);
+  octree.Insert(1, Eigen::Vector3d(0, 0, 0));
+  octree.Insert(2, Eigen::Vector3d(100, 0, 0));
+  octree.Insert(3, Eigen::Vector3d(-50, 20, 3));
+  EXPECT_ANY_THROW(octree.Insert(1, Eigen::Vector3d(1, 0, 0)));
+  EXPECT_EQ(octree.Size(), 3);
+  EXPECT_TRUE(octree.Exists(2));
+
+  const Eigen::AlignedBox3d box(Eigen::Vector3d(-1, -1, -1),
+                                Eigen::Vector3d(101, 1, 1));
+  EXPECT_THAT(octree.QueryBox(box), testing::UnorderedElementsAre(1, 2));
+
+  octree.Remove(2);
+  EXPECT_EQ(octree.Size(), 2);
+  EXPECT_FALSE(octree.Exists(2));
+  EXPECT_THAT(octree.QueryBox(box), testing::UnorderedElementsAre(1));
+
+  octree.Update(3, Eigen::Vector3d(50, 0, 0));
+  EXPECT_THAT(octree.QueryBox(box), testing::UnorderedElementsAre(1, 3));
+  EXPECT_THAT(octree.QueryNearest(Eigen::Vector3d(40, 0, 0), 1),
+              testing::ElementsAre(3));
+
+  octree.Clear();
+  EXPECT_EQ(octree.Size(), 0);
+  EXPECT_THAT(octree.QueryBox(box), testing::IsEmpty());
+}
+
+TEST(Point3DOctree, DuplicateAndNonFinitePoints) {
+  Point3DOctree octree(/*max_leaf_size=*/2);
+  for (point3D_t point3D_id = 0; point3D_id < 100; ++point3D_id) {
+    octree.Insert(point3D_id, Eigen::Vector3d(1, 2, 3));
+  }
+  octree.Insert(100, Eigen::Vector3d::Constant(NAN));
+  EXPECT_EQ(octree.Size(), 101);
+  EXPECT_EQ(octree
+                .QueryBox(Eigen::AlignedBox3d(Eigen::Vector3d(1, 2, 3),
+                                              Eigen::Vector3d(1, 2, 3)))
+                .size(),
+            100);
+  EXPECT_EQ(octree.QueryNearest(Eigen::Vector3d::Zero(), 1000).size(), 100);
+  octree.Remove(100);
+  octree.Remove(0);
+  EXPECT_EQ(octree.Size(), 99);
+}
+
+TEST(Point3DOctree, QueryBox) {
+  SetPRNGSeed(1);
+  const std::vector<Eigen::Vector3d> points = RandomPoints(5000, 10);
+  const Point3DOctree octree = CreateOctree(points);
+  for (int i = 0; i < 20; ++i) {
+    const Eigen::Vector3d corner1 = RandomPoints(1, 12)[0];
+    const Eigen::Vector3d corner2 = RandomPoints(1, 12)[0];
+    const Eigen::AlignedBox3d box(corner1.cwiseMin(corner2),
+                                  corner1.cwiseMax(corner2));
+    EXPECT_THAT(octree.QueryBox(box),
+                testing::UnorderedElementsAreArray(FilterPoints(
+                    points, [&](const auto& xyz) {
+                      return box.contains(xyz);
+                    })));
+  }
+}
+
+TEST(Point3DOctree, QueryHalfSpaces) {
+  SetPRNGSeed(1);
+  const std::vector<Eigen::Vector3d> points = RandomPoints(5000, 10);
+  const Point3DOctree octree = CreateOctree(points);
+  for (int i = 0; i < 20; ++i) {
+    std::vector<Eigen::Vector4d> planes;
+    for (int j = 0; j < 3; ++j) {
+      planes.emplace_back(Eigen::Vector4d::Random());
+    }
+    EXPECT_THAT(octree.QueryHalfSpaces(planes),
+                testing::UnorderedElementsAreArray(
+                    FilterPoints(points, [&](const auto& xyz) {
+                      for (const auto& plane : planes) {
+                        if (plane.head<3>().dot(xyz) + plane(3) < 0) {
+                          return false;
+                        }
+                      }
+                      return true;
+                    })));
+  }
+}
+
+TEST(Point3DOctree, QueryCameraFrustum) {
+  SetPRNGSeed(1);
+  const std::vector<Eigen::Vector3d> points = RandomPoints(5000, 10);
+  const Point3DOctree octree = CreateOctree(points);
+  Camera camera = Camera::CreateFromModelName(1, "RADIAL", 100, 200, 150);
+  camera.params[3] = 0.05;
+  camera.params[4] = 0.01;
+  for (int i = 0; i < 10; ++i) {
+    const Rigid3d cam_from_world(Eigen::Quaterniond::UnitRandom(),
+                                 RandomPoints(1, 5)[0]);
+    const double max_depth = i % 2 == 0 ? 8 : 1e6;
+    EXPECT_THAT(
+        octree.QueryCameraFrustum(camera, cam_from_world, max_depth),
+        testing::UnorderedElementsAreArray(
+            FilterPoints(points, [&](const auto& xyz) {
+              const Eigen::Vector3d cam_point = cam_from_world * xyz;
+              if (cam_point.z() <= 0 || cam_point.z() > max_depth) {
+                return false;
+              }
+              const std::optional<Eigen::Vector2d> image_point =
+                  camera.ImgFromCam(cam_point);
+              return image_point && image_point->x() >= 0 &&
+                     image_point->x() < camera.width &&
+                     image_point->y() >= 0 &&
+                     image_point->y() < camera.height;
+            })));
+  }
+}
+
+TEST(Point3DOctree, QueryNearest) {
+  SetPRNGSeed(1);
+  std::vector<Eigen::Vector3d> points = RandomPoints(2000, 10);
+  // Far away points grow the root cell.
+  points.emplace_back(1000, -2000, 500);
+  points.emplace_back(-1e5, 0, 0);
+  const Point3DOctree octree = CreateOctree(points);
+  for (int i = 0; i < 20; ++i) {
+    const Eigen::Vector3d query = RandomPoints(1, 15)[0];
+    std::vector<point3D_t> expected(points.size());
+    std::iota(expected.begin(), expected.end(), 0);
+    std::sort(expected.begin(), expected.end(), [&](auto id1, auto id2) {
+      return (points[id1] - query).squaredNorm() <
+             (points[id2] - query).squaredNorm();
+    });
+    expected.resize(7);
+    EXPECT_THAT(octree.QueryNearest(query, 7),
+                testing::ElementsAreArray(expected));
+  }
+  EXPECT_EQ(octree.QueryNearest(Eigen::Vector3d::Zero(), 10000).size(),
+            points.size());
+}
+
+}  // namespace
+}  // namespace colmap
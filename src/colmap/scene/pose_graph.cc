@@ -1,6 +1,9 @@
 #include "colmap/scene/pose_graph.h"
 
 #include "colmap/math/connected_components.h"
+#include "colmap/math/spanning_tree.h"
+
+#include <algorithm>
 
 namespace colmap {
 
@@ -65,6 +68,87 @@ void PoseGraph::InvalidatePairsOutsideActiveImageIds(
   }
 }
 
+size_t PoseGraph::Sparsify(int max_degree) {
+  THROW_CHECK_GT(max_degree, 0);
+
+  std::vector<image_pair_t> pair_ids;
+  std::unordered_map<image_t, int> image_id_to_idx;
+  for (const auto& [pair_id, edge] : ValidEdges()) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    image_id_to_idx.emplace(image_id1, image_id_to_idx.size());
+    image_id_to_idx.emplace(image_id2, image_id_to_idx.size());
+    pair_ids.push_back(pair_id);
+  }
+  if (pair_ids.empty()) {
+    return 0;
+  }
+
+  // Sort by decreasing number of matches and pair id for determinism.
+  std::sort(pair_ids.begin(),
+            pair_ids.end(),
+            [this](image_pair_t pair_id1, image_pair_t pair_id2) {
+              const int num_matches1 = edges_.at(pair_id1).num_matches;
+              const int num_matches2 = edges_.at(pair_id2).num_matches;
+              if (num_matches1 != num_matches2) {
+                return num_matches1 > num_matches2;
+              }
+              return pair_id1 < pair_id2;
+            });
+
+  // Connect a virtual root to all images with the lowest weight, such that
+  // the maximum spanning tree contains a maximum spanning forest of the
+  // graph and exactly one virtual edge per connected component.
+  const int num_images = static_cast<int>(image_id_to_idx.size());
+  const int root = num_images;
+  std::vector<std::pair<int, int>> tree_edges;
+  std::vector<float> tree_weights;
+  tree_edges.reserve(pair_ids.size() + num_images);
+  tree_weights.reserve(pair_ids.size() + num_images);
+  for (const image_pair_t pair_id : pair_ids) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    tree_edges.emplace_back(image_id_to_idx.at(image_id1),
+                            image_id_to_idx.at(image_id2));
+    tree_weights.push_back(edges_.at(pair_id).num_matches);
+  }
+  for (int idx = 0; idx < num_images; ++idx) {
+    tree_edges.emplace_back(root, idx);
+    tree_weights.push_back(-1.f);
+  }
+  const SpanningTree tree = ComputeMaximumSpanningTree(
+      num_images + 1, tree_edges, tree_weights, root);
+
+  std::vector<int> degrees(num_images, 0);
+  std::vector<char> keep(pair_ids.size(), false);
+  for (size_t i = 0; i < pair_ids.size(); ++i) {
+    const auto [idx1, idx2] = tree_edges[i];
+    if (tree.parents[idx1] == idx2 || tree.parents[idx2] == idx1) {
+      keep[i] = true;
+      ++degrees[idx1];
+      ++degrees[idx2];
+    }
+  }
+
+  size_t num_invalidated = 0;
+  for (size_t i = 0; i < pair_ids.size(); ++i) {
+    if (keep[i]) {
+      continue;
+    }
+    const auto [idx1, idx2] = tree_edges[i];
+    if (degrees[idx1] < max_degree && degrees[idx2] < max_degree) {
+      ++degrees[idx1];
+      ++degrees[idx2];
+    } else {
+      SetInvalidEdge(pair_ids[i]);
+      ++num_invalidated;
+    }
+  }
+
+  LOG(INFO) << "Sparsified pose graph from " << pair_ids.size() << " to "
+            << pair_ids.size() - num_invalidated << " valid edges";
+
+  return num_invalidated;
+}
+
 int PoseGraph::MarkConnectedComponents(
     const Reconstruction& reconstruction,
     std::unordered_map<frame_t, int>& cluster_ids,
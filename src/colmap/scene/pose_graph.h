@@ -82,6 +82,13 @@ class PoseGraph {
   void InvalidatePairsOutsideActiveImageIds(
       const std::unordered_set<image_t>& active_image_ids);
 
+  // Sparsify the graph by invalidating redundant valid edges. The edges of a
+  // maximum spanning forest on the number of matches are always kept, so the
+  // connectivity of the graph is preserved. The remaining edges are kept in
+  // order of decreasing number of matches, as long as both images have fewer
+  // than max_degree kept edges. Returns the number of invalidated edges.
+  size_t Sparsify(int max_degree);
+
   // Mark connected clusters of images, where the cluster_id is sorted by the
   // the number of images. Populates `cluster_ids` output parameter.
   int MarkConnectedComponents(const Reconstruction& reconstruction,
@@ -367,5 +367,55 @@ TEST(PoseGraph, InvalidatePairsOutsideActiveImageIds) {
   EXPECT_FALSE(pose_graph.IsValid(ImagePairToPairId(2, 3)));
 }
 
+TEST(PoseGraph, Sparsify) {
+  PoseGraph pose_graph;
+  pose_graph.AddEdge(1, 2, SynthesizeEdge(10));
+  pose_graph.AddEdge(1, 3, SynthesizeEdge(50));
+  pose_graph.AddEdge(1, 4, SynthesizeEdge(40));
+  pose_graph.AddEdge(2, 3, SynthesizeEdge(30));
+  pose_graph.AddEdge(3, 4, SynthesizeEdge(20));
+  // Separate component.
+  pose_graph.AddEdge(5, 6, SynthesizeEdge(7));
+  pose_graph.AddEdge(5, 7, SynthesizeEdge(6));
+  pose_graph.AddEdge(6, 7, SynthesizeEdge(5));
+  // Invalid edges are ignored.
+  pose_graph.AddEdge(2, 4, SynthesizeEdge(100)).valid = false;
+
+  EXPECT_EQ(pose_graph.Sparsify(/*max_degree=*/1), 3);
+
+  // The maximum spanning forest is kept in spite of the degree limit.
+  EXPECT_TRUE(pose_graph.IsValid(ImagePairToPairId(1, 3)));
+  EXPECT_TRUE(pose_graph.IsValid(ImagePairToPairId(1, 4)));
+  EXPECT_TRUE(pose_graph.IsValid(ImagePairToPairId(2, 3)));
+  EXPECT_FALSE(pose_graph.IsValid(ImagePairToPairId(1, 2)));
+  EXPECT_FALSE(pose_graph.IsValid(ImagePairToPairId(3, 4)));
+  EXPECT_FALSE(pose_graph.IsValid(ImagePairToPairId(2, 4)));
+  EXPECT_TRUE(pose_graph.IsValid(ImagePairToPairId(5, 6)));
+  EXPECT_TRUE(pose_graph.IsValid(ImagePairToPairId(5, 7)));
+  EXPECT_FALSE(pose_graph.IsValid(ImagePairToPairId(6, 7)));
+
+  EXPECT_EQ(pose_graph.Sparsify(/*max_degree=*/1), 0);
+  EXPECT_ANY_THROW(pose_graph.Sparsify(/*max_degree=*/0));
+}
+
+TEST(PoseGraph, SparsifyMaxDegree) {
+  PoseGraph pose_graph;
+  pose_graph.AddEdge(1, 2, SynthesizeEdge(60));
+  pose_graph.AddEdge(2, 3, SynthesizeEdge(50));
+  pose_graph.AddEdge(3, 4, SynthesizeEdge(40));
+  pose_graph.AddEdge(1, 3, SynthesizeEdge(30));
+  pose_graph.AddEdge(2, 4, SynthesizeEdge(20));
+  pose_graph.AddEdge(1, 4, SynthesizeEdge(10));
+
+  // Edges are added in order of decreasing matches up to the degree limit.
+  EXPECT_EQ(pose_graph.Sparsify(/*max_degree=*/2), 2);
+  EXPECT_TRUE(pose_graph.IsValid(ImagePairToPairId(1, 2)));
+  EXPECT_TRUE(pose_graph.IsValid(ImagePairToPairId(2, 3)));
+  EXPECT_TRUE(pose_graph.IsValid(ImagePairToPairId(3, 4)));
+  EXPECT_FALSE(pose_graph.IsValid(ImagePairToPairId(1, 3)));
+  EXPECT_FALSE(pose_graph.IsValid(ImagePairToPairId(2, 4)));
+  EXPECT_TRUE(pose_graph.IsValid(ImagePairToPairId(1, 4)));
+}
+
 }  // namespace
 }  // namespace colmap
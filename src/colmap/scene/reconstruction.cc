@@ -33,25 +33,37 @@
 #include "colmap/geometry/pose.h"
 #include "colmap/scene/database_cache.h"
 #include "colmap/scene/projection.h"
+#include "colmap/scene/reconstruction_delta.h"
 #include "colmap/scene/reconstruction_io_binary.h"
+#include "colmap/scene/reconstruction_io_mapped.h"
 #include "colmap/scene/reconstruction_io_text.h"
+#include "colmap/scene/reconstruction_statistics.h"
 #include "colmap/sensor/bitmap.h"
 #include "colmap/util/file.h"
 #include "colmap/util/ply.h"
 #include "colmap/util/threading.h"
 
+#include <algorithm>
 #include <set>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 
 namespace colmap {
 
 Reconstruction::Reconstruction() : num_reg_images_(0), max_point3D_id_(0) {}
 
 Reconstruction::Reconstruction(const Reconstruction& other)
+    : Reconstruction(other, other.points3D_) {}
+
+Reconstruction::Reconstruction(const Reconstruction& other,
+                               DenseIdMap<point3D_t, struct Point3D> points3D)
     : rigs_(other.rigs_),
       cameras_(other.cameras_),
       frames_(other.frames_),
       images_(other.images_),
-      points3D_(other.points3D_),
+      points3D_(std::move(points3D)),
+      points3D_index_(other.points3D_index_),
       reg_frame_ids_(other.reg_frame_ids_),
       num_reg_images_(other.num_reg_images_),
       max_point3D_id_(other.max_point3D_id_) {
@@ -74,6 +86,7 @@ Reconstruction& Reconstruction::operator=(const Reconstruction& other) {
     frames_ = other.frames_;
     images_ = other.images_;
     points3D_ = other.points3D_;
+    points3D_index_ = other.points3D_index_;
     reg_frame_ids_ = other.reg_frame_ids_;
     num_reg_images_ = other.num_reg_images_;
     max_point3D_id_ = other.max_point3D_id_;
@@ -91,6 +104,10 @@ Reconstruction& Reconstruction::operator=(const Reconstruction& other) {
   return *this;
 }
 
+Reconstruction Reconstruction::Snapshot() const {
+  return Reconstruction(*this, points3D_.Snapshot());
+}
+
 std::vector<image_t> Reconstruction::RegImageIds() const {
   std::vector<image_t> reg_image_ids;
   for (const frame_t frame_id : reg_frame_ids_) {
@@ -340,7 +357,8 @@ void Reconstruction::Load(const DatabaseCache& database_cache) {
       if (existing_image.NumPoints2D() == 0) {
         existing_image.SetPoints2D(image.Points2D());
       } else {
-        THROW_CHECK_EQ(image.NumPoints2D(), existing_image.NumPoints2D());
+        THROW_CHECK_EQ(database_cache.NumPoints2D(image_id),
+                       existing_image.NumPoints2D());
       }
     } else {
       AddImage(image);
@@ -535,7 +553,11 @@ void Reconstruction::AddPoint3D(const point3D_t point3D_id,
     }
     THROW_CHECK_LE(image.NumPoints3D(), image.NumPoints2D());
   }
+  const Eigen::Vector3d xyz = point3D.xyz;
   THROW_CHECK(points3D_.emplace(point3D_id, std::move(point3D)).second);
+  if (points3D_index_) {
+    MutablePoints3DIndex()->Insert(point3D_id, xyz);
+  }
 }
 
 point3D_t Reconstruction::AddPoint3D(const Eigen::Vector3d& xyz,
@@ -600,6 +622,9 @@ void Reconstruction::DeletePoint3D(const point3D_t point3D_id) {
   }
 
   points3D_.erase(point3D_id);
+  if (points3D_index_) {
+    MutablePoints3DIndex()->Remove(point3D_id);
+  }
 }
 
 void Reconstruction::DeleteObservation(const image_t image_id,
@@ -621,7 +646,7 @@ void Reconstruction::DeleteObservation(const image_t image_id,
 }
 
 void Reconstruction::DeleteAllPoints2DAndPoints3D() {
-  points3D_.clear();
+  ClearPoints3D();
   for (auto& [_, image] : images_) {
     image.SetPoints2D(std::vector<Eigen::Vector2d>(0));
   }
@@ -799,6 +824,9 @@ void Reconstruction::Transform(const Sim3d& new_from_old_world) {
   for (auto& [_, point3D] : points3D_) {
     point3D.xyz = new_from_old_world * point3D.xyz;
   }
+  if (points3D_index_) {
+    BuildPoints3DIndex();
+  }
 }
 
 Reconstruction Reconstruction::Crop(const Eigen::AlignedBox3d& bbox) const {
@@ -823,13 +851,26 @@ Reconstruction Reconstruction::Crop(const Eigen::AlignedBox3d& bbox) const {
     cropped_reconstruction.AddImage(std::move(image));
   }
   std::unordered_set<image_t> cropped_frame_ids;
-  for (const auto& [_, point3D] : points3D_) {
-    if (bbox.contains(point3D.xyz)) {
-      for (const auto& track_el : point3D.track.Elements()) {
-        cropped_frame_ids.insert(Image(track_el.image_id).FrameId());
+  auto AddCroppedPoint3D = [&](const struct Point3D& point3D) {
+    for (const auto& track_el : point3D.track.Elements()) {
+      cropped_frame_ids.insert(Image(track_el.image_id).FrameId());
+    }
+    cropped_reconstruction.AddPoint3D(
+        point3D.xyz, point3D.track, point3D.color);
+  };
+  if (points3D_index_) {
+    // Sort the identifiers to assign new identifiers in the same order as
+    // without the index.
+    std::vector<point3D_t> point3D_ids = points3D_index_->QueryBox(bbox);
+    std::sort(point3D_ids.begin(), point3D_ids.end());
+    for (const point3D_t point3D_id : point3D_ids) {
+      AddCroppedPoint3D(Point3D(point3D_id));
+    }
+  } else {
+    for (const auto& [_, point3D] : points3D_) {
+      if (bbox.contains(point3D.xyz)) {
+        AddCroppedPoint3D(point3D);
       }
-      cropped_reconstruction.AddPoint3D(
-          point3D.xyz, point3D.track, point3D.color);
     }
   }
   for (const auto& [frame_id, _] : cropped_reconstruction.Frames()) {
@@ -840,6 +881,199 @@ Reconstruction Reconstruction::Crop(const Eigen::AlignedBox3d& bbox) const {
   return cropped_reconstruction;
 }
 
+void Reconstruction::BuildPoints3DIndex() {
+  auto points3D_index = std::make_shared<Point3DOctree>();
+  for (const auto& [point3D_id, point3D] : points3D_) {
+    points3D_index->Insert(point3D_id, point3D.xyz);
+  }
+  points3D_index_ = std::move(points3D_index);
+}
+
+void Reconstruction::ClearPoints3DIndex() { points3D_index_.reset(); }
+
+namespace {
+
+// Compare the entities of two reconstructions by value and collect the added
+// or modified entities as well as the identifiers of the deleted entities.
+template <typename Map,
+          typename Equal,
+          typename ID = typename Map::key_type,
+          typename T = typename Map::mapped_type>
+void ComputeEntityDelta(const Map& entities,
+                        const Map& base_entities,
+                        Equal&& equal,
+                        std::vector<T>* changed_entities,
+                        std::vector<ID>* deleted_ids) {
+  std::vector<ID> changed_ids;
+  for (const auto& [id, entity] : entities) {
+    const auto base_it = base_entities.find(id);
+    if (base_it == base_entities.end() || !equal(entity, base_it->second)) {
+      changed_ids.push_back(id);
+    }
+  }
+  std::sort(changed_ids.begin(), changed_ids.end());
+  changed_entities->reserve(changed_ids.size());
+  for (const ID id : changed_ids) {
+    changed_entities->push_back(entities.at(id));
+  }
+
+  for (const auto& [id, _] : base_entities) {
+    if (entities.count(id) == 0) {
+      deleted_ids->push_back(id);
+    }
+  }
+  std::sort(deleted_ids->begin(), deleted_ids->end());
+}
+
+}  // namespace
+
+ReconstructionDelta Reconstruction::ComputeDelta(
+    const Reconstruction& base) const {
+  ReconstructionDelta delta;
+
+  ComputeEntityDelta(cameras_,
+                     base.cameras_,
+                     std::equal_to<struct Camera>(),
+                     &delta.cameras,
+                     &delta.deleted_camera_ids);
+  ComputeEntityDelta(rigs_,
+                     base.rigs_,
+                     std::equal_to<class Rig>(),
+                     &delta.rigs,
+                     &delta.deleted_rig_ids);
+  ComputeEntityDelta(frames_,
+                     base.frames_,
+                     std::equal_to<class Frame>(),
+                     &delta.frames,
+                     &delta.deleted_frame_ids);
+  // The pose of images is stored in their frames, so images are compared
+  // without their pose, which would otherwise dereference the frame pointers.
+  ComputeEntityDelta(
+      images_,
+      base.images_,
+      [](const class Image& image, const class Image& base_image) {
+        return image.CameraId() == base_image.CameraId() &&
+               image.FrameId() == base_image.FrameId() &&
+               image.Name() == base_image.Name() &&
+               image.NumPoints3D() == base_image.NumPoints3D() &&
+               image.Points2D() == base_image.Points2D();
+      },
+      &delta.images,
+      &delta.deleted_image_ids);
+  for (class Frame& frame : delta.frames) {
+    frame.ResetRigPtr();
+  }
+  for (class Image& image : delta.images) {
+    image.ResetCameraPtr();
+    image.ResetFramePtr();
+  }
+
+  // Chunks of 3D points still shared with the base are unchanged, so only the
+  // points in chunks modified by either reconstruction must be compared.
+  std::vector<point3D_t> point3D_ids;
+  points3D_.ForEachUnsharedId(
+      base.points3D_,
+      [&point3D_ids](const point3D_t point3D_id) {
+        point3D_ids.push_back(point3D_id);
+      });
+  std::sort(point3D_ids.begin(), point3D_ids.end());
+  point3D_ids.erase(std::unique(point3D_ids.begin(), point3D_ids.end()),
+                    point3D_ids.end());
+  for (const point3D_t point3D_id : point3D_ids) {
+    const auto point3D_it = points3D_.find(point3D_id);
+    const auto base_point3D_it = base.points3D_.find(point3D_id);
+    if (point3D_it == points3D_.end()) {
+      if (base_point3D_it != base.points3D_.end()) {
+        delta.deleted_point3D_ids.push_back(point3D_id);
+      }
+    } else if (base_point3D_it == base.points3D_.end() ||
+               point3D_it->second != base_point3D_it->second) {
+      delta.points3D.emplace_back(point3D_id, point3D_it->second);
+    }
+  }
+
+  delta.reg_frame_ids = reg_frame_ids_;
+  delta.max_point3D_id = max_point3D_id_;
+
+  return delta;
+}
+
+void Reconstruction::ApplyDelta(const ReconstructionDelta& delta) {
+  for (const point3D_t point3D_id : delta.deleted_point3D_ids) {
+    points3D_.erase(point3D_id);
+    if (points3D_index_) {
+      MutablePoints3DIndex()->Remove(point3D_id);
+    }
+  }
+  for (const image_t image_id : delta.deleted_image_ids) {
+    images_.erase(image_id);
+  }
+  for (const frame_t frame_id : delta.deleted_frame_ids) {
+    frames_.erase(frame_id);
+  }
+  for (const rig_t rig_id : delta.deleted_rig_ids) {
+    rigs_.erase(rig_id);
+  }
+  for (const camera_t camera_id : delta.deleted_camera_ids) {
+    cameras_.erase(camera_id);
+  }
+
+  // Entities are replaced in place, so that the pointers of other entities
+  // remain valid. The pointers of replaced frames and images are set below.
+  for (const struct Camera& camera : delta.cameras) {
+    cameras_[camera.camera_id] = camera;
+  }
+  for (const class Rig& rig : delta.rigs) {
+    rigs_[rig.RigId()] = rig;
+  }
+  for (const class Frame& frame : delta.frames) {
+    class Frame& new_frame = frames_[frame.FrameId()];
+    new_frame = frame;
+    new_frame.ResetRigPtr();
+  }
+  for (const class Image& image : delta.images) {
+    class Image& new_image = images_[image.ImageId()];
+    new_image = image;
+    new_image.ResetCameraPtr();
+    new_image.ResetFramePtr();
+  }
+
+  for (auto& [_, frame] : frames_) {
+    if (!frame.HasRigPtr()) {
+      frame.SetRigPtr(&Rig(frame.RigId()));
+    }
+  }
+  for (auto& [_, image] : images_) {
+    if (!image.HasCameraPtr()) {
+      image.SetCameraPtr(&Camera(image.CameraId()));
+    }
+    if (!image.HasFramePtr()) {
+      image.SetFramePtr(&Frame(image.FrameId()));
+    }
+  }
+
+  for (const auto& [point3D_id, point3D] : delta.points3D) {
+    points3D_[point3D_id] = point3D;
+    if (points3D_index_) {
+      Point3DOctree* points3D_index = MutablePoints3DIndex();
+      if (points3D_index->Exists(point3D_id)) {
+        points3D_index->Update(point3D_id, point3D.xyz);
+      } else {
+        points3D_index->Insert(point3D_id, point3D.xyz);
+      }
+    }
+  }
+
+  reg_frame_ids_ = delta.reg_frame_ids;
+  num_reg_images_ = 0;
+  for (const frame_t frame_id : reg_frame_ids_) {
+    const class Frame& frame = Frame(frame_id);
+    num_reg_images_ +=
+        std::distance(frame.ImageIds().begin(), frame.ImageIds().end());
+  }
+  max_point3D_id_ = delta.max_point3D_id;
+}
+
 const class Image* Reconstruction::FindImageWithName(
     const std::string& name) const {
   for (const auto& [_, image] : images_) {
@@ -852,15 +1086,24 @@ const class Image* Reconstruction::FindImageWithName(
 
 std::vector<std::pair<image_t, image_t>> Reconstruction::FindCommonRegImageIds(
     const Reconstruction& other) const {
+  // Index the images of the other reconstruction by name instead of searching
+  // them linearly for every image.
+  std::unordered_map<std::string_view, const class Image*> other_images;
+  other_images.reserve(other.NumImages());
+  for (const auto& [_, other_image] : other.images_) {
+    other_images.emplace(other_image.Name(), &other_image);
+  }
+
   std::vector<std::pair<image_t, image_t>> common_reg_image_ids;
   for (const frame_t frame_id : reg_frame_ids_) {
     const auto& frame = Frame(frame_id);
     for (const data_t& data_id : frame.ImageIds()) {
       const auto& image = Image(data_id.id);
-      const auto* other_image = other.FindImageWithName(image.Name());
-      if (other_image != nullptr && other_image->FramePtr()->HasPose()) {
+      const auto other_image_it = other_images.find(image.Name());
+      if (other_image_it != other_images.end() &&
+          other_image_it->second->FramePtr()->HasPose()) {
         common_reg_image_ids.emplace_back(image.ImageId(),
-                                          other_image->ImageId());
+                                          other_image_it->second->ImageId());
       }
     }
   }
@@ -871,7 +1114,7 @@ void Reconstruction::TranscribeImageIdsToDatabase(const Database& database) {
   std::unordered_map<image_t, image_t> old_to_new_image_ids;
   old_to_new_image_ids.reserve(NumImages());
 
-  std::unordered_map<image_t, class Image> new_images;
+  DenseIdMap<image_t, class Image> new_images;
   new_images.reserve(NumImages());
 
   for (auto& [_, image] : images_) {
@@ -954,26 +1197,25 @@ double Reconstruction::ComputeMeanReprojectionError() const {
 }
 
 void Reconstruction::UpdatePoint3DErrors() {
-  for (auto& [_, point3D] : points3D_) {
-    if (point3D.track.Length() == 0) {
-      point3D.error = 0;
-      continue;
-    }
-    point3D.error = 0;
-    for (const auto& track_el : point3D.track.Elements()) {
-      const auto& image = Image(track_el.image_id);
-      const auto& point2D = image.Point2D(track_el.point2D_idx);
-      const auto& camera = *image.CameraPtr();
-      point3D.error += std::sqrt(CalculateSquaredReprojectionError(
-          point2D.xy, point3D.xyz, image.CamFromWorld(), camera));
-    }
-    point3D.error /= point3D.track.Length();
+  std::vector<point3D_t> point3D_ids;
+  point3D_ids.reserve(points3D_.size());
+  for (const auto& [point3D_id, _] : std::as_const(points3D_)) {
+    point3D_ids.push_back(point3D_id);
+  }
+
+  Point3DStatisticsOptions options;
+  options.compute_tri_angle = false;
+  const std::vector<Point3DStatistics> stats =
+      ComputePoint3DStatistics(*this, point3D_ids, options);
+  for (size_t i = 0; i < point3D_ids.size(); ++i) {
+    points3D_.at(point3D_ids[i]).error = stats[i].mean_error;
   }
 }
 
 void Reconstruction::Read(const std::filesystem::path& path) {
   if (ExistsFile(path / "cameras.bin") && ExistsFile(path / "images.bin") &&
-      ExistsFile(path / "points3D.bin")) {
+      (ExistsFile(path / "points3D.bin") ||
+       ExistsFile(path / "points3D.mbin"))) {
     ReadBinary(path);
   } else if (ExistsFile(path / "cameras.txt") &&
              ExistsFile(path / "images.txt") &&
@@ -995,7 +1237,7 @@ void Reconstruction::ReadText(const std::filesystem::path& path) {
   rigs_.clear();
   frames_.clear();
   images_.clear();
-  points3D_.clear();
+  ClearPoints3D();
   ReadCamerasText(*this, path / "cameras.txt");
   const auto rigs_path = path / "rigs.txt";
   if (ExistsFile(rigs_path)) {
@@ -1014,7 +1256,7 @@ void Reconstruction::ReadBinary(const std::filesystem::path& path) {
   rigs_.clear();
   frames_.clear();
   images_.clear();
-  points3D_.clear();
+  ClearPoints3D();
   ReadCamerasBinary(*this, path / "cameras.bin");
   const auto rigs_path = path / "rigs.bin";
   if (ExistsFile(rigs_path)) {
@@ -1025,7 +1267,12 @@ void Reconstruction::ReadBinary(const std::filesystem::path& path) {
     ReadFramesBinary(*this, frames_path);
   }
   ReadImagesBinary(*this, path / "images.bin");
-  ReadPoints3DBinary(*this, path / "points3D.bin");
+  const auto points3D_path = path / "points3D.bin";
+  if (ExistsFile(points3D_path)) {
+    ReadPoints3DBinary(*this, points3D_path);
+  } else {
+    ReadPoints3DMapped(*this, path / "points3D.mbin");
+  }
 }
 
 void Reconstruction::WriteText(const std::filesystem::path& path) const {
@@ -1046,6 +1293,19 @@ void Reconstruction::WriteBinary(const std::filesystem::path& path) const {
   WritePoints3DBinary(*this, path / "points3D.bin");
 }
 
+void Reconstruction::WriteMappedBinary(
+    const std::filesystem::path& path) const {
+  THROW_CHECK_DIR_EXISTS(path);
+  WriteRigsBinary(*this, path / "rigs.bin");
+  WriteCamerasBinary(*this, path / "cameras.bin");
+  WriteFramesBinary(*this, path / "frames.bin");
+  WriteImagesBinary(*this, path / "images.bin");
+  WritePoints3DMapped(*this, path / "points3D.mbin");
+  // The regular points file takes precedence when reading, so remove any
+  // stale one from a previous export.
+  std::filesystem::remove(path / "points3D.bin");
+}
+
 std::vector<PlyPoint> Reconstruction::ConvertToPLY() const {
   std::vector<PlyPoint> ply_points;
   ply_points.reserve(points3D_.size());
@@ -1065,7 +1325,7 @@ std::vector<PlyPoint> Reconstruction::ConvertToPLY() const {
 }
 
 void Reconstruction::ImportPLY(const std::filesystem::path& path) {
-  points3D_.clear();
+  ClearPoints3D();
 
   const auto ply_points = ReadPly(path);
 
@@ -1079,7 +1339,7 @@ void Reconstruction::ImportPLY(const std::filesystem::path& path) {
 }
 
 void Reconstruction::ImportPLY(const std::vector<PlyPoint>& ply_points) {
-  points3D_.clear();
+  ClearPoints3D();
   points3D_.reserve(ply_points.size());
   for (const auto& ply_point : ply_points) {
     AddPoint3D(Eigen::Vector3d(ply_point.x, ply_point.y, ply_point.z),
@@ -1180,6 +1440,20 @@ void Reconstruction::ExtractColorsForAllImages(
   }
 }
 
+void Reconstruction::ClearPoints3D() {
+  points3D_.clear();
+  if (points3D_index_) {
+    points3D_index_ = std::make_shared<Point3DOctree>();
+  }
+}
+
+Point3DOctree* Reconstruction::MutablePoints3DIndex() {
+  if (points3D_index_.use_count() > 1) {
+    points3D_index_ = std::make_shared<Point3DOctree>(*points3D_index_);
+  }
+  return points3D_index_.get();
+}
+
 void Reconstruction::CreateImageDirs(const std::filesystem::path& path) const {
   std::set<std::filesystem::path> image_dirs;
   for (const auto& [_, image] : images_) {
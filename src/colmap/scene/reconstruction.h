@@ -34,12 +34,15 @@
 #include "colmap/scene/database.h"
 #include "colmap/scene/image.h"
 #include "colmap/scene/point3d.h"
+#include "colmap/scene/point3d_octree.h"
 #include "colmap/scene/track.h"
 #include "colmap/sensor/rig.h"
+#include "colmap/util/dense_id_map.h"
 #include "colmap/util/eigen_alignment.h"
 #include "colmap/util/types.h"
 
 #include <filesystem>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -49,6 +52,7 @@
 namespace colmap {
 
 struct PlyPoint;
+struct ReconstructionDelta;
 class DatabaseCache;
 
 // Reconstruction class holds all information about a single reconstructed
@@ -62,6 +66,13 @@ class Reconstruction {
   Reconstruction(const Reconstruction& other);
   Reconstruction& operator=(const Reconstruction& other);
 
+  // Copy that shares the 3D points copy-on-write with this reconstruction (see
+  // DenseIdMap::Snapshot), so that snapshots are cheap for readers, e.g., in
+  // other threads, while the original continues to be modified. All other
+  // entities are copied deeply. References to 3D points obtained before the
+  // snapshot must not be used to modify this reconstruction afterwards.
+  Reconstruction Snapshot() const;
+
   // Get number of objects.
   inline size_t NumRigs() const;
   inline size_t NumCameras() const;
@@ -88,10 +99,10 @@ class Reconstruction {
   // Get reference to all objects.
   inline const std::unordered_map<rig_t, class Rig>& Rigs() const;
   inline const std::unordered_map<camera_t, struct Camera>& Cameras() const;
-  inline const std::unordered_map<frame_t, class Frame>& Frames() const;
+  inline const DenseIdMap<frame_t, class Frame>& Frames() const;
   inline const std::vector<frame_t>& RegFrameIds() const;
-  inline const std::unordered_map<image_t, class Image>& Images() const;
-  inline const std::unordered_map<point3D_t, struct Point3D>& Points3D() const;
+  inline const DenseIdMap<image_t, class Image>& Images() const;
+  inline const DenseIdMap<point3D_t, struct Point3D>& Points3D() const;
 
   // Identifiers of all registered images.
   std::vector<image_t> RegImageIds() const;
@@ -108,7 +119,8 @@ class Reconstruction {
   // Check whether the reconstruction object is internally consistent.
   bool IsValid() const;
 
-  // Load data from given `DatabaseCache`.
+  // Load data from given `DatabaseCache`. If the cache loads the points2D on
+  // demand, the new images have no points2D until they are set explicitly.
   void Load(const DatabaseCache& database_cache);
 
   // Finalize the Reconstruction after the reconstruction has finished.
@@ -217,9 +229,30 @@ class Reconstruction {
   // Creates a cropped reconstruction using the input bounds as corner points
   // of the bounding box containing the included 3D points of the new
   // reconstruction. Only the cameras and images of the included points are
-  // registered.
+  // registered. Uses the spatial index of the 3D points, if it was built.
   Reconstruction Crop(const Eigen::AlignedBox3d& bbox) const;
 
+  // Build a spatial index over the 3D points for box, frustum, and nearest
+  // neighbor queries. The index is kept up to date when adding, deleting, or
+  // transforming 3D points, but not when modifying their positions through
+  // Point3D(point3D_id), after which it must be built again.
+  void BuildPoints3DIndex();
+
+  // Remove the spatial index of the 3D points.
+  void ClearPoints3DIndex();
+
+  // The spatial index of the 3D points or nullptr, if it was not built.
+  inline const Point3DOctree* Points3DIndex() const;
+
+  // Compute the changes from the given base to this reconstruction, such that
+  // applying the delta to the base yields this reconstruction. The base is
+  // typically an earlier snapshot of this reconstruction, in which case only
+  // the chunks of 3D points modified since the snapshot are compared.
+  ReconstructionDelta ComputeDelta(const Reconstruction& base) const;
+
+  // Apply the changes computed by ComputeDelta to the base reconstruction.
+  void ApplyDelta(const ReconstructionDelta& delta);
+
   // Find specific image by name. Note that this uses linear search.
   const class Image* FindImageWithName(const std::string& name) const;
 
@@ -242,6 +275,7 @@ class Reconstruction {
   void UpdatePoint3DErrors();
 
   // Read data from text or binary file. Prefer binary data if it exists.
+  // Binary models may store their 3D points in the memory-mappable format.
   void Read(const std::filesystem::path& path);
   // Write reconstruction data to disk (binary format).
   void Write(const std::filesystem::path& path) const;
@@ -253,6 +287,9 @@ class Reconstruction {
   // Write data from binary/text file.
   void WriteText(const std::filesystem::path& path) const;
   void WriteBinary(const std::filesystem::path& path) const;
+  // Write binary data with the 3D points in the memory-mappable format
+  // (points3D.mbin), see reconstruction_io_mapped.h.
+  void WriteMappedBinary(const std::filesystem::path& path) const;
 
   // Convert 3D points in reconstruction to PLY point cloud.
   std::vector<PlyPoint> ConvertToPLY() const;
@@ -287,14 +324,27 @@ class Reconstruction {
   void CreateImageDirs(const std::filesystem::path& path) const;
 
  private:
+  Reconstruction(const Reconstruction& other,
+                 DenseIdMap<point3D_t, struct Point3D> points3D);
+
   std::pair<Eigen::AlignedBox3d, Eigen::Vector3d> ComputeBBBoxAndCentroid(
       double min_percentile, double max_percentile, bool use_images) const;
 
+  // Remove all 3D points without updating the images.
+  void ClearPoints3D();
+
+  // The spatial index, which is shared copy-on-write between copies.
+  Point3DOctree* MutablePoints3DIndex();
+
   std::unordered_map<rig_t, class Rig> rigs_;
   std::unordered_map<camera_t, struct Camera> cameras_;
-  std::unordered_map<frame_t, class Frame> frames_;
-  std::unordered_map<image_t, class Image> images_;
-  std::unordered_map<point3D_t, struct Point3D> points3D_;
+  // Frame, image, and point ids are mostly assigned consecutively, so they are
+  // stored densely.
+  DenseIdMap<frame_t, class Frame> frames_;
+  DenseIdMap<image_t, class Image> images_;
+  DenseIdMap<point3D_t, struct Point3D> points3D_;
+  // Optional spatial index of the 3D points.
+  std::shared_ptr<Point3DOctree> points3D_index_;
 
   // Unique set of frame_ids where `Frame(frame_id).HasPose() == true`.
   // Note that we intentionally use a vector instead of a set here leading
@@ -427,11 +477,11 @@ const std::unordered_map<camera_t, Camera>& Reconstruction::Cameras() const {
   return cameras_;
 }
 
-const std::unordered_map<frame_t, class Frame>& Reconstruction::Frames() const {
+const DenseIdMap<frame_t, class Frame>& Reconstruction::Frames() const {
   return frames_;
 }
 
-const std::unordered_map<image_t, class Image>& Reconstruction::Images() const {
+const DenseIdMap<image_t, class Image>& Reconstruction::Images() const {
   return images_;
 }
 
@@ -439,10 +489,14 @@ const std::vector<frame_t>& Reconstruction::RegFrameIds() const {
   return reg_frame_ids_;
 }
 
-const std::unordered_map<point3D_t, Point3D>& Reconstruction::Points3D() const {
+const DenseIdMap<point3D_t, Point3D>& Reconstruction::Points3D() const {
   return points3D_;
 }
 
+const Point3DOctree* Reconstruction::Points3DIndex() const {
+  return points3D_index_.get();
+}
+
 bool Reconstruction::ExistsRig(const rig_t rig_id) const {
   return rigs_.find(rig_id) != rigs_.end();
 }
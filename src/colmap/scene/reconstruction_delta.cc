@@ -0,0 +1,362 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/scene/reconstruction_delta.h"
+
+#include "colmap/geometry/rigid3.h"
+#include "colmap/util/endian.h"
+#include "colmap/util/logging.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace colmap {
+namespace {
+
+constexpr char kMagic[8] = {'C', 'O', 'L', 'M', 'A', 'P', 'D', 'L'};
+constexpr uint32_t kVersion = 1;
+
+void WriteRigid3d(const Rigid3d& tform, std::ostream& stream) {
+  WriteBinaryLittleEndian<double>(&stream, tform.rotation().w());
+  WriteBinaryLittleEndian<double>(&stream, tform.rotation().x());
+  WriteBinaryLittleEndian<double>(&stream, tform.rotation().y());
+  WriteBinaryLittleEndian<double>(&stream, tform.rotation().z());
+  WriteBinaryLittleEndian<double>(&stream, tform.translation().x());
+  WriteBinaryLittleEndian<double>(&stream, tform.translation().y());
+  WriteBinaryLittleEndian<double>(&stream, tform.translation().z());
+}
+
+Rigid3d ReadRigid3d(std::istream& stream) {
+  Rigid3d tform;
+  tform.rotation().w() = ReadBinaryLittleEndian<double>(&stream);
+  tform.rotation().x() = ReadBinaryLittleEndian<double>(&stream);
+  tform.rotation().y() = ReadBinaryLittleEndian<double>(&stream);
+  tform.rotation().z() = ReadBinaryLittleEndian<double>(&stream);
+  tform.translation().x() = ReadBinaryLittleEndian<double>(&stream);
+  tform.translation().y() = ReadBinaryLittleEndian<double>(&stream);
+  tform.translation().z() = ReadBinaryLittleEndian<double>(&stream);
+  return tform;
+}
+
+void WriteSensorId(const sensor_t& sensor_id, std::ostream& stream) {
+  WriteBinaryLittleEndian<int>(&stream, static_cast<int>(sensor_id.type));
+  WriteBinaryLittleEndian<uint32_t>(&stream, sensor_id.id);
+}
+
+sensor_t ReadSensorId(std::istream& stream) {
+  sensor_t sensor_id;
+  sensor_id.type =
+      static_cast<SensorType>(ReadBinaryLittleEndian<int>(&stream));
+  sensor_id.id = ReadBinaryLittleEndian<uint32_t>(&stream);
+  return sensor_id;
+}
+
+template <typename T>
+void WriteIds(const std::vector<T>& ids, std::ostream& stream) {
+  WriteBinaryLittleEndian<uint64_t>(&stream, ids.size());
+  for (const T id : ids) {
+    WriteBinaryLittleEndian<T>(&stream, id);
+  }
+}
+
+template <typename T>
+std::vector<T> ReadIds(std::istream& stream) {
+  std::vector<T> ids(ReadBinaryLittleEndian<uint64_t>(&stream));
+  for (T& id : ids) {
+    id = ReadBinaryLittleEndian<T>(&stream);
+  }
+  return ids;
+}
+
+void WriteCamera(const Camera& camera, std::ostream& stream) {
+  WriteBinaryLittleEndian<camera_t>(&stream, camera.camera_id);
+  WriteBinaryLittleEndian<int>(&stream, static_cast<int>(camera.model_id));
+  WriteBinaryLittleEndian<uint64_t>(&stream, camera.width);
+  WriteBinaryLittleEndian<uint64_t>(&stream, camera.height);
+  WriteBinaryLittleEndian<uint8_t>(&stream,
+                                   camera.has_prior_focal_length ? 1 : 0);
+  WriteBinaryLittleEndian<uint64_t>(&stream, camera.params.size());
+  for (const double param : camera.params) {
+    WriteBinaryLittleEndian<double>(&stream, param);
+  }
+}
+
+Camera ReadCamera(std::istream& stream) {
+  Camera camera;
+  camera.camera_id = ReadBinaryLittleEndian<camera_t>(&stream);
+  camera.model_id =
+      static_cast<CameraModelId>(ReadBinaryLittleEndian<int>(&stream));
+  camera.width = ReadBinaryLittleEndian<uint64_t>(&stream);
+  camera.height = ReadBinaryLittleEndian<uint64_t>(&stream);
+  camera.has_prior_focal_length = ReadBinaryLittleEndian<uint8_t>(&stream);
+  camera.params.resize(ReadBinaryLittleEndian<uint64_t>(&stream));
+  ReadBinaryLittleEndian<double>(&stream, &camera.params);
+  THROW_CHECK(camera.VerifyParams());
+  return camera;
+}
+
+void WriteRig(const Rig& rig, std::ostream& stream) {
+  WriteBinaryLittleEndian<rig_t>(&stream, rig.RigId());
+  WriteBinaryLittleEndian<uint32_t>(&stream, rig.NumSensors());
+  if (rig.NumSensors() > 0) {
+    WriteSensorId(rig.RefSensorId(), stream);
+  }
+  for (const auto& [sensor_id, sensor_from_rig] : rig.NonRefSensors()) {
+    WriteSensorId(sensor_id, stream);
+    WriteBinaryLittleEndian<uint8_t>(&stream,
+                                     sensor_from_rig.has_value() ? 1 : 0);
+    if (sensor_from_rig.has_value()) {
+      WriteRigid3d(*sensor_from_rig, stream);
+    }
+  }
+}
+
+Rig ReadRig(std::istream& stream) {
+  Rig rig;
+  rig.SetRigId(ReadBinaryLittleEndian<rig_t>(&stream));
+  const uint32_t num_sensors = ReadBinaryLittleEndian<uint32_t>(&stream);
+  if (num_sensors > 0) {
+    rig.AddRefSensor(ReadSensorId(stream));
+  }
+  for (uint32_t i = 1; i < num_sensors; ++i) {
+    const sensor_t sensor_id = ReadSensorId(stream);
+    std::optional<Rigid3d> sensor_from_rig;
+    if (ReadBinaryLittleEndian<uint8_t>(&stream)) {
+      sensor_from_rig = ReadRigid3d(stream);
+    }
+    rig.AddSensor(sensor_id, sensor_from_rig);
+  }
+  return rig;
+}
+
+void WriteFrame(const Frame& frame, std::ostream& stream) {
+  WriteBinaryLittleEndian<frame_t>(&stream, frame.FrameId());
+  WriteBinaryLittleEndian<rig_t>(&stream, frame.RigId());
+  WriteBinaryLittleEndian<uint8_t>(&stream, frame.HasPose() ? 1 : 0);
+  if (frame.HasPose()) {
+    WriteRigid3d(frame.RigFromWorld(), stream);
+  }
+  WriteBinaryLittleEndian<uint32_t>(&stream, frame.NumDataIds());
+  for (const data_t& data_id : frame.DataIds()) {
+    WriteSensorId(data_id.sensor_id, stream);
+    WriteBinaryLittleEndian<uint64_t>(&stream, data_id.id);
+  }
+}
+
+Frame ReadFrame(std::istream& stream) {
+  Frame frame;
+  frame.SetFrameId(ReadBinaryLittleEndian<frame_t>(&stream));
+  frame.SetRigId(ReadBinaryLittleEndian<rig_t>(&stream));
+  if (ReadBinaryLittleEndian<uint8_t>(&stream)) {
+    frame.SetRigFromWorld(ReadRigid3d(stream));
+  }
+  const uint32_t num_data_ids = ReadBinaryLittleEndian<uint32_t>(&stream);
+  for (uint32_t i = 0; i < num_data_ids; ++i) {
+    data_t data_id;
+    data_id.sensor_id = ReadSensorId(stream);
+    data_id.id = ReadBinaryLittleEndian<uint64_t>(&stream);
+    frame.AddDataId(data_id);
+  }
+  return frame;
+}
+
+void WriteImage(const Image& image, std::ostream& stream) {
+  WriteBinaryLittleEndian<image_t>(&stream, image.ImageId());
+  WriteBinaryLittleEndian<camera_t>(&stream, image.CameraId());
+  WriteBinaryLittleEndian<frame_t>(&stream, image.FrameId());
+  const std::string name = image.Name() + '\0';
+  stream.write(name.c_str(), name.size());
+  WriteBinaryLittleEndian<uint64_t>(&stream, image.NumPoints2D());
+  for (const Point2D& point2D : image.Points2D()) {
+    WriteBinaryLittleEndian<double>(&stream, point2D.xy(0));
+    WriteBinaryLittleEndian<double>(&stream, point2D.xy(1));
+    WriteBinaryLittleEndian<point3D_t>(&stream, point2D.point3D_id);
+  }
+}
+
+Image ReadImage(std::istream& stream) {
+  Image image;
+  image.SetImageId(ReadBinaryLittleEndian<image_t>(&stream));
+  image.SetCameraId(ReadBinaryLittleEndian<camera_t>(&stream));
+  image.SetFrameId(ReadBinaryLittleEndian<frame_t>(&stream));
+  std::getline(stream, image.Name(), '\0');
+  const size_t num_points2D = ReadBinaryLittleEndian<uint64_t>(&stream);
+  std::vector<Eigen::Vector2d> points2D(num_points2D);
+  std::vector<point3D_t> point3D_ids(num_points2D);
+  for (size_t i = 0; i < num_points2D; ++i) {
+    points2D[i](0) = ReadBinaryLittleEndian<double>(&stream);
+    points2D[i](1) = ReadBinaryLittleEndian<double>(&stream);
+    point3D_ids[i] = ReadBinaryLittleEndian<point3D_t>(&stream);
+  }
+  image.SetPoints2D(points2D);
+  for (point2D_t point2D_idx = 0; point2D_idx < num_points2D; ++point2D_idx) {
+    if (point3D_ids[point2D_idx] != kInvalidPoint3DId) {
+      image.SetPoint3DForPoint2D(point2D_idx, point3D_ids[point2D_idx]);
+    }
+  }
+  return image;
+}
+
+void WritePoint3D(const point3D_t point3D_id,
+                  const Point3D& point3D,
+                  std::ostream& stream) {
+  WriteBinaryLittleEndian<point3D_t>(&stream, point3D_id);
+  WriteBinaryLittleEndian<double>(&stream, point3D.xyz(0));
+  WriteBinaryLittleEndian<double>(&stream, point3D.xyz(1));
+  WriteBinaryLittleEndian<double>(&stream, point3D.xyz(2));
+  WriteBinaryLittleEndian<uint8_t>(&stream, point3D.color(0));
+  WriteBinaryLittleEndian<uint8_t>(&stream, point3D.color(1));
+  WriteBinaryLittleEndian<uint8_t>(&stream, point3D.color(2));
+  WriteBinaryLittleEndian<double>(&stream, point3D.error);
+  WriteBinaryLittleEndian<uint64_t>(&stream, point3D.track.Length());
+  for (const TrackElement& track_el : point3D.track.Elements()) {
+    WriteBinaryLittleEndian<image_t>(&stream, track_el.image_id);
+    WriteBinaryLittleEndian<point2D_t>(&stream, track_el.point2D_idx);
+  }
+}
+
+std::pair<point3D_t, Point3D> ReadPoint3D(std::istream& stream) {
+  std::pair<point3D_t, Point3D> point3D;
+  point3D.first = ReadBinaryLittleEndian<point3D_t>(&stream);
+  point3D.second.xyz(0) = ReadBinaryLittleEndian<double>(&stream);
+  point3D.second.xyz(1) = ReadBinaryLittleEndian<double>(&stream);
+  point3D.second.xyz(2) = ReadBinaryLittleEndian<double>(&stream);
+  point3D.second.color(0) = ReadBinaryLittleEndian<uint8_t>(&stream);
+  point3D.second.color(1) = ReadBinaryLittleEndian<uint8_t>(&stream);
+  point3D.second.color(2) = ReadBinaryLittleEndian<uint8_t>(&stream);
+  point3D.second.error = ReadBinaryLittleEndian<double>(&stream);
+  const size_t track_length = ReadBinaryLittleEndian<uint64_t>(&stream);
+  point3D.second.track.Reserve(track_length);
+  for (size_t i = 0; i < track_length; ++i) {
+    const image_t image_id = ReadBinaryLittleEndian<image_t>(&stream);
+    const point2D_t point2D_idx = ReadBinaryLittleEndian<point2D_t>(&stream);
+    point3D.second.track.AddElement(image_id, point2D_idx);
+  }
+  return point3D;
+}
+
+template <typename T, typename WriteFunc>
+void WriteEntities(const std::vector<T>& entities,
+                   WriteFunc&& write_func,
+                   std::ostream& stream) {
+  WriteBinaryLittleEndian<uint64_t>(&stream, entities.size());
+  for (const T& entity : entities) {
+    write_func(entity, stream);
+  }
+}
+
+template <typename T, typename ReadFunc>
+std::vector<T> ReadEntities(ReadFunc&& read_func, std::istream& stream) {
+  std::vector<T> entities;
+  const size_t num_entities = ReadBinaryLittleEndian<uint64_t>(&stream);
+  entities.reserve(num_entities);
+  for (size_t i = 0; i < num_entities; ++i) {
+    entities.push_back(read_func(stream));
+  }
+  return entities;
+}
+
+}  // namespace
+
+bool ReconstructionDelta::HasEntityChanges() const {
+  return !cameras.empty() || !deleted_camera_ids.empty() || !rigs.empty() ||
+         !deleted_rig_ids.empty() || !frames.empty() ||
+         !deleted_frame_ids.empty() || !images.empty() ||
+         !deleted_image_ids.empty() || !points3D.empty() ||
+         !deleted_point3D_ids.empty();
+}
+
+void WriteReconstructionDelta(const ReconstructionDelta& delta,
+                              std::ostream& stream) {
+  THROW_CHECK(stream.good());
+
+  stream.write(kMagic, sizeof(kMagic));
+  WriteBinaryLittleEndian<uint32_t>(&stream, kVersion);
+
+  WriteEntities(delta.cameras, WriteCamera, stream);
+  WriteIds(delta.deleted_camera_ids, stream);
+  WriteEntities(delta.rigs, WriteRig, stream);
+  WriteIds(delta.deleted_rig_ids, stream);
+  WriteEntities(delta.frames, WriteFrame, stream);
+  WriteIds(delta.deleted_frame_ids, stream);
+  WriteEntities(delta.images, WriteImage, stream);
+  WriteIds(delta.deleted_image_ids, stream);
+  WriteBinaryLittleEndian<uint64_t>(&stream, delta.points3D.size());
+  for (const auto& [point3D_id, point3D] : delta.points3D) {
+    WritePoint3D(point3D_id, point3D, stream);
+  }
+  WriteIds(delta.deleted_point3D_ids, stream);
+  WriteIds(delta.reg_frame_ids, stream);
+  WriteBinaryLittleEndian<point3D_t>(&stream, delta.max_point3D_id);
+}
+
+void WriteReconstructionDelta(const ReconstructionDelta& delta,
+                              const std::filesystem::path& path) {
+  std::ofstream file(path, std::ios::trunc | std::ios::binary);
+  THROW_CHECK_FILE_OPEN(file, path);
+  WriteReconstructionDelta(delta, file);
+}
+
+ReconstructionDelta ReadReconstructionDelta(std::istream& stream) {
+  THROW_CHECK(stream.good());
+
+  char magic[sizeof(kMagic)];
+  stream.read(magic, sizeof(magic));
+  THROW_CHECK(stream.good() &&
+              std::memcmp(magic, kMagic, sizeof(kMagic)) == 0)
+      << "Not a reconstruction delta";
+  const uint32_t version = ReadBinaryLittleEndian<uint32_t>(&stream);
+  THROW_CHECK_EQ(version, kVersion) << "Unsupported reconstruction delta";
+
+  ReconstructionDelta delta;
+  delta.cameras = ReadEntities<Camera>(ReadCamera, stream);
+  delta.deleted_camera_ids = ReadIds<camera_t>(stream);
+  delta.rigs = ReadEntities<Rig>(ReadRig, stream);
+  delta.deleted_rig_ids = ReadIds<rig_t>(stream);
+  delta.frames = ReadEntities<Frame>(ReadFrame, stream);
+  delta.deleted_frame_ids = ReadIds<frame_t>(stream);
+  delta.images = ReadEntities<Image>(ReadImage, stream);
+  delta.deleted_image_ids = ReadIds<image_t>(stream);
+  delta.points3D =
+      ReadEntities<std::pair<point3D_t, Point3D>>(ReadPoint3D, stream);
+  delta.deleted_point3D_ids = ReadIds<point3D_t>(stream);
+  delta.reg_frame_ids = ReadIds<frame_t>(stream);
+  delta.max_point3D_id = ReadBinaryLittleEndian<point3D_t>(&stream);
+  THROW_CHECK(!stream.fail()) << "Truncated reconstruction delta";
+  return delta;
+}
+
+ReconstructionDelta ReadReconstructionDelta(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  THROW_CHECK_FILE_OPEN(file, path);
+  return ReadReconstructionDelta(file);
+}
+
+}  // namespace colmap
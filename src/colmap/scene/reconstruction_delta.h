@@ -0,0 +1,86 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "colmap/scene/camera.h"
+#include "colmap/scene/frame.h"
+#include "colmap/scene/image.h"
+#include "colmap/scene/point3d.h"
+#include "colmap/sensor/rig.h"
+#include "colmap/util/types.h"
+
+#include <filesystem>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace colmap {
+
+// Changes between two states of a reconstruction, which can be exported and
+// applied instead of transferring the full reconstruction, e.g., to stream the
+// progress of the reconstruction to a viewer. Added or modified entities are
+// stored in full and replace the existing entities when applying the delta.
+// See Reconstruction::ComputeDelta and Reconstruction::ApplyDelta.
+struct ReconstructionDelta {
+  std::vector<struct Camera> cameras;
+  std::vector<camera_t> deleted_camera_ids;
+
+  std::vector<class Rig> rigs;
+  std::vector<rig_t> deleted_rig_ids;
+
+  std::vector<class Frame> frames;
+  std::vector<frame_t> deleted_frame_ids;
+
+  std::vector<class Image> images;
+  std::vector<image_t> deleted_image_ids;
+
+  std::vector<std::pair<point3D_t, struct Point3D>> points3D;
+  std::vector<point3D_t> deleted_point3D_ids;
+
+  // The registered frames of the new state in the order of registration.
+  std::vector<frame_t> reg_frame_ids;
+
+  // The largest 3D point identifier ever assigned in the new state.
+  point3D_t max_point3D_id = 0;
+
+  // Whether any entities were added, modified, or deleted.
+  bool HasEntityChanges() const;
+};
+
+void WriteReconstructionDelta(const ReconstructionDelta& delta,
+                              std::ostream& stream);
+void WriteReconstructionDelta(const ReconstructionDelta& delta,
+                              const std::filesystem::path& path);
+
+ReconstructionDelta ReadReconstructionDelta(std::istream& stream);
+ReconstructionDelta ReadReconstructionDelta(const std::filesystem::path& path);
+
+}  // namespace colmap
@@ -0,0 +1,148 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/scene/reconstruction_delta.h"
+
+#include "colmap/math/random.h"
+#include "colmap/scene/reconstruction.h"
+#include "colmap/scene/reconstruction_matchers.h"
+#include "colmap/scene/synthetic.h"
+#include "colmap/util/testing.h"
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+Reconstruction CreateSyntheticReconstruction() {
+  SetPRNGSeed(1);
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 2;
+  synthetic_dataset_options.num_frames_per_rig = 3;
+  synthetic_dataset_options.num_points3D = 3000;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+  return reconstruction;
+}
+
+TEST(ReconstructionDelta, Unchanged) {
+  const Reconstruction reconstruction = CreateSyntheticReconstruction();
+  const Reconstruction base = reconstruction.Snapshot();
+  const ReconstructionDelta delta = reconstruction.ComputeDelta(base);
+  EXPECT_FALSE(delta.HasEntityChanges());
+  EXPECT_EQ(delta.reg_frame_ids, reconstruction.RegFrameIds());
+  EXPECT_EQ(delta.max_point3D_id, reconstruction.NumPoints3D());
+}
+
+TEST(ReconstructionDelta, ComputeAndApply) {
+  Reconstruction reconstruction = CreateSyntheticReconstruction();
+  reconstruction.BuildPoints3DIndex();
+  Reconstruction base = reconstruction.Snapshot();
+
+  // Modify a single 3D point, which only unshares its chunk.
+  const point3D_t modified_point3D_id = 1;
+  reconstruction.Point3D(modified_point3D_id).error = 0.5;
+
+  // Delete a 3D point and thereby modify the images of its track.
+  const point3D_t deleted_point3D_id = 2500;
+  std::set<image_t> modified_image_ids;
+  for (const TrackElement& track_el :
+       reconstruction.Point3D(deleted_point3D_id).track.Elements()) {
+    modified_image_ids.insert(track_el.image_id);
+  }
+  reconstruction.DeletePoint3D(deleted_point3D_id);
+
+  // Add a new 3D point.
+  const point3D_t added_point3D_id =
+      reconstruction.AddPoint3D(Eigen::Vector3d(1, 2, 3), Track());
+
+  // Modify a frame pose and a camera.
+  const frame_t modified_frame_id = reconstruction.RegFrameIds().front();
+  reconstruction.Frame(modified_frame_id)
+      .RigFromWorld()
+      .translation()
+      .x() += 1;
+  const camera_t modified_camera_id = reconstruction.Cameras().begin()->first;
+  reconstruction.Camera(modified_camera_id).params[0] += 1;
+
+  const ReconstructionDelta delta = reconstruction.ComputeDelta(base);
+  EXPECT_TRUE(delta.HasEntityChanges());
+  ASSERT_EQ(delta.cameras.size(), 1);
+  EXPECT_EQ(delta.cameras[0].camera_id, modified_camera_id);
+  EXPECT_TRUE(delta.rigs.empty());
+  ASSERT_EQ(delta.frames.size(), 1);
+  EXPECT_EQ(delta.frames[0].FrameId(), modified_frame_id);
+  EXPECT_EQ(delta.images.size(), modified_image_ids.size());
+  for (const Image& image : delta.images) {
+    EXPECT_EQ(modified_image_ids.count(image.ImageId()), 1);
+  }
+  ASSERT_EQ(delta.points3D.size(), 2);
+  EXPECT_EQ(delta.points3D[0].first, modified_point3D_id);
+  EXPECT_EQ(delta.points3D[1].first, added_point3D_id);
+  EXPECT_EQ(delta.deleted_point3D_ids,
+            std::vector<point3D_t>{deleted_point3D_id});
+
+  std::stringstream stream;
+  WriteReconstructionDelta(delta, stream);
+  base.ApplyDelta(ReadReconstructionDelta(stream));
+  EXPECT_THAT(base, ReconstructionEq(reconstruction));
+  EXPECT_EQ(base.NumRegImages(), reconstruction.NumRegImages());
+  EXPECT_EQ(base.RegFrameIds(), reconstruction.RegFrameIds());
+  EXPECT_EQ(base.Points3DIndex()->Size(), reconstruction.NumPoints3D());
+  EXPECT_TRUE(base.Points3DIndex()->Exists(added_point3D_id));
+  EXPECT_FALSE(base.Points3DIndex()->Exists(deleted_point3D_id));
+  EXPECT_TRUE(base.ComputeDelta(reconstruction).points3D.empty());
+}
+
+TEST(ReconstructionDelta, ReadWriteFile) {
+  const Reconstruction reconstruction = CreateSyntheticReconstruction();
+  const ReconstructionDelta delta =
+      reconstruction.ComputeDelta(Reconstruction());
+  EXPECT_EQ(delta.images.size(), reconstruction.NumImages());
+  EXPECT_EQ(delta.points3D.size(), reconstruction.NumPoints3D());
+
+  const auto path = CreateTestDir() / "delta.bin";
+  WriteReconstructionDelta(delta, path);
+  Reconstruction applied;
+  applied.ApplyDelta(ReadReconstructionDelta(path));
+  EXPECT_THAT(applied, ReconstructionEq(reconstruction));
+  EXPECT_EQ(applied.NumRegImages(), reconstruction.NumRegImages());
+}
+
+TEST(ReconstructionDelta, ReadInvalid) {
+  std::stringstream stream("not a delta");
+  EXPECT_ANY_THROW(ReadReconstructionDelta(stream));
+}
+
+}  // namespace
+}  // namespace colmap
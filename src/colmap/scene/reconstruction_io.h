@@ -31,6 +31,7 @@
 
 #include "colmap/scene/reconstruction.h"
 #include "colmap/scene/reconstruction_io_binary.h"
+#include "colmap/scene/reconstruction_io_mapped.h"
 #include "colmap/scene/reconstruction_io_text.h"
 
 #include <filesystem>
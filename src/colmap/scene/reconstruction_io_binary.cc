@@ -270,13 +270,15 @@ void ReadPoints3DBinary(Reconstruction& reconstruction, std::istream& stream) {
     point3D.color(2) = ReadBinaryLittleEndian<uint8_t>(&stream);
     point3D.error = ReadBinaryLittleEndian<double>(&stream);
 
+    // Allocate the track exactly once instead of growing it element by
+    // element and shrinking it afterwards.
     const size_t track_length = ReadBinaryLittleEndian<uint64_t>(&stream);
+    point3D.track.Reserve(track_length);
     for (size_t j = 0; j < track_length; ++j) {
       const image_t image_id = ReadBinaryLittleEndian<image_t>(&stream);
       const point2D_t point2D_idx = ReadBinaryLittleEndian<point2D_t>(&stream);
       point3D.track.AddElement(image_id, point2D_idx);
     }
-    point3D.track.Compress();
 
     reconstruction.AddPoint3D(point3D_id, std::move(point3D));
   }
@@ -0,0 +1,231 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/scene/reconstruction_io_mapped.h"
+
+#include "colmap/scene/reconstruction_io_utils.h"
+#include "colmap/util/endian.h"
+#include "colmap/util/logging.h"
+
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace colmap {
+namespace {
+
+static_assert(std::is_trivially_copyable_v<MappedPoints3DHeader>);
+static_assert(std::is_trivially_copyable_v<MappedPoint3D>);
+static_assert(std::is_trivially_copyable_v<MappedTrackElement>);
+static_assert(sizeof(MappedPoints3DHeader) == 56);
+static_assert(sizeof(MappedPoint3D) == 56);
+static_assert(sizeof(MappedTrackElement) == 8);
+
+uint64_t AlignOffset(const uint64_t offset) {
+  constexpr uint64_t kAlignment = MappedPoints3DHeader::kAlignment;
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+void WritePadding(std::ostream& stream, uint64_t* offset) {
+  static const char kZeros[MappedPoints3DHeader::kAlignment] = {};
+  const uint64_t aligned_offset = AlignOffset(*offset);
+  stream.write(kZeros, aligned_offset - *offset);
+  *offset = aligned_offset;
+}
+
+template <typename T>
+void WriteRecord(std::ostream& stream, const T& record, uint64_t* offset) {
+  stream.write(reinterpret_cast<const char*>(&record), sizeof(T));
+  *offset += sizeof(T);
+}
+
+}  // namespace
+
+MappedPoints3D::MappedPoints3D(const std::filesystem::path& path) {
+  Open(path);
+}
+
+void MappedPoints3D::Open(const std::filesystem::path& path) {
+  THROW_CHECK(IsLittleEndian())
+      << "Memory-mapped points3D files require a little endian host";
+
+  file_.Map(path);
+  points3D_ = nullptr;
+  track_elements_ = nullptr;
+  num_points3D_ = 0;
+  num_track_elements_ = 0;
+
+  THROW_CHECK_GE(file_.Size(), sizeof(MappedPoints3DHeader))
+      << "Truncated points3D file " << path;
+  MappedPoints3DHeader header;
+  std::memcpy(&header, file_.Data(), sizeof(header));
+  THROW_CHECK_EQ(std::memcmp(header.magic,
+                             MappedPoints3DHeader::kMagic,
+                             sizeof(header.magic)),
+                 0)
+      << "Not a memory-mapped points3D file: " << path;
+  THROW_CHECK_EQ(header.version, MappedPoints3DHeader::kVersion)
+      << "Unsupported points3D file version in " << path;
+  THROW_CHECK_EQ(header.point3D_stride, sizeof(MappedPoint3D));
+  THROW_CHECK_EQ(header.track_element_stride, sizeof(MappedTrackElement));
+  THROW_CHECK_EQ(header.points3D_offset % MappedPoints3DHeader::kAlignment, 0);
+  THROW_CHECK_EQ(
+      header.track_elements_offset % MappedPoints3DHeader::kAlignment, 0);
+  THROW_CHECK_LE(header.points3D_offset +
+                     header.num_points3D * sizeof(MappedPoint3D),
+                 file_.Size())
+      << "Truncated points3D file " << path;
+  THROW_CHECK_LE(header.track_elements_offset +
+                     header.num_track_elements * sizeof(MappedTrackElement),
+                 file_.Size())
+      << "Truncated points3D file " << path;
+
+  num_points3D_ = header.num_points3D;
+  num_track_elements_ = header.num_track_elements;
+  if (num_points3D_ > 0) {
+    points3D_ = reinterpret_cast<const MappedPoint3D*>(file_.Data() +
+                                                       header.points3D_offset);
+  }
+  if (num_track_elements_ > 0) {
+    track_elements_ = reinterpret_cast<const MappedTrackElement*>(
+        file_.Data() + header.track_elements_offset);
+  }
+}
+
+struct Point3D MappedPoints3D::ToPoint3D(const size_t idx) const {
+  THROW_CHECK_LT(idx, num_points3D_);
+  const MappedPoint3D& mapped_point3D = points3D_[idx];
+  THROW_CHECK_LE(mapped_point3D.track_offset + mapped_point3D.track_length,
+                 num_track_elements_);
+
+  struct Point3D point3D;
+  point3D.xyz = Eigen::Map<const Eigen::Vector3d>(mapped_point3D.xyz);
+  point3D.color = Eigen::Map<const Eigen::Vector3ub>(mapped_point3D.color);
+  point3D.error = mapped_point3D.error;
+  point3D.track.Reserve(mapped_point3D.track_length);
+  for (const MappedTrackElement& track_el : Track(idx)) {
+    point3D.track.AddElement(track_el.image_id, track_el.point2D_idx);
+  }
+  return point3D;
+}
+
+std::vector<PlyPoint> MappedPoints3D::ConvertToPLY() const {
+  std::vector<PlyPoint> ply_points(num_points3D_);
+  for (size_t i = 0; i < num_points3D_; ++i) {
+    const MappedPoint3D& point3D = points3D_[i];
+    PlyPoint& ply_point = ply_points[i];
+    ply_point.x = point3D.xyz[0];
+    ply_point.y = point3D.xyz[1];
+    ply_point.z = point3D.xyz[2];
+    ply_point.r = point3D.color[0];
+    ply_point.g = point3D.color[1];
+    ply_point.b = point3D.color[2];
+  }
+  return ply_points;
+}
+
+void ReadPoints3DMapped(Reconstruction& reconstruction,
+                        const MappedPoints3D& mapped_points3D) {
+  for (size_t i = 0; i < mapped_points3D.NumPoints3D(); ++i) {
+    reconstruction.AddPoint3D(mapped_points3D.Point3D(i).point3D_id,
+                              mapped_points3D.ToPoint3D(i));
+  }
+}
+
+void ReadPoints3DMapped(Reconstruction& reconstruction,
+                        const std::filesystem::path& path) {
+  ReadPoints3DMapped(reconstruction, MappedPoints3D(path));
+}
+
+void WritePoints3DMapped(const Reconstruction& reconstruction,
+                         std::ostream& stream) {
+  THROW_CHECK(stream.good());
+  THROW_CHECK(IsLittleEndian())
+      << "Memory-mapped points3D files require a little endian host";
+
+  const std::vector<point3D_t> point3D_ids =
+      ExtractSortedIds(reconstruction.Points3D());
+
+  MappedPoints3DHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, MappedPoints3DHeader::kMagic, sizeof(header.magic));
+  header.version = MappedPoints3DHeader::kVersion;
+  header.point3D_stride = sizeof(MappedPoint3D);
+  header.track_element_stride = sizeof(MappedTrackElement);
+  header.num_points3D = point3D_ids.size();
+  header.num_track_elements = 0;
+  for (const point3D_t point3D_id : point3D_ids) {
+    header.num_track_elements +=
+        reconstruction.Point3D(point3D_id).track.Length();
+  }
+  header.points3D_offset = AlignOffset(sizeof(header));
+  header.track_elements_offset = AlignOffset(
+      header.points3D_offset + header.num_points3D * sizeof(MappedPoint3D));
+
+  uint64_t offset = 0;
+  WriteRecord(stream, header, &offset);
+
+  WritePadding(stream, &offset);
+  THROW_CHECK_EQ(offset, header.points3D_offset);
+  uint64_t track_offset = 0;
+  for (const point3D_t point3D_id : point3D_ids) {
+    const struct Point3D& point3D = reconstruction.Point3D(point3D_id);
+    MappedPoint3D mapped_point3D;
+    std::memset(&mapped_point3D, 0, sizeof(mapped_point3D));
+    mapped_point3D.point3D_id = point3D_id;
+    Eigen::Map<Eigen::Vector3d>(mapped_point3D.xyz) = point3D.xyz;
+    mapped_point3D.error = point3D.error;
+    mapped_point3D.track_offset = track_offset;
+    mapped_point3D.track_length = point3D.track.Length();
+    Eigen::Map<Eigen::Vector3ub>(mapped_point3D.color) = point3D.color;
+    WriteRecord(stream, mapped_point3D, &offset);
+    track_offset += point3D.track.Length();
+  }
+
+  WritePadding(stream, &offset);
+  THROW_CHECK_EQ(offset, header.track_elements_offset);
+  for (const point3D_t point3D_id : point3D_ids) {
+    for (const TrackElement& track_el :
+         reconstruction.Point3D(point3D_id).track.Elements()) {
+      MappedTrackElement mapped_track_el;
+      mapped_track_el.image_id = track_el.image_id;
+      mapped_track_el.point2D_idx = track_el.point2D_idx;
+      WriteRecord(stream, mapped_track_el, &offset);
+    }
+  }
+}
+
+void WritePoints3DMapped(const Reconstruction& reconstruction,
+                         const std::filesystem::path& path) {
+  std::ofstream file(path, std::ios::trunc | std::ios::binary);
+  THROW_CHECK_FILE_OPEN(file, path);
+  WritePoints3DMapped(reconstruction, file);
+}
+
+}  // namespace colmap
@@ -0,0 +1,155 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "colmap/scene/point3d.h"
+#include "colmap/scene/reconstruction.h"
+#include "colmap/util/file.h"
+#include "colmap/util/ply.h"
+#include "colmap/util/types.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace colmap {
+
+// Memory-mappable binary format of the 3D points of a reconstruction
+// ("points3D.mbin"). In contrast to "points3D.bin", all records have a fixed
+// stride and the point and track element sections are stored as contiguous,
+// 64-byte aligned arrays, so that the file can be accessed in place without
+// parsing. The layout is:
+//
+//   MappedPoints3DHeader
+//   MappedPoint3D[num_points3D]              at header.points3D_offset
+//   MappedTrackElement[num_track_elements]   at header.track_elements_offset
+//
+// The track of a point is the range [track_offset, track_offset +
+// track_length) in the track element section. All values are stored in
+// little endian byte order. The other components of the reconstruction
+// (rigs, cameras, frames, images) continue to use the regular binary format.
+
+struct MappedPoints3DHeader {
+  static constexpr char kMagic[8] = {'C', 'O', 'L', 'M', 'A', 'P', 'P', '3'};
+  static constexpr uint32_t kVersion = 1;
+  static constexpr size_t kAlignment = 64;
+
+  char magic[8];
+  uint32_t version;
+  // Size of a single MappedPoint3D and MappedTrackElement record in bytes.
+  uint32_t point3D_stride;
+  uint32_t track_element_stride;
+  uint32_t reserved;
+  uint64_t num_points3D;
+  uint64_t num_track_elements;
+  uint64_t points3D_offset;
+  uint64_t track_elements_offset;
+};
+
+struct MappedPoint3D {
+  point3D_t point3D_id;
+  double xyz[3];
+  double error;
+  uint64_t track_offset;
+  uint32_t track_length;
+  uint8_t color[3];
+  uint8_t reserved;
+};
+
+struct MappedTrackElement {
+  image_t image_id;
+  point2D_t point2D_idx;
+};
+
+// Read-only view of a memory-mapped points3D file. Points are accessed by
+// their index in the file (sorted by identifier) and only the touched pages
+// are loaded from disk, so statistics over large models can be computed
+// without materializing the points in a reconstruction.
+class MappedPoints3D {
+ public:
+  MappedPoints3D() = default;
+  explicit MappedPoints3D(const std::filesystem::path& path);
+
+  // Map and validate the file at the given path.
+  void Open(const std::filesystem::path& path);
+
+  inline size_t NumPoints3D() const;
+  inline size_t NumTrackElements() const;
+
+  inline const MappedPoint3D& Point3D(size_t idx) const;
+  inline span<const MappedTrackElement> Track(size_t idx) const;
+
+  // Convert the point at the given index to a regular 3D point.
+  struct Point3D ToPoint3D(size_t idx) const;
+
+  // Convert the 3D points to a PLY point cloud.
+  std::vector<PlyPoint> ConvertToPLY() const;
+
+ private:
+  MemoryMappedFile file_;
+  const MappedPoint3D* points3D_ = nullptr;
+  const MappedTrackElement* track_elements_ = nullptr;
+  size_t num_points3D_ = 0;
+  size_t num_track_elements_ = 0;
+};
+
+// Note that images must be read before the 3D points.
+void ReadPoints3DMapped(Reconstruction& reconstruction,
+                        const MappedPoints3D& mapped_points3D);
+void ReadPoints3DMapped(Reconstruction& reconstruction,
+                        const std::filesystem::path& path);
+
+void WritePoints3DMapped(const Reconstruction& reconstruction,
+                         std::ostream& stream);
+void WritePoints3DMapped(const Reconstruction& reconstruction,
+                         const std::filesystem::path& path);
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////////////////////////////////////
+
+size_t MappedPoints3D::NumPoints3D() const { return num_points3D_; }
+
+size_t MappedPoints3D::NumTrackElements() const { return num_track_elements_; }
+
+const MappedPoint3D& MappedPoints3D::Point3D(const size_t idx) const {
+  return points3D_[idx];
+}
+
+span<const MappedTrackElement> MappedPoints3D::Track(const size_t idx) const {
+  const MappedPoint3D& point3D = points3D_[idx];
+  return span<const MappedTrackElement>(
+      track_elements_ + point3D.track_offset, point3D.track_length);
+}
+
+}  // namespace colmap
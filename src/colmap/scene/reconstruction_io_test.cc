@@ -289,6 +289,15 @@ struct ReaderWriterBinaryFileStream : public ReaderWriterFileStream {
   }
 };
 
+struct ReaderWriterMappedFileStream : public ReaderWriterBinaryFileStream {
+  void ReadPoints3D(Reconstruction& reconstruction) override {
+    ReadPoints3DMapped(reconstruction, points3D_path_);
+  }
+  void WritePoints3D(const Reconstruction& reconstruction) override {
+    WritePoints3DMapped(reconstruction, points3D_path_);
+  }
+};
+
 class ParameterizedReaderWriterTests
     : public ::testing::TestWithParam<
           std::function<std::unique_ptr<ReaderWriter>()>> {};
@@ -370,7 +379,69 @@ INSTANTIATE_TEST_SUITE_P(
         []() { return std::make_unique<ReaderWriterTextStringStream>(); },
         []() { return std::make_unique<ReaderWriterBinaryStringStream>(); },
         []() { return std::make_unique<ReaderWriterTextFileStream>(); },
-        []() { return std::make_unique<ReaderWriterBinaryFileStream>(); }));
+        []() { return std::make_unique<ReaderWriterBinaryFileStream>(); },
+        []() { return std::make_unique<ReaderWriterMappedFileStream>(); }));
+
+TEST(MappedPoints3D, Nominal) {
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 4;
+  synthetic_dataset_options.num_points3D = 123;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+
+  const auto path = CreateTestDir() / "points3D.mbin";
+  WritePoints3DMapped(reconstruction, path);
+
+  const MappedPoints3D mapped_points3D(path);
+  ASSERT_EQ(mapped_points3D.NumPoints3D(), reconstruction.NumPoints3D());
+  EXPECT_EQ(mapped_points3D.NumTrackElements(),
+            reconstruction.ComputeNumObservations());
+  point3D_t prev_point3D_id = 0;
+  for (size_t i = 0; i < mapped_points3D.NumPoints3D(); ++i) {
+    const point3D_t point3D_id = mapped_points3D.Point3D(i).point3D_id;
+    EXPECT_GT(point3D_id, prev_point3D_id);
+    prev_point3D_id = point3D_id;
+    const struct Point3D& point3D = reconstruction.Point3D(point3D_id);
+    EXPECT_EQ(mapped_points3D.ToPoint3D(i), point3D);
+    const auto track = mapped_points3D.Track(i);
+    ASSERT_EQ(track.size(), point3D.track.Length());
+    for (size_t j = 0; j < track.size(); ++j) {
+      EXPECT_EQ(track[j].image_id, point3D.track.Element(j).image_id);
+      EXPECT_EQ(track[j].point2D_idx, point3D.track.Element(j).point2D_idx);
+    }
+  }
+
+  const std::vector<PlyPoint> ply_points = mapped_points3D.ConvertToPLY();
+  EXPECT_EQ(ply_points.size(), reconstruction.NumPoints3D());
+}
+
+TEST(MappedPoints3D, Empty) {
+  const auto path = CreateTestDir() / "points3D.mbin";
+  WritePoints3DMapped(Reconstruction(), path);
+  const MappedPoints3D mapped_points3D(path);
+  EXPECT_EQ(mapped_points3D.NumPoints3D(), 0);
+  EXPECT_EQ(mapped_points3D.NumTrackElements(), 0);
+}
+
+TEST(MappedPoints3D, InvalidFile) {
+  const auto test_dir = CreateTestDir();
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_points3D = 10;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+  const auto binary_path = test_dir / "points3D.bin";
+  WritePoints3DBinary(reconstruction, binary_path);
+  EXPECT_ANY_THROW(MappedPoints3D{binary_path});
+
+  // Truncate a valid file.
+  const auto mapped_path = test_dir / "points3D.mbin";
+  WritePoints3DMapped(reconstruction, mapped_path);
+  std::filesystem::resize_file(
+      mapped_path, std::filesystem::file_size(mapped_path) - 1);
+  EXPECT_ANY_THROW(MappedPoints3D{mapped_path});
+}
 
 TEST(ExportNVM, Nominal) {
   Reconstruction reconstruction;
@@ -623,5 +694,37 @@ TEST(TextIO, LocaleIndependentRoundtrip) {
   std::locale::global(original_locale);
 }
 
+TEST(TextIO, ParallelRoundtrip) {
+  // Large enough to be split into multiple chunks for parallel processing.
+  Reconstruction orig;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 3;
+  synthetic_dataset_options.num_points3D = 20000;
+  SynthesizeDataset(synthetic_dataset_options, &orig);
+
+  ReaderWriterTextStringStream rw;
+  rw.WriteRigs(orig);
+  rw.WriteCameras(orig);
+  rw.WriteFrames(orig);
+  rw.WriteImages(orig);
+  rw.WritePoints3D(orig);
+
+  Reconstruction test;
+  rw.ReadCameras(test);
+  rw.ReadRigs(test);
+  rw.ReadFrames(test);
+  rw.ReadImages(test);
+  EXPECT_EQ(orig.Images(), test.Images());
+  rw.ReadPoints3D(test);
+  EXPECT_EQ(orig.Points3D(), test.Points3D());
+
+  // Serialization must be deterministic.
+  ReaderWriterTextStringStream rw2;
+  rw2.WritePoints3D(test);
+  EXPECT_EQ(rw.Points3DStr(), rw2.Points3DStr());
+}
+
 }  // namespace
 }  // namespace colmap
@@ -36,12 +36,68 @@
 #include "colmap/scene/reconstruction_io_utils.h"
 #include "colmap/scene/track.h"
 #include "colmap/util/file.h"
+#include "colmap/util/threading.h"
 #include "colmap/util/types.h"
 
 #include <fstream>
 #include <locale>
+#include <sstream>
 
 namespace colmap {
+namespace {
+
+// Minimum number of images or points handled by a single thread when parsing
+// or serializing text files in parallel. Smaller files are processed serially.
+constexpr size_t kMinNumItemsPerThread = 4096;
+
+size_t GetNumChunks(const size_t num_items) {
+  return std::max<size_t>(1,
+                          std::min<size_t>(GetEffectiveNumThreads(-1),
+                                           num_items / kMinNumItemsPerThread));
+}
+
+// Splits the range [0, num_items) into contiguous chunks and calls
+// func(chunk_idx, begin, end) for each chunk in parallel.
+template <typename Func>
+void ParallelForChunks(const size_t num_items,
+                       const size_t num_chunks,
+                       const Func& func) {
+  if (num_chunks <= 1) {
+    func(0, 0, num_items);
+    return;
+  }
+
+  const size_t chunk_size = (num_items + num_chunks - 1) / num_chunks;
+  ThreadPool thread_pool(num_chunks);
+  for (size_t chunk_idx = 0; chunk_idx < num_chunks; ++chunk_idx) {
+    const size_t begin = std::min(num_items, chunk_idx * chunk_size);
+    const size_t end = std::min(num_items, begin + chunk_size);
+    thread_pool.AddTask(
+        [&func, chunk_idx, begin, end]() { func(chunk_idx, begin, end); });
+  }
+  thread_pool.Wait();
+}
+
+// Reads all lines of the stream into memory, so they can be parsed in
+// parallel.
+std::vector<std::string> ReadLines(std::istream& stream) {
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline(stream, line)) {
+    lines.push_back(std::move(line));
+  }
+  return lines;
+}
+
+std::ostringstream CreateTextStream() {
+  // Ensure that we don't loose any precision by storing in text.
+  std::ostringstream stream;
+  stream.imbue(std::locale::classic());
+  stream.precision(17);
+  return stream;
+}
+
+}  // namespace
 
 void ReadRigsText(Reconstruction& reconstruction, std::istream& stream) {
   THROW_CHECK(stream.good());
@@ -224,26 +280,65 @@ void ReadImagesText(Reconstruction& reconstruction, std::istream& stream) {
   const std::unordered_map<image_t, Frame*> image_to_frame =
       ExtractImageToFramePtr(reconstruction);
 
-  std::string line;
-  std::vector<Eigen::Vector2d> points2D;
-  std::vector<point3D_t> point3D_ids;
-
-  while (std::getline(stream, line)) {
-    StringTrim(&line);
+  std::vector<std::string> lines = ReadLines(stream);
 
-    if (line.empty() || line[0] == '#') {
+  // Each image consists of a header line followed by a line with its 2D
+  // points, which dominate the file size and are parsed in parallel.
+  std::vector<std::pair<size_t, size_t>> image_lines;
+  for (size_t i = 0; i < lines.size(); ++i) {
+    StringTrim(&lines[i]);
+    if (lines[i].empty() || lines[i][0] == '#') {
       continue;
     }
+    if (i + 1 == lines.size()) {
+      break;
+    }
+    image_lines.emplace_back(i, i + 1);
+    ++i;
+    StringTrim(&lines[i]);
+  }
 
-    std::stringstream line_stream1(line);
-    line_stream1.imbue(std::locale::classic());
+  std::vector<std::vector<Eigen::Vector2d>> points2D(image_lines.size());
+  std::vector<std::vector<point3D_t>> point3D_ids(image_lines.size());
+  ParallelForChunks(
+      image_lines.size(),
+      GetNumChunks(image_lines.size()),
+      [&](size_t /*chunk_idx*/, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const std::string& line = lines[image_lines[i].second];
+          if (line.empty()) {
+            continue;
+          }
+
+          std::stringstream line_stream(line);
+          line_stream.imbue(std::locale::classic());
+
+          Eigen::Vector2d point;
+          while (line_stream >> point.x() >> point.y()) {
+            points2D[i].push_back(point);
+
+            int64_t point3D_id_signed;
+            THROW_CHECK(line_stream >> point3D_id_signed);
+            if (point3D_id_signed == -1) {
+              point3D_ids[i].push_back(kInvalidPoint3DId);
+            } else {
+              point3D_ids[i].push_back(
+                  static_cast<point3D_t>(point3D_id_signed));
+            }
+          }
+        }
+      });
+
+  for (size_t i = 0; i < image_lines.size(); ++i) {
+    std::stringstream line_stream(lines[image_lines[i].first]);
+    line_stream.imbue(std::locale::classic());
 
     // ID, CAM_FROM_WORLD, CAMERA_ID
     image_t image_id;
     Rigid3d cam_from_world;
     camera_t camera_id;
     THROW_CHECK(
-        line_stream1 >> image_id >> cam_from_world.rotation().w() >>
+        line_stream >> image_id >> cam_from_world.rotation().w() >>
         cam_from_world.rotation().x() >> cam_from_world.rotation().y() >>
         cam_from_world.rotation().z() >> cam_from_world.translation().x() >>
         cam_from_world.translation().y() >> cam_from_world.translation().z() >>
@@ -264,41 +359,15 @@ void ReadImagesText(Reconstruction& reconstruction, std::istream& stream) {
     }
 
     // NAME
-    THROW_CHECK(line_stream1 >> image.Name());
+    THROW_CHECK(line_stream >> image.Name());
 
     // POINTS2D
-    if (!std::getline(stream, line)) {
-      break;
-    }
-
-    StringTrim(&line);
-    std::stringstream line_stream2(line);
-    line_stream2.imbue(std::locale::classic());
-
-    points2D.clear();
-    point3D_ids.clear();
-
-    if (!line.empty()) {
-      Eigen::Vector2d point;
-      while (line_stream2 >> point.x() >> point.y()) {
-        points2D.push_back(point);
-
-        int64_t point3D_id_signed;
-        THROW_CHECK(line_stream2 >> point3D_id_signed);
-        if (point3D_id_signed == -1) {
-          point3D_ids.push_back(kInvalidPoint3DId);
-        } else {
-          point3D_ids.push_back(static_cast<point3D_t>(point3D_id_signed));
-        }
-      }
-    }
-
-    image.SetPoints2D(points2D);
+    image.SetPoints2D(points2D[i]);
 
     for (point2D_t point2D_idx = 0; point2D_idx < image.NumPoints2D();
          ++point2D_idx) {
-      if (point3D_ids[point2D_idx] != kInvalidPoint3DId) {
-        image.SetPoint3DForPoint2D(point2D_idx, point3D_ids[point2D_idx]);
+      if (point3D_ids[i][point2D_idx] != kInvalidPoint3DId) {
+        image.SetPoint3DForPoint2D(point2D_idx, point3D_ids[i][point2D_idx]);
       }
     }
 
@@ -317,45 +386,62 @@ void ReadPoints3DText(Reconstruction& reconstruction, std::istream& stream) {
   THROW_CHECK(stream.good());
   stream.imbue(std::locale::classic());
 
-  std::string line;
-
-  while (std::getline(stream, line)) {
-    StringTrim(&line);
-
-    if (line.empty() || line[0] == '#') {
-      continue;
-    }
-
-    std::stringstream line_stream(line);
-    line_stream.imbue(std::locale::classic());
-
-    // ID
-    point3D_t point3D_id;
-
-    struct Point3D point3D;
-
-    // ID, XYZ, RGB
-    int r, g, b;
-    THROW_CHECK(line_stream >> point3D_id >> point3D.xyz(0) >> point3D.xyz(1) >>
-                point3D.xyz(2) >> r >> g >> b);
-    point3D.color(0) = static_cast<uint8_t>(r);
-    point3D.color(1) = static_cast<uint8_t>(g);
-    point3D.color(2) = static_cast<uint8_t>(b);
-
-    // ERROR
-    THROW_CHECK(line_stream >> point3D.error);
+  std::vector<std::string> lines = ReadLines(stream);
+
+  const size_t num_chunks = GetNumChunks(lines.size());
+  std::vector<std::vector<std::pair<point3D_t, struct Point3D>>> chunk_points3D(
+      num_chunks);
+  ParallelForChunks(
+      lines.size(),
+      num_chunks,
+      [&](size_t chunk_idx, size_t begin, size_t end) {
+        std::vector<std::pair<point3D_t, struct Point3D>>& points3D =
+            chunk_points3D[chunk_idx];
+        for (size_t i = begin; i < end; ++i) {
+          std::string& line = lines[i];
+          StringTrim(&line);
+
+          if (line.empty() || line[0] == '#') {
+            continue;
+          }
+
+          std::stringstream line_stream(line);
+          line_stream.imbue(std::locale::classic());
+
+          // ID
+          point3D_t point3D_id;
+
+          struct Point3D point3D;
+
+          // ID, XYZ, RGB
+          int r, g, b;
+          THROW_CHECK(line_stream >> point3D_id >> point3D.xyz(0) >>
+                      point3D.xyz(1) >> point3D.xyz(2) >> r >> g >> b);
+          point3D.color(0) = static_cast<uint8_t>(r);
+          point3D.color(1) = static_cast<uint8_t>(g);
+          point3D.color(2) = static_cast<uint8_t>(b);
+
+          // ERROR
+          THROW_CHECK(line_stream >> point3D.error);
+
+          // TRACK
+          {
+            TrackElement track_el;
+            while (line_stream >> track_el.image_id >> track_el.point2D_idx) {
+              point3D.track.AddElement(track_el);
+            }
+          }
+
+          point3D.track.Compress();
+
+          points3D.emplace_back(point3D_id, std::move(point3D));
+        }
+      });
 
-    // TRACK
-    {
-      TrackElement track_el;
-      while (line_stream >> track_el.image_id >> track_el.point2D_idx) {
-        point3D.track.AddElement(track_el);
-      }
+  for (size_t chunk_idx = 0; chunk_idx < num_chunks; ++chunk_idx) {
+    for (auto& [point3D_id, point3D] : chunk_points3D[chunk_idx]) {
+      reconstruction.AddPoint3D(point3D_id, std::move(point3D));
     }
-
-    point3D.track.Compress();
-
-    reconstruction.AddPoint3D(point3D_id, std::move(point3D));
   }
 }
 
@@ -538,49 +624,63 @@ void WriteImagesText(const Reconstruction& reconstruction,
          << ", mean observations per image: "
          << reconstruction.ComputeMeanObservationsPerRegImage() << '\n';
 
-  std::ostringstream line;
-  line.imbue(std::locale::classic());
-  line.precision(17);
-
-  for (const image_t image_id : reconstruction.RegImageIds()) {
-    const Image& image = reconstruction.Image(image_id);
-
-    line.str("");
-    line.clear();
-
-    line << image_id << " ";
-
-    const Rigid3d& cam_from_world = image.CamFromWorld();
-    line << cam_from_world.rotation().w() << " ";
-    line << cam_from_world.rotation().x() << " ";
-    line << cam_from_world.rotation().y() << " ";
-    line << cam_from_world.rotation().z() << " ";
-    line << cam_from_world.translation().x() << " ";
-    line << cam_from_world.translation().y() << " ";
-    line << cam_from_world.translation().z() << " ";
-
-    line << image.CameraId() << " ";
-
-    line << image.Name();
-
-    stream << line.str() << '\n';
+  const std::vector<image_t> image_ids = reconstruction.RegImageIds();
+  const size_t num_chunks = GetNumChunks(image_ids.size());
+  std::vector<std::string> chunk_texts(num_chunks);
+  ParallelForChunks(
+      image_ids.size(),
+      num_chunks,
+      [&](size_t chunk_idx, size_t begin, size_t end) {
+        std::ostringstream chunk_stream = CreateTextStream();
+        std::ostringstream line = CreateTextStream();
+
+        for (size_t i = begin; i < end; ++i) {
+          const image_t image_id = image_ids[i];
+          const Image& image = reconstruction.Image(image_id);
+
+          line.str("");
+          line.clear();
+
+          line << image_id << " ";
+
+          const Rigid3d& cam_from_world = image.CamFromWorld();
+          line << cam_from_world.rotation().w() << " ";
+          line << cam_from_world.rotation().x() << " ";
+          line << cam_from_world.rotation().y() << " ";
+          line << cam_from_world.rotation().z() << " ";
+          line << cam_from_world.translation().x() << " ";
+          line << cam_from_world.translation().y() << " ";
+          line << cam_from_world.translation().z() << " ";
+
+          line << image.CameraId() << " ";
+
+          line << image.Name();
+
+          chunk_stream << line.str() << '\n';
+
+          line.str("");
+          line.clear();
+
+          for (const Point2D& point2D : image.Points2D()) {
+            line << point2D.xy(0) << " ";
+            line << point2D.xy(1) << " ";
+            if (point2D.HasPoint3D()) {
+              line << point2D.point3D_id << " ";
+            } else {
+              line << -1 << " ";
+            }
+          }
+          if (image.NumPoints2D() > 0) {
+            line.seekp(-1, std::ios_base::end);
+          }
+          chunk_stream << line.str() << '\n';
+        }
 
-    line.str("");
-    line.clear();
+        chunk_texts[chunk_idx] = chunk_stream.str();
+      });
 
-    for (const Point2D& point2D : image.Points2D()) {
-      line << point2D.xy(0) << " ";
-      line << point2D.xy(1) << " ";
-      if (point2D.HasPoint3D()) {
-        line << point2D.point3D_id << " ";
-      } else {
-        line << -1 << " ";
-      }
-    }
-    if (image.NumPoints2D() > 0) {
-      line.seekp(-1, std::ios_base::end);
-    }
-    stream << line.str() << '\n';
+  for (const std::string& chunk_text : chunk_texts) {
+    stream << chunk_text;
   }
 }
 
@@ -606,32 +706,47 @@ void WritePoints3DText(const Reconstruction& reconstruction,
          << ", mean track length: " << reconstruction.ComputeMeanTrackLength()
          << '\n';
 
-  for (const point3D_t point3D_id :
-       ExtractSortedIds(reconstruction.Points3D())) {
-    const Point3D& point3D = reconstruction.Point3D(point3D_id);
-
-    stream << point3D_id << " ";
-    stream << point3D.xyz(0) << " ";
-    stream << point3D.xyz(1) << " ";
-    stream << point3D.xyz(2) << " ";
-    stream << static_cast<int>(point3D.color(0)) << " ";
-    stream << static_cast<int>(point3D.color(1)) << " ";
-    stream << static_cast<int>(point3D.color(2)) << " ";
-    stream << point3D.error << " ";
-
-    std::ostringstream line;
-    line.imbue(std::locale::classic());
-    line.precision(17);
-
-    for (const auto& track_el : point3D.track.Elements()) {
-      line << track_el.image_id << " ";
-      line << track_el.point2D_idx << " ";
-    }
+  const std::vector<point3D_t> point3D_ids =
+      ExtractSortedIds(reconstruction.Points3D());
+  const size_t num_chunks = GetNumChunks(point3D_ids.size());
+  std::vector<std::string> chunk_texts(num_chunks);
+  ParallelForChunks(
+      point3D_ids.size(),
+      num_chunks,
+      [&](size_t chunk_idx, size_t begin, size_t end) {
+        std::ostringstream chunk_stream = CreateTextStream();
+
+        for (size_t i = begin; i < end; ++i) {
+          const point3D_t point3D_id = point3D_ids[i];
+          const Point3D& point3D = reconstruction.Point3D(point3D_id);
+
+          chunk_stream << point3D_id << " ";
+          chunk_stream << point3D.xyz(0) << " ";
+          chunk_stream << point3D.xyz(1) << " ";
+          chunk_stream << point3D.xyz(2) << " ";
+          chunk_stream << static_cast<int>(point3D.color(0)) << " ";
+          chunk_stream << static_cast<int>(point3D.color(1)) << " ";
+          chunk_stream << static_cast<int>(point3D.color(2)) << " ";
+          chunk_stream << point3D.error << " ";
+
+          std::ostringstream line = CreateTextStream();
+
+          for (const auto& track_el : point3D.track.Elements()) {
+            line << track_el.image_id << " ";
+            line << track_el.point2D_idx << " ";
+          }
+
+          std::string line_string = line.str();
+          line_string = line_string.substr(0, line_string.size() - 1);
+
+          chunk_stream << line_string << '\n';
+        }
 
-    std::string line_string = line.str();
-    line_string = line_string.substr(0, line_string.size() - 1);
+        chunk_texts[chunk_idx] = chunk_stream.str();
+      });
 
-    stream << line_string << '\n';
+  for (const std::string& chunk_text : chunk_texts) {
+    stream << chunk_text;
   }
 }
 
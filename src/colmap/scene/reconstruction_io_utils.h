@@ -41,9 +41,12 @@ namespace colmap {
 // We sort the identifiers before writing to the stream, such that we produce
 // deterministic output independent of standard library dependent ordering of
 // the unordered map container.
-template <typename ID_TYPE, typename DATA_TYPE>
+template <typename ID_TYPE,
+          typename DATA_TYPE,
+          template <typename...> class MAP_TYPE,
+          typename... MAP_ARGS>
 std::vector<ID_TYPE> ExtractSortedIds(
-    const std::unordered_map<ID_TYPE, DATA_TYPE>& data,
+    const MAP_TYPE<ID_TYPE, DATA_TYPE, MAP_ARGS...>& data,
     const std::function<bool(const DATA_TYPE&)>& filter = nullptr) {
   std::vector<ID_TYPE> ids;
   ids.reserve(data.size());
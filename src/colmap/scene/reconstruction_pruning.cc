@@ -29,6 +29,7 @@
 
 #include "colmap/math/math.h"
 #include "colmap/scene/reconstruction.h"
+#include "colmap/util/threading.h"
 
 #include <queue>
 #include <unordered_map>
@@ -112,17 +113,26 @@ std::vector<point3D_t> FindRedundantPoints3D(
            std::tie(right.gain, right.point3D_id);
   };
 
+  std::vector<Point3DInfo> point3D_infos;
+  point3D_infos.reserve(num_init_points3D);
+  for (const auto& [point3D_id, point3D] : reconstruction.Points3D()) {
+    point3D_infos.push_back({point3D_id, &point3D, 0});
+  }
+  ParallelFor(0,
+              point3D_infos.size(),
+              [&](const int64_t begin, const int64_t end) {
+                for (int64_t i = begin; i < end; ++i) {
+                  point3D_infos[i].gain = ComputeCoverageGain(
+                      *point3D_infos[i].point3D,
+                      num_selected_points3D_per_image_tile,
+                      image_tile_idxs);
+                }
+              });
+
   std::priority_queue<Point3DInfo,
                       std::vector<Point3DInfo>,
                       decltype(has_left_smaller_gain)>
-      priority_queue(has_left_smaller_gain);
-  for (const auto& [point3D_id, point3D] : reconstruction.Points3D()) {
-    priority_queue.push(
-        {point3D_id,
-         &point3D,
-         ComputeCoverageGain(
-             point3D, num_selected_points3D_per_image_tile, image_tile_idxs)});
-  }
+      priority_queue(has_left_smaller_gain, std::move(point3D_infos));
 
   std::unordered_set<point3D_t> selected_point3D_ids;
   selected_point3D_ids.reserve(num_init_points3D);
@@ -0,0 +1,251 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/scene/reconstruction_statistics.h"
+
+#include "colmap/geometry/triangulation.h"
+#include "colmap/math/math.h"
+#include "colmap/scene/projection.h"
+#include "colmap/util/logging.h"
+#include "colmap/util/threading.h"
+
+#include <unordered_map>
+
+namespace colmap {
+namespace {
+
+// Minimum number of points per thread to amortize the threading overhead.
+constexpr size_t kMinNumPoints3DPerThread = 1000;
+
+struct ImagePose {
+  Rigid3d cam_from_world;
+  Eigen::Vector3d proj_center;
+  const Camera* camera = nullptr;
+};
+
+void ComputePoint3DStatisticsImpl(
+    const std::unordered_map<image_t, ImagePose>& image_poses,
+    const Reconstruction& reconstruction,
+    const struct Point3D& point3D,
+    const Point3DStatisticsOptions& options,
+    std::vector<const ImagePose*>& track_poses,
+    Point3DStatistics& stats) {
+  const Track& track = point3D.track;
+  stats.track_length = track.Length();
+
+  track_poses.clear();
+  for (const TrackElement& track_el : track.Elements()) {
+    track_poses.push_back(&image_poses.at(track_el.image_id));
+  }
+
+  if (options.compute_errors && stats.track_length > 0) {
+    if (options.store_observation_errors) {
+      stats.observation_errors.resize(stats.track_length);
+    }
+    double error_sum = 0;
+    for (size_t i = 0; i < stats.track_length; ++i) {
+      const TrackElement& track_el = track.Element(i);
+      const ImagePose& pose = *track_poses[i];
+      const double error = CalculateObservationError(
+          options.error_type,
+          reconstruction.Image(track_el.image_id)
+              .Point2D(track_el.point2D_idx)
+              .xy,
+          point3D.xyz,
+          pose.cam_from_world,
+          *pose.camera);
+      error_sum += error;
+      stats.max_error = std::max(stats.max_error, error);
+      if (options.store_observation_errors) {
+        stats.observation_errors[i] = error;
+      }
+    }
+    stats.mean_error = error_sum / stats.track_length;
+  }
+
+  if (options.compute_tri_angle) {
+    for (size_t i1 = 0; i1 < stats.track_length; ++i1) {
+      for (size_t i2 = 0; i2 < i1; ++i2) {
+        const double tri_angle =
+            CalculateTriangulationAngle(track_poses[i1]->proj_center,
+                                        track_poses[i2]->proj_center,
+                                        point3D.xyz);
+        stats.max_tri_angle = std::max(stats.max_tri_angle, tri_angle);
+        if (tri_angle >= options.tri_angle_early_stop) {
+          return;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+double CalculateObservationError(const ReprojectionErrorType error_type,
+                                 const Eigen::Vector2d& point2D,
+                                 const Eigen::Vector3d& point3D,
+                                 const Rigid3d& cam_from_world,
+                                 const Camera& camera) {
+  switch (error_type) {
+    case ReprojectionErrorType::PIXEL:
+      return std::sqrt(CalculateSquaredReprojectionError(
+          point2D, point3D, cam_from_world, camera));
+    case ReprojectionErrorType::NORMALIZED: {
+      const Eigen::Vector3d point3D_in_cam = cam_from_world * point3D;
+      if (camera.IsPerspective()) {
+        constexpr double kMinDepth = 1e-12;
+        const std::optional<Eigen::Vector2d> cam_point =
+            camera.CamFromImg(point2D);
+        return (point3D_in_cam.z() >= kMinDepth && cam_point.has_value())
+                   ? (point3D_in_cam.hnormalized().head<2>() - *cam_point)
+                         .norm()
+                   : std::numeric_limits<double>::infinity();
+      } else {
+        // Omnidirectional cameras (e.g. EQUIRECTANGULAR) have no pinhole
+        // z-divide and legitimately observe points behind the local +Z axis,
+        // so the cheirality gate and 2D CamFromImg above do not apply.
+        // Compare unit bearings instead (chord distance ~= angle for small
+        // errors, consistent with the normalized threshold).
+        const std::optional<Eigen::Vector3d> cam_ray =
+            camera.CamRayFromImg(point2D);
+        return cam_ray.has_value()
+                   ? (point3D_in_cam.normalized() - *cam_ray).norm()
+                   : std::numeric_limits<double>::infinity();
+      }
+    }
+    case ReprojectionErrorType::ANGULAR:
+      return RadToDeg(CalculateAngularReprojectionError(
+          point2D, point3D, cam_from_world, camera));
+  }
+  return std::numeric_limits<double>::infinity();
+}
+
+bool Point3DStatisticsOptions::Check() const {
+  CHECK_OPTION_GE(tri_angle_early_stop, 0);
+  CHECK_OPTION(!store_observation_errors || compute_errors);
+  return true;
+}
+
+std::vector<Point3DStatistics> ComputePoint3DStatistics(
+    const Reconstruction& reconstruction,
+    const std::vector<point3D_t>& point3D_ids,
+    const Point3DStatisticsOptions& options) {
+  THROW_CHECK(options.Check());
+
+  // Compute the poses of all observing images once, so that the threads only
+  // read them.
+  std::unordered_map<image_t, ImagePose> image_poses;
+  for (const point3D_t point3D_id : point3D_ids) {
+    for (const TrackElement& track_el :
+         reconstruction.Point3D(point3D_id).track.Elements()) {
+      const auto [it, inserted] = image_poses.try_emplace(track_el.image_id);
+      if (inserted) {
+        const Image& image = reconstruction.Image(track_el.image_id);
+        it->second.cam_from_world = image.CamFromWorld();
+        it->second.proj_center = image.ProjectionCenter();
+        it->second.camera = image.CameraPtr();
+      }
+    }
+  }
+
+  std::vector<Point3DStatistics> stats(point3D_ids.size());
+
+  const size_t num_threads = std::max<size_t>(
+      1,
+      std::min<size_t>(GetEffectiveNumThreads(options.num_threads),
+                       point3D_ids.size() / kMinNumPoints3DPerThread));
+  const size_t chunk_size = (point3D_ids.size() + num_threads - 1) /
+                            std::max<size_t>(1, num_threads);
+
+  auto ComputeChunk = [&](const size_t begin, const size_t end) {
+    std::vector<const ImagePose*> track_poses;
+    for (size_t i = begin; i < end; ++i) {
+      ComputePoint3DStatisticsImpl(image_poses,
+                                   reconstruction,
+                                   reconstruction.Point3D(point3D_ids[i]),
+                                   options,
+                                   track_poses,
+                                   stats[i]);
+    }
+  };
+
+  if (num_threads == 1) {
+    ComputeChunk(0, point3D_ids.size());
+  } else {
+    ThreadPool thread_pool(num_threads);
+    for (size_t begin = 0; begin < point3D_ids.size(); begin += chunk_size) {
+      thread_pool.AddTask(ComputeChunk,
+                          begin,
+                          std::min(point3D_ids.size(), begin + chunk_size));
+    }
+    thread_pool.Wait();
+  }
+
+  return stats;
+}
+
+ReconstructionStatistics ComputeReconstructionStatistics(
+    const Reconstruction& reconstruction, const int num_threads) {
+  std::vector<point3D_t> point3D_ids;
+  point3D_ids.reserve(reconstruction.NumPoints3D());
+  for (const auto& [point3D_id, _] : reconstruction.Points3D()) {
+    point3D_ids.push_back(point3D_id);
+  }
+
+  Point3DStatisticsOptions options;
+  options.num_threads = num_threads;
+  const std::vector<Point3DStatistics> point3D_stats =
+      ComputePoint3DStatistics(reconstruction, point3D_ids, options);
+
+  ReconstructionStatistics stats;
+  stats.num_points3D = point3D_ids.size();
+  double error_sum = 0;
+  std::vector<double> tri_angles;
+  tri_angles.reserve(point3D_stats.size());
+  for (const Point3DStatistics& point3D_stats_i : point3D_stats) {
+    stats.num_observations += point3D_stats_i.track_length;
+    error_sum += point3D_stats_i.mean_error * point3D_stats_i.track_length;
+    if (point3D_stats_i.track_length >= 2) {
+      tri_angles.push_back(RadToDeg(point3D_stats_i.max_tri_angle));
+    }
+  }
+  if (stats.num_points3D > 0) {
+    stats.mean_track_length =
+        stats.num_observations / static_cast<double>(stats.num_points3D);
+  }
+  if (stats.num_observations > 0) {
+    stats.mean_reproj_error = error_sum / stats.num_observations;
+  }
+  if (!tri_angles.empty()) {
+    stats.median_tri_angle = Median(tri_angles);
+  }
+  return stats;
+}
+
+}  // namespace colmap
@@ -0,0 +1,121 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "colmap/geometry/rigid3.h"
+#include "colmap/scene/camera.h"
+#include "colmap/scene/reconstruction.h"
+#include "colmap/util/enum_utils.h"
+#include "colmap/util/types.h"
+
+#include <limits>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace colmap {
+
+// Type of error metric used for filtering 3D point observations.
+MAKE_ENUM_CLASS_OVERLOAD_STREAM(
+    ReprojectionErrorType, 0, PIXEL, NORMALIZED, ANGULAR);
+
+// Error of a single observation of a 3D point in the units of the error type
+// (pixels, normalized chord length, or degrees). Degenerate observations that
+// must always be filtered report an infinite error.
+double CalculateObservationError(ReprojectionErrorType error_type,
+                                 const Eigen::Vector2d& point2D,
+                                 const Eigen::Vector3d& point3D,
+                                 const Rigid3d& cam_from_world,
+                                 const Camera& camera);
+
+struct Point3DStatisticsOptions {
+  // Error metric used for the observation errors.
+  ReprojectionErrorType error_type = ReprojectionErrorType::PIXEL;
+
+  // Whether to compute the mean and maximum observation error.
+  bool compute_errors = true;
+
+  // Whether to additionally store the error of every observation.
+  bool store_observation_errors = false;
+
+  // Whether to compute the maximum triangulation angle of the track.
+  bool compute_tri_angle = true;
+
+  // Stop searching for the maximum triangulation angle (in radians) once an
+  // angle of at least this value was found, e.g., when only checking against a
+  // minimum angle. Pairs are visited in the same order as by the filters.
+  double tri_angle_early_stop = std::numeric_limits<double>::infinity();
+
+  // The number of threads, -1 for all available threads.
+  int num_threads = -1;
+
+  bool Check() const;
+};
+
+struct Point3DStatistics {
+  size_t track_length = 0;
+
+  // Mean and maximum error over all observations of the track.
+  double mean_error = 0;
+  double max_error = 0;
+
+  // Maximum triangulation angle in radians over all pairs of observations.
+  double max_tri_angle = 0;
+
+  // Errors of the observations in the order of the track elements, if
+  // requested.
+  std::vector<double> observation_errors;
+};
+
+// Computes the statistics of the given 3D points in a single parallel pass
+// over their observations. The image poses and projection centers are
+// computed once upfront, so the per-observation work reduces to projecting the
+// point. The returned statistics are in the order of the given identifiers.
+std::vector<Point3DStatistics> ComputePoint3DStatistics(
+    const Reconstruction& reconstruction,
+    const std::vector<point3D_t>& point3D_ids,
+    const Point3DStatisticsOptions& options);
+
+struct ReconstructionStatistics {
+  size_t num_points3D = 0;
+  size_t num_observations = 0;
+  double mean_track_length = 0;
+  // Mean pixel reprojection error over all observations, as opposed to the
+  // mean of the cached per-point errors.
+  double mean_reproj_error = 0;
+  // Median over the points of their maximum triangulation angle in degrees.
+  double median_tri_angle = 0;
+};
+
+// Recomputes summary statistics of all 3D points.
+ReconstructionStatistics ComputeReconstructionStatistics(
+    const Reconstruction& reconstruction, int num_threads = -1);
+
+}  // namespace colmap
@@ -0,0 +1,210 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/scene/reconstruction_statistics.h"
+
+#include "colmap/geometry/triangulation.h"
+#include "colmap/math/math.h"
+#include "colmap/math/random.h"
+#include "colmap/scene/projection.h"
+#include "colmap/scene/synthetic.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+Reconstruction CreateNoisyReconstruction(int num_points3D) {
+  SetPRNGSeed(1);
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 2;
+  synthetic_dataset_options.num_frames_per_rig = 4;
+  synthetic_dataset_options.num_points3D = num_points3D;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+  SyntheticNoiseOptions synthetic_noise_options;
+  synthetic_noise_options.point2D_stddev = 1.0;
+  SynthesizeNoise(synthetic_noise_options, &reconstruction);
+  return reconstruction;
+}
+
+std::vector<point3D_t> GetPoint3DIds(const Reconstruction& reconstruction) {
+  std::vector<point3D_t> point3D_ids;
+  for (const auto& [point3D_id, _] : reconstruction.Points3D()) {
+    point3D_ids.push_back(point3D_id);
+  }
+  return point3D_ids;
+}
+
+TEST(CalculateObservationError, Nominal) {
+  const Reconstruction reconstruction = CreateNoisyReconstruction(10);
+  for (const auto& [_, point3D] : reconstruction.Points3D()) {
+    for (const TrackElement& track_el : point3D.track.Elements()) {
+      const Image& image = reconstruction.Image(track_el.image_id);
+      const Eigen::Vector2d& xy = image.Point2D(track_el.point2D_idx).xy;
+      const Rigid3d cam_from_world = image.CamFromWorld();
+      const Camera& camera = *image.CameraPtr();
+      EXPECT_EQ(
+          CalculateObservationError(ReprojectionErrorType::PIXEL,
+                                    xy,
+                                    point3D.xyz,
+                                    cam_from_world,
+                                    camera),
+          std::sqrt(CalculateSquaredReprojectionError(
+              xy, point3D.xyz, cam_from_world, camera)));
+      EXPECT_EQ(CalculateObservationError(ReprojectionErrorType::ANGULAR,
+                                          xy,
+                                          point3D.xyz,
+                                          cam_from_world,
+                                          camera),
+                RadToDeg(CalculateAngularReprojectionError(
+                    xy, point3D.xyz, cam_from_world, camera)));
+      EXPECT_GE(CalculateObservationError(ReprojectionErrorType::NORMALIZED,
+                                          xy,
+                                          point3D.xyz,
+                                          cam_from_world,
+                                          camera),
+                0);
+    }
+  }
+}
+
+TEST(ComputePoint3DStatistics, Nominal) {
+  const Reconstruction reconstruction = CreateNoisyReconstruction(50);
+  const std::vector<point3D_t> point3D_ids = GetPoint3DIds(reconstruction);
+
+  Point3DStatisticsOptions options;
+  options.store_observation_errors = true;
+  const std::vector<Point3DStatistics> stats =
+      ComputePoint3DStatistics(reconstruction, point3D_ids, options);
+  ASSERT_EQ(stats.size(), point3D_ids.size());
+
+  for (size_t i = 0; i < point3D_ids.size(); ++i) {
+    const Point3D& point3D = reconstruction.Point3D(point3D_ids[i]);
+    ASSERT_EQ(stats[i].track_length, point3D.track.Length());
+    ASSERT_EQ(stats[i].observation_errors.size(), point3D.track.Length());
+
+    double error_sum = 0;
+    double max_error = 0;
+    double max_tri_angle = 0;
+    for (size_t j = 0; j < point3D.track.Length(); ++j) {
+      const Image& image1 =
+          reconstruction.Image(point3D.track.Element(j).image_id);
+      const double error = std::sqrt(CalculateSquaredReprojectionError(
+          image1.Point2D(point3D.track.Element(j).point2D_idx).xy,
+          point3D.xyz,
+          image1.CamFromWorld(),
+          *image1.CameraPtr()));
+      EXPECT_NEAR(stats[i].observation_errors[j], error, 1e-12);
+      error_sum += error;
+      max_error = std::max(max_error, error);
+      for (size_t k = 0; k < j; ++k) {
+        const Image& image2 =
+            reconstruction.Image(point3D.track.Element(k).image_id);
+        max_tri_angle = std::max(
+            max_tri_angle,
+            CalculateTriangulationAngle(image1.ProjectionCenter(),
+                                        image2.ProjectionCenter(),
+                                        point3D.xyz));
+      }
+    }
+    EXPECT_NEAR(
+        stats[i].mean_error, error_sum / point3D.track.Length(), 1e-12);
+    EXPECT_NEAR(stats[i].max_error, max_error, 1e-12);
+    EXPECT_NEAR(stats[i].max_tri_angle, max_tri_angle, 1e-12);
+  }
+}
+
+TEST(ComputePoint3DStatistics, EarlyStop) {
+  const Reconstruction reconstruction = CreateNoisyReconstruction(20);
+  const std::vector<point3D_t> point3D_ids = GetPoint3DIds(reconstruction);
+
+  Point3DStatisticsOptions options;
+  options.compute_errors = false;
+  const std::vector<Point3DStatistics> stats =
+      ComputePoint3DStatistics(reconstruction, point3D_ids, options);
+  options.tri_angle_early_stop = 0;
+  const std::vector<Point3DStatistics> early_stop_stats =
+      ComputePoint3DStatistics(reconstruction, point3D_ids, options);
+
+  for (size_t i = 0; i < point3D_ids.size(); ++i) {
+    EXPECT_EQ(stats[i].mean_error, 0);
+    EXPECT_LE(early_stop_stats[i].max_tri_angle, stats[i].max_tri_angle);
+  }
+}
+
+TEST(ComputePoint3DStatistics, ParallelMatchesSerial) {
+  const Reconstruction reconstruction = CreateNoisyReconstruction(5000);
+  const std::vector<point3D_t> point3D_ids = GetPoint3DIds(reconstruction);
+
+  Point3DStatisticsOptions options;
+  options.error_type = ReprojectionErrorType::NORMALIZED;
+  options.num_threads = 1;
+  const std::vector<Point3DStatistics> serial_stats =
+      ComputePoint3DStatistics(reconstruction, point3D_ids, options);
+  options.num_threads = 4;
+  const std::vector<Point3DStatistics> parallel_stats =
+      ComputePoint3DStatistics(reconstruction, point3D_ids, options);
+
+  ASSERT_EQ(serial_stats.size(), parallel_stats.size());
+  for (size_t i = 0; i < serial_stats.size(); ++i) {
+    EXPECT_EQ(serial_stats[i].track_length, parallel_stats[i].track_length);
+    EXPECT_EQ(serial_stats[i].mean_error, parallel_stats[i].mean_error);
+    EXPECT_EQ(serial_stats[i].max_tri_angle, parallel_stats[i].max_tri_angle);
+  }
+}
+
+TEST(ComputeReconstructionStatistics, Nominal) {
+  EXPECT_EQ(ComputeReconstructionStatistics(Reconstruction()).num_points3D, 0);
+
+  Reconstruction reconstruction = CreateNoisyReconstruction(100);
+  const ReconstructionStatistics stats =
+      ComputeReconstructionStatistics(reconstruction);
+  EXPECT_EQ(stats.num_points3D, reconstruction.NumPoints3D());
+  EXPECT_EQ(stats.num_observations, reconstruction.ComputeNumObservations());
+  EXPECT_NEAR(
+      stats.mean_track_length, reconstruction.ComputeMeanTrackLength(), 1e-12);
+  EXPECT_GT(stats.mean_reproj_error, 0);
+  EXPECT_GT(stats.median_tri_angle, 0);
+
+  // The mean over all observations weights the per-point errors by the track
+  // lengths.
+  reconstruction.UpdatePoint3DErrors();
+  double error_sum = 0;
+  for (const auto& [_, point3D] : reconstruction.Points3D()) {
+    error_sum += point3D.error * point3D.track.Length();
+  }
+  EXPECT_NEAR(
+      stats.mean_reproj_error, error_sum / stats.num_observations, 1e-9);
+}
+
+}  // namespace
+}  // namespace colmap
@@ -171,6 +171,73 @@ TEST(Reconstruction, AssignCopy) {
   ExpectValidPtrs(reconstruction_copy);
 }
 
+TEST(Reconstruction, CopyIsIndependentSnapshot) {
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 3;
+  synthetic_dataset_options.num_points3D = 10;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+  const Reconstruction snapshot = reconstruction;
+
+  const std::unordered_set<point3D_t> point3D_ids =
+      reconstruction.Point3DIds();
+  const point3D_t point3D_id = *point3D_ids.begin();
+  const point3D_t deleted_point3D_id = *std::next(point3D_ids.begin());
+  const Eigen::Vector3d xyz = snapshot.Point3D(point3D_id).xyz;
+  reconstruction.Point3D(point3D_id).xyz += Eigen::Vector3d::Ones();
+  reconstruction.DeletePoint3D(deleted_point3D_id);
+
+  EXPECT_EQ(snapshot.Point3D(point3D_id).xyz, xyz);
+  EXPECT_TRUE(snapshot.ExistsPoint3D(deleted_point3D_id));
+  EXPECT_EQ(snapshot.NumPoints3D(), 10);
+  EXPECT_EQ(reconstruction.NumPoints3D(), 9);
+  ExpectValidPtrs(snapshot);
+}
+
+TEST(Reconstruction, CopyIsIndependentOfPreCopyReferences) {
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 3;
+  synthetic_dataset_options.num_points3D = 10;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+
+  const point3D_t point3D_id = *reconstruction.Point3DIds().begin();
+  struct Point3D& point3D = reconstruction.Point3D(point3D_id);
+  const Eigen::Vector3d xyz = point3D.xyz;
+  const Reconstruction copy = reconstruction;
+  point3D.xyz += Eigen::Vector3d::Ones();
+  point3D.track.DeleteElement(0);
+
+  EXPECT_EQ(reconstruction.Point3D(point3D_id).xyz,
+            xyz + Eigen::Vector3d::Ones());
+  EXPECT_EQ(copy.Point3D(point3D_id).xyz, xyz);
+  EXPECT_EQ(copy.Point3D(point3D_id).track.Length(),
+            reconstruction.Point3D(point3D_id).track.Length() + 1);
+}
+
+TEST(Reconstruction, Snapshot) {
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 3;
+  synthetic_dataset_options.num_points3D = 10;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+  const Reconstruction snapshot = reconstruction.Snapshot();
+  EXPECT_THAT(snapshot, ReconstructionEq(reconstruction));
+  ExpectValidPtrs(snapshot);
+
+  // Modifications through the reconstruction clone the shared points.
+  const point3D_t point3D_id = *reconstruction.Point3DIds().begin();
+  const Eigen::Vector3d xyz = snapshot.Point3D(point3D_id).xyz;
+  reconstruction.Point3D(point3D_id).xyz += Eigen::Vector3d::Ones();
+  EXPECT_EQ(snapshot.Point3D(point3D_id).xyz, xyz);
+}
+
 TEST(Reconstruction, Print) {
   Reconstruction reconstruction;
   SyntheticDatasetOptions synthetic_dataset_options;
@@ -568,6 +635,24 @@ TEST(Reconstruction, AddPoint3D) {
   EXPECT_EQ(reconstruction2.Point3DIds().count(5), 1);
 }
 
+TEST(Reconstruction, AddPoint3DWithHugeId) {
+  // Point ids read from files may be arbitrarily large.
+  constexpr point3D_t kHugePoint3DId = point3D_t(1) << 40;
+  Reconstruction reconstruction;
+  reconstruction.AddPoint3D(kHugePoint3DId, Point3D());
+  EXPECT_TRUE(reconstruction.ExistsPoint3D(kHugePoint3DId));
+  const point3D_t point3D_id =
+      reconstruction.AddPoint3D(Eigen::Vector3d::Random(), Track());
+  EXPECT_EQ(point3D_id, kHugePoint3DId + 1);
+  EXPECT_EQ(reconstruction.NumPoints3D(), 2);
+
+  const Reconstruction reconstruction_copy = reconstruction;
+  reconstruction.DeletePoint3D(kHugePoint3DId);
+  EXPECT_FALSE(reconstruction.ExistsPoint3D(kHugePoint3DId));
+  EXPECT_TRUE(reconstruction.ExistsPoint3D(point3D_id));
+  EXPECT_TRUE(reconstruction_copy.ExistsPoint3D(kHugePoint3DId));
+}
+
 TEST(Reconstruction, AddObservation) {
   Reconstruction reconstruction;
   GenerateReconstruction(3, &reconstruction);
@@ -906,6 +991,49 @@ TEST(Reconstruction, Crop) {
   EXPECT_FALSE(cropped2.Image(3).HasPose());
 }
 
+TEST(Reconstruction, CropWithPoints3DIndex) {
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 5;
+  synthetic_dataset_options.num_points3D = 200;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+  EXPECT_EQ(reconstruction.Points3DIndex(), nullptr);
+
+  reconstruction.BuildPoints3DIndex();
+  ASSERT_NE(reconstruction.Points3DIndex(), nullptr);
+  EXPECT_EQ(reconstruction.Points3DIndex()->Size(), 200);
+
+  // The index is maintained when deleting, adding, and transforming points.
+  const point3D_t deleted_point3D_id = *reconstruction.Point3DIds().begin();
+  reconstruction.DeletePoint3D(deleted_point3D_id);
+  EXPECT_FALSE(reconstruction.Points3DIndex()->Exists(deleted_point3D_id));
+  const point3D_t added_point3D_id =
+      reconstruction.AddPoint3D(Eigen::Vector3d(0.1, 0.2, 0.3), Track());
+  EXPECT_TRUE(reconstruction.Points3DIndex()->Exists(added_point3D_id));
+  reconstruction.Transform(
+      Sim3d(2, Eigen::Quaterniond::Identity(), Eigen::Vector3d(1, 2, 3)));
+  EXPECT_EQ(reconstruction.Points3DIndex()->Size(), 200);
+
+  // Copies share the index until it is modified.
+  Reconstruction reconstruction_copy = reconstruction;
+  EXPECT_EQ(reconstruction_copy.Points3DIndex(),
+            reconstruction.Points3DIndex());
+  reconstruction_copy.DeletePoint3D(added_point3D_id);
+  EXPECT_FALSE(reconstruction_copy.Points3DIndex()->Exists(added_point3D_id));
+  EXPECT_TRUE(reconstruction.Points3DIndex()->Exists(added_point3D_id));
+
+  const Eigen::AlignedBox3d bbox = reconstruction.ComputeBoundingBox(0.2, 0.7);
+  const Reconstruction cropped = reconstruction.Crop(bbox);
+  reconstruction.ClearPoints3DIndex();
+  EXPECT_EQ(reconstruction.Points3DIndex(), nullptr);
+  const Reconstruction expected_cropped = reconstruction.Crop(bbox);
+  EXPECT_GT(cropped.NumPoints3D(), 0);
+  EXPECT_LT(cropped.NumPoints3D(), reconstruction.NumPoints3D());
+  EXPECT_THAT(cropped, ReconstructionEq(expected_cropped));
+}
+
 TEST(Reconstruction, Transform) {
   Reconstruction reconstruction;
   GenerateReconstruction(3, &reconstruction);
@@ -1357,6 +1485,29 @@ TEST(Reconstruction, ReadWriteBinaryRoundtrip) {
   ExpectValidPtrs(loaded);
 }
 
+TEST(Reconstruction, ReadWriteMappedBinaryRoundtrip) {
+  SetPRNGSeed(0);
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 1;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 3;
+  synthetic_dataset_options.num_points3D = 5;
+  SynthesizeDataset(synthetic_dataset_options, &reconstruction);
+
+  const auto test_dir = CreateTestDir();
+  reconstruction.WriteBinary(test_dir);
+  reconstruction.WriteMappedBinary(test_dir);
+  EXPECT_FALSE(ExistsFile(test_dir / "points3D.bin"));
+  EXPECT_TRUE(ExistsFile(test_dir / "points3D.mbin"));
+
+  Reconstruction loaded;
+  loaded.Read(test_dir);
+
+  EXPECT_THAT(loaded, ReconstructionEq(reconstruction));
+  ExpectValidPtrs(loaded);
+}
+
 TEST(Reconstruction, ReadAutoDetectFormat) {
   SetPRNGSeed(0);
   Reconstruction reconstruction;
@@ -30,6 +30,7 @@
 #include "colmap/scene/rig.h"
 
 #include "colmap/geometry/pose.h"
+#include "colmap/util/threading.h"
 
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -154,13 +155,20 @@ void UpdateRigsAndFramesFromDatabase(const Database& database,
     image_name_to_image.emplace(image.Name(), &image);
   }
 
+  // Read all images at once instead of one by one for every visited frame.
+  std::unordered_map<image_t, Image> database_images;
+  database_images.reserve(database.NumImages());
+  for (auto& image : database.ReadAllImages()) {
+    database_images.emplace(image.ImageId(), std::move(image));
+  }
+
   auto visit_frame_data =
-      [&database, &image_name_to_image, &database_frames](
+      [&database_images, &image_name_to_image, &database_frames](
           const std::function<void(const Frame&, const Image&, const Image&)>&
               visitor) {
         for (const Frame& database_frame : database_frames) {
           for (const data_t& data_id : database_frame.ImageIds()) {
-            const Image database_image = database.ReadImage(data_id.id);
+            const Image& database_image = database_images.at(data_id.id);
             const auto reconstruction_image =
                 image_name_to_image.find(database_image.Name());
             if (reconstruction_image == image_name_to_image.end()) {
@@ -336,47 +344,70 @@ std::vector<RigConfig> ReadRigConfig(
 void ApplyRigConfig(const std::vector<RigConfig>& configs,
                     Database& database,
                     Reconstruction* reconstruction) {
+  // Write all updates in a single transaction instead of committing every
+  // camera, rig, and frame separately, which dominates the runtime for large
+  // databases.
+  DatabaseTransaction database_transaction(&database);
+
   database.ClearFrames();
   database.ClearRigs();
 
   const std::vector<Image> images = database.ReadAllImages();
-  std::set<image_t> configured_image_ids;
+  const int64_t num_images = images.size();
+  std::vector<char> configured_images(num_images, false);
 
   for (const RigConfig& config : configs) {
     Rig rig;
 
     const size_t num_cameras = config.cameras.size();
 
+    // Match the image names against the prefixes of the cameras in parallel.
+    // The matches of each chunk are concatenated in the order of the images.
+    using ImageCameraMatches = std::vector<std::pair<int64_t, size_t>>;
+    const ImageCameraMatches matches = ParallelReduce(
+        0,
+        num_images,
+        ImageCameraMatches(),
+        [&](const int64_t image_idx, ImageCameraMatches* matches) {
+          const std::string& image_name = images[image_idx].Name();
+          for (size_t camera_idx = 0; camera_idx < num_cameras; ++camera_idx) {
+            if (StringStartsWith(image_name,
+                                 config.cameras[camera_idx].image_prefix)) {
+              matches->emplace_back(image_idx, camera_idx);
+            }
+          }
+        },
+        [](ImageCameraMatches matches1, ImageCameraMatches matches2) {
+          matches1.insert(matches1.end(), matches2.begin(), matches2.end());
+          return matches1;
+        });
+
     std::vector<std::optional<camera_t>> camera_ids(num_cameras);
     std::map<std::string, std::vector<const Image*>> frame_name_to_images;
-    for (const Image& image : images) {
-      for (size_t camera_idx = 0; camera_idx < num_cameras; ++camera_idx) {
-        const auto& config_camera = config.cameras[camera_idx];
-        if (StringStartsWith(image.Name(), config_camera.image_prefix)) {
-          const std::string frame_name =
-              StringGetAfter(image.Name(), config_camera.image_prefix);
-          frame_name_to_images[frame_name].push_back(&image);
-          std::optional<camera_t>& camera_id = camera_ids[camera_idx];
-          if (camera_id.has_value()) {
-            THROW_CHECK_EQ(*camera_id, image.CameraId())
-                << "Inconsistent cameras for images with prefix: "
-                << config_camera.image_prefix
-                << ". Consider setting --ImageReader.single_camera_per_folder "
-                   "during feature extraction or manually assign consistent "
-                   "camera_id's.";
-          } else {
-            camera_id = image.CameraId();
-            if (config_camera.camera.has_value()) {
-              Camera database_camera = database.ReadCamera(image.CameraId());
-              CopyCameraIntrinsics(*config_camera.camera, database_camera);
-              database.UpdateCamera(database_camera);
-              if (reconstruction != nullptr) {
-                auto& reconstruction_camera =
-                    reconstruction->Camera(image.CameraId());
-                CopyCameraIntrinsics(*config_camera.camera,
-                                     reconstruction_camera);
-              }
-            }
+    for (const auto& [image_idx, camera_idx] : matches) {
+      const Image& image = images[image_idx];
+      const auto& config_camera = config.cameras[camera_idx];
+      const std::string frame_name =
+          StringGetAfter(image.Name(), config_camera.image_prefix);
+      frame_name_to_images[frame_name].push_back(&image);
+      std::optional<camera_t>& camera_id = camera_ids[camera_idx];
+      if (camera_id.has_value()) {
+        THROW_CHECK_EQ(*camera_id, image.CameraId())
+            << "Inconsistent cameras for images with prefix: "
+            << config_camera.image_prefix
+            << ". Consider setting --ImageReader.single_camera_per_folder "
+               "during feature extraction or manually assign consistent "
+               "camera_id's.";
+      } else {
+        camera_id = image.CameraId();
+        if (config_camera.camera.has_value()) {
+          Camera database_camera = database.ReadCamera(image.CameraId());
+          CopyCameraIntrinsics(*config_camera.camera, database_camera);
+          database.UpdateCamera(database_camera);
+          if (reconstruction != nullptr) {
+            auto& reconstruction_camera =
+                reconstruction->Camera(image.CameraId());
+            CopyCameraIntrinsics(*config_camera.camera, reconstruction_camera);
           }
         }
       }
@@ -403,8 +434,10 @@ void ApplyRigConfig(const std::vector<RigConfig>& configs,
     rig.SetRigId(database.WriteRig(rig));
     LOG(INFO) << "Configured: " << rig;
 
+    std::vector<Frame> frames;
+    frames.reserve(frame_name_to_images.size());
     for (auto& [frame_name, images] : frame_name_to_images) {
-      Frame frame;
+      Frame& frame = frames.emplace_back();
       frame.SetRigId(rig.RigId());
       for (const Image* image : images) {
         const data_t& data_id = image->DataId();
@@ -413,11 +446,20 @@ void ApplyRigConfig(const std::vector<RigConfig>& configs,
             << ", camera_id=" << image->CameraId() << ", name=" << image->Name()
             << ")";
         frame.AddDataId(data_id);
-        configured_image_ids.insert(image->ImageId());
       }
-      frame.SetFrameId(database.WriteFrame(frame));
-      LOG(INFO) << "Configured: " << frame;
     }
+    for (const auto& [image_idx, camera_idx] : matches) {
+      configured_images[image_idx] = true;
+    }
+
+    const std::vector<frame_t> frame_ids =
+        database.WriteFrames({frames.data(), frames.size()});
+    for (size_t frame_idx = 0; frame_idx < frames.size(); ++frame_idx) {
+      frames[frame_idx].SetFrameId(frame_ids[frame_idx]);
+      VLOG(2) << "Configured: " << frames[frame_idx];
+    }
+    LOG(INFO) << "Configured " << frames.size() << " frames of rig "
+              << rig.RigId();
 
     if (reconstruction != nullptr) {
       UpdateRigAndCameraCalibsFromReconstruction(
@@ -428,10 +470,12 @@ void ApplyRigConfig(const std::vector<RigConfig>& configs,
   // Create trivial rigs/frames for images without configuration.
   // This is necessary because we clear rigs/frames above.
   std::unordered_map<camera_t, rig_t> camera_to_rig_id;
-  for (const Image& image : images) {
-    if (configured_image_ids.count(image.ImageId()) > 0) {
+  std::vector<Frame> trivial_frames;
+  for (int64_t image_idx = 0; image_idx < num_images; ++image_idx) {
+    if (configured_images[image_idx]) {
       continue;
     }
+    const Image& image = images[image_idx];
     const sensor_t sensor_id(SensorType::CAMERA, image.CameraId());
     auto rig_id_it = camera_to_rig_id.find(image.CameraId());
     if (rig_id_it == camera_to_rig_id.end()) {
@@ -441,11 +485,11 @@ void ApplyRigConfig(const std::vector<RigConfig>& configs,
           camera_to_rig_id.emplace(image.CameraId(), database.WriteRig(rig))
               .first;
     }
-    Frame frame;
+    Frame& frame = trivial_frames.emplace_back();
     frame.SetRigId(rig_id_it->second);
     frame.AddDataId(data_t(sensor_id, image.ImageId()));
-    frame.SetFrameId(database.WriteFrame(frame));
   }
+  database.WriteFrames({trivial_frames.data(), trivial_frames.size()});
 
   if (reconstruction != nullptr) {
     UpdateRigsAndFramesFromDatabase(database, reconstruction);
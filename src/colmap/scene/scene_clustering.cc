@@ -30,6 +30,7 @@
 #include "colmap/scene/scene_clustering.h"
 
 #include "colmap/math/graph_cut.h"
+#include "colmap/util/threading.h"
 
 #include <set>
 
@@ -38,6 +39,9 @@ namespace colmap {
 bool SceneClustering::Options::Check() const {
   CHECK_OPTION_GT(branching, 0);
   CHECK_OPTION_GE(image_overlap, 0);
+  CHECK_OPTION_GT(leaf_max_num_images, 0);
+  CHECK_OPTION_GE(max_imbalance, 1.0);
+  CHECK_OPTION_NE(num_threads, 0);
   return true;
 }
 
@@ -64,7 +68,11 @@ void SceneClustering::Partition(
   root_cluster_->image_ids.insert(
       root_cluster_->image_ids.end(), image_ids.begin(), image_ids.end());
   if (options_.is_hierarchical) {
-    PartitionHierarchicalCluster(edges, num_inliers, root_cluster_.get());
+    const int num_leaf_clusters =
+        (image_ids.size() + options_.leaf_max_num_images - 1) /
+        options_.leaf_max_num_images;
+    PartitionHierarchicalCluster(
+        edges, num_inliers, num_leaf_clusters, root_cluster_.get());
   } else {
     PartitionFlatCluster(edges, num_inliers);
   }
@@ -73,21 +81,42 @@ void SceneClustering::Partition(
 void SceneClustering::PartitionHierarchicalCluster(
     const std::vector<std::pair<int, int>>& edges,
     const std::vector<int>& weights,
+    const int num_leaf_clusters,
     Cluster* cluster) {
   THROW_CHECK_EQ(edges.size(), weights.size());
 
   // If the cluster is small enough, we return from the recursive clustering.
-  if (edges.empty() || cluster->image_ids.size() <=
-                           static_cast<size_t>(options_.leaf_max_num_images)) {
+  if (edges.empty() ||
+      (options_.balanced_leaves
+           ? num_leaf_clusters <= 1
+           : cluster->image_ids.size() <=
+                 static_cast<size_t>(options_.leaf_max_num_images))) {
     return;
   }
 
-  // Partition the cluster using a normalized cut on the scene graph.
-  const auto labels =
-      ComputeNormalizedMinGraphCut(edges, weights, options_.branching);
+  // Partition the cluster using a normalized cut on the scene graph. For
+  // balanced leaves, the leaves are distributed as evenly as possible over the
+  // child clusters and the images in proportion to their number of leaves.
+  int num_child_clusters = options_.branching;
+  std::vector<int> child_num_leaf_clusters(num_child_clusters, 0);
+  std::unordered_map<int, int> labels;
+  if (options_.balanced_leaves) {
+    num_child_clusters = std::min(options_.branching, num_leaf_clusters);
+    child_num_leaf_clusters.resize(num_child_clusters);
+    std::vector<double> part_weights(num_child_clusters);
+    for (int i = 0; i < num_child_clusters; ++i) {
+      child_num_leaf_clusters[i] = num_leaf_clusters / num_child_clusters +
+                                   (i < num_leaf_clusters % num_child_clusters);
+      part_weights[i] = child_num_leaf_clusters[i];
+    }
+    labels = ComputeNormalizedMinGraphCut(
+        edges, weights, part_weights, options_.max_imbalance);
+  } else {
+    labels = ComputeNormalizedMinGraphCut(edges, weights, num_child_clusters);
+  }
 
   // Assign the images to the clustered child clusters.
-  cluster->child_clusters.resize(options_.branching);
+  cluster->child_clusters.resize(num_child_clusters);
   for (const auto image_id : cluster->image_ids) {
     if (labels.count(image_id)) {
       auto& child_cluster = cluster->child_clusters.at(labels.at(image_id));
@@ -100,10 +129,10 @@ void SceneClustering::PartitionHierarchicalCluster(
   }
 
   // Collect the edges based on whether they are inter or intra child clusters.
-  std::vector<std::vector<std::pair<int, int>>> child_edges(options_.branching);
-  std::vector<std::vector<int>> child_weights(options_.branching);
+  std::vector<std::vector<std::pair<int, int>>> child_edges(num_child_clusters);
+  std::vector<std::vector<int>> child_weights(num_child_clusters);
   std::vector<std::vector<std::pair<std::pair<int, int>, int>>>
-      overlapping_edges(options_.branching);
+      overlapping_edges(num_child_clusters);
   for (size_t i = 0; i < edges.size(); ++i) {
     const int label1 = labels.at(edges[i].first);
     const int label2 = labels.at(edges[i].second);
@@ -116,20 +145,78 @@ void SceneClustering::PartitionHierarchicalCluster(
     }
   }
 
-  // Recursively partition all the child clusters.
-  for (int i = 0; i < options_.branching; ++i) {
-    // Skip empty clusters or clusters where the current cluster has as many
-    // images as its child to avoid infinite loops. This can happen because
-    // the normalized cut sometimes decides to put all images into one
-    // cluster.
-    if (cluster->child_clusters[i].image_ids.empty() ||
-        cluster->child_clusters[i].image_ids.size() ==
-            cluster->image_ids.size()) {
-      continue;
-    }
+  // Recursively partition all the child clusters. The child clusters are
+  // independent and thus partitioned concurrently.
+  ParallelFor(
+      0,
+      num_child_clusters,
+      [&](const int64_t begin, const int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          // Skip empty clusters or clusters where the current cluster has as
+          // many images as its child to avoid infinite loops. This can happen
+          // because the normalized cut sometimes decides to put all images
+          // into one cluster.
+          if (cluster->child_clusters[i].image_ids.empty() ||
+              cluster->child_clusters[i].image_ids.size() ==
+                  cluster->image_ids.size()) {
+            continue;
+          }
+
+          PartitionHierarchicalCluster(child_edges[i],
+                                       child_weights[i],
+                                       child_num_leaf_clusters[i],
+                                       &cluster->child_clusters[i]);
+        }
+      },
+      options_.num_threads,
+      /*grain_size=*/1);
 
-    PartitionHierarchicalCluster(
-        child_edges[i], child_weights[i], &cluster->child_clusters[i]);
+  if (options_.image_overlap > 0) {
+    ParallelFor(
+        0,
+        num_child_clusters,
+        [&](const int64_t begin, const int64_t end) {
+          for (int64_t i = begin; i < end; ++i) {
+            // Sort the overlapping edges by the number of inlier matches, such
+            // that we add overlapping images with many common observations.
+            std::sort(overlapping_edges[i].begin(),
+                      overlapping_edges[i].end(),
+                      [](const std::pair<std::pair<int, int>, int>& edge1,
+                         const std::pair<std::pair<int, int>, int>& edge2) {
+                        return edge1.second > edge2.second;
+                      });
+
+            // Select overlapping edges at random and add image to cluster.
+            std::set<int> overlapping_image_ids;
+            for (const auto& edge : overlapping_edges[i]) {
+              if (labels.at(edge.first.first) == i) {
+                overlapping_image_ids.insert(edge.first.second);
+              } else {
+                overlapping_image_ids.insert(edge.first.first);
+              }
+              if (overlapping_image_ids.size() >=
+                  static_cast<size_t>(options_.image_overlap)) {
+                break;
+              }
+            }
+
+            // Recursively append the overlapping images to cluster and its
+            // children.
+            std::function<void(Cluster*)> InsertOverlappingImageIds =
+                [&](Cluster* cluster) {
+                  cluster->image_ids.insert(cluster->image_ids.end(),
+                                            overlapping_image_ids.begin(),
+                                            overlapping_image_ids.end());
+                  for (auto& child_cluster : cluster->child_clusters) {
+                    InsertOverlappingImageIds(&child_cluster);
+                  }
+                };
+
+            InsertOverlappingImageIds(&cluster->child_clusters[i]);
+          }
+        },
+        options_.num_threads,
+        /*grain_size=*/1);
   }
 
   // Remove empty clusters.
@@ -148,46 +235,6 @@ void SceneClustering::PartitionHierarchicalCluster(
           cluster->child_clusters[0].image_ids.size()) {
     cluster->child_clusters = {};
   }
-
-  if (options_.image_overlap > 0) {
-    for (int i = 0; i < options_.branching; ++i) {
-      // Sort the overlapping edges by the number of inlier matches, such
-      // that we add overlapping images with many common observations.
-      std::sort(overlapping_edges[i].begin(),
-                overlapping_edges[i].end(),
-                [](const std::pair<std::pair<int, int>, int>& edge1,
-                   const std::pair<std::pair<int, int>, int>& edge2) {
-                  return edge1.second > edge2.second;
-                });
-
-      // Select overlapping edges at random and add image to cluster.
-      std::set<int> overlapping_image_ids;
-      for (const auto& edge : overlapping_edges[i]) {
-        if (labels.at(edge.first.first) == i) {
-          overlapping_image_ids.insert(edge.first.second);
-        } else {
-          overlapping_image_ids.insert(edge.first.first);
-        }
-        if (overlapping_image_ids.size() >=
-            static_cast<size_t>(options_.image_overlap)) {
-          break;
-        }
-      }
-
-      // Recursively append the overlapping images to cluster and its children.
-      std::function<void(Cluster*)> InsertOverlappingImageIds =
-          [&](Cluster* cluster) {
-            cluster->image_ids.insert(cluster->image_ids.end(),
-                                      overlapping_image_ids.begin(),
-                                      overlapping_image_ids.end());
-            for (auto& child_cluster : cluster->child_clusters) {
-              InsertOverlappingImageIds(&child_cluster);
-            }
-          };
-
-      InsertOverlappingImageIds(&cluster->child_clusters[i]);
-    }
-  }
 }
 
 void SceneClustering::PartitionFlatCluster(
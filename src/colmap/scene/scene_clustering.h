@@ -61,6 +61,20 @@ class SceneClustering {
     // overlap` images to satisfy the overlap constraint.
     int leaf_max_num_images = 500;
 
+    // Whether to determine the number of leaf clusters upfront from the number
+    // of images and `leaf_max_num_images`. Every cluster is then split in
+    // proportion to the number of leaves in its child clusters, such that all
+    // leaf clusters have about the same number of images. Only applies to the
+    // hierarchical clustering.
+    bool balanced_leaves = false;
+
+    // The maximum size of a child cluster relative to its target size for
+    // balanced leaves, e.g., 1.03 allows child clusters to be 3% larger.
+    double max_imbalance = 1.03;
+
+    // The number of threads used to partition independent clusters.
+    int num_threads = -1;
+
     bool Check() const;
   };
 
@@ -84,6 +98,7 @@ class SceneClustering {
   void PartitionHierarchicalCluster(
       const std::vector<std::pair<int, int>>& edges,
       const std::vector<int>& weights,
+      int num_leaf_clusters,
       Cluster* cluster);
 
   void PartitionFlatCluster(const std::vector<std::pair<int, int>>& edges,
@@ -158,5 +158,46 @@ TEST(SceneClustering, ThreeFlatClustersTwoOverlap) {
   EXPECT_TRUE(image_ids2.count(5));
 }
 
+TEST(SceneClustering, BalancedLeaves) {
+  // Grid of images, where each image is connected to its direct neighbors.
+  const int kNumRows = 40;
+  const int kNumCols = 50;
+  std::vector<std::pair<image_t, image_t>> image_pairs;
+  std::vector<int> num_inliers;
+  for (int row = 0; row < kNumRows; ++row) {
+    for (int col = 0; col < kNumCols; ++col) {
+      const image_t image_id = row * kNumCols + col;
+      if (col + 1 < kNumCols) {
+        image_pairs.emplace_back(image_id, image_id + 1);
+        num_inliers.push_back(100);
+      }
+      if (row + 1 < kNumRows) {
+        image_pairs.emplace_back(image_id, image_id + kNumCols);
+        num_inliers.push_back(100);
+      }
+    }
+  }
+
+  SceneClustering::Options options;
+  options.branching = 2;
+  options.image_overlap = 0;
+  options.leaf_max_num_images = 300;
+  options.balanced_leaves = true;
+  SceneClustering scene_clustering(options);
+  scene_clustering.Partition(image_pairs, num_inliers);
+
+  // The 2000 images are distributed evenly over ceil(2000 / 300) leaves.
+  const auto leaf_clusters = scene_clustering.GetLeafClusters();
+  EXPECT_EQ(leaf_clusters.size(), 7);
+  std::set<image_t> image_ids;
+  for (const auto* leaf_cluster : leaf_clusters) {
+    EXPECT_GE(leaf_cluster->image_ids.size(), 250);
+    EXPECT_LE(leaf_cluster->image_ids.size(), 320);
+    image_ids.insert(leaf_cluster->image_ids.begin(),
+                     leaf_cluster->image_ids.end());
+  }
+  EXPECT_EQ(image_ids.size(), kNumRows * kNumCols);
+}
+
 }  // namespace
 }  // namespace colmap
@@ -181,7 +181,9 @@ void SynthesizeChainedMatches(double inlier_match_ratio,
                               Database* database) {
   std::unordered_map<image_pair_t, TwoViewGeometry> two_view_geometries;
   for (const auto& point3D : reconstruction->Points3D()) {
-    std::vector<TrackElement> track_elements = point3D.second.track.Elements();
+    std::vector<TrackElement> track_elements(
+        point3D.second.track.Elements().begin(),
+        point3D.second.track.Elements().end());
     std::sort(track_elements.begin(),
               track_elements.end(),
               [](const TrackElement& left, const TrackElement& right) {
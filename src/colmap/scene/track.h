@@ -30,6 +30,7 @@
 #pragma once
 
 #include "colmap/util/logging.h"
+#include "colmap/util/small_vector.h"
 #include "colmap/util/types.h"
 
 #include <vector>
@@ -49,6 +50,10 @@ struct TrackElement {
   inline bool operator!=(const TrackElement& other) const;
 };
 
+// Most tracks only have a few elements, which are stored inline in the track
+// to avoid a separate heap allocation for each of the many 3D points.
+using TrackElements = SmallVector<TrackElement, 3>;
+
 class Track {
  public:
   Track();
@@ -57,9 +62,9 @@ class Track {
   inline size_t Length() const;
 
   // Access all elements.
-  inline const std::vector<TrackElement>& Elements() const;
-  inline std::vector<TrackElement>& Elements();
-  inline void SetElements(std::vector<TrackElement> elements);
+  inline const TrackElements& Elements() const;
+  inline TrackElements& Elements();
+  inline void SetElements(const std::vector<TrackElement>& elements);
 
   // Access specific elements.
   inline const TrackElement& Element(size_t idx) const;
@@ -70,6 +75,7 @@ class Track {
   inline void AddElement(const TrackElement& element);
   inline void AddElement(image_t image_id, point2D_t point2D_idx);
   inline void AddElements(const std::vector<TrackElement>& elements);
+  inline void AddElements(const TrackElements& elements);
 
   // Delete existing element.
   inline void DeleteElement(size_t idx);
@@ -79,14 +85,15 @@ class Track {
   // specified number of elements.
   inline void Reserve(size_t num_elements);
 
-  // Shrink the capacity of track vector to fit its size to save memory.
+  // Shrink the capacity of the track to fit its size to save memory. Short
+  // tracks are moved back into the inline storage.
   inline void Compress();
 
   inline bool operator==(const Track& other) const;
   inline bool operator!=(const Track& other) const;
 
  private:
-  std::vector<TrackElement> elements_;
+  TrackElements elements_;
 };
 
 std::ostream& operator<<(std::ostream& stream, const TrackElement& track_el);
@@ -106,12 +113,12 @@ bool TrackElement::operator!=(const TrackElement& other) const {
 
 size_t Track::Length() const { return elements_.size(); }
 
-const std::vector<TrackElement>& Track::Elements() const { return elements_; }
+const TrackElements& Track::Elements() const { return elements_; }
 
-std::vector<TrackElement>& Track::Elements() { return elements_; }
+TrackElements& Track::Elements() { return elements_; }
 
-void Track::SetElements(std::vector<TrackElement> elements) {
-  elements_ = std::move(elements);
+void Track::SetElements(const std::vector<TrackElement>& elements) {
+  elements_.assign(elements.begin(), elements.end());
 }
 
 // Access specific elements.
@@ -137,6 +144,10 @@ void Track::AddElements(const std::vector<TrackElement>& elements) {
   elements_.insert(elements_.end(), elements.begin(), elements.end());
 }
 
+void Track::AddElements(const TrackElements& elements) {
+  elements_.insert(elements_.end(), elements.begin(), elements.end());
+}
+
 void Track::DeleteElement(const size_t idx) {
   THROW_CHECK_LT(idx, elements_.size());
   elements_.erase(elements_.begin() + idx);
@@ -153,7 +153,9 @@ TEST(Track, DeleteElement) {
 TEST(Track, Reserve) {
   Track track;
   track.Reserve(2);
-  EXPECT_EQ(track.Elements().capacity(), 2);
+  EXPECT_EQ(track.Elements().capacity(), TrackElements::kInlineCapacity);
+  track.Reserve(5);
+  EXPECT_EQ(track.Elements().capacity(), 5);
 }
 
 TEST(Track, Compress) {
@@ -162,12 +164,36 @@ TEST(Track, Compress) {
   track.AddElement(0, 2);
   track.AddElement(0, 3);
   track.AddElement(0, 3);
+  track.AddElement(0, 4);
+  EXPECT_EQ(track.Elements().capacity(), 6);
+  track.DeleteElement(0);
+  EXPECT_EQ(track.Elements().capacity(), 6);
+  track.Compress();
   EXPECT_EQ(track.Elements().capacity(), 4);
   track.DeleteElement(0);
   track.DeleteElement(0);
-  EXPECT_EQ(track.Elements().capacity(), 4);
   track.Compress();
-  EXPECT_EQ(track.Elements().capacity(), 2);
+  EXPECT_EQ(track.Elements().capacity(), TrackElements::kInlineCapacity);
+  EXPECT_EQ(track.Element(0).point2D_idx, 3);
+  EXPECT_EQ(track.Element(1).point2D_idx, 4);
+}
+
+TEST(Track, StoresShortTracksInline) {
+  Track track;
+  const TrackElement* inline_data = track.Elements().data();
+  for (size_t i = 0; i < TrackElements::kInlineCapacity; ++i) {
+    track.AddElement(1, i);
+  }
+  EXPECT_EQ(track.Elements().data(), inline_data);
+  track.AddElement(2, 0);
+  EXPECT_NE(track.Elements().data(), inline_data);
+  EXPECT_EQ(track.Length(), TrackElements::kInlineCapacity + 1);
+
+  Track copy = track;
+  EXPECT_EQ(copy, track);
+  copy.DeleteElement(2, 0);
+  EXPECT_NE(copy, track);
+  EXPECT_EQ(track.Length(), TrackElements::kInlineCapacity + 1);
 }
 
 }  // namespace
@@ -39,29 +39,32 @@ VisibilityPyramid::VisibilityPyramid() : VisibilityPyramid(0, 0, 0) {}
 VisibilityPyramid::VisibilityPyramid(const size_t num_levels,
                                      const size_t width,
                                      const size_t height)
-    : width_(width), height_(height), score_(0), max_score_(0) {
-  pyramid_.resize(num_levels);
+    : width_(width),
+      height_(height),
+      score_(0),
+      max_score_(0),
+      num_levels_(num_levels) {
   for (size_t level = 0; level < num_levels; ++level) {
-    const size_t level_plus_one = level + 1;
-    const int dim = 1 << level_plus_one;
-    pyramid_[level].setZero(dim, dim);
-    max_score_ += dim * dim * dim * dim;
+    const size_t num_level_cells = size_t(1) << (2 * (level + 1));
+    max_score_ += num_level_cells * num_level_cells;
   }
+  cells_.resize(LevelOffset(num_levels), 0);
 }
 
 void VisibilityPyramid::SetPoint(const double x, const double y) {
-  THROW_CHECK_GT(pyramid_.size(), 0);
+  THROW_CHECK_GT(num_levels_, 0);
 
   size_t cx = 0;
   size_t cy = 0;
   CellForPoint(x, y, &cx, &cy);
 
-  for (int i = static_cast<int>(pyramid_.size() - 1); i >= 0; --i) {
-    auto& level = pyramid_[i];
+  for (int i = static_cast<int>(num_levels_ - 1); i >= 0; --i) {
+    const size_t dim = size_t(1) << (i + 1);
+    uint32_t& cell = cells_[LevelOffset(i) + cy * dim + cx];
 
-    level(cy, cx) += 1;
-    if (level(cy, cx) == 1) {
-      score_ += level.size();
+    cell += 1;
+    if (cell == 1) {
+      score_ += dim * dim;
     }
 
     cx = cx >> 1;
@@ -72,18 +75,19 @@ void VisibilityPyramid::SetPoint(const double x, const double y) {
 }
 
 void VisibilityPyramid::ResetPoint(const double x, const double y) {
-  THROW_CHECK_GT(pyramid_.size(), 0);
+  THROW_CHECK_GT(num_levels_, 0);
 
   size_t cx = 0;
   size_t cy = 0;
   CellForPoint(x, y, &cx, &cy);
 
-  for (int i = static_cast<int>(pyramid_.size() - 1); i >= 0; --i) {
-    auto& level = pyramid_[i];
+  for (int i = static_cast<int>(num_levels_ - 1); i >= 0; --i) {
+    const size_t dim = size_t(1) << (i + 1);
+    uint32_t& cell = cells_[LevelOffset(i) + cy * dim + cx];
 
-    level(cy, cx) -= 1;
-    if (level(cy, cx) == 0) {
-      score_ -= level.size();
+    cell -= 1;
+    if (cell == 0) {
+      score_ -= dim * dim;
     }
 
     cx = cx >> 1;
@@ -99,7 +103,7 @@ void VisibilityPyramid::CellForPoint(const double x,
                                      size_t* cy) const {
   THROW_CHECK_GT(width_, 0);
   THROW_CHECK_GT(height_, 0);
-  const int max_dim = 1 << pyramid_.size();
+  const int max_dim = 1 << num_levels_;
   *cx = Clamp<size_t>(max_dim * x / width_, 0, max_dim - 1);
   *cy = Clamp<size_t>(max_dim * y / height_, 0, max_dim - 1);
 }
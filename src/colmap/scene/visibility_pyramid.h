@@ -29,12 +29,9 @@
 
 #pragma once
 
-#include "colmap/util/eigen_alignment.h"
-
+#include <cstdint>
 #include <vector>
 
-#include <Eigen/Core>
-
 namespace colmap {
 
 // A class that captures the distribution of points in a 2D grid.
@@ -66,6 +63,9 @@ class VisibilityPyramid {
  private:
   void CellForPoint(double x, double y, size_t* cx, size_t* cy) const;
 
+  // Offset of the first cell of the given level in the flattened cells.
+  inline static size_t LevelOffset(size_t level);
+
   // Range of the input points.
   size_t width_;
   size_t height_;
@@ -76,15 +76,21 @@ class VisibilityPyramid {
   // The maximum score when all cells are populated.
   size_t max_score_;
 
-  // The visibilty pyramid with multiple levels.
-  std::vector<Eigen::MatrixXi> pyramid_;
+  // The number of pyramid levels.
+  size_t num_levels_;
+
+  // The cell counts of all levels, stored in a single contiguous buffer from
+  // the coarsest to the finest level and row-major within each level. This
+  // avoids one heap allocation per level and keeps the cells visited by
+  // SetPoint/ResetPoint for all levels close in memory.
+  std::vector<uint32_t> cells_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 // Implementation
 ////////////////////////////////////////////////////////////////////////////////
 
-size_t VisibilityPyramid::NumLevels() const { return pyramid_.size(); }
+size_t VisibilityPyramid::NumLevels() const { return num_levels_; }
 
 size_t VisibilityPyramid::Width() const { return width_; }
 
@@ -94,4 +100,9 @@ size_t VisibilityPyramid::Score() const { return score_; }
 
 size_t VisibilityPyramid::MaxScore() const { return max_score_; }
 
+size_t VisibilityPyramid::LevelOffset(const size_t level) {
+  // Sum of 4^(l+1) for all coarser levels l < level.
+  return ((size_t(1) << (2 * (level + 1))) - 4) / 3;
+}
+
 }  // namespace colmap
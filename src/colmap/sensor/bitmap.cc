@@ -33,11 +33,19 @@
 #include "colmap/util/file.h"
 #include "colmap/util/logging.h"
 #include "colmap/util/oiio_utils.h"
+#include "colmap/util/threading.h"
 
 #include <OpenImageIO/color.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imageio.h>
 
+#if defined(COLMAP_LIBJPEG_ENABLED)
+#include <csetjmp>
+#include <cstdio>
+
+#include <jpeglib.h>
+#endif
+
 namespace colmap {
 namespace {
 
@@ -140,6 +148,313 @@ bool IsEquivalentColorSpace(const std::string_view& colorspace1,
 #endif
 }
 
+// Number of consecutive rows processed by each task of the row-parallel image
+// operations, which amortizes the scheduling overhead and, for resampling, the
+// source rows shared between neighboring chunks.
+constexpr int64_t kNumRowsPerChunk = 64;
+
+template <int kChannels>
+std::optional<BitmapColor<float>> InterpolateBilinearImpl(const uint8_t* data,
+                                                          const int width,
+                                                          const int height,
+                                                          const double x,
+                                                          const double y) {
+  const int x0 = static_cast<int>(std::floor(x));
+  const int x1 = x0 + 1;
+  const int y0 = static_cast<int>(std::floor(y));
+  const int y1 = y0 + 1;
+
+  if (x0 < 0 || x1 >= width || y0 < 0 || y1 >= height) {
+    return std::nullopt;
+  }
+
+  const double dx = x - x0;
+  const double dy = y - y0;
+  const double dx_1 = 1 - dx;
+  const double dy_1 = 1 - dy;
+
+  const int pitch = width * kChannels;
+  const uint8_t* p00 = &data[y0 * pitch + kChannels * x0];
+  const uint8_t* p01 = &data[y0 * pitch + kChannels * x1];
+  const uint8_t* p10 = &data[y1 * pitch + kChannels * x0];
+  const uint8_t* p11 = &data[y1 * pitch + kChannels * x1];
+
+  float values[kChannels];
+  for (int c = 0; c < kChannels; ++c) {
+    // Top row, column-wise linear interpolation.
+    const double v0 = dx_1 * p00[c] + dx * p01[c];
+    // Bottom row, column-wise linear interpolation.
+    const double v1 = dx_1 * p10[c] + dx * p11[c];
+    // Row-wise linear interpolation.
+    values[c] = dy_1 * v0 + dy * v1;
+  }
+
+  if constexpr (kChannels == 1) {
+    return BitmapColor<float>(values[0], values[0], values[0]);
+  } else {
+    return BitmapColor<float>(values[0], values[1], values[2]);
+  }
+}
+
+// Contributions of the source pixels to the target pixels along one image
+// dimension. Target pixel i is the weighted sum of num_taps[i] consecutive
+// source pixels starting at offsets[i] with the weights starting at
+// weights[i * max_num_taps].
+struct ResampleWeights {
+  int max_num_taps = 0;
+  std::vector<int> offsets;
+  std::vector<int> num_taps;
+  std::vector<float> weights;
+};
+
+double LanczosKernel(double x) {
+  constexpr double kRadius = 3;
+  x = std::abs(x);
+  if (x < 1e-8) {
+    return 1;
+  } else if (x >= kRadius) {
+    return 0;
+  }
+  const double pi_x = M_PI * x;
+  return kRadius * std::sin(pi_x) * std::sin(pi_x / kRadius) / (pi_x * pi_x);
+}
+
+ResampleWeights ComputeResampleWeights(const int size,
+                                       const int new_size,
+                                       const Bitmap::RescaleFilter filter) {
+  const double scale = static_cast<double>(size) / new_size;
+  // Widen the filter when downsampling, such that it integrates over the
+  // footprint of the target pixels in the source image.
+  const double filter_scale = std::max(1.0, scale);
+
+  double radius = 0;
+  switch (filter) {
+    case Bitmap::RescaleFilter::kBilinear:
+      radius = 1;
+      break;
+    case Bitmap::RescaleFilter::kBox:
+      radius = 0.5;
+      break;
+    case Bitmap::RescaleFilter::kLanczos:
+      radius = 3;
+      break;
+  }
+  const double support = radius * filter_scale;
+
+  ResampleWeights weights;
+  weights.max_num_taps = static_cast<int>(std::ceil(2 * support)) + 1;
+  weights.offsets.resize(new_size);
+  weights.num_taps.resize(new_size);
+  weights.weights.resize(static_cast<size_t>(new_size) * weights.max_num_taps,
+                         0.f);
+
+  std::vector<double> tap_weights(weights.max_num_taps);
+  for (int i = 0; i < new_size; ++i) {
+    // The upper left pixel center is at 0.5 in both images.
+    const double center = (i + 0.5) * scale;
+    const int begin =
+        std::max(0, static_cast<int>(std::floor(center - support)));
+    const int end =
+        std::min(size, static_cast<int>(std::ceil(center + support)));
+    THROW_CHECK_LT(begin, end);
+    const int num_taps = end - begin;
+    THROW_CHECK_LE(num_taps, weights.max_num_taps);
+
+    double sum = 0;
+    for (int k = 0; k < num_taps; ++k) {
+      const double x = begin + k + 0.5 - center;
+      switch (filter) {
+        case Bitmap::RescaleFilter::kBilinear:
+          tap_weights[k] = std::max(0.0, 1 - std::abs(x) / filter_scale);
+          break;
+        case Bitmap::RescaleFilter::kBox:
+          // Overlap of the source pixel with the target pixel footprint.
+          tap_weights[k] = std::max(
+              0.0, std::min(x + 0.5, support) - std::max(x - 0.5, -support));
+          break;
+        case Bitmap::RescaleFilter::kLanczos:
+          tap_weights[k] = LanczosKernel(x / filter_scale);
+          break;
+      }
+      sum += tap_weights[k];
+    }
+    THROW_CHECK_GT(sum, 0);
+
+    weights.offsets[i] = begin;
+    weights.num_taps[i] = num_taps;
+    float* target_weights = &weights.weights[i * weights.max_num_taps];
+    for (int k = 0; k < num_taps; ++k) {
+      target_weights[k] = static_cast<float>(tap_weights[k] / sum);
+    }
+  }
+
+  return weights;
+}
+
+// Separable resampling of an interleaved 8-bit image, where each chunk of
+// target rows is first resampled horizontally from the source rows in its
+// footprint and then vertically. The inner loops run over contiguous floats
+// and are vectorized by the compiler. Every target pixel is computed by the
+// same sequence of operations, independent of the chunking.
+template <int kChannels>
+void ResampleImage(const uint8_t* data,
+                   const int width,
+                   const int height,
+                   const int new_width,
+                   const int new_height,
+                   const Bitmap::RescaleFilter filter,
+                   uint8_t* new_data) {
+  const ResampleWeights x_weights =
+      ComputeResampleWeights(width, new_width, filter);
+  const ResampleWeights y_weights =
+      ComputeResampleWeights(height, new_height, filter);
+
+  const size_t pitch = static_cast<size_t>(width) * kChannels;
+  const size_t new_pitch = static_cast<size_t>(new_width) * kChannels;
+
+  ParallelFor(
+      0,
+      new_height,
+      [&](const int64_t y_begin, const int64_t y_end) {
+        const int row_begin = y_weights.offsets[y_begin];
+        const int row_end =
+            y_weights.offsets[y_end - 1] + y_weights.num_taps[y_end - 1];
+
+        // Horizontal pass over the source rows in the footprint of the chunk.
+        std::vector<float> rows((row_end - row_begin) * new_pitch);
+        for (int row = row_begin; row < row_end; ++row) {
+          const uint8_t* src_row = data + row * pitch;
+          float* dst_row = &rows[(row - row_begin) * new_pitch];
+          for (int x = 0; x < new_width; ++x) {
+            const uint8_t* src = src_row + x_weights.offsets[x] * kChannels;
+            const float* weights =
+                &x_weights.weights[x * x_weights.max_num_taps];
+            float sums[kChannels] = {0};
+            for (int k = 0; k < x_weights.num_taps[x]; ++k) {
+              for (int c = 0; c < kChannels; ++c) {
+                sums[c] += weights[k] * src[k * kChannels + c];
+              }
+            }
+            for (int c = 0; c < kChannels; ++c) {
+              dst_row[x * kChannels + c] = sums[c];
+            }
+          }
+        }
+
+        // Vertical pass into the target rows of the chunk.
+        std::vector<float> sums(new_pitch);
+        for (int64_t y = y_begin; y < y_end; ++y) {
+          std::fill(sums.begin(), sums.end(), 0.f);
+          const float* weights =
+              &y_weights.weights[y * y_weights.max_num_taps];
+          for (int k = 0; k < y_weights.num_taps[y]; ++k) {
+            const float weight = weights[k];
+            const float* src_row =
+                &rows[(y_weights.offsets[y] + k - row_begin) * new_pitch];
+            for (size_t i = 0; i < new_pitch; ++i) {
+              sums[i] += weight * src_row[i];
+            }
+          }
+          uint8_t* dst_row = new_data + y * new_pitch;
+          for (size_t i = 0; i < new_pitch; ++i) {
+            dst_row[i] = static_cast<uint8_t>(
+                std::min(255.f, std::max(0.f, sums[i])) + 0.5f);
+          }
+        }
+      },
+      ThreadPool::kMaxNumThreads,
+      kNumRowsPerChunk);
+}
+
+#if defined(COLMAP_LIBJPEG_ENABLED)
+
+struct JpegErrorManager {
+  jpeg_error_mgr error_mgr;
+  std::jmp_buf jump_buffer;
+};
+
+void JpegErrorExit(j_common_ptr cinfo) {
+  char message[JMSG_LENGTH_MAX];
+  (*cinfo->err->format_message)(cinfo, message);
+  VLOG(3) << "Failed to decode JPEG: " << message;
+  std::longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->jump_buffer,
+               1);
+}
+
+// Suppress the warnings that libjpeg otherwise prints to stderr.
+void JpegOutputMessage(j_common_ptr /*cinfo*/) {}
+
+// Decode grey or RGB JPEG data at the smallest DCT scale (1/8, 1/4, 1/2, or 1)
+// whose dimensions are not smaller than the given minimum dimensions. Returns
+// false if the data is not a JPEG image with one or three components.
+bool DecodeScaledJpeg(const std::vector<char>& file_data,
+                      const int min_width,
+                      const int min_height,
+                      int* width,
+                      int* height,
+                      int* channels,
+                      std::vector<uint8_t>* data) {
+  if (file_data.size() < 3 || static_cast<uint8_t>(file_data[0]) != 0xFF ||
+      static_cast<uint8_t>(file_data[1]) != 0xD8 ||
+      static_cast<uint8_t>(file_data[2]) != 0xFF) {
+    return false;
+  }
+
+  jpeg_decompress_struct cinfo;
+  JpegErrorManager error_manager;
+  cinfo.err = jpeg_std_error(&error_manager.error_mgr);
+  error_manager.error_mgr.error_exit = &JpegErrorExit;
+  error_manager.error_mgr.output_message = &JpegOutputMessage;
+  if (setjmp(error_manager.jump_buffer)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  // Older libjpeg versions take a non-const input buffer.
+  jpeg_mem_src(&cinfo,
+               reinterpret_cast<unsigned char*>(
+                   const_cast<char*>(file_data.data())),
+               file_data.size());
+  jpeg_read_header(&cinfo, TRUE);
+
+  if (cinfo.num_components == 1) {
+    cinfo.out_color_space = JCS_GRAYSCALE;
+  } else if (cinfo.num_components == 3) {
+    cinfo.out_color_space = JCS_RGB;
+  } else {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+
+  cinfo.scale_num = 1;
+  for (const unsigned int scale_denom : {8, 4, 2, 1}) {
+    cinfo.scale_denom = scale_denom;
+    jpeg_calc_output_dimensions(&cinfo);
+    if (static_cast<int>(cinfo.output_width) >= min_width &&
+        static_cast<int>(cinfo.output_height) >= min_height) {
+      break;
+    }
+  }
+
+  jpeg_start_decompress(&cinfo);
+  *width = static_cast<int>(cinfo.output_width);
+  *height = static_cast<int>(cinfo.output_height);
+  *channels = cinfo.output_components;
+  const size_t pitch = static_cast<size_t>(*width) * *channels;
+  data->resize(pitch * *height);
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW row = data->data() + cinfo.output_scanline * pitch;
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+
+  return true;
+}
+
+#endif  // COLMAP_LIBJPEG_ENABLED
+
 }  // namespace
 
 Bitmap::Bitmap()
@@ -240,57 +555,31 @@ std::optional<BitmapColor<uint8_t>> Bitmap::InterpolateNearestNeighbor(
 
 std::optional<BitmapColor<float>> Bitmap::InterpolateBilinear(
     const double x, const double y) const {
-  const int x0 = static_cast<int>(std::floor(x));
-  const int x1 = x0 + 1;
-  const int y0 = static_cast<int>(std::floor(y));
-  const int y1 = y0 + 1;
-
-  if (x0 < 0 || x1 >= width_ || y0 < 0 || y1 >= height_) {
-    return std::nullopt;
+  if (IsGrey()) {
+    return InterpolateBilinearImpl<1>(data_.data(), width_, height_, x, y);
+  } else if (IsRGB()) {
+    return InterpolateBilinearImpl<3>(data_.data(), width_, height_, x, y);
   }
+  return std::nullopt;
+}
 
-  const double dx = x - x0;
-  const double dy = y - y0;
-  const double dx_1 = 1 - dx;
-  const double dy_1 = 1 - dy;
-
-  const int pitch = width_ * channels_;
-  const uint8_t* line0 = &data_[y0 * pitch];
-  const uint8_t* line1 = &data_[y1 * pitch];
-
+void Bitmap::InterpolateBilinearBatch(
+    span<const Eigen::Vector2d> points,
+    span<std::optional<BitmapColor<float>>> colors) const {
+  THROW_CHECK_EQ(points.size(), colors.size());
   if (IsGrey()) {
-    // Top row, column-wise linear interpolation.
-    const double v0 = dx_1 * line0[x0] + dx * line0[x1];
-
-    // Bottom row, column-wise linear interpolation.
-    const double v1 = dx_1 * line1[x0] + dx * line1[x1];
-
-    // Row-wise linear interpolation.
-    const float r = dy_1 * v0 + dy * v1;
-    return BitmapColor<float>(r, r, r);
+    for (size_t i = 0; i < points.size(); ++i) {
+      colors[i] = InterpolateBilinearImpl<1>(
+          data_.data(), width_, height_, points[i].x(), points[i].y());
+    }
   } else if (IsRGB()) {
-    const uint8_t* p00 = &line0[3 * x0];
-    const uint8_t* p01 = &line0[3 * x1];
-    const uint8_t* p10 = &line1[3 * x0];
-    const uint8_t* p11 = &line1[3 * x1];
-
-    // Top row, column-wise linear interpolation.
-    const double v0_r = dx_1 * p00[0] + dx * p01[0];
-    const double v0_g = dx_1 * p00[1] + dx * p01[1];
-    const double v0_b = dx_1 * p00[2] + dx * p01[2];
-
-    // Bottom row, column-wise linear interpolation.
-    const double v1_r = dx_1 * p10[0] + dx * p11[0];
-    const double v1_g = dx_1 * p10[1] + dx * p11[1];
-    const double v1_b = dx_1 * p10[2] + dx * p11[2];
-
-    // Row-wise linear interpolation.
-    return BitmapColor<float>(dy_1 * v0_r + dy * v1_r,
-                              dy_1 * v0_g + dy * v1_g,
-                              dy_1 * v0_b + dy * v1_b);
+    for (size_t i = 0; i < points.size(); ++i) {
+      colors[i] = InterpolateBilinearImpl<3>(
+          data_.data(), width_, height_, points[i].x(), points[i].y());
+    }
+  } else {
+    std::fill(colors.begin(), colors.end(), std::nullopt);
   }
-
-  return std::nullopt;
 }
 
 std::optional<int> Bitmap::ExifOrientation() const {
@@ -520,6 +809,148 @@ bool Bitmap::Read(const std::filesystem::path& path,
   return true;
 }
 
+bool Bitmap::ReadMetaData(const std::filesystem::path& path,
+                          const bool as_rgb) {
+  if (!ExistsFile(path)) {
+    VLOG(3) << "Failed to read bitmap, because file does not exist";
+    return false;
+  }
+
+  OIIO::ImageSpec config;
+  config["oiio:reorient"] = 0;
+
+  const auto input = OIIO::ImageInput::open(PathToUtf8(path), &config);
+  if (!input) {
+    // Always retrieve the error to clear OIIO's pending error state.
+    const std::string error = OIIO::geterror();
+    VLOG(3) << "Failed to read bitmap: " << error;
+    return false;
+  }
+
+  const OIIO::ImageSpec& image_spec = input->spec();
+  if (image_spec.nchannels < 1 || image_spec.nchannels > 4) {
+    VLOG(3) << "Unsupported number of channels: " << image_spec.nchannels;
+    return false;
+  }
+
+  width_ = image_spec.width;
+  height_ = image_spec.height;
+  channels_ = as_rgb ? 3 : 1;
+  data_.clear();
+  data_.shrink_to_fit();
+
+  auto meta_data = std::make_unique<OIIOMetaData>();
+  meta_data->image_spec = image_spec;
+  meta_data->image_spec.nchannels = channels_;
+  meta_data_ = std::move(meta_data);
+
+  input->close();
+
+  return true;
+}
+
+bool Bitmap::ReadThumbnail(const std::filesystem::path& path,
+                           const int max_image_size,
+                           const bool as_rgb,
+                           const bool linearize_colorspace) {
+  THROW_CHECK_GT(max_image_size, 0);
+  if (!ReadMetaData(path, as_rgb)) {
+    return false;
+  }
+
+  int new_width = width_;
+  int new_height = height_;
+  if (width_ > max_image_size || height_ > max_image_size) {
+    // Same dimensions as in Thumbnail.
+    const double scale =
+        static_cast<double>(max_image_size) / std::max(width_, height_);
+    new_width = static_cast<int>(std::round(width_ * scale));
+    new_height = static_cast<int>(std::round(height_ * scale));
+  }
+
+  return ReadRescaledPixels(
+      path, new_width, new_height, as_rgb, linearize_colorspace);
+}
+
+bool Bitmap::ReadRescaled(const std::filesystem::path& path,
+                          const int new_width,
+                          const int new_height,
+                          const bool as_rgb,
+                          const bool linearize_colorspace) {
+  THROW_CHECK_GT(new_width, 0);
+  THROW_CHECK_GT(new_height, 0);
+  if (!ReadMetaData(path, as_rgb)) {
+    return false;
+  }
+  return ReadRescaledPixels(
+      path, new_width, new_height, as_rgb, linearize_colorspace);
+}
+
+bool Bitmap::ReadRescaledPixels(const std::filesystem::path& path,
+                                const int new_width,
+                                const int new_height,
+                                const bool as_rgb,
+                                const bool linearize_colorspace) {
+#if defined(COLMAP_LIBJPEG_ENABLED)
+  // Only bypass OpenImageIO if the DCT scaling saves decoding work.
+  if ((HasFileExtension(path, ".jpg") || HasFileExtension(path, ".jpeg")) &&
+      2 * new_width <= width_ && 2 * new_height <= height_) {
+    std::vector<char> file_data;
+    ReadBinaryBlob(path, &file_data);
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<uint8_t> data;
+    if (DecodeScaledJpeg(file_data,
+                         new_width,
+                         new_height,
+                         &width,
+                         &height,
+                         &channels,
+                         &data)) {
+      width_ = width;
+      height_ = height;
+      channels_ = channels;
+      data_ = std::move(data);
+
+      auto* meta_data = OIIOMetaData::Upcast(meta_data_.get());
+      meta_data->image_spec.width = width_;
+      meta_data->image_spec.height = height_;
+      meta_data->image_spec.nchannels = channels_;
+
+      if (linearize_colorspace) {
+        const std::string colorspace =
+            meta_data->image_spec["oiio:ColorSpace"];
+        if (IsEquivalentColorSpace(colorspace, "linear")) {
+          data_ = ConvertColorSpace(
+              data_.data(), width_, height_, channels_, colorspace, "linear");
+        }
+      }
+
+      if (as_rgb && channels_ != 3) {
+        *this = CloneAsRGB();
+      } else if (!as_rgb && channels_ != 1) {
+        *this = CloneAsGrey();
+      }
+
+      if (width_ != new_width || height_ != new_height) {
+        Rescale(new_width, new_height);
+      }
+
+      return true;
+    }
+  }
+#endif  // COLMAP_LIBJPEG_ENABLED
+
+  if (!Read(path, as_rgb, linearize_colorspace)) {
+    return false;
+  }
+  if (width_ != new_width || height_ != new_height) {
+    Rescale(new_width, new_height);
+  }
+  return true;
+}
+
 bool Bitmap::Write(const std::filesystem::path& path,
                    const bool delinearize_colorspace) const {
   const std::string utf8_path = PathToUtf8(path);
@@ -580,14 +1011,31 @@ bool Bitmap::Write(const std::filesystem::path& path,
 void Bitmap::Rescale(const int new_width,
                      const int new_height,
                      RescaleFilter filter) {
-  const OIIO::ImageBuf buf(
-      OIIO::ImageSpec(width_, height_, channels_, OIIO::TypeDesc::UINT8),
-      data_.data());
-  std::vector<uint8_t> new_data(new_width * new_height * channels_);
-  OIIO::ImageBuf new_buf(
-      OIIO::ImageSpec(new_width, new_height, channels_, OIIO::TypeDesc::UINT8),
-      new_data.data());
-  THROW_CHECK(OIIO::ImageBufAlgo::resize(new_buf, buf));
+  THROW_CHECK_GT(width_, 0);
+  THROW_CHECK_GT(height_, 0);
+  THROW_CHECK_GT(new_width, 0);
+  THROW_CHECK_GT(new_height, 0);
+  std::vector<uint8_t> new_data(static_cast<size_t>(new_width) * new_height *
+                                channels_);
+  if (IsGrey()) {
+    ResampleImage<1>(data_.data(),
+                     width_,
+                     height_,
+                     new_width,
+                     new_height,
+                     filter,
+                     new_data.data());
+  } else if (IsRGB()) {
+    ResampleImage<3>(data_.data(),
+                     width_,
+                     height_,
+                     new_width,
+                     new_height,
+                     filter,
+                     new_data.data());
+  } else {
+    LOG(FATAL_THROW) << "Unsupported number of channels: " << channels_;
+  }
 
   width_ = new_width;
   height_ = new_height;
@@ -665,11 +1113,20 @@ Bitmap Bitmap::CloneAsGrey() const {
     cloned.channels_ = 1;
     cloned.linear_colorspace_ = linear_colorspace_;
     cloned.data_.resize(width_ * height_);
-    for (size_t i = 0; i < cloned.data_.size(); ++i) {
-      cloned.data_[i] =
-          std::round(.2126f * data_[3 * i + 0] + .7152f * data_[3 * i + 1] +
-                     .0722f * data_[3 * i + 2]);
-    }
+    ParallelFor(
+        0,
+        height_,
+        [&](const int64_t y_begin, const int64_t y_end) {
+          const size_t begin = y_begin * width_;
+          const size_t end = y_end * width_;
+          for (size_t i = begin; i < end; ++i) {
+            cloned.data_[i] = std::round(.2126f * data_[3 * i + 0] +
+                                         .7152f * data_[3 * i + 1] +
+                                         .0722f * data_[3 * i + 2]);
+          }
+        },
+        ThreadPool::kMaxNumThreads,
+        kNumRowsPerChunk);
     cloned.meta_data_ = OIIOMetaData::Clone(meta_data_);
     auto* cloned_meta_data = OIIOMetaData::Upcast(cloned.meta_data_.get());
     cloned_meta_data->image_spec.nchannels = 1;
@@ -688,11 +1145,20 @@ Bitmap Bitmap::CloneAsRGB() const {
     cloned.channels_ = 3;
     cloned.linear_colorspace_ = linear_colorspace_;
     cloned.data_.resize(width_ * height_ * 3);
-    for (size_t i = 0; i < data_.size(); ++i) {
-      cloned.data_[3 * i + 0] = data_[i];
-      cloned.data_[3 * i + 1] = data_[i];
-      cloned.data_[3 * i + 2] = data_[i];
-    }
+    ParallelFor(
+        0,
+        height_,
+        [&](const int64_t y_begin, const int64_t y_end) {
+          const size_t begin = y_begin * width_;
+          const size_t end = y_end * width_;
+          for (size_t i = begin; i < end; ++i) {
+            cloned.data_[3 * i + 0] = data_[i];
+            cloned.data_[3 * i + 1] = data_[i];
+            cloned.data_[3 * i + 2] = data_[i];
+          }
+        },
+        ThreadPool::kMaxNumThreads,
+        kNumRowsPerChunk);
     cloned.meta_data_ = OIIOMetaData::Clone(meta_data_);
     auto* cloned_meta_data = OIIOMetaData::Upcast(cloned.meta_data_.get());
     cloned_meta_data->image_spec.nchannels = 3;
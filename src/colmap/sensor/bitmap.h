@@ -29,6 +29,8 @@
 
 #pragma once
 
+#include "colmap/util/types.h"
+
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
@@ -118,6 +120,13 @@ class Bitmap {
   std::optional<BitmapColor<float>> InterpolateBilinear(double x,
                                                         double y) const;
 
+  // Batched version of InterpolateBilinear, which dispatches on the number of
+  // channels once for all points and yields identical results. Points outside
+  // the image are set to std::nullopt.
+  void InterpolateBilinearBatch(
+      span<const Eigen::Vector2d> points,
+      span<std::optional<BitmapColor<float>>> colors) const;
+
   // Extract EXIF information from bitmap. Returns std::nullopt if no EXIF
   // information is embedded in the bitmap.
   std::optional<int> ExifOrientation() const;
@@ -134,15 +143,40 @@ class Bitmap {
             bool as_rgb = true,
             bool linearize_colorspace = false);
 
+  // Read only the dimensions and metadata (e.g., EXIF) of the bitmap at given
+  // path without decoding the pixel data, which is left empty. The number of
+  // channels is set as if the bitmap was read in grey- or colorscale.
+  bool ReadMetaData(const std::filesystem::path& path, bool as_rgb = true);
+
+  // Read bitmap at given path and either downscale it so that neither
+  // dimension exceeds `max_image_size` (with the same dimensions as Read
+  // followed by Thumbnail) or rescale it to the given dimensions. If COLMAP
+  // was built with libjpeg, JPEG images are decoded directly at 1/2, 1/4, or
+  // 1/8 of their original resolution when the target dimensions permit, which
+  // skips most of the decoding work.
+  bool ReadThumbnail(const std::filesystem::path& path,
+                     int max_image_size,
+                     bool as_rgb = true,
+                     bool linearize_colorspace = false);
+  bool ReadRescaled(const std::filesystem::path& path,
+                    int new_width,
+                    int new_height,
+                    bool as_rgb = true,
+                    bool linearize_colorspace = false);
+
   // Write bitmap to file at given path. Defaults to converting to sRGB
   // colorspace for file storage.
   bool Write(const std::filesystem::path& path,
              bool delinearize_colorspace = true) const;
 
-  // Rescale image to the new dimensions.
+  // Rescale image to the new dimensions. The image is resampled separably
+  // in parallel over the rows, where the filter footprint is widened when
+  // downsampling to avoid aliasing. The result does not depend on the number
+  // of threads. The box filter averages over the area of the target pixels.
   enum class RescaleFilter {
     kBilinear,
     kBox,
+    kLanczos,
   };
   void Rescale(int new_width,
                int new_height,
@@ -186,6 +220,14 @@ class Bitmap {
   };
 
  private:
+  // Decode the pixels of the bitmap, whose metadata was previously read with
+  // ReadMetaData, and rescale them to the given dimensions.
+  bool ReadRescaledPixels(const std::filesystem::path& path,
+                          int new_width,
+                          int new_height,
+                          bool as_rgb,
+                          bool linearize_colorspace);
+
   int width_;
   int height_;
   int channels_;
@@ -401,6 +401,68 @@ TEST(Bitmap, RescaleGrey) {
   EXPECT_EQ(bitmap2.Channels(), 1);
 }
 
+TEST(Bitmap, RescaleBox) {
+  Bitmap bitmap(4, 4, /*as_rgb=*/false);
+  for (int y = 0; y < 4; ++y) {
+    for (int x = 0; x < 4; ++x) {
+      bitmap.SetPixel(x, y, BitmapColor<uint8_t>(40 * y + 10 * x));
+    }
+  }
+  bitmap.Rescale(2, 2, Bitmap::RescaleFilter::kBox);
+  EXPECT_EQ(bitmap.Width(), 2);
+  EXPECT_EQ(bitmap.Height(), 2);
+  EXPECT_EQ(bitmap.RowMajorData(), std::vector<uint8_t>({25, 45, 105, 125}));
+}
+
+TEST(Bitmap, RescaleBilinearUpsample) {
+  Bitmap bitmap(2, 1, /*as_rgb=*/false);
+  bitmap.SetPixel(0, 0, BitmapColor<uint8_t>(0));
+  bitmap.SetPixel(1, 0, BitmapColor<uint8_t>(100));
+  bitmap.Rescale(4, 1, Bitmap::RescaleFilter::kBilinear);
+  EXPECT_EQ(bitmap.RowMajorData(), std::vector<uint8_t>({0, 25, 75, 100}));
+}
+
+TEST(Bitmap, RescaleUniformColor) {
+  for (const auto filter : {Bitmap::RescaleFilter::kBilinear,
+                            Bitmap::RescaleFilter::kBox,
+                            Bitmap::RescaleFilter::kLanczos}) {
+    for (const bool as_rgb : {false, true}) {
+      Bitmap bitmap(100, 80, as_rgb);
+      bitmap.Fill(BitmapColor<uint8_t>(137, 137, 137));
+      Bitmap downsampled = bitmap.Clone();
+      downsampled.Rescale(33, 17, filter);
+      for (const uint8_t value : downsampled.RowMajorData()) {
+        EXPECT_EQ(value, 137);
+      }
+      Bitmap upsampled = bitmap.Clone();
+      upsampled.Rescale(257, 131, filter);
+      for (const uint8_t value : upsampled.RowMajorData()) {
+        EXPECT_EQ(value, 137);
+      }
+    }
+  }
+}
+
+TEST(Bitmap, InterpolateBilinearBatch) {
+  for (const bool as_rgb : {false, true}) {
+    Bitmap bitmap(11, 10, as_rgb);
+    for (int y = 0; y < 10; ++y) {
+      for (int x = 0; x < 11; ++x) {
+        bitmap.SetPixel(x, y, BitmapColor<uint8_t>(x * y, x + y, x));
+      }
+    }
+    const std::vector<Eigen::Vector2d> points = {
+        {5, 4}, {5.5, 4}, {5.25, 4.75}, {0, 0}, {10, 5}, {-0.5, 5}, {3, 9}};
+    std::vector<std::optional<BitmapColor<float>>> colors(points.size());
+    bitmap.InterpolateBilinearBatch({points.data(), points.size()},
+                                    {colors.data(), colors.size()});
+    for (size_t i = 0; i < points.size(); ++i) {
+      EXPECT_EQ(colors[i],
+                bitmap.InterpolateBilinear(points[i].x(), points[i].y()));
+    }
+  }
+}
+
 TEST(Bitmap, Thumbnail) {
   Bitmap bitmap(100, 80, /*as_rgb=*/true);
 
@@ -840,6 +902,87 @@ TEST(Bitmap, ReadWriteAsRGB) {
   EXPECT_EQ(read_bitmap.RowMajorData(), bitmap.CloneAsGrey().RowMajorData());
 }
 
+TEST(Bitmap, ReadMetaData) {
+  Bitmap bitmap(4, 3, /*as_rgb=*/true);
+  const auto filename = CreateTestDir() / "bitmap.png";
+  EXPECT_TRUE(bitmap.Write(filename));
+
+  Bitmap read_bitmap;
+  EXPECT_FALSE(read_bitmap.ReadMetaData(filename.string() + ".missing"));
+  EXPECT_TRUE(read_bitmap.ReadMetaData(filename));
+  EXPECT_EQ(read_bitmap.Width(), bitmap.Width());
+  EXPECT_EQ(read_bitmap.Height(), bitmap.Height());
+  EXPECT_EQ(read_bitmap.Channels(), 3);
+  EXPECT_TRUE(read_bitmap.IsEmpty());
+
+  EXPECT_TRUE(read_bitmap.ReadMetaData(filename, /*as_rgb=*/false));
+  EXPECT_EQ(read_bitmap.Channels(), 1);
+  EXPECT_TRUE(read_bitmap.IsEmpty());
+}
+
+TEST(Bitmap, ReadThumbnail) {
+  Bitmap bitmap(203, 101, /*as_rgb=*/true);
+  for (int y = 0; y < bitmap.Height(); ++y) {
+    for (int x = 0; x < bitmap.Width(); ++x) {
+      bitmap.SetPixel(x, y, BitmapColor<uint8_t>(x, y, (x + y) / 2));
+    }
+  }
+
+  const auto test_dir = CreateTestDir();
+  for (const std::string ext : {".png", ".jpg"}) {
+    const auto filename = test_dir / ("bitmap" + ext);
+    EXPECT_TRUE(bitmap.Write(filename));
+
+    Bitmap expected_bitmap;
+    EXPECT_TRUE(expected_bitmap.Read(filename));
+    expected_bitmap.Thumbnail(50);
+
+    Bitmap read_bitmap;
+    EXPECT_FALSE(read_bitmap.ReadThumbnail(filename.string() + ".missing", 50));
+    EXPECT_TRUE(read_bitmap.ReadThumbnail(filename, 50));
+    EXPECT_EQ(read_bitmap.Width(), expected_bitmap.Width());
+    EXPECT_EQ(read_bitmap.Height(), expected_bitmap.Height());
+    EXPECT_EQ(read_bitmap.Channels(), 3);
+    const std::vector<uint8_t> data = read_bitmap.RowMajorData();
+    const std::vector<uint8_t> expected_data = expected_bitmap.RowMajorData();
+    ASSERT_EQ(data.size(), expected_data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+      EXPECT_NEAR(data[i], expected_data[i], 8);
+    }
+
+    EXPECT_TRUE(read_bitmap.ReadThumbnail(filename, 50, /*as_rgb=*/false));
+    EXPECT_EQ(read_bitmap.Width(), expected_bitmap.Width());
+    EXPECT_EQ(read_bitmap.Height(), expected_bitmap.Height());
+    EXPECT_EQ(read_bitmap.Channels(), 1);
+
+    // No upsampling of smaller images.
+    EXPECT_TRUE(read_bitmap.ReadThumbnail(filename, 1000));
+    EXPECT_EQ(read_bitmap.Width(), bitmap.Width());
+    EXPECT_EQ(read_bitmap.Height(), bitmap.Height());
+  }
+}
+
+TEST(Bitmap, ReadRescaled) {
+  Bitmap bitmap(80, 60, /*as_rgb=*/false);
+  bitmap.Fill(BitmapColor<uint8_t>(100));
+  const auto filename = CreateTestDir() / "bitmap.jpg";
+  EXPECT_TRUE(bitmap.Write(filename));
+
+  Bitmap read_bitmap;
+  EXPECT_TRUE(read_bitmap.ReadRescaled(filename, 15, 11, /*as_rgb=*/false));
+  EXPECT_EQ(read_bitmap.Width(), 15);
+  EXPECT_EQ(read_bitmap.Height(), 11);
+  EXPECT_EQ(read_bitmap.Channels(), 1);
+  for (const uint8_t value : read_bitmap.RowMajorData()) {
+    EXPECT_NEAR(value, 100, 1);
+  }
+
+  EXPECT_TRUE(read_bitmap.ReadRescaled(filename, 100, 75));
+  EXPECT_EQ(read_bitmap.Width(), 100);
+  EXPECT_EQ(read_bitmap.Height(), 75);
+  EXPECT_EQ(read_bitmap.Channels(), 3);
+}
+
 TEST(Bitmap, ReadWriteUnicodePath) {
   Bitmap bitmap(2, 3, /*as_rgb=*/true);
   bitmap.SetPixel(0, 0, BitmapColor<uint8_t>(10, 20, 30));
@@ -34,6 +34,9 @@
 namespace colmap {
 
 const camera_specs_t CameraDatabase::specs_ = InitializeCameraSpecs();
+std::mutex CameraDatabase::cache_mutex_;
+std::unordered_map<std::string, CameraDatabase::QueryResult>
+    CameraDatabase::cache_;
 
 bool CameraDatabase::QuerySensorWidth(const std::string& make,
                                       const std::string& model,
@@ -51,19 +54,43 @@ bool CameraDatabase::QuerySensorWidth(const std::string& make,
   // Make sure that make name is not duplicated.
   cleaned_model = StringReplace(cleaned_model, cleaned_make, "");
 
+  const std::string key = cleaned_make + '\n' + cleaned_model;
+
+  QueryResult result;
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    const auto it = cache_.find(key);
+    if (it != cache_.end()) {
+      result = it->second;
+    } else {
+      result = QuerySensorWidthUncached(cleaned_make, cleaned_model);
+      cache_.emplace(key, result);
+    }
+  }
+
+  if (result.sensor_width.has_value()) {
+    *sensor_width_mm = *result.sensor_width;
+  }
+  return result.is_unique;
+}
+
+CameraDatabase::QueryResult CameraDatabase::QuerySensorWidthUncached(
+    const std::string& cleaned_make, const std::string& cleaned_model) {
   // Check if cleaned_make exists in database: Test whether EXIF string is
   // substring of database entry and vice versa.
+  QueryResult result;
   size_t spec_matches = 0;
   for (const auto& [make_name, models] : specs_) {
     if (StringContains(cleaned_make, make_name) ||
         StringContains(make_name, cleaned_make)) {
-      for (const auto& [model_name, sensor_width] : models) {
+      for (const auto& [model_name, model_sensor_width] : models) {
         if (StringContains(cleaned_model, model_name) ||
             StringContains(model_name, cleaned_model)) {
-          *sensor_width_mm = sensor_width;
+          result.sensor_width = model_sensor_width;
           if (cleaned_model == model_name) {
             // Model exactly matches, return immediately.
-            return true;
+            result.is_unique = true;
+            return result;
           }
           spec_matches += 1;
           if (spec_matches > 1) {
@@ -75,7 +102,8 @@ bool CameraDatabase::QuerySensorWidth(const std::string& make,
   }
 
   // Only return unique results, if model does not exactly match.
-  return spec_matches == 1;
+  result.is_unique = spec_matches == 1;
+  return result;
 }
 
 }  // namespace colmap
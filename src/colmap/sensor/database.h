@@ -31,7 +31,10 @@
 
 #include "colmap/sensor/specs.h"
 
+#include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
 
 namespace colmap {
 
@@ -43,12 +46,29 @@ struct CameraDatabase {
 
   size_t NumEntries() const { return specs_.size(); }
 
+  // Query the sensor width of the camera, where make and model are matched by
+  // substring. The results are cached in a hash table by the cleaned make and
+  // model, since the same camera is typically queried for many images and the
+  // substring matching scans the entire database. Thread-safe.
   bool QuerySensorWidth(const std::string& make,
                         const std::string& model,
                         double* sensor_width_mm);
 
  private:
+  struct QueryResult {
+    bool is_unique = false;
+    // Sensor width of the last matching model, also set for ambiguous matches.
+    std::optional<float> sensor_width;
+  };
+
+  static QueryResult QuerySensorWidthUncached(const std::string& cleaned_make,
+                                              const std::string& cleaned_model);
+
   static const camera_specs_t specs_;
+
+  // Query results by make and model separated by a newline character.
+  static std::mutex cache_mutex_;
+  static std::unordered_map<std::string, QueryResult> cache_;
 };
 
 }  // namespace colmap
@@ -56,5 +56,29 @@ TEST(CameraDatabase, AmbiguousMatch) {
   EXPECT_EQ(sensor_width, 6.1600f);
 }
 
+TEST(CameraDatabase, CleanedMatch) {
+  CameraDatabase database;
+  double sensor_width = 0;
+  EXPECT_TRUE(database.QuerySensorWidth(
+      "Canon", "Canon Digital-IXUS 100 IS", &sensor_width));
+  EXPECT_EQ(sensor_width, 6.1600f);
+}
+
+TEST(CameraDatabase, RepeatedQuery) {
+  CameraDatabase database;
+  for (int i = 0; i < 3; ++i) {
+    double sensor_width = 0;
+    EXPECT_TRUE(
+        database.QuerySensorWidth("canon", "digitalixus100is", &sensor_width));
+    EXPECT_EQ(sensor_width, 6.1600f);
+    sensor_width = 0;
+    EXPECT_FALSE(
+        database.QuerySensorWidth("canon", "digitalixus", &sensor_width));
+    EXPECT_EQ(sensor_width, 6.1600f);
+    EXPECT_FALSE(
+        database.QuerySensorWidth("unknown", "unknown", &sensor_width));
+  }
+}
+
 }  // namespace
 }  // namespace colmap
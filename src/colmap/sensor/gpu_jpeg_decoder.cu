@@ -0,0 +1,255 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/sensor/gpu_jpeg_decoder.h"
+
+#include "colmap/util/cuda.h"
+#include "colmap/util/cudacc.h"
+#include "colmap/util/logging.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include <nvjpeg.h>
+
+namespace colmap {
+namespace {
+
+bool NvjpegCheck(const nvjpegStatus_t status, const char* call) {
+  if (status != NVJPEG_STATUS_SUCCESS) {
+    VLOG(3) << "nvJPEG call " << call << " failed with status " << status;
+    return false;
+  }
+  return true;
+}
+
+#define NVJPEG_SAFE_CALL(call) \
+  THROW_CHECK(NvjpegCheck(call, #call)) << "Failed to set up nvJPEG"
+
+// Downscale the interleaved source image by averaging all source pixels that
+// fall into the footprint of each target pixel.
+__global__ void AreaResizeKernel(const uint8_t* src,
+                                 const int src_width,
+                                 const int src_height,
+                                 uint8_t* dst,
+                                 const int dst_width,
+                                 const int dst_height,
+                                 const int channels) {
+  const int x = blockIdx.x * blockDim.x + threadIdx.x;
+  const int y = blockIdx.y * blockDim.y + threadIdx.y;
+  if (x >= dst_width || y >= dst_height) {
+    return;
+  }
+
+  const float scale_x = static_cast<float>(src_width) / dst_width;
+  const float scale_y = static_cast<float>(src_height) / dst_height;
+  const int src_x0 = static_cast<int>(floorf(x * scale_x));
+  const int src_y0 = static_cast<int>(floorf(y * scale_y));
+  const int src_x1 = max(
+      src_x0 + 1, min(src_width, static_cast<int>(ceilf((x + 1) * scale_x))));
+  const int src_y1 = max(
+      src_y0 + 1, min(src_height, static_cast<int>(ceilf((y + 1) * scale_y))));
+
+  float sum[3] = {0, 0, 0};
+  for (int src_y = src_y0; src_y < src_y1; ++src_y) {
+    const uint8_t* src_row =
+        src + static_cast<size_t>(src_y) * src_width * channels;
+    for (int src_x = src_x0; src_x < src_x1; ++src_x) {
+      for (int c = 0; c < channels; ++c) {
+        sum[c] += src_row[src_x * channels + c];
+      }
+    }
+  }
+
+  const float norm = 1.0f / ((src_x1 - src_x0) * (src_y1 - src_y0));
+  uint8_t* dst_pixel =
+      dst + (static_cast<size_t>(y) * dst_width + x) * channels;
+  for (int c = 0; c < channels; ++c) {
+    dst_pixel[c] = static_cast<uint8_t>(
+        fminf(255.0f, fmaxf(0.0f, roundf(sum[c] * norm))));
+  }
+}
+
+// Device buffer that only grows to avoid reallocations for every image.
+class DeviceBuffer {
+ public:
+  ~DeviceBuffer() { FreeCudaMemory(data_); }
+
+  uint8_t* Reserve(const size_t num_bytes) {
+    if (num_bytes > num_bytes_) {
+      FreeCudaMemory(data_);
+      data_ = nullptr;
+      data_ = static_cast<uint8_t*>(
+          AllocateCudaMemory(num_bytes, "jpeg_decoder"));
+      num_bytes_ = num_bytes;
+    }
+    return data_;
+  }
+
+ private:
+  uint8_t* data_ = nullptr;
+  size_t num_bytes_ = 0;
+};
+
+}  // namespace
+
+struct GpuJpegDecoderState {
+  nvjpegHandle_t handle = nullptr;
+  nvjpegJpegState_t jpeg_state = nullptr;
+  cudaStream_t stream = nullptr;
+  DeviceBuffer decoded;
+  DeviceBuffer resized;
+};
+
+GpuJpegDecoder::GpuJpegDecoder()
+    : state_(std::make_unique<GpuJpegDecoderState>()) {
+  NVJPEG_SAFE_CALL(nvjpegCreateSimple(&state_->handle));
+  NVJPEG_SAFE_CALL(nvjpegJpegStateCreate(state_->handle, &state_->jpeg_state));
+  CUDA_SAFE_CALL(
+      cudaStreamCreateWithFlags(&state_->stream, cudaStreamNonBlocking));
+}
+
+GpuJpegDecoder::~GpuJpegDecoder() {
+  if (state_->stream != nullptr) {
+    cudaStreamDestroy(state_->stream);
+  }
+  if (state_->jpeg_state != nullptr) {
+    nvjpegJpegStateDestroy(state_->jpeg_state);
+  }
+  if (state_->handle != nullptr) {
+    nvjpegDestroy(state_->handle);
+  }
+}
+
+bool GpuJpegDecoder::Decode(const std::vector<uint8_t>& data,
+                            const bool as_rgb,
+                            const int max_image_size,
+                            Bitmap* bitmap) {
+  THROW_CHECK_GT(max_image_size, 0);
+  THROW_CHECK_NOTNULL(bitmap);
+
+  int num_components = 0;
+  nvjpegChromaSubsampling_t subsampling;
+  int widths[NVJPEG_MAX_COMPONENT];
+  int heights[NVJPEG_MAX_COMPONENT];
+  if (!NvjpegCheck(nvjpegGetImageInfo(state_->handle,
+                                      data.data(),
+                                      data.size(),
+                                      &num_components,
+                                      &subsampling,
+                                      widths,
+                                      heights),
+                   "nvjpegGetImageInfo")) {
+    return false;
+  }
+
+  const int width = widths[0];
+  const int height = heights[0];
+  const int channels = as_rgb ? 3 : 1;
+  if (width <= 0 || height <= 0) {
+    return false;
+  }
+
+  // Decode into interleaved RGB or the luma channel, which matches the
+  // grayscale conversion of the CPU code path.
+  uint8_t* decoded = state_->decoded.Reserve(
+      static_cast<size_t>(width) * height * channels);
+  nvjpegImage_t decoded_image{};
+  decoded_image.channel[0] = decoded;
+  decoded_image.pitch[0] = static_cast<size_t>(width) * channels;
+  if (!NvjpegCheck(nvjpegDecode(state_->handle,
+                                state_->jpeg_state,
+                                data.data(),
+                                data.size(),
+                                as_rgb ? NVJPEG_OUTPUT_RGBI : NVJPEG_OUTPUT_Y,
+                                &decoded_image,
+                                state_->stream),
+                   "nvjpegDecode")) {
+    return false;
+  }
+
+  // Fit the down-sampled version exactly into the max dimensions using the
+  // same rounding as Bitmap::Thumbnail.
+  int new_width = width;
+  int new_height = height;
+  const uint8_t* output = decoded;
+  if (width > max_image_size || height > max_image_size) {
+    const double scale =
+        static_cast<double>(max_image_size) / std::max(width, height);
+    new_width = std::max(1, static_cast<int>(std::round(width * scale)));
+    new_height = std::max(1, static_cast<int>(std::round(height * scale)));
+    uint8_t* resized = state_->resized.Reserve(
+        static_cast<size_t>(new_width) * new_height * channels);
+    const dim3 block_size(16, 16);
+    const dim3 grid_size((new_width + block_size.x - 1) / block_size.x,
+                         (new_height + block_size.y - 1) / block_size.y);
+    AreaResizeKernel<<<grid_size, block_size, 0, state_->stream>>>(
+        decoded, width, height, resized, new_width, new_height, channels);
+    CUDA_CHECK();
+    output = resized;
+  }
+
+  Bitmap output_bitmap(new_width, new_height, as_rgb);
+  CUDA_SAFE_CALL(cudaMemcpyAsync(output_bitmap.RowMajorData().data(),
+                                 output,
+                                 output_bitmap.NumBytes(),
+                                 cudaMemcpyDeviceToHost,
+                                 state_->stream));
+  CUDA_SAFE_CALL(cudaStreamSynchronize(state_->stream));
+
+  // Keep the metadata (e.g., EXIF) of bitmaps read with Bitmap::ReadMetaData.
+  if (bitmap->Width() > 0 && bitmap->Height() > 0) {
+    bitmap->CloneMetadata(&output_bitmap);
+  }
+  *bitmap = std::move(output_bitmap);
+
+  return true;
+}
+
+bool GpuJpegDecoder::Decode(const std::filesystem::path& path,
+                            const bool as_rgb,
+                            const int max_image_size,
+                            Bitmap* bitmap) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    VLOG(3) << "Failed to open JPEG file " << path;
+    return false;
+  }
+  std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+  file.seekg(0, std::ios::beg);
+  if (!file.read(reinterpret_cast<char*>(data.data()), data.size())) {
+    VLOG(3) << "Failed to read JPEG file " << path;
+    return false;
+  }
+  return Decode(data, as_rgb, max_image_size, bitmap);
+}
+
+}  // namespace colmap
@@ -0,0 +1,73 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "colmap/sensor/bitmap.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace colmap {
+
+struct GpuJpegDecoderState;
+
+// Decodes JPEG images with nvJPEG on the GPU and downscales them on the
+// device. Only the downscaled image is copied back to host memory, which
+// avoids decoding and resizing large images on the CPU. The decoder uses the
+// current CUDA device and is not thread-safe.
+class GpuJpegDecoder {
+ public:
+  GpuJpegDecoder();
+  ~GpuJpegDecoder();
+
+  // Decode the encoded JPEG data and downscale the image with area averaging,
+  // so that neither dimension exceeds max_image_size. The pixel data of the
+  // bitmap is replaced while its metadata is kept. Returns false, if the data
+  // cannot be decoded by nvJPEG, in which case the bitmap is left unchanged and
+  // the image should be decoded on the CPU instead.
+  bool Decode(const std::vector<uint8_t>& data,
+              bool as_rgb,
+              int max_image_size,
+              Bitmap* bitmap);
+
+  // Read the JPEG file at the given path and decode it, see above.
+  bool Decode(const std::filesystem::path& path,
+              bool as_rgb,
+              int max_image_size,
+              Bitmap* bitmap);
+
+ private:
+  std::unique_ptr<GpuJpegDecoderState> state_;
+};
+
+}  // namespace colmap
@@ -433,7 +433,7 @@ struct BasePerspectiveFisheyeCameraModel
 struct SimplePinholeCameraModel
     : public BasePerspectiveCameraModel<SimplePinholeCameraModel> {
   PERSPECTIVE_CAMERA_MODEL_DEFINITIONS(
-      CameraModelId::kSimplePinhole, "SIMPLE_PINHOLE", 1, 2, 0, false)
+      CameraModelId::kSimplePinhole, "SIMPLE_PINHOLE", 1, 2, 0, true)
 };
 
 // Pinhole camera model.
@@ -448,7 +448,7 @@ struct SimplePinholeCameraModel
 struct PinholeCameraModel
     : public BasePerspectiveCameraModel<PinholeCameraModel> {
   PERSPECTIVE_CAMERA_MODEL_DEFINITIONS(
-      CameraModelId::kPinhole, "PINHOLE", 2, 2, 0, false)
+      CameraModelId::kPinhole, "PINHOLE", 2, 2, 0, true)
 };
 
 // Simple camera model with one focal length and one radial distortion
@@ -499,7 +499,7 @@ struct RadialCameraModel
 struct OpenCVCameraModel
     : public BasePerspectiveCameraModel<OpenCVCameraModel> {
   PERSPECTIVE_CAMERA_MODEL_DEFINITIONS(
-      CameraModelId::kOpenCV, "OPENCV", 2, 2, 4, false)
+      CameraModelId::kOpenCV, "OPENCV", 2, 2, 4, true)
 };
 
 // OpenCV fish-eye camera model.
@@ -930,6 +930,27 @@ inline std::optional<Eigen::Vector3d> CameraModelCamRayFromImg(
     const std::vector<double>& params,
     const Eigen::Vector2d& xy);
 
+// Batched versions of `CameraModelImgFromCam`, `CameraModelCamFromImg`, and
+// `CameraModelCamRayFromImg`. The camera model is dispatched once for all
+// points instead of once per point, such that the per-point loop is fully
+// specialized for the model. Points that fail to (un)project are set to
+// std::nullopt. The input and output spans must have the same size.
+inline void CameraModelImgFromCamBatch(
+    CameraModelId model_id,
+    const std::vector<double>& params,
+    span<const Eigen::Vector3d> uvw,
+    span<std::optional<Eigen::Vector2d>> xy);
+inline void CameraModelCamFromImgBatch(
+    CameraModelId model_id,
+    const std::vector<double>& params,
+    span<const Eigen::Vector2d> xy,
+    span<std::optional<Eigen::Vector2d>> uv);
+inline void CameraModelCamRayFromImgBatch(
+    CameraModelId model_id,
+    const std::vector<double>& params,
+    span<const Eigen::Vector2d> xy,
+    span<std::optional<Eigen::Vector3d>> rays);
+
 // Convert pixel threshold in image plane to camera space by dividing
 // the threshold through the mean focal length.
 //
@@ -1146,6 +1167,54 @@ bool SimplePinholeCameraModel::ImgFromCam(
   return true;
 }
 
+template <bool Enable, typename std::enable_if<Enable, int>::type>
+bool SimplePinholeCameraModel::ImgFromCamWithJac(const double* params,
+                                                 const double& u,
+                                                 const double& v,
+                                                 const double& w,
+                                                 double* x,
+                                                 double* y,
+                                                 double* J_params,
+                                                 double* J_uvw) {
+  if (w < std::numeric_limits<double>::epsilon()) {
+    return false;
+  }
+
+  const double f = params[0];
+  const double c1 = params[1];
+  const double c2 = params[2];
+
+  const double inv_w = 1.0 / w;
+  const double uu = u * inv_w;
+  const double vv = v * inv_w;
+
+  *x = f * uu + c1;
+  *y = f * vv + c2;
+
+  if (J_uvw) {
+    // J_uvw is a 2x3 matrix (row-major): d(x, y) / d(u, v, w)
+    const double f_inv_w = f * inv_w;
+    J_uvw[0] = f_inv_w;
+    J_uvw[1] = 0.0;
+    J_uvw[2] = -f_inv_w * uu;
+    J_uvw[3] = 0.0;
+    J_uvw[4] = f_inv_w;
+    J_uvw[5] = -f_inv_w * vv;
+  }
+
+  if (J_params) {
+    // J_params is a 2x3 matrix (row-major): d(x, y) / d(f, cx, cy)
+    J_params[0] = uu;
+    J_params[1] = 1.0;
+    J_params[2] = 0.0;
+    J_params[3] = vv;
+    J_params[4] = 0.0;
+    J_params[5] = 1.0;
+  }
+
+  return true;
+}
+
 bool SimplePinholeCameraModel::CamFromImg(
     const double* params, double x, double y, double* u, double* v) {
   const double f = params[0];
@@ -1203,6 +1272,58 @@ bool PinholeCameraModel::ImgFromCam(
   return true;
 }
 
+template <bool Enable, typename std::enable_if<Enable, int>::type>
+bool PinholeCameraModel::ImgFromCamWithJac(const double* params,
+                                           const double& u,
+                                           const double& v,
+                                           const double& w,
+                                           double* x,
+                                           double* y,
+                                           double* J_params,
+                                           double* J_uvw) {
+  if (w < std::numeric_limits<double>::epsilon()) {
+    return false;
+  }
+
+  const double f1 = params[0];
+  const double f2 = params[1];
+  const double c1 = params[2];
+  const double c2 = params[3];
+
+  const double inv_w = 1.0 / w;
+  const double uu = u * inv_w;
+  const double vv = v * inv_w;
+
+  *x = f1 * uu + c1;
+  *y = f2 * vv + c2;
+
+  if (J_uvw) {
+    // J_uvw is a 2x3 matrix (row-major): d(x, y) / d(u, v, w)
+    const double f1_inv_w = f1 * inv_w;
+    const double f2_inv_w = f2 * inv_w;
+    J_uvw[0] = f1_inv_w;
+    J_uvw[1] = 0.0;
+    J_uvw[2] = -f1_inv_w * uu;
+    J_uvw[3] = 0.0;
+    J_uvw[4] = f2_inv_w;
+    J_uvw[5] = -f2_inv_w * vv;
+  }
+
+  if (J_params) {
+    // J_params is a 2x4 matrix (row-major): d(x, y) / d(fx, fy, cx, cy)
+    J_params[0] = uu;
+    J_params[1] = 0.0;
+    J_params[2] = 1.0;
+    J_params[3] = 0.0;
+    J_params[4] = 0.0;
+    J_params[5] = vv;
+    J_params[6] = 0.0;
+    J_params[7] = 1.0;
+  }
+
+  return true;
+}
+
 bool PinholeCameraModel::CamFromImg(
     const double* params, double x, double y, double* u, double* v) {
   const double f1 = params[0];
@@ -1504,6 +1625,99 @@ bool OpenCVCameraModel::ImgFromCam(
   return true;
 }
 
+template <bool Enable, typename std::enable_if<Enable, int>::type>
+bool OpenCVCameraModel::ImgFromCamWithJac(const double* params,
+                                          const double& u,
+                                          const double& v,
+                                          const double& w,
+                                          double* x,
+                                          double* y,
+                                          double* J_params,
+                                          double* J_uvw) {
+  if (w < std::numeric_limits<double>::epsilon()) {
+    return false;
+  }
+
+  const double f1 = params[0];
+  const double f2 = params[1];
+  const double c1 = params[2];
+  const double c2 = params[3];
+  const double k1 = params[4];
+  const double k2 = params[5];
+  const double p1 = params[6];
+  const double p2 = params[7];
+
+  const double inv_w = 1.0 / w;
+  const double uu = u * inv_w;
+  const double vv = v * inv_w;
+
+  const double uu2 = uu * uu;
+  const double uu_vv = uu * vv;
+  const double vv2 = vv * vv;
+  const double r2 = uu2 + vv2;
+  const double r4 = r2 * r2;
+  const double alpha = 1.0 + k1 * r2 + k2 * r4;
+  const double xd = alpha * uu + 2.0 * p1 * uu_vv + p2 * (r2 + 2.0 * uu2);
+  const double yd = alpha * vv + 2.0 * p2 * uu_vv + p1 * (r2 + 2.0 * vv2);
+
+  *x = f1 * xd + c1;
+  *y = f2 * yd + c2;
+
+  if (J_uvw) {
+    // J_uvw is a 2x3 matrix (row-major): d(x, y) / d(u, v, w)
+    //
+    // With the derivatives of the distorted point w.r.t. the normalized point
+    // (uu, vv), where d_alpha = 2 * (k1 + 2 * k2 * r2):
+    // dxd/duu = alpha + d_alpha * uu^2 + 2 * p1 * vv + 6 * p2 * uu
+    // dxd/dvv = d_alpha * uu * vv + 2 * p1 * uu + 2 * p2 * vv
+    // dyd/duu = d_alpha * uu * vv + 2 * p2 * vv + 2 * p1 * uu
+    // dyd/dvv = alpha + d_alpha * vv^2 + 2 * p2 * uu + 6 * p1 * vv
+    //
+    // and duu/du = 1/w, duu/dw = -uu/w, dvv/dv = 1/w, dvv/dw = -vv/w.
+
+    const double d_alpha = 2.0 * (k1 + 2.0 * k2 * r2);
+    const double d_alpha_uu_vv = d_alpha * uu_vv;
+    const double dxd_duu =
+        alpha + d_alpha * uu2 + 2.0 * p1 * vv + 6.0 * p2 * uu;
+    const double dxd_dvv = d_alpha_uu_vv + 2.0 * p1 * uu + 2.0 * p2 * vv;
+    const double dyd_duu = d_alpha_uu_vv + 2.0 * p2 * vv + 2.0 * p1 * uu;
+    const double dyd_dvv =
+        alpha + d_alpha * vv2 + 2.0 * p2 * uu + 6.0 * p1 * vv;
+
+    const double f1_inv_w = f1 * inv_w;
+    const double f2_inv_w = f2 * inv_w;
+    J_uvw[0] = f1_inv_w * dxd_duu;
+    J_uvw[1] = f1_inv_w * dxd_dvv;
+    J_uvw[2] = -f1_inv_w * (dxd_duu * uu + dxd_dvv * vv);
+    J_uvw[3] = f2_inv_w * dyd_duu;
+    J_uvw[4] = f2_inv_w * dyd_dvv;
+    J_uvw[5] = -f2_inv_w * (dyd_duu * uu + dyd_dvv * vv);
+  }
+
+  if (J_params) {
+    // J_params is a 2x8 matrix (row-major):
+    // d(x, y) / d(fx, fy, cx, cy, k1, k2, p1, p2)
+    J_params[0] = xd;
+    J_params[1] = 0.0;
+    J_params[2] = 1.0;
+    J_params[3] = 0.0;
+    J_params[4] = f1 * uu * r2;
+    J_params[5] = f1 * uu * r4;
+    J_params[6] = f1 * 2.0 * uu_vv;
+    J_params[7] = f1 * (r2 + 2.0 * uu2);
+    J_params[8] = 0.0;
+    J_params[9] = yd;
+    J_params[10] = 0.0;
+    J_params[11] = 1.0;
+    J_params[12] = f2 * vv * r2;
+    J_params[13] = f2 * vv * r4;
+    J_params[14] = f2 * (r2 + 2.0 * vv2);
+    J_params[15] = f2 * 2.0 * uu_vv;
+  }
+
+  return true;
+}
+
 bool OpenCVCameraModel::CamFromImg(
     const double* params, double x, double y, double* u, double* v) {
   const double f1 = params[0];
@@ -2871,6 +3085,86 @@ std::optional<Eigen::Vector3d> CameraModelCamRayFromImg(
   return std::nullopt;
 }
 
+void CameraModelImgFromCamBatch(const CameraModelId model_id,
+                                const std::vector<double>& params,
+                                span<const Eigen::Vector3d> uvw,
+                                span<std::optional<Eigen::Vector2d>> xy) {
+  switch (model_id) {
+#define CAMERA_MODEL_CASE(CameraModel)                                       \
+  case CameraModel::model_id:                                                \
+    for (size_t i = 0; i < uvw.size(); ++i) {                                \
+      Eigen::Vector2d point;                                                 \
+      if (CameraModel::ImgFromCam(params.data(),                             \
+                                  uvw[i].x(),                                \
+                                  uvw[i].y(),                                \
+                                  uvw[i].z(),                                \
+                                  &point.x(),                                \
+                                  &point.y())) {                             \
+        xy[i] = point;                                                       \
+      } else {                                                               \
+        xy[i] = std::nullopt;                                                \
+      }                                                                      \
+    }                                                                        \
+    break;
+
+    CAMERA_MODEL_SWITCH_CASES
+
+#undef CAMERA_MODEL_CASE
+  }
+}
+
+void CameraModelCamFromImgBatch(const CameraModelId model_id,
+                                const std::vector<double>& params,
+                                span<const Eigen::Vector2d> xy,
+                                span<std::optional<Eigen::Vector2d>> uv) {
+  switch (model_id) {
+#define CAMERA_MODEL_CASE(CameraModel)                                       \
+  case CameraModel::model_id:                                                \
+    for (size_t i = 0; i < xy.size(); ++i) {                                 \
+      Eigen::Vector2d point;                                                 \
+      if (CameraModel::CamFromImg(                                           \
+              params.data(), xy[i].x(), xy[i].y(), &point.x(), &point.y())) { \
+        uv[i] = point;                                                       \
+      } else {                                                               \
+        uv[i] = std::nullopt;                                                \
+      }                                                                      \
+    }                                                                        \
+    break;
+
+    CAMERA_MODEL_SWITCH_CASES
+
+#undef CAMERA_MODEL_CASE
+  }
+}
+
+void CameraModelCamRayFromImgBatch(const CameraModelId model_id,
+                                   const std::vector<double>& params,
+                                   span<const Eigen::Vector2d> xy,
+                                   span<std::optional<Eigen::Vector3d>> rays) {
+  switch (model_id) {
+#define CAMERA_MODEL_CASE(CameraModel)                                       \
+  case CameraModel::model_id:                                                \
+    for (size_t i = 0; i < xy.size(); ++i) {                                 \
+      Eigen::Vector3d ray;                                                   \
+      if (CameraModel::CamRayFromImg(params.data(),                          \
+                                     xy[i].x(),                              \
+                                     xy[i].y(),                              \
+                                     &ray.x(),                               \
+                                     &ray.y(),                               \
+                                     &ray.z())) {                            \
+        rays[i] = ray;                                                       \
+      } else {                                                               \
+        rays[i] = std::nullopt;                                              \
+      }                                                                      \
+    }                                                                        \
+    break;
+
+    CAMERA_MODEL_SWITCH_CASES
+
+#undef CAMERA_MODEL_CASE
+  }
+}
+
 double CameraModelCamFromImgThreshold(const CameraModelId model_id,
                                       const std::vector<double>& params,
                                       const double threshold) {
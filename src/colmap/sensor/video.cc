@@ -0,0 +1,247 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/sensor/video.h"
+
+#include "colmap/util/logging.h"
+#include "colmap/util/oiio_utils.h"
+#include "colmap/util/string.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <OpenImageIO/imageio.h>
+
+namespace colmap {
+namespace {
+
+// See bitmap.cc for why the path is not converted with path.string().
+std::string PathToUtf8(const std::filesystem::path& path) {
+  const auto u8 = path.u8string();
+  return std::string(reinterpret_cast<const char*>(u8.data()), u8.size());
+}
+
+}  // namespace
+
+bool IsVideoFile(const std::filesystem::path& path) {
+  std::string extension = path.extension().string();
+  StringToLower(&extension);
+  return extension == ".mp4" || extension == ".mov" || extension == ".avi" ||
+         extension == ".mkv" || extension == ".m4v" || extension == ".webm";
+}
+
+struct VideoReader::Impl {
+  std::unique_ptr<OIIO::ImageInput> input;
+  int num_frames = 0;
+  double frames_per_second = 0;
+};
+
+VideoReader::VideoReader() : impl_(std::make_unique<Impl>()) {}
+
+VideoReader::~VideoReader() { Close(); }
+
+bool VideoReader::Open(const std::filesystem::path& path) {
+  Close();
+  EnsureOpenImageIOInitialized();
+
+  impl_->input = OIIO::ImageInput::open(PathToUtf8(path));
+  if (!impl_->input) {
+    // Always retrieve the error to clear OIIO's pending error state.
+    const std::string error = OIIO::geterror();
+    VLOG(3) << "Failed to open video: " << error;
+    return false;
+  }
+
+  const OIIO::ImageSpec& spec = impl_->input->spec();
+  if (spec.get_int_attribute("oiio:Movie", 0) == 0) {
+    VLOG(3) << "Failed to open video, because file is not a movie";
+    Close();
+    return false;
+  }
+
+  impl_->num_frames = spec.get_int_attribute("oiio:subimages", 0);
+  if (impl_->num_frames <= 0) {
+    // Seeking only updates the spec without decoding the frame.
+    while (impl_->input->seek_subimage(impl_->num_frames, 0)) {
+      ++impl_->num_frames;
+    }
+  }
+
+  int frames_per_second[2] = {0, 0};
+  if (spec.getattribute(
+          "FramesPerSecond", OIIO::TypeRational, frames_per_second) &&
+      frames_per_second[1] != 0) {
+    impl_->frames_per_second =
+        static_cast<double>(frames_per_second[0]) / frames_per_second[1];
+  } else {
+    impl_->frames_per_second = spec.get_float_attribute("FramesPerSecond", 0);
+  }
+
+  return true;
+}
+
+void VideoReader::Close() {
+  if (impl_->input) {
+    impl_->input->close();
+    impl_->input.reset();
+  }
+  impl_->num_frames = 0;
+  impl_->frames_per_second = 0;
+}
+
+bool VideoReader::IsOpen() const { return impl_->input != nullptr; }
+
+int VideoReader::NumFrames() const { return impl_->num_frames; }
+
+double VideoReader::FramesPerSecond() const {
+  return impl_->frames_per_second;
+}
+
+timestamp_t VideoReader::FrameTimestamp(const int frame_idx) const {
+  if (impl_->frames_per_second <= 0) {
+    return kInvalidTimestamp;
+  }
+  return static_cast<timestamp_t>(
+      std::round(frame_idx * 1e9 / impl_->frames_per_second));
+}
+
+bool VideoReader::ReadFrame(const int frame_idx,
+                            const bool as_rgb,
+                            Bitmap* bitmap) {
+  THROW_CHECK_NOTNULL(bitmap);
+  THROW_CHECK(IsOpen());
+  if (frame_idx < 0 || frame_idx >= impl_->num_frames ||
+      !impl_->input->seek_subimage(frame_idx, 0)) {
+    VLOG(3) << "Failed to seek to video frame " << frame_idx;
+    return false;
+  }
+
+  const OIIO::ImageSpec& spec = impl_->input->spec();
+  // Drops alpha channels as for regular images.
+  const bool is_rgb = spec.nchannels >= 3;
+  Bitmap frame(spec.width, spec.height, is_rgb);
+  if (!impl_->input->read_image(frame_idx,
+                                0,
+                                0,
+                                frame.Channels(),
+                                OIIO::TypeDesc::UINT8,
+                                frame.RowMajorData().data())) {
+    const std::string error = impl_->input->geterror();
+    VLOG(3) << "Failed to read video frame " << frame_idx << ": " << error;
+    return false;
+  }
+
+  if (as_rgb && !is_rgb) {
+    *bitmap = frame.CloneAsRGB();
+  } else if (!as_rgb && is_rgb) {
+    *bitmap = frame.CloneAsGrey();
+  } else {
+    *bitmap = std::move(frame);
+  }
+
+  return true;
+}
+
+Eigen::MatrixXf ComputeVideoFrameSignature(const Bitmap& frame,
+                                           const int max_size) {
+  THROW_CHECK_GT(max_size, 0);
+  const int width = frame.Width();
+  const int height = frame.Height();
+  const int channels = frame.Channels();
+  if (width == 0 || height == 0) {
+    return Eigen::MatrixXf();
+  }
+
+  const double scale =
+      std::max(1.0, static_cast<double>(std::max(width, height)) / max_size);
+  const int signature_width =
+      std::max(1, static_cast<int>(std::round(width / scale)));
+  const int signature_height =
+      std::max(1, static_cast<int>(std::round(height / scale)));
+
+  // Only sample a subset of the pixels in each cell, which is sufficient to
+  // detect duplicates and keeps the cost negligible for large frames.
+  const int step = std::max(1, static_cast<int>(scale / 4));
+
+  Eigen::MatrixXf sums =
+      Eigen::MatrixXf::Zero(signature_height, signature_width);
+  Eigen::MatrixXf counts =
+      Eigen::MatrixXf::Zero(signature_height, signature_width);
+  const std::vector<uint8_t>& data = frame.RowMajorData();
+  for (int y = 0; y < height; y += step) {
+    const int signature_y =
+        std::min(signature_height - 1,
+                 static_cast<int>(static_cast<double>(y) * signature_height /
+                                  height));
+    for (int x = 0; x < width; x += step) {
+      const int signature_x =
+          std::min(signature_width - 1,
+                   static_cast<int>(static_cast<double>(x) * signature_width /
+                                    width));
+      const uint8_t* pixel = &data[(y * width + x) * channels];
+      float intensity = 0;
+      for (int c = 0; c < channels; ++c) {
+        intensity += pixel[c];
+      }
+      sums(signature_y, signature_x) += intensity / channels;
+      counts(signature_y, signature_x) += 1;
+    }
+  }
+
+  return sums.cwiseQuotient(counts.cwiseMax(1.f));
+}
+
+double ComputeVideoFrameDifference(const Eigen::MatrixXf& signature1,
+                                   const Eigen::MatrixXf& signature2) {
+  if (signature1.rows() != signature2.rows() ||
+      signature1.cols() != signature2.cols() || signature1.size() == 0) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return (signature1 - signature2).cwiseAbs().mean();
+}
+
+double ComputeVideoFrameSharpness(const Eigen::MatrixXf& signature) {
+  const Eigen::Index rows = signature.rows();
+  const Eigen::Index cols = signature.cols();
+  if (rows < 3 || cols < 3) {
+    return 0;
+  }
+  const Eigen::MatrixXf laplacian =
+      signature.block(0, 1, rows - 2, cols - 2) +
+      signature.block(2, 1, rows - 2, cols - 2) +
+      signature.block(1, 0, rows - 2, cols - 2) +
+      signature.block(1, 2, rows - 2, cols - 2) -
+      4 * signature.block(1, 1, rows - 2, cols - 2);
+  const double mean = laplacian.mean();
+  return (laplacian.array() - mean).square().mean();
+}
+
+}  // namespace colmap
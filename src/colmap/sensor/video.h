@@ -0,0 +1,94 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "colmap/sensor/bitmap.h"
+#include "colmap/util/types.h"
+
+#include <filesystem>
+#include <memory>
+
+#include <Eigen/Core>
+
+namespace colmap {
+
+// Whether the path has the extension of a common video container format.
+bool IsVideoFile(const std::filesystem::path& path);
+
+// Reader for the frames of a video file. Videos are decoded through
+// OpenImageIO, which must be built with FFmpeg support, and each frame is a
+// subimage of the video. Reading the frames in increasing order avoids
+// repeated seeking in the video stream.
+class VideoReader {
+ public:
+  VideoReader();
+  ~VideoReader();
+
+  // Opens the video at the given path. Returns false if the file is not a
+  // readable video.
+  bool Open(const std::filesystem::path& path);
+  void Close();
+  bool IsOpen() const;
+
+  int NumFrames() const;
+
+  // Frame rate of the video or 0 if unknown.
+  double FramesPerSecond() const;
+
+  // Timestamp of the frame relative to the start of the video or
+  // kInvalidTimestamp if the frame rate is unknown.
+  timestamp_t FrameTimestamp(int frame_idx) const;
+
+  // Decodes the frame and converts it to grey- or colorscale.
+  bool ReadFrame(int frame_idx, bool as_rgb, Bitmap* bitmap);
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+// Downsampled grayscale intensities of a video frame, whose longer side has at
+// most max_size pixels. Used to cheaply detect near-duplicate and blurry
+// frames without comparing the full resolution frames.
+Eigen::MatrixXf ComputeVideoFrameSignature(const Bitmap& frame,
+                                           int max_size = 64);
+
+// Mean absolute intensity difference in [0, 255] between two frame signatures,
+// which is low if the camera barely moved between the frames. Returns
+// infinity if the signatures have different dimensions.
+double ComputeVideoFrameDifference(const Eigen::MatrixXf& signature1,
+                                   const Eigen::MatrixXf& signature2);
+
+// Variance of the Laplacian of the frame signature, which decreases with the
+// amount of motion or defocus blur in the frame.
+double ComputeVideoFrameSharpness(const Eigen::MatrixXf& signature);
+
+}  // namespace colmap
@@ -0,0 +1,111 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/sensor/video.h"
+
+#include <limits>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+Bitmap CreateCheckerboardBitmap(int width, int height, int cell_size) {
+  Bitmap bitmap(width, height, /*as_rgb=*/false);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const uint8_t value = ((x / cell_size + y / cell_size) % 2) * 255;
+      bitmap.SetPixel(x, y, BitmapColor<uint8_t>(value));
+    }
+  }
+  return bitmap;
+}
+
+TEST(IsVideoFile, Nominal) {
+  EXPECT_TRUE(IsVideoFile("video.mp4"));
+  EXPECT_TRUE(IsVideoFile("abc/video.MOV"));
+  EXPECT_TRUE(IsVideoFile("video.mkv"));
+  EXPECT_FALSE(IsVideoFile("image.jpg"));
+  EXPECT_FALSE(IsVideoFile("mp4"));
+}
+
+TEST(VideoReader, OpenInvalid) {
+  VideoReader reader;
+  EXPECT_FALSE(reader.IsOpen());
+  EXPECT_FALSE(reader.Open("does_not_exist.mp4"));
+  EXPECT_FALSE(reader.IsOpen());
+  EXPECT_EQ(reader.NumFrames(), 0);
+  EXPECT_EQ(reader.FrameTimestamp(0), kInvalidTimestamp);
+}
+
+TEST(ComputeVideoFrameSignature, Nominal) {
+  EXPECT_EQ(ComputeVideoFrameSignature(Bitmap()).size(), 0);
+
+  Bitmap bitmap(200, 100, /*as_rgb=*/true);
+  bitmap.Fill(BitmapColor<uint8_t>(30, 60, 90));
+  const Eigen::MatrixXf signature =
+      ComputeVideoFrameSignature(bitmap, /*max_size=*/20);
+  EXPECT_EQ(signature.rows(), 10);
+  EXPECT_EQ(signature.cols(), 20);
+  EXPECT_NEAR(signature.minCoeff(), 60, 1e-4);
+  EXPECT_NEAR(signature.maxCoeff(), 60, 1e-4);
+
+  // Small frames are not upsampled.
+  EXPECT_EQ(ComputeVideoFrameSignature(bitmap, /*max_size=*/400).cols(), 200);
+}
+
+TEST(ComputeVideoFrameDifference, Nominal) {
+  const Bitmap bitmap1 = CreateCheckerboardBitmap(320, 240, 40);
+  const Bitmap bitmap2 = CreateCheckerboardBitmap(320, 240, 80);
+  const Eigen::MatrixXf signature1 = ComputeVideoFrameSignature(bitmap1);
+  const Eigen::MatrixXf signature2 = ComputeVideoFrameSignature(bitmap2);
+  EXPECT_EQ(ComputeVideoFrameDifference(signature1, signature1), 0);
+  EXPECT_GT(ComputeVideoFrameDifference(signature1, signature2), 10);
+  EXPECT_EQ(ComputeVideoFrameDifference(signature1, Eigen::MatrixXf()),
+            std::numeric_limits<double>::infinity());
+  EXPECT_EQ(
+      ComputeVideoFrameDifference(signature1, signature1.leftCols(10)),
+      std::numeric_limits<double>::infinity());
+}
+
+TEST(ComputeVideoFrameSharpness, Nominal) {
+  Bitmap uniform(320, 240, /*as_rgb=*/false);
+  uniform.Fill(BitmapColor<uint8_t>(128));
+  EXPECT_EQ(ComputeVideoFrameSharpness(ComputeVideoFrameSignature(uniform)),
+            0);
+  EXPECT_GT(ComputeVideoFrameSharpness(ComputeVideoFrameSignature(
+                CreateCheckerboardBitmap(320, 240, 10))),
+            ComputeVideoFrameSharpness(ComputeVideoFrameSignature(
+                CreateCheckerboardBitmap(320, 240, 40))));
+  EXPECT_EQ(ComputeVideoFrameSharpness(Eigen::MatrixXf(2, 2)), 0);
+}
+
+}  // namespace
+}  // namespace colmap
@@ -1,16 +1,24 @@
 #include "colmap/sfm/global_mapper.h"
 
 #include "colmap/estimators/bundle_adjustment_caspar.h"
+#include "colmap/estimators/cost_functions/motion_averaging.h"
 #include "colmap/estimators/rotation_averaging.h"
+#include "colmap/geometry/pose.h"
+#include "colmap/math/math.h"
 #include "colmap/math/union_find.h"
 #include "colmap/scene/projection.h"
 #include "colmap/sfm/incremental_mapper.h"
 #include "colmap/sfm/observation_manager.h"
 #include "colmap/util/logging.h"
 #include "colmap/util/misc.h"
+#include "colmap/util/threading.h"
 #include "colmap/util/timer.h"
+#include "colmap/util/tracing.h"
 
 #include <algorithm>
+#include <atomic>
+#include <optional>
+#include <queue>
 
 namespace colmap {
 namespace {
@@ -39,11 +47,135 @@ bool RunBundleAdjustment(const BundleAdjustmentOptions& options,
   return ba->Solve()->IsSolutionUsable();
 }
 
+
+// Returns the pose of an image's camera in its rig, if known.
+std::optional<Rigid3d> MaybeCamFromRig(const Image& image) {
+  if (image.IsRefInFrame()) {
+    return Rigid3d();
+  }
+  return image.FramePtr()->RigPtr()->MaybeSensorFromRig(
+      image.CameraPtr()->SensorId());
+}
+
+// An image pair between two different frames, of which at least one frame was
+// not registered at the beginning of the extension.
+struct ExtensionEdge {
+  image_t image_id1 = kInvalidImageId;
+  image_t image_id2 = kInvalidImageId;
+  frame_t frame_id1 = kInvalidFrameId;
+  frame_t frame_id2 = kInvalidFrameId;
+  Rigid3d cam1_from_rig1;
+  Rigid3d cam2_from_rig2;
+  Rigid3d cam2_from_cam1;
+  double weight = 0;
+
+  Eigen::Quaterniond Rig2FromRig1Rotation() const {
+    return cam2_from_rig2.rotation().inverse() * cam2_from_cam1.rotation() *
+           cam1_from_rig1.rotation();
+  }
+};
+
+// Collects the valid image pairs involving at least one new frame. If
+// registered_only is true, both frames of the pair must be registered.
+std::vector<ExtensionEdge> CollectExtensionEdges(
+    const PoseGraph& pose_graph,
+    const Reconstruction& reconstruction,
+    const std::unordered_set<frame_t>& existing_frame_ids,
+    bool registered_only) {
+  std::vector<ExtensionEdge> edges;
+  for (const auto& [pair_id, edge] : pose_graph.ValidEdges()) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    if (!reconstruction.ExistsImage(image_id1) ||
+        !reconstruction.ExistsImage(image_id2)) {
+      continue;
+    }
+    const Image& image1 = reconstruction.Image(image_id1);
+    const Image& image2 = reconstruction.Image(image_id2);
+    if (image1.FrameId() == image2.FrameId() ||
+        (existing_frame_ids.count(image1.FrameId()) &&
+         existing_frame_ids.count(image2.FrameId()))) {
+      continue;
+    }
+    if (registered_only && (!image1.HasPose() || !image2.HasPose())) {
+      continue;
+    }
+    const std::optional<Rigid3d> cam1_from_rig1 = MaybeCamFromRig(image1);
+    const std::optional<Rigid3d> cam2_from_rig2 = MaybeCamFromRig(image2);
+    if (!cam1_from_rig1.has_value() || !cam2_from_rig2.has_value()) {
+      continue;
+    }
+    ExtensionEdge& extension_edge = edges.emplace_back();
+    extension_edge.image_id1 = image_id1;
+    extension_edge.image_id2 = image_id2;
+    extension_edge.frame_id1 = image1.FrameId();
+    extension_edge.frame_id2 = image2.FrameId();
+    extension_edge.cam1_from_rig1 = *cam1_from_rig1;
+    extension_edge.cam2_from_rig2 = *cam2_from_rig2;
+    extension_edge.cam2_from_cam1 = edge.cam2_from_cam1;
+    extension_edge.weight = std::max(edge.num_matches, 1);
+  }
+  return edges;
+}
+
+// Visits the edges in the order of a maximum spanning tree grown from the
+// existing frames. For each edge that connects a known frame to a frame
+// without estimate, the callback is invoked with the edge index and whether
+// the first frame of the edge is the known one. Returns the newly visited
+// frames in the order of their discovery.
+std::vector<frame_t> TraverseExtensionSpanningTree(
+    const std::vector<ExtensionEdge>& edges,
+    const std::unordered_set<frame_t>& existing_frame_ids,
+    const std::function<void(size_t, bool)>& visit_edge) {
+  std::unordered_map<frame_t, std::vector<size_t>> frame_edge_indices;
+  for (size_t edge_idx = 0; edge_idx < edges.size(); ++edge_idx) {
+    frame_edge_indices[edges[edge_idx].frame_id1].push_back(edge_idx);
+    frame_edge_indices[edges[edge_idx].frame_id2].push_back(edge_idx);
+  }
+
+  std::unordered_set<frame_t> visited_frame_ids;
+  const auto is_known = [&](frame_t frame_id) {
+    return existing_frame_ids.count(frame_id) > 0 ||
+           visited_frame_ids.count(frame_id) > 0;
+  };
+
+  std::priority_queue<std::pair<double, size_t>> queue;
+  for (size_t edge_idx = 0; edge_idx < edges.size(); ++edge_idx) {
+    if (is_known(edges[edge_idx].frame_id1) ||
+        is_known(edges[edge_idx].frame_id2)) {
+      queue.emplace(edges[edge_idx].weight, edge_idx);
+    }
+  }
+
+  std::vector<frame_t> new_frame_ids;
+  while (!queue.empty()) {
+    const size_t edge_idx = queue.top().second;
+    queue.pop();
+    const ExtensionEdge& edge = edges[edge_idx];
+    const bool known1 = is_known(edge.frame_id1);
+    const bool known2 = is_known(edge.frame_id2);
+    if (known1 == known2) {
+      continue;
+    }
+    visit_edge(edge_idx, known1);
+    const frame_t frame_id = known1 ? edge.frame_id2 : edge.frame_id1;
+    visited_frame_ids.insert(frame_id);
+    new_frame_ids.push_back(frame_id);
+    for (const size_t next_edge_idx : frame_edge_indices.at(frame_id)) {
+      const ExtensionEdge& next_edge = edges[next_edge_idx];
+      if (!is_known(next_edge.frame_id1) || !is_known(next_edge.frame_id2)) {
+        queue.emplace(next_edge.weight, next_edge_idx);
+      }
+    }
+  }
+  return new_frame_ids;
+}
+
 }  // namespace
 
 RotationEstimatorOptions GlobalMapperOptions::RotationAveraging() const {
   RotationEstimatorOptions opts = rotation_averaging;
   opts.refine_sensor_from_rig = refine_sensor_from_rig;
+  opts.num_threads = num_threads;
   if (random_seed >= 0) {
     opts.random_seed = random_seed;
   }
@@ -58,6 +190,10 @@ GlobalPositionerOptions GlobalMapperOptions::GlobalPositioning() const {
     opts.random_seed = random_seed;
     opts.use_parameter_block_ordering = false;
   }
+  if (deterministic) {
+    opts.solver_options.num_threads = 1;
+    opts.use_gpu = false;
+  }
   return opts;
 }
 
@@ -71,6 +207,13 @@ BundleAdjustmentOptions GlobalMapperOptions::BundleAdjustment() const {
   if (opts.caspar) {
     opts.caspar->gpu_index = ba_gpu_index;
   }
+  if (deterministic) {
+    opts.backend = BundleAdjustmentBackend::CERES;
+    if (opts.ceres) {
+      opts.ceres->solver_options.num_threads = 1;
+      opts.ceres->use_gpu = false;
+    }
+  }
   return opts;
 }
 
@@ -92,6 +235,9 @@ void GlobalMapper::BeginReconstruction(
   reconstruction_->Load(*database_cache_);
   pose_graph_ = std::make_shared<class PoseGraph>();
   pose_graph_->Load(*database_cache_->CorrespondenceGraph());
+  existing_frame_ids_ =
+      std::unordered_set<frame_t>(reconstruction_->RegFrameIds().begin(),
+                                  reconstruction_->RegFrameIds().end());
 }
 
 std::shared_ptr<Reconstruction> GlobalMapper::Reconstruction() const {
@@ -99,6 +245,7 @@ std::shared_ptr<Reconstruction> GlobalMapper::Reconstruction() const {
 }
 
 bool GlobalMapper::RotationAveraging(const RotationEstimatorOptions& options) {
+  COLMAP_TRACE_ZONE("RotationAveraging");
   THROW_CHECK_NOTNULL(reconstruction_);
   THROW_CHECK_NOTNULL(pose_graph_);
 
@@ -136,144 +283,256 @@ bool GlobalMapper::RotationAveraging(const RotationEstimatorOptions& options) {
 }
 
 void GlobalMapper::EstablishTracks(const GlobalMapperOptions& options) {
-  using Observation = std::pair<image_t, point2D_t>;
+  COLMAP_TRACE_ZONE("EstablishTracks");
   THROW_CHECK_EQ(reconstruction_->NumPoints3D(), 0);
 
-  // Build keypoints map from registered images.
-  std::unordered_map<image_t, std::vector<Eigen::Vector2d>>
-      image_id_to_keypoints;
-  for (const auto image_id : reconstruction_->RegImageIds()) {
-    const auto& image = reconstruction_->Image(image_id);
-    std::vector<Eigen::Vector2d> points;
-    points.reserve(image.NumPoints2D());
-    for (const auto& point2D : image.Points2D()) {
-      points.push_back(point2D.xy);
-    }
-    image_id_to_keypoints.emplace(image_id, std::move(points));
+  // Assign compact 32-bit observation ids by concatenating the 2D points of
+  // all registered images, such that the observations of an image form a
+  // contiguous id range starting at its offset.
+  std::vector<image_t> image_ids = reconstruction_->RegImageIds();
+  std::sort(image_ids.begin(), image_ids.end());
+  const size_t num_images = image_ids.size();
+  std::vector<const Image*> images(num_images);
+  std::vector<uint32_t> image_offsets(num_images + 1, 0);
+  std::unordered_map<image_t, size_t> image_id_to_idx;
+  image_id_to_idx.reserve(num_images);
+  uint64_t num_observations = 0;
+  for (size_t image_idx = 0; image_idx < num_images; ++image_idx) {
+    images[image_idx] = &reconstruction_->Image(image_ids[image_idx]);
+    image_id_to_idx.emplace(image_ids[image_idx], image_idx);
+    image_offsets[image_idx] = static_cast<uint32_t>(num_observations);
+    num_observations += images[image_idx]->NumPoints2D();
+    THROW_CHECK_LT(num_observations, std::numeric_limits<uint32_t>::max())
+        << "Too many observations for 32-bit observation ids";
   }
+  image_offsets[num_images] = static_cast<uint32_t>(num_observations);
 
-  auto corr_graph = database_cache_->CorrespondenceGraph();
-
-  // Union all matching observations.
-  UnionFind<Observation> uf;
-  FeatureMatches matches;
+  // Collect the valid neighbors of each image. Every pair is stored only once
+  // at the image with the smaller id, so each match is united exactly once.
+  std::vector<std::vector<image_t>> image_neighbors(num_images);
   for (const auto& [pair_id, edge] : pose_graph_->ValidEdges()) {
     const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
-    THROW_CHECK(image_id_to_keypoints.count(image_id1))
+    const auto it1 = image_id_to_idx.find(image_id1);
+    THROW_CHECK(it1 != image_id_to_idx.end())
         << "Missing keypoints for image " << image_id1;
-    THROW_CHECK(image_id_to_keypoints.count(image_id2))
+    THROW_CHECK(image_id_to_idx.count(image_id2))
         << "Missing keypoints for image " << image_id2;
-    corr_graph->ExtractMatchesBetweenImages(image_id1, image_id2, matches);
-    for (const auto& match : matches) {
-      const Observation obs1(image_id1, match.point2D_idx1);
-      const Observation obs2(image_id2, match.point2D_idx2);
-      if (obs2 < obs1) {
-        uf.Union(obs1, obs2);
-      } else {
-        uf.Union(obs2, obs1);
-      }
-    }
+    image_neighbors[it1->second].push_back(image_id2);
+  }
+  for (auto& neighbors : image_neighbors) {
+    std::sort(neighbors.begin(), neighbors.end());
   }
 
-  // Group observations by their root.
+  const auto corr_graph = database_cache_->CorrespondenceGraph();
+  const int num_threads = GetEffectiveNumThreads(options.num_threads);
+
+  // Union all matching observations. The images are sharded across threads
+  // and correspondences are streamed directly from the correspondence graph
+  // without materializing the matches of each image pair.
+  ConcurrentUnionFind uf(static_cast<uint32_t>(num_observations));
+  {
+    ThreadPool thread_pool(num_threads);
+    for (int thread_idx = 0; thread_idx < num_threads; ++thread_idx) {
+      thread_pool.AddTask([&, thread_idx]() {
+        for (size_t image_idx = thread_idx; image_idx < num_images;
+             image_idx += num_threads) {
+          const std::vector<image_t>& neighbors = image_neighbors[image_idx];
+          if (neighbors.empty()) {
+            continue;
+          }
+          const image_t image_id1 = image_ids[image_idx];
+          const point2D_t num_points2D = images[image_idx]->NumPoints2D();
+          for (point2D_t point2D_idx1 = 0; point2D_idx1 < num_points2D;
+               ++point2D_idx1) {
+            const auto range =
+                corr_graph->FindCorrespondences(image_id1, point2D_idx1);
+            for (const auto* corr = range.beg; corr < range.end; ++corr) {
+              if (!std::binary_search(
+                      neighbors.begin(), neighbors.end(), corr->image_id)) {
+                continue;
+              }
+              const size_t image_idx2 = image_id_to_idx.at(corr->image_id);
+              uf.Union(image_offsets[image_idx] + point2D_idx1,
+                       image_offsets[image_idx2] + corr->point2D_idx);
+            }
+          }
+        }
+      });
+    }
+    thread_pool.Wait();
+  }
   uf.Compress();
-  std::unordered_map<Observation, std::vector<Observation>> track_map;
-  for (const auto& [obs, root] : uf.Parents()) {
-    track_map[root].push_back(obs);
+
+  // Count the observations per track. Tracks with fewer observations than the
+  // minimum number of views cannot be valid, so they are discarded here
+  // before any per-track storage is allocated.
+  std::vector<uint32_t> track_sizes(num_observations, 0);
+  for (uint32_t obs_id = 0; obs_id < num_observations; ++obs_id) {
+    ++track_sizes[uf.Parent(obs_id)];
   }
-  LOG(INFO) << "Established " << track_map.size() << " tracks from "
-            << uf.Parents().size() << " observations";
+  const uint32_t min_track_size =
+      std::max(2, options.track_min_num_views_per_track);
+  size_t num_tracks = 0;
+  size_t num_short_tracks = 0;
+  std::vector<uint32_t> track_roots;
+  std::vector<uint32_t> track_begs = {0};
+  for (uint32_t obs_id = 0; obs_id < num_observations; ++obs_id) {
+    const uint32_t track_size = track_sizes[obs_id];
+    if (track_size < 2) {
+      continue;
+    }
+    ++num_tracks;
+    if (track_size < min_track_size) {
+      ++num_short_tracks;
+      continue;
+    }
+    track_roots.push_back(obs_id);
+    track_begs.push_back(track_begs.back() + track_size);
+  }
+  LOG(INFO) << "Established " << num_tracks << " tracks from "
+            << num_observations << " observations, discarded "
+            << num_short_tracks << " short tracks";
+
+  // Gather the observations of the remaining tracks into contiguous ranges.
+  // The storage of the track sizes is reused to map roots to track indices.
+  // As observation ids are visited in increasing order, the observations of
+  // each track are grouped by image.
+  constexpr uint32_t kInvalidTrackIdx = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> root_to_track_idx = std::move(track_sizes);
+  std::fill(
+      root_to_track_idx.begin(), root_to_track_idx.end(), kInvalidTrackIdx);
+  for (size_t track_idx = 0; track_idx < track_roots.size(); ++track_idx) {
+    root_to_track_idx[track_roots[track_idx]] = track_idx;
+  }
+  std::vector<uint32_t> track_cursors(track_begs.begin(),
+                                      track_begs.end() - 1);
+  std::vector<uint32_t> track_observations(track_begs.back());
+  for (uint32_t obs_id = 0; obs_id < num_observations; ++obs_id) {
+    const uint32_t track_idx = root_to_track_idx[uf.Parent(obs_id)];
+    if (track_idx != kInvalidTrackIdx) {
+      track_observations[track_cursors[track_idx]++] = obs_id;
+    }
+  }
+  std::vector<uint32_t>().swap(root_to_track_idx);
+  std::vector<uint32_t>().swap(track_cursors);
 
-  // Validate tracks, check consistency, and collect valid ones with lengths.
-  std::unordered_map<point3D_t, Point3D> candidate_points3D;
-  std::vector<std::pair<size_t, point3D_t>> track_lengths;
-  size_t discarded_counter = 0;
-  point3D_t next_point3D_id = 0;
+  const auto obs_id_to_image_idx = [&image_offsets](uint32_t obs_id) {
+    return static_cast<size_t>(
+        std::upper_bound(image_offsets.begin(), image_offsets.end(), obs_id) -
+        image_offsets.begin() - 1);
+  };
 
-  for (const auto& [track_id, observations] : track_map) {
-    std::unordered_map<image_t, std::vector<Eigen::Vector2d>> image_id_set;
-    Point3D point3D;
-    bool is_consistent = true;
-
-    for (const auto& [image_id, feature_id] : observations) {
-      const Eigen::Vector2d& xy =
-          image_id_to_keypoints.at(image_id).at(feature_id);
-
-      auto it = image_id_set.find(image_id);
-      if (it != image_id_set.end()) {
-        for (const auto& existing_xy : it->second) {
-          const double sq_threshold =
-              options.track_intra_image_consistency_threshold *
-              options.track_intra_image_consistency_threshold;
-          if ((existing_xy - xy).squaredNorm() > sq_threshold) {
+  // Check that all observations of a track within the same image are
+  // consistent and that the track spans enough images.
+  const double sq_threshold = options.track_intra_image_consistency_threshold *
+                              options.track_intra_image_consistency_threshold;
+  const auto is_valid_track = [&](size_t track_idx, bool& is_consistent) {
+    const uint32_t* track_beg =
+        track_observations.data() + track_begs[track_idx];
+    const uint32_t* track_end =
+        track_observations.data() + track_begs[track_idx + 1];
+    size_t num_track_images = 0;
+    while (track_beg != track_end) {
+      const size_t image_idx = obs_id_to_image_idx(*track_beg);
+      const Image& image = *images[image_idx];
+      const uint32_t* image_end =
+          std::lower_bound(track_beg, track_end, image_offsets[image_idx + 1]);
+      for (const uint32_t* obs1 = track_beg; obs1 != image_end; ++obs1) {
+        const Eigen::Vector2d& xy1 =
+            image.Point2D(*obs1 - image_offsets[image_idx]).xy;
+        for (const uint32_t* obs2 = track_beg; obs2 != obs1; ++obs2) {
+          const Eigen::Vector2d& xy2 =
+              image.Point2D(*obs2 - image_offsets[image_idx]).xy;
+          if ((xy1 - xy2).squaredNorm() > sq_threshold) {
             is_consistent = false;
-            break;
+            return false;
           }
         }
-        if (!is_consistent) {
-          ++discarded_counter;
-          break;
-        }
-        it->second.push_back(xy);
-      } else {
-        image_id_set[image_id].push_back(xy);
       }
-      point3D.track.AddElement(image_id, feature_id);
+      ++num_track_images;
+      track_beg = image_end;
     }
+    is_consistent = true;
+    return num_track_images >=
+           static_cast<size_t>(options.track_min_num_views_per_track);
+  };
 
-    if (!is_consistent) continue;
-
-    const size_t num_images = image_id_set.size();
-    if (num_images < static_cast<size_t>(options.track_min_num_views_per_track))
-      continue;
+  // Validate the tracks in parallel.
+  std::vector<char> track_valid(track_roots.size(), 0);
+  std::atomic<size_t> num_inconsistent_tracks(0);
+  {
+    ThreadPool thread_pool(num_threads);
+    for (int thread_idx = 0; thread_idx < num_threads; ++thread_idx) {
+      thread_pool.AddTask([&, thread_idx]() {
+        for (size_t track_idx = thread_idx; track_idx < track_roots.size();
+             track_idx += num_threads) {
+          bool is_consistent = true;
+          track_valid[track_idx] = is_valid_track(track_idx, is_consistent);
+          if (!is_consistent) {
+            ++num_inconsistent_tracks;
+          }
+        }
+      });
+    }
+    thread_pool.Wait();
+  }
 
-    const point3D_t point3D_id = next_point3D_id++;
-    track_lengths.emplace_back(point3D.track.Length(), point3D_id);
-    candidate_points3D.emplace(point3D_id, std::move(point3D));
+  std::vector<std::pair<uint32_t, uint32_t>> track_lengths;
+  for (size_t track_idx = 0; track_idx < track_roots.size(); ++track_idx) {
+    if (track_valid[track_idx]) {
+      track_lengths.emplace_back(
+          track_begs[track_idx + 1] - track_begs[track_idx], track_idx);
+    }
   }
 
-  LOG(INFO) << "Kept " << candidate_points3D.size() << " tracks, discarded "
-            << discarded_counter << " due to inconsistency";
+  LOG(INFO) << "Kept " << track_lengths.size() << " tracks, discarded "
+            << num_inconsistent_tracks.load() << " due to inconsistency";
 
-  // Sort tracks by length (descending) and select for problem.
+  // Sort tracks by length (descending) and select for problem. Only the
+  // selected tracks are materialized as 3D points.
   std::sort(track_lengths.begin(), track_lengths.end(), std::greater<>());
 
-  std::unordered_map<image_t, size_t> tracks_per_image;
-  size_t images_left = image_id_to_keypoints.size();
+  std::vector<size_t> tracks_per_image(num_images, 0);
+  size_t images_left = num_images;
   const size_t max_num_tracks =
       static_cast<size_t>(options.keep_max_num_tracks);
-  for (const auto& [track_length, point3D_id] : track_lengths) {
+  const size_t required_tracks_per_view =
+      static_cast<size_t>(options.track_required_tracks_per_view);
+  point3D_t next_point3D_id = 0;
+  for (const auto& [track_length, track_idx] : track_lengths) {
     // Stop once the global track budget is exhausted. As tracks are sorted by
     // decreasing length, this keeps the longest tracks and bounds memory usage.
     if (reconstruction_->NumPoints3D() >= max_num_tracks) break;
 
-    auto& point3D = candidate_points3D.at(point3D_id);
+    const auto track_beg = track_observations.begin() + track_begs[track_idx];
+    const auto track_end =
+        track_observations.begin() + track_begs[track_idx + 1];
 
     // Check if any image in this track still needs more observations.
-    const bool should_add = std::any_of(
-        point3D.track.Elements().begin(),
-        point3D.track.Elements().end(),
-        [&](const auto& obs) {
-          return tracks_per_image[obs.image_id] <=
-                 static_cast<size_t>(options.track_required_tracks_per_view);
+    const bool should_add =
+        std::any_of(track_beg, track_end, [&](const uint32_t obs_id) {
+          return tracks_per_image[obs_id_to_image_idx(obs_id)] <=
+                 required_tracks_per_view;
         });
     if (!should_add) continue;
 
-    // Update image counts.
-    for (const auto& obs : point3D.track.Elements()) {
-      auto& count = tracks_per_image[obs.image_id];
-      if (count == static_cast<size_t>(options.track_required_tracks_per_view))
-        --images_left;
+    // Update image counts and add track.
+    Point3D point3D;
+    point3D.track.Reserve(track_length);
+    for (auto it = track_beg; it != track_end; ++it) {
+      const size_t image_idx = obs_id_to_image_idx(*it);
+      auto& count = tracks_per_image[image_idx];
+      if (count == required_tracks_per_view) --images_left;
       ++count;
+      point3D.track.AddElement(image_ids[image_idx],
+                               *it - image_offsets[image_idx]);
     }
-
-    // Add track after updating counts so we can move.
-    reconstruction_->AddPoint3D(point3D_id, std::move(point3D));
+    reconstruction_->AddPoint3D(next_point3D_id++, std::move(point3D));
 
     if (images_left == 0) break;
   }
 
-  LOG(INFO) << "Before filtering: " << candidate_points3D.size()
+  LOG(INFO) << "Before filtering: " << track_lengths.size()
             << ", after filtering: " << reconstruction_->NumPoints3D();
 }
 
@@ -281,6 +540,7 @@ bool GlobalMapper::GlobalPositioning(const GlobalPositionerOptions& options,
                                      double max_angular_reproj_error_deg,
                                      double max_normalized_reproj_error,
                                      double min_tri_angle_deg) {
+  COLMAP_TRACE_ZONE("GlobalPositioning");
   if (!RunGlobalPositioning(options, *pose_graph_, *reconstruction_)) {
     return false;
   }
@@ -347,6 +607,7 @@ bool GlobalMapper::IterativeBundleAdjustment(
     bool skip_fixed_rotation_stage,
     bool skip_joint_optimization_stage,
     const std::function<bool()>& on_progress) {
+  COLMAP_TRACE_ZONE("IterativeBundleAdjustment");
   for (int ite = 0; ite < num_iterations; ite++) {
     // Optional fixed-rotation stage: optimize positions only
     if (!skip_fixed_rotation_stage) {
@@ -390,6 +651,7 @@ bool GlobalMapper::IterativeBundleAdjustment(
     // adjustment right away. Instead, use a more strict criteria to filter
     LOG(INFO) << "Filtering tracks by reprojection ...";
 
+    COLMAP_TRACE_ZONE("FilterPoints");
     ObservationManager obs_manager(*reconstruction_);
     bool status = true;
     size_t filtered_num = 0;
@@ -415,6 +677,7 @@ bool GlobalMapper::IterativeBundleAdjustment(
   // Filter tracks based on the estimation
   LOG(INFO) << "Filtering tracks by reprojection ...";
   {
+    COLMAP_TRACE_ZONE("FilterPoints");
     ObservationManager obs_manager(*reconstruction_);
     obs_manager.FilterPoints3DWithLargeReprojectionError(
         max_normalized_reproj_error,
@@ -427,11 +690,445 @@ bool GlobalMapper::IterativeBundleAdjustment(
   return true;
 }
 
+bool GlobalMapper::ExtendRotations(const RotationEstimatorOptions& options) {
+  THROW_CHECK_NOTNULL(reconstruction_);
+  THROW_CHECK_NOTNULL(pose_graph_);
+
+  if (existing_frame_ids_.empty()) {
+    LOG(ERROR) << "Cannot extend a reconstruction without registered frames";
+    return false;
+  }
+
+  const std::vector<ExtensionEdge> edges =
+      CollectExtensionEdges(*pose_graph_,
+                            *reconstruction_,
+                            existing_frame_ids_,
+                            /*registered_only=*/false);
+
+  std::unordered_map<frame_t, Eigen::Quaterniond> rotations;
+  for (const frame_t frame_id : existing_frame_ids_) {
+    rotations.emplace(
+        frame_id, reconstruction_->Frame(frame_id).RigFromWorld().rotation());
+  }
+
+  // Initialize the new rotations along a maximum spanning tree.
+  const std::vector<frame_t> new_frame_ids = TraverseExtensionSpanningTree(
+      edges, existing_frame_ids_, [&](size_t edge_idx, bool known1) {
+        const ExtensionEdge& edge = edges[edge_idx];
+        const Eigen::Quaterniond rig2_from_rig1 = edge.Rig2FromRig1Rotation();
+        if (known1) {
+          rotations[edge.frame_id2] =
+              rig2_from_rig1 * rotations.at(edge.frame_id1);
+        } else {
+          rotations[edge.frame_id1] =
+              rig2_from_rig1.inverse() * rotations.at(edge.frame_id2);
+        }
+      });
+  if (new_frame_ids.empty()) {
+    LOG(WARNING) << "No unregistered frames connected to the reconstruction";
+    return true;
+  }
+
+  std::unordered_map<frame_t, std::vector<size_t>> frame_edge_indices;
+  for (size_t edge_idx = 0; edge_idx < edges.size(); ++edge_idx) {
+    const ExtensionEdge& edge = edges[edge_idx];
+    if (rotations.count(edge.frame_id1) && rotations.count(edge.frame_id2)) {
+      frame_edge_indices[edge.frame_id1].push_back(edge_idx);
+      frame_edge_indices[edge.frame_id2].push_back(edge_idx);
+    }
+  }
+
+  // Refine the new rotations by iteratively reweighted averaging of the
+  // rotations predicted by their neighbors, using Geman-McClure weights.
+  const double sigma_sq = DegToRad(options.irls_loss_parameter_sigma) *
+                          DegToRad(options.irls_loss_parameter_sigma);
+  std::vector<Eigen::Quaterniond> predicted_rotations;
+  std::vector<double> weights;
+  for (int iter = 0; iter < options.max_num_irls_iterations; ++iter) {
+    double sum_step = 0;
+    for (const frame_t frame_id : new_frame_ids) {
+      Eigen::Quaterniond& rotation = rotations.at(frame_id);
+      predicted_rotations.clear();
+      weights.clear();
+      for (const size_t edge_idx : frame_edge_indices.at(frame_id)) {
+        const ExtensionEdge& edge = edges[edge_idx];
+        const Eigen::Quaterniond rig2_from_rig1 = edge.Rig2FromRig1Rotation();
+        const Eigen::Quaterniond predicted_rotation =
+            frame_id == edge.frame_id2
+                ? rig2_from_rig1 * rotations.at(edge.frame_id1)
+                : rig2_from_rig1.inverse() * rotations.at(edge.frame_id2);
+        const double error = rotation.angularDistance(predicted_rotation);
+        const double robust_weight = sigma_sq / (sigma_sq + error * error);
+        predicted_rotations.push_back(predicted_rotation);
+        weights.push_back(edge.weight * robust_weight * robust_weight);
+      }
+      const Eigen::Quaterniond refined_rotation =
+          AverageQuaternions(predicted_rotations, weights);
+      sum_step += rotation.angularDistance(refined_rotation);
+      rotation = refined_rotation;
+    }
+    if (sum_step / new_frame_ids.size() <
+        options.irls_step_convergence_threshold) {
+      break;
+    }
+  }
+
+  for (const frame_t frame_id : new_frame_ids) {
+    reconstruction_->Frame(frame_id).SetRigFromWorld(
+        Rigid3d(rotations.at(frame_id), Eigen::Vector3d::Zero()));
+    reconstruction_->RegisterFrame(frame_id);
+  }
+
+  // Filter image pairs by their relative rotation error.
+  size_t num_invalid_edges = 0;
+  if (options.max_rotation_error_deg > 0) {
+    const double max_rotation_error_rad =
+        DegToRad(options.max_rotation_error_deg);
+    for (const ExtensionEdge& edge : edges) {
+      if (!rotations.count(edge.frame_id1) ||
+          !rotations.count(edge.frame_id2)) {
+        continue;
+      }
+      const Eigen::Quaterniond rig2_from_rig1 =
+          rotations.at(edge.frame_id2) * rotations.at(edge.frame_id1).inverse();
+      if (rig2_from_rig1.angularDistance(edge.Rig2FromRig1Rotation()) >
+          max_rotation_error_rad) {
+        pose_graph_->SetInvalidEdge(
+            ImagePairToPairId(edge.image_id1, edge.image_id2));
+        ++num_invalid_edges;
+      }
+    }
+  }
+
+  LOG(INFO) << "Estimated rotations of " << new_frame_ids.size()
+            << " new frames, marked " << num_invalid_edges
+            << " image pairs as invalid";
+
+  return true;
+}
+
+bool GlobalMapper::ExtendPositions(const GlobalPositionerOptions& options) {
+  THROW_CHECK_NOTNULL(reconstruction_);
+  THROW_CHECK_NOTNULL(pose_graph_);
+
+  std::vector<ExtensionEdge> edges =
+      CollectExtensionEdges(*pose_graph_,
+                            *reconstruction_,
+                            existing_frame_ids_,
+                            /*registered_only=*/true);
+  edges.erase(std::remove_if(edges.begin(),
+                             edges.end(),
+                             [](const ExtensionEdge& edge) {
+                               return edge.cam2_from_cam1.translation().norm() <
+                                      1e-12;
+                             }),
+              edges.end());
+
+  std::unordered_map<frame_t, Eigen::Vector3d> centers;
+  for (const frame_t frame_id : existing_frame_ids_) {
+    centers.emplace(
+        frame_id,
+        reconstruction_->Frame(frame_id).RigFromWorld().TgtOriginInSrc());
+  }
+
+  // Camera center of an image relative to its frame center in world
+  // coordinates.
+  const auto cam_in_rig_in_world = [this](frame_t frame_id,
+                                          const Rigid3d& cam_from_rig) {
+    const Rigid3d& rig_from_world =
+        reconstruction_->Frame(frame_id).RigFromWorld();
+    return (rig_from_world.rotation().inverse() * cam_from_rig.TgtOriginInSrc())
+        .eval();
+  };
+  // Direction from the second to the first camera center in world coordinates.
+  const auto cam1_from_cam2_dir = [this](const ExtensionEdge& edge) {
+    const Eigen::Quaterniond cam2_from_world_rotation =
+        edge.cam2_from_rig2.rotation() *
+        reconstruction_->Frame(edge.frame_id2).RigFromWorld().rotation();
+    return (cam2_from_world_rotation.inverse() *
+            edge.cam2_from_cam1.translation())
+        .normalized()
+        .eval();
+  };
+
+  // Use the median distance between the connected existing frames as the
+  // baseline to initialize the new positions.
+  std::unordered_set<frame_t> anchor_frame_ids;
+  for (const ExtensionEdge& edge : edges) {
+    for (const frame_t frame_id : {edge.frame_id1, edge.frame_id2}) {
+      if (existing_frame_ids_.count(frame_id)) {
+        anchor_frame_ids.insert(frame_id);
+      }
+    }
+  }
+  std::vector<double> baselines;
+  for (const auto& [pair_id, edge] : pose_graph_->ValidEdges()) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    const frame_t frame_id1 = reconstruction_->Image(image_id1).FrameId();
+    const frame_t frame_id2 = reconstruction_->Image(image_id2).FrameId();
+    if (frame_id1 != frame_id2 && anchor_frame_ids.count(frame_id1) &&
+        anchor_frame_ids.count(frame_id2)) {
+      baselines.push_back(
+          (centers.at(frame_id1) - centers.at(frame_id2)).norm());
+    }
+  }
+  const double baseline = baselines.empty() ? 1.0 : Median(baselines);
+
+  // Initialize the new positions along a maximum spanning tree.
+  const std::vector<frame_t> new_frame_ids = TraverseExtensionSpanningTree(
+      edges, existing_frame_ids_, [&](size_t edge_idx, bool known1) {
+        const ExtensionEdge& edge = edges[edge_idx];
+        const Eigen::Vector3d offset1 =
+            cam_in_rig_in_world(edge.frame_id1, edge.cam1_from_rig1);
+        const Eigen::Vector3d offset2 =
+            cam_in_rig_in_world(edge.frame_id2, edge.cam2_from_rig2);
+        const Eigen::Vector3d dir = cam1_from_cam2_dir(edge);
+        if (known1) {
+          centers[edge.frame_id2] =
+              centers.at(edge.frame_id1) + offset1 - baseline * dir - offset2;
+        } else {
+          centers[edge.frame_id1] =
+              centers.at(edge.frame_id2) + offset2 + baseline * dir - offset1;
+        }
+      });
+
+  // De-register the new frames that are not connected through any image pair
+  // with a translation to the existing frames.
+  std::unordered_set<frame_t> new_frame_ids_set(new_frame_ids.begin(),
+                                                new_frame_ids.end());
+  const std::vector<frame_t> reg_frame_ids = reconstruction_->RegFrameIds();
+  for (const frame_t frame_id : reg_frame_ids) {
+    if (!existing_frame_ids_.count(frame_id) &&
+        !new_frame_ids_set.count(frame_id)) {
+      reconstruction_->DeRegisterFrame(frame_id);
+    }
+  }
+  if (new_frame_ids.empty()) {
+    LOG(WARNING) << "No new frames to position";
+    return true;
+  }
+
+  // Solve for the positions of the new frames given the translation
+  // directions of their image pairs, with auxiliary scale variables:
+  // dir - scale * (c1 + offset1 - c2 - offset2).
+  GlobalPositionerOptions custom_options = options;
+  std::shared_ptr<ceres::LossFunction> loss_function =
+      custom_options.CreateLossFunction();
+  ceres::Problem::Options problem_options;
+  problem_options.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+  ceres::Problem problem(problem_options);
+  std::vector<double> scales;
+  scales.reserve(edges.size());
+  for (const ExtensionEdge& edge : edges) {
+    if (!centers.count(edge.frame_id1) || !centers.count(edge.frame_id2)) {
+      continue;
+    }
+    const Eigen::Vector3d offset1 =
+        cam_in_rig_in_world(edge.frame_id1, edge.cam1_from_rig1);
+    const Eigen::Vector3d offset2 =
+        cam_in_rig_in_world(edge.frame_id2, edge.cam2_from_rig2);
+    double* center1 = centers.at(edge.frame_id1).data();
+    double* center2 = centers.at(edge.frame_id2).data();
+    const double dist = (centers.at(edge.frame_id1) + offset1 -
+                         centers.at(edge.frame_id2) - offset2)
+                            .norm();
+    scales.push_back(1.0 / std::max(dist, 1e-5 * baseline));
+    problem.AddResidualBlock(
+        RigBATAPairwiseDirectionConstantRigCostFunctor::Create(
+            cam1_from_cam2_dir(edge), offset1 - offset2),
+        loss_function.get(),
+        center1,
+        center2,
+        &scales.back());
+    problem.SetParameterLowerBound(&scales.back(), 0, 1e-5);
+    for (const frame_t frame_id : {edge.frame_id1, edge.frame_id2}) {
+      if (existing_frame_ids_.count(frame_id)) {
+        problem.SetParameterBlockConstant(centers.at(frame_id).data());
+      }
+    }
+  }
+
+  ceres::Solver::Options solver_options = custom_options.solver_options;
+  solver_options.linear_solver_type = ceres::SPARSE_SCHUR;
+  solver_options.num_threads =
+      GetEffectiveNumThreads(solver_options.num_threads);
+  solver_options.minimizer_progress_to_stdout = VLOG_IS_ON(2);
+  ceres::Solver::Summary summary;
+  ceres::Solve(solver_options, &problem, &summary);
+  VLOG(2) << summary.FullReport();
+  if (!summary.IsSolutionUsable()) {
+    LOG(ERROR) << "Failed to estimate the positions of the new frames";
+    return false;
+  }
+
+  for (const frame_t frame_id : new_frame_ids) {
+    Rigid3d& rig_from_world = reconstruction_->Frame(frame_id).RigFromWorld();
+    rig_from_world.translation() =
+        -(rig_from_world.rotation() * centers.at(frame_id));
+  }
+
+  LOG(INFO) << "Estimated positions of " << new_frame_ids.size()
+            << " new frames";
+
+  return true;
+}
+
+bool GlobalMapper::ExtendStructure(const GlobalMapperOptions& options) {
+  THROW_CHECK_NOTNULL(reconstruction_);
+  THROW_CHECK_NOTNULL(pose_graph_);
+
+  std::vector<image_t> new_image_ids;
+  std::unordered_set<frame_t> anchor_frame_ids;
+  for (const frame_t frame_id : reconstruction_->RegFrameIds()) {
+    if (existing_frame_ids_.count(frame_id)) {
+      continue;
+    }
+    for (const auto& data_id : reconstruction_->Frame(frame_id).ImageIds()) {
+      new_image_ids.push_back(data_id.id);
+    }
+  }
+  if (new_image_ids.empty()) {
+    return true;
+  }
+  for (const ExtensionEdge& edge :
+       CollectExtensionEdges(*pose_graph_,
+                             *reconstruction_,
+                             existing_frame_ids_,
+                             /*registered_only=*/true)) {
+    for (const frame_t frame_id : {edge.frame_id1, edge.frame_id2}) {
+      if (existing_frame_ids_.count(frame_id)) {
+        anchor_frame_ids.insert(frame_id);
+      }
+    }
+  }
+
+  IncrementalMapper mapper(database_cache_);
+  mapper.BeginReconstruction(reconstruction_);
+
+  const IncrementalTriangulator::Options tri_options =
+      options.Retriangulation();
+  for (const image_t image_id : new_image_ids) {
+    mapper.TriangulateImage(tri_options, image_id);
+  }
+
+  // Bundle adjustment scoped to the new frames, with the connected existing
+  // frames and the cameras of existing frames held constant.
+  BundleAdjustmentConfig ba_config;
+  for (const image_t image_id : new_image_ids) {
+    ba_config.AddImage(image_id);
+  }
+  for (const frame_t frame_id : anchor_frame_ids) {
+    for (const auto& data_id : reconstruction_->Frame(frame_id).ImageIds()) {
+      ba_config.AddImage(data_id.id);
+    }
+    ba_config.SetConstantRigFromWorldPose(frame_id);
+  }
+  std::unordered_set<camera_t> existing_camera_ids;
+  for (const frame_t frame_id : existing_frame_ids_) {
+    for (const auto& data_id : reconstruction_->Frame(frame_id).ImageIds()) {
+      existing_camera_ids.insert(reconstruction_->Image(data_id.id).CameraId());
+    }
+  }
+  for (const image_t image_id : ba_config.Images()) {
+    const camera_t camera_id = reconstruction_->Image(image_id).CameraId();
+    if (existing_camera_ids.count(camera_id)) {
+      ba_config.SetConstantCamIntrinsics(camera_id);
+    }
+  }
+
+  BundleAdjustmentOptions ba_options = options.BundleAdjustment();
+  ba_options.refine_sensor_from_rig = false;
+
+  bool success = true;
+  for (int iter = 0; iter < options.ba_num_iterations; ++iter) {
+    auto ba =
+        CreateDefaultBundleAdjuster(ba_options, ba_config, *reconstruction_);
+    if (!ba->Solve()->IsSolutionUsable()) {
+      success = false;
+      break;
+    }
+
+    std::unordered_set<point3D_t> point3D_ids;
+    for (const image_t image_id : new_image_ids) {
+      const Image& image = reconstruction_->Image(image_id);
+      for (const Point2D& point2D : image.Points2D()) {
+        if (point2D.HasPoint3D()) {
+          point3D_ids.insert(point2D.point3D_id);
+        }
+      }
+    }
+    const size_t num_filtered =
+        mapper.ObservationManager().FilterPoints3DWithLargeReprojectionError(
+            options.max_normalized_reproj_error,
+            point3D_ids,
+            ReprojectionErrorType::NORMALIZED) +
+        mapper.ObservationManager().FilterPoints3DWithSmallTriangulationAngle(
+            options.min_tri_angle_deg, point3D_ids);
+    LOG(INFO) << "Scoped bundle adjustment iteration " << iter + 1 << " / "
+              << options.ba_num_iterations << ", filtered " << num_filtered
+              << " observations";
+    if (num_filtered == 0) {
+      break;
+    }
+  }
+
+  mapper.EndReconstruction(/*discard=*/false);
+
+  return success;
+}
+
+bool GlobalMapper::SolveExtension(const GlobalMapperOptions& options,
+                                  const std::function<bool()>& on_progress) {
+  LOG(INFO) << "Extending reconstruction with " << existing_frame_ids_.size()
+            << " registered frames";
+
+  if (!options.skip_rotation_averaging) {
+    LOG_HEADING1("Running rotation averaging of new frames");
+    Timer run_timer;
+    run_timer.Start();
+    if (!ExtendRotations(options.RotationAveraging())) {
+      return false;
+    }
+    LOG(INFO) << "Rotation averaging done in " << run_timer.ElapsedSeconds()
+              << " seconds";
+  }
+
+  if (!options.skip_global_positioning) {
+    LOG_HEADING1("Running global positioning of new frames");
+    Timer run_timer;
+    run_timer.Start();
+    if (!ExtendPositions(options.GlobalPositioning())) {
+      return false;
+    }
+    LOG(INFO) << "Global positioning done in " << run_timer.ElapsedSeconds()
+              << " seconds";
+  }
+
+  if (!options.skip_bundle_adjustment) {
+    LOG_HEADING1("Running scoped bundle adjustment of new frames");
+    Timer run_timer;
+    run_timer.Start();
+    if (!ExtendStructure(options)) {
+      return false;
+    }
+    LOG(INFO) << "Scoped bundle adjustment done in "
+              << run_timer.ElapsedSeconds() << " seconds";
+  }
+
+  reconstruction_->UpdatePoint3DErrors();
+  if (on_progress) {
+    on_progress();
+  }
+
+  return true;
+}
+
 bool GlobalMapper::IterativeRetriangulateAndRefine(
     const IncrementalTriangulator::Options& options,
     const BundleAdjustmentOptions& ba_options,
     double max_normalized_reproj_error,
     double min_tri_angle_deg) {
+  COLMAP_TRACE_ZONE("IterativeRetriangulateAndRefine");
   // Delete all existing 3D points and re-establish 2D-3D correspondences.
   reconstruction_->DeleteAllPoints2DAndPoints3D();
 
@@ -502,6 +1199,15 @@ bool GlobalMapper::Solve(const GlobalMapperOptions& options,
     return false;
   }
 
+  if (options.deterministic && options.random_seed < 0) {
+    LOG(WARNING) << "Deterministic mode requires random_seed >= 0, results "
+                    "will vary between runs";
+  }
+
+  if (options.extend_reconstruction && !existing_frame_ids_.empty()) {
+    return SolveExtension(options, on_progress);
+  }
+
   // Reports the current reconstruction and returns whether a stop was
   // requested. Point errors are recomputed in pixels before reporting because
   // the preceding filter passes leave point3D.error in normalized units, which
@@ -515,6 +1221,12 @@ bool GlobalMapper::Solve(const GlobalMapperOptions& options,
     return on_progress();
   };
 
+  // Pose graph sparsification
+  if (options.max_pose_graph_degree < std::numeric_limits<int>::max()) {
+    LOG_HEADING1("Running pose graph sparsification");
+    pose_graph_->Sparsify(options.max_pose_graph_degree);
+  }
+
   // Run rotation averaging
   if (!options.skip_rotation_averaging) {
     LOG_HEADING1("Running rotation averaging");
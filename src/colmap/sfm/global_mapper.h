@@ -11,6 +11,7 @@
 #include <filesystem>
 #include <functional>
 #include <limits>
+#include <unordered_set>
 
 namespace colmap {
 
@@ -24,6 +25,14 @@ struct GlobalMapperOptions {
   // seed.
   int random_seed = -1;
 
+  // Whether to produce bit-identical results independent of the number of
+  // threads, which requires random_seed >= 0. The parallel stages of the
+  // mapper derive their results from stable image, pair, and track ids, but
+  // the parallel reductions inside Ceres depend on the number of threads. In
+  // this mode, all Ceres problems are solved single-threaded on the CPU, while
+  // the other stages still run in parallel.
+  bool deterministic = false;
+
   // The image path at which to find the images to extract point colors.
   // If not specified, all point colors will be black.
   std::filesystem::path image_path;
@@ -60,6 +69,13 @@ struct GlobalMapperOptions {
     return opts;
   }();
 
+  // Maximum number of valid pose graph edges per image. If limited, the pose
+  // graph is sparsified before rotation averaging by keeping a maximum
+  // spanning forest on the number of matches and the remaining edges with the
+  // most matches up to this degree. The dropped edges are also not used for
+  // track establishment. By default, there is no limit.
+  int max_pose_graph_degree = std::numeric_limits<int>::max();
+
   // Track establishment options.
   // Max pixel distance between observations of the same track within one image.
   double track_intra_image_consistency_threshold = 10.;
@@ -96,6 +112,14 @@ struct GlobalMapperOptions {
   // ba_skip_fixed_rotation_stage.
   bool ba_skip_joint_optimization_stage = false;
 
+  // Whether to extend the registered frames of the reconstruction passed to
+  // BeginReconstruction instead of solving from scratch. If enabled, the
+  // existing frame poses are held fixed, and rotations and positions are only
+  // averaged for the unregistered frames connected to them, using the image
+  // pairs involving these frames. This is followed by bundle adjustment of the
+  // new frames and their directly connected existing frames.
+  bool extend_reconstruction = false;
+
   // Control the flow of the global sfm
   bool skip_rotation_averaging = false;
   bool skip_track_establishment = false;
@@ -122,13 +146,18 @@ class GlobalMapper {
   // after global positioning, after each bundle-adjustment iteration, and after
   // retriangulation/refinement; it returns true if a stop has been requested,
   // in which case the pipeline terminates early and keeps the current result.
+  // If options.extend_reconstruction is set and frames were registered at
+  // BeginReconstruction, only the new frames are estimated using
+  // ExtendRotations, ExtendPositions, and ExtendStructure.
   bool Solve(const GlobalMapperOptions& options,
              const std::function<bool()>& on_progress = {});
 
   // Run rotation averaging to estimate global rotations.
   bool RotationAveraging(const RotationEstimatorOptions& options);
 
-  // Establish tracks from feature matches.
+  // Establish tracks from feature matches. Observations are united in
+  // parallel using compact 32-bit ids, and short or inconsistent tracks are
+  // discarded before any 3D points are materialized.
   void EstablishTracks(const GlobalMapperOptions& options);
 
   // Estimate global camera positions.
@@ -148,6 +177,23 @@ class GlobalMapper {
                                  bool skip_joint_optimization_stage = false,
                                  const std::function<bool()>& on_progress = {});
 
+  // Estimate the rotations of the unregistered frames connected to the frames
+  // registered at BeginReconstruction, which are held fixed. The rotations are
+  // initialized along a maximum spanning tree and refined by robust rotation
+  // averaging over the image pairs involving the new frames. Image pairs with
+  // large rotation error are marked as invalid.
+  bool ExtendRotations(const RotationEstimatorOptions& options);
+
+  // Estimate the positions of the frames registered since BeginReconstruction
+  // from the relative translation directions of their image pairs, while the
+  // positions of the previously registered frames are held fixed.
+  bool ExtendPositions(const GlobalPositionerOptions& options);
+
+  // Triangulate the frames registered since BeginReconstruction and refine
+  // them in a bundle adjustment that is scoped to the new frames and their
+  // directly connected existing frames, which are held fixed.
+  bool ExtendStructure(const GlobalMapperOptions& options);
+
   // Iteratively retriangulate tracks and refine to improve structure.
   bool IterativeRetriangulateAndRefine(
       const IncrementalTriangulator::Options& options,
@@ -159,9 +205,16 @@ class GlobalMapper {
   std::shared_ptr<class Reconstruction> Reconstruction() const;
 
  private:
+  // Run the pipeline stages of the extension mode.
+  bool SolveExtension(const GlobalMapperOptions& options,
+                      const std::function<bool()>& on_progress);
+
   std::shared_ptr<const DatabaseCache> database_cache_;
   std::shared_ptr<class PoseGraph> pose_graph_;
   std::shared_ptr<class Reconstruction> reconstruction_;
+
+  // Frames registered at the time of BeginReconstruction.
+  std::unordered_set<frame_t> existing_frame_ids_;
 };
 
 }  // namespace colmap
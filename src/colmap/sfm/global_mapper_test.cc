@@ -3,6 +3,7 @@
 #include "colmap/scene/database_cache.h"
 #include "colmap/scene/reconstruction_matchers.h"
 #include "colmap/scene/synthetic.h"
+#include "colmap/sfm/observation_manager.h"
 #include "colmap/util/testing.h"
 
 #include <gtest/gtest.h>
@@ -152,6 +153,66 @@ TEST(GlobalMapper, WithNoiseAndOutliers) {
                                  /*num_obs_tolerance=*/0.02));
 }
 
+TEST(GlobalMapper, ExtendReconstruction) {
+  SetPRNGSeed(1);
+  const auto database_path = CreateTestDir() / "database.db";
+
+  auto database = Database::Open(database_path);
+  Reconstruction gt_reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 7;
+  synthetic_dataset_options.num_points3D = 50;
+  synthetic_dataset_options.two_view_geometry_has_relative_pose = true;
+  SynthesizeDataset(
+      synthetic_dataset_options, &gt_reconstruction, database.get());
+
+  // Start from the ground truth with the last frames removed.
+  auto reconstruction = std::make_shared<Reconstruction>(gt_reconstruction);
+  std::vector<frame_t> frame_ids = reconstruction->RegFrameIds();
+  std::sort(frame_ids.begin(), frame_ids.end());
+  const std::vector<frame_t> new_frame_ids(frame_ids.end() - 3,
+                                           frame_ids.end());
+  {
+    ObservationManager obs_manager(*reconstruction);
+    for (const frame_t frame_id : new_frame_ids) {
+      obs_manager.DeRegisterFrame(frame_id);
+    }
+  }
+  std::unordered_map<frame_t, Rigid3d> existing_rigs_from_world;
+  for (const frame_t frame_id : reconstruction->RegFrameIds()) {
+    existing_rigs_from_world.emplace(
+        frame_id, reconstruction->Frame(frame_id).RigFromWorld());
+  }
+
+  GlobalMapper global_mapper(CreateDatabaseCache(*database));
+  global_mapper.BeginReconstruction(reconstruction);
+
+  GlobalMapperOptions options;
+  options.extend_reconstruction = true;
+  ASSERT_TRUE(global_mapper.Solve(options));
+
+  EXPECT_EQ(reconstruction->NumRegFrames(), gt_reconstruction.NumRegFrames());
+  for (const auto& [frame_id, rig_from_world] : existing_rigs_from_world) {
+    EXPECT_EQ(reconstruction->Frame(frame_id).RigFromWorld(), rig_from_world);
+  }
+  for (const frame_t frame_id : new_frame_ids) {
+    const Rigid3d& rig_from_world =
+        reconstruction->Frame(frame_id).RigFromWorld();
+    const Rigid3d& gt_rig_from_world =
+        gt_reconstruction.Frame(frame_id).RigFromWorld();
+    EXPECT_LT(RadToDeg(rig_from_world.rotation().angularDistance(
+                  gt_rig_from_world.rotation())),
+              1e-2);
+    EXPECT_LT((rig_from_world.TgtOriginInSrc() -
+               gt_rig_from_world.TgtOriginInSrc())
+                  .norm(),
+              1e-2);
+  }
+  EXPECT_GT(reconstruction->NumPoints3D(), 0);
+}
+
 TEST(GlobalMapperOptions, RefineSensorFromRigPropagatesToSubOptions) {
   GlobalMapperOptions options;
   options.refine_sensor_from_rig = false;
@@ -34,13 +34,193 @@
 #include "colmap/estimators/generalized_pose.h"
 #include "colmap/estimators/pose.h"
 #include "colmap/estimators/triangulation.h"
+#include "colmap/scene/projection.h"
 #include "colmap/scene/reconstruction_pruning.h"
 #include "colmap/sfm/incremental_mapper_impl.h"
+#include "colmap/util/endian.h"
+#include "colmap/util/metrics.h"
+#include "colmap/util/threading.h"
+#include "colmap/util/tracing.h"
 
+#include <algorithm>
 #include <array>
+#include <functional>
 
 namespace colmap {
 
+namespace {
+
+// Version of the binary mapper state format.
+constexpr uint32_t kMapperStateVersion = 1;
+
+template <typename T>
+void WriteSet(std::ostream& stream, const std::unordered_set<T>& set) {
+  WriteBinaryLittleEndian<uint64_t>(&stream, set.size());
+  for (const T& value : set) {
+    WriteBinaryLittleEndian<T>(&stream, value);
+  }
+}
+
+template <typename T>
+std::unordered_set<T> ReadSet(std::istream& stream) {
+  const uint64_t size = ReadBinaryLittleEndian<uint64_t>(&stream);
+  std::unordered_set<T> set;
+  set.reserve(size);
+  for (uint64_t i = 0; i < size; ++i) {
+    set.insert(ReadBinaryLittleEndian<T>(&stream));
+  }
+  return set;
+}
+
+// Writes the values in a fixed-size type to be platform independent.
+template <typename K, typename V, typename StoredV = V>
+void WriteMap(std::ostream& stream, const std::unordered_map<K, V>& map) {
+  WriteBinaryLittleEndian<uint64_t>(&stream, map.size());
+  for (const auto& [key, value] : map) {
+    WriteBinaryLittleEndian<K>(&stream, key);
+    WriteBinaryLittleEndian<StoredV>(&stream, static_cast<StoredV>(value));
+  }
+}
+
+template <typename K, typename V, typename StoredV = V>
+std::unordered_map<K, V> ReadMap(std::istream& stream) {
+  const uint64_t size = ReadBinaryLittleEndian<uint64_t>(&stream);
+  std::unordered_map<K, V> map;
+  map.reserve(size);
+  for (uint64_t i = 0; i < size; ++i) {
+    const K key = ReadBinaryLittleEndian<K>(&stream);
+    map.emplace(key, static_cast<V>(ReadBinaryLittleEndian<StoredV>(&stream)));
+  }
+  return map;
+}
+
+// Find the 2D-3D correspondences between the points of an unregistered image
+// and the triangulated points of the registered images.
+void FindTri2D3DCorrespondences(
+    const IncrementalMapper::Options& options,
+    const Reconstruction& reconstruction,
+    const CorrespondenceGraph& correspondence_graph,
+    const image_t image_id,
+    std::vector<std::pair<point2D_t, point3D_t>>* tri_corrs,
+    std::vector<Eigen::Vector2d>* tri_points2D,
+    std::vector<Eigen::Vector3d>* tri_points3D) {
+  const Image& image = reconstruction.Image(image_id);
+
+  std::unordered_set<point3D_t> corr_point3D_ids;
+  for (point2D_t point2D_idx = 0; point2D_idx < image.NumPoints2D();
+       ++point2D_idx) {
+    const Point2D& point2D = image.Point2D(point2D_idx);
+
+    corr_point3D_ids.clear();
+    const auto corr_range =
+        correspondence_graph.FindCorrespondences(image_id, point2D_idx);
+    for (const auto* corr = corr_range.beg; corr < corr_range.end; ++corr) {
+      const Image& corr_image = reconstruction.Image(corr->image_id);
+      if (!corr_image.HasPose()) {
+        continue;
+      }
+
+      const Point2D& corr_point2D = corr_image.Point2D(corr->point2D_idx);
+      if (!corr_point2D.HasPoint3D()) {
+        continue;
+      }
+
+      // Avoid duplicate correspondences.
+      if (corr_point3D_ids.count(corr_point2D.point3D_id) > 0) {
+        continue;
+      }
+
+      const Camera& corr_camera = *corr_image.CameraPtr();
+
+      // Avoid correspondences to images with bogus camera parameters.
+      if (corr_camera.HasBogusParams(options.min_focal_length_ratio,
+                                     options.max_focal_length_ratio,
+                                     options.max_extra_param)) {
+        continue;
+      }
+
+      const Point3D& point3D = reconstruction.Point3D(corr_point2D.point3D_id);
+
+      tri_corrs->emplace_back(point2D_idx, corr_point2D.point3D_id);
+      corr_point3D_ids.insert(corr_point2D.point3D_id);
+      tri_points2D->push_back(point2D.xy);
+      tri_points3D->push_back(point3D.xyz);
+    }
+  }
+}
+
+// Configure the absolute pose estimation and refinement for the camera of the
+// next image. If the camera was not refined from another image before, its
+// parameters are reset to the database values to be re-estimated.
+void SetupNextImagePoseEstimation(
+    const IncrementalMapper::Options& options,
+    const Camera& database_camera,
+    const std::unordered_map<camera_t, size_t>& num_reg_images_per_camera,
+    Camera& camera,
+    AbsolutePoseEstimationOptions* abs_pose_options,
+    AbsolutePoseRefinementOptions* abs_pose_refinement_options) {
+  // Note that we use single-threaded RANSAC here, because benchmarking showed
+  // no significant speedup for multi-threaded RANSAC here (as opposed to the
+  // generalized absolute pose estimation).
+  abs_pose_options->ransac_options.max_error = options.abs_pose_max_error;
+  abs_pose_options->ransac_options.min_inlier_ratio =
+      options.abs_pose_min_inlier_ratio;
+  abs_pose_options->ransac_options.random_seed = options.random_seed;
+
+  if (options.constant_cameras.count(camera.camera_id) > 0) {
+    abs_pose_options->estimate_focal_length = false;
+    abs_pose_refinement_options->refine_focal_length = false;
+    abs_pose_refinement_options->refine_extra_params = false;
+    return;
+  }
+
+  const auto num_reg_images_it =
+      num_reg_images_per_camera.find(camera.camera_id);
+  if (num_reg_images_it != num_reg_images_per_camera.end() &&
+      num_reg_images_it->second > 0) {
+    // Camera already refined from another image with the same camera.
+    if (camera.HasBogusParams(options.min_focal_length_ratio,
+                              options.max_focal_length_ratio,
+                              options.max_extra_param)) {
+      abs_pose_options->estimate_focal_length = !camera.has_prior_focal_length;
+      abs_pose_refinement_options->refine_focal_length = true;
+      abs_pose_refinement_options->refine_extra_params = true;
+    } else {
+      abs_pose_options->estimate_focal_length = false;
+      abs_pose_refinement_options->refine_focal_length = false;
+      abs_pose_refinement_options->refine_extra_params = false;
+    }
+  } else {
+    // Camera not refined before. Note that the camera parameters might have
+    // been changed before but the image was filtered, so we explicitly reset
+    // the camera parameters and try to re-estimate them.
+    camera.params = database_camera.params;
+    abs_pose_options->estimate_focal_length = !camera.has_prior_focal_length;
+    abs_pose_refinement_options->refine_focal_length = true;
+    abs_pose_refinement_options->refine_extra_params = true;
+  }
+
+  if (!options.abs_pose_refine_focal_length) {
+    abs_pose_options->estimate_focal_length = false;
+    abs_pose_refinement_options->refine_focal_length = false;
+  }
+
+  if (!options.abs_pose_refine_extra_params) {
+    abs_pose_refinement_options->refine_extra_params = false;
+  }
+
+  // Omnidirectional cameras (e.g. EQUIRECTANGULAR) have no focal length, and
+  // their parameters (e.g. image dimensions) are not distortion coefficients
+  // to be refined during registration.
+  if (!camera.IsPerspective()) {
+    abs_pose_options->estimate_focal_length = false;
+    abs_pose_refinement_options->refine_focal_length = false;
+    abs_pose_refinement_options->refine_extra_params = false;
+  }
+}
+
+}  // namespace
+
 bool IncrementalMapper::Options::Check() const {
   CHECK_OPTION_GT(init_min_num_inliers, 0);
   CHECK_OPTION_GT(init_max_error, 0.0);
@@ -61,6 +241,7 @@ bool IncrementalMapper::Options::Check() const {
   CHECK_OPTION_GE(filter_max_reproj_error, 0.0);
   CHECK_OPTION_GE(filter_min_tri_angle, 0.0);
   CHECK_OPTION_GE(max_reg_trials, 1);
+  CHECK_OPTION_GE(lazy_points2D_cache_size, 0.0);
   CHECK_OPTION_GE(num_threads, -1);
   CHECK_OPTION_GE(random_seed, -1);
   return true;
@@ -97,6 +278,7 @@ void IncrementalMapper::BeginReconstruction(
   filtered_frames_.clear();
   reg_stats_.num_reg_trials.clear();
   reg_stats_.num_structure_less_reg_trials.clear();
+  lazy_points2D_last_use_.clear();
 }
 
 void IncrementalMapper::EndReconstruction(const bool discard) {
@@ -112,6 +294,8 @@ void IncrementalMapper::EndReconstruction(const bool discard) {
     }
   }
 
+  local_bundle_adjuster_.reset();
+  global_bundle_adjuster_.reset();
   triangulator_.reset();
   obs_manager_.reset();
   reconstruction_->TearDown();
@@ -129,6 +313,7 @@ bool IncrementalMapper::FindInitialImagePair(const Options& options,
       reg_stats_.init_num_reg_trials,
       reg_stats_.num_registrations,
       reg_stats_.init_image_pairs,
+      reg_stats_.init_rejected_pair_stats,
       image_id1,
       image_id2,
       cam2_from_cam1);
@@ -136,6 +321,45 @@ bool IncrementalMapper::FindInitialImagePair(const Options& options,
 
 std::vector<image_t> IncrementalMapper::FindNextImages(const Options& options,
                                                        bool structure_less) {
+  if (database_cache_->HasLazyPoints2D() && !structure_less) {
+    // Release the points2D of images that can no longer be registered and
+    // load them for the candidates, whose rank depends on their visibility
+    // pyramid in case of the minimum uncertainty criterion.
+    const bool rank_by_uncertainty =
+        options.image_selection_method ==
+        Options::ImageSelectionMethod::MIN_UNCERTAINTY;
+    const uint64_t min_last_use = lazy_points2D_use_counter_ + 1;
+    const auto has_exhausted_reg_trials = [&](const image_t image_id) {
+      const auto it = reg_stats_.num_reg_trials.find(image_id);
+      return it != reg_stats_.num_reg_trials.end() &&
+             it->second >= static_cast<size_t>(options.max_reg_trials);
+    };
+    // Only the unregistered images with loaded points2D can be released and
+    // only the unregistered images that see triangulated points can be
+    // candidates, so neither pass needs to scan all images.
+    std::vector<image_t> release_image_ids;
+    for (const auto& [image_id, _] : lazy_points2D_last_use_) {
+      if (has_exhausted_reg_trials(image_id)) {
+        release_image_ids.push_back(image_id);
+      }
+    }
+    for (const image_t image_id : release_image_ids) {
+      ReleasePoints2D(image_id);
+    }
+    if (rank_by_uncertainty) {
+      for (const image_t image_id :
+           obs_manager_->UnregisteredVisibleImageIds()) {
+        if (!reconstruction_->Image(image_id).HasPose() &&
+            !has_exhausted_reg_trials(image_id) &&
+            obs_manager_->NumVisiblePoints3D(image_id) >=
+                static_cast<size_t>(options.abs_pose_min_num_inliers)) {
+          MaterializePoints2D(image_id);
+        }
+      }
+    }
+    LimitLazyPoints2D(options, min_last_use);
+  }
+
   return IncrementalMapperImpl::FindNextImages(
       options,
       *obs_manager_,
@@ -167,6 +391,8 @@ void IncrementalMapper::RegisterInitialImagePair(
 
   Image& image1 = reconstruction_->Image(image_id1);
   Image& image2 = reconstruction_->Image(image_id2);
+  MaterializeFramePoints2D(image1.FrameId());
+  MaterializeFramePoints2D(image2.FrameId());
 
   //////////////////////////////////////////////////////////////////////////////
   // Apply two-view geometry
@@ -187,6 +413,7 @@ void IncrementalMapper::RegisterInitialImagePair(
 
 bool IncrementalMapper::RegisterNextImage(const Options& options,
                                           const image_t image_id) {
+  COLMAP_TRACE_ZONE("RegisterNextImage");
   THROW_CHECK_NOTNULL(reconstruction_);
   THROW_CHECK_NOTNULL(obs_manager_);
   THROW_CHECK_GT(reconstruction_->NumRegFrames(), 0);
@@ -194,6 +421,7 @@ bool IncrementalMapper::RegisterNextImage(const Options& options,
 
   Image& image = reconstruction_->Image(image_id);
   Camera& camera = *image.CameraPtr();
+  MaterializeFramePoints2D(image.FrameId());
 
   for (const auto& [_, sensor_from_rig] :
        image.FramePtr()->RigPtr()->NonRefSensors()) {
@@ -243,52 +471,13 @@ bool IncrementalMapper::RegisterNextImage(const Options& options,
   std::vector<std::pair<point2D_t, point3D_t>> tri_corrs;
   std::vector<Eigen::Vector2d> tri_points2D;
   std::vector<Eigen::Vector3d> tri_points3D;
-
-  const std::shared_ptr<const CorrespondenceGraph> correspondence_graph =
-      database_cache_->CorrespondenceGraph();
-
-  std::unordered_set<point3D_t> corr_point3D_ids;
-  for (point2D_t point2D_idx = 0; point2D_idx < image.NumPoints2D();
-       ++point2D_idx) {
-    const Point2D& point2D = image.Point2D(point2D_idx);
-
-    corr_point3D_ids.clear();
-    const auto corr_range =
-        correspondence_graph->FindCorrespondences(image_id, point2D_idx);
-    for (const auto* corr = corr_range.beg; corr < corr_range.end; ++corr) {
-      const Image& corr_image = reconstruction_->Image(corr->image_id);
-      if (!corr_image.HasPose()) {
-        continue;
-      }
-
-      const Point2D& corr_point2D = corr_image.Point2D(corr->point2D_idx);
-      if (!corr_point2D.HasPoint3D()) {
-        continue;
-      }
-
-      // Avoid duplicate correspondences.
-      if (corr_point3D_ids.count(corr_point2D.point3D_id) > 0) {
-        continue;
-      }
-
-      const Camera& corr_camera = *corr_image.CameraPtr();
-
-      // Avoid correspondences to images with bogus camera parameters.
-      if (corr_camera.HasBogusParams(options.min_focal_length_ratio,
-                                     options.max_focal_length_ratio,
-                                     options.max_extra_param)) {
-        continue;
-      }
-
-      const Point3D& point3D =
-          reconstruction_->Point3D(corr_point2D.point3D_id);
-
-      tri_corrs.emplace_back(point2D_idx, corr_point2D.point3D_id);
-      corr_point3D_ids.insert(corr_point2D.point3D_id);
-      tri_points2D.push_back(point2D.xy);
-      tri_points3D.push_back(point3D.xyz);
-    }
-  }
+  FindTri2D3DCorrespondences(options,
+                             *reconstruction_,
+                             *database_cache_->CorrespondenceGraph(),
+                             image_id,
+                             &tri_corrs,
+                             &tri_points2D,
+                             &tri_points3D);
 
   // The size of `next_image.num_tri_obs` and `tri_corrs_point2D_idxs.size()`
   // can only differ, when there are images with bogus camera parameters, and
@@ -308,63 +497,14 @@ bool IncrementalMapper::RegisterNextImage(const Options& options,
   // Only refine / estimate focal length, if no focal length was specified
   // (manually or through EXIF) and if it was not already estimated previously
   // from another image (when multiple images share the same camera parameters).
-
-  // Note that we use single-threaded RANSAC here, because benchmarking showed
-  // no significant speedup for multi-threaded RANSAC here (as opposed to the
-  // generalized absolute pose estimation).
   AbsolutePoseEstimationOptions abs_pose_options;
-  abs_pose_options.ransac_options.max_error = options.abs_pose_max_error;
-  abs_pose_options.ransac_options.min_inlier_ratio =
-      options.abs_pose_min_inlier_ratio;
-  abs_pose_options.ransac_options.random_seed = options.random_seed;
-
   AbsolutePoseRefinementOptions abs_pose_refinement_options;
-  if (options.constant_cameras.count(image.CameraId()) > 0) {
-    abs_pose_options.estimate_focal_length = false;
-    abs_pose_refinement_options.refine_focal_length = false;
-    abs_pose_refinement_options.refine_extra_params = false;
-  } else {
-    if (reg_stats_.num_reg_images_per_camera[image.CameraId()] > 0) {
-      // Camera already refined from another image with the same camera.
-      if (camera.HasBogusParams(options.min_focal_length_ratio,
-                                options.max_focal_length_ratio,
-                                options.max_extra_param)) {
-        abs_pose_options.estimate_focal_length = !camera.has_prior_focal_length;
-        abs_pose_refinement_options.refine_focal_length = true;
-        abs_pose_refinement_options.refine_extra_params = true;
-      } else {
-        abs_pose_options.estimate_focal_length = false;
-        abs_pose_refinement_options.refine_focal_length = false;
-        abs_pose_refinement_options.refine_extra_params = false;
-      }
-    } else {
-      // Camera not refined before. Note that the camera parameters might have
-      // been changed before but the image was filtered, so we explicitly reset
-      // the camera parameters and try to re-estimate them.
-      camera.params = database_cache_->Camera(image.CameraId()).params;
-      abs_pose_options.estimate_focal_length = !camera.has_prior_focal_length;
-      abs_pose_refinement_options.refine_focal_length = true;
-      abs_pose_refinement_options.refine_extra_params = true;
-    }
-
-    if (!options.abs_pose_refine_focal_length) {
-      abs_pose_options.estimate_focal_length = false;
-      abs_pose_refinement_options.refine_focal_length = false;
-    }
-
-    if (!options.abs_pose_refine_extra_params) {
-      abs_pose_refinement_options.refine_extra_params = false;
-    }
-
-    // Omnidirectional cameras (e.g. EQUIRECTANGULAR) have no focal length, and
-    // their parameters (e.g. image dimensions) are not distortion coefficients
-    // to be refined during registration.
-    if (!camera.IsPerspective()) {
-      abs_pose_options.estimate_focal_length = false;
-      abs_pose_refinement_options.refine_focal_length = false;
-      abs_pose_refinement_options.refine_extra_params = false;
-    }
-  }
+  SetupNextImagePoseEstimation(options,
+                               database_cache_->Camera(image.CameraId()),
+                               reg_stats_.num_reg_images_per_camera,
+                               camera,
+                               &abs_pose_options,
+                               &abs_pose_refinement_options);
 
   // If any of the cameras in the same rig has bogus cameras, reset them to the
   // original values from the database, so we have a chance of recovering from
@@ -444,6 +584,195 @@ bool IncrementalMapper::RegisterNextImage(const Options& options,
   return true;
 }
 
+std::vector<IncrementalMapper::NextImagePose>
+IncrementalMapper::EstimateNextImagePoses(
+    const Options& options, const std::vector<image_t>& image_ids) {
+  THROW_CHECK_NOTNULL(reconstruction_);
+  THROW_CHECK_NOTNULL(obs_manager_);
+  THROW_CHECK_GT(reconstruction_->NumRegFrames(), 0);
+  THROW_CHECK(options.Check());
+
+  // Update the mapper state before the concurrent estimation, which only
+  // reads from the reconstruction.
+  std::vector<NextImagePose> poses(image_ids.size());
+  for (size_t i = 0; i < image_ids.size(); ++i) {
+    const Image& image = reconstruction_->Image(image_ids[i]);
+    THROW_CHECK(!image.HasPose());
+    THROW_CHECK_EQ(image.FramePtr()->RigPtr()->NumSensors(), 1)
+        << "Speculative registration only implemented for trivial frames";
+    MaterializeFramePoints2D(image.FrameId());
+    reg_stats_.num_reg_trials[image_ids[i]] += 1;
+    poses[i].image_id = image_ids[i];
+  }
+
+  const std::shared_ptr<const CorrespondenceGraph> correspondence_graph =
+      database_cache_->CorrespondenceGraph();
+  const size_t min_num_inliers =
+      static_cast<size_t>(options.abs_pose_min_num_inliers);
+
+  auto estimate_pose = [&](NextImagePose& pose) {
+    if (obs_manager_->NumVisiblePoints3D(pose.image_id) < min_num_inliers) {
+      return;
+    }
+
+    std::vector<std::pair<point2D_t, point3D_t>> tri_corrs;
+    std::vector<Eigen::Vector2d> tri_points2D;
+    std::vector<Eigen::Vector3d> tri_points3D;
+    FindTri2D3DCorrespondences(options,
+                               *reconstruction_,
+                               *correspondence_graph,
+                               pose.image_id,
+                               &tri_corrs,
+                               &tri_points2D,
+                               &tri_points3D);
+    if (tri_points2D.size() < min_num_inliers) {
+      return;
+    }
+
+    // Estimate the intrinsics on a copy of the camera, because the camera may
+    // be shared with the other concurrently estimated images.
+    const Image& image = reconstruction_->Image(pose.image_id);
+    const Camera& database_camera = database_cache_->Camera(image.CameraId());
+    pose.camera = *image.CameraPtr();
+    pose.prev_camera_params = pose.camera.params;
+    AbsolutePoseEstimationOptions abs_pose_options;
+    AbsolutePoseRefinementOptions abs_pose_refinement_options;
+    SetupNextImagePoseEstimation(options,
+                                 database_camera,
+                                 reg_stats_.num_reg_images_per_camera,
+                                 pose.camera,
+                                 &abs_pose_options,
+                                 &abs_pose_refinement_options);
+    if (pose.camera.HasBogusParams(options.min_focal_length_ratio,
+                                   options.max_focal_length_ratio,
+                                   options.max_extra_param)) {
+      pose.camera.params = database_camera.params;
+    }
+
+    size_t num_inliers;
+    std::vector<char> inlier_mask;
+    if (!EstimateAbsolutePose(abs_pose_options,
+                              tri_points2D,
+                              tri_points3D,
+                              &pose.cam_from_world,
+                              &pose.camera,
+                              &num_inliers,
+                              &inlier_mask) ||
+        num_inliers < min_num_inliers ||
+        !RefineAbsolutePose(abs_pose_refinement_options,
+                            inlier_mask,
+                            tri_points2D,
+                            tri_points3D,
+                            &pose.cam_from_world,
+                            &pose.camera)) {
+      return;
+    }
+
+    pose.inlier_corrs.reserve(num_inliers);
+    for (size_t i = 0; i < inlier_mask.size(); ++i) {
+      if (inlier_mask[i]) {
+        pose.inlier_corrs.push_back(tri_corrs[i]);
+      }
+    }
+    pose.success = true;
+  };
+
+  const int num_threads = std::min<int>(
+      GetEffectiveNumThreads(options.num_threads), poses.size());
+  if (num_threads <= 1) {
+    for (NextImagePose& pose : poses) {
+      estimate_pose(pose);
+    }
+  } else {
+    ThreadPool thread_pool(num_threads);
+    for (NextImagePose& pose : poses) {
+      thread_pool.AddTask(estimate_pose, std::ref(pose));
+    }
+    thread_pool.Wait();
+  }
+
+  return poses;
+}
+
+bool IncrementalMapper::RegisterNextImage(const Options& options,
+                                          const NextImagePose& pose) {
+  COLMAP_TRACE_ZONE("RegisterNextImage");
+  THROW_CHECK_NOTNULL(reconstruction_);
+  THROW_CHECK_NOTNULL(obs_manager_);
+  THROW_CHECK(options.Check());
+
+  if (!pose.success) {
+    return false;
+  }
+
+  Image& image = reconstruction_->Image(pose.image_id);
+  if (image.HasPose()) {
+    return false;
+  }
+
+  MaterializeFramePoints2D(image.FrameId());
+
+  // Estimated intrinsics can only be applied, if the camera was not changed by
+  // other registrations or bundle adjustment since the estimation.
+  Camera& camera = *image.CameraPtr();
+  const bool update_camera = pose.camera.params != pose.prev_camera_params;
+  if (update_camera && camera.params != pose.prev_camera_params) {
+    VLOG(2) << "Camera changed since the speculative pose estimation";
+    return false;
+  }
+  const Camera& reg_camera = update_camera ? pose.camera : camera;
+
+  // Check that the inlier correspondences are still consistent with the
+  // current state of the reconstruction.
+  const double max_squared_error =
+      options.abs_pose_max_error * options.abs_pose_max_error;
+  std::vector<std::pair<point2D_t, point3D_t>> inlier_corrs;
+  inlier_corrs.reserve(pose.inlier_corrs.size());
+  for (const auto& [point2D_idx, point3D_id] : pose.inlier_corrs) {
+    if (reconstruction_->ExistsPoint3D(point3D_id) &&
+        CalculateSquaredReprojectionError(
+            image.Point2D(point2D_idx).xy,
+            reconstruction_->Point3D(point3D_id).xyz,
+            pose.cam_from_world,
+            reg_camera) <= max_squared_error) {
+      inlier_corrs.emplace_back(point2D_idx, point3D_id);
+    }
+  }
+
+  if (inlier_corrs.size() <
+      static_cast<size_t>(options.abs_pose_min_num_inliers)) {
+    VLOG(2) << "Speculative pose inconsistent with reconstruction ("
+            << inlier_corrs.size() << " < " << options.abs_pose_min_num_inliers
+            << " consistent inliers)";
+    return false;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Continue tracks
+  //////////////////////////////////////////////////////////////////////////////
+
+  VLOG(2) << "Continuing tracks for " << inlier_corrs.size()
+          << " inlier 2D-3D correspondences";
+
+  if (update_camera) {
+    camera.params = pose.camera.params;
+  }
+  image.FramePtr()->SetCamFromWorld(image.CameraId(), pose.cam_from_world);
+
+  obs_manager_->RegisterFrame(image.FrameId());
+  RegisterFrameEvent(image.FrameId());
+
+  for (const auto& [point2D_idx, point3D_id] : inlier_corrs) {
+    if (!image.Point2D(point2D_idx).HasPoint3D()) {
+      const TrackElement track_el(pose.image_id, point2D_idx);
+      obs_manager_->AddObservation(point3D_id, track_el);
+      triangulator_->AddModifiedPoint3D(point3D_id);
+    }
+  }
+
+  return true;
+}
+
 bool IncrementalMapper::RegisterNextGeneralFrame(const Options& options,
                                                  Frame& frame) {
   // Only call this method for frames with more than
@@ -455,77 +784,111 @@ bool IncrementalMapper::RegisterNextGeneralFrame(const Options& options,
     point3D_t point3D_id;
   };
 
-  std::vector<Corr> tri_corrs;
-  std::vector<Eigen::Vector2d> tri_points2D;
-  std::vector<Eigen::Vector3d> tri_points3D;
-  std::vector<size_t> tri_camera_idxs;
-
   std::vector<Rigid3d> cams_from_rig;
   cams_from_rig.reserve(frame.RigPtr()->NumSensors());
   std::vector<Camera> cameras;
   cameras.reserve(frame.RigPtr()->NumSensors());
 
-  const std::shared_ptr<const CorrespondenceGraph> correspondence_graph =
-      database_cache_->CorrespondenceGraph();
-
+  std::vector<image_t> image_ids;
+  image_ids.reserve(frame.RigPtr()->NumSensors());
   for (const data_t& data_id : frame.ImageIds()) {
     const image_t image_id = data_id.id;
-    const Image& image = reconstruction_->Image(image_id);
-    const Camera& camera = *image.CameraPtr();
-
-    const size_t camera_idx = cameras.size();
+    const Camera& camera = *reconstruction_->Image(image_id).CameraPtr();
     if (frame.RigPtr()->IsRefSensor(camera.SensorId())) {
       cams_from_rig.push_back(Rigid3d());
     } else {
       cams_from_rig.push_back(frame.RigPtr()->SensorFromRig(camera.SensorId()));
     }
     cameras.push_back(camera);
-
+    image_ids.push_back(image_id);
     reg_stats_.num_reg_trials[image_id] += 1;
+  }
 
-    std::unordered_set<point3D_t> corr_point3D_ids;
-    for (point2D_t point2D_idx = 0; point2D_idx < image.NumPoints2D();
-         ++point2D_idx) {
-      const Point2D& point2D = image.Point2D(point2D_idx);
-
-      corr_point3D_ids.clear();
-      const auto corr_range =
-          correspondence_graph->FindCorrespondences(image_id, point2D_idx);
-      for (const auto* corr = corr_range.beg; corr < corr_range.end; ++corr) {
-        const Image& corr_image = reconstruction_->Image(corr->image_id);
-        if (!corr_image.HasPose()) {
-          continue;
-        }
-
-        const Point2D& corr_point2D = corr_image.Point2D(corr->point2D_idx);
-        if (!corr_point2D.HasPoint3D()) {
-          continue;
-        }
-
-        // Avoid duplicate correspondences.
-        if (corr_point3D_ids.count(corr_point2D.point3D_id) > 0) {
-          continue;
-        }
-
-        const Camera& corr_camera = *corr_image.CameraPtr();
+  const std::shared_ptr<const CorrespondenceGraph> correspondence_graph =
+      database_cache_->CorrespondenceGraph();
 
-        // Avoid correspondences to images with bogus camera parameters.
-        if (corr_camera.HasBogusParams(options.min_focal_length_ratio,
-                                       options.max_focal_length_ratio,
-                                       options.max_extra_param)) {
-          continue;
+  // Gather the 2D-3D correspondences of the images of the frame in parallel,
+  // each into its own contiguous buffer. The reconstruction is only read here.
+  std::vector<std::vector<Corr>> image_corrs(image_ids.size());
+  ParallelFor(
+      0,
+      image_ids.size(),
+      [&](const int64_t begin, const int64_t end) {
+        std::vector<point3D_t> corr_point3D_ids;
+        for (int64_t camera_idx = begin; camera_idx < end; ++camera_idx) {
+          const image_t image_id = image_ids[camera_idx];
+          const Image& image = reconstruction_->Image(image_id);
+          std::vector<Corr>& corrs = image_corrs[camera_idx];
+          for (point2D_t point2D_idx = 0; point2D_idx < image.NumPoints2D();
+               ++point2D_idx) {
+            corr_point3D_ids.clear();
+            const auto corr_range =
+                correspondence_graph->FindCorrespondences(image_id,
+                                                          point2D_idx);
+            for (const auto* corr = corr_range.beg; corr < corr_range.end;
+                 ++corr) {
+              const Image& corr_image = reconstruction_->Image(corr->image_id);
+              if (!corr_image.HasPose()) {
+                continue;
+              }
+
+              const Point2D& corr_point2D =
+                  corr_image.Point2D(corr->point2D_idx);
+              if (!corr_point2D.HasPoint3D()) {
+                continue;
+              }
+
+              // Avoid duplicate correspondences. There are only few
+              // correspondences per point, so a linear search is fastest.
+              if (std::find(corr_point3D_ids.begin(),
+                            corr_point3D_ids.end(),
+                            corr_point2D.point3D_id) !=
+                  corr_point3D_ids.end()) {
+                continue;
+              }
+
+              const Camera& corr_camera = *corr_image.CameraPtr();
+
+              // Avoid correspondences to images with bogus camera parameters.
+              if (corr_camera.HasBogusParams(options.min_focal_length_ratio,
+                                             options.max_focal_length_ratio,
+                                             options.max_extra_param)) {
+                continue;
+              }
+
+              corrs.push_back(
+                  Corr{point2D_idx, image_id, corr_point2D.point3D_id});
+              corr_point3D_ids.push_back(corr_point2D.point3D_id);
+            }
+          }
         }
+      },
+      GetEffectiveNumThreads(options.num_threads),
+      /*grain_size=*/1);
 
-        const Point3D& point3D =
-            reconstruction_->Point3D(corr_point2D.point3D_id);
+  size_t num_corrs = 0;
+  for (const std::vector<Corr>& corrs : image_corrs) {
+    num_corrs += corrs.size();
+  }
 
-        tri_corrs.push_back(
-            Corr{point2D_idx, image_id, corr_point2D.point3D_id});
-        corr_point3D_ids.insert(corr_point2D.point3D_id);
-        tri_points2D.push_back(point2D.xy);
-        tri_points3D.push_back(point3D.xyz);
-        tri_camera_idxs.push_back(camera_idx);
-      }
+  std::vector<Corr> tri_corrs;
+  std::vector<Eigen::Vector2d> tri_points2D;
+  std::vector<Eigen::Vector3d> tri_points3D;
+  std::vector<point3D_t> tri_point3D_ids;
+  std::vector<size_t> tri_camera_idxs;
+  tri_corrs.reserve(num_corrs);
+  tri_points2D.reserve(num_corrs);
+  tri_points3D.reserve(num_corrs);
+  tri_point3D_ids.reserve(num_corrs);
+  tri_camera_idxs.reserve(num_corrs);
+  for (size_t camera_idx = 0; camera_idx < image_corrs.size(); ++camera_idx) {
+    const Image& image = reconstruction_->Image(image_ids[camera_idx]);
+    for (const Corr& corr : image_corrs[camera_idx]) {
+      tri_corrs.push_back(corr);
+      tri_points2D.push_back(image.Point2D(corr.point2D_idx).xy);
+      tri_points3D.push_back(reconstruction_->Point3D(corr.point3D_id).xyz);
+      tri_point3D_ids.push_back(corr.point3D_id);
+      tri_camera_idxs.push_back(camera_idx);
     }
   }
 
@@ -552,6 +915,9 @@ bool IncrementalMapper::RegisterNextGeneralFrame(const Options& options,
   abs_pose_options.max_error = options.abs_pose_max_error;
   abs_pose_options.min_inlier_ratio = options.abs_pose_min_inlier_ratio;
   abs_pose_options.random_seed = options.random_seed;
+  // Each trial of the generalized minimal solver is expensive, so we
+  // evaluate the hypotheses in parallel.
+  abs_pose_options.num_threads = options.num_threads;
 
   AbsolutePoseRefinementOptions abs_pose_refinement_options;
   abs_pose_refinement_options.refine_focal_length = false;
@@ -568,7 +934,8 @@ bool IncrementalMapper::RegisterNextGeneralFrame(const Options& options,
                                        cameras,
                                        &rig_from_world,
                                        &num_inliers,
-                                       &inlier_mask)) {
+                                       &inlier_mask,
+                                       &tri_point3D_ids)) {
     VLOG(2) << "Absolute pose estimation failed";
     return false;
   }
@@ -640,6 +1007,7 @@ bool IncrementalMapper::RegisterNextStructureLessImage(const Options& options,
 
   Image& image = reconstruction_->Image(image_id);
   Camera& camera = *image.CameraPtr();
+  MaterializeFramePoints2D(image.FrameId());
 
   //////////////////////////////////////////////////////////////////////////////
   // Search for structure-less correspondences
@@ -837,7 +1205,7 @@ bool IncrementalMapper::RegisterNextStructureLessImage(const Options& options,
       }
     }
 
-    if (continued_track) {
+    if (continued_track || !options.structure_less_triangulate) {
       continue;
     }
 
@@ -889,6 +1257,12 @@ bool IncrementalMapper::RegisterNextStructureLessImage(const Options& options,
     abs_pose_refinement_config.AddVariablePoint(point3D_id);
   }
 
+  // Without any continued or new tracks, there is no structure to refine the
+  // pose against.
+  if (image.NumPoints3D() == 0) {
+    return true;
+  }
+
   // Refine pose using triangulated 3D point structure.
   auto abs_pose_refinement =
       CreateDefaultBundleAdjuster(abs_pose_refinement_options,
@@ -906,17 +1280,30 @@ bool IncrementalMapper::RegisterNextStructureLessImage(const Options& options,
 size_t IncrementalMapper::TriangulateImage(
     const IncrementalTriangulator::Options& tri_options,
     const image_t image_id) {
+  TraceZone trace_zone("TriangulateImage");
   THROW_CHECK_NOTNULL(reconstruction_);
   VLOG(1) << "=> Existing observations: "
           << reconstruction_->Image(image_id).NumPoints3D();
   const size_t num_tris =
       triangulator_->TriangulateImage(tri_options, image_id);
   VLOG(1) << "=> Added observations: " << num_tris;
+  trace_zone.SetNumItems(num_tris);
+  return num_tris;
+}
+
+size_t IncrementalMapper::TriangulateAllImages(
+    const IncrementalTriangulator::Options& tri_options) {
+  TraceZone trace_zone("TriangulateAllImages");
+  THROW_CHECK_NOTNULL(reconstruction_);
+  const size_t num_tris = triangulator_->TriangulateAllImages(tri_options);
+  VLOG(1) << "=> Added observations: " << num_tris;
+  trace_zone.SetNumItems(num_tris);
   return num_tris;
 }
 
 size_t IncrementalMapper::Retriangulate(
     const IncrementalTriangulator::Options& tri_options) {
+  COLMAP_TRACE_ZONE("Retriangulate");
   THROW_CHECK_NOTNULL(reconstruction_);
   return triangulator_->Retriangulate(tri_options);
 }
@@ -935,6 +1322,7 @@ size_t IncrementalMapper::MergeTracks(
 
 size_t IncrementalMapper::CompleteAndMergeTracks(
     const IncrementalTriangulator::Options& tri_options) {
+  COLMAP_TRACE_ZONE("CompleteAndMergeTracks");
   const size_t num_completed_observations = CompleteTracks(tri_options);
   VLOG(1) << "=> Completed observations: " << num_completed_observations;
   const size_t num_merged_observations = MergeTracks(tri_options);
@@ -949,6 +1337,7 @@ IncrementalMapper::AdjustLocalBundle(
     const IncrementalTriangulator::Options& tri_options,
     const image_t image_id,
     const std::unordered_set<point3D_t>& point3D_ids) {
+  COLMAP_TRACE_ZONE("AdjustLocalBundle");
   THROW_CHECK_NOTNULL(reconstruction_);
   THROW_CHECK_NOTNULL(obs_manager_);
   THROW_CHECK(options.Check());
@@ -1037,9 +1426,27 @@ IncrementalMapper::AdjustLocalBundle(
     // Adjust the local bundle.
     image_ids = ba_config.Images();
 
-    auto bundle_adjuster =
-        CreateDefaultBundleAdjuster(ba_options, ba_config, *reconstruction_);
-    const auto summary = bundle_adjuster->Solve();
+    std::shared_ptr<BundleAdjustmentSummary> summary;
+    if (options.ba_local_reuse_problem &&
+        ba_options.backend == BundleAdjustmentBackend::CERES) {
+      // Successive local bundles share most of their images and points, so
+      // only update the changed parts of the previous problem.
+      if (local_bundle_adjuster_ == nullptr) {
+        local_bundle_adjuster_ = CreateIncrementalCeresBundleAdjuster(
+            ba_options, ba_config, *reconstruction_);
+      } else {
+        local_bundle_adjuster_->Update(ba_options, ba_config);
+      }
+      VLOG(2) << "Updated local bundle adjustment problem with "
+              << local_bundle_adjuster_->NumAddedResiduals()
+              << " added and " << local_bundle_adjuster_->NumRemovedResiduals()
+              << " removed residuals";
+      summary = local_bundle_adjuster_->Solve();
+    } else {
+      auto bundle_adjuster =
+          CreateDefaultBundleAdjuster(ba_options, ba_config, *reconstruction_);
+      summary = bundle_adjuster->Solve();
+    }
 
     report.num_adjusted_observations = summary->num_residuals / 2;
 
@@ -1067,11 +1474,27 @@ IncrementalMapper::AdjustLocalBundle(
                                    options.filter_min_tri_angle,
                                    point3D_ids);
 
+  double reproj_error_sum = 0;
+  size_t num_points3D = 0;
+  for (const point3D_t point3D_id : point3D_ids) {
+    if (reconstruction_->ExistsPoint3D(point3D_id)) {
+      const Point3D& point3D = reconstruction_->Point3D(point3D_id);
+      if (point3D.HasError()) {
+        reproj_error_sum += point3D.error;
+        num_points3D += 1;
+      }
+    }
+  }
+  if (num_points3D > 0) {
+    report.mean_reproj_error = reproj_error_sum / num_points3D;
+  }
+
   return report;
 }
 
 bool IncrementalMapper::AdjustGlobalBundle(
     const Options& options, const BundleAdjustmentOptions& ba_options) {
+  COLMAP_TRACE_ZONE("AdjustGlobalBundle");
   THROW_CHECK_NOTNULL(reconstruction_);
   THROW_CHECK_NOTNULL(obs_manager_);
 
@@ -1144,7 +1567,7 @@ bool IncrementalMapper::AdjustGlobalBundle(
   const bool use_prior_position =
       options.use_prior_position && ba_config.NumImages() > 2;
 
-  std::unique_ptr<BundleAdjuster> bundle_adjuster;
+  std::shared_ptr<BundleAdjuster> bundle_adjuster;
   if (!use_prior_position) {
     // Fixing the gauge with two cameras leads to a more stable optimization
     // with fewer steps as compared to fixing three points.
@@ -1152,8 +1575,25 @@ bool IncrementalMapper::AdjustGlobalBundle(
     // as initial experiments show that it is even faster.
 
     ba_config.FixGauge(BundleAdjustmentGauge::TWO_CAMS_FROM_WORLD);
-    bundle_adjuster =
-        CreateDefaultBundleAdjuster(ba_options, ba_config, *reconstruction_);
+    if (options.ba_global_reuse_problem &&
+        ba_options.backend == BundleAdjustmentBackend::CERES) {
+      // Successive global bundles share most of their images and points, so
+      // only update the changed parts of the previous problem.
+      if (global_bundle_adjuster_ == nullptr) {
+        global_bundle_adjuster_ = CreateIncrementalCeresBundleAdjuster(
+            ba_options, ba_config, *reconstruction_);
+      } else {
+        global_bundle_adjuster_->Update(ba_options, ba_config);
+      }
+      VLOG(2) << "Updated global bundle adjustment problem with "
+              << global_bundle_adjuster_->NumAddedResiduals()
+              << " added and " << global_bundle_adjuster_->NumRemovedResiduals()
+              << " removed residuals";
+      bundle_adjuster = global_bundle_adjuster_;
+    } else {
+      bundle_adjuster =
+          CreateDefaultBundleAdjuster(ba_options, ba_config, *reconstruction_);
+    }
   } else {
     PosePriorBundleAdjustmentOptions prior_options;
     if (options.use_robust_loss_on_prior_position) {
@@ -1200,7 +1640,8 @@ bool IncrementalMapper::AdjustGlobalBundle(
   return bundle_adjuster->Solve()->IsSolutionUsable();
 }
 
-void IncrementalMapper::IterativeLocalRefinement(
+IncrementalMapper::LocalBundleAdjustmentReport
+IncrementalMapper::IterativeLocalRefinement(
     const int max_num_refinements,
     const double max_refinement_change,
     const Options& options,
@@ -1208,12 +1649,13 @@ void IncrementalMapper::IterativeLocalRefinement(
     const IncrementalTriangulator::Options& tri_options,
     const image_t image_id) {
   BundleAdjustmentOptions custom_ba_options = ba_options;
+  LocalBundleAdjustmentReport report;
   for (int i = 0; i < max_num_refinements; ++i) {
-    const auto report = AdjustLocalBundle(options,
-                                          custom_ba_options,
-                                          tri_options,
-                                          image_id,
-                                          GetModifiedPoints3D());
+    report = AdjustLocalBundle(options,
+                               custom_ba_options,
+                               tri_options,
+                               image_id,
+                               GetModifiedPoints3D());
     VLOG(1) << "=> Merged observations: " << report.num_merged_observations;
     VLOG(1) << "=> Completed observations: "
             << report.num_completed_observations;
@@ -1236,6 +1678,7 @@ void IncrementalMapper::IterativeLocalRefinement(
     }
   }
   ClearModifiedPoints3D();
+  return report;
 }
 
 void IncrementalMapper::IterativeGlobalRefinement(
@@ -1272,6 +1715,7 @@ void IncrementalMapper::IterativeGlobalRefinement(
 }
 
 size_t IncrementalMapper::FilterFrames(const Options& options) {
+  COLMAP_TRACE_ZONE("FilterFrames");
   THROW_CHECK_NOTNULL(reconstruction_);
   THROW_CHECK_NOTNULL(obs_manager_);
   THROW_CHECK(options.Check());
@@ -1307,6 +1751,7 @@ size_t IncrementalMapper::FilterFrames(const Options& options) {
 }
 
 size_t IncrementalMapper::FilterPoints(const Options& options) {
+  COLMAP_TRACE_ZONE("FilterPoints");
   THROW_CHECK_NOTNULL(obs_manager_);
   THROW_CHECK(options.Check());
   const size_t num_filtered_observations = obs_manager_->FilterAllPoints3D(
@@ -1343,6 +1788,79 @@ void IncrementalMapper::ResetInitializationStats() {
   reg_stats_.init_num_reg_trials.clear();
 }
 
+void IncrementalMapper::WriteState(std::ostream& stream) const {
+  WriteBinaryLittleEndian<uint32_t>(&stream, kMapperStateVersion);
+
+  WriteBinaryLittleEndian<uint64_t>(&stream, reg_stats_.num_total_reg_images);
+  WriteBinaryLittleEndian<uint64_t>(&stream, reg_stats_.num_shared_reg_images);
+  WriteMap<image_t, size_t, uint64_t>(stream, reg_stats_.init_num_reg_trials);
+  WriteSet(stream, reg_stats_.init_image_pairs);
+  WriteBinaryLittleEndian<uint64_t>(
+      &stream, reg_stats_.init_rejected_pair_stats.size());
+  for (const auto& [pair_id, stats] : reg_stats_.init_rejected_pair_stats) {
+    WriteBinaryLittleEndian<image_pair_t>(&stream, pair_id);
+    WriteBinaryLittleEndian<double>(&stream, stats.max_error);
+    WriteBinaryLittleEndian<uint64_t>(&stream, stats.num_inliers);
+    WriteBinaryLittleEndian<double>(&stream, stats.forward_motion);
+    WriteBinaryLittleEndian<double>(&stream, stats.tri_angle);
+  }
+  WriteMap<rig_t, size_t, uint64_t>(stream, reg_stats_.num_reg_frames_per_rig);
+  WriteMap<camera_t, size_t, uint64_t>(stream,
+                                       reg_stats_.num_reg_images_per_camera);
+  WriteMap<image_t, size_t, uint64_t>(stream, reg_stats_.num_registrations);
+  WriteMap<image_t, size_t, uint64_t>(stream, reg_stats_.num_reg_trials);
+  WriteMap<image_t, size_t, uint64_t>(
+      stream, reg_stats_.num_structure_less_reg_trials);
+
+  WriteSet(stream, filtered_frames_);
+  WriteSet(stream, existing_frame_ids_);
+
+  if (triangulator_) {
+    WriteMap(stream, triangulator_->RetriangulationTrials());
+  } else {
+    WriteMap(stream, std::unordered_map<image_pair_t, int>());
+  }
+}
+
+void IncrementalMapper::ReadState(std::istream& stream) {
+  const uint32_t version = ReadBinaryLittleEndian<uint32_t>(&stream);
+  THROW_CHECK_EQ(version, kMapperStateVersion)
+      << "Unsupported mapper state version";
+
+  reg_stats_.num_total_reg_images = ReadBinaryLittleEndian<uint64_t>(&stream);
+  reg_stats_.num_shared_reg_images = ReadBinaryLittleEndian<uint64_t>(&stream);
+  reg_stats_.init_num_reg_trials = ReadMap<image_t, size_t, uint64_t>(stream);
+  reg_stats_.init_image_pairs = ReadSet<image_pair_t>(stream);
+  const uint64_t num_rejected_pairs = ReadBinaryLittleEndian<uint64_t>(&stream);
+  reg_stats_.init_rejected_pair_stats.clear();
+  for (uint64_t i = 0; i < num_rejected_pairs; ++i) {
+    const image_pair_t pair_id = ReadBinaryLittleEndian<image_pair_t>(&stream);
+    InitialImagePairStats& stats = reg_stats_.init_rejected_pair_stats[pair_id];
+    stats.max_error = ReadBinaryLittleEndian<double>(&stream);
+    stats.num_inliers = ReadBinaryLittleEndian<uint64_t>(&stream);
+    stats.forward_motion = ReadBinaryLittleEndian<double>(&stream);
+    stats.tri_angle = ReadBinaryLittleEndian<double>(&stream);
+  }
+  reg_stats_.num_reg_frames_per_rig = ReadMap<rig_t, size_t, uint64_t>(stream);
+  reg_stats_.num_reg_images_per_camera =
+      ReadMap<camera_t, size_t, uint64_t>(stream);
+  reg_stats_.num_registrations = ReadMap<image_t, size_t, uint64_t>(stream);
+  reg_stats_.num_reg_trials = ReadMap<image_t, size_t, uint64_t>(stream);
+  reg_stats_.num_structure_less_reg_trials =
+      ReadMap<image_t, size_t, uint64_t>(stream);
+
+  filtered_frames_ = ReadSet<frame_t>(stream);
+  existing_frame_ids_ = ReadSet<frame_t>(stream);
+
+  std::unordered_map<image_pair_t, int> re_num_trials =
+      ReadMap<image_pair_t, int>(stream);
+  if (triangulator_) {
+    triangulator_->SetRetriangulationTrials(std::move(re_num_trials));
+  }
+
+  THROW_CHECK(stream.good()) << "Failed to read mapper state";
+}
+
 const std::unordered_map<rig_t, size_t>& IncrementalMapper::NumRegFramesPerRig()
     const {
   return reg_stats_.num_reg_frames_per_rig;
@@ -1378,6 +1896,8 @@ std::vector<image_t> IncrementalMapper::FindLocalBundle(
 void IncrementalMapper::RegisterFrameEvent(const frame_t frame_id) {
   const Frame& frame = reconstruction_->Frame(frame_id);
 
+  IncrementMetricCounter("colmap_registered_frames_total");
+
   size_t& num_reg_frames_for_rig =
       reg_stats_.num_reg_frames_per_rig[frame.RigId()];
   num_reg_frames_for_rig += 1;
@@ -1422,6 +1942,90 @@ void IncrementalMapper::DeRegisterFrameEvent(const frame_t frame_id) {
     } else if (num_regs_for_image > 0) {
       reg_stats_.num_shared_reg_images -= 1;
     }
+
+    // Track the loaded points2D of the unregistered image again, so that they
+    // can be released.
+    if (database_cache_->HasLazyPoints2D() && image.NumPoints2D() > 0) {
+      lazy_points2D_last_use_[data_id.id] = ++lazy_points2D_use_counter_;
+    }
+  }
+}
+
+void IncrementalMapper::MaterializePoints2D(const image_t image_id) {
+  if (!database_cache_->HasLazyPoints2D()) {
+    return;
+  }
+  Image& image = reconstruction_->Image(image_id);
+  if (!image.HasPose()) {
+    lazy_points2D_last_use_[image_id] = ++lazy_points2D_use_counter_;
+  }
+  if (image.NumPoints2D() > 0 || database_cache_->NumPoints2D(image_id) == 0) {
+    return;
+  }
+  image.SetPoints2D(database_cache_->LoadPoints2D(image_id));
+  obs_manager_->UpdateImagePoints2D(image_id);
+}
+
+void IncrementalMapper::MaterializeFramePoints2D(const frame_t frame_id) {
+  if (!database_cache_->HasLazyPoints2D()) {
+    return;
+  }
+  for (const data_t& data_id : reconstruction_->Frame(frame_id).ImageIds()) {
+    MaterializePoints2D(data_id.id);
+  }
+}
+
+void IncrementalMapper::ReleasePoints2D(const image_t image_id) {
+  if (!database_cache_->HasLazyPoints2D()) {
+    return;
+  }
+  Image& image = reconstruction_->Image(image_id);
+  if (image.HasPose() || image.NumPoints2D() == 0) {
+    return;
+  }
+  image.Points2D().clear();
+  image.Points2D().shrink_to_fit();
+  obs_manager_->UpdateImagePoints2D(image_id);
+  lazy_points2D_last_use_.erase(image_id);
+}
+
+void IncrementalMapper::LimitLazyPoints2D(const Options& options,
+                                          const uint64_t min_last_use) {
+  if (options.lazy_points2D_cache_size <= 0) {
+    return;
+  }
+
+  const size_t max_num_bytes =
+      static_cast<size_t>(1024.0 * 1024.0 * 1024.0 *
+                          options.lazy_points2D_cache_size);
+  size_t num_bytes = 0;
+  std::vector<std::pair<uint64_t, image_t>> releasable_images;
+  for (auto it = lazy_points2D_last_use_.begin();
+       it != lazy_points2D_last_use_.end();) {
+    const Image& image = reconstruction_->Image(it->first);
+    if (image.HasPose()) {
+      it = lazy_points2D_last_use_.erase(it);
+      continue;
+    }
+    num_bytes += image.NumPoints2D() * sizeof(Point2D);
+    if (it->second < min_last_use && image.NumPoints2D() > 0) {
+      releasable_images.emplace_back(it->second, it->first);
+    }
+    ++it;
+  }
+
+  if (num_bytes <= max_num_bytes) {
+    return;
+  }
+
+  std::sort(releasable_images.begin(), releasable_images.end());
+  for (const auto& [last_use, image_id] : releasable_images) {
+    if (num_bytes <= max_num_bytes) {
+      break;
+    }
+    num_bytes -= reconstruction_->Image(image_id).NumPoints2D() *
+                 sizeof(Point2D);
+    ReleasePoints2D(image_id);
   }
 }
 
@@ -35,8 +35,12 @@
 #include "colmap/sfm/incremental_triangulator.h"
 #include "colmap/sfm/observation_manager.h"
 
+#include <iostream>
+
 namespace colmap {
 
+class CeresIncrementalBundleAdjuster;
+
 // Class that provides all functionality for the incremental reconstruction
 // procedure. Example usage:
 //
@@ -94,12 +98,31 @@ class IncrementalMapper {
     // Whether to estimate the extra parameters in absolute pose estimation.
     bool abs_pose_refine_extra_params = true;
 
+    // Whether to robustly triangulate new points from the inlier 2D-2D
+    // correspondences in structure-less registration. Otherwise, only existing
+    // tracks are continued and new points are left to the subsequent
+    // triangulation of the image.
+    bool structure_less_triangulate = true;
+
     // Number of images to optimize in local bundle adjustment.
     int ba_local_num_images = 6;
 
     // Minimum triangulation for images to be chosen in local bundle adjustment.
     double ba_local_min_tri_angle = 6;
 
+    // Whether to keep the local bundle adjustment problem alive across
+    // successive calls and only update the parts of the problem that changed
+    // with the local window. Only used with the Ceres backend.
+    bool ba_local_reuse_problem = true;
+
+    // Whether to keep the global bundle adjustment problem alive across
+    // successive calls and only update the parts of the problem that changed,
+    // e.g., newly registered images or retriangulated points. This avoids
+    // rebuilding the problem during iterative global refinement at the cost
+    // of keeping it in memory. Only used with the Ceres backend and without
+    // prior positions.
+    bool ba_global_reuse_problem = true;
+
     // Whether to ignore redundant 3D points in bundle adjustment when
     // jointly optimizing all parameters. If this is enabled, then the bundle
     // adjustment problem is first solved with a reduced set of 3D points and
@@ -128,6 +151,14 @@ class IncrementalMapper {
     // Maximum number of trials to register an image.
     int max_reg_trials = 3;
 
+    // Maximum size in gigabytes of the points2D of unregistered images, if
+    // the database cache loads them on demand. Beyond this size, the points2D
+    // of the least recently considered images are released and loaded again,
+    // when these are next considered for registration. The points2D of
+    // registered images and of the current registration candidates are never
+    // released. Unlimited if zero.
+    double lazy_points2D_cache_size = 0;
+
     // If reconstruction is provided as input, fix the existing image poses.
     bool fix_existing_frames = false;
 
@@ -167,11 +198,41 @@ class IncrementalMapper {
     bool Check() const;
   };
 
+  // Two-view statistics of a candidate initial image pair, which decide
+  // whether the pair is suitable for initialization.
+  struct InitialImagePairStats {
+    // The RANSAC threshold used for the estimation.
+    double max_error = 0;
+    size_t num_inliers = 0;
+    // Absolute z-component of the normalized relative translation.
+    double forward_motion = 0;
+    // Median triangulation angle in radians.
+    double tri_angle = 0;
+  };
+
+  // Pose of an unregistered image, which was estimated without registering
+  // the image, see `EstimateNextImagePoses`.
+  struct NextImagePose {
+    image_t image_id = kInvalidImageId;
+    // Whether the pose estimation succeeded.
+    bool success = false;
+    Rigid3d cam_from_world;
+    // Camera with the intrinsics used for/refined during estimation.
+    Camera camera;
+    // Parameters of the camera in the reconstruction at estimation time.
+    std::vector<double> prev_camera_params;
+    // The inlier 2D-3D correspondences.
+    std::vector<std::pair<point2D_t, point3D_t>> inlier_corrs;
+  };
+
   struct LocalBundleAdjustmentReport {
     size_t num_merged_observations = 0;
     size_t num_completed_observations = 0;
     size_t num_filtered_observations = 0;
     size_t num_adjusted_observations = 0;
+    // Mean reprojection error in pixels of the refined 3D points after
+    // filtering, or zero if no refined 3D points remain.
+    double mean_reproj_error = 0;
   };
 
   // Create incremental mapper. The database cache must live for the entire
@@ -215,6 +276,19 @@ class IncrementalMapper {
   // a previous call to `RegisterInitialImagePair` was successful.
   bool RegisterNextImage(const Options& options, image_t image_id);
 
+  // Speculatively estimate the poses of multiple next images concurrently
+  // against the current state of the reconstruction without registering them.
+  // Only images in frames with a single sensor are supported. Each estimation
+  // counts as a registration trial of the image.
+  std::vector<NextImagePose> EstimateNextImagePoses(
+      const Options& options, const std::vector<image_t>& image_ids);
+
+  // Attempt to register image from a speculatively estimated pose. Since the
+  // reconstruction may have changed after the estimation, the image is only
+  // registered if sufficiently many of its inlier correspondences are still
+  // consistent and its intrinsics were not changed in the meantime.
+  bool RegisterNextImage(const Options& options, const NextImagePose& pose);
+
   // Attempts to register image using structure-less resectioning as proposed in
   // "Structure from Motion Using Structure-less Resection" by Zheng and Wu.
   bool RegisterNextStructureLessImage(const Options& options, image_t image_id);
@@ -223,6 +297,10 @@ class IncrementalMapper {
   size_t TriangulateImage(const IncrementalTriangulator::Options& tri_options,
                           image_t image_id);
 
+  // Triangulate observations of all registered images at once.
+  size_t TriangulateAllImages(
+      const IncrementalTriangulator::Options& tri_options);
+
   // Retriangulate image pairs that should have common observations according to
   // the scene graph but don't due to drift, etc. To handle drift, the employed
   // reprojection error thresholds should be relatively large. If the thresholds
@@ -261,8 +339,9 @@ class IncrementalMapper {
   bool AdjustGlobalBundle(const Options& options,
                           const BundleAdjustmentOptions& ba_options);
 
-  // Perform multiple rounds of local bundle adjustment.
-  void IterativeLocalRefinement(
+  // Perform multiple rounds of local bundle adjustment and return the report
+  // of the last round.
+  LocalBundleAdjustmentReport IterativeLocalRefinement(
       int max_num_refinements,
       double max_refinement_change,
       const Options& options,
@@ -294,9 +373,18 @@ class IncrementalMapper {
 
   // Reset registration statistics for initialization. This can be used when
   // relaxing the initialization thresholds, such that previously tried pairs
-  // will be tried again.
+  // will be tried again. The statistics of rejected pairs are kept, such that
+  // pairs that also fail the relaxed thresholds are not estimated again.
   void ResetInitializationStats();
 
+  // Write / read the state of the mapper that is not contained in the
+  // reconstructions, i.e., the registration statistics, the filtered frames,
+  // and the retriangulation trials, e.g., to checkpoint and resume the
+  // reconstruction. When resuming a reconstruction, the state must be read
+  // after beginning the reconstruction from the same checkpoint.
+  void WriteState(std::ostream& stream) const;
+  void ReadState(std::istream& stream);
+
   // Number of images that are registered in at least on reconstruction.
   size_t NumTotalRegImages() const;
 
@@ -335,6 +423,8 @@ class IncrementalMapper {
     // and image pair is only tried once for initialization.
     std::unordered_map<image_t, size_t> init_num_reg_trials;
     std::unordered_set<image_pair_t> init_image_pairs;
+    std::unordered_map<image_pair_t, InitialImagePairStats>
+        init_rejected_pair_stats;
 
     // The number of registered frames/images per rig/camera. This information
     // is used to avoid duplicate refinement of rig/camera parameters and
@@ -360,6 +450,17 @@ class IncrementalMapper {
   void RegisterFrameEvent(frame_t frame_id);
   void DeRegisterFrameEvent(frame_t frame_id);
 
+  // Load / release the points2D of unregistered images, if the database cache
+  // loads them on demand. Otherwise, these are no-ops.
+  void MaterializePoints2D(image_t image_id);
+  void MaterializeFramePoints2D(frame_t frame_id);
+  void ReleasePoints2D(image_t image_id);
+
+  // Release the least recently used points2D of unregistered images that
+  // were not used since `min_last_use` until their total size is within
+  // `Options::lazy_points2D_cache_size`.
+  void LimitLazyPoints2D(const Options& options, uint64_t min_last_use);
+
   // Class that holds all necessary data from database in memory.
   const std::shared_ptr<const DatabaseCache> database_cache_;
 
@@ -372,12 +473,22 @@ class IncrementalMapper {
   // Class that is responsible for incremental triangulation.
   std::shared_ptr<IncrementalTriangulator> triangulator_;
 
+  // Persistent local bundle adjustment problem of the current reconstruction.
+  std::shared_ptr<CeresIncrementalBundleAdjuster> local_bundle_adjuster_;
+
+  // Persistent global bundle adjustment problem of the current reconstruction.
+  std::shared_ptr<CeresIncrementalBundleAdjuster> global_bundle_adjuster_;
+
   // Statistics
   RegistrationStatistics reg_stats_;
 
   // Frames that have been filtered in current reconstruction.
   std::unordered_set<frame_t> filtered_frames_;
 
+  // Last use of the points2D of the unregistered images loaded on demand.
+  std::unordered_map<image_t, uint64_t> lazy_points2D_last_use_;
+  uint64_t lazy_points2D_use_counter_ = 0;
+
   // Frames that were registered before beginning the reconstruction.
   // This frame list will be non-empty, if the reconstruction is continued from
   // an existing reconstruction.
@@ -151,10 +151,11 @@ std::vector<image_t> IncrementalMapperImpl::FindSecondInitialImage(
     const std::unordered_map<image_t, size_t>& num_registrations) {
   // Collect images that are connected to the first seed image and have
   // not been registered before in other reconstructions.
-  const class Image& image1 = reconstruction.Image(image_id1);
+  // Note that the points2D of the image may not be loaded yet.
+  const point2D_t num_points2D =
+      correspondence_graph.NumPoints2DForImage(image_id1);
   std::unordered_map<image_t, point2D_t> num_correspondences;
-  for (point2D_t point2D_idx = 0; point2D_idx < image1.NumPoints2D();
-       ++point2D_idx) {
+  for (point2D_t point2D_idx = 0; point2D_idx < num_points2D; ++point2D_idx) {
     const auto corr_range =
         correspondence_graph.FindCorrespondences(image_id1, point2D_idx);
     for (const auto* corr = corr_range.beg; corr < corr_range.end; ++corr) {
@@ -192,6 +193,8 @@ bool IncrementalMapperImpl::FindInitialImagePair(
     const std::unordered_map<image_t, size_t>& init_num_reg_trials,
     const std::unordered_map<image_t, size_t>& num_registrations,
     std::unordered_set<image_pair_t>& init_image_pairs,
+    std::unordered_map<image_pair_t, IncrementalMapper::InitialImagePairStats>&
+        init_rejected_pair_stats,
     image_t& image_id1,
     image_t& image_id2,
     Rigid3d& cam2_from_cam1) {
@@ -258,27 +261,50 @@ bool IncrementalMapperImpl::FindInitialImagePair(
 
         const image_pair_t pair_id = ImagePairToPairId(image_id1, image_id2);
 
-        // Try every pair only once.
+        // Try every pair only once and skip pairs that were rejected before
+        // under the same or stricter thresholds.
         {
           std::lock_guard<std::mutex> lock_guard(init_image_pairs_mutex);
           if (!init_image_pairs.emplace(pair_id).second) {
             continue;
           }
+          if (const auto stats_it = init_rejected_pair_stats.find(pair_id);
+              stats_it != init_rejected_pair_stats.end() &&
+              stats_it->second.max_error == options.init_max_error &&
+              !IncrementalMapperImpl::IsSuitableInitialImagePair(
+                  options, stats_it->second)) {
+            continue;
+          }
+        }
+
+        if (!IncrementalMapperImpl::IsInitialImagePairCandidate(
+                options, correspondence_graph, image_id1, image_id2)) {
+          continue;
         }
 
         InitInfo init_info;
         init_info.image_id1 = image_id1;
         init_info.image_id2 = image_id2;
+        IncrementalMapper::InitialImagePairStats stats;
         if (IncrementalMapperImpl::EstimateInitialTwoViewGeometry(
                 options,
                 database_cache,
                 init_info.image_id1,
                 init_info.image_id2,
-                init_info.cam2_from_cam1)) {
+                init_info.cam2_from_cam1,
+                &stats)) {
           stop.store(true);
           init_info.success = true;
           return init_info;
         }
+
+        // Only remember pairs rejected by the two-view statistics, since the
+        // rejection of rig pairs may also depend on other estimates.
+        if (!IncrementalMapperImpl::IsSuitableInitialImagePair(options,
+                                                               stats)) {
+          std::lock_guard<std::mutex> lock_guard(init_image_pairs_mutex);
+          init_rejected_pair_stats[pair_id] = stats;
+        }
       }
 
       return {};
@@ -310,7 +336,7 @@ std::vector<image_t> IncrementalMapperImpl::FindNextImages(
     const IncrementalMapper::Options& options,
     const ObservationManager& obs_manager,
     const std::unordered_set<frame_t>& filtered_frames,
-    std::unordered_map<image_t, size_t>& num_reg_trials,
+    const std::unordered_map<image_t, size_t>& num_reg_trials,
     bool structure_less) {
   THROW_CHECK(options.Check());
   const Reconstruction& reconstruction = obs_manager.Reconstruction();
@@ -338,13 +364,19 @@ std::vector<image_t> IncrementalMapperImpl::FindNextImages(
     }
   }
 
-  std::vector<std::pair<image_t, float>> image_ranks;
-  std::vector<std::pair<image_t, float>> other_image_ranks;
+  const auto get_num_reg_trials = [&num_reg_trials](const image_t image_id) {
+    const auto it = num_reg_trials.find(image_id);
+    return it == num_reg_trials.end() ? size_t(0) : it->second;
+  };
 
-  // Append images that have not failed to register before.
-  for (const auto& [image_id, image] : reconstruction.Images()) {
-    // Skip images that are already registered.
-    if (image.HasPose()) {
+  // Only unregistered images that see at least one triangulated point can
+  // satisfy the minimum number of visible points, so there is no need to scan
+  // all images of the reconstruction.
+  std::vector<image_t> candidate_image_ids;
+  candidate_image_ids.reserve(obs_manager.UnregisteredVisibleImageIds().size());
+  for (const image_t image_id : obs_manager.UnregisteredVisibleImageIds()) {
+    // Skip images that were registered without the observation manager.
+    if (reconstruction.Image(image_id).HasPose()) {
       continue;
     }
 
@@ -355,19 +387,42 @@ std::vector<image_t> IncrementalMapperImpl::FindNextImages(
     }
 
     // Only try registration for a certain maximum number of times.
-    const size_t image_num_reg_trials = num_reg_trials[image_id];
-    if (image_num_reg_trials >= static_cast<size_t>(options.max_reg_trials)) {
+    if (get_num_reg_trials(image_id) >=
+        static_cast<size_t>(options.max_reg_trials)) {
       continue;
     }
 
+    candidate_image_ids.push_back(image_id);
+  }
+
+  // Rank the candidates in parallel. The ranking only reads the observation
+  // manager, and the chunks are large enough that small sets of candidates
+  // are ranked on the calling thread.
+  std::vector<float> candidate_ranks(candidate_image_ids.size());
+  ParallelFor(
+      0,
+      candidate_image_ids.size(),
+      [&](const int64_t begin, const int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          candidate_ranks[i] =
+              rank_image_func(candidate_image_ids[i], obs_manager);
+        }
+      },
+      GetEffectiveNumThreads(options.num_threads),
+      /*grain_size=*/1024);
+
+  std::vector<std::pair<image_t, float>> image_ranks;
+  std::vector<std::pair<image_t, float>> other_image_ranks;
+  for (size_t i = 0; i < candidate_image_ids.size(); ++i) {
     // If image has been filtered or failed to register, place it in the
     // second bucket and prefer images that have not been tried before.
-    const float rank = rank_image_func(image_id, obs_manager);
-    const frame_t frame_id = image.FrameId();
-    if (filtered_frames.count(frame_id) == 0 && image_num_reg_trials == 0) {
-      image_ranks.emplace_back(image_id, rank);
+    const image_t image_id = candidate_image_ids[i];
+    const frame_t frame_id = reconstruction.Image(image_id).FrameId();
+    if (filtered_frames.count(frame_id) == 0 &&
+        get_num_reg_trials(image_id) == 0) {
+      image_ranks.emplace_back(image_id, candidate_ranks[i]);
     } else {
-      other_image_ranks.emplace_back(image_id, rank);
+      other_image_ranks.emplace_back(image_id, candidate_ranks[i]);
     }
   }
 
@@ -591,6 +646,8 @@ bool EstimateInitialGeneralizedTwoViewGeometry(
     const Image& image1 = database_cache.Image(image_id1.id);
     const Camera& camera1 = database_cache.Camera(image1.CameraId());
     const size_t camera_idx1 = maybe_add_camera(rig1, camera1);
+    const std::vector<Eigen::Vector2d> image_points2D1 =
+        database_cache.LoadPoints2D(image_id1.id);
 
     for (const data_t& image_id2 : frame2.ImageIds()) {
       const Image& image2 = database_cache.Image(image_id2.id);
@@ -599,9 +656,14 @@ bool EstimateInitialGeneralizedTwoViewGeometry(
 
       database_cache.CorrespondenceGraph()->ExtractMatchesBetweenImages(
           image_id1.id, image_id2.id, matches);
+      if (matches.empty()) {
+        continue;
+      }
+      const std::vector<Eigen::Vector2d> image_points2D2 =
+          database_cache.LoadPoints2D(image_id2.id);
       for (const auto& match : matches) {
-        points2D1.push_back(image1.Point2D(match.point2D_idx1).xy);
-        points2D2.push_back(image2.Point2D(match.point2D_idx2).xy);
+        points2D1.push_back(image_points2D1[match.point2D_idx1]);
+        points2D2.push_back(image_points2D2[match.point2D_idx2]);
         camera_idxs1.push_back(camera_idx1);
         camera_idxs2.push_back(camera_idx2);
       }
@@ -666,12 +728,52 @@ bool EstimateInitialGeneralizedTwoViewGeometry(
 
 }  // namespace
 
+bool IncrementalMapperImpl::IsSuitableInitialImagePair(
+    const IncrementalMapper::Options& options,
+    const IncrementalMapper::InitialImagePairStats& stats) {
+  return static_cast<int>(stats.num_inliers) >= options.init_min_num_inliers &&
+         stats.forward_motion < options.init_max_forward_motion &&
+         stats.tri_angle > DegToRad(options.init_min_tri_angle);
+}
+
+bool IncrementalMapperImpl::IsInitialImagePairCandidate(
+    const IncrementalMapper::Options& options,
+    const CorrespondenceGraph& correspondence_graph,
+    const image_t image_id1,
+    const image_t image_id2) {
+  // The re-estimated inliers are a subset of the verified matches.
+  if (static_cast<int>(correspondence_graph.NumMatchesBetweenImages(
+          image_id1, image_id2)) < options.init_min_num_inliers) {
+    return false;
+  }
+
+  const TwoViewGeometry two_view_geometry =
+      correspondence_graph.ExtractTwoViewGeometry(
+          image_id1, image_id2, /*extract_inlier_matches=*/false);
+  if (two_view_geometry.tri_angle >= 0 &&
+      two_view_geometry.tri_angle <= DegToRad(options.init_min_tri_angle)) {
+    return false;
+  }
+  if (two_view_geometry.cam2_from_cam1.has_value()) {
+    const Eigen::Vector3d& translation =
+        two_view_geometry.cam2_from_cam1->translation();
+    const double norm = translation.norm();
+    if (norm > 0 &&
+        std::abs(translation.z()) / norm >= options.init_max_forward_motion) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 bool IncrementalMapperImpl::EstimateInitialTwoViewGeometry(
     const IncrementalMapper::Options& options,
     const DatabaseCache& database_cache,
     const image_t image_id1,
     const image_t image_id2,
-    Rigid3d& cam2_from_cam1) {
+    Rigid3d& cam2_from_cam1,
+    IncrementalMapper::InitialImagePairStats* stats) {
   const Image& image1 = database_cache.Image(image_id1);
   const Image& image2 = database_cache.Image(image_id2);
   const Camera& camera1 = database_cache.Camera(image1.CameraId());
@@ -681,17 +783,10 @@ bool IncrementalMapperImpl::EstimateInitialTwoViewGeometry(
   database_cache.CorrespondenceGraph()->ExtractMatchesBetweenImages(
       image_id1, image_id2, matches);
 
-  std::vector<Eigen::Vector2d> points1;
-  points1.reserve(image1.NumPoints2D());
-  for (const auto& point : image1.Points2D()) {
-    points1.push_back(point.xy);
-  }
-
-  std::vector<Eigen::Vector2d> points2;
-  points2.reserve(image2.NumPoints2D());
-  for (const auto& point : image2.Points2D()) {
-    points2.push_back(point.xy);
-  }
+  const std::vector<Eigen::Vector2d> points1 =
+      database_cache.LoadPoints2D(image_id1);
+  const std::vector<Eigen::Vector2d> points2 =
+      database_cache.LoadPoints2D(image_id2);
 
   TwoViewGeometryOptions two_view_geometry_options;
   two_view_geometry_options.ransac_options.min_num_trials = 30;
@@ -700,8 +795,13 @@ bool IncrementalMapperImpl::EstimateInitialTwoViewGeometry(
   TwoViewGeometry two_view_geometry = EstimateCalibratedTwoViewGeometry(
       camera1, points1, camera2, points2, matches, two_view_geometry_options);
 
+  IncrementalMapper::InitialImagePairStats pair_stats;
+  pair_stats.max_error = options.init_max_error;
   if (!EstimateTwoViewGeometryPose(
           camera1, points1, camera2, points2, &two_view_geometry)) {
+    if (stats != nullptr) {
+      *stats = pair_stats;
+    }
     return false;
   }
 
@@ -712,11 +812,15 @@ bool IncrementalMapperImpl::EstimateInitialTwoViewGeometry(
           << " z translation, " << RadToDeg(two_view_geometry.tri_angle)
           << " deg triangulation angle";
 
-  if (static_cast<int>(two_view_geometry.inlier_matches.size()) <
-          options.init_min_num_inliers ||
-      std::abs(two_view_geometry.cam2_from_cam1->translation().z()) >=
-          options.init_max_forward_motion ||
-      two_view_geometry.tri_angle <= DegToRad(options.init_min_tri_angle)) {
+  pair_stats.num_inliers = two_view_geometry.inlier_matches.size();
+  pair_stats.forward_motion =
+      std::abs(two_view_geometry.cam2_from_cam1->translation().z());
+  pair_stats.tri_angle = two_view_geometry.tri_angle;
+  if (stats != nullptr) {
+    *stats = pair_stats;
+  }
+
+  if (!IsSuitableInitialImagePair(options, pair_stats)) {
     return false;
   }
 
@@ -68,6 +68,9 @@ class IncrementalMapperImpl {
       const std::unordered_map<image_t, size_t>& init_num_reg_trials,
       const std::unordered_map<image_t, size_t>& num_registrations,
       std::unordered_set<image_pair_t>& init_image_pairs,
+      std::unordered_map<image_pair_t,
+                         IncrementalMapper::InitialImagePairStats>&
+          init_rejected_pair_stats,
       image_t& image_id1,
       image_t& image_id2,
       Rigid3d& cam2_from_cam1);
@@ -77,7 +80,7 @@ class IncrementalMapperImpl {
       const IncrementalMapper::Options& options,
       const ObservationManager& obs_manager,
       const std::unordered_set<frame_t>& filtered_frames,
-      std::unordered_map<image_t, size_t>& num_reg_trials,
+      const std::unordered_map<image_t, size_t>& num_reg_trials,
       bool structure_less = false);
 
   // Implement IncrementalMapper::FindLocalBundle
@@ -86,13 +89,31 @@ class IncrementalMapperImpl {
       image_t image_id,
       const Reconstruction& reconstruction);
 
-  // Implement IncrementalMapper::EstimateInitialTwoViewGeometry
+  // Implement IncrementalMapper::EstimateInitialTwoViewGeometry. Optionally
+  // outputs the two-view statistics of the pair, if its relative pose could
+  // be estimated.
   static bool EstimateInitialTwoViewGeometry(
       const IncrementalMapper::Options& options,
       const DatabaseCache& database_cache,
       image_t image_id1,
       image_t image_id2,
-      Rigid3d& cam2_from_cam1);
+      Rigid3d& cam2_from_cam1,
+      IncrementalMapper::InitialImagePairStats* stats = nullptr);
+
+  // Check whether the two-view statistics satisfy the initialization
+  // thresholds.
+  static bool IsSuitableInitialImagePair(
+      const IncrementalMapper::Options& options,
+      const IncrementalMapper::InitialImagePairStats& stats);
+
+  // Cheaply check whether an image pair is a candidate for initialization
+  // based on the number of matches and the two-view geometry estimated during
+  // matching, before re-estimating its two-view geometry.
+  static bool IsInitialImagePairCandidate(
+      const IncrementalMapper::Options& options,
+      const CorrespondenceGraph& correspondence_graph,
+      image_t image_id1,
+      image_t image_id2);
 };
 
 }  // namespace colmap
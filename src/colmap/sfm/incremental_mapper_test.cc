@@ -35,6 +35,7 @@
 #include "colmap/scene/synthetic.h"
 
 #include <algorithm>
+#include <unordered_set>
 
 #include <gtest/gtest.h>
 
@@ -333,6 +334,41 @@ TEST_F(IncrementalMapperTest, FullPipeline) {
   EXPECT_GE(max_track_length, reconstruction_->NumRegImages());
 }
 
+TEST_F(IncrementalMapperTest, SpeculativeNextImageRegistration) {
+  FindAndRegisterInitialPair();
+  TriangulateInitialPair();
+
+  options_.num_threads = 2;
+  const std::vector<image_t> next_image_ids =
+      mapper_->FindNextImages(options_);
+  ASSERT_FALSE(next_image_ids.empty());
+  const std::vector<IncrementalMapper::NextImagePose> poses =
+      mapper_->EstimateNextImagePoses(options_, next_image_ids);
+  ASSERT_EQ(poses.size(), next_image_ids.size());
+  EXPECT_EQ(reconstruction_->NumRegFrames(), 2);
+
+  for (size_t i = 0; i < poses.size(); ++i) {
+    EXPECT_EQ(poses[i].image_id, next_image_ids[i]);
+    ASSERT_TRUE(poses[i].success);
+    EXPECT_GE(poses[i].inlier_corrs.size(),
+              static_cast<size_t>(options_.abs_pose_min_num_inliers));
+  }
+
+  // Commit the speculative poses one after another without triangulating in
+  // between, such that all estimates remain consistent.
+  for (const auto& pose : poses) {
+    EXPECT_TRUE(mapper_->RegisterNextImage(options_, pose));
+    EXPECT_TRUE(reconstruction_->Image(pose.image_id).HasPose());
+  }
+  EXPECT_EQ(reconstruction_->NumRegFrames(), 2 + poses.size());
+
+  // Already registered images are rejected.
+  EXPECT_FALSE(mapper_->RegisterNextImage(options_, poses.front()));
+
+  RegisterAllRemainingImages();
+  EXPECT_EQ(reconstruction_->NumRegFrames(), 10);
+}
+
 TEST_F(IncrementalMapperTest, FindLocalBundle) {
   FindAndRegisterInitialPair();
   TriangulateInitialPair();
@@ -370,6 +406,25 @@ TEST_F(IncrementalMapperTest, ResetInitializationStats) {
   EXPECT_NE(image_id4, kInvalidImageId);
 }
 
+TEST_F(IncrementalMapperTest, FindInitialImagePairAfterRelaxation) {
+  // All pairs are rejected by their triangulation angle.
+  const double init_min_tri_angle = options_.init_min_tri_angle;
+  options_.init_min_tri_angle = 89;
+  EXPECT_FALSE(mapper_->FindInitialImagePair(
+      options_, image_id1_, image_id2_, cam2_from_cam1_));
+  mapper_->ResetInitializationStats();
+  EXPECT_FALSE(mapper_->FindInitialImagePair(
+      options_, image_id1_, image_id2_, cam2_from_cam1_));
+
+  // Previously rejected pairs are reconsidered under relaxed thresholds.
+  options_.init_min_tri_angle = init_min_tri_angle;
+  mapper_->ResetInitializationStats();
+  EXPECT_TRUE(mapper_->FindInitialImagePair(
+      options_, image_id1_, image_id2_, cam2_from_cam1_));
+  EXPECT_NE(image_id1_, kInvalidImageId);
+  EXPECT_NE(image_id2_, kInvalidImageId);
+}
+
 // Frame filtering is disabled before the 20-frame mapper threshold.
 TEST_F(IncrementalMapperTest, FilterFramesNoOpBelowMinFrames) {
   BeginWithSynthesizedReconstruction();
@@ -642,5 +697,73 @@ TEST_F(IncrementalMapperTest, RegStatsResetBetweenReconstructions) {
   mapper_->EndReconstruction(/*discard=*/false);
 }
 
+TEST(IncrementalMapper, LazyPoints2DCacheSize) {
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+  Reconstruction gt_reconstruction;
+  SyntheticDatasetOptions synthetic_options = DefaultSyntheticOptions();
+  synthetic_options.num_frames_per_rig = 8;
+  SynthesizeDataset(synthetic_options, &gt_reconstruction, database.get());
+
+  DatabaseCache::Options cache_options;
+  cache_options.lazy_load_points2D = true;
+  auto cache = DatabaseCache::Create(database, cache_options);
+  ASSERT_TRUE(cache->HasLazyPoints2D());
+
+  IncrementalMapper mapper(cache);
+  auto reconstruction = std::make_shared<Reconstruction>();
+  mapper.BeginReconstruction(reconstruction);
+
+  IncrementalMapper::Options options;
+  options.init_min_num_inliers = 10;
+  options.abs_pose_min_num_inliers = 10;
+  options.abs_pose_min_inlier_ratio = 0.1;
+  // Smaller than the points2D of a single image.
+  options.lazy_points2D_cache_size = 1e-9;
+  IncrementalTriangulator::Options tri_options;
+
+  image_t image_id1 = kInvalidImageId;
+  image_t image_id2 = kInvalidImageId;
+  Rigid3d cam2_from_cam1;
+  ASSERT_TRUE(mapper.FindInitialImagePair(
+      options, image_id1, image_id2, cam2_from_cam1));
+  mapper.RegisterInitialImagePair(
+      options, image_id1, image_id2, cam2_from_cam1);
+  mapper.TriangulateImage(tri_options, image_id1);
+  mapper.TriangulateImage(tri_options, image_id2);
+
+  while (true) {
+    const std::vector<image_t> next_image_ids = mapper.FindNextImages(options);
+    // Only the points2D of the current candidates are kept.
+    const std::unordered_set<image_t> candidate_image_ids(
+        next_image_ids.begin(), next_image_ids.end());
+    for (const auto& [image_id, image] : reconstruction->Images()) {
+      if (!image.HasPose() && image.NumPoints2D() > 0) {
+        EXPECT_EQ(candidate_image_ids.count(image_id), 1);
+      }
+    }
+
+    bool any_image_registered = false;
+    for (const image_t image_id : next_image_ids) {
+      if (mapper.RegisterNextImage(options, image_id)) {
+        mapper.TriangulateImage(tri_options, image_id);
+        any_image_registered = true;
+        break;
+      }
+    }
+    if (!any_image_registered) {
+      break;
+    }
+  }
+
+  EXPECT_EQ(reconstruction->NumRegFrames(), gt_reconstruction.NumRegFrames());
+  for (const auto& [image_id, image] : reconstruction->Images()) {
+    if (image.HasPose()) {
+      EXPECT_EQ(image.NumPoints2D(), cache->NumPoints2D(image_id));
+    }
+  }
+
+  mapper.EndReconstruction(/*discard=*/false);
+}
+
 }  // namespace
 }  // namespace colmap
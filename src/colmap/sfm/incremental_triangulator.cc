@@ -30,11 +30,80 @@
 #include "colmap/sfm/incremental_triangulator.h"
 
 #include "colmap/estimators/triangulation.h"
+#include "colmap/math/union_find.h"
 #include "colmap/scene/projection.h"
+#include "colmap/util/threading.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
 
 namespace colmap {
 namespace {
 
+// Number of 3D points, for which candidates are found concurrently before
+// committing them. Smaller chunks more closely follow the sequential order,
+// while larger chunks reduce the synchronization overhead.
+constexpr size_t kParallelChunkSize = 4096;
+
+// Tracks up to this length are triangulated with exhaustive sampling.
+constexpr size_t kExhaustiveSamplingThreshold = 15;
+
+// Run the function for all indices in [0, num) on the thread pool or
+// serially, if no thread pool is given.
+template <typename Func>
+void ParallelFor(ThreadPool* thread_pool, const size_t num, const Func& func) {
+  if (thread_pool == nullptr) {
+    for (size_t i = 0; i < num; ++i) {
+      func(i);
+    }
+    return;
+  }
+
+  const size_t num_tasks = std::min(num, thread_pool->NumThreads());
+  for (size_t task_idx = 0; task_idx < num_tasks; ++task_idx) {
+    const size_t begin = task_idx * num / num_tasks;
+    const size_t end = (task_idx + 1) * num / num_tasks;
+    thread_pool->AddTask([&func, begin, end]() {
+      for (size_t i = begin; i < end; ++i) {
+        func(i);
+      }
+    });
+  }
+  thread_pool->Wait();
+}
+
+// Check whether all observations of two 3D points are inliers to the
+// weighted average of their locations.
+bool IsMergeConsistent(const Reconstruction& reconstruction,
+                       const Point3D& point3D1,
+                       const Point3D& point3D2,
+                       const double max_squared_reproj_error) {
+  // Weighted average of point locations, depending on track length.
+  const Eigen::Vector3d merged_xyz =
+      (point3D1.track.Length() * point3D1.xyz +
+       point3D2.track.Length() * point3D2.xyz) /
+      (point3D1.track.Length() + point3D2.track.Length());
+
+  for (const Track* track : {&point3D1.track, &point3D2.track}) {
+    for (const auto& test_track_el : track->Elements()) {
+      const Image& test_image = reconstruction.Image(test_track_el.image_id);
+      const Camera& test_camera = *test_image.CameraPtr();
+      const Point2D& test_point2D =
+          test_image.Point2D(test_track_el.point2D_idx);
+      if (CalculateSquaredReprojectionError(test_point2D.xy,
+                                            merged_xyz,
+                                            test_image.CamFromWorld(),
+                                            test_camera) >
+          max_squared_reproj_error) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
 bool TriangulateTrack(
     const EstimateTriangulationOptions& options,
     const std::vector<IncrementalTriangulator::CorrData>& corrs_data,
@@ -55,7 +124,6 @@ bool TriangulateTrack(
 
   // Enforce exhaustive sampling for small track lengths.
   EstimateTriangulationOptions options_(options);
-  const size_t kExhaustiveSamplingThreshold = 15;
   if (points.size() <= kExhaustiveSamplingThreshold) {
     options_.ransac_options.min_num_trials = NChooseK(points.size(), 2);
   }
@@ -155,6 +223,253 @@ size_t IncrementalTriangulator::TriangulateImage(const Options& options,
   return num_tris;
 }
 
+size_t IncrementalTriangulator::TriangulateAllImages(const Options& options) {
+  THROW_CHECK(options.Check());
+
+  ClearCaches();
+  CacheCameraBogusParams(options);
+
+  // Assign compact 32-bit observation ids by concatenating the 2D points of
+  // all registered images, such that the observations of an image form a
+  // contiguous id range starting at its offset.
+  std::vector<image_t> image_ids;
+  for (const image_t image_id : reconstruction_.RegImageIds()) {
+    if (!HasCachedCameraBogusParams(
+            reconstruction_.Image(image_id).CameraId())) {
+      image_ids.push_back(image_id);
+    }
+  }
+  std::sort(image_ids.begin(), image_ids.end());
+  const size_t num_images = image_ids.size();
+  std::vector<const Image*> images(num_images);
+  std::vector<uint32_t> image_offsets(num_images + 1, 0);
+  std::unordered_map<image_t, size_t> image_id_to_idx;
+  image_id_to_idx.reserve(num_images);
+  uint64_t num_observations = 0;
+  for (size_t image_idx = 0; image_idx < num_images; ++image_idx) {
+    images[image_idx] = &reconstruction_.Image(image_ids[image_idx]);
+    image_id_to_idx.emplace(image_ids[image_idx], image_idx);
+    image_offsets[image_idx] = static_cast<uint32_t>(num_observations);
+    num_observations += images[image_idx]->NumPoints2D();
+    THROW_CHECK_LT(num_observations, std::numeric_limits<uint32_t>::max())
+        << "Too many observations for 32-bit observation ids";
+  }
+  image_offsets[num_images] = static_cast<uint32_t>(num_observations);
+
+  const int num_threads = GetEffectiveNumThreads(options.num_threads);
+  std::unique_ptr<ThreadPool> thread_pool;
+  if (num_threads > 1 && num_images > 1) {
+    thread_pool = std::make_unique<ThreadPool>(num_threads);
+  }
+
+  // Unite the untriangulated observations with their correspondences. Every
+  // correspondence is stored for both images, so it is only united from the
+  // image with the smaller id.
+  ConcurrentUnionFind uf(static_cast<uint32_t>(num_observations));
+  ParallelFor(thread_pool.get(), num_images, [&](const size_t image_idx1) {
+    const image_t image_id1 = image_ids[image_idx1];
+    const Image& image1 = *images[image_idx1];
+    for (point2D_t point2D_idx1 = 0; point2D_idx1 < image1.NumPoints2D();
+         ++point2D_idx1) {
+      if (image1.Point2D(point2D_idx1).HasPoint3D()) {
+        continue;
+      }
+      const auto range =
+          correspondence_graph_->FindCorrespondences(image_id1, point2D_idx1);
+      for (const auto* corr = range.beg; corr < range.end; ++corr) {
+        if (corr->image_id <= image_id1) {
+          continue;
+        }
+        const auto it = image_id_to_idx.find(corr->image_id);
+        if (it == image_id_to_idx.end() ||
+            images[it->second]->Point2D(corr->point2D_idx).HasPoint3D()) {
+          continue;
+        }
+        uf.Union(image_offsets[image_idx1] + point2D_idx1,
+                 image_offsets[it->second] + corr->point2D_idx);
+      }
+    }
+  });
+  uf.Compress();
+
+  // Gather the observations of the candidate tracks into contiguous ranges.
+  // As observation ids are visited in increasing order, the observations of
+  // each track are grouped by image.
+  constexpr uint32_t kInvalidTrackIdx = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> root_to_track_idx(num_observations, 0);
+  for (uint32_t obs_id = 0; obs_id < num_observations; ++obs_id) {
+    ++root_to_track_idx[uf.Parent(obs_id)];
+  }
+  std::vector<uint32_t> track_begs = {0};
+  for (uint32_t obs_id = 0; obs_id < num_observations; ++obs_id) {
+    const uint32_t track_size = root_to_track_idx[obs_id];
+    if (track_size < 2) {
+      root_to_track_idx[obs_id] = kInvalidTrackIdx;
+    } else {
+      root_to_track_idx[obs_id] = track_begs.size() - 1;
+      track_begs.push_back(track_begs.back() + track_size);
+    }
+  }
+  const size_t num_tracks = track_begs.size() - 1;
+  std::vector<uint32_t> track_cursors(track_begs.begin(),
+                                      track_begs.end() - 1);
+  std::vector<uint32_t> track_observations(track_begs.back());
+  for (uint32_t obs_id = 0; obs_id < num_observations; ++obs_id) {
+    const uint32_t track_idx = root_to_track_idx[uf.Parent(obs_id)];
+    if (track_idx != kInvalidTrackIdx) {
+      track_observations[track_cursors[track_idx]++] = obs_id;
+    }
+  }
+  std::vector<uint32_t>().swap(root_to_track_idx);
+  std::vector<uint32_t>().swap(track_cursors);
+
+  VLOG(1) << "=> Candidate tracks: " << num_tracks;
+
+  EstimateTriangulationOptions tri_options;
+  tri_options.min_tri_angle = DegToRad(options.min_angle);
+  tri_options.residual_type =
+      TriangulationEstimator::ResidualType::ANGULAR_ERROR;
+  tri_options.ransac_options.max_error =
+      DegToRad(options.create_max_angle_error);
+  tri_options.ransac_options.random_seed = options.random_seed;
+
+  // Enforce exhaustive sampling for small track lengths as in
+  // TriangulateTrack, which is at the same time the minimum number of trials
+  // for longer tracks.
+  tri_options.ransac_options.min_num_trials =
+      NChooseK(kExhaustiveSamplingThreshold, 2);
+
+  const auto ImageIdxForObservation = [&](const uint32_t obs_id) {
+    return static_cast<uint32_t>(std::upper_bound(image_offsets.begin(),
+                                                  image_offsets.end(),
+                                                  obs_id) -
+                                 image_offsets.begin() - 1);
+  };
+
+  TriangulationBatch batch;
+  batch.cams_from_world.reserve(num_images);
+  batch.cameras.reserve(num_images);
+  for (const Image* image : images) {
+    batch.cams_from_world.push_back(image->CamFromWorld());
+    batch.cameras.push_back(image->CameraPtr());
+  }
+
+  // The observation ids of the batch and the candidate track of every track in
+  // the batch.
+  std::vector<uint32_t> batch_obs_ids;
+  std::vector<uint32_t> batch_track_idxs;
+  const auto AddBatchTrack = [&](const uint32_t track_idx,
+                                 const uint32_t* obs_ids_begin,
+                                 const uint32_t* obs_ids_end) {
+    for (const uint32_t* obs_id = obs_ids_begin; obs_id < obs_ids_end;
+         ++obs_id) {
+      const uint32_t image_idx = ImageIdxForObservation(*obs_id);
+      batch.AddObservation(
+          image_idx,
+          images[image_idx]->Point2D(*obs_id - image_offsets[image_idx]).xy);
+      batch_obs_ids.push_back(*obs_id);
+    }
+    batch.FinishTrack();
+    batch_track_idxs.push_back(track_idx);
+  };
+
+  for (uint32_t track_idx = 0; track_idx < num_tracks; ++track_idx) {
+    const uint32_t* obs_ids_begin =
+        track_observations.data() + track_begs[track_idx];
+    const uint32_t* obs_ids_end =
+        track_observations.data() + track_begs[track_idx + 1];
+    if (options.ignore_two_view_tracks && obs_ids_end - obs_ids_begin == 2) {
+      const uint32_t image_idx = ImageIdxForObservation(*obs_ids_begin);
+      if (correspondence_graph_->IsTwoViewObservation(
+              image_ids[image_idx],
+              *obs_ids_begin - image_offsets[image_idx])) {
+        continue;
+      }
+    }
+    AddBatchTrack(track_idx, obs_ids_begin, obs_ids_end);
+  }
+  std::vector<uint32_t>().swap(track_observations);
+
+  // Triangulate the candidate tracks in rounds of concurrent batches. Each
+  // point keeps at most one observation per image and the remaining
+  // observations of a track are triangulated again in the next round, if
+  // there are enough of them.
+  const size_t kMinRecursiveTrackLength = 3;
+  std::vector<std::vector<std::pair<Eigen::Vector3d, Track>>> track_points(
+      num_tracks);
+  std::vector<char> success;
+  std::vector<Eigen::Vector3d> xyzs;
+  std::vector<char> inlier_masks;
+  std::unordered_set<uint32_t> track_image_idxs;
+  std::vector<uint32_t> remaining_obs_ids;
+  std::vector<size_t> remaining_offsets;
+  std::vector<uint32_t> remaining_track_idxs;
+  while (batch.NumTracks() > 0) {
+    EstimateTriangulationBatch(
+        tri_options, batch, &success, &xyzs, &inlier_masks, num_threads);
+
+    remaining_obs_ids.clear();
+    remaining_offsets.assign(1, 0);
+    remaining_track_idxs.clear();
+    for (size_t i = 0; i < batch.NumTracks(); ++i) {
+      if (!success[i]) {
+        continue;
+      }
+
+      Track track;
+      track_image_idxs.clear();
+      for (size_t j = batch.track_offsets[i]; j < batch.track_offsets[i + 1];
+           ++j) {
+        const uint32_t image_idx = batch.image_idxs[j];
+        if (inlier_masks[j] && track_image_idxs.insert(image_idx).second) {
+          track.AddElement(image_ids[image_idx],
+                           batch_obs_ids[j] - image_offsets[image_idx]);
+        } else {
+          remaining_obs_ids.push_back(batch_obs_ids[j]);
+        }
+      }
+
+      if (track.Length() < 2) {
+        remaining_obs_ids.resize(remaining_offsets.back());
+        continue;
+      }
+
+      track_points[batch_track_idxs[i]].emplace_back(xyzs[i], std::move(track));
+
+      if (remaining_obs_ids.size() - remaining_offsets.back() <
+          kMinRecursiveTrackLength) {
+        remaining_obs_ids.resize(remaining_offsets.back());
+      } else {
+        remaining_offsets.push_back(remaining_obs_ids.size());
+        remaining_track_idxs.push_back(batch_track_idxs[i]);
+      }
+    }
+
+    batch.ClearTracks();
+    batch_obs_ids.clear();
+    batch_track_idxs.clear();
+    for (size_t i = 0; i < remaining_track_idxs.size(); ++i) {
+      AddBatchTrack(remaining_track_idxs[i],
+                    remaining_obs_ids.data() + remaining_offsets[i],
+                    remaining_obs_ids.data() + remaining_offsets[i + 1]);
+    }
+  }
+
+  // Add the points in the order of their tracks, such that the point
+  // identifiers do not depend on the number of threads.
+  size_t num_tris = 0;
+  for (auto& points : track_points) {
+    for (auto& [xyz, track] : points) {
+      num_tris += track.Length();
+      const point3D_t point3D_id = obs_manager_->AddPoint3D(xyz, track);
+      modified_point3D_ids_.insert(point3D_id);
+    }
+    points.clear();
+  }
+
+  return num_tris;
+}
+
 size_t IncrementalTriangulator::CompleteImage(const Options& options,
                                               const image_t image_id) {
   THROW_CHECK(options.Check());
@@ -249,58 +564,46 @@ size_t IncrementalTriangulator::CompleteTracks(
     const Options& options, const std::unordered_set<point3D_t>& point3D_ids) {
   THROW_CHECK(options.Check());
 
-  size_t num_completed = 0;
-
   ClearCaches();
 
-  for (const point3D_t point3D_id : point3D_ids) {
-    num_completed += Complete(options, point3D_id);
-  }
-
-  return num_completed;
+  return CompleteTracksParallel(
+      options,
+      std::vector<point3D_t>(point3D_ids.begin(), point3D_ids.end()));
 }
 
 size_t IncrementalTriangulator::CompleteAllTracks(const Options& options) {
   THROW_CHECK(options.Check());
 
-  size_t num_completed = 0;
-
   ClearCaches();
 
-  for (const point3D_t point3D_id : reconstruction_.Point3DIds()) {
-    num_completed += Complete(options, point3D_id);
-  }
-
-  return num_completed;
+  const std::unordered_set<point3D_t> point3D_ids =
+      reconstruction_.Point3DIds();
+  return CompleteTracksParallel(
+      options,
+      std::vector<point3D_t>(point3D_ids.begin(), point3D_ids.end()));
 }
 
 size_t IncrementalTriangulator::MergeTracks(
     const Options& options, const std::unordered_set<point3D_t>& point3D_ids) {
   THROW_CHECK(options.Check());
 
-  size_t num_merged = 0;
-
   ClearCaches();
 
-  for (const point3D_t point3D_id : point3D_ids) {
-    num_merged += Merge(options, point3D_id);
-  }
-
-  return num_merged;
+  return MergeTracksParallel(
+      options,
+      std::vector<point3D_t>(point3D_ids.begin(), point3D_ids.end()));
 }
 
 size_t IncrementalTriangulator::MergeAllTracks(const Options& options) {
   THROW_CHECK(options.Check());
 
-  size_t num_merged = 0;
-
   ClearCaches();
 
-  for (const point3D_t point3D_id : reconstruction_.Point3DIds()) {
-    num_merged += Merge(options, point3D_id);
-  }
-
-  return num_merged;
+  const std::unordered_set<point3D_t> point3D_ids =
+      reconstruction_.Point3DIds();
+  return MergeTracksParallel(
+      options,
+      std::vector<point3D_t>(point3D_ids.begin(), point3D_ids.end()));
 }
 
 size_t IncrementalTriangulator::Retriangulate(const Options& options) {
@@ -404,6 +707,16 @@ size_t IncrementalTriangulator::Retriangulate(const Options& options) {
   return num_tris;
 }
 
+const std::unordered_map<image_pair_t, int>&
+IncrementalTriangulator::RetriangulationTrials() const {
+  return re_num_trials_;
+}
+
+void IncrementalTriangulator::SetRetriangulationTrials(
+    std::unordered_map<image_pair_t, int> re_num_trials) {
+  re_num_trials_ = std::move(re_num_trials);
+}
+
 void IncrementalTriangulator::AddModifiedPoint3D(const point3D_t point3D_id) {
   modified_point3D_ids_.insert(point3D_id);
 }
@@ -620,37 +933,11 @@ size_t IncrementalTriangulator::Merge(const Options& options,
       const Point3D& corr_point3D =
           reconstruction_.Point3D(corr_point2D.point3D_id);
 
-      // Weighted average of point locations, depending on track length.
-      const Eigen::Vector3d merged_xyz =
-          (point3D.track.Length() * point3D.xyz +
-           corr_point3D.track.Length() * corr_point3D.xyz) /
-          (point3D.track.Length() + corr_point3D.track.Length());
-
-      // Count number of inlier track elements of the merged track.
-      bool merge_success = true;
-      for (const Track* track : {&point3D.track, &corr_point3D.track}) {
-        for (const auto& test_track_el : track->Elements()) {
-          const Image& test_image =
-              reconstruction_.Image(test_track_el.image_id);
-          const Camera& test_camera = *test_image.CameraPtr();
-          const Point2D& test_point2D =
-              test_image.Point2D(test_track_el.point2D_idx);
-          if (CalculateSquaredReprojectionError(test_point2D.xy,
-                                                merged_xyz,
-                                                test_image.CamFromWorld(),
-                                                test_camera) >
-              max_squared_reproj_error) {
-            merge_success = false;
-            break;
-          }
-        }
-        if (!merge_success) {
-          break;
-        }
-      }
-
       // Only accept merge if all track elements are inliers.
-      if (merge_success) {
+      if (IsMergeConsistent(reconstruction_,
+                            point3D,
+                            corr_point3D,
+                            max_squared_reproj_error)) {
         const size_t num_merged =
             point3D.track.Length() + corr_point3D.track.Length();
 
@@ -691,7 +978,8 @@ size_t IncrementalTriangulator::Complete(const Options& options,
 
   // Reuse member-held BFS scratch buffers across Complete() invocations to
   // avoid per-call heap allocations.
-  complete_curr_queue_ = point3D.track.Elements();
+  complete_curr_queue_.assign(point3D.track.Elements().begin(),
+                              point3D.track.Elements().end());
   complete_next_queue_.clear();
   complete_visited_.clear();
 
@@ -764,6 +1052,247 @@ size_t IncrementalTriangulator::Complete(const Options& options,
   return num_completed;
 }
 
+size_t IncrementalTriangulator::CompleteTracksParallel(
+    const Options& options, const std::vector<point3D_t>& point3D_ids) {
+  CacheCameraBogusParams(options);
+
+  const int num_threads = GetEffectiveNumThreads(options.num_threads);
+  std::unique_ptr<ThreadPool> thread_pool;
+  if (num_threads > 1 && point3D_ids.size() > 1) {
+    thread_pool = std::make_unique<ThreadPool>(num_threads);
+  }
+
+  size_t num_completed = 0;
+
+  std::vector<std::vector<CompleteCandidate>> candidates;
+  std::vector<char> committed;
+  for (size_t chunk_begin = 0; chunk_begin < point3D_ids.size();
+       chunk_begin += kParallelChunkSize) {
+    const size_t chunk_size =
+        std::min(kParallelChunkSize, point3D_ids.size() - chunk_begin);
+
+    candidates.resize(chunk_size);
+    ParallelFor(thread_pool.get(), chunk_size, [&](const size_t i) {
+      FindCompleteCandidates(
+          options, point3D_ids[chunk_begin + i], &candidates[i]);
+    });
+
+    // Commit the candidates in order. Observations claimed by previously
+    // completed 3D points are skipped together with the candidates found
+    // through them, as in sequential completion.
+    for (size_t i = 0; i < chunk_size; ++i) {
+      const point3D_t point3D_id = point3D_ids[chunk_begin + i];
+      committed.assign(candidates[i].size(), false);
+      for (size_t j = 0; j < candidates[i].size(); ++j) {
+        const CompleteCandidate& candidate = candidates[i][j];
+        if (candidate.parent_idx >= 0 && !committed[candidate.parent_idx]) {
+          continue;
+        }
+
+        const Point2D& point2D =
+            reconstruction_.Image(candidate.track_el.image_id)
+                .Point2D(candidate.track_el.point2D_idx);
+        if (point2D.HasPoint3D()) {
+          continue;
+        }
+
+        obs_manager_->AddObservation(point3D_id, candidate.track_el);
+        modified_point3D_ids_.insert(point3D_id);
+        committed[j] = true;
+        num_completed += 1;
+      }
+    }
+  }
+
+  return num_completed;
+}
+
+size_t IncrementalTriangulator::MergeTracksParallel(
+    const Options& options, const std::vector<point3D_t>& point3D_ids) {
+  const int num_threads = GetEffectiveNumThreads(options.num_threads);
+  std::unique_ptr<ThreadPool> thread_pool;
+  if (num_threads > 1 && point3D_ids.size() > 1) {
+    thread_pool = std::make_unique<ThreadPool>(num_threads);
+  }
+
+  size_t num_merged = 0;
+
+  std::vector<point3D_t> merge_point3D_ids;
+  for (size_t chunk_begin = 0; chunk_begin < point3D_ids.size();
+       chunk_begin += kParallelChunkSize) {
+    const size_t chunk_size =
+        std::min(kParallelChunkSize, point3D_ids.size() - chunk_begin);
+
+    merge_point3D_ids.resize(chunk_size);
+    ParallelFor(thread_pool.get(), chunk_size, [&](const size_t i) {
+      merge_point3D_ids[i] =
+          FindMergeCandidate(options, point3D_ids[chunk_begin + i]);
+    });
+
+    for (size_t i = 0; i < chunk_size; ++i) {
+      const point3D_t point3D_id = point3D_ids[chunk_begin + i];
+      const point3D_t merge_point3D_id = merge_point3D_ids[i];
+      if (merge_point3D_id == kInvalidPoint3DId ||
+          !reconstruction_.ExistsPoint3D(point3D_id)) {
+        continue;
+      }
+
+      // The candidate was merged into another 3D point in the meantime.
+      if (!reconstruction_.ExistsPoint3D(merge_point3D_id)) {
+        num_merged += Merge(options, point3D_id);
+        continue;
+      }
+
+      merge_trials_.emplace(std::min(point3D_id, merge_point3D_id),
+                            std::max(point3D_id, merge_point3D_id));
+
+      const size_t num_merged_observations =
+          reconstruction_.Point3D(point3D_id).track.Length() +
+          reconstruction_.Point3D(merge_point3D_id).track.Length();
+
+      const point3D_t merged_point3D_id =
+          obs_manager_->MergePoints3D(point3D_id, merge_point3D_id);
+
+      modified_point3D_ids_.erase(point3D_id);
+      modified_point3D_ids_.erase(merge_point3D_id);
+      modified_point3D_ids_.insert(merged_point3D_id);
+
+      const size_t num_merged_recursive = Merge(options, merged_point3D_id);
+      if (num_merged_recursive > 0) {
+        num_merged += num_merged_recursive;
+      } else {
+        num_merged += num_merged_observations;
+      }
+    }
+  }
+
+  return num_merged;
+}
+
+void IncrementalTriangulator::FindCompleteCandidates(
+    const Options& options,
+    const point3D_t point3D_id,
+    std::vector<CompleteCandidate>* candidates) const {
+  candidates->clear();
+
+  if (!reconstruction_.ExistsPoint3D(point3D_id)) {
+    return;
+  }
+
+  const double max_squared_reproj_error =
+      options.complete_max_reproj_error * options.complete_max_reproj_error;
+
+  const Point3D& point3D = reconstruction_.Point3D(point3D_id);
+
+  // Queue elements with the index of their candidate.
+  std::vector<std::pair<TrackElement, int>> curr_queue;
+  std::vector<std::pair<TrackElement, int>> next_queue;
+  std::unordered_set<std::pair<image_t, point2D_t>> visited;
+  curr_queue.reserve(point3D.track.Length());
+  for (const TrackElement& el : point3D.track.Elements()) {
+    curr_queue.emplace_back(el, -1);
+    visited.insert(std::make_pair(el.image_id, el.point2D_idx));
+  }
+
+  const int max_transitivity = options.complete_max_transitivity;
+  for (int transitivity = 1; transitivity <= max_transitivity; ++transitivity) {
+    while (!curr_queue.empty()) {
+      const auto [queue_elem, queue_elem_idx] = curr_queue.back();
+      curr_queue.pop_back();
+
+      const auto corr_range = correspondence_graph_->FindCorrespondences(
+          queue_elem.image_id, queue_elem.point2D_idx);
+      for (const auto* corr = corr_range.beg; corr < corr_range.end; ++corr) {
+        if (!visited.insert(std::make_pair(corr->image_id, corr->point2D_idx))
+                 .second) {
+          continue;
+        }
+
+        const Image& image = reconstruction_.Image(corr->image_id);
+        if (!image.HasPose()) {
+          continue;
+        }
+
+        const Point2D& point2D = image.Point2D(corr->point2D_idx);
+        if (point2D.HasPoint3D()) {
+          continue;
+        }
+
+        if (HasCachedCameraBogusParams(image.CameraId())) {
+          continue;
+        }
+
+        if (CalculateSquaredReprojectionError(point2D.xy,
+                                              point3D.xyz,
+                                              image.CamFromWorld(),
+                                              *image.CameraPtr()) >
+            max_squared_reproj_error) {
+          continue;
+        }
+
+        const TrackElement track_el(corr->image_id, corr->point2D_idx);
+        candidates->push_back({track_el, queue_elem_idx});
+
+        // Recursively complete track for this new correspondence.
+        if (transitivity < max_transitivity) {
+          next_queue.emplace_back(track_el,
+                                  static_cast<int>(candidates->size() - 1));
+        }
+      }
+    }
+
+    if (next_queue.empty()) {
+      break;
+    }
+
+    std::swap(curr_queue, next_queue);
+  }
+}
+
+point3D_t IncrementalTriangulator::FindMergeCandidate(
+    const Options& options, const point3D_t point3D_id) const {
+  if (!reconstruction_.ExistsPoint3D(point3D_id)) {
+    return kInvalidPoint3DId;
+  }
+
+  const double max_squared_reproj_error =
+      options.merge_max_reproj_error * options.merge_max_reproj_error;
+
+  const Point3D& point3D = reconstruction_.Point3D(point3D_id);
+
+  for (const auto& track_el : point3D.track.Elements()) {
+    const auto corr_range = correspondence_graph_->FindCorrespondences(
+        track_el.image_id, track_el.point2D_idx);
+    for (const auto* corr = corr_range.beg; corr < corr_range.end; ++corr) {
+      const Image& image = reconstruction_.Image(corr->image_id);
+      if (!image.HasPose()) {
+        continue;
+      }
+
+      const Point2D& corr_point2D = image.Point2D(corr->point2D_idx);
+      if (!corr_point2D.HasPoint3D() || corr_point2D.point3D_id == point3D_id) {
+        continue;
+      }
+
+      if (merge_trials_.count(
+              std::make_pair(std::min(point3D_id, corr_point2D.point3D_id),
+                             std::max(point3D_id, corr_point2D.point3D_id))) >
+          0) {
+        continue;
+      }
+
+      if (IsMergeConsistent(reconstruction_,
+                            point3D,
+                            reconstruction_.Point3D(corr_point2D.point3D_id),
+                            max_squared_reproj_error)) {
+        return corr_point2D.point3D_id;
+      }
+    }
+  }
+
+  return kInvalidPoint3DId;
+}
+
 bool IncrementalTriangulator::HasCameraBogusParams(const Options& options,
                                                    const Camera& camera) {
   const auto it = camera_has_bogus_params_.find(camera.camera_id);
@@ -779,6 +1308,17 @@ bool IncrementalTriangulator::HasCameraBogusParams(const Options& options,
   }
 }
 
+void IncrementalTriangulator::CacheCameraBogusParams(const Options& options) {
+  for (const auto& [_, camera] : reconstruction_.Cameras()) {
+    HasCameraBogusParams(options, camera);
+  }
+}
+
+bool IncrementalTriangulator::HasCachedCameraBogusParams(
+    const camera_t camera_id) const {
+  return camera_has_bogus_params_.at(camera_id);
+}
+
 std::ostream& operator<<(std::ostream& stream,
                          const IncrementalTriangulator& triangulator) {
   stream << "IncrementalTriangulator(reconstruction="
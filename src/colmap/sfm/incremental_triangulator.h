@@ -34,6 +34,7 @@
 #include "colmap/sfm/observation_manager.h"
 
 #include <memory>
+#include <vector>
 
 namespace colmap {
 
@@ -86,6 +87,11 @@ class IncrementalTriangulator {
     // PRNG seed for all stochastic methods during triangulation.
     int random_seed = -1;
 
+    // Number of threads to find candidates for track completion and merging.
+    // The reconstruction is always modified sequentially, such that the
+    // results do not depend on the number of threads.
+    int num_threads = -1;
+
     bool Check() const;
   };
 
@@ -105,6 +111,14 @@ class IncrementalTriangulator {
   // in the associated reconstruction.
   size_t TriangulateImage(const Options& options, image_t image_id);
 
+  // Triangulate the observations of all registered images at once, which is
+  // much faster than triangulating image by image for models with known
+  // poses. Candidate tracks are the connected components of the untriangulated
+  // observations in the correspondence graph, which are found and then
+  // triangulated concurrently. Existing 3D points are not modified.
+  // Returns the number of triangulated observations.
+  size_t TriangulateAllImages(const Options& options);
+
   // Complete triangulations for image. Tries to create new tracks for not
   // yet triangulated observations and tries to complete existing tracks.
   // Returns the number of completed observations.
@@ -139,6 +153,12 @@ class IncrementalTriangulator {
   // inlier matches between the image pair.
   size_t Retriangulate(const Options& options);
 
+  // Number of retriangulation trials per image pair, e.g., to checkpoint and
+  // restore the state of the triangulator.
+  const std::unordered_map<image_pair_t, int>& RetriangulationTrials() const;
+  void SetRetriangulationTrials(
+      std::unordered_map<image_pair_t, int> re_num_trials);
+
   // Indicate that a 3D point has been modified.
   void AddModifiedPoint3D(point3D_t point3D_id);
 
@@ -188,9 +208,41 @@ class IncrementalTriangulator {
   // Try to transitively complete the track of a 3D point.
   size_t Complete(const Options& options, point3D_t point3D_id);
 
+  // Candidate observation to complete the track of a 3D point. The parent is
+  // the index of the candidate, through which it was found, or -1 if it was
+  // found through an existing track element.
+  struct CompleteCandidate {
+    TrackElement track_el;
+    int parent_idx;
+  };
+
+  // Complete and merge the tracks of multiple 3D points. Candidates are found
+  // concurrently for chunks of 3D points and then committed sequentially in
+  // the given order, if they do not conflict with earlier commits.
+  size_t CompleteTracksParallel(const Options& options,
+                                const std::vector<point3D_t>& point3D_ids);
+  size_t MergeTracksParallel(const Options& options,
+                             const std::vector<point3D_t>& point3D_ids);
+
+  // Find candidate observations to transitively complete the track of a 3D
+  // point without modifying the reconstruction.
+  void FindCompleteCandidates(const Options& options,
+                              point3D_t point3D_id,
+                              std::vector<CompleteCandidate>* candidates) const;
+
+  // Find the first 3D point that can be merged with the given 3D point
+  // without modifying the reconstruction.
+  point3D_t FindMergeCandidate(const Options& options,
+                               point3D_t point3D_id) const;
+
   // Check if camera has bogus parameters and cache the result.
   bool HasCameraBogusParams(const Options& options, const Camera& camera);
 
+  // Cache the bogus parameter checks of all cameras, such that they can be
+  // looked up concurrently using `HasCachedCameraBogusParams`.
+  void CacheCameraBogusParams(const Options& options);
+  bool HasCachedCameraBogusParams(camera_t camera_id) const;
+
   // Database cache for the reconstruction. Used to retrieve correspondence
   // information for triangulation.
   const std::shared_ptr<const CorrespondenceGraph> correspondence_graph_;
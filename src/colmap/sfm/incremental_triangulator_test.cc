@@ -184,6 +184,80 @@ TEST(IncrementalTriangulator, TriangulateImage) {
             synthetic_options.num_points3D * reconstruction.NumRegImages());
 }
 
+TEST(IncrementalTriangulator, TriangulateAllImages) {
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_options;
+  synthetic_options.num_rigs = 1;
+  synthetic_options.num_cameras_per_rig = 1;
+  synthetic_options.num_frames_per_rig = 5;
+  synthetic_options.num_points3D = 50;
+  SynthesizeDataset(synthetic_options, &reconstruction, database.get());
+
+  auto cache = DatabaseCache::Create(*database, DatabaseCache::Options());
+
+  DeleteAllPoints3D(reconstruction);
+
+  for (const int num_threads : {1, 4}) {
+    Reconstruction test_reconstruction = reconstruction;
+    IncrementalTriangulator triangulator(cache->CorrespondenceGraph(),
+                                         test_reconstruction);
+    IncrementalTriangulator::Options options;
+    options.num_threads = num_threads;
+    EXPECT_EQ(triangulator.TriangulateAllImages(options),
+              synthetic_options.num_points3D *
+                  test_reconstruction.NumRegImages());
+    EXPECT_EQ(test_reconstruction.NumPoints3D(),
+              synthetic_options.num_points3D);
+    EXPECT_EQ(triangulator.GetModifiedPoints3D().size(),
+              synthetic_options.num_points3D);
+    for (const auto& [_, point3D] : test_reconstruction.Points3D()) {
+      EXPECT_EQ(point3D.track.Length(), test_reconstruction.NumRegImages());
+    }
+  }
+}
+
+TEST(IncrementalTriangulator, TriangulateAllImagesKeepsExistingPoints) {
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_options;
+  synthetic_options.num_rigs = 1;
+  synthetic_options.num_cameras_per_rig = 1;
+  synthetic_options.num_frames_per_rig = 5;
+  synthetic_options.num_points3D = 50;
+  SynthesizeDataset(synthetic_options, &reconstruction, database.get());
+
+  auto cache = DatabaseCache::Create(*database, DatabaseCache::Options());
+
+  // Only keep the first half of the points.
+  std::vector<point3D_t> point3D_ids;
+  for (const auto point3D_id : reconstruction.Point3DIds()) {
+    point3D_ids.push_back(point3D_id);
+  }
+  std::sort(point3D_ids.begin(), point3D_ids.end());
+  point3D_ids.resize(point3D_ids.size() / 2);
+  for (const point3D_t point3D_id : point3D_ids) {
+    reconstruction.DeletePoint3D(point3D_id);
+  }
+  const std::unordered_set<point3D_t> existing_point3D_ids =
+      reconstruction.Point3DIds();
+
+  IncrementalTriangulator triangulator(cache->CorrespondenceGraph(),
+                                       reconstruction);
+  EXPECT_EQ(
+      triangulator.TriangulateAllImages(IncrementalTriangulator::Options()),
+      point3D_ids.size() * reconstruction.NumRegImages());
+  EXPECT_EQ(reconstruction.NumPoints3D(), synthetic_options.num_points3D);
+  for (const point3D_t point3D_id : existing_point3D_ids) {
+    EXPECT_EQ(reconstruction.Point3D(point3D_id).track.Length(),
+              reconstruction.NumRegImages());
+  }
+  EXPECT_EQ(reconstruction.ComputeNumObservations(),
+            synthetic_options.num_points3D * reconstruction.NumRegImages());
+}
+
 TEST(IncrementalTriangulator, CompleteImage) {
   auto database = Database::Open(kInMemorySqliteDatabasePath);
 
@@ -326,6 +400,50 @@ TEST(IncrementalTriangulator, MergeAllTracks) {
   EXPECT_EQ(reconstruction.NumPoints3D(), synthetic_options.num_points3D);
 }
 
+TEST(IncrementalTriangulator, CompleteAndMergeAllTracksMultiThreaded) {
+  auto database = Database::Open(kInMemorySqliteDatabasePath);
+
+  Reconstruction reconstruction;
+  SyntheticDatasetOptions synthetic_options;
+  synthetic_options.num_rigs = 1;
+  synthetic_options.num_cameras_per_rig = 1;
+  synthetic_options.num_frames_per_rig = 8;
+  synthetic_options.num_points3D = 200;
+  SynthesizeDataset(synthetic_options, &reconstruction, database.get());
+
+  auto cache = DatabaseCache::Create(*database, DatabaseCache::Options());
+
+  // Split some of the incomplete tracks, such that both parts compete for
+  // the same missing observation during completion.
+  DeleteOneObservationFromEachTrack(reconstruction);
+  std::vector<point3D_t> split_point3D_ids;
+  for (const auto& [point3D_id, _] : reconstruction.Points3D()) {
+    if (split_point3D_ids.size() < 10) {
+      split_point3D_ids.push_back(point3D_id);
+    }
+  }
+  for (const point3D_t point3D_id : split_point3D_ids) {
+    SplitPoint3D(reconstruction, point3D_id);
+  }
+
+  for (const int num_threads : {1, 4}) {
+    Reconstruction test_reconstruction = reconstruction;
+    IncrementalTriangulator triangulator(cache->CorrespondenceGraph(),
+                                         test_reconstruction);
+    IncrementalTriangulator::Options options;
+    options.num_threads = num_threads;
+    EXPECT_EQ(triangulator.CompleteAllTracks(options),
+              synthetic_options.num_points3D);
+    EXPECT_EQ(triangulator.MergeAllTracks(options),
+              10 * test_reconstruction.NumRegImages());
+    EXPECT_EQ(test_reconstruction.NumPoints3D(),
+              synthetic_options.num_points3D);
+    EXPECT_EQ(
+        test_reconstruction.ComputeNumObservations(),
+        synthetic_options.num_points3D * test_reconstruction.NumRegImages());
+  }
+}
+
 TEST(IncrementalTriangulator, Retriangulate) {
   auto database = Database::Open(kInMemorySqliteDatabasePath);
 
@@ -32,12 +32,20 @@
 #include "colmap/estimators/alignment.h"
 #include "colmap/geometry/triangulation.h"
 #include "colmap/math/math.h"
+#include "colmap/math/union_find.h"
 #include "colmap/scene/camera.h"
 #include "colmap/scene/projection.h"
 #include "colmap/util/logging.h"
+#include "colmap/util/misc.h"
+#include "colmap/util/threading.h"
 
+#include <algorithm>
 #include <cassert>
 #include <limits>
+#include <map>
+#include <numeric>
+#include <string>
+#include <unordered_map>
 
 namespace colmap {
 
@@ -53,6 +61,186 @@ bool MergeAndFilterReconstructions(const double max_reproj_error,
   return true;
 }
 
+bool ReconstructionMergingOptions::Check() const {
+  CHECK_OPTION_GT(max_reproj_error, 0);
+  CHECK_OPTION_GE(min_num_common_images, 3);
+  CHECK_OPTION_GE(num_threads, -1);
+  return true;
+}
+
+std::vector<std::shared_ptr<Reconstruction>> MergeAndFilterReconstructions(
+    const ReconstructionMergingOptions& options,
+    const std::vector<std::shared_ptr<Reconstruction>>& reconstructions) {
+  THROW_CHECK(options.Check());
+
+  const size_t num_reconstructions = reconstructions.size();
+
+  // Build the overlap graph from the common registered images, which are
+  // matched by name as in the alignment.
+  std::unordered_map<std::string, std::vector<size_t>> image_name_to_idxs;
+  for (size_t idx = 0; idx < num_reconstructions; ++idx) {
+    for (const image_t image_id : reconstructions[idx]->RegImageIds()) {
+      image_name_to_idxs[reconstructions[idx]->Image(image_id).Name()]
+          .push_back(idx);
+    }
+  }
+  std::map<std::pair<size_t, size_t>, int> num_common_images;
+  for (const auto& [_, idxs] : image_name_to_idxs) {
+    for (size_t i = 0; i < idxs.size(); ++i) {
+      for (size_t j = i + 1; j < idxs.size(); ++j) {
+        ++num_common_images[std::make_pair(idxs[i], idxs[j])];
+      }
+    }
+  }
+
+  struct Edge {
+    size_t idx1;
+    size_t idx2;
+    int num_common_images;
+    Sim3d idx1_from_idx2;
+    bool aligned = false;
+  };
+  std::vector<Edge> edges;
+  for (const auto& [idx_pair, num_common] : num_common_images) {
+    if (num_common >= options.min_num_common_images) {
+      Edge& edge = edges.emplace_back();
+      edge.idx1 = idx_pair.first;
+      edge.idx2 = idx_pair.second;
+      edge.num_common_images = num_common;
+    }
+  }
+
+  // Align all overlapping pairs concurrently.
+  ThreadPool thread_pool(GetEffectiveNumThreads(options.num_threads));
+  for (Edge& edge : edges) {
+    thread_pool.AddTask([&reconstructions, &options, &edge]() {
+      edge.aligned = AlignReconstructionsViaReprojections(
+          *reconstructions[edge.idx2],
+          *reconstructions[edge.idx1],
+          /*min_inlier_observations=*/0.3,
+          options.max_reproj_error,
+          &edge.idx1_from_idx2);
+    });
+  }
+  thread_pool.Wait();
+
+  // Select the maximum spanning tree of the aligned pairs.
+  std::stable_sort(
+      edges.begin(), edges.end(), [](const Edge& edge1, const Edge& edge2) {
+        return edge1.num_common_images > edge2.num_common_images;
+      });
+  UnionFind<size_t> spanning_tree_components;
+  std::vector<Edge> tree_edges;
+  int num_aligned_edges = 0;
+  for (const Edge& edge : edges) {
+    if (!edge.aligned) {
+      continue;
+    }
+    ++num_aligned_edges;
+    if (spanning_tree_components.Find(edge.idx1) !=
+        spanning_tree_components.Find(edge.idx2)) {
+      spanning_tree_components.Union(edge.idx1, edge.idx2);
+      tree_edges.push_back(edge);
+    }
+  }
+  LOG(INFO) << StringPrintf("Aligned %d of %d overlapping pairs",
+                            num_aligned_edges,
+                            static_cast<int>(edges.size()));
+
+  // Each input reconstruction is merged into the reconstruction of its root,
+  // whose coordinate frame is kept.
+  std::vector<size_t> root_idxs(num_reconstructions);
+  std::iota(root_idxs.begin(), root_idxs.end(), 0);
+  std::vector<Sim3d> root_from_members(num_reconstructions);
+
+  // Merge along the tree edges, where each level merges a set of edges
+  // without common reconstructions concurrently.
+  while (!tree_edges.empty()) {
+    struct Merge {
+      size_t src_idx;
+      size_t tgt_idx;
+      Sim3d tgt_from_src;
+      int num_src_reg_images;
+      int num_tgt_reg_images;
+    };
+    std::vector<Merge> merges;
+    std::vector<bool> is_merging(num_reconstructions, false);
+    std::vector<Edge> remaining_tree_edges;
+    for (const Edge& edge : tree_edges) {
+      const size_t root_idx1 = root_idxs[edge.idx1];
+      const size_t root_idx2 = root_idxs[edge.idx2];
+      if (is_merging[root_idx1] || is_merging[root_idx2]) {
+        remaining_tree_edges.push_back(edge);
+        continue;
+      }
+      is_merging[root_idx1] = true;
+      is_merging[root_idx2] = true;
+      const Sim3d root1_from_root2 =
+          root_from_members[edge.idx1] * edge.idx1_from_idx2 *
+          Inverse(root_from_members[edge.idx2]);
+      // Merge the smaller into the larger reconstruction.
+      Merge& merge = merges.emplace_back();
+      if (reconstructions[root_idx1]->NumRegImages() >=
+          reconstructions[root_idx2]->NumRegImages()) {
+        merge.src_idx = root_idx2;
+        merge.tgt_idx = root_idx1;
+        merge.tgt_from_src = root1_from_root2;
+      } else {
+        merge.src_idx = root_idx1;
+        merge.tgt_idx = root_idx2;
+        merge.tgt_from_src = Inverse(root1_from_root2);
+      }
+      merge.num_src_reg_images =
+          reconstructions[merge.src_idx]->NumRegImages();
+      merge.num_tgt_reg_images =
+          reconstructions[merge.tgt_idx]->NumRegImages();
+    }
+    tree_edges = std::move(remaining_tree_edges);
+
+    for (const Merge& merge : merges) {
+      thread_pool.AddTask([&reconstructions, &options, &merge]() {
+        Reconstruction& tgt_reconstruction = *reconstructions[merge.tgt_idx];
+        MergeAlignedReconstructions(merge.tgt_from_src,
+                                    *reconstructions[merge.src_idx],
+                                    tgt_reconstruction);
+        ObservationManager(tgt_reconstruction)
+            .FilterAllPoints3D(options.max_reproj_error,
+                               /*min_tri_angle=*/0);
+      });
+    }
+    thread_pool.Wait();
+
+    for (const Merge& merge : merges) {
+      LOG(INFO) << StringPrintf(
+          "=> Merged reconstructions with %d and %d images into %d images",
+          merge.num_tgt_reg_images,
+          merge.num_src_reg_images,
+          reconstructions[merge.tgt_idx]->NumRegImages());
+      for (size_t idx = 0; idx < num_reconstructions; ++idx) {
+        if (root_idxs[idx] == merge.src_idx) {
+          root_idxs[idx] = merge.tgt_idx;
+          root_from_members[idx] = merge.tgt_from_src * root_from_members[idx];
+        }
+      }
+    }
+  }
+
+  std::vector<std::shared_ptr<Reconstruction>> merged_reconstructions;
+  for (size_t idx = 0; idx < num_reconstructions; ++idx) {
+    if (root_idxs[idx] == idx) {
+      merged_reconstructions.push_back(reconstructions[idx]);
+    }
+  }
+  std::stable_sort(merged_reconstructions.begin(),
+                   merged_reconstructions.end(),
+                   [](const std::shared_ptr<Reconstruction>& reconstruction1,
+                      const std::shared_ptr<Reconstruction>& reconstruction2) {
+                     return reconstruction1->NumRegImages() >
+                            reconstruction2->NumRegImages();
+                   });
+  return merged_reconstructions;
+}
+
 ObservationManager::ObservationManager(
     class Reconstruction& reconstruction,
     std::shared_ptr<const CorrespondenceGraph> correspondence_graph)
@@ -72,7 +260,7 @@ ObservationManager::ObservationManager(
   // Add image stats.
   image_stats_.reserve(reconstruction_.NumImages());
   for (const auto& [image_id, image] : reconstruction_.Images()) {
-    image_stats_.emplace(image_id, InitImageStat(image_id, image));
+    EmplaceImageStat(image_id, InitImageStat(image_id, image));
   }
 
   // If an existing model was loaded from disk and there were already images
@@ -89,7 +277,7 @@ ObservationManager::ObservationManager(
         const auto corr_range =
             correspondence_graph_->FindCorrespondences(image_id, point2D_idx);
         for (const auto* corr = corr_range.beg; corr < corr_range.end; ++corr) {
-          image_stats_[corr->image_id].num_visible_correspondences += 1;
+          GetImageStat(corr->image_id).num_visible_correspondences += 1;
         }
       }
     }
@@ -97,7 +285,7 @@ ObservationManager::ObservationManager(
 }
 
 void ObservationManager::AddImage(const image_t image_id) {
-  THROW_CHECK(image_stats_.find(image_id) == image_stats_.end())
+  THROW_CHECK(!ExistsImageStat(image_id))
       << "Image " << image_id << " already exists in the ObservationManager";
   THROW_CHECK(reconstruction_.ExistsImage(image_id))
       << "Image " << image_id << " must be added to the Reconstruction first";
@@ -107,14 +295,15 @@ void ObservationManager::AddImage(const image_t image_id) {
         << " must be added to the CorrespondenceGraph first";
   }
   const Image& image = reconstruction_.Image(image_id);
-  image_stats_.emplace(image_id, InitImageStat(image_id, image));
+  EmplaceImageStat(image_id, InitImageStat(image_id, image));
 
   if (correspondence_graph_) {
     // Add image pair stats for all pairs involving the new image and refresh
     // the cached stats for existing images, whose observation/correspondence
     // counts may have increased when AddTwoViewGeometry added new
     // correspondences.
-    for (auto& [other_image_id, other_stats] : image_stats_) {
+    for (ImageStat& other_stats : image_stats_) {
+      const image_t other_image_id = other_stats.image_id;
       if (other_image_id == image_id) {
         continue;
       }
@@ -163,6 +352,7 @@ ObservationManager::ImageStat ObservationManager::InitImageStat(
     const image_t image_id, const Image& image) const {
   const Camera& camera = *image.CameraPtr();
   ImageStat image_stat;
+  image_stat.image_id = image_id;
   image_stat.point3D_visibility_pyramid = VisibilityPyramid(
       kNumPoint3DVisibilityPyramidLevels, camera.width, camera.height);
   image_stat.num_visible_correspondences = 0;
@@ -177,18 +367,44 @@ ObservationManager::ImageStat ObservationManager::InitImageStat(
   return image_stat;
 }
 
+void ObservationManager::EmplaceImageStat(const image_t image_id,
+                                          ImageStat image_stat) {
+  const size_t idx = image_stats_.size();
+  image_stats_.push_back(std::move(image_stat));
+  // Grow the dense remap only if the identifier is close to its current size,
+  // so that sparse identifiers do not allocate a table proportional to their
+  // magnitude.
+  if (image_id < image_stat_idxs_.size()) {
+    image_stat_idxs_[image_id] = idx;
+  } else if (image_id <= 4 * image_stats_.size() + 1024) {
+    image_stat_idxs_.resize(image_id + 1, kInvalidImageStatIdx);
+    image_stat_idxs_[image_id] = idx;
+  } else {
+    sparse_image_stat_idxs_.emplace(image_id, idx);
+  }
+}
+
 void ObservationManager::IncrementCorrespondenceHasPoint3D(
     const image_t image_id, const point2D_t point2D_idx) {
   const Image& image = reconstruction_.Image(image_id);
-  const Point2D& point2D = image.Point2D(point2D_idx);
-  ImageStat& stats = image_stats_.at(image_id);
+  ImageStat& stats = GetImageStat(image_id);
 
+  // Images whose points2D are not loaded yet were initialized without them.
+  if (point2D_idx >= stats.num_correspondences_have_point3D.size()) {
+    stats.num_correspondences_have_point3D.resize(point2D_idx + 1, 0);
+  }
   stats.num_correspondences_have_point3D[point2D_idx] += 1;
   if (stats.num_correspondences_have_point3D[point2D_idx] == 1) {
     stats.num_visible_points3D += 1;
+    if (stats.num_visible_points3D == 1 && !image.HasPose()) {
+      unregistered_visible_image_ids_.insert(image_id);
+    }
   }
 
-  stats.point3D_visibility_pyramid.SetPoint(point2D.xy(0), point2D.xy(1));
+  if (point2D_idx < image.NumPoints2D()) {
+    const Point2D& point2D = image.Point2D(point2D_idx);
+    stats.point3D_visibility_pyramid.SetPoint(point2D.xy(0), point2D.xy(1));
+  }
 
   THROW_CHECK_LE(stats.num_visible_points3D, stats.num_observations);
 }
@@ -196,22 +412,48 @@ void ObservationManager::IncrementCorrespondenceHasPoint3D(
 void ObservationManager::DecrementCorrespondenceHasPoint3D(
     const image_t image_id, const point2D_t point2D_idx) {
   const Image& image = reconstruction_.Image(image_id);
-  const Point2D& point2D = image.Point2D(point2D_idx);
-  ImageStat& stats = image_stats_.at(image_id);
+  ImageStat& stats = GetImageStat(image_id);
 
+  THROW_CHECK_LT(point2D_idx, stats.num_correspondences_have_point3D.size());
   THROW_CHECK_GT(stats.num_correspondences_have_point3D[point2D_idx], 0)
       << "Correspondence counter underflow for image " << image_id
       << " point2D " << point2D_idx;
   stats.num_correspondences_have_point3D[point2D_idx] -= 1;
   if (stats.num_correspondences_have_point3D[point2D_idx] == 0) {
     stats.num_visible_points3D -= 1;
+    if (stats.num_visible_points3D == 0) {
+      unregistered_visible_image_ids_.erase(image_id);
+    }
   }
 
-  stats.point3D_visibility_pyramid.ResetPoint(point2D.xy(0), point2D.xy(1));
+  if (point2D_idx < image.NumPoints2D()) {
+    const Point2D& point2D = image.Point2D(point2D_idx);
+    stats.point3D_visibility_pyramid.ResetPoint(point2D.xy(0), point2D.xy(1));
+  }
 
   THROW_CHECK_LE(stats.num_visible_points3D, stats.num_observations);
 }
 
+void ObservationManager::UpdateImagePoints2D(const image_t image_id) {
+  const Image& image = reconstruction_.Image(image_id);
+  THROW_CHECK(!image.HasPose());
+  ImageStat& stats = GetImageStat(image_id);
+
+  const Camera& camera = *image.CameraPtr();
+  stats.point3D_visibility_pyramid = VisibilityPyramid(
+      kNumPoint3DVisibilityPyramidLevels, camera.width, camera.height);
+  const point2D_t num_points2D = std::min<point2D_t>(
+      image.NumPoints2D(), stats.num_correspondences_have_point3D.size());
+  for (point2D_t point2D_idx = 0; point2D_idx < num_points2D; ++point2D_idx) {
+    const Point2D& point2D = image.Point2D(point2D_idx);
+    for (point2D_t i = 0;
+         i < stats.num_correspondences_have_point3D[point2D_idx];
+         ++i) {
+      stats.point3D_visibility_pyramid.SetPoint(point2D.xy(0), point2D.xy(1));
+    }
+  }
+}
+
 void ObservationManager::SetObservationAsTriangulated(
     const image_t image_id,
     const point2D_t point2D_idx,
@@ -228,12 +470,14 @@ void ObservationManager::SetObservationAsTriangulated(
   const auto corr_range =
       correspondence_graph_->FindCorrespondences(image_id, point2D_idx);
   for (const auto* corr = corr_range.beg; corr < corr_range.end; ++corr) {
-    Image& corr_image = reconstruction_.Image(corr->image_id);
-    const Point2D& corr_point2D = corr_image.Point2D(corr->point2D_idx);
+    const Image& corr_image = reconstruction_.Image(corr->image_id);
     IncrementCorrespondenceHasPoint3D(corr->image_id, corr->point2D_idx);
     // Update number of shared 3D points between image pairs and make sure to
     // only count the correspondences once (not twice forward and backward).
-    if (point2D.point3D_id == corr_point2D.point3D_id &&
+    // Images whose points2D are not loaded cannot observe any 3D points.
+    if (corr->point2D_idx < corr_image.NumPoints2D() &&
+        point2D.point3D_id ==
+            corr_image.Point2D(corr->point2D_idx).point3D_id &&
         (is_continued_point3D || image_id < corr->image_id)) {
       const image_pair_t pair_id = ImagePairToPairId(image_id, corr->image_id);
       auto& stats = image_pair_stats_[pair_id];
@@ -259,12 +503,13 @@ void ObservationManager::ResetTriObservations(const image_t image_id,
   const auto corr_range =
       correspondence_graph_->FindCorrespondences(image_id, point2D_idx);
   for (const auto* corr = corr_range.beg; corr < corr_range.end; ++corr) {
-    Image& corr_image = reconstruction_.Image(corr->image_id);
-    const Point2D& corr_point2D = corr_image.Point2D(corr->point2D_idx);
+    const Image& corr_image = reconstruction_.Image(corr->image_id);
     DecrementCorrespondenceHasPoint3D(corr->image_id, corr->point2D_idx);
     // Update number of shared 3D points between image pairs and make sure to
     // only count the correspondences once (not twice forward and backward).
-    if (point2D.point3D_id == corr_point2D.point3D_id &&
+    if (corr->point2D_idx < corr_image.NumPoints2D() &&
+        point2D.point3D_id ==
+            corr_image.Point2D(corr->point2D_idx).point3D_id &&
         (!is_deleted_point3D || image_id < corr->image_id)) {
       const image_pair_t pair_id = ImagePairToPairId(image_id, corr->image_id);
       THROW_CHECK_GT(image_pair_stats_[pair_id].num_tri_corrs, 0)
@@ -442,53 +687,28 @@ size_t ObservationManager::FilterPoints3DWithSmallTriangulationAngle(
   // Minimum triangulation angle in radians.
   const double min_tri_angle_rad = DegToRad(min_tri_angle);
 
-  // Cache for image projection centers.
-  std::unordered_map<image_t, Eigen::Vector3d> proj_centers;
-
+  std::vector<point3D_t> existing_point3D_ids;
+  existing_point3D_ids.reserve(point3D_ids.size());
   for (const auto point3D_id : point3D_ids) {
-    if (!reconstruction_.ExistsPoint3D(point3D_id)) {
-      continue;
-    }
-
-    const struct Point3D& point3D = reconstruction_.Point3D(point3D_id);
-
-    // Calculate triangulation angle for all pairwise combinations of image
-    // poses in the track. Only delete point if none of the combinations
-    // has a sufficient triangulation angle.
-    bool keep_point = false;
-    for (size_t i1 = 0; i1 < point3D.track.Length(); ++i1) {
-      const image_t image_id1 = point3D.track.Element(i1).image_id;
-
-      Eigen::Vector3d proj_center1;
-      if (proj_centers.count(image_id1) == 0) {
-        const Image& image1 = reconstruction_.Image(image_id1);
-        proj_center1 = image1.ProjectionCenter();
-        proj_centers.emplace(image_id1, proj_center1);
-      } else {
-        proj_center1 = proj_centers.at(image_id1);
-      }
-
-      for (size_t i2 = 0; i2 < i1; ++i2) {
-        const image_t image_id2 = point3D.track.Element(i2).image_id;
-        const Eigen::Vector3d& proj_center2 = proj_centers.at(image_id2);
-
-        const double tri_angle = CalculateTriangulationAngle(
-            proj_center1, proj_center2, point3D.xyz);
-
-        if (tri_angle >= min_tri_angle_rad) {
-          keep_point = true;
-          break;
-        }
-      }
-
-      if (keep_point) {
-        break;
-      }
+    if (reconstruction_.ExistsPoint3D(point3D_id)) {
+      existing_point3D_ids.push_back(point3D_id);
     }
+  }
 
+  // Only delete a point if none of the pairwise combinations of image poses
+  // in its track has a sufficient triangulation angle.
+  Point3DStatisticsOptions stats_options;
+  stats_options.compute_errors = false;
+  stats_options.tri_angle_early_stop = min_tri_angle_rad;
+  const std::vector<Point3DStatistics> stats = ComputePoint3DStatistics(
+      reconstruction_, existing_point3D_ids, stats_options);
+
+  for (size_t i = 0; i < existing_point3D_ids.size(); ++i) {
+    const bool keep_point = stats[i].track_length >= 2 &&
+                            stats[i].max_tri_angle >= min_tri_angle_rad;
     if (!keep_point) {
-      num_filtered_observations += point3D.track.Length();
-      DeletePoint3D(point3D_id);
+      num_filtered_observations += stats[i].track_length;
+      DeletePoint3D(existing_point3D_ids[i]);
     }
   }
 
@@ -501,11 +721,25 @@ size_t ObservationManager::FilterPoints3DWithLargeReprojectionError(
     const ReprojectionErrorType error_type) {
   size_t num_filtered_observations = 0;
 
+  std::vector<point3D_t> existing_point3D_ids;
+  existing_point3D_ids.reserve(point3D_ids.size());
   for (const auto point3D_id : point3D_ids) {
-    if (!reconstruction_.ExistsPoint3D(point3D_id)) {
-      continue;
+    if (reconstruction_.ExistsPoint3D(point3D_id)) {
+      existing_point3D_ids.push_back(point3D_id);
     }
+  }
 
+  // The errors only depend on the point and the observing image poses, so
+  // they can be computed upfront for all points before deleting observations.
+  Point3DStatisticsOptions stats_options;
+  stats_options.error_type = error_type;
+  stats_options.store_observation_errors = true;
+  stats_options.compute_tri_angle = false;
+  const std::vector<Point3DStatistics> stats = ComputePoint3DStatistics(
+      reconstruction_, existing_point3D_ids, stats_options);
+
+  for (size_t i = 0; i < existing_point3D_ids.size(); ++i) {
+    const point3D_t point3D_id = existing_point3D_ids[i];
     struct Point3D& point3D = reconstruction_.Point3D(point3D_id);
 
     if (point3D.track.Length() < 2) {
@@ -517,55 +751,10 @@ size_t ObservationManager::FilterPoints3DWithLargeReprojectionError(
     double error_sum = 0.0;
     std::vector<TrackElement> track_els_to_delete;
 
-    for (const auto& track_el : point3D.track.Elements()) {
-      const Image& image = reconstruction_.Image(track_el.image_id);
-      const Camera& camera = *image.CameraPtr();
-      const Point2D& point2D = image.Point2D(track_el.point2D_idx);
-
-      // Each case reports observation_error in the same units as max_error
-      // (pixels, normalized chord length, or degrees). Degenerate observations
-      // that must always be filtered report an infinite error.
-      double observation_error = 0.0;
-      switch (error_type) {
-        case ReprojectionErrorType::PIXEL:
-          observation_error = std::sqrt(CalculateSquaredReprojectionError(
-              point2D.xy, point3D.xyz, image.CamFromWorld(), camera));
-          break;
-        case ReprojectionErrorType::NORMALIZED: {
-          const Eigen::Vector3d point3D_in_cam =
-              image.CamFromWorld() * point3D.xyz;
-          if (camera.IsPerspective()) {
-            constexpr double kMinDepth = 1e-12;
-            const std::optional<Eigen::Vector2d> cam_point =
-                camera.CamFromImg(point2D.xy);
-            observation_error =
-                (point3D_in_cam.z() >= kMinDepth && cam_point.has_value())
-                    ? (point3D_in_cam.hnormalized().head<2>() - *cam_point)
-                          .norm()
-                    : std::numeric_limits<double>::infinity();
-          } else {
-            // Omnidirectional cameras (e.g. EQUIRECTANGULAR) have no pinhole
-            // z-divide and legitimately observe points behind the local +Z
-            // axis, so the cheirality gate and 2D CamFromImg above do not
-            // apply. Compare unit bearings instead (chord distance ~= angle for
-            // small errors, consistent with the normalized threshold).
-            const std::optional<Eigen::Vector3d> cam_ray =
-                camera.CamRayFromImg(point2D.xy);
-            observation_error =
-                cam_ray.has_value()
-                    ? (point3D_in_cam.normalized() - *cam_ray).norm()
-                    : std::numeric_limits<double>::infinity();
-          }
-          break;
-        }
-        case ReprojectionErrorType::ANGULAR:
-          observation_error = RadToDeg(CalculateAngularReprojectionError(
-              point2D.xy, point3D.xyz, image.CamFromWorld(), camera));
-          break;
-      }
-
+    for (size_t j = 0; j < point3D.track.Length(); ++j) {
+      const double observation_error = stats[i].observation_errors[j];
       if (observation_error > max_error) {
-        track_els_to_delete.push_back(track_el);
+        track_els_to_delete.push_back(point3D.track.Element(j));
       } else {
         error_sum += observation_error;
       }
@@ -596,12 +785,15 @@ void ObservationManager::RegisterFrame(const frame_t frame_id) {
         const auto corr_range =
             correspondence_graph_->FindCorrespondences(data_id.id, point2D_idx);
         for (const auto* corr = corr_range.beg; corr < corr_range.end; ++corr) {
-          image_stats_[corr->image_id].num_visible_correspondences += 1;
+          GetImageStat(corr->image_id).num_visible_correspondences += 1;
         }
       }
     }
   }
   reconstruction_.RegisterFrame(frame_id);
+  for (const data_t& data_id : frame.ImageIds()) {
+    unregistered_visible_image_ids_.erase(data_id.id);
+  }
 }
 
 void ObservationManager::DeRegisterFrame(const frame_t frame_id) {
@@ -614,7 +806,7 @@ void ObservationManager::DeRegisterFrame(const frame_t frame_id) {
         const auto corr_range =
             correspondence_graph_->FindCorrespondences(data_id.id, point2D_idx);
         for (const auto* corr = corr_range.beg; corr < corr_range.end; ++corr) {
-          auto& stats = image_stats_[corr->image_id];
+          auto& stats = GetImageStat(corr->image_id);
           THROW_CHECK_GT(stats.num_visible_correspondences, 0)
               << "Visible correspondences underflow for image "
               << corr->image_id << " when deregistering frame " << frame_id;
@@ -627,6 +819,11 @@ void ObservationManager::DeRegisterFrame(const frame_t frame_id) {
     }
   }
   reconstruction_.DeRegisterFrame(frame_id);
+  for (const data_t& data_id : frame.ImageIds()) {
+    if (GetImageStat(data_id.id).num_visible_points3D > 0) {
+      unregistered_visible_image_ids_.insert(data_id.id);
+    }
+  }
 }
 
 std::vector<frame_t> ObservationManager::FindFramesToFilter(
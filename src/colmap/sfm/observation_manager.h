@@ -31,21 +31,49 @@
 
 #include "colmap/scene/correspondence_graph.h"
 #include "colmap/scene/reconstruction.h"
+#include "colmap/scene/reconstruction_statistics.h"
 #include "colmap/scene/track.h"
 #include "colmap/scene/visibility_pyramid.h"
 #include "colmap/util/enum_utils.h"
 #include "colmap/util/types.h"
 
-namespace colmap {
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 
-// Type of error metric used for filtering 3D point observations.
-MAKE_ENUM_CLASS_OVERLOAD_STREAM(
-    ReprojectionErrorType, 0, PIXEL, NORMALIZED, ANGULAR);
+namespace colmap {
 
 bool MergeAndFilterReconstructions(double max_reproj_error,
                                    const Reconstruction& src_reconstruction,
                                    Reconstruction& tgt_reconstruction);
 
+struct ReconstructionMergingOptions {
+  // Maximum reprojection error in pixels for aligning the reconstructions and
+  // filtering the merged 3D points.
+  double max_reproj_error = 8.0;
+
+  // Minimum number of common registered images to align two reconstructions.
+  int min_num_common_images = 3;
+
+  // The number of threads to use for aligning and merging.
+  int num_threads = -1;
+
+  bool Check() const;
+};
+
+// Merges many overlapping reconstructions, e.g., of the clusters of a
+// partitioned scene. First, all pairs of reconstructions with common images
+// are aligned concurrently. The reconstructions are then merged along a
+// maximum spanning tree of the successfully aligned pairs (weighted by the
+// number of common images), where disjoint pairs of tree edges are merged
+// concurrently in each level. The merged reconstructions are modified in
+// place and returned sorted by decreasing number of registered images, with
+// one reconstruction per connected component of the alignment graph.
+std::vector<std::shared_ptr<Reconstruction>> MergeAndFilterReconstructions(
+    const ReconstructionMergingOptions& options,
+    const std::vector<std::shared_ptr<Reconstruction>>& reconstructions);
+
 class ObservationManager {
  public:
   // The number of levels in the 3D point multi-resolution visibility pyramid.
@@ -175,6 +203,12 @@ class ObservationManager {
   // uniform distribution of observations results in more robust registration.
   inline size_t Point3DVisibilityScore(image_t image_id) const;
 
+  // Get the unregistered images that have at least one correspondence to a
+  // triangulated point, i.e., the candidates for the next image registration.
+  // The set is maintained incrementally as points are triangulated/deleted and
+  // frames are (de-)registered through this class.
+  inline const std::unordered_set<image_t>& UnregisteredVisibleImageIds() const;
+
   // Indicate that another image has a point that is triangulated and has
   // a correspondence to this image point.
   void IncrementCorrespondenceHasPoint3D(image_t image_id,
@@ -187,6 +221,12 @@ class ObservationManager {
   void DecrementCorrespondenceHasPoint3D(image_t image_id,
                                          point2D_t point2D_idx);
 
+  // Rebuild the visibility pyramid of an unregistered image after its points2D
+  // were set or cleared, e.g., when the points2D are loaded on demand. Images
+  // without points2D only track the number of triangulated correspondences
+  // and have an empty visibility pyramid.
+  void UpdateImagePoints2D(image_t image_id);
+
  private:
   friend std::ostream& operator<<(std::ostream& stream,
                                   const ObservationManager& obs_manager);
@@ -199,20 +239,23 @@ class ObservationManager {
                             bool is_deleted_point3D);
 
   struct ImageStat {
+    // The identifier of the image, used to iterate over the compact stats.
+    image_t image_id = kInvalidImageId;
+
     // The number of image points that have at least one correspondence to
     // another image.
-    point2D_t num_observations;
+    point2D_t num_observations = 0;
 
     // The sum of correspondences per image point.
-    point2D_t num_correspondences;
+    point2D_t num_correspondences = 0;
 
     // The sum of correspondences that have a corresponding registered image.
-    point2D_t num_visible_correspondences;
+    point2D_t num_visible_correspondences = 0;
 
     // The number of 2D points, which have at least one corresponding 2D point
     // in another image that is part of a 3D point track, i.e. the sum of
     // `points2D` where `num_tris > 0`.
-    point2D_t num_visible_points3D;
+    point2D_t num_visible_points3D = 0;
 
     // Per image point, the number of correspondences that have a 3D point.
     std::vector<point2D_t> num_correspondences_have_point3D;
@@ -222,12 +265,29 @@ class ObservationManager {
     VisibilityPyramid point3D_visibility_pyramid;
   };
 
+  static constexpr size_t kInvalidImageStatIdx =
+      std::numeric_limits<size_t>::max();
+
   ImageStat InitImageStat(image_t image_id, const Image& image) const;
+  void EmplaceImageStat(image_t image_id, ImageStat image_stat);
+  inline size_t FindImageStatIdx(image_t image_id) const;
+  inline bool ExistsImageStat(image_t image_id) const;
+  inline ImageStat& GetImageStat(image_t image_id);
+  inline const ImageStat& GetImageStat(image_t image_id) const;
 
   class Reconstruction& reconstruction_;
   const std::shared_ptr<const CorrespondenceGraph> correspondence_graph_;
   std::unordered_map<image_pair_t, ImagePairStat> image_pair_stats_;
-  std::unordered_map<image_t, ImageStat> image_stats_;
+  // Image stats are stored compactly and looked up through a remap from image
+  // identifier to stat index. Image identifiers are usually dense, so the
+  // remap is a table indexed by identifier, which avoids the hashing of a map
+  // in the hot observation update paths. Identifiers far beyond the size of
+  // the table, e.g. from sparse imported models, fall back to a hash map, so
+  // that the table never grows with the magnitude of the identifiers.
+  std::vector<ImageStat> image_stats_;
+  std::vector<size_t> image_stat_idxs_;
+  std::unordered_map<image_t, size_t> sparse_image_stat_idxs_;
+  std::unordered_set<image_t> unregistered_visible_image_ids_;
 };
 
 std::ostream& operator<<(std::ostream& stream,
@@ -247,25 +307,64 @@ ObservationManager::ImagePairs() const {
 }
 
 point2D_t ObservationManager::NumObservations(const image_t image_id) const {
-  return image_stats_.at(image_id).num_observations;
+  return GetImageStat(image_id).num_observations;
 }
 
 point2D_t ObservationManager::NumCorrespondences(const image_t image_id) const {
-  return image_stats_.at(image_id).num_correspondences;
+  return GetImageStat(image_id).num_correspondences;
 }
 
 point2D_t ObservationManager::NumVisibleCorrespondences(
     const image_t image_id) const {
-  return image_stats_.at(image_id).num_visible_correspondences;
+  return GetImageStat(image_id).num_visible_correspondences;
 }
 
 point2D_t ObservationManager::NumVisiblePoints3D(const image_t image_id) const {
-  return image_stats_.at(image_id).num_visible_points3D;
+  return GetImageStat(image_id).num_visible_points3D;
 }
 
 size_t ObservationManager::Point3DVisibilityScore(
     const image_t image_id) const {
-  return image_stats_.at(image_id).point3D_visibility_pyramid.Score();
+  return GetImageStat(image_id).point3D_visibility_pyramid.Score();
+}
+
+const std::unordered_set<image_t>&
+ObservationManager::UnregisteredVisibleImageIds() const {
+  return unregistered_visible_image_ids_;
+}
+
+size_t ObservationManager::FindImageStatIdx(const image_t image_id) const {
+  if (image_id < image_stat_idxs_.size() &&
+      image_stat_idxs_[image_id] != kInvalidImageStatIdx) {
+    return image_stat_idxs_[image_id];
+  }
+  if (!sparse_image_stat_idxs_.empty()) {
+    const auto it = sparse_image_stat_idxs_.find(image_id);
+    if (it != sparse_image_stat_idxs_.end()) {
+      return it->second;
+    }
+  }
+  return kInvalidImageStatIdx;
+}
+
+bool ObservationManager::ExistsImageStat(const image_t image_id) const {
+  return FindImageStatIdx(image_id) < image_stats_.size();
+}
+
+ObservationManager::ImageStat& ObservationManager::GetImageStat(
+    const image_t image_id) {
+  const size_t idx = FindImageStatIdx(image_id);
+  THROW_CHECK_LT(idx, image_stats_.size())
+      << "Image " << image_id << " does not exist in the ObservationManager";
+  return image_stats_[idx];
+}
+
+const ObservationManager::ImageStat& ObservationManager::GetImageStat(
+    const image_t image_id) const {
+  const size_t idx = FindImageStatIdx(image_id);
+  THROW_CHECK_LT(idx, image_stats_.size())
+      << "Image " << image_id << " does not exist in the ObservationManager";
+  return image_stats_[idx];
 }
 
 }  // namespace colmap
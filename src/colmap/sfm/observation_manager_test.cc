@@ -29,6 +29,8 @@
 
 #include "colmap/sfm/observation_manager.h"
 
+#include "colmap/scene/synthetic.h"
+
 #include <memory>
 
 #include <gtest/gtest.h>
@@ -500,6 +502,116 @@ TEST(ObservationManager, NumVisiblePoints3D) {
   EXPECT_EQ(obs_manager.NumVisiblePoints3D(kImageId1), 0);
 }
 
+TEST(ObservationManager, SparseImageIds) {
+  Reconstruction reconstruction;
+  const image_t kImageId1 = 1;
+  const image_t kImageId2 = kMaxNumImages - 1;
+  const camera_t kCameraId = 1;
+  const Camera camera = Camera::CreateFromModelId(kCameraId,
+                                                  CameraModelId::kPinhole,
+                                                  /*focal_length=*/10,
+                                                  /*width=*/10,
+                                                  /*height=*/10);
+  reconstruction.AddCamera(camera);
+  Rig rig;
+  rig.SetRigId(1);
+  rig.AddRefSensor(camera.SensorId());
+  reconstruction.AddRig(rig);
+  Frame frame;
+  frame.SetFrameId(1);
+  frame.SetRigId(rig.RigId());
+  frame.AddDataId(data_t(camera.SensorId(), kImageId1));
+  frame.AddDataId(data_t(camera.SensorId(), kImageId2));
+  reconstruction.AddFrame(frame);
+  Image image;
+  image.SetImageId(kImageId1);
+  image.SetCameraId(kCameraId);
+  image.SetFrameId(frame.FrameId());
+  image.SetPoints2D(std::vector<Eigen::Vector2d>(10));
+  reconstruction.AddImage(image);
+  image.SetImageId(kImageId2);
+  reconstruction.AddImage(image);
+  auto correspondence_graph = std::make_shared<CorrespondenceGraph>();
+  correspondence_graph->AddImage(kImageId1, 10);
+  correspondence_graph->AddImage(kImageId2, 10);
+  TwoViewGeometry two_view_geometry;
+  for (size_t i = 0; i < 5; ++i) {
+    two_view_geometry.inlier_matches.emplace_back(i, i);
+  }
+  correspondence_graph->AddTwoViewGeometry(
+      kImageId1, kImageId2, two_view_geometry);
+  correspondence_graph->Finalize();
+  ObservationManager obs_manager(reconstruction, correspondence_graph);
+
+  EXPECT_EQ(obs_manager.NumObservations(kImageId1), 5);
+  EXPECT_EQ(obs_manager.NumObservations(kImageId2), 5);
+  EXPECT_ANY_THROW(obs_manager.NumObservations(2));
+  EXPECT_ANY_THROW(obs_manager.NumObservations(kImageId2 - 1));
+  EXPECT_ANY_THROW(obs_manager.NumObservations(kInvalidImageId));
+
+  obs_manager.IncrementCorrespondenceHasPoint3D(kImageId2, 0);
+  EXPECT_EQ(obs_manager.NumVisiblePoints3D(kImageId1), 0);
+  EXPECT_EQ(obs_manager.NumVisiblePoints3D(kImageId2), 1);
+  obs_manager.DecrementCorrespondenceHasPoint3D(kImageId2, 0);
+  EXPECT_EQ(obs_manager.NumVisiblePoints3D(kImageId2), 0);
+}
+
+TEST(ObservationManager, UnregisteredVisibleImageIds) {
+  Reconstruction reconstruction;
+  const image_t kImageId1 = 1;
+  const image_t kImageId2 = 2;
+  const camera_t kCameraId = 1;
+  const Camera camera = Camera::CreateFromModelId(kCameraId,
+                                                  CameraModelId::kPinhole,
+                                                  /*focal_length=*/10,
+                                                  /*width=*/10,
+                                                  /*height=*/10);
+  reconstruction.AddCamera(camera);
+  Rig rig;
+  rig.SetRigId(1);
+  rig.AddRefSensor(camera.SensorId());
+  reconstruction.AddRig(rig);
+  for (const image_t image_id : {kImageId1, kImageId2}) {
+    Frame frame;
+    frame.SetFrameId(image_id);
+    frame.SetRigId(rig.RigId());
+    frame.AddDataId(data_t(camera.SensorId(), image_id));
+    reconstruction.AddFrame(frame);
+    Image image;
+    image.SetImageId(image_id);
+    image.SetCameraId(kCameraId);
+    image.SetFrameId(frame.FrameId());
+    image.SetPoints2D(std::vector<Eigen::Vector2d>(10));
+    reconstruction.AddImage(image);
+  }
+  auto correspondence_graph = std::make_shared<CorrespondenceGraph>();
+  correspondence_graph->AddImage(kImageId1, 10);
+  correspondence_graph->AddImage(kImageId2, 10);
+  TwoViewGeometry two_view_geometry;
+  for (size_t i = 0; i < 10; ++i) {
+    two_view_geometry.inlier_matches.emplace_back(i, i);
+  }
+  correspondence_graph->AddTwoViewGeometry(
+      kImageId1, kImageId2, two_view_geometry);
+  correspondence_graph->Finalize();
+  ObservationManager obs_manager(reconstruction, correspondence_graph);
+
+  using ImageIds = std::unordered_set<image_t>;
+  EXPECT_EQ(obs_manager.UnregisteredVisibleImageIds(), ImageIds());
+  obs_manager.IncrementCorrespondenceHasPoint3D(kImageId1, 0);
+  obs_manager.IncrementCorrespondenceHasPoint3D(kImageId1, 1);
+  EXPECT_EQ(obs_manager.UnregisteredVisibleImageIds(), ImageIds({kImageId1}));
+  reconstruction.Frame(kImageId1).SetRigFromWorld(Rigid3d());
+  obs_manager.RegisterFrame(kImageId1);
+  EXPECT_EQ(obs_manager.UnregisteredVisibleImageIds(), ImageIds());
+  obs_manager.DeRegisterFrame(kImageId1);
+  EXPECT_EQ(obs_manager.UnregisteredVisibleImageIds(), ImageIds({kImageId1}));
+  obs_manager.DecrementCorrespondenceHasPoint3D(kImageId1, 0);
+  EXPECT_EQ(obs_manager.UnregisteredVisibleImageIds(), ImageIds({kImageId1}));
+  obs_manager.DecrementCorrespondenceHasPoint3D(kImageId1, 1);
+  EXPECT_EQ(obs_manager.UnregisteredVisibleImageIds(), ImageIds());
+}
+
 TEST(ObservationManager, NumVisibleCorrespondences) {
   Reconstruction reconstruction;
   const image_t kImageId1 = 1;
@@ -695,6 +807,84 @@ TEST(ObservationManager, Point3DVisibilityScore) {
             2 * scores.sum() + 2 * scores.bottomRows(scores.size() - 1).sum());
 }
 
+TEST(ObservationManager, UpdateImagePoints2D) {
+  Reconstruction reconstruction;
+  const image_t kImageId = 1;
+  const image_t kOtherImageId = 2;
+  const Camera camera = Camera::CreateFromModelId(1,
+                                                  CameraModelId::kPinhole,
+                                                  /*focal_length=*/4,
+                                                  /*width=*/4,
+                                                  /*height=*/4);
+  reconstruction.AddCamera(camera);
+  Rig rig;
+  rig.SetRigId(1);
+  rig.AddRefSensor(camera.SensorId());
+  reconstruction.AddRig(rig);
+  Frame frame;
+  frame.SetFrameId(1);
+  frame.SetRigId(rig.RigId());
+  frame.AddDataId(data_t(camera.SensorId(), kImageId));
+  frame.AddDataId(data_t(camera.SensorId(), kOtherImageId));
+  reconstruction.AddFrame(frame);
+  // The points2D of the image are not loaded yet.
+  Image image;
+  image.SetImageId(kImageId);
+  image.SetCameraId(camera.camera_id);
+  image.SetFrameId(frame.FrameId());
+  reconstruction.AddImage(image);
+  image.SetImageId(kOtherImageId);
+  image.SetPoints2D(std::vector<Eigen::Vector2d>(16));
+  reconstruction.AddImage(image);
+  auto correspondence_graph = std::make_shared<CorrespondenceGraph>();
+  correspondence_graph->AddImage(kImageId, 16);
+  correspondence_graph->AddImage(kOtherImageId, 16);
+  TwoViewGeometry two_view_geometry;
+  for (size_t i = 0; i < 16; ++i) {
+    two_view_geometry.inlier_matches.emplace_back(i, i);
+  }
+  correspondence_graph->AddTwoViewGeometry(
+      kImageId, kOtherImageId, two_view_geometry);
+  correspondence_graph->Finalize();
+
+  ObservationManager obs_manager(reconstruction, correspondence_graph);
+  obs_manager.IncrementCorrespondenceHasPoint3D(kImageId, 0);
+  obs_manager.IncrementCorrespondenceHasPoint3D(kImageId, 5);
+  obs_manager.IncrementCorrespondenceHasPoint3D(kImageId, 5);
+  obs_manager.DecrementCorrespondenceHasPoint3D(kImageId, 5);
+  EXPECT_EQ(obs_manager.NumVisiblePoints3D(kImageId), 2);
+  EXPECT_EQ(obs_manager.Point3DVisibilityScore(kImageId), 0);
+
+  std::vector<Eigen::Vector2d> points2D;
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      points2D.emplace_back(i, j);
+    }
+  }
+  reconstruction.Image(kImageId).SetPoints2D(points2D);
+  obs_manager.UpdateImagePoints2D(kImageId);
+  EXPECT_EQ(obs_manager.NumVisiblePoints3D(kImageId), 2);
+  const size_t score = obs_manager.Point3DVisibilityScore(kImageId);
+  EXPECT_GT(score, 0);
+
+  // The pyramid must match the one that is built incrementally.
+  Reconstruction expected_reconstruction = reconstruction;
+  ObservationManager expected_obs_manager(expected_reconstruction,
+                                          correspondence_graph);
+  expected_obs_manager.IncrementCorrespondenceHasPoint3D(kImageId, 0);
+  expected_obs_manager.IncrementCorrespondenceHasPoint3D(kImageId, 5);
+  EXPECT_EQ(expected_obs_manager.Point3DVisibilityScore(kImageId), score);
+
+  obs_manager.DecrementCorrespondenceHasPoint3D(kImageId, 5);
+  EXPECT_EQ(obs_manager.NumVisiblePoints3D(kImageId), 1);
+  EXPECT_LT(obs_manager.Point3DVisibilityScore(kImageId), score);
+
+  reconstruction.Image(kImageId).Points2D().clear();
+  obs_manager.UpdateImagePoints2D(kImageId);
+  EXPECT_EQ(obs_manager.NumVisiblePoints3D(kImageId), 1);
+  EXPECT_EQ(obs_manager.Point3DVisibilityScore(kImageId), 0);
+}
+
 TEST(ObservationManager, AddImage) {
   // Images 1,2 start registered with a triangulated point. Image 3 arrives
   // incrementally with a match on a previously-unmatched point in image 1,
@@ -773,5 +963,89 @@ TEST(ObservationManager, AddImage) {
   obs_manager.AddPoint3D(Eigen::Vector3d(1, 0, 1), track2);
 }
 
+TEST(ObservationManager, UnknownImage) {
+  Reconstruction reconstruction;
+  GenerateReconstruction(2, reconstruction);
+  ObservationManager obs_manager(reconstruction);
+  EXPECT_EQ(obs_manager.NumObservations(1), 0);
+  EXPECT_ANY_THROW(obs_manager.NumObservations(0));
+  EXPECT_ANY_THROW(obs_manager.NumObservations(3));
+  EXPECT_ANY_THROW(obs_manager.Point3DVisibilityScore(kInvalidImageId));
+}
+
+TEST(MergeAndFilterReconstructions, SpanningTree) {
+  Reconstruction orig_reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 4;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 10;
+  synthetic_dataset_options.num_points3D = 50;
+  SynthesizeDataset(synthetic_dataset_options, &orig_reconstruction);
+
+  // Create a chain of reconstructions with overlapping rigs in different
+  // coordinate frames, so the alignments must be concatenated when merging.
+  std::vector<std::shared_ptr<Reconstruction>> reconstructions;
+  for (rig_t rig_id = 1; rig_id <= 3; ++rig_id) {
+    auto reconstruction =
+        std::make_shared<Reconstruction>(orig_reconstruction);
+    const std::vector<frame_t> frame_ids = reconstruction->RegFrameIds();
+    for (const frame_t frame_id : frame_ids) {
+      const rig_t frame_rig_id = reconstruction->Frame(frame_id).RigId();
+      if (frame_rig_id != rig_id && frame_rig_id != rig_id + 1) {
+        reconstruction->DeRegisterFrame(frame_id);
+      }
+    }
+    reconstruction->TearDown();
+    EXPECT_EQ(reconstruction->NumRegFrames(), 20);
+    reconstruction->Transform(
+        Sim3d(rig_id,
+              Eigen::Quaterniond(1, 0.1 * rig_id, 0.2, 0.3).normalized(),
+              Eigen::Vector3d(rig_id, 2, 3)));
+    reconstructions.push_back(std::move(reconstruction));
+  }
+
+  ReconstructionMergingOptions options;
+  options.max_reproj_error = 1e-4;
+  const std::vector<std::shared_ptr<Reconstruction>> merged_reconstructions =
+      MergeAndFilterReconstructions(options, reconstructions);
+  ASSERT_EQ(merged_reconstructions.size(), 1);
+  const Reconstruction& merged_reconstruction = *merged_reconstructions[0];
+  EXPECT_EQ(merged_reconstruction.NumRigs(), 4);
+  EXPECT_EQ(merged_reconstruction.NumRegFrames(), 40);
+  EXPECT_EQ(merged_reconstruction.NumImages(), 40);
+  EXPECT_EQ(merged_reconstruction.NumPoints3D(), 50);
+  EXPECT_EQ(merged_reconstruction.ComputeNumObservations(),
+            orig_reconstruction.ComputeNumObservations());
+}
+
+TEST(MergeAndFilterReconstructions, Disconnected) {
+  Reconstruction orig_reconstruction;
+  SyntheticDatasetOptions synthetic_dataset_options;
+  synthetic_dataset_options.num_rigs = 2;
+  synthetic_dataset_options.num_cameras_per_rig = 1;
+  synthetic_dataset_options.num_frames_per_rig = 5;
+  synthetic_dataset_options.num_points3D = 50;
+  SynthesizeDataset(synthetic_dataset_options, &orig_reconstruction);
+
+  std::vector<std::shared_ptr<Reconstruction>> reconstructions;
+  for (rig_t rig_id = 1; rig_id <= 2; ++rig_id) {
+    auto reconstruction =
+        std::make_shared<Reconstruction>(orig_reconstruction);
+    const std::vector<frame_t> frame_ids = reconstruction->RegFrameIds();
+    for (const frame_t frame_id : frame_ids) {
+      if (reconstruction->Frame(frame_id).RigId() != rig_id) {
+        reconstruction->DeRegisterFrame(frame_id);
+      }
+    }
+    reconstruction->TearDown();
+    reconstructions.push_back(std::move(reconstruction));
+  }
+
+  const std::vector<std::shared_ptr<Reconstruction>> merged_reconstructions =
+      MergeAndFilterReconstructions(ReconstructionMergingOptions(),
+                                    reconstructions);
+  EXPECT_EQ(merged_reconstructions.size(), 2);
+}
+
 }  // namespace
 }  // namespace colmap
@@ -84,6 +84,9 @@ AutomaticReconstructionWidget::AutomaticReconstructionWidget(
                 "Shared intrinsics per sub-folder");
   AddOptionBool(&options_.sparse, "Sparse model");
   AddOptionBool(&options_.dense, "Dense model");
+  AddOptionBool(&options_.pipelined, "Pipelined stages");
+  AddOptionBool(&options_.progressive, "Progressive preview");
+  AddOptionInt(&options_.progressive_num_features, "progressive_num_features");
 
   QLabel* mesher_label = new QLabel(tr("Mesher"), this);
   mesher_label->setFont(font());
@@ -104,22 +104,39 @@ BundleAdjustmentWidget::BundleAdjustmentWidget(MainWindow* main_window,
   AddSection("Caspar Options");
   AddOptionText(&options->bundle_adjustment->caspar->gpu_index,
                 "gpu_index (-1 = auto)");
+  int* num_multi_gpu_iterations =
+      &options->bundle_adjustment->caspar->num_multi_gpu_iterations;
+  AddOptionInt(num_multi_gpu_iterations, "num_multi_gpu_iterations", 1);
+  int* max_num_observations_per_solve =
+      &options->bundle_adjustment->caspar->max_num_observations_per_solve;
+  AddOptionInt(max_num_observations_per_solve,
+               "max_num_observations_per_solve (-1 = unlimited)",
+               -1);
 
   const bool caspar_active =
       options->bundle_adjustment->backend == BundleAdjustmentBackend::CASPAR;
   if (!caspar_active) {
     HideOption(&options->bundle_adjustment->caspar->gpu_index);
+    HideOption(num_multi_gpu_iterations);
+    HideOption(max_num_observations_per_solve);
   }
 
   connect(backend_combo,
           QOverload<int>::of(&QComboBox::currentIndexChanged),
-          [this, options](int idx) {
+          [this,
+           options,
+           num_multi_gpu_iterations,
+           max_num_observations_per_solve](int idx) {
             const bool is_caspar = static_cast<BundleAdjustmentBackend>(idx) ==
                                    BundleAdjustmentBackend::CASPAR;
             if (is_caspar) {
               ShowOption(&options->bundle_adjustment->caspar->gpu_index);
+              ShowOption(num_multi_gpu_iterations);
+              ShowOption(max_num_observations_per_solve);
             } else {
               HideOption(&options->bundle_adjustment->caspar->gpu_index);
+              HideOption(num_multi_gpu_iterations);
+              HideOption(max_num_observations_per_solve);
             }
           });
 #endif
@@ -32,6 +32,7 @@
 #include "colmap/scene/camera.h"
 #include "colmap/scene/image.h"
 #include "colmap/scene/point3d.h"
+#include "colmap/util/dense_id_map.h"
 #include "colmap/util/eigen_alignment.h"
 #include "colmap/util/types.h"
 
@@ -47,7 +48,7 @@ class PointColormapBase {
 
   virtual void Prepare(std::unordered_map<camera_t, Camera>& cameras,
                        std::unordered_map<image_t, Image>& images,
-                       std::unordered_map<point3D_t, Point3D>& points3D,
+                       DenseIdMap<point3D_t, Point3D>& points3D,
                        std::vector<image_t>& reg_image_ids) = 0;
 
   virtual Eigen::Vector4f ComputeColor(point3D_t point3D_id,
@@ -69,7 +70,7 @@ class PointColormapPhotometric : public PointColormapBase {
  public:
   void Prepare(std::unordered_map<camera_t, Camera>& cameras,
                std::unordered_map<image_t, Image>& images,
-               std::unordered_map<point3D_t, Point3D>& points3D,
+               DenseIdMap<point3D_t, Point3D>& points3D,
                std::vector<image_t>& reg_image_ids) override;
 
   Eigen::Vector4f ComputeColor(point3D_t point3D_id,
@@ -81,7 +82,7 @@ class PointColormapError : public PointColormapBase {
  public:
   void Prepare(std::unordered_map<camera_t, Camera>& cameras,
                std::unordered_map<image_t, Image>& images,
-               std::unordered_map<point3D_t, Point3D>& points3D,
+               DenseIdMap<point3D_t, Point3D>& points3D,
                std::vector<image_t>& reg_image_ids) override;
 
   Eigen::Vector4f ComputeColor(point3D_t point3D_id,
@@ -93,7 +94,7 @@ class PointColormapTrackLen : public PointColormapBase {
  public:
   void Prepare(std::unordered_map<camera_t, Camera>& cameras,
                std::unordered_map<image_t, Image>& images,
-               std::unordered_map<point3D_t, Point3D>& points3D,
+               DenseIdMap<point3D_t, Point3D>& points3D,
                std::vector<image_t>& reg_image_ids) override;
 
   Eigen::Vector4f ComputeColor(point3D_t point3D_id,
@@ -105,7 +106,7 @@ class PointColormapGroundResolution : public PointColormapBase {
  public:
   void Prepare(std::unordered_map<camera_t, Camera>& cameras,
                std::unordered_map<image_t, Image>& images,
-               std::unordered_map<point3D_t, Point3D>& points3D,
+               DenseIdMap<point3D_t, Point3D>& points3D,
                std::vector<image_t>& reg_image_ids) override;
 
   Eigen::Vector4f ComputeColor(point3D_t point3D_id,
@@ -123,7 +124,7 @@ class ImageColormapBase {
 
   virtual void Prepare(std::unordered_map<camera_t, Camera>& cameras,
                        std::unordered_map<image_t, Image>& images,
-                       std::unordered_map<point3D_t, Point3D>& points3D,
+                       DenseIdMap<point3D_t, Point3D>& points3D,
                        std::vector<image_t>& reg_image_ids) = 0;
 
   virtual void ComputeColor(const Image& image,
@@ -139,7 +140,7 @@ class ImageColormapUniform : public ImageColormapBase {
  public:
   void Prepare(std::unordered_map<camera_t, Camera>& cameras,
                std::unordered_map<image_t, Image>& images,
-               std::unordered_map<point3D_t, Point3D>& points3D,
+               DenseIdMap<point3D_t, Point3D>& points3D,
                std::vector<image_t>& reg_image_ids) override;
 
   void ComputeColor(const Image& image,
@@ -155,7 +156,7 @@ class ImageColormapNameFilter : public ImageColormapBase {
  public:
   void Prepare(std::unordered_map<camera_t, Camera>& cameras,
                std::unordered_map<image_t, Image>& images,
-               std::unordered_map<point3D_t, Point3D>& points3D,
+               DenseIdMap<point3D_t, Point3D>& points3D,
                std::vector<image_t>& reg_image_ids) override;
 
   void AddColorForWord(const std::string& word,
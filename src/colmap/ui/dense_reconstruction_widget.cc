@@ -60,6 +60,7 @@ class StereoOptionsTab : public OptionsWidget {
 
     AddOptionInt(
         &options->patch_match_stereo->max_image_size, "max_image_size", -1);
+    AddOptionBool(&options->patch_match_stereo->use_gpu, "use_gpu");
     AddOptionText(&options->patch_match_stereo->gpu_index, "gpu_index");
     AddOptionDouble(&options->patch_match_stereo->depth_min, "depth_min", -1);
     AddOptionDouble(&options->patch_match_stereo->depth_max, "depth_max", -1);
@@ -69,6 +70,12 @@ class StereoOptionsTab : public OptionsWidget {
         &options->patch_match_stereo->sigma_spatial, "sigma_spatial", -1);
     AddOptionDouble(&options->patch_match_stereo->sigma_color, "sigma_color");
     AddOptionInt(&options->patch_match_stereo->num_samples, "num_samples");
+    AddOptionText(&options->patch_match_stereo->src_image_selection,
+                  "src_image_selection");
+    AddOptionDouble(&options->patch_match_stereo->src_image_prune_min_sel_prob,
+                    "src_image_prune_min_sel_prob");
+    AddOptionInt(&options->patch_match_stereo->src_image_prune_tile_size,
+                 "src_image_prune_tile_size");
     AddOptionDouble(&options->patch_match_stereo->ncc_sigma, "ncc_sigma");
     AddOptionDouble(&options->patch_match_stereo->min_triangulation_angle,
                     "min_triangulation_angle");
@@ -76,6 +83,18 @@ class StereoOptionsTab : public OptionsWidget {
                     "incident_angle_sigma");
     AddOptionInt(&options->patch_match_stereo->num_iterations,
                  "num_iterations");
+    AddOptionInt(&options->patch_match_stereo->pyramid_num_levels,
+                 "pyramid_num_levels");
+    AddOptionInt(&options->patch_match_stereo->pyramid_num_iterations,
+                 "pyramid_num_iterations");
+    AddOptionText(&options->patch_match_stereo->init_mode, "init_mode");
+    AddOptionInt(&options->patch_match_stereo->init_num_iterations,
+                 "init_num_iterations",
+                 -1);
+    AddOptionBool(&options->patch_match_stereo->half_precision,
+                  "half_precision");
+    AddOptionInt(&options->patch_match_stereo->tile_size, "tile_size", 0);
+    AddOptionInt(&options->patch_match_stereo->tile_overlap, "tile_overlap", 0);
     AddOptionBool(&options->patch_match_stereo->geom_consistency,
                   "geom_consistency");
     AddOptionDouble(&options->patch_match_stereo->geom_consistency_regularizer,
@@ -101,6 +120,10 @@ class StereoOptionsTab : public OptionsWidget {
                     1);
     AddOptionBool(&options->patch_match_stereo->write_consistency_graph,
                   "write_consistency_graph");
+    AddOptionText(&options->patch_match_stereo->map_compression,
+                  "map_compression");
+    AddOptionInt(&options->patch_match_stereo->io_pipeline_depth,
+                 "io_pipeline_depth");
     AddOptionInt(&options->patch_match_stereo->num_threads, "num_threads", -1);
   }
 };
@@ -133,6 +156,10 @@ class FusionOptionsTab : public OptionsWidget {
                     0.1,
                     1);
     AddOptionBool(&options->stereo_fusion->use_cache, "use_cache");
+    AddOptionDouble(
+        &options->stereo_fusion->merge_radius, "merge_radius [pixels]", 0);
+    AddOptionBool(&options->stereo_fusion->use_gpu, "use_gpu");
+    AddOptionText(&options->stereo_fusion->gpu_index, "gpu_index");
   }
 };
 
@@ -146,6 +173,11 @@ class MeshingOptionsTab : public OptionsWidget {
     AddOptionBool(&options->poisson_meshing->color, "color");
     AddOptionDouble(&options->poisson_meshing->trim, "trim", 0);
     AddOptionInt(&options->poisson_meshing->num_threads, "num_threads", -1);
+    AddOptionInt(&options->poisson_meshing->max_num_points_per_block,
+                 "max_num_points_per_block",
+                 0);
+    AddOptionDouble(
+        &options->poisson_meshing->block_overlap, "block_overlap", 0);
 
     AddSection("Delaunay Meshing");
     AddOptionDouble(
@@ -164,6 +196,12 @@ class MeshingOptionsTab : public OptionsWidget {
     AddOptionDouble(&options->delaunay_meshing->max_side_length_percentile,
                     "max_side_length_percentile",
                     0);
+    AddOptionInt(&options->delaunay_meshing->max_num_points_per_partition,
+                 "max_num_points_per_partition",
+                 0);
+    AddOptionDouble(&options->delaunay_meshing->partition_overlap,
+                    "partition_overlap",
+                    0);
     AddOptionInt(&options->delaunay_meshing->num_threads, "num_threads", -1);
   }
 };
@@ -392,7 +430,7 @@ void DenseReconstructionWidget::Stereo() {
     return;
   }
 
-#if defined(COLMAP_MVS_ENABLED) && defined(COLMAP_CUDA_ENABLED)
+#if defined(COLMAP_MVS_ENABLED)
   auto processor =
       std::make_unique<ControllerThread<mvs::PatchMatchController>>(
           std::make_shared<mvs::PatchMatchController>(
@@ -400,16 +438,11 @@ void DenseReconstructionWidget::Stereo() {
   processor->AddCallback(Thread::FINISHED_CALLBACK,
                          [this]() { refresh_workspace_action_->trigger(); });
   thread_control_widget_->StartThread("Stereo...", true, std::move(processor));
-#elif !defined(COLMAP_MVS_ENABLED)
+#else
   QMessageBox::critical(this,
                         "",
                         tr("Dense stereo reconstruction requires the MVS "
                            "module, which is not available in this build."));
-#else
-  QMessageBox::critical(this,
-                        "",
-                        tr("Dense stereo reconstruction requires CUDA, which "
-                           "is not available on your system."));
 #endif
 }
 
@@ -97,6 +97,8 @@ SIFTExtractionWidget::SIFTExtractionWidget(QWidget* parent,
   AddOptionInt(&options->feature_extraction->num_threads, "num_threads", -1);
   AddOptionBool(&options->feature_extraction->use_gpu, "use_gpu");
   AddOptionText(&options->feature_extraction->gpu_index, "gpu_index");
+  AddOptionInt(&options->feature_extraction->num_cpu_workers,
+               "num_cpu_workers");
 
   SiftExtractionOptions& sift_options = *options->feature_extraction->sift;
   AddOptionInt(&sift_options.max_num_features, "sift.max_num_features");
@@ -120,6 +122,9 @@ SIFTExtractionWidget::SIFTExtractionWidget(QWidget* parent,
   AddOptionDouble(
       &sift_options.dsp_max_scale, "sift.dsp_max_scale", 0.0, 1e7, 0.00001, 5);
   AddOptionInt(&sift_options.dsp_num_scales, "sift.dsp_num_scales", 1);
+  AddOptionInt(&sift_options.tile_size, "sift.tile_size", 0);
+  AddOptionInt(&sift_options.tile_overlap, "sift.tile_overlap", 0);
+  AddOptionInt(&sift_options.tile_num_threads, "sift.tile_num_threads", -1);
 }
 
 void SIFTExtractionWidget::Run() {
@@ -172,6 +177,8 @@ AlikedExtractionWidget::AlikedExtractionWidget(QWidget* parent,
   AddOptionInt(&options->feature_extraction->num_threads, "num_threads", -1);
   AddOptionBool(&options->feature_extraction->use_gpu, "use_gpu");
   AddOptionText(&options->feature_extraction->gpu_index, "gpu_index");
+  AddOptionInt(&options->feature_extraction->num_cpu_workers,
+               "num_cpu_workers");
 
   model_variant_cb_ = new QComboBox(this);
   model_variant_cb_->addItem(
@@ -82,6 +82,12 @@ class VocabTreeMatchingTab : public FeatureMatchingTab {
   void Run() override;
 };
 
+class GlobalDescriptorMatchingTab : public FeatureMatchingTab {
+ public:
+  GlobalDescriptorMatchingTab(QWidget* parent, OptionManager* options);
+  void Run() override;
+};
+
 class SpatialMatchingTab : public FeatureMatchingTab {
  public:
   SpatialMatchingTab(QWidget* parent, OptionManager* options);
@@ -137,6 +143,9 @@ void FeatureMatchingTab::CreateGeneralOptions() {
                                  "gpu_index");
   options_widget_->AddOptionInt(&options_->feature_matching->max_num_matches,
                                 "max_num_matches");
+  options_widget_->AddOptionInt(&options_->feature_matching->max_num_features,
+                                "max_num_features",
+                                -1);
   options_widget_->AddOptionBool(&options_->feature_matching->guided_matching,
                                  "guided_matching");
   options_widget_->AddOptionBool(
@@ -244,6 +253,12 @@ SequentialMatchingTab::SequentialMatchingTab(QWidget* parent,
                                 "overlap");
   options_widget_->AddOptionBool(
       &options_->sequential_pairing->quadratic_overlap, "quadratic_overlap");
+  options_widget_->AddOptionBool(
+      &options_->sequential_pairing->adaptive_overlap, "adaptive_overlap");
+  options_widget_->AddOptionInt(
+      &options_->sequential_pairing->adaptive_overlap_min_num_inliers,
+      "adaptive_overlap_min_num_inliers",
+      0);
   options_widget_->AddOptionBool(&options_->sequential_pairing->loop_detection,
                                  "loop_detection");
   options_widget_->AddOptionInt(
@@ -268,6 +283,10 @@ SequentialMatchingTab::SequentialMatchingTab(QWidget* parent,
       &options_->sequential_pairing->loop_detection_max_num_features,
       "loop_detection_max_num_features",
       -1);
+  options_widget_->AddOptionInt(
+      &options_->sequential_pairing->loop_detection_query_batch_size,
+      "loop_detection_query_batch_size",
+      1);
   options_widget_->AddOptionFilePath(
       &options_->sequential_pairing->vocab_tree_path, "vocab_tree_path");
 
@@ -312,6 +331,8 @@ VocabTreeMatchingTab::VocabTreeMatchingTab(QWidget* parent,
       &options_->vocab_tree_pairing->max_num_features, "max_num_features", -1);
   options_widget_->AddOptionFilePath(
       &options_->vocab_tree_pairing->vocab_tree_path, "vocab_tree_path");
+  options_widget_->AddOptionFilePath(&options_->vocab_tree_pairing->index_path,
+                                     "index_path");
 
   CreateGeneralOptions();
 }
@@ -335,6 +356,37 @@ void VocabTreeMatchingTab::Run() {
   thread_control_widget_->StartThread("Matching...", true, std::move(matcher));
 }
 
+GlobalDescriptorMatchingTab::GlobalDescriptorMatchingTab(
+    QWidget* parent, OptionManager* options)
+    : FeatureMatchingTab(parent, options) {
+  options_widget_->AddOptionInt(
+      &options_->global_descriptor_pairing->num_images, "num_images");
+  options_widget_->AddOptionInt(
+      &options_->global_descriptor_pairing->num_clusters, "num_clusters");
+  options_widget_->AddOptionInt(
+      &options_->global_descriptor_pairing->codebook_num_training_features,
+      "codebook_num_training_features");
+  options_widget_->AddOptionInt(
+      &options_->global_descriptor_pairing->max_num_features,
+      "max_num_features",
+      -1);
+  options_widget_->AddOptionFilePath(
+      &options_->global_descriptor_pairing->codebook_path, "codebook_path");
+
+  CreateGeneralOptions();
+}
+
+void GlobalDescriptorMatchingTab::Run() {
+  WriteOptions();
+
+  auto matcher = CreateGlobalDescriptorFeatureMatcher(
+      *options_->global_descriptor_pairing,
+      *options_->feature_matching,
+      *options_->two_view_geometry,
+      *options_->database_path);
+  thread_control_widget_->StartThread("Matching...", true, std::move(matcher));
+}
+
 SpatialMatchingTab::SpatialMatchingTab(QWidget* parent, OptionManager* options)
     : FeatureMatchingTab(parent, options) {
   options_widget_->AddOptionBool(&options_->spatial_pairing->ignore_z,
@@ -366,6 +418,10 @@ TransitiveMatchingTab::TransitiveMatchingTab(QWidget* parent,
                                 "batch_size");
   options_widget_->AddOptionInt(&options->transitive_pairing->num_iterations,
                                 "num_iterations");
+  options_widget_->AddOptionInt(
+      &options->transitive_pairing->max_num_candidates_per_image,
+      "max_num_candidates_per_image",
+      -1);
 
   CreateGeneralOptions();
 }
@@ -447,6 +503,8 @@ FeatureMatchingWidget::FeatureMatchingWidget(QWidget* parent,
   tab_widget_->addTab(new SequentialMatchingTab(this, options),
                       tr("Sequential"));
   tab_widget_->addTab(new VocabTreeMatchingTab(this, options), tr("VocabTree"));
+  tab_widget_->addTab(new GlobalDescriptorMatchingTab(this, options),
+                      tr("GlobalDescriptor"));
   tab_widget_->addTab(new SpatialMatchingTab(this, options), tr("Spatial"));
   tab_widget_->addTab(new TransitiveMatchingTab(this, options),
                       tr("Transitive"));
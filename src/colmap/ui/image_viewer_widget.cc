@@ -46,7 +46,23 @@ QGraphicsPixmapItem* ImageViewerGraphicsScene::ImagePixmapItem() const {
   return image_pixmap_item_;
 }
 
-ImageViewerWidget::ImageViewerWidget(QWidget* parent) : QWidget(parent) {
+namespace {
+
+// Reads the image at the given path as a QImage, which, unlike a QPixmap, can
+// be created outside of the UI thread.
+QImage ReadImage(const std::filesystem::path& path) {
+  Bitmap bitmap;
+  if (!bitmap.Read(path, /*as_rgb=*/true)) {
+    LOG(ERROR) << "Cannot read image at path " << path;
+    return QImage();
+  }
+  return BitmapToQImageRGB(bitmap);
+}
+
+}  // namespace
+
+ImageViewerWidget::ImageViewerWidget(QWidget* parent)
+    : QWidget(parent), async_generation_(0), async_thread_pool_(1) {
   setWindowFlags(Qt::Window | Qt::WindowTitleHint |
                  Qt::WindowMinimizeButtonHint | Qt::WindowMaximizeButtonHint |
                  Qt::WindowCloseButtonHint);
@@ -105,6 +121,8 @@ void ImageViewerWidget::closeEvent(QCloseEvent* event) {
 }
 
 void ImageViewerWidget::ShowBitmap(const Bitmap& bitmap) {
+  // Discard pending loads, which would otherwise replace the bitmap.
+  ++async_generation_;
   ShowPixmap(QPixmap::fromImage(BitmapToQImageRGB(bitmap)));
 }
 
@@ -119,13 +137,48 @@ void ImageViewerWidget::ShowPixmap(const QPixmap& pixmap) {
 }
 
 void ImageViewerWidget::ReadAndShow(const std::filesystem::path& path) {
-  Bitmap bitmap;
-  if (!bitmap.Read(path, /*as_rgb=*/true)) {
-    LOG(ERROR) << "Cannot read image at path " << path;
-    return;
-  }
+  RunAsync([this, path]() -> std::function<void()> {
+    QImage image = ReadImage(path);
+    if (image.isNull()) {
+      return nullptr;
+    }
+    return [this, image = std::move(image)]() {
+      ShowPixmap(QPixmap::fromImage(image));
+    };
+  });
+}
 
-  ShowBitmap(bitmap);
+void ImageViewerWidget::RunAsync(
+    std::function<std::function<void()>()> load_fn) {
+  const int generation = ++async_generation_;
+  async_thread_pool_.AddTask([this,
+                              generation,
+                              load_fn = std::move(load_fn)]() {
+    // Skip loads that were superseded while they were queued.
+    if (generation != async_generation_) {
+      return;
+    }
+
+    // Exceptions must not escape, since the thread pool rethrows them.
+    std::function<void()> show_fn;
+    try {
+      show_fn = load_fn();
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Failed to load image: " << e.what();
+    }
+    if (!show_fn) {
+      return;
+    }
+
+    QMetaObject::invokeMethod(
+        this,
+        [this, generation, show_fn = std::move(show_fn)]() {
+          if (generation == async_generation_) {
+            show_fn();
+          }
+        },
+        Qt::QueuedConnection);
+  });
 }
 
 void ImageViewerWidget::ZoomIn() {
@@ -173,15 +226,6 @@ void FeatureImageViewerWidget::ReadAndShowWithKeypoints(
     const std::filesystem::path& path,
     const FeatureKeypoints& keypoints,
     const std::vector<char>& tri_mask) {
-  Bitmap bitmap;
-  if (!bitmap.Read(path, /*as_rgb=*/true)) {
-    LOG(ERROR) << "Cannot read image at path " << path;
-    return;
-  }
-
-  image1_ = QPixmap::fromImage(BitmapToQImageRGB(bitmap));
-  image2_ = image1_;
-
   const size_t num_tri_keypoints = std::count_if(
       tri_mask.begin(), tri_mask.end(), [](const bool tri) { return tri; });
 
@@ -197,14 +241,32 @@ void FeatureImageViewerWidget::ReadAndShowWithKeypoints(
     }
   }
 
-  DrawKeypoints(&image2_, keypoints_tri, Qt::magenta);
-  DrawKeypoints(&image2_, keypoints_not_tri, Qt::red);
-
-  if (switch_state_) {
-    ShowPixmap(image2_);
-  } else {
-    ShowPixmap(image1_);
-  }
+  RunAsync([this,
+            path,
+            keypoints_tri = std::move(keypoints_tri),
+            keypoints_not_tri = std::move(
+                keypoints_not_tri)]() -> std::function<void()> {
+    QImage image = ReadImage(path);
+    if (image.isNull()) {
+      return nullptr;
+    }
+    return [this,
+            image = std::move(image),
+            keypoints_tri,
+            keypoints_not_tri]() {
+      image1_ = QPixmap::fromImage(image);
+      image2_ = image1_;
+
+      DrawKeypoints(&image2_, keypoints_tri, Qt::magenta);
+      DrawKeypoints(&image2_, keypoints_not_tri, Qt::red);
+
+      if (switch_state_) {
+        ShowPixmap(image2_);
+      } else {
+        ShowPixmap(image1_);
+      }
+    };
+  });
 }
 
 void FeatureImageViewerWidget::ReadAndShowWithMatches(
@@ -213,25 +275,32 @@ void FeatureImageViewerWidget::ReadAndShowWithMatches(
     const FeatureKeypoints& keypoints1,
     const FeatureKeypoints& keypoints2,
     const FeatureMatches& matches) {
-  Bitmap bitmap1;
-  Bitmap bitmap2;
-  if (!bitmap1.Read(path1, /*as_rgb=*/true) ||
-      !bitmap2.Read(path2, /*as_rgb=*/true)) {
-    LOG(ERROR) << "Cannot read images at paths " << path1 << " and " << path2;
-    return;
-  }
-
-  const auto image1 = QPixmap::fromImage(BitmapToQImageRGB(bitmap1));
-  const auto image2 = QPixmap::fromImage(BitmapToQImageRGB(bitmap2));
-
-  image1_ = ShowImagesSideBySide(image1, image2);
-  image2_ = DrawMatches(image1, image2, keypoints1, keypoints2, matches);
-
-  if (switch_state_) {
-    ShowPixmap(image2_);
-  } else {
-    ShowPixmap(image1_);
-  }
+  RunAsync([this, path1, path2, keypoints1, keypoints2, matches]()
+               -> std::function<void()> {
+    QImage image1 = ReadImage(path1);
+    QImage image2 = ReadImage(path2);
+    if (image1.isNull() || image2.isNull()) {
+      return nullptr;
+    }
+    return [this,
+            image1 = std::move(image1),
+            image2 = std::move(image2),
+            keypoints1,
+            keypoints2,
+            matches]() {
+      const auto pixmap1 = QPixmap::fromImage(image1);
+      const auto pixmap2 = QPixmap::fromImage(image2);
+
+      image1_ = ShowImagesSideBySide(pixmap1, pixmap2);
+      image2_ = DrawMatches(pixmap1, pixmap2, keypoints1, keypoints2, matches);
+
+      if (switch_state_) {
+        ShowPixmap(image2_);
+      } else {
+        ShowPixmap(image1_);
+      }
+    };
+  });
 }
 
 void FeatureImageViewerWidget::ShowOrHide() {
@@ -34,6 +34,10 @@
 #include "colmap/scene/projection.h"
 #include "colmap/scene/reconstruction.h"
 #include "colmap/ui/qt_utils.h"
+#include "colmap/util/threading.h"
+
+#include <atomic>
+#include <functional>
 
 #include <QtCore>
 #include <QtWidgets>
@@ -66,6 +70,12 @@ class ImageViewerWidget : public QWidget {
   ImageViewerGraphicsScene graphics_scene_;
   QGraphicsView* graphics_view_;
 
+  // Incremented for every asynchronous load to discard outdated results.
+  std::atomic<int> async_generation_;
+  // Declared last, so that a running load finishes before the other members
+  // are destroyed.
+  ThreadPool async_thread_pool_;
+
  protected:
   void resizeEvent(QResizeEvent* event);
   void closeEvent(QCloseEvent* event);
@@ -73,6 +83,14 @@ class ImageViewerWidget : public QWidget {
   void ZoomOut();
   void Save();
 
+  // Runs the given load function in a background thread and then the
+  // function it returns in the UI thread, unless another load was started in
+  // the meantime, e.g., because the user already selected another image.
+  // Expensive work, such as reading and decoding images, should thus be done
+  // in the load function, while widgets and pixmaps may only be accessed in
+  // the returned function.
+  void RunAsync(std::function<std::function<void()>()> load_fn);
+
   QGridLayout* grid_layout_;
   QHBoxLayout* button_layout_;
 };
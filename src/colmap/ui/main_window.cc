@@ -902,6 +902,7 @@ void MainWindow::CreateControllers() {
           *options_.hierarchical_mapper;
       hierarchical_options.image_path = *options_.image_path;
       hierarchical_options.incremental_options = *options_.mapper;
+      hierarchical_options.global_options = *options_.global_mapper;
       // The hierarchical mapper reconstructs clusters in separate managers and
       // only populates the main reconstruction at the end, so no intermediate
       // render callback is wired; only the finished callback below renders.
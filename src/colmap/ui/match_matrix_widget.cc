@@ -29,18 +29,23 @@
 
 #include "colmap/ui/match_matrix_widget.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace colmap {
+namespace {
 
-MatchMatrixWidget::MatchMatrixWidget(QWidget* parent, OptionManager* options)
-    : ImageViewerWidget(parent), options_(options) {
-  setWindowTitle("Match matrix");
-}
+// Computes the match matrix of the images sorted by name. For many images,
+// each pixel of the matrix shows the maximum number of inliers of a square
+// tile of image pairs, so that the size of the matrix is bounded.
+Bitmap ComputeMatchMatrix(const std::filesystem::path& database_path) {
+  // Maximum width and height of the match matrix in pixels.
+  constexpr size_t kMaxMatrixSize = 2048;
 
-void MatchMatrixWidget::Show() {
-  const auto database = Database::Open(*options_->database_path);
+  const auto database = Database::Open(database_path);
 
   if (database->NumImages() == 0) {
-    return;
+    return Bitmap();
   }
 
   // Sort the images according to their name.
@@ -51,42 +56,86 @@ void MatchMatrixWidget::Show() {
               return image1.Name() < image2.Name();
             });
 
-  // Allocate the match matrix image.
-  Bitmap match_matrix(images.size(), images.size(), true);
-  match_matrix.Fill(BitmapColor<uint8_t>(255));
+  const size_t tile_size =
+      (images.size() + kMaxMatrixSize - 1) / kMaxMatrixSize;
+  const size_t matrix_size = (images.size() + tile_size - 1) / tile_size;
 
   // Map image identifiers to match matrix locations.
   std::unordered_map<image_t, size_t> image_id_to_idx;
   for (size_t idx = 0; idx < images.size(); ++idx) {
-    image_id_to_idx.emplace(images[idx].ImageId(), idx);
+    image_id_to_idx.emplace(images[idx].ImageId(), idx / tile_size);
   }
+  images.clear();
 
   const std::vector<std::pair<image_pair_t, int>> pair_ids_and_num_inliers =
       database->ReadTwoViewGeometryNumInliers();
 
+  std::vector<int> max_num_inliers(matrix_size * matrix_size, 0);
+  int max_value = 0;
+  for (const auto& [pair_id, num_inliers] : pair_ids_and_num_inliers) {
+    const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
+    const size_t idx1 = image_id_to_idx.at(image_id1);
+    const size_t idx2 = image_id_to_idx.at(image_id2);
+    int& value1 = max_num_inliers[idx1 * matrix_size + idx2];
+    int& value2 = max_num_inliers[idx2 * matrix_size + idx1];
+    value1 = std::max(value1, num_inliers);
+    value2 = std::max(value2, num_inliers);
+    max_value = std::max(max_value, num_inliers);
+  }
+
+  // Allocate the match matrix image.
+  Bitmap match_matrix(matrix_size, matrix_size, true);
+  match_matrix.Fill(BitmapColor<uint8_t>(255));
+
   // Fill the match matrix.
-  if (!pair_ids_and_num_inliers.empty()) {
-    const double max_value =
-        std::log1p(std::max_element(pair_ids_and_num_inliers.begin(),
-                                    pair_ids_and_num_inliers.end(),
-                                    [](const auto& left, const auto& right) {
-                                      return left.second < right.second;
-                                    })
-                       ->second);
-    for (const auto& [pair_id, num_inliers] : pair_ids_and_num_inliers) {
-      const double value = std::log1p(num_inliers) / max_value;
-      const auto [image_id1, image_id2] = PairIdToImagePair(pair_id);
-      const size_t idx1 = image_id_to_idx.at(image_id1);
-      const size_t idx2 = image_id_to_idx.at(image_id2);
-      const BitmapColor<float> color(255 * JetColormap::Red(value),
-                                     255 * JetColormap::Green(value),
-                                     255 * JetColormap::Blue(value));
-      match_matrix.SetPixel(idx1, idx2, color.Cast<uint8_t>());
-      match_matrix.SetPixel(idx2, idx1, color.Cast<uint8_t>());
+  if (max_value > 0) {
+    const double max_log_value = std::log1p(max_value);
+    for (size_t idx1 = 0; idx1 < matrix_size; ++idx1) {
+      for (size_t idx2 = 0; idx2 < matrix_size; ++idx2) {
+        const int num_inliers = max_num_inliers[idx1 * matrix_size + idx2];
+        if (num_inliers == 0) {
+          continue;
+        }
+        const double value = std::log1p(num_inliers) / max_log_value;
+        const BitmapColor<float> color(255 * JetColormap::Red(value),
+                                       255 * JetColormap::Green(value),
+                                       255 * JetColormap::Blue(value));
+        match_matrix.SetPixel(idx1, idx2, color.Cast<uint8_t>());
+      }
     }
   }
 
-  ShowBitmap(match_matrix);
+  return match_matrix;
+}
+
+}  // namespace
+
+MatchMatrixWidget::MatchMatrixWidget(QWidget* parent, OptionManager* options)
+    : ImageViewerWidget(parent), options_(options) {
+  setWindowTitle("Match matrix");
+}
+
+void MatchMatrixWidget::Show() {
+  // Compute the match matrix in the background, since reading the matches
+  // of large databases takes a long time.
+  setWindowTitle("Match matrix (loading...)");
+  show();
+  raise();
+
+  RunAsync([this, database_path = *options_->database_path]()
+               -> std::function<void()> {
+    const Bitmap match_matrix = ComputeMatchMatrix(database_path);
+    if (match_matrix.IsEmpty()) {
+      return [this]() {
+        setWindowTitle("Match matrix");
+        hide();
+      };
+    }
+    return [this, image = BitmapToQImageRGB(match_matrix)]() {
+      setWindowTitle("Match matrix");
+      ShowPixmap(QPixmap::fromImage(image));
+    };
+  });
 }
 
 }  // namespace colmap
@@ -467,8 +467,12 @@ void ModelViewerWidget::paintGL() {
   }
 
   // Points
-  point_painter_.Render(pmv_matrix, point_size_);
-  point_cloud_painter_.Render(pmv_matrix, point_size_);
+  const size_t max_num_points =
+      static_cast<size_t>(options_->render->max_num_points);
+  point_painter_.Render(
+      pmv_matrix, width(), height(), point_size_, max_num_points);
+  point_cloud_painter_.Render(
+      pmv_matrix, width(), height(), point_size_, max_num_points);
   point_connection_painter_.Render(pmv_matrix, width(), height(), 1);
 
   // Mesh
@@ -506,8 +510,9 @@ void ModelViewerWidget::ReloadReconstruction() {
 
   rigs = reconstruction->Rigs();
   cameras = reconstruction->Cameras();
-  frames = reconstruction->Frames();
-  points3D = reconstruction->Points3D();
+  // The mapper is blocked during the reload and does not keep references to
+  // 3D points across its render callbacks, so the points can be shared.
+  points3D = reconstruction->Points3D().Snapshot();
 
   frames.clear();
   images.clear();
@@ -740,7 +745,11 @@ void ModelViewerWidget::SelectObject(const int x, const int y) {
   // Render in selection mode, with larger points to improve selection accuracy.
   const QMatrix4x4 pmv_matrix = projection_matrix_ * model_view_matrix_;
   image_triangle_painter_.Render(pmv_matrix);
-  point_painter_.Render(pmv_matrix, 2 * point_size_);
+  point_painter_.Render(pmv_matrix,
+                        width(),
+                        height(),
+                        2 * point_size_,
+                        static_cast<size_t>(options_->render->max_num_points));
 
   const int scaled_x = devicePixelRatio() * x;
   const int scaled_y = devicePixelRatio() * (height() - y - 1);
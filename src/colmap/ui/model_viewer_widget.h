@@ -125,7 +125,7 @@ class ModelViewerWidget : public QOpenGLWidget,
   std::unordered_map<camera_t, Camera> cameras;
   std::unordered_map<frame_t, Frame> frames;
   std::unordered_map<image_t, Image> images;
-  std::unordered_map<point3D_t, Point3D> points3D;
+  DenseIdMap<point3D_t, Point3D> points3D;
   std::vector<image_t> reg_image_ids;
 
   std::optional<std::vector<PlyPoint>> point_cloud;
@@ -0,0 +1,303 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/ui/point_octree.h"
+
+#include "colmap/util/logging.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <queue>
+
+namespace colmap {
+
+void PointOctree::Build(const std::vector<Eigen::Vector3f>& points,
+                        const int max_num_points_per_node) {
+  THROW_CHECK_GT(max_num_points_per_node, 0);
+  THROW_CHECK_LE(points.size(), std::numeric_limits<uint32_t>::max());
+
+  max_num_points_per_node_ = max_num_points_per_node;
+  order_.resize(points.size());
+  std::iota(order_.begin(), order_.end(), 0);
+  nodes_.clear();
+
+  if (points.empty()) {
+    return;
+  }
+
+  Eigen::AlignedBox3f bounds;
+  for (const Eigen::Vector3f& point : points) {
+    bounds.extend(point);
+  }
+
+  BuildNode(points, bounds, 0, static_cast<uint32_t>(points.size()), 0);
+}
+
+void PointOctree::UpdateBounds(
+    const std::vector<Eigen::Vector3f>& ordered_points) {
+  THROW_CHECK_EQ(ordered_points.size(), order_.size());
+  if (!nodes_.empty()) {
+    UpdateNodeBounds(ordered_points, 0);
+  }
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> PointOctree::SelectRanges(
+    const Eigen::Matrix4f& pmv_matrix,
+    const int width,
+    const int height,
+    const float max_point_spacing,
+    const size_t max_num_points) const {
+  std::vector<std::pair<uint32_t, uint32_t>> ranges;
+  if (nodes_.empty() || max_num_points == 0) {
+    return ranges;
+  }
+
+  // Returns false if the node is outside the view frustum and otherwise
+  // computes the projected size of the node in pixels.
+  const auto ProjectNode = [&](const Node& node, float* extent) {
+    uint8_t outside_mask = 0x3f;
+    bool behind_camera = false;
+    Eigen::Vector2f min_ndc =
+        Eigen::Vector2f::Constant(std::numeric_limits<float>::max());
+    Eigen::Vector2f max_ndc = -min_ndc;
+    for (int i = 0; i < 8; ++i) {
+      const Eigen::Vector3f corner =
+          node.bbox.corner(static_cast<Eigen::AlignedBox3f::CornerType>(i));
+      const Eigen::Vector4f clip = pmv_matrix * corner.homogeneous();
+      const uint8_t corner_outside_mask =
+          (clip.x() < -clip.w()) | ((clip.x() > clip.w()) << 1) |
+          ((clip.y() < -clip.w()) << 2) | ((clip.y() > clip.w()) << 3) |
+          ((clip.z() < -clip.w()) << 4) | ((clip.z() > clip.w()) << 5);
+      outside_mask &= corner_outside_mask;
+      if (clip.w() <= std::numeric_limits<float>::epsilon()) {
+        behind_camera = true;
+      } else {
+        const Eigen::Vector2f ndc = clip.head<2>() / clip.w();
+        min_ndc = min_ndc.cwiseMin(ndc);
+        max_ndc = max_ndc.cwiseMax(ndc);
+      }
+    }
+
+    // All corners are outside of the same clipping plane.
+    if (outside_mask != 0) {
+      return false;
+    }
+
+    if (behind_camera) {
+      *extent = std::numeric_limits<float>::max();
+    } else {
+      *extent = 0.5f * std::max((max_ndc.x() - min_ndc.x()) * width,
+                                (max_ndc.y() - min_ndc.y()) * height);
+    }
+    return true;
+  };
+
+  // Refine the nodes with the largest projected size first.
+  std::priority_queue<std::pair<float, int>> queue;
+  float root_extent;
+  if (ProjectNode(nodes_[0], &root_extent)) {
+    queue.emplace(root_extent, 0);
+  }
+
+  size_t num_points = 0;
+  while (!queue.empty()) {
+    const auto [extent, node_idx] = queue.top();
+    queue.pop();
+
+    const Node& node = nodes_[node_idx];
+    const uint32_t num_node_points = node.end - node.begin;
+    if (num_points + num_node_points > max_num_points) {
+      break;
+    }
+    if (num_node_points > 0) {
+      ranges.emplace_back(node.begin, node.end);
+      num_points += num_node_points;
+    }
+
+    // The points of a node are spread evenly over its extent, so their
+    // projected spacing decreases with the square root of their number.
+    const float point_spacing =
+        extent / std::sqrt(static_cast<float>(std::max(num_node_points, 1u)));
+    if (point_spacing <= max_point_spacing) {
+      continue;
+    }
+
+    for (const int child_idx : node.children) {
+      float child_extent;
+      if (child_idx >= 0 && ProjectNode(nodes_[child_idx], &child_extent)) {
+        queue.emplace(child_extent, child_idx);
+      }
+    }
+  }
+
+  std::sort(ranges.begin(), ranges.end());
+
+  // Merge adjacent ranges to reduce the number of draw calls.
+  size_t num_merged_ranges = 0;
+  for (const auto& range : ranges) {
+    if (num_merged_ranges > 0 &&
+        ranges[num_merged_ranges - 1].second == range.first) {
+      ranges[num_merged_ranges - 1].second = range.second;
+    } else {
+      ranges[num_merged_ranges++] = range;
+    }
+  }
+  ranges.resize(num_merged_ranges);
+
+  return ranges;
+}
+
+int PointOctree::BuildNode(const std::vector<Eigen::Vector3f>& points,
+                           const Eigen::AlignedBox3f& bounds,
+                           const uint32_t begin,
+                           const uint32_t end,
+                           const int depth) {
+  const int node_idx = static_cast<int>(nodes_.size());
+  nodes_.emplace_back();
+
+  if (end - begin <= static_cast<uint32_t>(max_num_points_per_node_) ||
+      depth >= kMaxDepth) {
+    Node& node = nodes_[node_idx];
+    node.begin = begin;
+    node.end = end;
+    for (uint32_t i = begin; i < end; ++i) {
+      node.bbox.extend(points[order_[i]]);
+    }
+    return node_idx;
+  }
+
+  // Keep the first point in each cell of a regular grid over the bounds of
+  // the node, so that the points of the node are spread evenly in space.
+  const int grid_size = std::max(
+      1, static_cast<int>(std::cbrt(max_num_points_per_node_ + 0.5)));
+  const Eigen::Vector3f grid_scale =
+      (grid_size / bounds.sizes().array().max(
+                       std::numeric_limits<float>::epsilon()))
+          .matrix();
+  std::vector<bool> occupied_cells(grid_size * grid_size * grid_size, false);
+  uint32_t num_node_points = 0;
+  for (uint32_t i = begin; i < end; ++i) {
+    const Eigen::Vector3i cell =
+        ((points[order_[i]] - bounds.min()).cwiseProduct(grid_scale))
+            .cast<int>()
+            .cwiseMax(0)
+            .cwiseMin(grid_size - 1);
+    const int cell_idx = (cell.z() * grid_size + cell.y()) * grid_size +
+                         cell.x();
+    if (!occupied_cells[cell_idx]) {
+      occupied_cells[cell_idx] = true;
+      std::swap(order_[i], order_[begin + num_node_points]);
+      ++num_node_points;
+    }
+  }
+
+  const uint32_t children_begin = begin + num_node_points;
+  nodes_[node_idx].begin = begin;
+  nodes_[node_idx].end = children_begin;
+
+  // Distribute the remaining points to the octants of the bounds.
+  const Eigen::Vector3f center = bounds.center();
+  const auto Octant = [&center](const Eigen::Vector3f& point) {
+    return static_cast<int>(point.x() >= center.x()) |
+           (static_cast<int>(point.y() >= center.y()) << 1) |
+           (static_cast<int>(point.z() >= center.z()) << 2);
+  };
+
+  std::array<uint32_t, 9> octant_begins{};
+  for (uint32_t i = children_begin; i < end; ++i) {
+    ++octant_begins[Octant(points[order_[i]]) + 1];
+  }
+  for (int octant = 0; octant < 8; ++octant) {
+    octant_begins[octant + 1] += octant_begins[octant];
+  }
+
+  std::vector<uint32_t> octant_order(end - children_begin);
+  std::array<uint32_t, 8> octant_offsets;
+  std::copy_n(octant_begins.begin(), 8, octant_offsets.begin());
+  for (uint32_t i = children_begin; i < end; ++i) {
+    octant_order[octant_offsets[Octant(points[order_[i]])]++] = order_[i];
+  }
+  std::copy(octant_order.begin(),
+            octant_order.end(),
+            order_.begin() + children_begin);
+  octant_order.clear();
+  octant_order.shrink_to_fit();
+
+  for (int octant = 0; octant < 8; ++octant) {
+    const uint32_t octant_begin = children_begin + octant_begins[octant];
+    const uint32_t octant_end = children_begin + octant_begins[octant + 1];
+    if (octant_begin == octant_end) {
+      continue;
+    }
+    Eigen::AlignedBox3f octant_bounds;
+    for (int d = 0; d < 3; ++d) {
+      if (octant & (1 << d)) {
+        octant_bounds.min()(d) = center(d);
+        octant_bounds.max()(d) = bounds.max()(d);
+      } else {
+        octant_bounds.min()(d) = bounds.min()(d);
+        octant_bounds.max()(d) = center(d);
+      }
+    }
+    const int child_idx =
+        BuildNode(points, octant_bounds, octant_begin, octant_end, depth + 1);
+    nodes_[node_idx].children[octant] = child_idx;
+  }
+
+  Node& node = nodes_[node_idx];
+  for (uint32_t i = node.begin; i < node.end; ++i) {
+    node.bbox.extend(points[order_[i]]);
+  }
+  for (const int child_idx : node.children) {
+    if (child_idx >= 0) {
+      node.bbox.extend(nodes_[child_idx].bbox);
+    }
+  }
+
+  return node_idx;
+}
+
+void PointOctree::UpdateNodeBounds(
+    const std::vector<Eigen::Vector3f>& ordered_points, const int node_idx) {
+  Eigen::AlignedBox3f bbox;
+  for (uint32_t i = nodes_[node_idx].begin; i < nodes_[node_idx].end; ++i) {
+    bbox.extend(ordered_points[i]);
+  }
+  for (const int child_idx : nodes_[node_idx].children) {
+    if (child_idx >= 0) {
+      UpdateNodeBounds(ordered_points, child_idx);
+      bbox.extend(nodes_[child_idx].bbox);
+    }
+  }
+  nodes_[node_idx].bbox = bbox;
+}
+
+}  // namespace colmap
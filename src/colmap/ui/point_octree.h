@@ -0,0 +1,114 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace colmap {
+
+// Spatial hierarchy over a set of points for level-of-detail rendering.
+//
+// Each node holds a spatially evenly spread subset of the points inside its
+// bounds and distributes the remaining points to its children. The points are
+// reordered, such that the points held by a node are contiguous. Rendering a
+// node together with its ancestors thus gives a coarser version of all the
+// points in its subtree and the renderer can select the detail per node.
+class PointOctree {
+ public:
+  struct Node {
+    // Bounding box of all points in the subtree of the node.
+    Eigen::AlignedBox3f bbox;
+    // Range of the points held by the node in the reordered points.
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    // Indices of the child nodes or -1 for missing children.
+    std::array<int, 8> children = {-1, -1, -1, -1, -1, -1, -1, -1};
+  };
+
+  // Builds the octree, where each node holds at most the given number of
+  // points, unless the maximum depth is reached.
+  void Build(const std::vector<Eigen::Vector3f>& points,
+             int max_num_points_per_node = 4096);
+
+  // Recomputes the bounding boxes of the nodes after some of the points moved
+  // without changing the structure of the tree. The points must be given in
+  // the reordered sequence.
+  void UpdateBounds(const std::vector<Eigen::Vector3f>& ordered_points);
+
+  // Selects the ranges of the reordered points to render for the given
+  // projection-model-view matrix and viewport size. Nodes outside the view
+  // frustum are culled. Nodes are refined in the order of their projected
+  // size until the projected spacing of their points is below the given
+  // number of pixels or the maximum number of points is reached. The returned
+  // ranges are sorted and adjacent ranges are merged.
+  std::vector<std::pair<uint32_t, uint32_t>> SelectRanges(
+      const Eigen::Matrix4f& pmv_matrix,
+      int width,
+      int height,
+      float max_point_spacing,
+      size_t max_num_points) const;
+
+  // The index of the input point for each position in the reordered points.
+  inline const std::vector<uint32_t>& Order() const;
+  inline const std::vector<Node>& Nodes() const;
+
+ private:
+  static constexpr int kMaxDepth = 21;
+
+  int BuildNode(const std::vector<Eigen::Vector3f>& points,
+                const Eigen::AlignedBox3f& bounds,
+                uint32_t begin,
+                uint32_t end,
+                int depth);
+  void UpdateNodeBounds(const std::vector<Eigen::Vector3f>& ordered_points,
+                        int node_idx);
+
+  int max_num_points_per_node_ = 0;
+  std::vector<uint32_t> order_;
+  std::vector<Node> nodes_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////////////////////////////////////
+
+const std::vector<uint32_t>& PointOctree::Order() const { return order_; }
+
+const std::vector<PointOctree::Node>& PointOctree::Nodes() const {
+  return nodes_;
+}
+
+}  // namespace colmap
@@ -0,0 +1,197 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/ui/point_octree.h"
+
+#include "colmap/math/random.h"
+
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+std::vector<Eigen::Vector3f> RandomPoints(const int num_points) {
+  std::vector<Eigen::Vector3f> points(num_points);
+  for (Eigen::Vector3f& point : points) {
+    point = Eigen::Vector3f(RandomUniformReal<float>(-1, 1),
+                            RandomUniformReal<float>(-1, 1),
+                            RandomUniformReal<float>(-1, 1));
+  }
+  return points;
+}
+
+Eigen::Matrix4f LookAtOrigin(const float distance) {
+  // Perspective projection with 90 degrees field of view of a camera at
+  // (0, 0, distance) looking towards the origin.
+  const float near = 0.1f;
+  const float far = 100.0f;
+  Eigen::Matrix4f projection = Eigen::Matrix4f::Zero();
+  projection(0, 0) = 1;
+  projection(1, 1) = 1;
+  projection(2, 2) = -(far + near) / (far - near);
+  projection(2, 3) = -2 * far * near / (far - near);
+  projection(3, 2) = -1;
+  Eigen::Matrix4f model_view = Eigen::Matrix4f::Identity();
+  model_view(2, 3) = -distance;
+  return projection * model_view;
+}
+
+size_t NumSelectedPoints(
+    const std::vector<std::pair<uint32_t, uint32_t>>& ranges) {
+  size_t num_points = 0;
+  for (const auto& [begin, end] : ranges) {
+    num_points += end - begin;
+  }
+  return num_points;
+}
+
+TEST(PointOctree, Empty) {
+  PointOctree octree;
+  octree.Build({});
+  EXPECT_TRUE(octree.Order().empty());
+  EXPECT_TRUE(octree.Nodes().empty());
+  EXPECT_TRUE(
+      octree.SelectRanges(LookAtOrigin(5), 100, 100, 1, 1000).empty());
+}
+
+TEST(PointOctree, Build) {
+  SetPRNGSeed(0);
+  const std::vector<Eigen::Vector3f> points = RandomPoints(10000);
+  PointOctree octree;
+  octree.Build(points, /*max_num_points_per_node=*/64);
+
+  // The order is a permutation of the points.
+  std::vector<uint32_t> order = octree.Order();
+  std::sort(order.begin(), order.end());
+  for (size_t i = 0; i < order.size(); ++i) {
+    EXPECT_EQ(order[i], i);
+  }
+
+  // The nodes partition the reordered points and their bounding boxes
+  // contain all points of their subtrees.
+  std::vector<int> point_nodes(points.size(), -1);
+  for (size_t node_idx = 0; node_idx < octree.Nodes().size(); ++node_idx) {
+    const PointOctree::Node& node = octree.Nodes()[node_idx];
+    EXPECT_LE(node.end - node.begin, 64);
+    for (uint32_t i = node.begin; i < node.end; ++i) {
+      EXPECT_EQ(point_nodes[i], -1);
+      point_nodes[i] = static_cast<int>(node_idx);
+      EXPECT_TRUE(node.bbox.contains(points[octree.Order()[i]]));
+    }
+    for (const int child_idx : node.children) {
+      if (child_idx >= 0) {
+        EXPECT_TRUE(node.bbox.contains(octree.Nodes()[child_idx].bbox));
+      }
+    }
+  }
+  EXPECT_EQ(std::count(point_nodes.begin(), point_nodes.end(), -1), 0);
+}
+
+TEST(PointOctree, BuildDuplicatePoints) {
+  const std::vector<Eigen::Vector3f> points(1000, Eigen::Vector3f(1, 2, 3));
+  PointOctree octree;
+  octree.Build(points, /*max_num_points_per_node=*/8);
+  EXPECT_EQ(octree.Order().size(), points.size());
+  // The points project to a single pixel and are thus not refined.
+  EXPECT_EQ(NumSelectedPoints(octree.SelectRanges(
+                LookAtOrigin(5), 100, 100, 0, points.size())),
+            1);
+  // The maximum depth limits the refinement for a negative spacing.
+  EXPECT_EQ(NumSelectedPoints(octree.SelectRanges(
+                LookAtOrigin(5), 100, 100, -1, points.size())),
+            points.size());
+}
+
+TEST(PointOctree, UpdateBounds) {
+  SetPRNGSeed(0);
+  const std::vector<Eigen::Vector3f> points = RandomPoints(1000);
+  PointOctree octree;
+  octree.Build(points, /*max_num_points_per_node=*/16);
+
+  std::vector<Eigen::Vector3f> ordered_points(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    ordered_points[i] = 2 * points[octree.Order()[i]];
+  }
+  octree.UpdateBounds(ordered_points);
+
+  Eigen::AlignedBox3f bbox;
+  for (const Eigen::Vector3f& point : ordered_points) {
+    bbox.extend(point);
+  }
+  EXPECT_TRUE(octree.Nodes()[0].bbox.isApprox(bbox));
+  for (const PointOctree::Node& node : octree.Nodes()) {
+    for (uint32_t i = node.begin; i < node.end; ++i) {
+      EXPECT_TRUE(node.bbox.contains(ordered_points[i]));
+    }
+  }
+}
+
+TEST(PointOctree, SelectRanges) {
+  SetPRNGSeed(0);
+  const std::vector<Eigen::Vector3f> points = RandomPoints(10000);
+  PointOctree octree;
+  octree.Build(points, /*max_num_points_per_node=*/64);
+
+  // All points are selected with full detail and a sufficient budget.
+  const auto all_ranges =
+      octree.SelectRanges(LookAtOrigin(5), 100, 100, 0, points.size());
+  ASSERT_EQ(all_ranges.size(), 1);
+  EXPECT_EQ(all_ranges[0].first, 0);
+  EXPECT_EQ(all_ranges[0].second, points.size());
+
+  // The number of points is limited by the budget.
+  EXPECT_LE(NumSelectedPoints(
+                octree.SelectRanges(LookAtOrigin(5), 100, 100, 0, 1000)),
+            1000);
+
+  // Fewer points are selected for distant views.
+  const size_t num_near_points = NumSelectedPoints(
+      octree.SelectRanges(LookAtOrigin(5), 100, 100, 1, points.size()));
+  const size_t num_far_points = NumSelectedPoints(
+      octree.SelectRanges(LookAtOrigin(50), 100, 100, 1, points.size()));
+  EXPECT_GT(num_far_points, 0);
+  EXPECT_LT(num_far_points, num_near_points);
+
+  // No points are selected when looking away from the points.
+  EXPECT_TRUE(
+      octree.SelectRanges(LookAtOrigin(-5), 100, 100, 1, points.size())
+          .empty());
+
+  // The selected ranges are sorted and disjoint.
+  const auto ranges =
+      octree.SelectRanges(LookAtOrigin(5), 100, 100, 1, points.size());
+  for (size_t i = 1; i < ranges.size(); ++i) {
+    EXPECT_LT(ranges[i - 1].second, ranges[i].first);
+  }
+}
+
+}  // namespace
+}  // namespace colmap
@@ -29,6 +29,7 @@
 
 #include "colmap/ui/point_painter.h"
 
+#include "colmap/ui/qt_utils.h"
 #include "colmap/util/opengl_utils.h"
 
 namespace colmap {
@@ -43,6 +44,8 @@ PointPainter::~PointPainter() {
 void PointPainter::Setup() {
   vao_.destroy();
   vbo_.destroy();
+  num_geoms_ = 0;
+  data_.clear();
   if (shader_program_.isLinked()) {
     shader_program_.release();
     shader_program_.removeAllShaders();
@@ -64,7 +67,25 @@ void PointPainter::Setup() {
 }
 
 void PointPainter::Upload(const std::vector<PointPainter::Data>& data) {
-  num_geoms_ = data.size();
+  if (num_geoms_ > 0 && data.size() == num_geoms_ && UploadChanges(data)) {
+    return;
+  }
+
+  std::vector<Eigen::Vector3f> positions(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    positions[i] = Eigen::Vector3f(data[i].x, data[i].y, data[i].z);
+  }
+  octree_.Build(positions);
+  positions.clear();
+  positions.shrink_to_fit();
+
+  const std::vector<uint32_t>& order = octree_.Order();
+  data_.resize(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    data_[i] = data[order[i]];
+  }
+
+  num_geoms_ = data_.size();
   if (num_geoms_ == 0) {
     return;
   }
@@ -74,8 +95,8 @@ void PointPainter::Upload(const std::vector<PointPainter::Data>& data) {
 
   // Upload data array to GPU
   vbo_.setUsagePattern(QOpenGLBuffer::DynamicDraw);
-  vbo_.allocate(data.data(),
-                static_cast<int>(data.size() * sizeof(PointPainter::Data)));
+  vbo_.allocate(data_.data(),
+                static_cast<int>(data_.size() * sizeof(PointPainter::Data)));
 
   // in_position
   shader_program_.enableAttributeArray("a_position");
@@ -106,11 +127,24 @@ void PointPainter::Upload(const std::vector<PointPainter::Data>& data) {
 }
 
 void PointPainter::Render(const QMatrix4x4& pmv_matrix,
-                          const float point_size) {
+                          const int width,
+                          const int height,
+                          const float point_size,
+                          const size_t max_num_points) {
   if (num_geoms_ == 0) {
     return;
   }
 
+  const std::vector<std::pair<uint32_t, uint32_t>> ranges =
+      octree_.SelectRanges(QMatrixToEigen(pmv_matrix),
+                           width,
+                           height,
+                           /*max_point_spacing=*/point_size,
+                           max_num_points);
+  if (ranges.empty()) {
+    return;
+  }
+
   shader_program_.bind();
   vao_.bind();
 
@@ -118,7 +152,11 @@ void PointPainter::Render(const QMatrix4x4& pmv_matrix,
   shader_program_.setUniformValue("u_point_size", point_size);
 
   QOpenGLFunctions* gl_funcs = QOpenGLContext::currentContext()->functions();
-  gl_funcs->glDrawArrays(GL_POINTS, 0, (GLsizei)num_geoms_);
+  for (const auto& [begin, end] : ranges) {
+    gl_funcs->glDrawArrays(GL_POINTS,
+                           static_cast<GLint>(begin),
+                           static_cast<GLsizei>(end - begin));
+  }
 
   // Make sure the VAO is not changed from the outside
   vao_.release();
@@ -128,4 +166,63 @@ void PointPainter::Render(const QMatrix4x4& pmv_matrix,
 #endif
 }
 
+bool PointPainter::UploadChanges(const std::vector<PointPainter::Data>& data) {
+  // Rebuild the octree instead, if many points moved, since the points would
+  // then be poorly distributed over its nodes.
+  const size_t max_num_moved_points = data.size() / 10;
+  // Ranges of changed points closer than this are written together.
+  constexpr size_t kMinGapBetweenRanges = 1024;
+
+  const std::vector<uint32_t>& order = octree_.Order();
+  std::vector<std::pair<size_t, size_t>> changed_ranges;
+  size_t num_moved_points = 0;
+  for (size_t i = 0; i < data_.size(); ++i) {
+    const PointPainter::Data& point = data[order[i]];
+    PointPainter::Data& prev_point = data_[i];
+    const bool moved = point.x != prev_point.x || point.y != prev_point.y ||
+                       point.z != prev_point.z;
+    if (!moved && point.r == prev_point.r && point.g == prev_point.g &&
+        point.b == prev_point.b && point.a == prev_point.a) {
+      continue;
+    }
+    if (moved && ++num_moved_points > max_num_moved_points) {
+      return false;
+    }
+    prev_point = point;
+    if (!changed_ranges.empty() &&
+        i - changed_ranges.back().second < kMinGapBetweenRanges) {
+      changed_ranges.back().second = i + 1;
+    } else {
+      changed_ranges.emplace_back(i, i + 1);
+    }
+  }
+
+  if (changed_ranges.empty()) {
+    return true;
+  }
+
+  vbo_.bind();
+  for (const auto& [begin, end] : changed_ranges) {
+    vbo_.write(static_cast<int>(begin * sizeof(PointPainter::Data)),
+               data_.data() + begin,
+               static_cast<int>((end - begin) * sizeof(PointPainter::Data)));
+  }
+  vbo_.release();
+
+  if (num_moved_points > 0) {
+    std::vector<Eigen::Vector3f> ordered_positions(data_.size());
+    for (size_t i = 0; i < data_.size(); ++i) {
+      ordered_positions[i] =
+          Eigen::Vector3f(data_[i].x, data_[i].y, data_[i].z);
+    }
+    octree_.UpdateBounds(ordered_positions);
+  }
+
+#if DEBUG
+  glDebugLog();
+#endif
+
+  return true;
+}
+
 }  // namespace colmap
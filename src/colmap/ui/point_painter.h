@@ -29,9 +29,12 @@
 
 #pragma once
 
+#include "colmap/ui/point_octree.h"
+
 #include <QtCore>
 #include <QtOpenGL>
 #include <cstdint>
+#include <limits>
 
 namespace colmap {
 
@@ -50,15 +53,34 @@ class PointPainter {
   };
 
   void Setup();
+
+  // Uploads the points in the order of a level-of-detail octree. If the same
+  // number of points as in the previous upload is given and few of them
+  // moved, only the changed points are written to the existing buffer.
   void Upload(const std::vector<PointPainter::Data>& data);
-  void Render(const QMatrix4x4& pmv_matrix, float point_size);
+
+  // Renders the points inside the view frustum, where distant parts of the
+  // scene are rendered with fewer points, such that the spacing of the points
+  // is roughly the point size and at most the given number of points is
+  // rendered.
+  void Render(const QMatrix4x4& pmv_matrix,
+              int width,
+              int height,
+              float point_size,
+              size_t max_num_points = std::numeric_limits<size_t>::max());
 
  private:
+  bool UploadChanges(const std::vector<PointPainter::Data>& data);
+
   QOpenGLShaderProgram shader_program_;
   QOpenGLVertexArrayObject vao_;
   QOpenGLBuffer vbo_;
 
   size_t num_geoms_;
+
+  // Copy of the uploaded points in octree order to detect changes.
+  std::vector<PointPainter::Data> data_;
+  PointOctree octree_;
 };
 
 }  // namespace colmap
@@ -101,6 +101,11 @@ class IncrementalMapperRegistrationOptionsWidget : public OptionsWidget {
                   "structure_less_registration_fallback");
     AddOptionBool(&options->mapper->structure_less_registration_only,
                   "structure_less_registration_only");
+    AddOptionBool(&options->mapper->structure_less_registration_first,
+                  "structure_less_registration_first");
+    AddOptionInt(&options->mapper->structure_less_batch_size,
+                 "structure_less_batch_size",
+                 1);
   }
 };
 
@@ -248,7 +253,7 @@ class IncrementalMapperPriorsOptionsWidget : public OptionsWidget {
 };
 
 // Hierarchical-specific options. The per-cluster reconstruction itself is
-// configured through the shared incremental mapper options.
+// configured through the shared incremental or global mapper options.
 class HierarchicalMapperOptionsWidget : public OptionsWidget {
  public:
   HierarchicalMapperOptionsWidget(QWidget* parent, OptionManager* options)
@@ -257,6 +262,7 @@ class HierarchicalMapperOptionsWidget : public OptionsWidget {
     AddOptionInt(&hierarchical.num_threads, "num_threads", -1);
     AddOptionInt(&hierarchical.num_workers, "num_workers", -1);
     AddOptionInt(&hierarchical.init_num_trials, "init_num_trials");
+    AddOptionBool(&hierarchical.use_global_mapper, "use_global_mapper");
 
     AddSpacer();
 
@@ -270,6 +276,11 @@ class HierarchicalMapperOptionsWidget : public OptionsWidget {
                  "num_image_matches");
     AddOptionInt(&hierarchical.clustering_options.leaf_max_num_images,
                  "leaf_max_num_images");
+    AddOptionBool(&hierarchical.clustering_options.balanced_leaves,
+                  "balanced_leaves");
+    AddOptionDouble(&hierarchical.clustering_options.max_imbalance,
+                    "max_imbalance",
+                    1.0);
   }
 };
 
@@ -282,10 +293,14 @@ class GlobalMapperGeneralOptionsWidget : public OptionsWidget {
                   "ignore_watermarks");
     AddOptionInt(&options->global_mapper->num_threads, "num_threads", -1);
     AddOptionInt(&options->global_mapper->random_seed, "random_seed", -1);
+    AddOptionBool(&options->global_mapper->mapper.deterministic,
+                  "deterministic");
     AddOptionBool(&options->global_mapper->decompose_relative_pose,
                   "decompose_relative_pose");
     AddOptionBool(&options->global_mapper->mapper.refine_sensor_from_rig,
                   "refine_sensor_from_rig");
+    AddOptionIntUnlimited(&options->global_mapper->mapper.max_pose_graph_degree,
+                          "max_pose_graph_degree");
     AddOptionInt(&options->global_mapper->mapper.ba_num_iterations,
                  "ba_num_iterations");
     AddOptionDouble(
@@ -315,6 +330,8 @@ class GlobalMapperGeneralOptionsWidget : public OptionsWidget {
                   "skip_bundle_adjustment");
     AddOptionBool(&options->global_mapper->mapper.skip_retriangulation,
                   "skip_retriangulation");
+    AddOptionBool(&options->global_mapper->mapper.extend_reconstruction,
+                  "extend_reconstruction");
   }
 };
 
@@ -351,6 +368,9 @@ class GlobalMapperRotationAveragingOptionsWidget : public OptionsWidget {
     AddOptionDouble(&options->global_mapper->mapper.rotation_averaging
                          .max_rotation_error_deg,
                     "max_rotation_error [deg]");
+    AddOptionDouble(
+        &options->global_mapper->mapper.rotation_averaging.max_cycle_error_deg,
+        "max_cycle_error [deg]");
   }
 };
 
@@ -104,6 +104,10 @@ RenderOptionsWidget::RenderOptionsWidget(QWidget* parent,
 
   AddOptionDouble(&options->render->max_error, "Point max. error [px]");
   AddOptionInt(&options->render->min_track_len, "Point min. track length", 0);
+  AddOptionInt(&options->render->max_num_points,
+               "Point max. number",
+               1,
+               static_cast<int>(2e9));
 
   AddSpacer();
 
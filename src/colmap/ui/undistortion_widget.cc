@@ -58,6 +58,8 @@ UndistortionWidget::UndistortionWidget(QWidget* parent,
   AddOptionDouble(&camera_options_.roi_min_y, "roi_min_y", 0.0, 1.0);
   AddOptionDouble(&camera_options_.roi_max_x, "roi_max_x", 0.0, 1.0);
   AddOptionDouble(&camera_options_.roi_max_y, "roi_max_y", 0.0, 1.0);
+  AddOptionDouble(
+      &camera_options_.warp_map_max_error, "warp_map_max_error", -1);
   AddOptionInt(&colmap_options_.jpeg_quality, "jpeg_quality", -1);
   AddOptionInt(&num_threads_, "num_threads", -1);
   AddOptionDirPath(&output_path_, "output_path");
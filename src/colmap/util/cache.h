@@ -29,14 +29,22 @@
 
 #pragma once
 
+#include "colmap/util/file.h"
 #include "colmap/util/logging.h"
 
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
 #include <functional>
 #include <future>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace colmap {
 
@@ -104,6 +112,11 @@ class ThreadSafeLRUCache {
   // Get the value of an element either from the cache or compute the new value.
   std::shared_ptr<value_t> Get(const key_t& key);
 
+  // Manually insert an already computed value, e.g., from a batched load.
+  // Returns false and leaves the cache unchanged if the element is already
+  // cached or currently being loaded.
+  bool Insert(const key_t& key, std::shared_ptr<value_t> value);
+
   // Manually evict an element from the cache.
   // Returns true if the element was evicted.
   bool Evict(const key_t& key);
@@ -138,8 +151,16 @@ class MemoryConstrainedLRUCache {
  public:
   using LoadFn = std::function<std::shared_ptr<value_t>(const key_t&)>;
 
+  using EvictFn =
+      std::function<void(const key_t&, const std::shared_ptr<value_t>&)>;
+
   MemoryConstrainedLRUCache(size_t max_num_bytes, LoadFn load_fn);
 
+  // Set a function that is called for every element that is popped from the
+  // cache, e.g., to spill it into a FileSpillCache. It is not called for
+  // manually evicted or cleared elements.
+  void SetEvictFn(EvictFn evict_fn);
+
   // The size in bytes of the elements in the cache.
   size_t NumBytes() const;
   size_t MaxNumBytes() const;
@@ -149,6 +170,10 @@ class MemoryConstrainedLRUCache {
   size_t NumElems() const;
   size_t MaxNumElems() const;
 
+  // The number of gets that found the element in the cache or had to load it.
+  size_t NumHits() const;
+  size_t NumMisses() const;
+
   // Check whether the element with the given key exists.
   bool Exists(const key_t& key) const;
 
@@ -171,6 +196,8 @@ class MemoryConstrainedLRUCache {
 
   const size_t max_num_bytes_;
   size_t num_bytes_;
+  size_t num_hits_ = 0;
+  size_t num_misses_ = 0;
 
   // List to keep track of the least-recently-used elements.
   std::list<key_value_pair_t> elems_list_;
@@ -180,6 +207,203 @@ class MemoryConstrainedLRUCache {
 
   // Function to compute new values if not in the cache.
   const LoadFn load_fn_;
+
+  // Optional function that is called for popped elements.
+  EvictFn evict_fn_;
+};
+
+// Thread-safe Least Recently Used cache implementation that is constrained by a
+// maximum memory limitation of its elements. The elements are distributed over
+// independently locked shards by the hash of their key, such that concurrent
+// accesses of different elements rarely contend for the same lock. Each shard
+// deletes its least recently used elements once it exceeds its share of the
+// memory limit, but always keeps at least one element. As in
+// ThreadSafeLRUCache, concurrent gets of a missing element only load it once.
+// The size of an element is given by the num_bytes_fn, which by default calls
+// the `size_t NumBytes()` method of the element.
+template <typename key_t, typename value_t>
+class ThreadSafeMemoryConstrainedLRUCache {
+ public:
+  using LoadFn = std::function<std::shared_ptr<value_t>(const key_t&)>;
+  using NumBytesFn = std::function<size_t(const value_t&)>;
+  using EvictFn =
+      std::function<void(const key_t&, const std::shared_ptr<value_t>&)>;
+
+  ThreadSafeMemoryConstrainedLRUCache(
+      size_t max_num_bytes,
+      LoadFn load_fn,
+      NumBytesFn num_bytes_fn =
+          [](const value_t& value) -> size_t { return value.NumBytes(); },
+      size_t num_shards = 16);
+
+  // Set a function that is called for every loaded element that is deleted to
+  // fit the memory limit, e.g., to spill it into a FileSpillCache. It is called
+  // outside of the locks by the thread whose get or insert deleted the element
+  // and must be set before the cache is used. It is not called for manually
+  // evicted or cleared elements.
+  void SetEvictFn(EvictFn evict_fn);
+
+  // The size in bytes of the loaded elements in the cache.
+  size_t NumBytes() const;
+  size_t MaxNumBytes() const;
+
+  // The number of elements in the cache.
+  size_t NumElems() const;
+
+  // The number of gets that found the element in the cache or had to load it.
+  // Concurrent gets of a missing element count as one miss.
+  size_t NumHits() const;
+  size_t NumMisses() const;
+
+  size_t NumShards() const;
+
+  // Check whether the element with the given key exists.
+  bool Exists(const key_t& key) const;
+
+  // Get the value of an element either from the cache or compute the new value.
+  std::shared_ptr<value_t> Get(const key_t& key);
+
+  // Manually insert an already computed value, e.g., from a batched load.
+  // Returns false and leaves the cache unchanged if the element is already
+  // cached or currently being loaded.
+  bool Insert(const key_t& key, std::shared_ptr<value_t> value);
+
+  // Manually evict an element from the cache.
+  // Returns true if the element was evicted.
+  bool Evict(const key_t& key);
+
+  // Clear all elements from cache.
+  void Clear();
+
+ private:
+  struct Entry {
+    Entry() : future(promise.get_future()) {}
+    std::promise<std::shared_ptr<value_t>> promise;
+    std::shared_future<std::shared_ptr<value_t>> future;
+    // Zero until the value is loaded.
+    size_t num_bytes = 0;
+    bool is_loaded = false;
+  };
+
+  using key_entry_pair_t = typename std::pair<key_t, std::shared_ptr<Entry>>;
+  using list_iterator_t = typename std::list<key_entry_pair_t>::iterator;
+
+  struct Shard {
+    mutable std::mutex mutex;
+    size_t num_bytes = 0;
+    // List to keep track of the least-recently-used elements.
+    std::list<key_entry_pair_t> elems_list;
+    // Mapping from key to location in the list.
+    std::unordered_map<key_t, list_iterator_t> elems_map;
+  };
+
+  Shard& GetShard(const key_t& key);
+  const Shard& GetShard(const key_t& key) const;
+
+  // Adds the size of a loaded entry, if it was not evicted in the meantime, and
+  // deletes the least recently used elements of the shard until the shard fits
+  // into its share of the memory limit. Must be called with the shard lock.
+  void AddNumBytes(Shard& shard,
+                   const key_t& key,
+                   const std::shared_ptr<Entry>& entry,
+                   size_t num_bytes,
+                   std::vector<key_entry_pair_t>* deleted_elems);
+
+  // Calls the evict function for the deleted elements that were loaded. Must be
+  // called without the shard lock.
+  void NotifyEvicted(const std::vector<key_entry_pair_t>& deleted_elems) const;
+
+  const size_t max_num_bytes_;
+  const size_t max_num_bytes_per_shard_;
+
+  // Function to compute new values if not in the cache.
+  const LoadFn load_fn_;
+
+  // Function to compute the size of a value in bytes.
+  const NumBytesFn num_bytes_fn_;
+
+  // Optional function that is called for deleted elements.
+  EvictFn evict_fn_;
+
+  std::atomic<size_t> num_hits_;
+  std::atomic<size_t> num_misses_;
+
+  std::vector<Shard> shards_;
+};
+
+// Thread-safe file cache that serves as a second tier behind an in-memory
+// cache, e.g., on a local SSD in front of slow network storage. Elements that
+// are evicted from the in-memory cache are put into this cache and served from
+// it on later misses before loading them from their origin. Each value is
+// serialized into a separate file in the cache directory using the given write
+// and read functions. The files are deleted in least recently used order when
+// the maximum number of bytes is exceeded and when the cache is destroyed. The
+// cache directory should not be shared with other caches.
+template <typename key_t, typename value_t>
+class FileSpillCache {
+ public:
+  using WriteFn = std::function<void(const value_t&, std::ostream*)>;
+  using ReadFn = std::function<std::shared_ptr<value_t>(std::istream*)>;
+
+  FileSpillCache(std::filesystem::path cache_path,
+                 size_t max_num_bytes,
+                 WriteFn write_fn,
+                 ReadFn read_fn);
+  ~FileSpillCache();
+
+  // The size in bytes of the files in the cache.
+  size_t NumBytes() const;
+  size_t MaxNumBytes() const;
+
+  // The number of elements in the cache.
+  size_t NumElems() const;
+
+  // Check whether the element with the given key exists.
+  bool Exists(const key_t& key) const;
+
+  // Write the value of an element into the cache, unless it already exists.
+  // Values larger than the cache are discarded.
+  void Put(const key_t& key, const value_t& value);
+
+  // Read the value of an element from the cache. Returns null if the element
+  // does not exist.
+  std::shared_ptr<value_t> Get(const key_t& key);
+
+  // Manually evict an element from the cache.
+  // Returns true if the element was evicted.
+  bool Evict(const key_t& key);
+
+  // Clear all elements from cache.
+  void Clear();
+
+ private:
+  using list_iterator_t = typename std::list<key_t>::iterator;
+
+  struct Elem {
+    size_t file_idx;
+    size_t num_bytes;
+    list_iterator_t list_it;
+  };
+
+  std::filesystem::path GetFilePath(size_t file_idx) const;
+
+  // Delete the file of the element. Must be called with the lock.
+  void DeleteElem(typename std::unordered_map<key_t, Elem>::iterator it);
+
+  const std::filesystem::path cache_path_;
+  const size_t max_num_bytes_;
+  const WriteFn write_fn_;
+  const ReadFn read_fn_;
+
+  mutable std::mutex mutex_;
+  size_t num_bytes_ = 0;
+  size_t next_file_idx_ = 0;
+
+  // List to keep track of the least-recently-used elements.
+  std::list<key_t> elems_list_;
+
+  // Mapping from key to the file and location in the list.
+  std::unordered_map<key_t, Elem> elems_map_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -315,6 +539,20 @@ std::shared_ptr<value_t> ThreadSafeLRUCache<key_t, value_t>::Get(
   return shared_future.get();
 }
 
+template <typename key_t, typename value_t>
+bool ThreadSafeLRUCache<key_t, value_t>::Insert(
+    const key_t& key, std::shared_ptr<value_t> value) {
+  THROW_CHECK_NOTNULL(value);
+  std::unique_lock lock(cache_mutex_);
+  if (cache_.Exists(key)) {
+    return false;
+  }
+  std::shared_ptr<Entry> entry = cache_.Get(key);
+  entry->is_loading = true;
+  entry->promise.set_value(std::move(value));
+  return true;
+}
+
 template <typename key_t, typename value_t>
 bool ThreadSafeLRUCache<key_t, value_t>::Evict(const key_t& key) {
   std::unique_lock lock(cache_mutex_);
@@ -343,11 +581,26 @@ MemoryConstrainedLRUCache<key_t, value_t>::MemoryConstrainedLRUCache(
   THROW_CHECK_GT(max_num_bytes, 0);
 }
 
+template <typename key_t, typename value_t>
+void MemoryConstrainedLRUCache<key_t, value_t>::SetEvictFn(EvictFn evict_fn) {
+  evict_fn_ = std::move(evict_fn);
+}
+
 template <typename key_t, typename value_t>
 size_t MemoryConstrainedLRUCache<key_t, value_t>::NumElems() const {
   return elems_map_.size();
 }
 
+template <typename key_t, typename value_t>
+size_t MemoryConstrainedLRUCache<key_t, value_t>::NumHits() const {
+  return num_hits_;
+}
+
+template <typename key_t, typename value_t>
+size_t MemoryConstrainedLRUCache<key_t, value_t>::NumMisses() const {
+  return num_misses_;
+}
+
 template <typename key_t, typename value_t>
 size_t MemoryConstrainedLRUCache<key_t, value_t>::NumBytes() const {
   return num_bytes_;
@@ -368,6 +621,7 @@ std::shared_ptr<value_t> MemoryConstrainedLRUCache<key_t, value_t>::Get(
     const key_t& key) {
   const auto it = elems_map_.find(key);
   if (it == elems_map_.end()) {
+    ++num_misses_;
     std::shared_ptr<value_t> value = load_fn_(key);
     const size_t num_bytes = value->NumBytes();
     auto it = elems_map_.find(key);
@@ -386,6 +640,7 @@ std::shared_ptr<value_t> MemoryConstrainedLRUCache<key_t, value_t>::Get(
 
     return it->second.first->second;
   } else {
+    ++num_hits_;
     elems_list_.splice(elems_list_.begin(), elems_list_, it->second.first);
     return it->second.first->second;
   }
@@ -412,8 +667,12 @@ void MemoryConstrainedLRUCache<key_t, value_t>::Pop() {
     THROW_CHECK_GE(num_bytes_, it->second.second)
         << "Unsigned underflow in MemoryConstrainedLRUCache::Pop";
     num_bytes_ -= it->second.second;
+    key_value_pair_t elem = std::move(*last);
     elems_map_.erase(it);
     elems_list_.pop_back();
+    if (evict_fn_) {
+      evict_fn_(elem.first, elem.second);
+    }
   }
 }
 
@@ -439,4 +698,384 @@ void MemoryConstrainedLRUCache<key_t, value_t>::Clear() {
   num_bytes_ = 0;
 }
 
+template <typename key_t, typename value_t>
+ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::
+    ThreadSafeMemoryConstrainedLRUCache(const size_t max_num_bytes,
+                                        LoadFn load_fn,
+                                        NumBytesFn num_bytes_fn,
+                                        const size_t num_shards)
+    : max_num_bytes_(max_num_bytes),
+      max_num_bytes_per_shard_((max_num_bytes + num_shards - 1) /
+                               std::max<size_t>(num_shards, 1)),
+      load_fn_(std::move(load_fn)),
+      num_bytes_fn_(std::move(num_bytes_fn)),
+      num_hits_(0),
+      num_misses_(0),
+      shards_(num_shards) {
+  THROW_CHECK_NOTNULL(load_fn_);
+  THROW_CHECK_NOTNULL(num_bytes_fn_);
+  THROW_CHECK_GT(max_num_bytes, 0);
+  THROW_CHECK_GT(num_shards, 0);
+}
+
+template <typename key_t, typename value_t>
+void ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::SetEvictFn(
+    EvictFn evict_fn) {
+  evict_fn_ = std::move(evict_fn);
+}
+
+template <typename key_t, typename value_t>
+size_t ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::NumBytes() const {
+  size_t num_bytes = 0;
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    num_bytes += shard.num_bytes;
+  }
+  return num_bytes;
+}
+
+template <typename key_t, typename value_t>
+size_t ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::MaxNumBytes()
+    const {
+  return max_num_bytes_;
+}
+
+template <typename key_t, typename value_t>
+size_t ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::NumElems() const {
+  size_t num_elems = 0;
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    num_elems += shard.elems_map.size();
+  }
+  return num_elems;
+}
+
+template <typename key_t, typename value_t>
+size_t ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::NumHits() const {
+  return num_hits_.load(std::memory_order_relaxed);
+}
+
+template <typename key_t, typename value_t>
+size_t ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::NumMisses() const {
+  return num_misses_.load(std::memory_order_relaxed);
+}
+
+template <typename key_t, typename value_t>
+size_t ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::NumShards() const {
+  return shards_.size();
+}
+
+template <typename key_t, typename value_t>
+bool ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::Exists(
+    const key_t& key) const {
+  const Shard& shard = GetShard(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  return shard.elems_map.find(key) != shard.elems_map.end();
+}
+
+template <typename key_t, typename value_t>
+std::shared_ptr<value_t> ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::
+    Get(const key_t& key) {
+  Shard& shard = GetShard(key);
+
+  bool should_load = false;
+  std::shared_ptr<Entry> entry;
+
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.elems_map.find(key);
+    if (it == shard.elems_map.end()) {
+      should_load = true;
+      entry = std::make_shared<Entry>();
+      shard.elems_list.emplace_front(key, entry);
+      shard.elems_map.emplace(key, shard.elems_list.begin());
+    } else {
+      shard.elems_list.splice(
+          shard.elems_list.begin(), shard.elems_list, it->second);
+      entry = it->second->second;
+    }
+  }
+
+  if (should_load) {
+    num_misses_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    num_hits_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (should_load) {
+    std::shared_ptr<value_t> value;
+    size_t num_bytes = 0;
+    try {
+      value = THROW_CHECK_NOTNULL(load_fn_(key));
+      num_bytes = num_bytes_fn_(*value);
+    } catch (...) {
+      // Evict the cache entry after load failed and set the exception.
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto it = shard.elems_map.find(key);
+        if (it != shard.elems_map.end() && it->second->second == entry) {
+          shard.elems_list.erase(it->second);
+          shard.elems_map.erase(it);
+        }
+      }
+      entry->promise.set_exception(std::current_exception());
+      return entry->future.get();
+    }
+
+    entry->promise.set_value(std::move(value));
+    std::vector<key_entry_pair_t> deleted_elems;
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      AddNumBytes(shard, key, entry, num_bytes, &deleted_elems);
+    }
+    NotifyEvicted(deleted_elems);
+  }
+
+  return entry->future.get();
+}
+
+template <typename key_t, typename value_t>
+bool ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::Insert(
+    const key_t& key, std::shared_ptr<value_t> value) {
+  THROW_CHECK_NOTNULL(value);
+  const size_t num_bytes = num_bytes_fn_(*value);
+  Shard& shard = GetShard(key);
+  std::vector<key_entry_pair_t> deleted_elems;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.elems_map.find(key) != shard.elems_map.end()) {
+      return false;
+    }
+    auto entry = std::make_shared<Entry>();
+    entry->promise.set_value(std::move(value));
+    shard.elems_list.emplace_front(key, entry);
+    shard.elems_map.emplace(key, shard.elems_list.begin());
+    AddNumBytes(shard, key, entry, num_bytes, &deleted_elems);
+  }
+  NotifyEvicted(deleted_elems);
+  return true;
+}
+
+template <typename key_t, typename value_t>
+bool ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::Evict(
+    const key_t& key) {
+  Shard& shard = GetShard(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  const auto it = shard.elems_map.find(key);
+  if (it != shard.elems_map.end()) {
+    shard.num_bytes -= it->second->second->num_bytes;
+    shard.elems_list.erase(it->second);
+    shard.elems_map.erase(it);
+    return true;
+  }
+  return false;
+}
+
+template <typename key_t, typename value_t>
+void ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::Clear() {
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.elems_list.clear();
+    shard.elems_map.clear();
+    shard.num_bytes = 0;
+  }
+}
+
+template <typename key_t, typename value_t>
+typename ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::Shard&
+ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::GetShard(
+    const key_t& key) {
+  return shards_[std::hash<key_t>{}(key) % shards_.size()];
+}
+
+template <typename key_t, typename value_t>
+const typename ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::Shard&
+ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::GetShard(
+    const key_t& key) const {
+  return shards_[std::hash<key_t>{}(key) % shards_.size()];
+}
+
+template <typename key_t, typename value_t>
+void ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::AddNumBytes(
+    Shard& shard,
+    const key_t& key,
+    const std::shared_ptr<Entry>& entry,
+    const size_t num_bytes,
+    std::vector<key_entry_pair_t>* deleted_elems) {
+  const auto it = shard.elems_map.find(key);
+  if (it == shard.elems_map.end() || it->second->second != entry) {
+    return;
+  }
+
+  entry->num_bytes = num_bytes;
+  entry->is_loaded = true;
+  shard.num_bytes += num_bytes;
+
+  while (shard.num_bytes > max_num_bytes_per_shard_ &&
+         shard.elems_map.size() > 1) {
+    const key_entry_pair_t& last = shard.elems_list.back();
+    THROW_CHECK_GE(shard.num_bytes, last.second->num_bytes)
+        << "Unsigned underflow in ThreadSafeMemoryConstrainedLRUCache";
+    shard.num_bytes -= last.second->num_bytes;
+    shard.elems_map.erase(last.first);
+    deleted_elems->push_back(std::move(shard.elems_list.back()));
+    shard.elems_list.pop_back();
+  }
+}
+
+template <typename key_t, typename value_t>
+void ThreadSafeMemoryConstrainedLRUCache<key_t, value_t>::NotifyEvicted(
+    const std::vector<key_entry_pair_t>& deleted_elems) const {
+  if (!evict_fn_) {
+    return;
+  }
+  for (const auto& [key, entry] : deleted_elems) {
+    // Skip the entries that are still being loaded.
+    if (entry->is_loaded) {
+      evict_fn_(key, entry->future.get());
+    }
+  }
+}
+
+template <typename key_t, typename value_t>
+FileSpillCache<key_t, value_t>::FileSpillCache(
+    std::filesystem::path cache_path,
+    const size_t max_num_bytes,
+    WriteFn write_fn,
+    ReadFn read_fn)
+    : cache_path_(std::move(cache_path)),
+      max_num_bytes_(max_num_bytes),
+      write_fn_(std::move(write_fn)),
+      read_fn_(std::move(read_fn)) {
+  THROW_CHECK_NOTNULL(write_fn_);
+  THROW_CHECK_NOTNULL(read_fn_);
+  THROW_CHECK_GT(max_num_bytes, 0);
+  std::filesystem::create_directories(cache_path_);
+}
+
+template <typename key_t, typename value_t>
+FileSpillCache<key_t, value_t>::~FileSpillCache() {
+  Clear();
+  // Only removes the directory if it is empty.
+  std::error_code error_code;
+  std::filesystem::remove(cache_path_, error_code);
+}
+
+template <typename key_t, typename value_t>
+size_t FileSpillCache<key_t, value_t>::NumBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_bytes_;
+}
+
+template <typename key_t, typename value_t>
+size_t FileSpillCache<key_t, value_t>::MaxNumBytes() const {
+  return max_num_bytes_;
+}
+
+template <typename key_t, typename value_t>
+size_t FileSpillCache<key_t, value_t>::NumElems() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return elems_map_.size();
+}
+
+template <typename key_t, typename value_t>
+bool FileSpillCache<key_t, value_t>::Exists(const key_t& key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return elems_map_.find(key) != elems_map_.end();
+}
+
+template <typename key_t, typename value_t>
+void FileSpillCache<key_t, value_t>::Put(const key_t& key,
+                                         const value_t& value) {
+  size_t file_idx;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (elems_map_.find(key) != elems_map_.end()) {
+      return;
+    }
+    file_idx = next_file_idx_++;
+  }
+
+  // Write the file without the lock, so that concurrent reads are not blocked.
+  const std::filesystem::path path = GetFilePath(file_idx);
+  size_t num_bytes;
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    THROW_CHECK_FILE_OPEN(file, path);
+    write_fn_(value, &file);
+    num_bytes = file.tellp();
+    THROW_CHECK(file.good()) << "Failed to write spill file " << path;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (num_bytes > max_num_bytes_ || elems_map_.find(key) != elems_map_.end()) {
+    std::filesystem::remove(path);
+    return;
+  }
+
+  elems_list_.push_front(key);
+  elems_map_.emplace(key, Elem{file_idx, num_bytes, elems_list_.begin()});
+  num_bytes_ += num_bytes;
+  while (num_bytes_ > max_num_bytes_) {
+    DeleteElem(elems_map_.find(elems_list_.back()));
+  }
+}
+
+template <typename key_t, typename value_t>
+std::shared_ptr<value_t> FileSpillCache<key_t, value_t>::Get(
+    const key_t& key) {
+  std::filesystem::path path;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = elems_map_.find(key);
+    if (it == elems_map_.end()) {
+      return nullptr;
+    }
+    elems_list_.splice(elems_list_.begin(), elems_list_, it->second.list_it);
+    path = GetFilePath(it->second.file_idx);
+  }
+
+  // The file may have been deleted concurrently, which is treated as a miss.
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return nullptr;
+  }
+  return read_fn_(&file);
+}
+
+template <typename key_t, typename value_t>
+bool FileSpillCache<key_t, value_t>::Evict(const key_t& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = elems_map_.find(key);
+  if (it == elems_map_.end()) {
+    return false;
+  }
+  DeleteElem(it);
+  return true;
+}
+
+template <typename key_t, typename value_t>
+void FileSpillCache<key_t, value_t>::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (!elems_map_.empty()) {
+    DeleteElem(elems_map_.begin());
+  }
+}
+
+template <typename key_t, typename value_t>
+std::filesystem::path FileSpillCache<key_t, value_t>::GetFilePath(
+    const size_t file_idx) const {
+  return cache_path_ / (std::to_string(file_idx) + ".bin");
+}
+
+template <typename key_t, typename value_t>
+void FileSpillCache<key_t, value_t>::DeleteElem(
+    const typename std::unordered_map<key_t, Elem>::iterator it) {
+  std::error_code error_code;
+  std::filesystem::remove(GetFilePath(it->second.file_idx), error_code);
+  num_bytes_ -= it->second.num_bytes;
+  elems_list_.erase(it->second.list_it);
+  elems_map_.erase(it);
+}
+
 }  // namespace colmap
@@ -29,6 +29,13 @@
 
 #include "colmap/util/cache.h"
 
+#include "colmap/util/testing.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -150,6 +157,8 @@ TEST(MemoryConstrainedLRUCache, Empty) {
   EXPECT_EQ(cache.NumElems(), 0);
   EXPECT_EQ(cache.NumBytes(), 0);
   EXPECT_EQ(cache.MaxNumBytes(), 5);
+  EXPECT_EQ(cache.NumHits(), 0);
+  EXPECT_EQ(cache.NumMisses(), 0);
 }
 
 TEST(MemoryConstrainedLRUCache, Get) {
@@ -187,6 +196,9 @@ TEST(MemoryConstrainedLRUCache, Get) {
   EXPECT_FALSE(cache.Exists(0));
   EXPECT_TRUE(cache.Exists(1));
   EXPECT_TRUE(cache.Exists(6));
+
+  EXPECT_EQ(cache.NumHits(), 1);
+  EXPECT_EQ(cache.NumMisses(), 8);
 }
 
 TEST(MemoryConstrainedLRUCache, Pop) {
@@ -330,6 +342,34 @@ TEST(ThreadSafeLRUCache, Get) {
   EXPECT_TRUE(cache.Exists(6));
 }
 
+TEST(ThreadSafeLRUCache, Insert) {
+  int num_loads = 0;
+  ThreadSafeLRUCache<int, int> cache(5, [&num_loads](const int key) {
+    ++num_loads;
+    return std::make_shared<int>(key);
+  });
+  EXPECT_TRUE(cache.Insert(0, std::make_shared<int>(42)));
+  EXPECT_TRUE(cache.Exists(0));
+  EXPECT_EQ(cache.NumElems(), 1);
+  EXPECT_EQ(*cache.Get(0), 42);
+  EXPECT_EQ(num_loads, 0);
+
+  EXPECT_FALSE(cache.Insert(0, std::make_shared<int>(43)));
+  EXPECT_EQ(*cache.Get(0), 42);
+
+  EXPECT_EQ(*cache.Get(1), 1);
+  EXPECT_EQ(num_loads, 1);
+  EXPECT_FALSE(cache.Insert(1, std::make_shared<int>(43)));
+  EXPECT_EQ(*cache.Get(1), 1);
+
+  for (int i = 2; i < 7; ++i) {
+    EXPECT_TRUE(cache.Insert(i, std::make_shared<int>(i)));
+  }
+  EXPECT_EQ(cache.NumElems(), 5);
+  EXPECT_FALSE(cache.Exists(0));
+  EXPECT_FALSE(cache.Exists(1));
+}
+
 TEST(ThreadSafeLRUCache, ConcurrentGet) {
   std::mutex mutex;
   std::condition_variable cv;
@@ -529,5 +569,343 @@ TEST(MemoryConstrainedLRUCache, UpdateNumBytesConsistency) {
   EXPECT_EQ(cache.NumBytes(), 13);
 }
 
+TEST(ThreadSafeMemoryConstrainedLRUCache, Empty) {
+  ThreadSafeMemoryConstrainedLRUCache<int, SizedElem> cache(
+      5, [](const int key) { return std::make_shared<SizedElem>(key); });
+  EXPECT_EQ(cache.NumElems(), 0);
+  EXPECT_EQ(cache.NumBytes(), 0);
+  EXPECT_EQ(cache.MaxNumBytes(), 5);
+  EXPECT_EQ(cache.NumShards(), 16);
+  EXPECT_EQ(cache.NumHits(), 0);
+  EXPECT_EQ(cache.NumMisses(), 0);
+}
+
+TEST(ThreadSafeMemoryConstrainedLRUCache, Get) {
+  ThreadSafeMemoryConstrainedLRUCache<int, SizedElem> cache(
+      10,
+      [](const int key) { return std::make_shared<SizedElem>(key); },
+      [](const SizedElem& elem) { return elem.NumBytes(); },
+      /*num_shards=*/1);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(cache.Get(i)->NumBytes(), i);
+    EXPECT_EQ(cache.NumElems(), i + 1);
+    EXPECT_TRUE(cache.Exists(i));
+  }
+
+  EXPECT_EQ(cache.Get(5)->NumBytes(), 5);
+  EXPECT_EQ(cache.NumElems(), 2);
+  EXPECT_EQ(cache.NumBytes(), 9);
+  EXPECT_FALSE(cache.Exists(0));
+  EXPECT_TRUE(cache.Exists(4));
+  EXPECT_TRUE(cache.Exists(5));
+
+  EXPECT_EQ(cache.Get(6)->NumBytes(), 6);
+  EXPECT_EQ(cache.NumElems(), 1);
+  EXPECT_EQ(cache.NumBytes(), 6);
+  EXPECT_TRUE(cache.Exists(6));
+
+  // Elements larger than the limit are kept as the only element.
+  EXPECT_EQ(cache.Get(20)->NumBytes(), 20);
+  EXPECT_EQ(cache.NumElems(), 1);
+  EXPECT_EQ(cache.NumBytes(), 20);
+  EXPECT_TRUE(cache.Exists(20));
+}
+
+TEST(ThreadSafeMemoryConstrainedLRUCache, Shards) {
+  ThreadSafeMemoryConstrainedLRUCache<int, SizedElem> cache(
+      8,
+      [](const int) { return std::make_shared<SizedElem>(1); },
+      [](const SizedElem& elem) { return elem.NumBytes(); },
+      /*num_shards=*/4);
+  EXPECT_EQ(cache.NumShards(), 4);
+  for (int i = 0; i < 8; ++i) {
+    cache.Get(i);
+  }
+  EXPECT_EQ(cache.NumElems(), 8);
+  EXPECT_EQ(cache.NumBytes(), 8);
+
+  // Each shard only evicts its own least recently used elements.
+  cache.Get(0);
+  cache.Get(8);
+  EXPECT_EQ(cache.NumElems(), 8);
+  EXPECT_EQ(cache.NumBytes(), 8);
+  EXPECT_TRUE(cache.Exists(0));
+  EXPECT_FALSE(cache.Exists(4));
+  EXPECT_TRUE(cache.Exists(8));
+  for (int i = 1; i < 4; ++i) {
+    EXPECT_TRUE(cache.Exists(i));
+  }
+}
+
+TEST(ThreadSafeMemoryConstrainedLRUCache, Insert) {
+  int num_loads = 0;
+  ThreadSafeMemoryConstrainedLRUCache<int, SizedElem> cache(
+      10,
+      [&num_loads](const int key) {
+        ++num_loads;
+        return std::make_shared<SizedElem>(key);
+      },
+      [](const SizedElem& elem) { return elem.NumBytes(); },
+      /*num_shards=*/1);
+  EXPECT_TRUE(cache.Insert(0, std::make_shared<SizedElem>(3)));
+  EXPECT_TRUE(cache.Exists(0));
+  EXPECT_EQ(cache.NumBytes(), 3);
+  EXPECT_EQ(cache.Get(0)->NumBytes(), 3);
+  EXPECT_EQ(num_loads, 0);
+
+  EXPECT_FALSE(cache.Insert(0, std::make_shared<SizedElem>(4)));
+  EXPECT_EQ(cache.Get(0)->NumBytes(), 3);
+
+  EXPECT_TRUE(cache.Insert(1, std::make_shared<SizedElem>(8)));
+  EXPECT_EQ(cache.NumElems(), 1);
+  EXPECT_EQ(cache.NumBytes(), 8);
+  EXPECT_FALSE(cache.Exists(0));
+}
+
+TEST(ThreadSafeMemoryConstrainedLRUCache, ConcurrentGet) {
+  std::atomic<int> num_loads(0);
+  ThreadSafeMemoryConstrainedLRUCache<int, SizedElem> cache(
+      1000, [&num_loads](const int key) {
+        ++num_loads;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return std::make_shared<SizedElem>(key);
+      });
+
+  constexpr int kNumThreads = 8;
+  constexpr int kNumKeys = 32;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&cache] {
+      for (int key = 0; key < kNumKeys; ++key) {
+        EXPECT_EQ(cache.Get(key)->NumBytes(), key);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(num_loads, kNumKeys);
+  EXPECT_EQ(cache.NumElems(), kNumKeys);
+  EXPECT_EQ(cache.NumBytes(), kNumKeys * (kNumKeys - 1) / 2);
+  EXPECT_EQ(cache.NumHits(), (kNumThreads - 1) * kNumKeys);
+  EXPECT_EQ(cache.NumMisses(), kNumKeys);
+}
+
+TEST(ThreadSafeMemoryConstrainedLRUCache, Evict) {
+  ThreadSafeMemoryConstrainedLRUCache<int, SizedElem> cache(
+      10, [](const int key) { return std::make_shared<SizedElem>(key); });
+  for (int i = 0; i < 4; ++i) {
+    cache.Get(i);
+  }
+  EXPECT_EQ(cache.NumBytes(), 6);
+  EXPECT_TRUE(cache.Evict(3));
+  EXPECT_FALSE(cache.Evict(3));
+  EXPECT_FALSE(cache.Exists(3));
+  EXPECT_EQ(cache.NumElems(), 3);
+  EXPECT_EQ(cache.NumBytes(), 3);
+}
+
+TEST(ThreadSafeMemoryConstrainedLRUCache, Clear) {
+  ThreadSafeMemoryConstrainedLRUCache<int, SizedElem> cache(
+      10, [](const int key) { return std::make_shared<SizedElem>(key); });
+  for (int i = 0; i < 4; ++i) {
+    cache.Get(i);
+  }
+  cache.Clear();
+  EXPECT_EQ(cache.NumElems(), 0);
+  EXPECT_EQ(cache.NumBytes(), 0);
+  EXPECT_EQ(cache.Get(2)->NumBytes(), 2);
+  EXPECT_EQ(cache.NumBytes(), 2);
+}
+
+TEST(ThreadSafeMemoryConstrainedLRUCache, ExceptionSafety) {
+  int num_loads = 0;
+  ThreadSafeMemoryConstrainedLRUCache<int, SizedElem> cache(
+      10, [&num_loads](const int key) {
+        ++num_loads;
+        if (key == 3) {
+          throw std::runtime_error("load failed");
+        }
+        return std::make_shared<SizedElem>(key);
+      });
+  EXPECT_EQ(cache.Get(1)->NumBytes(), 1);
+  EXPECT_THROW(cache.Get(3), std::runtime_error);
+  EXPECT_FALSE(cache.Exists(3));
+  EXPECT_EQ(cache.NumElems(), 1);
+  EXPECT_EQ(cache.NumBytes(), 1);
+  EXPECT_THROW(cache.Get(3), std::runtime_error);
+  EXPECT_EQ(num_loads, 3);
+}
+
+TEST(MemoryConstrainedLRUCache, EvictFn) {
+  MemoryConstrainedLRUCache<int, SizedElem> cache(
+      10, [](const int key) { return std::make_shared<SizedElem>(key); });
+  std::vector<int> evicted_keys;
+  cache.SetEvictFn([&evicted_keys](const int key,
+                                   const std::shared_ptr<SizedElem>& value) {
+    EXPECT_EQ(value->NumBytes(), key);
+    evicted_keys.push_back(key);
+  });
+  for (int i = 0; i < 5; ++i) {
+    cache.Get(i);
+  }
+  EXPECT_TRUE(evicted_keys.empty());
+  cache.Get(5);
+  EXPECT_THAT(evicted_keys, testing::ElementsAre(0, 1, 2, 3));
+  cache.Evict(5);
+  cache.Clear();
+  EXPECT_THAT(evicted_keys, testing::ElementsAre(0, 1, 2, 3));
+}
+
+TEST(ThreadSafeMemoryConstrainedLRUCache, EvictFn) {
+  ThreadSafeMemoryConstrainedLRUCache<int, SizedElem> cache(
+      10,
+      [](const int key) { return std::make_shared<SizedElem>(key); },
+      [](const SizedElem& elem) { return elem.NumBytes(); },
+      /*num_shards=*/1);
+  std::vector<int> evicted_keys;
+  cache.SetEvictFn([&evicted_keys](const int key,
+                                   const std::shared_ptr<SizedElem>& value) {
+    EXPECT_EQ(value->NumBytes(), key);
+    evicted_keys.push_back(key);
+  });
+  for (int i = 0; i < 5; ++i) {
+    cache.Get(i);
+  }
+  EXPECT_TRUE(evicted_keys.empty());
+  cache.Get(5);
+  EXPECT_THAT(evicted_keys, testing::ElementsAre(0, 1, 2, 3));
+  EXPECT_TRUE(cache.Insert(1, std::make_shared<SizedElem>(1)));
+  EXPECT_THAT(evicted_keys, testing::ElementsAre(0, 1, 2, 3));
+  cache.Evict(5);
+  cache.Clear();
+  EXPECT_THAT(evicted_keys, testing::ElementsAre(0, 1, 2, 3));
+}
+
+FileSpillCache<int, std::vector<int>> CreateFileSpillCache(
+    const std::filesystem::path& cache_path, const size_t max_num_bytes) {
+  return FileSpillCache<int, std::vector<int>>(
+      cache_path,
+      max_num_bytes,
+      [](const std::vector<int>& value, std::ostream* stream) {
+        const uint64_t size = value.size();
+        stream->write(reinterpret_cast<const char*>(&size), sizeof(size));
+        stream->write(reinterpret_cast<const char*>(value.data()),
+                      size * sizeof(int));
+      },
+      [](std::istream* stream) {
+        uint64_t size = 0;
+        stream->read(reinterpret_cast<char*>(&size), sizeof(size));
+        auto value = std::make_shared<std::vector<int>>(size);
+        stream->read(reinterpret_cast<char*>(value->data()),
+                     size * sizeof(int));
+        return value;
+      });
+}
+
+TEST(FileSpillCache, PutGet) {
+  const std::filesystem::path cache_path = CreateTestDir() / "spill";
+  {
+    auto cache = CreateFileSpillCache(cache_path, 1000);
+    EXPECT_EQ(cache.NumElems(), 0);
+    EXPECT_EQ(cache.NumBytes(), 0);
+    EXPECT_EQ(cache.MaxNumBytes(), 1000);
+    EXPECT_EQ(cache.Get(0), nullptr);
+
+    cache.Put(0, std::vector<int>{1, 2, 3});
+    EXPECT_TRUE(cache.Exists(0));
+    EXPECT_EQ(cache.NumElems(), 1);
+    EXPECT_EQ(cache.NumBytes(), sizeof(uint64_t) + 3 * sizeof(int));
+    EXPECT_THAT(*cache.Get(0), testing::ElementsAre(1, 2, 3));
+
+    // Existing elements are not overwritten.
+    cache.Put(0, std::vector<int>{4});
+    EXPECT_THAT(*cache.Get(0), testing::ElementsAre(1, 2, 3));
+
+    cache.Put(1, std::vector<int>{});
+    EXPECT_EQ(cache.NumElems(), 2);
+    EXPECT_TRUE(cache.Get(1)->empty());
+  }
+  // The files and the directory are deleted with the cache.
+  EXPECT_FALSE(std::filesystem::exists(cache_path));
+}
+
+TEST(FileSpillCache, Pop) {
+  const std::filesystem::path cache_path = CreateTestDir() / "spill";
+  constexpr size_t kElemNumBytes = sizeof(uint64_t) + 2 * sizeof(int);
+  auto cache = CreateFileSpillCache(cache_path, 3 * kElemNumBytes);
+  for (int i = 0; i < 3; ++i) {
+    cache.Put(i, std::vector<int>{i, i});
+  }
+  EXPECT_EQ(cache.NumElems(), 3);
+  EXPECT_EQ(cache.NumBytes(), 3 * kElemNumBytes);
+
+  cache.Get(0);
+  cache.Put(3, std::vector<int>{3, 3});
+  EXPECT_EQ(cache.NumElems(), 3);
+  EXPECT_EQ(cache.NumBytes(), 3 * kElemNumBytes);
+  EXPECT_TRUE(cache.Exists(0));
+  EXPECT_FALSE(cache.Exists(1));
+  EXPECT_EQ(cache.Get(1), nullptr);
+  EXPECT_TRUE(cache.Exists(2));
+  EXPECT_TRUE(cache.Exists(3));
+
+  // Values larger than the cache are discarded.
+  cache.Put(4, std::vector<int>(100));
+  EXPECT_FALSE(cache.Exists(4));
+  EXPECT_EQ(cache.NumElems(), 3);
+}
+
+TEST(FileSpillCache, EvictClear) {
+  const std::filesystem::path cache_path = CreateTestDir() / "spill";
+  auto cache = CreateFileSpillCache(cache_path, 1000);
+  for (int i = 0; i < 3; ++i) {
+    cache.Put(i, std::vector<int>{i});
+  }
+  EXPECT_TRUE(cache.Evict(1));
+  EXPECT_FALSE(cache.Evict(1));
+  EXPECT_FALSE(cache.Exists(1));
+  EXPECT_EQ(cache.NumElems(), 2);
+  EXPECT_EQ(cache.NumBytes(), 2 * (sizeof(uint64_t) + sizeof(int)));
+
+  cache.Clear();
+  EXPECT_EQ(cache.NumElems(), 0);
+  EXPECT_EQ(cache.NumBytes(), 0);
+  EXPECT_TRUE(std::filesystem::is_empty(cache_path));
+}
+
+TEST(FileSpillCache, SecondTier) {
+  const std::filesystem::path cache_path = CreateTestDir() / "spill";
+  auto spill_cache = CreateFileSpillCache(cache_path, 1000);
+  int num_loads = 0;
+  ThreadSafeMemoryConstrainedLRUCache<int, std::vector<int>> cache(
+      2,
+      [&num_loads, &spill_cache](const int key) {
+        if (auto value = spill_cache.Get(key)) {
+          return value;
+        }
+        ++num_loads;
+        return std::make_shared<std::vector<int>>(1, key);
+      },
+      [](const std::vector<int>& value) { return value.size(); },
+      /*num_shards=*/1);
+  cache.SetEvictFn(
+      [&spill_cache](const int key,
+                     const std::shared_ptr<std::vector<int>>& value) {
+        spill_cache.Put(key, *value);
+      });
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_THAT(*cache.Get(i), testing::ElementsAre(i));
+  }
+  EXPECT_EQ(num_loads, 4);
+  EXPECT_EQ(spill_cache.NumElems(), 2);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_THAT(*cache.Get(i), testing::ElementsAre(i));
+  }
+  EXPECT_EQ(num_loads, 4);
+}
+
 }  // namespace
 }  // namespace colmap
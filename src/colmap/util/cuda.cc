@@ -31,9 +31,16 @@
 
 #include "colmap/util/cudacc.h"
 #include "colmap/util/logging.h"
+#include "colmap/util/metrics.h"
+#include "colmap/util/string.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <cuda_runtime.h>
 
@@ -49,6 +56,55 @@ bool CompareCudaDevice(const cudaDeviceProp& d1, const cudaDeviceProp& d2) {
   return result;
 }
 
+struct CudaMemoryComponent {
+  size_t budget = 0;
+  CudaMemoryStats stats;
+};
+
+struct CudaMemoryAllocation {
+  std::string component;
+  size_t num_bytes = 0;
+};
+
+struct CudaMemoryPool {
+  std::mutex mutex;
+  std::unordered_set<int> configured_devices;
+  std::unordered_map<std::string, CudaMemoryComponent> components;
+  std::unordered_map<void*, CudaMemoryAllocation> allocations;
+};
+
+// Intentionally leaked, since device memory may still be freed during the
+// destruction of other static objects.
+CudaMemoryPool& GetCudaMemoryPool() {
+  static CudaMemoryPool* pool = new CudaMemoryPool();
+  return *pool;
+}
+
+// Must be called with the pool mutex held.
+void UpdateCudaMemoryMetrics(const std::string& component_name,
+                             const CudaMemoryComponent& component) {
+  const std::string labels = "{component=\"" + component_name + "\"}";
+  SetMetricGauge("colmap_cuda_memory_bytes" + labels,
+                 component.stats.num_bytes);
+  SetMetricGauge("colmap_cuda_memory_peak_bytes" + labels,
+                 component.stats.peak_num_bytes);
+  SetMetricGauge("colmap_cuda_memory_budget_bytes" + labels, component.budget);
+}
+
+// Keep freed memory in the pool of the device instead of releasing it to the
+// driver at the next synchronization.
+void MaybeConfigureCudaMemoryPool(CudaMemoryPool& pool, const int device) {
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  if (!pool.configured_devices.insert(device).second) {
+    return;
+  }
+  cudaMemPool_t mem_pool;
+  CUDA_SAFE_CALL(cudaDeviceGetDefaultMemPool(&mem_pool, device));
+  uint64_t release_threshold = std::numeric_limits<uint64_t>::max();
+  CUDA_SAFE_CALL(cudaMemPoolSetAttribute(
+      mem_pool, cudaMemPoolAttrReleaseThreshold, &release_threshold));
+}
+
 }  // namespace
 
 int GetNumCudaDevices() {
@@ -84,4 +140,137 @@ void SetBestCudaDevice(const int gpu_index) {
   CUDA_SAFE_CALL(cudaSetDevice(selected));
 }
 
+void GetCudaMemoryInfo(const int gpu_index,
+                       size_t* num_free_bytes,
+                       size_t* num_total_bytes) {
+  THROW_CHECK_GE(gpu_index, 0);
+  THROW_CHECK_LT(gpu_index, GetNumCudaDevices());
+  CUDA_SAFE_CALL(cudaSetDevice(gpu_index));
+  CUDA_SAFE_CALL(cudaMemGetInfo(num_free_bytes, num_total_bytes));
+}
+
+void SetCudaMemoryBudget(const std::string& component,
+                         const size_t num_bytes) {
+  CudaMemoryPool& pool = GetCudaMemoryPool();
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  CudaMemoryComponent& memory_component = pool.components[component];
+  memory_component.budget = num_bytes;
+  UpdateCudaMemoryMetrics(component, memory_component);
+}
+
+size_t GetCudaMemoryBudget(const std::string& component) {
+  CudaMemoryPool& pool = GetCudaMemoryPool();
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  const auto it = pool.components.find(component);
+  return it == pool.components.end() ? 0 : it->second.budget;
+}
+
+void SetCudaMemoryBudgets(const std::string& budgets) {
+  for (std::string budget : StringSplit(budgets, ",")) {
+    StringTrim(&budget);
+    if (budget.empty()) {
+      continue;
+    }
+    const std::vector<std::string> component_and_size =
+        StringSplit(budget, "=");
+    THROW_CHECK_EQ(component_and_size.size(), 2)
+        << "Invalid CUDA memory budget: " << budget;
+    const double num_megabytes = std::stod(component_and_size[1]);
+    THROW_CHECK_GE(num_megabytes, 0);
+    SetCudaMemoryBudget(component_and_size[0],
+                        static_cast<size_t>(num_megabytes * 1024 * 1024));
+  }
+}
+
+CudaMemoryStats GetCudaMemoryStats(const std::string& component) {
+  CudaMemoryPool& pool = GetCudaMemoryPool();
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  const auto it = pool.components.find(component);
+  return it == pool.components.end() ? CudaMemoryStats() : it->second.stats;
+}
+
+void* AllocateCudaMemory(const size_t num_bytes,
+                         const std::string& component) {
+  CudaMemoryPool& pool = GetCudaMemoryPool();
+
+  int device = 0;
+  CUDA_SAFE_CALL(cudaGetDevice(&device));
+  MaybeConfigureCudaMemoryPool(pool, device);
+
+  // Reserve the memory before the allocation, so that concurrent allocations
+  // cannot exceed the budget.
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    CudaMemoryComponent& memory_component = pool.components[component];
+    THROW_CHECK(memory_component.budget == 0 ||
+                memory_component.stats.num_bytes + num_bytes <=
+                    memory_component.budget)
+        << "CUDA memory budget of " << component << " exceeded: "
+        << memory_component.stats.num_bytes << " + " << num_bytes << " > "
+        << memory_component.budget << " bytes";
+    memory_component.stats.num_bytes += num_bytes;
+  }
+
+  void* ptr = nullptr;
+  cudaError_t error = cudaMallocAsync(&ptr, num_bytes, /*stream=*/nullptr);
+  if (error == cudaSuccess) {
+    // Make the memory usable by work on non-blocking streams.
+    error = cudaStreamSynchronize(/*stream=*/nullptr);
+  }
+
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  CudaMemoryComponent& memory_component = pool.components[component];
+  if (error != cudaSuccess) {
+    memory_component.stats.num_bytes -= num_bytes;
+    CUDA_SAFE_CALL(error);
+  }
+  memory_component.stats.peak_num_bytes = std::max(
+      memory_component.stats.peak_num_bytes, memory_component.stats.num_bytes);
+  memory_component.stats.num_allocations += 1;
+  UpdateCudaMemoryMetrics(component, memory_component);
+  pool.allocations.emplace(ptr, CudaMemoryAllocation{component, num_bytes});
+  return ptr;
+}
+
+void* AllocateCudaMemoryPitch(const size_t width_num_bytes,
+                              const size_t height,
+                              const std::string& component,
+                              size_t* pitch) {
+  THROW_CHECK_NOTNULL(pitch);
+  int device = 0;
+  CUDA_SAFE_CALL(cudaGetDevice(&device));
+  int alignment = 0;
+  CUDA_SAFE_CALL(cudaDeviceGetAttribute(
+      &alignment, cudaDevAttrTexturePitchAlignment, device));
+  alignment = std::max(alignment, 1);
+  *pitch = (width_num_bytes + alignment - 1) / alignment * alignment;
+  return AllocateCudaMemory(*pitch * height, component);
+}
+
+void FreeCudaMemory(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+
+  CudaMemoryPool& pool = GetCudaMemoryPool();
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    const auto it = pool.allocations.find(ptr);
+    if (it != pool.allocations.end()) {
+      CudaMemoryComponent& memory_component =
+          pool.components[it->second.component];
+      memory_component.stats.num_bytes -= it->second.num_bytes;
+      UpdateCudaMemoryMetrics(it->second.component, memory_component);
+      pool.allocations.erase(it);
+    } else {
+      LOG(ERROR) << "Freeing CUDA memory that was not allocated by the pool";
+    }
+  }
+
+  const cudaError_t error = cudaFreeAsync(ptr, /*stream=*/nullptr);
+  if (error != cudaSuccess) {
+    LOG(ERROR) << "Failed to free CUDA memory: " << cudaGetErrorString(error);
+  }
+}
+
 }  // namespace colmap
@@ -29,6 +29,9 @@
 
 #pragma once
 
+#include <cstddef>
+#include <string>
+
 namespace colmap {
 
 int GetNumCudaDevices();
@@ -37,4 +40,51 @@ int FindBestCudaDevice();
 
 void SetBestCudaDevice(int gpu_index);
 
+// Get the free and total memory of the given device in bytes. Note that this
+// selects the device on the calling thread.
+void GetCudaMemoryInfo(int gpu_index,
+                       size_t* num_free_bytes,
+                       size_t* num_total_bytes);
+
+// Device memory allocations shared by the CUDA components. Allocations are
+// served from the stream-ordered memory pool of the current device, which
+// keeps freed memory for reuse by any component instead of returning it to the
+// driver. This avoids fragmenting the device, when multiple components run
+// concurrently in one process. Allocations and frees are ordered on the
+// default stream. The memory is accounted per component and exported as the
+// metrics colmap_cuda_memory_bytes, colmap_cuda_memory_peak_bytes, and
+// colmap_cuda_memory_budget_bytes with the label component="...".
+struct CudaMemoryStats {
+  // The number of currently allocated bytes.
+  size_t num_bytes = 0;
+  // The maximum number of allocated bytes at any time.
+  size_t peak_num_bytes = 0;
+  // The total number of allocations.
+  size_t num_allocations = 0;
+};
+
+// Limit the memory of a component to the given number of bytes, such that
+// further allocations throw. A budget of zero disables the limit.
+void SetCudaMemoryBudget(const std::string& component, size_t num_bytes);
+size_t GetCudaMemoryBudget(const std::string& component);
+
+// Set the budgets from a comma-separated list of "component=megabytes", e.g.,
+// "mvs=8192,onnx=2048".
+void SetCudaMemoryBudgets(const std::string& budgets);
+
+CudaMemoryStats GetCudaMemoryStats(const std::string& component);
+
+void* AllocateCudaMemory(size_t num_bytes, const std::string& component);
+
+// Allocate a 2D array with rows padded to the texture pitch alignment of the
+// device. Returns the pitch of the rows in bytes.
+void* AllocateCudaMemoryPitch(size_t width_num_bytes,
+                              size_t height,
+                              const std::string& component,
+                              size_t* pitch);
+
+// Return the memory to the pool. Does not throw, so that it can be called in
+// destructors.
+void FreeCudaMemory(void* ptr);
+
 }  // namespace colmap
@@ -0,0 +1,642 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace colmap {
+
+// Associative container for entities with dense integer ids, such as the 3D
+// points of a reconstruction, which are assigned consecutively. It implements
+// the subset of the std::unordered_map interface used throughout the code base,
+// but stores the values in contiguous slots that are addressed through a flat
+// id-to-slot table instead of hash buckets. Lookups are therefore a single
+// indirection and iteration is a linear scan over memory. Removed values leave
+// a tombstone slot that is reused by the next insertion. As for
+// std::unordered_map, references to values remain valid when other values are
+// inserted or removed. The id table is allocated in chunks of ids on the first
+// insertion of one of their ids and takes 4 bytes per id of the allocated
+// chunks. Ids far beyond the number of values, e.g., read from a file written
+// by another tool, are instead indexed in a hash map, such that sparse ids do
+// not blow up the id table but only lose the faster lookup.
+//
+// Copies are deep and independent of the original. In addition, Snapshot()
+// returns a copy that shares the reference-counted chunks of the slots and the
+// id table with the original, which are only cloned on the first mutable access
+// after the snapshot by either container (copy-on-write). Taking a snapshot is
+// therefore cheap and its cost is paid incrementally for the chunks that are
+// modified later on, which allows taking frequent snapshots of large, slowly
+// changing containers. Iterating over a mutable container clones every chunk
+// that is visited, so read-only code should iterate over a const reference.
+// A snapshot can be read from another thread while the original is modified.
+template <typename ID, typename T>
+class DenseIdMap {
+ public:
+  using key_type = ID;
+  using mapped_type = T;
+  using value_type = std::pair<const ID, T>;
+  using size_type = size_t;
+
+  template <bool kConst>
+  class Iterator;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  DenseIdMap() = default;
+  DenseIdMap(const DenseIdMap& other);
+  DenseIdMap& operator=(const DenseIdMap& other);
+  DenseIdMap(DenseIdMap&& other) noexcept = default;
+  DenseIdMap& operator=(DenseIdMap&& other) noexcept = default;
+
+  size_t size() const;
+  bool empty() const;
+
+  iterator begin();
+  iterator end();
+  const_iterator begin() const;
+  const_iterator end() const;
+  const_iterator cbegin() const;
+  const_iterator cend() const;
+
+  iterator find(ID id);
+  const_iterator find(ID id) const;
+  size_t count(ID id) const;
+  bool contains(ID id) const;
+
+  // Throws std::out_of_range if the id does not exist.
+  T& at(ID id);
+  const T& at(ID id) const;
+
+  // Default-constructs the value if the id does not exist.
+  T& operator[](ID id);
+
+  // Constructs the value from the given arguments if the id does not exist.
+  // Returns the iterator to the value and whether it was inserted.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(ID id, Args&&... args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(ID id, Args&&... args);
+
+  size_t erase(ID id);
+  iterator erase(const_iterator pos);
+
+  void clear();
+
+  // Pre-allocates slots for the given number of values.
+  void reserve(size_t num_values);
+
+  bool operator==(const DenseIdMap& other) const;
+  bool operator!=(const DenseIdMap& other) const;
+
+  // Returns a copy that shares its chunks copy-on-write with this container.
+  // References and iterators obtained through mutable access before the
+  // snapshot point into the shared chunks, so they must not be used to modify
+  // this container afterwards, as the modification would also change the
+  // snapshot. Obtain them again after the snapshot instead.
+  DenseIdMap Snapshot() const;
+
+  // Calls func(id) for all ids stored in chunks that are not shared
+  // copy-on-write with the other container, in either of the two containers.
+  // The values of all other ids are identical in both containers, so that
+  // diffing a container against an earlier snapshot only visits the chunks
+  // modified since the snapshot. Ids may be visited more than once.
+  template <typename Func>
+  void ForEachUnsharedId(const DenseIdMap& other, Func&& func) const;
+
+  template <bool kConst>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = DenseIdMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer =
+        std::conditional_t<kConst, const value_type*, value_type*>;
+    using reference =
+        std::conditional_t<kConst, const value_type&, value_type&>;
+    using map_pointer =
+        std::conditional_t<kConst, const DenseIdMap*, DenseIdMap*>;
+
+    Iterator() = default;
+    Iterator(map_pointer map, size_t slot_idx);
+    // Allow conversion from iterator to const_iterator.
+    template <bool kOtherConst,
+              typename = std::enable_if_t<kConst && !kOtherConst>>
+    Iterator(const Iterator<kOtherConst>& other);  // NOLINT
+
+    reference operator*() const;
+    pointer operator->() const;
+    Iterator& operator++();
+    Iterator operator++(int);
+    bool operator==(const Iterator& other) const;
+    bool operator!=(const Iterator& other) const;
+
+   private:
+    template <bool>
+    friend class Iterator;
+    friend class DenseIdMap;
+
+    map_pointer map_ = nullptr;
+    size_t slot_idx_ = 0;
+  };
+
+ private:
+  using Slot = std::optional<value_type>;
+
+  // Slots are allocated in fixed-size chunks, which keeps references stable
+  // when the container grows.
+  static constexpr size_t kChunkSize = 1024;
+  static constexpr uint32_t kInvalidSlotIdx =
+      std::numeric_limits<uint32_t>::max();
+
+  static constexpr size_t kIdChunkSize = 4096;
+
+  template <typename U>
+  using Chunk = std::shared_ptr<U[]>;
+
+  template <typename U>
+  static Chunk<U> NewChunk(size_t chunk_size);
+  // Clones the chunk if it is shared with a snapshot of the container.
+  template <typename U>
+  static void MakeChunkUnique(Chunk<U>& chunk, size_t chunk_size);
+  // Clones all chunks that are shared with the container they were copied
+  // from.
+  void MakeChunksUnique();
+
+  // The mutable overload clones shared chunks.
+  Slot& GetSlot(size_t slot_idx);
+  const Slot& GetSlot(size_t slot_idx) const;
+  // Returns the slot index entry of the id, which is created in the id table
+  // or, for ids far beyond the number of values, in the sparse id map.
+  uint32_t& GetMutableIdSlotIdx(size_t id_idx);
+  size_t FindSlotIdx(ID id) const;
+  size_t NextOccupiedSlotIdx(size_t slot_idx) const;
+  size_t AllocateSlot();
+
+  std::vector<Chunk<Slot>> chunks_;
+  // Maps ids to slot indices, kInvalidSlotIdx for non-existent ids. Chunks
+  // are allocated on the first insertion of one of their ids, and a null
+  // chunk means that none of its ids exist.
+  std::vector<Chunk<uint32_t>> id_chunks_;
+  // Maps ids that were beyond the id table on insertion to slot indices.
+  std::unordered_map<size_t, uint32_t> sparse_id_slot_idxs_;
+  // Tombstone slots below num_used_slots_ that can be reused.
+  std::vector<uint32_t> free_slot_idxs_;
+  // Upper bound of the slots that were ever occupied.
+  size_t num_used_slots_ = 0;
+  size_t size_ = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename ID, typename T>
+DenseIdMap<ID, T>::DenseIdMap(const DenseIdMap& other)
+    : chunks_(other.chunks_),
+      id_chunks_(other.id_chunks_),
+      sparse_id_slot_idxs_(other.sparse_id_slot_idxs_),
+      free_slot_idxs_(other.free_slot_idxs_),
+      num_used_slots_(other.num_used_slots_),
+      size_(other.size_) {
+  MakeChunksUnique();
+}
+
+template <typename ID, typename T>
+DenseIdMap<ID, T>& DenseIdMap<ID, T>::operator=(const DenseIdMap& other) {
+  if (this != &other) {
+    DenseIdMap copy(other);
+    *this = std::move(copy);
+  }
+  return *this;
+}
+
+template <typename ID, typename T>
+size_t DenseIdMap<ID, T>::size() const {
+  return size_;
+}
+
+template <typename ID, typename T>
+bool DenseIdMap<ID, T>::empty() const {
+  return size_ == 0;
+}
+
+template <typename ID, typename T>
+typename DenseIdMap<ID, T>::iterator DenseIdMap<ID, T>::begin() {
+  return iterator(this, NextOccupiedSlotIdx(0));
+}
+
+template <typename ID, typename T>
+typename DenseIdMap<ID, T>::iterator DenseIdMap<ID, T>::end() {
+  return iterator(this, num_used_slots_);
+}
+
+template <typename ID, typename T>
+typename DenseIdMap<ID, T>::const_iterator DenseIdMap<ID, T>::begin() const {
+  return const_iterator(this, NextOccupiedSlotIdx(0));
+}
+
+template <typename ID, typename T>
+typename DenseIdMap<ID, T>::const_iterator DenseIdMap<ID, T>::end() const {
+  return const_iterator(this, num_used_slots_);
+}
+
+template <typename ID, typename T>
+typename DenseIdMap<ID, T>::const_iterator DenseIdMap<ID, T>::cbegin() const {
+  return begin();
+}
+
+template <typename ID, typename T>
+typename DenseIdMap<ID, T>::const_iterator DenseIdMap<ID, T>::cend() const {
+  return end();
+}
+
+template <typename ID, typename T>
+typename DenseIdMap<ID, T>::iterator DenseIdMap<ID, T>::find(const ID id) {
+  return iterator(this, FindSlotIdx(id));
+}
+
+template <typename ID, typename T>
+typename DenseIdMap<ID, T>::const_iterator DenseIdMap<ID, T>::find(
+    const ID id) const {
+  return const_iterator(this, FindSlotIdx(id));
+}
+
+template <typename ID, typename T>
+size_t DenseIdMap<ID, T>::count(const ID id) const {
+  return FindSlotIdx(id) == num_used_slots_ ? 0 : 1;
+}
+
+template <typename ID, typename T>
+bool DenseIdMap<ID, T>::contains(const ID id) const {
+  return count(id) > 0;
+}
+
+template <typename ID, typename T>
+T& DenseIdMap<ID, T>::at(const ID id) {
+  const size_t slot_idx = FindSlotIdx(id);
+  if (slot_idx == num_used_slots_) {
+    throw std::out_of_range("DenseIdMap::at");
+  }
+  return GetSlot(slot_idx)->second;
+}
+
+template <typename ID, typename T>
+const T& DenseIdMap<ID, T>::at(const ID id) const {
+  const size_t slot_idx = FindSlotIdx(id);
+  if (slot_idx == num_used_slots_) {
+    throw std::out_of_range("DenseIdMap::at");
+  }
+  return GetSlot(slot_idx)->second;
+}
+
+template <typename ID, typename T>
+T& DenseIdMap<ID, T>::operator[](const ID id) {
+  return try_emplace(id).first->second;
+}
+
+template <typename ID, typename T>
+template <typename... Args>
+std::pair<typename DenseIdMap<ID, T>::iterator, bool>
+DenseIdMap<ID, T>::emplace(const ID id, Args&&... args) {
+  return try_emplace(id, std::forward<Args>(args)...);
+}
+
+template <typename ID, typename T>
+template <typename... Args>
+std::pair<typename DenseIdMap<ID, T>::iterator, bool>
+DenseIdMap<ID, T>::try_emplace(const ID id, Args&&... args) {
+  const size_t existing_slot_idx = FindSlotIdx(id);
+  if (existing_slot_idx != num_used_slots_) {
+    return {iterator(this, existing_slot_idx), false};
+  }
+
+  const size_t slot_idx = AllocateSlot();
+  GetSlot(slot_idx).emplace(std::piecewise_construct,
+                            std::forward_as_tuple(id),
+                            std::forward_as_tuple(std::forward<Args>(args)...));
+  GetMutableIdSlotIdx(static_cast<size_t>(id)) =
+      static_cast<uint32_t>(slot_idx);
+  ++size_;
+  return {iterator(this, slot_idx), true};
+}
+
+template <typename ID, typename T>
+size_t DenseIdMap<ID, T>::erase(const ID id) {
+  const size_t slot_idx = FindSlotIdx(id);
+  if (slot_idx == num_used_slots_) {
+    return 0;
+  }
+  erase(const_iterator(this, slot_idx));
+  return 1;
+}
+
+template <typename ID, typename T>
+typename DenseIdMap<ID, T>::iterator DenseIdMap<ID, T>::erase(
+    const const_iterator pos) {
+  const size_t slot_idx = pos.slot_idx_;
+  Slot& slot = GetSlot(slot_idx);
+  const size_t id_idx = static_cast<size_t>(slot->first);
+  if (sparse_id_slot_idxs_.erase(id_idx) == 0) {
+    GetMutableIdSlotIdx(id_idx) = kInvalidSlotIdx;
+  }
+  slot.reset();
+  free_slot_idxs_.push_back(static_cast<uint32_t>(slot_idx));
+  --size_;
+  return iterator(this, NextOccupiedSlotIdx(slot_idx + 1));
+}
+
+template <typename ID, typename T>
+void DenseIdMap<ID, T>::clear() {
+  chunks_.clear();
+  id_chunks_.clear();
+  sparse_id_slot_idxs_.clear();
+  free_slot_idxs_.clear();
+  num_used_slots_ = 0;
+  size_ = 0;
+}
+
+template <typename ID, typename T>
+void DenseIdMap<ID, T>::reserve(const size_t num_values) {
+  const size_t num_chunks = (num_values + kChunkSize - 1) / kChunkSize;
+  chunks_.reserve(num_chunks);
+  while (chunks_.size() < num_chunks) {
+    chunks_.push_back(NewChunk<Slot>(kChunkSize));
+  }
+}
+
+template <typename ID, typename T>
+bool DenseIdMap<ID, T>::operator==(const DenseIdMap& other) const {
+  if (size_ != other.size_) {
+    return false;
+  }
+  for (const auto& [id, value] : *this) {
+    const auto it = other.find(id);
+    if (it == other.end() || !(it->second == value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename ID, typename T>
+bool DenseIdMap<ID, T>::operator!=(const DenseIdMap& other) const {
+  return !(*this == other);
+}
+
+template <typename ID, typename T>
+DenseIdMap<ID, T> DenseIdMap<ID, T>::Snapshot() const {
+  DenseIdMap snapshot;
+  snapshot.chunks_ = chunks_;
+  snapshot.id_chunks_ = id_chunks_;
+  snapshot.sparse_id_slot_idxs_ = sparse_id_slot_idxs_;
+  snapshot.free_slot_idxs_ = free_slot_idxs_;
+  snapshot.num_used_slots_ = num_used_slots_;
+  snapshot.size_ = size_;
+  return snapshot;
+}
+
+template <typename ID, typename T>
+template <typename Func>
+void DenseIdMap<ID, T>::ForEachUnsharedId(const DenseIdMap& other,
+                                          Func&& func) const {
+  const size_t num_chunks = std::max(chunks_.size(), other.chunks_.size());
+  for (size_t chunk_idx = 0; chunk_idx < num_chunks; ++chunk_idx) {
+    if (chunk_idx < chunks_.size() && chunk_idx < other.chunks_.size() &&
+        chunks_[chunk_idx] == other.chunks_[chunk_idx]) {
+      continue;
+    }
+    for (const DenseIdMap* map : {this, &other}) {
+      if (chunk_idx >= map->chunks_.size()) {
+        continue;
+      }
+      const size_t end_slot_idx =
+          std::min((chunk_idx + 1) * kChunkSize, map->num_used_slots_);
+      for (size_t slot_idx = chunk_idx * kChunkSize; slot_idx < end_slot_idx;
+           ++slot_idx) {
+        const Slot& slot = map->GetSlot(slot_idx);
+        if (slot.has_value()) {
+          func(slot->first);
+        }
+      }
+    }
+  }
+}
+
+template <typename ID, typename T>
+template <typename U>
+typename DenseIdMap<ID, T>::template Chunk<U> DenseIdMap<ID, T>::NewChunk(
+    const size_t chunk_size) {
+  return Chunk<U>(new U[chunk_size]());
+}
+
+template <typename ID, typename T>
+template <typename U>
+void DenseIdMap<ID, T>::MakeChunkUnique(Chunk<U>& chunk,
+                                        const size_t chunk_size) {
+  if (chunk.use_count() == 1) {
+    // Synchronize with the release of the chunk by copies in other threads.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return;
+  }
+  Chunk<U> unique_chunk = NewChunk<U>(chunk_size);
+  for (size_t i = 0; i < chunk_size; ++i) {
+    if constexpr (std::is_same_v<U, Slot>) {
+      if (chunk[i].has_value()) {
+        unique_chunk[i].emplace(*chunk[i]);
+      }
+    } else {
+      unique_chunk[i] = chunk[i];
+    }
+  }
+  chunk = std::move(unique_chunk);
+}
+
+template <typename ID, typename T>
+void DenseIdMap<ID, T>::MakeChunksUnique() {
+  for (Chunk<Slot>& chunk : chunks_) {
+    MakeChunkUnique(chunk, kChunkSize);
+  }
+  for (Chunk<uint32_t>& chunk : id_chunks_) {
+    if (chunk != nullptr) {
+      MakeChunkUnique(chunk, kIdChunkSize);
+    }
+  }
+}
+
+template <typename ID, typename T>
+typename DenseIdMap<ID, T>::Slot& DenseIdMap<ID, T>::GetSlot(
+    const size_t slot_idx) {
+  Chunk<Slot>& chunk = chunks_[slot_idx / kChunkSize];
+  MakeChunkUnique(chunk, kChunkSize);
+  return chunk[slot_idx % kChunkSize];
+}
+
+template <typename ID, typename T>
+const typename DenseIdMap<ID, T>::Slot& DenseIdMap<ID, T>::GetSlot(
+    const size_t slot_idx) const {
+  return chunks_[slot_idx / kChunkSize][slot_idx % kChunkSize];
+}
+
+template <typename ID, typename T>
+uint32_t& DenseIdMap<ID, T>::GetMutableIdSlotIdx(const size_t id_idx) {
+  const size_t chunk_idx = id_idx / kIdChunkSize;
+  if (chunk_idx >= id_chunks_.size() &&
+      id_idx >= 4 * size_ + kIdChunkSize) {
+    return sparse_id_slot_idxs_.emplace(id_idx, kInvalidSlotIdx).first->second;
+  }
+  if (chunk_idx >= id_chunks_.size()) {
+    id_chunks_.resize(chunk_idx + 1);
+  }
+  Chunk<uint32_t>& chunk = id_chunks_[chunk_idx];
+  if (chunk == nullptr) {
+    chunk = NewChunk<uint32_t>(kIdChunkSize);
+    std::fill_n(chunk.get(), kIdChunkSize, kInvalidSlotIdx);
+  } else {
+    MakeChunkUnique(chunk, kIdChunkSize);
+  }
+  return chunk[id_idx % kIdChunkSize];
+}
+
+template <typename ID, typename T>
+size_t DenseIdMap<ID, T>::FindSlotIdx(const ID id) const {
+  const size_t id_idx = static_cast<size_t>(id);
+  const size_t chunk_idx = id_idx / kIdChunkSize;
+  if (chunk_idx < id_chunks_.size() && id_chunks_[chunk_idx] != nullptr) {
+    const uint32_t slot_idx = id_chunks_[chunk_idx][id_idx % kIdChunkSize];
+    if (slot_idx != kInvalidSlotIdx) {
+      return slot_idx;
+    }
+  }
+  // Sparse ids may also lie within the id table, if it grew after they were
+  // inserted.
+  if (!sparse_id_slot_idxs_.empty()) {
+    const auto it = sparse_id_slot_idxs_.find(id_idx);
+    if (it != sparse_id_slot_idxs_.end()) {
+      return it->second;
+    }
+  }
+  return num_used_slots_;
+}
+
+template <typename ID, typename T>
+size_t DenseIdMap<ID, T>::NextOccupiedSlotIdx(size_t slot_idx) const {
+  while (slot_idx < num_used_slots_ && !GetSlot(slot_idx).has_value()) {
+    ++slot_idx;
+  }
+  return slot_idx;
+}
+
+template <typename ID, typename T>
+size_t DenseIdMap<ID, T>::AllocateSlot() {
+  if (!free_slot_idxs_.empty()) {
+    const size_t slot_idx = free_slot_idxs_.back();
+    free_slot_idxs_.pop_back();
+    return slot_idx;
+  }
+  if (num_used_slots_ == chunks_.size() * kChunkSize) {
+    chunks_.push_back(NewChunk<Slot>(kChunkSize));
+  }
+  if (num_used_slots_ >= kInvalidSlotIdx) {
+    throw std::length_error("DenseIdMap exceeds maximum size");
+  }
+  return num_used_slots_++;
+}
+
+template <typename ID, typename T>
+template <bool kConst>
+DenseIdMap<ID, T>::Iterator<kConst>::Iterator(const map_pointer map,
+                                              const size_t slot_idx)
+    : map_(map), slot_idx_(slot_idx) {}
+
+template <typename ID, typename T>
+template <bool kConst>
+template <bool kOtherConst, typename>
+DenseIdMap<ID, T>::Iterator<kConst>::Iterator(
+    const Iterator<kOtherConst>& other)
+    : map_(other.map_), slot_idx_(other.slot_idx_) {}
+
+template <typename ID, typename T>
+template <bool kConst>
+typename DenseIdMap<ID, T>::template Iterator<kConst>::reference
+DenseIdMap<ID, T>::Iterator<kConst>::operator*() const {
+  return *map_->GetSlot(slot_idx_);
+}
+
+template <typename ID, typename T>
+template <bool kConst>
+typename DenseIdMap<ID, T>::template Iterator<kConst>::pointer
+DenseIdMap<ID, T>::Iterator<kConst>::operator->() const {
+  return &*map_->GetSlot(slot_idx_);
+}
+
+template <typename ID, typename T>
+template <bool kConst>
+typename DenseIdMap<ID, T>::template Iterator<kConst>&
+DenseIdMap<ID, T>::Iterator<kConst>::operator++() {
+  slot_idx_ = map_->NextOccupiedSlotIdx(slot_idx_ + 1);
+  return *this;
+}
+
+template <typename ID, typename T>
+template <bool kConst>
+typename DenseIdMap<ID, T>::template Iterator<kConst>
+DenseIdMap<ID, T>::Iterator<kConst>::operator++(int) {
+  Iterator it = *this;
+  ++(*this);
+  return it;
+}
+
+template <typename ID, typename T>
+template <bool kConst>
+bool DenseIdMap<ID, T>::Iterator<kConst>::operator==(
+    const Iterator& other) const {
+  return map_ == other.map_ && slot_idx_ == other.slot_idx_;
+}
+
+template <typename ID, typename T>
+template <bool kConst>
+bool DenseIdMap<ID, T>::Iterator<kConst>::operator!=(
+    const Iterator& other) const {
+  return !(*this == other);
+}
+
+}  // namespace colmap
@@ -0,0 +1,331 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/util/dense_id_map.h"
+
+#include <limits>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+TEST(DenseIdMap, Empty) {
+  DenseIdMap<uint32_t, int> map;
+  EXPECT_EQ(map.size(), 0);
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+  EXPECT_EQ(map.count(0), 0);
+  EXPECT_EQ(map.find(0), map.end());
+  EXPECT_ANY_THROW(map.at(0));
+}
+
+TEST(DenseIdMap, EmplaceFindErase) {
+  DenseIdMap<uint32_t, std::string> map;
+  EXPECT_TRUE(map.emplace(1, "a").second);
+  EXPECT_TRUE(map.emplace(3, "c").second);
+  EXPECT_FALSE(map.emplace(1, "b").second);
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(map.at(1), "a");
+  EXPECT_EQ(map.at(3), "c");
+  EXPECT_EQ(map.count(2), 0);
+  EXPECT_TRUE(map.contains(3));
+  EXPECT_EQ(map.find(3)->first, 3);
+  EXPECT_EQ(map.find(3)->second, "c");
+
+  map[2] = "b";
+  EXPECT_EQ(map.size(), 3);
+  EXPECT_EQ(map.at(2), "b");
+
+  EXPECT_EQ(map.erase(2), 1);
+  EXPECT_EQ(map.erase(2), 0);
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_FALSE(map.contains(2));
+  EXPECT_ANY_THROW(map.at(2));
+
+  auto it = map.erase(map.find(1));
+  ASSERT_NE(it, map.end());
+  EXPECT_EQ(it->first, 3);
+  EXPECT_EQ(map.size(), 1);
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(DenseIdMap, Iterate) {
+  DenseIdMap<uint64_t, int> map;
+  std::unordered_map<uint64_t, int> ref_map;
+  for (int i = 0; i < 5000; ++i) {
+    map.emplace(i, 2 * i);
+    ref_map.emplace(i, 2 * i);
+  }
+  for (int i = 0; i < 5000; i += 3) {
+    map.erase(i);
+    ref_map.erase(i);
+  }
+
+  std::unordered_map<uint64_t, int> iterated;
+  for (const auto& [id, value] : map) {
+    EXPECT_TRUE(iterated.emplace(id, value).second);
+  }
+  EXPECT_EQ(iterated, ref_map);
+  EXPECT_EQ(map.size(), ref_map.size());
+
+  for (auto& [id, value] : map) {
+    value += 1;
+  }
+  for (const auto& [id, value] : ref_map) {
+    EXPECT_EQ(map.at(id), value + 1);
+  }
+}
+
+TEST(DenseIdMap, ReusesErasedSlotsWithStableReferences) {
+  DenseIdMap<uint32_t, int> map;
+  for (uint32_t i = 0; i < 3000; ++i) {
+    map.emplace(i, i);
+  }
+  const int* value_ptr = &map.at(2999);
+  for (uint32_t i = 0; i < 1000; ++i) {
+    map.erase(i);
+  }
+  for (uint32_t i = 3000; i < 10000; ++i) {
+    map.emplace(i, i);
+  }
+  EXPECT_EQ(value_ptr, &map.at(2999));
+  EXPECT_EQ(*value_ptr, 2999);
+  EXPECT_EQ(map.size(), 9000);
+}
+
+TEST(DenseIdMap, CopyAndCompare) {
+  DenseIdMap<uint32_t, int> map1;
+  map1.reserve(10);
+  map1.emplace(1, 1);
+  map1.emplace(2, 2);
+  map1.emplace(5, 5);
+  map1.erase(2);
+
+  DenseIdMap<uint32_t, int> map2 = map1;
+  EXPECT_EQ(map1, map2);
+  EXPECT_EQ(map2.size(), 2);
+  EXPECT_EQ(map2.at(5), 5);
+
+  map2.at(5) = 6;
+  EXPECT_NE(map1, map2);
+  EXPECT_EQ(map1.at(5), 5);
+
+  map2 = map1;
+  EXPECT_EQ(map1, map2);
+
+  // Insertion order does not matter.
+  DenseIdMap<uint32_t, int> map3;
+  map3.emplace(5, 5);
+  map3.emplace(1, 1);
+  EXPECT_EQ(map1, map3);
+
+  DenseIdMap<uint32_t, int> map4 = std::move(map3);
+  EXPECT_EQ(map1, map4);
+}
+
+TEST(DenseIdMap, CopyOnWrite) {
+  DenseIdMap<uint32_t, std::vector<int>> map;
+  for (uint32_t i = 0; i < 5000; ++i) {
+    map.emplace(i, std::vector<int>{static_cast<int>(i)});
+  }
+
+  const DenseIdMap<uint32_t, std::vector<int>> snapshot = map.Snapshot();
+  // Const access does not clone the shared chunks.
+  const auto& const_map = map;
+  EXPECT_EQ(&const_map.at(42), &snapshot.at(42));
+
+  // Modifications of the original are not visible in the snapshot.
+  map.at(42).push_back(1);
+  map.erase(100);
+  map.emplace(10000, std::vector<int>{-1});
+  map.find(4000)->second[0] = -4000;
+  EXPECT_NE(&const_map.at(42), &snapshot.at(42));
+  EXPECT_EQ(map.at(42), (std::vector<int>{42, 1}));
+  EXPECT_EQ(map.at(4000), std::vector<int>{-4000});
+  EXPECT_EQ(map.count(100), 0);
+  EXPECT_EQ(map.size(), 5000);
+  EXPECT_EQ(snapshot.at(42), std::vector<int>{42});
+  EXPECT_EQ(snapshot.at(4000), std::vector<int>{4000});
+  EXPECT_EQ(snapshot.count(100), 1);
+  EXPECT_EQ(snapshot.count(10000), 0);
+  EXPECT_EQ(snapshot.size(), 5000);
+
+  // Chunks that were not modified remain shared.
+  EXPECT_EQ(&const_map.at(2500), &snapshot.at(2500));
+}
+
+TEST(DenseIdMap, CopyIsIndependentOfPreCopyReferences) {
+  DenseIdMap<uint32_t, int> map;
+  for (uint32_t i = 0; i < 5000; ++i) {
+    map.emplace(i, i);
+  }
+
+  int& value1 = map.at(42);
+  int& value2 = map.find(4000)->second;
+  const DenseIdMap<uint32_t, int> copy = map;
+  value1 = -42;
+  value2 = -4000;
+  EXPECT_EQ(map.at(42), -42);
+  EXPECT_EQ(map.at(4000), -4000);
+  EXPECT_EQ(copy.at(42), 42);
+  EXPECT_EQ(copy.at(4000), 4000);
+
+  // Unlike a snapshot, a copy shares no chunks with the original.
+  std::set<uint32_t> unshared_ids;
+  map.ForEachUnsharedId(copy, [&](uint32_t id) { unshared_ids.insert(id); });
+  EXPECT_EQ(unshared_ids.size(), 5000);
+}
+
+TEST(DenseIdMap, SparseIds) {
+  // Ids far beyond the number of values must not allocate an id table up to
+  // the largest id.
+  constexpr uint64_t kHugeId = uint64_t(1) << 40;
+  DenseIdMap<uint64_t, int> map;
+  EXPECT_TRUE(map.emplace(kHugeId, 1).second);
+  EXPECT_FALSE(map.emplace(kHugeId, 2).second);
+  EXPECT_TRUE(map.emplace(kHugeId + 1, 2).second);
+  EXPECT_TRUE(map.emplace(std::numeric_limits<uint64_t>::max() - 1, 3).second);
+  for (uint64_t i = 0; i < 5000; ++i) {
+    map.emplace(i, -static_cast<int>(i));
+  }
+  EXPECT_EQ(map.size(), 5003);
+  EXPECT_EQ(map.at(kHugeId), 1);
+  EXPECT_EQ(map.at(kHugeId + 1), 2);
+  EXPECT_EQ(map.at(std::numeric_limits<uint64_t>::max() - 1), 3);
+  EXPECT_EQ(map.at(4999), -4999);
+  EXPECT_EQ(map.count(kHugeId + 2), 0);
+
+  const DenseIdMap<uint64_t, int> snapshot = map;
+  EXPECT_EQ(map.erase(kHugeId), 1);
+  EXPECT_EQ(map.erase(kHugeId), 0);
+  EXPECT_FALSE(map.contains(kHugeId));
+  EXPECT_EQ(map.size(), 5002);
+  EXPECT_EQ(snapshot.at(kHugeId), 1);
+  EXPECT_NE(map, snapshot);
+
+  std::set<uint64_t> ids;
+  for (const auto& [id, value] : map) {
+    ids.insert(id);
+  }
+  EXPECT_EQ(ids.size(), 5002);
+  EXPECT_EQ(ids.count(kHugeId + 1), 1);
+
+  map.clear();
+  EXPECT_EQ(map.count(kHugeId + 1), 0);
+}
+
+TEST(DenseIdMap, IdGaps) {
+  DenseIdMap<uint32_t, int> map;
+  for (uint32_t i = 0; i < 4000; ++i) {
+    map.emplace(i, static_cast<int>(i));
+  }
+  // Skips the id chunks in between, which are not allocated.
+  EXPECT_TRUE(map.emplace(20000, 1).second);
+  EXPECT_EQ(map.count(5000), 0);
+  EXPECT_EQ(map.count(12000), 0);
+  EXPECT_EQ(map.find(16383), map.end());
+  EXPECT_EQ(map.erase(9000), 0);
+  EXPECT_EQ(map.at(20000), 1);
+
+  const DenseIdMap<uint32_t, int> snapshot = map;
+  EXPECT_TRUE(map.emplace(12000, 2).second);
+  EXPECT_EQ(map.at(12000), 2);
+  EXPECT_EQ(map.size(), 4002);
+  EXPECT_EQ(snapshot.count(12000), 0);
+  EXPECT_EQ(snapshot.size(), 4001);
+  EXPECT_EQ(map.erase(12000), 1);
+  EXPECT_EQ(map, snapshot);
+}
+
+TEST(DenseIdMap, ForEachUnsharedId) {
+  DenseIdMap<uint32_t, int> map;
+  for (uint32_t i = 0; i < 5000; ++i) {
+    map.emplace(i, i);
+  }
+
+  const DenseIdMap<uint32_t, int> snapshot = map.Snapshot();
+  std::set<uint32_t> unshared_ids;
+  map.ForEachUnsharedId(snapshot,
+                        [&](uint32_t id) { unshared_ids.insert(id); });
+  EXPECT_THAT(unshared_ids, testing::IsEmpty());
+
+  map.at(42) = -1;
+  map.erase(2100);
+  map.emplace(6000, 6000);
+  map.ForEachUnsharedId(snapshot,
+                        [&](uint32_t id) { unshared_ids.insert(id); });
+  // Only the ids in the modified chunks of 1024 slots are visited.
+  EXPECT_EQ(unshared_ids.size(), 2 * 1024 + 1);
+  EXPECT_EQ(unshared_ids.count(42), 1);
+  EXPECT_EQ(unshared_ids.count(2100), 1);
+  EXPECT_EQ(unshared_ids.count(6000), 1);
+  EXPECT_EQ(unshared_ids.count(4000), 0);
+}
+
+TEST(DenseIdMap, ConcurrentSnapshotReads) {
+  DenseIdMap<uint32_t, int> map;
+  for (uint32_t i = 0; i < 10000; ++i) {
+    map.emplace(i, 0);
+  }
+
+  std::vector<DenseIdMap<uint32_t, int>> snapshots;
+  std::vector<std::thread> readers;
+  for (int value = 1; value <= 4; ++value) {
+    snapshots.push_back(map.Snapshot());
+    for (auto& [_, v] : map) {
+      v = value;
+    }
+  }
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&snapshots, i]() {
+      for (const auto& [_, v] : snapshots[i]) {
+        EXPECT_EQ(v, i);
+      }
+    });
+  }
+  for (auto& [_, v] : map) {
+    v = -1;
+  }
+  for (auto& reader : readers) {
+    reader.join();
+  }
+}
+
+}  // namespace
+}  // namespace colmap
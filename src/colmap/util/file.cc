@@ -51,6 +51,15 @@
 #endif
 #endif
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #ifndef _MSC_VER
 extern "C" {
 extern char** environ;
@@ -200,8 +209,6 @@ std::vector<std::filesystem::path> GetDirList(
   return dir_list;
 }
 
-namespace {
-
 std::optional<std::string> GetEnvSafe(const char* key) {
 #ifdef _MSC_VER
   size_t size = 0;
@@ -234,8 +241,6 @@ std::optional<std::string> GetEnvSafe(const char* key) {
 #endif
 }
 
-}  // namespace
-
 std::optional<std::filesystem::path> HomeDir() {
 #ifdef _MSC_VER
   std::optional<std::string> userprofile = GetEnvSafe("USERPROFILE");
@@ -281,6 +286,108 @@ void WriteBinaryBlob(const std::filesystem::path& path,
   file.write(data.begin(), data.size());
 }
 
+MemoryMappedFile::MemoryMappedFile(const std::filesystem::path& path) {
+  Map(path);
+}
+
+MemoryMappedFile::~MemoryMappedFile() { Unmap(); }
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept {
+  *this = std::move(other);
+}
+
+MemoryMappedFile& MemoryMappedFile::operator=(
+    MemoryMappedFile&& other) noexcept {
+  if (this != &other) {
+    Unmap();
+    std::swap(is_mapped_, other.is_mapped_);
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+#ifdef _WIN32
+    std::swap(file_handle_, other.file_handle_);
+    std::swap(mapping_handle_, other.mapping_handle_);
+#endif
+  }
+  return *this;
+}
+
+void MemoryMappedFile::Map(const std::filesystem::path& path) {
+  Unmap();
+
+  const size_t num_bytes = std::filesystem::file_size(path);
+
+#ifdef _WIN32
+  HANDLE file_handle = CreateFileW(path.wstring().c_str(),
+                                   GENERIC_READ,
+                                   FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                   nullptr,
+                                   OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL,
+                                   nullptr);
+  THROW_CHECK(file_handle != INVALID_HANDLE_VALUE)
+      << "Could not open " << path << " for memory mapping.";
+  if (num_bytes > 0) {
+    HANDLE mapping_handle =
+        CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) {
+      CloseHandle(file_handle);
+      LOG(FATAL_THROW) << "Could not create file mapping for " << path;
+    }
+    const void* data =
+        MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, num_bytes);
+    if (data == nullptr) {
+      CloseHandle(mapping_handle);
+      CloseHandle(file_handle);
+      LOG(FATAL_THROW) << "Could not map view of " << path;
+    }
+    mapping_handle_ = mapping_handle;
+    data_ = static_cast<const char*>(data);
+  }
+  file_handle_ = file_handle;
+#else
+  if (num_bytes > 0) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    THROW_CHECK_GE(fd, 0) << "Could not open " << path
+                          << " for memory mapping.";
+    void* data = mmap(nullptr, num_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps a reference to the file, so the descriptor is no
+    // longer needed.
+    close(fd);
+    THROW_CHECK(data != MAP_FAILED) << "Could not memory map " << path;
+    data_ = static_cast<const char*>(data);
+  }
+#endif
+
+  size_ = num_bytes;
+  is_mapped_ = true;
+}
+
+void MemoryMappedFile::Unmap() {
+  if (!is_mapped_) {
+    return;
+  }
+#ifdef _WIN32
+  if (data_ != nullptr) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_handle_ != nullptr) {
+    CloseHandle(mapping_handle_);
+    mapping_handle_ = nullptr;
+  }
+  if (file_handle_ != nullptr) {
+    CloseHandle(file_handle_);
+    file_handle_ = nullptr;
+  }
+#else
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  is_mapped_ = false;
+}
+
 std::vector<std::string> ReadTextFileLines(const std::filesystem::path& path) {
   std::ifstream file(path);
   THROW_CHECK_FILE_OPEN(file, path);
@@ -305,6 +412,39 @@ bool IsURI(const std::string& uri) {
          StringStartsWith(uri, "https://") || StringStartsWith(uri, "file://");
 }
 
+namespace {
+
+constexpr uint64_t kFNV1aOffsetBasis = 0xcbf29ce484222325;
+constexpr uint64_t kFNV1aPrime = 0x100000001b3;
+
+uint64_t UpdateFNV1aHash(uint64_t hash, const char* data, size_t num_bytes) {
+  for (size_t i = 0; i < num_bytes; ++i) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= kFNV1aPrime;
+  }
+  return hash;
+}
+
+}  // namespace
+
+uint64_t ComputeFNV1aHash(const std::string_view& data) {
+  return UpdateFNV1aHash(kFNV1aOffsetBasis, data.data(), data.size());
+}
+
+uint64_t ComputeFileFNV1aHash(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  THROW_CHECK_FILE_OPEN(file, path);
+  constexpr size_t kChunkSize = 1 << 20;
+  std::vector<char> chunk(kChunkSize);
+  uint64_t hash = kFNV1aOffsetBasis;
+  while (file) {
+    file.read(chunk.data(), kChunkSize);
+    hash = UpdateFNV1aHash(hash, chunk.data(), file.gcount());
+  }
+  THROW_CHECK(file.eof()) << "Failed to read file: " << path;
+  return hash;
+}
+
 #ifdef COLMAP_DOWNLOAD_ENABLED
 
 namespace {
@@ -37,6 +37,7 @@
 #include <fstream>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #define THROW_CHECK_FILE_EXISTS(path)                 \
@@ -136,6 +137,9 @@ std::vector<std::filesystem::path> GetRecursiveFileList(
 std::vector<std::filesystem::path> GetDirList(
     const std::filesystem::path& path);
 
+// Gets the value of an environment variable or null if it is not set.
+std::optional<std::string> GetEnvSafe(const char* key);
+
 // Gets current user's home directory from environment variables.
 // Returns null if it cannot be resolved.
 std::optional<std::filesystem::path> HomeDir();
@@ -147,6 +151,39 @@ void ReadBinaryBlob(const std::filesystem::path& path, std::vector<char>* data);
 void WriteBinaryBlob(const std::filesystem::path& path,
                      const span<const char>& data);
 
+// Read-only memory mapping of an entire file. The mapping reflects the size of
+// the file at the time it was mapped, so it must be re-mapped to observe data
+// that was appended to the file afterwards. Empty files are valid and yield a
+// mapping without data.
+class MemoryMappedFile {
+ public:
+  MemoryMappedFile() = default;
+  explicit MemoryMappedFile(const std::filesystem::path& path);
+  ~MemoryMappedFile();
+
+  NON_COPYABLE(MemoryMappedFile)
+
+  MemoryMappedFile(MemoryMappedFile&& other) noexcept;
+  MemoryMappedFile& operator=(MemoryMappedFile&& other) noexcept;
+
+  // Map the file at the given path and unmap any previously mapped file.
+  void Map(const std::filesystem::path& path);
+  void Unmap();
+
+  inline bool IsMapped() const { return is_mapped_; }
+  inline const char* Data() const { return data_; }
+  inline size_t Size() const { return size_; }
+
+ private:
+  bool is_mapped_ = false;
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+#ifdef _WIN32
+  void* file_handle_ = nullptr;
+  void* mapping_handle_ = nullptr;
+#endif
+};
+
 // Read each line of a text file into a separate element. Empty lines are
 // ignored and leading/trailing whitespace is removed.
 std::vector<std::string> ReadTextFileLines(const std::filesystem::path& path);
@@ -155,6 +192,12 @@ std::vector<std::string> ReadTextFileLines(const std::filesystem::path& path);
 // (i.e., starts with http://, https://, file://).
 bool IsURI(const std::string& uri);
 
+// Computes the 64-bit FNV-1a hash of the given data or of the content of the
+// file at the given path. In contrast to SHA256, the hash is not cryptographic
+// but cheap to compute, e.g., to detect modified files.
+uint64_t ComputeFNV1aHash(const std::string_view& data);
+uint64_t ComputeFileFNV1aHash(const std::filesystem::path& path);
+
 #ifdef COLMAP_DOWNLOAD_ENABLED
 
 // Download file from server. Supports any protocol suppported by Curl.
@@ -0,0 +1,260 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/util/file_job_queue.h"
+
+#include "colmap/util/file.h"
+#include "colmap/util/logging.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace colmap {
+namespace {
+
+constexpr char kJobsDir[] = "jobs";
+constexpr char kPendingDir[] = "pending";
+constexpr char kRunningDir[] = "running";
+constexpr char kDoneDir[] = "done";
+constexpr char kFailedDir[] = "failed";
+constexpr const char* kDirs[] = {
+    kJobsDir, kPendingDir, kRunningDir, kDoneDir, kFailedDir};
+
+// Parse the name and attempt of a job from the name of its marker file.
+bool ParseMarkerName(const std::filesystem::path& path,
+                     std::string* name,
+                     int* attempt) {
+  const std::string marker_name = path.filename().string();
+  const size_t dot_pos = marker_name.rfind('.');
+  if (dot_pos == std::string::npos || dot_pos == 0) {
+    return false;
+  }
+  try {
+    *attempt = std::stoi(marker_name.substr(dot_pos + 1));
+  } catch (const std::exception&) {
+    return false;
+  }
+  *name = marker_name.substr(0, dot_pos);
+  return true;
+}
+
+// List the marker files in a state directory sorted by name.
+std::vector<std::filesystem::path> ListMarkers(
+    const std::filesystem::path& path) {
+  std::vector<std::filesystem::path> markers;
+  std::error_code error_code;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(path, error_code)) {
+    if (entry.is_regular_file(error_code)) {
+      markers.push_back(entry.path());
+    }
+  }
+  std::sort(markers.begin(), markers.end());
+  return markers;
+}
+
+bool RenameMarker(const std::filesystem::path& from_path,
+                  const std::filesystem::path& to_path) {
+  std::error_code error_code;
+  std::filesystem::rename(from_path, to_path, error_code);
+  return !error_code;
+}
+
+}  // namespace
+
+bool FileJobQueueOptions::Check() const {
+  CHECK_OPTION_GT(max_num_attempts, 0);
+  CHECK_OPTION_GT(job_timeout, 0);
+  return true;
+}
+
+FileJobQueue::FileJobQueue(const std::filesystem::path& path,
+                           const FileJobQueueOptions& options)
+    : path_(path), options_(options) {
+  THROW_CHECK(options_.Check());
+  for (const char* dir : kDirs) {
+    std::filesystem::create_directories(path_ / dir);
+  }
+}
+
+bool FileJobQueue::IsEmpty() const {
+  for (const char* dir : kDirs) {
+    if (!std::filesystem::is_empty(path_ / dir)) {
+      return false;
+    }
+  }
+  return !IsClosed();
+}
+
+std::filesystem::path FileJobQueue::JobPath(const std::string& name) const {
+  return path_ / kJobsDir / name;
+}
+
+void FileJobQueue::Submit(const std::string& name) {
+  THROW_CHECK(!name.empty());
+  THROW_CHECK_EQ(name.find_first_of("./\\"), std::string::npos)
+      << "Invalid job name: " << name;
+  THROW_CHECK_DIR_EXISTS(JobPath(name));
+  const std::filesystem::path marker_path =
+      StatePath(kPendingDir, name, /*attempt=*/1);
+  THROW_CHECK(!ExistsFile(marker_path)) << "Duplicate job: " << name;
+  std::ofstream file(marker_path);
+  THROW_CHECK_FILE_OPEN(file, marker_path);
+}
+
+FileJobQueue::Status FileJobQueue::Update() {
+  const auto now = std::chrono::steady_clock::now();
+  const auto job_timeout = std::chrono::duration_cast<
+      std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(options_.job_timeout));
+
+  // Move the running jobs without recent heartbeat to the failed jobs.
+  std::unordered_map<std::string, HeartbeatObservation> heartbeats;
+  for (const auto& marker_path : ListMarkers(path_ / kRunningDir)) {
+    const std::string marker_name = marker_path.filename().string();
+    std::error_code error_code;
+    const auto write_time =
+        std::filesystem::last_write_time(marker_path, error_code);
+    if (error_code) {
+      // The job was finished or failed in the meantime.
+      continue;
+    }
+    HeartbeatObservation heartbeat{write_time, now};
+    if (const auto it = heartbeats_.find(marker_name);
+        it != heartbeats_.end() && it->second.write_time == write_time) {
+      heartbeat.observe_time = it->second.observe_time;
+    }
+    if (now - heartbeat.observe_time > job_timeout) {
+      LOG(WARNING) << "Job " << marker_name << " timed out";
+      RenameMarker(marker_path, path_ / kFailedDir / marker_name);
+      continue;
+    }
+    heartbeats.emplace(marker_name, heartbeat);
+  }
+  heartbeats_ = std::move(heartbeats);
+
+  // Retry the failed jobs until the maximum number of attempts.
+  Status status;
+  for (const auto& marker_path : ListMarkers(path_ / kFailedDir)) {
+    std::string name;
+    int attempt = 0;
+    if (!ParseMarkerName(marker_path, &name, &attempt)) {
+      continue;
+    }
+    if (attempt < options_.max_num_attempts) {
+      LOG(WARNING) << "Retrying job " << name << " (attempt " << attempt + 1
+                   << " of " << options_.max_num_attempts << ")";
+      RenameMarker(marker_path, StatePath(kPendingDir, name, attempt + 1));
+    } else {
+      status.num_abandoned += 1;
+    }
+  }
+
+  status.num_pending = ListMarkers(path_ / kPendingDir).size();
+  status.num_running = ListMarkers(path_ / kRunningDir).size();
+  status.num_done = ListMarkers(path_ / kDoneDir).size();
+  return status;
+}
+
+std::vector<FileJobQueue::Job> FileJobQueue::DoneJobs() const {
+  std::vector<Job> jobs;
+  for (const auto& marker_path : ListMarkers(path_ / kDoneDir)) {
+    std::string name;
+    int attempt = 0;
+    if (ParseMarkerName(marker_path, &name, &attempt)) {
+      jobs.push_back(MakeJob(name, attempt));
+    }
+  }
+  return jobs;
+}
+
+void FileJobQueue::Close() {
+  const std::filesystem::path closed_path = path_ / "closed";
+  std::ofstream file(closed_path);
+  THROW_CHECK_FILE_OPEN(file, closed_path);
+}
+
+bool FileJobQueue::IsClosed() const { return ExistsFile(path_ / "closed"); }
+
+std::optional<FileJobQueue::Job> FileJobQueue::Claim() {
+  for (const auto& marker_path : ListMarkers(path_ / kPendingDir)) {
+    std::string name;
+    int attempt = 0;
+    if (!ParseMarkerName(marker_path, &name, &attempt)) {
+      continue;
+    }
+    // Only one of the concurrently claiming workers succeeds to rename.
+    if (!RenameMarker(marker_path, StatePath(kRunningDir, name, attempt))) {
+      continue;
+    }
+    Job job = MakeJob(name, attempt);
+    Heartbeat(job);
+    std::filesystem::create_directories(job.output_path);
+    return job;
+  }
+  return std::nullopt;
+}
+
+bool FileJobQueue::Heartbeat(const Job& job) {
+  std::error_code error_code;
+  std::filesystem::last_write_time(
+      StatePath(kRunningDir, job.name, job.attempt),
+      std::filesystem::file_time_type::clock::now(),
+      error_code);
+  return !error_code;
+}
+
+bool FileJobQueue::Finish(const Job& job) {
+  return RenameMarker(StatePath(kRunningDir, job.name, job.attempt),
+                      StatePath(kDoneDir, job.name, job.attempt));
+}
+
+bool FileJobQueue::Fail(const Job& job) {
+  return RenameMarker(StatePath(kRunningDir, job.name, job.attempt),
+                      StatePath(kFailedDir, job.name, job.attempt));
+}
+
+std::filesystem::path FileJobQueue::StatePath(const std::string& state,
+                                              const std::string& name,
+                                              const int attempt) const {
+  return path_ / state / (name + "." + std::to_string(attempt));
+}
+
+FileJobQueue::Job FileJobQueue::MakeJob(const std::string& name,
+                                        const int attempt) const {
+  Job job;
+  job.name = name;
+  job.attempt = attempt;
+  job.path = JobPath(name);
+  job.output_path = job.path / ("attempt" + std::to_string(attempt));
+  return job;
+}
+
+}  // namespace colmap
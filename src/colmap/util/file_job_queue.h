@@ -0,0 +1,142 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace colmap {
+
+struct FileJobQueueOptions {
+  // The maximum number of attempts to run a job before it is abandoned.
+  int max_num_attempts = 3;
+
+  // The time in seconds after which a running job without a heartbeat of
+  // its worker is considered lost and retried.
+  double job_timeout = 300;
+
+  bool Check() const;
+};
+
+// A job queue on a shared file system, through which a coordinator hands out
+// jobs to workers in other processes or on other machines. The state of each
+// job is represented by a marker file in a subdirectory of the queue and all
+// state transitions are atomic renames of the marker file, such that every
+// attempt of a job is claimed by at most one worker without any locking.
+// Failed jobs and jobs whose worker stopped sending heartbeats are retried
+// until the maximum number of attempts is reached.
+class FileJobQueue {
+ public:
+  struct Job {
+    std::string name;
+
+    // The attempt of running the job, starting at 1.
+    int attempt = 0;
+
+    // The directory with the inputs of the job.
+    std::filesystem::path path;
+
+    // The directory into which the worker writes the outputs of the attempt.
+    std::filesystem::path output_path;
+  };
+
+  struct Status {
+    size_t num_pending = 0;
+    size_t num_running = 0;
+    size_t num_done = 0;
+    size_t num_abandoned = 0;
+
+    inline bool IsFinished() const {
+      return num_pending == 0 && num_running == 0;
+    }
+  };
+
+  explicit FileJobQueue(const std::filesystem::path& path,
+                        const FileJobQueueOptions& options =
+                            FileJobQueueOptions());
+
+  // Whether no job was submitted and the queue was not closed yet.
+  bool IsEmpty() const;
+
+  // Directory for the inputs of a job, which must be written before the job
+  // is submitted. The name of the job must not contain dots or slashes.
+  std::filesystem::path JobPath(const std::string& name) const;
+
+  // Make the job available to the workers.
+  void Submit(const std::string& name);
+
+  // Retry failed and lost jobs and return the status of all jobs. Must be
+  // called periodically by the coordinator to detect lost jobs.
+  Status Update();
+
+  // The successfully finished jobs with their outputs.
+  std::vector<Job> DoneJobs() const;
+
+  // Signal the workers that no more jobs will be submitted.
+  void Close();
+  bool IsClosed() const;
+
+  // Claim the next pending job or return null if there is none.
+  std::optional<Job> Claim();
+
+  // Signal that the worker of a claimed job is still alive. Returns false if
+  // the job was lost, e.g., because a heartbeat was missed.
+  bool Heartbeat(const Job& job);
+
+  // Mark a claimed job as done or failed. Returns false if the job was lost,
+  // in which case its outputs are ignored.
+  bool Finish(const Job& job);
+  bool Fail(const Job& job);
+
+ private:
+  std::filesystem::path StatePath(const std::string& state,
+                                  const std::string& name,
+                                  int attempt) const;
+  Job MakeJob(const std::string& name, int attempt) const;
+
+  const std::filesystem::path path_;
+  const FileJobQueueOptions options_;
+
+  struct HeartbeatObservation {
+    std::filesystem::file_time_type write_time;
+    std::chrono::steady_clock::time_point observe_time;
+  };
+
+  // The last change of the heartbeat of the running jobs, as observed on the
+  // clock of the coordinator to be robust to clock skew between machines.
+  std::unordered_map<std::string, HeartbeatObservation> heartbeats_;
+};
+
+}  // namespace colmap
@@ -0,0 +1,159 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/util/file_job_queue.h"
+
+#include "colmap/util/file.h"
+#include "colmap/util/testing.h"
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+void SubmitJob(FileJobQueue* queue, const std::string& name) {
+  std::filesystem::create_directories(queue->JobPath(name));
+  queue->Submit(name);
+}
+
+TEST(FileJobQueue, Nominal) {
+  const std::filesystem::path test_dir = CreateTestDir();
+  FileJobQueue coordinator(test_dir);
+  EXPECT_TRUE(coordinator.IsEmpty());
+  SubmitJob(&coordinator, "job1");
+  EXPECT_FALSE(coordinator.IsEmpty());
+  SubmitJob(&coordinator, "job2");
+  EXPECT_ANY_THROW(SubmitJob(&coordinator, "job1"));
+  EXPECT_ANY_THROW(SubmitJob(&coordinator, "job.3"));
+
+  FileJobQueue::Status status = coordinator.Update();
+  EXPECT_EQ(status.num_pending, 2);
+  EXPECT_EQ(status.num_running, 0);
+  EXPECT_FALSE(status.IsFinished());
+
+  FileJobQueue worker(test_dir);
+  EXPECT_FALSE(worker.IsClosed());
+  const std::optional<FileJobQueue::Job> job1 = worker.Claim();
+  ASSERT_TRUE(job1.has_value());
+  EXPECT_EQ(job1->name, "job1");
+  EXPECT_EQ(job1->attempt, 1);
+  EXPECT_EQ(job1->path, coordinator.JobPath("job1"));
+  EXPECT_TRUE(ExistsDir(job1->output_path));
+  const std::optional<FileJobQueue::Job> job2 = worker.Claim();
+  ASSERT_TRUE(job2.has_value());
+  EXPECT_EQ(job2->name, "job2");
+  EXPECT_FALSE(worker.Claim().has_value());
+
+  status = coordinator.Update();
+  EXPECT_EQ(status.num_pending, 0);
+  EXPECT_EQ(status.num_running, 2);
+
+  EXPECT_TRUE(worker.Heartbeat(*job1));
+  EXPECT_TRUE(worker.Finish(*job1));
+  EXPECT_FALSE(worker.Heartbeat(*job1));
+  EXPECT_FALSE(worker.Finish(*job1));
+  EXPECT_TRUE(worker.Finish(*job2));
+
+  status = coordinator.Update();
+  EXPECT_EQ(status.num_done, 2);
+  EXPECT_EQ(status.num_abandoned, 0);
+  EXPECT_TRUE(status.IsFinished());
+  const std::vector<FileJobQueue::Job> done_jobs = coordinator.DoneJobs();
+  ASSERT_EQ(done_jobs.size(), 2);
+  EXPECT_EQ(done_jobs[0].name, "job1");
+  EXPECT_EQ(done_jobs[0].output_path, job1->output_path);
+  EXPECT_EQ(done_jobs[1].name, "job2");
+
+  coordinator.Close();
+  EXPECT_TRUE(worker.IsClosed());
+}
+
+TEST(FileJobQueue, RetryFailed) {
+  const std::filesystem::path test_dir = CreateTestDir();
+  FileJobQueueOptions options;
+  options.max_num_attempts = 2;
+  FileJobQueue coordinator(test_dir, options);
+  SubmitJob(&coordinator, "job");
+
+  FileJobQueue worker(test_dir);
+  std::optional<FileJobQueue::Job> job = worker.Claim();
+  ASSERT_TRUE(job.has_value());
+  EXPECT_TRUE(worker.Fail(*job));
+
+  FileJobQueue::Status status = coordinator.Update();
+  EXPECT_EQ(status.num_pending, 1);
+  EXPECT_EQ(status.num_abandoned, 0);
+
+  job = worker.Claim();
+  ASSERT_TRUE(job.has_value());
+  EXPECT_EQ(job->attempt, 2);
+  EXPECT_TRUE(worker.Fail(*job));
+
+  status = coordinator.Update();
+  EXPECT_EQ(status.num_pending, 0);
+  EXPECT_EQ(status.num_abandoned, 1);
+  EXPECT_TRUE(status.IsFinished());
+  EXPECT_TRUE(coordinator.DoneJobs().empty());
+}
+
+TEST(FileJobQueue, RetryTimedOut) {
+  const std::filesystem::path test_dir = CreateTestDir();
+  FileJobQueueOptions options;
+  options.job_timeout = 0.01;
+  FileJobQueue coordinator(test_dir, options);
+  SubmitJob(&coordinator, "job");
+
+  FileJobQueue worker(test_dir);
+  const std::optional<FileJobQueue::Job> lost_job = worker.Claim();
+  ASSERT_TRUE(lost_job.has_value());
+
+  EXPECT_EQ(coordinator.Update().num_running, 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  const FileJobQueue::Status status = coordinator.Update();
+  EXPECT_EQ(status.num_running, 0);
+  EXPECT_EQ(status.num_pending, 1);
+
+  // The outputs of the lost attempt are ignored.
+  EXPECT_FALSE(worker.Heartbeat(*lost_job));
+  EXPECT_FALSE(worker.Finish(*lost_job));
+
+  const std::optional<FileJobQueue::Job> job = worker.Claim();
+  ASSERT_TRUE(job.has_value());
+  EXPECT_EQ(job->attempt, 2);
+  EXPECT_NE(job->output_path, lost_job->output_path);
+  EXPECT_TRUE(worker.Finish(*job));
+  EXPECT_EQ(coordinator.DoneJobs().size(), 1);
+}
+
+}  // namespace
+}  // namespace colmap
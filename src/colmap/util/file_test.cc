@@ -266,6 +266,42 @@ TEST(ReadWriteBinaryBlob, Nominal) {
   EXPECT_EQ(read_data, data);
 }
 
+TEST(MemoryMappedFile, Nominal) {
+  const auto file_path = CreateTestDir() / "test.bin";
+  const int kNumBytes = 123;
+  std::vector<char> data(kNumBytes);
+  for (int i = 0; i < kNumBytes; ++i) {
+    data[i] = (i * 100 + 4 + i) % 256;
+  }
+  WriteBinaryBlob(file_path, {data.data(), data.size()});
+
+  MemoryMappedFile mapped_file;
+  EXPECT_FALSE(mapped_file.IsMapped());
+  mapped_file.Map(file_path);
+  EXPECT_TRUE(mapped_file.IsMapped());
+  ASSERT_EQ(mapped_file.Size(), kNumBytes);
+  EXPECT_EQ(std::memcmp(mapped_file.Data(), data.data(), kNumBytes), 0);
+
+  MemoryMappedFile moved_mapped_file = std::move(mapped_file);
+  EXPECT_FALSE(mapped_file.IsMapped());
+  EXPECT_TRUE(moved_mapped_file.IsMapped());
+  EXPECT_EQ(moved_mapped_file.Size(), kNumBytes);
+
+  moved_mapped_file.Unmap();
+  EXPECT_FALSE(moved_mapped_file.IsMapped());
+  EXPECT_EQ(moved_mapped_file.Data(), nullptr);
+  EXPECT_EQ(moved_mapped_file.Size(), 0);
+}
+
+TEST(MemoryMappedFile, Empty) {
+  const auto file_path = CreateTestDir() / "test.bin";
+  WriteBinaryBlob(file_path, {nullptr, 0});
+  MemoryMappedFile mapped_file(file_path);
+  EXPECT_TRUE(mapped_file.IsMapped());
+  EXPECT_EQ(mapped_file.Size(), 0);
+  EXPECT_ANY_THROW(mapped_file.Map(file_path.parent_path() / "missing.bin"));
+}
+
 TEST(IsURI, Nominal) {
   EXPECT_FALSE(IsURI(""));
   EXPECT_TRUE(IsURI("http://"));
@@ -279,6 +315,28 @@ TEST(IsURI, Nominal) {
   EXPECT_FALSE(IsURI("file"));
 }
 
+TEST(ComputeFNV1aHash, Nominal) {
+  EXPECT_EQ(ComputeFNV1aHash(""), 0xcbf29ce484222325);
+  EXPECT_EQ(ComputeFNV1aHash("a"), 0xaf63dc4c8601ec8c);
+  EXPECT_EQ(ComputeFNV1aHash("foobar"), 0x85944171f73967e8);
+}
+
+TEST(ComputeFileFNV1aHash, Nominal) {
+  const auto file_path = CreateTestDir() / "test.bin";
+  // Larger than the internal chunk size to test hashing across chunks.
+  std::string data(3 * (1 << 20) + 17, 0);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (i * 100 + 4 + i) % 256;
+  }
+  WriteBinaryBlob(file_path, {data.data(), data.size()});
+  EXPECT_EQ(ComputeFileFNV1aHash(file_path), ComputeFNV1aHash(data));
+
+  WriteBinaryBlob(file_path, {nullptr, 0});
+  EXPECT_EQ(ComputeFileFNV1aHash(file_path), ComputeFNV1aHash(""));
+
+  EXPECT_ANY_THROW(ComputeFileFNV1aHash(file_path.parent_path() / "missing"));
+}
+
 #ifdef COLMAP_DOWNLOAD_ENABLED
 
 TEST(DownloadFile, Nominal) {
@@ -0,0 +1,259 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/util/metrics.h"
+
+#include "colmap/util/logging.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace colmap {
+namespace {
+
+struct MetricFn {
+  std::string name;
+  MetricType type;
+  std::function<double()> fn;
+};
+
+struct MetricsRegistry {
+  std::mutex values_mutex;
+  std::map<std::string, double> counters;
+  std::map<std::string, double> gauges;
+
+  // Separate from the values mutex, so that the metric functions can be
+  // evaluated while other threads update counters or gauges.
+  std::mutex fns_mutex;
+  size_t next_fn_id = 0;
+  std::map<size_t, MetricFn> fns;
+};
+
+MetricsRegistry& GetMetricsRegistry() {
+  static MetricsRegistry registry;
+  return registry;
+}
+
+// Returns the name without labels, e.g., `name` for `name{label="value"}`.
+std::string MetricBaseName(const std::string& name) {
+  return name.substr(0, name.find('{'));
+}
+
+const char* MetricTypeToString(const MetricType type) {
+  switch (type) {
+    case MetricType::kCounter:
+      return "counter";
+    case MetricType::kGauge:
+      return "gauge";
+  }
+  return "untyped";
+}
+
+}  // namespace
+
+void IncrementMetricCounter(const std::string& name, const double delta) {
+  MetricsRegistry& registry = GetMetricsRegistry();
+  std::lock_guard<std::mutex> lock(registry.values_mutex);
+  registry.counters[name] += delta;
+}
+
+void SetMetricGauge(const std::string& name, const double value) {
+  MetricsRegistry& registry = GetMetricsRegistry();
+  std::lock_guard<std::mutex> lock(registry.values_mutex);
+  registry.gauges[name] = value;
+}
+
+ScopedMetricFn::ScopedMetricFn(std::string name,
+                               const MetricType type,
+                               std::function<double()> fn) {
+  THROW_CHECK_NOTNULL(fn);
+  MetricsRegistry& registry = GetMetricsRegistry();
+  std::lock_guard<std::mutex> lock(registry.fns_mutex);
+  id_ = registry.next_fn_id++;
+  registry.fns.emplace(id_, MetricFn{std::move(name), type, std::move(fn)});
+}
+
+ScopedMetricFn::~ScopedMetricFn() {
+  MetricsRegistry& registry = GetMetricsRegistry();
+  std::lock_guard<std::mutex> lock(registry.fns_mutex);
+  registry.fns.erase(id_);
+}
+
+double GetMetricValue(const std::string& name) {
+  MetricsRegistry& registry = GetMetricsRegistry();
+  double value = 0;
+  {
+    std::lock_guard<std::mutex> lock(registry.fns_mutex);
+    for (const auto& [_, metric_fn] : registry.fns) {
+      if (metric_fn.name == name) {
+        value += metric_fn.fn();
+      }
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(registry.values_mutex);
+    if (const auto it = registry.counters.find(name);
+        it != registry.counters.end()) {
+      value += it->second;
+    }
+    if (const auto it = registry.gauges.find(name);
+        it != registry.gauges.end()) {
+      value += it->second;
+    }
+  }
+  return value;
+}
+
+double SumMetricValues(const std::string& base_name) {
+  const auto HasBaseName = [&base_name](const std::string& name) {
+    return name.compare(0, base_name.size(), base_name) == 0 &&
+           (name.size() == base_name.size() || name[base_name.size()] == '{');
+  };
+
+  MetricsRegistry& registry = GetMetricsRegistry();
+  double value = 0;
+  {
+    std::lock_guard<std::mutex> lock(registry.fns_mutex);
+    for (const auto& [_, metric_fn] : registry.fns) {
+      if (HasBaseName(metric_fn.name)) {
+        value += metric_fn.fn();
+      }
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(registry.values_mutex);
+    for (const auto& [name, counter] : registry.counters) {
+      if (HasBaseName(name)) {
+        value += counter;
+      }
+    }
+    for (const auto& [name, gauge] : registry.gauges) {
+      if (HasBaseName(name)) {
+        value += gauge;
+      }
+    }
+  }
+  return value;
+}
+
+void ClearMetrics() {
+  MetricsRegistry& registry = GetMetricsRegistry();
+  std::lock_guard<std::mutex> lock(registry.values_mutex);
+  registry.counters.clear();
+  registry.gauges.clear();
+}
+
+std::string FormatMetrics() {
+  // Samples grouped by their base name, such that all samples of a metric
+  // follow its type line.
+  std::map<std::pair<std::string, std::string>, std::pair<MetricType, double>>
+      samples;
+  const auto AddSample =
+      [&samples](const std::string& name, MetricType type, double value) {
+        auto& sample = samples[std::make_pair(MetricBaseName(name), name)];
+        sample.first = type;
+        sample.second += value;
+      };
+
+  MetricsRegistry& registry = GetMetricsRegistry();
+  {
+    std::lock_guard<std::mutex> lock(registry.fns_mutex);
+    for (const auto& [_, metric_fn] : registry.fns) {
+      AddSample(metric_fn.name, metric_fn.type, metric_fn.fn());
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(registry.values_mutex);
+    for (const auto& [name, value] : registry.counters) {
+      AddSample(name, MetricType::kCounter, value);
+    }
+    for (const auto& [name, value] : registry.gauges) {
+      AddSample(name, MetricType::kGauge, value);
+    }
+  }
+
+  std::ostringstream stream;
+  stream << std::setprecision(15);
+  const std::string* prev_base_name = nullptr;
+  for (const auto& [names, sample] : samples) {
+    const auto& [base_name, name] = names;
+    if (prev_base_name == nullptr || *prev_base_name != base_name) {
+      stream << "# TYPE " << base_name << " "
+             << MetricTypeToString(sample.first) << "\n";
+      prev_base_name = &base_name;
+    }
+    stream << name << " " << sample.second << "\n";
+  }
+  return stream.str();
+}
+
+void WriteMetrics(const std::filesystem::path& path) {
+  const std::string metrics = FormatMetrics();
+  std::filesystem::path tmp_path = path;
+  tmp_path += ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::trunc);
+    THROW_CHECK_FILE_OPEN(file, tmp_path);
+    file << metrics;
+    THROW_CHECK(file.good()) << "Failed to write metrics to " << tmp_path;
+  }
+  std::filesystem::rename(tmp_path, path);
+}
+
+MetricsWriterThread::MetricsWriterThread(std::filesystem::path path,
+                                         const double interval_seconds)
+    : path_(std::move(path)), interval_seconds_(interval_seconds) {
+  THROW_CHECK_GT(interval_seconds_, 0);
+}
+
+void MetricsWriterThread::Run() {
+  // Poll the stopped state at a finer granularity than the interval, so that
+  // stopping the thread does not block for a full interval.
+  constexpr double kMaxSleepSeconds = 0.1;
+  while (!IsStopped()) {
+    WriteMetrics(path_);
+    Timer timer;
+    timer.Start();
+    while (!IsStopped() && timer.ElapsedSeconds() < interval_seconds_) {
+      std::this_thread::sleep_for(std::chrono::duration<double>(
+          std::min(kMaxSleepSeconds,
+                   interval_seconds_ - timer.ElapsedSeconds())));
+    }
+  }
+  WriteMetrics(path_);
+}
+
+}  // namespace colmap
@@ -0,0 +1,115 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "colmap/util/threading.h"
+#include "colmap/util/types.h"
+
+#include <filesystem>
+#include <functional>
+#include <string>
+
+namespace colmap {
+
+// Process-wide registry of metrics for monitoring long-running commands, which
+// are exported in the Prometheus text format. Metric names may contain labels,
+// e.g., `colmap_job_queue_size{queue="matcher"}`. Rates, such as the number of
+// processed items per second, are derived from counters by the consumer.
+//
+// Example usage:
+//
+//    IncrementMetricCounter("colmap_processed_images_total");
+//
+//    ScopedMetricFn queue_size_metric(
+//        "colmap_job_queue_size{queue=\"reader\"}",
+//        MetricType::kGauge,
+//        [&queue]() { return queue.Size(); });
+//
+enum class MetricType {
+  kCounter,
+  kGauge,
+};
+
+// Add to the value of a monotonically increasing counter.
+void IncrementMetricCounter(const std::string& name, double delta = 1);
+
+// Set the current value of a gauge.
+void SetMetricGauge(const std::string& name, double value);
+
+// Registers a function that is evaluated whenever the metrics are exported,
+// e.g., to report the current size of a queue or the hits of a cache. The
+// values of functions with the same name are summed, such that multiple
+// instances of a class can report the same metric. The function is
+// unregistered on destruction. It is called from the exporting thread and must
+// not register or unregister metric functions itself.
+class ScopedMetricFn {
+ public:
+  ScopedMetricFn(std::string name, MetricType type, std::function<double()> fn);
+  ~ScopedMetricFn();
+
+ private:
+  NON_COPYABLE(ScopedMetricFn)
+  NON_MOVABLE(ScopedMetricFn)
+
+  size_t id_;
+};
+
+// Get the current value of a metric including the registered functions.
+// Returns zero for unknown metrics.
+double GetMetricValue(const std::string& name);
+
+// Get the summed values of all metrics with the given name regardless of their
+// labels, e.g., "bytes" sums "bytes{a=\"1\"}" and "bytes{a=\"2\"}".
+double SumMetricValues(const std::string& base_name);
+
+// Reset all counters and gauges. Registered functions are kept.
+void ClearMetrics();
+
+// Format all metrics in the Prometheus text exposition format.
+std::string FormatMetrics();
+
+// Write the metrics to a file, which is atomically replaced, e.g., for the
+// textfile collector of the Prometheus node exporter.
+void WriteMetrics(const std::filesystem::path& path);
+
+// Thread that periodically writes the metrics to a file until it is stopped,
+// after which the final metrics are written.
+class MetricsWriterThread : public Thread {
+ public:
+  MetricsWriterThread(std::filesystem::path path, double interval_seconds);
+
+ private:
+  void Run() override;
+
+  const std::filesystem::path path_;
+  const double interval_seconds_;
+};
+
+}  // namespace colmap
@@ -0,0 +1,144 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/util/metrics.h"
+
+#include "colmap/util/testing.h"
+
+#include <fstream>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+std::string ReadFile(const std::filesystem::path& path) {
+  std::ifstream file(path);
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  return buffer.str();
+}
+
+TEST(Metrics, Counter) {
+  ClearMetrics();
+  EXPECT_EQ(GetMetricValue("test_counter_total"), 0);
+  IncrementMetricCounter("test_counter_total");
+  IncrementMetricCounter("test_counter_total", 2);
+  EXPECT_EQ(GetMetricValue("test_counter_total"), 3);
+  EXPECT_EQ(FormatMetrics(),
+            "# TYPE test_counter_total counter\n"
+            "test_counter_total 3\n");
+  ClearMetrics();
+  EXPECT_EQ(GetMetricValue("test_counter_total"), 0);
+  EXPECT_EQ(FormatMetrics(), "");
+}
+
+TEST(Metrics, Gauge) {
+  ClearMetrics();
+  SetMetricGauge("test_gauge", 1.5);
+  SetMetricGauge("test_gauge", 2.5);
+  EXPECT_EQ(GetMetricValue("test_gauge"), 2.5);
+  EXPECT_EQ(FormatMetrics(),
+            "# TYPE test_gauge gauge\n"
+            "test_gauge 2.5\n");
+  ClearMetrics();
+}
+
+TEST(Metrics, Labels) {
+  ClearMetrics();
+  SetMetricGauge("test_gauge{queue=\"b\"}", 2);
+  SetMetricGauge("test_gauge_other", 3);
+  SetMetricGauge("test_gauge{queue=\"a\"}", 1);
+  EXPECT_EQ(FormatMetrics(),
+            "# TYPE test_gauge gauge\n"
+            "test_gauge{queue=\"a\"} 1\n"
+            "test_gauge{queue=\"b\"} 2\n"
+            "# TYPE test_gauge_other gauge\n"
+            "test_gauge_other 3\n");
+  EXPECT_EQ(SumMetricValues("test_gauge"), 3);
+  EXPECT_EQ(SumMetricValues("test_gauge_other"), 3);
+  EXPECT_EQ(SumMetricValues("test_gauge_"), 0);
+  ClearMetrics();
+}
+
+TEST(Metrics, ScopedMetricFn) {
+  ClearMetrics();
+  int value1 = 1;
+  int value2 = 2;
+  {
+    ScopedMetricFn metric_fn1(
+        "test_fn", MetricType::kGauge, [&value1]() { return value1; });
+    EXPECT_EQ(GetMetricValue("test_fn"), 1);
+    value1 = 3;
+    EXPECT_EQ(GetMetricValue("test_fn"), 3);
+    {
+      ScopedMetricFn metric_fn2(
+          "test_fn", MetricType::kGauge, [&value2]() { return value2; });
+      EXPECT_EQ(GetMetricValue("test_fn"), 5);
+      EXPECT_EQ(FormatMetrics(),
+                "# TYPE test_fn gauge\n"
+                "test_fn 5\n");
+    }
+    EXPECT_EQ(GetMetricValue("test_fn"), 3);
+  }
+  EXPECT_EQ(GetMetricValue("test_fn"), 0);
+  EXPECT_EQ(FormatMetrics(), "");
+}
+
+TEST(Metrics, WriteMetrics) {
+  ClearMetrics();
+  IncrementMetricCounter("test_counter_total", 1234567);
+  const auto path = CreateTestDir() / "metrics.prom";
+  WriteMetrics(path);
+  EXPECT_EQ(ReadFile(path),
+            "# TYPE test_counter_total counter\n"
+            "test_counter_total 1234567\n");
+  EXPECT_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+  ClearMetrics();
+}
+
+TEST(Metrics, MetricsWriterThread) {
+  ClearMetrics();
+  const auto path = CreateTestDir() / "metrics.prom";
+  MetricsWriterThread writer(path, /*interval_seconds=*/100);
+  writer.Start();
+  IncrementMetricCounter("test_counter_total");
+  writer.Stop();
+  writer.Wait();
+  // The final metrics are written after stopping.
+  EXPECT_EQ(ReadFile(path),
+            "# TYPE test_counter_total counter\n"
+            "test_counter_total 1\n");
+  EXPECT_ANY_THROW(MetricsWriterThread(path, /*interval_seconds=*/0));
+  ClearMetrics();
+}
+
+}  // namespace
+}  // namespace colmap
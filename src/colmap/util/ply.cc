@@ -430,6 +430,70 @@ void WriteBinaryPlyPoints(const std::filesystem::path& path,
   binary_file.close();
 }
 
+BinaryPlyPointsWriter::BinaryPlyPointsWriter(
+    const std::filesystem::path& path,
+    const bool write_normal,
+    const bool write_rgb)
+    : write_normal_(write_normal),
+      write_rgb_(write_rgb),
+      file_(path,
+            std::ios::in | std::ios::out | std::ios::binary |
+                std::ios::trunc) {
+  THROW_CHECK_FILE_OPEN(file_, path);
+
+  file_ << "ply\n";
+  file_ << "format binary_little_endian 1.0\n";
+  file_ << "element vertex ";
+  num_points_pos_ = file_.tellp();
+  file_ << StringPrintf("%020zu", num_points_) << '\n';
+
+  file_ << "property float x\n";
+  file_ << "property float y\n";
+  file_ << "property float z\n";
+
+  if (write_normal_) {
+    file_ << "property float nx\n";
+    file_ << "property float ny\n";
+    file_ << "property float nz\n";
+  }
+
+  if (write_rgb_) {
+    file_ << "property uchar red\n";
+    file_ << "property uchar green\n";
+    file_ << "property uchar blue\n";
+  }
+
+  file_ << "end_header\n";
+  file_.flush();
+}
+
+void BinaryPlyPointsWriter::Write(const std::vector<PlyPoint>& points) {
+  file_.seekp(0, std::ios::end);
+  for (const auto& point : points) {
+    WriteBinaryLittleEndian<float>(&file_, point.x);
+    WriteBinaryLittleEndian<float>(&file_, point.y);
+    WriteBinaryLittleEndian<float>(&file_, point.z);
+
+    if (write_normal_) {
+      WriteBinaryLittleEndian<float>(&file_, point.nx);
+      WriteBinaryLittleEndian<float>(&file_, point.ny);
+      WriteBinaryLittleEndian<float>(&file_, point.nz);
+    }
+
+    if (write_rgb_) {
+      WriteBinaryLittleEndian<uint8_t>(&file_, point.r);
+      WriteBinaryLittleEndian<uint8_t>(&file_, point.g);
+      WriteBinaryLittleEndian<uint8_t>(&file_, point.b);
+    }
+  }
+
+  num_points_ += points.size();
+  file_.seekp(num_points_pos_);
+  file_ << StringPrintf("%020zu", num_points_);
+  file_.flush();
+  THROW_CHECK(file_.good());
+}
+
 PlyTexturedMesh ReadPlyMesh(const std::filesystem::path& path) {
   std::ifstream file(path, std::ios::binary);
   THROW_CHECK_FILE_OPEN(file, path);
@@ -776,7 +840,8 @@ PlyTexturedMesh ReadPlyMesh(const std::filesystem::path& path) {
 }
 
 void WriteTextPlyMesh(const std::filesystem::path& path,
-                      const PlyTexturedMesh& mesh) {
+                      const PlyTexturedMesh& mesh,
+                      const bool write_rgb) {
   std::fstream file(path, std::ios::out);
   THROW_CHECK_FILE_OPEN(file, path);
   file.imbue(std::locale::classic());
@@ -796,6 +861,11 @@ void WriteTextPlyMesh(const std::filesystem::path& path,
   file << "property float x\n";
   file << "property float y\n";
   file << "property float z\n";
+  if (write_rgb) {
+    file << "property uchar red\n";
+    file << "property uchar green\n";
+    file << "property uchar blue\n";
+  }
   file << "element face " << mesh.mesh.faces.size() << '\n';
   if (has_texcoords) {
     file << "property list uchar int vertex_indices\n";
@@ -806,7 +876,12 @@ void WriteTextPlyMesh(const std::filesystem::path& path,
   file << "end_header\n";
 
   for (const auto& vertex : mesh.mesh.vertices) {
-    file << vertex.x << " " << vertex.y << " " << vertex.z << '\n';
+    file << vertex.x << " " << vertex.y << " " << vertex.z;
+    if (write_rgb) {
+      file << " " << static_cast<int>(vertex.r) << " "
+           << static_cast<int>(vertex.g) << " " << static_cast<int>(vertex.b);
+    }
+    file << '\n';
   }
 
   for (size_t i = 0; i < mesh.mesh.faces.size(); ++i) {
@@ -824,7 +899,8 @@ void WriteTextPlyMesh(const std::filesystem::path& path,
 }
 
 void WriteBinaryPlyMesh(const std::filesystem::path& path,
-                        const PlyTexturedMesh& mesh) {
+                        const PlyTexturedMesh& mesh,
+                        const bool write_rgb) {
   std::fstream text_file(path, std::ios::out);
   THROW_CHECK_FILE_OPEN(text_file, path);
 
@@ -843,6 +919,11 @@ void WriteBinaryPlyMesh(const std::filesystem::path& path,
   text_file << "property float x\n";
   text_file << "property float y\n";
   text_file << "property float z\n";
+  if (write_rgb) {
+    text_file << "property uchar red\n";
+    text_file << "property uchar green\n";
+    text_file << "property uchar blue\n";
+  }
   text_file << "element face " << mesh.mesh.faces.size() << '\n';
   if (has_texcoords) {
     text_file << "property list uchar int vertex_indices\n";
@@ -861,6 +942,11 @@ void WriteBinaryPlyMesh(const std::filesystem::path& path,
     WriteBinaryLittleEndian<float>(&binary_file, vertex.x);
     WriteBinaryLittleEndian<float>(&binary_file, vertex.y);
     WriteBinaryLittleEndian<float>(&binary_file, vertex.z);
+    if (write_rgb) {
+      WriteBinaryLittleEndian<uint8_t>(&binary_file, vertex.r);
+      WriteBinaryLittleEndian<uint8_t>(&binary_file, vertex.g);
+      WriteBinaryLittleEndian<uint8_t>(&binary_file, vertex.b);
+    }
   }
 
   for (size_t i = 0; i < mesh.mesh.faces.size(); ++i) {
@@ -31,6 +31,7 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -110,16 +111,40 @@ void WriteBinaryPlyPoints(const std::filesystem::path& path,
                           bool write_normal = true,
                           bool write_rgb = true);
 
+// Write PLY point cloud to binary file in chunks, e.g., if the points do not
+// fit into memory at once. The number of points in the header has a fixed
+// width and is updated after every chunk, so that the file is always valid.
+class BinaryPlyPointsWriter {
+ public:
+  explicit BinaryPlyPointsWriter(const std::filesystem::path& path,
+                                 bool write_normal = true,
+                                 bool write_rgb = true);
+
+  // Append the points to the file.
+  void Write(const std::vector<PlyPoint>& points);
+
+  inline size_t NumPoints() const { return num_points_; }
+
+ private:
+  const bool write_normal_;
+  const bool write_rgb_;
+  std::fstream file_;
+  std::streampos num_points_pos_;
+  size_t num_points_ = 0;
+};
+
 // Read PLY mesh from text or binary file. Supports both plain and textured
 // meshes (with per-face UV coordinates and "comment TextureFile" header).
 PlyTexturedMesh ReadPlyMesh(const std::filesystem::path& path);
 
 // Write PLY mesh to text or binary file. Writes texture coordinates and
-// TextureFile comment when present in the mesh.
+// TextureFile comment when present in the mesh and optionally vertex colors.
 void WriteTextPlyMesh(const std::filesystem::path& path,
-                      const PlyTexturedMesh& mesh);
+                      const PlyTexturedMesh& mesh,
+                      bool write_rgb = false);
 void WriteBinaryPlyMesh(const std::filesystem::path& path,
-                        const PlyTexturedMesh& mesh);
+                        const PlyTexturedMesh& mesh,
+                        bool write_rgb = false);
 
 // Returns true if the PLY file contains face elements (i.e., is a mesh).
 bool HasPlyMeshFaces(const std::filesystem::path& path);
@@ -245,6 +245,54 @@ TEST(Ply, RoundTripBinaryPlyPointsXYZOnly) {
   EXPECT_EQ(loaded_points[0].b, 0);
 }
 
+TEST(Ply, RoundTripBinaryPlyPointsWriterInChunks) {
+  const auto test_dir = CreateTestDir();
+  const auto test_file = test_dir / "test.ply";
+
+  std::vector<PlyPoint> original_points;
+  for (int i = 0; i < 7; ++i) {
+    PlyPoint p;
+    p.x = i * 1.5f;
+    p.y = i * 2.5f;
+    p.z = i * 3.5f;
+    p.nx = i * 0.15f;
+    p.ny = i * 0.25f;
+    p.nz = i * 0.35f;
+    p.r = i * 15;
+    p.g = i * 25;
+    p.b = i * 35;
+    original_points.push_back(p);
+  }
+
+  BinaryPlyPointsWriter writer(test_file);
+  EXPECT_EQ(writer.NumPoints(), 0);
+  EXPECT_TRUE(ReadPly(test_file).empty());
+
+  writer.Write({original_points.begin(), original_points.begin() + 3});
+  EXPECT_EQ(writer.NumPoints(), 3);
+  EXPECT_EQ(ReadPly(test_file).size(), 3);
+
+  writer.Write({});
+  writer.Write({original_points.begin() + 3, original_points.end()});
+  EXPECT_EQ(writer.NumPoints(), original_points.size());
+
+  std::vector<PlyPoint> loaded_points = ReadPly(test_file);
+
+  ASSERT_EQ(loaded_points.size(), original_points.size());
+
+  for (size_t i = 0; i < original_points.size(); ++i) {
+    EXPECT_EQ(loaded_points[i].x, original_points[i].x);
+    EXPECT_EQ(loaded_points[i].y, original_points[i].y);
+    EXPECT_EQ(loaded_points[i].z, original_points[i].z);
+    EXPECT_EQ(loaded_points[i].nx, original_points[i].nx);
+    EXPECT_EQ(loaded_points[i].ny, original_points[i].ny);
+    EXPECT_EQ(loaded_points[i].nz, original_points[i].nz);
+    EXPECT_EQ(loaded_points[i].r, original_points[i].r);
+    EXPECT_EQ(loaded_points[i].g, original_points[i].g);
+    EXPECT_EQ(loaded_points[i].b, original_points[i].b);
+  }
+}
+
 TEST(Ply, RoundTripTextPlyMesh) {
   const auto test_dir = CreateTestDir();
   const auto test_file = test_dir / "mesh.ply";
@@ -325,6 +373,38 @@ TEST(Ply, RoundTripBinaryPlyMesh) {
   }
 }
 
+TEST(Ply, RoundTripPlyMeshWithVertexColors) {
+  const auto test_dir = CreateTestDir();
+
+  PlyMesh original_mesh;
+  original_mesh.vertices.emplace_back(0.0f, 0.0f, 0.0f, 10, 20, 30);
+  original_mesh.vertices.emplace_back(1.0f, 0.0f, 0.0f, 40, 50, 60);
+  original_mesh.vertices.emplace_back(0.0f, 1.0f, 0.0f, 70, 80, 90);
+  original_mesh.faces.emplace_back(0, 1, 2);
+
+  const auto text_file = test_dir / "text_mesh.ply";
+  const auto binary_file = test_dir / "binary_mesh.ply";
+  WriteTextPlyMesh(
+      text_file, PlyTexturedMesh{original_mesh}, /*write_rgb=*/true);
+  WriteBinaryPlyMesh(
+      binary_file, PlyTexturedMesh{original_mesh}, /*write_rgb=*/true);
+
+  for (const auto& path : {text_file, binary_file}) {
+    const PlyMesh loaded_mesh = ReadPlyMesh(path).mesh;
+    ASSERT_EQ(loaded_mesh.vertices.size(), original_mesh.vertices.size());
+    ASSERT_EQ(loaded_mesh.faces.size(), original_mesh.faces.size());
+    for (size_t i = 0; i < original_mesh.vertices.size(); ++i) {
+      EXPECT_EQ(loaded_mesh.vertices[i].x, original_mesh.vertices[i].x);
+      EXPECT_EQ(loaded_mesh.vertices[i].y, original_mesh.vertices[i].y);
+      EXPECT_EQ(loaded_mesh.vertices[i].z, original_mesh.vertices[i].z);
+      EXPECT_EQ(loaded_mesh.vertices[i].r, original_mesh.vertices[i].r);
+      EXPECT_EQ(loaded_mesh.vertices[i].g, original_mesh.vertices[i].g);
+      EXPECT_EQ(loaded_mesh.vertices[i].b, original_mesh.vertices[i].b);
+    }
+    EXPECT_EQ(loaded_mesh.faces[0].vertex_idx2, 1);
+  }
+}
+
 PlyTexturedMesh CreateTestTexturedMesh() {
   PlyTexturedMesh textured_mesh;
   textured_mesh.texture_file = "texture.png";
@@ -0,0 +1,349 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/util/quantized_points.h"
+
+#include "colmap/util/endian.h"
+#include "colmap/util/logging.h"
+#include "colmap/util/threading.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <limits>
+#include <sstream>
+
+#include <Eigen/Core>
+
+namespace colmap {
+namespace {
+
+constexpr char kMagic[8] = {'C', 'O', 'L', 'M', 'A', 'P', 'Q', 'P'};
+constexpr uint32_t kVersion = 1;
+constexpr int kMortonBits = 21;
+constexpr int16_t kZeroNormal = std::numeric_limits<int16_t>::min();
+
+using TileIdx = std::array<int64_t, 3>;
+
+uint64_t SpreadMortonBits(uint64_t x) {
+  x &= 0x1fffff;
+  x = (x | x << 32) & 0x1f00000000ffff;
+  x = (x | x << 16) & 0x1f0000ff0000ff;
+  x = (x | x << 8) & 0x100f00f00f00f00f;
+  x = (x | x << 4) & 0x10c30c30c30c30c3;
+  x = (x | x << 2) & 0x1249249249249249;
+  return x;
+}
+
+uint64_t CompactMortonBits(uint64_t x) {
+  x &= 0x1249249249249249;
+  x = (x ^ (x >> 2)) & 0x10c30c30c30c30c3;
+  x = (x ^ (x >> 4)) & 0x100f00f00f00f00f;
+  x = (x ^ (x >> 8)) & 0x1f0000ff0000ff;
+  x = (x ^ (x >> 16)) & 0x1f00000000ffff;
+  x = (x ^ (x >> 32)) & 0x1fffff;
+  return x;
+}
+
+void WriteVarint(uint64_t value, std::ostream& stream) {
+  while (value >= 0x80) {
+    stream.put(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  stream.put(static_cast<char>(value));
+}
+
+uint64_t ReadVarint(std::istream& stream) {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    const int byte = stream.get();
+    THROW_CHECK_NE(byte, std::char_traits<char>::eof())
+        << "Truncated quantized points";
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  LOG(FATAL_THROW) << "Invalid varint in quantized points";
+  return value;
+}
+
+// Octahedral normal encoding, see "A Survey of Efficient Representations for
+// Independent Unit Vectors", Cigolle et al., 2014.
+std::array<int16_t, 2> EncodeNormal(const PlyPoint& point) {
+  const Eigen::Vector3f normal(point.nx, point.ny, point.nz);
+  const float l1_norm = normal.lpNorm<1>();
+  if (!(l1_norm > 0)) {
+    return {kZeroNormal, kZeroNormal};
+  }
+  Eigen::Vector2f proj = normal.head<2>() / l1_norm;
+  if (normal.z() < 0) {
+    proj = Eigen::Vector2f(
+        (1 - std::abs(proj.y())) * (proj.x() >= 0 ? 1 : -1),
+        (1 - std::abs(proj.x())) * (proj.y() >= 0 ? 1 : -1));
+  }
+  return {static_cast<int16_t>(std::lround(proj.x() * 32767)),
+          static_cast<int16_t>(std::lround(proj.y() * 32767))};
+}
+
+Eigen::Vector3f DecodeNormal(const std::array<int16_t, 2>& code) {
+  if (code[0] == kZeroNormal && code[1] == kZeroNormal) {
+    return Eigen::Vector3f::Zero();
+  }
+  const Eigen::Vector2f proj(code[0] / 32767.f, code[1] / 32767.f);
+  Eigen::Vector3f normal(
+      proj.x(), proj.y(), 1 - std::abs(proj.x()) - std::abs(proj.y()));
+  if (normal.z() < 0) {
+    normal.head<2>() = Eigen::Vector2f(
+        (1 - std::abs(proj.y())) * (proj.x() >= 0 ? 1 : -1),
+        (1 - std::abs(proj.x())) * (proj.y() >= 0 ? 1 : -1));
+  }
+  return normal.normalized();
+}
+
+int64_t FloorDiv(const int64_t a, const int64_t b) {
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+struct TileHeader {
+  TileIdx tile_idx;
+  uint64_t num_points = 0;
+  uint64_t num_bytes = 0;
+};
+
+std::string EncodeTile(const std::vector<PlyPoint>& points,
+                       const std::vector<size_t>& point_idxs,
+                       const TileIdx& tile_idx,
+                       const QuantizedPointsOptions& options,
+                       const int64_t tile_steps) {
+  std::vector<std::pair<uint64_t, size_t>> codes;
+  codes.reserve(point_idxs.size());
+  for (const size_t point_idx : point_idxs) {
+    const PlyPoint& point = points[point_idx];
+    const float xyz[3] = {point.x, point.y, point.z};
+    uint64_t code = 0;
+    for (int d = 0; d < 3; ++d) {
+      const int64_t local =
+          std::llround(xyz[d] / options.position_step) -
+          tile_idx[d] * tile_steps;
+      code |= SpreadMortonBits(std::clamp<int64_t>(local, 0, tile_steps - 1))
+              << d;
+    }
+    codes.emplace_back(code, point_idx);
+  }
+  std::sort(codes.begin(), codes.end());
+
+  std::ostringstream stream(std::ios::binary);
+  uint64_t prev_code = 0;
+  for (const auto& [code, _] : codes) {
+    WriteVarint(code - prev_code, stream);
+    prev_code = code;
+  }
+  if (options.write_normal) {
+    for (const auto& [_, point_idx] : codes) {
+      const std::array<int16_t, 2> normal = EncodeNormal(points[point_idx]);
+      WriteBinaryLittleEndian<int16_t>(&stream, normal[0]);
+      WriteBinaryLittleEndian<int16_t>(&stream, normal[1]);
+    }
+  }
+  if (options.write_rgb) {
+    for (const auto& [_, point_idx] : codes) {
+      const PlyPoint& point = points[point_idx];
+      WriteBinaryLittleEndian<uint8_t>(&stream, point.r);
+      WriteBinaryLittleEndian<uint8_t>(&stream, point.g);
+      WriteBinaryLittleEndian<uint8_t>(&stream, point.b);
+    }
+  }
+  return stream.str();
+}
+
+std::vector<PlyPoint> DecodeTile(const std::string& data,
+                                 const TileHeader& header,
+                                 const bool has_normal,
+                                 const bool has_rgb,
+                                 const double position_step,
+                                 const int64_t tile_steps) {
+  std::istringstream stream(data, std::ios::binary);
+  std::vector<PlyPoint> points(header.num_points);
+  uint64_t code = 0;
+  for (PlyPoint& point : points) {
+    code += ReadVarint(stream);
+    float* xyz[3] = {&point.x, &point.y, &point.z};
+    for (int d = 0; d < 3; ++d) {
+      const int64_t global = header.tile_idx[d] * tile_steps +
+                             static_cast<int64_t>(CompactMortonBits(code >> d));
+      *xyz[d] = static_cast<float>(global * position_step);
+    }
+  }
+  if (has_normal) {
+    for (PlyPoint& point : points) {
+      std::array<int16_t, 2> code;
+      code[0] = ReadBinaryLittleEndian<int16_t>(&stream);
+      code[1] = ReadBinaryLittleEndian<int16_t>(&stream);
+      const Eigen::Vector3f normal = DecodeNormal(code);
+      point.nx = normal.x();
+      point.ny = normal.y();
+      point.nz = normal.z();
+    }
+  }
+  if (has_rgb) {
+    for (PlyPoint& point : points) {
+      point.r = ReadBinaryLittleEndian<uint8_t>(&stream);
+      point.g = ReadBinaryLittleEndian<uint8_t>(&stream);
+      point.b = ReadBinaryLittleEndian<uint8_t>(&stream);
+    }
+  }
+  THROW_CHECK(!stream.fail()) << "Truncated quantized points";
+  return points;
+}
+
+}  // namespace
+
+bool QuantizedPointsOptions::Check() const {
+  CHECK_OPTION_GT(position_step, 0);
+  CHECK_OPTION_GE(tile_size, position_step);
+  CHECK_OPTION_LE(tile_size / position_step, 1 << kMortonBits);
+  return true;
+}
+
+void WriteQuantizedPoints(const std::filesystem::path& path,
+                          const std::vector<PlyPoint>& points,
+                          const QuantizedPointsOptions& options) {
+  THROW_CHECK(options.Check());
+
+  const int64_t tile_steps =
+      std::max<int64_t>(1, std::llround(options.tile_size /
+                                        options.position_step));
+
+  // Ordered by tile index, so that neighboring tiles are stored close by.
+  std::map<TileIdx, std::vector<size_t>> tiles;
+  for (size_t point_idx = 0; point_idx < points.size(); ++point_idx) {
+    const PlyPoint& point = points[point_idx];
+    const float xyz[3] = {point.x, point.y, point.z};
+    TileIdx tile_idx;
+    for (int d = 0; d < 3; ++d) {
+      THROW_CHECK(std::isfinite(xyz[d]));
+      tile_idx[d] =
+          FloorDiv(std::llround(xyz[d] / options.position_step), tile_steps);
+    }
+    tiles[tile_idx].push_back(point_idx);
+  }
+
+  std::ofstream file(path, std::ios::trunc | std::ios::binary);
+  THROW_CHECK_FILE_OPEN(file, path);
+
+  file.write(kMagic, sizeof(kMagic));
+  WriteBinaryLittleEndian<uint32_t>(&file, kVersion);
+  WriteBinaryLittleEndian<uint8_t>(&file, options.write_normal ? 1 : 0);
+  WriteBinaryLittleEndian<uint8_t>(&file, options.write_rgb ? 1 : 0);
+  WriteBinaryLittleEndian<double>(&file, options.position_step);
+  WriteBinaryLittleEndian<uint32_t>(&file, tile_steps);
+  WriteBinaryLittleEndian<uint64_t>(&file, points.size());
+  WriteBinaryLittleEndian<uint64_t>(&file, tiles.size());
+
+  // Encode batches of tiles in parallel and write them in order, which bounds
+  // the memory of the encoded tiles.
+  const int num_threads = GetEffectiveNumThreads(options.num_threads);
+  const size_t batch_size = 4 * num_threads;
+  std::vector<std::string> encoded_tiles(batch_size);
+  auto tile_it = tiles.begin();
+  while (tile_it != tiles.end()) {
+    std::vector<decltype(tile_it)> batch;
+    for (; tile_it != tiles.end() && batch.size() < batch_size; ++tile_it) {
+      batch.push_back(tile_it);
+    }
+    GetSharedThreadPool().ParallelFor(
+        0,
+        batch.size(),
+        [&](const int64_t i) {
+          encoded_tiles[i] = EncodeTile(
+              points, batch[i]->second, batch[i]->first, options, tile_steps);
+        },
+        num_threads);
+    for (size_t i = 0; i < batch.size(); ++i) {
+      for (const int64_t tile_idx : batch[i]->first) {
+        WriteBinaryLittleEndian<int64_t>(&file, tile_idx);
+      }
+      WriteBinaryLittleEndian<uint64_t>(&file, batch[i]->second.size());
+      WriteBinaryLittleEndian<uint64_t>(&file, encoded_tiles[i].size());
+      file.write(encoded_tiles[i].data(), encoded_tiles[i].size());
+    }
+  }
+}
+
+void ReadQuantizedPointsTiles(
+    const std::filesystem::path& path,
+    const std::function<void(std::vector<PlyPoint>)>& callback) {
+  std::ifstream file(path, std::ios::binary);
+  THROW_CHECK_FILE_OPEN(file, path);
+
+  char magic[sizeof(kMagic)];
+  file.read(magic, sizeof(magic));
+  THROW_CHECK(file.good() && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0)
+      << "Not a quantized point cloud: " << path;
+  const uint32_t version = ReadBinaryLittleEndian<uint32_t>(&file);
+  THROW_CHECK_EQ(version, kVersion)
+      << "Unsupported quantized point cloud: " << path;
+  const bool has_normal = ReadBinaryLittleEndian<uint8_t>(&file);
+  const bool has_rgb = ReadBinaryLittleEndian<uint8_t>(&file);
+  const double position_step = ReadBinaryLittleEndian<double>(&file);
+  const int64_t tile_steps = ReadBinaryLittleEndian<uint32_t>(&file);
+  ReadBinaryLittleEndian<uint64_t>(&file);  // Total number of points.
+  const uint64_t num_tiles = ReadBinaryLittleEndian<uint64_t>(&file);
+  THROW_CHECK(file.good()) << "Truncated quantized points: " << path;
+
+  std::string data;
+  for (uint64_t i = 0; i < num_tiles; ++i) {
+    TileHeader header;
+    for (int64_t& tile_idx : header.tile_idx) {
+      tile_idx = ReadBinaryLittleEndian<int64_t>(&file);
+    }
+    header.num_points = ReadBinaryLittleEndian<uint64_t>(&file);
+    header.num_bytes = ReadBinaryLittleEndian<uint64_t>(&file);
+    data.resize(header.num_bytes);
+    file.read(data.data(), data.size());
+    THROW_CHECK(file.good()) << "Truncated quantized points: " << path;
+    callback(DecodeTile(
+        data, header, has_normal, has_rgb, position_step, tile_steps));
+  }
+}
+
+std::vector<PlyPoint> ReadQuantizedPoints(const std::filesystem::path& path) {
+  std::vector<PlyPoint> points;
+  ReadQuantizedPointsTiles(path, [&points](std::vector<PlyPoint> tile_points) {
+    points.insert(points.end(), tile_points.begin(), tile_points.end());
+  });
+  return points;
+}
+
+}  // namespace colmap
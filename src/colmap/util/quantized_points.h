@@ -0,0 +1,78 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "colmap/util/ply.h"
+
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+namespace colmap {
+
+// Compact binary format for large point clouds. The points are grouped into
+// cubic tiles, positions are quantized relative to the tile origins and
+// encoded in octree (Morton) order as variable-length deltas, normals are
+// octahedron-encoded with 16 bits per component, and colors are stored as
+// is. Tiles are encoded in parallel and stored as independent chunks, so
+// viewers can load the point cloud progressively tile by tile. Note that the
+// order of the points is not preserved.
+struct QuantizedPointsOptions {
+  // Quantization step of the positions. The maximum position error is half
+  // of the step.
+  double position_step = 1e-3;
+
+  // Edge length of the tiles. Must be at most 2^21 quantization steps.
+  double tile_size = 100;
+
+  // Whether to write the normals and colors of the points.
+  bool write_normal = true;
+  bool write_rgb = true;
+
+  // The number of threads used to encode tiles.
+  int num_threads = -1;
+
+  bool Check() const;
+};
+
+void WriteQuantizedPoints(const std::filesystem::path& path,
+                          const std::vector<PlyPoint>& points,
+                          const QuantizedPointsOptions& options = {});
+
+// Read the points of one tile at a time and pass them to the callback.
+void ReadQuantizedPointsTiles(
+    const std::filesystem::path& path,
+    const std::function<void(std::vector<PlyPoint>)>& callback);
+
+// Read all points into memory.
+std::vector<PlyPoint> ReadQuantizedPoints(const std::filesystem::path& path);
+
+}  // namespace colmap
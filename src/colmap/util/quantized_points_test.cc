@@ -0,0 +1,160 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/util/quantized_points.h"
+
+#include "colmap/util/testing.h"
+
+#include <cmath>
+#include <map>
+#include <random>
+#include <tuple>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+std::vector<PlyPoint> CreateRandomPoints(const size_t num_points) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> position_dist(-200, 200);
+  std::normal_distribution<float> normal_dist;
+  std::uniform_int_distribution<int> color_dist(0, 255);
+  std::vector<PlyPoint> points(num_points);
+  for (PlyPoint& point : points) {
+    point.x = position_dist(rng);
+    point.y = position_dist(rng);
+    point.z = position_dist(rng);
+    const float nx = normal_dist(rng);
+    const float ny = normal_dist(rng);
+    const float nz = normal_dist(rng);
+    const float norm = std::sqrt(nx * nx + ny * ny + nz * nz);
+    point.nx = nx / norm;
+    point.ny = ny / norm;
+    point.nz = nz / norm;
+    point.r = color_dist(rng);
+    point.g = color_dist(rng);
+    point.b = color_dist(rng);
+  }
+  return points;
+}
+
+std::tuple<int64_t, int64_t, int64_t> QuantizedKey(const PlyPoint& point,
+                                                   const double step) {
+  return {std::llround(point.x / step),
+          std::llround(point.y / step),
+          std::llround(point.z / step)};
+}
+
+TEST(QuantizedPoints, Nominal) {
+  const std::vector<PlyPoint> points = CreateRandomPoints(2000);
+  QuantizedPointsOptions options;
+  options.position_step = 1e-2;
+  options.tile_size = 100;
+  const auto path = CreateTestDir() / "points.qpc";
+  WriteQuantizedPoints(path, points, options);
+
+  size_t num_tiles = 0;
+  ReadQuantizedPointsTiles(path, [&num_tiles](std::vector<PlyPoint>) {
+    ++num_tiles;
+  });
+  EXPECT_EQ(num_tiles, 4 * 4 * 4);
+
+  const std::vector<PlyPoint> read_points = ReadQuantizedPoints(path);
+  ASSERT_EQ(read_points.size(), points.size());
+
+  std::map<std::tuple<int64_t, int64_t, int64_t>, const PlyPoint*>
+      points_by_key;
+  for (const PlyPoint& point : points) {
+    points_by_key.emplace(QuantizedKey(point, options.position_step), &point);
+  }
+  for (const PlyPoint& read_point : read_points) {
+    const auto it =
+        points_by_key.find(QuantizedKey(read_point, options.position_step));
+    ASSERT_NE(it, points_by_key.end());
+    const PlyPoint& point = *it->second;
+    EXPECT_NEAR(read_point.x, point.x, 0.5 * options.position_step + 1e-4);
+    EXPECT_NEAR(read_point.y, point.y, 0.5 * options.position_step + 1e-4);
+    EXPECT_NEAR(read_point.z, point.z, 0.5 * options.position_step + 1e-4);
+    EXPECT_NEAR(read_point.nx, point.nx, 1e-3);
+    EXPECT_NEAR(read_point.ny, point.ny, 1e-3);
+    EXPECT_NEAR(read_point.nz, point.nz, 1e-3);
+    EXPECT_EQ(read_point.r, point.r);
+    EXPECT_EQ(read_point.g, point.g);
+    EXPECT_EQ(read_point.b, point.b);
+  }
+}
+
+TEST(QuantizedPoints, WithoutNormalAndColor) {
+  std::vector<PlyPoint> points = CreateRandomPoints(100);
+  points[0].nx = points[0].ny = points[0].nz = 0;
+  QuantizedPointsOptions options;
+  options.write_normal = false;
+  options.write_rgb = false;
+  const auto path = CreateTestDir() / "points.qpc";
+  WriteQuantizedPoints(path, points, options);
+  const std::vector<PlyPoint> read_points = ReadQuantizedPoints(path);
+  ASSERT_EQ(read_points.size(), points.size());
+  for (const PlyPoint& point : read_points) {
+    EXPECT_EQ(point.nx, 0);
+    EXPECT_EQ(point.ny, 0);
+    EXPECT_EQ(point.nz, 0);
+    EXPECT_EQ(point.r, 0);
+  }
+}
+
+TEST(QuantizedPoints, ZeroNormal) {
+  PlyPoint point;
+  point.x = -1;
+  const auto path = CreateTestDir() / "points.qpc";
+  WriteQuantizedPoints(path, {point});
+  const std::vector<PlyPoint> read_points = ReadQuantizedPoints(path);
+  ASSERT_EQ(read_points.size(), 1);
+  EXPECT_EQ(read_points[0].x, -1);
+  EXPECT_EQ(read_points[0].nx, 0);
+  EXPECT_EQ(read_points[0].ny, 0);
+  EXPECT_EQ(read_points[0].nz, 0);
+}
+
+TEST(QuantizedPoints, Empty) {
+  const auto path = CreateTestDir() / "points.qpc";
+  WriteQuantizedPoints(path, {});
+  EXPECT_TRUE(ReadQuantizedPoints(path).empty());
+}
+
+TEST(QuantizedPoints, InvalidOptions) {
+  QuantizedPointsOptions options;
+  options.position_step = 1e-6;
+  options.tile_size = 100;
+  EXPECT_ANY_THROW(options.Check());
+}
+
+}  // namespace
+}  // namespace colmap
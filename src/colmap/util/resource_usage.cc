@@ -0,0 +1,268 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/util/resource_usage.h"
+
+#include "colmap/util/logging.h"
+#include "colmap/util/metrics.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+
+#ifdef _WIN32
+#include <windows.h>
+// Must be included after windows.h.
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+namespace colmap {
+namespace {
+
+const std::chrono::steady_clock::time_point kProcessStartTime =
+    std::chrono::steady_clock::now();
+
+struct StageRegistry {
+  std::mutex mutex;
+  std::vector<StageResourceUsage> stages;
+};
+
+StageRegistry& GetStageRegistry() {
+  static StageRegistry registry;
+  return registry;
+}
+
+#ifdef _WIN32
+double FileTimeToSeconds(const FILETIME& file_time) {
+  ULARGE_INTEGER time;
+  time.LowPart = file_time.dwLowDateTime;
+  time.HighPart = file_time.dwHighDateTime;
+  // FILETIME is in units of 100 nanoseconds.
+  return 1e-7 * time.QuadPart;
+}
+#endif
+
+#if defined(__linux__)
+// Reads the number of bytes read and written through system calls.
+void ReadProcessIoBytes(int64_t* read_bytes, int64_t* write_bytes) {
+  std::ifstream file("/proc/self/io");
+  std::string key;
+  int64_t value = 0;
+  while (file >> key >> value) {
+    if (key == "rchar:") {
+      *read_bytes = value;
+    } else if (key == "wchar:") {
+      *write_bytes = value;
+    }
+  }
+}
+#endif
+
+void WriteResourceUsageJson(const ResourceUsage& usage, std::ostream* stream) {
+  *stream << "\"wall_time_sec\":" << usage.wall_time_sec
+          << ",\"user_cpu_time_sec\":" << usage.user_cpu_time_sec
+          << ",\"system_cpu_time_sec\":" << usage.system_cpu_time_sec
+          << ",\"peak_rss_bytes\":" << usage.peak_rss_bytes
+          << ",\"io_read_bytes\":" << usage.io_read_bytes
+          << ",\"io_write_bytes\":" << usage.io_write_bytes
+          << ",\"peak_gpu_memory_bytes\":" << usage.peak_gpu_memory_bytes;
+}
+
+void WriteJsonString(const std::string& str, std::ostream* stream) {
+  *stream << '"';
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      *stream << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      *stream << ' ';
+    } else {
+      *stream << c;
+    }
+  }
+  *stream << '"';
+}
+
+}  // namespace
+
+ResourceUsage GetProcessResourceUsage() {
+  ResourceUsage usage;
+  usage.wall_time_sec =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                    kProcessStartTime)
+          .count();
+
+#ifdef _WIN32
+  const HANDLE process = GetCurrentProcess();
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if (GetProcessTimes(
+          process, &creation_time, &exit_time, &kernel_time, &user_time)) {
+    usage.user_cpu_time_sec = FileTimeToSeconds(user_time);
+    usage.system_cpu_time_sec = FileTimeToSeconds(kernel_time);
+  }
+  PROCESS_MEMORY_COUNTERS memory_counters;
+  if (K32GetProcessMemoryInfo(
+          process, &memory_counters, sizeof(memory_counters))) {
+    usage.peak_rss_bytes = memory_counters.PeakWorkingSetSize;
+  }
+  IO_COUNTERS io_counters;
+  if (GetProcessIoCounters(process, &io_counters)) {
+    usage.io_read_bytes = io_counters.ReadTransferCount;
+    usage.io_write_bytes = io_counters.WriteTransferCount;
+  }
+#else
+  struct rusage rusage;
+  if (getrusage(RUSAGE_SELF, &rusage) == 0) {
+    usage.user_cpu_time_sec =
+        rusage.ru_utime.tv_sec + 1e-6 * rusage.ru_utime.tv_usec;
+    usage.system_cpu_time_sec =
+        rusage.ru_stime.tv_sec + 1e-6 * rusage.ru_stime.tv_usec;
+#ifdef __APPLE__
+    // In bytes on macOS and in kilobytes on Linux.
+    usage.peak_rss_bytes = rusage.ru_maxrss;
+#else
+    usage.peak_rss_bytes = static_cast<int64_t>(rusage.ru_maxrss) * 1024;
+#endif
+  }
+#if defined(__linux__)
+  ReadProcessIoBytes(&usage.io_read_bytes, &usage.io_write_bytes);
+#endif
+#endif
+
+  usage.peak_gpu_memory_bytes = static_cast<int64_t>(
+      SumMetricValues("colmap_cuda_memory_peak_bytes"));
+
+  return usage;
+}
+
+int64_t GetThreadCpuTimeMicroSeconds() {
+#ifdef _WIN32
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if (!GetThreadTimes(GetCurrentThread(),
+                      &creation_time,
+                      &exit_time,
+                      &kernel_time,
+                      &user_time)) {
+    return 0;
+  }
+  return static_cast<int64_t>(
+      1e6 * (FileTimeToSeconds(kernel_time) + FileTimeToSeconds(user_time)));
+#else
+  struct timespec time;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+    return 0;
+  }
+  return static_cast<int64_t>(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+#endif
+}
+
+ScopedResourceUsage::ScopedResourceUsage(const char* name)
+    : name_(name), start_usage_(GetProcessResourceUsage()), trace_zone_(name) {}
+
+ScopedResourceUsage::~ScopedResourceUsage() {
+  const ResourceUsage end_usage = GetProcessResourceUsage();
+
+  StageResourceUsage stage;
+  stage.name = name_;
+  stage.start_time_sec = start_usage_.wall_time_sec;
+  stage.usage.wall_time_sec =
+      end_usage.wall_time_sec - start_usage_.wall_time_sec;
+  stage.usage.user_cpu_time_sec =
+      end_usage.user_cpu_time_sec - start_usage_.user_cpu_time_sec;
+  stage.usage.system_cpu_time_sec =
+      end_usage.system_cpu_time_sec - start_usage_.system_cpu_time_sec;
+  stage.usage.peak_rss_bytes = end_usage.peak_rss_bytes;
+  stage.usage.io_read_bytes =
+      end_usage.io_read_bytes - start_usage_.io_read_bytes;
+  stage.usage.io_write_bytes =
+      end_usage.io_write_bytes - start_usage_.io_write_bytes;
+  stage.usage.peak_gpu_memory_bytes = end_usage.peak_gpu_memory_bytes;
+
+  VLOG(2) << "Stage " << name_ << ": " << stage.usage.wall_time_sec
+          << "s wall, "
+          << stage.usage.user_cpu_time_sec + stage.usage.system_cpu_time_sec
+          << "s CPU";
+
+  StageRegistry& registry = GetStageRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.stages.push_back(std::move(stage));
+}
+
+std::vector<StageResourceUsage> GetStageResourceUsages() {
+  StageRegistry& registry = GetStageRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  return registry.stages;
+}
+
+void ClearStageResourceUsages() {
+  StageRegistry& registry = GetStageRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.stages.clear();
+}
+
+void WriteResourceUsageSummary(const std::filesystem::path& path) {
+  std::ofstream file(path);
+  THROW_CHECK_FILE_OPEN(file, path);
+  file << std::setprecision(10);
+
+  file << "{\"total\":{";
+  WriteResourceUsageJson(GetProcessResourceUsage(), &file);
+  file << "},\n\"stages\":[";
+  bool first = true;
+  for (const StageResourceUsage& stage : GetStageResourceUsages()) {
+    file << (first ? "\n" : ",\n");
+    first = false;
+    file << "{\"name\":";
+    WriteJsonString(stage.name, &file);
+    file << ",\"start_time_sec\":" << stage.start_time_sec << ",";
+    WriteResourceUsageJson(stage.usage, &file);
+    file << "}";
+  }
+  file << "],\n\"zones\":[";
+  first = true;
+  for (const auto& [name, summary] : SummarizeTraceZones()) {
+    file << (first ? "\n" : ",\n");
+    first = false;
+    file << "{\"name\":";
+    WriteJsonString(name, &file);
+    file << ",\"num_calls\":" << summary.num_calls
+         << ",\"wall_time_sec\":" << 1e-6 * summary.total_duration_us
+         << ",\"cpu_time_sec\":" << 1e-6 * summary.total_cpu_duration_us
+         << ",\"num_items\":" << summary.num_items << "}";
+  }
+  file << "]}\n";
+
+  THROW_CHECK(file.good()) << "Failed to write resource usage to " << path;
+}
+
+}  // namespace colmap
@@ -0,0 +1,117 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "colmap/util/tracing.h"
+#include "colmap/util/types.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace colmap {
+
+// Resource usage of the process, e.g., for capacity planning of jobs.
+// Unsupported fields on the current platform are zero.
+struct ResourceUsage {
+  // Elapsed wall-clock time.
+  double wall_time_sec = 0;
+  // CPU time spent in user and kernel mode by all threads of the process.
+  double user_cpu_time_sec = 0;
+  double system_cpu_time_sec = 0;
+  // High-water mark of the resident memory of the process.
+  int64_t peak_rss_bytes = 0;
+  // Number of bytes read and written by the process through system calls,
+  // including reads served from the page cache.
+  int64_t io_read_bytes = 0;
+  int64_t io_write_bytes = 0;
+  // High-water mark of the device memory allocated through the shared CUDA
+  // memory pool, summed over the components of the pool.
+  int64_t peak_gpu_memory_bytes = 0;
+};
+
+// Get the resource usage of the process since its start. The wall-clock time
+// is measured from the static initialization of the library.
+ResourceUsage GetProcessResourceUsage();
+
+// Get the CPU time spent by the calling thread in microseconds.
+int64_t GetThreadCpuTimeMicroSeconds();
+
+// Resource usage of a stage, where the times and I/O are the differences
+// between the end and start of the stage, while the peak memory is the
+// high-water mark of the process at the end of the stage. Stages are not
+// isolated from concurrent work in the same process, e.g., the CPU time of
+// nested or parallel stages is also counted towards the enclosing stage.
+struct StageResourceUsage {
+  std::string name;
+  // Start of the stage in seconds since the start of the process.
+  double start_time_sec = 0;
+  ResourceUsage usage;
+};
+
+// Records the resource usage of a stage from construction to destruction.
+// The stage is also recorded as a trace zone of the same name, see
+// util/tracing.h. The name must be a string literal or otherwise outlive the
+// export of the trace.
+//
+// Example usage:
+//
+//    void Controller::Run() {
+//      ScopedResourceUsage resource_usage("Controller");
+//      ...
+//    }
+//
+class ScopedResourceUsage {
+ public:
+  explicit ScopedResourceUsage(const char* name);
+  ~ScopedResourceUsage();
+
+ private:
+  NON_COPYABLE(ScopedResourceUsage)
+  NON_MOVABLE(ScopedResourceUsage)
+
+  const char* name_;
+  ResourceUsage start_usage_;
+  TraceZone trace_zone_;
+};
+
+// Get the recorded stages in the order of their completion.
+std::vector<StageResourceUsage> GetStageResourceUsages();
+
+// Delete all recorded stages.
+void ClearStageResourceUsages();
+
+// Write a JSON summary with the total resource usage of the process, the
+// recorded stages, and the runtimes of the recorded trace zones as sub-stages.
+void WriteResourceUsageSummary(const std::filesystem::path& path);
+
+}  // namespace colmap
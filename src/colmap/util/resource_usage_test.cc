@@ -0,0 +1,140 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/util/resource_usage.h"
+
+#include "colmap/util/metrics.h"
+#include "colmap/util/testing.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+// Keeps the thread busy to accumulate a measurable amount of CPU time.
+double BusyLoop(const int num_iterations) {
+  volatile double value = 0;
+  for (int i = 0; i < num_iterations; ++i) {
+    value = value + 1e-3 * i;
+  }
+  return value;
+}
+
+TEST(ResourceUsage, GetProcessResourceUsage) {
+  const ResourceUsage usage1 = GetProcessResourceUsage();
+  BusyLoop(10000000);
+  const ResourceUsage usage2 = GetProcessResourceUsage();
+  EXPECT_GT(usage2.wall_time_sec, usage1.wall_time_sec);
+  EXPECT_GE(usage2.user_cpu_time_sec + usage2.system_cpu_time_sec,
+            usage1.user_cpu_time_sec + usage1.system_cpu_time_sec);
+  EXPECT_GE(usage2.peak_rss_bytes, usage1.peak_rss_bytes);
+  EXPECT_GE(usage2.io_read_bytes, usage1.io_read_bytes);
+  EXPECT_GE(usage2.io_write_bytes, usage1.io_write_bytes);
+#if defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+  EXPECT_GT(usage2.peak_rss_bytes, 0);
+#endif
+}
+
+TEST(ResourceUsage, GpuMemoryFromMetrics) {
+  ClearMetrics();
+  EXPECT_EQ(GetProcessResourceUsage().peak_gpu_memory_bytes, 0);
+  SetMetricGauge("colmap_cuda_memory_peak_bytes{component=\"a\"}", 100);
+  SetMetricGauge("colmap_cuda_memory_peak_bytes{component=\"b\"}", 20);
+  EXPECT_EQ(GetProcessResourceUsage().peak_gpu_memory_bytes, 120);
+  ClearMetrics();
+}
+
+TEST(ResourceUsage, GetThreadCpuTimeMicroSeconds) {
+  const int64_t cpu_time_us1 = GetThreadCpuTimeMicroSeconds();
+  BusyLoop(10000000);
+  const int64_t cpu_time_us2 = GetThreadCpuTimeMicroSeconds();
+  EXPECT_GT(cpu_time_us2, cpu_time_us1);
+}
+
+TEST(ResourceUsage, ScopedResourceUsage) {
+  ClearStageResourceUsages();
+  {
+    ScopedResourceUsage outer("Outer");
+    {
+      ScopedResourceUsage inner("Inner");
+      BusyLoop(1000000);
+    }
+  }
+
+  const std::vector<StageResourceUsage> stages = GetStageResourceUsages();
+  ASSERT_EQ(stages.size(), 2);
+  EXPECT_EQ(stages[0].name, "Inner");
+  EXPECT_EQ(stages[1].name, "Outer");
+  EXPECT_LE(stages[1].start_time_sec, stages[0].start_time_sec);
+  EXPECT_GE(stages[1].usage.wall_time_sec, stages[0].usage.wall_time_sec);
+  EXPECT_GE(stages[0].usage.user_cpu_time_sec, 0);
+  EXPECT_GE(stages[0].usage.system_cpu_time_sec, 0);
+  EXPECT_GT(stages[0].usage.peak_rss_bytes, 0);
+
+  ClearStageResourceUsages();
+  EXPECT_TRUE(GetStageResourceUsages().empty());
+}
+
+TEST(ResourceUsage, WriteResourceUsageSummary) {
+  ClearStageResourceUsages();
+  ClearTrace();
+  SetTracingEnabled(true);
+  {
+    ScopedResourceUsage stage("Stage");
+    COLMAP_TRACE_ZONE("SubStage");
+  }
+  SetTracingEnabled(false);
+
+  const auto path = CreateTestDir() / "resource_usage.json";
+  WriteResourceUsageSummary(path);
+  std::ifstream file(path);
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  const std::string summary = buffer.str();
+  EXPECT_EQ(summary.find("{\"total\":{\"wall_time_sec\":"), 0);
+  EXPECT_NE(summary.find("{\"name\":\"Stage\",\"start_time_sec\":"),
+            std::string::npos);
+  EXPECT_NE(summary.find("\"peak_gpu_memory_bytes\":"), std::string::npos);
+  EXPECT_NE(summary.find("{\"name\":\"Stage\",\"num_calls\":1,"),
+            std::string::npos);
+  EXPECT_NE(summary.find("{\"name\":\"SubStage\",\"num_calls\":1,"),
+            std::string::npos);
+
+  ClearStageResourceUsages();
+  ClearTrace();
+}
+
+}  // namespace
+}  // namespace colmap
@@ -0,0 +1,520 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace colmap {
+
+// Sequence container with the subset of the std::vector interface used
+// throughout the code base, which stores up to N elements inline in the
+// container itself and only allocates heap memory for more elements. This
+// avoids one heap allocation per container for the many small sequences of a
+// reconstruction, such as the tracks of its 3D points. The inline storage and
+// the heap pointer share their memory, so the container takes
+// max(N * sizeof(T), sizeof(T*)) plus 8 bytes. The element type must be
+// trivially copyable, such that elements can be relocated with memcpy. As for
+// std::vector, iterators are pointers that are invalidated by any operation
+// changing the capacity. Moving a container with inline elements also copies
+// them, so iterators into the moved-from container do not carry over.
+template <typename T, size_t N>
+class SmallVector {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "SmallVector requires trivially copyable elements");
+  static_assert(N > 0, "SmallVector requires inline capacity");
+
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  static constexpr size_t kInlineCapacity = N;
+
+  SmallVector() = default;
+  explicit SmallVector(size_t count, const T& value = T());
+  template <
+      typename InputIt,
+      typename = typename std::iterator_traits<InputIt>::iterator_category>
+  SmallVector(InputIt first, InputIt last);
+  SmallVector(std::initializer_list<T> init);
+  SmallVector(const SmallVector& other);
+  SmallVector& operator=(const SmallVector& other);
+  SmallVector(SmallVector&& other) noexcept;
+  SmallVector& operator=(SmallVector&& other) noexcept;
+  ~SmallVector();
+
+  size_t size() const;
+  bool empty() const;
+  size_t capacity() const;
+
+  // Grows the heap storage to at least the given capacity.
+  void reserve(size_t new_capacity);
+  // Moves the elements back into the inline storage if they fit, or otherwise
+  // reallocates the heap storage to the number of elements.
+  void shrink_to_fit();
+
+  void resize(size_t new_size);
+  void resize(size_t new_size, const T& value);
+  void clear();
+
+  template <
+      typename InputIt,
+      typename = typename std::iterator_traits<InputIt>::iterator_category>
+  void assign(InputIt first, InputIt last);
+
+  void push_back(const T& value);
+  template <typename... Args>
+  T& emplace_back(Args&&... args);
+  void pop_back();
+
+  iterator insert(const_iterator pos, const T& value);
+  // As for std::vector, the range must not point into this container.
+  template <
+      typename InputIt,
+      typename = typename std::iterator_traits<InputIt>::iterator_category>
+  iterator insert(const_iterator pos, InputIt first, InputIt last);
+
+  iterator erase(const_iterator pos);
+  iterator erase(const_iterator first, const_iterator last);
+
+  T* data();
+  const T* data() const;
+
+  iterator begin();
+  iterator end();
+  const_iterator begin() const;
+  const_iterator end() const;
+  const_iterator cbegin() const;
+  const_iterator cend() const;
+
+  // Throws std::out_of_range if the index is out of bounds.
+  T& at(size_t idx);
+  const T& at(size_t idx) const;
+
+  T& operator[](size_t idx);
+  const T& operator[](size_t idx) const;
+
+  T& front();
+  const T& front() const;
+  T& back();
+  const T& back() const;
+
+  bool operator==(const SmallVector& other) const;
+  bool operator!=(const SmallVector& other) const;
+
+ private:
+  bool IsInline() const;
+  // Moves the elements to storage for exactly the given capacity, which is
+  // the inline storage if it fits the capacity.
+  void Reallocate(size_t new_capacity);
+  // Ensures capacity for the given number of elements with geometric growth.
+  void Grow(size_t min_capacity);
+
+  union {
+    T* heap_;
+    alignas(T) unsigned char inline_[N * sizeof(T)];
+  };
+  uint32_t size_ = 0;
+  uint32_t capacity_ = N;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T, size_t N>
+SmallVector<T, N>::SmallVector(const size_t count, const T& value) {
+  resize(count, value);
+}
+
+template <typename T, size_t N>
+template <typename InputIt, typename>
+SmallVector<T, N>::SmallVector(InputIt first, InputIt last) {
+  assign(first, last);
+}
+
+template <typename T, size_t N>
+SmallVector<T, N>::SmallVector(std::initializer_list<T> init) {
+  assign(init.begin(), init.end());
+}
+
+template <typename T, size_t N>
+SmallVector<T, N>::SmallVector(const SmallVector& other) {
+  reserve(other.size_);
+  std::memcpy(data(), other.data(), other.size_ * sizeof(T));
+  size_ = other.size_;
+}
+
+template <typename T, size_t N>
+SmallVector<T, N>& SmallVector<T, N>::operator=(const SmallVector& other) {
+  if (this != &other) {
+    clear();
+    reserve(other.size_);
+    std::memcpy(data(), other.data(), other.size_ * sizeof(T));
+    size_ = other.size_;
+  }
+  return *this;
+}
+
+template <typename T, size_t N>
+SmallVector<T, N>::SmallVector(SmallVector&& other) noexcept
+    : size_(other.size_), capacity_(other.capacity_) {
+  if (other.IsInline()) {
+    std::memcpy(inline_, other.inline_, size_ * sizeof(T));
+  } else {
+    heap_ = other.heap_;
+    other.capacity_ = N;
+  }
+  other.size_ = 0;
+}
+
+template <typename T, size_t N>
+SmallVector<T, N>& SmallVector<T, N>::operator=(SmallVector&& other) noexcept {
+  if (this != &other) {
+    if (!IsInline()) {
+      ::operator delete(heap_);
+    }
+    size_ = other.size_;
+    capacity_ = other.capacity_;
+    if (other.IsInline()) {
+      std::memcpy(inline_, other.inline_, size_ * sizeof(T));
+    } else {
+      heap_ = other.heap_;
+      other.capacity_ = N;
+    }
+    other.size_ = 0;
+  }
+  return *this;
+}
+
+template <typename T, size_t N>
+SmallVector<T, N>::~SmallVector() {
+  if (!IsInline()) {
+    ::operator delete(heap_);
+  }
+}
+
+template <typename T, size_t N>
+size_t SmallVector<T, N>::size() const {
+  return size_;
+}
+
+template <typename T, size_t N>
+bool SmallVector<T, N>::empty() const {
+  return size_ == 0;
+}
+
+template <typename T, size_t N>
+size_t SmallVector<T, N>::capacity() const {
+  return capacity_;
+}
+
+template <typename T, size_t N>
+void SmallVector<T, N>::reserve(const size_t new_capacity) {
+  if (new_capacity > capacity_) {
+    Reallocate(new_capacity);
+  }
+}
+
+template <typename T, size_t N>
+void SmallVector<T, N>::shrink_to_fit() {
+  if (!IsInline() && size_ < capacity_) {
+    Reallocate(size_);
+  }
+}
+
+template <typename T, size_t N>
+void SmallVector<T, N>::resize(const size_t new_size) {
+  Grow(new_size);
+  for (size_t i = size_; i < new_size; ++i) {
+    new (data() + i) T();
+  }
+  size_ = static_cast<uint32_t>(new_size);
+}
+
+template <typename T, size_t N>
+void SmallVector<T, N>::resize(const size_t new_size, const T& value) {
+  if (new_size > size_) {
+    const T copy = value;
+    Grow(new_size);
+    std::fill(data() + size_, data() + new_size, copy);
+  }
+  size_ = static_cast<uint32_t>(new_size);
+}
+
+template <typename T, size_t N>
+void SmallVector<T, N>::clear() {
+  size_ = 0;
+}
+
+template <typename T, size_t N>
+template <typename InputIt, typename>
+void SmallVector<T, N>::assign(InputIt first, InputIt last) {
+  clear();
+  insert(end(), first, last);
+}
+
+template <typename T, size_t N>
+void SmallVector<T, N>::push_back(const T& value) {
+  emplace_back(value);
+}
+
+template <typename T, size_t N>
+template <typename... Args>
+T& SmallVector<T, N>::emplace_back(Args&&... args) {
+  // Construct the element before growing, since the arguments may refer to
+  // elements of this container.
+  const T value(std::forward<Args>(args)...);
+  Grow(size_ + 1);
+  T* element = data() + size_;
+  std::memcpy(element, &value, sizeof(T));
+  ++size_;
+  return *element;
+}
+
+template <typename T, size_t N>
+void SmallVector<T, N>::pop_back() {
+  --size_;
+}
+
+template <typename T, size_t N>
+typename SmallVector<T, N>::iterator SmallVector<T, N>::insert(
+    const_iterator pos, const T& value) {
+  // Copy the value, since it may refer to an element that is shifted.
+  const T copy = value;
+  return insert(pos, &copy, &copy + 1);
+}
+
+template <typename T, size_t N>
+template <typename InputIt, typename>
+typename SmallVector<T, N>::iterator SmallVector<T, N>::insert(
+    const_iterator pos, InputIt first, InputIt last) {
+  const size_t idx = pos - begin();
+  using Category = typename std::iterator_traits<InputIt>::iterator_category;
+  if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+    const size_t count = std::distance(first, last);
+    if (count == 0) {
+      return begin() + idx;
+    }
+    if (size_ + count > capacity_) {
+      // Copy into the new storage before releasing the old one, since a
+      // single inserted element may refer to an element of this container.
+      SmallVector grown;
+      grown.Reallocate(std::max<size_t>(size_ + count, 2 * size_t(capacity_)));
+      T* dest = grown.data();
+      std::memcpy(dest, data(), idx * sizeof(T));
+      std::copy(first, last, dest + idx);
+      std::memcpy(dest + idx + count, data() + idx, (size_ - idx) * sizeof(T));
+      grown.size_ = static_cast<uint32_t>(size_ + count);
+      *this = std::move(grown);
+      return begin() + idx;
+    }
+    T* dest = data() + idx;
+    std::memmove(dest + count, dest, (size_ - idx) * sizeof(T));
+    std::copy(first, last, dest);
+    size_ += static_cast<uint32_t>(count);
+    return dest;
+  } else {
+    SmallVector range;
+    for (; first != last; ++first) {
+      range.push_back(*first);
+    }
+    return insert(begin() + idx, range.begin(), range.end());
+  }
+}
+
+template <typename T, size_t N>
+typename SmallVector<T, N>::iterator SmallVector<T, N>::erase(
+    const_iterator pos) {
+  return erase(pos, pos + 1);
+}
+
+template <typename T, size_t N>
+typename SmallVector<T, N>::iterator SmallVector<T, N>::erase(
+    const_iterator first, const_iterator last) {
+  T* dest = begin() + (first - begin());
+  const size_t count = last - first;
+  std::memmove(dest, last, (end() - last) * sizeof(T));
+  size_ -= count;
+  return dest;
+}
+
+template <typename T, size_t N>
+T* SmallVector<T, N>::data() {
+  return IsInline() ? reinterpret_cast<T*>(inline_) : heap_;
+}
+
+template <typename T, size_t N>
+const T* SmallVector<T, N>::data() const {
+  return IsInline() ? reinterpret_cast<const T*>(inline_) : heap_;
+}
+
+template <typename T, size_t N>
+typename SmallVector<T, N>::iterator SmallVector<T, N>::begin() {
+  return data();
+}
+
+template <typename T, size_t N>
+typename SmallVector<T, N>::iterator SmallVector<T, N>::end() {
+  return data() + size_;
+}
+
+template <typename T, size_t N>
+typename SmallVector<T, N>::const_iterator SmallVector<T, N>::begin() const {
+  return data();
+}
+
+template <typename T, size_t N>
+typename SmallVector<T, N>::const_iterator SmallVector<T, N>::end() const {
+  return data() + size_;
+}
+
+template <typename T, size_t N>
+typename SmallVector<T, N>::const_iterator SmallVector<T, N>::cbegin() const {
+  return begin();
+}
+
+template <typename T, size_t N>
+typename SmallVector<T, N>::const_iterator SmallVector<T, N>::cend() const {
+  return end();
+}
+
+template <typename T, size_t N>
+T& SmallVector<T, N>::at(const size_t idx) {
+  if (idx >= size_) {
+    throw std::out_of_range("SmallVector::at");
+  }
+  return data()[idx];
+}
+
+template <typename T, size_t N>
+const T& SmallVector<T, N>::at(const size_t idx) const {
+  if (idx >= size_) {
+    throw std::out_of_range("SmallVector::at");
+  }
+  return data()[idx];
+}
+
+template <typename T, size_t N>
+T& SmallVector<T, N>::operator[](const size_t idx) {
+  return data()[idx];
+}
+
+template <typename T, size_t N>
+const T& SmallVector<T, N>::operator[](const size_t idx) const {
+  return data()[idx];
+}
+
+template <typename T, size_t N>
+T& SmallVector<T, N>::front() {
+  return data()[0];
+}
+
+template <typename T, size_t N>
+const T& SmallVector<T, N>::front() const {
+  return data()[0];
+}
+
+template <typename T, size_t N>
+T& SmallVector<T, N>::back() {
+  return data()[size_ - 1];
+}
+
+template <typename T, size_t N>
+const T& SmallVector<T, N>::back() const {
+  return data()[size_ - 1];
+}
+
+template <typename T, size_t N>
+bool SmallVector<T, N>::operator==(const SmallVector& other) const {
+  return std::equal(begin(), end(), other.begin(), other.end());
+}
+
+template <typename T, size_t N>
+bool SmallVector<T, N>::operator!=(const SmallVector& other) const {
+  return !(*this == other);
+}
+
+template <typename T, size_t N>
+bool SmallVector<T, N>::IsInline() const {
+  return capacity_ == N;
+}
+
+template <typename T, size_t N>
+void SmallVector<T, N>::Reallocate(size_t new_capacity) {
+  if (new_capacity > std::numeric_limits<uint32_t>::max()) {
+    throw std::length_error("SmallVector exceeds maximum size");
+  }
+  new_capacity = std::max(new_capacity, N);
+  if (new_capacity == capacity_) {
+    return;
+  }
+  T* new_data = new_capacity == N ? nullptr
+                                  : static_cast<T*>(::operator new(
+                                        new_capacity * sizeof(T)));
+  T* old_data = data();
+  const bool was_inline = IsInline();
+  if (new_data == nullptr) {
+    // Moving from the heap back into the inline storage, which overlaps the
+    // heap pointer.
+    std::memcpy(inline_, old_data, size_ * sizeof(T));
+  } else {
+    std::memcpy(new_data, old_data, size_ * sizeof(T));
+    heap_ = new_data;
+  }
+  if (!was_inline) {
+    ::operator delete(old_data);
+  }
+  capacity_ = static_cast<uint32_t>(new_capacity);
+}
+
+template <typename T, size_t N>
+void SmallVector<T, N>::Grow(const size_t min_capacity) {
+  if (min_capacity > capacity_) {
+    Reallocate(std::max<size_t>(min_capacity, 2 * size_t(capacity_)));
+  }
+}
+
+}  // namespace colmap
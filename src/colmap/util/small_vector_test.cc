@@ -0,0 +1,184 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "colmap/util/small_vector.h"
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+TEST(SmallVector, Empty) {
+  SmallVector<int, 2> vector;
+  EXPECT_EQ(vector.size(), 0);
+  EXPECT_TRUE(vector.empty());
+  EXPECT_EQ(vector.capacity(), 2);
+  EXPECT_EQ(vector.begin(), vector.end());
+  EXPECT_ANY_THROW(vector.at(0));
+}
+
+TEST(SmallVector, PushBackGrowsFromInlineToHeap) {
+  SmallVector<int, 2> vector;
+  const int* inline_data = vector.data();
+  vector.push_back(1);
+  vector.emplace_back(2);
+  EXPECT_EQ(vector.data(), inline_data);
+  EXPECT_EQ(vector.capacity(), 2);
+  vector.push_back(3);
+  EXPECT_NE(vector.data(), inline_data);
+  EXPECT_EQ(vector.capacity(), 4);
+  EXPECT_THAT(vector, testing::ElementsAre(1, 2, 3));
+  EXPECT_EQ(vector.front(), 1);
+  EXPECT_EQ(vector.back(), 3);
+  EXPECT_EQ(vector.at(1), 2);
+  EXPECT_ANY_THROW(vector.at(3));
+  vector.pop_back();
+  EXPECT_THAT(vector, testing::ElementsAre(1, 2));
+}
+
+TEST(SmallVector, PushBackOwnElement) {
+  SmallVector<int, 2> vector = {1, 2};
+  vector.push_back(vector[0]);
+  vector.push_back(vector[2]);
+  EXPECT_THAT(vector, testing::ElementsAre(1, 2, 1, 1));
+}
+
+TEST(SmallVector, Construct) {
+  EXPECT_THAT((SmallVector<int, 2>(3, 7)), testing::ElementsAre(7, 7, 7));
+  const std::vector<int> values = {1, 2, 3};
+  EXPECT_THAT((SmallVector<int, 2>(values.begin(), values.end())),
+              testing::ElementsAre(1, 2, 3));
+  const std::list<int> list = {4, 5};
+  EXPECT_THAT((SmallVector<int, 1>(list.begin(), list.end())),
+              testing::ElementsAre(4, 5));
+  std::istringstream stream("6 7 8");
+  EXPECT_THAT((SmallVector<int, 2>(std::istream_iterator<int>(stream),
+                                   std::istream_iterator<int>())),
+              testing::ElementsAre(6, 7, 8));
+}
+
+TEST(SmallVector, Insert) {
+  SmallVector<int, 4> vector = {1, 4};
+  const std::vector<int> values = {2, 3};
+  EXPECT_EQ(*vector.insert(vector.begin() + 1, values.begin(), values.end()),
+            2);
+  EXPECT_THAT(vector, testing::ElementsAre(1, 2, 3, 4));
+  EXPECT_EQ(vector.capacity(), 4);
+  EXPECT_EQ(*vector.insert(vector.end(), 5), 5);
+  EXPECT_EQ(*vector.insert(vector.begin(), vector[1]), 2);
+  EXPECT_THAT(vector, testing::ElementsAre(2, 1, 2, 3, 4, 5));
+  EXPECT_EQ(*vector.insert(vector.begin(), vector[5]), 5);
+  EXPECT_THAT(vector, testing::ElementsAre(5, 2, 1, 2, 3, 4, 5));
+}
+
+TEST(SmallVector, Erase) {
+  SmallVector<int, 2> vector = {1, 2, 3, 4, 5};
+  EXPECT_EQ(*vector.erase(vector.begin() + 1), 3);
+  EXPECT_THAT(vector, testing::ElementsAre(1, 3, 4, 5));
+  const auto it = vector.erase(vector.begin() + 2, vector.end());
+  EXPECT_EQ(it, vector.end());
+  EXPECT_THAT(vector, testing::ElementsAre(1, 3));
+  vector.erase(std::remove(vector.begin(), vector.end(), 1), vector.end());
+  EXPECT_THAT(vector, testing::ElementsAre(3));
+}
+
+TEST(SmallVector, Resize) {
+  SmallVector<int, 2> vector;
+  vector.resize(3);
+  EXPECT_THAT(vector, testing::ElementsAre(0, 0, 0));
+  vector.resize(1);
+  EXPECT_THAT(vector, testing::ElementsAre(0));
+  vector.resize(2, 5);
+  EXPECT_THAT(vector, testing::ElementsAre(0, 5));
+  vector.clear();
+  EXPECT_TRUE(vector.empty());
+  EXPECT_EQ(vector.capacity(), 4);
+}
+
+TEST(SmallVector, ReserveAndShrinkToFit) {
+  SmallVector<int, 2> vector = {1};
+  vector.reserve(2);
+  EXPECT_EQ(vector.capacity(), 2);
+  vector.reserve(5);
+  EXPECT_EQ(vector.capacity(), 5);
+  vector.push_back(2);
+  vector.push_back(3);
+  vector.shrink_to_fit();
+  EXPECT_EQ(vector.capacity(), 3);
+  EXPECT_THAT(vector, testing::ElementsAre(1, 2, 3));
+  vector.pop_back();
+  vector.shrink_to_fit();
+  EXPECT_EQ(vector.capacity(), 2);
+  EXPECT_THAT(vector, testing::ElementsAre(1, 2));
+}
+
+TEST(SmallVector, CopyAndMove) {
+  for (const int size : {1, 3}) {
+    SmallVector<int, 2> vector;
+    for (int i = 0; i < size; ++i) {
+      vector.push_back(i);
+    }
+
+    SmallVector<int, 2> copy(vector);
+    EXPECT_EQ(copy, vector);
+    copy[0] = 10;
+    EXPECT_NE(copy, vector);
+    copy = vector;
+    EXPECT_EQ(copy, vector);
+
+    SmallVector<int, 2> moved(std::move(copy));
+    EXPECT_EQ(moved, vector);
+    EXPECT_TRUE(copy.empty());  // NOLINT(bugprone-use-after-move)
+    copy.push_back(1);
+    SmallVector<int, 2> move_assigned = {4, 5, 6};
+    move_assigned = std::move(moved);
+    EXPECT_EQ(move_assigned, vector);
+  }
+}
+
+TEST(SmallVector, Equals) {
+  SmallVector<int, 2> vector = {1, 2, 3};
+  SmallVector<int, 2> other = {1, 2};
+  EXPECT_NE(vector, other);
+  other.push_back(3);
+  EXPECT_EQ(vector, other);
+  other.back() = 4;
+  EXPECT_NE(vector, other);
+}
+
+}  // namespace
+}  // namespace colmap
@@ -30,6 +30,18 @@
 #include "colmap/util/threading.h"
 
 #include "colmap/util/logging.h"
+#include "colmap/util/string.h"
+
+#include <atomic>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 namespace colmap {
 
@@ -181,8 +193,8 @@ void Thread::RunFunc() {
   Callback(FINISHED_CALLBACK);
 }
 
-ThreadPool::ThreadPool(const int num_threads)
-    : stopped_(false), num_active_workers_(0) {
+ThreadPool::ThreadPool(const int num_threads, const int numa_node)
+    : numa_node_(numa_node), stopped_(false), num_active_workers_(0) {
   const int num_effective_threads = GetEffectiveNumThreads(num_threads);
   for (int index = 0; index < num_effective_threads; ++index) {
     std::function<void(void)> worker =
@@ -229,8 +241,75 @@ void ThreadPool::Stop() {
   finished_condition_.notify_all();
 }
 
+void ThreadPool::ParallelFor(const int64_t begin,
+                             const int64_t end,
+                             const std::function<void(int64_t)>& func,
+                             const int num_threads) {
+  if (begin >= end) {
+    return;
+  }
+
+  // The state outlives the call, since tasks may only start after all
+  // iterations were claimed by other threads. Such tasks do not access func.
+  struct State {
+    std::atomic<int64_t> next_index;
+    int64_t num_finished = 0;
+    std::exception_ptr exception;
+    std::mutex mutex;
+    std::condition_variable finished_condition;
+  };
+  auto state = std::make_shared<State>();
+  state->next_index = begin;
+  const int64_t num_iterations = end - begin;
+
+  auto RunIterations = [state, &func, end, num_iterations]() {
+    int64_t num_finished = 0;
+    std::exception_ptr exception;
+    for (int64_t index = state->next_index++; index < end;
+         index = state->next_index++) {
+      try {
+        func(index);
+      } catch (...) {
+        if (!exception) {
+          exception = std::current_exception();
+        }
+      }
+      num_finished += 1;
+    }
+    if (num_finished == 0) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->num_finished += num_finished;
+    if (exception && !state->exception) {
+      state->exception = exception;
+    }
+    if (state->num_finished == num_iterations) {
+      state->finished_condition.notify_all();
+    }
+  };
+
+  const int64_t max_num_tasks =
+      num_threads <= 0 ? static_cast<int64_t>(NumThreads()) : num_threads - 1;
+  const int64_t num_tasks = std::min(max_num_tasks, num_iterations - 1);
+  for (int64_t i = 0; i < num_tasks; ++i) {
+    AddTaskWithPriority(kParallelForPriority, RunIterations);
+  }
+
+  RunIterations();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->finished_condition.wait(
+      lock, [&]() { return state->num_finished == num_iterations; });
+  if (state->exception) {
+    std::rethrow_exception(state->exception);
+  }
+}
+
 void ThreadPool::Wait() {
   std::unique_lock<std::mutex> lock(mutex_);
+  THROW_CHECK_EQ(thread_id_to_index_.count(GetThreadId()), 0)
+      << "Cannot wait for the tasks of a thread pool from within its tasks.";
   if (!tasks_.empty() || num_active_workers_ > 0) {
     finished_condition_.wait(
         lock, [this]() { return tasks_.empty() && num_active_workers_ == 0; });
@@ -256,6 +335,12 @@ void ThreadPool::CheckFinishedTasks() {
 }
 
 void ThreadPool::WorkerFunc(const int index) {
+  const int num_numa_nodes = GetNumNumaNodes();
+  if (num_numa_nodes > 1) {
+    PinThreadToNumaNode(numa_node_ == kAnyNumaNode ? index % num_numa_nodes
+                                                   : numa_node_);
+  }
+
   {
     std::lock_guard<std::mutex> lock(mutex_);
     thread_id_to_index_.emplace(GetThreadId(), index);
@@ -270,8 +355,9 @@ void ThreadPool::WorkerFunc(const int index) {
       if (stopped_ && tasks_.empty()) {
         return;
       }
-      task = std::move(tasks_.front());
-      tasks_.pop();
+      std::pop_heap(tasks_.begin(), tasks_.end());
+      task = std::move(tasks_.back().func);
+      tasks_.pop_back();
       num_active_workers_ += 1;
     }
 
@@ -280,13 +366,20 @@ void ThreadPool::WorkerFunc(const int index) {
     {
       std::unique_lock<std::mutex> lock(mutex_);
       num_active_workers_ -= 1;
-      finished_task_checkers_.push_back(std::move(finished_task_checker));
+      if (finished_task_checker) {
+        finished_task_checkers_.push_back(std::move(finished_task_checker));
+      }
     }
 
     finished_condition_.notify_all();
   }
 }
 
+size_t ThreadPool::NumFailedTasks() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return finished_task_checkers_.size();
+}
+
 std::thread::id ThreadPool::GetThreadId() const {
   return std::this_thread::get_id();
 }
@@ -309,4 +402,175 @@ int GetEffectiveNumThreads(const int num_threads) {
   return num_effective_threads;
 }
 
+namespace {
+
+std::atomic<bool> numa_aware_threading(false);
+thread_local int thread_numa_node = -1;
+
+}  // namespace
+
+void SetNumaAwareThreading(const bool enabled) {
+  numa_aware_threading = enabled;
+}
+
+bool IsNumaAwareThreading() { return numa_aware_threading; }
+
+const std::vector<std::vector<int>>& GetNumaNodeCpus() {
+  static const std::vector<std::vector<int>> numa_node_cpus = []() {
+    std::vector<std::vector<int>> numa_node_cpus;
+#if defined(__linux__)
+    const std::filesystem::path nodes_path = "/sys/devices/system/node";
+    std::error_code error;
+    std::map<int, std::vector<int>> node_cpus;
+    for (const auto& entry :
+         std::filesystem::directory_iterator(nodes_path, error)) {
+      const std::string name = entry.path().filename().string();
+      if (!StringStartsWith(name, "node") || name.size() == 4 ||
+          !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+        continue;
+      }
+      std::ifstream file(entry.path() / "cpulist");
+      std::string cpu_list;
+      if (!std::getline(file, cpu_list)) {
+        continue;
+      }
+      std::vector<int> cpus = internal::ParseCpuList(cpu_list);
+      if (!cpus.empty()) {
+        node_cpus.emplace(std::stoi(name.substr(4)), std::move(cpus));
+      }
+    }
+    for (auto& [node, cpus] : node_cpus) {
+      numa_node_cpus.push_back(std::move(cpus));
+    }
+#endif
+    return numa_node_cpus;
+  }();
+  return numa_node_cpus;
+}
+
+int GetNumNumaNodes() {
+  if (!IsNumaAwareThreading()) {
+    return 1;
+  }
+  return std::max(1, static_cast<int>(GetNumaNodeCpus().size()));
+}
+
+bool PinThreadToNumaNode(const int numa_node) {
+#if defined(__linux__)
+  const std::vector<std::vector<int>>& numa_node_cpus = GetNumaNodeCpus();
+  if (numa_node < 0 || numa_node >= static_cast<int>(numa_node_cpus.size())) {
+    return false;
+  }
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (const int cpu : numa_node_cpus[numa_node]) {
+    CPU_SET(cpu, &cpu_set);
+  }
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) !=
+      0) {
+    return false;
+  }
+  thread_numa_node = numa_node;
+  return true;
+#else
+  return false;
+#endif
+}
+
+int GetThreadNumaNode() { return thread_numa_node; }
+
+NumaThreadPool::NumaThreadPool(const int num_threads) {
+  const int num_effective_threads = GetEffectiveNumThreads(num_threads);
+  const int num_nodes = std::min(GetNumNumaNodes(), num_effective_threads);
+  if (num_nodes <= 1) {
+    thread_pools_.push_back(
+        std::make_unique<ThreadPool>(num_effective_threads));
+    return;
+  }
+  for (int node = 0; node < num_nodes; ++node) {
+    const int num_node_threads = num_effective_threads / num_nodes +
+                                 (node < num_effective_threads % num_nodes);
+    thread_pools_.push_back(
+        std::make_unique<ThreadPool>(num_node_threads, node));
+  }
+}
+
+void NumaThreadPool::Wait() {
+  std::vector<std::exception_ptr> exceptions;
+  for (auto& thread_pool : thread_pools_) {
+    try {
+      thread_pool->Wait();
+    } catch (const AggregateException& e) {
+      exceptions.insert(
+          exceptions.end(), e.exceptions().begin(), e.exceptions().end());
+    }
+  }
+  if (!exceptions.empty()) {
+    throw AggregateException(std::move(exceptions));
+  }
+}
+
+ThreadPool& GetSharedThreadPool() {
+  static ThreadPool thread_pool;
+  return thread_pool;
+}
+
+void ParallelFor(const int64_t begin,
+                 const int64_t end,
+                 const std::function<void(int64_t, int64_t)>& func,
+                 const int num_threads,
+                 const int64_t grain_size) {
+  if (begin >= end) {
+    return;
+  }
+  const int64_t chunk_size =
+      internal::GetParallelChunkSize(end - begin, num_threads, grain_size);
+  const int64_t num_chunks = (end - begin + chunk_size - 1) / chunk_size;
+  GetSharedThreadPool().ParallelFor(
+      0,
+      num_chunks,
+      [&](const int64_t chunk_idx) {
+        const int64_t chunk_begin = begin + chunk_idx * chunk_size;
+        func(chunk_begin, std::min(end, chunk_begin + chunk_size));
+      },
+      num_threads);
+}
+
+namespace internal {
+
+int64_t GetParallelChunkSize(const int64_t num_iterations,
+                             const int num_threads,
+                             const int64_t grain_size) {
+  if (grain_size > 0) {
+    return grain_size;
+  }
+  // A few chunks per thread balance the load of uneven iterations.
+  constexpr int64_t kNumChunksPerThread = 4;
+  const int64_t num_chunks =
+      kNumChunksPerThread * GetEffectiveNumThreads(num_threads);
+  return std::max<int64_t>(1, (num_iterations + num_chunks - 1) / num_chunks);
+}
+
+std::vector<int> ParseCpuList(const std::string& cpu_list) {
+  std::vector<int> cpus;
+  for (std::string range : StringSplit(cpu_list, ",")) {
+    StringTrim(&range);
+    if (range.empty()) {
+      continue;
+    }
+    const std::vector<std::string> bounds = StringSplit(range, "-");
+    THROW_CHECK(bounds.size() == 1 || bounds.size() == 2)
+        << "Invalid CPU list: " << cpu_list;
+    const int first_cpu = std::stoi(bounds[0]);
+    const int last_cpu = std::stoi(bounds.back());
+    THROW_CHECK_LE(first_cpu, last_cpu) << "Invalid CPU list: " << cpu_list;
+    for (int cpu = first_cpu; cpu <= last_cpu; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+}  // namespace internal
+
 }  // namespace colmap
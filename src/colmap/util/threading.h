@@ -31,15 +31,23 @@
 
 #include "colmap/util/timer.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <climits>
+#include <cstdint>
 #include <functional>
 #include <future>
+#include <iterator>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <string>
 #include <thread>
 #include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 namespace colmap {
 
@@ -150,6 +158,10 @@ class Thread {
   // Call back to the function with the specified name, if it exists.
   void Callback(int id) const;
 
+  // The number of finished tasks whose exceptions were not yet rethrown by
+  // Wait(). Tasks that finished without an exception are not kept track of.
+  size_t NumFailedTasks();
+
   // Get the unique identifier of the current thread.
   std::thread::id GetThreadId() const;
 
@@ -227,10 +239,22 @@ class AggregateException : public std::exception {
 // Exceptions thrown from the tasks are caught and propagated to the caller
 // through both the returned future and the Wait() call. Wait() throws an
 // AggregateException containing all task exceptions at once.
+//
+// Tasks with a higher priority are started first and tasks with the same
+// priority in the order they were added. Data-parallel loops should use
+// ParallelFor, which may also be called from within tasks of the same pool.
 class ThreadPool {
  public:
   static const int kMaxNumThreads = -1;
 
+  // Priority of the tasks of ParallelFor, such that nested loops finish
+  // before other queued tasks are started.
+  static const int kParallelForPriority = INT_MAX;
+
+  // Without a NUMA node, the workers are distributed round-robin over the
+  // NUMA nodes, if NUMA-aware threading is enabled.
+  static const int kAnyNumaNode = -1;
+
   template <class func_t, class... args_t>
 #ifdef __cpp_lib_is_invocable
   using result_of_t = std::invoke_result_t<func_t, args_t...>;
@@ -238,7 +262,10 @@ class ThreadPool {
   using result_of_t = typename std::result_of<func_t(args_t...)>::type;
 #endif
 
-  explicit ThreadPool(int num_threads = kMaxNumThreads);
+  // If NUMA-aware threading is enabled, the workers are pinned to the CPUs of
+  // the given NUMA node.
+  explicit ThreadPool(int num_threads = kMaxNumThreads,
+                      int numa_node = kAnyNumaNode);
   ~ThreadPool();
 
   inline size_t NumThreads() const;
@@ -248,12 +275,36 @@ class ThreadPool {
   auto AddTask(func_t&& f, args_t&&... args)
       -> std::shared_future<result_of_t<func_t, args_t...>>;
 
+  // Add new task to the thread pool, which is started before all queued tasks
+  // with a lower priority. AddTask uses a priority of zero.
+  template <class func_t, class... args_t>
+  auto AddTaskWithPriority(int priority, func_t&& f, args_t&&... args)
+      -> std::shared_future<result_of_t<func_t, args_t...>>;
+
+  // Call func(i) for all i in [begin, end) using at most num_threads threads,
+  // including the calling thread, and return once all calls finished. The
+  // iterations are claimed dynamically by the calling thread and the workers,
+  // so the calling thread never blocks on queued tasks. Calls can hence be
+  // nested, e.g., func may itself call ParallelFor on the same pool. The first
+  // exception thrown by func is rethrown after all iterations finished. Note
+  // that func may run on the calling thread, i.e., GetThreadIndex must not be
+  // used inside func.
+  void ParallelFor(int64_t begin,
+                   int64_t end,
+                   const std::function<void(int64_t)>& func,
+                   int num_threads = kMaxNumThreads);
+
   // Stop the execution of all workers.
   void Stop();
 
-  // Wait until tasks are finished.
+  // Wait until tasks are finished. Must not be called from a task of the same
+  // pool, since the task itself would never finish; use ParallelFor instead.
   void Wait();
 
+  // The number of finished tasks whose exceptions were not yet rethrown by
+  // Wait(). Tasks that finished without an exception are not kept track of.
+  size_t NumFailedTasks();
+
   // Get the unique identifier of the current thread.
   std::thread::id GetThreadId() const;
 
@@ -267,8 +318,24 @@ class ThreadPool {
 
   void CheckFinishedTasks();
 
+  struct Task {
+    int priority = 0;
+    // Sequence number of the task to keep the order of equal priorities.
+    uint64_t index = 0;
+    std::function<std::function<void()>()> func;
+    // Order of the heap, where the top task is started first.
+    bool operator<(const Task& other) const {
+      return priority < other.priority ||
+             (priority == other.priority && index > other.index);
+    }
+  };
+
+  const int numa_node_;
   std::vector<std::thread> workers_;
-  std::queue<std::function<std::function<void()>()>> tasks_;
+  // Heap of the queued tasks.
+  std::vector<Task> tasks_;
+  uint64_t num_added_tasks_ = 0;
+  // Checkers of the failed tasks, which rethrow their exceptions in Wait().
   std::vector<std::function<void()>> finished_task_checkers_;
 
   std::mutex mutex_;
@@ -335,6 +402,10 @@ class JobQueue {
   // Pop a job from the queue. Waits if there is no job in the queue.
   Job Pop();
 
+  // Pop a job from the queue. Waits until the deadline if there is no job in
+  // the queue and returns an invalid job, if the deadline expired.
+  Job PopUntil(std::chrono::steady_clock::time_point deadline);
+
   // Wait for all jobs to be popped and then stop the queue.
   void Wait();
 
@@ -354,19 +425,222 @@ class JobQueue {
   std::condition_variable empty_condition_;
 };
 
+// A job queue with the same interface and semantics as JobQueue, which is
+// implemented as a lock-free bounded ring buffer for multiple producers and
+// multiple consumers. Push and pop only take a lock to park, once the queue
+// stayed full or empty for a short spin, e.g., in pipelines that process many
+// small jobs at a high rate.
+template <typename T>
+class LockFreeJobQueue {
+ public:
+  using Job = typename JobQueue<T>::Job;
+
+  // The capacity is rounded up to the next power of two of at least two.
+  explicit LockFreeJobQueue(size_t max_num_jobs);
+  ~LockFreeJobQueue();
+
+  // The number of pushed and not popped jobs in the queue.
+  size_t Size() const;
+
+  // Push a new job to the queue. Waits if the number of jobs is exceeded.
+  bool Push(T data);
+
+  // Push the jobs in order. Waits whenever the number of jobs is exceeded and
+  // returns false without pushing the remaining jobs, if the queue stopped.
+  bool PushBatch(std::vector<T> data);
+
+  // Pop a job from the queue. Waits if there is no job in the queue.
+  Job Pop();
+
+  // Pop a job from the queue. Waits until the deadline if there is no job in
+  // the queue and returns an invalid job, if the deadline expired.
+  Job PopUntil(std::chrono::steady_clock::time_point deadline);
+
+  // Pop at least one and at most max_num_jobs jobs from the queue and append
+  // them to jobs. Only waits for the first job. Returns the number of popped
+  // jobs, which is zero if the queue stopped.
+  size_t PopBatch(size_t max_num_jobs, std::vector<T>* jobs);
+
+  // Wait for all jobs to be popped and then stop the queue.
+  void Wait();
+
+  // Stop the queue and return from all push/pop calls with false.
+  void Stop();
+
+  // Clear all pushed and not popped jobs from the queue.
+  void Clear();
+
+ private:
+  // Number of attempts before parking, of which the first ones busy wait and
+  // the remaining ones yield.
+  static constexpr int kNumSpins = 64;
+  static constexpr int kNumBusySpins = 16;
+
+  bool TryPush(T* data);
+  bool TryPop(T* data);
+
+  // Repeatedly call done() until it returns true or the deadline expired.
+  // Returns the result of the last call.
+  template <typename Func>
+  bool SpinThenPark(Func&& done,
+                    std::chrono::steady_clock::time_point deadline);
+
+  // Wake up all parked threads after a change of the queue.
+  void NotifyParked();
+
+  // Each cell stores its sequence number, which encodes whether it is ready
+  // to be pushed or popped at the current positions, see D. Vyukov, "Bounded
+  // MPMC queue".
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  alignas(64) std::atomic<size_t> push_pos_;
+  alignas(64) std::atomic<size_t> pop_pos_;
+  alignas(64) std::atomic<bool> stop_;
+  std::atomic<int> num_parked_;
+  std::mutex park_mutex_;
+  std::condition_variable park_condition_;
+};
+
 // Return the number of logical CPU cores if num_threads <= 0,
 // otherwise return the input value of num_threads.
 int GetEffectiveNumThreads(int num_threads);
 
+// NUMA-aware thread placement. If enabled, the workers of thread pools created
+// afterwards are pinned to the CPUs of a single NUMA node each. By the
+// first-touch policy of the operating system, the memory that tasks allocate
+// and first write is then placed on the node of their worker, so that it is
+// accessed locally. Only supported on Linux and disabled by default.
+void SetNumaAwareThreading(bool enabled);
+bool IsNumaAwareThreading();
+
+// Return the logical CPUs of each NUMA node of the system or an empty list,
+// if the topology is unknown.
+const std::vector<std::vector<int>>& GetNumaNodeCpus();
+
+// Return the number of NUMA nodes to distribute threads over, which is one
+// if NUMA-aware threading is disabled or not supported.
+int GetNumNumaNodes();
+
+// Pin the calling thread to the CPUs of the given NUMA node and return whether
+// it succeeded.
+bool PinThreadToNumaNode(int numa_node);
+
+// Return the NUMA node the calling thread is pinned to or -1.
+int GetThreadNumaNode();
+
+// One thread pool per NUMA node, whose workers are pinned to the node, such
+// that items can be partitioned per node. The threads are split evenly over
+// the nodes. Without NUMA-aware threading, there is a single pool.
+class NumaThreadPool {
+ public:
+  explicit NumaThreadPool(int num_threads = ThreadPool::kMaxNumThreads);
+
+  inline int NumNodes() const;
+  inline ThreadPool& Node(int node);
+
+  // Wait until the tasks of all nodes are finished.
+  void Wait();
+
+ private:
+  std::vector<std::unique_ptr<ThreadPool>> thread_pools_;
+};
+
+// Process-wide thread pool with one worker per logical CPU core. Short
+// data-parallel loops should use its ParallelFor instead of creating their own
+// pools, which avoids oversubscribing the cores when called concurrently from
+// multiple threads or nested within each other.
+ThreadPool& GetSharedThreadPool();
+
+// Call func(chunk_begin, chunk_end) for consecutive chunks of [begin, end) on
+// the shared thread pool using at most num_threads threads. The chunks have
+// grain_size iterations except for the last one. If grain_size <= 0, the
+// iterations are split into a few chunks per thread. Calls can be nested.
+//
+//    ParallelFor(0, values.size(), [&](int64_t begin, int64_t end) {
+//      for (int64_t i = begin; i < end; ++i) {
+//        values[i] = Compute(i);
+//      }
+//    });
+//
+void ParallelFor(int64_t begin,
+                 int64_t end,
+                 const std::function<void(int64_t, int64_t)>& func,
+                 int num_threads = ThreadPool::kMaxNumThreads,
+                 int64_t grain_size = 0);
+
+// Accumulate the iterations of [begin, end) into a separate value per chunk
+// through accumulate(index, &value), starting from init, and then combine the
+// values of all chunks with reduce(value1, value2) in the order of the chunks.
+// The result hence does not depend on the scheduling of the chunks and, with
+// a fixed grain_size, also not on the number of threads.
+//
+//    const double sum = ParallelReduce(
+//        0, values.size(), 0.0,
+//        [&](int64_t i, double* sum) { *sum += values[i]; },
+//        std::plus<double>());
+//
+template <typename T, typename AccumulateFunc, typename ReduceFunc>
+T ParallelReduce(int64_t begin,
+                 int64_t end,
+                 const T& init,
+                 AccumulateFunc&& accumulate,
+                 ReduceFunc&& reduce,
+                 int num_threads = ThreadPool::kMaxNumThreads,
+                 int64_t grain_size = 0);
+
+// Sort the range with the given comparison on the shared thread pool. The
+// chunks of the range are sorted concurrently and then merged pairwise. Like
+// std::sort, the order of equal elements is not preserved.
+template <typename Iterator, typename Compare = std::less<>>
+void ParallelSort(Iterator begin,
+                  Iterator end,
+                  Compare comp = Compare(),
+                  int num_threads = ThreadPool::kMaxNumThreads,
+                  int64_t grain_size = 0);
+
+namespace internal {
+
+// Number of iterations per chunk of the parallel primitives.
+int64_t GetParallelChunkSize(int64_t num_iterations,
+                             int num_threads,
+                             int64_t grain_size);
+
+// Parse a list of CPUs in the format of the Linux sysfs, e.g., "0-3,8,10-11".
+std::vector<int> ParseCpuList(const std::string& cpu_list);
+
+}  // namespace internal
+
 ////////////////////////////////////////////////////////////////////////////////
 // Implementation
 ////////////////////////////////////////////////////////////////////////////////
 
 size_t ThreadPool::NumThreads() const { return workers_.size(); }
 
+int NumaThreadPool::NumNodes() const {
+  return static_cast<int>(thread_pools_.size());
+}
+
+ThreadPool& NumaThreadPool::Node(const int node) {
+  return *thread_pools_.at(node);
+}
+
 template <class func_t, class... args_t>
 auto ThreadPool::AddTask(func_t&& f, args_t&&... args)
     -> std::shared_future<result_of_t<func_t, args_t...>> {
+  return AddTaskWithPriority(
+      0, std::forward<func_t>(f), std::forward<args_t>(args)...);
+}
+
+template <class func_t, class... args_t>
+auto ThreadPool::AddTaskWithPriority(const int priority,
+                                     func_t&& f,
+                                     args_t&&... args)
+    -> std::shared_future<result_of_t<func_t, args_t...>> {
   using return_t = result_of_t<func_t, args_t...>;
 
   auto task = std::make_shared<std::packaged_task<return_t()>>(
@@ -379,10 +653,20 @@ auto ThreadPool::AddTask(func_t&& f, args_t&&... args)
     if (stopped_) {
       throw std::runtime_error("Cannot add task to stopped thread pool.");
     }
-    tasks_.emplace([task = std::move(task), result]() {
-      (*task)();
-      return [result = std::move(result)]() { result.get(); };
-    });
+    tasks_.push_back({priority,
+                      num_added_tasks_++,
+                      [task = std::move(task), result]() {
+                        (*task)();
+                        // Only failed tasks need to be checked by Wait().
+                        std::function<void()> finished_task_checker;
+                        try {
+                          result.get();
+                        } catch (...) {
+                          finished_task_checker = [result]() { result.get(); };
+                        }
+                        return finished_task_checker;
+                      }});
+    std::push_heap(tasks_.begin(), tasks_.end());
   }
 
   task_condition_.notify_one();
@@ -390,6 +674,83 @@ auto ThreadPool::AddTask(func_t&& f, args_t&&... args)
   return result;
 }
 
+template <typename T, typename AccumulateFunc, typename ReduceFunc>
+T ParallelReduce(const int64_t begin,
+                 const int64_t end,
+                 const T& init,
+                 AccumulateFunc&& accumulate,
+                 ReduceFunc&& reduce,
+                 const int num_threads,
+                 const int64_t grain_size) {
+  if (begin >= end) {
+    return init;
+  }
+
+  const int64_t chunk_size =
+      internal::GetParallelChunkSize(end - begin, num_threads, grain_size);
+  const int64_t num_chunks = (end - begin + chunk_size - 1) / chunk_size;
+  std::vector<T> chunk_values(num_chunks, init);
+  GetSharedThreadPool().ParallelFor(
+      0,
+      num_chunks,
+      [&](const int64_t chunk_idx) {
+        T& value = chunk_values[chunk_idx];
+        const int64_t chunk_begin = begin + chunk_idx * chunk_size;
+        const int64_t chunk_end = std::min(end, chunk_begin + chunk_size);
+        for (int64_t index = chunk_begin; index < chunk_end; ++index) {
+          accumulate(index, &value);
+        }
+      },
+      num_threads);
+
+  T result = std::move(chunk_values[0]);
+  for (int64_t chunk_idx = 1; chunk_idx < num_chunks; ++chunk_idx) {
+    result = reduce(std::move(result), std::move(chunk_values[chunk_idx]));
+  }
+  return result;
+}
+
+template <typename Iterator, typename Compare>
+void ParallelSort(Iterator begin,
+                  Iterator end,
+                  Compare comp,
+                  const int num_threads,
+                  const int64_t grain_size) {
+  const int64_t num_elements = std::distance(begin, end);
+  if (num_elements <= 1) {
+    return;
+  }
+
+  const int64_t chunk_size =
+      internal::GetParallelChunkSize(num_elements, num_threads, grain_size);
+  ParallelFor(
+      0,
+      num_elements,
+      [&](const int64_t chunk_begin, const int64_t chunk_end) {
+        std::sort(begin + chunk_begin, begin + chunk_end, comp);
+      },
+      num_threads,
+      chunk_size);
+
+  // Merge neighboring sorted runs of doubling size.
+  for (int64_t run_size = chunk_size; run_size < num_elements;
+       run_size *= 2) {
+    const int64_t num_merges =
+        (num_elements + 2 * run_size - 1) / (2 * run_size);
+    GetSharedThreadPool().ParallelFor(
+        0,
+        num_merges,
+        [&](const int64_t merge_idx) {
+          const int64_t first = 2 * merge_idx * run_size;
+          const int64_t middle = std::min(num_elements, first + run_size);
+          const int64_t last = std::min(num_elements, first + 2 * run_size);
+          std::inplace_merge(
+              begin + first, begin + middle, begin + last, comp);
+        },
+        num_threads);
+  }
+}
+
 template <typename T>
 JobQueue<T>::JobQueue() : JobQueue(std::numeric_limits<size_t>::max()) {}
 
@@ -442,6 +803,29 @@ typename JobQueue<T>::Job JobQueue<T>::Pop() {
   }
 }
 
+template <typename T>
+typename JobQueue<T>::Job JobQueue<T>::PopUntil(
+    const std::chrono::steady_clock::time_point deadline) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (jobs_.empty() && !stop_) {
+    if (push_condition_.wait_until(lock, deadline) ==
+        std::cv_status::timeout) {
+      break;
+    }
+  }
+  if (stop_ || jobs_.empty()) {
+    return Job();
+  } else {
+    Job job(std::move(jobs_.front()));
+    jobs_.pop();
+    pop_condition_.notify_one();
+    if (jobs_.empty()) {
+      empty_condition_.notify_all();
+    }
+    return job;
+  }
+}
+
 template <typename T>
 void JobQueue<T>::Wait() {
   std::unique_lock<std::mutex> lock(mutex_);
@@ -467,4 +851,225 @@ void JobQueue<T>::Clear() {
   std::swap(jobs_, empty_jobs);
 }
 
+template <typename T>
+LockFreeJobQueue<T>::LockFreeJobQueue(const size_t max_num_jobs)
+    : mask_([max_num_jobs]() {
+        size_t capacity = 2;
+        while (capacity < max_num_jobs) {
+          capacity *= 2;
+        }
+        return capacity - 1;
+      }()),
+      cells_(new Cell[mask_ + 1]),
+      push_pos_(0),
+      pop_pos_(0),
+      stop_(false),
+      num_parked_(0) {
+  for (size_t i = 0; i <= mask_; ++i) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+LockFreeJobQueue<T>::~LockFreeJobQueue() {
+  Stop();
+}
+
+template <typename T>
+size_t LockFreeJobQueue<T>::Size() const {
+  const size_t pop_pos = pop_pos_.load(std::memory_order_acquire);
+  const size_t push_pos = push_pos_.load(std::memory_order_acquire);
+  return push_pos > pop_pos ? push_pos - pop_pos : 0;
+}
+
+template <typename T>
+bool LockFreeJobQueue<T>::Push(T data) {
+  bool pushed = false;
+  SpinThenPark(
+      [&]() {
+        if (stop_.load(std::memory_order_acquire)) {
+          return true;
+        }
+        pushed = TryPush(&data);
+        return pushed;
+      },
+      std::chrono::steady_clock::time_point::max());
+  if (pushed) {
+    NotifyParked();
+  }
+  return pushed;
+}
+
+template <typename T>
+bool LockFreeJobQueue<T>::PushBatch(std::vector<T> data) {
+  for (T& job : data) {
+    if (!Push(std::move(job))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+typename LockFreeJobQueue<T>::Job LockFreeJobQueue<T>::Pop() {
+  return PopUntil(std::chrono::steady_clock::time_point::max());
+}
+
+template <typename T>
+typename LockFreeJobQueue<T>::Job LockFreeJobQueue<T>::PopUntil(
+    const std::chrono::steady_clock::time_point deadline) {
+  T data;
+  bool popped = false;
+  SpinThenPark(
+      [&]() {
+        if (stop_.load(std::memory_order_acquire)) {
+          return true;
+        }
+        popped = TryPop(&data);
+        return popped;
+      },
+      deadline);
+  if (!popped) {
+    return Job();
+  }
+  NotifyParked();
+  return Job(std::move(data));
+}
+
+template <typename T>
+size_t LockFreeJobQueue<T>::PopBatch(const size_t max_num_jobs,
+                                     std::vector<T>* jobs) {
+  if (max_num_jobs == 0) {
+    return 0;
+  }
+  Job job = Pop();
+  if (!job.IsValid()) {
+    return 0;
+  }
+  jobs->push_back(std::move(job.Data()));
+  size_t num_popped = 1;
+  T data;
+  while (num_popped < max_num_jobs && !stop_.load(std::memory_order_acquire) &&
+         TryPop(&data)) {
+    jobs->push_back(std::move(data));
+    num_popped += 1;
+  }
+  if (num_popped > 1) {
+    NotifyParked();
+  }
+  return num_popped;
+}
+
+template <typename T>
+void LockFreeJobQueue<T>::Wait() {
+  SpinThenPark([this]() { return Size() == 0; },
+               std::chrono::steady_clock::time_point::max());
+}
+
+template <typename T>
+void LockFreeJobQueue<T>::Stop() {
+  stop_.store(true, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(park_mutex_);
+  }
+  park_condition_.notify_all();
+}
+
+template <typename T>
+void LockFreeJobQueue<T>::Clear() {
+  T data;
+  while (TryPop(&data)) {
+  }
+  NotifyParked();
+}
+
+template <typename T>
+bool LockFreeJobQueue<T>::TryPush(T* data) {
+  size_t pos = push_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    Cell& cell = cells_[pos & mask_];
+    const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence == pos) {
+      if (push_pos_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        cell.data = std::move(*data);
+        cell.sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (static_cast<int64_t>(sequence - pos) < 0) {
+      // The cell was not yet popped after the previous round, i.e., full.
+      return false;
+    } else {
+      pos = push_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+bool LockFreeJobQueue<T>::TryPop(T* data) {
+  size_t pos = pop_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    Cell& cell = cells_[pos & mask_];
+    const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence == pos + 1) {
+      if (pop_pos_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        *data = std::move(cell.data);
+        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (static_cast<int64_t>(sequence - (pos + 1)) < 0) {
+      // The cell was not yet pushed, i.e., empty.
+      return false;
+    } else {
+      pos = pop_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+template <typename Func>
+bool LockFreeJobQueue<T>::SpinThenPark(
+    Func&& done, const std::chrono::steady_clock::time_point deadline) {
+  for (int i = 0; i < kNumSpins; ++i) {
+    if (done()) {
+      return true;
+    }
+    if (i >= kNumBusySpins) {
+      std::this_thread::yield();
+    }
+  }
+
+  // The parked thread is registered before checking again, and notifiers
+  // check for parked threads after their change. With the fences, at least
+  // one of them observes the other, so that no wake up is lost.
+  std::unique_lock<std::mutex> lock(park_mutex_);
+  num_parked_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  bool result = done();
+  while (!result) {
+    if (deadline == std::chrono::steady_clock::time_point::max()) {
+      park_condition_.wait(lock);
+    } else if (park_condition_.wait_until(lock, deadline) ==
+               std::cv_status::timeout) {
+      result = done();
+      break;
+    }
+    result = done();
+  }
+  num_parked_.fetch_sub(1, std::memory_order_relaxed);
+  return result;
+}
+
+template <typename T>
+void LockFreeJobQueue<T>::NotifyParked() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (num_parked_.load(std::memory_order_relaxed) > 0) {
+    {
+      std::lock_guard<std::mutex> lock(park_mutex_);
+    }
+    park_condition_.notify_all();
+  }
+}
+
 }  // namespace colmap
@@ -31,6 +31,11 @@
 
 #include "colmap/util/logging.h"
 
+#include <atomic>
+#include <numeric>
+#include <random>
+
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 namespace colmap {
@@ -716,6 +721,224 @@ TEST(ThreadPool, AggregateExceptionMessage) {
   }
 }
 
+TEST(ThreadPool, NumFailedTasks) {
+  ThreadPool pool(2);
+  std::vector<std::shared_future<void>> futures;
+  for (int i = 0; i < 1000; ++i) {
+    futures.push_back(pool.AddTask([]() {}));
+  }
+  for (const auto& future : futures) {
+    future.get();
+  }
+  EXPECT_EQ(pool.NumFailedTasks(), 0);
+
+  pool.AddTask([]() { throw std::runtime_error("Error"); });
+  while (pool.NumFailedTasks() == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(pool.NumFailedTasks(), 1);
+  EXPECT_THROW(pool.Wait(), AggregateException);
+  EXPECT_EQ(pool.NumFailedTasks(), 0);
+}
+
+TEST(ThreadPool, Priority) {
+  ThreadPool pool(1);
+
+  // Block the worker until all tasks were added.
+  std::promise<void> added_promise;
+  std::shared_future<void> added_future = added_promise.get_future().share();
+  pool.AddTask([added_future]() { added_future.wait(); });
+
+  std::vector<int> order;
+  pool.AddTaskWithPriority(0, [&]() { order.push_back(0); });
+  pool.AddTaskWithPriority(2, [&]() { order.push_back(2); });
+  pool.AddTaskWithPriority(1, [&]() { order.push_back(1); });
+  pool.AddTaskWithPriority(2, [&]() { order.push_back(3); });
+  added_promise.set_value();
+  pool.Wait();
+
+  EXPECT_EQ(order, std::vector<int>({2, 3, 1, 0}));
+}
+
+TEST(ThreadPool, ParallelFor) {
+  ThreadPool pool(4);
+  for (const int num_threads : {-1, 1, 2, 8}) {
+    std::vector<std::atomic<int>> counts(100);
+    pool.ParallelFor(
+        0,
+        counts.size(),
+        [&](const int64_t i) { counts[i] += 1; },
+        num_threads);
+    for (const auto& count : counts) {
+      EXPECT_EQ(count, 1);
+    }
+  }
+  pool.ParallelFor(0, 0, [](const int64_t) { FAIL(); });
+  pool.Wait();
+}
+
+TEST(ThreadPool, NestedParallelFor) {
+  // More outer iterations than workers, such that all workers block in
+  // nested loops, if the calling threads did not run their own iterations.
+  ThreadPool pool(2);
+  std::vector<std::atomic<int>> counts(8 * 16);
+  pool.ParallelFor(0, 8, [&](const int64_t i) {
+    pool.ParallelFor(
+        0, 16, [&](const int64_t j) { counts[16 * i + j] += 1; });
+  });
+  for (const auto& count : counts) {
+    EXPECT_EQ(count, 1);
+  }
+
+  // Nested loops from within a regular task of the same pool.
+  std::atomic<int> count(0);
+  pool.AddTask([&]() {
+        pool.ParallelFor(0, 10, [&](const int64_t) { count += 1; });
+      })
+      .get();
+  EXPECT_EQ(count, 10);
+  pool.Wait();
+}
+
+TEST(ThreadPool, ParallelForPropagatesException) {
+  ThreadPool pool(4);
+  std::atomic<int> count(0);
+  EXPECT_THROW(pool.ParallelFor(0,
+                                100,
+                                [&](const int64_t i) {
+                                  count += 1;
+                                  if (i == 10) {
+                                    throw std::runtime_error("Error");
+                                  }
+                                }),
+               std::runtime_error);
+  EXPECT_EQ(count, 100);
+  EXPECT_NO_THROW(pool.Wait());
+}
+
+TEST(ThreadPool, WaitWithinTaskThrows) {
+  ThreadPool pool(1);
+  auto future = pool.AddTask([&]() { pool.Wait(); });
+  EXPECT_THROW(future.get(), std::exception);
+  EXPECT_THROW(pool.Wait(), AggregateException);
+}
+
+TEST(GetSharedThreadPool, Nominal) {
+  EXPECT_EQ(&GetSharedThreadPool(), &GetSharedThreadPool());
+  EXPECT_EQ(GetSharedThreadPool().NumThreads(),
+            static_cast<size_t>(GetEffectiveNumThreads(-1)));
+  std::atomic<int> count(0);
+  GetSharedThreadPool().ParallelFor(0, 10, [&](const int64_t) { count += 1; });
+  EXPECT_EQ(count, 10);
+}
+
+TEST(GetSharedThreadPool, ParallelForDoesNotAccumulateTasks) {
+  // The shared pool is never waited on, so finished tasks must not be kept.
+  for (int i = 0; i < 1000; ++i) {
+    ParallelFor(0, 100, [](int64_t, int64_t) {}, -1, 1);
+  }
+  EXPECT_EQ(GetSharedThreadPool().NumFailedTasks(), 0);
+  EXPECT_ANY_THROW(ParallelFor(
+      0,
+      100,
+      [](int64_t, int64_t) { throw std::runtime_error("Error"); },
+      -1,
+      1));
+  EXPECT_EQ(GetSharedThreadPool().NumFailedTasks(), 0);
+}
+
+TEST(ParallelFor, Chunks) {
+  for (const int64_t grain_size : {0, 1, 7, 1000}) {
+    std::vector<std::atomic<int>> counts(100);
+    std::atomic<int> num_chunks(0);
+    ParallelFor(
+        10,
+        counts.size(),
+        [&](const int64_t begin, const int64_t end) {
+          EXPECT_LT(begin, end);
+          if (grain_size > 0) {
+            EXPECT_LE(end - begin, grain_size);
+          }
+          for (int64_t i = begin; i < end; ++i) {
+            counts[i] += 1;
+          }
+          num_chunks += 1;
+        },
+        /*num_threads=*/4,
+        grain_size);
+    for (size_t i = 0; i < counts.size(); ++i) {
+      EXPECT_EQ(counts[i], i < 10 ? 0 : 1);
+    }
+    if (grain_size > 0) {
+      EXPECT_EQ(num_chunks, (90 + grain_size - 1) / grain_size);
+    }
+  }
+  ParallelFor(0, 0, [](const int64_t, const int64_t) { FAIL(); });
+}
+
+TEST(ParallelReduce, Nominal) {
+  std::vector<int> values(1000);
+  std::iota(values.begin(), values.end(), 0);
+  for (const int num_threads : {-1, 1, 3}) {
+    EXPECT_EQ(ParallelReduce(
+                  0,
+                  values.size(),
+                  int64_t(0),
+                  [&](const int64_t i, int64_t* sum) { *sum += values[i]; },
+                  std::plus<int64_t>(),
+                  num_threads),
+              999 * 1000 / 2);
+  }
+  EXPECT_EQ(ParallelReduce(
+                0,
+                0,
+                int64_t(5),
+                [](const int64_t, int64_t*) { FAIL(); },
+                std::plus<int64_t>()),
+            5);
+}
+
+TEST(ParallelReduce, ChunkOrder) {
+  // Non-commutative reduction to check the order of the chunks.
+  const std::string result = ParallelReduce(
+      0,
+      26,
+      std::string(),
+      [](const int64_t i, std::string* str) {
+        str->push_back(static_cast<char>('a' + i));
+      },
+      [](std::string str1, const std::string& str2) { return str1 + str2; },
+      /*num_threads=*/4,
+      /*grain_size=*/3);
+  EXPECT_EQ(result, "abcdefghijklmnopqrstuvwxyz");
+}
+
+TEST(ParallelSort, Nominal) {
+  std::mt19937 rng(42);
+  for (const int64_t grain_size : {0, 1, 13, 10000}) {
+    std::vector<int> values(1001);
+    for (auto& value : values) {
+      value = rng() % 100;
+    }
+    std::vector<int> expected_values = values;
+    std::sort(expected_values.begin(), expected_values.end());
+    ParallelSort(values.begin(),
+                 values.end(),
+                 std::less<>(),
+                 /*num_threads=*/4,
+                 grain_size);
+    EXPECT_EQ(values, expected_values);
+
+    ParallelSort(values.begin(), values.end(), std::greater<>());
+    std::reverse(expected_values.begin(), expected_values.end());
+    EXPECT_EQ(values, expected_values);
+  }
+
+  std::vector<int> empty_values;
+  ParallelSort(empty_values.begin(), empty_values.end());
+  EXPECT_TRUE(empty_values.empty());
+}
+
 TEST(JobQueue, SingleProducerSingleConsumer) {
   JobQueue<int> job_queue;
 
@@ -953,6 +1176,37 @@ TEST(JobQueue, StopConsumer) {
   EXPECT_FALSE(job_queue.Pop().IsValid());
 }
 
+TEST(JobQueue, PopUntil) {
+  JobQueue<int> job_queue;
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(
+      job_queue.PopUntil(start + std::chrono::milliseconds(10)).IsValid());
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(10));
+
+  EXPECT_TRUE(job_queue.Push(1));
+  const auto job = job_queue.PopUntil(std::chrono::steady_clock::now());
+  EXPECT_TRUE(job.IsValid());
+  EXPECT_EQ(job.Data(), 1);
+  EXPECT_EQ(job_queue.Size(), 0);
+
+  std::thread producer_thread([&job_queue]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(job_queue.Push(2));
+  });
+  const auto delayed_job = job_queue.PopUntil(std::chrono::steady_clock::now() +
+                                              std::chrono::seconds(60));
+  producer_thread.join();
+  EXPECT_TRUE(delayed_job.IsValid());
+  EXPECT_EQ(delayed_job.Data(), 2);
+
+  job_queue.Stop();
+  EXPECT_FALSE(job_queue.PopUntil(std::chrono::steady_clock::now() +
+                                  std::chrono::seconds(60))
+                   .IsValid());
+}
+
 TEST(JobQueue, Clear) {
   JobQueue<int> job_queue(1);
 
@@ -963,6 +1217,142 @@ TEST(JobQueue, Clear) {
   EXPECT_EQ(job_queue.Size(), 0);
 }
 
+TEST(LockFreeJobQueue, Capacity) {
+  LockFreeJobQueue<int> job_queue(3);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(job_queue.Push(i));
+  }
+  EXPECT_EQ(job_queue.Size(), 4);
+  EXPECT_EQ(job_queue.Pop().Data(), 0);
+  EXPECT_EQ(job_queue.Size(), 3);
+  for (int i = 1; i < 4; ++i) {
+    const auto job = job_queue.Pop();
+    EXPECT_TRUE(job.IsValid());
+    EXPECT_EQ(job.Data(), i);
+  }
+  EXPECT_EQ(job_queue.Size(), 0);
+  EXPECT_FALSE(job_queue.PopUntil(std::chrono::steady_clock::now() +
+                                  std::chrono::milliseconds(10))
+                   .IsValid());
+}
+
+TEST(LockFreeJobQueue, MultipleProducerMultipleConsumer) {
+  LockFreeJobQueue<int> job_queue(4);
+
+  // IMPORTANT: EXPECT_TRUE_* macros are not thread-safe,
+  //            so we use glog's CHECK macros inside threads.
+
+  constexpr int kNumThreads = 4;
+  constexpr int kNumJobs = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&job_queue, t]() {
+      for (int i = 0; i < kNumJobs; ++i) {
+        CHECK(job_queue.Push(t * kNumJobs + i));
+      }
+    });
+  }
+
+  std::vector<std::vector<int>> popped_jobs(kNumThreads);
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&job_queue, &popped_jobs, t]() {
+      for (int i = 0; i < kNumJobs; ++i) {
+        const auto job = job_queue.Pop();
+        CHECK(job.IsValid());
+        popped_jobs[t].push_back(job.Data());
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Every job is popped exactly once and in order per producer.
+  std::vector<int> all_jobs;
+  for (const auto& jobs : popped_jobs) {
+    std::vector<int> last_job(kNumThreads, -1);
+    for (const int job : jobs) {
+      EXPECT_GT(job, last_job[job / kNumJobs]);
+      last_job[job / kNumJobs] = job;
+    }
+    all_jobs.insert(all_jobs.end(), jobs.begin(), jobs.end());
+  }
+  std::sort(all_jobs.begin(), all_jobs.end());
+  ASSERT_EQ(all_jobs.size(), kNumThreads * kNumJobs);
+  for (int i = 0; i < kNumThreads * kNumJobs; ++i) {
+    EXPECT_EQ(all_jobs[i], i);
+  }
+  EXPECT_EQ(job_queue.Size(), 0);
+}
+
+TEST(LockFreeJobQueue, Batch) {
+  LockFreeJobQueue<int> job_queue(2);
+
+  std::thread producer_thread(
+      [&job_queue]() { CHECK(job_queue.PushBatch({0, 1, 2, 3, 4, 5, 6})); });
+
+  std::vector<int> jobs;
+  while (jobs.size() < 7) {
+    const size_t num_jobs = jobs.size();
+    EXPECT_GT(job_queue.PopBatch(3, &jobs), 0);
+    EXPECT_LE(jobs.size() - num_jobs, 3);
+  }
+  producer_thread.join();
+
+  EXPECT_EQ(jobs, std::vector<int>({0, 1, 2, 3, 4, 5, 6}));
+  EXPECT_EQ(job_queue.PopBatch(0, &jobs), 0);
+}
+
+TEST(LockFreeJobQueue, Wait) {
+  LockFreeJobQueue<int> job_queue(16);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(job_queue.Push(i));
+  }
+
+  std::thread consumer_thread([&job_queue]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    for (int i = 0; i < 10; ++i) {
+      CHECK(job_queue.Pop().IsValid());
+    }
+  });
+
+  job_queue.Wait();
+  EXPECT_EQ(job_queue.Size(), 0);
+  consumer_thread.join();
+}
+
+TEST(LockFreeJobQueue, Stop) {
+  LockFreeJobQueue<int> job_queue(2);
+  EXPECT_TRUE(job_queue.Push(0));
+  EXPECT_TRUE(job_queue.Push(1));
+
+  // Blocked producers and consumers return once the queue is stopped.
+  std::thread producer_thread([&job_queue]() { CHECK(!job_queue.Push(2)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  job_queue.Stop();
+  producer_thread.join();
+  EXPECT_FALSE(job_queue.Pop().IsValid());
+  EXPECT_FALSE(job_queue.PushBatch({3}));
+
+  LockFreeJobQueue<int> empty_job_queue(2);
+  std::thread consumer_thread(
+      [&empty_job_queue]() { CHECK(!empty_job_queue.Pop().IsValid()); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  empty_job_queue.Stop();
+  consumer_thread.join();
+}
+
+TEST(LockFreeJobQueue, Clear) {
+  LockFreeJobQueue<int> job_queue(1);
+
+  EXPECT_TRUE(job_queue.Push(0));
+  EXPECT_EQ(job_queue.Size(), 1);
+
+  job_queue.Clear();
+  EXPECT_EQ(job_queue.Size(), 0);
+}
+
 TEST(GetEffectiveNumThreads, Nominal) {
   EXPECT_GT(GetEffectiveNumThreads(-2), 0);
   EXPECT_GT(GetEffectiveNumThreads(-1), 0);
@@ -972,5 +1362,64 @@ TEST(GetEffectiveNumThreads, Nominal) {
   EXPECT_EQ(GetEffectiveNumThreads(3), 3);
 }
 
+TEST(ParseCpuList, Nominal) {
+  EXPECT_THAT(internal::ParseCpuList(""), testing::IsEmpty());
+  EXPECT_THAT(internal::ParseCpuList("3"), testing::ElementsAre(3));
+  EXPECT_THAT(internal::ParseCpuList("0-3,8,10-11\n"),
+              testing::ElementsAre(0, 1, 2, 3, 8, 10, 11));
+  EXPECT_ANY_THROW(internal::ParseCpuList("3-1"));
+  EXPECT_ANY_THROW(internal::ParseCpuList("1-2-3"));
+}
+
+TEST(NumaAwareThreading, Disabled) {
+  SetNumaAwareThreading(false);
+  EXPECT_FALSE(IsNumaAwareThreading());
+  EXPECT_EQ(GetNumNumaNodes(), 1);
+  NumaThreadPool pool(3);
+  EXPECT_EQ(pool.NumNodes(), 1);
+  EXPECT_EQ(pool.Node(0).NumThreads(), 3);
+  auto future = pool.Node(0).AddTask([]() { return GetThreadNumaNode(); });
+  EXPECT_EQ(future.get(), -1);
+}
+
+TEST(NumaAwareThreading, Enabled) {
+  SetNumaAwareThreading(true);
+  EXPECT_TRUE(IsNumaAwareThreading());
+  const int num_numa_nodes = GetNumNumaNodes();
+  EXPECT_EQ(num_numa_nodes,
+            std::max<int>(1, GetNumaNodeCpus().size()));
+
+  const int num_threads = 2 * num_numa_nodes + 1;
+  NumaThreadPool pool(num_threads);
+  EXPECT_EQ(pool.NumNodes(), num_numa_nodes);
+  size_t num_pool_threads = 0;
+  std::atomic<int> count(0);
+  for (int node = 0; node < pool.NumNodes(); ++node) {
+    num_pool_threads += pool.Node(node).NumThreads();
+    for (int i = 0; i < 10; ++i) {
+      pool.Node(node).AddTask([&count, node, num_numa_nodes]() {
+        if (num_numa_nodes > 1) {
+          EXPECT_EQ(GetThreadNumaNode(), node);
+        }
+        count += 1;
+      });
+    }
+  }
+  pool.Wait();
+  EXPECT_EQ(num_pool_threads, static_cast<size_t>(num_threads));
+  EXPECT_EQ(count, 10 * num_numa_nodes);
+
+  EXPECT_FALSE(PinThreadToNumaNode(-1));
+  EXPECT_FALSE(PinThreadToNumaNode(GetNumaNodeCpus().size()));
+  SetNumaAwareThreading(false);
+}
+
+TEST(NumaThreadPool, WaitRethrows) {
+  NumaThreadPool pool(2);
+  pool.Node(0).AddTask([]() { throw std::runtime_error("Error"); });
+  EXPECT_THROW(pool.Wait(), AggregateException);
+  EXPECT_NO_THROW(pool.Wait());
+}
+
 }  // namespace
 }  // namespace colmap
@@ -0,0 +1,287 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/util/tracing.h"
+
+#include "colmap/util/file.h"
+#include "colmap/util/logging.h"
+#include "colmap/util/resource_usage.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace colmap {
+namespace internal {
+
+std::atomic<bool> tracing_enabled(false);
+
+}  // namespace internal
+namespace {
+
+struct TraceEvent {
+  const char* name;
+  // Either 'X' for complete zones or 'C' for counters.
+  char phase;
+  int64_t timestamp_us;
+  int64_t duration_us;
+  // The thread CPU time of zones.
+  int64_t cpu_duration_us;
+  // The number of items of zones or the value of counters, if not negative.
+  int64_t value;
+};
+
+struct ThreadTraceBuffer {
+  int thread_id = 0;
+  // Only contended while exporting or clearing the trace.
+  std::mutex mutex;
+  std::vector<TraceEvent> events;
+};
+
+struct TraceRegistry {
+  std::mutex mutex;
+  // Buffers are kept alive after their threads exit until they are exported.
+  std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers;
+  std::unordered_map<const char*, int64_t> counters;
+  const std::chrono::steady_clock::time_point start_time =
+      std::chrono::steady_clock::now();
+};
+
+TraceRegistry& GetTraceRegistry() {
+  static TraceRegistry registry;
+  return registry;
+}
+
+ThreadTraceBuffer& GetThreadTraceBuffer() {
+  thread_local std::shared_ptr<ThreadTraceBuffer> buffer = [] {
+    auto buffer = std::make_shared<ThreadTraceBuffer>();
+    TraceRegistry& registry = GetTraceRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    buffer->thread_id = static_cast<int>(registry.buffers.size());
+    registry.buffers.push_back(buffer);
+    return buffer;
+  }();
+  return *buffer;
+}
+
+int64_t GetTraceTimeMicroSeconds() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - GetTraceRegistry().start_time)
+      .count();
+}
+
+void RecordTraceEvent(const TraceEvent& event) {
+  ThreadTraceBuffer& buffer = GetThreadTraceBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  buffer.events.push_back(event);
+}
+
+void RecordTraceCounter(const char* name, const int64_t value) {
+  RecordTraceEvent({name,
+                    'C',
+                    GetTraceTimeMicroSeconds(),
+                    /*duration_us=*/0,
+                    /*cpu_duration_us=*/0,
+                    value});
+}
+
+void WriteJsonString(const char* str, std::ostream* stream) {
+  *stream << '"';
+  for (; *str != '\0'; ++str) {
+    const char c = *str;
+    if (c == '"' || c == '\\') {
+      *stream << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      *stream << ' ';
+    } else {
+      *stream << c;
+    }
+  }
+  *stream << '"';
+}
+
+}  // namespace
+
+void SetTracingEnabled(const bool enabled) {
+  // Make sure the start time is initialized before the first event.
+  GetTraceRegistry();
+  internal::tracing_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+TraceZone::TraceZone(const char* name)
+    : name_(name), start_time_us_(-1), start_cpu_time_us_(0), num_items_(-1) {
+  if (IsTracingEnabled()) {
+    start_time_us_ = GetTraceTimeMicroSeconds();
+    start_cpu_time_us_ = GetThreadCpuTimeMicroSeconds();
+  }
+}
+
+TraceZone::~TraceZone() {
+  if (start_time_us_ < 0) {
+    return;
+  }
+  RecordTraceEvent({name_,
+                    'X',
+                    start_time_us_,
+                    GetTraceTimeMicroSeconds() - start_time_us_,
+                    GetThreadCpuTimeMicroSeconds() - start_cpu_time_us_,
+                    num_items_});
+}
+
+void TraceZone::SetNumItems(const int64_t num_items) {
+  num_items_ = num_items;
+}
+
+void RecordTraceZone(const char* name,
+                     const int64_t duration_us,
+                     const int64_t num_items) {
+  if (!IsTracingEnabled()) {
+    return;
+  }
+  const int64_t end_time_us = GetTraceTimeMicroSeconds();
+  RecordTraceEvent({name,
+                    'X',
+                    std::max<int64_t>(0, end_time_us - duration_us),
+                    duration_us,
+                    /*cpu_duration_us=*/0,
+                    num_items});
+}
+
+void SetTraceCounter(const char* name, const int64_t value) {
+  if (!IsTracingEnabled()) {
+    return;
+  }
+  {
+    TraceRegistry& registry = GetTraceRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.counters[name] = value;
+  }
+  RecordTraceCounter(name, value);
+}
+
+void IncrementTraceCounter(const char* name, const int64_t delta) {
+  if (!IsTracingEnabled()) {
+    return;
+  }
+  int64_t value;
+  {
+    TraceRegistry& registry = GetTraceRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    value = registry.counters[name] += delta;
+  }
+  RecordTraceCounter(name, value);
+}
+
+size_t NumTraceEvents() {
+  TraceRegistry& registry = GetTraceRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  size_t num_events = 0;
+  for (const auto& buffer : registry.buffers) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    num_events += buffer->events.size();
+  }
+  return num_events;
+}
+
+std::map<std::string, TraceZoneSummary> SummarizeTraceZones() {
+  std::map<std::string, TraceZoneSummary> summaries;
+  TraceRegistry& registry = GetTraceRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const auto& buffer : registry.buffers) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    for (const TraceEvent& event : buffer->events) {
+      if (event.phase != 'X') {
+        continue;
+      }
+      TraceZoneSummary& summary = summaries[event.name];
+      summary.num_calls += 1;
+      summary.total_duration_us += event.duration_us;
+      summary.max_duration_us =
+          std::max(summary.max_duration_us, event.duration_us);
+      summary.total_cpu_duration_us += event.cpu_duration_us;
+      if (event.value >= 0) {
+        summary.num_items += event.value;
+      }
+    }
+  }
+  return summaries;
+}
+
+void ClearTrace() {
+  TraceRegistry& registry = GetTraceRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const auto& buffer : registry.buffers) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    buffer->events.clear();
+  }
+  registry.counters.clear();
+}
+
+void WriteTrace(const std::filesystem::path& path) {
+  std::ofstream file(path);
+  THROW_CHECK_FILE_OPEN(file, path);
+
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  bool first_event = true;
+  TraceRegistry& registry = GetTraceRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const auto& buffer : registry.buffers) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    for (const TraceEvent& event : buffer->events) {
+      file << (first_event ? "\n" : ",\n");
+      first_event = false;
+      file << "{\"name\":";
+      WriteJsonString(event.name, &file);
+      file << ",\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":"
+           << buffer->thread_id << ",\"ts\":" << event.timestamp_us;
+      if (event.phase == 'X') {
+        file << ",\"dur\":" << event.duration_us
+             << ",\"args\":{\"cpu_us\":" << event.cpu_duration_us;
+        if (event.value >= 0) {
+          file << ",\"items\":" << event.value;
+        }
+        file << "}";
+      } else {
+        file << ",\"args\":{\"value\":" << event.value << "}";
+      }
+      file << "}";
+    }
+  }
+
+  file << "\n]}\n";
+  THROW_CHECK(file.good()) << "Failed to write trace to " << path;
+}
+
+}  // namespace colmap
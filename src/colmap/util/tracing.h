@@ -0,0 +1,141 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+
+namespace colmap {
+
+// Lightweight tracing of nested zones and counters across threads. Tracing is
+// disabled by default, in which case a zone only costs a relaxed atomic load.
+// Once enabled, the events are recorded into per-thread buffers and can be
+// exported in the Chrome trace event format, which can be inspected in
+// chrome://tracing or https://ui.perfetto.dev.
+//
+// Example usage:
+//
+//    void ProcessImages(const std::vector<Image>& images) {
+//      COLMAP_TRACE_ZONE("ProcessImages");
+//      for (const auto& image : images) {
+//        COLMAP_TRACE_ZONE("ProcessImage");
+//        ...
+//      }
+//      IncrementTraceCounter("NumProcessedImages", images.size());
+//    }
+//
+// Zone and counter names must be string literals or otherwise outlive the
+// export of the trace.
+
+// Enable or disable the recording of trace events.
+void SetTracingEnabled(bool enabled);
+
+inline bool IsTracingEnabled();
+
+// Records the time spent in the scope of the zone on the calling thread.
+class TraceZone {
+ public:
+  explicit TraceZone(const char* name);
+  ~TraceZone();
+
+  // Set the number of items processed in the zone, which is exported as an
+  // argument of the zone.
+  void SetNumItems(int64_t num_items);
+
+ private:
+  const char* name_;
+  int64_t start_time_us_;
+  int64_t start_cpu_time_us_;
+  int64_t num_items_;
+};
+
+// Record a zone of the given duration that ends now on the calling thread,
+// e.g., for stages that are timed by external libraries. The CPU time of such
+// zones is not known and recorded as zero.
+void RecordTraceZone(const char* name,
+                     int64_t duration_us,
+                     int64_t num_items = -1);
+
+// Record the current value of a counter.
+void SetTraceCounter(const char* name, int64_t value);
+
+// Add to the value of a counter, e.g., the number of processed items, and
+// record its new value.
+void IncrementTraceCounter(const char* name, int64_t delta = 1);
+
+// The number of recorded events across all threads.
+size_t NumTraceEvents();
+
+// Aggregated statistics of the recorded zones with the same name. Durations
+// are inclusive, i.e., the time of nested zones is also counted towards the
+// enclosing zones.
+struct TraceZoneSummary {
+  size_t num_calls = 0;
+  int64_t total_duration_us = 0;
+  int64_t max_duration_us = 0;
+  // The CPU time spent by the recording thread within the zones, excluding
+  // the time of other threads the zones wait on.
+  int64_t total_cpu_duration_us = 0;
+  // The total number of items of the zones that set their number of items.
+  int64_t num_items = 0;
+};
+
+// Summarize the recorded zones across all threads by their name.
+std::map<std::string, TraceZoneSummary> SummarizeTraceZones();
+
+// Delete all recorded events and reset the counters.
+void ClearTrace();
+
+// Write the recorded events in the Chrome trace event JSON format.
+void WriteTrace(const std::filesystem::path& path);
+
+#define COLMAP_TRACE_CONCAT_IMPL(a, b) a##b
+#define COLMAP_TRACE_CONCAT(a, b) COLMAP_TRACE_CONCAT_IMPL(a, b)
+#define COLMAP_TRACE_ZONE(name) \
+  ::colmap::TraceZone COLMAP_TRACE_CONCAT(trace_zone_, __LINE__)(name)
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////////////////////////////////////
+
+namespace internal {
+
+extern std::atomic<bool> tracing_enabled;
+
+}  // namespace internal
+
+bool IsTracingEnabled() {
+  return internal::tracing_enabled.load(std::memory_order_relaxed);
+}
+
+}  // namespace colmap
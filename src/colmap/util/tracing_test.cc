@@ -0,0 +1,194 @@
+// Copyright (c), ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "colmap/util/tracing.h"
+
+#include "colmap/util/testing.h"
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace colmap {
+namespace {
+
+class ScopedTracing {
+ public:
+  ScopedTracing() {
+    ClearTrace();
+    SetTracingEnabled(true);
+  }
+  ~ScopedTracing() {
+    SetTracingEnabled(false);
+    ClearTrace();
+  }
+};
+
+std::string ReadTrace(const std::filesystem::path& path) {
+  std::ifstream file(path);
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  return buffer.str();
+}
+
+TEST(Tracing, Disabled) {
+  ClearTrace();
+  EXPECT_FALSE(IsTracingEnabled());
+  {
+    COLMAP_TRACE_ZONE("Zone");
+    IncrementTraceCounter("Counter");
+    SetTraceCounter("Counter", 1);
+  }
+  EXPECT_EQ(NumTraceEvents(), 0);
+}
+
+TEST(Tracing, NestedZones) {
+  ScopedTracing tracing;
+  {
+    TraceZone outer_zone("Outer");
+    outer_zone.SetNumItems(3);
+    for (int i = 0; i < 3; ++i) {
+      COLMAP_TRACE_ZONE("Inner");
+    }
+  }
+  EXPECT_EQ(NumTraceEvents(), 4);
+
+  const auto path = CreateTestDir() / "trace.json";
+  WriteTrace(path);
+  const std::string trace = ReadTrace(path);
+  EXPECT_NE(trace.find("\"name\":\"Outer\",\"ph\":\"X\""), std::string::npos);
+  EXPECT_NE(trace.find("\"name\":\"Inner\",\"ph\":\"X\""), std::string::npos);
+  EXPECT_NE(trace.find("\"args\":{\"cpu_us\":"), std::string::npos);
+  EXPECT_NE(trace.find(",\"items\":3}"), std::string::npos);
+
+  ClearTrace();
+  EXPECT_EQ(NumTraceEvents(), 0);
+}
+
+TEST(Tracing, SummarizeZones) {
+  ScopedTracing tracing;
+  {
+    TraceZone outer_zone("Outer");
+    outer_zone.SetNumItems(3);
+    for (int i = 0; i < 3; ++i) {
+      TraceZone inner_zone("Inner");
+      inner_zone.SetNumItems(i);
+    }
+    COLMAP_TRACE_ZONE("Other");
+  }
+  IncrementTraceCounter("Counter");
+
+  const std::map<std::string, TraceZoneSummary> summaries =
+      SummarizeTraceZones();
+  ASSERT_EQ(summaries.size(), 3);
+  EXPECT_EQ(summaries.at("Outer").num_calls, 1);
+  EXPECT_EQ(summaries.at("Outer").num_items, 3);
+  EXPECT_EQ(summaries.at("Inner").num_calls, 3);
+  EXPECT_EQ(summaries.at("Inner").num_items, 3);
+  EXPECT_EQ(summaries.at("Other").num_calls, 1);
+  EXPECT_EQ(summaries.at("Other").num_items, 0);
+  EXPECT_GE(summaries.at("Outer").total_duration_us,
+            summaries.at("Inner").total_duration_us);
+  EXPECT_LE(summaries.at("Inner").max_duration_us,
+            summaries.at("Inner").total_duration_us);
+  EXPECT_GE(summaries.at("Outer").total_cpu_duration_us,
+            summaries.at("Inner").total_cpu_duration_us);
+
+  ClearTrace();
+  EXPECT_TRUE(SummarizeTraceZones().empty());
+}
+
+TEST(Tracing, RecordZone) {
+  RecordTraceZone("Zone", 100);
+  EXPECT_EQ(NumTraceEvents(), 0);
+
+  ScopedTracing tracing;
+  RecordTraceZone("Zone", 100);
+  RecordTraceZone("Zone", 50, /*num_items=*/2);
+  EXPECT_EQ(NumTraceEvents(), 2);
+
+  const std::map<std::string, TraceZoneSummary> summaries =
+      SummarizeTraceZones();
+  ASSERT_EQ(summaries.size(), 1);
+  EXPECT_EQ(summaries.at("Zone").num_calls, 2);
+  EXPECT_EQ(summaries.at("Zone").total_duration_us, 150);
+  EXPECT_EQ(summaries.at("Zone").max_duration_us, 100);
+  EXPECT_EQ(summaries.at("Zone").total_cpu_duration_us, 0);
+  EXPECT_EQ(summaries.at("Zone").num_items, 2);
+}
+
+TEST(Tracing, Counters) {
+  ScopedTracing tracing;
+  IncrementTraceCounter("Counter");
+  IncrementTraceCounter("Counter", 2);
+  SetTraceCounter("Other", 5);
+  EXPECT_EQ(NumTraceEvents(), 3);
+
+  const auto path = CreateTestDir() / "trace.json";
+  WriteTrace(path);
+  const std::string trace = ReadTrace(path);
+  EXPECT_NE(trace.find("\"args\":{\"value\":1}"), std::string::npos);
+  EXPECT_NE(trace.find("\"args\":{\"value\":3}"), std::string::npos);
+  EXPECT_NE(trace.find("\"args\":{\"value\":5}"), std::string::npos);
+}
+
+TEST(Tracing, MultipleThreads) {
+  ScopedTracing tracing;
+  constexpr int kNumThreads = 4;
+  constexpr int kNumZones = 100;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([]() {
+      for (int j = 0; j < kNumZones; ++j) {
+        COLMAP_TRACE_ZONE("Zone");
+        IncrementTraceCounter("Counter");
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // The events of exited threads must be retained.
+  EXPECT_EQ(NumTraceEvents(), 2 * kNumThreads * kNumZones);
+
+  const auto path = CreateTestDir() / "trace.json";
+  WriteTrace(path);
+  const std::string trace = ReadTrace(path);
+  EXPECT_NE(trace.find("\"args\":{\"value\":400}"), std::string::npos);
+  EXPECT_EQ(trace.find("\"args\":{\"value\":401}"), std::string::npos);
+}
+
+}  // namespace
+}  // namespace colmap
@@ -33,14 +33,17 @@ void BindAlignmentEstimator(py::module& m) {
          const Reconstruction& tgt_reconstruction,
          const double min_inlier_observations,
          const double max_reproj_error) -> py::typing::Optional<Sim3d> {
+        py::gil_scoped_release release;
         Sim3d tgt_from_src;
         if (!AlignReconstructionsViaReprojections(src_reconstruction,
                                                   tgt_reconstruction,
                                                   min_inlier_observations,
                                                   max_reproj_error,
                                                   &tgt_from_src)) {
+          py::gil_scoped_acquire acquire;
           return py::none();
         }
+        py::gil_scoped_acquire acquire;
         return py::cast(tgt_from_src);
       },
       "src_reconstruction"_a,
@@ -53,13 +56,16 @@ void BindAlignmentEstimator(py::module& m) {
       [](const Reconstruction& src_reconstruction,
          const Reconstruction& tgt_reconstruction,
          const double max_proj_center_error) -> py::typing::Optional<Sim3d> {
+        py::gil_scoped_release release;
         Sim3d tgt_from_src;
         if (!AlignReconstructionsViaProjCenters(src_reconstruction,
                                                 tgt_reconstruction,
                                                 max_proj_center_error,
                                                 &tgt_from_src)) {
+          py::gil_scoped_acquire acquire;
           return py::none();
         }
+        py::gil_scoped_acquire acquire;
         return py::cast(tgt_from_src);
       },
       "src_reconstruction"_a,
@@ -73,6 +79,7 @@ void BindAlignmentEstimator(py::module& m) {
          const size_t min_common_observations,
          const double max_error,
          const double min_inlier_ratio) -> py::typing::Optional<Sim3d> {
+        py::gil_scoped_release release;
         Sim3d tgt_from_src;
         if (!AlignReconstructionsViaPoints(src_reconstruction,
                                            tgt_reconstruction,
@@ -80,8 +87,10 @@ void BindAlignmentEstimator(py::module& m) {
                                            max_error,
                                            min_inlier_ratio,
                                            &tgt_from_src)) {
+          py::gil_scoped_acquire acquire;
           return py::none();
         }
+        py::gil_scoped_acquire acquire;
         return py::cast(tgt_from_src);
       },
       "src_reconstruction"_a,
@@ -97,6 +106,7 @@ void BindAlignmentEstimator(py::module& m) {
          const std::vector<Eigen::Vector3d>& tgt_locations,
          const int min_common_images,
          const RANSACOptions& ransac_options) -> py::typing::Optional<Sim3d> {
+        py::gil_scoped_release release;
         Sim3d locations_from_src;
         if (!AlignReconstructionToLocations(src,
                                             tgt_image_names,
@@ -104,8 +114,10 @@ void BindAlignmentEstimator(py::module& m) {
                                             min_common_images,
                                             ransac_options,
                                             &locations_from_src)) {
+          py::gil_scoped_acquire acquire;
           return py::none();
         }
+        py::gil_scoped_acquire acquire;
         return py::cast(locations_from_src);
       },
       "src"_a,
@@ -123,6 +135,7 @@ void BindAlignmentEstimator(py::module& m) {
          double max_reproj_error,
          double max_proj_center_error) -> py::typing::Optional<py::dict> {
         std::vector<ImageAlignmentError> errors;
+        py::gil_scoped_release release;
         Sim3d rec2_from_rec1;
         if (!CompareModels(reconstruction1,
                            reconstruction2,
@@ -132,8 +145,10 @@ void BindAlignmentEstimator(py::module& m) {
                            max_proj_center_error,
                            errors,
                            rec2_from_rec1)) {
+          py::gil_scoped_acquire acquire;
           return py::none();
         }
+        py::gil_scoped_acquire acquire;
         return py::dict("rec2_from_rec1"_a = rec2_from_rec1,
                         "errors"_a = errors);
       },
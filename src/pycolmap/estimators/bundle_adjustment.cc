@@ -8,6 +8,7 @@
 #include "pycolmap/utils.h"
 
 #include <pybind11/eigen.h>
+#include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -75,12 +76,56 @@ void BindBundleAdjuster(py::module& m) {
           .value("USER_FAILURE", BundleAdjustmentTerminationType::USER_FAILURE);
   AddStringToEnumConstructor(PyBundleAdjustmentTerminationType);
 
+  using BAIterSummary = BundleAdjustmentIterationSummary;
+  auto PyBundleAdjustmentIterationSummary =
+      py::classh<BAIterSummary>(m, "BundleAdjustmentIterationSummary")
+          .def(py::init<>())
+          .def_readwrite("iteration", &BAIterSummary::iteration)
+          .def_readwrite("cost", &BAIterSummary::cost)
+          .def_readwrite("step_accepted", &BAIterSummary::step_accepted)
+          .def_readwrite("iteration_time_sec",
+                         &BAIterSummary::iteration_time_sec)
+          .def_readwrite("cumulative_time_sec",
+                         &BAIterSummary::cumulative_time_sec)
+          .def_readwrite("linear_solver_time_sec",
+                         &BAIterSummary::linear_solver_time_sec,
+                         "Time to solve the linear system for the step. "
+                         "Negative if not reported by the backend.")
+          .def_readwrite("evaluation_time_sec",
+                         &BAIterSummary::evaluation_time_sec,
+                         "Time to evaluate the residuals and Jacobians. "
+                         "Negative if not reported by the backend.")
+          .def_readwrite("num_linear_solver_iterations",
+                         &BAIterSummary::num_linear_solver_iterations,
+                         "Number of iterations of iterative linear solvers, "
+                         "e.g., PCG iterations.");
+  MakeDataclass(PyBundleAdjustmentIterationSummary);
+
   using BASummary = BundleAdjustmentSummary;
   auto PyBundleAdjustmentSummary =
       py::classh<BASummary>(m, "BundleAdjustmentSummary")
           .def(py::init<>())
           .def_readwrite("termination_type", &BASummary::termination_type)
           .def_readwrite("num_residuals", &BASummary::num_residuals)
+          .def_readwrite("num_iterations", &BASummary::num_iterations)
+          .def_readwrite("iteration_summaries",
+                         &BASummary::iteration_summaries,
+                         "Per-iteration statistics of the solver.")
+          .def_readwrite("total_time_sec", &BASummary::total_time_sec)
+          .def_readwrite("jacobian_evaluation_time_sec",
+                         &BASummary::jacobian_evaluation_time_sec)
+          .def_readwrite("residual_evaluation_time_sec",
+                         &BASummary::residual_evaluation_time_sec)
+          .def_readwrite("linear_solver_time_sec",
+                         &BASummary::linear_solver_time_sec)
+          .def_readwrite("line_search_time_sec",
+                         &BASummary::line_search_time_sec)
+          .def_readwrite("device_transfer_time_sec",
+                         &BASummary::device_transfer_time_sec,
+                         "Time to transfer the problem to and the solution "
+                         "from the device.")
+          .def_readwrite("num_linear_solver_iterations",
+                         &BASummary::num_linear_solver_iterations)
           .def("is_solution_usable", &BASummary::IsSolutionUsable)
           .def("brief_report", &BASummary::BriefReport);
   MakeDataclass(PyBundleAdjustmentSummary);
@@ -292,7 +337,22 @@ void BindBundleAdjuster(py::module& m) {
                          "Minimum relative solver decrease.")
           .def_readwrite("gpu_index",
                          &CasparBAOpts::gpu_index,
-                         "Which GPU to use for solving the problem.");
+                         "Which GPU to use for solving the problem. Multiple "
+                         "comma-separated GPUs partition the problem across "
+                         "the devices.")
+          .def_readwrite("num_double_precision_iterations",
+                         &CasparBAOpts::num_double_precision_iterations,
+                         "Number of double-precision Ceres iterations to "
+                         "refine the Caspar solution. Zero disables the "
+                         "refinement.")
+          .def_readwrite("max_num_observations_per_solve",
+                         &CasparBAOpts::max_num_observations_per_solve,
+                         "Maximum number of observations solved at once on a "
+                         "single GPU. Larger problems are solved in blocks. "
+                         "Negative value disables the limit.")
+          .def_readwrite("num_multi_gpu_iterations",
+                         &CasparBAOpts::num_multi_gpu_iterations,
+                         "Number of alternations when solving in blocks.");
   MakeDataclass(PyCasparBundleAdjustmentOptions);
 
   // Solver-agnostic bundle adjustment options
@@ -335,6 +395,11 @@ void BindBundleAdjuster(py::module& m) {
           .def_readwrite("backend",
                          &BAOpts::backend,
                          "Solver backend to use for bundle adjustment.")
+          .def_readwrite(
+              "iteration_callback",
+              &BAOpts::iteration_callback,
+              "Optional callback invoked with the "
+              "BundleAdjustmentIterationSummary of every solver iteration.")
           .def_readwrite("ceres",
                          &BAOpts::ceres,
                          "Ceres-specific bundle adjustment options.")
@@ -386,7 +451,9 @@ void BindBundleAdjuster(py::module& m) {
            }),
            "options"_a,
            "config"_a)
-      .def("solve", &BundleAdjuster::Solve)
+      .def("solve",
+           &BundleAdjuster::Solve,
+           py::call_guard<py::gil_scoped_release>())
       .def_property_readonly("options", &BundleAdjuster::Options)
       .def_property_readonly("config", &BundleAdjuster::Config);
 
@@ -400,18 +467,47 @@ void BindBundleAdjuster(py::module& m) {
            "config"_a)
       .def_property_readonly("problem", &CeresBundleAdjuster::Problem);
 
+  py::classh<CeresIncrementalBundleAdjuster, CeresBundleAdjuster>(
+      m, "CeresIncrementalBundleAdjuster")
+      .def("update",
+           &CeresIncrementalBundleAdjuster::Update,
+           "options"_a,
+           "config"_a,
+           "Synchronize the problem with the given options, config, and the "
+           "current state of the reconstruction.")
+      .def_property_readonly(
+          "num_added_residuals",
+          &CeresIncrementalBundleAdjuster::NumAddedResiduals)
+      .def_property_readonly(
+          "num_removed_residuals",
+          &CeresIncrementalBundleAdjuster::NumRemovedResiduals);
+
   m.def("create_default_bundle_adjuster",
         CreateDefaultBundleAdjuster,
         "options"_a,
         "config"_a,
         "reconstruction"_a);
 
+  m.def("solve_bundle_adjustment_batch",
+        SolveBundleAdjustmentBatch,
+        "options"_a,
+        "configs"_a,
+        "reconstructions"_a,
+        "num_threads"_a = -1,
+        py::call_guard<py::gil_scoped_release>());
+
   m.def("create_default_ceres_bundle_adjuster",
         CreateDefaultCeresBundleAdjuster,
         "options"_a,
         "config"_a,
         "reconstruction"_a);
 
+  m.def("create_incremental_ceres_bundle_adjuster",
+        CreateIncrementalCeresBundleAdjuster,
+        "options"_a,
+        "config"_a,
+        "reconstruction"_a);
+
   m.def("create_pose_prior_bundle_adjuster",
         CreatePosePriorBundleAdjuster,
         "options"_a,
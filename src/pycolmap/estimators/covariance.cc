@@ -54,6 +54,21 @@ void BindCovarianceEstimator(py::module& m) {
           &BACovarianceOptions::damping,
           "Damping factor for the Hessian in the Schur complement solver. "
           "Enables to robustly deal with poorly conditioned parameters.")
+      .def_readwrite(
+          "block_diagonal",
+          &BACovarianceOptions::block_diagonal,
+          "Whether to only compute the diagonal blocks of the pose/other "
+          "covariance, i.e., the marginal covariance of each parameter block "
+          "without the cross-covariances between different blocks. "
+          "Recommended for large reconstructions.")
+      .def_readwrite("sparse_cholesky",
+                     &BACovarianceOptions::sparse_cholesky,
+                     "Sparse Cholesky factorization of the Schur complement "
+                     "in block-diagonal mode.")
+      .def_readwrite("num_threads",
+                     &BACovarianceOptions::num_threads,
+                     "The number of threads to use, -1 for all available "
+                     "threads.")
       .def_readwrite(
           "experimental_custom_poses",
           &BACovarianceOptions::experimental_custom_poses,
@@ -85,7 +100,8 @@ void BindCovarianceEstimator(py::module& m) {
            "image_id2"_a,
            "Tangent space covariance in the order [rotation, translation]. If "
            "some dimensions are kept constant, the respective rows/columns are "
-           "omitted. Returns null if image is not a variable in the problem.")
+           "omitted. Returns null if image is not a variable in the problem "
+           "or if only block-diagonal covariances were estimated.")
       .def("get_cam2_cov_from_cam1",
            &BACovariance::GetCam2CovFromCam1,
            "image_id1"_a,
@@ -121,7 +137,8 @@ void BindCovarianceEstimator(py::module& m) {
       "solving using the Schur complement trick. This is the case for the "
       "standard configuration of bundle adjustment problems, but be careful "
       "if you modify the underlying problem with custom residuals. Returns "
-      "null if the estimation was not successful.");
+      "null if the estimation was not successful.",
+      py::call_guard<py::gil_scoped_release>());
 
   m.def(
       "estimate_ba_covariance_from_problem",
@@ -134,5 +151,6 @@ void BindCovarianceEstimator(py::module& m) {
       "solving using the Schur complement trick. This is the case for the "
       "standard configuration of bundle adjustment problems, but be careful "
       "if you modify the underlying problem with custom residuals. Returns "
-      "null if the estimation was not successful.");
+      "null if the estimation was not successful.",
+      py::call_guard<py::gil_scoped_release>());
 }
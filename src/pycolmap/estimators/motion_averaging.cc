@@ -121,6 +121,15 @@ void BindRotationEstimator(py::module& m) {
                           .value("HALF_NORM", WeightType::HALF_NORM);
   AddStringToEnumConstructor(PyWeightType);
 
+  auto PyLinearSolver =
+      py::enum_<RotationAveragingLinearSolver>(m,
+                                               "RotationAveragingLinearSolver")
+          .value("SPARSE_CHOLESKY",
+                 RotationAveragingLinearSolver::SPARSE_CHOLESKY)
+          .value("CONJUGATE_GRADIENT",
+                 RotationAveragingLinearSolver::CONJUGATE_GRADIENT);
+  AddStringToEnumConstructor(PyLinearSolver);
+
   auto PyRotationEstimatorOptions =
       py::classh<RotationEstimatorOptions>(m, "RotationEstimatorOptions")
           .def(py::init<>())
@@ -156,6 +165,22 @@ void BindRotationEstimator(py::module& m) {
               "before each Cholesky factorization in the L1 and IRLS phases. "
               "Set to a small positive value (e.g., 1e-9) to stabilize poorly "
               "conditioned systems. Zero disables regularization.")
+          .def_readwrite("linear_solver",
+                         &RotationEstimatorOptions::linear_solver,
+                         "Linear solver for the normal equations in the L1 "
+                         "and IRLS phases.")
+          .def_readwrite("sparse_cholesky",
+                         &RotationEstimatorOptions::sparse_cholesky,
+                         "Backend and ordering of the SPARSE_CHOLESKY linear "
+                         "solver.")
+          .def_readwrite("max_num_cg_iterations",
+                         &RotationEstimatorOptions::max_num_cg_iterations,
+                         "Maximum number of iterations of each conjugate "
+                         "gradient solve.")
+          .def_readwrite("cg_tolerance",
+                         &RotationEstimatorOptions::cg_tolerance,
+                         "Relative residual tolerance of each conjugate "
+                         "gradient solve.")
           .def_readwrite("weight_type",
                          &RotationEstimatorOptions::weight_type,
                          "Weight type for IRLS: GEMAN_MCCLURE or HALF_NORM.")
@@ -178,6 +203,15 @@ void BindRotationEstimator(py::module& m) {
               &RotationEstimatorOptions::max_rotation_error_deg,
               "Filter pairs with rotation error exceeding this threshold "
               "(degrees).")
+          .def_readwrite(
+              "max_cycle_error_deg",
+              &RotationEstimatorOptions::max_cycle_error_deg,
+              "If > 0, filter pairs before solving whose relative rotation is "
+              "inconsistent with all their triangles in the pose graph "
+              "(degrees).")
+          .def_readwrite("num_threads",
+                         &RotationEstimatorOptions::num_threads,
+                         "Number of threads for the cycle consistency filter.")
           .def_readwrite(
               "refine_sensor_from_rig",
               &RotationEstimatorOptions::refine_sensor_from_rig,
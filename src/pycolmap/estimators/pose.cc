@@ -4,11 +4,15 @@
 #include "colmap/math/random.h"
 #include "colmap/scene/camera.h"
 #include "colmap/util/logging.h"
+#include "colmap/util/threading.h"
 
 #include "pycolmap/helpers.h"
 #include "pycolmap/pybind11_extension.h"
 #include "pycolmap/utils.h"
 
+#include <algorithm>
+#include <vector>
+
 #include <pybind11/eigen.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
@@ -115,6 +119,80 @@ py::typing::Optional<py::dict> PyEstimateAndRefineAbsolutePose(
   return result;
 }
 
+std::vector<py::typing::Optional<py::dict>>
+PyEstimateAndRefineAbsolutePoseBatch(
+    const std::vector<std::vector<Eigen::Vector2d>>& points2D,
+    const std::vector<std::vector<Eigen::Vector3d>>& points3D,
+    const std::vector<Camera>& cameras,
+    const AbsolutePoseEstimationOptions& estimation_options,
+    const AbsolutePoseRefinementOptions& refinement_options,
+    const bool return_covariance,
+    const int num_threads) {
+  THROW_CHECK_EQ(points2D.size(), points3D.size());
+  THROW_CHECK_EQ(points2D.size(), cameras.size());
+  const size_t num_queries = points2D.size();
+  for (size_t i = 0; i < num_queries; ++i) {
+    THROW_CHECK_EQ(points2D[i].size(), points3D[i].size());
+  }
+
+  struct Result {
+    bool success = false;
+    Rigid3d cam_from_world;
+    Camera camera;
+    size_t num_inliers = 0;
+    std::vector<char> inlier_mask;
+    Eigen::Matrix<double, 6, 6> covariance;
+  };
+  std::vector<Result> results(num_queries);
+
+  {
+    py::gil_scoped_release release;
+    ThreadPool thread_pool(
+        std::min(GetEffectiveNumThreads(num_threads),
+                 std::max(1, static_cast<int>(num_queries))));
+    for (size_t i = 0; i < num_queries; ++i) {
+      thread_pool.AddTask([&, i]() {
+        Result& result = results[i];
+        result.camera = cameras[i];
+        if (!EstimateAbsolutePose(estimation_options,
+                                  points2D[i],
+                                  points3D[i],
+                                  &result.cam_from_world,
+                                  &result.camera,
+                                  &result.num_inliers,
+                                  &result.inlier_mask)) {
+          return;
+        }
+        result.success = RefineAbsolutePose(
+            refinement_options,
+            result.inlier_mask,
+            points2D[i],
+            points3D[i],
+            &result.cam_from_world,
+            &result.camera,
+            return_covariance ? &result.covariance : nullptr);
+      });
+    }
+    thread_pool.Wait();
+  }
+
+  std::vector<py::typing::Optional<py::dict>> py_results;
+  py_results.reserve(num_queries);
+  for (const Result& result : results) {
+    if (!result.success) {
+      py_results.emplace_back(py::none());
+      continue;
+    }
+    py::dict py_result("cam_from_world"_a = result.cam_from_world,
+                       "camera"_a = result.camera,
+                       "num_inliers"_a = result.num_inliers,
+                       "inlier_mask"_a = ToPythonMask(result.inlier_mask));
+    if (return_covariance) py_result["covariance"] = result.covariance;
+    py_results.emplace_back(std::move(py_result));
+  }
+  return py_results;
+}
+
 py::typing::Optional<py::dict> PyEstimateRelativePose(
     const std::vector<Eigen::Vector3d>& cam_rays1,
     const std::vector<Eigen::Vector3d>& cam_rays2,
@@ -170,6 +248,8 @@ void BindAbsolutePoseEstimator(py::module& m) {
   PyEstimationOptions.def(py::init<>())
       .def_readwrite("estimate_focal_length",
                      &AbsolutePoseEstimationOptions::estimate_focal_length)
+      .def_readwrite("use_marginalized_scoring",
+                     &AbsolutePoseEstimationOptions::use_marginalized_scoring)
       .def_readwrite("ransac", &AbsolutePoseEstimationOptions::ransac_options);
   MakeDataclass(PyEstimationOptions);
 
@@ -235,6 +315,25 @@ void BindAbsolutePoseEstimator(py::module& m) {
         "Robust absolute pose estimation with LO-RANSAC "
         "followed by non-linear refinement.");
 
+  m.def("estimate_and_refine_absolute_pose_batch",
+        &PyEstimateAndRefineAbsolutePoseBatch,
+        "points2D"_a,
+        "points3D"_a,
+        "cameras"_a,
+        py::arg_v("estimation_options",
+                  AbsolutePoseEstimationOptions(),
+                  "AbsolutePoseEstimationOptions()"),
+        py::arg_v("refinement_options",
+                  AbsolutePoseRefinementOptions(),
+                  "AbsolutePoseRefinementOptions()"),
+        "return_covariance"_a = false,
+        "num_threads"_a = -1,
+        "Robust absolute pose estimation with LO-RANSAC followed by "
+        "non-linear refinement for a batch of queries, which are processed "
+        "in parallel without holding the GIL. The input cameras are not "
+        "modified; the refined camera of each query is returned in its "
+        "result. Returns None for the queries that failed.");
+
   m.def("estimate_relative_pose",
         &PyEstimateRelativePose,
         "cam_rays1"_a,
@@ -97,9 +97,50 @@ def test_absolute_pose_refinement_options_position_prior_covariance_readwrite():
         "estimate_absolute_pose",
         "refine_absolute_pose",
         "estimate_and_refine_absolute_pose",
+        "estimate_and_refine_absolute_pose_batch",
         "estimate_relative_pose",
         "refine_relative_pose",
     ],
 )
 def test_public_api_callable(name):
     assert callable(getattr(pycolmap, name))
+
+
+def test_estimate_and_refine_absolute_pose_batch():
+    rng = np.random.default_rng(42)
+    camera = pycolmap.Camera.create_from_model_name(
+        0, "SIMPLE_PINHOLE", 100.0, 200, 200
+    )
+    num_queries = 4
+    points2D = []
+    points3D = []
+    for _ in range(num_queries):
+        query_points3D = rng.uniform(-1, 1, (50, 3)) + [0, 0, 5]
+        points2D.append(camera.img_from_cam(query_points3D))
+        points3D.append(query_points3D)
+    # The last query has too few correspondences to estimate a pose.
+    points2D[-1] = points2D[-1][:2]
+    points3D[-1] = points3D[-1][:2]
+
+    results = pycolmap.estimate_and_refine_absolute_pose_batch(
+        points2D, points3D, [camera] * num_queries, num_threads=2
+    )
+    assert len(results) == num_queries
+    for result in results[:-1]:
+        assert result is not None
+        assert result["num_inliers"] == 50
+        np.testing.assert_allclose(
+            result["cam_from_world"].translation, [0, 0, 0], atol=1e-6
+        )
+        assert isinstance(result["camera"], pycolmap.Camera)
+    assert results[-1] is None
+
+
+def test_estimate_and_refine_absolute_pose_batch_mismatched_sizes():
+    camera = pycolmap.Camera.create_from_model_name(
+        0, "SIMPLE_PINHOLE", 100.0, 200, 200
+    )
+    with pytest.raises(ValueError):
+        pycolmap.estimate_and_refine_absolute_pose_batch(
+            [np.zeros((4, 2))], [np.zeros((4, 3)), np.zeros((4, 3))], [camera]
+        )
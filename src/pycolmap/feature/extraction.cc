@@ -173,6 +173,17 @@ void BindFeatureExtraction(py::module& m) {
           .def_readwrite("dsp_max_scale", &SiftExtractionOptions::dsp_max_scale)
           .def_readwrite("dsp_num_scales",
                          &SiftExtractionOptions::dsp_num_scales)
+          .def_readwrite("tile_size",
+                         &SiftExtractionOptions::tile_size,
+                         "Split images larger than tile_size into overlapping "
+                         "tiles to bound the memory of CPU extraction. "
+                         "0 disables tiling.")
+          .def_readwrite("tile_overlap",
+                         &SiftExtractionOptions::tile_overlap,
+                         "Overlap between neighboring tiles in pixels.")
+          .def_readwrite("tile_num_threads",
+                         &SiftExtractionOptions::tile_num_threads,
+                         "Number of threads for extracting tiles in parallel.")
           .def_readwrite("normalization",
                          &SiftExtractionOptions::normalization,
                          "L1_ROOT or L2 descriptor normalization")
@@ -198,6 +209,10 @@ void BindFeatureExtraction(py::module& m) {
                          &AlikedExtractionOptions::n32_model_path,
                          "Path to the ONNX model file for the n32 ALIKED "
                          "extractor.")
+          .def_readwrite("descriptor_precision",
+                         &AlikedExtractionOptions::descriptor_precision,
+                         "Storage precision of the descriptors. FLOAT16 and "
+                         "INT8 reduce the storage by 2x and 4x.")
           .def("check", &AlikedExtractionOptions::Check);
   MakeDataclass(PyAlikedExtractionOptions);
 #endif
@@ -223,6 +238,23 @@ void BindFeatureExtraction(py::module& m) {
                          "Index of the GPU used for feature matching. For "
                          "multi-GPU matching, you should separate multiple "
                          "GPU indices by comma, e.g., '0,1,2,3'.")
+          .def_readwrite("num_cpu_workers",
+                         &FeatureExtractionOptions::num_cpu_workers,
+                         "Number of additional CPU extraction threads when "
+                         "extracting on the GPU. Images are scheduled among "
+                         "the GPU and CPU workers by their throughput.")
+          .def_readwrite("use_gpu_decoding",
+                         &FeatureExtractionOptions::use_gpu_decoding,
+                         "Whether to decode and downscale JPEG images with "
+                         "nvJPEG on the GPU instead of on the CPU.")
+          .def_readwrite("batch_size",
+                         &FeatureExtractionOptions::batch_size,
+                         "Maximum number of images passed to the extractor "
+                         "at once. Only used by batched extractors.")
+          .def_readwrite("batch_timeout_ms",
+                         &FeatureExtractionOptions::batch_timeout_ms,
+                         "Maximum time in milliseconds to wait for further "
+                         "images to fill a batch.")
           .def_readwrite("sift", &FeatureExtractionOptions::sift)
 
           .def("requires_rgb", &FeatureExtractionOptions::RequiresRGB)
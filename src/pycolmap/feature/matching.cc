@@ -12,6 +12,7 @@
 
 #include <Eigen/Core>
 #include <pybind11/eigen.h>
+#include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -102,6 +103,19 @@ void BindFeatureMatching(py::module& m) {
           .def_readwrite("min_score",
                          &LightGlueONNXMatchingOptions::min_score,
                          "Minimum match score threshold.")
+          .def_readwrite(
+              "prefilter_min_num_matches",
+              &LightGlueONNXMatchingOptions::prefilter_min_num_matches,
+              "Skip image pairs with fewer mutual nearest neighbor matches "
+              "among their first prefilter_max_num_features descriptors "
+              "before the LightGlue inference. Set to 0 to match all pairs.")
+          .def_readwrite(
+              "prefilter_max_num_features",
+              &LightGlueONNXMatchingOptions::prefilter_max_num_features,
+              "The number of descriptors per image used by the prefilter.")
+          .def_readwrite("prefilter_max_ratio",
+                         &LightGlueONNXMatchingOptions::prefilter_max_ratio,
+                         "Maximum distance ratio of the prefilter matches.")
           .def_readwrite("model_path",
                          &LightGlueONNXMatchingOptions::model_path,
                          "Path to the LightGlue ONNX model file.")
@@ -138,6 +152,10 @@ void BindFeatureMatching(py::module& m) {
               "cpu_brute_force_matcher",
               &SiftMatchingOptions::cpu_brute_force_matcher,
               "Whether to use brute-force instead of faiss based CPU matching.")
+          .def_readwrite("cpu_descriptor_index_path",
+                         &SiftMatchingOptions::cpu_descriptor_index_path,
+                         "Optional directory in which the descriptor indices "
+                         "of the faiss based CPU matching are persisted.")
 #ifdef COLMAP_ONNX_ENABLED
           .def_readwrite("lightglue",
                          &SiftMatchingOptions::lightglue,
@@ -146,6 +164,36 @@ void BindFeatureMatching(py::module& m) {
           .def("check", &SiftMatchingOptions::Check);
   MakeDataclass(PySiftMatchingOptions);
 
+  py::classh<FeatureMatchingProgress>(m, "FeatureMatchingProgress")
+      .def(py::init<>())
+      .def_readonly("elapsed_time_sec",
+                    &FeatureMatchingProgress::elapsed_time_sec)
+      .def_readonly("interval_time_sec",
+                    &FeatureMatchingProgress::interval_time_sec)
+      .def_readonly("progress", &FeatureMatchingProgress::progress)
+      .def_readonly("remaining_time_sec",
+                    &FeatureMatchingProgress::remaining_time_sec)
+      .def_readonly("num_processed_pairs",
+                    &FeatureMatchingProgress::num_processed_pairs)
+      .def_readonly("num_skipped_pairs",
+                    &FeatureMatchingProgress::num_skipped_pairs)
+      .def_readonly("num_matched_pairs",
+                    &FeatureMatchingProgress::num_matched_pairs)
+      .def_readonly("num_verified_pairs",
+                    &FeatureMatchingProgress::num_verified_pairs)
+      .def_readonly("pairs_per_sec", &FeatureMatchingProgress::pairs_per_sec)
+      .def_readonly("mean_matcher_queue_size",
+                    &FeatureMatchingProgress::mean_matcher_queue_size)
+      .def_readonly("mean_verifier_queue_size",
+                    &FeatureMatchingProgress::mean_verifier_queue_size)
+      .def_readonly("keypoints_cache_hit_ratio",
+                    &FeatureMatchingProgress::keypoints_cache_hit_ratio)
+      .def_readonly("descriptors_cache_hit_ratio",
+                    &FeatureMatchingProgress::descriptors_cache_hit_ratio)
+      .def_readonly("database_wait_time_sec",
+                    &FeatureMatchingProgress::database_wait_time_sec)
+      .def("__repr__", &FeatureMatchingProgress::ToString);
+
   auto PyFeatureMatchingOptions =
       py::classh<FeatureMatchingOptions>(m, "FeatureMatchingOptions")
           .def(py::init<FeatureMatcherType>(),
@@ -162,6 +210,11 @@ void BindFeatureMatching(py::module& m) {
           .def_readwrite("max_num_matches",
                          &FeatureMatchingOptions::max_num_matches,
                          "Maximum number of matches.")
+          .def_readwrite("max_num_features",
+                         &FeatureMatchingOptions::max_num_features,
+                         "Maximum number of features per image used for "
+                         "matching. If positive, only the features with the "
+                         "largest scale are matched.")
           .def_readwrite("guided_matching",
                          &FeatureMatchingOptions::guided_matching,
                          "Whether to perform guided matching, if geometric "
@@ -185,6 +238,54 @@ void BindFeatureMatching(py::module& m) {
               &FeatureMatchingOptions::skip_image_pairs_in_same_frame,
               "Whether to skip matching images within the same frame. This is "
               "useful for the case of non-overlapping cameras in a rig.")
+          .def_readwrite("num_shards",
+                         &FeatureMatchingOptions::num_shards,
+                         "Number of shards for distributed feature matching. "
+                         "If larger than 1, only the image pairs of the shard "
+                         "are matched and written into the shard database.")
+          .def_readwrite("shard_index",
+                         &FeatureMatchingOptions::shard_index,
+                         "Index of the matched shard.")
+          .def_readwrite("shard_database_path",
+                         &FeatureMatchingOptions::shard_database_path,
+                         "Path to the shard database, into which the matches "
+                         "and two-view geometries of the shard are written.")
+          .def_readwrite("feature_cache_size",
+                         &FeatureMatchingOptions::feature_cache_size,
+                         "Maximum memory in gigabytes of the cached keypoints "
+                         "and descriptors. If positive, features are cached "
+                         "up to this memory instead of for a fixed number of "
+                         "images.")
+          .def_readwrite("spill_cache_path",
+                         &FeatureMatchingOptions::spill_cache_path,
+                         "Optional directory, e.g., on a local SSD, into which "
+                         "features evicted from the in-memory cache are "
+                         "spilled and from which later misses are served.")
+          .def_readwrite("spill_cache_size",
+                         &FeatureMatchingOptions::spill_cache_size,
+                         "Maximum size in gigabytes of the spilled features.")
+          .def_readwrite("checkpoint_path",
+                         &FeatureMatchingOptions::checkpoint_path,
+                         "Optional path to a checkpoint file, from which "
+                         "interrupted feature matching is resumed.")
+          .def_readwrite("progress_interval",
+                         &FeatureMatchingOptions::progress_interval,
+                         "Interval in seconds in which the progress of "
+                         "matching is logged and passed to the progress "
+                         "callback. Disabled if not positive.")
+          .def_readwrite("progress_callback",
+                         &FeatureMatchingOptions::progress_callback,
+                         "Optional callback, which is called with the "
+                         "FeatureMatchingProgress in every interval.")
+          .def_readwrite("batch_size",
+                         &FeatureMatchingOptions::batch_size,
+                         "Maximum number of image pairs passed to the matcher "
+                         "at once. Only used by batched matchers and ignored "
+                         "for guided matching.")
+          .def_readwrite("batch_timeout_ms",
+                         &FeatureMatchingOptions::batch_timeout_ms,
+                         "Maximum time in milliseconds to wait for further "
+                         "image pairs to fill a batch.")
           .def_readwrite("sift", &FeatureMatchingOptions::sift)
           .def("check", &FeatureMatchingOptions::Check);
 #ifdef COLMAP_ONNX_ENABLED
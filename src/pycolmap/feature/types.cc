@@ -19,22 +19,45 @@ void BindFeatureTypes(py::module& m) {
       .value("ALIKED_N16ROT", FeatureExtractorType::ALIKED_N16ROT)
       .value("ALIKED_N32", FeatureExtractorType::ALIKED_N32);
 
+  auto PyFeatureDescriptorPrecision =
+      py::enum_<FeatureDescriptorPrecision>(m, "FeatureDescriptorPrecision")
+          .value("NATIVE",
+                 FeatureDescriptorPrecision::NATIVE,
+                 "Precision of the extractor, i.e., uint8 for SIFT and "
+                 "float32 for ALIKED.")
+          .value("FLOAT16",
+                 FeatureDescriptorPrecision::FLOAT16,
+                 "Half precision for float descriptors.")
+          .value("INT8",
+                 FeatureDescriptorPrecision::INT8,
+                 "Linear quantization of float descriptors in [-1, 1].");
+  AddStringToEnumConstructor(PyFeatureDescriptorPrecision);
+
   // Define both classes first without cross-referencing methods.
   auto PyFeatureDescriptors =
       py::classh<FeatureDescriptors>(m, "FeatureDescriptors")
           .def(py::init<>())
-          .def(py::init<FeatureExtractorType, FeatureDescriptorsData>(),
+          .def(py::init<FeatureExtractorType,
+                        FeatureDescriptorsData,
+                        FeatureDescriptorPrecision>(),
                "type"_a,
-               "data"_a)
+               "data"_a,
+               "precision"_a = FeatureDescriptorPrecision::NATIVE)
           .def_readwrite("type", &FeatureDescriptors::type)
-          .def_readwrite("data", &FeatureDescriptors::data);
+          .def_readwrite("precision", &FeatureDescriptors::precision)
+          .def_readwrite("data", &FeatureDescriptors::data)
+          .def("num_dims", &FeatureDescriptors::NumDims);
   auto PyFeatureDescriptorsFloat =
       py::classh<FeatureDescriptorsFloat>(m, "FeatureDescriptorsFloat")
           .def(py::init<>())
-          .def(py::init<FeatureExtractorType, FeatureDescriptorsFloatData>(),
+          .def(py::init<FeatureExtractorType,
+                        FeatureDescriptorsFloatData,
+                        FeatureDescriptorPrecision>(),
                "type"_a,
-               "data"_a)
+               "data"_a,
+               "precision"_a = FeatureDescriptorPrecision::NATIVE)
           .def_readwrite("type", &FeatureDescriptorsFloat::type)
+          .def_readwrite("precision", &FeatureDescriptorsFloat::precision)
           .def_readwrite("data", &FeatureDescriptorsFloat::data);
 
   // Add cross-referencing methods after both classes are defined.
@@ -42,22 +65,20 @@ void BindFeatureTypes(py::module& m) {
       .def_static("from_float",
                   &FeatureDescriptors::FromFloat,
                   "float_desc"_a,
-                  "Create from float descriptors by reinterpreting float32 "
-                  "data as uint8 bytes.")
+                  "Create from float descriptors by encoding them as uint8 "
+                  "bytes in the precision of the float descriptors.")
       .def("to_float",
            &FeatureDescriptors::ToFloat,
-           "Convert to float descriptors by reinterpreting uint8 data as "
-           "float32.");
+           "Convert to float descriptors by decoding the uint8 data.");
   PyFeatureDescriptorsFloat
       .def_static("from_bytes",
                   &FeatureDescriptorsFloat::FromBytes,
                   "byte_desc"_a,
-                  "Create from byte descriptors by reinterpreting uint8 "
-                  "data as float32.")
+                  "Create from byte descriptors by decoding the uint8 data.")
       .def("to_bytes",
            &FeatureDescriptorsFloat::ToBytes,
-           "Convert to byte descriptors by reinterpreting float32 data as "
-           "uint8.");
+           "Convert to byte descriptors by encoding the float data in the "
+           "precision.");
 
   MakeDataclass(PyFeatureDescriptors);
   MakeDataclass(PyFeatureDescriptorsFloat);
@@ -88,7 +109,21 @@ void BindFeatureTypes(py::module& m) {
             return ss.str();
           });
   MakeDataclass(PyFeatureKeypoint);
-  py::bind_vector<FeatureKeypoints>(m, "FeatureKeypoints");
+  static_assert(sizeof(FeatureKeypoint) == 6 * sizeof(float));
+  py::bind_vector<FeatureKeypoints>(m, "FeatureKeypoints")
+      .def_property_readonly(
+          "data",
+          [](py::object self) {
+            FeatureKeypoints& keypoints = self.cast<FeatureKeypoints&>();
+            return py::array_t<float>(
+                {keypoints.size(), size_t(6)},
+                {sizeof(FeatureKeypoint), sizeof(float)},
+                keypoints.empty() ? nullptr : &keypoints[0].x,
+                self);
+          },
+          "Nx6 view [x, y, a11, a12, a21, a22] of the keypoints without "
+          "copying. The view keeps the keypoints alive and is invalidated "
+          "when they are resized.");
   py::implicitly_convertible<py::iterable, FeatureKeypoints>();
 
   auto PyFeatureMatch =
@@ -104,7 +139,21 @@ void BindFeatureTypes(py::module& m) {
             return ss.str();
           });
   MakeDataclass(PyFeatureMatch);
-  py::bind_vector<FeatureMatches>(m, "FeatureMatches");
+  static_assert(sizeof(FeatureMatch) == 2 * sizeof(point2D_t));
+  py::bind_vector<FeatureMatches>(m, "FeatureMatches")
+      .def_property_readonly(
+          "data",
+          [](py::object self) {
+            FeatureMatches& matches = self.cast<FeatureMatches&>();
+            return py::array_t<point2D_t>(
+                {matches.size(), size_t(2)},
+                {sizeof(FeatureMatch), sizeof(point2D_t)},
+                matches.empty() ? nullptr : &matches[0].point2D_idx1,
+                self);
+          },
+          "Nx2 view [point2D_idx1, point2D_idx2] of the matches without "
+          "copying. The view keeps the matches alive and is invalidated when "
+          "they are resized.");
   py::implicitly_convertible<py::iterable, FeatureMatches>();
 
   m.def("keypoints_to_matrix",
@@ -172,6 +172,42 @@ def test_feature_matches_vector():
     assert len(matches) == 2
 
 
+def test_feature_keypoints_data_view():
+    keypoints = pycolmap.FeatureKeypoints()
+    assert keypoints.data.shape == (0, 6)
+    keypoint = pycolmap.FeatureKeypoint()
+    keypoint.x = 1.0
+    keypoint.y = 2.0
+    keypoint.a11 = 3.0
+    keypoint.a12 = 4.0
+    keypoint.a21 = 5.0
+    keypoint.a22 = 6.0
+    keypoints.append(keypoint)
+    keypoints.append(pycolmap.FeatureKeypoint())
+    data = keypoints.data
+    assert data.dtype == np.float32
+    assert data.shape == (2, 6)
+    np.testing.assert_array_equal(data[0], [1, 2, 3, 4, 5, 6])
+    # The view shares the memory of the keypoints.
+    data[1, 0] = 7.0
+    assert keypoints[1].x == 7.0
+    # The view keeps the keypoints alive.
+    del keypoints
+    np.testing.assert_array_equal(data[0], [1, 2, 3, 4, 5, 6])
+
+
+def test_feature_matches_data_view():
+    matches = pycolmap.FeatureMatches()
+    assert matches.data.shape == (0, 2)
+    matches.append(pycolmap.FeatureMatch(0, 1))
+    matches.append(pycolmap.FeatureMatch(2, 3))
+    data = matches.data
+    assert data.dtype == np.uint32
+    np.testing.assert_array_equal(data, [[0, 1], [2, 3]])
+    data[0, 1] = 5
+    assert matches[0].point2D_idx2 == 5
+
+
 def test_keypoints_to_from_matrix_roundtrip():
     keypoints = pycolmap.FeatureKeypoints()
     keypoint = pycolmap.FeatureKeypoint()
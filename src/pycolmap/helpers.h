@@ -6,11 +6,13 @@
 
 #include "pycolmap/feature/opaque_types.h"
 
+#include <chrono>
 #include <exception>
 #include <optional>
 #include <regex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <type_traits>
 
 #include <Eigen/Core>
@@ -453,6 +455,9 @@ inline void PyWait(colmap::Thread* thread, double gap = 2.0) {
       thread->Wait();
       throw py::error_already_set();
     }
+    // Avoid spinning a core while waiting, e.g., when several threads of the
+    // Python interpreter wait for pipelines concurrently.
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
   }
   // after finishing join the thread to avoid abort
   thread->Wait();
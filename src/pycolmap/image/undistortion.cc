@@ -24,7 +24,9 @@ void BindUndistortion(py::module& m) {
           .def_readwrite("roi_max_x", &UndistortCameraOptions::roi_max_x)
           .def_readwrite("roi_max_y", &UndistortCameraOptions::roi_max_y)
           .def_readwrite("max_cam_point_norm",
-                         &UndistortCameraOptions::max_cam_point_norm);
+                         &UndistortCameraOptions::max_cam_point_norm)
+          .def_readwrite("warp_map_max_error",
+                         &UndistortCameraOptions::warp_map_max_error);
   MakeDataclass(PyUndistortCameraOptions);
 
   m.def("undistort_camera",
@@ -64,6 +64,13 @@ def test_undistort_camera_options_roi_max_y_readwrite():
     assert options.roi_max_y == 0.8
 
 
+def test_undistort_camera_options_warp_map_max_error_readwrite():
+    options = pycolmap.UndistortCameraOptions()
+    assert isinstance(options.warp_map_max_error, float)
+    options.warp_map_max_error = -1.0
+    assert options.warp_map_max_error == -1.0
+
+
 def test_undistort_camera():
     options = pycolmap.UndistortCameraOptions()
     camera = pycolmap.Camera.create_from_model_id(
@@ -1,4 +1,5 @@
 #include "colmap/optim/ransac.h"
+#include "colmap/optim/sparse_cholesky.h"
 
 #include "pycolmap/helpers.h"
 
@@ -30,4 +31,30 @@ void BindOptim(py::module& m) {
           .def_readwrite("num_threads", &RANSACOptions::num_threads)
           .def("check", &RANSACOptions::Check);
   MakeDataclass(PyRANSACOptions);
+
+  auto PySparseCholeskyBackend =
+      py::enum_<SparseCholeskyOptions::Backend>(m, "SparseCholeskyBackend")
+          .value("SUPERNODAL", SparseCholeskyOptions::Backend::SUPERNODAL)
+          .value("SIMPLICIAL", SparseCholeskyOptions::Backend::SIMPLICIAL);
+  AddStringToEnumConstructor(PySparseCholeskyBackend);
+
+  auto PySparseCholeskyOrdering =
+      py::enum_<SparseCholeskyOptions::Ordering>(m, "SparseCholeskyOrdering")
+          .value("AUTO", SparseCholeskyOptions::Ordering::AUTO)
+          .value("AMD", SparseCholeskyOptions::Ordering::AMD)
+          .value("METIS", SparseCholeskyOptions::Ordering::METIS)
+          .value("NESDIS", SparseCholeskyOptions::Ordering::NESDIS);
+  AddStringToEnumConstructor(PySparseCholeskyOrdering);
+
+  auto PySparseCholeskyOptions =
+      py::classh<SparseCholeskyOptions>(m, "SparseCholeskyOptions")
+          .def(py::init<>())
+          .def_readwrite("backend",
+                         &SparseCholeskyOptions::backend,
+                         "CHOLMOD supernodal LLT with simplicial LDLT "
+                         "fallback or simplicial LDLT only.")
+          .def_readwrite("ordering",
+                         &SparseCholeskyOptions::ordering,
+                         "Fill-reducing ordering of the supernodal backend.");
+  MakeDataclass(PySparseCholeskyOptions);
 }
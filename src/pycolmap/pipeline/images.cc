@@ -33,10 +33,15 @@ void ImportImages(const std::filesystem::path& database_path,
   ImageReaderOptions options(options_);
   options.image_path = image_path;
   options.image_names = image_names;
+  // Only the metadata of the images is imported, so there is no need to
+  // decode JPEG images.
+  options.defer_jpeg_decoding = true;
   UpdateImageReaderOptionsFromCameraMode(options, camera_mode);
 
+  py::gil_scoped_release release;
   auto database = Database::Open(database_path);
   ImageReader image_reader(options, database.get());
+  image_reader.PrescanMetaData();
 
   PyInterrupt py_interrupt(2.0);
 
@@ -224,6 +229,23 @@ void BindImages(py::module& m) {
               "Optional path to an image file specifying a mask for all "
               "images. No features will be extracted in regions where the "
               "mask is black (pixel intensity value 0 in grayscale)")
+          .def_readwrite("read_video_frames",
+                         &IROpts::read_video_frames,
+                         "Whether to read the frames of video files in the "
+                         "image path directly. The frame with index 12 of a "
+                         "video abc/012.mp4 is named "
+                         "abc/012.mp4/frame_000012.png. All frames of a video "
+                         "share the same camera.")
+          .def_readwrite("video_min_frame_difference",
+                         &IROpts::video_min_frame_difference,
+                         "Skip video frames whose mean absolute intensity "
+                         "difference in [0, 255] to the previously read frame "
+                         "is below this threshold.")
+          .def_readwrite("video_min_relative_sharpness",
+                         &IROpts::video_min_relative_sharpness,
+                         "Skip blurry video frames whose sharpness is below "
+                         "this fraction of the average sharpness of the "
+                         "preceding frames. Disabled if 0.")
           .def("check", &IROpts::Check);
   MakeDataclass(PyImageReaderOptions);
 
@@ -246,7 +268,8 @@ void BindImages(py::module& m) {
         &InferCameraFromImage,
         "image_path"_a,
         py::arg_v("options", ImageReaderOptions(), "ImageReaderOptions()"),
-        "Guess the camera parameters from the EXIF metadata");
+        "Guess the camera parameters from the EXIF metadata",
+        py::call_guard<py::gil_scoped_release>());
 
   m.def("undistort_images",
         &UndistortImages,
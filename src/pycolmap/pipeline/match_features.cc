@@ -104,6 +104,10 @@ void BindMatchFeatures(py::module& m) {
       py::classh<ExhaustivePairingOptions>(m, "ExhaustivePairingOptions")
           .def(py::init<>())
           .def_readwrite("block_size", &ExhaustivePairingOptions::block_size)
+          .def_readwrite("hilbert_order",
+                         &ExhaustivePairingOptions::hilbert_order)
+          .def_readwrite("num_cached_blocks",
+                         &ExhaustivePairingOptions::num_cached_blocks)
           .def("check", &ExhaustivePairingOptions::Check);
   MakeDataclass(PyExhaustivePairingOptions);
 
@@ -162,9 +166,52 @@ void BindMatchFeatures(py::module& m) {
               &VocabTreePairingOptions::match_list_path,
               "Optional path to file with specific image names to match.")
           .def_readwrite("num_threads", &VocabTreePairingOptions::num_threads)
+          .def_readwrite("query_batch_size",
+                         &VocabTreePairingOptions::query_batch_size,
+                         "Number of query images retrieved together in one "
+                         "batch.")
+          .def_readwrite("index_batch_size",
+                         &VocabTreePairingOptions::index_batch_size,
+                         "Number of images indexed together in one batch.")
+          .def_readwrite(
+              "index_path",
+              &VocabTreePairingOptions::index_path,
+              "Optional path to the index of the database images. If the "
+              "file exists, only images missing from the index are indexed "
+              "and then saved to the file.")
           .def("check", &VocabTreePairingOptions::Check);
   MakeDataclass(PyVocabTreePairingOptions);
 
+  auto PyGlobalDescriptorPairingOptions =
+      py::classh<GlobalDescriptorPairingOptions>(
+          m, "GlobalDescriptorPairingOptions")
+          .def(py::init<>())
+          .def_readwrite("num_images",
+                         &GlobalDescriptorPairingOptions::num_images,
+                         "Number of images to retrieve for each query image.")
+          .def_readwrite(
+              "num_clusters",
+              &GlobalDescriptorPairingOptions::num_clusters,
+              "Number of centroids of the codebook, which aggregates the "
+              "local features of an image into its global descriptor.")
+          .def_readwrite(
+              "codebook_num_training_features",
+              &GlobalDescriptorPairingOptions::codebook_num_training_features,
+              "Maximum number of local features used to train the codebook.")
+          .def_readwrite("max_num_features",
+                         &GlobalDescriptorPairingOptions::max_num_features,
+                         "The maximum number of features aggregated into the "
+                         "global descriptor of an image.")
+          .def_readwrite(
+              "codebook_path",
+              &GlobalDescriptorPairingOptions::codebook_path,
+              "Optional path to the codebook. Read if it exists, otherwise "
+              "trained on the images and written to it.")
+          .def_readwrite("num_threads",
+                         &GlobalDescriptorPairingOptions::num_threads)
+          .def("check", &GlobalDescriptorPairingOptions::Check);
+  MakeDataclass(PyGlobalDescriptorPairingOptions);
+
   auto PySequentialPairingOptions =
       py::classh<SequentialPairingOptions>(m, "SequentialPairingOptions")
           .def(py::init<>())
@@ -175,6 +222,16 @@ void BindMatchFeatures(py::module& m) {
               "quadratic_overlap",
               &SequentialPairingOptions::quadratic_overlap,
               "Whether to match images against their quadratic neighbors.")
+          .def_readwrite("adaptive_overlap",
+                         &SequentialPairingOptions::adaptive_overlap,
+                         "Whether to limit the overlap of an image based on "
+                         "the number of inlier matches of the previous image "
+                         "with its neighbors.")
+          .def_readwrite(
+              "adaptive_overlap_min_num_inliers",
+              &SequentialPairingOptions::adaptive_overlap_min_num_inliers,
+              "Minimum number of inlier matches for a neighbor to count "
+              "towards the adaptive overlap.")
           .def_readwrite("expand_rig_images",
                          &SequentialPairingOptions::expand_rig_images,
                          "Whether to match an image against all images in "
@@ -213,6 +270,10 @@ void BindMatchFeatures(py::module& m) {
               "The maximum number of features to use for indexing "
               "an image. If an image has more features, only the "
               "largest-scale features will be indexed.")
+          .def_readwrite(
+              "loop_detection_query_batch_size",
+              &SequentialPairingOptions::loop_detection_query_batch_size,
+              "Number of loop detection queries to retrieve in one batch.")
           .def_readwrite("vocab_tree_path",
                          &SequentialPairingOptions::vocab_tree_path,
                          "Path to the vocabulary tree.")
@@ -302,6 +363,22 @@ void BindMatchFeatures(py::module& m) {
         "device"_a = Device::AUTO,
         "Vocab tree feature matching");
 
+  m.def("match_global_descriptor",
+        &MatchFeatures<GlobalDescriptorPairingOptions,
+                       CreateGlobalDescriptorFeatureMatcher>,
+        "database_path"_a,
+        py::arg_v("matching_options",
+                  FeatureMatchingOptions(),
+                  "FeatureMatchingOptions()"),
+        py::arg_v("pairing_options",
+                  GlobalDescriptorPairingOptions(),
+                  "GlobalDescriptorPairingOptions()"),
+        py::arg_v("verification_options",
+                  TwoViewGeometryOptions(),
+                  "TwoViewGeometryOptions()"),
+        "device"_a = Device::AUTO,
+        "Global image descriptor feature matching");
+
   m.def(
       "match_sequential",
       &MatchFeatures<SequentialPairingOptions, CreateSequentialFeatureMatcher>,
@@ -372,7 +449,13 @@ void BindMatchFeatures(py::module& m) {
   py::classh<PairGenerator>(m, "PairGenerator")
       .def("reset", &PairGenerator::Reset)
       .def("has_finished", &PairGenerator::HasFinished)
+      .def("progress",
+           &PairGenerator::Progress,
+           "Fraction of the image pairs returned by next() so far in [0, 1] "
+           "or negative, if the total number is unknown.")
       .def("next", &PairGenerator::Next)
+      .def("cursor", &PairGenerator::Cursor)
+      .def("seek", &PairGenerator::Seek, "cursor"_a)
       .def("all_pairs", &PairGenerator::AllPairs);
   py::classh<ExhaustivePairGenerator, PairGenerator>(m,
                                                      "ExhaustivePairGenerator")
@@ -387,6 +470,12 @@ void BindMatchFeatures(py::module& m) {
            "options"_a,
            "database"_a,
            "query_image_ids"_a = std::vector<image_t>());
+  py::classh<GlobalDescriptorPairGenerator, PairGenerator>(
+      m, "GlobalDescriptorPairGenerator")
+      .def(py::init<const GlobalDescriptorPairingOptions&,
+                    const std::shared_ptr<Database>&>(),
+           "options"_a,
+           "database"_a);
   py::classh<SequentialPairGenerator, PairGenerator>(m,
                                                      "SequentialPairGenerator")
       .def(py::init<const SequentialPairingOptions&,
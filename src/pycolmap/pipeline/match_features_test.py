@@ -14,6 +14,15 @@ def test_exhaustive_pairing_options_block_size():
     assert options.block_size == 100
 
 
+def test_exhaustive_pairing_options_hilbert_order():
+    options = pycolmap.ExhaustivePairingOptions()
+    options.hilbert_order = True
+    options.num_cached_blocks = 4
+    assert options.hilbert_order
+    assert options.num_cached_blocks == 4
+    assert options.check()
+
+
 def test_exhaustive_pairing_options_check():
     options = pycolmap.ExhaustivePairingOptions()
     assert options.check()
@@ -41,6 +50,16 @@ def test_spatial_pairing_options_check():
     assert options.check()
 
 
+def test_global_descriptor_pairing_options_check():
+    options = pycolmap.GlobalDescriptorPairingOptions()
+    assert options.check()
+    options.num_clusters = 8
+    options.codebook_num_training_features = 1000
+    assert options.num_clusters == 8
+    assert options.codebook_num_training_features == 1000
+    assert options.check()
+
+
 def test_vocab_tree_pairing_options_init():
     options = pycolmap.VocabTreePairingOptions()
     assert options is not None
@@ -1,6 +1,7 @@
 #include "colmap/mvs/advancing_front_meshing.h"
 #include "colmap/mvs/delaunay_meshing.h"
 #include "colmap/mvs/mesh_simplification.h"
+#include "colmap/mvs/mesh_tiling.h"
 #include "colmap/mvs/poisson_meshing.h"
 #include "colmap/util/file.h"
 #include "colmap/util/misc.h"
@@ -63,6 +64,17 @@ void BindMeshing(py::module& m) {
               "num_threads",
               &PoissonMOpts::num_threads,
               "The number of threads used for the Poisson reconstruction.")
+          .def_readwrite(
+              "max_num_points_per_block",
+              &PoissonMOpts::max_num_points_per_block,
+              "Maximum number of input points per block, which bounds the "
+              "memory usage. If positive, the blocks are reconstructed "
+              "separately at the same resolution and their meshes are merged. "
+              "Disabled if zero.")
+          .def_readwrite("block_overlap",
+                         &PoissonMOpts::block_overlap,
+                         "Overlap between neighboring blocks relative to the "
+                         "block extent.")
           .def("check", &PoissonMOpts::Check);
   MakeDataclass(PyPoissonMeshingOptions);
 
@@ -117,6 +129,16 @@ void BindMeshing(py::module& m) {
                          "certain percentile by the given factor, then it is "
                          "considered an outlier"
                          "mesh face and discarded.")
+          .def_readwrite(
+              "max_num_points_per_partition",
+              &DMOpts::max_num_points_per_partition,
+              "Maximum number of input points per spatial partition. If "
+              "positive, the partitions are meshed independently in parallel "
+              "and their surfaces are stitched together. Disabled if zero.")
+          .def_readwrite("partition_overlap",
+                         &DMOpts::partition_overlap,
+                         "Overlap between neighboring partitions relative to "
+                         "the partition extent.")
           .def_readwrite("num_threads",
                          &DMOpts::num_threads,
                          "The number of threads to use for reconstruction. "
@@ -135,7 +157,8 @@ void BindMeshing(py::module& m) {
       "output_path"_a,
       py::arg_v(
           "options", mvs::PoissonMeshingOptions(), "PoissonMeshingOptions()"),
-      "Perform Poisson surface reconstruction and return true if successful.");
+      "Perform Poisson surface reconstruction and return true if successful.",
+      py::call_guard<py::gil_scoped_release>());
 
 #ifdef COLMAP_CGAL_ENABLED
   m.def(
@@ -149,7 +172,8 @@ void BindMeshing(py::module& m) {
       "output_path"_a,
       py::arg_v(
           "options", mvs::DelaunayMeshingOptions(), "DelaunayMeshingOptions()"),
-      "Delaunay meshing of sparse COLMAP reconstructions.");
+      "Delaunay meshing of sparse COLMAP reconstructions.",
+      py::call_guard<py::gil_scoped_release>());
 
   m.def(
       "dense_delaunay_meshing",
@@ -162,7 +186,8 @@ void BindMeshing(py::module& m) {
       "output_path"_a,
       py::arg_v(
           "options", mvs::DelaunayMeshingOptions(), "DelaunayMeshingOptions()"),
-      "Delaunay meshing of dense COLMAP reconstructions.");
+      "Delaunay meshing of dense COLMAP reconstructions.",
+      py::call_guard<py::gil_scoped_release>());
 
   using AFMOpts = mvs::AdvancingFrontMeshingOptions;
   auto PyAdvancingFrontMeshingOptions =
@@ -213,7 +238,8 @@ void BindMeshing(py::module& m) {
                 mvs::AdvancingFrontMeshingOptions(),
                 "AdvancingFrontMeshingOptions()"),
       "Advancing front surface reconstruction of dense COLMAP "
-      "reconstructions.");
+      "reconstructions.",
+      py::call_guard<py::gil_scoped_release>());
 #endif
 
   using MSOpts = mvs::MeshSimplificationOptions;
@@ -237,6 +263,11 @@ void BindMeshing(py::module& m) {
                          &MSOpts::num_threads,
                          "The number of threads to use for initialization. "
                          "-1 = all threads.")
+          .def_readwrite("max_num_faces_per_block",
+                         &MSOpts::max_num_faces_per_block,
+                         "Maximum number of faces per spatial block; 0 = "
+                         "disabled. If enabled, larger meshes are split into "
+                         "blocks that are simplified in parallel.")
           .def("check", &MSOpts::Check);
   MakeDataclass(PyMeshSimplificationOptions);
 
@@ -260,4 +291,36 @@ void BindMeshing(py::module& m) {
       "Read a PLY mesh, simplify it using QEM decimation, and write "
       "the result.",
       py::call_guard<py::gil_scoped_release>());
+
+  using MTOpts = mvs::MeshTilingOptions;
+  auto PyMeshTilingOptions =
+      py::classh<MTOpts>(m, "MeshTilingOptions")
+          .def(py::init<>())
+          .def_readwrite("max_num_faces_per_tile",
+                         &MTOpts::max_num_faces_per_tile,
+                         "Maximum number of faces per tile at any level of "
+                         "detail.")
+          .def_readwrite("num_threads",
+                         &MTOpts::num_threads,
+                         "The number of threads to use. -1 = all threads.")
+          .def("check", &MTOpts::Check);
+  MakeDataclass(PyMeshTilingOptions);
+
+  m.def(
+      "tile_mesh",
+      [](const std::filesystem::path& input_path,
+         const std::filesystem::path& output_path,
+         const MTOpts& options) -> void {
+        THROW_CHECK_HAS_FILE_EXTENSION(input_path, ".ply");
+        THROW_CHECK_FILE_EXISTS(input_path);
+        CreateDirIfNotExists(output_path);
+        const PlyMesh mesh = ReadPlyMesh(input_path).mesh;
+        mvs::WriteMeshTiles(options, mesh, output_path);
+      },
+      "input_path"_a,
+      "output_path"_a,
+      py::arg_v("options", mvs::MeshTilingOptions(), "MeshTilingOptions()"),
+      "Read a PLY mesh and write it as a hierarchy of tiles with levels of "
+      "detail to the output directory.",
+      py::call_guard<py::gil_scoped_release>());
 }
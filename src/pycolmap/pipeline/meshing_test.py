@@ -46,6 +46,13 @@ def test_mesh_simplification_options_check():
     assert options.check()
 
 
+def test_mesh_tiling_options_check():
+    options = pycolmap.MeshTilingOptions()
+    options.max_num_faces_per_tile = 1000
+    assert options.max_num_faces_per_tile == 1000
+    assert options.check()
+
+
 @pytest.mark.skipif(
     not hasattr(pycolmap, "DelaunayMeshingOptions"),
     reason="DelaunayMeshingOptions not available",
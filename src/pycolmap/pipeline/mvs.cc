@@ -1,15 +1,12 @@
 #include "colmap/exe/mvs.h"
 
 #include "colmap/mvs/fusion.h"
+#include "colmap/mvs/patch_match.h"
 #include "colmap/mvs/patch_match_options.h"
 #include "colmap/scene/reconstruction.h"
 #include "colmap/util/file.h"
 #include "colmap/util/misc.h"
 
-#ifdef COLMAP_CUDA_ENABLED
-#include "colmap/mvs/patch_match.h"
-#endif  // COLMAP_CUDA_ENABLED
-
 #include "colmap/util/logging.h"
 
 #include "pycolmap/helpers.h"
@@ -30,6 +27,11 @@ void BindMVS(py::module& m) {
           .def_readwrite("max_image_size",
                          &PMOpts::max_image_size,
                          "Maximum image size in either dimension.")
+          .def_readwrite("use_gpu",
+                         &PMOpts::use_gpu,
+                         "Whether to run PatchMatch on the GPU. Otherwise, the "
+                         "multi-threaded CPU implementation is used, which is "
+                         "considerably slower but does not require CUDA.")
           .def_readwrite(
               "gpu_index",
               &PMOpts::gpu_index,
@@ -55,6 +57,18 @@ void BindMVS(py::module& m) {
               "num_samples",
               &PMOpts::num_samples,
               "Number of random samples to draw in Monte Carlo sampling.")
+          .def_readwrite("src_image_selection",
+                         &PMOpts::src_image_selection,
+                         "Ranking of the candidate source images for the "
+                         "__auto__ configuration: shared_points or score.")
+          .def_readwrite("src_image_prune_min_sel_prob",
+                         &PMOpts::src_image_prune_min_sel_prob,
+                         "Minimum selection probability of a source image in "
+                         "a tile of pixels to keep computing its costs. "
+                         "0 disables pruning.")
+          .def_readwrite("src_image_prune_tile_size",
+                         &PMOpts::src_image_prune_tile_size,
+                         "Size of the pixel tiles for source image pruning.")
           .def_readwrite("ncc_sigma",
                          &PMOpts::ncc_sigma,
                          "Spread of the NCC likelihood function.")
@@ -67,6 +81,38 @@ void BindMVS(py::module& m) {
           .def_readwrite("num_iterations",
                          &PMOpts::num_iterations,
                          "Number of coordinate descent iterations.")
+          .def_readwrite("pyramid_num_levels",
+                         &PMOpts::pyramid_num_levels,
+                         "Number of levels for coarse-to-fine estimation of "
+                         "the photometric depth and normal maps.")
+          .def_readwrite("pyramid_num_iterations",
+                         &PMOpts::pyramid_num_iterations,
+                         "Number of coordinate descent iterations at the "
+                         "levels finer than the coarsest pyramid level.")
+          .def_readwrite("init_mode",
+                         &PMOpts::init_mode,
+                         "Initialization of the photometric problem: "
+                         "random, sparse (interpolated sparse point depths), "
+                         "or prior (depth maps in the prior_depth_maps "
+                         "folder of the stereo folder).")
+          .def_readwrite("init_num_iterations",
+                         &PMOpts::init_num_iterations,
+                         "Number of coordinate descent iterations at the "
+                         "coarsest level for sparse or prior initialization. "
+                         "-1 uses num_iterations.")
+          .def_readwrite("half_precision",
+                         &PMOpts::half_precision,
+                         "Whether to store the per source image cost and "
+                         "selection probability maps and the source depth "
+                         "maps in half precision on the GPU.")
+          .def_readwrite("tile_size",
+                         &PMOpts::tile_size,
+                         "Maximum width and height of the reference image "
+                         "tiles to bound the GPU memory. 0 disables tiling.")
+          .def_readwrite("tile_overlap",
+                         &PMOpts::tile_overlap,
+                         "Overlap of neighboring tiles in pixels, across which "
+                         "the tile outputs are blended.")
           .def_readwrite("geom_consistency",
                          &PMOpts::geom_consistency,
                          "Whether to add a regularized geometric consistency "
@@ -109,6 +155,20 @@ void BindMVS(py::module& m) {
           .def_readwrite("write_consistency_graph",
                          &PMOpts::write_consistency_graph,
                          "Whether to write the consistency graph.")
+          .def_readwrite("map_compression",
+                         &PMOpts::map_compression,
+                         "Format of the written depth and normal maps: "
+                         "none, lossless, or quantized.")
+          .def_readwrite("distributed",
+                         &PMOpts::distributed,
+                         "Whether to claim problems through lock directories "
+                         "in the workspace, so that multiple processes can "
+                         "process the same workspace concurrently.")
+          .def_readwrite("io_pipeline_depth",
+                         &PMOpts::io_pipeline_depth,
+                         "Number of problems per GPU whose inputs are read "
+                         "ahead and whose outputs are written in the "
+                         "background. 0 disables pipelining.")
           .def_readwrite("num_threads",
                          &PMOpts::num_threads,
                          "Number of threads for processing. "
@@ -123,7 +183,7 @@ void BindMVS(py::module& m) {
         "pmvs_option_name"_a = "option-all",
         py::arg_v("options", mvs::PatchMatchOptions(), "PatchMatchOptions()"),
         "config_path"_a = "",
-        "Runs Patch-Match-Stereo (requires CUDA)",
+        "Runs Patch-Match-Stereo on the GPU or CPU.",
         py::call_guard<py::gil_scoped_release>());
 
   using SFOpts = mvs::StereoFusionOptions;
@@ -173,6 +233,33 @@ void BindMVS(py::module& m) {
           .def_readwrite("cache_size",
                          &SFOpts::cache_size,
                          "Cache size in gigabytes for fusion.")
+          .def_readwrite("use_gpu",
+                         &SFOpts::use_gpu,
+                         "Whether to check the consistency of the reference "
+                         "pixels with the overlapping images on the GPU.")
+          .def_readwrite("gpu_index",
+                         &SFOpts::gpu_index,
+                         "Index of the GPU used for fusion. Set to -1 to "
+                         "select the best GPU.")
+          .def_readwrite("stream_output_path",
+                         &SFOpts::stream_output_path,
+                         "If not empty, the fused points are written to this "
+                         "PLY file and their visibility to <path>.vis after "
+                         "every fused image instead of keeping them in "
+                         "memory.")
+          .def_readwrite("input_fused_path",
+                         &SFOpts::input_fused_path,
+                         "If not empty, the points of a previous fusion are "
+                         "read from this PLY file and <path>.vis and only "
+                         "the images with changed depth maps and the images "
+                         "observing their points are fused again.")
+          .def_readwrite("merge_radius",
+                         &SFOpts::merge_radius,
+                         "If positive, fused points in the same cell of a "
+                         "voxel grid with this factor times the pixel "
+                         "footprint of the points as cell size are merged "
+                         "into a single point with the union of their "
+                         "visibility.")
           .def_readwrite("bounding_box",
                          &SFOpts::bounding_box,
                          "Bounding box Tuple[min, max]")
@@ -157,6 +157,9 @@ void BindSfM(py::module& m) {
                            &Opts::min_calibrated_pair_ratio)
             .def_readwrite("reestimate_relative_pose",
                            &Opts::reestimate_relative_pose)
+            .def_readwrite("skip_unchanged_pairs", &Opts::skip_unchanged_pairs)
+            .def_readwrite("max_unchanged_focal_length_change",
+                           &Opts::max_unchanged_focal_length_change)
             .def_readwrite("min_focal_length_ratio",
                            &Opts::min_focal_length_ratio)
             .def_readwrite("max_focal_length_ratio",
@@ -180,6 +183,11 @@ void BindSfM(py::module& m) {
             .def(py::init<>())
             .def_readwrite("num_threads", &Opts::num_threads)
             .def_readwrite("random_seed", &Opts::random_seed)
+            .def_readwrite("deterministic",
+                           &Opts::deterministic,
+                           "Whether to produce bit-identical results "
+                           "independent of the number of threads. Requires "
+                           "random_seed >= 0.")
             .def_readwrite("refine_sensor_from_rig",
                            &Opts::refine_sensor_from_rig,
                            "When False, treat each non-ref sensor's "
@@ -190,6 +198,8 @@ void BindSfM(py::module& m) {
             .def_readwrite("global_positioning", &Opts::global_positioning)
             .def_readwrite("bundle_adjustment", &Opts::bundle_adjustment)
             .def_readwrite("retriangulation", &Opts::retriangulation)
+            .def_readwrite("max_pose_graph_degree",
+                           &Opts::max_pose_graph_degree)
             .def_readwrite("track_intra_image_consistency_threshold",
                            &Opts::track_intra_image_consistency_threshold)
             .def_readwrite("track_required_tracks_per_view",
@@ -215,7 +225,9 @@ void BindSfM(py::module& m) {
                            &Opts::skip_global_positioning)
             .def_readwrite("skip_bundle_adjustment",
                            &Opts::skip_bundle_adjustment)
-            .def_readwrite("skip_retriangulation", &Opts::skip_retriangulation);
+            .def_readwrite("skip_retriangulation", &Opts::skip_retriangulation)
+            .def_readwrite("extend_reconstruction",
+                           &Opts::extend_reconstruction);
     MakeDataclass(PyOpts);
   }
 
@@ -228,6 +240,8 @@ void BindSfM(py::module& m) {
             .def_readwrite("min_num_matches", &Opts::min_num_matches)
             .def_readwrite("ignore_watermarks", &Opts::ignore_watermarks)
             .def_readwrite("image_names", &Opts::image_names)
+            .def_readwrite("correspondence_graph_snapshot_path",
+                           &Opts::correspondence_graph_snapshot_path)
             .def_readwrite("num_threads", &Opts::num_threads)
             .def_readwrite("random_seed", &Opts::random_seed)
             .def_readwrite("decompose_relative_pose",
@@ -50,6 +50,20 @@ class PyVisualIndexImpl : public VisualIndex, py::trampoline_self_life_support {
         void, VisualIndex, Add, options, image_id, keypoints, descriptors);
   }
 
+  void AddBatch(const IndexOptions& options,
+                const std::vector<int>& image_ids,
+                const std::vector<const FeatureKeypoints*>& keypoints,
+                const std::vector<const FeatureDescriptorsFloat*>& descriptors)
+      override {
+    PYBIND11_OVERRIDE_PURE(void,
+                           VisualIndex,
+                           AddBatch,
+                           options,
+                           image_ids,
+                           keypoints,
+                           descriptors);
+  }
+
   bool IsImageIndexed(int image_id) const override {
     PYBIND11_OVERRIDE_PURE(bool, VisualIndex, IsImageIndexed, image_id);
   }
@@ -69,6 +83,20 @@ class PyVisualIndexImpl : public VisualIndex, py::trampoline_self_life_support {
         void, VisualIndex, Query, keypoints, descriptors, image_scores);
   }
 
+  void QueryBatch(
+      const QueryOptions& options,
+      const std::vector<const FeatureKeypoints*>& keypoints,
+      const std::vector<const FeatureDescriptorsFloat*>& descriptors,
+      std::vector<std::vector<ImageScore>>* image_scores) const override {
+    PYBIND11_OVERRIDE_PURE(void,
+                           VisualIndex,
+                           QueryBatch,
+                           options,
+                           keypoints,
+                           descriptors,
+                           image_scores);
+  }
+
   void Prepare() override {
     PYBIND11_OVERRIDE_PURE(void, VisualIndex, Prepare);
   }
@@ -82,6 +110,14 @@ class PyVisualIndexImpl : public VisualIndex, py::trampoline_self_life_support {
     PYBIND11_OVERRIDE_PURE(void, VisualIndex, Read);
   }
 
+  void AppendImages(const std::filesystem::path& path) override {
+    PYBIND11_OVERRIDE_PURE(void, VisualIndex, AppendImages, path);
+  }
+
+  int NumDeltaSegments() const override {
+    PYBIND11_OVERRIDE_PURE(int, VisualIndex, NumDeltaSegments);
+  }
+
  protected:
   void ReadFromFaiss(const std::filesystem::path& path,
                      long offset,
@@ -136,7 +172,9 @@ void BindVisualIndex(py::module& m) {
           .def_readwrite("num_rounds", &VisualIndex::BuildOptions::num_rounds)
           .def_readwrite("num_checks", &VisualIndex::BuildOptions::num_checks)
           .def_readwrite("num_threads",
-                         &VisualIndex::BuildOptions::num_threads);
+                         &VisualIndex::BuildOptions::num_threads)
+          .def_readwrite("use_gpu", &VisualIndex::BuildOptions::use_gpu)
+          .def_readwrite("gpu_index", &VisualIndex::BuildOptions::gpu_index);
   MakeDataclass(PyBuildOptions);
 
   PyVisualIndex.def(py::init<>())
@@ -148,6 +186,30 @@ void BindVisualIndex(py::module& m) {
                const FeatureKeypoints&,
                const FeatureDescriptorsFloat&)>(&VisualIndex::Add),
            py::call_guard<py::gil_scoped_release>())
+      .def(
+          "add_batch",
+          [](VisualIndex& self,
+             const typename VisualIndex::IndexOptions& options,
+             const std::vector<int>& image_ids,
+             const std::vector<FeatureKeypoints>& keypoints,
+             const std::vector<FeatureDescriptorsFloat>& descriptors) {
+            THROW_CHECK_EQ(keypoints.size(), image_ids.size());
+            THROW_CHECK_EQ(descriptors.size(), image_ids.size());
+            std::vector<const FeatureKeypoints*> keypoints_ptrs;
+            std::vector<const FeatureDescriptorsFloat*> descriptors_ptrs;
+            keypoints_ptrs.reserve(keypoints.size());
+            descriptors_ptrs.reserve(descriptors.size());
+            for (size_t i = 0; i < keypoints.size(); ++i) {
+              keypoints_ptrs.push_back(&keypoints[i]);
+              descriptors_ptrs.push_back(&descriptors[i]);
+            }
+            self.AddBatch(options, image_ids, keypoints_ptrs, descriptors_ptrs);
+          },
+          "options"_a,
+          "image_ids"_a,
+          "keypoints"_a,
+          "descriptors"_a,
+          py::call_guard<py::gil_scoped_release>())
       .def("is_image_indexed", &VisualIndex::IsImageIndexed)
       .def("num_visual_words", &VisualIndex::NumVisualWords)
       .def("num_images", &VisualIndex::NumImages)
@@ -167,6 +229,30 @@ void BindVisualIndex(py::module& m) {
                const FeatureDescriptorsFloat&,
                std::vector<ImageScore>*) const>(&VisualIndex::Query),
            py::call_guard<py::gil_scoped_release>())
+      .def(
+          "query_batch",
+          [](const VisualIndex& self,
+             const typename VisualIndex::QueryOptions& options,
+             const std::vector<FeatureKeypoints>& keypoints,
+             const std::vector<FeatureDescriptorsFloat>& descriptors) {
+            THROW_CHECK_EQ(keypoints.size(), descriptors.size());
+            std::vector<const FeatureKeypoints*> keypoints_ptrs;
+            std::vector<const FeatureDescriptorsFloat*> descriptors_ptrs;
+            keypoints_ptrs.reserve(keypoints.size());
+            descriptors_ptrs.reserve(descriptors.size());
+            for (size_t i = 0; i < keypoints.size(); ++i) {
+              keypoints_ptrs.push_back(&keypoints[i]);
+              descriptors_ptrs.push_back(&descriptors[i]);
+            }
+            std::vector<std::vector<ImageScore>> image_scores;
+            self.QueryBatch(
+                options, keypoints_ptrs, descriptors_ptrs, &image_scores);
+            return image_scores;
+          },
+          "options"_a,
+          "keypoints"_a,
+          "descriptors"_a,
+          py::call_guard<py::gil_scoped_release>())
       .def("prepare",
            &VisualIndex::Prepare,
            py::call_guard<py::gil_scoped_release>())
@@ -178,6 +264,10 @@ void BindVisualIndex(py::module& m) {
       .def("write",
            &VisualIndex::Write,
            py::call_guard<py::gil_scoped_release>())
+      .def("append_images",
+           &VisualIndex::AppendImages,
+           py::call_guard<py::gil_scoped_release>())
+      .def("num_delta_segments", &VisualIndex::NumDeltaSegments)
       .def("__repr__", [](const VisualIndex& self) {
         std::ostringstream ss;
         ss << self;
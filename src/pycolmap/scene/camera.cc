@@ -22,6 +22,19 @@ using namespace colmap;
 using namespace pybind11::literals;
 namespace py = pybind11;
 
+namespace {
+
+template <typename VectorType, typename MatrixType>
+std::vector<VectorType> RowsToVector(const MatrixType& matrix) {
+  std::vector<VectorType> vectors(matrix.rows());
+  for (Eigen::Index i = 0; i < matrix.rows(); ++i) {
+    vectors[i] = matrix.row(i).transpose();
+  }
+  return vectors;
+}
+
+}  // namespace
+
 void BindCamera(py::module& m) {
   py::enum_<CameraModelId> PyCameraModelId(m, "CameraModelId");
   PyCameraModelId.value("INVALID", CameraModelId::kInvalid);
@@ -144,10 +157,17 @@ void BindCamera(py::module& m) {
           "cam_from_img",
           [](const Camera& self,
              const py::EigenDRef<const Eigen::MatrixX2d>& image_points) {
+            const std::vector<Eigen::Vector2d> image_points_vec =
+                RowsToVector<Eigen::Vector2d>(image_points);
+            std::vector<std::optional<Eigen::Vector2d>> maybe_cam_points(
+                image_points_vec.size());
+            self.CamFromImgBatch(
+                {image_points_vec.data(), image_points_vec.size()},
+                {maybe_cam_points.data(), maybe_cam_points.size()});
             std::vector<Eigen::Vector2d> cam_points(image_points.rows());
             for (Eigen::Index i = 0; i < image_points.rows(); ++i) {
-              const std::optional<Eigen::Vector2d> cam_point =
-                  self.CamFromImg(image_points.row(i));
+              const std::optional<Eigen::Vector2d>& cam_point =
+                  maybe_cam_points[i];
               if (cam_point) {
                 cam_points[i] = *cam_point;
               } else {
@@ -187,10 +207,17 @@ void BindCamera(py::module& m) {
           "cam_ray_from_img",
           [](const Camera& self,
              const py::EigenDRef<const Eigen::MatrixX2d>& image_points) {
+            const std::vector<Eigen::Vector2d> image_points_vec =
+                RowsToVector<Eigen::Vector2d>(image_points);
+            std::vector<std::optional<Eigen::Vector3d>> maybe_cam_rays(
+                image_points_vec.size());
+            self.CamRayFromImgBatch(
+                {image_points_vec.data(), image_points_vec.size()},
+                {maybe_cam_rays.data(), maybe_cam_rays.size()});
             std::vector<Eigen::Vector3d> cam_rays(image_points.rows());
             for (Eigen::Index i = 0; i < image_points.rows(); ++i) {
-              const std::optional<Eigen::Vector3d> cam_ray =
-                  self.CamRayFromImg(image_points.row(i));
+              const std::optional<Eigen::Vector3d>& cam_ray =
+                  maybe_cam_rays[i];
               if (cam_ray) {
                 cam_rays[i] = *cam_ray;
               } else {
@@ -235,10 +262,17 @@ void BindCamera(py::module& m) {
           [](const Camera& self,
              const py::EigenDRef<const Eigen::MatrixX3d>& cam_points) {
             const size_t num_points = cam_points.rows();
+            const std::vector<Eigen::Vector3d> cam_points_vec =
+                RowsToVector<Eigen::Vector3d>(cam_points);
+            std::vector<std::optional<Eigen::Vector2d>> maybe_image_points(
+                num_points);
+            self.ImgFromCamBatch(
+                {cam_points_vec.data(), cam_points_vec.size()},
+                {maybe_image_points.data(), maybe_image_points.size()});
             std::vector<Eigen::Vector2d> image_points(num_points);
             for (size_t i = 0; i < num_points; ++i) {
-              const std::optional<Eigen::Vector2d> image_point =
-                  self.ImgFromCam(cam_points.row(i));
+              const std::optional<Eigen::Vector2d>& image_point =
+                  maybe_image_points[i];
               if (image_point) {
                 image_points[i] = *image_point;
               } else {
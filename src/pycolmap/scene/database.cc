@@ -2,8 +2,13 @@
 
 #include "colmap/util/logging.h"
 
+#include "pycolmap/helpers.h"
 #include "pycolmap/pybind11_extension.h"
 
+#include <tuple>
+#include <utility>
+#include <vector>
+
 #include <pybind11/eigen.h>
 #include <pybind11/pybind11.h>
 
@@ -223,6 +228,22 @@ class PyDatabaseImpl : public Database, py::trampoline_self_life_support {
         FeatureDescriptors, Database, ReadDescriptors, image_id);
   }
 
+  std::optional<FeatureExtractionFingerprint> ReadFeatureExtractionFingerprint(
+      image_t image_id) const override {
+    PYBIND11_OVERRIDE_PURE(std::optional<FeatureExtractionFingerprint>,
+                           Database,
+                           ReadFeatureExtractionFingerprint,
+                           image_id);
+  }
+
+  std::optional<GlobalImageDescriptor> ReadGlobalImageDescriptor(
+      image_t image_id) const override {
+    PYBIND11_OVERRIDE_PURE(std::optional<GlobalImageDescriptor>,
+                           Database,
+                           ReadGlobalImageDescriptor,
+                           image_id);
+  }
+
   FeatureMatchesBlob ReadMatchesBlob(image_t image_id1,
                                      image_t image_id2) const override {
     PYBIND11_OVERRIDE_PURE(
@@ -308,6 +329,22 @@ class PyDatabaseImpl : public Database, py::trampoline_self_life_support {
         void, Database, WriteDescriptors, image_id, descriptors);
   }
 
+  void WriteFeatureExtractionFingerprint(
+      image_t image_id,
+      const FeatureExtractionFingerprint& fingerprint) override {
+    PYBIND11_OVERRIDE_PURE(void,
+                           Database,
+                           WriteFeatureExtractionFingerprint,
+                           image_id,
+                           fingerprint);
+  }
+
+  void WriteGlobalImageDescriptor(
+      image_t image_id, const GlobalImageDescriptor& descriptor) override {
+    PYBIND11_OVERRIDE_PURE(
+        void, Database, WriteGlobalImageDescriptor, image_id, descriptor);
+  }
+
   void WriteMatches(image_t image_id1,
                     image_t image_id2,
                     const FeatureMatches& matches) override {
@@ -364,6 +401,12 @@ class PyDatabaseImpl : public Database, py::trampoline_self_life_support {
     PYBIND11_OVERRIDE_PURE(void, Database, UpdateKeypoints, image_id, blob);
   }
 
+  void UpdateDescriptors(image_t image_id,
+                         const FeatureDescriptors& descriptors) override {
+    PYBIND11_OVERRIDE_PURE(
+        void, Database, UpdateDescriptors, image_id, descriptors);
+  }
+
   void UpdateTwoViewGeometry(
       image_t image_id1,
       image_t image_id2,
@@ -439,9 +482,129 @@ class PyDatabaseImpl : public Database, py::trampoline_self_life_support {
   }
 };
 
+using BatchOffsets = Eigen::Matrix<int64_t, Eigen::Dynamic, 1>;
+
+// Concatenate the rows of the given matrices into one contiguous matrix,
+// where the rows of matrices[i] are in the range [offsets[i], offsets[i + 1]).
+template <typename Matrix>
+std::pair<Matrix, BatchOffsets> ConcatenateRows(
+    const std::vector<Matrix>& matrices, const Eigen::Index num_cols) {
+  BatchOffsets offsets(matrices.size() + 1);
+  offsets(0) = 0;
+  for (size_t i = 0; i < matrices.size(); ++i) {
+    offsets(i + 1) = offsets(i) + matrices[i].rows();
+  }
+  Matrix concat(offsets(matrices.size()), num_cols);
+  for (size_t i = 0; i < matrices.size(); ++i) {
+    if (matrices[i].rows() > 0) {
+      concat.middleRows(offsets(i), matrices[i].rows()) = matrices[i];
+    }
+  }
+  return {std::move(concat), std::move(offsets)};
+}
+
+std::pair<FeatureKeypointsBlob, BatchOffsets> ReadKeypointsBatch(
+    const Database& database, const std::vector<image_t>& image_ids) {
+  std::vector<FeatureKeypointsBlob> blobs;
+  blobs.reserve(image_ids.size());
+  Eigen::Index num_cols = 0;
+  bool mixed_num_cols = false;
+  for (const image_t image_id : image_ids) {
+    FeatureKeypointsBlob& blob =
+        blobs.emplace_back(database.ReadKeypointsBlob(image_id));
+    if (blob.rows() == 0) {
+      continue;
+    } else if (num_cols == 0) {
+      num_cols = blob.cols();
+    } else if (blob.cols() != num_cols) {
+      mixed_num_cols = true;
+    }
+  }
+
+  // Keypoints stored in different formats are converted to the full affine
+  // shape, which is also used for an empty batch.
+  constexpr Eigen::Index kNumAffineCols = 6;
+  if (mixed_num_cols) {
+    for (FeatureKeypointsBlob& blob : blobs) {
+      if (blob.rows() > 0 && blob.cols() != kNumAffineCols) {
+        blob = FeatureKeypointsToBlob(FeatureKeypointsFromBlob(blob));
+      }
+    }
+  }
+  if (mixed_num_cols || num_cols == 0) {
+    num_cols = kNumAffineCols;
+  }
+
+  return ConcatenateRows(blobs, num_cols);
+}
+
+std::pair<FeatureDescriptors, BatchOffsets> ReadDescriptorsBatch(
+    const Database& database, const std::vector<image_t>& image_ids) {
+  FeatureDescriptors batch;
+  std::vector<FeatureDescriptorsData> data;
+  data.reserve(image_ids.size());
+  bool is_first = true;
+  for (const image_t image_id : image_ids) {
+    FeatureDescriptors descriptors = database.ReadDescriptors(image_id);
+    if (descriptors.data.rows() > 0) {
+      if (is_first) {
+        batch.type = descriptors.type;
+        batch.precision = descriptors.precision;
+        batch.data.resize(0, descriptors.data.cols());
+        is_first = false;
+      } else {
+        THROW_CHECK_EQ(descriptors.type, batch.type)
+            << "Descriptors of image " << image_id
+            << " have a different type";
+        THROW_CHECK_EQ(descriptors.precision, batch.precision)
+            << "Descriptors of image " << image_id
+            << " have a different precision";
+        THROW_CHECK_EQ(descriptors.data.cols(), batch.data.cols())
+            << "Descriptors of image " << image_id
+            << " have a different dimensionality";
+      }
+    }
+    data.push_back(std::move(descriptors.data));
+  }
+
+  BatchOffsets offsets;
+  std::tie(batch.data, offsets) = ConcatenateRows(data, batch.data.cols());
+  return {std::move(batch), std::move(offsets)};
+}
+
+std::pair<FeatureMatchesBlob, BatchOffsets> ReadMatchesBatch(
+    const Database& database,
+    const std::vector<std::pair<image_t, image_t>>& image_pairs) {
+  std::vector<FeatureMatchesBlob> blobs;
+  blobs.reserve(image_pairs.size());
+  for (const auto& [image_id1, image_id2] : image_pairs) {
+    blobs.push_back(database.ReadMatchesBlob(image_id1, image_id2));
+  }
+  return ConcatenateRows(blobs, 2);
+}
+
 }  // namespace
 
 void BindDatabase(py::module& m) {
+  auto PyFeatureExtractionFingerprint =
+      py::classh<FeatureExtractionFingerprint>(m,
+                                               "FeatureExtractionFingerprint")
+          .def(py::init<>())
+          .def_readwrite("file_hash", &FeatureExtractionFingerprint::file_hash)
+          .def_readwrite("file_size", &FeatureExtractionFingerprint::file_size)
+          .def_readwrite("file_mtime",
+                         &FeatureExtractionFingerprint::file_mtime)
+          .def_readwrite("options_hash",
+                         &FeatureExtractionFingerprint::options_hash);
+  MakeDataclass(PyFeatureExtractionFingerprint);
+
+  auto PyGlobalImageDescriptor =
+      py::classh<GlobalImageDescriptor>(m, "GlobalImageDescriptor")
+          .def(py::init<>())
+          .def_readwrite("model_hash", &GlobalImageDescriptor::model_hash)
+          .def_readwrite("data", &GlobalImageDescriptor::data);
+  MakeDataclass(PyGlobalImageDescriptor);
+
   py::classh<Database, PyDatabaseImpl> PyDatabase(m, "Database");
   PyDatabase.def_static("open", &Database::Open, "path"_a)
       .def("close", &Database::Close)
@@ -499,11 +662,40 @@ void BindDatabase(py::module& m) {
            "is_deprecated_image_prior"_a = true)
       .def("read_all_pose_priors", &Database::ReadAllPosePriors)
       .def("read_keypoints", &Database::ReadKeypointsBlob, "image_id"_a)
-      .def("read_descriptors", &Database::ReadDescriptors, "image_id"_a)
+      .def("read_descriptors",
+           py::overload_cast<image_t>(&Database::ReadDescriptors, py::const_),
+           "image_id"_a)
+      .def("read_keypoints_batch",
+           &ReadKeypointsBatch,
+           "image_ids"_a,
+           "Read the keypoints of multiple images into one contiguous array. "
+           "Returns the concatenated keypoints and the offsets, where the "
+           "keypoints of image_ids[i] are in the rows "
+           "[offsets[i], offsets[i + 1]).")
+      .def("read_descriptors_batch",
+           &ReadDescriptorsBatch,
+           "image_ids"_a,
+           "Read the descriptors of multiple images into one contiguous "
+           "array. Returns the concatenated descriptors and the offsets, where "
+           "the descriptors of image_ids[i] are in the rows "
+           "[offsets[i], offsets[i + 1]).")
+      .def("read_feature_extraction_fingerprint",
+           &Database::ReadFeatureExtractionFingerprint,
+           "image_id"_a)
+      .def("read_global_image_descriptor",
+           &Database::ReadGlobalImageDescriptor,
+           "image_id"_a)
       .def("read_matches",
            &Database::ReadMatchesBlob,
            "image_id1"_a,
            "image_id2"_a)
+      .def("read_matches_batch",
+           &ReadMatchesBatch,
+           "image_pairs"_a,
+           "Read the matches of multiple image pairs into one contiguous "
+           "array. Returns the concatenated matches and the offsets, where the "
+           "matches of image_pairs[i] are in the rows "
+           "[offsets[i], offsets[i + 1]).")
       .def("read_all_matches",
            [](const Database& self) {
              std::vector<std::pair<image_pair_t, FeatureMatchesBlob>>
@@ -582,6 +774,18 @@ void BindDatabase(py::module& m) {
            &Database::WriteFrame,
            "frame"_a,
            "use_frame_id"_a = false)
+      .def(
+          "write_frames",
+          [](Database& self,
+             const std::vector<Frame>& frames,
+             const bool use_frame_ids) {
+            return self.WriteFrames({frames.data(), frames.size()},
+                                    use_frame_ids);
+          },
+          "frames"_a,
+          "use_frame_ids"_a = false,
+          "Write multiple frames and return their identifiers in the same "
+          "order.")
       .def("write_image",
            &Database::WriteImage,
            "image"_a,
@@ -590,6 +794,18 @@ void BindDatabase(py::module& m) {
            &Database::WritePosePrior,
            "pose_prior"_a,
            "use_pose_prior_id"_a = false)
+      .def(
+          "write_pose_priors",
+          [](Database& self,
+             const std::vector<PosePrior>& pose_priors,
+             const bool use_pose_prior_ids) {
+            return self.WritePosePriors(
+                {pose_priors.data(), pose_priors.size()}, use_pose_prior_ids);
+          },
+          "pose_priors"_a,
+          "use_pose_prior_ids"_a = false,
+          "Write multiple pose priors and return their identifiers in the "
+          "same order.")
       .def("write_keypoints",
            py::overload_cast<image_t, const FeatureKeypointsBlob&>(
                &Database::WriteKeypoints),
@@ -599,6 +815,14 @@ void BindDatabase(py::module& m) {
            &Database::WriteDescriptors,
            "image_id"_a,
            "descriptors"_a)
+      .def("write_feature_extraction_fingerprint",
+           &Database::WriteFeatureExtractionFingerprint,
+           "image_id"_a,
+           "fingerprint"_a)
+      .def("write_global_image_descriptor",
+           &Database::WriteGlobalImageDescriptor,
+           "image_id"_a,
+           "descriptor"_a)
       .def("write_matches",
            py::overload_cast<image_t, image_t, const FeatureMatchesBlob&>(
                &Database::WriteMatches),
@@ -620,6 +844,10 @@ void BindDatabase(py::module& m) {
                &Database::UpdateKeypoints),
            "image_id"_a,
            "keypoints"_a)
+      .def("update_descriptors",
+           &Database::UpdateDescriptors,
+           "image_id"_a,
+           "descriptors"_a)
       .def("update_two_view_geometry",
            &Database::UpdateTwoViewGeometry,
            "image_id1"_a,
@@ -647,11 +875,22 @@ void BindDatabase(py::module& m) {
       .def("clear_keypoints", &Database::ClearKeypoints)
       .def("clear_matches", &Database::ClearMatches)
       .def("clear_two_view_geometries", &Database::ClearTwoViewGeometries)
-      .def_static("merge",
-                  &Database::Merge,
-                  "database1"_a,
-                  "database2"_a,
-                  "merged_database"_a);
+      .def("set_blob_compression", &Database::SetBlobCompression, "enabled"_a)
+      .def_static(
+          "merge",
+          py::overload_cast<const Database&, const Database&, Database*>(
+              &Database::Merge),
+          "database1"_a,
+          "database2"_a,
+          "merged_database"_a)
+      .def_static(
+          "merge",
+          py::overload_cast<const std::vector<const Database*>&, Database*>(
+              &Database::Merge),
+          "databases"_a,
+          "merged_database"_a,
+          "Merge multiple databases in one pass into the merged database, "
+          "which may already contain entries.");
 
   py::classh<PyDatabaseTransaction>(m, "DatabaseTransaction")
       .def(py::init<Database*>(), "database"_a)
@@ -34,18 +34,51 @@ void BindDatabaseCache(py::module& m) {
       .def_readwrite(
           "convert_pose_priors_to_enu",
           &Opts::convert_pose_priors_to_enu,
-          "Whether to convert pose priors to ENU coordinate system.");
+          "Whether to convert pose priors to ENU coordinate system.")
+      .def_readwrite(
+          "stream_two_view_geometries",
+          &Opts::stream_two_view_geometries,
+          "Whether to stream the two-view geometries from the database in "
+          "batches directly into the correspondence graph to bound the peak "
+          "memory usage. Image pairs without inlier matches are not loaded.")
+      .def_readwrite(
+          "correspondence_graph_snapshot_path",
+          &Opts::correspondence_graph_snapshot_path,
+          "Optional path to a snapshot of the correspondence graph. It is "
+          "loaded instead of rebuilding the graph, if it was built from the "
+          "same database contents with the same options, and written "
+          "otherwise.")
+      .def_readwrite(
+          "lazy_load_points2D",
+          &Opts::lazy_load_points2D,
+          "Whether to load the points2D of images on demand from the "
+          "database instead of keeping them in the cached images.");
 
   MakeDataclass(PyOpts);
 
   py::classh<DatabaseCache> PyDatabaseCache(m, "DatabaseCache");
   PyDatabaseCache.def(py::init<>())
-      .def_static("create", &DatabaseCache::Create, "database"_a, "options"_a)
+      .def_static(
+          "create",
+          [](std::shared_ptr<Database> database,
+             const DatabaseCache::Options& options) {
+            return DatabaseCache::Create(std::move(database), options);
+          },
+          "database"_a,
+          "options"_a)
       .def_static("create_from_cache",
                   &DatabaseCache::CreateFromCache,
                   "database_cache"_a,
                   "options"_a)
-      .def("load", &DatabaseCache::Load, "database"_a, "options"_a)
+      .def(
+          "load",
+          [](DatabaseCache& self,
+             std::shared_ptr<Database> database,
+             const DatabaseCache::Options& options) {
+            self.Load(std::move(database), options);
+          },
+          "database"_a,
+          "options"_a)
       .def("add_rig", &DatabaseCache::AddRig)
       .def("add_camera", &DatabaseCache::AddCamera)
       .def("add_frame", &DatabaseCache::AddFrame)
@@ -93,5 +126,8 @@ void BindDatabaseCache(py::module& m) {
           "correspondence_graph",
           static_cast<std::shared_ptr<const class CorrespondenceGraph> (
               DatabaseCache::*)() const>(&DatabaseCache::CorrespondenceGraph))
-      .def("find_image_with_name", &DatabaseCache::FindImageWithName, "name"_a);
+      .def("find_image_with_name", &DatabaseCache::FindImageWithName, "name"_a)
+      .def("has_lazy_points2D", &DatabaseCache::HasLazyPoints2D)
+      .def("num_points2D", &DatabaseCache::NumPoints2D, "image_id"_a)
+      .def("load_points2D", &DatabaseCache::LoadPoints2D, "image_id"_a);
 }
@@ -57,6 +57,24 @@ def test_database_clear_cameras(database, simple_camera):
     assert database.num_cameras() == 0
 
 
+def test_database_write_pose_priors(database):
+    pose_priors = []
+    for i in range(3):
+        pose_prior = pycolmap.PosePrior()
+        pose_prior.corr_data_id = pycolmap.data_t(
+            pycolmap.sensor_t(pycolmap.SensorType.CAMERA, 1), i + 1
+        )
+        pose_prior.position = np.array([i, 2.0 * i, 3.0 * i])
+        pose_priors.append(pose_prior)
+    pose_prior_ids = database.write_pose_priors(pose_priors)
+    assert len(pose_prior_ids) == 3
+    assert database.num_pose_priors() == 3
+    read_pose_priors = database.read_all_pose_priors()
+    assert sorted(p.pose_prior_id for p in read_pose_priors) == sorted(
+        pose_prior_ids
+    )
+
+
 def test_database_write_and_read_keypoints(populated_database):
     database, camera_id, image_id = populated_database
     keypoints = np.array(
@@ -91,6 +109,50 @@ def test_database_write_and_read_matches(populated_database):
     assert read_matches.shape[0] == 2
 
 
+def test_database_read_features_batch(populated_database):
+    database, camera_id, image_id1 = populated_database
+    image2 = pycolmap.Image()
+    image2.name = "test2.jpg"
+    image2.camera_id = camera_id
+    image_id2 = database.write_image(image2)
+    keypoints1 = np.array(
+        [[10.0, 20.0, 1.0, 0.0, 0.0, 1.0], [30.0, 40.0, 1.0, 0.0, 0.0, 1.0]],
+        dtype=np.float32,
+    )
+    keypoints2 = np.array([[50.0, 60.0, 2.0, 0.0, 0.0, 2.0]], dtype=np.float32)
+    database.write_keypoints(image_id1, keypoints1)
+    database.write_keypoints(image_id2, keypoints2)
+    keypoints, offsets = database.read_keypoints_batch([image_id2, image_id1])
+    np.testing.assert_array_equal(offsets, [0, 1, 3])
+    np.testing.assert_array_equal(keypoints[0:1], keypoints2)
+    np.testing.assert_array_equal(keypoints[1:3], keypoints1)
+
+    for image_id, num_descriptors in [(image_id1, 2), (image_id2, 1)]:
+        database.write_descriptors(
+            image_id,
+            pycolmap.FeatureDescriptors(
+                type=pycolmap.FeatureExtractorType.SIFT,
+                data=np.full((num_descriptors, 3), image_id, dtype=np.uint8),
+            ),
+        )
+    descriptors, offsets = database.read_descriptors_batch(
+        [image_id1, image_id2]
+    )
+    assert descriptors.type == pycolmap.FeatureExtractorType.SIFT
+    assert descriptors.data.shape == (3, 3)
+    np.testing.assert_array_equal(offsets, [0, 2, 3])
+    np.testing.assert_array_equal(descriptors.data[2], [image_id2] * 3)
+
+    matches = np.array([[0, 0], [1, 1]], dtype=np.uint32)
+    database.write_matches(image_id1, image_id2, matches)
+    all_matches, offsets = database.read_matches_batch(
+        [(image_id1, image_id2), (image_id2, image_id1)]
+    )
+    np.testing.assert_array_equal(offsets, [0, 2, 4])
+    np.testing.assert_array_equal(all_matches[0:2], matches)
+    np.testing.assert_array_equal(all_matches[2:4], matches[:, ::-1])
+
+
 def test_database_write_and_read_two_view_geometry(populated_database):
     database, camera_id, image_id = populated_database
     image2 = pycolmap.Image()
@@ -102,4 +102,5 @@ void BindFrame(py::module& m) {
   MakeDataclass(PyFrame);
 
   py::bind_map<FrameMap>(m, "FrameMap");
+  py::bind_map<DenseFrameMap>(m, "DenseFrameMap");
 }
@@ -113,3 +113,12 @@ def test_frame_map_insert_and_access():
     frame_map[1] = frame
     assert len(frame_map) == 1
     assert frame_map[1].frame_id == 1
+
+
+def test_dense_frame_map_insert_and_access():
+    frame_map = pycolmap.DenseFrameMap()
+    frame = pycolmap.Frame()
+    frame.frame_id = 1
+    frame_map[1] = frame
+    assert len(frame_map) == 1
+    assert frame_map[1].frame_id == 1
@@ -193,4 +193,5 @@ void BindSceneImage(py::module& m) {
   MakeDataclass(PyImage);
 
   py::bind_map<ImageMap>(m, "ImageMap");
+  py::bind_map<DenseImageMap>(m, "DenseImageMap");
 }
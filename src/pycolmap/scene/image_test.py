@@ -93,3 +93,13 @@ def test_image_map_insert_and_access():
     image_map[1] = image
     assert len(image_map) == 1
     assert image_map[1].name == "test.jpg"
+
+
+def test_dense_image_map_insert_and_access():
+    image_map = pycolmap.DenseImageMap()
+    image = pycolmap.Image()
+    image.image_id = 1
+    image.name = "test.jpg"
+    image_map[1] = image
+    assert len(image_map) == 1
+    assert image_map[1].name == "test.jpg"
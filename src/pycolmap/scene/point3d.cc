@@ -1,4 +1,5 @@
 #include "colmap/scene/point3d.h"
+#include "colmap/scene/point3d_octree.h"
 
 #include "colmap/util/logging.h"
 #include "colmap/util/misc.h"
@@ -8,6 +9,7 @@
 #include "pycolmap/pybind11_extension.h"
 #include "pycolmap/scene/types.h"
 
+#include <limits>
 #include <memory>
 #include <sstream>
 
@@ -16,6 +18,7 @@
 #include <pybind11/stl.h>
 
 using namespace colmap;
+using namespace pybind11::literals;
 namespace py = pybind11;
 
 void BindPoint3D(py::module& m) {
@@ -30,4 +33,34 @@ void BindPoint3D(py::module& m) {
   MakeDataclass(PyPoint3D);
 
   py::bind_map<Point3DMap>(m, "Point3DMap");
+
+  py::classh<Point3DOctree>(m, "Point3DOctree")
+      .def(py::init<int, int>(), "max_leaf_size"_a = 32, "max_depth"_a = 24)
+      .def("size", &Point3DOctree::Size)
+      .def("exists", &Point3DOctree::Exists, "point3D_id"_a)
+      .def("insert", &Point3DOctree::Insert, "point3D_id"_a, "xyz"_a)
+      .def("remove", &Point3DOctree::Remove, "point3D_id"_a)
+      .def("update", &Point3DOctree::Update, "point3D_id"_a, "xyz"_a)
+      .def("clear", &Point3DOctree::Clear)
+      .def("query_box",
+           &Point3DOctree::QueryBox,
+           "bbox"_a,
+           "Find the points inside the closed box.")
+      .def("query_half_spaces",
+           &Point3DOctree::QueryHalfSpaces,
+           "planes"_a,
+           "Find the points in the intersection of the half-spaces, where "
+           "each plane (n, d) defines the half-space n^T * x + d >= 0.")
+      .def("query_camera_frustum",
+           &Point3DOctree::QueryCameraFrustum,
+           "camera"_a,
+           "cam_from_world"_a,
+           "max_depth"_a = std::numeric_limits<double>::max(),
+           "Find the points in front of the camera that project into its "
+           "image.")
+      .def("query_nearest",
+           &Point3DOctree::QueryNearest,
+           "xyz"_a,
+           "k"_a,
+           "Find the k nearest points sorted by increasing distance.");
 }
@@ -49,6 +49,11 @@ void BindReconstruction(py::module& m) {
       .def("read_binary", &Reconstruction::ReadBinary, "path"_a)
       .def("write_text", &Reconstruction::WriteText, "path"_a)
       .def("write_binary", &Reconstruction::WriteBinary, "path"_a)
+      .def("write_mapped_binary",
+           &Reconstruction::WriteMappedBinary,
+           "path"_a,
+           "Write reconstruction in COLMAP binary format with the 3D points "
+           "in the memory-mappable points3D.mbin format.")
       .def("num_rigs", &Reconstruction::NumRigs)
       .def("num_cameras", &Reconstruction::NumCameras)
       .def("num_frames", &Reconstruction::NumFrames)
@@ -230,6 +235,16 @@ void BindReconstruction(py::module& m) {
            "max_percentile"_a = 1.0,
            "use_images"_a = false)
       .def("crop", &Reconstruction::Crop, "bbox"_a)
+      .def("build_points3D_index",
+           &Reconstruction::BuildPoints3DIndex,
+           "Build a spatial index over the 3D points, which is kept up to "
+           "date when adding, deleting, or transforming 3D points.")
+      .def("clear_points3D_index", &Reconstruction::ClearPoints3DIndex)
+      .def_property_readonly(
+          "points3D_index",
+          &Reconstruction::Points3DIndex,
+          py::return_value_policy::reference_internal,
+          "The spatial index of the 3D points or None, if it was not built.")
       .def("find_image_with_name",
            &Reconstruction::FindImageWithName,
            py::return_value_policy::reference_internal,
@@ -259,6 +259,19 @@ def test_reconstruction_crop(synthetic_reconstruction):
     assert reconstruction_copy is not None
 
 
+def test_reconstruction_points3d_index(synthetic_reconstruction):
+    reconstruction_copy = pycolmap.Reconstruction(synthetic_reconstruction)
+    assert reconstruction_copy.points3D_index is None
+    reconstruction_copy.build_points3D_index()
+    index = reconstruction_copy.points3D_index
+    assert index.size() == reconstruction_copy.num_points3D()
+    bbox = reconstruction_copy.compute_bounding_box()
+    assert len(index.query_box(bbox)) == reconstruction_copy.num_points3D()
+    assert len(index.query_nearest(bbox.min, 3)) == 3
+    reconstruction_copy.clear_points3D_index()
+    assert reconstruction_copy.points3D_index is None
+
+
 def test_reconstruction_delete_all_points2d_and_points3d(
     synthetic_reconstruction,
 ):
@@ -7,6 +7,7 @@
 #include "pycolmap/helpers.h"
 
 #include <memory>
+#include <vector>
 
 #include <pybind11/eigen.h>
 #include <pybind11/pybind11.h>
@@ -33,9 +34,13 @@ void BindTrack(py::module& m) {
              return track;
            }),
            "elements"_a)
-      .def_property("elements",
-                    py::overload_cast<>(&Track::Elements),
-                    &Track::SetElements)
+      .def_property(
+          "elements",
+          [](const Track& self) {
+            return std::vector<TrackElement>(self.Elements().begin(),
+                                             self.Elements().end());
+          },
+          &Track::SetElements)
       .def("length", &Track::Length, "Track Length.")
       .def("add_element",
            py::overload_cast<image_t, point2D_t>(&Track::AddElement),
@@ -46,7 +51,8 @@ void BindTrack(py::module& m) {
            py::overload_cast<const TrackElement&>(&Track::AddElement),
            "element"_a)
       .def("add_elements",
-           &Track::AddElements,
+           py::overload_cast<const std::vector<TrackElement>&>(
+               &Track::AddElements),
            "elements"_a,
            "Add multiple elements.")
       .def("delete_element",
@@ -6,6 +6,7 @@
 #include "colmap/scene/point2d.h"
 #include "colmap/scene/point3d.h"
 #include "colmap/scene/pose_graph.h"
+#include "colmap/util/dense_id_map.h"
 #include "colmap/util/types.h"
 
 #include <pybind11/eigen.h>
@@ -22,13 +23,19 @@ PYBIND11_MAKE_OPAQUE(CameraMap);
 using FrameMap = std::unordered_map<colmap::frame_t, colmap::Frame>;
 PYBIND11_MAKE_OPAQUE(FrameMap);
 
+using DenseFrameMap = colmap::DenseIdMap<colmap::frame_t, colmap::Frame>;
+PYBIND11_MAKE_OPAQUE(DenseFrameMap);
+
 using ImageMap = std::unordered_map<colmap::image_t, colmap::Image>;
 PYBIND11_MAKE_OPAQUE(ImageMap);
 
+using DenseImageMap = colmap::DenseIdMap<colmap::image_t, colmap::Image>;
+PYBIND11_MAKE_OPAQUE(DenseImageMap);
+
 using Point2DVector = std::vector<struct colmap::Point2D>;
 PYBIND11_MAKE_OPAQUE(Point2DVector);
 
-using Point3DMap = std::unordered_map<colmap::point3D_t, colmap::Point3D>;
+using Point3DMap = colmap::DenseIdMap<colmap::point3D_t, colmap::Point3D>;
 PYBIND11_MAKE_OPAQUE(Point3DMap);
 
 using PoseGraphEdgeMap =
@@ -120,6 +120,29 @@ void BindBitmap(pybind11::module& m) {
           "Read bitmap at given path and convert to grey- or colorscale. "
           "Defaults to keeping the original colorspace (potentially "
           "non-linear) for image processing.")
+      .def_static(
+          "read_thumbnail",
+          [](const std::filesystem::path& path,
+             int max_image_size,
+             bool as_rgb,
+             bool linearize_colorspace) -> py::typing::Optional<Bitmap> {
+            Bitmap bitmap;
+            if (!bitmap.ReadThumbnail(
+                    path,
+                    max_image_size,
+                    /*as_rgb=*/as_rgb,
+                    /*linearize_colorspace=*/linearize_colorspace)) {
+              return py::none();
+            }
+            return py::cast(bitmap);
+          },
+          "path"_a,
+          "max_image_size"_a,
+          "as_rgb"_a,
+          "linearize_colorspace"_a = false,
+          "Read bitmap at given path downscaled so that neither dimension "
+          "exceeds max_image_size, as with read followed by thumbnail. JPEG "
+          "images are decoded directly at reduced resolution, if supported.")
       .def("rescale",
            &Bitmap::Rescale,
            "new_width"_a,
@@ -163,6 +163,26 @@ def test_bitmap_write_read(tmp_path):
     np.testing.assert_array_equal(loaded.to_array(), array)
 
 
+def test_bitmap_read_thumbnail(tmp_path):
+    array = np.random.randint(0, 256, (48, 64, 3), dtype=np.uint8)
+    bitmap = pycolmap.Bitmap.from_array(array)
+    filepath = str(tmp_path / "test.jpg")
+    bitmap.write(filepath)
+    loaded = pycolmap.Bitmap.read_thumbnail(
+        filepath, max_image_size=16, as_rgb=False
+    )
+    assert loaded is not None
+    assert loaded.width == 16
+    assert loaded.height == 12
+    assert loaded.is_grey
+    assert (
+        pycolmap.Bitmap.read_thumbnail(
+            str(tmp_path / "missing.jpg"), max_image_size=16, as_rgb=True
+        )
+        is None
+    )
+
+
 def test_bitmap_set_jpeg_quality():
     bitmap = pycolmap.Bitmap(width=32, height=24, as_rgb=True)
     bitmap.set_jpeg_quality(85)
@@ -45,6 +45,17 @@ void BindIncrementalPipeline(py::module& m) {
                      "first sub-model is always kept independent of size. If "
                      "the model contains at least half of the total number of "
                      "images, we also always keep it.")
+      .def_readwrite("parallel_components",
+                     &Opts::parallel_components,
+                     "Whether to reconstruct the connected components of the "
+                     "correspondence graph concurrently with separate "
+                     "mappers, if the scene consists of multiple components.")
+      .def_readwrite("parallel_triangulation",
+                     &Opts::parallel_triangulation,
+                     "Whether to triangulate models with known poses by "
+                     "triangulating the candidate tracks of all images "
+                     "concurrently, followed by a single global bundle "
+                     "adjustment. Only used by point triangulation.")
       .def_readwrite("init_image_id1",
                      &Opts::init_image_id1,
                      "The image identifier of the first image used to "
@@ -66,6 +77,22 @@ void BindIncrementalPipeline(py::module& m) {
                      &Opts::structure_less_registration_only,
                      "Only use structure-less and skip structure-based image "
                      "registration.")
+      .def_readwrite("structure_less_registration_first",
+                     &Opts::structure_less_registration_first,
+                     "Whether to try structure-less registration before "
+                     "structure-based registration, e.g., for video sequences "
+                     "with high overlap between consecutive frames.")
+      .def_readwrite("structure_less_batch_size",
+                     &Opts::structure_less_batch_size,
+                     "The number of images registered structure-less in a "
+                     "row, after which they are triangulated and locally "
+                     "refined together.")
+      .def_readwrite("num_speculative_reg_images",
+                     &Opts::num_speculative_reg_images,
+                     "The number of next image candidates whose poses are "
+                     "speculatively estimated in parallel. The successful "
+                     "estimates are registered one after another, as long as "
+                     "they remain consistent with the reconstruction.")
       .def_readwrite("extract_colors",
                      &Opts::extract_colors,
                      "Whether to extract colors for reconstructed points.")
@@ -132,6 +159,29 @@ void BindIncrementalPipeline(py::module& m) {
           "ba_global_points_freq",
           &Opts::ba_global_points_freq,
           "The growth rates after which to perform global bundle adjustment.")
+      .def_readwrite("ba_global_adaptive",
+                     &Opts::ba_global_adaptive,
+                     "Whether to skip the global bundle adjustments triggered "
+                     "by the growth rates as long as the local bundle "
+                     "adjustments indicate no drift of the model.")
+      .def_readwrite("ba_global_adaptive_min_num_frames",
+                     &Opts::ba_global_adaptive_min_num_frames,
+                     "Models with fewer registered frames are always refined "
+                     "globally.")
+      .def_readwrite("ba_global_adaptive_max_frames_ratio",
+                     &Opts::ba_global_adaptive_max_frames_ratio,
+                     "Growth ratio of registered frames since the last global "
+                     "bundle adjustment after which it is always run.")
+      .def_readwrite("ba_global_adaptive_max_error_increase",
+                     &Opts::ba_global_adaptive_max_error_increase,
+                     "Relative increase of the local reprojection error over "
+                     "its reference after the last global bundle adjustment "
+                     "above which the model is considered as drifted.")
+      .def_readwrite("ba_global_adaptive_max_filtered_ratio",
+                     &Opts::ba_global_adaptive_max_filtered_ratio,
+                     "Fraction of filtered observations in local bundle "
+                     "adjustment above which the model is considered as "
+                     "drifted.")
       .def_readwrite(
           "ba_global_function_tolerance",
           &Opts::ba_global_function_tolerance,
@@ -189,6 +239,18 @@ void BindIncrementalPipeline(py::module& m) {
                      &Opts::snapshot_frames_freq,
                      "Frequency of registered images according to which "
                      "reconstruction snapshots will be saved.")
+      .def_readwrite("checkpoint_path",
+                     &Opts::checkpoint_path,
+                     "Path to a folder in which checkpoints of the models and "
+                     "the mapper state are written asynchronously.")
+      .def_readwrite("checkpoint_frames_freq",
+                     &Opts::checkpoint_frames_freq,
+                     "Frequency of registered frames according to which "
+                     "checkpoints will be written.")
+      .def_readwrite("resume_from_checkpoint",
+                     &Opts::resume_from_checkpoint,
+                     "Whether to resume from the latest checkpoint in "
+                     "checkpoint_path without redoing registrations.")
       .def_readwrite(
           "image_path",
           &Opts::image_path,
@@ -203,6 +265,16 @@ void BindIncrementalPipeline(py::module& m) {
           &Opts::load_all_images,
           "Whether to load all images from the database, including those "
           "without correspondences. Only useful for triangulation.")
+      .def_readwrite("correspondence_graph_snapshot_path",
+                     &Opts::correspondence_graph_snapshot_path,
+                     "Optional path to a snapshot of the correspondence graph, "
+                     "which is reused in subsequent runs on the same database "
+                     "instead of rebuilding the graph.")
+      .def_readwrite("lazy_load_points2D",
+                     &Opts::lazy_load_points2D,
+                     "Whether to load the keypoints of images on demand, when "
+                     "they are considered for registration, instead of "
+                     "keeping the keypoints of all images in memory.")
       .def_readwrite("fix_existing_frames",
                      &Opts::fix_existing_frames,
                      "If reconstruction is provided as input, fix the existing "
@@ -388,6 +460,24 @@ void BindIncrementalMapperOptions(py::module& m) {
                      &Opts::ba_local_min_tri_angle,
                      "Minimum triangulation for images to be chosen in local "
                      "bundle adjustment.")
+      .def_readwrite("structure_less_triangulate",
+                     &Opts::structure_less_triangulate,
+                     "Whether to robustly triangulate new points from the "
+                     "inlier 2D-2D correspondences in structure-less "
+                     "registration. Otherwise, only existing tracks are "
+                     "continued.")
+      .def_readwrite("ba_local_reuse_problem",
+                     &Opts::ba_local_reuse_problem,
+                     "Whether to keep the local bundle adjustment problem "
+                     "alive across successive calls and only update the parts "
+                     "of the problem that changed with the local window. Only "
+                     "used with the Ceres backend.")
+      .def_readwrite("ba_global_reuse_problem",
+                     &Opts::ba_global_reuse_problem,
+                     "Whether to keep the global bundle adjustment problem "
+                     "alive across successive calls and only update the parts "
+                     "of the problem that changed. Only used with the Ceres "
+                     "backend and without prior positions.")
       .def_readwrite(
           "ba_global_ignore_redundant_points3D",
           &Opts::ba_global_ignore_redundant_points3D,
@@ -427,6 +517,12 @@ void BindIncrementalMapperOptions(py::module& m) {
       .def_readwrite("max_reg_trials",
                      &Opts::max_reg_trials,
                      "Maximum number of trials to register an image.")
+      .def_readwrite("lazy_points2D_cache_size",
+                     &Opts::lazy_points2D_cache_size,
+                     "Maximum size in gigabytes of the points2D of "
+                     "unregistered images loaded on demand. Beyond this "
+                     "size, the least recently considered ones are released "
+                     "and loaded again when needed. Unlimited if zero.")
       .def_readwrite("fix_existing_frames",
                      &Opts::fix_existing_frames,
                      "If reconstruction is provided as input, fix the existing "
@@ -468,9 +564,21 @@ void BindIncrementalMapperImpl(py::module& m) {
       .def_readwrite("num_filtered_observations",
                      &LocalBAReport::num_filtered_observations)
       .def_readwrite("num_adjusted_observations",
-                     &LocalBAReport::num_adjusted_observations);
+                     &LocalBAReport::num_adjusted_observations)
+      .def_readwrite("mean_reproj_error", &LocalBAReport::mean_reproj_error);
   MakeDataclass(PyLocalBAReport);
 
+  using NextImagePose = IncrementalMapper::NextImagePose;
+  auto PyNextImagePose = py::classh<NextImagePose>(m, "NextImagePose");
+  PyNextImagePose.def(py::init<>())
+      .def_readwrite("image_id", &NextImagePose::image_id)
+      .def_readwrite("success", &NextImagePose::success)
+      .def_readwrite("cam_from_world", &NextImagePose::cam_from_world)
+      .def_readwrite("camera", &NextImagePose::camera)
+      .def_readwrite("prev_camera_params", &NextImagePose::prev_camera_params)
+      .def_readwrite("inlier_corrs", &NextImagePose::inlier_corrs);
+  MakeDataclass(PyNextImagePose);
+
   // bind incremental mapper
   py::classh<IncrementalMapper>(
       m,
@@ -559,12 +667,28 @@ void BindIncrementalMapperImpl(py::module& m) {
            "reconstruction. This function automatically ignores images that "
            "failed to register for max_reg_trials.")
       .def("register_next_image",
-           &IncrementalMapper::RegisterNextImage,
+           py::overload_cast<const IncrementalMapper::Options&, image_t>(
+               &IncrementalMapper::RegisterNextImage),
            "options"_a,
            "image_id"_a,
            "Attempt to register image to the existing model. This requires "
            "that a previous call to register_initial_image_pair was "
            "successful.")
+      .def("estimate_next_image_poses",
+           &IncrementalMapper::EstimateNextImagePoses,
+           "options"_a,
+           "image_ids"_a,
+           "Speculatively estimate the poses of multiple next images "
+           "concurrently without registering them. Only images in frames "
+           "with a single sensor are supported.")
+      .def("register_next_image",
+           py::overload_cast<const IncrementalMapper::Options&,
+                             const IncrementalMapper::NextImagePose&>(
+               &IncrementalMapper::RegisterNextImage),
+           "options"_a,
+           "pose"_a,
+           "Attempt to register image from a speculatively estimated pose, "
+           "if it is still consistent with the reconstruction.")
       .def("register_next_structure_less_image",
            &IncrementalMapper::RegisterNextStructureLessImage,
            "options"_a,
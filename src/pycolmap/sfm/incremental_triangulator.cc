@@ -74,6 +74,10 @@ void BindIncrementalTriangulator(py::module& m) {
           "random_seed",
           &Opts::random_seed,
           "PRNG seed for all stochastic methods during triangulation.")
+      .def_readwrite("num_threads",
+                     &Opts::num_threads,
+                     "Number of threads to find candidates for track "
+                     "completion and merging.")
       .def("check", &Opts::Check);
   MakeDataclass(PyOpts);
 
@@ -160,6 +160,11 @@ void BindObservationManager(py::module& m) {
            "select the next best image in incremental reconstruction, because a"
            "more uniform distribution of observations results in more robust "
            "registration.")
+      .def_property_readonly(
+          "unregistered_visible_image_ids",
+          &ObservationManager::UnregisteredVisibleImageIds,
+          "Unregistered images that have at least one correspondence to a "
+          "triangulated point, i.e., the next image registration candidates.")
       .def("increment_correspondence_has_point3D",
            &ObservationManager::IncrementCorrespondenceHasPoint3D,
            "image_id"_a,
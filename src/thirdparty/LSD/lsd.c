@@ -1024,11 +1024,6 @@ static double log_gamma_windschitl(double x)
  */
 #define log_gamma(x) ((x)>15.0?log_gamma_windschitl(x):log_gamma_lanczos(x))
 
-/*----------------------------------------------------------------------------*/
-/** Size of the table to store already computed inverse values.
- */
-#define TABSIZE 100000
-
 /*----------------------------------------------------------------------------*/
 /** Computes -log10(NFA).
 
@@ -1073,7 +1068,6 @@ static double log_gamma_windschitl(double x)
  */
 static double nfa(int n, int k, double p, double logNT)
 {
-  static double inv[TABSIZE];   /* table to keep computed inverse values */
   double tolerance = 0.1;       /* an error of 10% in the result is accepted */
   double log1term,term,bin_term,mult_term,bin_tail,err,p_term;
   int i;
@@ -1124,13 +1118,11 @@ static double nfa(int n, int k, double p, double logNT)
            term_i / term_i-1 = (n-i+1)/i * p/(1-p)
          and
            term_i = term_i-1 * (n-i+1)/i * p/(1-p).
-         1/i is stored in a table as they are computed,
-         because divisions are expensive.
+         1/i is not cached in a static table, such that lsd() can be
+         called concurrently from multiple threads.
          p/(1-p) is computed only once and stored in 'p_term'.
        */
-      bin_term = (double) (n-i+1) * ( i<TABSIZE ?
-                   ( inv[i]!=0.0 ? inv[i] : ( inv[i] = 1.0 / (double) i ) ) :
-                   1.0 / (double) i );
+      bin_term = (double) (n-i+1) * ( 1.0 / (double) i );
 
       mult_term = bin_term * p_term;
       term *= mult_term;
@@ -1082,6 +1082,34 @@ vl_get_simd_enabled (void)
   return vl_get_state()->simdEnabled ;
 }
 
+/** @brief Check for AVX-512F instruction set
+ ** @return @c true if AVX-512F is present and enabled by the OS.
+ **/
+
+vl_bool
+vl_cpu_has_avx512f (void)
+{
+#if defined(VL_ARCH_IX86) || defined(VL_ARCH_X64) || defined(VL_ARCH_IA64)
+  return vl_get_state()->cpuInfo.hasAVX512F ;
+#else
+  return VL_FALSE ;
+#endif
+}
+
+/** @brief Check for AVX2 instruction set
+ ** @return @c true if AVX2 is present and enabled by the OS.
+ **/
+
+vl_bool
+vl_cpu_has_avx2 (void)
+{
+#if defined(VL_ARCH_IX86) || defined(VL_ARCH_X64) || defined(VL_ARCH_IA64)
+  return vl_get_state()->cpuInfo.hasAVX2 ;
+#else
+  return VL_FALSE ;
+#endif
+}
+
 /** @brief Check for AVX instruction set
  ** @return @c true if AVX is present.
  **/
@@ -405,11 +405,24 @@ it supports POSIX threads.
 
 #if defined(HAS_CPUID) & defined(VL_COMPILER_MSC)
 #include <intrin.h>
+#include <immintrin.h>
 VL_INLINE void
 _vl_cpuid (vl_int32* info, int function)
 {
   __cpuid(info, function) ;
 }
+
+VL_INLINE void
+_vl_cpuidex (vl_int32* info, int function, int subfunction)
+{
+  __cpuidex(info, function, subfunction) ;
+}
+
+VL_INLINE vl_uint64
+_vl_xgetbv (void)
+{
+  return _xgetbv(0) ;
+}
 #endif
 
 #if defined(HAS_CPUID) & defined(VL_COMPILER_GNUC)
@@ -439,6 +452,39 @@ _vl_cpuid (vl_int32* info, int function)
 #endif
 }
 
+VL_INLINE void
+_vl_cpuidex (vl_int32* info, int function, int subfunction)
+{
+#if defined(VL_ARCH_IX86) && (defined(__PIC__) || defined(__pic__))
+  __asm__ __volatile__
+  ("pushl %%ebx      \n"
+   "cpuid            \n"
+   "movl %%ebx, %1   \n"
+   "popl %%ebx       \n"
+   : "=a"(info[0]), "=r"(info[1]), "=c"(info[2]), "=d"(info[3])
+   : "a"(function), "c"(subfunction)
+   : "cc") ;
+#else
+  __asm__ __volatile__
+  ("cpuid"
+   : "=a"(info[0]), "=b"(info[1]), "=c"(info[2]), "=d"(info[3])
+   : "a"(function), "c"(subfunction)
+   : "cc") ;
+#endif
+}
+
+VL_INLINE vl_uint64
+_vl_xgetbv (void)
+{
+  vl_uint32 eax, edx ;
+  /* xgetbv, encoded as bytes for old assemblers */
+  __asm__ __volatile__
+  (".byte 0x0f, 0x01, 0xd0"
+   : "=a"(eax), "=d"(edx)
+   : "c"(0)) ;
+  return ((vl_uint64) edx << 32) | eax ;
+}
+
 #endif
 
 #if defined(HAS_CPUID)
@@ -463,6 +509,13 @@ _vl_x86cpu_info_init (VlX86CpuInfo *self)
     self->hasSSE41 = info[2] & (1 << 19) ;
     self->hasSSE42 = info[2] & (1 << 20) ;
     self->hasAVX   = info[2] & (1 << 28) ;
+    /* AVX2 and AVX-512 registers must also be enabled by the OS. */
+    if ((info[2] & (1 << 27)) && max_func >= 7) {
+      vl_uint64 const xcr0 = _vl_xgetbv() ;
+      _vl_cpuidex(info, 7, 0) ;
+      self->hasAVX2    = (xcr0 & 0x06) == 0x06 && (info[1] & (1 << 5)) ;
+      self->hasAVX512F = (xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16)) ;
+    }
   }
 }
 
@@ -478,7 +531,7 @@ _vl_x86cpu_info_to_string_copy (VlX86CpuInfo const *self)
       string = vl_malloc(sizeof(char) * length) ;
       if (string == NULL) break ;
     }
-    length = snprintf(string, length, "%s%s%s%s%s%s%s%s",
+    length = snprintf(string, length, "%s%s%s%s%s%s%s%s%s%s",
                       self->vendor.string,
                       self->hasMMX   ? " MMX" : "",
                       self->hasSSE   ? " SSE" : "",
@@ -486,7 +539,9 @@ _vl_x86cpu_info_to_string_copy (VlX86CpuInfo const *self)
                       self->hasSSE3  ? " SSE3" : "",
                       self->hasSSE41 ? " SSE41" : "",
                       self->hasSSE42 ? " SSE42" : "",
-                      self->hasAVX   ? " AVX" : "") ;
+                      self->hasAVX   ? " AVX" : "",
+                      self->hasAVX2  ? " AVX2" : "",
+                      self->hasAVX512F ? " AVX512F" : "") ;
     length += 1 ;
   }
   return string ;
@@ -562,6 +562,8 @@ typedef struct _VlX86CpuInfo
     char string [0x20] ;
     vl_uint32 words [0x20 / 4] ;
   } vendor ;
+  vl_bool hasAVX512F ;
+  vl_bool hasAVX2 ;
   vl_bool hasAVX ;
   vl_bool hasSSE42 ;
   vl_bool hasSSE41 ;
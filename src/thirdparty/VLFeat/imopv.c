@@ -35,6 +35,7 @@ the terms of the BSD license (see the COPYING file).
 #ifndef VL_IMOPV_INSTANTIATING
 
 #include "imopv.h"
+#include "imopv_simd.h"
 #include "imopv_sse2.h"
 #include "mathop.h"
 
@@ -54,6 +55,58 @@ the terms of the BSD license (see the COPYING file).
 #define VL_IMOPV_INSTANTIATING
 #include "imopv.c"
 
+/** @brief Compute gradient modulus and angle of a row of inner pixels
+ ** @param gradient interleaved modulus and angle of the pixels (output).
+ ** @param image pointer to the first pixel of the row.
+ ** @param numPixels number of pixels.
+ ** @param imageStride width of the image including padding.
+ **
+ ** The gradient is computed by central differences, so that the
+ ** pixels must have valid neighbours in both directions. The angle is
+ ** normalised into the interval 0 and @f$ 2\pi @f$.
+ **
+ ** The function uses AVX-512, AVX2, or NEON instructions, if available
+ ** and enabled. The vectorized code reproduces the scalar operations
+ ** one by one and its results are bit-identical to the scalar code.
+ **/
+
+VL_EXPORT void
+vl_imgradient_polar_row_f (float * gradient,
+                           float const * image,
+                           vl_size numPixels,
+                           vl_size imageStride)
+{
+  vl_index const yo = (vl_index) imageStride ;
+  vl_size i = 0 ;
+
+  if (vl_get_simd_enabled()) {
+#ifndef VL_DISABLE_AVX512
+    if (vl_cpu_has_avx512f()) {
+      i += _vl_imgradient_polar_row_f_avx512
+        (gradient + 2 * i, image + i, numPixels - i, imageStride) ;
+    }
+#endif
+#ifndef VL_DISABLE_AVX2
+    if (vl_cpu_has_avx2()) {
+      i += _vl_imgradient_polar_row_f_avx2
+        (gradient + 2 * i, image + i, numPixels - i, imageStride) ;
+    }
+#endif
+#ifndef VL_DISABLE_NEON
+    i += _vl_imgradient_polar_row_f_neon
+      (gradient + 2 * i, image + i, numPixels - i, imageStride) ;
+#endif
+  }
+
+  for ( ; i < numPixels ; ++i) {
+    float const * src = image + i ;
+    float const gx = 0.5 * (src[+1]  - src[-1]) ;
+    float const gy = 0.5 * (src[+yo] - src[-yo]) ;
+    gradient[2 * i]     = vl_fast_sqrt_f (gx*gx + gy*gy) ;
+    gradient[2 * i + 1] = vl_mod_2pi_f (vl_fast_atan2_f (gy, gx) + 2*VL_PI) ;
+  }
+}
+
 /* VL_IMOPV_INSTANTIATING */
 #endif
 
@@ -934,6 +987,17 @@ pgrad_angl += gradientHorizontalStride ;                             \
 
     /* middle pixels of the middle rows */
     end = (src - 1) + w - 1 ;
+#if (FLT == VL_TYPE_FLOAT)
+    if (gradientHorizontalStride == 2 &&
+        pgrad_angl == pgrad_ampl + 1 && src < end) {
+      /* vectorized version for interleaved modulus and angle */
+      vl_size const n = end - src ;
+      vl_imgradient_polar_row_f (pgrad_ampl, src, n, imageStride) ;
+      pgrad_ampl += 2 * n ;
+      pgrad_angl += 2 * n ;
+      src = end ;
+    }
+#endif
     while (src < end) {
       gx = 0.5 * (src[+xo] - src[-xo]) ;
       gy = 0.5 * (src[+yo] - src[-yo]) ;
@@ -131,6 +131,12 @@ vl_imgradient_polar_f (float* amplitudeGradient, float* angleGradient,
                        vl_size imageWidth, vl_size imageHeight,
                        vl_size imageStride);
 
+VL_EXPORT void
+vl_imgradient_polar_row_f (float * gradient,
+                           float const * image,
+                           vl_size numPixels,
+                           vl_size imageStride) ;
+
 VL_EXPORT void
 vl_imgradient_polar_d (double* amplitudeGradient, double* angleGradient,
                        vl_size gradWidthStride, vl_size gradHeightStride,
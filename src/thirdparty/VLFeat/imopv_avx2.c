@@ -0,0 +1,130 @@
+/** @file imopv_avx2.c
+ ** @brief Vectorized image gradients - AVX2 - Definition
+ **/
+
+/*
+Copyright (C) 2007-12 Andrea Vedaldi and Brian Fulkerson.
+All rights reserved.
+
+This file is part of the VLFeat library and is made available under
+the terms of the BSD license (see the COPYING file).
+*/
+
+#if ! defined(VL_DISABLE_AVX2) & ! defined(__AVX2__)
+#error "Compiling with AVX2 enabled, but no __AVX2__ defined"
+#endif
+
+#if ! defined(VL_DISABLE_AVX2)
+
+#include <immintrin.h>
+
+#include "imopv_simd.h"
+#include "mathop.h"
+
+/* The operations replicate vl_fast_sqrt_f, vl_fast_atan2_f and
+ * vl_mod_2pi_f step by step, so that the results are bit-identical to
+ * the scalar code. This requires that the compiler does not contract
+ * multiplications and additions into fused multiply-adds. */
+
+vl_size
+_vl_imgradient_polar_row_f_avx2 (float * gradient,
+                                 float const * image,
+                                 vl_size numPixels,
+                                 vl_size imageStride)
+{
+  __m256 const half = _mm256_set1_ps (0.5F) ;
+  __m256 const one_and_half = _mm256_set1_ps (1.5F) ;
+  __m256 const min_modulus_sq = _mm256_set1_ps ((float) 1e-8) ;
+  __m256i const magic = _mm256_set1_epi32 (0x5f3759df) ;
+  __m256 const sign = _mm256_set1_ps (-0.0F) ;
+  __m256 const zero = _mm256_setzero_ps () ;
+  __m256 const eps = _mm256_set1_ps (VL_EPSILON_F) ;
+  __m256 const c1 = _mm256_set1_ps (0.9675F) ;
+  __m256 const c3 = _mm256_set1_ps (0.1821F) ;
+  __m256 const quarter_pi = _mm256_set1_ps ((float) (VL_PI / 4)) ;
+  __m256 const three_quarter_pi = _mm256_set1_ps ((float) (3 * VL_PI / 4)) ;
+  __m256d const two_pi_d = _mm256_set1_pd (2 * VL_PI) ;
+  __m256 const two_pi = _mm256_set1_ps ((float) (2 * VL_PI)) ;
+
+  vl_size const numVectors = numPixels / 8 ;
+  vl_size v ;
+
+  for (v = 0 ; v < numVectors ; ++v) {
+    float const * src = image + 8 * v ;
+    __m256 gx, gy, modulus_sq, modulus, xhalf, y ;
+    __m256 abs_y, pos_x, num, den, r, angle, angle_lo_hi ;
+    __m256 lo, hi ;
+    __m256d angle_lo, angle_hi ;
+
+    gx = _mm256_mul_ps (half, _mm256_sub_ps (_mm256_loadu_ps (src + 1),
+                                             _mm256_loadu_ps (src - 1))) ;
+    gy = _mm256_mul_ps (half,
+                        _mm256_sub_ps (_mm256_loadu_ps (src + imageStride),
+                                       _mm256_loadu_ps (src - imageStride))) ;
+
+    /* vl_fast_sqrt_f */
+    modulus_sq = _mm256_add_ps (_mm256_mul_ps (gx, gx),
+                                _mm256_mul_ps (gy, gy)) ;
+    xhalf = _mm256_mul_ps (half, modulus_sq) ;
+    y = _mm256_castsi256_ps
+      (_mm256_sub_epi32 (magic,
+                         _mm256_srli_epi32
+                         (_mm256_castps_si256 (modulus_sq), 1))) ;
+    y = _mm256_mul_ps (y, _mm256_sub_ps (one_and_half,
+                                         _mm256_mul_ps (_mm256_mul_ps (xhalf, y),
+                                                        y))) ;
+    y = _mm256_mul_ps (y, _mm256_sub_ps (one_and_half,
+                                         _mm256_mul_ps (_mm256_mul_ps (xhalf, y),
+                                                        y))) ;
+    modulus = _mm256_mul_ps (modulus_sq, y) ;
+    /* x < 1e-8 in double precision equals x <= (float) 1e-8 */
+    modulus = _mm256_blendv_ps (modulus, zero,
+                                _mm256_cmp_ps (modulus_sq, min_modulus_sq,
+                                               _CMP_LE_OQ)) ;
+
+    /* vl_fast_atan2_f */
+    abs_y = _mm256_add_ps (_mm256_andnot_ps (sign, gy), eps) ;
+    pos_x = _mm256_cmp_ps (gx, zero, _CMP_GE_OQ) ;
+    num = _mm256_blendv_ps (_mm256_add_ps (gx, abs_y),
+                            _mm256_sub_ps (gx, abs_y), pos_x) ;
+    den = _mm256_blendv_ps (_mm256_sub_ps (abs_y, gx),
+                            _mm256_add_ps (gx, abs_y), pos_x) ;
+    r = _mm256_div_ps (num, den) ;
+    angle = _mm256_blendv_ps (three_quarter_pi, quarter_pi, pos_x) ;
+    angle = _mm256_add_ps
+      (angle, _mm256_mul_ps (_mm256_sub_ps (_mm256_mul_ps (_mm256_mul_ps (c3, r),
+                                                           r),
+                                            c1),
+                             r)) ;
+    angle = _mm256_blendv_ps (angle, _mm256_xor_ps (angle, sign),
+                              _mm256_cmp_ps (gy, zero, _CMP_LT_OQ)) ;
+
+    /* vl_mod_2pi_f (angle + 2 * VL_PI), where the addition is in double
+     * precision. The angle is in [-pi, pi], so that a single subtraction
+     * suffices. */
+    angle_lo = _mm256_add_pd (_mm256_cvtps_pd (_mm256_castps256_ps128 (angle)),
+                              two_pi_d) ;
+    angle_hi = _mm256_add_pd (_mm256_cvtps_pd (_mm256_extractf128_ps (angle, 1)),
+                              two_pi_d) ;
+    angle_lo_hi = _mm256_insertf128_ps
+      (_mm256_castps128_ps256 (_mm256_cvtpd_ps (angle_lo)),
+       _mm256_cvtpd_ps (angle_hi), 1) ;
+    angle = _mm256_blendv_ps (angle_lo_hi,
+                              _mm256_sub_ps (angle_lo_hi, two_pi),
+                              _mm256_cmp_ps (angle_lo_hi, two_pi,
+                                             _CMP_GT_OQ)) ;
+
+    /* Interleave modulus and angle. */
+    lo = _mm256_unpacklo_ps (modulus, angle) ;
+    hi = _mm256_unpackhi_ps (modulus, angle) ;
+    _mm256_storeu_ps (gradient + 16 * v,
+                      _mm256_permute2f128_ps (lo, hi, 0x20)) ;
+    _mm256_storeu_ps (gradient + 16 * v + 8,
+                      _mm256_permute2f128_ps (lo, hi, 0x31)) ;
+  }
+
+  return 8 * numVectors ;
+}
+
+/* ! VL_DISABLE_AVX2 */
+#endif
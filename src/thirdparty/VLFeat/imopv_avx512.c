@@ -0,0 +1,132 @@
+/** @file imopv_avx512.c
+ ** @brief Vectorized image gradients - AVX-512 - Definition
+ **/
+
+/*
+Copyright (C) 2007-12 Andrea Vedaldi and Brian Fulkerson.
+All rights reserved.
+
+This file is part of the VLFeat library and is made available under
+the terms of the BSD license (see the COPYING file).
+*/
+
+#if ! defined(VL_DISABLE_AVX512) & ! defined(__AVX512F__)
+#error "Compiling with AVX-512 enabled, but no __AVX512F__ defined"
+#endif
+
+#if ! defined(VL_DISABLE_AVX512)
+
+#include <immintrin.h>
+
+#include "imopv_simd.h"
+#include "mathop.h"
+
+/* See imopv_avx2.c for the correspondence to the scalar code. Only
+ * AVX-512F instructions are used. */
+
+vl_size
+_vl_imgradient_polar_row_f_avx512 (float * gradient,
+                                   float const * image,
+                                   vl_size numPixels,
+                                   vl_size imageStride)
+{
+  __m512 const half = _mm512_set1_ps (0.5F) ;
+  __m512 const one_and_half = _mm512_set1_ps (1.5F) ;
+  __m512 const min_modulus_sq = _mm512_set1_ps ((float) 1e-8) ;
+  __m512i const magic = _mm512_set1_epi32 (0x5f3759df) ;
+  __m512i const sign = _mm512_set1_epi32 ((int) 0x80000000) ;
+  __m512 const zero = _mm512_setzero_ps () ;
+  __m512 const eps = _mm512_set1_ps (VL_EPSILON_F) ;
+  __m512 const c1 = _mm512_set1_ps (0.9675F) ;
+  __m512 const c3 = _mm512_set1_ps (0.1821F) ;
+  __m512 const quarter_pi = _mm512_set1_ps ((float) (VL_PI / 4)) ;
+  __m512 const three_quarter_pi = _mm512_set1_ps ((float) (3 * VL_PI / 4)) ;
+  __m512d const two_pi_d = _mm512_set1_pd (2 * VL_PI) ;
+  __m512 const two_pi = _mm512_set1_ps ((float) (2 * VL_PI)) ;
+  __m512i const interleave_lo = _mm512_set_epi32
+    (23, 7, 22, 6, 21, 5, 20, 4, 19, 3, 18, 2, 17, 1, 16, 0) ;
+  __m512i const interleave_hi = _mm512_set_epi32
+    (31, 15, 30, 14, 29, 13, 28, 12, 27, 11, 26, 10, 25, 9, 24, 8) ;
+
+  vl_size const numVectors = numPixels / 16 ;
+  vl_size v ;
+
+  for (v = 0 ; v < numVectors ; ++v) {
+    float const * src = image + 16 * v ;
+    __m512 gx, gy, modulus_sq, modulus, xhalf, y ;
+    __m512 abs_y, num, den, r, angle ;
+    __m256 angle_lo, angle_hi ;
+    __mmask16 pos_x ;
+
+    gx = _mm512_mul_ps (half, _mm512_sub_ps (_mm512_loadu_ps (src + 1),
+                                             _mm512_loadu_ps (src - 1))) ;
+    gy = _mm512_mul_ps (half,
+                        _mm512_sub_ps (_mm512_loadu_ps (src + imageStride),
+                                       _mm512_loadu_ps (src - imageStride))) ;
+
+    /* vl_fast_sqrt_f */
+    modulus_sq = _mm512_add_ps (_mm512_mul_ps (gx, gx),
+                                _mm512_mul_ps (gy, gy)) ;
+    xhalf = _mm512_mul_ps (half, modulus_sq) ;
+    y = _mm512_castsi512_ps
+      (_mm512_sub_epi32 (magic,
+                         _mm512_srli_epi32
+                         (_mm512_castps_si512 (modulus_sq), 1))) ;
+    y = _mm512_mul_ps (y, _mm512_sub_ps (one_and_half,
+                                         _mm512_mul_ps (_mm512_mul_ps (xhalf, y),
+                                                        y))) ;
+    y = _mm512_mul_ps (y, _mm512_sub_ps (one_and_half,
+                                         _mm512_mul_ps (_mm512_mul_ps (xhalf, y),
+                                                        y))) ;
+    modulus = _mm512_mask_blend_ps
+      (_mm512_cmp_ps_mask (modulus_sq, min_modulus_sq, _CMP_LE_OQ),
+       _mm512_mul_ps (modulus_sq, y), zero) ;
+
+    /* vl_fast_atan2_f */
+    abs_y = _mm512_add_ps (_mm512_abs_ps (gy), eps) ;
+    pos_x = _mm512_cmp_ps_mask (gx, zero, _CMP_GE_OQ) ;
+    num = _mm512_mask_blend_ps (pos_x, _mm512_add_ps (gx, abs_y),
+                                _mm512_sub_ps (gx, abs_y)) ;
+    den = _mm512_mask_blend_ps (pos_x, _mm512_sub_ps (abs_y, gx),
+                                _mm512_add_ps (gx, abs_y)) ;
+    r = _mm512_div_ps (num, den) ;
+    angle = _mm512_mask_blend_ps (pos_x, three_quarter_pi, quarter_pi) ;
+    angle = _mm512_add_ps
+      (angle, _mm512_mul_ps (_mm512_sub_ps (_mm512_mul_ps (_mm512_mul_ps (c3, r),
+                                                           r),
+                                            c1),
+                             r)) ;
+    angle = _mm512_castsi512_ps
+      (_mm512_mask_xor_epi32 (_mm512_castps_si512 (angle),
+                              _mm512_cmp_ps_mask (gy, zero, _CMP_LT_OQ),
+                              _mm512_castps_si512 (angle), sign)) ;
+
+    /* vl_mod_2pi_f (angle + 2 * VL_PI) with the addition in double
+     * precision. */
+    angle_lo = _mm512_cvtpd_ps
+      (_mm512_add_pd (_mm512_cvtps_pd (_mm512_castps512_ps256 (angle)),
+                      two_pi_d)) ;
+    angle_hi = _mm512_cvtpd_ps
+      (_mm512_add_pd (_mm512_cvtps_pd (_mm256_castpd_ps
+                                       (_mm512_extractf64x4_pd
+                                        (_mm512_castps_pd (angle), 1))),
+                      two_pi_d)) ;
+    angle = _mm512_castpd_ps
+      (_mm512_insertf64x4 (_mm512_castps_pd (_mm512_castps256_ps512 (angle_lo)),
+                           _mm256_castps_pd (angle_hi), 1)) ;
+    angle = _mm512_mask_sub_ps (angle,
+                                _mm512_cmp_ps_mask (angle, two_pi, _CMP_GT_OQ),
+                                angle, two_pi) ;
+
+    /* Interleave modulus and angle. */
+    _mm512_storeu_ps (gradient + 32 * v,
+                      _mm512_permutex2var_ps (modulus, interleave_lo, angle)) ;
+    _mm512_storeu_ps (gradient + 32 * v + 16,
+                      _mm512_permutex2var_ps (modulus, interleave_hi, angle)) ;
+  }
+
+  return 16 * numVectors ;
+}
+
+/* ! VL_DISABLE_AVX512 */
+#endif
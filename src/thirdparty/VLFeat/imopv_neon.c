@@ -0,0 +1,101 @@
+/** @file imopv_neon.c
+ ** @brief Vectorized image gradients - NEON - Definition
+ **/
+
+/*
+Copyright (C) 2007-12 Andrea Vedaldi and Brian Fulkerson.
+All rights reserved.
+
+This file is part of the VLFeat library and is made available under
+the terms of the BSD license (see the COPYING file).
+*/
+
+#include "imopv_simd.h"
+#include "mathop.h"
+
+#if ! defined(VL_DISABLE_NEON)
+
+#include <arm_neon.h>
+
+/* See imopv_avx2.c for the correspondence to the scalar code. NEON is
+ * part of the AArch64 base architecture, so that no run-time check is
+ * needed. */
+
+vl_size
+_vl_imgradient_polar_row_f_neon (float * gradient,
+                                 float const * image,
+                                 vl_size numPixels,
+                                 vl_size imageStride)
+{
+  float32x4_t const half = vdupq_n_f32 (0.5F) ;
+  float32x4_t const one_and_half = vdupq_n_f32 (1.5F) ;
+  float32x4_t const min_modulus_sq = vdupq_n_f32 ((float) 1e-8) ;
+  int32x4_t const magic = vdupq_n_s32 (0x5f3759df) ;
+  float32x4_t const zero = vdupq_n_f32 (0.0F) ;
+  float32x4_t const eps = vdupq_n_f32 (VL_EPSILON_F) ;
+  float32x4_t const c1 = vdupq_n_f32 (0.9675F) ;
+  float32x4_t const c3 = vdupq_n_f32 (0.1821F) ;
+  float32x4_t const quarter_pi = vdupq_n_f32 ((float) (VL_PI / 4)) ;
+  float32x4_t const three_quarter_pi = vdupq_n_f32 ((float) (3 * VL_PI / 4)) ;
+  float64x2_t const two_pi_d = vdupq_n_f64 (2 * VL_PI) ;
+  float32x4_t const two_pi = vdupq_n_f32 ((float) (2 * VL_PI)) ;
+
+  vl_size const numVectors = numPixels / 4 ;
+  vl_size v ;
+
+  for (v = 0 ; v < numVectors ; ++v) {
+    float const * src = image + 4 * v ;
+    float32x4_t gx, gy, modulus_sq, modulus, xhalf, y ;
+    float32x4_t abs_y, num, den, r, angle ;
+    float32x4x2_t output ;
+    uint32x4_t pos_x ;
+
+    gx = vmulq_f32 (half, vsubq_f32 (vld1q_f32 (src + 1),
+                                     vld1q_f32 (src - 1))) ;
+    gy = vmulq_f32 (half, vsubq_f32 (vld1q_f32 (src + imageStride),
+                                     vld1q_f32 (src - imageStride))) ;
+
+    /* vl_fast_sqrt_f */
+    modulus_sq = vaddq_f32 (vmulq_f32 (gx, gx), vmulq_f32 (gy, gy)) ;
+    xhalf = vmulq_f32 (half, modulus_sq) ;
+    y = vreinterpretq_f32_s32
+      (vsubq_s32 (magic,
+                  vshrq_n_s32 (vreinterpretq_s32_f32 (modulus_sq), 1))) ;
+    y = vmulq_f32 (y, vsubq_f32 (one_and_half,
+                                 vmulq_f32 (vmulq_f32 (xhalf, y), y))) ;
+    y = vmulq_f32 (y, vsubq_f32 (one_and_half,
+                                 vmulq_f32 (vmulq_f32 (xhalf, y), y))) ;
+    modulus = vbslq_f32 (vcleq_f32 (modulus_sq, min_modulus_sq),
+                         zero, vmulq_f32 (modulus_sq, y)) ;
+
+    /* vl_fast_atan2_f */
+    abs_y = vaddq_f32 (vabsq_f32 (gy), eps) ;
+    pos_x = vcgeq_f32 (gx, zero) ;
+    num = vbslq_f32 (pos_x, vsubq_f32 (gx, abs_y), vaddq_f32 (gx, abs_y)) ;
+    den = vbslq_f32 (pos_x, vaddq_f32 (gx, abs_y), vsubq_f32 (abs_y, gx)) ;
+    r = vdivq_f32 (num, den) ;
+    angle = vbslq_f32 (pos_x, quarter_pi, three_quarter_pi) ;
+    angle = vaddq_f32
+      (angle, vmulq_f32 (vsubq_f32 (vmulq_f32 (vmulq_f32 (c3, r), r), c1),
+                         r)) ;
+    angle = vbslq_f32 (vcltq_f32 (gy, zero), vnegq_f32 (angle), angle) ;
+
+    /* vl_mod_2pi_f (angle + 2 * VL_PI) with the addition in double
+     * precision. */
+    angle = vcombine_f32
+      (vcvt_f32_f64 (vaddq_f64 (vcvt_f64_f32 (vget_low_f32 (angle)),
+                                two_pi_d)),
+       vcvt_f32_f64 (vaddq_f64 (vcvt_high_f64_f32 (angle), two_pi_d))) ;
+    angle = vbslq_f32 (vcgtq_f32 (angle, two_pi),
+                       vsubq_f32 (angle, two_pi), angle) ;
+
+    output.val[0] = modulus ;
+    output.val[1] = angle ;
+    vst2q_f32 (gradient + 8 * v, output) ;
+  }
+
+  return 4 * numVectors ;
+}
+
+/* ! VL_DISABLE_NEON */
+#endif
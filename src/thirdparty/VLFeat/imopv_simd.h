@@ -0,0 +1,52 @@
+/** @file imopv_simd.h
+ ** @brief Vectorized image gradients - AVX2, AVX-512 and NEON
+ **/
+
+/*
+Copyright (C) 2007-12 Andrea Vedaldi and Brian Fulkerson.
+All rights reserved.
+
+This file is part of the VLFeat library and is made available under
+the terms of the BSD license (see the COPYING file).
+*/
+
+#ifndef VL_IMOPV_SIMD_H
+#define VL_IMOPV_SIMD_H
+
+#include "generic.h"
+
+#if ! defined(VL_DISABLE_NEON) && \
+    ! (defined(__aarch64__) || defined(_M_ARM64))
+#define VL_DISABLE_NEON
+#endif
+
+/* Each function computes the polar gradient of the first pixels of a
+ * row, whose count is a multiple of the vector width, and returns the
+ * number of processed pixels. See ::vl_imgradient_polar_row_f. */
+
+#ifndef VL_DISABLE_AVX2
+VL_EXPORT vl_size
+_vl_imgradient_polar_row_f_avx2 (float * gradient,
+                                 float const * image,
+                                 vl_size numPixels,
+                                 vl_size imageStride) ;
+#endif
+
+#ifndef VL_DISABLE_AVX512
+VL_EXPORT vl_size
+_vl_imgradient_polar_row_f_avx512 (float * gradient,
+                                   float const * image,
+                                   vl_size numPixels,
+                                   vl_size imageStride) ;
+#endif
+
+#ifndef VL_DISABLE_NEON
+VL_EXPORT vl_size
+_vl_imgradient_polar_row_f_neon (float * gradient,
+                                 float const * image,
+                                 vl_size numPixels,
+                                 vl_size imageStride) ;
+#endif
+
+/* VL_IMOPV_SIMD_H */
+#endif
@@ -1495,12 +1495,12 @@ update_gradient (VlSiftFilt *f)
       gy = 0.5 * (src[+yo] - src[-yo]) ;
       SAVE_BACK ;
 
-      /* middle pixels of the middle rows */
+      /* middle pixels of the middle rows (vectorized) */
       end = (src - 1) + w - 1 ;
-      while (src < end) {
-        gx = 0.5 * (src[+xo] - src[-xo]) ;
-        gy = 0.5 * (src[+yo] - src[-yo]) ;
-        SAVE_BACK ;
+      if (src < end) {
+        vl_imgradient_polar_row_f (grad, src, end - src, yo) ;
+        grad += 2 * (end - src) ;
+        src = end ;
       }
 
       /* last pixel of the middle row */